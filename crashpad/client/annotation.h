@@ -0,0 +1,216 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_CLIENT_ANNOTATION_H_
+#define CRASHPAD_CLIENT_ANNOTATION_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+
+namespace crashpad {
+
+class AnnotationList;
+
+//! \brief Base class for a typed annotation, readable by the Crashpad handler
+//!     out-of-process.
+//!
+//! An annotation is a small header naming a value and giving its type, address,
+//! and size. The value itself lives in storage owned by the annotation, sized
+//! when the annotation is declared, so that setting a value never allocates
+//! memory and a value is never larger than it needs to be. Subclasses such as
+//! StringAnnotation, IntAnnotation, and BlobAnnotation provide that storage and
+//! typed setters.
+//!
+//! An annotation is captured in a crash report only once it has been added to
+//! an AnnotationList that is registered with CrashpadInfo, and only while it
+//! is set. Because annotations are expected to be declared with static storage
+//! duration, they may not be removed from their list once added.
+//!
+//! The layout of this class is read by the handler, and must be kept in sync
+//! with `snapshot/mac/process_types/annotation.proctype` and the
+//! process_types::Annotation structure in `snapshot/win/pe_image_reader.h`.
+class Annotation {
+ public:
+  //! \brief The maximum length of an annotation’s name, in bytes, not including
+  //!     the trailing `NUL`.
+  static constexpr size_t kNameMaxLength = 64;
+
+  //! \brief The maximum size of an annotation’s value, in bytes.
+  static constexpr size_t kValueMaxSize = 5 * 4096;
+
+  //! \brief The type of data stored in an annotation.
+  //!
+  //! These values are carried in minidump files, and must not be renumbered.
+  enum class Type : uint16_t {
+    //! \brief An invalid annotation. Reserved for internal use.
+    kInvalid = 0,
+
+    //! \brief A `NUL`-terminated C string, stored without its terminator.
+    kString = 1,
+
+    //! \brief A signed 64-bit integer, stored in the native byte order of the
+    //!     process.
+    kInt = 2,
+
+    //! \brief An opaque byte sequence.
+    kBlob = 3,
+  };
+
+  //! \brief Constructs an unset annotation.
+  //!
+  //! \param[in] type The type of the value.
+  //! \param[in] name The name of the annotation, which must remain valid for
+  //!     the lifetime of the annotation. Annotations with names longer than
+  //!     #kNameMaxLength are not captured.
+  //! \param[in] value_ptr The storage for the value, which must remain valid
+  //!     for the lifetime of the annotation.
+  constexpr Annotation(Type type, const char name[], void* value_ptr)
+      : link_node_(nullptr),
+        name_(name),
+        value_ptr_(value_ptr),
+        size_(0),
+        type_(type),
+        reserved_(0) {}
+
+  //! \brief Sets the size of the value, in bytes, marking the annotation as
+  //!     set if \a size is nonzero and as clear otherwise.
+  //!
+  //! The caller must have already written the value. \a size must not exceed
+  //! #kValueMaxSize.
+  void SetSize(uint32_t size) {
+    DCHECK_LE(size, kValueMaxSize);
+    size_ = size;
+  }
+
+  //! \brief Marks the annotation as clear, so that it is not captured.
+  void Clear() { size_ = 0; }
+
+  //! \brief Returns whether the annotation is set, and will be captured.
+  bool is_set() const { return size_ > 0; }
+
+  Type type() const { return type_; }
+  uint32_t size() const { return size_; }
+  const char* name() const { return name_; }
+  const void* value() const { return value_ptr_; }
+
+ private:
+  friend class AnnotationList;
+
+  // The next annotation in the AnnotationList that this annotation has been
+  // added to. This is managed by AnnotationList.
+  Annotation* link_node_;
+
+  const char* const name_;
+  void* const value_ptr_;
+  uint32_t size_;
+  const Type type_;
+  uint16_t reserved_;
+
+  DISALLOW_COPY_AND_ASSIGN(Annotation);
+};
+
+//! \brief An annotation holding a string of up to \a MaxSize bytes.
+template <uint32_t MaxSize>
+class StringAnnotation : public Annotation {
+ public:
+  static_assert(MaxSize > 0 && MaxSize <= kValueMaxSize,
+                "MaxSize out of range");
+
+  //! \brief Constructs an unset string annotation named \a name.
+  constexpr explicit StringAnnotation(const char name[])
+      : Annotation(Type::kString, name, value_), value_() {}
+
+  //! \brief Sets the value, truncating it to \a MaxSize bytes.
+  //!
+  //! An empty \a string clears the annotation.
+  void Set(base::StringPiece string) {
+    const uint32_t size =
+        static_cast<uint32_t>(std::min<size_t>(string.size(), MaxSize));
+    if (size) {
+      memcpy(value_, string.data(), size);
+    }
+    SetSize(size);
+  }
+
+  //! \brief Returns the value, which is empty if the annotation is not set.
+  base::StringPiece value() const { return base::StringPiece(value_, size()); }
+
+ private:
+  char value_[MaxSize];
+
+  DISALLOW_COPY_AND_ASSIGN(StringAnnotation);
+};
+
+//! \brief An annotation holding a signed 64-bit integer.
+class IntAnnotation : public Annotation {
+ public:
+  //! \brief Constructs an unset integer annotation named \a name.
+  constexpr explicit IntAnnotation(const char name[])
+      : Annotation(Type::kInt, name, &value_), value_(0) {}
+
+  //! \brief Sets the value.
+  void Set(int64_t value) {
+    value_ = value;
+    SetSize(sizeof(value_));
+  }
+
+  //! \brief Returns the value, which is `0` if the annotation is not set.
+  int64_t value() const { return is_set() ? value_ : 0; }
+
+ private:
+  int64_t value_;
+
+  DISALLOW_COPY_AND_ASSIGN(IntAnnotation);
+};
+
+//! \brief An annotation holding up to \a MaxSize bytes of opaque data.
+template <uint32_t MaxSize>
+class BlobAnnotation : public Annotation {
+ public:
+  static_assert(MaxSize > 0 && MaxSize <= kValueMaxSize,
+                "MaxSize out of range");
+
+  //! \brief Constructs an unset blob annotation named \a name.
+  constexpr explicit BlobAnnotation(const char name[])
+      : Annotation(Type::kBlob, name, value_), value_() {}
+
+  //! \brief Sets the value to \a size bytes at \a data, truncating it to \a
+  //!     MaxSize bytes.
+  //!
+  //! A \a size of `0` clears the annotation.
+  void Set(const void* data, size_t size) {
+    const uint32_t copy_size =
+        static_cast<uint32_t>(std::min<size_t>(size, MaxSize));
+    if (copy_size) {
+      memcpy(value_, data, copy_size);
+    }
+    SetSize(copy_size);
+  }
+
+ private:
+  uint8_t value_[MaxSize];
+
+  DISALLOW_COPY_AND_ASSIGN(BlobAnnotation);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_CLIENT_ANNOTATION_H_
@@ -0,0 +1,54 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/annotation_list.h"
+
+#include "base/logging.h"
+#include "client/crashpad_info.h"
+
+namespace crashpad {
+
+AnnotationList::AnnotationList() : head_(nullptr) {}
+
+AnnotationList::~AnnotationList() {}
+
+// static
+AnnotationList* AnnotationList::Get() {
+  return CrashpadInfo::GetCrashpadInfo()->annotations_list();
+}
+
+// static
+AnnotationList* AnnotationList::Register() {
+  CrashpadInfo* crashpad_info = CrashpadInfo::GetCrashpadInfo();
+  AnnotationList* list = crashpad_info->annotations_list();
+  if (!list) {
+    list = new AnnotationList();
+    crashpad_info->set_annotations_list(list);
+  }
+  return list;
+}
+
+void AnnotationList::Add(Annotation* annotation) {
+  DCHECK(!annotation->link_node_);
+
+  // The annotation must be fully linked before it becomes reachable from the
+  // head, because the handler may read the list at any time.
+  Annotation* head = head_.load(std::memory_order_relaxed);
+  do {
+    annotation->link_node_ = head;
+  } while (!head_.compare_exchange_weak(
+      head, annotation, std::memory_order_release, std::memory_order_relaxed));
+}
+
+}  // namespace crashpad
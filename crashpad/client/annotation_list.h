@@ -0,0 +1,100 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_CLIENT_ANNOTATION_LIST_H_
+#define CRASHPAD_CLIENT_ANNOTATION_LIST_H_
+
+#include <atomic>
+
+#include "base/macros.h"
+#include "client/annotation.h"
+
+namespace crashpad {
+
+//! \brief A list of Annotation objects, registered with CrashpadInfo so that
+//!     the Crashpad handler can read them out-of-process.
+//!
+//! The list is singly linked through the annotations themselves, so it needs
+//! no storage of its own beyond its head, and the handler reads it in a single
+//! pass. Annotations are added at the head of the list atomically, so adding
+//! annotations from multiple threads is safe. Annotations cannot be removed.
+//!
+//! The layout of this class is read by the handler, and must be kept in sync
+//! with `snapshot/mac/process_types/annotation.proctype` and the
+//! process_types::AnnotationList structure in `snapshot/win/pe_image_reader.h`.
+class AnnotationList {
+ public:
+  //! \brief An iterator to traverse the annotations in an AnnotationList,
+  //!     most recently added first.
+  class Iterator {
+   public:
+    explicit Iterator(const AnnotationList& list)
+        : current_(list.head_.load(std::memory_order_acquire)) {}
+
+    //! \brief Returns the next annotation in the list, or `nullptr` if at the
+    //!     end of the list.
+    const Annotation* Next() {
+      const Annotation* annotation = current_;
+      if (annotation) {
+        current_ = annotation->link_node_;
+      }
+      return annotation;
+    }
+
+   private:
+    const Annotation* current_;
+
+    DISALLOW_COPY_AND_ASSIGN(Iterator);
+  };
+
+  AnnotationList();
+  ~AnnotationList();
+
+  //! \brief Returns the AnnotationList registered with the CrashpadInfo
+  //!     structure for the calling module, or `nullptr` if none has been
+  //!     registered.
+  static AnnotationList* Get();
+
+  //! \brief Creates an AnnotationList and registers it with the CrashpadInfo
+  //!     structure for the calling module, if one has not already been
+  //!     registered.
+  //!
+  //! The list is never destroyed. This is not safe to call concurrently with
+  //! itself, and should be called once, early in the process’ lifetime.
+  //!
+  //! \return The registered AnnotationList.
+  static AnnotationList* Register();
+
+  //! \brief Adds \a annotation to the list.
+  //!
+  //! \param[in] annotation The annotation to add. It must remain valid for the
+  //!     lifetime of the list, and must not already be in any AnnotationList.
+  void Add(Annotation* annotation);
+
+ private:
+  friend class ThreadAnnotationRegistry;
+
+  // Empties the list. Only a ThreadAnnotationRegistry does this, when the
+  // thread that owns a slot releases it. The annotations themselves are not
+  // touched, as they may have already been destroyed.
+  void Clear() { head_.store(nullptr, std::memory_order_release); }
+
+  std::atomic<Annotation*> head_;
+
+  DISALLOW_COPY_AND_ASSIGN(AnnotationList);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_CLIENT_ANNOTATION_LIST_H_
@@ -0,0 +1,120 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/annotation_list.h"
+
+#include <memory>
+#include <vector>
+
+#include "client/crashpad_info.h"
+#include "gtest/gtest.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+std::vector<const Annotation*> Collect(const AnnotationList& list) {
+  std::vector<const Annotation*> annotations;
+  AnnotationList::Iterator iterator(list);
+  while (const Annotation* annotation = iterator.Next()) {
+    annotations.push_back(annotation);
+  }
+  return annotations;
+}
+
+TEST(AnnotationList, AddAndIterate) {
+  AnnotationList list;
+  EXPECT_TRUE(Collect(list).empty());
+
+  StringAnnotation<16> one("one");
+  IntAnnotation two("two");
+  BlobAnnotation<16> three("three");
+  list.Add(&one);
+  list.Add(&two);
+  list.Add(&three);
+
+  // Annotations appear whether or not they are set. Readers skip those that
+  // are not.
+  one.Set("1");
+  std::vector<const Annotation*> annotations = Collect(list);
+  ASSERT_EQ(annotations.size(), 3u);
+  EXPECT_EQ(annotations[0], &three);
+  EXPECT_EQ(annotations[1], &two);
+  EXPECT_EQ(annotations[2], &one);
+  EXPECT_FALSE(annotations[0]->is_set());
+  EXPECT_TRUE(annotations[2]->is_set());
+}
+
+TEST(AnnotationList, Register) {
+  CrashpadInfo* crashpad_info = CrashpadInfo::GetCrashpadInfo();
+  AnnotationList* previous = crashpad_info->annotations_list();
+  crashpad_info->set_annotations_list(nullptr);
+
+  EXPECT_FALSE(AnnotationList::Get());
+  AnnotationList* list = AnnotationList::Register();
+  ASSERT_TRUE(list);
+  EXPECT_EQ(AnnotationList::Get(), list);
+  EXPECT_EQ(crashpad_info->annotations_list(), list);
+
+  // Registering again returns the same list.
+  EXPECT_EQ(AnnotationList::Register(), list);
+
+  crashpad_info->set_annotations_list(previous);
+  delete list;
+}
+
+constexpr size_t kAnnotationsPerThread = 100;
+
+class AddThread : public Thread {
+ public:
+  explicit AddThread(AnnotationList* list)
+      : Thread(), list_(list), annotations_() {}
+  ~AddThread() override {}
+
+ private:
+  void ThreadMain() override {
+    for (IntAnnotation& annotation : annotations_) {
+      list_->Add(&annotation);
+    }
+  }
+
+  struct ThreadAnnotation : public IntAnnotation {
+    ThreadAnnotation() : IntAnnotation("thread") {}
+  };
+
+  AnnotationList* list_;  // weak
+  ThreadAnnotation annotations_[kAnnotationsPerThread];
+
+  DISALLOW_COPY_AND_ASSIGN(AddThread);
+};
+
+TEST(AnnotationList, ConcurrentAdd) {
+  AnnotationList list;
+  constexpr size_t kThreads = 4;
+  std::unique_ptr<AddThread> threads[kThreads];
+  for (auto& thread : threads) {
+    thread.reset(new AddThread(&list));
+    thread->Start();
+  }
+  for (auto& thread : threads) {
+    thread->Join();
+  }
+
+  EXPECT_EQ(Collect(list).size(), kThreads * kAnnotationsPerThread);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,100 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/annotation.h"
+
+#include <string.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(Annotation, StringAnnotation) {
+  StringAnnotation<8> annotation("string");
+  EXPECT_EQ(annotation.type(), Annotation::Type::kString);
+  EXPECT_STREQ(annotation.name(), "string");
+  EXPECT_FALSE(annotation.is_set());
+  EXPECT_EQ(annotation.size(), 0u);
+  EXPECT_TRUE(annotation.value().empty());
+
+  annotation.Set("value");
+  EXPECT_TRUE(annotation.is_set());
+  EXPECT_EQ(annotation.size(), 5u);
+  EXPECT_EQ(annotation.value().as_string(), "value");
+  EXPECT_EQ(
+      memcmp(static_cast<const Annotation&>(annotation).value(), "value", 5),
+      0);
+
+  // Values are truncated to the annotation’s size, without a terminator.
+  annotation.Set("truncated value");
+  EXPECT_EQ(annotation.size(), 8u);
+  EXPECT_EQ(annotation.value().as_string(), "truncate");
+
+  annotation.Set("");
+  EXPECT_FALSE(annotation.is_set());
+
+  annotation.Set("value");
+  annotation.Clear();
+  EXPECT_FALSE(annotation.is_set());
+  EXPECT_TRUE(annotation.value().empty());
+}
+
+TEST(Annotation, IntAnnotation) {
+  IntAnnotation annotation("int");
+  EXPECT_EQ(annotation.type(), Annotation::Type::kInt);
+  EXPECT_FALSE(annotation.is_set());
+  EXPECT_EQ(annotation.value(), 0);
+
+  annotation.Set(-1234567890123);
+  EXPECT_TRUE(annotation.is_set());
+  EXPECT_EQ(annotation.size(), sizeof(int64_t));
+  EXPECT_EQ(annotation.value(), -1234567890123);
+
+  int64_t raw;
+  memcpy(&raw, static_cast<const Annotation&>(annotation).value(), sizeof(raw));
+  EXPECT_EQ(raw, -1234567890123);
+
+  // Zero is a value like any other.
+  annotation.Set(0);
+  EXPECT_TRUE(annotation.is_set());
+
+  annotation.Clear();
+  EXPECT_FALSE(annotation.is_set());
+}
+
+TEST(Annotation, BlobAnnotation) {
+  BlobAnnotation<4> annotation("blob");
+  EXPECT_EQ(annotation.type(), Annotation::Type::kBlob);
+  EXPECT_FALSE(annotation.is_set());
+
+  const uint8_t kData[] = {0, 1, 2, 3, 4, 5};
+  annotation.Set(kData, 3);
+  EXPECT_EQ(annotation.size(), 3u);
+  EXPECT_EQ(memcmp(annotation.value(), kData, 3), 0);
+
+  annotation.Set(kData, sizeof(kData));
+  EXPECT_EQ(annotation.size(), 4u);
+  EXPECT_EQ(memcmp(annotation.value(), kData, 4), 0);
+
+  annotation.Set(nullptr, 0);
+  EXPECT_FALSE(annotation.is_set());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
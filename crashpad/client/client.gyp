@@ -29,17 +29,29 @@
         '..',
       ],
       'sources': [
+        'annotation.cc',
+        'annotation.h',
+        'annotation_list.cc',
+        'annotation_list.h',
         'capture_context_mac.S',
         'capture_context_mac.h',
         'crash_report_database.cc',
         'crash_report_database.h',
+        'crash_report_database_linux.cc',
         'crash_report_database_mac.mm',
         'crash_report_database_win.cc',
+        'crash_signature_history.cc',
+        'crash_signature_history.h',
         'crashpad_client.h',
         'crashpad_client_mac.cc',
         'crashpad_client_win.cc',
         'crashpad_info.cc',
         'crashpad_info.h',
+        'fallback_minidump_writer_linux.cc',
+        'fallback_minidump_writer_linux.h',
+        'indexed_simple_string_dictionary.h',
+        'module_table.cc',
+        'module_table.h',
         'prune_crash_reports.cc',
         'prune_crash_reports.h',
         'settings.cc',
@@ -52,6 +64,8 @@
         'simulate_crash_mac.cc',
         'simulate_crash_mac.h',
         'simulate_crash_win.h',
+        'thread_annotations.cc',
+        'thread_annotations.h',
       ],
       'conditions': [
         ['OS=="win"', {
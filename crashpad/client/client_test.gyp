@@ -24,6 +24,7 @@
         'client.gyp:crashpad_client',
         '../compat/compat.gyp:crashpad_compat',
         '../handler/handler.gyp:crashpad_handler',
+        '../snapshot/snapshot.gyp:crashpad_snapshot',
         '../test/test.gyp:crashpad_gmock_main',
         '../test/test.gyp:crashpad_test',
         '../third_party/gtest/gmock.gyp:gmock',
@@ -35,14 +36,21 @@
         '..',
       ],
       'sources': [
+        'annotation_list_test.cc',
+        'annotation_test.cc',
         'capture_context_mac_test.cc',
         'crash_report_database_test.cc',
+        'crash_signature_history_test.cc',
         'crashpad_client_win_test.cc',
+        'fallback_minidump_writer_linux_test.cc',
+        'indexed_simple_string_dictionary_test.cc',
+        'module_table_test.cc',
         'prune_crash_reports_test.cc',
         'settings_test.cc',
         'simple_address_range_bag_test.cc',
         'simple_string_dictionary_test.cc',
         'simulate_crash_mac_test.cc',
+        'thread_annotations_test.cc',
       ],
       'conditions': [
         ['OS=="win"', {
@@ -52,5 +60,23 @@
         }],
       ],
     },
+    {
+      'target_name': 'crashpad_database_benchmark',
+      'type': 'executable',
+      'dependencies': [
+        'client.gyp:crashpad_client',
+        '../compat/compat.gyp:crashpad_compat',
+        '../test/test.gyp:crashpad_test',
+        '../third_party/mini_chromium/mini_chromium.gyp:base',
+        '../tools/tools.gyp:crashpad_tool_support',
+        '../util/util.gyp:crashpad_util',
+      ],
+      'include_dirs': [
+        '..',
+      ],
+      'sources': [
+        'crash_report_database_benchmark.cc',
+      ],
+    },
   ],
 }
@@ -14,8 +14,115 @@
 
 #include "client/crash_report_database.h"
 
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "build/build_config.h"
+#include "util/misc/clock.h"
+#include "util/synchronization/semaphore.h"
+
+#if defined(OS_WIN)
+#include <windows.h>
+
+#include "base/strings/utf_string_conversions.h"
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "util/posix/scoped_dir.h"
+#endif
+
 namespace crashpad {
 
+namespace {
+
+// A record of upload parameters is a header, followed by each parameter’s key
+// and value sizes and then the key and value themselves, in the host’s byte
+// order.
+struct UploadParametersHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t parameter_count;
+};
+
+constexpr uint32_t kUploadParametersMagic = 'CPUP';
+constexpr uint32_t kUploadParametersVersion = 1;
+
+void AppendUint32(uint32_t value, std::string* data) {
+  data->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads a uint32_t from |data| at |*offset|, advancing |*offset| past it.
+// Returns false if |data| is too short.
+bool ReadUint32(const std::string& data, size_t* offset, uint32_t* value) {
+  if (data.size() - *offset < sizeof(*value)) {
+    return false;
+  }
+  memcpy(value, data.data() + *offset, sizeof(*value));
+  *offset += sizeof(*value);
+  return true;
+}
+
+// Reads a string of |size| bytes from |data| at |*offset|, advancing |*offset|
+// past it. Returns false if |data| is too short.
+bool ReadString(const std::string& data,
+                size_t* offset,
+                uint32_t size,
+                std::string* value) {
+  if (data.size() - *offset < size) {
+    return false;
+  }
+  value->assign(data, *offset, size);
+  *offset += size;
+  return true;
+}
+
+// Fills |summary| from |report|, which is pending if |pending| is true, and
+// completed otherwise.
+void SummarizeReport(const CrashReportDatabase::Report& report,
+                     bool pending,
+                     CrashReportDatabase::ReportSummary* summary) {
+  summary->uuid = report.uuid;
+  summary->creation_time = report.creation_time;
+  summary->last_upload_attempt_time = report.last_upload_attempt_time;
+  summary->upload_attempts = report.upload_attempts;
+  summary->size_in_kb = report.size_in_kb;
+  summary->pending = pending;
+  summary->uploaded = report.uploaded;
+  summary->upload_explicitly_requested = report.upload_explicitly_requested;
+  summary->dump_without_crash = report.dump_without_crash;
+}
+
+// Collects the UUIDs of the reports listed.
+class ReportUUIDCollector final
+    : public CrashReportDatabase::ListReportsDelegate {
+ public:
+  explicit ReportUUIDCollector(std::vector<UUID>* uuids) : uuids_(uuids) {}
+  ~ReportUUIDCollector() {}
+
+  // CrashReportDatabase::ListReportsDelegate:
+  bool ReportListed(
+      const CrashReportDatabase::ReportSummary& summary) override {
+    uuids_->push_back(summary.uuid);
+    return true;
+  }
+
+ private:
+  std::vector<UUID>* uuids_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ReportUUIDCollector);
+};
+
+}  // namespace
+
 CrashReportDatabase::Report::Report()
     : uuid(),
       file_path(),
@@ -24,7 +131,56 @@ CrashReportDatabase::Report::Report()
       uploaded(false),
       last_upload_attempt_time(0),
       upload_attempts(0),
-      upload_explicitly_requested(false) {}
+      upload_explicitly_requested(false),
+      dump_without_crash(false),
+      size_in_kb(0) {}
+
+CrashReportDatabase::ReportSummary::ReportSummary()
+    : uuid(),
+      creation_time(0),
+      last_upload_attempt_time(0),
+      upload_attempts(0),
+      size_in_kb(0),
+      pending(false),
+      uploaded(false),
+      upload_explicitly_requested(false),
+      dump_without_crash(false) {}
+
+CrashReportDatabase::ReportFilter::ReportFilter()
+    : pending(true),
+      completed(true),
+      created_at_or_after(0),
+      created_before(0),
+      upload_status(UploadStatus::kAny) {}
+
+bool CrashReportDatabase::ReportFilter::Matches(
+    const ReportSummary& summary) const {
+  if (!(summary.pending ? pending : completed)) {
+    return false;
+  }
+  if (created_at_or_after && summary.creation_time < created_at_or_after) {
+    return false;
+  }
+  if (created_before && summary.creation_time >= created_before) {
+    return false;
+  }
+  switch (upload_status) {
+    case UploadStatus::kAny:
+      return true;
+    case UploadStatus::kUploaded:
+      return summary.uploaded;
+    case UploadStatus::kNotUploaded:
+      return !summary.uploaded;
+  }
+  return true;
+}
+
+CrashReportDatabase::NewReportFileOptions::NewReportFileOptions()
+    : preallocation_size(0),
+      discard_file_cache(false),
+      spare_file_count(0),
+      durable(false),
+      commit_window_ms(0) {}
 
 CrashReportDatabase::CallErrorWritingCrashReport::CallErrorWritingCrashReport(
     CrashReportDatabase* database,
@@ -44,4 +200,544 @@ void CrashReportDatabase::CallErrorWritingCrashReport::Disarm() {
   new_report_ = nullptr;
 }
 
+CrashReportDatabase::CrashReportDatabase()
+    : new_report_file_options_(),
+      spare_report_file_directory_(),
+      spare_report_files_available_(),
+      spare_report_files_lock_(),
+      upload_parameters_directory_(),
+      attachments_directory_(),
+      commit_waiters_(),
+      commit_lock_(),
+      commit_in_progress_(false) {}
+
+CrashReportDatabase::OperationStatus CrashReportDatabase::ListReports(
+    const ReportFilter& filter,
+    ListReportsDelegate* delegate) {
+  for (bool pending : {true, false}) {
+    if (!(pending ? filter.pending : filter.completed)) {
+      continue;
+    }
+
+    std::vector<Report> reports;
+    OperationStatus os = pending ? GetPendingReports(&reports)
+                                 : GetCompletedReports(&reports);
+    if (os != kNoError) {
+      return os;
+    }
+
+    for (const Report& report : reports) {
+      ReportSummary summary;
+      SummarizeReport(report, pending, &summary);
+      if (filter.Matches(summary) && !delegate->ReportListed(summary)) {
+        return kNoError;
+      }
+    }
+  }
+
+  return kNoError;
+}
+
+CrashReportDatabase::OperationStatus CrashReportDatabase::DeleteReports(
+    const ReportFilter& filter,
+    size_t* deleted_count) {
+  // Reports can’t be deleted while they’re listed, because the delegate must
+  // not call into the database.
+  std::vector<UUID> uuids;
+  ReportUUIDCollector collector(&uuids);
+  OperationStatus os = ListReports(filter, &collector);
+  if (os != kNoError) {
+    return os;
+  }
+
+  size_t count = 0;
+  for (const UUID& uuid : uuids) {
+    OperationStatus delete_os = DeleteReport(uuid);
+    if (delete_os == kNoError) {
+      ++count;
+    } else {
+      os = delete_os;
+    }
+  }
+
+  if (deleted_count) {
+    *deleted_count = count;
+  }
+  return os;
+}
+
+CrashReportDatabase::OperationStatus CrashReportDatabase::RequestUploads(
+    const ReportFilter& filter,
+    size_t* requested_count) {
+  // Uploaded reports are skipped, so they needn’t be listed.
+  std::vector<UUID> uuids;
+  if (filter.upload_status != ReportFilter::UploadStatus::kUploaded) {
+    ReportFilter not_uploaded_filter = filter;
+    not_uploaded_filter.upload_status =
+        ReportFilter::UploadStatus::kNotUploaded;
+    ReportUUIDCollector collector(&uuids);
+    OperationStatus os = ListReports(not_uploaded_filter, &collector);
+    if (os != kNoError) {
+      return os;
+    }
+  }
+
+  OperationStatus os = kNoError;
+
+  size_t count = 0;
+  for (const UUID& uuid : uuids) {
+    OperationStatus request_os = RequestUpload(uuid);
+    if (request_os == kNoError) {
+      ++count;
+    } else if (request_os != kCannotRequestUpload) {
+      os = request_os;
+    }
+  }
+
+  if (requested_count) {
+    *requested_count = count;
+  }
+  return os;
+}
+
+CrashReportDatabase::OperationStatus
+CrashReportDatabase::LookUpUploadParameters(
+    const UUID& uuid,
+    std::map<std::string, std::string>* parameters) {
+  if (upload_parameters_directory_.empty()) {
+    return kReportNotFound;
+  }
+
+  // Reports written without parameters have no record, so failing to open it
+  // isn’t worth logging.
+  ScopedFileHandle handle(OpenFileForRead(UploadParametersPath(uuid)));
+  if (!handle.is_valid()) {
+    return kReportNotFound;
+  }
+
+  std::string data;
+  char buffer[4096];
+  FileOperationResult rv;
+  while ((rv = ReadFile(handle.get(), buffer, sizeof(buffer))) > 0) {
+    data.append(buffer, rv);
+  }
+  if (rv < 0) {
+    PLOG(ERROR) << internal::kNativeReadFunctionName;
+    return kFileSystemError;
+  }
+
+  UploadParametersHeader header;
+  if (data.size() < sizeof(header)) {
+    LOG(ERROR) << "upload parameters record too short";
+    return kDatabaseError;
+  }
+  memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != kUploadParametersMagic ||
+      header.version != kUploadParametersVersion) {
+    LOG(ERROR) << "unexpected upload parameters record";
+    return kDatabaseError;
+  }
+
+  std::map<std::string, std::string> local_parameters;
+  size_t offset = sizeof(header);
+  for (uint32_t index = 0; index < header.parameter_count; ++index) {
+    uint32_t key_size;
+    uint32_t value_size;
+    std::string key;
+    std::string value;
+    if (!ReadUint32(data, &offset, &key_size) ||
+        !ReadUint32(data, &offset, &value_size) ||
+        !ReadString(data, &offset, key_size, &key) ||
+        !ReadString(data, &offset, value_size, &value)) {
+      LOG(ERROR) << "upload parameters record truncated";
+      return kDatabaseError;
+    }
+    local_parameters[key] = value;
+  }
+
+  parameters->swap(local_parameters);
+  return kNoError;
+}
+
+CrashReportDatabase::OperationStatus CrashReportDatabase::GetAttachments(
+    const UUID& uuid,
+    std::vector<base::FilePath>* attachments) {
+  if (attachments_directory_.empty()) {
+    return kReportNotFound;
+  }
+
+  // Reports written without attachments have no directory for them, so
+  // failing to find one isn’t worth logging.
+  const base::FilePath directory = AttachmentsPath(uuid);
+  std::vector<base::FilePath> local_attachments;
+#if defined(OS_WIN)
+  WIN32_FIND_DATA find_data;
+  HANDLE find_handle =
+      FindFirstFile(directory.Append(L"*").value().c_str(), &find_data);
+  if (find_handle == INVALID_HANDLE_VALUE) {
+    const DWORD error = GetLastError();
+    if (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND) {
+      return kReportNotFound;
+    }
+    PLOG(ERROR) << "FindFirstFile " << base::UTF16ToUTF8(directory.value());
+    return kFileSystemError;
+  }
+  do {
+    if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+      local_attachments.push_back(directory.Append(find_data.cFileName));
+    }
+  } while (FindNextFile(find_handle, &find_data));
+  FindClose(find_handle);
+#else
+  ScopedDIR dir(opendir(directory.value().c_str()));
+  if (!dir) {
+    if (errno == ENOENT) {
+      return kReportNotFound;
+    }
+    PLOG(ERROR) << "opendir " << directory.value();
+    return kFileSystemError;
+  }
+  dirent* entry;
+  while ((entry = readdir(dir.get())) != nullptr) {
+    if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+      local_attachments.push_back(directory.Append(entry->d_name));
+    }
+  }
+#endif
+
+  if (local_attachments.empty()) {
+    return kReportNotFound;
+  }
+
+  // Directory order is arbitrary, so the files are sorted to be uploaded in a
+  // consistent order.
+  std::sort(local_attachments.begin(),
+            local_attachments.end(),
+            [](const base::FilePath& lhs, const base::FilePath& rhs) {
+              return lhs.value() < rhs.value();
+            });
+  attachments->swap(local_attachments);
+  return kNoError;
+}
+
+void CrashReportDatabase::SetNewReportFileOptions(
+    const NewReportFileOptions& options) {
+  new_report_file_options_ = options;
+
+  // Spare files beyond a reduced count are left in place, to be reused if the
+  // count is raised again.
+  base::AutoLock lock(spare_report_files_lock_);
+  spare_report_files_available_.resize(options.spare_file_count, false);
+}
+
+void CrashReportDatabase::ReplenishSpareReportFiles() {
+  if (spare_report_file_directory_.empty()) {
+    return;
+  }
+
+  for (size_t index = 0; index < new_report_file_options_.spare_file_count;
+       ++index) {
+    {
+      base::AutoLock lock(spare_report_files_lock_);
+      if (spare_report_files_available_[index]) {
+        continue;
+      }
+    }
+
+    // A spare left by an earlier instance is truncated, in case it was written
+    // to. Some file systems release storage reserved beyond a file’s end when
+    // it’s closed, so PrepareNewReportFile() reserves it again once claimed.
+    ScopedFileHandle handle(
+        LoggingOpenFileForWrite(SpareReportFilePath(index),
+                                FileWriteMode::kTruncateOrCreate,
+                                FilePermissions::kOwnerOnly));
+    if (!handle.is_valid()) {
+      return;
+    }
+    if (new_report_file_options_.preallocation_size > 0) {
+      LoggingReserveFileStorage(handle.get(),
+                                new_report_file_options_.preallocation_size);
+    }
+    handle.reset();
+
+    base::AutoLock lock(spare_report_files_lock_);
+    spare_report_files_available_[index] = true;
+  }
+}
+
+// static
+uint32_t CrashReportDatabase::ReportSizeInKB(FileOffset size) {
+  if (size <= 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(std::min<FileOffset>(
+      (size + 1023) / 1024, std::numeric_limits<uint32_t>::max()));
+}
+
+void CrashReportDatabase::PrepareNewReportFile(FileHandle handle) const {
+  if (new_report_file_options_.preallocation_size > 0) {
+    LoggingReserveFileStorage(handle,
+                              new_report_file_options_.preallocation_size);
+  }
+  if (new_report_file_options_.discard_file_cache) {
+    LoggingDiscardFileCache(handle);
+  }
+}
+
+void CrashReportDatabase::FinishNewReportFile(FileHandle handle) const {
+  if (new_report_file_options_.preallocation_size > 0) {
+    LoggingReleaseUnusedFileStorage(handle);
+  }
+  if (new_report_file_options_.durable) {
+    LoggingFlushFile(handle);
+  }
+  if (new_report_file_options_.discard_file_cache) {
+    LoggingDiscardFileCache(handle);
+  }
+}
+
+void CrashReportDatabase::CommitReportRecords() {
+  if (!new_report_file_options_.durable) {
+    return;
+  }
+
+  // A commit that another thread is leading flushes this thread’s records too,
+  // so long as it hasn’t started flushing yet.
+  Semaphore committed(0);
+  bool leading;
+  {
+    base::AutoLock lock(commit_lock_);
+    leading = !commit_in_progress_;
+    if (leading) {
+      commit_in_progress_ = true;
+    } else {
+      commit_waiters_.push_back(&committed);
+    }
+  }
+  if (!leading) {
+    committed.Wait();
+    return;
+  }
+
+  if (new_report_file_options_.commit_window_ms > 0) {
+    constexpr uint64_t kNanosecondsPerMillisecond = 1000000;
+    SleepNanoseconds(new_report_file_options_.commit_window_ms *
+                     kNanosecondsPerMillisecond);
+  }
+
+  // Threads arriving from here on lead the next commit, which may overlap this
+  // one’s flush.
+  std::vector<Semaphore*> waiters;
+  {
+    base::AutoLock lock(commit_lock_);
+    waiters.swap(commit_waiters_);
+    commit_in_progress_ = false;
+  }
+
+  FlushReportRecords();
+
+  for (Semaphore* waiter : waiters) {
+    waiter->Signal();
+  }
+}
+
+void CrashReportDatabase::FlushReportRecords() {}
+
+void CrashReportDatabase::SetSpareReportFileDirectory(
+    const base::FilePath& directory) {
+  spare_report_file_directory_ = directory;
+}
+
+bool CrashReportDatabase::ClaimSpareReportFile(const base::FilePath& path) {
+  size_t index;
+  {
+    base::AutoLock lock(spare_report_files_lock_);
+    auto it = std::find(spare_report_files_available_.begin(),
+                        spare_report_files_available_.end(),
+                        true);
+    if (it == spare_report_files_available_.end()) {
+      return false;
+    }
+    *it = false;
+    index = it - spare_report_files_available_.begin();
+  }
+
+  // Another instance of the database may have claimed the same file, in which
+  // case this fails and a new file is created instead.
+  return LoggingMoveFile(SpareReportFilePath(index), path);
+}
+
+FileHandle CrashReportDatabase::OpenNewReportFile(const base::FilePath& path) {
+  FileHandle handle = kInvalidFileHandle;
+  if (ClaimSpareReportFile(path)) {
+    handle = LoggingOpenFileForWrite(
+        path, FileWriteMode::kReuseOrFail, FilePermissions::kOwnerOnly);
+  }
+  if (handle == kInvalidFileHandle) {
+    handle = LoggingOpenFileForWrite(
+        path, FileWriteMode::kCreateOrFail, FilePermissions::kOwnerOnly);
+  }
+  if (handle != kInvalidFileHandle) {
+    PrepareNewReportFile(handle);
+  }
+  return handle;
+}
+
+void CrashReportDatabase::SetUploadParametersDirectory(
+    const base::FilePath& directory) {
+  upload_parameters_directory_ = directory;
+}
+
+bool CrashReportDatabase::WriteUploadParameters(const NewReport& report) {
+  if (upload_parameters_directory_.empty() ||
+      report.upload_parameters.empty()) {
+    return true;
+  }
+
+  // The record is built in memory so that it’s written all at once.
+  UploadParametersHeader header = {};
+  header.magic = kUploadParametersMagic;
+  header.version = kUploadParametersVersion;
+  header.parameter_count =
+      static_cast<uint32_t>(report.upload_parameters.size());
+  std::string data(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const auto& kv : report.upload_parameters) {
+    AppendUint32(static_cast<uint32_t>(kv.first.size()), &data);
+    AppendUint32(static_cast<uint32_t>(kv.second.size()), &data);
+    data.append(kv.first);
+    data.append(kv.second);
+  }
+
+  const base::FilePath path = UploadParametersPath(report.uuid);
+  ScopedFileHandle handle(LoggingOpenFileForWrite(
+      path, FileWriteMode::kTruncateOrCreate, FilePermissions::kOwnerOnly));
+  if (!handle.is_valid()) {
+    return false;
+  }
+  if (!LoggingWriteFile(handle.get(), data.data(), data.size())) {
+    handle.reset();
+    DeleteUploadParameters(report.uuid);
+    return false;
+  }
+  return true;
+}
+
+void CrashReportDatabase::DeleteUploadParameters(const UUID& uuid) {
+  if (upload_parameters_directory_.empty()) {
+    return;
+  }
+
+  // Most reports have no record, so failing to find one isn’t worth logging.
+  const base::FilePath path = UploadParametersPath(uuid);
+#if defined(OS_WIN)
+  if (!DeleteFile(path.value().c_str()) &&
+      GetLastError() != ERROR_FILE_NOT_FOUND) {
+    PLOG(ERROR) << "DeleteFile " << base::UTF16ToUTF8(path.value());
+  }
+#else
+  if (unlink(path.value().c_str()) != 0 && errno != ENOENT) {
+    PLOG(ERROR) << "unlink " << path.value();
+  }
+#endif
+}
+
+void CrashReportDatabase::SetAttachmentsDirectory(
+    const base::FilePath& directory) {
+  attachments_directory_ = directory;
+}
+
+bool CrashReportDatabase::WriteAttachments(const NewReport& report) {
+  if (attachments_directory_.empty() || report.attachments.empty()) {
+    return true;
+  }
+
+  const base::FilePath directory = AttachmentsPath(report.uuid);
+#if defined(OS_WIN)
+  if (!CreateDirectory(directory.value().c_str(), nullptr)) {
+    PLOG(ERROR) << "CreateDirectory " << base::UTF16ToUTF8(directory.value());
+    return false;
+  }
+#else
+  if (mkdir(directory.value().c_str(), 0700) != 0) {
+    PLOG(ERROR) << "mkdir " << directory.value();
+    return false;
+  }
+#endif
+
+  // Each file is cloned rather than copied, so that recording it takes about
+  // as long as creating an empty file, however large it is. Its contents are
+  // read only when the report is uploaded.
+  bool success = true;
+  for (const base::FilePath& attachment : report.attachments) {
+    if (!LoggingCloneFile(attachment,
+                          directory.Append(attachment.BaseName()))) {
+      success = false;
+    }
+  }
+  return success;
+}
+
+void CrashReportDatabase::DeleteAttachments(const UUID& uuid) {
+  std::vector<base::FilePath> attachments;
+  if (CrashReportDatabase::GetAttachments(uuid, &attachments) == kNoError) {
+    for (const base::FilePath& attachment : attachments) {
+#if defined(OS_WIN)
+      if (!DeleteFile(attachment.value().c_str())) {
+        PLOG(ERROR) << "DeleteFile " << base::UTF16ToUTF8(attachment.value());
+      }
+#else
+      if (unlink(attachment.value().c_str()) != 0) {
+        PLOG(ERROR) << "unlink " << attachment.value();
+      }
+#endif
+    }
+  }
+
+  // A directory is left without files if none of the report’s attachments
+  // could be cloned, so it’s removed even if none were listed.
+  if (attachments_directory_.empty()) {
+    return;
+  }
+  const base::FilePath directory = AttachmentsPath(uuid);
+#if defined(OS_WIN)
+  if (!RemoveDirectory(directory.value().c_str())) {
+    const DWORD error = GetLastError();
+    if (error != ERROR_FILE_NOT_FOUND && error != ERROR_PATH_NOT_FOUND) {
+      PLOG(ERROR) << "RemoveDirectory "
+                  << base::UTF16ToUTF8(directory.value());
+    }
+  }
+#else
+  if (rmdir(directory.value().c_str()) != 0 && errno != ENOENT) {
+    PLOG(ERROR) << "rmdir " << directory.value();
+  }
+#endif
+}
+
+base::FilePath CrashReportDatabase::SpareReportFilePath(size_t index) const {
+  const std::string name = base::StringPrintf("spare_%" PRIuS ".tmp", index);
+#if defined(OS_WIN)
+  return spare_report_file_directory_.Append(base::UTF8ToUTF16(name));
+#else
+  return spare_report_file_directory_.Append(name);
+#endif
+}
+
+base::FilePath CrashReportDatabase::UploadParametersPath(
+    const UUID& uuid) const {
+#if defined(OS_WIN)
+  return upload_parameters_directory_.Append(uuid.ToString16());
+#else
+  return upload_parameters_directory_.Append(uuid.ToString());
+#endif
+}
+
+base::FilePath CrashReportDatabase::AttachmentsPath(const UUID& uuid) const {
+#if defined(OS_WIN)
+  return attachments_directory_.Append(uuid.ToString16());
+#else
+  return attachments_directory_.Append(uuid.ToString());
+#endif
+}
+
 }  // namespace crashpad
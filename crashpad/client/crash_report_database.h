@@ -15,20 +15,25 @@
 #ifndef CRASHPAD_CLIENT_CRASH_REPORT_DATABASE_H_
 #define CRASHPAD_CLIENT_CRASH_REPORT_DATABASE_H_
 
+#include <stdint.h>
 #include <time.h>
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "base/files/file_path.h"
 #include "base/macros.h"
+#include "base/synchronization/lock.h"
 #include "util/file/file_io.h"
 #include "util/misc/metrics.h"
 #include "util/misc/uuid.h"
 
 namespace crashpad {
 
+class DirectoryChangeWatcher;
+class Semaphore;
 class Settings;
 
 //! \brief An interface for managing a collection of crash report files and
@@ -94,6 +99,109 @@ class CrashReportDatabase {
     //! Whether this crash report was explicitly requested by user to be
     //! uploaded. This can be true only if report is in the 'pending' state.
     bool upload_explicitly_requested;
+
+    //! Whether this crash report was requested by a process that continued
+    //! running, as by CrashpadClient::DumpWithoutCrash(), rather than written
+    //! because the process crashed.
+    bool dump_without_crash;
+
+    //! The size of the crash report’s file in kilobytes, rounded up, as
+    //! recorded by the database. This is `0` if the database did not record
+    //! the size, as for reports written by older versions of Crashpad.
+    uint32_t size_in_kb;
+  };
+
+  //! \brief The metadata of a crash report, as listed by ListReports().
+  //!
+  //! Unlike Report, this carries neither the report’s path nor the identifier
+  //! issued by a collection server, so that listing reports doesn’t build a
+  //! string for each one.
+  struct ReportSummary {
+    ReportSummary();
+
+    //! \copydoc Report::uuid
+    UUID uuid;
+
+    //! \copydoc Report::creation_time
+    time_t creation_time;
+
+    //! \copydoc Report::last_upload_attempt_time
+    time_t last_upload_attempt_time;
+
+    //! \copydoc Report::upload_attempts
+    int upload_attempts;
+
+    //! \copydoc Report::size_in_kb
+    uint32_t size_in_kb;
+
+    //! Whether the report is pending, as opposed to completed.
+    bool pending;
+
+    //! \copydoc Report::uploaded
+    bool uploaded;
+
+    //! \copydoc Report::upload_explicitly_requested
+    bool upload_explicitly_requested;
+
+    //! \copydoc Report::dump_without_crash
+    bool dump_without_crash;
+  };
+
+  //! \brief Selects the reports listed by ListReports().
+  //!
+  //! The default-constructed filter selects every pending and completed
+  //! report.
+  struct ReportFilter {
+    //! \brief Selects reports by whether they were uploaded.
+    enum class UploadStatus {
+      //! \brief Reports are listed whether or not they were uploaded.
+      kAny,
+
+      //! \brief Only reports that were uploaded are listed.
+      kUploaded,
+
+      //! \brief Only reports that were not uploaded are listed.
+      kNotUploaded,
+    };
+
+    ReportFilter();
+
+    //! \return `true` if \a summary is selected by this filter.
+    bool Matches(const ReportSummary& summary) const;
+
+    //! Whether pending reports are listed.
+    bool pending;
+
+    //! Whether completed reports are listed.
+    bool completed;
+
+    //! The earliest creation time of reports listed, or `0` for no limit.
+    time_t created_at_or_after;
+
+    //! The time before which reports listed were created, or `0` for no
+    //! limit.
+    time_t created_before;
+
+    //! Whether reports are listed according to their upload status.
+    UploadStatus upload_status;
+  };
+
+  //! \brief The interface for receiving the reports listed by ListReports().
+  class ListReportsDelegate {
+   public:
+    //! \brief Called for each report listed.
+    //!
+    //! This must not call into the database, which may be locked while reports
+    //! are listed.
+    //!
+    //! \param[in] summary The report’s metadata, which is only valid for the
+    //!     duration of the call.
+    //!
+    //! \return `true` to continue listing reports, or `false` to stop.
+    virtual bool ReportListed(const ReportSummary& summary) = 0;
+
+   protected:
+    ~ListReportsDelegate() {}
   };
 
   //! \brief A crash report that is in the process of being written.
@@ -110,6 +218,27 @@ class CrashReportDatabase {
 
     //! The path to the crash report being written.
     base::FilePath path;
+
+    //! Whether the report is being written for a process that will continue
+    //! running. This is initially `false`, and may be set by the writer before
+    //! calling FinishedWritingCrashReport() to be recorded as
+    //! Report::dump_without_crash.
+    bool dump_without_crash;
+
+    //! The HTTP form parameters to upload the report with, as they would be
+    //! derived from the report’s contents. This is initially empty, and may be
+    //! set by the writer before calling FinishedWritingCrashReport() to be
+    //! recorded for LookUpUploadParameters(), so that the report needn’t be
+    //! interpreted again when it’s uploaded.
+    std::map<std::string, std::string> upload_parameters;
+
+    //! The files to upload along with the report, by path. This is initially
+    //! empty, and may be set by the writer before calling
+    //! FinishedWritingCrashReport(). Each file is then cloned into the
+    //! database by LoggingCloneFile(), rather than copied, to be listed by
+    //! GetAttachments(). A file that can’t be cloned is left out, with a
+    //! message logged.
+    std::vector<base::FilePath> attachments;
   };
 
   //! \brief A scoper to cleanly handle the interface requirement imposed by
@@ -178,6 +307,54 @@ class CrashReportDatabase {
     kCannotRequestUpload,
   };
 
+  //! \brief Options controlling how the files of new crash reports are
+  //!     written.
+  struct NewReportFileOptions {
+    NewReportFileOptions();
+
+    //! \brief The number of bytes of storage to reserve for each new report’s
+    //!     file when it is created, or `0` to reserve none.
+    //!
+    //! This should be an estimate of a typical report’s size. Reserving
+    //! storage lets the file system allocate it at once rather than as the
+    //! report is written. The size of the file is unaffected, and storage
+    //! that the report doesn’t use is released by
+    //! FinishedWritingCrashReport(). See LoggingReserveFileStorage().
+    FileOffset preallocation_size;
+
+    //! \brief Whether to keep the contents of new reports out of the
+    //!     operating system’s file cache, so that writing a burst of reports
+    //!     doesn’t displace other cached data. See LoggingDiscardFileCache().
+    bool discard_file_cache;
+
+    //! \brief The number of spare report files to keep ready, or `0` to keep
+    //!     none.
+    //!
+    //! PrepareNewCrashReport() renames a spare file into place, when one is
+    //! available, rather than creating a new file while a crash is being
+    //! handled. Spare files are created, with storage reserved according to
+    //! #preallocation_size, by ReplenishSpareReportFiles().
+    size_t spare_file_count;
+
+    //! \brief Whether FinishedWritingCrashReport() makes each new report
+    //!     durable before returning, so that a report once pending survives a
+    //!     power failure or a kernel panic.
+    //!
+    //! Each report’s file is flushed with LoggingFlushFile() by the thread
+    //! finishing it, before the report is recorded. The database’s records are
+    //! then flushed once for all of the reports finished within
+    //! #commit_window_ms of the first, rather than once for each.
+    bool durable;
+
+    //! \brief When #durable is set, how long, in milliseconds, to wait for
+    //!     other reports to be finished before flushing the database’s
+    //!     records, or `0` to flush them at once.
+    //!
+    //! This adds up to this much to the time taken to finish a report, in
+    //! exchange for fewer flushes when many are finished together.
+    unsigned int commit_window_ms;
+  };
+
   virtual ~CrashReportDatabase() {}
 
   //! \brief Opens a database of crash reports, possibly creating it.
@@ -187,6 +364,13 @@ class CrashReportDatabase {
   //!     for databases implemented as directory structures, existence refers
   //!     solely to the outermost directory.
   //!
+  //! On macOS and Windows, a database that has come to hold thousands of
+  //! reports is migrated here to a sharded layout, in which report files are
+  //! kept in subdirectories named for the leading characters of their UUIDs,
+  //! so that operations on single reports don’t slow down as it grows. Once
+  //! migrated, a database is only usable by versions of Crashpad that
+  //! understand the sharded layout.
+  //!
   //! \return A database object on success, `nullptr` on failure with an error
   //!     logged.
   //!
@@ -355,10 +539,259 @@ class CrashReportDatabase {
   //! \return The operation status code.
   virtual OperationStatus RequestUpload(const UUID& uuid) = 0;
 
+  //! \brief Initializes a watcher to be notified when reports may have become
+  //!     pending, including reports added to the database by other processes.
+  //!
+  //! A notification may be spurious, or may reflect a change other than a
+  //! report becoming pending, so it should prompt a call to GetPendingReports()
+  //! rather than be taken to mean that a new report is available.
+  //!
+  //! \param[in] watcher A newly-constructed watcher to initialize by calling
+  //!     DirectoryChangeWatcher::Initialize(). The caller is responsible for
+  //!     starting it.
+  //!
+  //! \return `true` on success. `false` with a message logged if change
+  //!     notifications are unavailable, in which case callers should poll
+  //!     GetPendingReports() instead.
+  virtual bool WatchPendingReports(DirectoryChangeWatcher* watcher) = 0;
+
+  //! \brief Lists the reports selected by \a filter, in no particular order.
+  //!
+  //! This is intended for summarizing the contents of a large database, and
+  //! is cheaper than GetPendingReports() and GetCompletedReports(). It does
+  //! not confirm that each report’s file still exists. Implementations that
+  //! keep an index of reports list them from a single read of the index, so
+  //! that the reports listed are consistent with one another. The default
+  //! implementation lists them from the results of GetPendingReports() and
+  //! GetCompletedReports(), which are obtained separately. As with those
+  //! methods, reports being uploaded are not listed.
+  //!
+  //! \param[in] filter The reports to list.
+  //! \param[in] delegate Called for each report listed.
+  //!
+  //! \return The operation status code. #kNoError if listing was stopped by
+  //!     the delegate.
+  virtual OperationStatus ListReports(const ReportFilter& filter,
+                                      ListReportsDelegate* delegate);
+
+  //! \brief Deletes the reports selected by \a filter, as DeleteReport()
+  //!     would.
+  //!
+  //! Implementations that keep an index of reports select and delete them
+  //! while holding a single lock of the index, so that no other process sees
+  //! the database partway through. The default implementation lists the reports
+  //! with ListReports() and deletes each with DeleteReport(). As with
+  //! ListReports(), reports being uploaded are not deleted.
+  //!
+  //! \param[in] filter The reports to delete.
+  //! \param[out] deleted_count The number of reports deleted. Optional.
+  //!
+  //! \return The operation status code. A failure to delete one report doesn’t
+  //!     prevent others from being deleted, and the status of the last failure
+  //!     is returned.
+  virtual OperationStatus DeleteReports(const ReportFilter& filter,
+                                        size_t* deleted_count);
+
+  //! \brief Requests the upload of the reports selected by \a filter, as
+  //!     RequestUpload() would.
+  //!
+  //! Reports that have already been uploaded are skipped, rather than treated
+  //! as failures. This is otherwise like DeleteReports(): implementations that
+  //! keep an index of reports lock it once for all of the reports, and the
+  //! default implementation calls RequestUpload() for each.
+  //!
+  //! \param[in] filter The reports to request the upload of.
+  //! \param[out] requested_count The number of reports whose upload was
+  //!     requested. Optional.
+  //!
+  //! \return The operation status code, as for DeleteReports().
+  virtual OperationStatus RequestUploads(const ReportFilter& filter,
+                                         size_t* requested_count);
+
+  //! \brief Returns the HTTP form parameters recorded for the report identified
+  //!     by \a uuid, from NewReport::upload_parameters.
+  //!
+  //! \param[in] uuid The crash report record unique identifier.
+  //! \param[out] parameters The recorded parameters. Only valid if this returns
+  //!     #kNoError.
+  //!
+  //! \return The operation status code. #kReportNotFound if no parameters were
+  //!     recorded for the report, which is the case for reports written without
+  //!     them or by an implementation that doesn’t record them. #kDatabaseError
+  //!     if the record couldn’t be read, with a message logged.
+  virtual OperationStatus LookUpUploadParameters(
+      const UUID& uuid,
+      std::map<std::string, std::string>* parameters);
+
+  //! \brief Returns the files recorded for the report identified by \a uuid,
+  //!     from NewReport::attachments.
+  //!
+  //! \param[in] uuid The crash report record unique identifier.
+  //! \param[out] attachments The paths of the database’s clones of the files,
+  //!     each named as the file that it was cloned from is. These remain valid
+  //!     until the report is deleted. Only valid if this returns #kNoError.
+  //!
+  //! \return The operation status code. #kReportNotFound if no files were
+  //!     recorded for the report, which is the case for reports written without
+  //!     them or by an implementation that doesn’t record them.
+  //!     #kFileSystemError if the files couldn’t be listed, with a message
+  //!     logged.
+  virtual OperationStatus GetAttachments(
+      const UUID& uuid,
+      std::vector<base::FilePath>* attachments);
+
+  //! \brief Sets the options used for files of reports created by subsequent
+  //!     calls to PrepareNewCrashReport().
+  //!
+  //! This must not be called while another thread may be creating a report.
+  virtual void SetNewReportFileOptions(const NewReportFileOptions& options);
+
+  //! \brief Creates spare report files until the number available reaches
+  //!     NewReportFileOptions::spare_file_count.
+  //!
+  //! This is intended to be called periodically from a background thread, so
+  //! that files consumed by PrepareNewCrashReport() are replaced away from the
+  //! crash path. Spare files left by an earlier instance of the database are
+  //! reused. It may be called concurrently with PrepareNewCrashReport().
+  virtual void ReplenishSpareReportFiles();
+
  protected:
-  CrashReportDatabase() {}
+  CrashReportDatabase();
+
+  //! \brief Converts the size of a crash report’s file, in bytes, to the value
+  //!     to record as Report::size_in_kb.
+  static uint32_t ReportSizeInKB(FileOffset size);
+
+  //! \return The options set by SetNewReportFileOptions().
+  const NewReportFileOptions& new_report_file_options() const {
+    return new_report_file_options_;
+  }
+
+  //! \brief Applies the NewReportFileOptions to a newly-created report file.
+  //!
+  //! Implementations call this from PrepareNewCrashReport(). The options are
+  //! hints, so failures are logged and otherwise ignored.
+  void PrepareNewReportFile(FileHandle handle) const;
+
+  //! \brief Completes the NewReportFileOptions for a report file that has been
+  //!     written.
+  //!
+  //! Implementations call this from FinishedWritingCrashReport() before
+  //! determining the report’s size.
+  void FinishNewReportFile(FileHandle handle) const;
+
+  //! \brief Makes the records of the reports finished so far durable, if
+  //!     NewReportFileOptions::durable is set.
+  //!
+  //! Implementations call this from FinishedWritingCrashReport() once the
+  //! report has been recorded and any lock on the records released, so that
+  //! the report isn’t announced as pending until it is durable. Reports
+  //! committed by several threads within NewReportFileOptions::commit_window_ms
+  //! share a single call to FlushReportRecords(): the first waits out the
+  //! window and flushes, and the others wait for it.
+  void CommitReportRecords();
+
+  //! \brief Writes the database’s records of its reports, and the entries of
+  //!     the directories holding reports, to storage.
+  //!
+  //! This is called by CommitReportRecords(). The default implementation does
+  //! nothing. Failures should be logged and otherwise ignored.
+  virtual void FlushReportRecords();
+
+  //! \brief Enables spare report files, and sets the directory to keep them in.
+  //!
+  //! Implementations that support spare report files call this during
+  //! initialization. Spare files are renamed into place, so \a directory must
+  //! be on the same file system as new reports, and files in it other than
+  //! reports must be ignored by the implementation.
+  void SetSpareReportFileDirectory(const base::FilePath& directory);
+
+  //! \brief Moves a spare report file to \a path, if one is available.
+  //!
+  //! \return `true` if a spare report file was moved to \a path. `false` if
+  //!     there was none, or if it could not be moved, with a message logged.
+  bool ClaimSpareReportFile(const base::FilePath& path);
+
+  //! \brief Opens a new report file for writing at \a path.
+  //!
+  //! This claims a spare report file if one is available, and otherwise
+  //! creates the file. PrepareNewReportFile() is applied to it.
+  //!
+  //! \return The file handle, or kInvalidFileHandle with a message logged.
+  FileHandle OpenNewReportFile(const base::FilePath& path);
+
+  //! \brief Enables the recording of NewReport::upload_parameters, and sets the
+  //!     directory, which must exist, to keep the records in.
+  //!
+  //! Implementations that support LookUpUploadParameters() call this during
+  //! initialization.
+  void SetUploadParametersDirectory(const base::FilePath& directory);
+
+  //! \brief Records the NewReport::upload_parameters of \a report, if there
+  //!     are any.
+  //!
+  //! Implementations call this from FinishedWritingCrashReport() before the
+  //! report becomes pending, so that the record is in place by the time the
+  //! report may be uploaded.
+  //!
+  //! \return `true` on success, or if there was nothing to record. `false` with
+  //!     a message logged on failure, in which case the report can still be
+  //!     uploaded with the parameters derived from its contents.
+  bool WriteUploadParameters(const NewReport& report);
+
+  //! \brief Removes the record of the upload parameters of the report
+  //!     identified by \a uuid, if there is one.
+  //!
+  //! Implementations call this when a report is deleted.
+  void DeleteUploadParameters(const UUID& uuid);
+
+  //! \brief Enables the recording of NewReport::attachments, and sets the
+  //!     directory, which must exist and be on the same file system as the
+  //!     files attached, to keep them in.
+  //!
+  //! Implementations that support GetAttachments() call this during
+  //! initialization.
+  void SetAttachmentsDirectory(const base::FilePath& directory);
+
+  //! \brief Clones the NewReport::attachments of \a report into the database,
+  //!     if there are any.
+  //!
+  //! Implementations call this from FinishedWritingCrashReport() before the
+  //! report becomes pending, alongside WriteUploadParameters().
+  //!
+  //! \return `true` if every file was cloned, or if there was nothing to
+  //!     record. `false` with a message logged if any file couldn’t be cloned,
+  //!     in which case the report can still be uploaded with the rest.
+  bool WriteAttachments(const NewReport& report);
+
+  //! \brief Removes the files recorded for the report identified by \a uuid,
+  //!     if there are any.
+  //!
+  //! Implementations call this when a report is deleted.
+  void DeleteAttachments(const UUID& uuid);
 
  private:
+  base::FilePath SpareReportFilePath(size_t index) const;
+  base::FilePath UploadParametersPath(const UUID& uuid) const;
+  base::FilePath AttachmentsPath(const UUID& uuid) const;
+
+  NewReportFileOptions new_report_file_options_;
+  base::FilePath spare_report_file_directory_;
+
+  // Which of the spare report files named by SpareReportFilePath() exist and
+  // may be claimed. This has NewReportFileOptions::spare_file_count entries.
+  std::vector<bool> spare_report_files_available_;
+  base::Lock spare_report_files_lock_;
+
+  base::FilePath upload_parameters_directory_;
+  base::FilePath attachments_directory_;
+
+  // The threads waiting for a commit that another thread is leading, each
+  // signaled once the records it wrote have been flushed.
+  std::vector<Semaphore*> commit_waiters_;
+  base::Lock commit_lock_;
+  bool commit_in_progress_;
+
   DISALLOW_COPY_AND_ASSIGN(CrashReportDatabase);
 };
 
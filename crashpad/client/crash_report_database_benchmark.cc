@@ -0,0 +1,533 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "build/build_config.h"
+#include "client/crash_report_database.h"
+#include "client/prune_crash_reports.h"
+#include "test/scoped_temp_dir.h"
+#include "tools/tool_support.h"
+#include "util/file/file_io.h"
+#include "util/misc/clock.h"
+#include "util/misc/uuid.h"
+#include "util/stdlib/string_number_conversion.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace {
+
+// A collection of operation latencies, in nanoseconds.
+class Latencies {
+ public:
+  Latencies() : samples_() {}
+  ~Latencies() {}
+
+  void Add(uint64_t ns) { samples_.push_back(ns); }
+  void Append(const Latencies& other) {
+    samples_.insert(samples_.end(), other.samples_.begin(),
+                    other.samples_.end());
+  }
+
+  size_t count() const { return samples_.size(); }
+
+  // Prints one table row for |name|.
+  void Print(const char* name) {
+    std::sort(samples_.begin(), samples_.end());
+    uint64_t total = 0;
+    for (uint64_t sample : samples_) {
+      total += sample;
+    }
+    const size_t count = std::max(samples_.size(), size_t{1});
+    printf("%-28s %8" PRIuS " %10.1f %10.1f %10.1f %10.1f\n",
+           name,
+           samples_.size(),
+           total / 1E3 / count,
+           Percentile(50) / 1E3,
+           Percentile(99) / 1E3,
+           samples_.empty() ? 0 : samples_.back() / 1E3);
+  }
+
+ private:
+  // Nearest-rank percentile of the sorted samples.
+  uint64_t Percentile(unsigned int percent) const {
+    if (samples_.empty()) {
+      return 0;
+    }
+    size_t rank = (samples_.size() * percent + 99) / 100;
+    return samples_[std::max(rank, size_t{1}) - 1];
+  }
+
+  std::vector<uint64_t> samples_;
+
+  DISALLOW_COPY_AND_ASSIGN(Latencies);
+};
+
+void PrintHeader(const char* title) {
+  printf("\n%-28s %8s %10s %10s %10s %10s\n",
+         title,
+         "count",
+         "mean_us",
+         "p50_us",
+         "p99_us",
+         "max_us");
+}
+
+// Adds a report holding |contents| to |database|, recording the latency of
+// each database operation, and sets |uuid| to the new report’s UUID.
+bool WriteReport(CrashReportDatabase* database,
+                 const std::string& contents,
+                 Latencies* prepare,
+                 Latencies* finish,
+                 UUID* uuid) {
+  CrashReportDatabase::NewReport* new_report;
+  uint64_t start_time = ClockMonotonicNanoseconds();
+  CrashReportDatabase::OperationStatus status =
+      database->PrepareNewCrashReport(&new_report);
+  prepare->Add(ClockMonotonicNanoseconds() - start_time);
+  if (status != CrashReportDatabase::kNoError) {
+    LOG(ERROR) << "PrepareNewCrashReport: " << status;
+    return false;
+  }
+
+  CrashReportDatabase::CallErrorWritingCrashReport
+      call_error_writing_crash_report(database, new_report);
+  if (!LoggingWriteFile(new_report->handle, contents.data(), contents.size())) {
+    return false;
+  }
+  call_error_writing_crash_report.Disarm();
+
+  start_time = ClockMonotonicNanoseconds();
+  status = database->FinishedWritingCrashReport(new_report, uuid);
+  finish->Add(ClockMonotonicNanoseconds() - start_time);
+  if (status != CrashReportDatabase::kNoError) {
+    LOG(ERROR) << "FinishedWritingCrashReport: " << status;
+    return false;
+  }
+  return true;
+}
+
+// Moves the report |uuid| to the completed state as an upload would.
+bool CompleteReport(CrashReportDatabase* database,
+                    const UUID& uuid,
+                    Latencies* latencies) {
+  const uint64_t start_time = ClockMonotonicNanoseconds();
+  const CrashReportDatabase::Report* report;
+  CrashReportDatabase::OperationStatus status =
+      database->GetReportForUploading(uuid, &report);
+  if (status == CrashReportDatabase::kNoError) {
+    status = database->RecordUploadAttempt(report, true, "benchmark");
+  }
+  latencies->Add(ClockMonotonicNanoseconds() - start_time);
+  if (status != CrashReportDatabase::kNoError) {
+    LOG(ERROR) << "GetReportForUploading or RecordUploadAttempt: " << status;
+    return false;
+  }
+  return true;
+}
+
+class CountingDelegate final
+    : public CrashReportDatabase::ListReportsDelegate {
+ public:
+  CountingDelegate() : count_(0) {}
+  ~CountingDelegate() {}
+
+  size_t count() const { return count_; }
+
+  // CrashReportDatabase::ListReportsDelegate:
+  bool ReportListed(
+      const CrashReportDatabase::ReportSummary& summary) override {
+    ++count_;
+    return true;
+  }
+
+ private:
+  size_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingDelegate);
+};
+
+// Times each way of listing every report.
+bool MeasureScans(CrashReportDatabase* database, unsigned int iterations) {
+  Latencies pending;
+  Latencies completed;
+  Latencies listed;
+  for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+    std::vector<CrashReportDatabase::Report> pending_reports;
+    uint64_t start_time = ClockMonotonicNanoseconds();
+    if (database->GetPendingReports(&pending_reports) !=
+        CrashReportDatabase::kNoError) {
+      return false;
+    }
+    pending.Add(ClockMonotonicNanoseconds() - start_time);
+
+    std::vector<CrashReportDatabase::Report> completed_reports;
+    start_time = ClockMonotonicNanoseconds();
+    if (database->GetCompletedReports(&completed_reports) !=
+        CrashReportDatabase::kNoError) {
+      return false;
+    }
+    completed.Add(ClockMonotonicNanoseconds() - start_time);
+
+    CountingDelegate delegate;
+    start_time = ClockMonotonicNanoseconds();
+    if (database->ListReports(CrashReportDatabase::ReportFilter(),
+                              &delegate) != CrashReportDatabase::kNoError) {
+      return false;
+    }
+    listed.Add(ClockMonotonicNanoseconds() - start_time);
+  }
+
+  PrintHeader("scan");
+  pending.Print("GetPendingReports");
+  completed.Print("GetCompletedReports");
+  listed.Print("ListReports");
+  return true;
+}
+
+// Writes reports through a database instance of its own, as a separate
+// handler process would.
+class WriterThread final : public Thread {
+ public:
+  WriterThread(const base::FilePath& path,
+               const std::string* contents,
+               unsigned int report_count,
+               std::atomic<unsigned int>* finished_count)
+      : Thread(),
+        path_(path),
+        prepare_(),
+        finish_(),
+        contents_(contents),
+        finished_count_(finished_count),
+        report_count_(report_count),
+        successful_(false) {}
+
+  ~WriterThread() override {}
+
+  const Latencies& prepare() const { return prepare_; }
+  const Latencies& finish() const { return finish_; }
+  bool successful() const { return successful_; }
+
+ private:
+  // Thread:
+  void ThreadMain() override {
+    successful_ = WriteReports();
+    ++*finished_count_;
+  }
+
+  bool WriteReports() {
+    std::unique_ptr<CrashReportDatabase> database =
+        CrashReportDatabase::InitializeWithoutCreating(path_);
+    if (!database) {
+      return false;
+    }
+    for (unsigned int index = 0; index < report_count_; ++index) {
+      UUID uuid;
+      if (!WriteReport(
+              database.get(), *contents_, &prepare_, &finish_, &uuid)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  base::FilePath path_;
+  Latencies prepare_;
+  Latencies finish_;
+  const std::string* contents_;  // weak
+  std::atomic<unsigned int>* finished_count_;  // weak
+  unsigned int report_count_;
+  bool successful_;
+
+  DISALLOW_COPY_AND_ASSIGN(WriterThread);
+};
+
+// Runs |writer_count| concurrent writers, each with its own database
+// instance, while |database| repeatedly scans for pending reports, as the
+// upload thread does.
+bool MeasureContention(CrashReportDatabase* database,
+                       const base::FilePath& path,
+                       const std::string& contents,
+                       unsigned int writer_count,
+                       unsigned int reports_per_writer) {
+  std::atomic<unsigned int> finished_count(0);
+  std::vector<std::unique_ptr<WriterThread>> writers;
+  for (unsigned int index = 0; index < writer_count; ++index) {
+    writers.push_back(std::unique_ptr<WriterThread>(new WriterThread(
+        path, &contents, reports_per_writer, &finished_count)));
+  }
+
+  const uint64_t start_time = ClockMonotonicNanoseconds();
+  for (const auto& writer : writers) {
+    writer->Start();
+  }
+
+  // Scan at least once, so that the reader’s cost is always reported, and
+  // then until every writer has finished.
+  Latencies scans;
+  bool scanned = true;
+  do {
+    std::vector<CrashReportDatabase::Report> reports;
+    const uint64_t scan_start_time = ClockMonotonicNanoseconds();
+    if (database->GetPendingReports(&reports) !=
+        CrashReportDatabase::kNoError) {
+      scanned = false;
+    }
+    scans.Add(ClockMonotonicNanoseconds() - scan_start_time);
+  } while (finished_count < writer_count);
+
+  Latencies prepare;
+  Latencies finish;
+  bool successful = scanned;
+  for (const auto& writer : writers) {
+    writer->Join();
+    successful = successful && writer->successful();
+    prepare.Append(writer->prepare());
+    finish.Append(writer->finish());
+  }
+  const uint64_t elapsed_ns = ClockMonotonicNanoseconds() - start_time;
+  if (!successful) {
+    return false;
+  }
+
+  PrintHeader("contention");
+  prepare.Print("PrepareNewCrashReport");
+  finish.Print("FinishedWritingCrashReport");
+  scans.Print("GetPendingReports");
+  printf("%u writers, %.1f reports/s\n",
+         writer_count,
+         prepare.count() * 1E9 / std::max(elapsed_ns, uint64_t{1}));
+  return true;
+}
+
+// Times a prune pass that deletes nothing, and one that deletes the oldest
+// tenth of the reports.
+void MeasurePrune(CrashReportDatabase* database, size_t total_size_in_kb) {
+  PrintHeader("prune");
+
+  Latencies keep_all;
+  DatabaseSizePruneCondition keep_all_condition(total_size_in_kb * 2);
+  uint64_t start_time = ClockMonotonicNanoseconds();
+  PruneCrashReportDatabase(database, &keep_all_condition);
+  keep_all.Add(ClockMonotonicNanoseconds() - start_time);
+  keep_all.Print("prune, keeping all");
+
+  Latencies prune_tenth;
+  DatabaseSizePruneCondition prune_tenth_condition(total_size_in_kb / 10 * 9);
+  start_time = ClockMonotonicNanoseconds();
+  PruneCrashReportDatabase(database, &prune_tenth_condition);
+  prune_tenth.Add(ClockMonotonicNanoseconds() - start_time);
+  prune_tenth.Print("prune, deleting oldest 10%");
+}
+
+void Usage(const base::FilePath& me) {
+  fprintf(stderr,
+"Usage: %" PRFilePath " [OPTION]...\n"
+"Measure the cost of crash report database operations as the database grows,\n"
+"and under contention from concurrent writers.\n"
+"\n"
+"  -d, --database=PATH           use the database at PATH, which should be\n"
+"                                empty, instead of a temporary one\n"
+"  -i, --iterations=COUNT        repeat each scan COUNT times (10)\n"
+"  -n, --reports=COUNT           populate the database with COUNT reports\n"
+"                                (10000)\n"
+"  -s, --report-size=BYTES       make each report BYTES bytes long (4096)\n"
+"  -w, --writers=COUNT           run COUNT concurrent writers (4)\n"
+"  -k, --writer-reports=COUNT    have each writer add COUNT reports (250)\n"
+"      --help                    display this help and exit\n"
+"      --version                 output version information and exit\n",
+          me.value().c_str());
+  ToolSupport::UsageTail(me);
+}
+
+int CrashReportDatabaseBenchmarkMain(int argc, char* argv[]) {
+  const base::FilePath argv0(
+      ToolSupport::CommandLineArgumentToFilePathStringType(argv[0]));
+  const base::FilePath me(argv0.BaseName());
+
+  enum OptionFlags {
+    // “Short” (single-character) options.
+    kOptionDatabase = 'd',
+    kOptionIterations = 'i',
+    kOptionWriterReports = 'k',
+    kOptionReports = 'n',
+    kOptionReportSize = 's',
+    kOptionWriters = 'w',
+
+    // Long options without short equivalents.
+    kOptionLastChar = 255,
+
+    // Standard options.
+    kOptionHelp = -2,
+    kOptionVersion = -3,
+  };
+
+  const char* database_path = nullptr;
+  unsigned int iterations = 10;
+  unsigned int report_count = 10000;
+  unsigned int report_size = 4096;
+  unsigned int writer_count = 4;
+  unsigned int reports_per_writer = 250;
+
+  static constexpr option long_options[] = {
+      {"database", required_argument, nullptr, kOptionDatabase},
+      {"iterations", required_argument, nullptr, kOptionIterations},
+      {"reports", required_argument, nullptr, kOptionReports},
+      {"report-size", required_argument, nullptr, kOptionReportSize},
+      {"writers", required_argument, nullptr, kOptionWriters},
+      {"writer-reports", required_argument, nullptr, kOptionWriterReports},
+      {"help", no_argument, nullptr, kOptionHelp},
+      {"version", no_argument, nullptr, kOptionVersion},
+      {nullptr, 0, nullptr, 0},
+  };
+
+  int opt;
+  while ((opt = getopt_long(
+              argc, argv, "d:i:k:n:s:w:", long_options, nullptr)) != -1) {
+    unsigned int* value;
+    switch (opt) {
+      case kOptionDatabase:
+        database_path = optarg;
+        continue;
+      case kOptionIterations:
+        value = &iterations;
+        break;
+      case kOptionWriterReports:
+        value = &reports_per_writer;
+        break;
+      case kOptionReports:
+        value = &report_count;
+        break;
+      case kOptionReportSize:
+        value = &report_size;
+        break;
+      case kOptionWriters:
+        value = &writer_count;
+        break;
+      case kOptionHelp:
+        Usage(me);
+        return EXIT_SUCCESS;
+      case kOptionVersion:
+        ToolSupport::Version(me);
+        return EXIT_SUCCESS;
+      default:
+        ToolSupport::UsageHint(me, nullptr);
+        return EXIT_FAILURE;
+    }
+
+    if (!StringToNumber(optarg, value)) {
+      ToolSupport::UsageHint(me, "numeric value required");
+      return EXIT_FAILURE;
+    }
+  }
+  argc -= optind;
+  argv += optind;
+
+  if (argc != 0 || iterations == 0) {
+    ToolSupport::UsageHint(me, nullptr);
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<test::ScopedTempDir> temp_dir;
+  base::FilePath path;
+  if (database_path) {
+    path = base::FilePath(
+        ToolSupport::CommandLineArgumentToFilePathStringType(database_path));
+  } else {
+    temp_dir.reset(new test::ScopedTempDir());
+    path = temp_dir->path();
+  }
+
+  std::unique_ptr<CrashReportDatabase> database =
+      CrashReportDatabase::Initialize(path);
+  if (!database) {
+    return EXIT_FAILURE;
+  }
+
+  const std::string contents(report_size, 'r');
+  printf("%u reports of %u bytes, %u iterations, %u writers of %u reports\n",
+         report_count,
+         report_size,
+         iterations,
+         writer_count,
+         reports_per_writer);
+
+  // Populate the database, reporting latencies for each tenth of the reports
+  // written so that any growth with the size of the database shows. Every
+  // other report is completed, so that both states are populated.
+  PrintHeader("populate");
+  constexpr unsigned int kSteps = 10;
+  for (unsigned int step = 0; step < kSteps; ++step) {
+    Latencies prepare;
+    Latencies finish;
+    Latencies complete;
+    const unsigned int begin = report_count * step / kSteps;
+    const unsigned int end = report_count * (step + 1) / kSteps;
+    for (unsigned int index = begin; index < end; ++index) {
+      UUID uuid;
+      if (!WriteReport(database.get(), contents, &prepare, &finish, &uuid) ||
+          (index % 2 && !CompleteReport(database.get(), uuid, &complete))) {
+        return EXIT_FAILURE;
+      }
+    }
+
+    printf("-- reports %u to %u\n", begin, end);
+    prepare.Print("PrepareNewCrashReport");
+    finish.Print("FinishedWritingCrashReport");
+    complete.Print("RecordUploadAttempt");
+  }
+
+  if (!MeasureScans(database.get(), iterations) ||
+      !MeasureContention(database.get(),
+                         path,
+                         contents,
+                         writer_count,
+                         reports_per_writer)) {
+    return EXIT_FAILURE;
+  }
+
+  const size_t total_reports =
+      report_count + size_t{writer_count} * reports_per_writer;
+  const size_t report_size_in_kb = (report_size + 1023) / 1024;
+  MeasurePrune(database.get(), total_reports * report_size_in_kb);
+
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+}  // namespace crashpad
+
+#if defined(OS_POSIX)
+int main(int argc, char* argv[]) {
+  return crashpad::CrashReportDatabaseBenchmarkMain(argc, argv);
+}
+#elif defined(OS_WIN)
+int wmain(int argc, wchar_t* argv[]) {
+  return crashpad::ToolSupport::Wmain(
+      argc, argv, crashpad::CrashReportDatabaseBenchmarkMain);
+}
+#endif  // OS_POSIX
@@ -0,0 +1,1007 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/crash_report_database.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "client/settings.h"
+#include "util/file/directory_change_watcher.h"
+#include "util/file/file_io.h"
+#include "util/misc/initialization_state_dcheck.h"
+#include "util/misc/metrics.h"
+#include "util/posix/scoped_mmap.h"
+
+namespace crashpad {
+
+namespace {
+
+constexpr char kReportsDirectory[] = "reports";
+constexpr char kUploadParametersDirectory[] = "upload_parameters";
+constexpr char kAttachmentsDirectory[] = "attachments";
+constexpr char kIndexFileName[] = "metadata";
+
+constexpr char kSettings[] = "settings.dat";
+
+constexpr char kCrashReportFileExtension[] = "dmp";
+
+constexpr uint32_t kIndexFileHeaderMagic = 'CPLI';
+constexpr uint32_t kIndexFileVersion = 1;
+
+using OperationStatus = CrashReportDatabase::OperationStatus;
+
+// Helpers ---------------------------------------------------------------------
+
+// Ensures that the node at |path| is a directory. If the |path| refers to a
+// file, rather than a directory, returns false. Otherwise, returns true,
+// indicating that |path| already was a directory.
+bool EnsureDirectoryExists(const base::FilePath& path) {
+  struct stat st;
+  if (stat(path.value().c_str(), &st) != 0) {
+    PLOG(ERROR) << "stat " << path.value();
+    return false;
+  }
+  if (!S_ISDIR(st.st_mode)) {
+    LOG(ERROR) << "stat " << path.value() << ": not a directory";
+    return false;
+  }
+  return true;
+}
+
+// Ensures that the node at |path| is a directory, and creates it if it does
+// not exist. If the |path| refers to a file, rather than a directory, or the
+// directory could not be created, returns false. Otherwise, returns true,
+// indicating that |path| already was or now is a directory.
+bool CreateOrEnsureDirectoryExists(const base::FilePath& path) {
+  if (mkdir(path.value().c_str(), 0755) == 0) {
+    return true;
+  }
+  if (errno != EEXIST) {
+    PLOG(ERROR) << "mkdir " << path.value();
+    return false;
+  }
+  return EnsureDirectoryExists(path);
+}
+
+// Helper structures, and conversions ------------------------------------------
+
+// The on disk index file is an IndexFileHeader followed by a number of fixed
+// size IndexRecords, one for each report. A record whose UUID is zero is a free
+// slot, which may be reused by a later report. Records are laid out as in the
+// Windows implementation’s MetadataFileReportRecord, except that the file path
+// is implied by the UUID and the ID is stored inline, so that no string table
+// is needed and each record can be rewritten independently.
+//
+// Both structures are 128 bytes, so that every record lies within a single
+// page, and a record is always written with a single pwrite(). Readers hold a
+// shared lock on the file, and writers an exclusive lock, so a reader never
+// observes a record that is partially written. A trailing partial record, left
+// by a crash while the file was being extended, is ignored.
+
+enum class ReportState : int32_t {
+  //! \brief Created and filled out by caller, owned by database.
+  kPending,
+  //! \brief In the process of uploading, owned by caller.
+  kUploading,
+  //! \brief Upload completed or skipped, owned by database.
+  kCompleted,
+};
+
+enum : uint8_t {
+  //! \brief Corresponds to uploaded bit of the report state.
+  kAttributeUploaded = 1 << 0,
+
+  //! \brief Corresponds to upload_explicity_requested bit of the report state.
+  kAttributeUploadExplicitlyRequested = 1 << 1,
+
+  //! \brief Corresponds to dump_without_crash bit of the report state.
+  kAttributeDumpWithoutCrash = 1 << 2,
+};
+
+struct IndexFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;
+  uint8_t padding[116];
+};
+
+struct IndexRecord {
+  UUID uuid;  // UUID is a 16 byte, standard layout structure.
+  int64_t creation_time;  // Holds a time_t.
+  int64_t last_upload_attempt_time;  // Holds a time_t.
+  int32_t upload_attempts;
+  int32_t state;  // A ReportState.
+  uint8_t attributes;  // Bitfield of kAttribute*.
+  uint8_t id_length;
+  uint8_t padding[2];
+  uint32_t size_in_kb;  // 0 in records written before sizes were recorded.
+  char id[80];  // Not \0 terminated.
+};
+
+static_assert(sizeof(IndexRecord) == 128, "IndexRecord size");
+static_assert(sizeof(IndexFileHeader) == sizeof(IndexRecord),
+              "IndexFileHeader size");
+
+// Returns the path of the report identified by |uuid|.
+base::FilePath ReportPath(const base::FilePath& report_dir, const UUID& uuid) {
+  return report_dir.Append(uuid.ToString() + "." + kCrashReportFileExtension);
+}
+
+// Fills |report| from |record|.
+void ReportFromRecord(const IndexRecord& record,
+                      const base::FilePath& report_dir,
+                      CrashReportDatabase::Report* report) {
+  report->uuid = record.uuid;
+  report->file_path = ReportPath(report_dir, record.uuid);
+  report->id.assign(record.id,
+                    std::min(static_cast<size_t>(record.id_length),
+                             sizeof(record.id)));
+  report->creation_time = record.creation_time;
+  report->uploaded = (record.attributes & kAttributeUploaded) != 0;
+  report->last_upload_attempt_time = record.last_upload_attempt_time;
+  report->upload_attempts = record.upload_attempts;
+  report->upload_explicitly_requested =
+      (record.attributes & kAttributeUploadExplicitlyRequested) != 0;
+  report->dump_without_crash =
+      (record.attributes & kAttributeDumpWithoutCrash) != 0;
+  report->size_in_kb = record.size_in_kb;
+}
+
+// Fills |summary| from |record|, which must be pending or completed.
+void SummaryFromRecord(const IndexRecord& record,
+                       CrashReportDatabase::ReportSummary* summary) {
+  summary->uuid = record.uuid;
+  summary->creation_time = record.creation_time;
+  summary->last_upload_attempt_time = record.last_upload_attempt_time;
+  summary->upload_attempts = record.upload_attempts;
+  summary->size_in_kb = record.size_in_kb;
+  summary->pending =
+      record.state == static_cast<int32_t>(ReportState::kPending);
+  summary->uploaded = (record.attributes & kAttributeUploaded) != 0;
+  summary->upload_explicitly_requested =
+      (record.attributes & kAttributeUploadExplicitlyRequested) != 0;
+  summary->dump_without_crash =
+      (record.attributes & kAttributeDumpWithoutCrash) != 0;
+}
+
+// Stores |id| in |record|, truncating it if it does not fit.
+void SetRecordID(const std::string& id, IndexRecord* record) {
+  size_t length = id.size();
+  if (length > sizeof(record->id)) {
+    LOG(WARNING) << "report ID " << id << " truncated";
+    length = sizeof(record->id);
+  }
+  memset(record->id, 0, sizeof(record->id));
+  memcpy(record->id, id.data(), length);
+  record->id_length = static_cast<uint8_t>(length);
+}
+
+// Sets or clears |attribute| in |record|.
+void SetRecordAttribute(uint8_t attribute, bool set, IndexRecord* record) {
+  if (set) {
+    record->attributes |= attribute;
+  } else {
+    record->attributes &= ~attribute;
+  }
+}
+
+// Index -----------------------------------------------------------------------
+
+//! \brief Provides locked access to the index file, mapped into memory for
+//!     queries.
+class Index {
+ public:
+  //! \brief Unmaps, unlocks, and closes the index file.
+  ~Index();
+
+  //! \brief Opens, locks, and maps the index file.
+  //!
+  //! \param[in] index_file The path to the index file, which is created if it
+  //!     does not exist.
+  //! \param[in] locking FileLocking::kShared for queries, or
+  //!     FileLocking::kExclusive to permit changes.
+  //!
+  //! \return The index, or `nullptr` with a message logged on failure. If the
+  //!     index file is damaged, it is treated as empty, and is reinitialized
+  //!     if \a locking is FileLocking::kExclusive. This means that existing
+  //!     crash reports have been orphaned.
+  static std::unique_ptr<Index> Open(const base::FilePath& index_file,
+                                     FileLocking locking);
+
+  //! \brief The number of record slots in the index, including free ones.
+  size_t record_count() const { return record_count_; }
+
+  //! \brief Returns the record in \a slot, which must be less than
+  //!     record_count().
+  const IndexRecord& RecordAt(size_t slot) const;
+
+  //! \brief Finds the record for the report identified by \a uuid.
+  //!
+  //! \param[in] uuid The report identifier.
+  //! \param[out] slot The slot holding the report’s record.
+  //!
+  //! \return `true` if the report was found, `false` otherwise.
+  bool FindRecord(const UUID& uuid, size_t* slot) const;
+
+  //! \brief Replaces the record in \a slot with \a record. Requires an
+  //!     exclusive lock.
+  //!
+  //! \return `true` on success, `false` with a message logged on failure.
+  bool WriteRecord(size_t slot, const IndexRecord& record);
+
+  //! \brief Stores \a record in the first free slot, extending the file if
+  //!     there is none. Requires an exclusive lock.
+  //!
+  //! A record added beyond the end of the mapping established by Open() is
+  //! not visible through this object.
+  //!
+  //! \return `true` on success, `false` with a message logged on failure.
+  bool AddRecord(const IndexRecord& record);
+
+ private:
+  explicit Index(FileHandle handle);
+
+  ScopedFileHandle handle_;
+  ScopedMmap mapping_;
+  size_t record_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(Index);
+};
+
+Index::~Index() {
+  mapping_.Reset();
+  LoggingUnlockFile(handle_.get());
+}
+
+// static
+std::unique_ptr<Index> Index::Open(const base::FilePath& index_file,
+                                   FileLocking locking) {
+  ScopedFileHandle handle(LoggingOpenFileForReadAndWrite(
+      index_file, FileWriteMode::kReuseOrCreate, FilePermissions::kOwnerOnly));
+  if (!handle.is_valid() || !LoggingLockFile(handle.get(), locking))
+    return std::unique_ptr<Index>();
+
+  std::unique_ptr<Index> index(new Index(handle.release()));
+
+  struct stat st;
+  if (fstat(index->handle_.get(), &st) != 0) {
+    PLOG(ERROR) << "fstat " << index_file.value();
+    return std::unique_ptr<Index>();
+  }
+  const size_t file_size = static_cast<size_t>(st.st_size);
+
+  bool valid = false;
+  if (file_size >= sizeof(IndexFileHeader)) {
+    IndexFileHeader header;
+    if (LoggingReadFileExactly(index->handle_.get(), &header, sizeof(header)) &&
+        header.magic == kIndexFileHeaderMagic &&
+        header.version == kIndexFileVersion &&
+        header.record_size == sizeof(IndexRecord)) {
+      valid = true;
+    } else {
+      LOG(ERROR) << "unexpected index header";
+    }
+  }
+
+  if (!valid) {
+    if (locking != FileLocking::kExclusive)
+      return index;
+
+    if (HANDLE_EINTR(ftruncate(index->handle_.get(), 0)) != 0) {
+      PLOG(ERROR) << "ftruncate " << index_file.value();
+      return std::unique_ptr<Index>();
+    }
+    IndexFileHeader header = {};
+    header.magic = kIndexFileHeaderMagic;
+    header.version = kIndexFileVersion;
+    header.record_size = sizeof(IndexRecord);
+    if (HANDLE_EINTR(pwrite(
+            index->handle_.get(), &header, sizeof(header), 0)) !=
+        static_cast<ssize_t>(sizeof(header))) {
+      PLOG(ERROR) << "pwrite " << index_file.value();
+      return std::unique_ptr<Index>();
+    }
+    return index;
+  }
+
+  index->record_count_ =
+      (file_size - sizeof(IndexFileHeader)) / sizeof(IndexRecord);
+
+  // Mappings are made in whole pages. The part of the last page beyond the end
+  // of the file reads as zero, and no record is read from it.
+  const size_t page_size = getpagesize();
+  const size_t mapping_size =
+      (sizeof(IndexFileHeader) + index->record_count_ * sizeof(IndexRecord) +
+       page_size - 1) /
+      page_size * page_size;
+  if (index->record_count_ > 0 &&
+      !index->mapping_.ResetMmap(nullptr,
+                                 mapping_size,
+                                 PROT_READ,
+                                 MAP_SHARED,
+                                 index->handle_.get(),
+                                 0)) {
+    return std::unique_ptr<Index>();
+  }
+
+  return index;
+}
+
+const IndexRecord& Index::RecordAt(size_t slot) const {
+  DCHECK_LT(slot, record_count_);
+
+  // The header occupies the first record-sized slot in the file.
+  return mapping_.addr_as<const IndexRecord*>()[slot + 1];
+}
+
+bool Index::FindRecord(const UUID& uuid, size_t* slot) const {
+  DCHECK(uuid != UUID());
+  for (size_t index = 0; index < record_count_; ++index) {
+    if (RecordAt(index).uuid == uuid) {
+      *slot = index;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Index::WriteRecord(size_t slot, const IndexRecord& record) {
+  const off_t offset = sizeof(IndexFileHeader) + slot * sizeof(IndexRecord);
+  if (HANDLE_EINTR(pwrite(handle_.get(), &record, sizeof(record), offset)) !=
+      static_cast<ssize_t>(sizeof(record))) {
+    PLOG(ERROR) << "pwrite";
+    return false;
+  }
+  return true;
+}
+
+bool Index::AddRecord(const IndexRecord& record) {
+  size_t slot = 0;
+  while (slot < record_count_ && RecordAt(slot).uuid != UUID()) {
+    ++slot;
+  }
+  return WriteRecord(slot, record);
+}
+
+Index::Index(FileHandle handle)
+    : handle_(handle), mapping_(), record_count_(0) {
+}
+
+// CrashReportDatabaseLinux ----------------------------------------------------
+
+//! \brief A CrashReportDatabase that keeps report metadata in a memory-mapped
+//!     index of fixed size records.
+class CrashReportDatabaseLinux : public CrashReportDatabase {
+ public:
+  explicit CrashReportDatabaseLinux(const base::FilePath& path);
+  ~CrashReportDatabaseLinux() override;
+
+  bool Initialize(bool may_create);
+
+  // CrashReportDatabase:
+  Settings* GetSettings() override;
+  OperationStatus PrepareNewCrashReport(NewReport** report) override;
+  OperationStatus FinishedWritingCrashReport(NewReport* report,
+                                             UUID* uuid) override;
+  OperationStatus ErrorWritingCrashReport(NewReport* report) override;
+  OperationStatus LookUpCrashReport(const UUID& uuid, Report* report) override;
+  OperationStatus GetPendingReports(std::vector<Report>* reports) override;
+  OperationStatus GetCompletedReports(std::vector<Report>* reports) override;
+  OperationStatus GetReportForUploading(const UUID& uuid,
+                                        const Report** report) override;
+  OperationStatus RecordUploadAttempt(const Report* report,
+                                      bool successful,
+                                      const std::string& id) override;
+  OperationStatus SkipReportUpload(const UUID& uuid,
+                                   Metrics::CrashSkippedReason reason) override;
+  OperationStatus DeleteReport(const UUID& uuid) override;
+  OperationStatus RequestUpload(const UUID& uuid) override;
+  bool WatchPendingReports(DirectoryChangeWatcher* watcher) override;
+  OperationStatus ListReports(const ReportFilter& filter,
+                              ListReportsDelegate* delegate) override;
+  OperationStatus DeleteReports(const ReportFilter& filter,
+                                size_t* deleted_count) override;
+  OperationStatus RequestUploads(const ReportFilter& filter,
+                                 size_t* requested_count) override;
+
+ protected:
+  void FlushReportRecords() override;
+
+ private:
+  std::unique_ptr<Index> AcquireIndex(FileLocking locking);
+
+  //! \brief Reports, in the order recorded in the index, in a given state.
+  //!
+  //! Unlike the operations on a single report, this does not confirm that each
+  //! report’s file still exists, so that it needs nothing beyond a scan of the
+  //! index.
+  OperationStatus ReportsInState(ReportState desired_state,
+                                 std::vector<Report>* reports);
+
+  //! \brief Finds the report identified by \a uuid in \a index, as in the
+  //!     Windows implementation’s Metadata::FindSingleReportAndMarkDirty().
+  //!
+  //! \param[in] index The locked index.
+  //! \param[in] uuid The report identifier.
+  //! \param[in] desired_state The state to match.
+  //! \param[out] slot The slot holding the report’s record.
+  //! \param[out] record A copy of the report’s record.
+  //!
+  //! \return #kNoError on success. #kReportNotFound if there was no report with
+  //!     the specified UUID or its file no longer exists, or if the report was
+  //!     not in the specified state and was not uploading. #kBusyError if the
+  //!     report was not in the specified state and was uploading.
+  OperationStatus FindReport(const Index& index,
+                             const UUID& uuid,
+                             ReportState desired_state,
+                             size_t* slot,
+                             IndexRecord* record);
+
+  //! \brief Confirms that the file of the report identified by \a uuid exists.
+  OperationStatus VerifyReportFile(const UUID& uuid);
+
+  base::FilePath base_dir_;
+  base::FilePath report_dir_;
+  Settings settings_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(CrashReportDatabaseLinux);
+};
+
+CrashReportDatabaseLinux::CrashReportDatabaseLinux(const base::FilePath& path)
+    : CrashReportDatabase(),
+      base_dir_(path),
+      report_dir_(base_dir_.Append(kReportsDirectory)),
+      settings_(base_dir_.Append(kSettings)),
+      initialized_() {
+}
+
+CrashReportDatabaseLinux::~CrashReportDatabaseLinux() {
+}
+
+bool CrashReportDatabaseLinux::Initialize(bool may_create) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  // Ensure the database directory exists.
+  if (may_create) {
+    if (!CreateOrEnsureDirectoryExists(base_dir_))
+      return false;
+  } else if (!EnsureDirectoryExists(base_dir_)) {
+    return false;
+  }
+
+  // Ensure that the report subdirectory exists.
+  if (!CreateOrEnsureDirectoryExists(report_dir_))
+    return false;
+
+  // Spare report files are named so that they’re never taken for reports.
+  SetSpareReportFileDirectory(report_dir_);
+
+  // Upload parameters are kept apart from reports, so that recording them
+  // doesn’t disturb anything watching the report subdirectory.
+  const base::FilePath upload_parameters_dir =
+      base_dir_.Append(kUploadParametersDirectory);
+  if (!CreateOrEnsureDirectoryExists(upload_parameters_dir))
+    return false;
+  SetUploadParametersDirectory(upload_parameters_dir);
+
+  // Attached files are cloned into the database, so they must be on the same
+  // file system as the files attached.
+  const base::FilePath attachments_dir =
+      base_dir_.Append(kAttachmentsDirectory);
+  if (!CreateOrEnsureDirectoryExists(attachments_dir))
+    return false;
+  SetAttachmentsDirectory(attachments_dir);
+
+  if (!settings_.Initialize())
+    return false;
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+Settings* CrashReportDatabaseLinux::GetSettings() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return &settings_;
+}
+
+OperationStatus CrashReportDatabaseLinux::PrepareNewCrashReport(
+    NewReport** report) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::unique_ptr<NewReport> new_report(new NewReport());
+  if (!new_report->uuid.InitializeWithNew())
+    return kFileSystemError;
+  new_report->path = ReportPath(report_dir_, new_report->uuid);
+  new_report->handle = OpenNewReportFile(new_report->path);
+  if (new_report->handle == kInvalidFileHandle)
+    return kFileSystemError;
+
+  *report = new_report.release();
+  return kNoError;
+}
+
+OperationStatus CrashReportDatabaseLinux::FinishedWritingCrashReport(
+    NewReport* report,
+    UUID* uuid) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Take ownership of the report.
+  std::unique_ptr<NewReport> scoped_report(report);
+  // Take ownership of the file handle.
+  ScopedFileHandle handle(report->handle);
+  FinishNewReportFile(handle.get());
+
+  WriteUploadParameters(*scoped_report);
+  WriteAttachments(*scoped_report);
+
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kExclusive));
+  if (!index) {
+    DeleteUploadParameters(scoped_report->uuid);
+    DeleteAttachments(scoped_report->uuid);
+    return kDatabaseError;
+  }
+
+  IndexRecord record = {};
+  record.uuid = scoped_report->uuid;
+  record.creation_time = time(nullptr);
+  record.state = static_cast<int32_t>(ReportState::kPending);
+  SetRecordAttribute(
+      kAttributeDumpWithoutCrash, scoped_report->dump_without_crash, &record);
+  record.size_in_kb = ReportSizeInKB(LoggingFileSizeByHandle(handle.get()));
+  if (!index->AddRecord(record)) {
+    DeleteUploadParameters(scoped_report->uuid);
+    DeleteAttachments(scoped_report->uuid);
+    return kDatabaseError;
+  }
+  index.reset();
+  CommitReportRecords();
+  *uuid = scoped_report->uuid;
+
+  Metrics::CrashReportPending(Metrics::PendingReportReason::kNewlyCreated);
+  Metrics::CrashReportSize(handle.get());
+
+  return kNoError;
+}
+
+OperationStatus CrashReportDatabaseLinux::ErrorWritingCrashReport(
+    NewReport* report) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Take ownership of the report.
+  std::unique_ptr<NewReport> scoped_report(report);
+
+  // Close the outstanding handle.
+  LoggingCloseFile(report->handle);
+
+  // We failed to write, so remove the dump file. There's no entry in the
+  // index yet.
+  if (unlink(scoped_report->path.value().c_str()) != 0) {
+    PLOG(ERROR) << "unlink " << scoped_report->path.value();
+    return kFileSystemError;
+  }
+
+  return kNoError;
+}
+
+OperationStatus CrashReportDatabaseLinux::LookUpCrashReport(const UUID& uuid,
+                                                            Report* report) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kShared));
+  if (!index)
+    return kDatabaseError;
+
+  size_t slot;
+  if (!index->FindRecord(uuid, &slot))
+    return kReportNotFound;
+  OperationStatus os = VerifyReportFile(uuid);
+  if (os == kNoError)
+    ReportFromRecord(index->RecordAt(slot), report_dir_, report);
+  return os;
+}
+
+OperationStatus CrashReportDatabaseLinux::GetPendingReports(
+    std::vector<Report>* reports) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return ReportsInState(ReportState::kPending, reports);
+}
+
+OperationStatus CrashReportDatabaseLinux::GetCompletedReports(
+    std::vector<Report>* reports) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return ReportsInState(ReportState::kCompleted, reports);
+}
+
+OperationStatus CrashReportDatabaseLinux::GetReportForUploading(
+    const UUID& uuid,
+    const Report** report) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kExclusive));
+  if (!index)
+    return kDatabaseError;
+
+  size_t slot;
+  IndexRecord record;
+  OperationStatus os =
+      FindReport(*index, uuid, ReportState::kPending, &slot, &record);
+  if (os != kNoError)
+    return os;
+
+  record.state = static_cast<int32_t>(ReportState::kUploading);
+  if (!index->WriteRecord(slot, record))
+    return kDatabaseError;
+
+  // Create a copy for passing back to client. This will be freed in
+  // RecordUploadAttempt.
+  std::unique_ptr<Report> upload_report(new Report());
+  ReportFromRecord(record, report_dir_, upload_report.get());
+  *report = upload_report.release();
+  return kNoError;
+}
+
+OperationStatus CrashReportDatabaseLinux::RecordUploadAttempt(
+    const Report* report,
+    bool successful,
+    const std::string& id) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  Metrics::CrashUploadAttempted(successful);
+
+  // Take ownership, allocated in GetReportForUploading.
+  std::unique_ptr<const Report> upload_report(report);
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kExclusive));
+  if (!index)
+    return kDatabaseError;
+
+  size_t slot;
+  IndexRecord record;
+  OperationStatus os = FindReport(
+      *index, report->uuid, ReportState::kUploading, &slot, &record);
+  if (os != kNoError)
+    return os;
+
+  time_t now = time(nullptr);
+
+  SetRecordAttribute(kAttributeUploaded, successful, &record);
+  SetRecordID(id, &record);
+  record.last_upload_attempt_time = now;
+  record.upload_attempts++;
+  if (successful) {
+    record.state = static_cast<int32_t>(ReportState::kCompleted);
+    SetRecordAttribute(kAttributeUploadExplicitlyRequested, false, &record);
+  } else {
+    record.state = static_cast<int32_t>(ReportState::kPending);
+    SetRecordAttribute(kAttributeUploadExplicitlyRequested,
+                       report->upload_explicitly_requested,
+                       &record);
+  }
+
+  if (!index->WriteRecord(slot, record))
+    return kDatabaseError;
+
+  if (!settings_.SetLastUploadAttemptTime(now))
+    return kDatabaseError;
+
+  return kNoError;
+}
+
+OperationStatus CrashReportDatabaseLinux::SkipReportUpload(
+    const UUID& uuid,
+    Metrics::CrashSkippedReason reason) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  Metrics::CrashUploadSkipped(reason);
+
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kExclusive));
+  if (!index)
+    return kDatabaseError;
+
+  size_t slot;
+  IndexRecord record;
+  OperationStatus os =
+      FindReport(*index, uuid, ReportState::kPending, &slot, &record);
+  if (os != kNoError)
+    return os;
+
+  record.state = static_cast<int32_t>(ReportState::kCompleted);
+  SetRecordAttribute(kAttributeUploadExplicitlyRequested, false, &record);
+  return index->WriteRecord(slot, record) ? kNoError : kDatabaseError;
+}
+
+OperationStatus CrashReportDatabaseLinux::DeleteReport(const UUID& uuid) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kExclusive));
+  if (!index)
+    return kDatabaseError;
+
+  size_t slot;
+  if (!index->FindRecord(uuid, &slot))
+    return kReportNotFound;
+
+  // Free the slot.
+  IndexRecord record = {};
+  if (!index->WriteRecord(slot, record))
+    return kDatabaseError;
+
+  DeleteUploadParameters(uuid);
+  DeleteAttachments(uuid);
+  base::FilePath report_path = ReportPath(report_dir_, uuid);
+  if (unlink(report_path.value().c_str()) != 0) {
+    PLOG(ERROR) << "unlink " << report_path.value();
+    return kFileSystemError;
+  }
+  return kNoError;
+}
+
+OperationStatus CrashReportDatabaseLinux::RequestUpload(const UUID& uuid) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kExclusive));
+  if (!index)
+    return kDatabaseError;
+
+  size_t slot;
+  IndexRecord record;
+  OperationStatus os =
+      FindReport(*index, uuid, ReportState::kCompleted, &slot, &record);
+  if (os == kReportNotFound) {
+    os = FindReport(*index, uuid, ReportState::kPending, &slot, &record);
+  }
+
+  if (os != kNoError)
+    return os;
+
+  // If the crash report has already been uploaded, don't request new upload.
+  if (record.attributes & kAttributeUploaded)
+    return kCannotRequestUpload;
+
+  // Mark the crash report as having upload explicitly requested by the user,
+  // and move it to the pending state.
+  SetRecordAttribute(kAttributeUploadExplicitlyRequested, true, &record);
+  record.state = static_cast<int32_t>(ReportState::kPending);
+  if (!index->WriteRecord(slot, record))
+    return kDatabaseError;
+
+  Metrics::CrashReportPending(Metrics::PendingReportReason::kUserInitiated);
+
+  return kNoError;
+}
+
+bool CrashReportDatabaseLinux::WatchPendingReports(
+    DirectoryChangeWatcher* watcher) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // New reports are written to the reports directory, and their index records
+  // are added before their files are closed, at which point the watcher is
+  // notified.
+  return watcher->Initialize(report_dir_);
+}
+
+void CrashReportDatabaseLinux::FlushReportRecords() {
+  // New reports’ files are created in the reports directory, and their records
+  // are written to the index in place. No lock is needed to flush the index,
+  // since flushing a record that another instance is writing does no harm.
+  ScopedFileHandle index_file(
+      LoggingOpenFileForRead(base_dir_.Append(kIndexFileName)));
+  if (index_file.is_valid()) {
+    LoggingFlushFile(index_file.get());
+  }
+  LoggingFlushDirectory(report_dir_);
+}
+
+std::unique_ptr<Index> CrashReportDatabaseLinux::AcquireIndex(
+    FileLocking locking) {
+  return Index::Open(base_dir_.Append(kIndexFileName), locking);
+}
+
+OperationStatus CrashReportDatabaseLinux::ListReports(
+    const ReportFilter& filter,
+    ListReportsDelegate* delegate) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // The shared lock is held throughout, so the records listed are a consistent
+  // view of the index. Records are read in place from the mapping.
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kShared));
+  if (!index)
+    return kDatabaseError;
+
+  for (size_t slot = 0; slot < index->record_count(); ++slot) {
+    const IndexRecord& record = index->RecordAt(slot);
+    if (record.uuid == UUID() ||
+        (record.state != static_cast<int32_t>(ReportState::kPending) &&
+         record.state != static_cast<int32_t>(ReportState::kCompleted))) {
+      continue;
+    }
+    ReportSummary summary;
+    SummaryFromRecord(record, &summary);
+    if (filter.Matches(summary) && !delegate->ReportListed(summary))
+      break;
+  }
+  return kNoError;
+}
+
+OperationStatus CrashReportDatabaseLinux::DeleteReports(
+    const ReportFilter& filter,
+    size_t* deleted_count) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // The exclusive lock is held throughout, so no other process sees the index
+  // with only some of the records freed.
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kExclusive));
+  if (!index)
+    return kDatabaseError;
+
+  OperationStatus os = kNoError;
+  size_t count = 0;
+  for (size_t slot = 0; slot < index->record_count(); ++slot) {
+    const IndexRecord& record = index->RecordAt(slot);
+    if (record.uuid == UUID() ||
+        (record.state != static_cast<int32_t>(ReportState::kPending) &&
+         record.state != static_cast<int32_t>(ReportState::kCompleted))) {
+      continue;
+    }
+    ReportSummary summary;
+    SummaryFromRecord(record, &summary);
+    if (!filter.Matches(summary))
+      continue;
+
+    // Free the slot.
+    IndexRecord free_record = {};
+    if (!index->WriteRecord(slot, free_record)) {
+      os = kDatabaseError;
+      continue;
+    }
+
+    ++count;
+    DeleteUploadParameters(summary.uuid);
+    DeleteAttachments(summary.uuid);
+    base::FilePath report_path = ReportPath(report_dir_, summary.uuid);
+    if (unlink(report_path.value().c_str()) != 0) {
+      PLOG(ERROR) << "unlink " << report_path.value();
+      os = kFileSystemError;
+    }
+  }
+
+  if (deleted_count)
+    *deleted_count = count;
+  return os;
+}
+
+OperationStatus CrashReportDatabaseLinux::RequestUploads(
+    const ReportFilter& filter,
+    size_t* requested_count) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kExclusive));
+  if (!index)
+    return kDatabaseError;
+
+  OperationStatus os = kNoError;
+  size_t count = 0;
+  for (size_t slot = 0; slot < index->record_count(); ++slot) {
+    IndexRecord record = index->RecordAt(slot);
+    if (record.uuid == UUID() ||
+        (record.state != static_cast<int32_t>(ReportState::kPending) &&
+         record.state != static_cast<int32_t>(ReportState::kCompleted)) ||
+        (record.attributes & kAttributeUploaded)) {
+      continue;
+    }
+    ReportSummary summary;
+    SummaryFromRecord(record, &summary);
+    if (!filter.Matches(summary))
+      continue;
+
+    // As in RequestUpload().
+    SetRecordAttribute(kAttributeUploadExplicitlyRequested, true, &record);
+    record.state = static_cast<int32_t>(ReportState::kPending);
+    if (!index->WriteRecord(slot, record)) {
+      os = kDatabaseError;
+      continue;
+    }
+
+    ++count;
+    Metrics::CrashReportPending(Metrics::PendingReportReason::kUserInitiated);
+  }
+
+  if (requested_count)
+    *requested_count = count;
+  return os;
+}
+
+OperationStatus CrashReportDatabaseLinux::ReportsInState(
+    ReportState desired_state,
+    std::vector<Report>* reports) {
+  DCHECK(reports->empty());
+
+  std::unique_ptr<Index> index(AcquireIndex(FileLocking::kShared));
+  if (!index)
+    return kDatabaseError;
+
+  for (size_t slot = 0; slot < index->record_count(); ++slot) {
+    const IndexRecord& record = index->RecordAt(slot);
+    if (record.uuid == UUID() ||
+        record.state != static_cast<int32_t>(desired_state)) {
+      continue;
+    }
+    reports->push_back(Report());
+    ReportFromRecord(record, report_dir_, &reports->back());
+  }
+  return kNoError;
+}
+
+OperationStatus CrashReportDatabaseLinux::FindReport(const Index& index,
+                                                     const UUID& uuid,
+                                                     ReportState desired_state,
+                                                     size_t* slot,
+                                                     IndexRecord* record) {
+  if (!index.FindRecord(uuid, slot))
+    return kReportNotFound;
+  *record = index.RecordAt(*slot);
+
+  if (record->state != static_cast<int32_t>(desired_state)) {
+    return record->state == static_cast<int32_t>(ReportState::kUploading)
+               ? kBusyError
+               : kReportNotFound;
+  }
+  return VerifyReportFile(uuid);
+}
+
+OperationStatus CrashReportDatabaseLinux::VerifyReportFile(const UUID& uuid) {
+  base::FilePath report_path = ReportPath(report_dir_, uuid);
+  struct stat st;
+  if (stat(report_path.value().c_str(), &st) != 0)
+    return kReportNotFound;
+  return S_ISDIR(st.st_mode) ? kFileSystemError : kNoError;
+}
+
+std::unique_ptr<CrashReportDatabase> InitializeInternal(
+    const base::FilePath& path,
+    bool may_create) {
+  std::unique_ptr<CrashReportDatabaseLinux> database_linux(
+      new CrashReportDatabaseLinux(path));
+  return database_linux->Initialize(may_create)
+             ? std::move(database_linux)
+             : std::unique_ptr<CrashReportDatabaseLinux>();
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<CrashReportDatabase> CrashReportDatabase::Initialize(
+    const base::FilePath& path) {
+  return InitializeInternal(path, true);
+}
+
+// static
+std::unique_ptr<CrashReportDatabase>
+CrashReportDatabase::InitializeWithoutCreating(const base::FilePath& path) {
+  return InitializeInternal(path, false);
+}
+
+}  // namespace crashpad
@@ -17,14 +17,20 @@
 #include <errno.h>
 #include <fcntl.h>
 #import <Foundation/Foundation.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 #include <uuid/uuid.h>
 
+#include <limits>
+#include <map>
+#include <set>
+
 #include "base/logging.h"
 #include "base/mac/scoped_nsautorelease_pool.h"
 #include "base/posix/eintr_wrapper.h"
@@ -32,7 +38,9 @@
 #include "base/strings/string_piece.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/sys_string_conversions.h"
+#include "base/synchronization/lock.h"
 #include "client/settings.h"
+#include "util/file/directory_change_watcher.h"
 #include "util/file/file_io.h"
 #include "util/mac/xattr.h"
 #include "util/misc/initialization_state_dcheck.h"
@@ -45,8 +53,11 @@ namespace {
 constexpr char kWriteDirectory[] = "new";
 constexpr char kUploadPendingDirectory[] = "pending";
 constexpr char kCompletedDirectory[] = "completed";
+constexpr char kUploadParametersDirectory[] = "upload_parameters";
+constexpr char kAttachmentsDirectory[] = "attachments";
 
 constexpr char kSettings[] = "settings.dat";
+constexpr char kIndex[] = "index.dat";
 
 constexpr const char* kReportDirectories[] = {
     kWriteDirectory,
@@ -64,8 +75,145 @@ constexpr char kXattrLastUploadTime[] = "last_upload_time";
 constexpr char kXattrUploadAttemptCount[] = "upload_count";
 constexpr char kXattrIsUploadExplicitlyRequested[] =
     "upload_explicitly_requested";
+constexpr char kXattrIsDumpWithoutCrash[] = "dump_without_crash";
 
 constexpr char kXattrDatabaseInitialized[] = "initialized";
+constexpr char kXattrShardedLayout[] = "sharded";
+
+// In the sharded layout, each report directory holds a subdirectory, or shard,
+// for each possible pair of leading characters of a report’s UUID, and each
+// report is kept in the shard matching its UUID. This keeps directories small
+// enough that creating, renaming, and listing entries stays fast however many
+// reports the database holds. Reports found directly within a report
+// directory, as in the flat layout, are still used, because another instance
+// of the database may have put them there.
+constexpr size_t kReportShardNameLength = 2;
+
+// A database in the flat layout is migrated to the sharded layout once it holds
+// at least this many pending and completed reports.
+constexpr size_t kShardedLayoutMinReports = 4096;
+
+// Reports made pending in the sharded layout don’t change the pending
+// directory itself, so a file with this extension is created and removed
+// there to notify anything watching it.
+constexpr char kPendingAnnouncementFileExtension[] = "announce";
+
+// The index file is an IndexFileHeader followed by a journal of records. Each
+// record is an IndexRecord followed by IndexRecord::id_length bytes of the
+// report’s collector ID. Records are only ever appended, and a later record for
+// a UUID supersedes any earlier one. The file is rewritten without superseded
+// records when they come to dominate it.
+constexpr uint32_t kIndexFileMagic = 'CPIX';
+constexpr uint32_t kIndexFileVersion = 1;
+constexpr uint32_t kIndexRecordMagic = 'CPIR';
+
+// The index file is rewritten once it holds at least this many records and
+// more than twice as many records as reports.
+constexpr size_t kIndexCompactionMinRecords = 256;
+
+enum : uint8_t {
+  //! \brief Corresponds to CrashReportDatabase::Report::uploaded.
+  kIndexAttributeUploaded = 1 << 0,
+
+  //! \brief Corresponds to
+  //!     CrashReportDatabase::Report::upload_explicitly_requested.
+  kIndexAttributeUploadExplicitlyRequested = 1 << 1,
+
+  //! \brief The report has been deleted, and the record carries no metadata.
+  kIndexAttributeDeleted = 1 << 2,
+
+  //! \brief Corresponds to CrashReportDatabase::Report::dump_without_crash.
+  kIndexAttributeDumpWithoutCrash = 1 << 3,
+};
+
+struct IndexFileHeader {
+  uint32_t magic;
+  uint32_t version;
+};
+
+struct IndexRecord {
+  uint32_t magic;
+
+  // An FNV-1a hash of the remainder of the record and the collector ID that
+  // follows it. Records that don’t match, such as a record torn by a crash
+  // while it was being appended, end the journal.
+  uint32_t checksum;
+
+  UUID uuid;  // UUID is a 16 byte, standard layout structure.
+
+  // The report file’s status change time when the record was written. The
+  // report file’s xattrs remain authoritative: any modification to them
+  // changes this time, and causes the record to be disregarded.
+  int64_t status_change_time_sec;
+  int64_t status_change_time_nsec;
+
+  // The time that the record was written. Filesystem timestamps may be as
+  // coarse as one second, so a record is only trusted if the report was last
+  // changed in an earlier second than this.
+  int64_t indexed_time;
+
+  int64_t creation_time;  // Holds a time_t.
+  int64_t last_upload_attempt_time;  // Holds a time_t.
+  int32_t upload_attempts;
+  uint16_t id_length;
+  uint8_t attributes;  // Bitfield of kIndexAttribute*.
+  uint8_t padding;
+};
+
+uint32_t IndexRecordChecksum(const IndexRecord& record,
+                             const base::StringPiece& id) {
+  uint32_t hash = 2166136261u;
+  auto hash_bytes = [&hash](const char* data, size_t size) {
+    for (size_t index = 0; index < size; ++index) {
+      hash = (hash ^ static_cast<uint8_t>(data[index])) * 16777619u;
+    }
+  };
+
+  constexpr size_t kChecksummedOffset = offsetof(IndexRecord, uuid);
+  hash_bytes(reinterpret_cast<const char*>(&record) + kChecksummedOffset,
+             sizeof(record) - kChecksummedOffset);
+  hash_bytes(id.data(), id.size());
+  return hash;
+}
+
+// Appends |record| and |id| to |data| in the index file’s format.
+void SerializeIndexRecord(IndexRecord record,
+                          const base::StringPiece& id,
+                          std::string* data) {
+  DCHECK_EQ(record.id_length, id.size());
+  record.magic = kIndexRecordMagic;
+  record.checksum = IndexRecordChecksum(record, id);
+  data->append(reinterpret_cast<const char*>(&record), sizeof(record));
+  data->append(id.data(), id.size());
+}
+
+// Determines the UUID of the report at |path| from its file name.
+bool ReportUUIDFromPath(const base::FilePath& path, UUID* uuid) {
+  const std::string suffix = std::string(".") + kCrashReportFileExtension;
+  const std::string name = path.BaseName().value();
+  if (name.size() <= suffix.size() ||
+      name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+    return false;
+  }
+  return uuid->InitializeFromString(
+      base::StringPiece(name.data(), name.size() - suffix.size()));
+}
+
+// Returns the name of the shard in the sharded layout that holds the report
+// file named |file_name|.
+std::string ReportShardName(const std::string& file_name) {
+  return file_name.substr(0, kReportShardNameLength);
+}
+
+// Returns the names of all of the shards of a report directory in the sharded
+// layout.
+std::vector<std::string> AllReportShardNames() {
+  std::vector<std::string> names;
+  for (unsigned int shard = 0; shard <= 0xff; ++shard) {
+    names.push_back(base::StringPrintf("%02x", shard));
+  }
+  return names;
+}
 
 // Ensures that the node at |path| is a directory. If the |path| refers to a
 // file, rather than a directory, returns false. Otherwise, returns true,
@@ -121,6 +269,12 @@ std::string XattrNameInternal(const base::StringPiece& name, bool new_name) {
 //! ensure safe access, the report file is locked using `O_EXLOCK` during all
 //! extended attribute operations. The lock should be obtained using
 //! ObtainReportLock().
+//!
+//! So that listing reports doesn’t require locking each report and reading
+//! each of its xattrs, a copy of the metadata is also kept in an index file,
+//! which is consulted for reports that haven’t changed since they were indexed.
+//! The index is only an accelerator: reports that it doesn’t describe
+//! accurately are read from their xattrs, and then indexed again.
 class CrashReportDatabaseMac : public CrashReportDatabase {
  public:
   explicit CrashReportDatabaseMac(const base::FilePath& path);
@@ -146,6 +300,10 @@ class CrashReportDatabaseMac : public CrashReportDatabase {
                                    Metrics::CrashSkippedReason reason) override;
   OperationStatus DeleteReport(const UUID& uuid) override;
   OperationStatus RequestUpload(const UUID& uuid) override;
+  bool WatchPendingReports(DirectoryChangeWatcher* watcher) override;
+
+ protected:
+  void FlushReportRecords() override;
 
  private:
   //! \brief Report states for use with LocateCrashReport().
@@ -177,6 +335,31 @@ class CrashReportDatabaseMac : public CrashReportDatabase {
   //!     found.
   base::FilePath LocateCrashReport(const UUID& uuid, uint8_t desired_state);
 
+  //! \brief Returns the path that a report file named \a file_name is kept at
+  //!     in the report directory \a directory, in the database’s layout.
+  base::FilePath ReportPath(const char* directory,
+                            const std::string& file_name) const;
+
+  //! \brief Lists the report files in the report directory at \a path,
+  //!     including those in its shards in the sharded layout.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool ReportPathsInDirectory(const base::FilePath& path,
+                              std::vector<base::FilePath>* report_paths);
+
+  //! \brief Switches the database to the sharded layout if it is large enough
+  //!     to benefit, and moves reports left in the flat layout into shards.
+  //!
+  //! Reports that are locked, and reports still being written, are left where
+  //! they are, to be moved when the database is next initialized.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool MigrateReportLayout();
+
+  //! \brief Notifies anything watching the pending directory that the report
+  //!     file named \a file_name has been made pending in its shard.
+  void AnnouncePendingReport(const std::string& file_name);
+
   //! \brief Obtains an exclusive advisory lock on a file.
   //!
   //! The flock is used to prevent cross-process concurrent metadata reads or
@@ -232,9 +415,70 @@ class CrashReportDatabaseMac : public CrashReportDatabase {
       const base::FilePath& report_path,
       base::FilePath* out_path);
 
+  //! \brief Brings \a index_ up to date with the index file.
+  void ReadIndex();
+
+  //! \brief Sets \a report from its record in \a index_, if the record is
+  //!     current for the report file described by \a st.
+  //!
+  //! \return `true` if \a report was set, `false` if the report must be read
+  //!     from its file instead.
+  bool LookUpIndexedReport(const UUID& uuid,
+                           const struct stat& st,
+                           Report* report);
+
+  //! \brief Brings \a index_ up to date with the index file open at \a fd,
+  //!     which must be locked. \a index_lock_ must be held.
+  //!
+  //! \return `true` if the file was read to its end, `false` if it is damaged
+  //!     beyond the last record read into \a index_.
+  bool ReadIndexLocked(int fd);
+
+  //! \brief Applies the serialized records in \a data to \a index_, with
+  //!     \a index_lock_ held.
+  //!
+  //! \return The number of bytes of \a data that held valid records. Records
+  //!     are applied up to the first invalid one.
+  size_t ApplyIndexRecords(const base::StringPiece& data);
+
+  //! \brief Appends serialized records to the index file, rewriting it if it is
+  //!     damaged or if superseded records dominate it.
+  //!
+  //! Failures are logged, but are otherwise harmless, because reports that
+  //! aren’t indexed are read from their xattrs.
+  void AppendToIndex(const std::string& records);
+
+  //! \brief Resets \a index_ to describe an empty index file, with \a
+  //!     index_lock_ held.
+  void ResetIndex();
+
+  //! \brief The in-memory copy of a report’s latest record in the index file.
+  struct IndexEntry {
+    IndexRecord record;
+    std::string id;
+  };
+
   base::FilePath base_dir_;
+  base::FilePath index_path_;
   Settings settings_;
+
+  // The contents of the index file, keyed by UUID string, as of
+  // index_offset_ bytes into the file identified by index_inode_. These fields
+  // are guarded by index_lock_, because the database may be used from several
+  // threads at once.
+  base::Lock index_lock_;
+  std::map<std::string, IndexEntry> index_;
+  ino_t index_inode_;
+  off_t index_offset_;
+  size_t index_record_count_;
+
+  // The shards that reports have been made pending in since
+  // FlushReportRecords() last flushed them, in the sharded layout.
+  base::Lock unflushed_shards_lock_;
+  std::set<std::string> unflushed_shards_;
+
   bool xattr_new_names_;
+  bool sharded_;
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(CrashReportDatabaseMac);
@@ -243,8 +487,17 @@ class CrashReportDatabaseMac : public CrashReportDatabase {
 CrashReportDatabaseMac::CrashReportDatabaseMac(const base::FilePath& path)
     : CrashReportDatabase(),
       base_dir_(path),
+      index_path_(base_dir_.Append(kIndex)),
       settings_(base_dir_.Append(kSettings)),
+      index_lock_(),
+      index_(),
+      index_inode_(0),
+      index_offset_(0),
+      index_record_count_(0),
+      unflushed_shards_lock_(),
+      unflushed_shards_(),
       xattr_new_names_(false),
+      sharded_(false),
       initialized_() {
 }
 
@@ -268,6 +521,23 @@ bool CrashReportDatabaseMac::Initialize(bool may_create) {
       return false;
   }
 
+  // Spare report files are kept alongside reports being written. They don’t
+  // have the report file extension, so they’re never taken for reports.
+  SetSpareReportFileDirectory(base_dir_.Append(kWriteDirectory));
+
+  // Upload parameters are kept apart from reports, so that recording them
+  // doesn’t disturb anything watching the report directories.
+  if (!CreateOrEnsureDirectoryExists(
+          base_dir_.Append(kUploadParametersDirectory)))
+    return false;
+  SetUploadParametersDirectory(base_dir_.Append(kUploadParametersDirectory));
+
+  // Attached files are cloned into the database, so they must be on the same
+  // file system as the files attached.
+  if (!CreateOrEnsureDirectoryExists(base_dir_.Append(kAttachmentsDirectory)))
+    return false;
+  SetAttachmentsDirectory(base_dir_.Append(kAttachmentsDirectory));
+
   if (!settings_.Initialize())
     return false;
 
@@ -291,6 +561,9 @@ bool CrashReportDatabaseMac::Initialize(bool may_create) {
       return false;
   }
 
+  if (!MigrateReportLayout())
+    return false;
+
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
@@ -311,12 +584,16 @@ CrashReportDatabaseMac::PrepareNewCrashReport(NewReport** out_report) {
   report->uuid.InitializeFromBytes(uuid_gen);
 
   report->path =
-      base_dir_.Append(kWriteDirectory)
-          .Append(report->uuid.ToString() + "." + kCrashReportFileExtension);
+      ReportPath(kWriteDirectory,
+                 report->uuid.ToString() + "." + kCrashReportFileExtension);
 
+  // A claimed spare report file is already in place, and is opened without
+  // O_CREAT. Otherwise, the file is created here.
+  const int create_flags =
+      ClaimSpareReportFile(report->path) ? 0 : O_CREAT | O_EXCL;
   report->handle = HANDLE_EINTR(
       open(report->path.value().c_str(),
-           O_WRONLY | O_EXLOCK | O_CREAT | O_EXCL | O_NOCTTY | O_CLOEXEC,
+           O_WRONLY | O_EXLOCK | O_NOCTTY | O_CLOEXEC | create_flags,
            0600));
   if (report->handle < 0) {
     PLOG(ERROR) << "open " << report->path.value();
@@ -329,6 +606,7 @@ CrashReportDatabaseMac::PrepareNewCrashReport(NewReport** out_report) {
     PLOG_IF(ERROR, IGNORE_EINTR(close(report->handle)) != 0) << "close";
     return kDatabaseError;
   }
+  PrepareNewReportFile(report->handle);
 
   *out_report = report.release();
 
@@ -367,14 +645,39 @@ CrashReportDatabaseMac::FinishedWritingCrashReport(NewReport* report,
     return kDatabaseError;
   }
 
+  if (report->dump_without_crash &&
+      !WriteXattrBool(
+          report->path, XattrName(kXattrIsDumpWithoutCrash), true)) {
+    return kDatabaseError;
+  }
+
+  // This follows the extended attributes, so that they’re flushed along with
+  // the file’s contents.
+  FinishNewReportFile(lock.get());
+
+  WriteUploadParameters(*report);
+  WriteAttachments(*report);
+
   // Move the report to its new location for uploading.
-  base::FilePath new_path =
-      base_dir_.Append(kUploadPendingDirectory).Append(report->path.BaseName());
+  const std::string file_name = report->path.BaseName().value();
+  base::FilePath new_path = ReportPath(kUploadPendingDirectory, file_name);
   if (rename(report->path.value().c_str(), new_path.value().c_str()) != 0) {
     PLOG(ERROR) << "rename " << report->path.value() << " to "
                 << new_path.value();
+    DeleteUploadParameters(report->uuid);
+    DeleteAttachments(report->uuid);
     return kFileSystemError;
   }
+  if (sharded_) {
+    {
+      base::AutoLock lock(unflushed_shards_lock_);
+      unflushed_shards_.insert(ReportShardName(file_name));
+    }
+    CommitReportRecords();
+    AnnouncePendingReport(file_name);
+  } else {
+    CommitReportRecords();
+  }
 
   Metrics::CrashReportPending(Metrics::PendingReportReason::kNewlyCreated);
   Metrics::CrashReportSize(report->handle);
@@ -557,6 +860,19 @@ CrashReportDatabase::OperationStatus CrashReportDatabaseMac::DeleteReport(
     return kFileSystemError;
   }
 
+  DeleteUploadParameters(uuid);
+  DeleteAttachments(uuid);
+
+  // Record the deletion, so that the report’s record can be discarded when the
+  // index is rewritten.
+  IndexRecord record;
+  memset(&record, 0, sizeof(record));
+  record.uuid = uuid;
+  record.attributes = kIndexAttributeDeleted;
+  std::string records;
+  SerializeIndexRecord(record, base::StringPiece(), &records);
+  AppendToIndex(records);
+
   return kNoError;
 }
 
@@ -576,23 +892,31 @@ base::FilePath CrashReportDatabaseMac::LocateCrashReport(
     report_directories.push_back(kCompletedDirectory);
   }
 
+  const std::string file_name =
+      target_uuid + "." + kCrashReportFileExtension;
   for (const std::string& report_directory : report_directories) {
-    base::FilePath path =
-        base_dir_.Append(report_directory)
-                 .Append(target_uuid + "." + kCrashReportFileExtension);
-
-    // Test if the path exists.
-    struct stat st;
-    if (lstat(path.value().c_str(), &st)) {
-      continue;
+    // In the sharded layout, a report may also have been left in the flat
+    // layout by another instance of the database.
+    std::vector<base::FilePath> paths(
+        1, ReportPath(report_directory.c_str(), file_name));
+    if (sharded_) {
+      paths.push_back(base_dir_.Append(report_directory).Append(file_name));
     }
 
-    // Check that the UUID of the report matches.
-    std::string uuid_string;
-    if (ReadXattr(path, XattrName(kXattrUUID),
-                  &uuid_string) == XattrStatus::kOK &&
-        uuid_string == target_uuid) {
-      return path;
+    for (const base::FilePath& path : paths) {
+      // Test if the path exists.
+      struct stat st;
+      if (lstat(path.value().c_str(), &st)) {
+        continue;
+      }
+
+      // Check that the UUID of the report matches.
+      std::string uuid_string;
+      if (ReadXattr(path, XattrName(kXattrUUID),
+                    &uuid_string) == XattrStatus::kOK &&
+          uuid_string == target_uuid) {
+        return path;
+      }
     }
   }
 
@@ -628,19 +952,54 @@ CrashReportDatabase::OperationStatus CrashReportDatabaseMac::RequestUpload(
     return kDatabaseError;
   }
 
-  base::FilePath new_path =
-      base_dir_.Append(kUploadPendingDirectory).Append(report_path.BaseName());
+  const std::string file_name = report_path.BaseName().value();
+  base::FilePath new_path = ReportPath(kUploadPendingDirectory, file_name);
   if (rename(report_path.value().c_str(), new_path.value().c_str()) != 0) {
     PLOG(ERROR) << "rename " << report_path.value() << " to "
                 << new_path.value();
     return kFileSystemError;
   }
+  if (sharded_) {
+    AnnouncePendingReport(file_name);
+  }
 
   Metrics::CrashReportPending(Metrics::PendingReportReason::kUserInitiated);
 
   return kNoError;
 }
 
+bool CrashReportDatabaseMac::WatchPendingReports(
+    DirectoryChangeWatcher* watcher) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Reports become pending by being moved into the pending directory, or in the
+  // sharded layout, into one of its shards, and then announced there.
+  return watcher->Initialize(base_dir_.Append(kUploadPendingDirectory));
+}
+
+void CrashReportDatabaseMac::FlushReportRecords() {
+  // A report’s record is its file’s extended attributes, which were flushed
+  // with the file, and its location. New reports are moved from the write
+  // directory to the pending directory, so both directories are flushed, or
+  // in the sharded layout, the shards of both that reports were moved between.
+  if (!sharded_) {
+    LoggingFlushDirectory(base_dir_.Append(kWriteDirectory));
+    LoggingFlushDirectory(base_dir_.Append(kUploadPendingDirectory));
+    return;
+  }
+
+  std::set<std::string> shards;
+  {
+    base::AutoLock lock(unflushed_shards_lock_);
+    shards.swap(unflushed_shards_);
+  }
+  for (const std::string& shard : shards) {
+    LoggingFlushDirectory(base_dir_.Append(kWriteDirectory).Append(shard));
+    LoggingFlushDirectory(
+        base_dir_.Append(kUploadPendingDirectory).Append(shard));
+  }
+}
+
 // static
 base::ScopedFD CrashReportDatabaseMac::ObtainReportLock(
     const base::FilePath& path) {
@@ -698,9 +1057,173 @@ bool CrashReportDatabaseMac::ReadReportMetadataLocked(
     return false;
   }
 
+  report->dump_without_crash = false;
+  if (ReadXattrBool(path,
+                    XattrName(kXattrIsDumpWithoutCrash),
+                    &report->dump_without_crash) == XattrStatus::kOtherError) {
+    return false;
+  }
+
   return true;
 }
 
+base::FilePath CrashReportDatabaseMac::ReportPath(
+    const char* directory,
+    const std::string& file_name) const {
+  base::FilePath path = base_dir_.Append(directory);
+  if (sharded_) {
+    path = path.Append(ReportShardName(file_name));
+  }
+  return path.Append(file_name);
+}
+
+bool CrashReportDatabaseMac::ReportPathsInDirectory(
+    const base::FilePath& path,
+    std::vector<base::FilePath>* report_paths) {
+  base::mac::ScopedNSAutoreleasePool pool;
+
+  std::vector<base::FilePath> directories(1, path);
+  if (sharded_) {
+    for (const std::string& shard : AllReportShardNames()) {
+      directories.push_back(path.Append(shard));
+    }
+  }
+
+  for (const base::FilePath& directory : directories) {
+    NSError* error = nil;
+    NSArray* entries = [[NSFileManager defaultManager]
+        contentsOfDirectoryAtPath:base::SysUTF8ToNSString(directory.value())
+                            error:&error];
+    if (error) {
+      LOG(ERROR) << "Failed to enumerate reports in directory "
+                 << directory.value() << ": "
+                 << [[error description] UTF8String];
+      return false;
+    }
+
+    // Shards, spare report files, and announcements of pending reports aren’t
+    // reports.
+    for (NSString* entry in entries) {
+      base::FilePath report_path =
+          directory.Append([entry fileSystemRepresentation]);
+      UUID uuid;
+      if (ReportUUIDFromPath(report_path, &uuid)) {
+        report_paths->push_back(report_path);
+      }
+    }
+  }
+  return true;
+}
+
+bool CrashReportDatabaseMac::MigrateReportLayout() {
+  bool value;
+  if (ReadXattrBool(base_dir_, XattrName(kXattrShardedLayout), &value) ==
+          XattrStatus::kOK &&
+      value) {
+    sharded_ = true;
+  } else {
+    size_t report_count = 0;
+    for (const char* directory :
+         {kUploadPendingDirectory, kCompletedDirectory}) {
+      std::vector<base::FilePath> report_paths;
+      if (!ReportPathsInDirectory(base_dir_.Append(directory),
+                                  &report_paths)) {
+        return false;
+      }
+      report_count += report_paths.size();
+    }
+    if (report_count < kShardedLayoutMinReports) {
+      return true;
+    }
+
+    LOG(INFO) << "moving " << report_count << " reports in "
+              << base_dir_.value() << " to the sharded layout";
+  }
+
+  // The shards are created before the database is marked as sharded, so that
+  // other instances never find the layout without them.
+  for (const char* directory : kReportDirectories) {
+    for (const std::string& shard : AllReportShardNames()) {
+      if (!CreateOrEnsureDirectoryExists(
+              base_dir_.Append(directory).Append(shard))) {
+        return false;
+      }
+    }
+  }
+  if (!sharded_) {
+    if (!WriteXattrBool(base_dir_, XattrName(kXattrShardedLayout), true)) {
+      return false;
+    }
+    sharded_ = true;
+  }
+
+  // Reports left in the flat layout are moved into their shards, except for
+  // those still being written, because their writers will move them by their
+  // original paths. They become pending in the flat layout, and are moved from
+  // there the next time that the database is initialized.
+  for (const char* directory : {kUploadPendingDirectory, kCompletedDirectory}) {
+    base::mac::ScopedNSAutoreleasePool pool;
+
+    const base::FilePath directory_path = base_dir_.Append(directory);
+    NSError* error = nil;
+    NSArray* entries = [[NSFileManager defaultManager]
+        contentsOfDirectoryAtPath:base::SysUTF8ToNSString(
+                                      directory_path.value())
+                            error:&error];
+    if (error) {
+      LOG(ERROR) << "Failed to enumerate reports in directory "
+                 << directory_path.value() << ": "
+                 << [[error description] UTF8String];
+      return false;
+    }
+
+    for (NSString* entry in entries) {
+      const std::string file_name = [entry fileSystemRepresentation];
+      base::FilePath report_path = directory_path.Append(file_name);
+      UUID uuid;
+      if (!ReportUUIDFromPath(report_path, &uuid)) {
+        continue;
+      }
+
+      // A report that’s locked is in use by another instance of the database,
+      // which will look for it at its current path.
+      base::ScopedFD lock(ObtainReportLock(report_path));
+      if (!lock.is_valid()) {
+        continue;
+      }
+
+      base::FilePath new_path = ReportPath(directory, file_name);
+      if (rename(report_path.value().c_str(), new_path.value().c_str()) != 0) {
+        PLOG(WARNING) << "rename " << report_path.value() << " to "
+                      << new_path.value();
+      }
+    }
+  }
+
+  return true;
+}
+
+void CrashReportDatabaseMac::AnnouncePendingReport(
+    const std::string& file_name) {
+  // The file’s name is unique to the report, so that other instances of the
+  // database announcing reports at the same time don’t interfere.
+  base::FilePath announcement_path =
+      base_dir_.Append(kUploadPendingDirectory)
+          .Append(file_name + "." + kPendingAnnouncementFileExtension);
+  base::ScopedFD announcement(HANDLE_EINTR(
+      open(announcement_path.value().c_str(),
+           O_WRONLY | O_CREAT | O_NOCTTY | O_CLOEXEC,
+           0600)));
+  if (!announcement.is_valid()) {
+    PLOG(WARNING) << "open " << announcement_path.value();
+    return;
+  }
+  announcement.reset();
+  if (unlink(announcement_path.value().c_str()) != 0) {
+    PLOG(WARNING) << "unlink " << announcement_path.value();
+  }
+}
+
 CrashReportDatabase::OperationStatus CrashReportDatabaseMac::ReportsInDirectory(
     const base::FilePath& path,
     std::vector<CrashReportDatabase::Report>* reports) {
@@ -708,20 +1231,33 @@ CrashReportDatabase::OperationStatus CrashReportDatabaseMac::ReportsInDirectory(
 
   DCHECK(reports->empty());
 
-  NSError* error = nil;
-  NSArray* paths = [[NSFileManager defaultManager]
-      contentsOfDirectoryAtPath:base::SysUTF8ToNSString(path.value())
-                          error:&error];
-  if (error) {
-    LOG(ERROR) << "Failed to enumerate reports in directory " << path.value()
-               << ": " << [[error description] UTF8String];
+  std::vector<base::FilePath> report_paths;
+  if (!ReportPathsInDirectory(path, &report_paths)) {
     return kFileSystemError;
   }
 
-  reports->reserve([paths count]);
-  for (NSString* entry in paths) {
+  ReadIndex();
+
+  const time_t now = time(nullptr);
+  std::string new_records;
+
+  reports->reserve(report_paths.size());
+  for (const base::FilePath& report_path : report_paths) {
     Report report;
-    report.file_path = path.Append([entry fileSystemRepresentation]);
+    report.file_path = report_path;
+
+    // Use the indexed metadata if the report hasn’t changed since it was
+    // indexed.
+    UUID uuid;
+    const bool have_uuid = ReportUUIDFromPath(report.file_path, &uuid);
+    struct stat st;
+    if (have_uuid && lstat(report.file_path.value().c_str(), &st) == 0 &&
+        LookUpIndexedReport(uuid, st, &report)) {
+      report.size_in_kb = ReportSizeInKB(st.st_size);
+      reports->push_back(report);
+      continue;
+    }
+
     base::ScopedFD lock(ObtainReportLock(report.file_path));
     if (!lock.is_valid())
       continue;
@@ -731,12 +1267,265 @@ CrashReportDatabase::OperationStatus CrashReportDatabaseMac::ReportsInDirectory(
                    << report.file_path.value();
       continue;
     }
+
+    const bool have_stat = fstat(lock.get(), &st) == 0;
+    if (have_stat) {
+      report.size_in_kb = ReportSizeInKB(st.st_size);
+    }
+
+    // The report is still locked, so its status change time corresponds to the
+    // metadata just read.
+    if (have_uuid && report.uuid == uuid &&
+        report.id.size() <= std::numeric_limits<uint16_t>::max() &&
+        have_stat) {
+      IndexRecord record;
+      memset(&record, 0, sizeof(record));
+      record.uuid = report.uuid;
+      record.status_change_time_sec = st.st_ctimespec.tv_sec;
+      record.status_change_time_nsec = st.st_ctimespec.tv_nsec;
+      record.indexed_time = now;
+      record.creation_time = report.creation_time;
+      record.last_upload_attempt_time = report.last_upload_attempt_time;
+      record.upload_attempts = report.upload_attempts;
+      record.id_length = static_cast<uint16_t>(report.id.size());
+      record.attributes =
+          (report.uploaded ? kIndexAttributeUploaded : 0) |
+          (report.upload_explicitly_requested
+               ? kIndexAttributeUploadExplicitlyRequested
+               : 0) |
+          (report.dump_without_crash ? kIndexAttributeDumpWithoutCrash : 0);
+      SerializeIndexRecord(record, report.id, &new_records);
+    }
+
     reports->push_back(report);
   }
 
+  AppendToIndex(new_records);
+
   return kNoError;
 }
 
+void CrashReportDatabaseMac::ReadIndex() {
+  base::AutoLock lock(index_lock_);
+
+  base::ScopedFD fd(HANDLE_EINTR(
+      open(index_path_.value().c_str(),
+           O_RDONLY | O_SHLOCK | O_NOCTTY | O_CLOEXEC)));
+  if (!fd.is_valid()) {
+    PLOG_IF(WARNING, errno != ENOENT) << "open " << index_path_.value();
+    ResetIndex();
+    return;
+  }
+
+  ReadIndexLocked(fd.get());
+}
+
+bool CrashReportDatabaseMac::LookUpIndexedReport(const UUID& uuid,
+                                                 const struct stat& st,
+                                                 Report* report) {
+  base::AutoLock lock(index_lock_);
+
+  const auto it = index_.find(uuid.ToString());
+  if (it == index_.end()) {
+    return false;
+  }
+
+  const IndexRecord& record = it->second.record;
+  if (record.status_change_time_sec != st.st_ctimespec.tv_sec ||
+      record.status_change_time_nsec != st.st_ctimespec.tv_nsec ||
+      record.status_change_time_sec >= record.indexed_time) {
+    return false;
+  }
+
+  report->uuid = record.uuid;
+  report->id = it->second.id;
+  report->creation_time = record.creation_time;
+  report->uploaded = (record.attributes & kIndexAttributeUploaded) != 0;
+  report->last_upload_attempt_time = record.last_upload_attempt_time;
+  report->upload_attempts = record.upload_attempts;
+  report->upload_explicitly_requested =
+      (record.attributes & kIndexAttributeUploadExplicitlyRequested) != 0;
+  report->dump_without_crash =
+      (record.attributes & kIndexAttributeDumpWithoutCrash) != 0;
+  return true;
+}
+
+bool CrashReportDatabaseMac::ReadIndexLocked(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    PLOG(WARNING) << "fstat " << index_path_.value();
+    ResetIndex();
+    return false;
+  }
+
+  if (st.st_ino != index_inode_ || st.st_size < index_offset_) {
+    // The index file was replaced, so index_ describes a different file.
+    ResetIndex();
+    index_inode_ = st.st_ino;
+  }
+
+  if (index_offset_ == 0) {
+    if (st.st_size == 0) {
+      return true;
+    }
+
+    IndexFileHeader header;
+    if (HANDLE_EINTR(pread(fd, &header, sizeof(header), 0)) !=
+            static_cast<ssize_t>(sizeof(header)) ||
+        header.magic != kIndexFileMagic ||
+        header.version != kIndexFileVersion) {
+      LOG(WARNING) << "invalid index " << index_path_.value();
+      return false;
+    }
+    index_offset_ = sizeof(header);
+  }
+
+  if (st.st_size == index_offset_) {
+    return true;
+  }
+
+  std::string data(static_cast<size_t>(st.st_size - index_offset_), '\0');
+  ssize_t rv = HANDLE_EINTR(pread(fd, &data[0], data.size(), index_offset_));
+  if (rv != static_cast<ssize_t>(data.size())) {
+    PLOG_IF(WARNING, rv < 0) << "pread " << index_path_.value();
+    return false;
+  }
+
+  size_t valid_size = ApplyIndexRecords(data);
+  index_offset_ += valid_size;
+  return valid_size == data.size();
+}
+
+size_t CrashReportDatabaseMac::ApplyIndexRecords(
+    const base::StringPiece& data) {
+  size_t offset = 0;
+  while (data.size() - offset >= sizeof(IndexRecord)) {
+    IndexRecord record;
+    memcpy(&record, data.data() + offset, sizeof(record));
+    if (record.magic != kIndexRecordMagic ||
+        record.id_length > data.size() - offset - sizeof(record)) {
+      break;
+    }
+
+    base::StringPiece id(data.data() + offset + sizeof(record),
+                         record.id_length);
+    if (record.checksum != IndexRecordChecksum(record, id)) {
+      break;
+    }
+
+    offset += sizeof(record) + record.id_length;
+    ++index_record_count_;
+
+    if (record.attributes & kIndexAttributeDeleted) {
+      index_.erase(record.uuid.ToString());
+    } else {
+      IndexEntry& entry = index_[record.uuid.ToString()];
+      entry.record = record;
+      id.CopyToString(&entry.id);
+    }
+  }
+
+  return offset;
+}
+
+void CrashReportDatabaseMac::AppendToIndex(const std::string& records) {
+  if (records.empty()) {
+    return;
+  }
+
+  base::AutoLock lock(index_lock_);
+
+  // Another process may replace the index file while this one waits for the
+  // lock. If that happens, the lock is held on a file that’s no longer in use,
+  // so try again.
+  base::ScopedFD fd;
+  for (int attempt = 0;; ++attempt) {
+    fd.reset(HANDLE_EINTR(open(index_path_.value().c_str(),
+                               O_RDWR | O_APPEND | O_CREAT | O_EXLOCK |
+                                   O_NOCTTY | O_CLOEXEC,
+                               0600)));
+    if (!fd.is_valid()) {
+      PLOG(WARNING) << "open " << index_path_.value();
+      return;
+    }
+
+    struct stat fd_st;
+    struct stat path_st;
+    if (fstat(fd.get(), &fd_st) != 0 ||
+        stat(index_path_.value().c_str(), &path_st) != 0) {
+      PLOG(WARNING) << "stat " << index_path_.value();
+      return;
+    }
+    if (fd_st.st_ino == path_st.st_ino) {
+      break;
+    }
+
+    constexpr int kMaxAttempts = 3;
+    if (attempt + 1 == kMaxAttempts) {
+      LOG(WARNING) << "index " << index_path_.value() << " replaced";
+      return;
+    }
+  }
+
+  const bool intact = ReadIndexLocked(fd.get());
+  const size_t valid_size = ApplyIndexRecords(records);
+  DCHECK_EQ(valid_size, records.size());
+
+  if (intact && (index_record_count_ < kIndexCompactionMinRecords ||
+                 index_record_count_ <= 2 * index_.size())) {
+    std::string data;
+    if (index_offset_ == 0) {
+      IndexFileHeader header = {kIndexFileMagic, kIndexFileVersion};
+      data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    data.append(records);
+
+    // A single write, so that a crash can tear only the records being
+    // appended, which the checksum will then reject.
+    if (!LoggingWriteFile(fd.get(), data.data(), data.size())) {
+      ResetIndex();
+      return;
+    }
+    index_offset_ += data.size();
+    return;
+  }
+
+  // Rewrite the index with only the latest record for each report, and replace
+  // the existing file with it atomically.
+  std::string data;
+  IndexFileHeader header = {kIndexFileMagic, kIndexFileVersion};
+  data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const auto& it : index_) {
+    SerializeIndexRecord(it.second.record, it.second.id, &data);
+  }
+
+  const base::FilePath new_path(index_path_.value() + ".new");
+  base::ScopedFD new_fd(HANDLE_EINTR(
+      open(new_path.value().c_str(),
+           O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY | O_CLOEXEC,
+           0600)));
+  struct stat new_st;
+  if (!new_fd.is_valid() ||
+      !LoggingWriteFile(new_fd.get(), data.data(), data.size()) ||
+      fstat(new_fd.get(), &new_st) != 0 ||
+      rename(new_path.value().c_str(), index_path_.value().c_str()) != 0) {
+    PLOG(WARNING) << "rewrite " << index_path_.value();
+    ResetIndex();
+    return;
+  }
+
+  index_inode_ = new_st.st_ino;
+  index_offset_ = data.size();
+  index_record_count_ = index_.size();
+}
+
+void CrashReportDatabaseMac::ResetIndex() {
+  index_.clear();
+  index_inode_ = 0;
+  index_offset_ = 0;
+  index_record_count_ = 0;
+}
+
 std::string CrashReportDatabaseMac::XattrName(const base::StringPiece& name) {
   return XattrNameInternal(name, xattr_new_names_);
 }
@@ -751,7 +1540,7 @@ CrashReportDatabaseMac::MarkReportCompletedLocked(
   }
 
   base::FilePath new_path =
-      base_dir_.Append(kCompletedDirectory).Append(report_path.BaseName());
+      ReportPath(kCompletedDirectory, report_path.BaseName().value());
   if (rename(report_path.value().c_str(), new_path.value().c_str()) != 0) {
     PLOG(ERROR) << "rename " << report_path.value() << " to "
                 << new_path.value();
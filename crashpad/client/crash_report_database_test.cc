@@ -14,13 +14,26 @@
 
 #include "client/crash_report_database.h"
 
+#include <time.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/memory/ptr_util.h"
 #include "build/build_config.h"
 #include "client/settings.h"
 #include "gtest/gtest.h"
 #include "test/errors.h"
 #include "test/file.h"
 #include "test/scoped_temp_dir.h"
+#include "util/file/directory_change_watcher.h"
 #include "util/file/file_io.h"
+#include "util/synchronization/semaphore.h"
+#include "util/thread/thread.h"
 
 namespace crashpad {
 namespace test {
@@ -95,6 +108,7 @@ class CrashReportDatabaseTest : public testing::Test {
     EXPECT_EQ(report.last_upload_attempt_time, 0);
     EXPECT_EQ(report.upload_attempts, 0);
     EXPECT_FALSE(report.upload_explicitly_requested);
+    EXPECT_FALSE(report.dump_without_crash);
   }
 
   void RelocateDatabase() {
@@ -683,6 +697,658 @@ TEST_F(CrashReportDatabaseTest, RequestUpload) {
             CrashReportDatabase::kCannotRequestUpload);
 }
 
+TEST_F(CrashReportDatabaseTest, DumpWithoutCrash) {
+  CrashReportDatabase::Report crash_report;
+  CreateCrashReport(&crash_report);
+
+  CrashReportDatabase::NewReport* new_report = nullptr;
+  ASSERT_EQ(db()->PrepareNewCrashReport(&new_report),
+            CrashReportDatabase::kNoError);
+  EXPECT_FALSE(new_report->dump_without_crash);
+  new_report->dump_without_crash = true;
+  static constexpr char kTest[] = "test";
+  ASSERT_TRUE(LoggingWriteFile(new_report->handle, kTest, sizeof(kTest)));
+  UUID uuid;
+  ASSERT_EQ(db()->FinishedWritingCrashReport(new_report, &uuid),
+            CrashReportDatabase::kNoError);
+
+  CrashReportDatabase::Report report;
+  ASSERT_EQ(db()->LookUpCrashReport(uuid, &report),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(report.dump_without_crash);
+
+  std::vector<CrashReportDatabase::Report> pending_reports;
+  ASSERT_EQ(db()->GetPendingReports(&pending_reports),
+            CrashReportDatabase::kNoError);
+  ASSERT_EQ(pending_reports.size(), 2u);
+  for (const CrashReportDatabase::Report& pending_report : pending_reports) {
+    EXPECT_EQ(pending_report.dump_without_crash, pending_report.uuid == uuid);
+  }
+
+  // The distinction survives changes to the report’s other metadata.
+  UploadReport(uuid, false, std::string());
+  ASSERT_EQ(db()->LookUpCrashReport(uuid, &report),
+            CrashReportDatabase::kNoError);
+  EXPECT_EQ(report.upload_attempts, 1);
+  EXPECT_TRUE(report.dump_without_crash);
+
+  UploadReport(uuid, true, "1");
+  ASSERT_EQ(db()->LookUpCrashReport(uuid, &report),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(report.uploaded);
+  EXPECT_TRUE(report.dump_without_crash);
+
+  ASSERT_EQ(db()->LookUpCrashReport(crash_report.uuid, &report),
+            CrashReportDatabase::kNoError);
+  EXPECT_FALSE(report.dump_without_crash);
+}
+
+TEST_F(CrashReportDatabaseTest, UploadParameters) {
+  CrashReportDatabase::Report crash_report;
+  CreateCrashReport(&crash_report);
+
+  CrashReportDatabase::NewReport* new_report = nullptr;
+  ASSERT_EQ(db()->PrepareNewCrashReport(&new_report),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(new_report->upload_parameters.empty());
+  new_report->upload_parameters["guid"] = "client";
+  new_report->upload_parameters["list_annotations"] = "one\ntwo";
+  new_report->upload_parameters["empty"] = std::string();
+  new_report->upload_parameters[std::string("nul\0key", 7)] =
+      std::string("nul\0value", 9);
+  const std::map<std::string, std::string> expected_parameters =
+      new_report->upload_parameters;
+  static constexpr char kTest[] = "test";
+  ASSERT_TRUE(LoggingWriteFile(new_report->handle, kTest, sizeof(kTest)));
+  UUID uuid;
+  ASSERT_EQ(db()->FinishedWritingCrashReport(new_report, &uuid),
+            CrashReportDatabase::kNoError);
+
+  std::map<std::string, std::string> parameters;
+  ASSERT_EQ(db()->LookUpUploadParameters(uuid, &parameters),
+            CrashReportDatabase::kNoError);
+  EXPECT_EQ(parameters, expected_parameters);
+
+  // The record survives changes to the report’s other metadata, and is visible
+  // to other instances of the database.
+  UploadReport(uuid, false, std::string());
+  std::unique_ptr<CrashReportDatabase> other_db =
+      CrashReportDatabase::Initialize(path());
+  ASSERT_TRUE(other_db);
+  parameters.clear();
+  ASSERT_EQ(other_db->LookUpUploadParameters(uuid, &parameters),
+            CrashReportDatabase::kNoError);
+  EXPECT_EQ(parameters, expected_parameters);
+
+  // A report written without parameters has no record.
+  EXPECT_EQ(db()->LookUpUploadParameters(crash_report.uuid, &parameters),
+            CrashReportDatabase::kReportNotFound);
+
+  // Deleting the report deletes its record.
+  EXPECT_EQ(db()->DeleteReport(uuid), CrashReportDatabase::kNoError);
+  EXPECT_EQ(db()->LookUpUploadParameters(uuid, &parameters),
+            CrashReportDatabase::kReportNotFound);
+}
+
+TEST_F(CrashReportDatabaseTest, Attachments) {
+  CrashReportDatabase::Report crash_report;
+  CreateCrashReport(&crash_report);
+
+  // Attached files must be on the database’s file system.
+  const base::FilePath attachment_path =
+      path().Append(FILE_PATH_LITERAL("attachment.log"));
+  static constexpr char kAttachment[] = "attachment";
+  {
+    ScopedFileHandle handle(
+        LoggingOpenFileForWrite(attachment_path,
+                                FileWriteMode::kCreateOrFail,
+                                FilePermissions::kOwnerOnly));
+    ASSERT_TRUE(handle.is_valid());
+    ASSERT_TRUE(
+        LoggingWriteFile(handle.get(), kAttachment, sizeof(kAttachment)));
+  }
+
+  CrashReportDatabase::NewReport* new_report = nullptr;
+  ASSERT_EQ(db()->PrepareNewCrashReport(&new_report),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(new_report->attachments.empty());
+  new_report->attachments.push_back(attachment_path);
+  static constexpr char kTest[] = "test";
+  ASSERT_TRUE(LoggingWriteFile(new_report->handle, kTest, sizeof(kTest)));
+  UUID uuid;
+  ASSERT_EQ(db()->FinishedWritingCrashReport(new_report, &uuid),
+            CrashReportDatabase::kNoError);
+
+  std::vector<base::FilePath> attachments;
+  ASSERT_EQ(db()->GetAttachments(uuid, &attachments),
+            CrashReportDatabase::kNoError);
+  ASSERT_EQ(attachments.size(), 1u);
+  EXPECT_EQ(attachments[0].BaseName().value(),
+            attachment_path.BaseName().value());
+  EXPECT_NE(attachments[0].value(), attachment_path.value());
+  char contents[sizeof(kAttachment)] = {};
+  {
+    ScopedFileHandle handle(LoggingOpenFileForRead(attachments[0]));
+    ASSERT_TRUE(handle.is_valid());
+    ASSERT_TRUE(
+        LoggingReadFileExactly(handle.get(), contents, sizeof(contents)));
+  }
+  EXPECT_STREQ(contents, kAttachment);
+
+  // A report written without attachments has none.
+  EXPECT_EQ(db()->GetAttachments(crash_report.uuid, &attachments),
+            CrashReportDatabase::kReportNotFound);
+
+  // Deleting the report deletes its files, but not the file attached.
+  EXPECT_EQ(db()->DeleteReport(uuid), CrashReportDatabase::kNoError);
+  EXPECT_EQ(db()->GetAttachments(uuid, &attachments),
+            CrashReportDatabase::kReportNotFound);
+  EXPECT_TRUE(FileExists(attachment_path));
+}
+
+TEST_F(CrashReportDatabaseTest, ReportSize) {
+  CrashReportDatabase::Report report;
+  CreateCrashReport(&report);
+
+  // Each report created by CreateCrashReport() is a few bytes, which rounds up
+  // to 1 KB.
+  std::vector<CrashReportDatabase::Report> reports;
+  ASSERT_EQ(db()->GetPendingReports(&reports), CrashReportDatabase::kNoError);
+  ASSERT_EQ(reports.size(), 1u);
+  EXPECT_EQ(reports[0].size_in_kb, 1u);
+
+  UploadReport(report.uuid, true, "1");
+  reports.clear();
+  ASSERT_EQ(db()->GetCompletedReports(&reports),
+            CrashReportDatabase::kNoError);
+  ASSERT_EQ(reports.size(), 1u);
+  EXPECT_EQ(reports[0].size_in_kb, 1u);
+}
+
+TEST_F(CrashReportDatabaseTest, NewReportFileOptions) {
+  CrashReportDatabase::NewReportFileOptions options;
+  options.preallocation_size = 1024 * 1024;
+  options.discard_file_cache = true;
+  db()->SetNewReportFileOptions(options);
+
+  // Storage reserved for the report must not be counted in its size.
+  CrashReportDatabase::Report report;
+  CreateCrashReport(&report);
+  EXPECT_EQ(report.size_in_kb, 1u);
+
+  std::string contents;
+  ASSERT_TRUE(LoggingReadEntireFile(report.file_path, &contents));
+  EXPECT_EQ(contents, std::string("test", sizeof("test")));
+}
+
+class DurableReportThread : public Thread {
+ public:
+  explicit DurableReportThread(CrashReportDatabase* database)
+      : Thread(), database_(database), uuid_() {}
+  ~DurableReportThread() override {}
+
+  const UUID& uuid() const { return uuid_; }
+
+ private:
+  // Thread:
+  void ThreadMain() override {
+    CrashReportDatabase::NewReport* new_report = nullptr;
+    ASSERT_EQ(database_->PrepareNewCrashReport(&new_report),
+              CrashReportDatabase::kNoError);
+    static constexpr char kTest[] = "test";
+    ASSERT_TRUE(LoggingWriteFile(new_report->handle, kTest, sizeof(kTest)));
+    EXPECT_EQ(database_->FinishedWritingCrashReport(new_report, &uuid_),
+              CrashReportDatabase::kNoError);
+  }
+
+  CrashReportDatabase* database_;  // weak
+  UUID uuid_;
+
+  DISALLOW_COPY_AND_ASSIGN(DurableReportThread);
+};
+
+TEST_F(CrashReportDatabaseTest, DurableReports) {
+  CrashReportDatabase::NewReportFileOptions options;
+  options.durable = true;
+  db()->SetNewReportFileOptions(options);
+
+  CrashReportDatabase::Report report;
+  CreateCrashReport(&report);
+  EXPECT_EQ(report.size_in_kb, 1u);
+
+  // Reports finished together share a commit, and each is pending by the time
+  // FinishedWritingCrashReport() returns.
+  options.commit_window_ms = 10;
+  db()->SetNewReportFileOptions(options);
+
+  std::vector<std::unique_ptr<DurableReportThread>> threads;
+  for (size_t index = 0; index < 4; ++index) {
+    threads.push_back(base::WrapUnique(new DurableReportThread(db())));
+  }
+  for (const auto& thread : threads) {
+    thread->Start();
+  }
+  for (const auto& thread : threads) {
+    thread->Join();
+    EXPECT_EQ(db()->LookUpCrashReport(thread->uuid(), &report),
+              CrashReportDatabase::kNoError);
+    ExpectPreparedCrashReport(report);
+  }
+
+  std::vector<CrashReportDatabase::Report> pending;
+  ASSERT_EQ(db()->GetPendingReports(&pending), CrashReportDatabase::kNoError);
+  EXPECT_EQ(pending.size(), 5u);
+}
+
+TEST_F(CrashReportDatabaseTest, SpareReportFiles) {
+  CrashReportDatabase::NewReportFileOptions options;
+  options.preallocation_size = 1024 * 1024;
+  options.spare_file_count = 2;
+  db()->SetNewReportFileOptions(options);
+  db()->ReplenishSpareReportFiles();
+
+  // Spare report files must not be taken for reports.
+  std::vector<CrashReportDatabase::Report> pending;
+  ASSERT_EQ(db()->GetPendingReports(&pending), CrashReportDatabase::kNoError);
+  EXPECT_TRUE(pending.empty());
+
+  // The first two reports are written to spare files, and the third to a new
+  // file once they’re used up.
+  std::vector<CrashReportDatabase::Report> reports(3);
+  for (CrashReportDatabase::Report& report : reports) {
+    CreateCrashReport(&report);
+    EXPECT_EQ(report.size_in_kb, 1u);
+
+    std::string contents;
+    ASSERT_TRUE(LoggingReadEntireFile(report.file_path, &contents));
+    EXPECT_EQ(contents, std::string("test", sizeof("test")));
+  }
+
+  pending.clear();
+  ASSERT_EQ(db()->GetPendingReports(&pending), CrashReportDatabase::kNoError);
+  EXPECT_EQ(pending.size(), 3u);
+
+  // Spare files left by an earlier instance aren’t taken for reports by a new
+  // one, which may reuse them.
+  db()->ReplenishSpareReportFiles();
+  ResetDatabase();
+  std::unique_ptr<CrashReportDatabase> db =
+      CrashReportDatabase::Initialize(path());
+  ASSERT_TRUE(db);
+  db->SetNewReportFileOptions(options);
+  db->ReplenishSpareReportFiles();
+
+  pending.clear();
+  ASSERT_EQ(db->GetPendingReports(&pending), CrashReportDatabase::kNoError);
+  EXPECT_EQ(pending.size(), 3u);
+}
+
+TEST_F(CrashReportDatabaseTest, ReportsConsistentAcrossReads) {
+  // Listing reports repeatedly, including from a newly-opened database, must
+  // return the same metadata each time, while reports change between reads.
+  std::vector<CrashReportDatabase::Report> reports(3);
+  CreateCrashReport(&reports[0]);
+  CreateCrashReport(&reports[1]);
+  CreateCrashReport(&reports[2]);
+
+  UploadReport(reports[1].uuid, true, "report1");
+  UploadReport(reports[2].uuid, false, std::string());
+
+  auto expect_reports = [this, &reports]() {
+    std::vector<CrashReportDatabase::Report> pending;
+    ASSERT_EQ(db()->GetPendingReports(&pending),
+              CrashReportDatabase::kNoError);
+    std::vector<CrashReportDatabase::Report> completed;
+    ASSERT_EQ(db()->GetCompletedReports(&completed),
+              CrashReportDatabase::kNoError);
+
+    ASSERT_EQ(pending.size(), 2u);
+    for (const auto& report : pending) {
+      EXPECT_FALSE(report.uploaded);
+      if (report.uuid == reports[2].uuid) {
+        EXPECT_EQ(report.upload_attempts, 1);
+        EXPECT_GT(report.last_upload_attempt_time, 0);
+      } else {
+        EXPECT_EQ(report.uuid, reports[0].uuid);
+        EXPECT_EQ(report.upload_attempts, 0);
+      }
+      EXPECT_TRUE(FileExists(report.file_path)) << report.file_path.value();
+    }
+
+    ASSERT_EQ(completed.size(), 1u);
+    EXPECT_EQ(completed[0].uuid, reports[1].uuid);
+    EXPECT_EQ(completed[0].id, "report1");
+    EXPECT_TRUE(completed[0].uploaded);
+    EXPECT_EQ(completed[0].upload_attempts, 1);
+    EXPECT_EQ(completed[0].creation_time, reports[1].creation_time);
+    EXPECT_TRUE(FileExists(completed[0].file_path))
+        << completed[0].file_path.value();
+  };
+
+  expect_reports();
+  expect_reports();
+
+  ResetDatabase();
+  SetUp();
+  expect_reports();
+
+  // A deleted report disappears from subsequent reads.
+  EXPECT_EQ(db()->DeleteReport(reports[1].uuid), CrashReportDatabase::kNoError);
+  std::vector<CrashReportDatabase::Report> completed;
+  EXPECT_EQ(db()->GetCompletedReports(&completed),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(completed.empty());
+
+  ResetDatabase();
+  SetUp();
+  completed.clear();
+  EXPECT_EQ(db()->GetCompletedReports(&completed),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(completed.empty());
+}
+
+TEST_F(CrashReportDatabaseTest, ChangesVisibleToOtherInstances) {
+  // Two databases open on the same path must each observe the other’s changes,
+  // including across enough changes to require the metadata to be compacted.
+  std::unique_ptr<CrashReportDatabase> other_db(
+      CrashReportDatabase::InitializeWithoutCreating(path()));
+  ASSERT_TRUE(other_db);
+
+  CrashReportDatabase::Report report;
+  CreateCrashReport(&report);
+
+  static constexpr int kAttempts = 300;
+  for (int attempt = 0; attempt < kAttempts; ++attempt) {
+    CrashReportDatabase* const upload_db =
+        attempt % 2 ? db() : other_db.get();
+    const CrashReportDatabase::Report* upload_report = nullptr;
+    ASSERT_EQ(upload_db->GetReportForUploading(report.uuid, &upload_report),
+              CrashReportDatabase::kNoError);
+    EXPECT_EQ(upload_report->upload_attempts, attempt);
+    ASSERT_EQ(upload_db->RecordUploadAttempt(
+                  upload_report, false, std::string()),
+              CrashReportDatabase::kNoError);
+  }
+
+  CrashReportDatabase::Report other_report;
+  EXPECT_EQ(other_db->LookUpCrashReport(report.uuid, &other_report),
+            CrashReportDatabase::kNoError);
+  EXPECT_EQ(other_report.upload_attempts, kAttempts);
+
+  EXPECT_EQ(db()->DeleteReport(report.uuid), CrashReportDatabase::kNoError);
+  EXPECT_EQ(other_db->LookUpCrashReport(report.uuid, &other_report),
+            CrashReportDatabase::kReportNotFound);
+
+  std::vector<CrashReportDatabase::Report> pending;
+  EXPECT_EQ(other_db->GetPendingReports(&pending),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(pending.empty());
+}
+
+class SemaphoreDelegate : public DirectoryChangeWatcher::Delegate {
+ public:
+  SemaphoreDelegate() : DirectoryChangeWatcher::Delegate(), semaphore_(0) {}
+  ~SemaphoreDelegate() {}
+
+  Semaphore* semaphore() { return &semaphore_; }
+
+  // DirectoryChangeWatcher::Delegate:
+  void DirectoryChanged() override { semaphore_.Signal(); }
+
+ private:
+  Semaphore semaphore_;
+
+  DISALLOW_COPY_AND_ASSIGN(SemaphoreDelegate);
+};
+
+TEST_F(CrashReportDatabaseTest, WatchPendingReports) {
+  DirectoryChangeWatcher watcher;
+  ASSERT_TRUE(db()->WatchPendingReports(&watcher));
+
+  SemaphoreDelegate delegate;
+  watcher.Start(&delegate);
+
+  // A report added by another instance of the database is noticed, and is
+  // pending by the time the notification arrives.
+  std::unique_ptr<CrashReportDatabase> other_db(
+      CrashReportDatabase::InitializeWithoutCreating(path()));
+  ASSERT_TRUE(other_db);
+  CrashReportDatabase::NewReport* new_report;
+  ASSERT_EQ(other_db->PrepareNewCrashReport(&new_report),
+            CrashReportDatabase::kNoError);
+  static constexpr char kTest[] = "test";
+  ASSERT_TRUE(LoggingWriteFile(new_report->handle, kTest, sizeof(kTest)));
+  UUID uuid;
+  ASSERT_EQ(other_db->FinishedWritingCrashReport(new_report, &uuid),
+            CrashReportDatabase::kNoError);
+
+  bool found = false;
+  while (!found && delegate.semaphore()->TimedWait(5)) {
+    std::vector<CrashReportDatabase::Report> pending;
+    ASSERT_EQ(db()->GetPendingReports(&pending),
+              CrashReportDatabase::kNoError);
+    for (const auto& report : pending) {
+      found |= report.uuid == uuid;
+    }
+  }
+  EXPECT_TRUE(found);
+
+  watcher.Stop();
+}
+
+// Collects the reports listed, stopping after a limit.
+class SummaryCollector : public CrashReportDatabase::ListReportsDelegate {
+ public:
+  explicit SummaryCollector(size_t limit = std::numeric_limits<size_t>::max())
+      : CrashReportDatabase::ListReportsDelegate(),
+        summaries_(),
+        limit_(limit) {}
+  ~SummaryCollector() {}
+
+  const std::vector<CrashReportDatabase::ReportSummary>& summaries() const {
+    return summaries_;
+  }
+
+  // Returns the UUIDs of the reports listed, as sorted strings.
+  std::vector<std::string> uuids() const {
+    std::vector<std::string> uuids;
+    for (const auto& summary : summaries_) {
+      uuids.push_back(summary.uuid.ToString());
+    }
+    std::sort(uuids.begin(), uuids.end());
+    return uuids;
+  }
+
+  // CrashReportDatabase::ListReportsDelegate:
+  bool ReportListed(
+      const CrashReportDatabase::ReportSummary& summary) override {
+    summaries_.push_back(summary);
+    return summaries_.size() < limit_;
+  }
+
+ private:
+  std::vector<CrashReportDatabase::ReportSummary> summaries_;
+  size_t limit_;
+
+  DISALLOW_COPY_AND_ASSIGN(SummaryCollector);
+};
+
+TEST_F(CrashReportDatabaseTest, ListReports) {
+  std::vector<CrashReportDatabase::Report> reports(4);
+  for (CrashReportDatabase::Report& report : reports) {
+    CreateCrashReport(&report);
+  }
+  UploadReport(reports[1].uuid, true, "1");
+  EXPECT_EQ(db()->SkipReportUpload(
+                reports[2].uuid, Metrics::CrashSkippedReason::kUploadsDisabled),
+            CrashReportDatabase::kNoError);
+
+  // A report being uploaded is not listed.
+  const CrashReportDatabase::Report* uploading;
+  ASSERT_EQ(db()->GetReportForUploading(reports[3].uuid, &uploading),
+            CrashReportDatabase::kNoError);
+
+  {
+    SummaryCollector collector;
+    ASSERT_EQ(
+        db()->ListReports(CrashReportDatabase::ReportFilter(), &collector),
+        CrashReportDatabase::kNoError);
+    std::vector<std::string> expected = {reports[0].uuid.ToString(),
+                                         reports[1].uuid.ToString(),
+                                         reports[2].uuid.ToString()};
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(collector.uuids(), expected);
+
+    for (const auto& summary : collector.summaries()) {
+      EXPECT_EQ(summary.pending, summary.uuid == reports[0].uuid);
+      EXPECT_EQ(summary.uploaded, summary.uuid == reports[1].uuid);
+      EXPECT_EQ(summary.upload_attempts,
+                summary.uuid == reports[1].uuid ? 1 : 0);
+      EXPECT_GT(summary.creation_time, 0);
+      EXPECT_EQ(summary.size_in_kb, 1u);
+    }
+  }
+
+  CrashReportDatabase::ReportFilter filter;
+  filter.completed = false;
+  {
+    SummaryCollector collector;
+    ASSERT_EQ(db()->ListReports(filter, &collector),
+              CrashReportDatabase::kNoError);
+    EXPECT_EQ(collector.uuids(),
+              std::vector<std::string>(1, reports[0].uuid.ToString()));
+  }
+
+  filter = CrashReportDatabase::ReportFilter();
+  filter.upload_status =
+      CrashReportDatabase::ReportFilter::UploadStatus::kUploaded;
+  {
+    SummaryCollector collector;
+    ASSERT_EQ(db()->ListReports(filter, &collector),
+              CrashReportDatabase::kNoError);
+    EXPECT_EQ(collector.uuids(),
+              std::vector<std::string>(1, reports[1].uuid.ToString()));
+  }
+
+  filter.pending = false;
+  filter.upload_status =
+      CrashReportDatabase::ReportFilter::UploadStatus::kNotUploaded;
+  {
+    SummaryCollector collector;
+    ASSERT_EQ(db()->ListReports(filter, &collector),
+              CrashReportDatabase::kNoError);
+    EXPECT_EQ(collector.uuids(),
+              std::vector<std::string>(1, reports[2].uuid.ToString()));
+  }
+
+  // Every report was created no later than now.
+  filter = CrashReportDatabase::ReportFilter();
+  filter.created_at_or_after = time(nullptr) + 60;
+  {
+    SummaryCollector collector;
+    ASSERT_EQ(db()->ListReports(filter, &collector),
+              CrashReportDatabase::kNoError);
+    EXPECT_TRUE(collector.summaries().empty());
+  }
+
+  filter = CrashReportDatabase::ReportFilter();
+  filter.created_before = reports[0].creation_time;
+  {
+    SummaryCollector collector;
+    ASSERT_EQ(db()->ListReports(filter, &collector),
+              CrashReportDatabase::kNoError);
+    EXPECT_TRUE(collector.summaries().empty());
+  }
+
+  // Listing stops when the delegate returns false.
+  {
+    SummaryCollector collector(1);
+    ASSERT_EQ(
+        db()->ListReports(CrashReportDatabase::ReportFilter(), &collector),
+        CrashReportDatabase::kNoError);
+    EXPECT_EQ(collector.summaries().size(), 1u);
+  }
+
+  EXPECT_EQ(db()->RecordUploadAttempt(uploading, false, std::string()),
+            CrashReportDatabase::kNoError);
+}
+
+TEST_F(CrashReportDatabaseTest, DeleteReports) {
+  std::vector<CrashReportDatabase::Report> reports(4);
+  for (CrashReportDatabase::Report& report : reports) {
+    CreateCrashReport(&report);
+  }
+  UploadReport(reports[1].uuid, true, "1");
+  EXPECT_EQ(db()->SkipReportUpload(
+                reports[2].uuid, Metrics::CrashSkippedReason::kUploadsDisabled),
+            CrashReportDatabase::kNoError);
+
+  // A report being uploaded is not deleted.
+  const CrashReportDatabase::Report* uploading;
+  ASSERT_EQ(db()->GetReportForUploading(reports[3].uuid, &uploading),
+            CrashReportDatabase::kNoError);
+
+  CrashReportDatabase::ReportFilter filter;
+  filter.pending = false;
+  size_t deleted_count;
+  EXPECT_EQ(db()->DeleteReports(filter, &deleted_count),
+            CrashReportDatabase::kNoError);
+  EXPECT_EQ(deleted_count, 2u);
+
+  CrashReportDatabase::Report report;
+  for (size_t index : {1, 2}) {
+    EXPECT_EQ(db()->LookUpCrashReport(reports[index].uuid, &report),
+              CrashReportDatabase::kReportNotFound);
+    EXPECT_FALSE(FileExists(reports[index].file_path));
+  }
+  EXPECT_EQ(db()->LookUpCrashReport(reports[0].uuid, &report),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(FileExists(reports[0].file_path));
+
+  EXPECT_EQ(db()->RecordUploadAttempt(uploading, false, std::string()),
+            CrashReportDatabase::kNoError);
+
+  EXPECT_EQ(db()->DeleteReports(CrashReportDatabase::ReportFilter(), nullptr),
+            CrashReportDatabase::kNoError);
+  SummaryCollector collector;
+  ASSERT_EQ(db()->ListReports(CrashReportDatabase::ReportFilter(), &collector),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(collector.summaries().empty());
+}
+
+TEST_F(CrashReportDatabaseTest, RequestUploads) {
+  std::vector<CrashReportDatabase::Report> reports(3);
+  for (CrashReportDatabase::Report& report : reports) {
+    CreateCrashReport(&report);
+  }
+  UploadReport(reports[1].uuid, true, "1");
+  EXPECT_EQ(db()->SkipReportUpload(
+                reports[2].uuid, Metrics::CrashSkippedReason::kUploadsDisabled),
+            CrashReportDatabase::kNoError);
+
+  // The uploaded report is skipped without causing a failure.
+  size_t requested_count;
+  EXPECT_EQ(db()->RequestUploads(CrashReportDatabase::ReportFilter(),
+                                 &requested_count),
+            CrashReportDatabase::kNoError);
+  EXPECT_EQ(requested_count, 2u);
+
+  std::vector<CrashReportDatabase::Report> pending_reports;
+  ASSERT_EQ(db()->GetPendingReports(&pending_reports),
+            CrashReportDatabase::kNoError);
+  ASSERT_EQ(pending_reports.size(), 2u);
+  for (const CrashReportDatabase::Report& pending_report : pending_reports) {
+    EXPECT_NE(pending_report.uuid, reports[1].uuid);
+    EXPECT_TRUE(pending_report.upload_explicitly_requested);
+  }
+
+  CrashReportDatabase::Report report;
+  ASSERT_EQ(db()->LookUpCrashReport(reports[1].uuid, &report),
+            CrashReportDatabase::kNoError);
+  EXPECT_TRUE(report.uploaded);
+  EXPECT_FALSE(report.upload_explicitly_requested);
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
@@ -15,12 +15,14 @@
 #include "client/crash_report_database.h"
 
 #include <windows.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <sys/types.h>
 #include <time.h>
 #include <wchar.h>
 
+#include <algorithm>
 #include <utility>
 
 #include "base/logging.h"
@@ -29,6 +31,7 @@
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "client/settings.h"
+#include "util/file/directory_change_watcher.h"
 #include "util/misc/initialization_state_dcheck.h"
 #include "util/misc/metrics.h"
 
@@ -37,14 +40,39 @@ namespace crashpad {
 namespace {
 
 constexpr wchar_t kReportsDirectory[] = L"reports";
+constexpr wchar_t kUploadParametersDirectory[] = L"upload_parameters";
+constexpr wchar_t kAttachmentsDirectory[] = L"attachments";
 constexpr wchar_t kMetadataFileName[] = L"metadata";
 
 constexpr wchar_t kSettings[] = L"settings.dat";
 
 constexpr wchar_t kCrashReportFileExtension[] = L"dmp";
 
+// In the sharded layout, the reports directory holds a subdirectory, or shard,
+// for each possible pair of leading characters of a report’s UUID, and each new
+// report is written to the shard matching its UUID. This keeps directories
+// small enough that creating and deleting reports stays fast however many the
+// database holds. Each report’s record names the file relative to the reports
+// directory, so reports in either layout are found wherever they are.
+constexpr size_t kReportShardNameLength = 2;
+
+// A database in the flat layout is migrated to the sharded layout once it holds
+// at least this many reports. A database holding any report in a shard is in
+// the sharded layout.
+constexpr size_t kShardedLayoutMinReports = 4096;
+
 constexpr uint32_t kMetadataFileHeaderMagic = 'CPAD';
-constexpr uint32_t kMetadataFileVersion = 1;
+constexpr uint32_t kMetadataFileVersion = 2;
+
+// Version 1 metadata files hold a snapshot of all records followed by a string
+// table. They are read, and rewritten as version 2 files.
+constexpr uint32_t kMetadataFileVersionSnapshot = 1;
+
+constexpr uint32_t kMetadataJournalEntryMagic = 'CPJE';
+
+// The journal is compacted once it holds at least this many entries and more
+// than twice as many entries as reports.
+constexpr size_t kMetadataCompactionMinEntries = 256;
 
 using OperationStatus = CrashReportDatabase::OperationStatus;
 
@@ -84,13 +112,43 @@ std::string ReadRestOfFileAsString(FileHandle file) {
 // Helper structures, and conversions ------------------------------------------
 
 // The format of the on disk metadata file is a MetadataFileHeader, followed by
-// a number of fixed size records of MetadataFileReportRecord, followed by a
-// string table in UTF8 format, where each string is \0 terminated.
+// a journal of entries. Each entry is a MetadataJournalEntryHeader followed by
+// MetadataJournalEntryHeader::size bytes: a MetadataFileReportRecord, followed
+// by a string table in UTF8 format, where each string is \0 terminated. Entries
+// are appended as reports change, and a later entry for a UUID supersedes any
+// earlier one. When superseded entries dominate the journal, it is compacted,
+// by rewriting it with a single entry for each report.
+//
+// In a version 1 file, the header is followed by num_records fixed size
+// MetadataFileReportRecords, followed by a single string table.
 struct MetadataFileHeader {
   uint32_t magic;
   uint32_t version;
-  uint32_t num_records;
-  uint32_t padding;
+  uint32_t num_records;  // Version 1 only.
+
+  // Version 2: incremented each time the journal is compacted, so that a
+  // MetadataCache can determine whether it describes the journal’s beginning.
+  uint32_t generation;
+};
+
+enum : uint32_t {
+  //! \brief The entry’s record holds the current state of a report.
+  kMetadataJournalEntryUpdate = 1,
+
+  //! \brief The report identified by the entry’s record was removed.
+  kMetadataJournalEntryDelete,
+};
+
+struct MetadataJournalEntryHeader {
+  uint32_t magic;
+
+  // An FNV-1a hash of |size|, |op|, and the entry’s data. The journal ends at
+  // the first entry that doesn’t match, such as one that a crash interrupted
+  // while it was being appended.
+  uint32_t checksum;
+
+  uint32_t size;
+  uint32_t op;  // kMetadataJournalEntry*.
 };
 
 struct ReportDisk;
@@ -110,6 +168,9 @@ enum {
 
   //! \brief Corresponds to upload_explicity_requested bit of the report state.
   kAttributeUploadExplicitlyRequested = 1 << 1,
+
+  //! \brief Corresponds to dump_without_crash bit of the report state.
+  kAttributeDumpWithoutCrash = 1 << 2,
 };
 
 struct MetadataFileReportRecord {
@@ -120,18 +181,22 @@ struct MetadataFileReportRecord {
 
   // Constructs from a ReportDisk, adding to |string_table| and storing indices
   // as strings into that table.
-  MetadataFileReportRecord(const ReportDisk& report, std::string* string_table);
+  MetadataFileReportRecord(const ReportDisk& report,
+                           const base::FilePath& report_dir,
+                           std::string* string_table);
 
   UUID uuid;  // UUID is a 16 byte, standard layout structure.
-  uint32_t file_path_index;  // Index into string table. File name is relative
-                             // to the reports directory when on disk.
+  uint32_t file_path_index;  // Index into string table. File path is relative
+                             // to the reports directory when on disk, and
+                             // names a shard in the sharded layout.
   uint32_t id_index;  // Index into string table.
   int64_t creation_time;  // Holds a time_t.
   int64_t last_upload_attempt_time;  // Holds a time_t.
   int32_t upload_attempts;
   int32_t state;  // A ReportState.
   uint8_t attributes;  // Bitfield of kAttribute*.
-  uint8_t padding[7];
+  uint8_t padding[3];
+  uint32_t size_in_kb;  // 0 in records written before sizes were recorded.
 };
 
 //! \brief A private extension of the Report class that includes additional data
@@ -150,11 +215,19 @@ struct ReportDisk : public CrashReportDatabase::Report {
   ReportState state;
 };
 
-MetadataFileReportRecord::MetadataFileReportRecord(const ReportDisk& report,
-                                                   std::string* string_table)
+MetadataFileReportRecord::MetadataFileReportRecord(
+    const ReportDisk& report,
+    const base::FilePath& report_dir,
+    std::string* string_table)
     : uuid(report.uuid),
-      file_path_index(
-          AddStringToTable(string_table, report.file_path.BaseName().value())),
+      file_path_index(AddStringToTable(
+          string_table,
+          report.file_path.DirName() == report_dir
+              ? report.file_path.BaseName().value()
+              : report.file_path.DirName()
+                    .BaseName()
+                    .Append(report.file_path.BaseName())
+                    .value())),
       id_index(AddStringToTable(string_table, report.id)),
       creation_time(report.creation_time),
       last_upload_attempt_time(report.last_upload_attempt_time),
@@ -163,7 +236,10 @@ MetadataFileReportRecord::MetadataFileReportRecord(const ReportDisk& report,
       attributes((report.uploaded ? kAttributeUploaded : 0) |
                  (report.upload_explicitly_requested
                       ? kAttributeUploadExplicitlyRequested
-                      : 0)) {
+                      : 0) |
+                 (report.dump_without_crash ? kAttributeDumpWithoutCrash
+                                            : 0)),
+      size_in_kb(report.size_in_kb) {
   memset(&padding, 0, sizeof(padding));
 }
 
@@ -182,6 +258,8 @@ ReportDisk::ReportDisk(const MetadataFileReportRecord& record,
   uploaded = (record.attributes & kAttributeUploaded) != 0;
   upload_explicitly_requested =
       (record.attributes & kAttributeUploadExplicitlyRequested) != 0;
+  dump_without_crash = (record.attributes & kAttributeDumpWithoutCrash) != 0;
+  size_in_kb = record.size_in_kb;
 }
 
 ReportDisk::ReportDisk(const UUID& uuid,
@@ -195,6 +273,66 @@ ReportDisk::ReportDisk(const UUID& uuid,
   this->state = state;
 }
 
+// Computes MetadataJournalEntryHeader::checksum for the |size| bytes of the
+// journal entry at |entry|.
+uint32_t JournalEntryChecksum(const char* entry, size_t size) {
+  constexpr size_t kChecksummedOffset =
+      offsetof(MetadataJournalEntryHeader, size);
+  uint32_t hash = 2166136261u;
+  for (size_t index = kChecksummedOffset; index < size; ++index) {
+    hash = (hash ^ static_cast<uint8_t>(entry[index])) * 16777619u;
+  }
+  return hash;
+}
+
+// Appends a journal entry of type |op|, holding |record| and |string_table|, to
+// |journal|.
+void AppendJournalEntry(uint32_t op,
+                        const MetadataFileReportRecord& record,
+                        const std::string& string_table,
+                        std::string* journal) {
+  MetadataJournalEntryHeader header;
+  header.magic = kMetadataJournalEntryMagic;
+  header.checksum = 0;
+  header.size =
+      base::checked_cast<uint32_t>(sizeof(record) + string_table.size());
+  header.op = op;
+
+  const size_t entry_offset = journal->size();
+  journal->append(reinterpret_cast<const char*>(&header), sizeof(header));
+  journal->append(reinterpret_cast<const char*>(&record), sizeof(record));
+  journal->append(string_table);
+
+  header.checksum = JournalEntryChecksum(&(*journal)[entry_offset],
+                                         journal->size() - entry_offset);
+  memcpy(&(*journal)[entry_offset], &header, sizeof(header));
+}
+
+//! \brief The contents of the metadata file as of the last time that it was
+//!     read or written by a CrashReportDatabaseWin.
+//!
+//! This allows a Metadata object to read only the journal entries appended
+//! since the last operation, rather than the entire file. It must only be
+//! accessed while the metadata file is locked.
+struct MetadataCache {
+  MetadataCache() : reports(), offset(0), generation(0), entry_count(0) {}
+
+  //! \brief Reports described by the journal, up to #offset.
+  std::vector<ReportDisk> reports;
+
+  //! \brief The offset in the file just beyond the last journal entry that
+  //!     #reports reflects, or `0` if the cache does not describe a valid
+  //!     version 2 journal, requiring the file to be read in full.
+  FileOffset offset;
+
+  //! \brief MetadataFileHeader::generation of the journal that #reports
+  //!     reflects.
+  uint32_t generation;
+
+  //! \brief The number of entries in the journal up to #offset.
+  size_t entry_count;
+};
+
 // Metadata --------------------------------------------------------------------
 
 //! \brief Manages the metadata for the set of reports, handling serialization
@@ -205,8 +343,18 @@ class Metadata {
   //!     handle.
   ~Metadata();
 
+  //! \brief Opens and locks the metadata file, bringing \a cache up to date
+  //!     with its contents.
+  //!
+  //! \param[in] metadata_file The path to the metadata file.
+  //! \param[in] report_dir The directory containing the reports.
+  //! \param[in] cache The state of the metadata file as previously observed.
+  //!     The Metadata object operates on this cache’s reports directly, so it
+  //!     must outlive the returned object, and no other Metadata object may use
+  //!     it concurrently.
   static std::unique_ptr<Metadata> Create(const base::FilePath& metadata_file,
-                                          const base::FilePath& report_dir);
+                                          const base::FilePath& report_dir,
+                                          MetadataCache* cache);
 
   //! \brief Adds a new report to the set.
   //!
@@ -223,6 +371,15 @@ class Metadata {
       ReportState desired_state,
       std::vector<CrashReportDatabase::Report>* reports) const;
 
+  //! \brief Lists the pending and completed reports selected by \a filter, as
+  //!     in CrashReportDatabase::ListReports().
+  //!
+  //! Unlike FindReports(), this does not confirm that each report’s file still
+  //! exists, so that it needs nothing beyond a scan of the cache.
+  void ListReports(
+      const CrashReportDatabase::ReportFilter& filter,
+      CrashReportDatabase::ListReportsDelegate* delegate) const;
+
   //! \brief Finds the report matching the given UUID.
   //!
   //! The returned report is only valid if CrashReportDatabase::kNoError is
@@ -262,14 +419,74 @@ class Metadata {
   OperationStatus DeleteReport(const UUID& uuid,
                                base::FilePath* report_path);
 
+  //! \brief Removes the pending and completed reports selected by \a filter
+  //!     from the metadata database, without touching their on-disk files.
+  //!
+  //! This will mark the database as dirty.
+  //!
+  //! \param[in] filter The reports to remove.
+  //! \param[out] report_paths The removed reports’ file paths, appended to.
+  void DeleteReports(const CrashReportDatabase::ReportFilter& filter,
+                     std::vector<base::FilePath>* report_paths);
+
+  //! \brief Marks the pending and completed reports selected by \a filter
+  //!     that haven’t been uploaded as having upload explicitly requested, and
+  //!     moves them to the pending state.
+  //!
+  //! This will mark the database as dirty.
+  //!
+  //! \return The number of reports marked.
+  size_t RequestUploads(const CrashReportDatabase::ReportFilter& filter);
+
+  //! \brief Determines whether the database is in the sharded layout, or
+  //!     holds enough reports, at least \a min_reports, to be migrated to it.
+  bool WantsShardedLayout(size_t min_reports) const;
+
+  //! \brief Moves the files of reports in the flat layout into their shards,
+  //!     which must exist.
+  //!
+  //! Reports whose files can’t be moved, such as those open for uploading, are
+  //! left where they are. This will mark the database as dirty if any report
+  //! is moved.
+  void MoveReportsToShards();
+
  private:
-  Metadata(FileHandle handle, const base::FilePath& report_dir);
+  Metadata(FileHandle handle,
+           const base::FilePath& report_dir,
+           MetadataCache* cache);
 
   bool Rewind();
 
+  //! \brief Brings the cache up to date with the file, reading only the
+  //!     journal entries appended since the cache was last updated when
+  //!     possible.
   void Read();
+
+  //! \brief Reads a version 1 file, whose header has already been read, in
+  //!     full.
+  void ReadSnapshot(const MetadataFileHeader& header);
+
+  //! \brief Applies the journal entries in \a journal, which was read from the
+  //!     cache’s offset, to the cache. Stops at the first damaged entry.
+  void ReadJournal(const std::string& journal);
+
+  //! \brief Appends journal entries for the reports that changed, or rewrites
+  //!     the journal in full when it needs to be compacted.
   void Write();
 
+  //! \brief Notes that the report identified by \a uuid changed, to be recorded
+  //!     by Write().
+  void MarkChanged(const UUID& uuid);
+
+  //! \brief Returns the report identified by \a uuid, or the end of the
+  //!     cache’s reports.
+  std::vector<ReportDisk>::iterator FindReport(const UUID& uuid);
+
+  //! \brief Fills \a summary from \a report_disk, which must be pending or
+  //!     completed.
+  static void SummarizeReport(const ReportDisk& report_disk,
+                              CrashReportDatabase::ReportSummary* summary);
+
   //! \brief Confirms that the corresponding report actually exists on disk
   //!     (that is, the dump file has not been removed), and that the report is
   //!     in the given state.
@@ -282,7 +499,8 @@ class Metadata {
   ScopedFileHandle handle_;
   const base::FilePath report_dir_;
   bool dirty_;  //! \brief `true` when a Write() is required on destruction.
-  std::vector<ReportDisk> reports_;
+  MetadataCache* cache_;  // weak
+  std::vector<UUID> changed_;  // Reports added, modified, or deleted.
 
   DISALLOW_COPY_AND_ASSIGN(Metadata);
 };
@@ -298,7 +516,8 @@ Metadata::~Metadata() {
 
 // static
 std::unique_ptr<Metadata> Metadata::Create(const base::FilePath& metadata_file,
-                                           const base::FilePath& report_dir) {
+                                           const base::FilePath& report_dir,
+                                           MetadataCache* cache) {
   // It is important that dwShareMode be non-zero so that concurrent access to
   // this file results in a successful open. This allows us to get to LockFileEx
   // which then blocks to guard access.
@@ -323,26 +542,27 @@ std::unique_ptr<Metadata> Metadata::Create(const base::FilePath& metadata_file,
     return std::unique_ptr<Metadata>();
   }
 
-  std::unique_ptr<Metadata> metadata(new Metadata(handle, report_dir));
-  // If Read() fails, for whatever reason (corruption, etc.) metadata will not
-  // have been modified and will be in a clean empty state. We continue on and
-  // return an empty database to hopefully recover. This means that existing
-  // crash reports have been orphaned.
+  std::unique_ptr<Metadata> metadata(new Metadata(handle, report_dir, cache));
+  // If Read() fails, for whatever reason (corruption, etc.) metadata will be in
+  // a clean empty state. We continue on and return an empty database to
+  // hopefully recover. This means that existing crash reports have been
+  // orphaned. If Read() finds a damaged journal entry, the reports recorded
+  // before it are retained.
   metadata->Read();
   return metadata;
 }
 
 void Metadata::AddNewRecord(const ReportDisk& new_report_disk) {
   DCHECK(new_report_disk.state == ReportState::kPending);
-  reports_.push_back(new_report_disk);
-  dirty_ = true;
+  cache_->reports.push_back(new_report_disk);
+  MarkChanged(new_report_disk.uuid);
 }
 
 OperationStatus Metadata::FindReports(
     ReportState desired_state,
     std::vector<CrashReportDatabase::Report>* reports) const {
   DCHECK(reports->empty());
-  for (const auto& report : reports_) {
+  for (const auto& report : cache_->reports) {
     if (report.state == desired_state &&
         VerifyReport(report, desired_state) == CrashReportDatabase::kNoError) {
       reports->push_back(report);
@@ -351,14 +571,116 @@ OperationStatus Metadata::FindReports(
   return CrashReportDatabase::kNoError;
 }
 
+void Metadata::ListReports(
+    const CrashReportDatabase::ReportFilter& filter,
+    CrashReportDatabase::ListReportsDelegate* delegate) const {
+  for (const auto& report : cache_->reports) {
+    if (report.state != ReportState::kPending &&
+        report.state != ReportState::kCompleted) {
+      continue;
+    }
+    CrashReportDatabase::ReportSummary summary;
+    SummarizeReport(report, &summary);
+    if (filter.Matches(summary) && !delegate->ReportListed(summary)) {
+      return;
+    }
+  }
+}
+
+void Metadata::DeleteReports(const CrashReportDatabase::ReportFilter& filter,
+                             std::vector<base::FilePath>* report_paths) {
+  std::vector<ReportDisk>& reports = cache_->reports;
+  auto kept_end = std::remove_if(
+      reports.begin(),
+      reports.end(),
+      [this, &filter, report_paths](const ReportDisk& report) {
+        if (report.state != ReportState::kPending &&
+            report.state != ReportState::kCompleted) {
+          return false;
+        }
+        CrashReportDatabase::ReportSummary summary;
+        SummarizeReport(report, &summary);
+        if (!filter.Matches(summary)) {
+          return false;
+        }
+        report_paths->push_back(report.file_path);
+        MarkChanged(report.uuid);
+        return true;
+      });
+  reports.erase(kept_end, reports.end());
+}
+
+size_t Metadata::RequestUploads(
+    const CrashReportDatabase::ReportFilter& filter) {
+  size_t count = 0;
+  for (auto& report : cache_->reports) {
+    if ((report.state != ReportState::kPending &&
+         report.state != ReportState::kCompleted) ||
+        report.uploaded) {
+      continue;
+    }
+    CrashReportDatabase::ReportSummary summary;
+    SummarizeReport(report, &summary);
+    if (!filter.Matches(summary)) {
+      continue;
+    }
+
+    // As in CrashReportDatabaseWin::RequestUpload().
+    report.upload_explicitly_requested = true;
+    report.state = ReportState::kPending;
+    MarkChanged(report.uuid);
+    ++count;
+  }
+  return count;
+}
+
+bool Metadata::WantsShardedLayout(size_t min_reports) const {
+  const std::vector<ReportDisk>& reports = cache_->reports;
+  if (reports.size() >= min_reports) {
+    return true;
+  }
+  return std::any_of(
+      reports.begin(), reports.end(), [this](const ReportDisk& report) {
+        return report.file_path.DirName() != report_dir_;
+      });
+}
+
+void Metadata::MoveReportsToShards() {
+  bool moved = false;
+  for (auto& report : cache_->reports) {
+    if (report.file_path.DirName() != report_dir_) {
+      continue;
+    }
+    const base::FilePath file_name = report.file_path.BaseName();
+    const base::FilePath new_path =
+        report_dir_.Append(file_name.value().substr(0, kReportShardNameLength))
+            .Append(file_name);
+    if (!MoveFileEx(report.file_path.value().c_str(),
+                    new_path.value().c_str(),
+                    0)) {
+      continue;
+    }
+    report.file_path = new_path;
+    moved = true;
+  }
+
+  // Rather than appending an entry for each report moved, the journal is
+  // rewritten in full.
+  if (moved) {
+    dirty_ = true;
+    cache_->offset = 0;
+  }
+}
+
 OperationStatus Metadata::FindSingleReport(
     const UUID& uuid,
     const ReportDisk** out_report) const {
+  const std::vector<ReportDisk>& reports = cache_->reports;
   auto report_iter = std::find_if(
-      reports_.begin(), reports_.end(), [uuid](const ReportDisk& report) {
+      reports.begin(), reports.end(), [uuid](const ReportDisk& report) {
         return report.uuid == uuid;
       });
-  if (report_iter == reports_.end())
+  if (report_iter == reports.end())
     return CrashReportDatabase::kReportNotFound;
   OperationStatus os = VerifyReportAnyState(*report_iter);
   if (os == CrashReportDatabase::kNoError)
@@ -370,15 +692,12 @@ OperationStatus Metadata::FindSingleReportAndMarkDirty(
     const UUID& uuid,
     ReportState desired_state,
     ReportDisk** report_disk) {
-  auto report_iter = std::find_if(
-      reports_.begin(), reports_.end(), [uuid](const ReportDisk& report) {
-        return report.uuid == uuid;
-      });
-  if (report_iter == reports_.end())
+  auto report_iter = FindReport(uuid);
+  if (report_iter == cache_->reports.end())
     return CrashReportDatabase::kReportNotFound;
   OperationStatus os = VerifyReport(*report_iter, desired_state);
   if (os == CrashReportDatabase::kNoError) {
-    dirty_ = true;
+    MarkChanged(uuid);
     *report_disk = &*report_iter;
   }
   return os;
@@ -386,20 +705,23 @@ OperationStatus Metadata::FindSingleReportAndMarkDirty(
 
 OperationStatus Metadata::DeleteReport(const UUID& uuid,
                                        base::FilePath* report_path) {
-  auto report_iter = std::find_if(
-      reports_.begin(), reports_.end(), [uuid](const ReportDisk& report) {
-        return report.uuid == uuid;
-      });
-  if (report_iter == reports_.end())
+  auto report_iter = FindReport(uuid);
+  if (report_iter == cache_->reports.end())
     return CrashReportDatabase::kReportNotFound;
   *report_path = report_iter->file_path;
-  reports_.erase(report_iter);
-  dirty_ = true;
+  cache_->reports.erase(report_iter);
+  MarkChanged(uuid);
   return CrashReportDatabase::kNoError;
 }
 
-Metadata::Metadata(FileHandle handle, const base::FilePath& report_dir)
-    : handle_(handle), report_dir_(report_dir), dirty_(false), reports_() {
+Metadata::Metadata(FileHandle handle,
+                   const base::FilePath& report_dir,
+                   MetadataCache* cache)
+    : handle_(handle),
+      report_dir_(report_dir),
+      dirty_(false),
+      cache_(cache),
+      changed_() {
 }
 
 bool Metadata::Rewind() {
@@ -410,8 +732,36 @@ bool Metadata::Rewind() {
 
 void Metadata::Read() {
   FileOffset length = LoggingSeekFile(handle_.get(), 0, SEEK_END);
-  if (length <= 0)  // Failed, or empty: Abort.
+  if (length <= 0) {  // Failed, or empty: Abort.
+    cache_->reports.clear();
+    cache_->offset = 0;
     return;
+  }
+
+  // A cache that stops within the file’s length, in the same journal
+  // generation, is still accurate up to its offset. Only what follows needs to
+  // be read.
+  if (cache_->offset != 0 && cache_->offset <= length) {
+    MetadataFileHeader header;
+    if (Rewind() &&
+        LoggingReadFileExactly(handle_.get(), &header, sizeof(header)) &&
+        header.magic == kMetadataFileHeaderMagic &&
+        header.version == kMetadataFileVersion &&
+        header.generation == cache_->generation) {
+      if (cache_->offset == length)
+        return;
+      if (LoggingSeekFile(handle_.get(), cache_->offset, SEEK_SET) ==
+          cache_->offset) {
+        ReadJournal(ReadRestOfFileAsString(handle_.get()));
+        return;
+      }
+    }
+  }
+
+  cache_->reports.clear();
+  cache_->offset = 0;
+  cache_->entry_count = 0;
+
   if (!Rewind()) {
     LOG(ERROR) << "failed to rewind to read";
     return;
@@ -422,12 +772,27 @@ void Metadata::Read() {
     LOG(ERROR) << "failed to read header";
     return;
   }
-  if (header.magic != kMetadataFileHeaderMagic ||
-      header.version != kMetadataFileVersion) {
+  if (header.magic != kMetadataFileHeaderMagic) {
+    LOG(ERROR) << "unexpected header";
+    return;
+  }
+  if (header.version == kMetadataFileVersionSnapshot) {
+    // This leaves the cache’s offset at 0, so that the next Write() replaces
+    // the snapshot with a journal.
+    ReadSnapshot(header);
+    return;
+  }
+  if (header.version != kMetadataFileVersion) {
     LOG(ERROR) << "unexpected header";
     return;
   }
 
+  cache_->generation = header.generation;
+  cache_->offset = sizeof(header);
+  ReadJournal(ReadRestOfFileAsString(handle_.get()));
+}
+
+void Metadata::ReadSnapshot(const MetadataFileHeader& header) {
   base::CheckedNumeric<uint32_t> records_size =
       base::CheckedNumeric<uint32_t>(header.num_records) *
       static_cast<uint32_t>(sizeof(MetadataFileReportRecord));
@@ -460,62 +825,203 @@ void Metadata::Read() {
       reports.push_back(ReportDisk(record, report_dir_, string_table));
     }
   }
-  reports_.swap(reports);
+  cache_->reports.swap(reports);
 }
 
-void Metadata::Write() {
-  if (!Rewind()) {
-    LOG(ERROR) << "failed to rewind to write";
-    return;
-  }
+void Metadata::ReadJournal(const std::string& journal) {
+  size_t position = 0;
+  while (position < journal.size()) {
+    MetadataJournalEntryHeader header;
+    if (journal.size() - position < sizeof(header)) {
+      LOG(WARNING) << "truncated journal entry";
+      return;
+    }
+    memcpy(&header, &journal[position], sizeof(header));
 
-  // Truncate to ensure that a partial write doesn't cause a mix of old and new
-  // data causing an incorrect interpretation on read.
-  if (!SetEndOfFile(handle_.get())) {
-    PLOG(ERROR) << "failed to truncate";
-    return;
-  }
+    const size_t data_offset = position + sizeof(header);
+    if (header.magic != kMetadataJournalEntryMagic ||
+        header.size < sizeof(MetadataFileReportRecord) + 1 ||
+        header.size > journal.size() - data_offset) {
+      LOG(WARNING) << "truncated journal entry";
+      return;
+    }
+    if (header.checksum != JournalEntryChecksum(&journal[position],
+                                                sizeof(header) + header.size)) {
+      LOG(WARNING) << "journal entry checksum mismatch";
+      return;
+    }
 
-  size_t num_records = reports_.size();
+    MetadataFileReportRecord record;
+    memcpy(&record, &journal[data_offset], sizeof(record));
+    const std::string string_table =
+        journal.substr(data_offset + sizeof(record),
+                       header.size - sizeof(record));
+    if (string_table.back() != '\0' ||
+        record.file_path_index >= string_table.size() ||
+        record.id_index >= string_table.size()) {
+      LOG(ERROR) << "invalid string table index";
+      return;
+    }
 
-  // Fill and write out the header.
-  MetadataFileHeader header = {0};
-  header.magic = kMetadataFileHeaderMagic;
-  header.version = kMetadataFileVersion;
-  header.num_records = base::checked_cast<uint32_t>(num_records);
-  if (!LoggingWriteFile(handle_.get(), &header, sizeof(header))) {
-    LOG(ERROR) << "failed to write header";
-    return;
-  }
+    auto report_iter = FindReport(record.uuid);
+    switch (header.op) {
+      case kMetadataJournalEntryUpdate: {
+        ReportDisk report(record, report_dir_, string_table);
+        if (report_iter == cache_->reports.end()) {
+          cache_->reports.push_back(report);
+        } else {
+          *report_iter = report;
+        }
+        break;
+      }
 
-  if (num_records == 0)
-    return;
+      case kMetadataJournalEntryDelete:
+        if (report_iter != cache_->reports.end()) {
+          cache_->reports.erase(report_iter);
+        }
+        break;
+
+      default:
+        LOG(ERROR) << "unexpected journal entry " << header.op;
+        return;
+    }
+
+    position = data_offset + header.size;
+    cache_->offset += sizeof(header) + header.size;
+    ++cache_->entry_count;
+  }
+}
 
-  // Build the records and string table we're going to write.
-  std::string string_table;
-  std::vector<MetadataFileReportRecord> records;
-  records.reserve(num_records);
-  for (const auto& report : reports_) {
+void Metadata::Write() {
+  std::vector<ReportDisk>& reports = cache_->reports;
+
+  // Compact when there’s no journal to append to, or when most of its entries
+  // have been superseded.
+  const bool compact =
+      cache_->offset == 0 ||
+      (cache_->entry_count >= kMetadataCompactionMinEntries &&
+       cache_->entry_count > 2 * reports.size());
+
+  // Build the journal entries we’re going to write.
+  std::string journal;
+  size_t entry_count = 0;
+  auto append_update = [this, &journal, &entry_count](
+                           const ReportDisk& report) {
     const base::FilePath& path = report.file_path;
-    if (path.DirName() != report_dir_) {
+    if (path.DirName() != report_dir_ &&
+        path.DirName().DirName() != report_dir_) {
       LOG(ERROR) << path.value().c_str() << " expected to start with "
                  << base::UTF16ToUTF8(report_dir_.value());
-      return;
+      return false;
+    }
+    std::string string_table;
+    MetadataFileReportRecord record(report, report_dir_, &string_table);
+    AppendJournalEntry(
+        kMetadataJournalEntryUpdate, record, string_table, &journal);
+    ++entry_count;
+    return true;
+  };
+
+  MetadataFileHeader header = {0};
+  if (compact) {
+    header.magic = kMetadataFileHeaderMagic;
+    header.version = kMetadataFileVersion;
+    header.num_records = 0;
+    header.generation = cache_->generation + 1;
+    journal.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& report : reports) {
+      if (!append_update(report)) {
+        cache_->offset = 0;
+        return;
+      }
     }
-    records.push_back(MetadataFileReportRecord(report, &string_table));
+  } else {
+    for (const UUID& uuid : changed_) {
+      auto report_iter = FindReport(uuid);
+      if (report_iter != reports.end()) {
+        if (!append_update(*report_iter)) {
+          cache_->offset = 0;
+          return;
+        }
+        continue;
+      }
+
+      MetadataFileReportRecord record;
+      memset(&record, 0, sizeof(record));
+      record.uuid = uuid;
+      AppendJournalEntry(
+          kMetadataJournalEntryDelete, record, std::string(1, '\0'), &journal);
+      ++entry_count;
+    }
+  }
+
+  // Until the write completes, the file’s contents can’t be relied upon to
+  // match the cache.
+  const FileOffset write_offset = compact ? 0 : cache_->offset;
+  cache_->offset = 0;
+
+  if (LoggingSeekFile(handle_.get(), write_offset, SEEK_SET) != write_offset) {
+    LOG(ERROR) << "failed to seek to write";
+    return;
+  }
+
+  // When compacting, truncate first to ensure that a partial write doesn't
+  // cause a mix of old and new data causing an incorrect interpretation on
+  // read. When appending, a partial write leaves a damaged entry at the end of
+  // the journal, which readers ignore.
+  if (compact && !SetEndOfFile(handle_.get())) {
+    PLOG(ERROR) << "failed to truncate";
+    return;
   }
 
-  if (!LoggingWriteFile(handle_.get(),
-                        &records[0],
-                        records.size() * sizeof(MetadataFileReportRecord))) {
-    LOG(ERROR) << "failed to write records";
+  if (!LoggingWriteFile(handle_.get(), journal.data(), journal.size())) {
+    LOG(ERROR) << "failed to write journal";
     return;
   }
-  if (!LoggingWriteFile(
-          handle_.get(), string_table.c_str(), string_table.size())) {
-    LOG(ERROR) << "failed to write string table";
+
+  // Discard anything beyond the new end of the journal, such as a damaged entry
+  // left behind by an earlier interrupted write.
+  if (!compact && !SetEndOfFile(handle_.get())) {
+    PLOG(ERROR) << "failed to truncate";
     return;
   }
+
+  if (compact) {
+    cache_->generation = header.generation;
+    cache_->entry_count = entry_count;
+  } else {
+    cache_->entry_count += entry_count;
+  }
+  cache_->offset =
+      write_offset + base::checked_cast<FileOffset>(journal.size());
+}
+
+void Metadata::MarkChanged(const UUID& uuid) {
+  dirty_ = true;
+  if (std::find(changed_.begin(), changed_.end(), uuid) == changed_.end())
+    changed_.push_back(uuid);
+}
+
+// static
+void Metadata::SummarizeReport(const ReportDisk& report_disk,
+                               CrashReportDatabase::ReportSummary* summary) {
+  summary->uuid = report_disk.uuid;
+  summary->creation_time = report_disk.creation_time;
+  summary->last_upload_attempt_time = report_disk.last_upload_attempt_time;
+  summary->upload_attempts = report_disk.upload_attempts;
+  summary->size_in_kb = report_disk.size_in_kb;
+  summary->pending = report_disk.state == ReportState::kPending;
+  summary->uploaded = report_disk.uploaded;
+  summary->upload_explicitly_requested =
+      report_disk.upload_explicitly_requested;
+  summary->dump_without_crash = report_disk.dump_without_crash;
+}
+
+std::vector<ReportDisk>::iterator Metadata::FindReport(const UUID& uuid) {
+  return std::find_if(
+      cache_->reports.begin(),
+      cache_->reports.end(),
+      [uuid](const ReportDisk& report) { return report.uuid == uuid; });
 }
 
 // static
@@ -598,12 +1104,31 @@ class CrashReportDatabaseWin : public CrashReportDatabase {
                                    Metrics::CrashSkippedReason reason) override;
   OperationStatus DeleteReport(const UUID& uuid) override;
   OperationStatus RequestUpload(const UUID& uuid) override;
+  bool WatchPendingReports(DirectoryChangeWatcher* watcher) override;
+  OperationStatus ListReports(const ReportFilter& filter,
+                              ListReportsDelegate* delegate) override;
+  OperationStatus DeleteReports(const ReportFilter& filter,
+                                size_t* deleted_count) override;
+  OperationStatus RequestUploads(const ReportFilter& filter,
+                                 size_t* requested_count) override;
+
+ protected:
+  void FlushReportRecords() override;
 
  private:
   std::unique_ptr<Metadata> AcquireMetadata();
 
+  //! \brief Switches the database to the sharded layout if it is large enough
+  //!     to benefit, or if another instance already has, and moves reports
+  //!     left in the flat layout into shards.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool MigrateReportLayout();
+
   base::FilePath base_dir_;
   Settings settings_;
+  MetadataCache metadata_cache_;
+  bool sharded_;
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(CrashReportDatabaseWin);
@@ -613,6 +1138,8 @@ CrashReportDatabaseWin::CrashReportDatabaseWin(const base::FilePath& path)
     : CrashReportDatabase(),
       base_dir_(path),
       settings_(base_dir_.Append(kSettings)),
+      metadata_cache_(),
+      sharded_(false),
       initialized_() {
 }
 
@@ -634,9 +1161,27 @@ bool CrashReportDatabaseWin::Initialize(bool may_create) {
   if (!CreateDirectoryIfNecessary(base_dir_.Append(kReportsDirectory)))
     return false;
 
+  // Spare report files are named so that they’re never taken for reports.
+  SetSpareReportFileDirectory(base_dir_.Append(kReportsDirectory));
+
+  // Upload parameters are kept apart from reports, so that recording them
+  // doesn’t disturb anything watching the report subdirectory.
+  if (!CreateDirectoryIfNecessary(base_dir_.Append(kUploadParametersDirectory)))
+    return false;
+  SetUploadParametersDirectory(base_dir_.Append(kUploadParametersDirectory));
+
+  // Attached files are cloned into the database, so they must be on the same
+  // file system as the files attached.
+  if (!CreateDirectoryIfNecessary(base_dir_.Append(kAttachmentsDirectory)))
+    return false;
+  SetAttachmentsDirectory(base_dir_.Append(kAttachmentsDirectory));
+
   if (!settings_.Initialize())
     return false;
 
+  if (!MigrateReportLayout())
+    return false;
+
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
@@ -653,12 +1198,15 @@ OperationStatus CrashReportDatabaseWin::PrepareNewCrashReport(
   std::unique_ptr<NewReport> new_report(new NewReport());
   if (!new_report->uuid.InitializeWithNew())
     return kFileSystemError;
-  new_report->path = base_dir_.Append(kReportsDirectory)
-                         .Append(new_report->uuid.ToString16() + L"." +
-                                 kCrashReportFileExtension);
-  new_report->handle = LoggingOpenFileForWrite(new_report->path,
-                                               FileWriteMode::kCreateOrFail,
-                                               FilePermissions::kOwnerOnly);
+  const base::string16 file_name =
+      new_report->uuid.ToString16() + L"." + kCrashReportFileExtension;
+  new_report->path = base_dir_.Append(kReportsDirectory);
+  if (sharded_) {
+    new_report->path =
+        new_report->path.Append(file_name.substr(0, kReportShardNameLength));
+  }
+  new_report->path = new_report->path.Append(file_name);
+  new_report->handle = OpenNewReportFile(new_report->path);
   if (new_report->handle == INVALID_HANDLE_VALUE)
     return kFileSystemError;
 
@@ -675,14 +1223,28 @@ OperationStatus CrashReportDatabaseWin::FinishedWritingCrashReport(
   std::unique_ptr<NewReport> scoped_report(report);
   // Take ownership of the file handle.
   ScopedFileHandle handle(report->handle);
+  FinishNewReportFile(handle.get());
+
+  WriteUploadParameters(*scoped_report);
+  WriteAttachments(*scoped_report);
 
   std::unique_ptr<Metadata> metadata(AcquireMetadata());
-  if (!metadata)
+  if (!metadata) {
+    DeleteUploadParameters(scoped_report->uuid);
+    DeleteAttachments(scoped_report->uuid);
     return kDatabaseError;
-  metadata->AddNewRecord(ReportDisk(scoped_report->uuid,
-                                    scoped_report->path,
-                                    time(nullptr),
-                                    ReportState::kPending));
+  }
+  ReportDisk new_report_disk(scoped_report->uuid,
+                             scoped_report->path,
+                             time(nullptr),
+                             ReportState::kPending);
+  new_report_disk.dump_without_crash = scoped_report->dump_without_crash;
+  new_report_disk.size_in_kb =
+      ReportSizeInKB(LoggingFileSizeByHandle(handle.get()));
+  metadata->AddNewRecord(new_report_disk);
+  // The record is written when the metadata is released.
+  metadata.reset();
+  CommitReportRecords();
   *uuid = scoped_report->uuid;
 
   Metrics::CrashReportPending(Metrics::PendingReportReason::kNewlyCreated);
@@ -827,6 +1389,8 @@ OperationStatus CrashReportDatabaseWin::DeleteReport(const UUID& uuid) {
   if (os != kNoError)
     return os;
 
+  DeleteUploadParameters(uuid);
+  DeleteAttachments(uuid);
   if (!DeleteFile(report_path.value().c_str())) {
     PLOG(ERROR) << "DeleteFile "
                 << base::UTF16ToUTF8(report_path.value());
@@ -855,9 +1419,46 @@ OperationStatus CrashReportDatabaseWin::SkipReportUpload(
   return os;
 }
 
+void CrashReportDatabaseWin::FlushReportRecords() {
+  // Reports are recorded in the metadata file, which is opened for writing
+  // because FlushFileBuffers() requires it. Flushing it also writes NTFS’s
+  // journal, making the entries of new reports’ files durable.
+  ScopedFileHandle metadata_file(
+      LoggingOpenFileForWrite(base_dir_.Append(kMetadataFileName),
+                              FileWriteMode::kReuseOrFail,
+                              FilePermissions::kOwnerOnly));
+  if (metadata_file.is_valid()) {
+    LoggingFlushFile(metadata_file.get());
+  }
+}
+
+bool CrashReportDatabaseWin::MigrateReportLayout() {
+  std::unique_ptr<Metadata> metadata(AcquireMetadata());
+  if (!metadata)
+    return false;
+  if (!metadata->WantsShardedLayout(kShardedLayoutMinReports))
+    return true;
+
+  // Every shard is created, even if another instance has already migrated the
+  // database, in case reports are written to shards that don’t yet hold any.
+  const base::FilePath report_dir = base_dir_.Append(kReportsDirectory);
+  for (unsigned int shard = 0; shard <= 0xff; ++shard) {
+    if (!CreateDirectoryIfNecessary(
+            report_dir.Append(
+                base::UTF8ToUTF16(base::StringPrintf("%02x", shard))))) {
+      return false;
+    }
+  }
+  sharded_ = true;
+
+  metadata->MoveReportsToShards();
+  return true;
+}
+
 std::unique_ptr<Metadata> CrashReportDatabaseWin::AcquireMetadata() {
   base::FilePath metadata_file = base_dir_.Append(kMetadataFileName);
-  return Metadata::Create(metadata_file, base_dir_.Append(kReportsDirectory));
+  return Metadata::Create(
+      metadata_file, base_dir_.Append(kReportsDirectory), &metadata_cache_);
 }
 
 std::unique_ptr<CrashReportDatabase> InitializeInternal(
@@ -903,6 +1504,87 @@ OperationStatus CrashReportDatabaseWin::RequestUpload(const UUID& uuid) {
   return kNoError;
 }
 
+bool CrashReportDatabaseWin::WatchPendingReports(
+    DirectoryChangeWatcher* watcher) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // New reports are written to the reports directory, or in the sharded
+  // layout, to its shards, where changes are reported too. Their metadata
+  // entries are added before their files are closed. Notifications may also
+  // arrive while a report is still being written, before it is pending, in
+  // which case it is found when the watcher’s owner next polls.
+  return watcher->Initialize(base_dir_.Append(kReportsDirectory));
+}
+
+OperationStatus CrashReportDatabaseWin::ListReports(
+    const ReportFilter& filter,
+    ListReportsDelegate* delegate) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // The metadata file stays locked while reports are listed, so they are a
+  // consistent view of the database.
+  std::unique_ptr<Metadata> metadata(AcquireMetadata());
+  if (!metadata)
+    return kDatabaseError;
+  metadata->ListReports(filter, delegate);
+  return kNoError;
+}
+
+OperationStatus CrashReportDatabaseWin::DeleteReports(
+    const ReportFilter& filter,
+    size_t* deleted_count) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // The reports are removed from the metadata in a single update, written
+  // when the metadata is released. Their files are deleted afterwards, as
+  // DeleteReport() does after removing a single report.
+  std::vector<base::FilePath> report_paths;
+  {
+    std::unique_ptr<Metadata> metadata(AcquireMetadata());
+    if (!metadata)
+      return kDatabaseError;
+    metadata->DeleteReports(filter, &report_paths);
+  }
+
+  OperationStatus os = kNoError;
+  for (const base::FilePath& report_path : report_paths) {
+    // Report files are named for their UUIDs.
+    UUID uuid;
+    if (uuid.InitializeFromString(base::UTF16ToUTF8(
+            report_path.BaseName().RemoveFinalExtension().value()))) {
+      DeleteUploadParameters(uuid);
+      DeleteAttachments(uuid);
+    }
+    if (!DeleteFile(report_path.value().c_str())) {
+      PLOG(ERROR) << "DeleteFile " << base::UTF16ToUTF8(report_path.value());
+      os = kFileSystemError;
+    }
+  }
+
+  if (deleted_count)
+    *deleted_count = report_paths.size();
+  return os;
+}
+
+OperationStatus CrashReportDatabaseWin::RequestUploads(
+    const ReportFilter& filter,
+    size_t* requested_count) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::unique_ptr<Metadata> metadata(AcquireMetadata());
+  if (!metadata)
+    return kDatabaseError;
+
+  size_t count = metadata->RequestUploads(filter);
+  for (size_t index = 0; index < count; ++index) {
+    Metrics::CrashReportPending(Metrics::PendingReportReason::kUserInitiated);
+  }
+
+  if (requested_count)
+    *requested_count = count;
+  return kNoError;
+}
+
 }  // namespace
 
 // static
@@ -0,0 +1,158 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/crash_signature_history.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/logging.h"
+#include "client/settings.h"
+#include "util/file/file_io.h"
+
+namespace crashpad {
+
+namespace {
+
+struct Header {
+  static const uint32_t kHistoryMagic = 'CPcs';
+  static const uint32_t kHistoryVersion = 1;
+
+  Header()
+      : magic(kHistoryMagic),
+        version(kHistoryVersion),
+        entry_count(0),
+        padding_0(0) {}
+
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entry_count;
+  uint32_t padding_0;
+};
+
+using ScopedLockedFileHandle =
+    base::ScopedGeneric<FileHandle, internal::ScopedLockedFileHandleTraits>;
+
+}  // namespace
+
+struct CrashSignatureHistory::Entry {
+  uint64_t signature;
+  int64_t window_start;  // time_t
+  int64_t last_seen;  // time_t
+  uint32_t reports;
+  uint32_t suppressed;
+};
+
+CrashSignatureHistory::CrashSignatureHistory(const base::FilePath& file_path,
+                                             uint32_t max_reports,
+                                             time_t window_seconds)
+    : file_path_(file_path),
+      window_seconds_(window_seconds),
+      max_reports_(max_reports) {}
+
+CrashSignatureHistory::~CrashSignatureHistory() {}
+
+bool CrashSignatureHistory::RecordCrash(uint64_t signature,
+                                        time_t now,
+                                        uint32_t* suppressed_count) {
+  *suppressed_count = 0;
+
+  ScopedFileHandle scoped(LoggingOpenFileForReadAndWrite(
+      file_path_, FileWriteMode::kReuseOrCreate, FilePermissions::kOwnerOnly));
+  if (scoped.is_valid() &&
+      !LoggingLockFile(scoped.get(), FileLocking::kExclusive)) {
+    scoped.reset();
+  }
+  ScopedLockedFileHandle handle(scoped.release());
+  if (!handle.is_valid()) {
+    return true;
+  }
+
+  // A history that can’t be understood is discarded. This also covers a file
+  // that was just created, and is empty.
+  std::vector<Entry> entries;
+  const FileOffset file_size = LoggingFileSizeByHandle(handle.get());
+  Header header;
+  if (file_size > 0 &&
+      LoggingReadFileExactly(handle.get(), &header, sizeof(header))) {
+    if (header.magic != Header::kHistoryMagic ||
+        header.version != Header::kHistoryVersion ||
+        header.entry_count > kMaxSignatures) {
+      LOG(ERROR) << "discarding unrecognized crash signature history";
+    } else {
+      entries.resize(header.entry_count);
+      if (!entries.empty() &&
+          !LoggingReadFileExactly(handle.get(),
+                                  &entries[0],
+                                  entries.size() * sizeof(entries[0]))) {
+        entries.clear();
+      }
+    }
+  }
+
+  auto entry = std::find_if(
+      entries.begin(), entries.end(), [signature](const Entry& entry) {
+        return entry.signature == signature;
+      });
+  if (entry == entries.end()) {
+    // Make room by forgetting the signature that was seen least recently.
+    if (entries.size() >= kMaxSignatures) {
+      entries.erase(std::min_element(
+          entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.last_seen < b.last_seen;
+          }));
+    }
+    Entry new_entry = {};
+    new_entry.signature = signature;
+    new_entry.window_start = now;
+    entries.push_back(new_entry);
+    entry = entries.end() - 1;
+  }
+
+  // Start a new window once the current one has passed. A clock that went
+  // backwards does the same, so that a window can’t be held open indefinitely.
+  if (now < entry->window_start ||
+      now - entry->window_start >= window_seconds_) {
+    entry->window_start = now;
+    entry->reports = 0;
+  }
+  entry->last_seen = now;
+
+  bool report;
+  if (entry->reports < max_reports_) {
+    ++entry->reports;
+    *suppressed_count = entry->suppressed;
+    entry->suppressed = 0;
+    report = true;
+  } else {
+    ++entry->suppressed;
+    report = false;
+  }
+
+  header = Header();
+  header.entry_count = static_cast<uint32_t>(entries.size());
+  if (LoggingSeekFile(handle.get(), 0, SEEK_SET) != 0 ||
+      !LoggingTruncateFile(handle.get()) ||
+      !LoggingWriteFile(handle.get(), &header, sizeof(header)) ||
+      !LoggingWriteFile(
+          handle.get(), &entries[0], entries.size() * sizeof(entries[0]))) {
+    // Without a record of it, there’s no way to account for a suppressed
+    // crash later, so report it now.
+    return true;
+  }
+
+  return report;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,78 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_CLIENT_CRASH_SIGNATURE_HISTORY_H_
+#define CRASHPAD_CLIENT_CRASH_SIGNATURE_HISTORY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+
+namespace crashpad {
+
+//! \brief Tracks how often crashes with each signature have been seen, so that
+//!     repeated crashes may be reported once and counted thereafter.
+//!
+//! The history is kept in a file, which is normally placed alongside a
+//! CrashReportDatabase so that it is shared by every handler using that
+//! database. It is bounded to a fixed number of signatures, and when full, the
+//! signature seen least recently is forgotten.
+//!
+//! Signatures are computed by ComputeCrashSignature().
+class CrashSignatureHistory {
+ public:
+  //! \brief The maximum number of signatures remembered.
+  static constexpr size_t kMaxSignatures = 64;
+
+  //! \param[in] file_path The path to the file holding the history. It is
+  //!     created if it does not exist.
+  //! \param[in] max_reports The number of crashes with the same signature to
+  //!     report within each \a window_seconds.
+  //! \param[in] window_seconds The length of the window over which crashes
+  //!     are counted.
+  CrashSignatureHistory(const base::FilePath& file_path,
+                        uint32_t max_reports,
+                        time_t window_seconds);
+  ~CrashSignatureHistory();
+
+  //! \brief Records a crash, and determines whether it should be reported.
+  //!
+  //! \param[in] signature The crash’s signature.
+  //! \param[in] now The current time.
+  //! \param[out] suppressed_count If this method returns `true`, the number of
+  //!     crashes with the same signature that were not reported since the last
+  //!     one that was. This should be reported along with the crash.
+  //!
+  //! \return `true` if the crash should be reported, and `false` if the
+  //!     maximum number of reports of crashes with the same signature have
+  //!     already been made in the current window. If the history can’t be
+  //!     read or written, a message is logged and `true` is returned.
+  bool RecordCrash(uint64_t signature, time_t now, uint32_t* suppressed_count);
+
+ private:
+  struct Entry;
+
+  base::FilePath file_path_;
+  time_t window_seconds_;
+  uint32_t max_reports_;
+
+  DISALLOW_COPY_AND_ASSIGN(CrashSignatureHistory);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_CLIENT_CRASH_SIGNATURE_HISTORY_H_
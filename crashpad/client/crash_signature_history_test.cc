@@ -0,0 +1,138 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/crash_signature_history.h"
+
+#include "gtest/gtest.h"
+#include "test/scoped_temp_dir.h"
+#include "util/file/file_io.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr uint32_t kMaxReports = 2;
+constexpr time_t kWindowSeconds = 60 * 60;
+constexpr time_t kStartTime = 1500000000;
+
+class CrashSignatureHistoryTest : public testing::Test {
+ public:
+  CrashSignatureHistoryTest()
+      : temp_dir_(), history_(history_path(), kMaxReports, kWindowSeconds) {}
+
+  base::FilePath history_path() {
+    return temp_dir_.path().Append(FILE_PATH_LITERAL("crash_signatures"));
+  }
+
+  CrashSignatureHistory* history() { return &history_; }
+
+ private:
+  ScopedTempDir temp_dir_;
+  CrashSignatureHistory history_;
+
+  DISALLOW_COPY_AND_ASSIGN(CrashSignatureHistoryTest);
+};
+
+TEST_F(CrashSignatureHistoryTest, SuppressesDuplicates) {
+  uint32_t suppressed;
+  for (uint32_t report = 0; report < kMaxReports; ++report) {
+    EXPECT_TRUE(history()->RecordCrash(1, kStartTime + report, &suppressed));
+    EXPECT_EQ(suppressed, 0u);
+  }
+  EXPECT_FALSE(history()->RecordCrash(1, kStartTime + 10, &suppressed));
+  EXPECT_FALSE(history()->RecordCrash(1, kStartTime + 11, &suppressed));
+
+  // Other signatures are counted separately.
+  EXPECT_TRUE(history()->RecordCrash(2, kStartTime + 12, &suppressed));
+  EXPECT_EQ(suppressed, 0u);
+
+  // Once the window passes, the next crash is reported along with the number
+  // of crashes that weren’t.
+  EXPECT_TRUE(
+      history()->RecordCrash(1, kStartTime + kWindowSeconds, &suppressed));
+  EXPECT_EQ(suppressed, 2u);
+  EXPECT_TRUE(
+      history()->RecordCrash(1, kStartTime + kWindowSeconds, &suppressed));
+  EXPECT_EQ(suppressed, 0u);
+  EXPECT_FALSE(
+      history()->RecordCrash(1, kStartTime + kWindowSeconds, &suppressed));
+}
+
+TEST_F(CrashSignatureHistoryTest, Persists) {
+  uint32_t suppressed;
+  for (uint32_t report = 0; report < kMaxReports; ++report) {
+    EXPECT_TRUE(history()->RecordCrash(1, kStartTime, &suppressed));
+  }
+
+  CrashSignatureHistory local_history(
+      history_path(), kMaxReports, kWindowSeconds);
+  EXPECT_FALSE(local_history.RecordCrash(1, kStartTime, &suppressed));
+  EXPECT_FALSE(history()->RecordCrash(1, kStartTime, &suppressed));
+  EXPECT_TRUE(
+      local_history.RecordCrash(1, kStartTime + kWindowSeconds, &suppressed));
+  EXPECT_EQ(suppressed, 2u);
+}
+
+TEST_F(CrashSignatureHistoryTest, ClockGoesBackwards) {
+  uint32_t suppressed;
+  for (uint32_t report = 0; report < kMaxReports; ++report) {
+    EXPECT_TRUE(history()->RecordCrash(1, kStartTime, &suppressed));
+  }
+  EXPECT_FALSE(history()->RecordCrash(1, kStartTime, &suppressed));
+  EXPECT_TRUE(history()->RecordCrash(1, kStartTime - 1, &suppressed));
+  EXPECT_EQ(suppressed, 1u);
+}
+
+TEST_F(CrashSignatureHistoryTest, ForgetsLeastRecentlySeen) {
+  uint32_t suppressed;
+  for (uint32_t report = 0; report < kMaxReports; ++report) {
+    EXPECT_TRUE(history()->RecordCrash(0, kStartTime, &suppressed));
+    EXPECT_TRUE(history()->RecordCrash(1, kStartTime, &suppressed));
+  }
+
+  // Seeing signature 0 again keeps it from being forgotten.
+  EXPECT_FALSE(history()->RecordCrash(0, kStartTime + 1, &suppressed));
+  for (uint64_t signature = 2;
+       signature <= CrashSignatureHistory::kMaxSignatures;
+       ++signature) {
+    EXPECT_TRUE(history()->RecordCrash(signature, kStartTime + 2, &suppressed));
+  }
+
+  EXPECT_FALSE(history()->RecordCrash(0, kStartTime + 3, &suppressed));
+  EXPECT_TRUE(history()->RecordCrash(1, kStartTime + 3, &suppressed));
+  EXPECT_EQ(suppressed, 0u);
+}
+
+TEST_F(CrashSignatureHistoryTest, BadFile) {
+  {
+    ScopedFileHandle handle(
+        LoggingOpenFileForWrite(history_path(),
+                                FileWriteMode::kTruncateOrCreate,
+                                FilePermissions::kOwnerOnly));
+    ASSERT_TRUE(handle.is_valid());
+    static constexpr char kBuf[] = "test bad file";
+    ASSERT_TRUE(LoggingWriteFile(handle.get(), kBuf, sizeof(kBuf)));
+  }
+
+  uint32_t suppressed;
+  for (uint32_t report = 0; report < kMaxReports; ++report) {
+    EXPECT_TRUE(history()->RecordCrash(1, kStartTime, &suppressed));
+    EXPECT_EQ(suppressed, 0u);
+  }
+  EXPECT_FALSE(history()->RecordCrash(1, kStartTime, &suppressed));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -106,6 +106,41 @@ class CrashpadClient {
                     bool asynchronous_start);
 
 #if defined(OS_MACOSX) || DOXYGEN
+  //! \brief Registers a Crashpad handler with launchd as an on-demand Mach
+  //!     service in the current user session, if it isn’t already registered.
+  //!
+  //! This method is only defined on macOS.
+  //!
+  //! The handler is registered as a launchd job labeled \a service_name, which
+  //! reserves \a service_name with the bootstrap server. The handler isn’t
+  //! started by this method. Instead, launchd starts it, with a
+  //! `--mach-service` argument, when the first message arrives for the
+  //! service, and keeps it running until the job is removed or the session
+  //! ends. Clients, including this one, direct their crashes to the handler
+  //! with SetHandlerMachService(), which only needs to look the service up.
+  //! Unlike StartHandler(), no process is created and no handshake is
+  //! performed as each client starts.
+  //!
+  //! The job is registered once per session. A client that finds it already
+  //! registered uses the handler as it was configured by the client that
+  //! registered it, so all clients sharing a service should pass the same
+  //! values. The remaining parameters have the same meaning as they do for
+  //! StartHandler().
+  //!
+  //! \param[in] service_name The name of the Mach service, which also labels
+  //!     the launchd job.
+  //!
+  //! \return `true` if the handler is registered, `false` on failure with a
+  //!     message logged.
+  static bool RegisterHandlerMachService(
+      const std::string& service_name,
+      const base::FilePath& handler,
+      const base::FilePath& database,
+      const base::FilePath& metrics_dir,
+      const std::string& url,
+      const std::map<std::string, std::string>& annotations,
+      const std::vector<std::string>& arguments);
+
   //! \brief Sets the process’ crash handler to a Mach service registered with
   //!     the bootstrap server.
   //!
@@ -115,7 +150,8 @@ class CrashpadClient {
   //! configured.
   //!
   //! \param[in] service_name The service name of a Crashpad exception handler
-  //!     service previously registered with the bootstrap server.
+  //!     service previously registered with the bootstrap server, as by
+  //!     RegisterHandlerMachService().
   //!
   //! \return `true` on success, `false` on failure with a message logged.
   bool SetHandlerMachService(const std::string& service_name);
@@ -156,6 +192,39 @@ class CrashpadClient {
 #endif
 
 #if defined(OS_WIN) || DOXYGEN
+  //! \brief Registers with a Crashpad handler shared by all clients in the
+  //!     current session that use \a database, starting the handler first if
+  //!     it isn’t already running.
+  //!
+  //! This method is only defined on Windows.
+  //!
+  //! The handler listens on a pipe whose name is derived from the session and
+  //! \a database, and it keeps running after the client that started it
+  //! exits. Later clients, including later runs of the same application, find
+  //! the running handler and register with it as SetHandlerIPCPipe() does,
+  //! without paying to start a handler and open its database. Clients
+  //! starting at the same time are serialized so that only one handler is
+  //! started.
+  //!
+  //! The remaining parameters have the same meaning as they do for
+  //! StartHandler(), but they only take effect when this call starts the
+  //! handler. A client that finds the handler already running uses it as it
+  //! was configured by the client that started it, so all clients sharing a
+  //! handler should pass the same values.
+  //!
+  //! Unlike StartHandler(), this method waits for the handler to start and
+  //! must not be called from `DllMain()`. Because the handler does not
+  //! inherit any handles from this process, its standard output and error are
+  //! not connected to this process’ console.
+  //!
+  //! \return `true` on success and `false` on failure with a message logged.
+  bool StartSharedHandler(const base::FilePath& handler,
+                          const base::FilePath& database,
+                          const base::FilePath& metrics_dir,
+                          const std::string& url,
+                          const std::map<std::string, std::string>& annotations,
+                          const std::vector<std::string>& arguments);
+
   //! \brief Sets the IPC pipe of a presumably-running Crashpad handler process
   //!     which was started with StartHandler() or by other compatible means
   //!     and does an IPC message exchange to register this process with the
@@ -179,11 +248,11 @@ class CrashpadClient {
   //! This method is only defined on Windows.
   //!
   //! This method retrieves the IPC pipe name set by SetHandlerIPCPipe(), or a
-  //! suitable IPC pipe name chosen by StartHandler(). It must only be called
-  //! after a successful call to one of those methods. It is intended to be used
-  //! to obtain the IPC pipe name so that it may be passed to other processes,
-  //! so that they may register with an existing Crashpad handler by calling
-  //! SetHandlerIPCPipe().
+  //! suitable IPC pipe name chosen by StartHandler() or StartSharedHandler().
+  //! It must only be called after a successful call to one of those methods.
+  //! It is intended to be used to obtain the IPC pipe name so that it may be
+  //! passed to other processes, so that they may register with an existing
+  //! Crashpad handler by calling SetHandlerIPCPipe().
   //!
   //! \return The full name of the crash handler IPC pipe, a string of the form
   //!     `&quot;\\.\pipe\NAME&quot;`.
@@ -209,6 +278,38 @@ class CrashpadClient {
   //!     similar.
   static void DumpWithoutCrash(const CONTEXT& context);
 
+  //! \brief Requests that the handler capture a dump even though there hasn’t
+  //!     been a crash, without waiting for it to be taken.
+  //!
+  //! Unlike DumpWithoutCrash(), this method neither captures a context nor
+  //! blocks the calling thread while the dump is taken. Instead, the handler
+  //! takes the context of \a thread_id as it finds it when it suspends the
+  //! process, and resumes the process once it has copied what it needs, as it
+  //! does for DumpWithoutCrash(). The dump therefore shows \a thread_id
+  //! wherever it is when the handler reaches it, with a consistent stack,
+  //! rather than where this method was called. This suits reporting a thread
+  //! that has stopped responding, such as from a watchdog thread, without
+  //! stalling the caller.
+  //!
+  //! Requests are handed to the handler on a thread pool thread, one at a time
+  //! along with those made by DumpWithoutCrash(). A small number of requests
+  //! may be outstanding at once. Requests made while that many are outstanding
+  //! are dropped, and counted by GetDroppedAsyncDumpCount().
+  //!
+  //! A handler that predates this method logs an error and captures nothing
+  //! for these requests.
+  //!
+  //! \param[in] thread_id The thread that the dump is reported at. Pass
+  //!     `GetCurrentThreadId()` to report the calling thread.
+  //!
+  //! \return `true` if the request was queued. `false` if it was dropped or
+  //!     could not be made, with a message logged unless it was dropped.
+  static bool DumpWithoutCrashAsync(DWORD thread_id);
+
+  //! \brief Returns the number of requests made by DumpWithoutCrashAsync()
+  //!     that were dropped because too many were already outstanding.
+  static uint32_t GetDroppedAsyncDumpCount();
+
   //! \brief Requests that the handler capture a dump using the given \a
   //!     exception_pointers to get the `EXCEPTION_RECORD` and `CONTEXT`.
   //!
@@ -243,6 +344,36 @@ class CrashpadClient {
                                  HANDLE blame_thread,
                                  DWORD exception_code) const;
 
+  //! \brief Requests that the handler capture a dump of a different process
+  //!     without running any code in it, and then terminate it.
+  //!
+  //! This is like DumpAndCrashTargetProcess() with a \a blame_thread, but
+  //! instead of injecting a thread into the target process, the handler
+  //! suspends the process, captures the context of \a blame_thread directly,
+  //! and terminates the process with \a exception_code once everything needed
+  //! from it has been gathered. This works even when the target is hung in a
+  //! way that would keep an injected thread from running promptly, such as
+  //! while holding the loader lock, or when it is starved of CPU time.
+  //!
+  //! This client must be connected to the handler that the target process is
+  //! registered with, by StartHandler() or SetHandlerIPCPipe(), and must
+  //! itself be able to terminate the target.
+  //!
+  //! \param[in] process A `HANDLE` identifying the process to be dumped. It
+  //!     must have the `SYNCHRONIZE` access right.
+  //! \param[in] blame_thread A `HANDLE` valid in the caller's process,
+  //!     referring to a thread in the target process, that the exception is
+  //!     reported at.
+  //! \param[in] exception_code The exception code reported, and the exit code
+  //!     that the target process is terminated with.
+  //!
+  //! \return `true` if the target process was terminated by the handler
+  //!     within a minute of the request being made. `false` otherwise, with a
+  //!     message logged.
+  bool DumpAndCrashTargetProcessInHandler(HANDLE process,
+                                          HANDLE blame_thread,
+                                          DWORD exception_code) const;
+
   enum : uint32_t {
     //! \brief The exception code (roughly "Client called") used when
     //!     DumpAndCrashTargetProcess() triggers an exception in a target
@@ -252,6 +383,13 @@ class CrashpadClient {
     //!     confusion with real exception codes which tend to have those bits
     //!     set.
     kTriggeredExceptionCode = 0xcca11ed,
+
+    //! \brief The exception code (roughly "simulated") reported for dumps
+    //!     requested by DumpWithoutCrash() and DumpWithoutCrashAsync().
+    //!
+    //! \note Like #kTriggeredExceptionCode, this value has no bits of the top
+    //!     nibble set.
+    kSimulatedExceptionCode = 0x517a7ed,
   };
 #endif
 
@@ -29,6 +29,7 @@
 #include "base/posix/eintr_wrapper.h"
 #include "base/strings/stringprintf.h"
 #include "util/mac/mac_util.h"
+#include "util/mac/service_management.h"
 #include "util/mach/child_port_handshake.h"
 #include "util/mach/exception_ports.h"
 #include "util/mach/mach_extensions.h"
@@ -51,6 +52,40 @@ std::string FormatArgumentInt(const std::string& name, int value) {
   return base::StringPrintf("--%s=%d", name.c_str(), value);
 }
 
+// Returns the command line to run the handler with, as directed by the
+// parameters to CrashpadClient::StartHandler(). handler is argv[0]. |arguments|
+// are added next so that if it erroneously contains an argument such as --url,
+// the actual |url| argument passed will supersede it. In normal command-line
+// processing, the last parameter wins in the case of a conflict. The caller
+// appends the argument that tells the handler how to obtain its receive right.
+std::vector<std::string> HandlerArguments(
+    const base::FilePath& handler,
+    const base::FilePath& database,
+    const base::FilePath& metrics_dir,
+    const std::string& url,
+    const std::map<std::string, std::string>& annotations,
+    const std::vector<std::string>& arguments) {
+  std::vector<std::string> argv(1, handler.value());
+  argv.reserve(1 + arguments.size() + 2 + annotations.size() + 1);
+  for (const std::string& argument : arguments) {
+    argv.push_back(argument);
+  }
+  if (!database.value().empty()) {
+    argv.push_back(FormatArgumentString("database", database.value()));
+  }
+  if (!metrics_dir.value().empty()) {
+    argv.push_back(FormatArgumentString("metrics-dir", metrics_dir.value()));
+  }
+  if (!url.empty()) {
+    argv.push_back(FormatArgumentString("url", url));
+  }
+  for (const auto& kv : annotations) {
+    argv.push_back(
+        FormatArgumentString("annotation", kv.first + '=' + kv.second));
+  }
+  return argv;
+}
+
 // Set the exception handler for EXC_CRASH, EXC_RESOURCE, and EXC_GUARD.
 //
 // EXC_CRASH is how most crashes are received. Most other exception types such
@@ -312,29 +347,9 @@ class HandlerStarter final : public NotifyServer::DefaultInterface {
     base::ScopedFD server_write_fd = child_port_handshake.ServerWriteFD();
 
     // Use handler as argv[0], followed by arguments directed by this method’s
-    // parameters and a --handshake-fd argument. |arguments| are added first so
-    // that if it erroneously contains an argument such as --url, the actual
-    // |url| argument passed to this method will supersede it. In normal
-    // command-line processing, the last parameter wins in the case of a
-    // conflict.
-    std::vector<std::string> argv(1, handler.value());
-    argv.reserve(1 + arguments.size() + 2 + annotations.size() + 1);
-    for (const std::string& argument : arguments) {
-      argv.push_back(argument);
-    }
-    if (!database.value().empty()) {
-      argv.push_back(FormatArgumentString("database", database.value()));
-    }
-    if (!metrics_dir.value().empty()) {
-      argv.push_back(FormatArgumentString("metrics-dir", metrics_dir.value()));
-    }
-    if (!url.empty()) {
-      argv.push_back(FormatArgumentString("url", url));
-    }
-    for (const auto& kv : annotations) {
-      argv.push_back(
-          FormatArgumentString("annotation", kv.first + '=' + kv.second));
-    }
+    // parameters and a --handshake-fd argument.
+    std::vector<std::string> argv = HandlerArguments(
+        handler, database, metrics_dir, url, annotations, arguments);
     argv.push_back(FormatArgumentInt("handshake-fd", server_write_fd.get()));
 
     const char* handler_c = handler.value().c_str();
@@ -557,6 +572,37 @@ bool CrashpadClient::StartHandler(
   return true;
 }
 
+// static
+bool CrashpadClient::RegisterHandlerMachService(
+    const std::string& service_name,
+    const base::FilePath& handler,
+    const base::FilePath& database,
+    const base::FilePath& metrics_dir,
+    const std::string& url,
+    const std::map<std::string, std::string>& annotations,
+    const std::vector<std::string>& arguments) {
+  // The job is labeled with the service name, so a job already loaded under
+  // that label, by an earlier client in this session, is the handler.
+  if (ServiceManagementIsJobLoaded(service_name)) {
+    return true;
+  }
+
+  std::vector<std::string> argv = HandlerArguments(
+      handler, database, metrics_dir, url, annotations, arguments);
+  argv.push_back(FormatArgumentString("mach-service", service_name));
+
+  // Another client may have submitted the job since it was checked for above,
+  // in which case submitting it again fails, but the handler is registered.
+  if (!ServiceManagementSubmitOnDemandJob(
+          service_name, argv, std::vector<std::string>(1, service_name)) &&
+      !ServiceManagementIsJobLoaded(service_name)) {
+    LOG(ERROR) << "ServiceManagementSubmitOnDemandJob " << service_name;
+    return false;
+  }
+
+  return true;
+}
+
 bool CrashpadClient::SetHandlerMachService(const std::string& service_name) {
   base::mac::ScopedMachSendRight exception_port(BootstrapLookUp(service_name));
   if (!exception_port.is_valid()) {
@@ -72,6 +72,15 @@ base::Lock* g_non_crash_dump_lock;
 // dump.
 ExceptionInformation g_non_crash_exception_information;
 
+// The number of DumpWithoutCrashAsync() requests that may be waiting for, or
+// being serviced by, the handler at once.
+constexpr base::subtle::Atomic32 kMaxPendingAsyncDumps = 4;
+
+// The number of DumpWithoutCrashAsync() requests outstanding, and the number
+// dropped because kMaxPendingAsyncDumps were already outstanding.
+base::subtle::Atomic32 g_pending_async_dumps;
+base::subtle::Atomic32 g_dropped_async_dumps;
+
 enum class StartupState : int {
   kNotReady = 0,   // This must be value 0 because it is the initial value of a
                    // global AtomicWord.
@@ -347,36 +356,53 @@ class ScopedCallSetHandlerStartupState {
   DISALLOW_COPY_AND_ASSIGN(ScopedCallSetHandlerStartupState);
 };
 
-bool StartHandlerProcess(
-    std::unique_ptr<BackgroundHandlerStartThreadData> data) {
-  ScopedCallSetHandlerStartupState scoped_startup_state_caller;
-
+// Builds the part of the handler’s command line common to StartHandler() and
+// StartSharedHandler(): the executable followed by the caller’s arguments and
+// the arguments derived from the other parameters.
+std::wstring HandlerCommandLine(
+    const base::FilePath& handler,
+    const base::FilePath& database,
+    const base::FilePath& metrics_dir,
+    const std::string& url,
+    const std::map<std::string, std::string>& annotations,
+    const std::vector<std::string>& arguments) {
   std::wstring command_line;
-  AppendCommandLineArgument(data->handler.value(), &command_line);
-  for (const std::string& argument : data->arguments) {
+  AppendCommandLineArgument(handler.value(), &command_line);
+  for (const std::string& argument : arguments) {
     AppendCommandLineArgument(base::UTF8ToUTF16(argument), &command_line);
   }
-  if (!data->database.value().empty()) {
+  if (!database.value().empty()) {
     AppendCommandLineArgument(
-        FormatArgumentString("database", data->database.value()),
-        &command_line);
+        FormatArgumentString("database", database.value()), &command_line);
   }
-  if (!data->metrics_dir.value().empty()) {
+  if (!metrics_dir.value().empty()) {
     AppendCommandLineArgument(
-        FormatArgumentString("metrics-dir", data->metrics_dir.value()),
+        FormatArgumentString("metrics-dir", metrics_dir.value()),
         &command_line);
   }
-  if (!data->url.empty()) {
+  if (!url.empty()) {
     AppendCommandLineArgument(
-        FormatArgumentString("url", base::UTF8ToUTF16(data->url)),
-        &command_line);
+        FormatArgumentString("url", base::UTF8ToUTF16(url)), &command_line);
   }
-  for (const auto& kv : data->annotations) {
+  for (const auto& kv : annotations) {
     AppendCommandLineArgument(
         FormatArgumentString("annotation",
                              base::UTF8ToUTF16(kv.first + '=' + kv.second)),
         &command_line);
   }
+  return command_line;
+}
+
+bool StartHandlerProcess(
+    std::unique_ptr<BackgroundHandlerStartThreadData> data) {
+  ScopedCallSetHandlerStartupState scoped_startup_state_caller;
+
+  std::wstring command_line = HandlerCommandLine(data->handler,
+                                                 data->database,
+                                                 data->metrics_dir,
+                                                 data->url,
+                                                 data->annotations,
+                                                 data->arguments);
 
   ScopedKernelHANDLE this_process(
       OpenProcess(kXPProcessAllAccess, true, GetCurrentProcessId()));
@@ -523,6 +549,144 @@ DWORD WINAPI BackgroundHandlerStartThreadProc(void* data) {
   return StartHandlerProcess(std::move(data_as_ptr)) ? 0 : 1;
 }
 
+// The longest that StartSharedHandler() will wait for a handler that it
+// started to begin listening on the shared pipe.
+constexpr DWORD kSharedHandlerStartTimeoutMs = 10000;
+
+// The time that DumpAndCrashTargetProcess() and
+// DumpAndCrashTargetProcessInHandler() wait for the target to be dumped.
+constexpr DWORD kDumpAndCrashTimeoutMs = 60 * 1000;
+
+// Returns a name identifying the shared handler for |database| in the current
+// session. Paths on Windows are case-insensitive, so the database path is
+// lowercased before it is hashed, ensuring that clients which spell the same
+// path differently find the same handler.
+std::wstring SharedHandlerName(const base::FilePath& database) {
+  std::wstring path = database.value();
+  if (!path.empty()) {
+    CharLowerBuff(&path[0], static_cast<DWORD>(path.size()));
+  }
+
+  // FNV-1a.
+  uint32_t hash = 2166136261u;
+  for (wchar_t c : path) {
+    hash = (hash ^ static_cast<uint16_t>(c)) * 16777619u;
+  }
+
+  DWORD session_id;
+  if (!ProcessIdToSessionId(GetCurrentProcessId(), &session_id)) {
+    PLOG(WARNING) << "ProcessIdToSessionId";
+    session_id = 0;
+  }
+
+  return base::UTF8ToUTF16(
+      base::StringPrintf("crashpad_shared_%u_%08x", session_id, hash));
+}
+
+// Returns true if a server has created an instance of |pipe_name|, even if all
+// of its instances are currently busy.
+bool SharedHandlerPipeExists(const std::wstring& pipe_name) {
+  return WaitNamedPipe(pipe_name.c_str(), 1) ||
+         GetLastError() != ERROR_FILE_NOT_FOUND;
+}
+
+// Starts a handler that will listen on |pipe_name| and waits for it to begin
+// doing so. The handler is detached from this process: it inherits no handles,
+// and it continues running after this process exits.
+bool StartSharedHandlerProcess(const std::wstring& pipe_name,
+                               std::wstring command_line,
+                               const base::FilePath& handler) {
+  AppendCommandLineArgument(FormatArgumentString("pipe-name", pipe_name),
+                            &command_line);
+
+  STARTUPINFO startup_info = {};
+  startup_info.cb = sizeof(startup_info);
+  PROCESS_INFORMATION process_info;
+  if (!CreateProcess(handler.value().c_str(),
+                     &command_line[0],
+                     nullptr,
+                     nullptr,
+                     false,
+                     DETACHED_PROCESS,
+                     nullptr,
+                     nullptr,
+                     &startup_info,
+                     &process_info)) {
+    PLOG(ERROR) << "CreateProcess";
+    return false;
+  }
+
+  BOOL rv = CloseHandle(process_info.hThread);
+  PLOG_IF(WARNING, !rv) << "CloseHandle thread";
+  ScopedKernelHANDLE process(process_info.hProcess);
+
+  // The handler creates its pipe once its database is open. Poll for the pipe,
+  // watching for the handler to exit early, which it does if it can’t start or
+  // if another handler already owns the pipe.
+  constexpr DWORD kPollIntervalMs = 10;
+  for (DWORD waited_ms = 0; waited_ms < kSharedHandlerStartTimeoutMs;
+       waited_ms += kPollIntervalMs) {
+    if (SharedHandlerPipeExists(pipe_name)) {
+      return true;
+    }
+    if (WaitForSingleObject(process.get(), kPollIntervalMs) == WAIT_OBJECT_0) {
+      if (SharedHandlerPipeExists(pipe_name)) {
+        return true;
+      }
+      DWORD exit_code;
+      if (!GetExitCodeProcess(process.get(), &exit_code)) {
+        exit_code = 0;
+      }
+      LOG(ERROR) << "handler exited with code " << exit_code
+                 << " before listening on " << base::UTF16ToUTF8(pipe_name);
+      return false;
+    }
+  }
+
+  LOG(ERROR) << "timed out waiting for handler to listen on "
+             << base::UTF16ToUTF8(pipe_name);
+  return false;
+}
+
+// Has the handler take a dump of this process, reporting an exception at
+// |thread_id| described by the EXCEPTION_POINTERS at |exception_pointers|, or,
+// if that is 0, at |thread_id|’s context when the handler suspends the process.
+// Returns once the dump has been taken.
+void RequestNonCrashDump(DWORD thread_id, WinVMAddress exception_pointers) {
+  if (BlockUntilHandlerStartedOrFailed() == StartupState::kFailed) {
+    // If we know for certain that the handler has failed to start, then abort
+    // here, as we would otherwise wait indefinitely for the
+    // g_non_crash_dump_done event that would never be signalled.
+    LOG(ERROR) << "crash server failed to launch, no dump captured";
+    return;
+  }
+
+  // In the non-crashing case, we aren't concerned about avoiding calls into
+  // Win32 APIs, so just use regular locking here in case of multiple threads
+  // calling this function. If a crash occurs while we're in here, the worst
+  // that can happen is that the server captures a partial dump for this path
+  // because another thread’s crash processing finished and the process was
+  // terminated before this thread’s non-crash processing could be completed.
+  base::AutoLock lock(*g_non_crash_dump_lock);
+
+  g_non_crash_exception_information.thread_id = thread_id;
+  g_non_crash_exception_information.exception_pointers = exception_pointers;
+
+  bool set_event_result = !!SetEvent(g_signal_non_crash_dump);
+  PLOG_IF(ERROR, !set_event_result) << "SetEvent";
+
+  DWORD wfso_result = WaitForSingleObject(g_non_crash_dump_done, INFINITE);
+  PLOG_IF(ERROR, wfso_result != WAIT_OBJECT_0) << "WaitForSingleObject";
+}
+
+DWORD WINAPI AsyncDumpWorkItem(void* context) {
+  // This function is executed on the thread pool.
+  RequestNonCrashDump(static_cast<DWORD>(reinterpret_cast<uintptr_t>(context)),
+                      0);
+  base::subtle::Barrier_AtomicIncrement(&g_pending_async_dumps, -1);
+  return 0;
+}
+
 void CommonInProcessInitialization() {
   // We create this dummy CRITICAL_SECTION with the
   // RTL_CRITICAL_SECTION_FLAG_FORCE_DEBUG_INFO flag set to have an entry point
@@ -686,6 +850,57 @@ bool CrashpadClient::SetHandlerIPCPipe(const std::wstring& ipc_pipe) {
   return true;
 }
 
+bool CrashpadClient::StartSharedHandler(
+    const base::FilePath& handler,
+    const base::FilePath& database,
+    const base::FilePath& metrics_dir,
+    const std::string& url,
+    const std::map<std::string, std::string>& annotations,
+    const std::vector<std::string>& arguments) {
+  DCHECK(ipc_pipe_.empty());
+
+  const std::wstring name = SharedHandlerName(database);
+  const std::wstring pipe_name = L"\\\\.\\pipe\\" + name;
+
+  {
+    // Serialize the check-then-start across clients so that clients starting
+    // at the same time don’t each start a handler. A mutex abandoned by a
+    // client that died while holding it is still usable.
+    ScopedKernelHANDLE mutex(
+        CreateMutex(nullptr, false, (L"Local\\" + name).c_str()));
+    if (!mutex.is_valid()) {
+      PLOG(ERROR) << "CreateMutex";
+      return false;
+    }
+    DWORD result =
+        WaitForSingleObject(mutex.get(), kSharedHandlerStartTimeoutMs);
+    if (result != WAIT_OBJECT_0 && result != WAIT_ABANDONED) {
+      PLOG_IF(ERROR, result == WAIT_FAILED) << "WaitForSingleObject";
+      LOG_IF(ERROR, result != WAIT_FAILED) << "WaitForSingleObject timed out";
+      return false;
+    }
+
+    bool started = SharedHandlerPipeExists(pipe_name) ||
+                   StartSharedHandlerProcess(pipe_name,
+                                             HandlerCommandLine(handler,
+                                                                database,
+                                                                metrics_dir,
+                                                                url,
+                                                                annotations,
+                                                                arguments),
+                                             handler);
+
+    BOOL rv = ReleaseMutex(mutex.get());
+    PLOG_IF(WARNING, !rv) << "ReleaseMutex";
+
+    if (!started) {
+      return false;
+    }
+  }
+
+  return SetHandlerIPCPipe(pipe_name);
+}
+
 std::wstring CrashpadClient::GetHandlerIPCPipe() const {
   DCHECK(!ipc_pipe_.empty());
   return ipc_pipe_;
@@ -723,22 +938,6 @@ void CrashpadClient::DumpWithoutCrash(const CONTEXT& context) {
     return;
   }
 
-  if (BlockUntilHandlerStartedOrFailed() == StartupState::kFailed) {
-    // If we know for certain that the handler has failed to start, then abort
-    // here, as we would otherwise wait indefinitely for the
-    // g_non_crash_dump_done event that would never be signalled.
-    LOG(ERROR) << "crash server failed to launch, no dump captured";
-    return;
-  }
-
-  // In the non-crashing case, we aren't concerned about avoiding calls into
-  // Win32 APIs, so just use regular locking here in case of multiple threads
-  // calling this function. If a crash occurs while we're in here, the worst
-  // that can happen is that the server captures a partial dump for this path
-  // because another thread’s crash processing finished and the process was
-  // terminated before this thread’s non-crash processing could be completed.
-  base::AutoLock lock(*g_non_crash_dump_lock);
-
   // Create a fake EXCEPTION_POINTERS to give the handler something to work
   // with.
   EXCEPTION_POINTERS exception_pointers = {};
@@ -747,13 +946,12 @@ void CrashpadClient::DumpWithoutCrash(const CONTEXT& context) {
   // const, so we have to cast that away from the argument.
   exception_pointers.ContextRecord = const_cast<CONTEXT*>(&context);
 
-  // We include a fake exception and use a code of '0x517a7ed' (something like
-  // "simulated") so that it's relatively obvious in windbg that it's not
-  // actually an exception. Most values in
+  // We include a fake exception and use a code of kSimulatedExceptionCode so
+  // that it's relatively obvious in windbg that it's not actually an
+  // exception. Most values in
   // https://msdn.microsoft.com/en-us/library/windows/desktop/aa363082.aspx have
   // some of the top nibble set, so we make sure to pick a value that doesn't,
   // so as to be unlikely to conflict.
-  constexpr uint32_t kSimulatedExceptionCode = 0x517a7ed;
   EXCEPTION_RECORD record = {};
   record.ExceptionCode = kSimulatedExceptionCode;
 #if defined(ARCH_CPU_64_BITS)
@@ -764,15 +962,47 @@ void CrashpadClient::DumpWithoutCrash(const CONTEXT& context) {
 
   exception_pointers.ExceptionRecord = &record;
 
-  g_non_crash_exception_information.thread_id = GetCurrentThreadId();
-  g_non_crash_exception_information.exception_pointers =
-      FromPointerCast<WinVMAddress>(&exception_pointers);
+  RequestNonCrashDump(GetCurrentThreadId(),
+                      FromPointerCast<WinVMAddress>(&exception_pointers));
+}
 
-  bool set_event_result = !!SetEvent(g_signal_non_crash_dump);
-  PLOG_IF(ERROR, !set_event_result) << "SetEvent";
+// static
+bool CrashpadClient::DumpWithoutCrashAsync(DWORD thread_id) {
+  if (g_signal_non_crash_dump == INVALID_HANDLE_VALUE ||
+      g_non_crash_dump_done == INVALID_HANDLE_VALUE) {
+    LOG(ERROR) << "not connected";
+    return false;
+  }
 
-  DWORD wfso_result = WaitForSingleObject(g_non_crash_dump_done, INFINITE);
-  PLOG_IF(ERROR, wfso_result != WAIT_OBJECT_0) << "WaitForSingleObject";
+  // Requests beyond kMaxPendingAsyncDumps are dropped rather than queued, so
+  // that a caller making them faster than the handler can take dumps neither
+  // blocks nor accumulates thread pool work without bound.
+  if (base::subtle::Barrier_AtomicIncrement(&g_pending_async_dumps, 1) >
+      kMaxPendingAsyncDumps) {
+    base::subtle::Barrier_AtomicIncrement(&g_pending_async_dumps, -1);
+    base::subtle::NoBarrier_AtomicIncrement(&g_dropped_async_dumps, 1);
+    return false;
+  }
+
+  // The work item waits for the handler to start if it hasn’t yet, and then
+  // waits for the dump, so it is a long function for the thread pool’s
+  // purposes.
+  if (!QueueUserWorkItem(
+          &AsyncDumpWorkItem,
+          reinterpret_cast<void*>(static_cast<uintptr_t>(thread_id)),
+          WT_EXECUTELONGFUNCTION)) {
+    PLOG(ERROR) << "QueueUserWorkItem";
+    base::subtle::Barrier_AtomicIncrement(&g_pending_async_dumps, -1);
+    return false;
+  }
+
+  return true;
+}
+
+// static
+uint32_t CrashpadClient::GetDroppedAsyncDumpCount() {
+  return static_cast<uint32_t>(
+      base::subtle::NoBarrier_Load(&g_dropped_async_dumps));
 }
 
 // static
@@ -1027,7 +1257,8 @@ bool CrashpadClient::DumpAndCrashTargetProcess(HANDLE process,
   suspend.TolerateTermination();
 
   bool result = true;
-  if (WaitForSingleObject(injected_thread, 60 * 1000) != WAIT_OBJECT_0) {
+  if (WaitForSingleObject(injected_thread, kDumpAndCrashTimeoutMs) !=
+      WAIT_OBJECT_0) {
     PLOG(ERROR) << "WaitForSingleObject";
     result = false;
   }
@@ -1041,4 +1272,51 @@ bool CrashpadClient::DumpAndCrashTargetProcess(HANDLE process,
   return result;
 }
 
+bool CrashpadClient::DumpAndCrashTargetProcessInHandler(
+    HANDLE process,
+    HANDLE blame_thread,
+    DWORD exception_code) const {
+  if (ipc_pipe_.empty()) {
+    LOG(ERROR) << "not connected";
+    return false;
+  }
+
+  static const auto get_thread_id =
+      GET_FUNCTION_REQUIRED(L"kernel32.dll", ::GetThreadId);
+  const DWORD thread_id = get_thread_id(blame_thread);
+  if (!thread_id) {
+    PLOG(ERROR) << "GetThreadId";
+    return false;
+  }
+
+  const DWORD process_id = GetProcessId(process);
+  if (!process_id) {
+    PLOG(ERROR) << "GetProcessId";
+    return false;
+  }
+
+  ClientToServerMessage message;
+  memset(&message, 0, sizeof(message));
+  message.type = ClientToServerMessage::kDumpAndCrash;
+  message.dump_and_crash.client_process_id = process_id;
+  message.dump_and_crash.thread_id = thread_id;
+  message.dump_and_crash.exception_code = exception_code;
+
+  ServerToClientMessage response = {};
+  if (!SendToCrashHandlerServer(ipc_pipe_, message, &response)) {
+    return false;
+  }
+
+  // The handler terminates the target once it has been captured, without
+  // needing anything from the target to be scheduled.
+  const DWORD result = WaitForSingleObject(process, kDumpAndCrashTimeoutMs);
+  if (result != WAIT_OBJECT_0) {
+    PLOG_IF(ERROR, result == WAIT_FAILED) << "WaitForSingleObject";
+    LOG_IF(ERROR, result != WAIT_FAILED) << "WaitForSingleObject timed out";
+    return false;
+  }
+
+  return true;
+}
+
 }  // namespace crashpad
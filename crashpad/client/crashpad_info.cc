@@ -28,7 +28,7 @@
 
 namespace {
 
-constexpr uint32_t kCrashpadInfoVersion = 1;
+constexpr uint32_t kCrashpadInfoVersion = 7;
 
 }  // namespace
 
@@ -113,14 +113,21 @@ CrashpadInfo::CrashpadInfo()
       size_(sizeof(*this)),
       version_(kCrashpadInfoVersion),
       indirectly_referenced_memory_cap_(0),
-      padding_0_(0),
+      extra_memory_ranges_count_(0),
       crashpad_handler_behavior_(TriState::kUnset),
       system_crash_reporter_forwarding_(TriState::kUnset),
       gather_indirectly_referenced_memory_(TriState::kUnset),
       padding_1_(0),
       extra_memory_ranges_(nullptr),
       simple_annotations_(nullptr),
-      user_data_minidump_stream_head_(nullptr)
+      user_data_minidump_stream_head_(nullptr),
+      annotations_list_(nullptr),
+      thread_annotations_(nullptr),
+      ring_buffer_minidump_stream_head_(nullptr),
+      module_table_(nullptr),
+      capture_deadline_ms_(0),
+      excluded_memory_ranges_count_(0),
+      excluded_memory_ranges_(nullptr)
 #if !defined(NDEBUG) && defined(OS_WIN)
       ,
       invalid_read_detection_(0xbadc0de)
@@ -140,4 +147,16 @@ void CrashpadInfo::AddUserDataMinidumpStream(uint32_t stream_type,
   user_data_minidump_stream_head_ = to_be_added;
 }
 
+void CrashpadInfo::AddRingBufferMinidumpStream(
+    uint32_t stream_type,
+    const RingBufferDescriptor* descriptor) {
+  auto to_be_added = new internal::RingBufferMinidumpStreamListEntry();
+  to_be_added->next =
+      FromPointerCast<uint64_t>(ring_buffer_minidump_stream_head_);
+  to_be_added->descriptor_address = FromPointerCast<uint64_t>(descriptor);
+  to_be_added->stream_type = stream_type;
+  to_be_added->reserved = 0;
+  ring_buffer_minidump_stream_head_ = to_be_added;
+}
+
 }  // namespace crashpad
@@ -29,6 +29,10 @@
 
 namespace crashpad {
 
+class AnnotationList;
+class ModuleTable;
+class ThreadAnnotationRegistry;
+
 namespace internal {
 
 //! \brief A linked list of blocks representing custom streams in the minidump,
@@ -50,8 +54,64 @@ struct UserDataMinidumpStreamListEntry {
   uint32_t stream_type;
 };
 
+//! \brief A linked list of ring buffers to be written to the minidump as custom
+//!     streams, with addresses stored as uint64_t to simplify reading from the
+//!     handler process.
+struct RingBufferMinidumpStreamListEntry {
+  //! \brief The address of the next entry in the linked list.
+  uint64_t next;
+
+  //! \brief The address of the RingBufferDescriptor in the target process’
+  //!     address space.
+  uint64_t descriptor_address;
+
+  //! \brief The stream type identifier.
+  uint32_t stream_type;
+
+  uint32_t reserved;
+};
+
 }  // namespace internal
 
+//! \brief Describes an in-process ring buffer whose live contents should be
+//!     written to the minidump as a custom stream.
+//!
+//! The handler reads this structure at the time of the crash, and then reads
+//! only the portion of the buffer between #tail and #head, writing it to the
+//! minidump in order from oldest to newest. Data outside of that portion is
+//! not read.
+//!
+//! #head and #tail are byte offsets that increase monotonically as data is
+//! written and consumed, and are reduced modulo #capacity to find their
+//! positions within the buffer. If #head is more than #capacity beyond #tail,
+//! the writer has overwritten the oldest data, and only the most recent
+//! #capacity bytes are captured. Offsets that fall within an element are
+//! rounded inward to the nearest element boundary, so that an element being
+//! written at the time of the crash is not captured partially.
+//!
+//! All fields are fixed-width so that the handler can read this structure
+//! from a process of either bitness.
+struct RingBufferDescriptor {
+  //! \brief The address of the buffer.
+  uint64_t base_address;
+
+  //! \brief The size of the buffer in bytes. This must be a multiple of
+  //!     #element_size.
+  uint64_t capacity;
+
+  //! \brief The offset one past the newest byte written.
+  uint64_t head;
+
+  //! \brief The offset of the oldest byte that has not been consumed.
+  uint64_t tail;
+
+  //! \brief The size of each element in the buffer, in bytes. A buffer of
+  //!     variable-length records may use `1`.
+  uint32_t element_size;
+
+  uint32_t reserved;
+};
+
 //! \brief A structure that can be used by a Crashpad-enabled program to
 //!     provide information to the Crashpad crash handler.
 //!
@@ -72,14 +132,49 @@ struct CrashpadInfo {
   //! this method is called, or they may be added, removed, or modified in \a
   //! address_range_bag after this method is called.
   //!
+  //! The bag may have any capacity up to kSimpleAddressRangeBagMaxEntries. Its
+  //! capacity is recorded alongside it so that all of its entries can be read.
+  //!
   //! TODO(scottmg) This is currently only supported on Windows.
   //!
   //! \param[in] address_range_bag A bag of address ranges. The CrashpadInfo
-  //!     object does not take ownership of the SimpleAddressRangeBag object.
+  //!     object does not take ownership of the TSimpleAddressRangeBag object.
   //!     It is the caller’s responsibility to ensure that this pointer remains
   //!     valid while it is in effect for a CrashpadInfo object.
-  void set_extra_memory_ranges(SimpleAddressRangeBag* address_range_bag) {
+  template <size_t NumEntries>
+  void set_extra_memory_ranges(
+      TSimpleAddressRangeBag<NumEntries>* address_range_bag) {
     extra_memory_ranges_ = address_range_bag;
+    extra_memory_ranges_count_ = address_range_bag ? NumEntries : 0;
+  }
+
+  //! \brief Sets the bag of memory ranges to be left out of the snapshot’s
+  //!     indirectly referenced memory.
+  //!
+  //! Memory pointed to by registers, stacks, and the instruction at an
+  //! exception is normally captured. Memory within these ranges is not, so
+  //! that large regions of little diagnostic value, such as memory-mapped data
+  //! files and graphics buffers, do not use up the capture’s budget. Pointers
+  //! into these ranges are discarded before the handler queries the target
+  //! process about them. Ranges set by set_extra_memory_ranges() are captured
+  //! regardless. These are read by handlers that understand CrashpadInfo
+  //! version 7.
+  //!
+  //! Excluded ranges may exist in \a address_range_bag at the time that this
+  //! method is called, or they may be added, removed, or modified in \a
+  //! address_range_bag after this method is called.
+  //!
+  //! This is currently only supported on Windows.
+  //!
+  //! \param[in] address_range_bag A bag of address ranges. The CrashpadInfo
+  //!     object does not take ownership of the TSimpleAddressRangeBag object.
+  //!     It is the caller’s responsibility to ensure that this pointer remains
+  //!     valid while it is in effect for a CrashpadInfo object.
+  template <size_t NumEntries>
+  void set_excluded_memory_ranges(
+      TSimpleAddressRangeBag<NumEntries>* address_range_bag) {
+    excluded_memory_ranges_ = address_range_bag;
+    excluded_memory_ranges_count_ = address_range_bag ? NumEntries : 0;
   }
 
   //! \brief Sets the simple annotations dictionary.
@@ -109,6 +204,80 @@ struct CrashpadInfo {
     return simple_annotations_;
   }
 
+  //! \brief Sets the list of typed annotations.
+  //!
+  //! Annotations set on a CrashpadInfo structure are interpreted by Crashpad
+  //! as module-level annotations. Unlike simple annotations, each annotation
+  //! occupies only as much memory as its value needs, and may carry a string,
+  //! integer, or binary value. These are read by handlers that understand
+  //! CrashpadInfo version 2.
+  //!
+  //! Annotations may be added to \a annotations_list after this method is
+  //! called.
+  //!
+  //! \param[in] annotations_list The list of annotations. The CrashpadInfo
+  //!     object does not take ownership of the AnnotationList object. It is
+  //!     the caller’s responsibility to ensure that this pointer remains valid
+  //!     while it is in effect for a CrashpadInfo object.
+  //!
+  //! \sa annotations_list()
+  //! \sa AnnotationList::Register()
+  void set_annotations_list(AnnotationList* annotations_list) {
+    annotations_list_ = annotations_list;
+  }
+
+  //! \return The list of typed annotations.
+  //!
+  //! \sa set_annotations_list()
+  AnnotationList* annotations_list() const { return annotations_list_; }
+
+  //! \brief Sets the registry of per-thread annotations.
+  //!
+  //! Annotations in the registry are interpreted by Crashpad as belonging to
+  //! individual threads, and are read by handlers that understand CrashpadInfo
+  //! version 3. This is normally called by
+  //! ThreadAnnotationRegistry::GetInstance(), and does not need to be called
+  //! directly.
+  //!
+  //! \param[in] thread_annotations The registry. The CrashpadInfo object does
+  //!     not take ownership of the ThreadAnnotationRegistry object. It is the
+  //!     caller’s responsibility to ensure that this pointer remains valid
+  //!     while it is in effect for a CrashpadInfo object.
+  //!
+  //! \sa thread_annotations()
+  void set_thread_annotations(ThreadAnnotationRegistry* thread_annotations) {
+    thread_annotations_ = thread_annotations;
+  }
+
+  //! \return The registry of per-thread annotations.
+  //!
+  //! \sa set_thread_annotations()
+  ThreadAnnotationRegistry* thread_annotations() const {
+    return thread_annotations_;
+  }
+
+  //! \brief Sets the table of loaded modules.
+  //!
+  //! Handlers that understand CrashpadInfo version 5 read the list of modules
+  //! from the table rather than walking the loader’s structures. This is
+  //! normally called by ModuleTable::GetInstance(), and does not need to be
+  //! called directly.
+  //!
+  //! \param[in] module_table The table. The CrashpadInfo object does not take
+  //!     ownership of the ModuleTable object. It is the caller’s
+  //!     responsibility to ensure that this pointer remains valid while it is
+  //!     in effect for a CrashpadInfo object.
+  //!
+  //! \sa module_table()
+  void set_module_table(ModuleTable* module_table) {
+    module_table_ = module_table;
+  }
+
+  //! \return The table of loaded modules.
+  //!
+  //! \sa set_module_table()
+  ModuleTable* module_table() const { return module_table_; }
+
   //! \brief Enables or disables Crashpad handler processing.
   //!
   //! When handling an exception, the Crashpad handler will scan all modules in
@@ -170,6 +339,30 @@ struct CrashpadInfo {
     indirectly_referenced_memory_cap_ = limit;
   }
 
+  //! \brief Limits the time that the Crashpad handler may take to capture a
+  //!     snapshot of the process.
+  //!
+  //! When handling an exception, the Crashpad handler will scan all modules in
+  //! a process. The first one that has a CrashpadInfo structure populated with
+  //! a nonzero value for this field will dictate the limit, overriding the
+  //! handler’s own. This is read by handlers that understand CrashpadInfo
+  //! version 6.
+  //!
+  //! As the limit nears, the handler leaves out content that the minidump can
+  //! do without, such as indirectly referenced memory, handle data, the memory
+  //! map, unloaded modules, and locks, and records what it left out. This
+  //! allows a process that would be terminated by the system if it stayed
+  //! suspended for too long to still produce a minidump.
+  //!
+  //! This is currently only supported on Windows.
+  //!
+  //! \param[in] capture_deadline_ms The time, in milliseconds, that capturing a
+  //!     snapshot may take. `0` to use the handler’s limit, which is the
+  //!     default.
+  void set_capture_deadline_ms(uint32_t capture_deadline_ms) {
+    capture_deadline_ms_ = capture_deadline_ms;
+  }
+
   //! \brief Adds a custom stream to the minidump.
   //!
   //! The memory block referenced by \a data and \a size will added to the
@@ -191,6 +384,32 @@ struct CrashpadInfo {
                                  const void* data,
                                  size_t size);
 
+  //! \brief Adds a custom stream to the minidump, captured from a ring buffer.
+  //!
+  //! Unlike registering the buffer with AddUserDataMinidumpStream() or
+  //! set_extra_memory_ranges(), only the live portion of the buffer described
+  //! by \a descriptor is read, and it is written to the stream in order from
+  //! oldest to newest, regardless of where it wraps in the buffer. The stream
+  //! is omitted if the ring buffer is empty. These are read by handlers that
+  //! understand CrashpadInfo version 4.
+  //!
+  //! Note that streams will appear in the minidump in the reverse order to
+  //! which they are added.
+  //!
+  //! TODO(scottmg) This is currently only supported on Windows.
+  //!
+  //! \param[in] stream_type The stream type identifier to use. This should be
+  //!     normally be larger than `MINIDUMP_STREAM_TYPE::LastReservedStream`
+  //!     which is `0xffff`.
+  //! \param[in] descriptor The descriptor of the ring buffer. The CrashpadInfo
+  //!     object does not take ownership of the descriptor. The caller is
+  //!     expected to update its #RingBufferDescriptor::head and
+  //!     #RingBufferDescriptor::tail fields as the buffer is used, and it is
+  //!     the caller’s responsibility to ensure that this pointer remains valid
+  //!     while it is in effect for a CrashpadInfo object.
+  void AddRingBufferMinidumpStream(uint32_t stream_type,
+                                   const RingBufferDescriptor* descriptor);
+
   enum : uint32_t {
     kSignature = 'CPad',
   };
@@ -210,15 +429,40 @@ struct CrashpadInfo {
   uint32_t size_;  // The size of the entire CrashpadInfo structure.
   uint32_t version_;  // kVersion
   uint32_t indirectly_referenced_memory_cap_;
-  uint32_t padding_0_;
+
+  // The capacity of *extra_memory_ranges_. This was padding before it carried
+  // the capacity, and clients that wrote it as padding always wrote 0. A value
+  // of 0 means the SimpleAddressRangeBag default of 64 entries.
+  uint32_t extra_memory_ranges_count_;
+
   TriState crashpad_handler_behavior_;
   TriState system_crash_reporter_forwarding_;
   TriState gather_indirectly_referenced_memory_;
   uint8_t padding_1_;
-  SimpleAddressRangeBag* extra_memory_ranges_;  // weak
+  void* extra_memory_ranges_;  // weak, TSimpleAddressRangeBag
   SimpleStringDictionary* simple_annotations_;  // weak
   internal::UserDataMinidumpStreamListEntry* user_data_minidump_stream_head_;
 
+  // Fields present in version 2:
+  AnnotationList* annotations_list_;  // weak
+
+  // Fields present in version 3:
+  ThreadAnnotationRegistry* thread_annotations_;  // weak
+
+  // Fields present in version 4:
+  internal::RingBufferMinidumpStreamListEntry*
+      ring_buffer_minidump_stream_head_;
+
+  // Fields present in version 5:
+  ModuleTable* module_table_;  // weak
+
+  // Fields present in version 6:
+  uint32_t capture_deadline_ms_;
+
+  // Fields present in version 7:
+  uint32_t excluded_memory_ranges_count_;
+  void* excluded_memory_ranges_;  // weak, TSimpleAddressRangeBag
+
 #if !defined(NDEBUG) && defined(OS_WIN)
   uint32_t invalid_read_detection_;
 #endif
@@ -0,0 +1,588 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/fallback_minidump_writer_linux.h"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/strings/utf_string_conversions.h"
+#include "build/build_config.h"
+#include "minidump/minidump_context.h"
+#include "minidump/minidump_extensions.h"
+#include "util/misc/paths.h"
+#include "util/misc/pdb_structures.h"
+#include "util/misc/uuid.h"
+
+namespace crashpad {
+
+namespace {
+
+#if defined(ARCH_CPU_X86_64)
+using MinidumpContextNative = MinidumpContextAMD64;
+constexpr MinidumpCPUArchitecture kCPUArchitecture =
+    kMinidumpCPUArchitectureAMD64;
+
+// The System V x86_64 ABI allows functions to use 128 bytes below the stack
+// pointer without adjusting it.
+constexpr size_t kRedZoneSize = 128;
+#elif defined(ARCH_CPU_X86)
+using MinidumpContextNative = MinidumpContextX86;
+constexpr MinidumpCPUArchitecture kCPUArchitecture =
+    kMinidumpCPUArchitectureX86;
+constexpr size_t kRedZoneSize = 0;
+#else
+#error Port.
+#endif
+
+#if defined(OS_ANDROID)
+constexpr MinidumpOS kOperatingSystem = kMinidumpOSAndroid;
+#else
+constexpr MinidumpOS kOperatingSystem = kMinidumpOSLinux;
+#endif
+
+// The most stack captured for the crashing thread, starting at its stack
+// pointer.
+constexpr size_t kMaxStackCaptureSize = 64 * 1024;
+
+enum StreamIndex : size_t {
+  kSystemInfoStreamIndex = 0,
+  kExceptionStreamIndex,
+  kThreadListStreamIndex,
+  kMemoryListStreamIndex,
+  kModuleListStreamIndex,
+  kStreamCount,
+};
+
+// The minidump file is laid out as the structures in Scratch, in order, then
+// the module list stream prepared by UpdateModules(), then the crashing
+// thread’s stack. Everything but the stack is at a fixed offset.
+constexpr RVA kDirectoryRVA = sizeof(MINIDUMP_HEADER);
+constexpr RVA kSystemInfoRVA =
+    kDirectoryRVA + kStreamCount * sizeof(MINIDUMP_DIRECTORY);
+constexpr RVA kExceptionRVA = kSystemInfoRVA + sizeof(MINIDUMP_SYSTEM_INFO);
+constexpr RVA kThreadListRVA =
+    kExceptionRVA + sizeof(MINIDUMP_EXCEPTION_STREAM);
+constexpr RVA kThreadRVA = kThreadListRVA + sizeof(MINIDUMP_THREAD_LIST);
+constexpr RVA kMemoryListRVA = kThreadRVA + sizeof(MINIDUMP_THREAD);
+constexpr RVA kStackDescriptorRVA =
+    kMemoryListRVA + sizeof(MINIDUMP_MEMORY_LIST);
+constexpr RVA kContextRVA =
+    kStackDescriptorRVA + sizeof(MINIDUMP_MEMORY_DESCRIPTOR);
+constexpr RVA kModuleListRVA = kContextRVA + sizeof(MinidumpContextNative);
+
+struct ModuleRecord {
+  std::string name;
+  std::string build_id;
+  uint64_t base;
+  uint64_t size;
+};
+
+// Returns the GNU build ID in a PT_NOTE segment, or an empty string if it has
+// none.
+std::string FindBuildID(const char* notes, size_t size, size_t alignment) {
+  auto align = [alignment](size_t value) {
+    return (value + alignment - 1) & ~(alignment - 1);
+  };
+
+  size_t offset = 0;
+  while (size - offset >= sizeof(ElfW(Nhdr))) {
+    ElfW(Nhdr) note;
+    memcpy(&note, notes + offset, sizeof(note));
+    const size_t name_offset = offset + sizeof(note);
+    const size_t desc_offset = name_offset + align(note.n_namesz);
+    const size_t next_offset = desc_offset + align(note.n_descsz);
+    if (desc_offset > size || next_offset > size || next_offset <= offset) {
+      break;
+    }
+
+    static constexpr char kGNUNoteName[] = ELF_NOTE_GNU;
+    if (note.n_type == NT_GNU_BUILD_ID &&
+        note.n_namesz == sizeof(kGNUNoteName) &&
+        memcmp(notes + name_offset, kGNUNoteName, sizeof(kGNUNoteName)) == 0) {
+      return std::string(notes + desc_offset, note.n_descsz);
+    }
+    offset = next_offset;
+  }
+  return std::string();
+}
+
+int AddModuleRecord(dl_phdr_info* info, size_t size, void* data) {
+  auto modules = static_cast<std::vector<ModuleRecord>*>(data);
+
+  ModuleRecord module;
+  module.name = info->dlpi_name ? info->dlpi_name : "";
+  uint64_t start = std::numeric_limits<uint64_t>::max();
+  uint64_t end = 0;
+  for (ElfW(Half) index = 0; index < info->dlpi_phnum; ++index) {
+    const ElfW(Phdr)& phdr = info->dlpi_phdr[index];
+    if (phdr.p_type == PT_LOAD) {
+      start = std::min(start, static_cast<uint64_t>(phdr.p_vaddr));
+      end = std::max(end, static_cast<uint64_t>(phdr.p_vaddr + phdr.p_memsz));
+    } else if (phdr.p_type == PT_NOTE && module.build_id.empty()) {
+      // Note segments are loaded, so they can be read in place.
+      module.build_id =
+          FindBuildID(reinterpret_cast<const char*>(info->dlpi_addr +
+                                                    phdr.p_vaddr),
+                      phdr.p_memsz,
+                      phdr.p_align == 8 ? 8 : 4);
+    }
+  }
+  if (end <= start) {
+    return 0;
+  }
+
+  module.base = info->dlpi_addr + start;
+  module.size = end - start;
+  modules->push_back(module);
+  return 0;
+}
+
+// Appends |size| bytes at |data| to |stream|, padded to a multiple of 4 bytes,
+// and returns the RVA of the appended data.
+RVA AppendToStream(std::string* stream, const void* data, size_t size) {
+  const RVA rva = kModuleListRVA + static_cast<RVA>(stream->size());
+  stream->append(static_cast<const char*>(data), size);
+  stream->resize((stream->size() + 3) & ~3);
+  return rva;
+}
+
+// Writes all of |size| bytes at |data| to |fd|. This is async-signal-safe.
+bool WriteAll(int fd, const void* data, size_t size) {
+  const char* buffer = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t rv = HANDLE_EINTR(write(fd, buffer, size));
+    if (rv <= 0) {
+      return false;
+    }
+    buffer += rv;
+    size -= rv;
+  }
+  return true;
+}
+
+// Writes up to |size| bytes of this process’ memory at |address| to |fd|, and
+// returns the number of bytes written. The memory is written a page at a time,
+// and writing stops at the first page that can’t be read, which write()
+// rejects with EFAULT. This is async-signal-safe.
+size_t WriteMemory(int fd, uintptr_t address, size_t size, size_t page_size) {
+  size_t written = 0;
+  while (written < size) {
+    const uintptr_t chunk_address = address + written;
+    const size_t chunk_size =
+        std::min(size - written,
+                 page_size - (chunk_address & (page_size - 1)));
+    ssize_t rv = HANDLE_EINTR(write(
+        fd, reinterpret_cast<const void*>(chunk_address), chunk_size));
+    if (rv <= 0) {
+      break;
+    }
+    written += rv;
+  }
+  return written;
+}
+
+void InitializeContext(const ucontext_t* ucontext,
+                       MinidumpContextNative* context) {
+  memset(context, 0, sizeof(*context));
+  const greg_t* gregs = ucontext->uc_mcontext.gregs;
+
+#if defined(ARCH_CPU_X86_64)
+  context->context_flags = kMinidumpContextAMD64Full |
+                           kMinidumpContextAMD64Segment;
+  context->rax = gregs[REG_RAX];
+  context->rbx = gregs[REG_RBX];
+  context->rcx = gregs[REG_RCX];
+  context->rdx = gregs[REG_RDX];
+  context->rdi = gregs[REG_RDI];
+  context->rsi = gregs[REG_RSI];
+  context->rbp = gregs[REG_RBP];
+  context->rsp = gregs[REG_RSP];
+  context->r8 = gregs[REG_R8];
+  context->r9 = gregs[REG_R9];
+  context->r10 = gregs[REG_R10];
+  context->r11 = gregs[REG_R11];
+  context->r12 = gregs[REG_R12];
+  context->r13 = gregs[REG_R13];
+  context->r14 = gregs[REG_R14];
+  context->r15 = gregs[REG_R15];
+  context->rip = gregs[REG_RIP];
+  context->eflags = static_cast<uint32_t>(gregs[REG_EFL]);
+
+  // cs, gs, and fs are packed into a single register slot.
+  const uint64_t csgsfs = gregs[REG_CSGSFS];
+  context->cs = csgsfs & 0xffff;
+  context->gs = (csgsfs >> 16) & 0xffff;
+  context->fs = (csgsfs >> 32) & 0xffff;
+
+  // The floating-point state is in fxsave format.
+  if (ucontext->uc_mcontext.fpregs) {
+    static_assert(sizeof(context->fxsave) ==
+                      sizeof(*ucontext->uc_mcontext.fpregs),
+                  "fxsave size mismatch");
+    memcpy(&context->fxsave,
+           ucontext->uc_mcontext.fpregs,
+           sizeof(context->fxsave));
+    context->mx_csr = context->fxsave.mxcsr;
+  }
+#elif defined(ARCH_CPU_X86)
+  context->context_flags = kMinidumpContextX86Full;
+  context->eax = gregs[REG_EAX];
+  context->ebx = gregs[REG_EBX];
+  context->ecx = gregs[REG_ECX];
+  context->edx = gregs[REG_EDX];
+  context->edi = gregs[REG_EDI];
+  context->esi = gregs[REG_ESI];
+  context->ebp = gregs[REG_EBP];
+  context->esp = gregs[REG_ESP];
+  context->eip = gregs[REG_EIP];
+  context->eflags = gregs[REG_EFL];
+  context->cs = gregs[REG_CS];
+  context->ds = gregs[REG_DS];
+  context->es = gregs[REG_ES];
+  context->fs = gregs[REG_FS];
+  context->gs = gregs[REG_GS];
+  context->ss = gregs[REG_SS];
+
+  // The floating-point state begins in fsave format.
+  if (ucontext->uc_mcontext.fpregs) {
+    context->context_flags |= kMinidumpContextX86FloatingPoint;
+    memcpy(&context->fsave,
+           ucontext->uc_mcontext.fpregs,
+           sizeof(context->fsave));
+  }
+#endif
+}
+
+uint64_t StackPointer(const MinidumpContextNative& context) {
+#if defined(ARCH_CPU_X86_64)
+  return context.rsp;
+#elif defined(ARCH_CPU_X86)
+  return context.esp;
+#endif
+}
+
+// The minidump’s fixed-size structures, in the order that they appear in the
+// file. This lives at the start of the arena. The list streams’ headers are
+// represented by their counts, because the list structures end in zero-length
+// arrays.
+struct Scratch {
+  MINIDUMP_HEADER header;
+  MINIDUMP_DIRECTORY directory[kStreamCount];
+  MINIDUMP_SYSTEM_INFO system_info;
+  MINIDUMP_EXCEPTION_STREAM exception;
+  uint32_t thread_count;
+  MINIDUMP_THREAD thread;
+  uint32_t memory_range_count;
+  MINIDUMP_MEMORY_DESCRIPTOR stack;
+  MinidumpContextNative context;
+};
+
+static_assert(sizeof(MINIDUMP_THREAD_LIST) == sizeof(uint32_t),
+              "thread list header size");
+static_assert(sizeof(MINIDUMP_MEMORY_LIST) == sizeof(uint32_t),
+              "memory list header size");
+static_assert(sizeof(MINIDUMP_MODULE_LIST) == sizeof(uint32_t),
+              "module list header size");
+
+// Writes the minidump, but for the stack, whose size isn’t known until it has
+// been written. This is async-signal-safe.
+bool WriteFixedParts(int fd,
+                     const Scratch& scratch,
+                     const void* module_list,
+                     size_t module_list_size) {
+  return WriteAll(fd, &scratch.header, sizeof(scratch.header)) &&
+         WriteAll(fd, scratch.directory, sizeof(scratch.directory)) &&
+         WriteAll(fd, &scratch.system_info, sizeof(scratch.system_info)) &&
+         WriteAll(fd, &scratch.exception, sizeof(scratch.exception)) &&
+         WriteAll(fd, &scratch.thread_count, sizeof(scratch.thread_count)) &&
+         WriteAll(fd, &scratch.thread, sizeof(scratch.thread)) &&
+         WriteAll(fd,
+                  &scratch.memory_range_count,
+                  sizeof(scratch.memory_range_count)) &&
+         WriteAll(fd, &scratch.stack, sizeof(scratch.stack)) &&
+         WriteAll(fd, &scratch.context, sizeof(scratch.context)) &&
+         WriteAll(fd, module_list, module_list_size);
+}
+
+}  // namespace
+
+FallbackMinidumpWriter::FallbackMinidumpWriter()
+    : path_(),
+      arena_(),
+      page_size_(0),
+      module_list_size_(0),
+      writing_(false),
+      initialized_() {}
+
+FallbackMinidumpWriter::~FallbackMinidumpWriter() {}
+
+bool FallbackMinidumpWriter::Initialize(const base::FilePath& path,
+                                        size_t arena_size) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  if (arena_size <= sizeof(Scratch)) {
+    LOG(ERROR) << "arena size " << arena_size << " too small";
+    return false;
+  }
+
+  if (!arena_.ResetMmap(nullptr,
+                        arena_size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1,
+                        0)) {
+    return false;
+  }
+  path_ = path.value();
+  page_size_ = getpagesize();
+
+  // Everything that doesn’t depend on the crash is filled in now.
+  Scratch* scratch = arena_.addr_as<Scratch*>();
+  memset(scratch, 0, sizeof(*scratch));
+
+  scratch->header.Signature = MINIDUMP_SIGNATURE;
+  scratch->header.Version = MINIDUMP_VERSION;
+  scratch->header.NumberOfStreams = kStreamCount;
+  scratch->header.StreamDirectoryRva = kDirectoryRVA;
+  scratch->header.Flags = MiniDumpNormal;
+
+  MINIDUMP_DIRECTORY* directory = scratch->directory;
+  directory[kSystemInfoStreamIndex].StreamType = kMinidumpStreamTypeSystemInfo;
+  directory[kSystemInfoStreamIndex].Location.DataSize =
+      sizeof(MINIDUMP_SYSTEM_INFO);
+  directory[kSystemInfoStreamIndex].Location.Rva = kSystemInfoRVA;
+  directory[kExceptionStreamIndex].StreamType = kMinidumpStreamTypeException;
+  directory[kExceptionStreamIndex].Location.DataSize =
+      sizeof(MINIDUMP_EXCEPTION_STREAM);
+  directory[kExceptionStreamIndex].Location.Rva = kExceptionRVA;
+  directory[kThreadListStreamIndex].StreamType = kMinidumpStreamTypeThreadList;
+  directory[kThreadListStreamIndex].Location.DataSize =
+      sizeof(MINIDUMP_THREAD_LIST) + sizeof(MINIDUMP_THREAD);
+  directory[kThreadListStreamIndex].Location.Rva = kThreadListRVA;
+  directory[kMemoryListStreamIndex].StreamType = kMinidumpStreamTypeMemoryList;
+  directory[kMemoryListStreamIndex].Location.DataSize =
+      sizeof(MINIDUMP_MEMORY_LIST) + sizeof(MINIDUMP_MEMORY_DESCRIPTOR);
+  directory[kMemoryListStreamIndex].Location.Rva = kMemoryListRVA;
+  directory[kModuleListStreamIndex].StreamType = kMinidumpStreamTypeModuleList;
+  directory[kModuleListStreamIndex].Location.Rva = kModuleListRVA;
+
+  scratch->system_info.ProcessorArchitecture = kCPUArchitecture;
+  scratch->system_info.PlatformId = kOperatingSystem;
+  long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+  scratch->system_info.NumberOfProcessors =
+      cpu_count > 0 ? std::min(cpu_count, 255l) : 0;
+
+  scratch->exception.ThreadContext.DataSize = sizeof(MinidumpContextNative);
+  scratch->exception.ThreadContext.Rva = kContextRVA;
+
+  scratch->thread_count = 1;
+  scratch->thread.ThreadContext.DataSize = sizeof(MinidumpContextNative);
+  scratch->thread.ThreadContext.Rva = kContextRVA;
+
+  scratch->memory_range_count = 1;
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+bool FallbackMinidumpWriter::UpdateModules() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::vector<ModuleRecord> modules;
+  dl_iterate_phdr(AddModuleRecord, &modules);
+
+  // The main executable is reported without a name.
+  if (!modules.empty() && modules[0].name.empty()) {
+    base::FilePath executable;
+    if (Paths::Executable(&executable)) {
+      modules[0].name = executable.value();
+    }
+  }
+
+  // Lay out the stream in memory first. The module records must be
+  // contiguous, so their variable-length data follows all of them.
+  std::string stream;
+  MINIDUMP_MODULE_LIST module_list;
+  module_list.NumberOfModules = static_cast<uint32_t>(modules.size());
+  AppendToStream(&stream, &module_list, sizeof(module_list));
+  stream.resize(stream.size() + modules.size() * sizeof(MINIDUMP_MODULE));
+
+  for (size_t index = 0; index < modules.size(); ++index) {
+    const ModuleRecord& module = modules[index];
+
+    MINIDUMP_MODULE minidump_module = {};
+    minidump_module.BaseOfImage = module.base;
+    minidump_module.SizeOfImage = static_cast<uint32_t>(
+        std::min(module.size,
+                 static_cast<uint64_t>(std::numeric_limits<uint32_t>::max())));
+    minidump_module.VersionInfo.dwSignature = VS_FFI_SIGNATURE;
+    minidump_module.VersionInfo.dwStrucVersion = VS_FFI_STRUCVERSION;
+
+    base::string16 name_utf16 = base::UTF8ToUTF16(module.name);
+    std::string name(sizeof(MINIDUMP_STRING), '\0');
+    uint32_t name_length =
+        static_cast<uint32_t>(name_utf16.size() * sizeof(name_utf16[0]));
+    memcpy(&name[0], &name_length, sizeof(name_length));
+    name.append(reinterpret_cast<const char*>(name_utf16.c_str()),
+                name_length + sizeof(name_utf16[0]));
+    minidump_module.ModuleNameRva =
+        AppendToStream(&stream, name.data(), name.size());
+
+    // Build IDs stand in for a PDB’s UUID, as by ModuleSnapshotLinux.
+    uint8_t uuid_bytes[sizeof(UUID)] = {};
+    memcpy(uuid_bytes,
+           module.build_id.data(),
+           std::min(module.build_id.size(), sizeof(uuid_bytes)));
+    CodeViewRecordPDB70 codeview_record;
+    codeview_record.signature = CodeViewRecordPDB70::kSignature;
+    codeview_record.uuid.InitializeFromBytes(uuid_bytes);
+    codeview_record.age = 0;
+    const std::string pdb_name = base::FilePath(module.name).BaseName().value();
+    std::string record(reinterpret_cast<const char*>(&codeview_record),
+                       offsetof(CodeViewRecordPDB70, pdb_name));
+    record.append(pdb_name.c_str(), pdb_name.size() + 1);
+    minidump_module.CvRecord.DataSize = static_cast<uint32_t>(record.size());
+    minidump_module.CvRecord.Rva =
+        AppendToStream(&stream, record.data(), record.size());
+
+    memcpy(&stream[sizeof(module_list) + index * sizeof(minidump_module)],
+           &minidump_module,
+           sizeof(minidump_module));
+  }
+
+  const size_t capacity = arena_.len() - sizeof(Scratch);
+  if (stream.size() > capacity) {
+    LOG(ERROR) << "module list size " << stream.size() << " exceeds "
+               << capacity;
+    module_list_size_.store(0, std::memory_order_release);
+    return false;
+  }
+
+  // A minidump written while the stream is being replaced has no module list.
+  module_list_size_.store(0, std::memory_order_release);
+  memcpy(arena_.addr_as<char*>() + sizeof(Scratch), stream.data(),
+         stream.size());
+  module_list_size_.store(stream.size(), std::memory_order_release);
+  return true;
+}
+
+bool FallbackMinidumpWriter::WriteMinidump(const siginfo_t* siginfo,
+                                           const ucontext_t* context) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  if (writing_.exchange(true)) {
+    return false;
+  }
+
+  Scratch* scratch = arena_.addr_as<Scratch*>();
+  const size_t module_list_size =
+      module_list_size_.load(std::memory_order_acquire);
+  const char* module_list = arena_.addr_as<char*>() + sizeof(Scratch);
+
+  timespec now;
+  if (clock_gettime(CLOCK_REALTIME, &now) == 0) {
+    scratch->header.TimeDateStamp = static_cast<uint32_t>(now.tv_sec);
+  }
+
+  MINIDUMP_LOCATION_DESCRIPTOR& module_list_location =
+      scratch->directory[kModuleListStreamIndex].Location;
+  if (module_list_size) {
+    uint32_t module_count;
+    memcpy(&module_count, module_list, sizeof(module_count));
+    module_list_location.DataSize = static_cast<uint32_t>(
+        sizeof(MINIDUMP_MODULE_LIST) + module_count * sizeof(MINIDUMP_MODULE));
+  } else {
+    // An empty module list still needs its count.
+    static constexpr MINIDUMP_MODULE_LIST kEmptyModuleList = {};
+    module_list = reinterpret_cast<const char*>(&kEmptyModuleList);
+    module_list_location.DataSize = sizeof(kEmptyModuleList);
+  }
+  const size_t written_module_list_size =
+      module_list_size ? module_list_size : sizeof(MINIDUMP_MODULE_LIST);
+
+  const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+  InitializeContext(context, &scratch->context);
+
+  MINIDUMP_EXCEPTION& exception_record = scratch->exception.ExceptionRecord;
+  scratch->exception.ThreadId = tid;
+  exception_record.ExceptionCode = siginfo->si_signo;
+  exception_record.ExceptionFlags = siginfo->si_code;
+  switch (siginfo->si_signo) {
+    case SIGILL:
+    case SIGFPE:
+    case SIGSEGV:
+    case SIGBUS:
+    case SIGTRAP:
+      exception_record.ExceptionAddress =
+          reinterpret_cast<uintptr_t>(siginfo->si_addr);
+      break;
+    default:
+      exception_record.ExceptionAddress = 0;
+      break;
+  }
+
+  // The stack size is set once the stack has been written.
+  const uint64_t stack_start = StackPointer(scratch->context) - kRedZoneSize;
+  const RVA stack_rva =
+      kModuleListRVA + static_cast<RVA>(written_module_list_size);
+  scratch->thread.ThreadId = tid;
+  scratch->thread.Stack.StartOfMemoryRange = stack_start;
+  scratch->thread.Stack.Memory.DataSize = 0;
+  scratch->thread.Stack.Memory.Rva = stack_rva;
+  scratch->stack = scratch->thread.Stack;
+
+  // ScopedFileHandle isn’t used, because it may log on failure to close.
+  const int fd = HANDLE_EINTR(
+      open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600));
+  if (fd < 0) {
+    return false;
+  }
+
+  bool success =
+      WriteFixedParts(fd, *scratch, module_list, written_module_list_size);
+  if (success) {
+    const size_t stack_size = WriteMemory(fd,
+                                          static_cast<uintptr_t>(stack_start),
+                                          kMaxStackCaptureSize,
+                                          page_size_);
+    scratch->thread.Stack.Memory.DataSize = static_cast<uint32_t>(stack_size);
+    scratch->stack = scratch->thread.Stack;
+
+    success = lseek(fd, kThreadRVA, SEEK_SET) == kThreadRVA &&
+              WriteAll(fd, &scratch->thread, sizeof(scratch->thread)) &&
+              lseek(fd, kStackDescriptorRVA, SEEK_SET) == kStackDescriptorRVA &&
+              WriteAll(fd, &scratch->stack, sizeof(scratch->stack));
+  }
+
+  if (IGNORE_EINTR(close(fd)) != 0) {
+    success = false;
+  }
+  return success;
+}
+
+}  // namespace crashpad
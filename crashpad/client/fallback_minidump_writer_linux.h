@@ -0,0 +1,94 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_CLIENT_FALLBACK_MINIDUMP_WRITER_LINUX_H_
+#define CRASHPAD_CLIENT_FALLBACK_MINIDUMP_WRITER_LINUX_H_
+
+#include <signal.h>
+#include <stddef.h>
+#include <ucontext.h>
+
+#include <atomic>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "util/misc/initialization_state_dcheck.h"
+#include "util/posix/scoped_mmap.h"
+
+namespace crashpad {
+
+//! \brief Writes a reduced minidump from within a crashing process, for use
+//!     when the out-of-process handler can’t be reached.
+//!
+//! The minidump contains the system’s CPU architecture, the exception, the
+//! crashing thread with its context and the top of its stack, and the module
+//! list. Everything that requires allocation or locks is done ahead of time:
+//! Initialize() reserves an arena to hold the minidump’s fixed-size
+//! structures, and UpdateModules() lays out the module list stream in the
+//! arena. The minidump itself is then written by WriteMinidump(), which is
+//! async-signal-safe, from a signal handler.
+class FallbackMinidumpWriter {
+ public:
+  FallbackMinidumpWriter();
+  ~FallbackMinidumpWriter();
+
+  //! \brief Initializes the writer.
+  //!
+  //! This method is not async-signal-safe.
+  //!
+  //! \param[in] path The path that WriteMinidump() will write to. This should
+  //!     be unique to the process, as any existing file will be replaced.
+  //! \param[in] arena_size The size of the arena to reserve. This must be large
+  //!     enough for the module list stream laid out by UpdateModules(), for
+  //!     which 64 kB is ample in most processes.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool Initialize(const base::FilePath& path, size_t arena_size);
+
+  //! \brief Records the modules currently loaded in the process.
+  //!
+  //! This must be called at least once before WriteMinidump() for the minidump
+  //! to contain a module list, and should be called again whenever modules are
+  //! loaded or unloaded. It is not async-signal-safe. A minidump written while
+  //! this method is running has no module list.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool UpdateModules();
+
+  //! \brief Writes a minidump for a signal received by the calling thread.
+  //!
+  //! This method is async-signal-safe, and is intended to be called from a
+  //! signal handler. Only the first call writes a minidump.
+  //!
+  //! \param[in] siginfo The signal information passed to the signal handler.
+  //! \param[in] context The context passed to the signal handler.
+  //!
+  //! \return `true` on success. `false` on failure. No message is logged.
+  bool WriteMinidump(const siginfo_t* siginfo, const ucontext_t* context);
+
+ private:
+  std::string path_;
+  ScopedMmap arena_;
+  size_t page_size_;
+  std::atomic<size_t> module_list_size_;
+  std::atomic<bool> writing_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(FallbackMinidumpWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_CLIENT_FALLBACK_MINIDUMP_WRITER_LINUX_H_
@@ -0,0 +1,133 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/fallback_minidump_writer_linux.h"
+
+#include <signal.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "build/build_config.h"
+#include "gtest/gtest.h"
+#include "snapshot/cpu_context.h"
+#include "snapshot/exception_snapshot.h"
+#include "snapshot/memory_snapshot.h"
+#include "snapshot/minidump/process_snapshot_minidump.h"
+#include "snapshot/module_snapshot.h"
+#include "snapshot/system_snapshot.h"
+#include "snapshot/thread_snapshot.h"
+#include "test/scoped_temp_dir.h"
+#include "test/test_paths.h"
+#include "util/file/file_reader.h"
+#include "util/misc/from_pointer_cast.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr size_t kArenaSize = 256 * 1024;
+
+void CodeInExecutable() {}
+
+TEST(FallbackMinidumpWriter, WriteMinidump) {
+  ScopedTempDir temp_dir;
+  base::FilePath path = temp_dir.path().Append(FILE_PATH_LITERAL("minidump"));
+
+  FallbackMinidumpWriter writer;
+  ASSERT_TRUE(writer.Initialize(path, kArenaSize));
+  ASSERT_TRUE(writer.UpdateModules());
+
+  siginfo_t siginfo = {};
+  siginfo.si_signo = SIGSEGV;
+  siginfo.si_code = SEGV_MAPERR;
+  siginfo.si_addr = reinterpret_cast<void*>(0x1000);
+
+  ucontext_t context;
+  ASSERT_EQ(getcontext(&context), 0);
+
+  ASSERT_TRUE(writer.WriteMinidump(&siginfo, &context));
+
+  // Only one minidump is ever written.
+  EXPECT_FALSE(writer.WriteMinidump(&siginfo, &context));
+
+  FileReader reader;
+  ASSERT_TRUE(reader.Open(path));
+  ProcessSnapshotMinidump snapshot;
+  ASSERT_TRUE(snapshot.Initialize(&reader));
+
+  const SystemSnapshot* system = snapshot.System();
+  ASSERT_TRUE(system);
+#if defined(ARCH_CPU_X86_64)
+  EXPECT_EQ(system->GetCPUArchitecture(), kCPUArchitectureX86_64);
+#elif defined(ARCH_CPU_X86)
+  EXPECT_EQ(system->GetCPUArchitecture(), kCPUArchitectureX86);
+#endif
+
+  const pid_t tid = syscall(SYS_gettid);
+
+  const ExceptionSnapshot* exception = snapshot.Exception();
+  ASSERT_TRUE(exception);
+  EXPECT_EQ(exception->ThreadID(), static_cast<uint64_t>(tid));
+  EXPECT_EQ(exception->Exception(), static_cast<uint32_t>(SIGSEGV));
+  EXPECT_EQ(exception->ExceptionInfo(), static_cast<uint32_t>(SEGV_MAPERR));
+  EXPECT_EQ(exception->ExceptionAddress(), 0x1000u);
+
+  std::vector<const ThreadSnapshot*> threads = snapshot.Threads();
+  ASSERT_EQ(threads.size(), 1u);
+  EXPECT_EQ(threads[0]->ThreadID(), static_cast<uint64_t>(tid));
+
+  const CPUContext* cpu_context = threads[0]->Context();
+  ASSERT_TRUE(cpu_context);
+#if defined(ARCH_CPU_X86_64)
+  const uint64_t stack_pointer = cpu_context->x86_64->rsp;
+#elif defined(ARCH_CPU_X86)
+  const uint64_t stack_pointer = cpu_context->x86->esp;
+#endif
+
+  // getcontext() was called from this function, so the captured stack begins
+  // at or below this frame’s locals.
+  const MemorySnapshot* stack = threads[0]->Stack();
+  ASSERT_TRUE(stack);
+  EXPECT_LE(stack->Address(), stack_pointer);
+  EXPECT_GT(stack->Address() + stack->Size(), stack_pointer);
+  EXPECT_LE(stack->Address(), FromPointerCast<uint64_t>(&context));
+  EXPECT_GT(stack->Address() + stack->Size(),
+            FromPointerCast<uint64_t>(&context));
+
+  // The test executable is among the modules, and contains this code.
+  const base::FilePath executable = TestPaths::Executable();
+  const uint64_t code_address = FromPointerCast<uint64_t>(&CodeInExecutable);
+  bool found_executable = false;
+  for (const ModuleSnapshot* module : snapshot.Modules()) {
+    if (module->Name() == executable.value()) {
+      found_executable = true;
+      EXPECT_LE(module->Address(), code_address);
+      EXPECT_GT(module->Address() + module->Size(), code_address);
+      EXPECT_EQ(module->DebugFileName(), executable.BaseName().value());
+    }
+  }
+  EXPECT_TRUE(found_executable);
+}
+
+TEST(FallbackMinidumpWriter, ArenaTooSmall) {
+  ScopedTempDir temp_dir;
+  FallbackMinidumpWriter writer;
+  EXPECT_FALSE(writer.Initialize(
+      temp_dir.path().Append(FILE_PATH_LITERAL("minidump")), 16));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
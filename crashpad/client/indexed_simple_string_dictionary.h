@@ -0,0 +1,393 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_CLIENT_INDEXED_SIMPLE_STRING_DICTIONARY_H_
+#define CRASHPAD_CLIENT_INDEXED_SIMPLE_STRING_DICTIONARY_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <string>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+#include "client/simple_string_dictionary.h"
+
+namespace crashpad {
+
+namespace internal {
+
+//! \brief Returns the smallest power of two that is at least twice \a
+//!     num_entries, the size of a TIndexedSimpleStringDictionary’s index.
+constexpr size_t IndexedStringDictionaryIndexSize(size_t num_entries,
+                                                  size_t size = 1) {
+  return size >= 2 * num_entries
+             ? size
+             : IndexedStringDictionaryIndexSize(num_entries, size * 2);
+}
+
+}  // namespace internal
+
+//! \brief A TSimpleStringDictionary with a hash index, for dictionaries whose
+//!     values are updated frequently and from multiple threads.
+//!
+//! The entries are held in a TSimpleStringDictionary, available from
+//! dictionary(), whose layout is unchanged. That object is what should be
+//! given to CrashpadInfo::set_simple_annotations(), and it is read
+//! out-of-process exactly as any other SimpleStringDictionary is. Once it is
+//! owned by this object, it must only be modified through this object.
+//!
+//! Alongside the entries, an open-addressed index of 32-bit slots maps a hash
+//! of each key to its entry, so that a lookup usually examines a single key
+//! rather than all \a NumEntries of them. The index is not visible to readers
+//! of dictionary().
+//!
+//! Each entry is guarded by a sequence counter. Updating the value of a key
+//! that is already present and reading a value with GetValueForKey() do not
+//! take any lock shared with other keys: writers of the same entry exclude one
+//! another briefly, and readers retry if they observe a concurrent write.
+//! Adding and removing keys is serialized by a spin lock, and is expected to
+//! be much less frequent than updating values.
+//!
+//! Unlike TSimpleStringDictionary, this class is not POD, and cannot be copied.
+template <size_t KeySize = 256, size_t ValueSize = 256, size_t NumEntries = 64>
+class TIndexedSimpleStringDictionary {
+ public:
+  using Dictionary = TSimpleStringDictionary<KeySize, ValueSize, NumEntries>;
+  using Entry = typename Dictionary::Entry;
+
+  //! \brief Constant and publicly accessible versions of the template
+  //!     parameters.
+  //! \{
+  static const size_t key_size = KeySize;
+  static const size_t value_size = ValueSize;
+  static const size_t num_entries = NumEntries;
+  //! \}
+
+  TIndexedSimpleStringDictionary()
+      : dictionary_(),
+        index_(),
+        sequences_(),
+        count_(0),
+        lock_(false) {
+  }
+
+  //! \brief Returns the entries, for registration with
+  //!     CrashpadInfo::set_simple_annotations() and for iteration.
+  //!
+  //! Values observed through the returned object are not protected against
+  //! concurrent writers.
+  Dictionary* dictionary() { return &dictionary_; }
+
+  //! \brief Returns the number of active key/value pairs. The upper limit for
+  //!     this is \a NumEntries.
+  size_t GetCount() const { return count_.load(std::memory_order_relaxed); }
+
+  //! \brief Given \a key, copies its corresponding value to \a value.
+  //!
+  //! \param[in] key The key to look up. This must not be `nullptr`, nor an
+  //!     empty string. It must not contain embedded `NUL`s.
+  //! \param[out] value The value corresponding to \a key, read consistently
+  //!     with respect to concurrent writers.
+  //!
+  //! \return `true` if \a key was found, `false` otherwise.
+  bool GetValueForKey(base::StringPiece key, std::string* value) const {
+    DCHECK(key.data());
+    DCHECK(key.size());
+    DCHECK_EQ(key.find('\0', 0), base::StringPiece::npos);
+    if (!key.data() || !key.size()) {
+      return false;
+    }
+
+    const uint32_t hash = Hash(key);
+    char buffer[ValueSize];
+    while (true) {
+      const size_t slot = FindSlot(key, hash);
+      if (slot == kNotFound) {
+        return false;
+      }
+      const size_t entry_index = SlotEntryIndex(LoadSlot(slot));
+
+      // A concurrent writer may change the value, or a concurrent RemoveKey()
+      // may give the entry to another key. Retry the lookup unless the key and
+      // value were both read without either happening.
+      const uint32_t sequence =
+          sequences_[entry_index].load(std::memory_order_acquire);
+      if (sequence & 1) {
+        continue;
+      }
+      const Entry& entry = dictionary_.entries_[entry_index];
+      const bool key_equals = Dictionary::EntryKeyEquals(key, entry);
+      if (key_equals) {
+        memcpy(buffer, entry.value, sizeof(buffer));
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequences_[entry_index].load(std::memory_order_relaxed) !=
+          sequence) {
+        continue;
+      }
+      if (key_equals) {
+        buffer[sizeof(buffer) - 1] = '\0';
+        value->assign(buffer);
+        return true;
+      }
+    }
+  }
+
+  //! \brief Stores \a value into \a key, replacing the existing value if \a key
+  //!     is already present.
+  //!
+  //! If \a key is not yet in the map and the map is already full (containing
+  //! \a NumEntries active entries), this operation silently fails.
+  //!
+  //! \param[in] key The key to store. This must not be `nullptr`, nor an empty
+  //!     string. It must not contain embedded `NUL`s.
+  //! \param[in] value The value to store. If `nullptr`, \a key is removed from
+  //!     the map. Must not contain embedded `NUL`s.
+  void SetKeyValue(base::StringPiece key, base::StringPiece value) {
+    if (!value.data()) {
+      RemoveKey(key);
+      return;
+    }
+
+    DCHECK(key.data());
+    DCHECK(key.size());
+    DCHECK_EQ(key.find('\0', 0), base::StringPiece::npos);
+    if (!key.data() || !key.size()) {
+      return;
+    }
+
+    // |value| must not contain embedded NULs.
+    DCHECK_EQ(value.find('\0', 0), base::StringPiece::npos);
+
+    const uint32_t hash = Hash(key);
+
+    // Without taking the structural lock, update the value in place if the key
+    // is already present.
+    while (true) {
+      const size_t slot = FindSlot(key, hash);
+      if (slot == kNotFound) {
+        break;
+      }
+      if (SetValueIfKeyEquals(SlotEntryIndex(LoadSlot(slot)), key, value)) {
+        return;
+      }
+    }
+
+    LockStructure();
+
+    // Another writer may have inserted the key since it was looked up above.
+    // No entry can change keys while the structural lock is held.
+    size_t slot = FindSlot(key, hash);
+    if (slot != kNotFound) {
+      bool set =
+          SetValueIfKeyEquals(SlotEntryIndex(LoadSlot(slot)), key, value);
+      DCHECK(set);
+      UnlockStructure();
+      return;
+    }
+
+    size_t entry_index = 0;
+    while (entry_index < num_entries &&
+           dictionary_.entries_[entry_index].is_active()) {
+      ++entry_index;
+    }
+    if (entry_index == num_entries) {
+      // The map is out of space.
+      UnlockStructure();
+      return;
+    }
+
+    LockEntry(entry_index);
+    Entry* entry = &dictionary_.entries_[entry_index];
+    Dictionary::SetFromStringPiece(key, entry->key, key_size);
+    Dictionary::SetFromStringPiece(value, entry->value, value_size);
+    UnlockEntry(entry_index);
+
+    // Publish the entry only once its key has been written, so that lock-free
+    // lookups that find it through the index can compare it.
+    index_[FindInsertionSlot(hash)].store(
+        MakeSlot(hash, entry_index), std::memory_order_release);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    UnlockStructure();
+  }
+
+  //! \brief Removes \a key from the map.
+  //!
+  //! If \a key is not found, this is a no-op.
+  //!
+  //! \param[in] key The key of the entry to remove. This must not be `nullptr`,
+  //!     nor an empty string. It must not contain embedded `NUL`s.
+  void RemoveKey(base::StringPiece key) {
+    DCHECK(key.data());
+    DCHECK(key.size());
+    DCHECK_EQ(key.find('\0', 0), base::StringPiece::npos);
+    if (!key.data() || !key.size()) {
+      return;
+    }
+
+    LockStructure();
+
+    const size_t slot = FindSlot(key, Hash(key));
+    if (slot != kNotFound) {
+      const size_t entry_index = SlotEntryIndex(LoadSlot(slot));
+      index_[slot].store(kTombstoneSlot, std::memory_order_release);
+
+      LockEntry(entry_index);
+      Entry* entry = &dictionary_.entries_[entry_index];
+      entry->key[0] = '\0';
+      entry->value[0] = '\0';
+      UnlockEntry(entry_index);
+
+      count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    UnlockStructure();
+  }
+
+ private:
+  // The number of slots in |index_|, which is a power of two so that probes
+  // can wrap with a mask.
+  static constexpr size_t kIndexSize =
+      internal::IndexedStringDictionaryIndexSize(NumEntries);
+
+  // The low 16 bits of a slot hold one more than the index of the entry that
+  // the slot refers to, or one of the special values below. The high 16 bits
+  // hold the high 16 bits of the key’s hash, so that most mismatched slots
+  // can be skipped without examining their entries’ keys.
+  static constexpr uint32_t kEmptySlot = 0;
+  static constexpr uint32_t kTombstoneSlot = 0xffff;
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  static_assert(NumEntries < kTombstoneSlot, "NumEntries too large");
+
+  // FNV-1a.
+  static uint32_t Hash(base::StringPiece key) {
+    uint32_t hash = 2166136261u;
+    for (size_t index = 0; index < key.size(); ++index) {
+      hash ^= static_cast<unsigned char>(key[index]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  static uint32_t MakeSlot(uint32_t hash, size_t entry_index) {
+    return (hash & 0xffff0000) | static_cast<uint32_t>(entry_index + 1);
+  }
+
+  static bool SlotRefersToEntry(uint32_t slot) {
+    return (slot & 0xffff) != kEmptySlot && (slot & 0xffff) != kTombstoneSlot;
+  }
+
+  static size_t SlotEntryIndex(uint32_t slot) { return (slot & 0xffff) - 1; }
+
+  uint32_t LoadSlot(size_t slot) const {
+    return index_[slot].load(std::memory_order_acquire);
+  }
+
+  // Returns the index of the slot referring to the entry for |key|, or
+  // kNotFound. Without the structural lock, the entry’s key may be changing, so
+  // the caller must verify it while holding or observing the entry’s sequence
+  // counter.
+  size_t FindSlot(base::StringPiece key, uint32_t hash) const {
+    for (size_t probe = 0; probe < kIndexSize; ++probe) {
+      const size_t slot = (hash + probe) & (kIndexSize - 1);
+      const uint32_t contents = LoadSlot(slot);
+      if (contents == kEmptySlot) {
+        return kNotFound;
+      }
+      if (SlotRefersToEntry(contents) &&
+          (contents & 0xffff0000) == (hash & 0xffff0000) &&
+          Dictionary::EntryKeyEquals(
+              key, dictionary_.entries_[SlotEntryIndex(contents)])) {
+        return slot;
+      }
+    }
+    return kNotFound;
+  }
+
+  // Returns the first reusable slot along |hash|’s probe sequence. Called with
+  // the structural lock held, after the key was found to be absent. There are
+  // more slots than entries, so one is always available.
+  size_t FindInsertionSlot(uint32_t hash) const {
+    for (size_t probe = 0; probe < kIndexSize; ++probe) {
+      const size_t slot = (hash + probe) & (kIndexSize - 1);
+      if (!SlotRefersToEntry(LoadSlot(slot))) {
+        return slot;
+      }
+    }
+    NOTREACHED();
+    return 0;
+  }
+
+  // Sets the value of the entry at |entry_index| to |value| if its key is
+  // |key|, returning whether it did.
+  bool SetValueIfKeyEquals(size_t entry_index,
+                           base::StringPiece key,
+                           base::StringPiece value) {
+    LockEntry(entry_index);
+    Entry* entry = &dictionary_.entries_[entry_index];
+    const bool key_equals = Dictionary::EntryKeyEquals(key, *entry);
+    if (key_equals) {
+      Dictionary::SetFromStringPiece(value, entry->value, value_size);
+    }
+    UnlockEntry(entry_index);
+    return key_equals;
+  }
+
+  // An entry is being written while its sequence counter is odd.
+  void LockEntry(size_t entry_index) {
+    std::atomic<uint32_t>& sequence = sequences_[entry_index];
+    uint32_t expected = sequence.load(std::memory_order_relaxed);
+    while ((expected & 1) ||
+           !sequence.compare_exchange_weak(
+               expected, expected + 1, std::memory_order_acquire)) {
+      expected = sequence.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void UnlockEntry(size_t entry_index) {
+    sequences_[entry_index].fetch_add(1, std::memory_order_release);
+  }
+
+  void LockStructure() {
+    while (lock_.exchange(true, std::memory_order_acquire)) {
+    }
+  }
+
+  void UnlockStructure() { lock_.store(false, std::memory_order_release); }
+
+  Dictionary dictionary_;
+  std::atomic<uint32_t> index_[kIndexSize];
+  std::atomic<uint32_t> sequences_[NumEntries];
+  std::atomic<size_t> count_;
+  std::atomic<bool> lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(TIndexedSimpleStringDictionary);
+};
+
+//! \brief A TIndexedSimpleStringDictionary with the same parameters as
+//!     SimpleStringDictionary, whose dictionary() may be given to
+//!     CrashpadInfo::set_simple_annotations().
+using IndexedSimpleStringDictionary =
+    TIndexedSimpleStringDictionary<256, 256, 64>;
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_CLIENT_INDEXED_SIMPLE_STRING_DICTIONARY_H_
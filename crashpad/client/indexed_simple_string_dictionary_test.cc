@@ -0,0 +1,215 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/indexed_simple_string_dictionary.h"
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(IndexedSimpleStringDictionary, SetGetRemove) {
+  TIndexedSimpleStringDictionary<10, 10, 10> map;
+  std::string value;
+
+  map.SetKeyValue("one", "a");
+  map.SetKeyValue("two", "b");
+  map.SetKeyValue("three", "c");
+  EXPECT_EQ(map.GetCount(), 3u);
+  ASSERT_TRUE(map.GetValueForKey("one", &value));
+  EXPECT_EQ(value, "a");
+  ASSERT_TRUE(map.GetValueForKey("two", &value));
+  EXPECT_EQ(value, "b");
+  EXPECT_FALSE(map.GetValueForKey("four", &value));
+
+  map.SetKeyValue("two", "bb");
+  EXPECT_EQ(map.GetCount(), 3u);
+  ASSERT_TRUE(map.GetValueForKey("two", &value));
+  EXPECT_EQ(value, "bb");
+
+  // Values are truncated to fit, as in TSimpleStringDictionary.
+  map.SetKeyValue("one", "0123456789abc");
+  ASSERT_TRUE(map.GetValueForKey("one", &value));
+  EXPECT_EQ(value, "012345678");
+
+  map.RemoveKey("two");
+  EXPECT_EQ(map.GetCount(), 2u);
+  EXPECT_FALSE(map.GetValueForKey("two", &value));
+
+  map.SetKeyValue("three", nullptr);
+  EXPECT_EQ(map.GetCount(), 1u);
+  EXPECT_FALSE(map.GetValueForKey("three", &value));
+
+  // Removing a missing key is a no-op.
+  map.RemoveKey("three");
+  EXPECT_EQ(map.GetCount(), 1u);
+}
+
+TEST(IndexedSimpleStringDictionary, Dictionary) {
+  // The entries must be visible through dictionary(), which is what is read
+  // out-of-process.
+  IndexedSimpleStringDictionary map;
+  map.SetKeyValue("key1", "value1");
+  map.SetKeyValue("key2", "value2");
+  map.SetKeyValue("key1", "value3");
+  map.RemoveKey("key2");
+
+  SimpleStringDictionary* dictionary = map.dictionary();
+  EXPECT_EQ(static_cast<void*>(dictionary), static_cast<void*>(&map));
+  EXPECT_EQ(dictionary->GetCount(), 1u);
+  EXPECT_STREQ(dictionary->GetValueForKey("key1"), "value3");
+  EXPECT_FALSE(dictionary->GetValueForKey("key2"));
+
+  SimpleStringDictionary::Iterator iterator(*dictionary);
+  const SimpleStringDictionary::Entry* entry = iterator.Next();
+  ASSERT_TRUE(entry);
+  EXPECT_STREQ(entry->key, "key1");
+  EXPECT_STREQ(entry->value, "value3");
+  EXPECT_FALSE(iterator.Next());
+}
+
+TEST(IndexedSimpleStringDictionary, Full) {
+  using TestMap = TIndexedSimpleStringDictionary<10, 10, 4>;
+  TestMap map;
+  char key[TestMap::key_size];
+  std::string value;
+
+  constexpr size_t kCapacity = TestMap::num_entries;
+  for (size_t index = 0; index < kCapacity; ++index) {
+    snprintf(key, sizeof(key), "key%zu", index);
+    map.SetKeyValue(key, "value");
+  }
+  EXPECT_EQ(map.GetCount(), kCapacity);
+
+  // A new key does not fit, but an existing value may still change.
+  map.SetKeyValue("extra", "value");
+  EXPECT_EQ(map.GetCount(), kCapacity);
+  EXPECT_FALSE(map.GetValueForKey("extra", &value));
+  map.SetKeyValue("key0", "changed");
+  ASSERT_TRUE(map.GetValueForKey("key0", &value));
+  EXPECT_EQ(value, "changed");
+
+  map.RemoveKey("key1");
+  map.SetKeyValue("extra", "value");
+  EXPECT_EQ(map.GetCount(), kCapacity);
+  EXPECT_TRUE(map.GetValueForKey("extra", &value));
+  EXPECT_FALSE(map.GetValueForKey("key1", &value));
+}
+
+TEST(IndexedSimpleStringDictionary, Churn) {
+  // Repeatedly adding and removing distinct keys leaves removed slots in the
+  // index, which must be reused.
+  using TestMap = TIndexedSimpleStringDictionary<16, 16, 8>;
+  TestMap map;
+  char key[TestMap::key_size];
+  std::string value;
+
+  map.SetKeyValue("fixed", "value");
+  for (int index = 0; index < 1000; ++index) {
+    snprintf(key, sizeof(key), "key%d", index);
+    map.SetKeyValue(key, key);
+    ASSERT_TRUE(map.GetValueForKey(key, &value));
+    EXPECT_EQ(value, key);
+    map.RemoveKey(key);
+    EXPECT_FALSE(map.GetValueForKey(key, &value));
+  }
+
+  EXPECT_EQ(map.GetCount(), 1u);
+  ASSERT_TRUE(map.GetValueForKey("fixed", &value));
+  EXPECT_EQ(value, "value");
+}
+
+constexpr int kValueLength = 32;
+constexpr int kIterations = 10000;
+
+// Repeatedly sets |key_| to values made of a single repeated character, and
+// checks that its own values and those of |other_key_| are never torn.
+class UpdateThread : public Thread {
+ public:
+  UpdateThread(IndexedSimpleStringDictionary* map,
+               const char* key,
+               const char* other_key,
+               char character)
+      : Thread(),
+        map_(map),
+        key_(key),
+        other_key_(other_key),
+        character_(character),
+        torn_reads_(0) {}
+  ~UpdateThread() override {}
+
+  int torn_reads() const { return torn_reads_; }
+
+ private:
+  void ThreadMain() override {
+    std::string value;
+    for (int iteration = 0; iteration < kIterations; ++iteration) {
+      map_->SetKeyValue(
+          key_,
+          std::string(kValueLength, character_ + iteration % 2).c_str());
+      if (map_->GetValueForKey(other_key_, &value) &&
+          (value.size() != static_cast<size_t>(kValueLength) ||
+           value.find_first_not_of(value[0]) != std::string::npos)) {
+        ++torn_reads_;
+      }
+    }
+  }
+
+  IndexedSimpleStringDictionary* map_;  // weak
+  const char* key_;
+  const char* other_key_;
+  char character_;
+  int torn_reads_;
+
+  DISALLOW_COPY_AND_ASSIGN(UpdateThread);
+};
+
+TEST(IndexedSimpleStringDictionary, ConcurrentUpdates) {
+  // The maps are large, so allocate them on the heap.
+  std::unique_ptr<IndexedSimpleStringDictionary> map(
+      new IndexedSimpleStringDictionary());
+  map->SetKeyValue("shared", std::string(kValueLength, 'a').c_str());
+
+  // Two threads write the same key, and two others a key of their own, while
+  // all of them read the shared key.
+  UpdateThread threads[] = {
+      {map.get(), "shared", "shared", 'a'},
+      {map.get(), "shared", "shared", 'c'},
+      {map.get(), "first", "shared", 'e'},
+      {map.get(), "second", "shared", 'g'},
+  };
+  for (UpdateThread& thread : threads) {
+    thread.Start();
+  }
+  for (UpdateThread& thread : threads) {
+    thread.Join();
+    EXPECT_EQ(thread.torn_reads(), 0);
+  }
+
+  EXPECT_EQ(map->GetCount(), 3u);
+  std::string value;
+  EXPECT_TRUE(map->GetValueForKey("first", &value));
+  EXPECT_TRUE(map->GetValueForKey("second", &value));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,249 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/module_table.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/synchronization/lock.h"
+#include "build/build_config.h"
+#include "client/crashpad_info.h"
+#include "util/misc/from_pointer_cast.h"
+
+#if defined(OS_WIN)
+#include <windows.h>
+
+#include "util/win/get_function.h"
+#include "util/win/get_module_information.h"
+#include "util/win/nt_internals.h"
+#include "util/win/ntstatus_logging.h"
+#endif  // OS_WIN
+
+namespace crashpad {
+
+namespace {
+
+// Serializes modifications to every ModuleTable. The lock isn’t a member so
+// that it doesn’t become part of the layout read by the handler.
+base::Lock* GetModificationLock() {
+  static base::Lock* lock = new base::Lock();
+  return lock;
+}
+
+#if defined(OS_WIN)
+
+uint32_t ImageTimestamp(const void* image) {
+  const IMAGE_DOS_HEADER* dos_header =
+      reinterpret_cast<const IMAGE_DOS_HEADER*>(image);
+  const IMAGE_NT_HEADERS* nt_headers =
+      reinterpret_cast<const IMAGE_NT_HEADERS*>(
+          reinterpret_cast<const char*>(image) + dos_header->e_lfanew);
+  return nt_headers->FileHeader.TimeDateStamp;
+}
+
+VOID CALLBACK DllNotification(
+    ULONG notification_reason,
+    const LDR_DLL_NOTIFICATION_DATA* notification_data,
+    PVOID context) {
+  ModuleTable* table = reinterpret_cast<ModuleTable*>(context);
+  switch (notification_reason) {
+    case LDR_DLL_NOTIFICATION_REASON_LOADED: {
+      const LDR_DLL_LOADED_NOTIFICATION_DATA& loaded =
+          notification_data->Loaded;
+      table->Add(FromPointerCast<uint64_t>(loaded.DllBase),
+                 loaded.SizeOfImage,
+                 ImageTimestamp(loaded.DllBase),
+                 loaded.FullDllName->Buffer,
+                 loaded.FullDllName->Length);
+      break;
+    }
+
+    case LDR_DLL_NOTIFICATION_REASON_UNLOADED:
+      table->Remove(
+          FromPointerCast<uint64_t>(notification_data->Unloaded.DllBase));
+      break;
+  }
+}
+
+// Registers for notifications first, and then records the modules that were
+// already loaded, so that none is missed. A module loaded in between is
+// reported by both, and ModuleTable::Add() ignores the duplicate.
+bool Populate(ModuleTable* table) {
+  PVOID cookie;
+  NTSTATUS status =
+      LdrRegisterDllNotification(0, &DllNotification, table, &cookie);
+  if (!NT_SUCCESS(status)) {
+    NTSTATUS_LOG(ERROR, status) << "LdrRegisterDllNotification";
+    return false;
+  }
+
+  static const auto enum_process_modules =
+      GET_FUNCTION_REQUIRED(L"psapi.dll", ::EnumProcessModules);
+  std::vector<HMODULE> modules(256);
+  DWORD bytes_needed;
+  for (;;) {
+    const DWORD bytes = static_cast<DWORD>(modules.size() * sizeof(modules[0]));
+    if (!enum_process_modules(
+            GetCurrentProcess(), &modules[0], bytes, &bytes_needed)) {
+      PLOG(ERROR) << "EnumProcessModules";
+      return false;
+    }
+    if (bytes_needed <= bytes) {
+      break;
+    }
+    modules.resize(bytes_needed / sizeof(modules[0]));
+  }
+  modules.resize(bytes_needed / sizeof(modules[0]));
+
+  wchar_t name[MAX_PATH];
+  for (HMODULE module : modules) {
+    MODULEINFO module_info;
+    if (!CrashpadGetModuleInformation(
+            GetCurrentProcess(), module, &module_info, sizeof(module_info))) {
+      continue;
+    }
+    DWORD name_length = GetModuleFileNameW(module, name, arraysize(name));
+    if (name_length == 0) {
+      continue;
+    }
+    table->Add(FromPointerCast<uint64_t>(module_info.lpBaseOfDll),
+               module_info.SizeOfImage,
+               ImageTimestamp(module_info.lpBaseOfDll),
+               name,
+               name_length * sizeof(name[0]));
+  }
+
+  return true;
+}
+
+#endif  // OS_WIN
+
+char* EntryName(const ModuleTableEntry& entry) {
+  return reinterpret_cast<char*>(static_cast<uintptr_t>(entry.name_address));
+}
+
+}  // namespace
+
+// static
+ModuleTable* ModuleTable::GetInstance() {
+#if defined(OS_WIN)
+  static ModuleTable* table = []() -> ModuleTable* {
+    auto table = new ModuleTable();
+    if (!Populate(table)) {
+      // The table may already be registered for notifications, so it can’t be
+      // deleted.
+      return nullptr;
+    }
+    CrashpadInfo::GetCrashpadInfo()->set_module_table(table);
+    return table;
+  }();
+  return table;
+#else
+  return nullptr;
+#endif
+}
+
+ModuleTable::ModuleTable()
+    : version_(kVersion),
+      generation_(0),
+      count_(0),
+      flags_(0),
+      entries_address_(0),
+      entries_(new ModuleTableEntry[kCapacity]()) {
+  static_assert(std::is_standard_layout<ModuleTable>::value,
+                "ModuleTable must be standard layout");
+  static_assert(offsetof(ModuleTable, generation_) ==
+                    offsetof(ModuleTableHeader, generation),
+                "generation_ offset");
+  static_assert(offsetof(ModuleTable, entries_address_) ==
+                    offsetof(ModuleTableHeader, entries_address),
+                "entries_address_ offset");
+  entries_address_ = FromPointerCast<uint64_t>(entries_);
+}
+
+ModuleTable::~ModuleTable() {
+  for (size_t index = 0; index < count_; ++index) {
+    delete[] EntryName(entries_[index]);
+  }
+  delete[] entries_;
+}
+
+bool ModuleTable::Add(uint64_t base_address,
+                      uint64_t size,
+                      uint32_t timestamp,
+                      const void* name,
+                      size_t name_size) {
+  base::AutoLock lock(*GetModificationLock());
+
+  for (size_t index = 0; index < count_; ++index) {
+    if (entries_[index].base_address == base_address) {
+      return true;
+    }
+  }
+
+  char* name_copy = nullptr;
+  if (count_ < kCapacity) {
+    name_size = std::min(name_size, size_t{UINT32_MAX});
+    name_copy = new char[name_size];
+    if (name_size) {
+      memcpy(name_copy, name, name_size);
+    }
+  }
+
+  generation_.fetch_add(1, std::memory_order_acq_rel);
+  if (name_copy) {
+    ModuleTableEntry& entry = entries_[count_];
+    entry.base_address = base_address;
+    entry.size = size;
+    entry.name_address = FromPointerCast<uint64_t>(name_copy);
+    entry.name_size = static_cast<uint32_t>(name_size);
+    entry.timestamp = timestamp;
+    ++count_;
+  } else {
+    flags_ |= kFlagOverflowed;
+  }
+  generation_.fetch_add(1, std::memory_order_release);
+
+  return name_copy != nullptr;
+}
+
+void ModuleTable::Remove(uint64_t base_address) {
+  base::AutoLock lock(*GetModificationLock());
+
+  for (size_t index = 0; index < count_; ++index) {
+    if (entries_[index].base_address != base_address) {
+      continue;
+    }
+
+    char* name = EntryName(entries_[index]);
+
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    memmove(&entries_[index],
+            &entries_[index + 1],
+            (count_ - index - 1) * sizeof(entries_[0]));
+    --count_;
+    generation_.fetch_add(1, std::memory_order_release);
+
+    delete[] name;
+    return;
+  }
+}
+
+}  // namespace crashpad
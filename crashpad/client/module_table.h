@@ -0,0 +1,179 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_CLIENT_MODULE_TABLE_H_
+#define CRASHPAD_CLIENT_MODULE_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "base/macros.h"
+
+namespace crashpad {
+
+//! \brief A module recorded in a ModuleTable.
+//!
+//! All fields are fixed-width so that the handler can read this structure
+//! from a process of either bitness.
+struct ModuleTableEntry {
+  //! \brief The address at which the module is loaded.
+  uint64_t base_address;
+
+  //! \brief The size of the module’s image in memory.
+  uint64_t size;
+
+  //! \brief The address of the module’s pathname, owned by the ModuleTable.
+  //!
+  //! The pathname is in the loader’s native encoding: UTF-16 on Windows, and
+  //! UTF-8 elsewhere. It is not NUL-terminated.
+  uint64_t name_address;
+
+  //! \brief The size of the pathname at #name_address, in bytes.
+  uint32_t name_size;
+
+  //! \brief The module’s link timestamp, if the loader records one, or `0`.
+  uint32_t timestamp;
+};
+
+//! \brief The layout of a ModuleTable, as read by the handler.
+struct ModuleTableHeader {
+  //! \brief ModuleTable::kVersion.
+  uint32_t version;
+
+  //! \brief A counter that is odd while the table is being modified, and is
+  //!     advanced by two for each completed modification.
+  uint32_t generation;
+
+  //! \brief The number of entries in use at #entries_address.
+  uint32_t count;
+
+  //! \brief A bitwise combination of ModuleTable::Flags values.
+  uint32_t flags;
+
+  //! \brief The address of an array of ModuleTable::kCapacity ModuleTableEntry
+  //!     structures, the first #count of which are in use, in load order.
+  uint64_t entries_address;
+};
+
+//! \brief A compact table of the modules loaded in the process, kept current
+//!     by the loader’s own notifications and registered with CrashpadInfo so
+//!     that the Crashpad handler can read it out-of-process.
+//!
+//! Without this table, the handler discovers modules by walking the loader’s
+//! own data structures, which costs at least one read from the target process
+//! per module. The table can instead be read in a single read of its header
+//! and a single read of its entries, followed by one batch of reads for the
+//! modules’ names.
+//!
+//! Modifications are serialized by a lock, and bracketed by advancing
+//! #ModuleTableHeader::generation, so that a handler that finds the table in
+//! the middle of a modification can recognize that it is inconsistent and fall
+//! back to walking the loader’s structures. The table has a fixed capacity. If
+//! more modules are loaded than it can hold, it is marked as overflowed and
+//! the handler ignores it.
+//!
+//! The layout of this class is that of ModuleTableHeader, and must be kept in
+//! sync with the readers in `snapshot/win/process_reader_win.cc`.
+class ModuleTable {
+ public:
+  enum : uint32_t {
+    //! \brief The version of the table’s layout.
+    kVersion = 1,
+  };
+
+  enum : size_t {
+    //! \brief The number of entries that the table can hold.
+    kCapacity = 1024,
+  };
+
+  //! \brief Values for #ModuleTableHeader::flags.
+  enum Flags : uint32_t {
+    //! \brief More modules were loaded than the table can hold, and the table
+    //!     is incomplete.
+    kFlagOverflowed = 1 << 0,
+  };
+
+  //! \brief Returns the ModuleTable for the process, creating it if necessary.
+  //!
+  //! The first call populates the table with the modules already loaded,
+  //! registers for the loader’s notifications of modules loaded and unloaded
+  //! afterwards, and registers the table with the calling module’s
+  //! CrashpadInfo structure. Calling this is optional. Handlers that don’t find
+  //! a table, or don’t understand CrashpadInfo version 5, walk the loader’s
+  //! structures as before.
+  //!
+  //! The table is never destroyed.
+  //!
+  //! \return The table, or `nullptr` if the loader offers no notifications on
+  //!     this platform. This is currently only supported on Windows.
+  static ModuleTable* GetInstance();
+
+  ModuleTable();
+  ~ModuleTable();
+
+  //! \brief Records a loaded module.
+  //!
+  //! \param[in] base_address The address at which the module is loaded. If a
+  //!     module at this address is already recorded, this method does
+  //!     nothing.
+  //! \param[in] size The size of the module’s image in memory.
+  //! \param[in] timestamp The module’s link timestamp, or `0`.
+  //! \param[in] name The module’s pathname. This is copied into the table.
+  //! \param[in] name_size The size of \a name, in bytes.
+  //!
+  //! \return `true` if the module is recorded. `false` if the table is full,
+  //!     in which case it is marked as overflowed.
+  bool Add(uint64_t base_address,
+           uint64_t size,
+           uint32_t timestamp,
+           const void* name,
+           size_t name_size);
+
+  //! \brief Removes the module at \a base_address from the table, if it is
+  //!     recorded.
+  void Remove(uint64_t base_address);
+
+  //! \brief Returns the number of modules recorded.
+  size_t count() const { return count_; }
+
+  //! \brief Returns the recorded modules, in load order.
+  const ModuleTableEntry* entries() const { return entries_; }
+
+  //! \brief Returns the current #ModuleTableHeader::generation.
+  uint32_t generation() const {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+  //! \brief Returns the current #ModuleTableHeader::flags.
+  uint32_t flags() const { return flags_; }
+
+ private:
+  // The members up to and including entries_address_ are read by the
+  // handler. They are laid out as in ModuleTableHeader.
+  uint32_t version_;
+  std::atomic<uint32_t> generation_;
+  uint32_t count_;
+  uint32_t flags_;
+  uint64_t entries_address_;
+
+  ModuleTableEntry* entries_;  // owned, kCapacity elements
+
+  DISALLOW_COPY_AND_ASSIGN(ModuleTable);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_CLIENT_MODULE_TABLE_H_
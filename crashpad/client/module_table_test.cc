@@ -0,0 +1,152 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/module_table.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+#include "build/build_config.h"
+#include "client/crashpad_info.h"
+#include "gtest/gtest.h"
+#include "test/errors.h"
+#include "util/misc/from_pointer_cast.h"
+
+#if defined(OS_WIN)
+#include <windows.h>
+#endif  // OS_WIN
+
+namespace crashpad {
+namespace test {
+namespace {
+
+std::string EntryName(const ModuleTableEntry& entry) {
+  return std::string(
+      reinterpret_cast<const char*>(static_cast<uintptr_t>(entry.name_address)),
+      entry.name_size);
+}
+
+bool AddNamed(ModuleTable* table, uint64_t base_address, const char* name) {
+  return table->Add(base_address, 0x1000, 0, name, strlen(name));
+}
+
+TEST(ModuleTable, AddRemove) {
+  ModuleTable table;
+  EXPECT_EQ(table.count(), 0u);
+  EXPECT_EQ(table.generation(), 0u);
+  EXPECT_EQ(table.flags(), 0u);
+
+  std::string name("/lib/one");
+  ASSERT_TRUE(table.Add(0x10000, 0x2000, 0x5a5a, name.data(), name.size()));
+  name.assign("changed");
+  ASSERT_TRUE(AddNamed(&table, 0x20000, "/lib/two"));
+  ASSERT_TRUE(AddNamed(&table, 0x30000, "/lib/three"));
+  ASSERT_EQ(table.count(), 3u);
+  EXPECT_EQ(table.generation(), 6u);
+
+  // The name was copied into the table.
+  const ModuleTableEntry* entries = table.entries();
+  EXPECT_EQ(entries[0].base_address, 0x10000u);
+  EXPECT_EQ(entries[0].size, 0x2000u);
+  EXPECT_EQ(entries[0].timestamp, 0x5a5au);
+  EXPECT_EQ(EntryName(entries[0]), "/lib/one");
+  EXPECT_EQ(EntryName(entries[1]), "/lib/two");
+  EXPECT_EQ(EntryName(entries[2]), "/lib/three");
+
+  // A module already recorded isn’t recorded again.
+  EXPECT_TRUE(AddNamed(&table, 0x20000, "/lib/two"));
+  EXPECT_EQ(table.count(), 3u);
+  EXPECT_EQ(table.generation(), 6u);
+
+  // Removal keeps the remaining modules in load order.
+  table.Remove(0x20000);
+  ASSERT_EQ(table.count(), 2u);
+  EXPECT_EQ(table.generation(), 8u);
+  EXPECT_EQ(EntryName(entries[0]), "/lib/one");
+  EXPECT_EQ(EntryName(entries[1]), "/lib/three");
+
+  // Removing a module that isn’t recorded doesn’t modify the table.
+  table.Remove(0x20000);
+  EXPECT_EQ(table.count(), 2u);
+  EXPECT_EQ(table.generation(), 8u);
+
+  ASSERT_TRUE(AddNamed(&table, 0x20000, "/lib/two again"));
+  ASSERT_EQ(table.count(), 3u);
+  EXPECT_EQ(EntryName(entries[2]), "/lib/two again");
+  EXPECT_EQ(table.flags(), 0u);
+}
+
+TEST(ModuleTable, Overflow) {
+  ModuleTable table;
+  for (size_t index = 0; index < ModuleTable::kCapacity; ++index) {
+    ASSERT_TRUE(AddNamed(&table, (index + 1) * 0x1000, "module"));
+  }
+  EXPECT_EQ(table.count(), static_cast<size_t>(ModuleTable::kCapacity));
+  EXPECT_EQ(table.flags(), 0u);
+
+  EXPECT_FALSE(AddNamed(&table, 0, "one too many"));
+  EXPECT_EQ(table.count(), static_cast<size_t>(ModuleTable::kCapacity));
+  EXPECT_EQ(table.flags(), static_cast<uint32_t>(ModuleTable::kFlagOverflowed));
+
+  // Once incomplete, the table stays that way.
+  table.Remove(0x1000);
+  EXPECT_EQ(table.flags(), static_cast<uint32_t>(ModuleTable::kFlagOverflowed));
+}
+
+#if defined(OS_WIN)
+
+const ModuleTableEntry* FindEntry(const ModuleTable* table, const void* base) {
+  for (size_t index = 0; index < table->count(); ++index) {
+    if (table->entries()[index].base_address ==
+        FromPointerCast<uint64_t>(base)) {
+      return &table->entries()[index];
+    }
+  }
+  return nullptr;
+}
+
+TEST(ModuleTable, GetInstance) {
+  ModuleTable* table = ModuleTable::GetInstance();
+  ASSERT_TRUE(table);
+  EXPECT_EQ(ModuleTable::GetInstance(), table);
+  EXPECT_EQ(CrashpadInfo::GetCrashpadInfo()->module_table(), table);
+
+  const ModuleTableEntry* executable =
+      FindEntry(table, GetModuleHandle(nullptr));
+  ASSERT_TRUE(executable);
+  wchar_t name[MAX_PATH];
+  DWORD name_length = GetModuleFileName(nullptr, name, arraysize(name));
+  ASSERT_NE(name_length, 0u);
+  EXPECT_EQ(executable->name_size, name_length * sizeof(name[0]));
+  EXPECT_NE(executable->timestamp, 0u);
+  EXPECT_TRUE(FindEntry(table, GetModuleHandle(L"ntdll.dll")));
+
+  // Modules loaded and unloaded later are noticed. This uses a system library
+  // that nothing else in the test loads.
+  constexpr wchar_t kLibrary[] = L"mscms.dll";
+  ASSERT_FALSE(GetModuleHandle(kLibrary));
+  HMODULE module = LoadLibrary(kLibrary);
+  ASSERT_TRUE(module) << ErrorMessage("LoadLibrary");
+  EXPECT_TRUE(FindEntry(table, module));
+  ASSERT_TRUE(FreeLibrary(module)) << ErrorMessage("FreeLibrary");
+  EXPECT_FALSE(FindEntry(table, module));
+}
+
+#endif  // OS_WIN
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -17,14 +17,90 @@
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <utility>
 #include <vector>
 
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "build/build_config.h"
+#include "util/file/file_reader.h"
+#include "util/file/page_store.h"
+#include "util/file/paged_file_reader.h"
 
 namespace crashpad {
 
+namespace {
+
+// Returns the size of |report|’s file in kilobytes, rounded up, preferring the
+// size recorded by the database to the file’s current size.
+uint64_t MeasureReportSizeInKB(const CrashReportDatabase::Report& report) {
+  if (report.size_in_kb) {
+    return report.size_in_kb;
+  }
+#if defined(OS_POSIX)
+  struct stat statbuf;
+  if (stat(report.file_path.value().c_str(), &statbuf) == 0) {
+#elif defined(OS_WIN)
+  struct _stati64 statbuf;
+  if (_wstat64(report.file_path.value().c_str(), &statbuf) == 0) {
+#else
+#error "Not implemented"
+#endif
+    // Round up fractional KB to the next 1-KB boundary.
+    return static_cast<uint64_t>((statbuf.st_size + 1023) / 1024);
+  }
+  return 0;
+}
+
+void DeleteReport(CrashReportDatabase* database,
+                  const CrashReportDatabase::Report& report) {
+  CrashReportDatabase::OperationStatus status =
+      database->DeleteReport(report.uuid);
+  if (status != CrashReportDatabase::kNoError) {
+    LOG(ERROR) << "Database Pruning: Failed to remove report "
+               << report.uuid.ToString();
+  }
+}
+
+// Deletes reports from |reports| oldest-first until |condition| keeps one.
+void PruneOldestFirst(CrashReportDatabase* database,
+                      PruneCondition* condition,
+                      const std::vector<CrashReportDatabase::Report>& reports) {
+  std::vector<uint64_t> sizes_in_kb;
+  sizes_in_kb.reserve(reports.size());
+  uint64_t remaining_size_in_kb = 0;
+  for (const auto& report : reports) {
+    sizes_in_kb.push_back(MeasureReportSizeInKB(report));
+    remaining_size_in_kb += sizes_in_kb.back();
+  }
+
+  // A min-heap of indices into |reports| by creation time. Building it takes
+  // linear time, and only the reports that are evaluated are ever popped.
+  std::vector<size_t> indices(reports.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  const auto newer = [&reports](size_t lhs, size_t rhs) {
+    return reports[lhs].creation_time > reports[rhs].creation_time;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(newer)> oldest(
+      newer, std::move(indices));
+
+  while (!oldest.empty()) {
+    const size_t index = oldest.top();
+    if (!condition->ShouldPruneOldestReport(reports[index],
+                                            remaining_size_in_kb)) {
+      break;
+    }
+    DeleteReport(database, reports[index]);
+    remaining_size_in_kb -= sizes_in_kb[index];
+    oldest.pop();
+  }
+}
+
+}  // namespace
+
 void PruneCrashReportDatabase(CrashReportDatabase* database,
                               PruneCondition* condition) {
   std::vector<CrashReportDatabase::Report> all_reports;
@@ -45,6 +121,11 @@ void PruneCrashReportDatabase(CrashReportDatabase* database,
   all_reports.insert(all_reports.end(), completed_reports.begin(),
                      completed_reports.end());
 
+  if (condition->SupportsOldestFirst()) {
+    PruneOldestFirst(database, condition, all_reports);
+    return;
+  }
+
   std::sort(all_reports.begin(), all_reports.end(),
       [](const CrashReportDatabase::Report& lhs,
          const CrashReportDatabase::Report& rhs) {
@@ -53,11 +134,7 @@ void PruneCrashReportDatabase(CrashReportDatabase* database,
 
   for (const auto& report : all_reports) {
     if (condition->ShouldPruneReport(report)) {
-      status = database->DeleteReport(report.uuid);
-      if (status != CrashReportDatabase::kNoError) {
-        LOG(ERROR) << "Database Pruning: Failed to remove report "
-                   << report.uuid.ToString();
-      }
+      DeleteReport(database, report);
     }
   }
 
@@ -66,6 +143,48 @@ void PruneCrashReportDatabase(CrashReportDatabase* database,
   // orphaned crash report files on-disk. https://crashpad.chromium.org/bug/66
 }
 
+size_t PruneUnreferencedPages(CrashReportDatabase* database,
+                              PageStore* page_store,
+                              time_t minimum_age) {
+  std::vector<CrashReportDatabase::Report> all_reports;
+  CrashReportDatabase::OperationStatus status;
+
+  // A page referred to by a report that wasn’t listed would be removed, so
+  // nothing is removed unless all of the reports are known.
+  status = database->GetPendingReports(&all_reports);
+  if (status != CrashReportDatabase::kNoError) {
+    LOG(ERROR) << "PruneUnreferencedPages: Failed to get pending reports";
+    return 0;
+  }
+
+  std::vector<CrashReportDatabase::Report> completed_reports;
+  status = database->GetCompletedReports(&completed_reports);
+  if (status != CrashReportDatabase::kNoError) {
+    LOG(ERROR) << "PruneUnreferencedPages: Failed to get completed reports";
+    return 0;
+  }
+  all_reports.insert(all_reports.end(), completed_reports.begin(),
+                     completed_reports.end());
+
+  // A report whose file can’t be read as a paged file can’t be reassembled
+  // from its pages either, so it doesn’t keep any pages.
+  std::set<uint64_t> referenced;
+  for (const auto& report : all_reports) {
+    FileReader file_reader;
+    if (!file_reader.Open(report.file_path) ||
+        !PagedFileReader::IsPagedFile(&file_reader)) {
+      continue;
+    }
+
+    PagedFileReader paged_reader;
+    if (paged_reader.Initialize(&file_reader, nullptr)) {
+      paged_reader.StoredPages(&referenced);
+    }
+  }
+
+  return page_store->RemovePagesExcept(referenced, minimum_age);
+}
+
 // static
 std::unique_ptr<PruneCondition> PruneCondition::GetDefault() {
   // DatabaseSizePruneCondition must be the LHS so that it is always evaluated,
@@ -76,6 +195,17 @@ std::unique_ptr<PruneCondition> PruneCondition::GetDefault() {
                                new AgePruneCondition(365)));
 }
 
+bool PruneCondition::SupportsOldestFirst() const {
+  return false;
+}
+
+bool PruneCondition::ShouldPruneOldestReport(
+    const CrashReportDatabase::Report& report,
+    uint64_t remaining_size_in_kb) {
+  NOTREACHED();
+  return false;
+}
+
 static const time_t kSecondsInDay = 60 * 60 * 24;
 
 AgePruneCondition::AgePruneCondition(int max_age_in_days)
@@ -90,6 +220,16 @@ bool AgePruneCondition::ShouldPruneReport(
   return report.creation_time < oldest_report_time_;
 }
 
+bool AgePruneCondition::SupportsOldestFirst() const {
+  return true;
+}
+
+bool AgePruneCondition::ShouldPruneOldestReport(
+    const CrashReportDatabase::Report& report,
+    uint64_t remaining_size_in_kb) {
+  return ShouldPruneReport(report);
+}
+
 DatabaseSizePruneCondition::DatabaseSizePruneCondition(size_t max_size_in_kb)
     : max_size_in_kb_(max_size_in_kb), measured_size_in_kb_(0) {}
 
@@ -97,22 +237,20 @@ DatabaseSizePruneCondition::~DatabaseSizePruneCondition() {}
 
 bool DatabaseSizePruneCondition::ShouldPruneReport(
     const CrashReportDatabase::Report& report) {
-#if defined(OS_POSIX)
-  struct stat statbuf;
-  if (stat(report.file_path.value().c_str(), &statbuf) == 0) {
-#elif defined(OS_WIN)
-  struct _stati64 statbuf;
-  if (_wstat64(report.file_path.value().c_str(), &statbuf) == 0) {
-#else
-#error "Not implemented"
-#endif
-    // Round up fractional KB to the next 1-KB boundary.
-    measured_size_in_kb_ +=
-        static_cast<size_t>((statbuf.st_size + 1023) / 1024);
-  }
+  measured_size_in_kb_ += static_cast<size_t>(MeasureReportSizeInKB(report));
   return measured_size_in_kb_ > max_size_in_kb_;
 }
 
+bool DatabaseSizePruneCondition::SupportsOldestFirst() const {
+  return true;
+}
+
+bool DatabaseSizePruneCondition::ShouldPruneOldestReport(
+    const CrashReportDatabase::Report& report,
+    uint64_t remaining_size_in_kb) {
+  return remaining_size_in_kb > max_size_in_kb_;
+}
+
 BinaryPruneCondition::BinaryPruneCondition(
     Operator op, PruneCondition* lhs, PruneCondition* rhs)
     : op_(op), lhs_(lhs), rhs_(rhs) {}
@@ -132,4 +270,24 @@ bool BinaryPruneCondition::ShouldPruneReport(
   }
 }
 
+bool BinaryPruneCondition::SupportsOldestFirst() const {
+  return lhs_->SupportsOldestFirst() && rhs_->SupportsOldestFirst();
+}
+
+bool BinaryPruneCondition::ShouldPruneOldestReport(
+    const CrashReportDatabase::Report& report,
+    uint64_t remaining_size_in_kb) {
+  switch (op_) {
+    case AND:
+      return lhs_->ShouldPruneOldestReport(report, remaining_size_in_kb) &&
+             rhs_->ShouldPruneOldestReport(report, remaining_size_in_kb);
+    case OR:
+      return lhs_->ShouldPruneOldestReport(report, remaining_size_in_kb) ||
+             rhs_->ShouldPruneOldestReport(report, remaining_size_in_kb);
+    default:
+      NOTREACHED();
+      return false;
+  }
+}
+
 }  // namespace crashpad
@@ -15,6 +15,7 @@
 #ifndef CRASHPAD_CLIENT_PRUNE_CRASH_REPORTS_H_
 #define CRASHPAD_CLIENT_PRUNE_CRASH_REPORTS_H_
 
+#include <stdint.h>
 #include <sys/types.h>
 #include <time.h>
 
@@ -25,6 +26,7 @@
 
 namespace crashpad {
 
+class PageStore;
 class PruneCondition;
 
 //! \brief Deletes crash reports from \a database that match \a condition.
@@ -34,6 +36,13 @@ class PruneCondition;
 //! sorted in descending order by CrashReportDatabase::Report::creation_time.
 //! This guarantee allows conditions to be stateful.
 //!
+//! If \a condition supports it, as indicated by
+//! PruneCondition::SupportsOldestFirst(), it is instead evaluated with
+//! PruneCondition::ShouldPruneOldestReport() against the oldest report
+//! remaining, until it keeps one. The work done beyond listing the reports is
+//! then proportional to the number of reports deleted, rather than the size of
+//! the database.
+//!
 //! \param[in] database The database from which crash reports will be deleted.
 //! \param[in] condition The condition against which all reports in the database
 //!     will be evaluated.
@@ -42,6 +51,25 @@ void PruneCrashReportDatabase(CrashReportDatabase* database,
 
 std::unique_ptr<PruneCondition> GetDefaultDatabasePruneCondition();
 
+//! \brief Removes the pages from \a page_store that no crash report in \a
+//!     database refers to.
+//!
+//! Reports stored as paged files, as written by PagedFileWriter, refer to
+//! pages in a PageStore, which aren’t removed along with the reports. This
+//! removes the pages that no remaining pending or completed report refers to,
+//! except for those stored within the last \a minimum_age seconds, which may
+//! belong to a report that is still being written. Nothing is removed if the
+//! reports can’t be listed.
+//!
+//! \param[in] database The database whose reports refer to \a page_store.
+//! \param[in] page_store The store to remove pages from.
+//! \param[in] minimum_age The minimum age of a page to be removed, in seconds.
+//!
+//! \return The number of pages removed.
+size_t PruneUnreferencedPages(CrashReportDatabase* database,
+                              PageStore* page_store,
+                              time_t minimum_age);
+
 //! \brief An abstract base class for evaluating crash reports for deletion.
 //!
 //! When passed to PruneCrashReportDatabase(), each crash report in the
@@ -68,6 +96,32 @@ class PruneCondition {
   //! \return `true` if the crash report should be deleted, `false` if it
   //!     should be kept.
   virtual bool ShouldPruneReport(const CrashReportDatabase::Report& report) = 0;
+
+  //! \brief Determines whether this condition may be evaluated with
+  //!     ShouldPruneOldestReport().
+  //!
+  //! This is only possible for a condition that, having kept a report, would
+  //! keep every newer one, and whose decision depends only on a report and on
+  //! the total size of the reports newer than it.
+  //!
+  //! The default implementation returns `false`.
+  virtual bool SupportsOldestFirst() const;
+
+  //! \brief Evaluates the oldest crash report remaining for deletion.
+  //!
+  //! This is only called if SupportsOldestFirst() returns `true`. Reports are
+  //! evaluated in ascending order by CrashReportDatabase::Report::creation_time
+  //! until this returns `false`, after which every newer report is kept.
+  //!
+  //! \param[in] report The crash report to evaluate.
+  //! \param[in] remaining_size_in_kb The total size of \a report and every
+  //!     report newer than it, in kilobytes.
+  //!
+  //! \return `true` if the crash report should be deleted, `false` if it and
+  //!     every newer report should be kept.
+  virtual bool ShouldPruneOldestReport(
+      const CrashReportDatabase::Report& report,
+      uint64_t remaining_size_in_kb);
 };
 
 //! \brief A PruneCondition that deletes reports older than the specified number
@@ -82,6 +136,9 @@ class AgePruneCondition final : public PruneCondition {
   ~AgePruneCondition();
 
   bool ShouldPruneReport(const CrashReportDatabase::Report& report) override;
+  bool SupportsOldestFirst() const override;
+  bool ShouldPruneOldestReport(const CrashReportDatabase::Report& report,
+                               uint64_t remaining_size_in_kb) override;
 
  private:
   const time_t oldest_report_time_;
@@ -97,12 +154,18 @@ class DatabaseSizePruneCondition final : public PruneCondition {
   //!     sum of the size of all reports is not smaller than \a max_size_in_kb.
   //!     After the limit is reached, older reports will be pruned.
   //!
+  //! A report’s size is taken from CrashReportDatabase::Report::size_in_kb
+  //! where the database recorded it, and from its file otherwise.
+  //!
   //! \param[in] max_size_in_kb The maximum number of kilobytes that all crash
   //!     reports should consume.
   explicit DatabaseSizePruneCondition(size_t max_size_in_kb);
   ~DatabaseSizePruneCondition();
 
   bool ShouldPruneReport(const CrashReportDatabase::Report& report) override;
+  bool SupportsOldestFirst() const override;
+  bool ShouldPruneOldestReport(const CrashReportDatabase::Report& report,
+                               uint64_t remaining_size_in_kb) override;
 
  private:
   const size_t max_size_in_kb_;
@@ -135,6 +198,13 @@ class BinaryPruneCondition final : public PruneCondition {
 
   bool ShouldPruneReport(const CrashReportDatabase::Report& report) override;
 
+  //! \copydoc PruneCondition::SupportsOldestFirst()
+  //!
+  //! This returns `true` only if both sub-conditions support it.
+  bool SupportsOldestFirst() const override;
+  bool ShouldPruneOldestReport(const CrashReportDatabase::Report& report,
+                               uint64_t remaining_size_in_kb) override;
+
  private:
   const Operator op_;
   std::unique_ptr<PruneCondition> lhs_;
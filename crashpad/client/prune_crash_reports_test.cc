@@ -27,6 +27,9 @@
 #include "gtest/gtest.h"
 #include "test/scoped_temp_dir.h"
 #include "util/file/file_io.h"
+#include "util/file/file_writer.h"
+#include "util/file/page_store.h"
+#include "util/file/paged_file_writer.h"
 
 namespace crashpad {
 namespace test {
@@ -50,6 +53,7 @@ class MockDatabase : public CrashReportDatabase {
                OperationStatus(const UUID&, Metrics::CrashSkippedReason));
   MOCK_METHOD1(DeleteReport, OperationStatus(const UUID&));
   MOCK_METHOD1(RequestUpload, OperationStatus(const UUID&));
+  MOCK_METHOD1(WatchPendingReports, bool(DirectoryChangeWatcher*));
 };
 
 time_t NDaysAgo(int num_days) {
@@ -70,6 +74,10 @@ TEST(PruneCrashReports, AgeCondition) {
   EXPECT_TRUE(condition.ShouldPruneReport(report_80_days));
   EXPECT_FALSE(condition.ShouldPruneReport(report_10_days));
   EXPECT_FALSE(condition.ShouldPruneReport(report_30_days));
+
+  EXPECT_TRUE(condition.SupportsOldestFirst());
+  EXPECT_TRUE(condition.ShouldPruneOldestReport(report_80_days, 0));
+  EXPECT_FALSE(condition.ShouldPruneOldestReport(report_30_days, 0));
 }
 
 TEST(PruneCrashReports, SizeCondition) {
@@ -125,6 +133,22 @@ TEST(PruneCrashReports, SizeCondition) {
     EXPECT_FALSE(condition.ShouldPruneReport(report_3k));
     EXPECT_TRUE(condition.ShouldPruneReport(report_1k));
   }
+
+  {
+    // A size recorded by the database is used in place of the file’s size.
+    CrashReportDatabase::Report report_recorded_2k = report_1k;
+    report_recorded_2k.size_in_kb = 2;
+    DatabaseSizePruneCondition condition(3);
+    EXPECT_FALSE(condition.ShouldPruneReport(report_recorded_2k));
+    EXPECT_TRUE(condition.ShouldPruneReport(report_recorded_2k));
+  }
+
+  {
+    DatabaseSizePruneCondition condition(6);
+    EXPECT_TRUE(condition.SupportsOldestFirst());
+    EXPECT_TRUE(condition.ShouldPruneOldestReport(report_1k, 7));
+    EXPECT_FALSE(condition.ShouldPruneOldestReport(report_1k, 6));
+  }
 }
 
 class StaticCondition final : public PruneCondition {
@@ -236,6 +260,133 @@ TEST(PruneCrashReports, PruneOrder) {
   PruneCrashReportDatabase(&db, &delete_all);
 }
 
+// Keeps reports once their total size is within a limit, as
+// DatabaseSizePruneCondition does, and counts the reports it evaluates.
+class CountingSizeCondition final : public PruneCondition {
+ public:
+  explicit CountingSizeCondition(uint64_t max_size_in_kb)
+      : max_size_in_kb_(max_size_in_kb), evaluated_(0) {}
+  ~CountingSizeCondition() {}
+
+  bool ShouldPruneReport(const CrashReportDatabase::Report& report) override {
+    ADD_FAILURE();
+    return false;
+  }
+  bool SupportsOldestFirst() const override { return true; }
+  bool ShouldPruneOldestReport(const CrashReportDatabase::Report& report,
+                               uint64_t remaining_size_in_kb) override {
+    ++evaluated_;
+    return remaining_size_in_kb > max_size_in_kb_;
+  }
+
+  size_t evaluated() const { return evaluated_; }
+
+ private:
+  const uint64_t max_size_in_kb_;
+  size_t evaluated_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingSizeCondition);
+};
+
+TEST(PruneCrashReports, PruneOldestFirst) {
+  using ::testing::_;
+  using ::testing::DoAll;
+  using ::testing::Return;
+  using ::testing::SetArgPointee;
+
+  // Report i is i days old, and i + 1 KB in size.
+  std::vector<CrashReportDatabase::Report> reports;
+  for (int i = 0; i < 10; ++i) {
+    CrashReportDatabase::Report temp;
+    temp.uuid.data_1 = i;
+    temp.creation_time = NDaysAgo(i);
+    temp.size_in_kb = i + 1;
+    reports.push_back(temp);
+  }
+  const auto random_generator = [](ptrdiff_t rand_max) {
+    return base::RandInt(0, base::checked_cast<int>(rand_max) - 1);
+  };
+  std::random_shuffle(reports.begin(), reports.end(), random_generator);
+  std::vector<CrashReportDatabase::Report> pending_reports(
+      reports.begin(), reports.begin() + 5);
+  std::vector<CrashReportDatabase::Report> completed_reports(
+      reports.begin() + 5, reports.end());
+
+  MockDatabase db;
+  EXPECT_CALL(db, GetPendingReports(_)).WillOnce(DoAll(
+      SetArgPointee<0>(pending_reports),
+      Return(CrashReportDatabase::kNoError)));
+  EXPECT_CALL(db, GetCompletedReports(_)).WillOnce(DoAll(
+      SetArgPointee<0>(completed_reports),
+      Return(CrashReportDatabase::kNoError)));
+
+  // The six newest reports take 1 + 2 + … + 6 = 21 KB, which fits, but adding
+  // the seventh would not.
+  for (size_t i = 6; i < reports.size(); ++i) {
+    EXPECT_CALL(db, DeleteReport(TestUUID(i)))
+        .WillOnce(Return(CrashReportDatabase::kNoError));
+  }
+
+  CountingSizeCondition condition(21);
+  PruneCrashReportDatabase(&db, &condition);
+
+  // Evaluation stops at the first report that is kept.
+  EXPECT_EQ(condition.evaluated(), 5u);
+}
+
+TEST(PruneCrashReports, PruneUnreferencedPages) {
+  using ::testing::_;
+  using ::testing::DoAll;
+  using ::testing::Return;
+  using ::testing::SetArgPointee;
+
+  ScopedTempDir temp_dir;
+  PageStore page_store(temp_dir.path().Append(FILE_PATH_LITERAL("pages")));
+
+  // Two paged reports share their first page. A third report isn’t paged.
+  std::string data(2 * PageStore::kPageSize, 'a');
+  std::fill(data.begin() + PageStore::kPageSize, data.end(), 'b');
+  static constexpr const base::FilePath::CharType* kNames[] = {
+      FILE_PATH_LITERAL("report0"),
+      FILE_PATH_LITERAL("report1"),
+      FILE_PATH_LITERAL("report2"),
+  };
+  CrashReportDatabase::Report reports[arraysize(kNames)];
+  for (size_t index = 0; index < arraysize(kNames); ++index) {
+    reports[index].file_path = temp_dir.path().Append(kNames[index]);
+    FileWriter file_writer;
+    ASSERT_TRUE(file_writer.Open(reports[index].file_path,
+                                 FileWriteMode::kCreateOrFail,
+                                 FilePermissions::kOwnerOnly));
+    if (index == 2) {
+      ASSERT_TRUE(file_writer.Write(data.data(), data.size()));
+      continue;
+    }
+    data[PageStore::kPageSize] = static_cast<char>('0' + index);
+    PagedFileWriter paged_writer(&file_writer, &page_store);
+    ASSERT_TRUE(paged_writer.Write(data.data(), data.size()));
+    ASSERT_TRUE(paged_writer.Close());
+  }
+
+  // Removing the first report leaves only its second page unreferenced.
+  MockDatabase db;
+  EXPECT_CALL(db, GetPendingReports(_))
+      .WillRepeatedly(DoAll(
+          SetArgPointee<0>(std::vector<CrashReportDatabase::Report>(
+              1, reports[1])),
+          Return(CrashReportDatabase::kNoError)));
+  EXPECT_CALL(db, GetCompletedReports(_))
+      .WillRepeatedly(DoAll(
+          SetArgPointee<0>(std::vector<CrashReportDatabase::Report>(
+              1, reports[2])),
+          Return(CrashReportDatabase::kNoError)));
+
+  // Pages stored just now are too new to be removed.
+  EXPECT_EQ(PruneUnreferencedPages(&db, &page_store, 60 * 60), 0u);
+  EXPECT_EQ(PruneUnreferencedPages(&db, &page_store, 0), 1u);
+  EXPECT_EQ(PruneUnreferencedPages(&db, &page_store, 0), 0u);
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
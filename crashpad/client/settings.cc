@@ -20,10 +20,139 @@
 
 #include "base/logging.h"
 #include "base/posix/eintr_wrapper.h"
+#include "build/build_config.h"
 #include "util/numeric/in_range_cast.h"
 
+#if defined(OS_POSIX)
+#include <sys/stat.h>
+#elif defined(OS_WIN)
+#include <windows.h>
+#endif  // OS_POSIX
+
 namespace crashpad {
 
+namespace {
+
+// Settings files modified more recently than this aren’t cached. Another
+// change within the same tick of the file system’s clock, which may be as
+// coarse as two seconds, could leave the file’s size and modification time
+// unchanged, and so go unnoticed.
+constexpr time_t kMinimumCachedFileAgeSeconds = 3;
+
+// Identifies a version of the settings file without reading it.
+struct FileVersion {
+  bool operator==(const FileVersion& other) const {
+#if defined(OS_POSIX)
+    if (device != other.device || inode != other.inode) {
+      return false;
+    }
+#endif  // OS_POSIX
+    return size == other.size &&
+           modification_time_seconds == other.modification_time_seconds &&
+           modification_time_nanoseconds ==
+               other.modification_time_nanoseconds;
+  }
+
+#if defined(OS_POSIX)
+  dev_t device;
+  ino_t inode;
+#endif  // OS_POSIX
+  int64_t size;
+  int64_t modification_time_seconds;
+  int64_t modification_time_nanoseconds;
+};
+
+#if defined(OS_POSIX)
+
+void FileVersionFromStat(const struct stat& st, FileVersion* version) {
+  version->device = st.st_dev;
+  version->inode = st.st_ino;
+  version->size = st.st_size;
+#if defined(OS_MACOSX)
+  version->modification_time_seconds = st.st_mtimespec.tv_sec;
+  version->modification_time_nanoseconds = st.st_mtimespec.tv_nsec;
+#else
+  version->modification_time_seconds = st.st_mtim.tv_sec;
+  version->modification_time_nanoseconds = st.st_mtim.tv_nsec;
+#endif  // OS_MACOSX
+}
+
+bool FileVersionFromPath(const base::FilePath& path, FileVersion* version) {
+  struct stat st;
+  if (stat(path.value().c_str(), &st) != 0) {
+    return false;
+  }
+  FileVersionFromStat(st, version);
+  return true;
+}
+
+bool FileVersionFromHandle(FileHandle handle, FileVersion* version) {
+  struct stat st;
+  if (fstat(handle, &st) != 0) {
+    PLOG(ERROR) << "fstat";
+    return false;
+  }
+  FileVersionFromStat(st, version);
+  return true;
+}
+
+#elif defined(OS_WIN)
+
+void FileVersionFromAttributes(const FILETIME& last_write_time,
+                               DWORD file_size_high,
+                               DWORD file_size_low,
+                               FileVersion* version) {
+  // FILETIME counts 100-nanosecond intervals since 1601-01-01, which is this
+  // many seconds before the POSIX epoch.
+  constexpr int64_t kEpochOffsetSeconds = 11644473600;
+  const int64_t intervals =
+      (static_cast<int64_t>(last_write_time.dwHighDateTime) << 32) |
+      last_write_time.dwLowDateTime;
+  version->size = (static_cast<int64_t>(file_size_high) << 32) | file_size_low;
+  version->modification_time_seconds =
+      intervals / 10000000 - kEpochOffsetSeconds;
+  version->modification_time_nanoseconds = intervals % 10000000 * 100;
+}
+
+bool FileVersionFromPath(const base::FilePath& path, FileVersion* version) {
+  WIN32_FILE_ATTRIBUTE_DATA attributes;
+  if (!GetFileAttributesEx(
+          path.value().c_str(), GetFileExInfoStandard, &attributes)) {
+    return false;
+  }
+  FileVersionFromAttributes(attributes.ftLastWriteTime,
+                            attributes.nFileSizeHigh,
+                            attributes.nFileSizeLow,
+                            version);
+  return true;
+}
+
+bool FileVersionFromHandle(FileHandle handle, FileVersion* version) {
+  BY_HANDLE_FILE_INFORMATION information;
+  if (!GetFileInformationByHandle(handle, &information)) {
+    PLOG(ERROR) << "GetFileInformationByHandle";
+    return false;
+  }
+  FileVersionFromAttributes(information.ftLastWriteTime,
+                            information.nFileSizeHigh,
+                            information.nFileSizeLow,
+                            version);
+  return true;
+}
+
+#endif  // OS_POSIX
+
+// Computes the FNV-1a hash of |size| bytes at |data|, continuing from |hash|.
+uint32_t SlotChecksum(uint32_t hash, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t index = 0; index < size; ++index) {
+    hash = (hash ^ bytes[index]) * 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace
+
 namespace internal {
 
 // static
@@ -47,20 +176,54 @@ struct Settings::Data {
   Data() : magic(kSettingsMagic),
            version(kSettingsVersion),
            options(0),
-           padding_0(0),
+           uploads_deferred_until(0),
            last_upload_attempt_time(0),
            client_id() {}
 
   uint32_t magic;
   uint32_t version;
   uint32_t options;
-  uint32_t padding_0;
+
+  // This was padding, always written as 0, in older versions, which preserve
+  // it when they write the file.
+  uint32_t uploads_deferred_until;  // time_t
   int64_t last_upload_attempt_time;  // time_t
   UUID client_id;
 };
 
+// Settings are written alternately to one of two slots following the Data
+// record at the start of the file, the slot at index |sequence| % 2 holding
+// the write numbered |sequence|. A write only ever overwrites the older slot,
+// so the newer slot remains intact if the write is torn, and can be read
+// without taking a lock. The Data record at the start of the file is still
+// written after the slot for the benefit of versions of Crashpad that don’t
+// know about slots. Those versions truncate the file when they write it,
+// discarding the slots, so slots are never left stale.
+struct Settings::Slot {
+  static const uint32_t kSlotMagic = 'CPss';
+
+  Slot() : magic(kSlotMagic), checksum(0), sequence(0), data() {}
+
+  uint32_t ComputeChecksum() const {
+    uint32_t hash = SlotChecksum(2166136261u, &sequence, sizeof(sequence));
+    return SlotChecksum(hash, &data, sizeof(data));
+  }
+
+  uint32_t magic;
+  uint32_t checksum;  // ComputeChecksum()
+  uint64_t sequence;
+  Data data;
+};
+
+struct Settings::Cache {
+  Data data;
+  FileVersion version;
+};
+
 Settings::Settings(const base::FilePath& file_path)
     : file_path_(file_path),
+      cache_(),
+      cache_lock_(),
       initialized_() {
 }
 
@@ -82,7 +245,7 @@ bool Settings::GetClientID(UUID* client_id) {
   DCHECK(initialized_.is_valid());
 
   Data settings;
-  if (!OpenAndReadSettings(&settings))
+  if (!ReadCachedSettings(&settings))
     return false;
 
   *client_id = settings.client_id;
@@ -93,7 +256,7 @@ bool Settings::GetUploadsEnabled(bool* enabled) {
   DCHECK(initialized_.is_valid());
 
   Data settings;
-  if (!OpenAndReadSettings(&settings))
+  if (!ReadCachedSettings(&settings))
     return false;
 
   *enabled = (settings.options & Data::Options::kUploadsEnabled) != 0;
@@ -113,14 +276,18 @@ bool Settings::SetUploadsEnabled(bool enabled) {
   else
     settings.options &= ~Data::Options::kUploadsEnabled;
 
-  return WriteSettings(handle.get(), settings);
+  if (!WriteSettings(handle.get(), settings))
+    return false;
+
+  UpdateCache(handle.get(), settings);
+  return true;
 }
 
 bool Settings::GetLastUploadAttemptTime(time_t* time) {
   DCHECK(initialized_.is_valid());
 
   Data settings;
-  if (!OpenAndReadSettings(&settings))
+  if (!ReadCachedSettings(&settings))
     return false;
 
   *time = InRangeCast<time_t>(settings.last_upload_attempt_time,
@@ -138,7 +305,41 @@ bool Settings::SetLastUploadAttemptTime(time_t time) {
 
   settings.last_upload_attempt_time = InRangeCast<int64_t>(time, 0);
 
-  return WriteSettings(handle.get(), settings);
+  if (!WriteSettings(handle.get(), settings))
+    return false;
+
+  UpdateCache(handle.get(), settings);
+  return true;
+}
+
+bool Settings::GetUploadsDeferredUntil(time_t* time) {
+  DCHECK(initialized_.is_valid());
+
+  Data settings;
+  if (!ReadCachedSettings(&settings))
+    return false;
+
+  *time = InRangeCast<time_t>(settings.uploads_deferred_until,
+                              std::numeric_limits<time_t>::max());
+  return true;
+}
+
+bool Settings::SetUploadsDeferredUntil(time_t time) {
+  DCHECK(initialized_.is_valid());
+
+  Data settings;
+  ScopedLockedFileHandle handle = OpenForWritingAndReadSettings(&settings);
+  if (!handle.is_valid())
+    return false;
+
+  settings.uploads_deferred_until = InRangeCast<uint32_t>(
+      time, time > 0 ? std::numeric_limits<uint32_t>::max() : 0);
+
+  if (!WriteSettings(handle.get(), settings))
+    return false;
+
+  UpdateCache(handle.get(), settings);
+  return true;
 }
 
 // static
@@ -174,13 +375,60 @@ Settings::ScopedLockedFileHandle Settings::OpenForReadingAndWriting(
   return MakeScopedLockedFileHandle(handle, FileLocking::kExclusive);
 }
 
+bool Settings::ReadCachedSettings(Data* out_data) {
+  FileVersion version;
+  if (FileVersionFromPath(file_path(), &version)) {
+    base::AutoLock lock(cache_lock_);
+    if (cache_ && cache_->version == version) {
+      *out_data = cache_->data;
+      return true;
+    }
+  }
+
+  return OpenAndReadSettings(out_data);
+}
+
+void Settings::UpdateCache(FileHandle handle, const Data& data) {
+  FileVersion version;
+  const bool cacheable =
+      FileVersionFromHandle(handle, &version) &&
+      time(nullptr) - version.modification_time_seconds >=
+          kMinimumCachedFileAgeSeconds;
+
+  base::AutoLock lock(cache_lock_);
+  if (!cacheable) {
+    cache_.reset();
+    return;
+  }
+  if (!cache_) {
+    cache_.reset(new Cache());
+  }
+  cache_->data = data;
+  cache_->version = version;
+}
+
 bool Settings::OpenAndReadSettings(Data* out_data) {
+  // A slot can be read without a lock. On Windows, where locks are mandatory,
+  // this fails while a writer holds the lock, and the settings are read below
+  // once the lock is released.
+  {
+    ScopedFileHandle handle(OpenFileForRead(file_path()));
+    Slot slot;
+    if (handle.is_valid() && ReadCurrentSlot(handle.get(), &slot)) {
+      *out_data = slot.data;
+      UpdateCache(handle.get(), *out_data);
+      return true;
+    }
+  }
+
   ScopedLockedFileHandle handle = OpenForReading();
   if (!handle.is_valid())
     return false;
 
-  if (ReadSettings(handle.get(), out_data, true))
+  if (ReadSettings(handle.get(), out_data, true)) {
+    UpdateCache(handle.get(), *out_data);
     return true;
+  }
 
   // The settings file is corrupt, so reinitialize it.
   handle.reset();
@@ -240,9 +488,42 @@ Settings::ScopedLockedFileHandle Settings::OpenForWritingAndReadSettings(
   return handle;
 }
 
+bool Settings::ReadCurrentSlot(FileHandle handle, Slot* slot) {
+  if (LoggingSeekFile(handle, sizeof(Data), SEEK_SET) != sizeof(Data))
+    return false;
+
+  bool found = false;
+  for (size_t index = 0; index < 2; ++index) {
+    Slot candidate;
+    if (!ReadFileExactly(handle, &candidate, sizeof(candidate)))
+      break;
+
+    if (candidate.magic != Slot::kSlotMagic ||
+        candidate.checksum != candidate.ComputeChecksum() ||
+        candidate.sequence % 2 != index ||
+        candidate.data.magic != Data::kSettingsMagic ||
+        candidate.data.version != Data::kSettingsVersion) {
+      continue;
+    }
+
+    if (!found || candidate.sequence > slot->sequence) {
+      *slot = candidate;
+      found = true;
+    }
+  }
+
+  return found;
+}
+
 bool Settings::ReadSettings(FileHandle handle,
                             Data* out_data,
                             bool log_read_error) {
+  Slot slot;
+  if (ReadCurrentSlot(handle, &slot)) {
+    *out_data = slot.data;
+    return true;
+  }
+
   if (LoggingSeekFile(handle, 0, SEEK_SET) != 0)
     return false;
 
@@ -268,10 +549,27 @@ bool Settings::ReadSettings(FileHandle handle,
 }
 
 bool Settings::WriteSettings(FileHandle handle, const Data& data) {
-  if (LoggingSeekFile(handle, 0, SEEK_SET) != 0)
+  Slot slot;
+  if (ReadCurrentSlot(handle, &slot)) {
+    ++slot.sequence;
+  } else {
+    slot.sequence = 0;
+  }
+  slot.magic = Slot::kSlotMagic;
+  slot.data = data;
+  slot.checksum = slot.ComputeChecksum();
+
+  const FileOffset slot_offset =
+      sizeof(Data) + (slot.sequence % 2) * sizeof(Slot);
+  if (LoggingSeekFile(handle, slot_offset, SEEK_SET) != slot_offset)
     return false;
 
-  if (!LoggingTruncateFile(handle))
+  if (!LoggingWriteFile(handle, &slot, sizeof(slot)))
+    return false;
+
+  // The Data record is overwritten in place rather than truncated, so that the
+  // slots survive. Readers that understand slots won’t look at it.
+  if (LoggingSeekFile(handle, 0, SEEK_SET) != 0)
     return false;
 
   return LoggingWriteFile(handle, &data, sizeof(Data));
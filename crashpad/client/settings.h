@@ -17,11 +17,13 @@
 
 #include <time.h>
 
+#include <memory>
 #include <string>
 
 #include "base/files/file_path.h"
 #include "base/macros.h"
 #include "base/scoped_generic.h"
+#include "base/synchronization/lock.h"
 #include "util/file/file_io.h"
 #include "util/misc/initialization_state.h"
 #include "util/misc/uuid.h"
@@ -42,6 +44,12 @@ struct ScopedLockedFileHandleTraits {
 //!
 //! This class must not be instantiated directly, but rather an instance of it
 //! should be retrieved via CrashReportDatabase::GetSettings().
+//!
+//! The settings last read are cached, and are used again for as long as the
+//! settings file’s size, modification time, and identity are unchanged, so that
+//! repeated queries from a long-lived process don’t each read the file. A
+//! change made by another process is noticed by the next query. This class is
+//! thread-safe.
 class Settings {
  public:
   explicit Settings(const base::FilePath& file_path);
@@ -102,8 +110,33 @@ class Settings {
   //!     error logged.
   bool SetLastUploadAttemptTime(time_t time);
 
+  //! \brief Retrieves the time before which no report is to be uploaded,
+  //!     because the collection server asked for uploads to be held off.
+  //!
+  //! The default value is `0`, permitting uploads at any time.
+  //!
+  //! \param[out] time The time before which uploads are deferred.
+  //!
+  //! \return On success, returns `true`, otherwise returns `false` with an
+  //!     error logged.
+  bool GetUploadsDeferredUntil(time_t* time);
+
+  //! \brief Sets the time before which no report is to be uploaded.
+  //!
+  //! This is only meant to be used internally by the CrashReportUploadThread,
+  //! so that every process uploading from the database honors a request made
+  //! by the server to any of them.
+  //!
+  //! \param[in] time The time before which uploads are deferred.
+  //!
+  //! \return On success, returns `true`, otherwise returns `false` with an
+  //!     error logged.
+  bool SetUploadsDeferredUntil(time_t time);
+
  private:
   struct Data;
+  struct Slot;
+  struct Cache;
 
   // This must be constructed with MakeScopedLockedFileHandle(). It both unlocks
   // and closes the file on destruction.
@@ -127,6 +160,15 @@ class Settings {
   ScopedLockedFileHandle OpenForReadingAndWriting(FileWriteMode mode,
                                                   bool log_open_error);
 
+  // Returns the cached settings if the settings file hasn’t changed since they
+  // were cached, and otherwise reads them as OpenAndReadSettings() does.
+  bool ReadCachedSettings(Data* out_data);
+
+  // Caches |data| as the contents of the settings file open at |handle|, which
+  // must still be locked. If the file’s version can’t be determined, the cache
+  // is cleared instead.
+  void UpdateCache(FileHandle handle, const Data& data);
+
   // Opens the settings file and reads the data. If that fails, an error will
   // be logged and the settings will be recovered and re-initialized. If that
   // also fails, returns false with additional log data from recovery.
@@ -137,8 +179,15 @@ class Settings {
   // invalid file handle on failure, with an error logged.
   ScopedLockedFileHandle OpenForWritingAndReadSettings(Data* out_data);
 
-  // Reads the settings from |handle|. Logs an error and returns false on
-  // failure. This does not perform recovery.
+  // Reads the current slot from |handle|, which need not be locked. Returns
+  // false without logging anything if neither slot holds valid settings, as
+  // when the file was last written by a version of Crashpad that didn’t write
+  // slots.
+  bool ReadCurrentSlot(FileHandle handle, Slot* slot);
+
+  // Reads the settings from |handle|, from the current slot if there is one,
+  // and otherwise from the record at the start of the file. Logs an error and
+  // returns false on failure. This does not perform recovery.
   //
   // |handle| must be the result of OpenForReading() or
   // OpenForReadingAndWriting().
@@ -149,8 +198,9 @@ class Settings {
   // file.
   bool ReadSettings(FileHandle handle, Data* out_data, bool log_read_error);
 
-  // Writes the settings to |handle|. Logs an error and returns false on
-  // failure. This does not perform recovery.
+  // Writes the settings to |handle|, in the slot other than the current one,
+  // and then to the record at the start of the file. Logs an error and returns
+  // false on failure. This does not perform recovery.
   //
   // |handle| must be the result of OpenForReadingAndWriting().
   bool WriteSettings(FileHandle handle, const Data& data);
@@ -173,6 +223,9 @@ class Settings {
 
   base::FilePath file_path_;
 
+  std::unique_ptr<Cache> cache_;  // nullptr when nothing is cached.
+  base::Lock cache_lock_;  // Guards cache_.
+
   InitializationState initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(Settings);
@@ -15,6 +15,13 @@
 #include "client/settings.h"
 
 #include "build/build_config.h"
+
+#if defined(OS_POSIX)
+#include <utime.h>
+#elif defined(OS_WIN)
+#include <sys/utime.h>
+#endif  // OS_POSIX
+
 #include "gtest/gtest.h"
 #include "test/errors.h"
 #include "test/scoped_temp_dir.h"
@@ -34,6 +41,21 @@ class SettingsTest : public testing::Test {
 
   Settings* settings() { return &settings_; }
 
+  // Sets the settings file’s modification time to an hour ago, so that the
+  // settings read from it may be cached.
+  void AgeFile() {
+    const time_t then = time(nullptr) - 60 * 60;
+#if defined(OS_WIN)
+    struct _utimbuf times = {then, then};
+    ASSERT_EQ(_wutime(settings_path().value().c_str(), &times), 0)
+        << ErrnoMessage("_wutime");
+#else
+    struct utimbuf times = {then, then};
+    ASSERT_EQ(utime(settings_path().value().c_str(), &times), 0)
+        << ErrnoMessage("utime");
+#endif  // OS_WIN
+  }
+
   void InitializeBadFile() {
     ScopedFileHandle handle(
         LoggingOpenFileForWrite(settings_path(),
@@ -114,6 +136,34 @@ TEST_F(SettingsTest, LastUploadAttemptTime) {
   EXPECT_EQ(actual, expected);
 }
 
+TEST_F(SettingsTest, UploadsDeferredUntil) {
+  time_t actual = -1;
+  EXPECT_TRUE(settings()->GetUploadsDeferredUntil(&actual));
+  // Default value is 0.
+  EXPECT_EQ(actual, 0);
+
+  const time_t expected = time(nullptr) + 60 * 60;
+  EXPECT_TRUE(settings()->SetUploadsDeferredUntil(expected));
+  EXPECT_TRUE(settings()->GetUploadsDeferredUntil(&actual));
+  EXPECT_EQ(actual, expected);
+
+  Settings local_settings(settings_path());
+  EXPECT_TRUE(local_settings.Initialize());
+  actual = -1;
+  EXPECT_TRUE(local_settings.GetUploadsDeferredUntil(&actual));
+  EXPECT_EQ(actual, expected);
+
+  // The deferral is independent of the last upload attempt time.
+  time_t last_upload_attempt_time = -1;
+  EXPECT_TRUE(
+      local_settings.GetLastUploadAttemptTime(&last_upload_attempt_time));
+  EXPECT_EQ(last_upload_attempt_time, 0);
+
+  EXPECT_TRUE(settings()->SetUploadsDeferredUntil(0));
+  EXPECT_TRUE(local_settings.GetUploadsDeferredUntil(&actual));
+  EXPECT_EQ(actual, 0);
+}
+
 // The following tests write a corrupt settings file and test the recovery
 // operation.
 
@@ -147,6 +197,109 @@ TEST_F(SettingsTest, BadFileOnSet) {
   EXPECT_TRUE(enabled);
 }
 
+TEST_F(SettingsTest, TornWrite) {
+  UUID client_id;
+  ASSERT_TRUE(settings()->GetClientID(&client_id));
+  ASSERT_TRUE(settings()->SetUploadsEnabled(true));
+  ASSERT_TRUE(settings()->SetLastUploadAttemptTime(1));
+
+  // Damage the end of the file, as though the most recent write had been
+  // interrupted. The settings from an earlier write must still be found,
+  // without recovery replacing the client ID.
+  {
+    ScopedFileHandle handle(
+        LoggingOpenFileForReadAndWrite(settings_path(),
+                                       FileWriteMode::kReuseOrFail,
+                                       FilePermissions::kWorldReadable));
+    ASSERT_TRUE(handle.is_valid());
+    ASSERT_EQ(LoggingSeekFile(handle.get(), -1, SEEK_END) + 1,
+              LoggingFileSizeByHandle(handle.get()));
+    static constexpr char kGarbage[] = "x";
+    ASSERT_TRUE(LoggingWriteFile(handle.get(), kGarbage, 1));
+  }
+
+  Settings local_settings(settings_path());
+  EXPECT_TRUE(local_settings.Initialize());
+  UUID actual;
+  EXPECT_TRUE(local_settings.GetClientID(&actual));
+  EXPECT_EQ(actual, client_id);
+  bool enabled = false;
+  EXPECT_TRUE(local_settings.GetUploadsEnabled(&enabled));
+  EXPECT_TRUE(enabled);
+
+  EXPECT_TRUE(local_settings.SetLastUploadAttemptTime(2));
+  time_t time = 0;
+  EXPECT_TRUE(settings()->GetLastUploadAttemptTime(&time));
+  EXPECT_EQ(time, 2);
+}
+
+TEST_F(SettingsTest, WrittenByOlderVersion) {
+  UUID client_id;
+  ASSERT_TRUE(settings()->GetClientID(&client_id));
+  ASSERT_TRUE(settings()->SetUploadsEnabled(true));
+
+  // Older versions of Crashpad wrote only the record at the start of the
+  // file, truncating anything following it.
+  {
+    ScopedFileHandle handle(
+        LoggingOpenFileForReadAndWrite(settings_path(),
+                                       FileWriteMode::kReuseOrFail,
+                                       FilePermissions::kWorldReadable));
+    ASSERT_TRUE(handle.is_valid());
+    char record[40];
+    ASSERT_TRUE(LoggingReadFileExactly(handle.get(), record, sizeof(record)));
+    ASSERT_EQ(LoggingSeekFile(handle.get(), 0, SEEK_SET), 0);
+    ASSERT_TRUE(LoggingTruncateFile(handle.get()));
+    ASSERT_TRUE(LoggingWriteFile(handle.get(), record, sizeof(record)));
+  }
+
+  Settings local_settings(settings_path());
+  EXPECT_TRUE(local_settings.Initialize());
+  UUID actual;
+  EXPECT_TRUE(local_settings.GetClientID(&actual));
+  EXPECT_EQ(actual, client_id);
+  bool enabled = false;
+  EXPECT_TRUE(local_settings.GetUploadsEnabled(&enabled));
+  EXPECT_TRUE(enabled);
+
+  EXPECT_TRUE(local_settings.SetUploadsEnabled(false));
+  EXPECT_TRUE(settings()->GetUploadsEnabled(&enabled));
+  EXPECT_FALSE(enabled);
+}
+
+TEST_F(SettingsTest, ChangeFromOtherInstance) {
+  // Cache the settings, as a long-lived process would.
+  ASSERT_NO_FATAL_FAILURE(AgeFile());
+  bool enabled = true;
+  EXPECT_TRUE(settings()->GetUploadsEnabled(&enabled));
+  EXPECT_FALSE(enabled);
+  EXPECT_TRUE(settings()->GetUploadsEnabled(&enabled));
+  EXPECT_FALSE(enabled);
+
+  // A change made through another object is seen, in place of the cached
+  // settings.
+  Settings other_settings(settings_path());
+  ASSERT_TRUE(other_settings.Initialize());
+  EXPECT_TRUE(other_settings.SetUploadsEnabled(true));
+  EXPECT_TRUE(settings()->GetUploadsEnabled(&enabled));
+  EXPECT_TRUE(enabled);
+
+  ASSERT_NO_FATAL_FAILURE(AgeFile());
+  time_t time = -1;
+  EXPECT_TRUE(settings()->GetLastUploadAttemptTime(&time));
+  EXPECT_EQ(time, 0);
+  EXPECT_TRUE(other_settings.SetLastUploadAttemptTime(10));
+  EXPECT_TRUE(settings()->GetLastUploadAttemptTime(&time));
+  EXPECT_EQ(time, 10);
+
+  // A change made through this object is seen too.
+  ASSERT_NO_FATAL_FAILURE(AgeFile());
+  EXPECT_TRUE(settings()->GetUploadsEnabled(&enabled));
+  EXPECT_TRUE(settings()->SetUploadsEnabled(false));
+  EXPECT_TRUE(settings()->GetUploadsEnabled(&enabled));
+  EXPECT_FALSE(enabled);
+}
+
 TEST_F(SettingsTest, UnlinkFile) {
   UUID client_id;
   EXPECT_TRUE(settings()->GetClientID(&client_id));
@@ -16,6 +16,7 @@
 #define CRASHPAD_CLIENT_SIMPLE_ADDRESS_RANGE_BAG_H_
 
 #include <stdint.h>
+#include <string.h>
 
 #include "base/logging.h"
 #include "base/macros.h"
@@ -25,17 +26,34 @@
 
 namespace crashpad {
 
+//! \brief The largest number of entries that a TSimpleAddressRangeBag may be
+//!     declared to hold.
+//!
+//! This bounds the amount of memory that a crash reporter reads when it
+//! collects the ranges from another process.
+constexpr size_t kSimpleAddressRangeBagMaxEntries = 16384;
+
 //! \brief A bag implementation using a fixed amount of storage, so that it does
 //!     not perform any dynamic allocations for its operations.
 //!
 //! The actual bag storage (TSimpleAddressRangeBag::Entry) is POD, so that it
-//! can be transmitted over various IPC mechanisms.
+//! can be transmitted over various IPC mechanisms. The entries are laid out as
+//! an array at the start of the object, so that another process that knows
+//! \a NumEntries can read all of them at once.
+//!
+//! Inserting a range takes constant time. Removing a range takes constant time
+//! when it is identified by the Handle that insertion returned, and time linear
+//! in the number of entries ever used when it is identified by its address.
 template <size_t NumEntries = 64>
 class TSimpleAddressRangeBag {
  public:
   //! Constant and publicly accessible version of the template parameter.
   static const size_t num_entries = NumEntries;
 
+  static_assert(NumEntries > 0 &&
+                    NumEntries <= kSimpleAddressRangeBagMaxEntries,
+                "NumEntries out of range");
+
   //! \brief A single entry in the bag.
   struct Entry {
     //! \brief The base address of the range.
@@ -53,6 +71,17 @@ class TSimpleAddressRangeBag {
     }
   };
 
+  //! \brief Identifies a range inserted into a TSimpleAddressRangeBag, so that
+  //!     it can be removed without searching for it.
+  //!
+  //! A handle refers to one insertion. Once its range has been removed, the
+  //! handle is stale and is not valid for removing any range that later
+  //! occupies the same entry.
+  struct Handle {
+    uint32_t index;
+    uint32_t generation;
+  };
+
   //! \brief An iterator to traverse all of the active entries in a
   //!     TSimpleAddressRangeBag.
   class Iterator {
@@ -65,7 +94,7 @@ class TSimpleAddressRangeBag {
     //! \brief Returns the next entry in the bag, or `nullptr` if at the end of
     //!     the collection.
     const Entry* Next() {
-      while (current_ < bag_.num_entries) {
+      while (current_ < bag_.used_) {
         const Entry* entry = &bag_.entries_[current_++];
         if (entry->is_active()) {
           return entry;
@@ -82,7 +111,12 @@ class TSimpleAddressRangeBag {
   };
 
   TSimpleAddressRangeBag()
-      : entries_() {
+      : entries_(),
+        generations_(),
+        next_free_(),
+        free_head_(0),
+        used_(0),
+        count_(0) {
   }
 
   TSimpleAddressRangeBag(const TSimpleAddressRangeBag& other) {
@@ -91,19 +125,18 @@ class TSimpleAddressRangeBag {
 
   TSimpleAddressRangeBag& operator=(const TSimpleAddressRangeBag& other) {
     memcpy(entries_, other.entries_, sizeof(entries_));
+    memcpy(generations_, other.generations_, sizeof(generations_));
+    memcpy(next_free_, other.next_free_, sizeof(next_free_));
+    free_head_ = other.free_head_;
+    used_ = other.used_;
+    count_ = other.count_;
     return *this;
   }
 
   //! \brief Returns the number of active entries. The upper limit for this is
   //!     \a NumEntries.
   size_t GetCount() const {
-    size_t count = 0;
-    for (size_t i = 0; i < num_entries; ++i) {
-      if (entries_[i].is_active()) {
-        ++count;
-      }
-    }
-    return count;
+    return count_;
   }
 
   //! \brief Inserts the given range into the bag. Duplicates and overlapping
@@ -115,18 +148,43 @@ class TSimpleAddressRangeBag {
   //! \return `true` if there was space to insert the range into the bag,
   //!     otherwise `false` with an error logged.
   bool Insert(CheckedRange<uint64_t> range) {
+    Handle handle;
+    return Insert(range, &handle);
+  }
+
+  //! \brief Inserts the given range into the bag, returning a handle that can
+  //!     be used to remove it. Duplicates and overlapping ranges are supported
+  //!     and allowed, but not coalesced.
+  //!
+  //! \param[in] range The range to be inserted. The range must have either a
+  //!     non-zero base address or size.
+  //! \param[out] handle The handle identifying the inserted range, for use
+  //!     with Remove(Handle).
+  //!
+  //! \return `true` if there was space to insert the range into the bag,
+  //!     otherwise `false` with an error logged.
+  bool Insert(CheckedRange<uint64_t> range, Handle* handle) {
     DCHECK(range.base() != 0 || range.size() != 0);
 
-    for (size_t i = 0; i < num_entries; ++i) {
-      if (!entries_[i].is_active()) {
-        entries_[i].base = range.base();
-        entries_[i].size = range.size();
-        return true;
-      }
+    uint32_t index;
+    if (free_head_) {
+      index = free_head_ - 1;
+      free_head_ = next_free_[index];
+    } else if (used_ < num_entries) {
+      index = used_++;
+    } else {
+      LOG(ERROR) << "no space available to insert range";
+      return false;
     }
 
-    LOG(ERROR) << "no space available to insert range";
-    return false;
+    DCHECK(!entries_[index].is_active());
+    entries_[index].base = range.base();
+    entries_[index].size = range.size();
+    ++count_;
+
+    handle->index = index;
+    handle->generation = generations_[index];
+    return true;
   }
 
   //! \brief Inserts the given range into the bag. Duplicates and overlapping
@@ -154,10 +212,10 @@ class TSimpleAddressRangeBag {
   bool Remove(CheckedRange<uint64_t> range) {
     DCHECK(range.base() != 0 || range.size() != 0);
 
-    for (size_t i = 0; i < num_entries; ++i) {
+    for (uint32_t i = 0; i < used_; ++i) {
       if (entries_[i].base == range.base() &&
           entries_[i].size == range.size()) {
-        entries_[i].base = entries_[i].size = 0;
+        Release(i);
         return true;
       }
     }
@@ -166,6 +224,25 @@ class TSimpleAddressRangeBag {
     return false;
   }
 
+  //! \brief Removes the range identified by \a handle from the bag.
+  //!
+  //! \param[in] handle A handle obtained from Insert(CheckedRange<uint64_t>,
+  //!     Handle*).
+  //!
+  //! \return `true` if the range was found and removed, otherwise `false` with
+  //!     an error logged. A stale handle, whose range has already been
+  //!     removed, causes this method to fail.
+  bool Remove(Handle handle) {
+    if (handle.index >= used_ || !entries_[handle.index].is_active() ||
+        generations_[handle.index] != handle.generation) {
+      LOG(ERROR) << "did not find range to remove";
+      return false;
+    }
+
+    Release(handle.index);
+    return true;
+  }
+
   //! \brief Removes the given range from the bag.
   //!
   //! \param[in] base The base of the range to be removed. May not be null.
@@ -180,9 +257,39 @@ class TSimpleAddressRangeBag {
                                          base::checked_cast<uint64_t>(size)));
   }
 
-
  private:
+  // Deactivates the entry at |index| and returns it to the free list. Its
+  // generation is advanced so that handles to the removed range become stale.
+  void Release(uint32_t index) {
+    entries_[index].base = entries_[index].size = 0;
+    ++generations_[index];
+    next_free_[index] = free_head_;
+    free_head_ = index + 1;
+    --count_;
+  }
+
+  // entries_ must remain the first member so that the entries can be read by
+  // another process with a single read at the start of the object.
   Entry entries_[NumEntries];
+
+  // The generation of each entry, advanced each time that its range is
+  // removed.
+  uint32_t generations_[NumEntries];
+
+  // For each free entry, the index plus one of the next free entry, or 0 at
+  // the end of the free list.
+  uint32_t next_free_[NumEntries];
+
+  // The index plus one of the first entry in the free list, or 0 if the list is
+  // empty.
+  uint32_t free_head_;
+
+  // The number of entries at the start of entries_ that have ever been used.
+  // Entries beyond this are free but not on the free list.
+  uint32_t used_;
+
+  // The number of active entries.
+  uint32_t count_;
 };
 
 //! \brief A TSimpleAddressRangeBag with default template parameters.
@@ -14,6 +14,8 @@
 
 #include "client/simple_address_range_bag.h"
 
+#include <vector>
+
 #include "base/logging.h"
 #include "gtest/gtest.h"
 #include "test/gtest_death_check.h"
@@ -104,6 +106,66 @@ TEST(SimpleAddressRangeBag, OutOfSpace) {
   EXPECT_FALSE(bag.Remove(CheckedRange<uint64_t>(5, 6)));
 }
 
+TEST(SimpleAddressRangeBag, Handles) {
+  TSimpleAddressRangeBag<2> bag;
+  TSimpleAddressRangeBag<2>::Handle handle_1;
+  TSimpleAddressRangeBag<2>::Handle handle_2;
+  EXPECT_TRUE(bag.Insert(CheckedRange<uint64_t>(1, 2), &handle_1));
+  EXPECT_TRUE(bag.Insert(CheckedRange<uint64_t>(3, 4), &handle_2));
+  EXPECT_EQ(bag.GetCount(), 2u);
+
+  EXPECT_TRUE(bag.Remove(handle_1));
+  EXPECT_EQ(bag.GetCount(), 1u);
+
+  // A removed range’s handle is stale, even once its entry has been reused.
+  EXPECT_FALSE(bag.Remove(handle_1));
+  TSimpleAddressRangeBag<2>::Handle handle_3;
+  EXPECT_TRUE(bag.Insert(CheckedRange<uint64_t>(5, 6), &handle_3));
+  EXPECT_EQ(handle_3.index, handle_1.index);
+  EXPECT_FALSE(bag.Remove(handle_1));
+  EXPECT_EQ(bag.GetCount(), 2u);
+
+  // Ranges inserted with handles may also be removed by address.
+  EXPECT_TRUE(bag.Remove(CheckedRange<uint64_t>(5, 6)));
+  EXPECT_FALSE(bag.Remove(handle_3));
+  EXPECT_TRUE(bag.Remove(handle_2));
+  EXPECT_EQ(bag.GetCount(), 0u);
+  EXPECT_FALSE(TSimpleAddressRangeBag<2>::Iterator(bag).Next());
+}
+
+TEST(SimpleAddressRangeBag, Churn) {
+  constexpr size_t kNumEntries = 1024;
+  using TestBag = TSimpleAddressRangeBag<kNumEntries>;
+  TestBag bag;
+  std::vector<TestBag::Handle> handles(kNumEntries);
+
+  for (int round = 0; round < 3; ++round) {
+    for (size_t index = 0; index < handles.size(); ++index) {
+      ASSERT_TRUE(bag.Insert(CheckedRange<uint64_t>(0x1000 * (index + 1), 16),
+                             &handles[index]));
+    }
+    EXPECT_EQ(bag.GetCount(), kNumEntries);
+    EXPECT_FALSE(bag.Insert(CheckedRange<uint64_t>(1, 1)));
+
+    // Every range can be found by iteration.
+    size_t found = 0;
+    TestBag::Iterator iterator(bag);
+    while (iterator.Next()) {
+      ++found;
+    }
+    EXPECT_EQ(found, kNumEntries);
+
+    for (size_t index = 0; index < handles.size(); index += 2) {
+      EXPECT_TRUE(bag.Remove(handles[index]));
+    }
+    EXPECT_EQ(bag.GetCount(), kNumEntries / 2);
+    for (size_t index = 1; index < handles.size(); index += 2) {
+      EXPECT_TRUE(bag.Remove(handles[index]));
+    }
+    EXPECT_EQ(bag.GetCount(), 0u);
+  }
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
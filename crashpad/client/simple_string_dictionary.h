@@ -27,6 +27,9 @@
 
 namespace crashpad {
 
+template <size_t KeySize, size_t ValueSize, size_t NumEntries>
+class TIndexedSimpleStringDictionary;
+
 //! \brief A map/dictionary collection implementation using a fixed amount of
 //!     storage, so that it does not perform any dynamic allocations for its
 //!     operations.
@@ -39,6 +42,9 @@ namespace crashpad {
 //! glyphs, and include space for a trailing `NUL` byte. This gives space for
 //! `KeySize - 1` and `ValueSize - 1` characters in an entry. \a NumEntries is
 //! the total number of entries that will fit in the map.
+//!
+//! Lookups scan every entry. For dictionaries updated on a hot path, see
+//! TIndexedSimpleStringDictionary.
 template <size_t KeySize = 256, size_t ValueSize = 256, size_t NumEntries = 64>
 class TSimpleStringDictionary {
  public:
@@ -236,6 +242,8 @@ class TSimpleStringDictionary {
   }
 
  private:
+  friend class TIndexedSimpleStringDictionary<KeySize, ValueSize, NumEntries>;
+
   static void SetFromStringPiece(base::StringPiece src,
                                  char* dst,
                                  size_t dst_size) {
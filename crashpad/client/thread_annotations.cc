@@ -0,0 +1,166 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/thread_annotations.h"
+
+#include <type_traits>
+
+#include "base/logging.h"
+#include "base/threading/thread_local_storage.h"
+#include "build/build_config.h"
+#include "client/crashpad_info.h"
+
+#if defined(OS_MACOSX)
+#include <errno.h>
+#include <pthread.h>
+#elif defined(OS_WIN)
+#include <windows.h>
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace crashpad {
+
+namespace {
+
+// Returns the ID that the handler reports as ThreadSnapshot::ThreadID() for
+// the calling thread.
+uint64_t CurrentThreadID() {
+#if defined(OS_MACOSX)
+  uint64_t thread_id;
+  errno = pthread_threadid_np(pthread_self(), &thread_id);
+  PCHECK(errno == 0) << "pthread_threadid_np";
+  return thread_id;
+#elif defined(OS_WIN)
+  return GetCurrentThreadId();
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+  return syscall(SYS_gettid);
+#endif
+}
+
+class CurrentThreadAnnotationsSlot {
+ public:
+  static CurrentThreadAnnotationsSlot* GetInstance() {
+    static auto slot = new CurrentThreadAnnotationsSlot();
+    return slot;
+  }
+
+  ThreadAnnotations* Get() {
+    return reinterpret_cast<ThreadAnnotations*>(tls_.Get());
+  }
+
+  void Set(ThreadAnnotations* thread_annotations) {
+    tls_.Set(thread_annotations);
+  }
+
+ private:
+  CurrentThreadAnnotationsSlot() {
+    DCHECK(!tls_.initialized());
+    tls_.Initialize(nullptr);
+    DCHECK(tls_.initialized());
+  }
+
+  ~CurrentThreadAnnotationsSlot() = delete;
+
+  static base::ThreadLocalStorage::StaticSlot tls_;
+
+  DISALLOW_COPY_AND_ASSIGN(CurrentThreadAnnotationsSlot);
+};
+
+// static
+base::ThreadLocalStorage::StaticSlot CurrentThreadAnnotationsSlot::tls_ =
+    TLS_INITIALIZER;
+
+}  // namespace
+
+ThreadAnnotationRegistry::Slot::Slot()
+    : thread_id(0), link_node(nullptr), annotations() {}
+
+ThreadAnnotationRegistry::Slot::~Slot() {}
+
+// static
+ThreadAnnotationRegistry* ThreadAnnotationRegistry::GetInstance() {
+  static ThreadAnnotationRegistry* registry = []() {
+    auto registry = new ThreadAnnotationRegistry();
+    CrashpadInfo::GetCrashpadInfo()->set_thread_annotations(registry);
+    return registry;
+  }();
+  return registry;
+}
+
+ThreadAnnotationRegistry::ThreadAnnotationRegistry() : head_(nullptr) {
+  static_assert(std::is_standard_layout<ThreadAnnotationRegistry>::value,
+                "ThreadAnnotationRegistry must be standard layout");
+  static_assert(std::is_standard_layout<Slot>::value,
+                "Slot must be standard layout");
+}
+
+ThreadAnnotationRegistry::Slot* ThreadAnnotationRegistry::Claim(
+    uint64_t thread_id) {
+  DCHECK_NE(thread_id, 0u);
+
+  Slot* head = head_.load(std::memory_order_acquire);
+  for (Slot* slot = head; slot; slot = slot->link_node) {
+    uint64_t unowned = 0;
+    if (slot->thread_id.compare_exchange_strong(
+            unowned, thread_id, std::memory_order_acq_rel)) {
+      return slot;
+    }
+  }
+
+  // Every slot is owned. As with AnnotationList::Add(), the new slot must be
+  // fully initialized before it becomes reachable from the head.
+  Slot* slot = new Slot();
+  slot->thread_id.store(thread_id, std::memory_order_relaxed);
+  do {
+    slot->link_node = head;
+  } while (!head_.compare_exchange_weak(
+      head, slot, std::memory_order_release, std::memory_order_acquire));
+  return slot;
+}
+
+void ThreadAnnotationRegistry::Release(Slot* slot) {
+  slot->annotations.Clear();
+  slot->thread_id.store(0, std::memory_order_release);
+}
+
+ThreadAnnotations::ThreadAnnotations()
+    : slot_(ThreadAnnotationRegistry::GetInstance()->Claim(CurrentThreadID())) {
+  CurrentThreadAnnotationsSlot* current =
+      CurrentThreadAnnotationsSlot::GetInstance();
+  DCHECK(!current->Get());
+  current->Set(this);
+}
+
+ThreadAnnotations::~ThreadAnnotations() {
+  CurrentThreadAnnotationsSlot* current =
+      CurrentThreadAnnotationsSlot::GetInstance();
+  DCHECK_EQ(current->Get(), this);
+  current->Set(nullptr);
+
+  ThreadAnnotationRegistry::GetInstance()->Release(slot_);
+}
+
+// static
+ThreadAnnotations* ThreadAnnotations::Current() {
+  return CurrentThreadAnnotationsSlot::GetInstance()->Get();
+}
+
+void ThreadAnnotations::Add(Annotation* annotation) {
+  DCHECK_EQ(Current(), this);
+  slot_->annotations.Add(annotation);
+}
+
+}  // namespace crashpad
@@ -0,0 +1,138 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_CLIENT_THREAD_ANNOTATIONS_H_
+#define CRASHPAD_CLIENT_THREAD_ANNOTATIONS_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "base/macros.h"
+#include "client/annotation.h"
+#include "client/annotation_list.h"
+
+namespace crashpad {
+
+class ThreadAnnotations;
+
+//! \brief A registry of per-thread annotation slots, registered with
+//!     CrashpadInfo so that the Crashpad handler can read them out-of-process
+//!     and associate them with the threads that own them.
+//!
+//! Each slot carries the system thread ID of the thread that owns it, and an
+//! AnnotationList that only that thread modifies. Updating a thread’s
+//! annotations therefore needs no lock shared with other threads. Slots are
+//! allocated on demand, and are never freed: a slot released by a thread that
+//! has finished with it is reused by the next thread that needs one, so that
+//! the handler never encounters a slot that has been unlinked or deallocated.
+//!
+//! Clients do not normally interact with this class directly. Use
+//! ThreadAnnotations instead.
+//!
+//! The layout of this class and of its slots is read by the handler, and must
+//! be kept in sync with `snapshot/mac/process_types/annotation.proctype` and
+//! the process_types::ThreadAnnotationRegistry structure in
+//! `snapshot/win/pe_image_reader.h`.
+class ThreadAnnotationRegistry {
+ public:
+  //! \brief Returns the ThreadAnnotationRegistry for the calling module,
+  //!     creating it and registering it with the module’s CrashpadInfo
+  //!     structure if necessary.
+  //!
+  //! The registry is never destroyed.
+  static ThreadAnnotationRegistry* GetInstance();
+
+ private:
+  friend class ThreadAnnotations;
+
+  struct Slot {
+    Slot();
+    ~Slot();
+
+    //! \brief The system thread ID of the thread that owns the slot, or `0` if
+    //!     the slot is unowned. This is the value of
+    //!     ThreadSnapshot::ThreadID() for the owning thread.
+    std::atomic<uint64_t> thread_id;
+
+    //! \brief The next slot in the registry.
+    Slot* link_node;
+
+    //! \brief The annotations belonging to the owning thread.
+    AnnotationList annotations;
+
+    DISALLOW_COPY_AND_ASSIGN(Slot);
+  };
+
+  ThreadAnnotationRegistry();
+  ~ThreadAnnotationRegistry() = delete;
+
+  //! \brief Claims an unowned slot for \a thread_id, allocating a new one if
+  //!     none is available.
+  Slot* Claim(uint64_t thread_id);
+
+  //! \brief Releases \a slot, which must have been returned by Claim(),
+  //!     clearing its annotations.
+  void Release(Slot* slot);
+
+  std::atomic<Slot*> head_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadAnnotationRegistry);
+};
+
+//! \brief The annotations belonging to a single thread.
+//!
+//! While an object of this class exists, Annotation objects added to it are
+//! reported by the Crashpad handler as belonging to the thread that created
+//! it, in a per-thread annotation stream in the minidump file. This is
+//! intended for request-scoped state on worker threads: the worker registers
+//! its annotations once, and then sets and clears their values as it processes
+//! each request, without taking any lock.
+//!
+//! Only one object of this class may exist on a thread at a time, and it may
+//! only be used on the thread that created it.
+class ThreadAnnotations {
+ public:
+  ThreadAnnotations();
+  ~ThreadAnnotations();
+
+  //! \brief Returns the ThreadAnnotations object belonging to the calling
+  //!     thread, or `nullptr` if it has none.
+  static ThreadAnnotations* Current();
+
+  //! \brief Adds \a annotation to the calling thread’s annotations.
+  //!
+  //! \param[in] annotation The annotation to add. It must remain valid for the
+  //!     lifetime of this object, and must not already be in any
+  //!     AnnotationList.
+  void Add(Annotation* annotation);
+
+  //! \brief Returns the system thread ID under which the annotations are
+  //!     reported.
+  uint64_t thread_id() const {
+    return slot_->thread_id.load(std::memory_order_relaxed);
+  }
+
+  //! \brief Returns the calling thread’s annotations.
+  const AnnotationList& annotations() const { return slot_->annotations; }
+
+ private:
+  ThreadAnnotationRegistry::Slot* slot_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadAnnotations);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_CLIENT_THREAD_ANNOTATIONS_H_
@@ -0,0 +1,125 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "client/thread_annotations.h"
+
+#include <memory>
+#include <vector>
+
+#include "client/crashpad_info.h"
+#include "gtest/gtest.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+std::vector<const Annotation*> Collect(const AnnotationList& list) {
+  std::vector<const Annotation*> annotations;
+  AnnotationList::Iterator iterator(list);
+  while (const Annotation* annotation = iterator.Next()) {
+    annotations.push_back(annotation);
+  }
+  return annotations;
+}
+
+TEST(ThreadAnnotations, Current) {
+  EXPECT_FALSE(ThreadAnnotations::Current());
+
+  {
+    ThreadAnnotations thread_annotations;
+    EXPECT_EQ(ThreadAnnotations::Current(), &thread_annotations);
+    EXPECT_NE(thread_annotations.thread_id(), 0u);
+    EXPECT_TRUE(CrashpadInfo::GetCrashpadInfo()->thread_annotations());
+
+    StringAnnotation<16> request("request");
+    thread_annotations.Add(&request);
+    request.Set("GET /");
+
+    std::vector<const Annotation*> annotations =
+        Collect(thread_annotations.annotations());
+    ASSERT_EQ(annotations.size(), 1u);
+    EXPECT_EQ(annotations[0], &request);
+  }
+
+  EXPECT_FALSE(ThreadAnnotations::Current());
+}
+
+TEST(ThreadAnnotations, SlotReuse) {
+  const AnnotationList* first_list;
+  {
+    ThreadAnnotations thread_annotations;
+    first_list = &thread_annotations.annotations();
+
+    IntAnnotation count("count");
+    thread_annotations.Add(&count);
+  }
+
+  // A released slot is cleared, and reused by the next claimant.
+  ThreadAnnotations thread_annotations;
+  EXPECT_EQ(&thread_annotations.annotations(), first_list);
+  EXPECT_TRUE(Collect(thread_annotations.annotations()).empty());
+}
+
+class AnnotatingThread : public Thread {
+ public:
+  AnnotatingThread() : thread_id_(0), annotation_count_(0) {}
+  ~AnnotatingThread() override {}
+
+  uint64_t thread_id() const { return thread_id_; }
+  size_t annotation_count() const { return annotation_count_; }
+
+ private:
+  void ThreadMain() override {
+    ThreadAnnotations thread_annotations;
+    thread_id_ = thread_annotations.thread_id();
+
+    StringAnnotation<16> one("one");
+    IntAnnotation two("two");
+    thread_annotations.Add(&one);
+    thread_annotations.Add(&two);
+    annotation_count_ = Collect(thread_annotations.annotations()).size();
+  }
+
+  uint64_t thread_id_;
+  size_t annotation_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(AnnotatingThread);
+};
+
+TEST(ThreadAnnotations, Threads) {
+  ThreadAnnotations thread_annotations;
+
+  constexpr size_t kThreads = 4;
+  std::unique_ptr<AnnotatingThread> threads[kThreads];
+  for (auto& thread : threads) {
+    thread.reset(new AnnotatingThread());
+    thread->Start();
+  }
+  for (auto& thread : threads) {
+    thread->Join();
+  }
+
+  // Each thread’s annotations are kept apart from every other thread’s.
+  for (const auto& thread : threads) {
+    EXPECT_NE(thread->thread_id(), 0u);
+    EXPECT_NE(thread->thread_id(), thread_annotations.thread_id());
+    EXPECT_EQ(thread->annotation_count(), 2u);
+  }
+  EXPECT_TRUE(Collect(thread_annotations.annotations()).empty());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -43,6 +43,12 @@
 //! \sa MINIDUMP_LOCATION_DESCRIPTOR
 typedef uint32_t RVA;
 
+//! \brief A 64-bit offset within a minidump file.
+//!
+//! This is used in place of RVA by structures that may need to refer to data
+//! beyond the first 4GB of a minidump file.
+typedef uint64_t RVA64;
+
 //! \brief A pointer to a structure or union within a minidump file.
 struct __attribute__((packed, aligned(4))) MINIDUMP_LOCATION_DESCRIPTOR {
   //! \brief The size of the referenced structure or union, in bytes.
@@ -66,6 +72,22 @@ struct __attribute__((packed, aligned(4))) MINIDUMP_MEMORY_DESCRIPTOR {
   MINIDUMP_LOCATION_DESCRIPTOR Memory;
 };
 
+//! \brief A description of a region of memory whose snapshot is contained
+//!     within a minidump file’s MINIDUMP_MEMORY64_LIST.
+//!
+//! Unlike MINIDUMP_MEMORY_DESCRIPTOR, this structure does not locate the
+//! snapshot within the minidump file. The snapshots of every region in a
+//! MINIDUMP_MEMORY64_LIST are stored contiguously, in the order that the
+//! regions are listed, beginning at MINIDUMP_MEMORY64_LIST::BaseRva.
+struct __attribute__((packed, aligned(4))) MINIDUMP_MEMORY_DESCRIPTOR64 {
+  //! \brief The base address of the memory region in the address space of the
+  //!     process that the minidump file contains a snapshot of.
+  uint64_t StartOfMemoryRange;
+
+  //! \brief The size of the memory region, in bytes.
+  uint64_t DataSize;
+};
+
 //! \brief The top-level structure identifying a minidump file.
 //!
 //! This structure contains a pointer to the stream directory, a second-level
@@ -157,6 +179,9 @@ enum MINIDUMP_STREAM_TYPE {
   //! \brief The stream type for MINIDUMP_SYSTEM_INFO.
   SystemInfoStream = 7,
 
+  //! \brief The stream type for MINIDUMP_MEMORY64_LIST.
+  Memory64ListStream = 9,
+
   //! \brief The stream contains information about active `HANDLE`s.
   HandleDataStream = 12,
 
@@ -177,6 +202,9 @@ enum MINIDUMP_STREAM_TYPE {
   //! \brief The stream type for MINIDUMP_MEMORY_INFO_LIST.
   MemoryInfoListStream = 16,
 
+  //! \brief The stream type for MINIDUMP_THREAD_NAME_LIST.
+  ThreadNamesStream = 24,
+
   //! \brief Values greater than this value will not be used by the system
   //!     and can be used for custom user data streams.
   LastReservedStream = 0xffff,
@@ -412,6 +440,24 @@ struct __attribute__((packed, aligned(4))) MINIDUMP_THREAD_LIST {
   MINIDUMP_THREAD Threads[0];
 };
 
+//! \brief The name of a thread.
+struct __attribute__((packed, aligned(4))) MINIDUMP_THREAD_NAME {
+  //! \brief The identifier of the thread, matching MINIDUMP_THREAD::ThreadId.
+  uint32_t ThreadId;
+
+  //! \brief An offset to a MINIDUMP_STRING containing the thread’s name.
+  RVA64 RvaOfThreadName;
+};
+
+//! \brief The names of threads within the process.
+struct __attribute__((packed, aligned(4))) MINIDUMP_THREAD_NAME_LIST {
+  //! \brief The number of thread names present in the #ThreadNames array.
+  uint32_t NumberOfThreadNames;
+
+  //! \brief Structures identifying each named thread and its name.
+  MINIDUMP_THREAD_NAME ThreadNames[0];
+};
+
 //! \brief Information about an exception that occurred in the process.
 struct __attribute__((packed, aligned(4))) MINIDUMP_EXCEPTION {
   //! \brief The top-level exception code identifying the exception, in
@@ -633,6 +679,27 @@ struct __attribute__((packed, aligned(4))) MINIDUMP_MEMORY_LIST {
   MINIDUMP_MEMORY_DESCRIPTOR MemoryRanges[0];
 };
 
+//! \brief Information about memory regions within the process, whose
+//!     snapshots are stored contiguously at the end of the minidump file.
+//!
+//! This is the form used by minidump files identified as
+//! ::MiniDumpWithFullMemory in MINIDUMP_HEADER::Flags. Because memory regions
+//! are located by a single 64-bit offset rather than by a 32-bit offset each,
+//! the memory may extend beyond the first 4GB of the file.
+struct __attribute__((packed, aligned(4))) MINIDUMP_MEMORY64_LIST {
+  //! \brief The number of memory regions present in the #MemoryRanges array.
+  uint64_t NumberOfMemoryRanges;
+
+  //! \brief The offset of the snapshot of the first memory region from the
+  //!     beginning of the minidump file. The snapshot of each subsequent
+  //!     memory region immediately follows that of the region before it.
+  RVA64 BaseRva;
+
+  //! \brief Structures identifying each memory region present in the minidump
+  //!     file, in the order that their snapshots are stored.
+  MINIDUMP_MEMORY_DESCRIPTOR64 MemoryRanges[0];
+};
+
 //! \brief Contains the state of an individual system handle at the time the
 //!     snapshot was taken. This structure is Windows-specific.
 //!
@@ -1102,6 +1169,10 @@ enum MINIDUMP_TYPE {
   //!    MINIDUMP_MEMORY_DESCRIPTOR containing the 256 bytes centered around
   //!    the exception address or the instruction pointer.
   MiniDumpNormal = 0x00000000,
+
+  //! \brief A minidump file with a MINIDUMP_MEMORY64_LIST stream capturing
+  //!     most or all of the process’ memory.
+  MiniDumpWithFullMemory = 0x00000002,
 };
 
 #endif  // CRASHPAD_COMPAT_NON_WIN_DBGHELP_H_
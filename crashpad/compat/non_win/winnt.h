@@ -145,6 +145,7 @@
 #define MEM_PRIVATE 0x20000
 #define MEM_MAPPED 0x40000
 #define MEM_RESET 0x80000
+#define MEM_IMAGE 0x1000000
 //! \}
 
 //! \brief The maximum number of distinct identifiable features that could
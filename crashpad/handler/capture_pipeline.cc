@@ -0,0 +1,189 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/capture_pipeline.h"
+
+#include <deque>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/synchronization/lock.h"
+#include "util/stdlib/pointer_container.h"
+#include "util/synchronization/semaphore.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+
+// A bounded queue of jobs and the worker threads that run them.
+class CapturePipeline::Stage {
+ public:
+  using Handler = void (CapturePipeline::*)(std::unique_ptr<Job> job);
+
+  Stage(CapturePipeline* pipeline,
+        Handler handler,
+        size_t queue_capacity,
+        size_t thread_count)
+      : lock_(),
+        urgent_jobs_(),
+        jobs_(),
+        threads_(),
+        free_slots_(static_cast<int>(queue_capacity)),
+        queued_jobs_(0),
+        pipeline_(pipeline),
+        handler_(handler),
+        thread_count_(thread_count) {
+    DCHECK_GT(queue_capacity, 0u);
+    DCHECK_GT(thread_count, 0u);
+  }
+
+  ~Stage() { DCHECK(threads_.empty()); }
+
+  void Start() {
+    for (size_t index = 0; index < thread_count_; ++index) {
+      WorkerThread* thread = new WorkerThread(this);
+      threads_.push_back(thread);
+      thread->Start();
+    }
+  }
+
+  // Queues a null job for each worker thread, after every job already queued,
+  // and waits for the threads to reach them.
+  void Stop() {
+    for (size_t index = 0; index < threads_.size(); ++index) {
+      Push(nullptr, false);
+    }
+    for (WorkerThread* thread : threads_) {
+      thread->Join();
+    }
+    threads_.clear();
+  }
+
+  // Waits until there is room in the queue, then queues |job|.
+  void Push(std::unique_ptr<Job> job, bool urgent) {
+    free_slots_.Wait();
+    {
+      base::AutoLock auto_lock(lock_);
+      (urgent ? urgent_jobs_ : jobs_).push_back(std::move(job));
+    }
+    queued_jobs_.Signal();
+  }
+
+ private:
+  class WorkerThread : public Thread {
+   public:
+    explicit WorkerThread(Stage* stage) : Thread(), stage_(stage) {}
+    ~WorkerThread() override {}
+
+   private:
+    // Thread:
+    void ThreadMain() override {
+      while (std::unique_ptr<Job> job = stage_->Pop()) {
+        (stage_->pipeline_->*stage_->handler_)(std::move(job));
+      }
+    }
+
+    Stage* stage_;  // weak
+
+    DISALLOW_COPY_AND_ASSIGN(WorkerThread);
+  };
+
+  // Waits for a job, and returns the oldest urgent one, or the oldest one if
+  // none are urgent.
+  std::unique_ptr<Job> Pop() {
+    queued_jobs_.Wait();
+    std::unique_ptr<Job> job;
+    {
+      base::AutoLock auto_lock(lock_);
+      std::deque<std::unique_ptr<Job>>& queue =
+          urgent_jobs_.empty() ? jobs_ : urgent_jobs_;
+      DCHECK(!queue.empty());
+      job = std::move(queue.front());
+      queue.pop_front();
+    }
+    free_slots_.Signal();
+    return job;
+  }
+
+  base::Lock lock_;
+  // Access to these fields must be guarded by lock_.
+  std::deque<std::unique_ptr<Job>> urgent_jobs_;
+  std::deque<std::unique_ptr<Job>> jobs_;
+
+  PointerVector<WorkerThread> threads_;
+  Semaphore free_slots_;
+  Semaphore queued_jobs_;
+  CapturePipeline* pipeline_;  // weak
+  Handler handler_;
+  size_t thread_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(Stage);
+};
+
+CapturePipeline::CapturePipeline(size_t queue_capacity,
+                                 size_t serialize_thread_count,
+                                 size_t commit_thread_count)
+    : serialize_stage_(new Stage(this,
+                                 &CapturePipeline::SerializeJob,
+                                 queue_capacity,
+                                 serialize_thread_count)),
+      commit_stage_(new Stage(this,
+                              &CapturePipeline::CommitJob,
+                              queue_capacity,
+                              commit_thread_count)),
+      running_(false) {}
+
+CapturePipeline::~CapturePipeline() {
+  DCHECK(!running_);
+}
+
+void CapturePipeline::Start() {
+  DCHECK(!running_);
+  commit_stage_->Start();
+  serialize_stage_->Start();
+  running_ = true;
+}
+
+void CapturePipeline::Stop() {
+  DCHECK(running_);
+  running_ = false;
+
+  // Every job serialized is committed before the commit stage stops.
+  serialize_stage_->Stop();
+  commit_stage_->Stop();
+}
+
+void CapturePipeline::Submit(std::unique_ptr<Job> job, bool urgent) {
+  if (!running_) {
+    if (job->Serialize()) {
+      job->Commit();
+    }
+    return;
+  }
+
+  serialize_stage_->Push(std::move(job), urgent);
+}
+
+void CapturePipeline::SerializeJob(std::unique_ptr<Job> job) {
+  if (job->Serialize()) {
+    // Urgency only matters while jobs wait to be serialized, which is where
+    // the time is spent.
+    commit_stage_->Push(std::move(job), false);
+  }
+}
+
+void CapturePipeline::CommitJob(std::unique_ptr<Job> job) {
+  job->Commit();
+}
+
+}  // namespace crashpad
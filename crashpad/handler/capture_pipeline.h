@@ -0,0 +1,117 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_CAPTURE_PIPELINE_H_
+#define CRASHPAD_HANDLER_CAPTURE_PIPELINE_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+
+#include "base/macros.h"
+
+namespace crashpad {
+
+//! \brief Runs the stages of crash report capture that follow the release of
+//!     the target process on worker threads, so that captures overlap.
+//!
+//! Capturing a crash report proceeds in four stages:
+//!  1. The target is suspended, and everything needed from it is copied.
+//!  2. The target is resumed or terminated.
+//!  3. The minidump is serialized.
+//!  4. The report is committed to the database and the upload thread is
+//!     notified.
+//!
+//! Stages 1 and 2 run on the thread that received the exception, which ends
+//! them by handing a Job to Submit(). Stages 3 and 4 are each run by a pool of
+//! worker threads, fed by a bounded queue, so that the target is only frozen
+//! for stage 1 and several reports can be in different stages at once. A full
+//! queue makes the stage that feeds it wait, so that the memory held by
+//! captured reports waiting to be written is bounded.
+class CapturePipeline {
+ public:
+  //! \brief The work for one crash report, after its target has been released.
+  class Job {
+   public:
+    virtual ~Job() {}
+
+    //! \brief Serializes the report’s minidump.
+    //!
+    //! This is stage 3, and runs on a serialize worker thread.
+    //!
+    //! \return `true` if the report should be committed by Commit(). `false`
+    //!     if it couldn’t be serialized, in which case the job is destroyed.
+    virtual bool Serialize() = 0;
+
+    //! \brief Commits the serialized report.
+    //!
+    //! This is stage 4, and runs on a commit worker thread.
+    virtual void Commit() = 0;
+  };
+
+  //! \brief Constructs a new object.
+  //!
+  //! \param[in] queue_capacity The number of jobs that may wait for each stage
+  //!     before Submit(), or the stage before, waits.
+  //! \param[in] serialize_thread_count The number of jobs that may be
+  //!     serialized at once.
+  //! \param[in] commit_thread_count The number of jobs that may be committed
+  //!     at once.
+  CapturePipeline(size_t queue_capacity,
+                  size_t serialize_thread_count,
+                  size_t commit_thread_count);
+  ~CapturePipeline();
+
+  //! \brief Starts the worker threads.
+  //!
+  //! This method may only be called on a newly-constructed object.
+  void Start();
+
+  //! \brief Stops the worker threads once every job submitted has been run.
+  //!
+  //! This method must only be called after Start(), and once no more jobs will
+  //! be submitted. If Start() has been called, this method must be called
+  //! before destroying an object of this class.
+  void Stop();
+
+  //! \brief Runs stages 3 and 4 of \a job.
+  //!
+  //! This method returns once \a job is queued, waiting until there is room
+  //! for it. If the worker threads aren’t running, \a job is run to completion
+  //! on the calling thread instead.
+  //!
+  //! \param[in] job The job to run.
+  //! \param[in] urgent `true` if \a job should be run before any job that
+  //!     isn’t urgent, as for a crash, which is queued ahead of dumps requested
+  //!     by processes that continue to run.
+  void Submit(std::unique_ptr<Job> job, bool urgent);
+
+ private:
+  class Stage;
+
+  // Called by the serialize and commit stages’ worker threads for each job.
+  void SerializeJob(std::unique_ptr<Job> job);
+  void CommitJob(std::unique_ptr<Job> job);
+
+  std::unique_ptr<Stage> serialize_stage_;
+  std::unique_ptr<Stage> commit_stage_;
+  std::atomic<bool> running_;
+
+  DISALLOW_COPY_AND_ASSIGN(CapturePipeline);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_CAPTURE_PIPELINE_H_
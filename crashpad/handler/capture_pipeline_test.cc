@@ -0,0 +1,225 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/capture_pipeline.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/synchronization/lock.h"
+#include "gtest/gtest.h"
+#include "util/synchronization/semaphore.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+// Records the stages run for each job in a shared log.
+class Recorder {
+ public:
+  Recorder() : lock_(), log_() {}
+
+  void Record(const std::string& entry) {
+    base::AutoLock auto_lock(lock_);
+    log_.push_back(entry);
+  }
+
+  std::vector<std::string> log() {
+    base::AutoLock auto_lock(lock_);
+    return log_;
+  }
+
+ private:
+  base::Lock lock_;
+  std::vector<std::string> log_;
+
+  DISALLOW_COPY_AND_ASSIGN(Recorder);
+};
+
+class TestJob : public CapturePipeline::Job {
+ public:
+  TestJob(Recorder* recorder, const std::string& name, bool serializes)
+      : recorder_(recorder),
+        name_(name),
+        start_(nullptr),
+        started_(nullptr),
+        serializes_(serializes) {}
+
+  ~TestJob() override {}
+
+  // Makes Serialize() signal |started| and wait for |start|.
+  void SetGate(Semaphore* started, Semaphore* start) {
+    started_ = started;
+    start_ = start;
+  }
+
+  // CapturePipeline::Job:
+  bool Serialize() override {
+    if (started_) {
+      started_->Signal();
+    }
+    if (start_) {
+      start_->Wait();
+    }
+    recorder_->Record("serialize " + name_);
+    return serializes_;
+  }
+
+  void Commit() override { recorder_->Record("commit " + name_); }
+
+ private:
+  Recorder* recorder_;  // weak
+  std::string name_;
+  Semaphore* start_;  // weak
+  Semaphore* started_;  // weak
+  bool serializes_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestJob);
+};
+
+TEST(CapturePipeline, NotStarted) {
+  Recorder recorder;
+  CapturePipeline pipeline(1, 1, 1);
+
+  pipeline.Submit(std::make_unique<TestJob>(&recorder, "a", true), false);
+  pipeline.Submit(std::make_unique<TestJob>(&recorder, "b", false), false);
+
+  const std::vector<std::string> expected = {
+      "serialize a", "commit a", "serialize b"};
+  EXPECT_EQ(recorder.log(), expected);
+}
+
+TEST(CapturePipeline, RunsStagesInOrder) {
+  Recorder recorder;
+  CapturePipeline pipeline(4, 1, 1);
+  pipeline.Start();
+
+  pipeline.Submit(std::make_unique<TestJob>(&recorder, "a", true), false);
+  pipeline.Submit(std::make_unique<TestJob>(&recorder, "b", false), false);
+  pipeline.Submit(std::make_unique<TestJob>(&recorder, "c", true), false);
+
+  // Stop() returns once every job has been run.
+  pipeline.Stop();
+
+  const std::vector<std::string> log = recorder.log();
+  ASSERT_EQ(log.size(), 5u);
+
+  // With a single serialize thread, jobs are serialized in order.
+  std::vector<std::string> serialized;
+  std::vector<std::string> committed;
+  for (const std::string& entry : log) {
+    (entry.compare(0, 6, "commit") == 0 ? committed : serialized)
+        .push_back(entry);
+
+    // A job is only committed once it has been serialized.
+    if (entry == "commit a") {
+      EXPECT_NE(std::find(log.begin(), log.end(), "serialize a"), log.end());
+    }
+  }
+  const std::vector<std::string> expected_serialized = {
+      "serialize a", "serialize b", "serialize c"};
+  EXPECT_EQ(serialized, expected_serialized);
+  const std::vector<std::string> expected_committed = {"commit a",
+                                                       "commit c"};
+  EXPECT_EQ(committed, expected_committed);
+}
+
+TEST(CapturePipeline, SerializesConcurrently) {
+  Recorder recorder;
+  CapturePipeline pipeline(2, 2, 1);
+  pipeline.Start();
+
+  // Each job waits for the other to start serializing, which only happens if
+  // both are serialized at once.
+  Semaphore a_started(0);
+  Semaphore b_started(0);
+  auto a = std::make_unique<TestJob>(&recorder, "a", true);
+  a->SetGate(&a_started, &b_started);
+  auto b = std::make_unique<TestJob>(&recorder, "b", true);
+  b->SetGate(&b_started, &a_started);
+
+  pipeline.Submit(std::move(a), false);
+  pipeline.Submit(std::move(b), false);
+  pipeline.Stop();
+
+  EXPECT_EQ(recorder.log().size(), 4u);
+}
+
+TEST(CapturePipeline, UrgentFirst) {
+  Recorder recorder;
+  CapturePipeline pipeline(4, 1, 1);
+  pipeline.Start();
+
+  // Hold the serialize thread on the first job while the others are queued.
+  Semaphore started(0);
+  Semaphore start(0);
+  auto first = std::make_unique<TestJob>(&recorder, "first", true);
+  first->SetGate(&started, &start);
+  pipeline.Submit(std::move(first), false);
+  started.Wait();
+
+  pipeline.Submit(std::make_unique<TestJob>(&recorder, "dump", false), false);
+  pipeline.Submit(std::make_unique<TestJob>(&recorder, "crash", false), true);
+
+  start.Signal();
+  pipeline.Stop();
+
+  const std::vector<std::string> expected = {
+      "serialize first", "commit first", "serialize crash", "serialize dump"};
+  std::vector<std::string> log = recorder.log();
+
+  // The commit of the first job may happen at any point after it has been
+  // serialized.
+  ASSERT_EQ(log.size(), expected.size());
+  auto commit = std::find(log.begin(), log.end(), "commit first");
+  ASSERT_NE(commit, log.end());
+  log.erase(commit);
+  const std::vector<std::string> expected_serialized = {
+      "serialize first", "serialize crash", "serialize dump"};
+  EXPECT_EQ(log, expected_serialized);
+}
+
+TEST(CapturePipeline, BackPressure) {
+  Recorder recorder;
+  CapturePipeline pipeline(1, 1, 1);
+  pipeline.Start();
+
+  // Hold the serialize thread so that the queue fills.
+  Semaphore started(0);
+  Semaphore start(0);
+  auto first = std::make_unique<TestJob>(&recorder, "first", false);
+  first->SetGate(&started, &start);
+  pipeline.Submit(std::move(first), false);
+  started.Wait();
+
+  // This job fills the queue.
+  pipeline.Submit(std::make_unique<TestJob>(&recorder, "second", false),
+                  false);
+
+  // This job can’t be queued until the first one has been serialized, so it
+  // is submitted once there’s room, which Stop() waits for.
+  start.Signal();
+  pipeline.Submit(std::make_unique<TestJob>(&recorder, "third", false), false);
+  pipeline.Stop();
+
+  const std::vector<std::string> expected = {
+      "serialize first", "serialize second", "serialize third"};
+  EXPECT_EQ(recorder.log(), expected);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
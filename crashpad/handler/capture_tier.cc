@@ -0,0 +1,219 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/capture_tier.h"
+
+#include <limits>
+#include <set>
+
+#include "base/logging.h"
+#include "client/crash_report_database.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "util/misc/system_resources.h"
+
+namespace crashpad {
+
+namespace {
+
+constexpr uint64_t kMinuteNanoseconds = 60 * UINT64_C(1000000000);
+
+// The size that a report at CaptureTier::kStandard is held to.
+constexpr size_t kStandardSizeBudget = 4 * 1024 * 1024;
+
+// The bytes of each stack, other than the exception thread’s, written at
+// CaptureTier::kMinimal. This is enough for the frames nearest the stack
+// pointer.
+constexpr size_t kMinimalStackSizeLimit = 4096;
+
+// The load at which each tier is called for. A report is captured at the most
+// degraded tier for which any one measurement reaches its threshold.
+struct TierThresholds {
+  CaptureTier tier;
+  size_t pending_reports;
+  uint64_t available_disk_bytes;
+  int memory_load_percent;
+  size_t recent_crashes;
+};
+
+constexpr TierThresholds kTierThresholds[] = {
+    // A small report needs little memory to write, so memory alone never
+    // prevents one.
+    {CaptureTier::kCounterOnly, 500, 32 * 1024 * 1024, 101, 60},
+    {CaptureTier::kMinimal, 100, 256 * 1024 * 1024, 95, 20},
+    {CaptureTier::kStandard, 20, 1024 * 1024 * 1024, 85, 5},
+};
+
+// Crashes beyond the most that any threshold counts needn’t be remembered.
+constexpr size_t kMaxRecentCrashes = 60;
+
+class PendingReportCounter final
+    : public CrashReportDatabase::ListReportsDelegate {
+ public:
+  PendingReportCounter() : count_(0) {}
+  ~PendingReportCounter() {}
+
+  size_t count() const { return count_; }
+
+  // CrashReportDatabase::ListReportsDelegate:
+  bool ReportListed(
+      const CrashReportDatabase::ReportSummary& summary) override {
+    ++count_;
+    return true;
+  }
+
+ private:
+  size_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(PendingReportCounter);
+};
+
+}  // namespace
+
+const char* CaptureTierName(CaptureTier tier) {
+  switch (tier) {
+    case CaptureTier::kFull:
+      return "full";
+    case CaptureTier::kStandard:
+      return "standard";
+    case CaptureTier::kMinimal:
+      return "minimal";
+    case CaptureTier::kCounterOnly:
+      return "counter_only";
+  }
+
+  NOTREACHED();
+  return "unknown";
+}
+
+void ApplyCaptureTier(CaptureTier tier, MinidumpFileWriter* minidump) {
+  switch (tier) {
+    case CaptureTier::kFull:
+      break;
+
+    case CaptureTier::kStandard:
+      minidump->SetCollapseIdenticalStacks(true);
+      minidump->SetSizeBudget(kStandardSizeBudget);
+      break;
+
+    case CaptureTier::kMinimal:
+      minidump->SetStreamSelection(std::set<MinidumpStreamType>{
+          kMinidumpStreamTypeSystemInfo,
+          kMinidumpStreamTypeMiscInfo,
+          kMinidumpStreamTypeThreadList,
+          kMinidumpStreamTypeException,
+          kMinidumpStreamTypeModuleList,
+          kMinidumpStreamTypeCrashpadInfo,
+          kMinidumpStreamTypeCrashpadTopFrames,
+      });
+      minidump->SetCollapseIdenticalStacks(true);
+      minidump->SetStackSizeLimit(kMinimalStackSizeLimit);
+      break;
+
+    case CaptureTier::kCounterOnly:
+      NOTREACHED();
+      break;
+  }
+}
+
+CaptureLoad::CaptureLoad()
+    : pending_reports(0),
+      available_disk_bytes(std::numeric_limits<uint64_t>::max()),
+      memory_load_percent(0),
+      recent_crashes(0) {}
+
+CaptureTier CaptureTierForLoad(const CaptureLoad& load) {
+  for (const TierThresholds& thresholds : kTierThresholds) {
+    if (load.pending_reports >= thresholds.pending_reports ||
+        load.available_disk_bytes < thresholds.available_disk_bytes ||
+        load.memory_load_percent >= thresholds.memory_load_percent ||
+        load.recent_crashes >= thresholds.recent_crashes) {
+      return thresholds.tier;
+    }
+  }
+  return CaptureTier::kFull;
+}
+
+CaptureTierSelector::CaptureTierSelector(CrashReportDatabase* database,
+                                         const base::FilePath& database_path)
+    : lock_(),
+      database_path_(database_path),
+      recent_crash_times_(),
+      load_(),
+      last_measurement_time_(0),
+      database_(database),
+      last_tier_(CaptureTier::kFull),
+      measured_(false) {}
+
+CaptureTierSelector::~CaptureTierSelector() {}
+
+CaptureTier CaptureTierSelector::SelectTier(uint64_t now) {
+  base::AutoLock lock(lock_);
+
+  while (!recent_crash_times_.empty() &&
+         (now - recent_crash_times_.front() >= kMinuteNanoseconds ||
+          recent_crash_times_.size() >= kMaxRecentCrashes)) {
+    recent_crash_times_.pop_front();
+  }
+  recent_crash_times_.push_back(now);
+  load_.recent_crashes = recent_crash_times_.size();
+
+  if (!measured_ ||
+      now - last_measurement_time_ >= kMeasurementIntervalNanoseconds) {
+    MeasureLoad();
+    last_measurement_time_ = now;
+    measured_ = true;
+  }
+
+  // Only changes are logged, so that a storm doesn’t flood the log.
+  const CaptureTier tier = CaptureTierForLoad(load_);
+  if (tier != last_tier_) {
+    LOG(WARNING) << "capturing at tier " << CaptureTierName(tier) << ": "
+                 << load_.pending_reports << " pending reports, "
+                 << load_.available_disk_bytes << " bytes available, "
+                 << load_.memory_load_percent << "% memory load, "
+                 << load_.recent_crashes << " crashes in the last minute";
+    last_tier_ = tier;
+  }
+  return tier;
+}
+
+void CaptureTierSelector::MeasureLoad() {
+  // Anything that can’t be measured is taken not to be constrained, so that
+  // reports aren’t degraded without cause.
+  CaptureLoad load;
+  load.recent_crashes = load_.recent_crashes;
+
+  CrashReportDatabase::ReportFilter filter;
+  filter.completed = false;
+  PendingReportCounter counter;
+  if (database_->ListReports(filter, &counter) ==
+      CrashReportDatabase::kNoError) {
+    load.pending_reports = counter.count();
+  }
+
+  uint64_t available_disk_bytes;
+  if (GetAvailableDiskSpace(database_path_, &available_disk_bytes)) {
+    load.available_disk_bytes = available_disk_bytes;
+  }
+
+  int memory_load_percent;
+  if (GetSystemMemoryLoad(&memory_load_percent)) {
+    load.memory_load_percent = memory_load_percent;
+  }
+
+  load_ = load;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,142 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_CAPTURE_TIER_H_
+#define CRASHPAD_HANDLER_CAPTURE_TIER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+
+namespace crashpad {
+
+class CrashReportDatabase;
+class MinidumpFileWriter;
+
+//! \brief The process annotation that records the CaptureTier that a crash
+//!     report was written at, as named by CaptureTierName().
+constexpr char kCaptureTierAnnotation[] = "capture_tier";
+
+//! \brief How much of a crashed process a crash report captures.
+enum class CaptureTier {
+  //! \brief Everything that the handler is configured to capture.
+  kFull,
+
+  //! \brief Identical thread stacks are written once, and the minidump is held
+  //!     to a size budget, giving up memory data as
+  //!     MinidumpFileWriter::SetSizeBudget() does.
+  kStandard,
+
+  //! \brief The system information, thread contexts, exception, and module
+  //!     list, along with Crashpad’s own annotations and top frames. Only the
+  //!     stack of the thread that raised the exception is written in full.
+  kMinimal,
+
+  //! \brief No report is written. The crash is only counted, with
+  //!     Metrics::CaptureResult::kCounterOnly.
+  kCounterOnly,
+};
+
+//! \brief Returns the name of \a tier, as it is recorded in the
+//!     #kCaptureTierAnnotation process annotation.
+const char* CaptureTierName(CaptureTier tier);
+
+//! \brief Configures \a minidump to write a report at \a tier.
+//!
+//! This must be called before MinidumpFileWriter::InitializeFromSnapshot().
+//! \a tier must not be CaptureTier::kCounterOnly.
+void ApplyCaptureTier(CaptureTier tier, MinidumpFileWriter* minidump);
+
+//! \brief Measurements of the system’s load, from which CaptureTierForLoad()
+//!     determines the tier to capture at.
+//!
+//! A measurement that couldn’t be taken is left at its default value, which
+//! doesn’t contribute to the load.
+struct CaptureLoad {
+  CaptureLoad();
+
+  //! \brief The number of reports in the database waiting to be uploaded.
+  size_t pending_reports;
+
+  //! \brief The space available on the database’s volume, in bytes.
+  uint64_t available_disk_bytes;
+
+  //! \brief The proportion of the system’s memory in use, from `0` to `100`.
+  //!     See GetSystemMemoryLoad().
+  int memory_load_percent;
+
+  //! \brief The number of crashes handled in the last minute, including the
+  //!     one being captured.
+  size_t recent_crashes;
+};
+
+//! \brief Determines the tier to capture at under \a load.
+//!
+//! Each measurement raises the tier to at least the one that its own
+//! threshold calls for, so the most constrained resource decides.
+CaptureTier CaptureTierForLoad(const CaptureLoad& load);
+
+//! \brief Picks the tier of each crash report according to the load on the
+//!     system, so that a crash storm or a system that is out of disk space or
+//!     memory degrades reports instead of making matters worse.
+//!
+//! The crash rate is tracked from the crashes counted by SelectTier(), over a
+//! sliding window of a minute. The database’s pending reports, the space
+//! available on its volume, and the system’s memory load are measured at
+//! most once every #kMeasurementIntervalNanoseconds, so that a storm doesn’t
+//! pay for measuring them with every crash.
+//!
+//! This class is thread-safe.
+class CaptureTierSelector {
+ public:
+  //! \brief The interval at which the load on the system is measured again.
+  static constexpr uint64_t kMeasurementIntervalNanoseconds = 1000000000;
+
+  //! \param[in] database The database whose pending reports are counted.
+  //!     Weak.
+  //! \param[in] database_path The directory of \a database, whose volume’s
+  //!     available space is measured.
+  CaptureTierSelector(CrashReportDatabase* database,
+                      const base::FilePath& database_path);
+  ~CaptureTierSelector();
+
+  //! \brief Counts a crash and determines the tier to capture it at.
+  //!
+  //! \param[in] now The current time, from ClockMonotonicNanoseconds().
+  CaptureTier SelectTier(uint64_t now);
+
+ private:
+  //! \brief Measures everything in load_ but CaptureLoad::recent_crashes.
+  void MeasureLoad();
+
+  base::Lock lock_;
+  base::FilePath database_path_;
+  std::deque<uint64_t> recent_crash_times_;
+  CaptureLoad load_;
+  uint64_t last_measurement_time_;
+  CrashReportDatabase* database_;  // weak
+  CaptureTier last_tier_;
+  bool measured_;
+
+  DISALLOW_COPY_AND_ASSIGN(CaptureTierSelector);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_CAPTURE_TIER_H_
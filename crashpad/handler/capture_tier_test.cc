@@ -0,0 +1,85 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/capture_tier.h"
+
+#include <memory>
+
+#include "client/crash_report_database.h"
+#include "gtest/gtest.h"
+#include "test/scoped_temp_dir.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr uint64_t kSecond = 1000000000;
+constexpr uint64_t kStartTime = 1000 * kSecond;
+
+TEST(CaptureTier, ForLoad) {
+  CaptureLoad load;
+  EXPECT_EQ(CaptureTierForLoad(load), CaptureTier::kFull);
+
+  load.pending_reports = 20;
+  EXPECT_EQ(CaptureTierForLoad(load), CaptureTier::kStandard);
+
+  load.memory_load_percent = 95;
+  EXPECT_EQ(CaptureTierForLoad(load), CaptureTier::kMinimal);
+
+  // Memory load alone never stops a report from being written.
+  load.memory_load_percent = 100;
+  EXPECT_EQ(CaptureTierForLoad(load), CaptureTier::kMinimal);
+
+  load.available_disk_bytes = 1024 * 1024;
+  EXPECT_EQ(CaptureTierForLoad(load), CaptureTier::kCounterOnly);
+
+  load = CaptureLoad();
+  load.recent_crashes = 59;
+  EXPECT_EQ(CaptureTierForLoad(load), CaptureTier::kMinimal);
+  load.recent_crashes = 60;
+  EXPECT_EQ(CaptureTierForLoad(load), CaptureTier::kCounterOnly);
+}
+
+TEST(CaptureTier, Name) {
+  EXPECT_STREQ(CaptureTierName(CaptureTier::kFull), "full");
+  EXPECT_STREQ(CaptureTierName(CaptureTier::kStandard), "standard");
+  EXPECT_STREQ(CaptureTierName(CaptureTier::kMinimal), "minimal");
+  EXPECT_STREQ(CaptureTierName(CaptureTier::kCounterOnly), "counter_only");
+}
+
+TEST(CaptureTierSelector, CrashStorm) {
+  ScopedTempDir temp_dir;
+  std::unique_ptr<CrashReportDatabase> database(
+      CrashReportDatabase::Initialize(temp_dir.path()));
+  ASSERT_TRUE(database);
+  CaptureTierSelector selector(database.get(), temp_dir.path());
+
+  // The system’s load may degrade reports, but an empty database on a volume
+  // with room for it never stops one from being written on its own.
+  EXPECT_NE(selector.SelectTier(kStartTime), CaptureTier::kCounterOnly);
+
+  for (int index = 1; index < 59; ++index) {
+    selector.SelectTier(kStartTime + index * kSecond / 2);
+  }
+  EXPECT_EQ(selector.SelectTier(kStartTime + 30 * kSecond),
+            CaptureTier::kCounterOnly);
+
+  // Once the storm passes, crashes drop out of the window.
+  EXPECT_NE(selector.SelectTier(kStartTime + 200 * kSecond),
+            CaptureTier::kCounterOnly);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,116 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/client_dump_quota.h"
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+namespace {
+
+constexpr time_t kMinuteSeconds = 60;
+constexpr time_t kHourSeconds = 60 * 60;
+
+}  // namespace
+
+ClientDumpQuota::ClientDumpQuota(uint32_t max_dumps_per_minute,
+                                 uint64_t max_bytes_per_hour)
+    : lock_(),
+      clients_(),
+      max_bytes_per_hour_(max_bytes_per_hour),
+      max_dumps_per_minute_(max_dumps_per_minute) {}
+
+ClientDumpQuota::~ClientDumpQuota() {}
+
+bool ClientDumpQuota::TryAcquire(uint64_t client_id, time_t now) {
+  base::AutoLock lock(lock_);
+
+  auto it = clients_.find(client_id);
+  if (it == clients_.end()) {
+    EvictLocked(now);
+    Usage usage = {};
+    usage.minute_start = now;
+    usage.hour_start = now;
+    it = clients_.insert(std::make_pair(client_id, usage)).first;
+  }
+
+  Usage& usage = it->second;
+  if (now - usage.minute_start >= kMinuteSeconds || now < usage.minute_start) {
+    usage.minute_start = now;
+    usage.dumps = 0;
+  }
+  if (now - usage.hour_start >= kHourSeconds || now < usage.hour_start) {
+    usage.hour_start = now;
+    usage.bytes = 0;
+  }
+
+  if ((max_dumps_per_minute_ && usage.dumps >= max_dumps_per_minute_) ||
+      (max_bytes_per_hour_ && usage.bytes >= max_bytes_per_hour_)) {
+    return false;
+  }
+
+  ++usage.dumps;
+  usage.last_dump = now;
+  return true;
+}
+
+void ClientDumpQuota::RecordBytes(uint64_t client_id,
+                                  uint64_t bytes,
+                                  time_t now) {
+  base::AutoLock lock(lock_);
+
+  // The client may have been evicted since TryAcquire() if many others were
+  // seen in the meantime, in which case its dump goes uncounted.
+  auto it = clients_.find(client_id);
+  if (it == clients_.end()) {
+    return;
+  }
+
+  Usage& usage = it->second;
+  if (now - usage.hour_start >= kHourSeconds || now < usage.hour_start) {
+    usage.hour_start = now;
+    usage.bytes = 0;
+  }
+  usage.bytes += bytes;
+}
+
+void ClientDumpQuota::EvictLocked(time_t now) {
+  lock_.AssertAcquired();
+  if (clients_.size() < kMaxClients) {
+    return;
+  }
+
+  for (auto it = clients_.begin(); it != clients_.end();) {
+    if (now - it->second.minute_start >= kMinuteSeconds &&
+        now - it->second.hour_start >= kHourSeconds) {
+      it = clients_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (clients_.size() >= kMaxClients) {
+    auto oldest = clients_.begin();
+    for (auto it = clients_.begin(); it != clients_.end(); ++it) {
+      if (it->second.last_dump < oldest->second.last_dump) {
+        oldest = it;
+      }
+    }
+    clients_.erase(oldest);
+  }
+  DCHECK_LT(clients_.size(), kMaxClients);
+}
+
+}  // namespace crashpad
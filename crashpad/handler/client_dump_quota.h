@@ -0,0 +1,100 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_CLIENT_DUMP_QUOTA_H_
+#define CRASHPAD_HANDLER_CLIENT_DUMP_QUOTA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <map>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+
+namespace crashpad {
+
+//! \brief Limits how many dumps each client of a shared handler may have taken
+//!     without crashing, so that one client requesting dumps in a loop can’t
+//!     monopolize the handler’s capacity to write and upload reports.
+//!
+//! Clients are identified by process ID. Each client may have up to a set
+//! number of dumps taken per minute, and up to a set number of bytes of
+//! minidump written per hour. Both windows begin with the first dump counted
+//! in them. A crash ends its process, so crashes are never subject to the
+//! quota.
+//!
+//! At most #kMaxClients clients are tracked. When more have dumps taken,
+//! clients whose windows have both ended are forgotten first, followed by the
+//! client that had a dump taken least recently.
+//!
+//! This class is thread-safe.
+class ClientDumpQuota {
+ public:
+  //! \brief The maximum number of clients whose usage is tracked at once.
+  static constexpr size_t kMaxClients = 256;
+
+  //! \param[in] max_dumps_per_minute The number of dumps that each client may
+  //!     have taken in each minute, or `0` for no limit.
+  //! \param[in] max_bytes_per_hour The number of bytes of minidump that may be
+  //!     written for each client in each hour, or `0` for no limit. A dump is
+  //!     refused once the limit has been reached, so the dump that crosses it
+  //!     is still taken.
+  ClientDumpQuota(uint32_t max_dumps_per_minute, uint64_t max_bytes_per_hour);
+  ~ClientDumpQuota();
+
+  //! \brief Determines whether a client may have a dump taken, counting the
+  //!     dump against its quota if so.
+  //!
+  //! \param[in] client_id The client’s process ID.
+  //! \param[in] now The current time.
+  //!
+  //! \return `true` if the dump should be taken. `false` if the client has
+  //!     exhausted its quota for the current minute or hour.
+  bool TryAcquire(uint64_t client_id, time_t now);
+
+  //! \brief Counts the size of a dump allowed by TryAcquire() against the
+  //!     client’s quota.
+  //!
+  //! \param[in] client_id The client’s process ID.
+  //! \param[in] bytes The size of the minidump written.
+  //! \param[in] now The current time.
+  void RecordBytes(uint64_t client_id, uint64_t bytes, time_t now);
+
+ private:
+  struct Usage {
+    time_t minute_start;
+    uint32_t dumps;
+    time_t hour_start;
+    uint64_t bytes;
+    time_t last_dump;
+  };
+
+  //! \brief Forgets clients until there’s room to track another.
+  //!
+  //! lock_ must be held.
+  void EvictLocked(time_t now);
+
+  base::Lock lock_;
+  std::map<uint64_t, Usage> clients_;
+  const uint64_t max_bytes_per_hour_;
+  const uint32_t max_dumps_per_minute_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClientDumpQuota);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_CLIENT_DUMP_QUOTA_H_
@@ -0,0 +1,80 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/client_dump_quota.h"
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr time_t kStartTime = 1000000;
+
+TEST(ClientDumpQuota, DumpsPerMinute) {
+  ClientDumpQuota quota(2, 0);
+
+  EXPECT_TRUE(quota.TryAcquire(1, kStartTime));
+  EXPECT_TRUE(quota.TryAcquire(1, kStartTime + 1));
+  EXPECT_FALSE(quota.TryAcquire(1, kStartTime + 2));
+
+  // Other clients have their own quotas.
+  EXPECT_TRUE(quota.TryAcquire(2, kStartTime + 2));
+
+  // The window begins with the first dump counted in it.
+  EXPECT_FALSE(quota.TryAcquire(1, kStartTime + 59));
+  EXPECT_TRUE(quota.TryAcquire(1, kStartTime + 60));
+}
+
+TEST(ClientDumpQuota, BytesPerHour) {
+  ClientDumpQuota quota(0, 1000);
+
+  EXPECT_TRUE(quota.TryAcquire(1, kStartTime));
+  quota.RecordBytes(1, 600, kStartTime);
+  EXPECT_TRUE(quota.TryAcquire(1, kStartTime + 1));
+  quota.RecordBytes(1, 600, kStartTime + 1);
+
+  // The dump that crossed the limit was taken, but no more are.
+  EXPECT_FALSE(quota.TryAcquire(1, kStartTime + 2));
+  EXPECT_FALSE(quota.TryAcquire(1, kStartTime + 60 * 60 - 1));
+  EXPECT_TRUE(quota.TryAcquire(1, kStartTime + 60 * 60));
+}
+
+TEST(ClientDumpQuota, Unlimited) {
+  ClientDumpQuota quota(0, 0);
+  for (int index = 0; index < 100; ++index) {
+    EXPECT_TRUE(quota.TryAcquire(1, kStartTime));
+    quota.RecordBytes(1, 1 << 20, kStartTime);
+  }
+}
+
+TEST(ClientDumpQuota, Eviction) {
+  ClientDumpQuota quota(1, 0);
+
+  for (size_t client = 0; client < ClientDumpQuota::kMaxClients; ++client) {
+    EXPECT_TRUE(quota.TryAcquire(client, kStartTime + client));
+    EXPECT_FALSE(quota.TryAcquire(client, kStartTime + client));
+  }
+
+  // Tracking one more client forgets the one that had a dump taken least
+  // recently, so it starts over.
+  const time_t now = kStartTime + ClientDumpQuota::kMaxClients;
+  EXPECT_TRUE(quota.TryAcquire(ClientDumpQuota::kMaxClients, now));
+  EXPECT_TRUE(quota.TryAcquire(0, now));
+  EXPECT_FALSE(quota.TryAcquire(ClientDumpQuota::kMaxClients, now));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
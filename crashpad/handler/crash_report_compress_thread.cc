@@ -0,0 +1,159 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/crash_report_compress_thread.h"
+
+#include <stdio.h>
+
+#include <memory>
+
+#include "base/logging.h"
+#include "handler/crash_report_upload_thread.h"
+#include "util/file/block_compressed_file_writer.h"
+#include "util/file/file_io.h"
+#include "util/file/file_reader.h"
+#include "util/file/paged_file_writer.h"
+#include "util/file/string_file.h"
+#include "util/misc/trace_event.h"
+#include "util/thread/thread_priority.h"
+
+namespace crashpad {
+
+CrashReportCompressThread::CrashReportCompressThread(
+    CrashReportDatabase* database,
+    PageStore* page_store,
+    CrashReportUploadThread* upload_thread)
+    : thread_(WorkerThread::kIndefiniteWait, this),
+      new_reports_(),
+      database_(database),
+      page_store_(page_store),
+      upload_thread_(upload_thread),
+      priority_lowered_(false) {}
+
+CrashReportCompressThread::~CrashReportCompressThread() {}
+
+void CrashReportCompressThread::Start() {
+  thread_.Start(WorkerThread::kIndefiniteWait);
+}
+
+void CrashReportCompressThread::Stop() {
+  thread_.Stop();
+
+  // Don’t leave reports that arrived too late to be compressed unfinished.
+  while (std::unique_ptr<QueuedReport> queued_report = new_reports_.Pop()) {
+    ReportPending(queued_report->report);
+  }
+}
+
+void CrashReportCompressThread::FinishReport(
+    CrashReportDatabase::NewReport* report) {
+  new_reports_.Push(std::unique_ptr<QueuedReport>(new QueuedReport(report)));
+  thread_.DoWorkNow();
+}
+
+bool CrashReportCompressThread::CompressReport(
+    CrashReportDatabase::NewReport* report) {
+  ScopedTraceEvent trace_event(TraceEvent::kCompress, &report->uuid);
+
+  // The compressed report is built in memory, so that failures up to the point
+  // that the uncompressed report is replaced leave it intact. The report’s own
+  // handle is open only for writing, so it is read through another.
+  FileReader reader;
+  if (!reader.Open(report->path)) {
+    return true;
+  }
+
+  // A paged report’s pages are held in the page store as they are written, and
+  // only its index is built in memory. Pages stored for a report that is then
+  // left as it was are removed when the page store is next pruned.
+  StringFile compressed;
+  std::unique_ptr<BlockCompressedFileWriter> compressed_writer;
+  std::unique_ptr<PagedFileWriter> paged_writer;
+  FileWriterInterface* writer;
+  if (page_store_) {
+    paged_writer.reset(new PagedFileWriter(&compressed, page_store_));
+    writer = paged_writer.get();
+  } else {
+    compressed_writer.reset(new BlockCompressedFileWriter(
+        &compressed, BlockCompressedFileWriter::kDefaultBlockSize));
+    writer = compressed_writer.get();
+  }
+
+  FileOffset uncompressed_size = 0;
+  char buffer[4096];
+  FileOperationResult bytes;
+  while ((bytes = reader.Read(buffer, sizeof(buffer))) > 0) {
+    if (!writer->Write(buffer, bytes)) {
+      return true;
+    }
+    uncompressed_size += bytes;
+  }
+  if (bytes < 0 ||
+      !(paged_writer ? paged_writer->Close() : compressed_writer->Close())) {
+    return true;
+  }
+
+  if (compressed.string().size() >=
+      static_cast<uint64_t>(uncompressed_size)) {
+    return true;
+  }
+
+  // The report is rewritten through its own handle, which any lock the
+  // database holds on the file is tied to.
+  return LoggingSeekFile(report->handle, 0, SEEK_SET) == 0 &&
+         LoggingTruncateFile(report->handle) &&
+         LoggingWriteFile(report->handle,
+                          compressed.string().data(),
+                          compressed.string().size());
+}
+
+void CrashReportCompressThread::ReportPending(
+    CrashReportDatabase::NewReport* report) {
+  UUID uuid;
+  CrashReportDatabase::OperationStatus database_status;
+  {
+    ScopedTraceEvent trace_event(TraceEvent::kDatabaseCommit, &report->uuid);
+    database_status = database_->FinishedWritingCrashReport(report, &uuid);
+  }
+  if (database_status != CrashReportDatabase::kNoError) {
+    LOG(ERROR) << "FinishedWritingCrashReport failed";
+    return;
+  }
+
+  upload_thread_->ReportPending(uuid);
+}
+
+void CrashReportCompressThread::DoWork(const WorkerThread* thread) {
+  if (!priority_lowered_) {
+    LowerThreadPriority();
+    priority_lowered_ = true;
+  }
+
+  while (std::unique_ptr<QueuedReport> queued_report = new_reports_.Pop()) {
+    CrashReportDatabase::NewReport* report = queued_report->report;
+
+    // Once the thread is stopping, the remaining reports are finished as they
+    // are.
+    if (thread->is_running() && !CompressReport(report)) {
+      // A report that was partly rewritten can’t be trusted.
+      LOG(ERROR) << "failed to compress report " << report->uuid.ToString();
+      database_->ErrorWritingCrashReport(report);
+      continue;
+    }
+
+    ReportPending(report);
+  }
+}
+
+}  // namespace crashpad
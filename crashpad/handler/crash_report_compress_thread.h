@@ -0,0 +1,134 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_CRASH_REPORT_COMPRESS_THREAD_H_
+#define CRASHPAD_HANDLER_CRASH_REPORT_COMPRESS_THREAD_H_
+
+#include "base/macros.h"
+#include "client/crash_report_database.h"
+#include "util/thread/mpsc_queue.h"
+#include "util/thread/worker_thread.h"
+
+namespace crashpad {
+
+class CrashReportUploadThread;
+class PageStore;
+
+//! \brief A thread that compresses newly-written crash reports before they are
+//!     made available for upload.
+//!
+//! Reports handed to FinishReport() are rewritten in place as
+//! block-compressed files, as written by BlockCompressedFileWriter, on a
+//! thread running at the lowest available priority. Each report is then passed
+//! to CrashReportDatabase::FinishedWritingCrashReport() and
+//! CrashReportUploadThread::ReportPending(), exactly as if it had just been
+//! written. The upload thread recognizes compressed reports and sends their
+//! compressed data without compressing it again.
+//!
+//! When a PageStore is given, reports are instead rewritten as paged files, as
+//! written by PagedFileWriter, so that their pages are shared with those of
+//! other reports. The upload thread reassembles these from the same PageStore.
+//!
+//! Reports are compressed before they become pending, rather than after,
+//! because the database may move a pending report or read it at any time from
+//! another thread or process, and a report that has not been finished is owned
+//! only by its writer.
+class CrashReportCompressThread : public WorkerThread::Delegate {
+ public:
+  //! \brief Constructs a new object.
+  //!
+  //! \param[in] database The database that the reports were prepared in.
+  //! \param[in] page_store The store to hold the pages of paged reports in,
+  //!     or `nullptr` to compress reports instead. This object does not take
+  //!     ownership of \a page_store, which must outlive it.
+  //! \param[in] upload_thread The upload thread to notify once each report is
+  //!     pending.
+  CrashReportCompressThread(CrashReportDatabase* database,
+                            PageStore* page_store,
+                            CrashReportUploadThread* upload_thread);
+  ~CrashReportCompressThread();
+
+  //! \brief Starts a dedicated compression thread.
+  //!
+  //! This method may only be be called on a newly-constructed object or after
+  //! a call to Stop().
+  void Start();
+
+  //! \brief Stops the compression thread.
+  //!
+  //! Any reports not yet compressed are finished uncompressed, so that none
+  //! are lost.
+  //!
+  //! This method must only be called after Start(). If Start() has been called,
+  //! this method must be called before destroying an object of this class.
+  //!
+  //! This method may be called from any thread other than the compression
+  //! thread. It is expected to only be called from the same thread that called
+  //! Start().
+  void Stop();
+
+  //! \brief Compresses \a report and makes it pending.
+  //!
+  //! This is called in place of
+  //! CrashReportDatabase::FinishedWritingCrashReport() once a report has been
+  //! written in its entirety.
+  //!
+  //! \param[in] report A NewReport obtained from the database given to the
+  //!     constructor with CrashReportDatabase::PrepareNewCrashReport(). This
+  //!     object takes ownership of it, finishing it on the compression thread.
+  //!
+  //! This method may be called from any thread.
+  void FinishReport(CrashReportDatabase::NewReport* report);
+
+ private:
+  //! \brief Compresses \a report in place, or rewrites it as a paged file if
+  //!     there is a page store.
+  //!
+  //! The report is left as it is if rewriting it would not make it smaller, or
+  //! if it could not be rewritten.
+  //!
+  //! \return `true` if \a report is intact, compressed or not. `false` if
+  //!     rewriting it failed, with a message logged, in which case its contents
+  //!     are indeterminate.
+  bool CompressReport(CrashReportDatabase::NewReport* report);
+
+  //! \brief A report passed to FinishReport(), in new_reports_.
+  struct QueuedReport : public MPSCQueueNode {
+    explicit QueuedReport(CrashReportDatabase::NewReport* report)
+        : MPSCQueueNode(), report(report) {}
+
+    CrashReportDatabase::NewReport* report;  // owned by this object
+  };
+
+  //! \brief Calls CrashReportDatabase::FinishedWritingCrashReport() with \a
+  //!     report, and CrashReportUploadThread::ReportPending() with its UUID.
+  void ReportPending(CrashReportDatabase::NewReport* report);
+
+  // WorkerThread::Delegate:
+  //! \brief Compresses and finishes the reports passed to FinishReport().
+  void DoWork(const WorkerThread* thread) override;
+
+  WorkerThread thread_;
+  MPSCQueue<QueuedReport> new_reports_;
+  CrashReportDatabase* database_;  // weak
+  PageStore* page_store_;  // weak
+  CrashReportUploadThread* upload_thread_;  // weak
+  bool priority_lowered_;
+
+  DISALLOW_COPY_AND_ASSIGN(CrashReportCompressThread);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_CRASH_REPORT_COMPRESS_THREAD_H_
@@ -15,28 +15,47 @@
 #include "handler/crash_report_upload_thread.h"
 
 #include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <time.h>
 
 #include <algorithm>
+#include <limits>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "base/logging.h"
+#include "base/memory/ptr_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "build/build_config.h"
 #include "client/settings.h"
+#include "handler/upload_parameters.h"
+#include "minidump/minidump_file_writer.h"
 #include "snapshot/minidump/process_snapshot_minidump.h"
-#include "snapshot/module_snapshot.h"
+#include "snapshot/redacted/process_snapshot_redacted.h"
+#include "util/file/block_compressed_file_reader.h"
 #include "util/file/file_reader.h"
+#include "util/file/paged_file_reader.h"
+#include "util/file/string_file.h"
+#include "util/misc/clock.h"
 #include "util/misc/metrics.h"
+#include "util/misc/trace_event.h"
 #include "util/misc/uuid.h"
 #include "util/net/http_body.h"
+#include "util/net/http_body_gzip.h"
+#include "util/net/http_body_pipe.h"
+#include "util/net/http_headers.h"
 #include "util/net/http_multipart_builder.h"
+#include "util/net/http_retry_after.h"
 #include "util/net/http_transport.h"
 #include "util/net/url.h"
 #include "util/stdlib/map_insert.h"
+#include "util/stdlib/string_number_conversion.h"
+#include "util/thread/thread.h"
+#include "util/thread/thread_priority.h"
 
 #if defined(OS_MACOSX)
 #include "handler/mac/file_limit_annotation.h"
@@ -46,6 +65,63 @@ namespace crashpad {
 
 namespace {
 
+constexpr char kMinidumpKey[] = "upload_file_minidump";
+
+// When a minidump file is sent separately by SendMinidumpResumably(), the
+// report refers to it by this form parameter in place of kMinidumpKey.
+constexpr char kMinidumpIDKey[] = "upload_file_minidump_id";
+
+// The size of the chunks that SendMinidumpResumably() sends. An interrupted
+// upload loses at most this much progress.
+constexpr size_t kResumableUploadChunkSize = 1024 * 1024;
+
+// With Options::upload_minimal_first, the form parameter that tells the server
+// which minidump an upload carries, and its values.
+constexpr char kMinidumpTierKey[] = "minidump_tier";
+constexpr char kMinidumpTierMinimal[] = "minimal";
+constexpr char kMinidumpTierFull[] = "full";
+
+// Sent along with a full minidump, the ID that the server assigned to the
+// minimal one that preceded it.
+constexpr char kMinimalReportIDKey[] = "minimal_report_id";
+
+// A line of the response to a minimal upload that asks for the full minidump.
+constexpr char kFullDumpRequested[] = "full_dump_requested";
+
+// Reports made by processes that continued running, no larger than this, may be
+// uploaded together to Options::batch_upload_url.
+constexpr uint32_t kMaxBatchedReportSizeKB = 512;
+
+// When watching for pending reports by polling, check every 15 minutes, even in
+// the absence of a signal from the handler thread. This allows for failed
+// uploads to be retried periodically, and for pending reports written by other
+// processes to be recognized.
+constexpr double kPollIntervalSeconds = 15 * 60;
+
+// When the database provides change notifications, pending reports written by
+// other processes are recognized without polling, so the database only needs to
+// be examined periodically to retry failed uploads. This matches the interval
+// permitted between upload attempts when rate limiting.
+constexpr double kRetryIntervalSeconds = 60 * 60;
+
+// A report whose upload fails in a way that might succeed later stays pending
+// to be retried, up to this many attempts in all, before it is skipped.
+constexpr int kMaxUploadAttempts = 6;
+
+// The wait before a report is retried doubles with each failed attempt, from
+// kRetryBackoffSeconds after the first up to kMaxRetryBackoffSeconds.
+constexpr time_t kRetryBackoffSeconds = 15 * 60;
+constexpr time_t kMaxRetryBackoffSeconds = 24 * 60 * 60;
+
+// A server that declines an upload with status 429 (Too Many Requests) or 503
+// (Service Unavailable) holds off all uploads from the database, for as long as
+// its Retry-After header field asks, or kDefaultUploadDeferralSeconds if it
+// doesn’t say, but no longer than kMaxUploadDeferralSeconds. A jitter of up to
+// half the deferral plus kMinUploadDeferralJitterSeconds is added to it.
+constexpr time_t kDefaultUploadDeferralSeconds = 15 * 60;
+constexpr time_t kMaxUploadDeferralSeconds = 24 * 60 * 60;
+constexpr time_t kMinUploadDeferralJitterSeconds = 60;
+
 void InsertOrReplaceMapEntry(std::map<std::string, std::string>* map,
                              const std::string& key,
                              const std::string& value) {
@@ -56,57 +132,330 @@ void InsertOrReplaceMapEntry(std::map<std::string, std::string>* map,
   }
 }
 
-// Given a minidump file readable by |minidump_file_reader|, returns a map of
-// key-value pairs to use as HTTP form parameters for upload to a Breakpad
-// server. The map is built by combining the process simple annotations map with
-// each module’s simple annotations map. In the case of duplicate keys, the map
-// will retain the first value found for any key, and will log a warning about
-// discarded values. Each module’s annotations vector is also examined and built
-// into a single string value, with distinct elements separated by newlines, and
-// stored at the key named “list_annotations”, which supersedes any other key
-// found by that name. The client ID stored in the minidump is converted to
-// a string and stored at the key named “guid”, which supersedes any other key
-// found by that name.
+// Writes |process_snapshot| as a new minidump file, placing its contents in
+// |minidump|. Returns false with a message logged on failure.
+bool WriteMinidumpToString(const ProcessSnapshot* process_snapshot,
+                           std::string* minidump) {
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.InitializeFromSnapshot(process_snapshot);
+
+  StringFile string_file;
+  if (!minidump_file_writer.WriteEverything(&string_file)) {
+    return false;
+  }
+
+  *minidump = string_file.string();
+  return true;
+}
+
+// Adds |attachments| to |http_multipart_builder|, each in a part named for the
+// file, following |part_prefix|. The files are read as the request body is
+// sent, so none is ever copied in full.
+void SetAttachments(const std::vector<base::FilePath>& attachments,
+                    const std::string& part_prefix,
+                    HTTPMultipartBuilder* http_multipart_builder) {
+  for (const base::FilePath& attachment : attachments) {
+#if defined(OS_WIN)
+    const std::string name = base::UTF16ToUTF8(attachment.BaseName().value());
+#else
+    const std::string name = attachment.BaseName().value();
+#endif
+    http_multipart_builder->SetFileAttachment(
+        part_prefix + name, name, attachment, "application/octet-stream");
+  }
+}
+
+// Determines whether rate limiting prevents an upload attempt now, based on
+// the time of the most recent upload attempt recorded in |settings|. If so,
+// returns true and sets |reason| to the reason that the upload is skipped.
+bool UploadThrottled(Settings* settings, Metrics::CrashSkippedReason* reason) {
+  time_t last_upload_attempt_time;
+  if (!settings->GetLastUploadAttemptTime(&last_upload_attempt_time)) {
+    return false;
+  }
+
+  time_t now = time(nullptr);
+  if (now >= last_upload_attempt_time) {
+    // If the most recent upload attempt occurred within the past hour, don’t
+    // attempt to upload the new report. If it happened longer ago, attempt to
+    // upload the report.
+    constexpr int kUploadAttemptIntervalSeconds = 60 * 60;  // 1 hour
+    if (now - last_upload_attempt_time < kUploadAttemptIntervalSeconds) {
+      *reason = Metrics::CrashSkippedReason::kUploadThrottled;
+      return true;
+    }
+  } else {
+    // The most recent upload attempt purportedly occurred in the future. If it
+    // “happened” at least one day in the future, assume that the last upload
+    // attempt time is bogus, and attempt to upload the report. If the most
+    // recent upload time is in the future but within one day, accept it and
+    // don’t attempt to upload the report.
+    constexpr int kBackwardsClockTolerance = 60 * 60 * 24;  // 1 day
+    if (last_upload_attempt_time - now < kBackwardsClockTolerance) {
+      *reason = Metrics::CrashSkippedReason::kUnexpectedTime;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Determines whether |report|, which may have been attempted before, must wait
+// before being retried at |now|. If so, returns true and sets |retry_time| to
+// the time at which it may be retried.
 //
-// In the event of an error reading the minidump file, a message will be logged.
-std::map<std::string, std::string> BreakpadHTTPFormParametersFromMinidump(
-    FileReader* minidump_file_reader) {
-  ProcessSnapshotMinidump minidump_process_snapshot;
-  if (!minidump_process_snapshot.Initialize(minidump_file_reader)) {
-    return std::map<std::string, std::string>();
+// A report waits for between half of and all of the backoff for its number of
+// attempts, the fraction chosen from its UUID, so that reports that failed
+// together while a server was unavailable don’t all reach it together when it
+// recovers. Because the choice is derived from the report, every examination of
+// the report agrees on it, even across restarts.
+bool RetryDeferred(const CrashReportDatabase::Report& report,
+                   time_t now,
+                   time_t* retry_time) {
+  if (report.upload_attempts <= 0) {
+    return false;
+  }
+
+  // As in UploadThrottled(), an attempt that purportedly occurred at least one
+  // day in the future is assumed to have a bogus time.
+  constexpr time_t kBackwardsClockTolerance = 60 * 60 * 24;  // 1 day
+  if (report.last_upload_attempt_time > now &&
+      report.last_upload_attempt_time - now >= kBackwardsClockTolerance) {
+    return false;
+  }
+
+  time_t backoff = kRetryBackoffSeconds;
+  for (int attempt = 1;
+       attempt < report.upload_attempts && backoff < kMaxRetryBackoffSeconds;
+       ++attempt) {
+    backoff *= 2;
+  }
+  backoff = std::min(backoff, kMaxRetryBackoffSeconds);
+
+  const uint32_t jitter =
+      report.uuid.data_1 ^
+      (static_cast<uint32_t>(report.upload_attempts) * 0x9e3779b9);
+  *retry_time = report.last_upload_attempt_time + backoff / 2 +
+                jitter % (backoff / 2 + 1);
+  return now < *retry_time;
+}
+
+// Determines whether a server has deferred uploads past |now|, according to
+// |settings|. If so, returns true and sets |deferred_until| to the time at
+// which uploads may resume.
+bool UploadsDeferred(Settings* settings, time_t now, time_t* deferred_until) {
+  if (!settings->GetUploadsDeferredUntil(deferred_until) ||
+      *deferred_until <= now) {
+    return false;
+  }
+
+  // A deferral that ends further in the future than any that a server can ask
+  // for is assumed to have been recorded before the clock moved backwards.
+  constexpr time_t kMaxDeferral = kMaxUploadDeferralSeconds +
+                                  kMaxUploadDeferralSeconds / 2 +
+                                  kMinUploadDeferralJitterSeconds;
+  return *deferred_until - now <= kMaxDeferral;
+}
+
+// Restores the last upload attempt time stored in |settings| upon destruction
+// to what it was upon construction. Recording an upload attempt advances it, so
+// this keeps a retry from counting against the rate limit applied to new
+// reports.
+class ScopedRestoreLastUploadAttemptTime {
+ public:
+  explicit ScopedRestoreLastUploadAttemptTime(Settings* settings)
+      : settings_(settings),
+        last_upload_attempt_time_(0),
+        valid_(settings->GetLastUploadAttemptTime(&last_upload_attempt_time_)) {
+  }
+
+  ~ScopedRestoreLastUploadAttemptTime() {
+    if (valid_) {
+      settings_->SetLastUploadAttemptTime(last_upload_attempt_time_);
+    }
+  }
+
+ private:
+  Settings* settings_;  // weak
+  time_t last_upload_attempt_time_;
+  bool valid_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedRestoreLastUploadAttemptTime);
+};
+
+// Parses a response body from the resumable upload endpoint, which gives the
+// number of bytes of the minidump file that the server holds. Returns false
+// with a message logged if |response_body| is malformed or exceeds |size|.
+bool ParseResumableUploadOffset(const std::string& response_body,
+                                uint64_t size,
+                                uint64_t* offset) {
+  std::string offset_string(response_body);
+  while (!offset_string.empty() &&
+         (offset_string.back() == '\n' || offset_string.back() == '\r')) {
+    offset_string.pop_back();
+  }
+
+  if (!StringToNumber(offset_string, offset) || *offset > size) {
+    LOG(ERROR) << "invalid resumable upload offset " << response_body;
+    return false;
+  }
+  return true;
+}
+
+// Parses the response body from a minimal upload. Its first line is the ID
+// that the server assigned to the report, which is stored in |report_id|.
+// Returns true if any later line asks for the full minidump.
+bool ParseMinimalUploadResponse(const std::string& response_body,
+                                std::string* report_id) {
+  std::vector<std::string> lines;
+  size_t start = 0;
+  while (start <= response_body.size()) {
+    size_t end = response_body.find('\n', start);
+    if (end == std::string::npos) {
+      end = response_body.size();
+    }
+    std::string line = response_body.substr(start, end - start);
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    lines.push_back(line);
+    start = end + 1;
+  }
+
+  *report_id = lines[0];
+  for (size_t index = 1; index < lines.size(); ++index) {
+    if (lines[index] == kFullDumpRequested) {
+      return true;
+    }
   }
+  return false;
+}
+
+// Whether |report| may be uploaded along with others in a batch. Batches are
+// meant for the small reports that processes make without crashing, which
+// would otherwise each pay for a request of their own. Reports whose upload was
+// explicitly requested are sent individually, as they would be otherwise.
+bool BatchUploadEligible(const CrashReportDatabase::Report& report) {
+  return report.dump_without_crash && !report.upload_explicitly_requested &&
+         report.size_in_kb <= kMaxBatchedReportSizeKB;
+}
+
+// The server’s disposition of a single report in a batch upload.
+enum class BatchUploadPartStatus {
+  // The report was accepted, and has been assigned an ID.
+  kAccepted,
 
-  std::map<std::string, std::string> parameters =
-      minidump_process_snapshot.AnnotationsSimpleMap();
+  // The report should be sent again later.
+  kRetry,
+
+  // The report was rejected, and shouldn’t be sent again.
+  kRejected,
+};
+
+struct BatchUploadPartResult {
+  BatchUploadPartStatus status;
+  std::string id;
+};
+
+// Parses the response body from a batch upload, which has a line for each
+// report of the form “UUID STATUS [ID]”, where STATUS is ok, retry, or reject.
+// Returns the results keyed by UUID string. Malformed lines are logged and
+// skipped.
+std::map<std::string, BatchUploadPartResult> ParseBatchUploadResponse(
+    const std::string& response_body) {
+  std::map<std::string, BatchUploadPartResult> results;
+  size_t start = 0;
+  while (start < response_body.size()) {
+    size_t end = response_body.find('\n', start);
+    if (end == std::string::npos) {
+      end = response_body.size();
+    }
+    std::string line = response_body.substr(start, end - start);
+    start = end + 1;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      continue;
+    }
 
-  std::string list_annotations;
-  for (const ModuleSnapshot* module : minidump_process_snapshot.Modules()) {
-    for (const auto& kv : module->AnnotationsSimpleMap()) {
-      if (!parameters.insert(kv).second) {
-        LOG(WARNING) << "duplicate key " << kv.first << ", discarding value "
-                     << kv.second;
+    std::vector<std::string> fields;
+    size_t field_start = 0;
+    while (field_start <= line.size()) {
+      size_t field_end = line.find(' ', field_start);
+      if (field_end == std::string::npos) {
+        field_end = line.size();
       }
+      fields.push_back(line.substr(field_start, field_end - field_start));
+      field_start = field_end + 1;
     }
 
-    for (std::string annotation : module->AnnotationsVector()) {
-      list_annotations.append(annotation);
-      list_annotations.append("\n");
+    UUID uuid;
+    BatchUploadPartResult result;
+    if (fields.size() < 2 || fields.size() > 3 ||
+        !uuid.InitializeFromString(fields[0])) {
+      LOG(WARNING) << "invalid batch upload response line " << line;
+      continue;
+    }
+    if (fields[1] == "ok") {
+      result.status = BatchUploadPartStatus::kAccepted;
+    } else if (fields[1] == "retry") {
+      result.status = BatchUploadPartStatus::kRetry;
+    } else if (fields[1] == "reject") {
+      result.status = BatchUploadPartStatus::kRejected;
+    } else {
+      LOG(WARNING) << "invalid batch upload response line " << line;
+      continue;
     }
+    if (fields.size() == 3) {
+      result.id = fields[2];
+    }
+    results[uuid.ToString()] = result;
   }
+  return results;
+}
 
-  if (!list_annotations.empty()) {
-    // Remove the final newline character.
-    list_annotations.resize(list_annotations.size() - 1);
+// Writes a minidump file to an HTTPBodyPipe on its own thread, so that the
+// pipe can be read on another thread as the minidump file is produced.
+class MinidumpPipeWriterThread : public Thread {
+ public:
+  MinidumpPipeWriterThread(MinidumpFileWriter* minidump, HTTPBodyPipe* pipe)
+      : Thread(), minidump_(minidump), pipe_(pipe) {}
+
+  ~MinidumpPipeWriterThread() override {}
 
-    InsertOrReplaceMapEntry(&parameters, "list_annotations", list_annotations);
+ private:
+  // Thread:
+  void ThreadMain() override {
+    pipe_->CloseWrite(minidump_->WriteMinidump(pipe_->writer(), false));
   }
 
-  UUID client_id;
-  minidump_process_snapshot.ClientID(&client_id);
-  InsertOrReplaceMapEntry(&parameters, "guid", client_id.ToString());
+  MinidumpFileWriter* minidump_;  // weak
+  HTTPBodyPipe* pipe_;  // weak
 
-  return parameters;
-}
+  DISALLOW_COPY_AND_ASSIGN(MinidumpPipeWriterThread);
+};
+
+// Reads a minidump file’s contents through a reader that reassembles them from
+// how the file is stored, such as a BlockCompressedFileReader or a
+// PagedFileReader, for uploads that aren’t gzip-compressed.
+class StoredMinidumpHTTPBodyStream : public HTTPBodyStream {
+ public:
+  explicit StoredMinidumpHTTPBodyStream(FileReaderInterface* reader)
+      : HTTPBodyStream(), reader_(reader) {}
+
+  ~StoredMinidumpHTTPBodyStream() override {}
+
+  // HTTPBodyStream:
+  FileOperationResult GetBytesBuffer(uint8_t* buffer, size_t max_len) override {
+    return reader_->Read(buffer, max_len);
+  }
+
+ private:
+  FileReaderInterface* reader_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(StoredMinidumpHTTPBodyStream);
+};
 
 // Calls CrashReportDatabase::RecordUploadAttempt() with |successful| set to
 // false upon destruction unless disarmed by calling Fire() or Disarm(). Fire()
@@ -142,42 +491,322 @@ class CallRecordUploadAttempt {
   DISALLOW_COPY_AND_ASSIGN(CallRecordUploadAttempt);
 };
 
+// Creates the transports for CrashReportUploadThread::http_transports_, one for
+// each thread that may process reports concurrently.
+std::vector<std::unique_ptr<HTTPTransport>> CreateHTTPTransports(
+    size_t upload_thread_count) {
+  std::vector<std::unique_ptr<HTTPTransport>> http_transports;
+  for (size_t index = 0; index < std::max(upload_thread_count,
+                                          static_cast<size_t>(1));
+       ++index) {
+    http_transports.push_back(HTTPTransport::Create());
+  }
+  return http_transports;
+}
+
+// Creates CrashReportUploadThread::bandwidth_limiter_ as configured by
+// |options|.
+std::unique_ptr<HTTPBandwidthLimiter> CreateBandwidthLimiter(
+    const CrashReportUploadThread::Options& options) {
+  if (!options.upload_bandwidth_limit) {
+    return nullptr;
+  }
+  return std::unique_ptr<HTTPBandwidthLimiter>(new HTTPBandwidthLimiter(
+      options.upload_bandwidth_limit,
+      options.upload_bandwidth_burst ? options.upload_bandwidth_burst
+                                     : options.upload_bandwidth_limit));
+}
+
 }  // namespace
 
+// Hands out a pass’s reports to the threads that process them.
+class CrashReportUploadThread::ReportQueue {
+ public:
+  explicit ReportQueue(const std::vector<CrashReportDatabase::Report>& reports)
+      : lock_(), reports_(reports), next_index_(0) {}
+
+  ~ReportQueue() {}
+
+  //! \brief Returns the next report to process, followed by as many as \a
+  //!     max_count − 1 of those immediately after it that may be uploaded in
+  //!     the same batch. Returns an empty vector if no reports remain.
+  std::vector<const CrashReportDatabase::Report*> NextBatch(size_t max_count) {
+    base::AutoLock lock(lock_);
+    std::vector<const CrashReportDatabase::Report*> batch;
+    if (next_index_ == reports_.size()) {
+      return batch;
+    }
+    batch.push_back(&reports_[next_index_++]);
+    if (!BatchUploadEligible(*batch[0])) {
+      return batch;
+    }
+    while (batch.size() < max_count && next_index_ < reports_.size() &&
+           BatchUploadEligible(reports_[next_index_])) {
+      batch.push_back(&reports_[next_index_++]);
+    }
+    return batch;
+  }
+
+ private:
+  base::Lock lock_;
+  const std::vector<CrashReportDatabase::Report>& reports_;
+  size_t next_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReportQueue);
+};
+
+// Calls ProcessQueuedReports() on its own thread, allowing reports to be
+// uploaded concurrently with those processed on the upload thread.
+class CrashReportUploadThread::UploadWorkerThread : public Thread {
+ public:
+  UploadWorkerThread(CrashReportUploadThread* upload_thread,
+                     ReportQueue* queue,
+                     HTTPTransport* http_transport)
+      : Thread(),
+        upload_thread_(upload_thread),
+        queue_(queue),
+        http_transport_(http_transport) {}
+
+  ~UploadWorkerThread() override {}
+
+ private:
+  // Thread:
+  void ThreadMain() override {
+    LowerThreadPriority();
+    upload_thread_->ProcessQueuedReports(queue_, http_transport_);
+  }
+
+  CrashReportUploadThread* upload_thread_;  // weak
+  ReportQueue* queue_;  // weak
+  HTTPTransport* http_transport_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(UploadWorkerThread);
+};
+
 CrashReportUploadThread::CrashReportUploadThread(CrashReportDatabase* database,
                                                  const std::string& url,
                                                  const Options& options)
     : options_(options),
       url_(url),
-      // When watching for pending reports, check every 15 minutes, even in the
-      // absence of a signal from the handler thread. This allows for failed
-      // uploads to be retried periodically, and for pending reports written by
-      // other processes to be recognized.
-      thread_(options.watch_pending_reports ? 15 * 60.0
+      pending_report_watcher_(),
+      pending_report_watcher_lock_(),
+      pending_report_watch_attempted_(false),
+      watching_pending_reports_(false),
+      pending_report_watcher_running_(false),
+      started_(false),
+      network_watcher_(),
+      network_watch_attempted_(false),
+      watching_network_(false),
+      network_watcher_running_(false),
+      thread_(options.watch_pending_reports ? kPollIntervalSeconds
                                             : WorkerThread::kIndefiniteWait,
-              this),
+              this,
+              options.executor),
       known_pending_report_uuids_(),
-      database_(database) {}
+      database_(database),
+      rate_limit_lock_(),
+      http_transports_(CreateHTTPTransports(options.upload_thread_count)),
+      bandwidth_limiter_(CreateBandwidthLimiter(options)),
+      statistics_() {}
 
 CrashReportUploadThread::~CrashReportUploadThread() {
 }
 
 void CrashReportUploadThread::Start() {
-  thread_.Start(
-      options_.watch_pending_reports ? 0.0 : WorkerThread::kIndefiniteWait);
+  for (const auto& http_transport : http_transports_) {
+    http_transport->ClearCancellation();
+  }
+
+  thread_.Start(options_.watch_pending_reports
+                    ? options_.initial_work_delay
+                    : WorkerThread::kIndefiniteWait);
+
+  // After a restart, the watcher set up in an earlier run resumes.
+  {
+    base::AutoLock lock(pending_report_watcher_lock_);
+    started_ = true;
+    StartPendingReportWatcherLocked();
+  }
+
+  // Start() and Stop() are called on the same thread, so the network watcher
+  // needs no lock.
+  if (options_.wait_for_network && !network_watch_attempted_) {
+    network_watch_attempted_ = true;
+    watching_network_ = network_watcher_.Initialize();
+  }
+  if (watching_network_) {
+    network_watcher_.Start(this);
+    network_watcher_running_ = true;
+  }
 }
 
 void CrashReportUploadThread::Stop() {
+  // The watchers signal thread_, so they must stop first. Holding the lock
+  // while the pending report watcher stops keeps the upload thread from
+  // starting it again.
+  if (network_watcher_running_) {
+    network_watcher_.Stop();
+    network_watcher_running_ = false;
+  }
+  {
+    base::AutoLock lock(pending_report_watcher_lock_);
+    started_ = false;
+    if (pending_report_watcher_running_) {
+      pending_report_watcher_.Stop();
+      pending_report_watcher_running_ = false;
+    }
+  }
+
+  // Abandon uploads in progress rather than waiting for them.
+  for (const auto& http_transport : http_transports_) {
+    http_transport->Cancel();
+  }
+
   thread_.Stop();
 }
 
 void CrashReportUploadThread::ReportPending(const UUID& report_uuid) {
-  known_pending_report_uuids_.PushBack(report_uuid);
+  AddKnownPendingReport(report_uuid);
   thread_.DoWorkNow();
 }
 
+void CrashReportUploadThread::AddKnownPendingReport(const UUID& report_uuid) {
+  known_pending_report_uuids_.Push(
+      std::unique_ptr<KnownPendingReport>(new KnownPendingReport(report_uuid)));
+}
+
+bool CrashReportUploadThread::CanUploadDirectly() {
+  // A bandwidth-limited upload would keep the crashing process waiting for
+  // longer than is reasonable, on platforms where it waits. An upload sent
+  // with a Content-Length can’t begin until the minidump has been written, so
+  // it gains nothing from being direct.
+  if (!options_.upload_directly || url_.empty() ||
+      !RedactionPolicyIsEmpty(options_.redaction_policy) ||
+      options_.upload_bandwidth_limit || options_.upload_content_length ||
+      options_.upload_minimal_first) {
+    return false;
+  }
+
+  // The database may not be available when it is opened lazily.
+  Settings* const settings = database_->GetSettings();
+  bool uploads_enabled;
+  if (!settings || !settings->GetUploadsEnabled(&uploads_enabled) ||
+      !uploads_enabled) {
+    return false;
+  }
+
+  time_t uploads_deferred_until;
+  if (UploadsDeferred(settings, time(nullptr), &uploads_deferred_until) ||
+      !NetworkPermitsUpload(false)) {
+    return false;
+  }
+
+  Metrics::CrashSkippedReason throttled_reason;
+  return !options_.rate_limit ||
+         !UploadThrottled(settings, &throttled_reason);
+}
+
+bool CrashReportUploadThread::UploadMinidumpDirectly(
+    const ProcessSnapshot* process_snapshot,
+    MinidumpFileWriter* minidump,
+    const std::vector<base::FilePath>& attachments) {
+  DCHECK(CanUploadDirectly());
+
+  // As with an upload from the database, this counts as an attempt even if it
+  // fails, for the purposes of rate limiting.
+  database_->GetSettings()->SetLastUploadAttemptTime(time(nullptr));
+
+  UUID report_id;
+  process_snapshot->ReportID(&report_id);
+  ScopedTraceEvent trace_event(TraceEvent::kUpload, &report_id);
+
+  HTTPBodyPipe pipe(HTTPBodyPipe::kDefaultCapacity);
+  HTTPMultipartBuilder http_multipart_builder;
+  http_multipart_builder.SetFileAttachmentStream(kMinidumpKey,
+                                                 report_id.ToString() + ".dmp",
+                                                 &pipe,
+                                                 "application/octet-stream");
+  SetAttachments(attachments, std::string(), &http_multipart_builder);
+
+  MinidumpPipeWriterThread writer_thread(minidump, &pipe);
+  writer_thread.Start();
+
+  std::unique_ptr<HTTPTransport> http_transport(HTTPTransport::Create());
+  std::string response_body;
+  UploadResult upload_result =
+      SendReport(url_,
+                 BreakpadHTTPFormParametersFromSnapshot(process_snapshot),
+                 &http_multipart_builder,
+                 0,
+                 http_transport.get(),
+                 &response_body);
+
+  // If the upload ended before the whole minidump file was read, this releases
+  // the writer thread.
+  pipe.CloseRead();
+  writer_thread.Join();
+
+  if (upload_result != UploadResult::kSuccess) {
+    LOG(ERROR) << "direct upload failed, report " << report_id.ToString()
+               << " not retained";
+    return false;
+  }
+
+  return true;
+}
+
 void CrashReportUploadThread::ProcessPendingReports() {
-  std::vector<UUID> known_report_uuids = known_pending_report_uuids_.Drain();
+  // Collect the reports to process in this pass before processing any of them,
+  // so that they can be ordered as Options::upload_order specifies and divided
+  // among the threads that process them. Reports that have already been
+  // attempted are left for a later pass until their backoff has elapsed, and
+  // the thread is woken for the first of them to come due.
+  const time_t now = time(nullptr);
+
+  // While a server has deferred uploads, known pending reports remain queued
+  // for the first pass after the deferral ends.
+  time_t uploads_deferred_until;
+  if (UploadsDeferred(database_->GetSettings(), now, &uploads_deferred_until)) {
+    thread_.SetNextWorkDelay(static_cast<double>(uploads_deferred_until - now));
+    return;
+  }
+
+  // While no network is reachable, known pending reports likewise remain
+  // queued, until NetworkReachabilityChanged() signals that one is.
+  if (!NetworkPermitsUpload(true)) {
+    return;
+  }
+
+  // On a metered network, reports may have to wait for another network. They
+  // aren’t due at any particular time, so they don’t shorten the wait for the
+  // next pass.
+  const bool metered_network = !NetworkPermitsUpload(false);
+
+  time_t next_retry_time = std::numeric_limits<time_t>::max();
+  std::vector<CrashReportDatabase::Report> reports;
+  std::vector<UUID> deferred_report_uuids;
+  auto add_report = [now,
+                     metered_network,
+                     &next_retry_time,
+                     &reports,
+                     &deferred_report_uuids](
+      const CrashReportDatabase::Report& report) {
+    time_t retry_time;
+    if (metered_network && !report.upload_explicitly_requested) {
+      deferred_report_uuids.push_back(report.uuid);
+    } else if (RetryDeferred(report, now, &retry_time)) {
+      next_retry_time = std::min(next_retry_time, retry_time);
+      deferred_report_uuids.push_back(report.uuid);
+    } else {
+      reports.push_back(report);
+    }
+  };
+
+  std::vector<UUID> known_report_uuids;
+  while (std::unique_ptr<KnownPendingReport> known_report =
+             known_pending_report_uuids_.Pop()) {
+    known_report_uuids.push_back(known_report->uuid);
+  }
   for (const UUID& report_uuid : known_report_uuids) {
     CrashReportDatabase::Report report;
     if (database_->LookUpCrashReport(report_uuid, &report) !=
@@ -185,42 +814,130 @@ void CrashReportUploadThread::ProcessPendingReports() {
       continue;
     }
 
-    ProcessPendingReport(report);
-
-    // Respect Stop() being called after at least one attempt to process a
-    // report.
-    if (!thread_.is_running()) {
-      return;
-    }
-  }
-
-  // Known pending reports are always processed (above). The rest of this
-  // function is concerned with scanning for pending reports not already known
-  // to this thread.
-  if (!options_.watch_pending_reports) {
-    return;
+    add_report(report);
   }
 
-  std::vector<CrashReportDatabase::Report> reports;
-  if (database_->GetPendingReports(&reports) != CrashReportDatabase::kNoError) {
+  // Known pending reports are always processed. When enabled, the database is
+  // also scanned for pending reports not already known to this thread.
+  std::vector<CrashReportDatabase::Report> pending_reports;
+  if (options_.watch_pending_reports &&
+      database_->GetPendingReports(&pending_reports) !=
+          CrashReportDatabase::kNoError) {
     // The database is sick. It might be prudent to stop trying to poke it from
     // this thread by abandoning the thread altogether. On the other hand, if
     // the problem is transient, it might be possible to talk to it again on the
-    // next pass. For now, take the latter approach.
-    return;
+    // next pass. For now, take the latter approach, but still process the known
+    // reports.
+    pending_reports.clear();
   }
 
-  for (const CrashReportDatabase::Report& report : reports) {
+  for (const CrashReportDatabase::Report& report : pending_reports) {
     if (std::find(known_report_uuids.begin(),
                   known_report_uuids.end(),
                   report.uuid) != known_report_uuids.end()) {
-      // An attempt to process the report already occurred above. The report is
-      // still pending, so upload must have failed. Don’t retry it immediately,
-      // it can wait until at least the next pass through this method.
+      // The report is already queued for processing as a known report.
+      continue;
+    }
+
+    add_report(report);
+  }
+
+  // When rate limiting permits only some of the reports to be uploaded, those
+  // uploaded first are the ones that get through.
+  const UploadOrder upload_order = options_.upload_order;
+  std::stable_sort(
+      reports.begin(),
+      reports.end(),
+      [upload_order](const CrashReportDatabase::Report& lhs,
+                     const CrashReportDatabase::Report& rhs) {
+        if (lhs.upload_explicitly_requested !=
+            rhs.upload_explicitly_requested) {
+          return lhs.upload_explicitly_requested;
+        }
+        if (lhs.dump_without_crash != rhs.dump_without_crash) {
+          return rhs.dump_without_crash;
+        }
+        return upload_order == UploadOrder::kNewestFirst
+                   ? lhs.creation_time > rhs.creation_time
+                   : lhs.creation_time < rhs.creation_time;
+      });
+
+  // Deferred reports remain known, so that they’re found again when the
+  // database isn’t scanned.
+  for (const UUID& report_uuid : deferred_report_uuids) {
+    AddKnownPendingReport(report_uuid);
+  }
+  if (next_retry_time != std::numeric_limits<time_t>::max()) {
+    thread_.SetNextWorkDelay(static_cast<double>(next_retry_time - now));
+  }
+
+  const size_t pending_report_count =
+      reports.size() + deferred_report_uuids.size();
+  Metrics::CrashUploadQueueDepth(pending_report_count);
+  statistics_.SetPendingReports(pending_report_count);
+  WriteStatistics();
+
+  // This thread processes reports alongside the worker threads, which it waits
+  // for.
+  ReportQueue queue(reports);
+  const size_t thread_count = std::min(http_transports_.size(), reports.size());
+
+  std::vector<std::unique_ptr<UploadWorkerThread>> worker_threads;
+  for (size_t index = 1; index < thread_count; ++index) {
+    worker_threads.push_back(std::unique_ptr<UploadWorkerThread>(
+        new UploadWorkerThread(this, &queue, http_transports_[index].get())));
+    worker_threads.back()->Start();
+  }
+
+  if (thread_count > 0) {
+    ProcessQueuedReports(&queue, http_transports_[0].get());
+  }
+
+  for (const auto& worker_thread : worker_threads) {
+    worker_thread->Join();
+  }
+
+  // A server may have deferred uploads during the pass.
+  const time_t end_time = time(nullptr);
+  if (UploadsDeferred(
+          database_->GetSettings(), end_time, &uploads_deferred_until)) {
+    thread_.SetNextWorkDelay(
+        static_cast<double>(uploads_deferred_until - end_time));
+  }
+}
+
+void CrashReportUploadThread::ProcessQueuedReports(
+    ReportQueue* queue,
+    HTTPTransport* http_transport) {
+  // Without a batch upload URL, each batch is a single report.
+  const size_t batch_size = options_.batch_upload_url.empty()
+                                ? 1
+                                : options_.batch_upload_max_reports;
+  while (true) {
+    std::vector<const CrashReportDatabase::Report*> reports =
+        queue->NextBatch(batch_size);
+    if (reports.empty()) {
+      return;
+    }
+
+    // Once a server has deferred uploads, or the network has been lost, the
+    // reports not yet attempted in this pass are left for a later one.
+    time_t uploads_deferred_until;
+    if (UploadsDeferred(database_->GetSettings(),
+                        time(nullptr),
+                        &uploads_deferred_until) ||
+        !NetworkPermitsUpload(true)) {
+      for (const CrashReportDatabase::Report* report : reports) {
+        AddKnownPendingReport(report->uuid);
+      }
       continue;
     }
 
-    ProcessPendingReport(report);
+    if (reports.size() == 1) {
+      ProcessPendingReport(*reports[0], http_transport);
+    } else {
+      ProcessPendingReportBatch(reports, http_transport);
+    }
 
     // Respect Stop() being called after at least one attempt to process a
     // report.
@@ -231,119 +948,546 @@ void CrashReportUploadThread::ProcessPendingReports() {
 }
 
 void CrashReportUploadThread::ProcessPendingReport(
-    const CrashReportDatabase::Report& report) {
+    const CrashReportDatabase::Report& report,
+    HTTPTransport* http_transport) {
 #if defined(OS_MACOSX)
   RecordFileLimitAnnotation();
 #endif  // OS_MACOSX
 
   Settings* const settings = database_->GetSettings();
-
-  bool uploads_enabled;
-  if (url_.empty() ||
-      (!report.upload_explicitly_requested &&
-       (!settings->GetUploadsEnabled(&uploads_enabled) || !uploads_enabled))) {
-    // Don’t attempt an upload if there’s no URL to upload to. Allow upload if
-    // it has been explicitly requested by the user, otherwise, respect the
-    // upload-enabled state stored in the database’s settings.
+  if (!UploadPermitted(report)) {
     database_->SkipReportUpload(report.uuid,
                                 Metrics::CrashSkippedReason::kUploadsDisabled);
     return;
   }
 
-  // This currently implements very simplistic rate-limiting, compatible with
-  // the Breakpad client, where the strategy is to permit one upload attempt per
-  // hour, and retire reports that would exceed this limit or for which the
-  // upload fails on the first attempt.
+  // This implements rate-limiting compatible with the Breakpad client, where
+  // the strategy is to permit one upload attempt per hour, and retire reports
+  // that would exceed this limit. Only a report’s first attempt counts against
+  // the limit. Its retries are instead spaced out by a backoff of their own,
+  // applied by ProcessPendingReports(), so that a report that keeps failing
+  // doesn’t hold up new reports.
   //
   // If upload was requested explicitly (i.e. by user action), we do not
   // throttle the upload.
-  //
-  // TODO(mark): Provide a proper rate-limiting strategy and allow for failed
-  // upload attempts to be retried.
-  if (!report.upload_explicitly_requested && options_.rate_limit) {
-    time_t last_upload_attempt_time;
-    if (settings->GetLastUploadAttemptTime(&last_upload_attempt_time)) {
-      time_t now = time(nullptr);
-      if (now >= last_upload_attempt_time) {
-        // If the most recent upload attempt occurred within the past hour,
-        // don’t attempt to upload the new report. If it happened longer ago,
-        // attempt to upload the report.
-        constexpr int kUploadAttemptIntervalSeconds = 60 * 60;  // 1 hour
-        if (now - last_upload_attempt_time < kUploadAttemptIntervalSeconds) {
-          database_->SkipReportUpload(
-              report.uuid, Metrics::CrashSkippedReason::kUploadThrottled);
-          return;
+  const bool retry = report.upload_attempts > 0;
+  const bool rate_limit =
+      !retry && !report.upload_explicitly_requested && options_.rate_limit;
+  const CrashReportDatabase::Report* upload_report;
+  CrashReportDatabase::OperationStatus status;
+  {
+    // Other threads may be processing reports concurrently. The upload attempt
+    // is claimed before the lock is released, so that they observe it.
+    base::AutoLock lock(rate_limit_lock_);
+
+    Metrics::CrashSkippedReason throttled_reason;
+    if (rate_limit && UploadThrottled(settings, &throttled_reason)) {
+      database_->SkipReportUpload(report.uuid, throttled_reason);
+      return;
+    }
+
+    status = database_->GetReportForUploading(report.uuid, &upload_report);
+    if (status == CrashReportDatabase::kNoError && rate_limit) {
+      settings->SetLastUploadAttemptTime(time(nullptr));
+    }
+  }
+
+  if (!ReportClaimed(status, report.uuid)) {
+    return;
+  }
+
+  CallRecordUploadAttempt call_record_upload_attempt(database_, upload_report);
+
+  // A report that the user asked to upload is wanted in full.
+  const bool minimal_first =
+      options_.upload_minimal_first && !report.upload_explicitly_requested;
+
+  ScopedTraceEvent trace_event(TraceEvent::kUpload, &report.uuid);
+  std::string response_body;
+  uint64_t stored_size;
+  uint64_t content_size;
+  const uint64_t start_time = ClockMonotonicNanoseconds();
+  UploadResult upload_result = UploadReport(upload_report,
+                                            minimal_first
+                                                ? MinidumpTier::kMinimal
+                                                : MinidumpTier::kComplete,
+                                            std::string(),
+                                            http_transport,
+                                            &response_body,
+                                            &stored_size,
+                                            &content_size);
+  RecordAttemptStatistics(*upload_report,
+                          upload_result,
+                          (ClockMonotonicNanoseconds() - start_time) / 1000000,
+                          stored_size,
+                          content_size);
+  WriteStatistics();
+
+  // The full minidump is sent while the report is still claimed, so that no
+  // other thread uploads the report meanwhile. It’s sent outside of the lock,
+  // which mustn’t be held for the duration of an upload.
+  std::string report_id = response_body;
+  if (upload_result == UploadResult::kSuccess && minimal_first &&
+      ParseMinimalUploadResponse(response_body, &report_id)) {
+    std::string full_response_body;
+    uint64_t full_stored_size;
+    uint64_t full_content_size;
+    if (UploadReport(upload_report,
+                     MinidumpTier::kFull,
+                     report_id,
+                     http_transport,
+                     &full_response_body,
+                     &full_stored_size,
+                     &full_content_size) != UploadResult::kSuccess) {
+      LOG(WARNING) << "full minidump upload failed for report " << report_id;
+    }
+  }
+
+  call_record_upload_attempt.Disarm();
+  FinishUploadAttempt(upload_report, upload_result, report_id);
+}
+
+void CrashReportUploadThread::ProcessPendingReportBatch(
+    const std::vector<const CrashReportDatabase::Report*>& reports,
+    HTTPTransport* http_transport) {
+#if defined(OS_MACOSX)
+  RecordFileLimitAnnotation();
+#endif  // OS_MACOSX
+
+  Settings* const settings = database_->GetSettings();
+  std::vector<const CrashReportDatabase::Report*> permitted_reports;
+  for (const CrashReportDatabase::Report* report : reports) {
+    if (UploadPermitted(*report)) {
+      permitted_reports.push_back(report);
+    } else {
+      database_->SkipReportUpload(
+          report->uuid, Metrics::CrashSkippedReason::kUploadsDisabled);
+    }
+  }
+
+  // The batch is a single upload attempt as far as rate limiting is concerned.
+  // If it’s throttled, the reports making their first attempts are retired as
+  // they would be if uploaded individually, and retries proceed.
+  std::vector<const CrashReportDatabase::Report*> upload_reports;
+  {
+    base::AutoLock lock(rate_limit_lock_);
+
+    bool rate_limit = false;
+    if (options_.rate_limit) {
+      for (const CrashReportDatabase::Report* report : permitted_reports) {
+        if (report->upload_attempts == 0) {
+          rate_limit = true;
+          break;
         }
+      }
+    }
+
+    Metrics::CrashSkippedReason throttled_reason;
+    const bool throttled =
+        rate_limit && UploadThrottled(settings, &throttled_reason);
+    bool claimed_new_report = false;
+    for (const CrashReportDatabase::Report* report : permitted_reports) {
+      if (throttled && report->upload_attempts == 0) {
+        database_->SkipReportUpload(report->uuid, throttled_reason);
+        continue;
+      }
+
+      const CrashReportDatabase::Report* upload_report;
+      if (ReportClaimed(
+              database_->GetReportForUploading(report->uuid, &upload_report),
+              report->uuid)) {
+        upload_reports.push_back(upload_report);
+        claimed_new_report |= report->upload_attempts == 0;
+      }
+    }
+    if (rate_limit && claimed_new_report) {
+      settings->SetLastUploadAttemptTime(time(nullptr));
+    }
+  }
+
+  if (upload_reports.empty()) {
+    return;
+  }
+
+  ScopedTraceEvent trace_event(TraceEvent::kUploadBatch, nullptr);
+  for (const CrashReportDatabase::Report* upload_report : upload_reports) {
+    trace_event.SetReportID(upload_report->uuid);
+  }
+
+  std::vector<std::unique_ptr<CallRecordUploadAttempt>>
+      call_record_upload_attempts;
+  for (const CrashReportDatabase::Report* upload_report : upload_reports) {
+    call_record_upload_attempts.push_back(base::WrapUnique(
+        new CallRecordUploadAttempt(database_, upload_report)));
+  }
+
+  // Each report’s minidump file and form parameters occupy parts named for
+  // the report’s UUID.
+  const uint64_t start_time = ClockMonotonicNanoseconds();
+  std::map<std::string, std::string> parameters;
+  HTTPMultipartBuilder http_multipart_builder;
+  std::vector<UploadResult> upload_results(upload_reports.size(),
+                                           UploadResult::kSuccess);
+  std::vector<uint64_t> stored_sizes(upload_reports.size());
+  std::vector<uint64_t> content_sizes(upload_reports.size());
+  uint64_t minidump_size = 0;
+  size_t part_count = 0;
+  for (size_t index = 0; index < upload_reports.size(); ++index) {
+    const CrashReportDatabase::Report* upload_report = upload_reports[index];
+    std::map<std::string, std::string> report_parameters;
+    std::string minidump;
+    upload_results[index] = ReadReportForBatch(
+        upload_report, &report_parameters, &minidump, &stored_sizes[index]);
+    if (upload_results[index] != UploadResult::kSuccess) {
+      continue;
+    }
+
+    const std::string part_prefix = upload_report->uuid.ToString() + "/";
+    for (const auto& kv : report_parameters) {
+      parameters[part_prefix + kv.first] = kv.second;
+    }
+#if defined(OS_WIN)
+    const std::string upload_file_name =
+        base::UTF16ToUTF8(upload_report->file_path.BaseName().value());
+#else
+    const std::string upload_file_name =
+        upload_report->file_path.BaseName().value();
+#endif
+    http_multipart_builder.SetFileAttachmentData(part_prefix + kMinidumpKey,
+                                                 upload_file_name,
+                                                 minidump,
+                                                 "application/octet-stream");
+    // As in UploadReport(), attachments are left out of redacted reports.
+    std::vector<base::FilePath> attachments;
+    if (RedactionPolicyIsEmpty(options_.redaction_policy) &&
+        database_->GetAttachments(upload_report->uuid, &attachments) ==
+            CrashReportDatabase::kNoError) {
+      SetAttachments(attachments, part_prefix, &http_multipart_builder);
+    }
+    content_sizes[index] = minidump.size();
+    minidump_size += minidump.size();
+    ++part_count;
+  }
+
+  // Reports that couldn’t be read are left out, and those remaining are sent
+  // together. The server responds with a line for each report that it was
+  // sent. A report that it doesn’t mention is retried.
+  std::string response_body;
+  UploadResult batch_result = UploadResult::kSuccess;
+  if (part_count) {
+    batch_result = SendReport(options_.batch_upload_url,
+                              parameters,
+                              &http_multipart_builder,
+                              minidump_size,
+                              http_transport,
+                              &response_body);
+  }
+  const std::map<std::string, BatchUploadPartResult> part_results =
+      ParseBatchUploadResponse(response_body);
+  const uint64_t duration_ms =
+      (ClockMonotonicNanoseconds() - start_time) / 1000000;
+
+  for (size_t index = 0; index < upload_reports.size(); ++index) {
+    const CrashReportDatabase::Report* upload_report = upload_reports[index];
+    UploadResult upload_result = upload_results[index];
+    std::string report_id;
+    if (upload_result == UploadResult::kSuccess) {
+      upload_result = batch_result;
+    }
+    if (upload_result == UploadResult::kSuccess) {
+      const auto it = part_results.find(upload_report->uuid.ToString());
+      if (it == part_results.end()) {
+        upload_result = UploadResult::kRetry;
       } else {
-        // The most recent upload attempt purportedly occurred in the future. If
-        // it “happened” at least one day in the future, assume that the last
-        // upload attempt time is bogus, and attempt to upload the report. If
-        // the most recent upload time is in the future but within one day,
-        // accept it and don’t attempt to upload the report.
-        constexpr int kBackwardsClockTolerance = 60 * 60 * 24;  // 1 day
-        if (last_upload_attempt_time - now < kBackwardsClockTolerance) {
-          database_->SkipReportUpload(
-              report.uuid, Metrics::CrashSkippedReason::kUnexpectedTime);
-          return;
+        switch (it->second.status) {
+          case BatchUploadPartStatus::kAccepted:
+            report_id = it->second.id;
+            break;
+          case BatchUploadPartStatus::kRetry:
+            upload_result = UploadResult::kRetry;
+            break;
+          case BatchUploadPartStatus::kRejected:
+            upload_result = UploadResult::kPermanentFailure;
+            break;
         }
       }
     }
+
+    RecordAttemptStatistics(*upload_report,
+                            upload_result,
+                            duration_ms,
+                            stored_sizes[index],
+                            content_sizes[index]);
+    call_record_upload_attempts[index]->Disarm();
+    FinishUploadAttempt(upload_report, upload_result, report_id);
   }
+  WriteStatistics();
+}
 
-  const CrashReportDatabase::Report* upload_report;
-  CrashReportDatabase::OperationStatus status =
-      database_->GetReportForUploading(report.uuid, &upload_report);
+bool CrashReportUploadThread::UploadPermitted(
+    const CrashReportDatabase::Report& report) {
+  // Don’t attempt an upload if there’s no URL to upload to. Allow upload if it
+  // has been explicitly requested by the user, otherwise, respect the
+  // upload-enabled state stored in the database’s settings.
+  if (url_.empty()) {
+    return false;
+  }
+  if (report.upload_explicitly_requested) {
+    return true;
+  }
+  bool uploads_enabled;
+  return database_->GetSettings()->GetUploadsEnabled(&uploads_enabled) &&
+         uploads_enabled;
+}
+
+bool CrashReportUploadThread::ReportClaimed(
+    CrashReportDatabase::OperationStatus status,
+    const UUID& report_uuid) {
   switch (status) {
     case CrashReportDatabase::kNoError:
-      break;
+      return true;
 
     case CrashReportDatabase::kBusyError:
     case CrashReportDatabase::kReportNotFound:
       // Someone else may have gotten to it first. If they’re working on it now,
       // this will be kBusyError. If they’ve already finished with it, it’ll be
       // kReportNotFound.
-      return;
+      return false;
 
     case CrashReportDatabase::kFileSystemError:
     case CrashReportDatabase::kDatabaseError:
       // In these cases, SkipReportUpload() might not work either, but it’s best
       // to at least try to get the report out of the way.
-      database_->SkipReportUpload(report.uuid,
+      database_->SkipReportUpload(report_uuid,
                                   Metrics::CrashSkippedReason::kDatabaseError);
-      return;
+      return false;
 
     case CrashReportDatabase::kCannotRequestUpload:
       NOTREACHED();
-      return;
+      return false;
   }
 
-  CallRecordUploadAttempt call_record_upload_attempt(database_, upload_report);
+  NOTREACHED();
+  return false;
+}
 
-  std::string response_body;
-  UploadResult upload_result = UploadReport(upload_report, &response_body);
+void CrashReportUploadThread::RecordAttemptStatistics(
+    const CrashReportDatabase::Report& upload_report,
+    UploadResult upload_result,
+    uint64_t duration_ms,
+    uint64_t stored_size,
+    uint64_t content_size) {
+  // A cancelled attempt says nothing about the server or the connection to it.
+  if (upload_result == UploadResult::kCancelled) {
+    return;
+  }
+
+  const int upload_attempts = upload_report.upload_attempts + 1;
+  const time_t now = time(nullptr);
+  UploadStatistics::Attempt attempt;
+  attempt.successful = upload_result == UploadResult::kSuccess;
+  attempt.retry = upload_report.upload_attempts > 0;
+  attempt.duration_ms = duration_ms;
+  attempt.stored_size = stored_size;
+  attempt.minidump_size = content_size;
+  attempt.queue_seconds = now > upload_report.creation_time
+                              ? now - upload_report.creation_time
+                              : 0;
+  statistics_.RecordAttempt(attempt);
+
+  Metrics::CrashUploadDuration(attempt.duration_ms);
+  if (attempt.successful) {
+    Metrics::CrashUploadTimeInQueue(attempt.queue_seconds);
+    Metrics::CrashUploadCompressionRatio(stored_size, content_size);
+  }
+  if (upload_result != UploadResult::kRetry ||
+      upload_attempts >= kMaxUploadAttempts) {
+    // The report won’t be attempted again.
+    Metrics::CrashUploadAttemptCount(upload_attempts);
+  }
+}
+
+void CrashReportUploadThread::FinishUploadAttempt(
+    const CrashReportDatabase::Report* upload_report,
+    UploadResult upload_result,
+    const std::string& id) {
+  // Recording the attempt releases upload_report, so what’s needed of it is
+  // taken first.
+  const UUID report_uuid = upload_report->uuid;
+  const bool retry = upload_report->upload_attempts > 0;
+  const int upload_attempts = upload_report->upload_attempts + 1;
+
+  // Holding the lock keeps an attempt at a new report from being claimed while
+  // the time of a retry is being recorded and then taken back.
+  Settings* const settings = database_->GetSettings();
+  base::AutoLock lock(rate_limit_lock_);
+  std::unique_ptr<ScopedRestoreLastUploadAttemptTime> restore_last_attempt_time(
+      retry ? new ScopedRestoreLastUploadAttemptTime(settings) : nullptr);
   switch (upload_result) {
     case UploadResult::kSuccess:
-      call_record_upload_attempt.Disarm();
-      database_->RecordUploadAttempt(upload_report, true, response_body);
+      database_->RecordUploadAttempt(upload_report, true, id);
+      break;
+    case UploadResult::kCancelled:
+      // Recording the attempt releases the report, leaving it pending.
+      database_->RecordUploadAttempt(upload_report, false, std::string());
       break;
-    case UploadResult::kPermanentFailure:
     case UploadResult::kRetry:
-      call_record_upload_attempt.Fire();
-
-      // TODO(mark): Deal with retries properly: don’t call SkipReportUplaod()
-      // if the result was kRetry and the report hasn’t already been retried
-      // too many times.
-      database_->SkipReportUpload(report.uuid,
+      // Recording the attempt releases the report, leaving it pending to be
+      // retried, unless it has run out of attempts.
+      database_->RecordUploadAttempt(upload_report, false, std::string());
+      if (upload_attempts >= kMaxUploadAttempts) {
+        database_->SkipReportUpload(report_uuid,
+                                    Metrics::CrashSkippedReason::kUploadFailed);
+      } else {
+        AddKnownPendingReport(report_uuid);
+      }
+      break;
+    case UploadResult::kPermanentFailure:
+      database_->RecordUploadAttempt(upload_report, false, std::string());
+      database_->SkipReportUpload(report_uuid,
                                   Metrics::CrashSkippedReason::kUploadFailed);
       break;
   }
 }
 
+CrashReportUploadThread::UploadResult
+CrashReportUploadThread::ReadReportForBatch(
+    const CrashReportDatabase::Report* report,
+    std::map<std::string, std::string>* parameters,
+    std::string* minidump,
+    uint64_t* stored_size) {
+  *stored_size = 0;
+
+  FileReader file_reader;
+  if (!file_reader.Open(report->file_path)) {
+    return UploadResult::kPermanentFailure;
+  }
+  const FileOffset end = file_reader.Seek(0, SEEK_END);
+  if (end < 0 || !file_reader.SeekSet(0)) {
+    return UploadResult::kPermanentFailure;
+  }
+  *stored_size = end;
+
+  // A minidump file stored compressed or paged by CrashReportCompressThread is
+  // sent as it was written, along with the others in the batch.
+  BlockCompressedFileReader compressed_reader;
+  PagedFileReader paged_reader;
+  FileReaderInterface* minidump_reader = &file_reader;
+  if (BlockCompressedFileReader::IsBlockCompressedFile(&file_reader)) {
+    if (!compressed_reader.Initialize(&file_reader)) {
+      return UploadResult::kPermanentFailure;
+    }
+    minidump_reader = &compressed_reader;
+  } else if (PagedFileReader::IsPagedFile(&file_reader)) {
+    if (!InitializePagedFileReader(&paged_reader, &file_reader)) {
+      return UploadResult::kPermanentFailure;
+    }
+    minidump_reader = &paged_reader;
+  }
+  FileOffset minidump_end = end;
+  if (minidump_reader != &file_reader) {
+    minidump_end = minidump_reader->Seek(0, SEEK_END);
+    if (minidump_end < 0 || !minidump_reader->SeekSet(0)) {
+      return UploadResult::kPermanentFailure;
+    }
+  }
+
+  minidump->resize(static_cast<size_t>(minidump_end));
+  if (!minidump->empty() &&
+      !minidump_reader->ReadExactly(&(*minidump)[0], minidump->size())) {
+    return UploadResult::kPermanentFailure;
+  }
+
+  // As in UploadReport(), a minidump file that can’t be interpreted is sent
+  // with few or no parameters, unless it must be redacted.
+  const bool redact = !RedactionPolicyIsEmpty(options_.redaction_policy);
+  if (!redact && database_->LookUpUploadParameters(report->uuid, parameters) ==
+                     CrashReportDatabase::kNoError) {
+    return UploadResult::kSuccess;
+  }
+
+  StringFile minidump_file;
+  minidump_file.SetString(*minidump);
+  ProcessSnapshotMinidump minidump_process_snapshot;
+  if (!minidump_process_snapshot.Initialize(&minidump_file)) {
+    if (redact) {
+      LOG(ERROR) << "can't redact minidump";
+      return UploadResult::kPermanentFailure;
+    }
+    return UploadResult::kSuccess;
+  }
+  if (!redact) {
+    *parameters =
+        BreakpadHTTPFormParametersFromSnapshot(&minidump_process_snapshot);
+    return UploadResult::kSuccess;
+  }
+
+  ProcessSnapshotRedacted redacted_process_snapshot;
+  std::string redacted_minidump;
+  if (!redacted_process_snapshot.Initialize(&minidump_process_snapshot,
+                                            options_.redaction_policy) ||
+      !WriteMinidumpToString(&redacted_process_snapshot, &redacted_minidump)) {
+    LOG(ERROR) << "can't redact minidump";
+    return UploadResult::kPermanentFailure;
+  }
+  *parameters =
+      BreakpadHTTPFormParametersFromSnapshot(&redacted_process_snapshot);
+  minidump->swap(redacted_minidump);
+  return UploadResult::kSuccess;
+}
+
+bool CrashReportUploadThread::InitializePagedFileReader(
+    PagedFileReader* paged_reader,
+    FileReaderInterface* file_reader) {
+  if (!options_.page_store) {
+    LOG(ERROR) << "paged report without a page store";
+    return false;
+  }
+  return paged_reader->Initialize(file_reader, options_.page_store);
+}
+
 CrashReportUploadThread::UploadResult CrashReportUploadThread::UploadReport(
     const CrashReportDatabase::Report* report,
-    std::string* response_body) {
+    MinidumpTier tier,
+    const std::string& minimal_report_id,
+    HTTPTransport* http_transport,
+    std::string* response_body,
+    uint64_t* stored_size,
+    uint64_t* content_size) {
+  *stored_size = 0;
+  *content_size = 0;
+
   std::map<std::string, std::string> parameters;
 
+  // A minimal minidump is derived from the report’s by redacting it further.
+  RedactionPolicy redaction_policy(options_.redaction_policy);
+  if (tier == MinidumpTier::kMinimal) {
+    redaction_policy.drop_extra_memory = true;
+    redaction_policy.crashing_thread_only = true;
+  }
+
+  // When a redaction policy is in effect, the minidump file is rewritten
+  // without the information that the policy removes, and the rewritten
+  // contents are uploaded in place of the file.
+  const bool redact = !RedactionPolicyIsEmpty(redaction_policy);
+  std::string redacted_minidump;
+
+  // Whether the minidump file was stored compressed, by
+  // CrashReportCompressThread.
+  bool compressed;
+
+  // Whether the minidump file was stored as a paged file, by
+  // CrashReportCompressThread. Its contents are reassembled through these,
+  // which must outlive the body stream that SendReport() obtains from
+  // http_multipart_builder.
+  bool paged;
+  FileReader paged_file_reader;
+  PagedFileReader paged_minidump_reader;
+
+  // The size of the minidump file’s contents, which is at least the size of
+  // what is sent.
+  uint64_t minidump_size;
+
   {
     FileReader minidump_file_reader;
     if (!minidump_file_reader.Open(report->file_path)) {
@@ -351,48 +1495,315 @@ CrashReportUploadThread::UploadResult CrashReportUploadThread::UploadReport(
       return UploadResult::kPermanentFailure;
     }
 
-    // If the minidump file could be opened, ignore any errors that might occur
-    // when attempting to interpret it. This may result in its being uploaded
-    // with few or no parameters, but as long as there’s a dump file, the server
-    // can decide what to do with it.
-    parameters = BreakpadHTTPFormParametersFromMinidump(&minidump_file_reader);
+    compressed =
+        BlockCompressedFileReader::IsBlockCompressedFile(&minidump_file_reader);
+    paged = !compressed && PagedFileReader::IsPagedFile(&minidump_file_reader);
+    if (paged &&
+        (!paged_file_reader.Open(report->file_path) ||
+         !InitializePagedFileReader(&paged_minidump_reader,
+                                    &paged_file_reader))) {
+      return UploadResult::kPermanentFailure;
+    }
+
+    const FileOffset end = minidump_file_reader.Seek(0, SEEK_END);
+    if (end < 0) {
+      return UploadResult::kPermanentFailure;
+    }
+    minidump_size = end;
+    *stored_size = end;
+
+    // Parameters recorded when the report was written spare the minidump file
+    // from being interpreted here. Redaction needs it interpreted regardless,
+    // and the parameters must then come from the redacted snapshot.
+    if (redact ||
+        database_->LookUpUploadParameters(report->uuid, &parameters) !=
+            CrashReportDatabase::kNoError) {
+      // If the minidump file could be opened, ignore any errors that might
+      // occur when attempting to interpret it. This may result in its being
+      // uploaded with few or no parameters, but as long as there’s a dump file,
+      // the server can decide what to do with it.
+      ProcessSnapshotMinidump minidump_process_snapshot;
+      if (!minidump_process_snapshot.Initialize(
+              paged ? static_cast<FileReaderInterface*>(&paged_minidump_reader)
+                    : &minidump_file_reader)) {
+        if (redact) {
+          // A minidump file that can’t be interpreted can’t be redacted either,
+          // and uploading it intact would defeat the policy.
+          LOG(ERROR) << "can't redact minidump";
+          return UploadResult::kPermanentFailure;
+        }
+      } else if (!redact) {
+        parameters =
+            BreakpadHTTPFormParametersFromSnapshot(&minidump_process_snapshot);
+      } else {
+        ProcessSnapshotRedacted redacted_process_snapshot;
+        if (!redacted_process_snapshot.Initialize(&minidump_process_snapshot,
+                                                  redaction_policy) ||
+            !WriteMinidumpToString(&redacted_process_snapshot,
+                                   &redacted_minidump)) {
+          LOG(ERROR) << "can't redact minidump";
+          return UploadResult::kPermanentFailure;
+        }
+        parameters =
+            BreakpadHTTPFormParametersFromSnapshot(&redacted_process_snapshot);
+      }
+    }
+  }
+
+  // A compressed minidump file is read through these, which must outlive the
+  // body stream that SendReport() obtains from http_multipart_builder.
+  FileReader compressed_file_reader;
+  BlockCompressedFileReader compressed_minidump_reader;
+  std::unique_ptr<HTTPBodyStream> stored_minidump_stream;
+  if (compressed && !redact) {
+    if (!compressed_file_reader.Open(report->file_path) ||
+        !compressed_minidump_reader.Initialize(&compressed_file_reader)) {
+      return UploadResult::kPermanentFailure;
+    }
+    const FileOffset end = compressed_minidump_reader.Seek(0, SEEK_END);
+    if (end < 0 || compressed_minidump_reader.Seek(0, SEEK_SET) != 0) {
+      return UploadResult::kPermanentFailure;
+    }
+    minidump_size = end;
+  } else if (paged && !redact) {
+    const FileOffset end = paged_minidump_reader.Seek(0, SEEK_END);
+    if (end < 0 || paged_minidump_reader.Seek(0, SEEK_SET) != 0) {
+      return UploadResult::kPermanentFailure;
+    }
+    minidump_size = end;
+  } else if (redact) {
+    minidump_size = redacted_minidump.size();
+  }
+  *content_size = minidump_size;
+
+  switch (tier) {
+    case MinidumpTier::kComplete:
+      break;
+    case MinidumpTier::kMinimal:
+      InsertOrReplaceMapEntry(
+          &parameters, kMinidumpTierKey, kMinidumpTierMinimal);
+      break;
+    case MinidumpTier::kFull:
+      InsertOrReplaceMapEntry(&parameters, kMinidumpTierKey, kMinidumpTierFull);
+      if (!minimal_report_id.empty()) {
+        InsertOrReplaceMapEntry(
+            &parameters, kMinimalReportIDKey, minimal_report_id);
+      }
+      break;
   }
 
   HTTPMultipartBuilder http_multipart_builder;
-  http_multipart_builder.SetGzipEnabled(options_.upload_gzip);
 
-  static constexpr char kMinidumpKey[] = "upload_file_minidump";
+  if (!options_.resumable_upload_url.empty()) {
+    // The server assembles the minidump file from the chunks sent to it, and
+    // the report refers to it by the report’s UUID. A full minidump that
+    // follows a minimal one is held separately.
+    std::string resource_name = report->uuid.ToString();
+    if (tier == MinidumpTier::kFull) {
+      resource_name.append("-full");
+    }
+    UploadResult upload_result;
+    if (redact) {
+      StringFile redacted_minidump_file;
+      redacted_minidump_file.SetString(redacted_minidump);
+      upload_result = SendMinidumpResumably(
+          resource_name, &redacted_minidump_file, http_transport);
+    } else if (compressed) {
+      upload_result = SendMinidumpResumably(
+          resource_name, &compressed_minidump_reader, http_transport);
+    } else if (paged) {
+      upload_result = SendMinidumpResumably(
+          resource_name, &paged_minidump_reader, http_transport);
+    } else {
+      FileReader minidump_file_reader;
+      if (!minidump_file_reader.Open(report->file_path)) {
+        return UploadResult::kPermanentFailure;
+      }
+      upload_result = SendMinidumpResumably(
+          resource_name, &minidump_file_reader, http_transport);
+    }
+    if (upload_result != UploadResult::kSuccess) {
+      return upload_result;
+    }
+
+    InsertOrReplaceMapEntry(&parameters, kMinidumpIDKey, resource_name);
+    minidump_size = 0;
+  } else {
+#if defined(OS_WIN)
+    const std::string upload_file_name =
+        base::UTF16ToUTF8(report->file_path.BaseName().value());
+#else
+    const std::string upload_file_name = report->file_path.BaseName().value();
+#endif
+    if (redact) {
+      http_multipart_builder.SetFileAttachmentData(kMinidumpKey,
+                                                   upload_file_name,
+                                                   redacted_minidump,
+                                                   "application/octet-stream");
+    } else if (compressed &&
+               options_.upload_compression.coding == HTTPContentCoding::kGzip) {
+      // The minidump file’s compressed blocks are sent without being
+      // compressed again.
+      stored_minidump_stream.reset(
+          new BlockCompressedFileGzipHTTPBodyStream(
+              &compressed_minidump_reader));
+      http_multipart_builder.SetCompressedFileAttachmentStream(
+          kMinidumpKey,
+          upload_file_name,
+          stored_minidump_stream.get(),
+          "application/octet-stream",
+          HTTPContentCoding::kGzip);
+    } else if (compressed || paged) {
+      stored_minidump_stream.reset(new StoredMinidumpHTTPBodyStream(
+          compressed ? static_cast<FileReaderInterface*>(
+                           &compressed_minidump_reader)
+                     : &paged_minidump_reader));
+      http_multipart_builder.SetFileAttachmentStream(
+          kMinidumpKey,
+          upload_file_name,
+          stored_minidump_stream.get(),
+          "application/octet-stream");
+    } else {
+      http_multipart_builder.SetFileAttachment(kMinidumpKey,
+                                               upload_file_name,
+                                               report->file_path,
+                                               "application/octet-stream");
+    }
+  }
+
+  // The files attached to the report are sent from the database’s clones of
+  // them. They can’t be redacted, so a redacted report is sent without them,
+  // as is a minimal report, which is meant to be small.
+  std::vector<base::FilePath> attachments;
+  if (!redact && tier != MinidumpTier::kMinimal &&
+      database_->GetAttachments(report->uuid, &attachments) ==
+          CrashReportDatabase::kNoError) {
+    SetAttachments(attachments, std::string(), &http_multipart_builder);
+  }
+
+  return SendReport(url_,
+                    parameters,
+                    &http_multipart_builder,
+                    minidump_size,
+                    http_transport,
+                    response_body);
+}
+
+CrashReportUploadThread::UploadResult
+CrashReportUploadThread::SendMinidumpResumably(
+    const std::string& resource_name,
+    FileReaderInterface* minidump,
+    HTTPTransport* http_transport) {
+  const FileOffset end = minidump->Seek(0, SEEK_END);
+  if (end < 0) {
+    return UploadResult::kPermanentFailure;
+  }
+  const uint64_t size = end;
+  const std::string size_string = base::StringPrintf("%" PRIu64, size);
+
+  http_transport->SetURL(options_.resumable_upload_url + "/" + resource_name);
+
+  // Learn how much of the file the server already holds from previous attempts.
+  http_transport->ClearHeaders();
+  http_transport->SetMethod("GET");
+  http_transport->SetHeader(kContentLength, "0");
+  SetBodyStream(
+      http_transport,
+      std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream(std::string())),
+      0);
+  std::string response_body;
+  UploadResult result = ExecuteRequest(http_transport, &response_body);
+  if (result != UploadResult::kSuccess) {
+    return result;
+  }
+
+  uint64_t offset;
+  if (!ParseResumableUploadOffset(response_body, size, &offset)) {
+    return UploadResult::kRetry;
+  }
+
+  std::string chunk;
+  while (offset < size) {
+    chunk.resize(
+        static_cast<size_t>(std::min<uint64_t>(kResumableUploadChunkSize,
+                                               size - offset)));
+    if (minidump->Seek(offset, SEEK_SET) != static_cast<FileOffset>(offset) ||
+        !minidump->ReadExactly(&chunk[0], chunk.size())) {
+      return UploadResult::kPermanentFailure;
+    }
+
+    http_transport->ClearHeaders();
+    http_transport->SetMethod("POST");
+    http_transport->SetHeader(kContentType, "application/offset+octet-stream");
+    http_transport->SetHeader(kContentLength,
+                              base::StringPrintf("%zu", chunk.size()));
+    http_transport->SetHeader("Upload-Offset",
+                              base::StringPrintf("%" PRIu64, offset));
+    http_transport->SetHeader("Upload-Length", size_string);
+    SetBodyStream(
+        http_transport,
+        std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream(chunk)),
+        chunk.size());
+    result = ExecuteRequest(http_transport, &response_body);
+    if (result != UploadResult::kSuccess) {
+      return result;
+    }
+
+    // The server may have accepted less than the whole chunk, but it must
+    // make progress.
+    uint64_t new_offset;
+    if (!ParseResumableUploadOffset(response_body, size, &new_offset) ||
+        new_offset <= offset) {
+      return UploadResult::kRetry;
+    }
+    offset = new_offset;
+  }
+
+  return UploadResult::kSuccess;
+}
+
+CrashReportUploadThread::UploadResult CrashReportUploadThread::SendReport(
+    const std::string& base_url,
+    const std::map<std::string, std::string>& parameters,
+    HTTPMultipartBuilder* http_multipart_builder,
+    uint64_t minidump_size,
+    HTTPTransport* http_transport,
+    std::string* response_body) {
+  http_multipart_builder->SetCompression(options_.upload_compression);
 
   for (const auto& kv : parameters) {
     if (kv.first == kMinidumpKey) {
       LOG(WARNING) << "reserved key " << kv.first << ", discarding value "
                    << kv.second;
     } else {
-      http_multipart_builder.SetFormData(kv.first, kv.second);
+      http_multipart_builder->SetFormData(kv.first, kv.second);
     }
   }
 
-  http_multipart_builder.SetFileAttachment(
-      kMinidumpKey,
-#if defined(OS_WIN)
-      base::UTF16ToUTF8(report->file_path.BaseName().value()),
-#else
-      report->file_path.BaseName().value(),
-#endif
-      report->file_path,
-      "application/octet-stream");
-
-  std::unique_ptr<HTTPTransport> http_transport(HTTPTransport::Create());
+  // The transport may have sent a previous request, so its method and headers
+  // must not carry over.
+  http_transport->SetMethod("POST");
+  http_transport->ClearHeaders();
   HTTPHeaders content_headers;
-  http_multipart_builder.PopulateContentHeaders(&content_headers);
+  http_multipart_builder->PopulateContentHeaders(&content_headers);
   for (const auto& content_header : content_headers) {
     http_transport->SetHeader(content_header.first, content_header.second);
   }
-  http_transport->SetBodyStream(http_multipart_builder.GetBodyStream());
-  // TODO(mark): The timeout should be configurable by the client.
-  http_transport->SetTimeout(60.0);  // 1 minute.
+  std::unique_ptr<HTTPBodyStream> body_stream;
+  if (options_.upload_content_length) {
+    uint64_t body_length;
+    body_stream = http_multipart_builder->GetBodyStreamWithLength(&body_length);
+    if (!body_stream) {
+      return UploadResult::kRetry;
+    }
+    http_transport->SetHeader(kContentLength,
+                              base::StringPrintf("%" PRIu64, body_length));
+  } else {
+    body_stream = http_multipart_builder->GetBodyStream();
+  }
+  SetBodyStream(http_transport, std::move(body_stream), minidump_size);
 
-  std::string url = url_;
+  std::string url = base_url;
   if (options_.identify_client_via_url) {
     // Add parameters to the URL which identify the client to the server.
     static constexpr struct {
@@ -417,15 +1828,149 @@ CrashReportUploadThread::UploadResult CrashReportUploadThread::UploadReport(
   }
   http_transport->SetURL(url);
 
-  if (!http_transport->ExecuteSynchronously(response_body)) {
-    return UploadResult::kRetry;
+  return ExecuteRequest(http_transport, response_body);
+}
+
+CrashReportUploadThread::UploadResult CrashReportUploadThread::ExecuteRequest(
+    HTTPTransport* http_transport,
+    std::string* response_body) {
+  if (http_transport->ExecuteSynchronously(response_body)) {
+    return UploadResult::kSuccess;
+  }
+  if (http_transport->IsCancelled()) {
+    return UploadResult::kCancelled;
   }
 
-  return UploadResult::kSuccess;
+  const int status = http_transport->response_status();
+  if (status == 429 || status == 503) {
+    DeferUploads(http_transport->response_retry_after());
+  }
+  return UploadResult::kRetry;
+}
+
+void CrashReportUploadThread::DeferUploads(const std::string& retry_after) {
+  const time_t now = time(nullptr);
+  time_t deferral;
+  if (retry_after.empty() ||
+      !ParseHTTPRetryAfter(retry_after, now, &deferral)) {
+    deferral = kDefaultUploadDeferralSeconds;
+  }
+  deferral = std::min(deferral, kMaxUploadDeferralSeconds);
+
+  // Clients that were declined together resume at times spread across the
+  // jitter window, rather than all at once when the deferral ends. The spread
+  // is chosen from the client ID, which differs between clients, and the time,
+  // so that a client isn’t always among the first to resume.
+  Settings* const settings = database_->GetSettings();
+  UUID client_id;
+  if (!settings->GetClientID(&client_id)) {
+    client_id.InitializeToZero();
+  }
+  const uint32_t jitter =
+      client_id.data_1 ^ (static_cast<uint32_t>(now) * 0x9e3779b9);
+  const time_t deferred_until =
+      now + deferral +
+      jitter % (deferral / 2 + kMinUploadDeferralJitterSeconds);
+
+  // Concurrent uploads may each be declined. The longest deferral stands.
+  base::AutoLock lock(rate_limit_lock_);
+  time_t current_deferred_until;
+  if (UploadsDeferred(settings, now, &current_deferred_until) &&
+      current_deferred_until >= deferred_until) {
+    return;
+  }
+
+  LOG(WARNING) << "server deferred uploads for " << deferred_until - now
+               << " seconds";
+  settings->SetUploadsDeferredUntil(deferred_until);
+}
+
+void CrashReportUploadThread::SetBodyStream(
+    HTTPTransport* http_transport,
+    std::unique_ptr<HTTPBodyStream> body_stream,
+    uint64_t body_size) {
+  // TODO(mark): The timeout should be configurable by the client.
+  double timeout = 60.0;  // 1 minute.
+
+  if (bandwidth_limiter_) {
+    body_stream.reset(new BandwidthLimitedHTTPBodyStream(
+        std::move(body_stream), bandwidth_limiter_.get()));
+
+    // The timeout covers the entire request, so it must allow for the body to
+    // be sent at its share of the limit, which is divided among as many uploads
+    // as may run concurrently.
+    timeout += static_cast<double>(body_size) * http_transports_.size() /
+               options_.upload_bandwidth_limit;
+  }
+
+  http_transport->SetBodyStream(std::move(body_stream));
+  http_transport->SetTimeout(timeout);
+}
+
+void CrashReportUploadThread::WriteStatistics() {
+  if (!options_.statistics_path.empty()) {
+    statistics_.WriteToFile(options_.statistics_path);
+  }
+}
+
+void CrashReportUploadThread::WatchPendingReports() {
+  DCHECK(!pending_report_watch_attempted_);
+  pending_report_watch_attempted_ = true;
+
+  // The watcher isn’t running yet, so it may be set up without the lock.
+  bool watching = database_->WatchPendingReports(&pending_report_watcher_);
+
+  base::AutoLock lock(pending_report_watcher_lock_);
+  watching_pending_reports_ = watching;
+  if (watching) {
+    // Pending reports written by other processes will now be noticed without
+    // polling.
+    thread_.SetWorkInterval(kRetryIntervalSeconds);
+    StartPendingReportWatcherLocked();
+  }
+}
+
+void CrashReportUploadThread::StartPendingReportWatcherLocked() {
+  pending_report_watcher_lock_.AssertAcquired();
+  if (watching_pending_reports_ && started_ &&
+      !pending_report_watcher_running_) {
+    pending_report_watcher_.Start(this);
+    pending_report_watcher_running_ = true;
+  }
 }
 
 void CrashReportUploadThread::DoWork(const WorkerThread* thread) {
+  // Uploads are never urgent enough to compete with the user’s applications.
+  // With an executor, this may run on any of its threads, so each is lowered
+  // as it’s used.
+  LowerThreadPriority();
+
+  if (options_.watch_pending_reports && !pending_report_watch_attempted_) {
+    WatchPendingReports();
+  }
   ProcessPendingReports();
 }
 
+void CrashReportUploadThread::DirectoryChanged() {
+  thread_.DoWorkNow();
+}
+
+void CrashReportUploadThread::NetworkReachabilityChanged() {
+  thread_.DoWorkNow();
+}
+
+bool CrashReportUploadThread::NetworkPermitsUpload(
+    bool explicitly_requested) const {
+  if (!watching_network_) {
+    return true;
+  }
+  if (!network_watcher_.IsReachable()) {
+    return false;
+  }
+  return explicitly_requested ||
+         options_.metered_network_policy !=
+             MeteredNetworkPolicy::kUploadRequestedOnly ||
+         !network_watcher_.IsMetered();
+}
+
 }  // namespace crashpad
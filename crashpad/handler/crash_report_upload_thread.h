@@ -15,17 +15,38 @@
 #ifndef CRASHPAD_HANDLER_CRASH_REPORT_UPLOAD_THREAD_H_
 #define CRASHPAD_HANDLER_CRASH_REPORT_UPLOAD_THREAD_H_
 
+#include <stdint.h>
+
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "base/files/file_path.h"
 #include "base/macros.h"
+#include "base/synchronization/lock.h"
 #include "client/crash_report_database.h"
+#include "handler/upload_statistics.h"
+#include "snapshot/redacted/redaction_policy.h"
+#include "util/file/directory_change_watcher.h"
+#include "util/file/file_reader.h"
 #include "util/misc/uuid.h"
-#include "util/stdlib/thread_safe_vector.h"
+#include "util/net/http_body_bandwidth_limit.h"
+#include "util/net/http_body_compression.h"
+#include "util/net/network_reachability_watcher.h"
+#include "util/thread/mpsc_queue.h"
 #include "util/thread/worker_thread.h"
+#include "util/thread/worker_thread_executor.h"
 
 namespace crashpad {
 
+class HTTPMultipartBuilder;
+class HTTPTransport;
+class MinidumpFileWriter;
+class PageStore;
+class PagedFileReader;
+class ProcessSnapshot;
+
 //! \brief A thread that processes pending crash reports in a
 //!     CrashReportDatabase by uploading them or marking them as completed
 //!     without upload, as desired.
@@ -38,9 +59,52 @@ namespace crashpad {
 //! failed upload attempts for reports left in the pending state to be retried.
 //! It also catches reports that are added without a ReportPending() signal
 //! being caught. This may happen if crash reports are added to the database by
-//! other processes.
-class CrashReportUploadThread : public WorkerThread::Delegate {
+//! other processes. Where the database supports
+//! CrashReportDatabase::WatchPendingReports(), such reports are noticed as soon
+//! as they are added, and the periodic examination serves only to retry failed
+//! uploads, so it happens less often.
+//!
+//! A server that declines an upload with HTTP status 429 (Too Many Requests)
+//! or 503 (Service Unavailable) holds off all uploads from the database, for as
+//! long as its `Retry-After` header field asks, or a default deferral if it
+//! doesn’t say. The time at which uploads may resume is recorded in the
+//! database’s Settings, so that every process uploading from the database
+//! honors it. Each client adds its own jitter to the deferral, so that clients
+//! don’t all return to the server together when it ends.
+//!
+//! With Options::wait_for_network, uploads also wait while no network is
+//! reachable, as determined by a NetworkReachabilityWatcher, rather than each
+//! attempt failing after its timeout. They resume as soon as a network becomes
+//! reachable again.
+class CrashReportUploadThread : public WorkerThread::Delegate,
+                                public DirectoryChangeWatcher::Delegate,
+                                public NetworkReachabilityWatcher::Delegate {
  public:
+  //! \brief The order in which pending reports of equal priority are uploaded.
+  //!
+  //! Reports whose upload was explicitly requested are always uploaded first,
+  //! followed by reports of crashes, and finally reports for which
+  //! CrashReportDatabase::Report::dump_without_crash is set.
+  enum class UploadOrder {
+    //! \brief The most recently created reports first, so that newly
+    //!     introduced problems come to light as soon as possible.
+    kNewestFirst,
+
+    //! \brief The least recently created reports first.
+    kOldestFirst,
+  };
+
+  //! \brief Which reports are uploaded while the network is metered, as
+  //!     determined by NetworkReachabilityWatcher::IsMetered().
+  enum class MeteredNetworkPolicy {
+    //! \brief All reports, as on any other network.
+    kUploadAll,
+
+    //! \brief Only reports whose upload was explicitly requested. Others wait
+    //!     for a network that isn’t metered.
+    kUploadRequestedOnly,
+  };
+
    //! \brief Options to be passed to the CrashReportUploadThread constructor.
    struct Options {
     //! Whether client identifying parameters like product name or version
@@ -50,14 +114,102 @@ class CrashReportUploadThread : public WorkerThread::Delegate {
     //! Whether uploads should be throttled to a (currently hardcoded) rate.
     bool rate_limit;
 
-    //! Whether uploads should use `gzip` compression.
-    bool upload_gzip;
+    //! How uploads should be compressed.
+    HTTPCompression upload_compression;
+
+    //! Whether report uploads should be sent with a `Content-Length` rather
+    //! than `Transfer-Encoding: chunked`, so that proxies needn’t buffer them.
+    //! A compressed upload is then compressed in memory before it’s sent. See
+    //! HTTPMultipartBuilder::GetBodyStreamWithLength().
+    bool upload_content_length;
+
+    //! What to remove from crash reports as they are uploaded. Reports in the
+    //! database are left intact.
+    RedactionPolicy redaction_policy;
+
+    //! Whether each report should first be uploaded as a minimal minidump,
+    //! holding only the crashing thread and no extra memory, with the full
+    //! minidump following only if the server asks for it in its response. See
+    //! ProcessPendingReport(). Reports whose upload was explicitly requested
+    //! are always uploaded in full.
+    bool upload_minimal_first;
+
+    //! Whether new crash reports may be uploaded as their minidump files are
+    //! written, without being stored in the database. See
+    //! CanUploadDirectly().
+    bool upload_directly;
 
     //! Whether to periodically check for new pending reports not already known
     //! to exist. When `false`, only an initial upload attempt will be made for
     //! reports known to exist by having been added by the ReportPending()
     //! method. No scans for new pending reports will be conducted.
     bool watch_pending_reports;
+
+    //! How long, in seconds, Start() waits before the first scan for pending
+    //! reports when #watch_pending_reports is `true`. The database is not
+    //! examined, and changes to it are not watched for, until then, so that
+    //! this defers any cost of opening it. Reports passed to ReportPending()
+    //! are processed without waiting.
+    double initial_work_delay;
+
+    //! The maximum number of reports to upload concurrently. Each concurrent
+    //! upload runs on its own thread and keeps its HTTP connection alive for
+    //! the next report that it uploads, including in later passes. Values of
+    //! `0` and `1` both cause reports to be uploaded one at a time on the
+    //! upload thread.
+    size_t upload_thread_count;
+
+    //! The order in which pending reports are uploaded.
+    UploadOrder upload_order;
+
+    //! Whether uploads should wait while no network is reachable, and resume
+    //! as soon as one is, rather than being attempted and failing after their
+    //! timeout. If the network can’t be watched, uploads are attempted as
+    //! usual.
+    bool wait_for_network;
+
+    //! Which reports are uploaded while the network is metered. This has no
+    //! effect unless #wait_for_network is `true`.
+    MeteredNetworkPolicy metered_network_policy;
+
+    //! If not empty, the URL to send minidump files to in resumable chunks
+    //! before each report is sent to the URL passed to the constructor. See
+    //! SendMinidumpResumably().
+    std::string resumable_upload_url;
+
+    //! If not empty, the URL to send batches of small reports to, made by
+    //! processes that continued running, in place of the URL passed to the
+    //! constructor. See ProcessPendingReportBatch().
+    std::string batch_upload_url;
+
+    //! The most reports to send in each request to #batch_upload_url. This has
+    //! no effect when #batch_upload_url is empty.
+    size_t batch_upload_max_reports;
+
+    //! If nonzero, the rate, in bytes per second, to which uploads are limited
+    //! in aggregate. See HTTPBandwidthLimiter.
+    uint64_t upload_bandwidth_limit;
+
+    //! The most that may be sent at full speed after uploads have been idle,
+    //! in bytes. If `0`, one second’s worth of #upload_bandwidth_limit. This
+    //! has no effect when #upload_bandwidth_limit is `0`.
+    uint64_t upload_bandwidth_burst;
+
+    //! The executor to run the upload thread’s work on, which is shared with
+    //! other background tasks. Weak. `nullptr` to give the upload thread a
+    //! thread of its own. Concurrent uploads always run on threads of their
+    //! own.
+    WorkerThreadExecutor* executor;
+
+    //! The store holding the pages of reports that CrashReportCompressThread
+    //! wrote as paged files, which are reassembled from it as they are
+    //! uploaded. Weak. `nullptr` if no reports are paged, in which case a
+    //! paged report can’t be uploaded.
+    PageStore* page_store;
+
+    //! If not empty, the path of a file to which UploadStatistics are written
+    //! after each pass over the database and each upload attempt.
+    base::FilePath statistics_path;
   };
 
   //! \brief Constructs a new object.
@@ -72,16 +224,20 @@ class CrashReportUploadThread : public WorkerThread::Delegate {
 
   //! \brief Starts a dedicated upload thread, which executes ThreadMain().
   //!
+  //! The first scan for pending reports happens after
+  //! Options::initial_work_delay, or sooner if ReportPending() is called.
+  //!
   //! This method may only be be called on a newly-constructed object or after
   //! a call to Stop().
   void Start();
 
   //! \brief Stops the upload thread.
   //!
-  //! The upload thread will terminate after completing whatever task it is
-  //! performing. If it is not performing any task, it will terminate
-  //! immediately. This method blocks while waiting for the upload thread to
-  //! terminate.
+  //! Uploads in progress are cancelled, leaving their reports pending so that
+  //! they are retried once the upload thread is started again. The upload
+  //! thread will terminate after abandoning whatever task it is performing. If
+  //! it is not performing any task, it will terminate immediately. This method
+  //! blocks while waiting for the upload thread to terminate.
   //!
   //! This method must only be called after Start(). If Start() has been called,
   //! this method must be called before destroying an object of this class.
@@ -99,6 +255,47 @@ class CrashReportUploadThread : public WorkerThread::Delegate {
   //! This method may be called from any thread.
   void ReportPending(const UUID& report_uuid);
 
+  //! \brief Determines whether a new crash report should be uploaded by
+  //!     UploadMinidumpDirectly() rather than added to the database.
+  //!
+  //! This is the case when Options::upload_directly is set, there is a URL to
+  //! upload to, uploads are enabled in the database’s settings, no redaction
+  //! policy, bandwidth limit, Options::upload_content_length, or
+  //! Options::upload_minimal_first is in effect, no server has deferred
+  //! uploads, the network permits an upload, and rate limiting, if enabled,
+  //! permits an upload attempt now. Otherwise, the report should be added to
+  //! the database and passed to ReportPending() as usual.
+  //!
+  //! This method may be called from any thread.
+  bool CanUploadDirectly();
+
+  //! \brief Uploads a crash report while its minidump file is being written,
+  //!     without storing the minidump file anywhere.
+  //!
+  //! The minidump file is written with seeking disabled, as
+  //! MinidumpFileWriter::WriteMinidump() does when `allow_seek` is `false`, to
+  //! a bounded buffer from which the HTTP request body is read, so that
+  //! memory use does not grow with the size of the minidump file.
+  //!
+  //! There is no database record of a report uploaded this way, so a report
+  //! whose upload fails is lost rather than retried.
+  //!
+  //! \param[in] process_snapshot The snapshot that \a minidump was initialized
+  //!     from, which supplies the HTTP form parameters.
+  //! \param[in] minidump The minidump file to write and upload.
+  //! \param[in] attachments Files to upload along with the minidump file,
+  //!     which are read from where they are as the upload proceeds, as for
+  //!     CrashReportDatabase::NewReport::attachments.
+  //!
+  //! \return `true` if the report was uploaded successfully. `false` on
+  //!     failure, with an appropriate message logged.
+  //!
+  //! This method may be called from any thread other than the upload thread.
+  //! It blocks until the upload is complete.
+  bool UploadMinidumpDirectly(const ProcessSnapshot* process_snapshot,
+                              MinidumpFileWriter* minidump,
+                              const std::vector<base::FilePath>& attachments);
+
  private:
   //! \brief The result code from UploadReport().
   enum class UploadResult {
@@ -118,8 +315,48 @@ class CrashReportUploadThread : public WorkerThread::Delegate {
     //! may arrange to call UploadReport() for the report again in the future,
     //! after a suitable delay.
     kRetry,
+
+    //! \brief The crash report upload was cancelled by Stop().
+    //!
+    //! The report should be left pending, to be uploaded the next time that
+    //! the upload thread runs.
+    kCancelled,
   };
 
+  //! \brief Which minidump UploadReport() sends for a report.
+  enum class MinidumpTier {
+    //! \brief The minidump, subject only to Options::redaction_policy, with no
+    //!     indication that any other will follow it.
+    kComplete,
+
+    //! \brief A minimal minidump derived from the report’s, holding only the
+    //!     crashing thread and no extra memory, sent with a `minidump_tier`
+    //!     form parameter of `minimal`.
+    kMinimal,
+
+    //! \brief The report’s minidump, subject only to
+    //!     Options::redaction_policy, sent at the server’s request after a
+    //!     #kMinimal upload with a `minidump_tier` form parameter of `full`.
+    kFull,
+  };
+
+  class ReportQueue;
+  class UploadWorkerThread;
+
+  //! \brief A report known to be pending, in known_pending_report_uuids_.
+  struct KnownPendingReport : public MPSCQueueNode {
+    explicit KnownPendingReport(const UUID& uuid)
+        : MPSCQueueNode(), uuid(uuid) {}
+
+    UUID uuid;
+  };
+
+  //! \brief Adds \a report_uuid to the reports known to be pending, to be
+  //!     processed on the next pass of ProcessPendingReports().
+  //!
+  //! This method may be called from any thread.
+  void AddKnownPendingReport(const UUID& report_uuid);
+
   //! \brief Calls ProcessPendingReport() on pending reports.
   //!
   //! Assuming Stop() has not been called, this will process reports that the
@@ -127,11 +364,39 @@ class CrashReportUploadThread : public WorkerThread::Delegate {
   //! object was constructed with \a watch_pending_reports, it will also scan
   //! the crash report database for other pending reports, and process those as
   //! well.
+  //!
+  //! Up to Options::upload_thread_count reports are processed concurrently.
+  //! This method returns once all of them have been processed.
   void ProcessPendingReports();
 
+  //! \brief Asks the database to notify pending_report_watcher_ of new pending
+  //!     reports, and starts the watcher if it can.
+  //!
+  //! This is called on the upload thread the first time that it does work,
+  //! rather than on construction, so that the database is not examined until
+  //! the upload thread needs it.
+  void WatchPendingReports();
+
+  //! \brief Starts pending_report_watcher_ if it has been set up by
+  //!     WatchPendingReports(), the object is started, and the watcher is not
+  //!     already running.
+  //!
+  //! pending_report_watcher_lock_ must be held.
+  void StartPendingReportWatcherLocked();
+
+  //! \brief Calls ProcessPendingReport() on reports taken from \a queue,
+  //!     uploading them with \a http_transport, until \a queue is empty or
+  //!     Stop() is called.
+  //!
+  //! This method may be called on several threads at once, each with its own
+  //! \a http_transport.
+  void ProcessQueuedReports(ReportQueue* queue, HTTPTransport* http_transport);
+
   //! \brief Processes a single pending report from the database.
   //!
   //! \param[in] report The crash report to process.
+  //! \param[in] http_transport The transport to upload \a report with. Its
+  //!     settings from any previous request are overwritten.
   //!
   //! If report upload is enabled, this method attempts to upload \a report by
   //! calling UplaodReport(). If the upload is successful, the report will be
@@ -141,7 +406,100 @@ class CrashReportUploadThread : public WorkerThread::Delegate {
   //! remain in the “pending” state. If the upload fails and no more retries are
   //! desired, or report upload is disabled, it will be marked as “completed” in
   //! the database without ever having been uploaded.
-  void ProcessPendingReport(const CrashReportDatabase::Report& report);
+  //!
+  //! With Options::upload_minimal_first, a report whose upload wasn’t
+  //! explicitly requested is uploaded as MinidumpTier::kMinimal. The first
+  //! line of the server’s response body is then taken as the report’s ID, and
+  //! if any later line is `full_dump_requested`, the report is uploaded again
+  //! as MinidumpTier::kFull before it is marked as “completed”. A failure of
+  //! that second upload is logged, but doesn’t undo the first. Either way, the
+  //! report’s full minidump file remains among the database’s completed
+  //! reports until it is pruned.
+  void ProcessPendingReport(const CrashReportDatabase::Report& report,
+                            HTTPTransport* http_transport);
+
+  //! \brief Processes pending reports from the database, uploading them in a
+  //!     single request to Options::batch_upload_url.
+  //!
+  //! \param[in] reports The crash reports to process. There must be more than
+  //!     one.
+  //! \param[in] http_transport The transport to upload \a reports with. Its
+  //!     settings from any previous request are overwritten.
+  //!
+  //! Each report is treated as ProcessPendingReport() would treat it, except
+  //! that the reports are sent together, with their minidump files and form
+  //! parameters in parts whose names are prefixed by each report’s UUID and a
+  //! `/`. Minidump files are read into memory and sent uncompressed, and
+  //! Options::resumable_upload_url and Options::upload_minimal_first don’t
+  //! apply. The request counts as a single attempt against the rate limit.
+  //!
+  //! The server responds with a line for each report of the form
+  //! “UUID STATUS [ID]”. A STATUS of `ok` records a successful upload with
+  //! the ID that the server assigned, `retry` leaves the report pending to be
+  //! retried, and `reject` retires it. Reports that the response doesn’t
+  //! mention are retried.
+  void ProcessPendingReportBatch(
+      const std::vector<const CrashReportDatabase::Report*>& reports,
+      HTTPTransport* http_transport);
+
+  //! \brief Returns whether \a report may be uploaded, according to whether
+  //!     there’s a URL to upload to, whether its upload was explicitly
+  //!     requested, and the database’s settings.
+  bool UploadPermitted(const CrashReportDatabase::Report& report);
+
+  //! \brief Returns whether \a status, returned by
+  //!     CrashReportDatabase::GetReportForUploading() for the report identified
+  //!     by \a report_uuid, indicates that the report was obtained. If not, the
+  //!     report is skipped when it can’t be obtained due to an error.
+  bool ReportClaimed(CrashReportDatabase::OperationStatus status,
+                     const UUID& report_uuid);
+
+  //! \brief Records an attempt to upload \a upload_report in statistics_ and
+  //!     metrics, unless \a upload_result is UploadResult::kCancelled.
+  void RecordAttemptStatistics(const CrashReportDatabase::Report& upload_report,
+                               UploadResult upload_result,
+                               uint64_t duration_ms,
+                               uint64_t stored_size,
+                               uint64_t content_size);
+
+  //! \brief Records the outcome of an attempt to upload \a upload_report in
+  //!     the database, releasing it, and arranges for a retry according to \a
+  //!     upload_result.
+  //!
+  //! \param[in] upload_report A report obtained from
+  //!     CrashReportDatabase::GetReportForUploading().
+  //! \param[in] upload_result The result of the attempt.
+  //! \param[in] id The ID that the server assigned to the report, when \a
+  //!     upload_result is UploadResult::kSuccess.
+  void FinishUploadAttempt(const CrashReportDatabase::Report* upload_report,
+                           UploadResult upload_result,
+                           const std::string& id);
+
+  //! \brief Reads a crash report’s minidump file into memory, along with the
+  //!     form parameters to send with it, for ProcessPendingReportBatch().
+  //!
+  //! The minidump file is decompressed if it was stored compressed,
+  //! reassembled if it was stored as a paged file, and redacted according to
+  //! Options::redaction_policy.
+  //!
+  //! \return UploadResult::kSuccess on success. Otherwise,
+  //!     UploadResult::kPermanentFailure, with an appropriate message logged.
+  UploadResult ReadReportForBatch(
+      const CrashReportDatabase::Report* report,
+      std::map<std::string, std::string>* parameters,
+      std::string* minidump,
+      uint64_t* stored_size);
+
+  //! \brief Initializes \a paged_reader to reassemble a minidump file stored
+  //!     as a paged file from Options::page_store.
+  //!
+  //! \param[out] paged_reader The reader to initialize.
+  //! \param[in] file_reader The minidump file, positioned at its start.
+  //!
+  //! \return `true` on success. `false` on failure, including when there is no
+  //!     Options::page_store, with an error message logged.
+  bool InitializePagedFileReader(PagedFileReader* paged_reader,
+                                 FileReaderInterface* file_reader);
 
   //! \brief Attempts to upload a crash report.
   //!
@@ -149,26 +507,177 @@ class CrashReportUploadThread : public WorkerThread::Delegate {
   //!     calling CrashReportDatabase::GetReportForUploading() before calling
   //!     this method, and for calling
   //!     CrashReportDatabase::RecordUploadAttempt() after calling this method.
+  //! \param[in] tier Which minidump to send for \a report.
+  //! \param[in] minimal_report_id For MinidumpTier::kFull, the ID that the
+  //!     server assigned to the report’s MinidumpTier::kMinimal upload, sent
+  //!     as the `minimal_report_id` form parameter if not empty. Otherwise,
+  //!     ignored.
+  //! \param[in] http_transport The transport to upload \a report with.
   //! \param[out] response_body If the upload attempt is successful, this will
   //!     be set to the response body sent by the server. Breakpad-type servers
   //!     provide the crash ID assigned by the server in the response body.
+  //! \param[out] stored_size The size of the report’s minidump file as stored
+  //!     in the database, or `0` if it couldn’t be determined.
+  //! \param[out] content_size The size of the minidump file’s contents, as
+  //!     sent, or `0` if it couldn’t be determined.
   //!
   //! \return A member of UploadResult indicating the result of the upload
   //!    attempt.
   UploadResult UploadReport(const CrashReportDatabase::Report* report,
-                            std::string* response_body);
+                            MinidumpTier tier,
+                            const std::string& minimal_report_id,
+                            HTTPTransport* http_transport,
+                            std::string* response_body,
+                            uint64_t* stored_size,
+                            uint64_t* content_size);
+
+  //! \brief Sends a crash report’s minidump file to
+  //!     Options::resumable_upload_url in chunks, resuming from wherever the
+  //!     server reports that a previous attempt left off.
+  //!
+  //! The file is sent to a resource named by \a resource_name. A `GET`
+  //! request to the resource learns how many bytes the server already holds,
+  //! and each chunk is sent by a `POST` request carrying `Upload-Offset` and
+  //! `Upload-Length` headers. The server responds to each with the number of
+  //! bytes that it holds, in decimal, as the response body.
+  //!
+  //! \param[in] resource_name The name of the resource to send the file to,
+  //!     relative to Options::resumable_upload_url. The report’s UUID, followed
+  //!     by `-full` for MinidumpTier::kFull.
+  //! \param[in] minidump The minidump file to send. It must support seeking.
+  //! \param[in] http_transport The transport to send the requests with.
+  //!
+  //! \return A member of UploadResult indicating the result of the upload
+  //!    attempt. On success, the server holds the entire file.
+  UploadResult SendMinidumpResumably(const std::string& resource_name,
+                                     FileReaderInterface* minidump,
+                                     HTTPTransport* http_transport);
+
+  //! \brief Sends a crash report to the server.
+  //!
+  //! \param[in] base_url The URL to send the report to, before any client
+  //!     identifying parameters are added to it.
+  //! \param[in] parameters The HTTP form parameters to send along with the
+  //!     minidump file.
+  //! \param[in] http_multipart_builder A builder that the minidump file has
+  //!     already been attached to. \a parameters will be added to it.
+  //! \param[in] minidump_size The size of the minidump file attached to \a
+  //!     http_multipart_builder, before any compression applied as it is sent,
+  //!     or `0` if none is attached. This bounds the time that the request may
+  //!     take when bandwidth is limited.
+  //! \param[in] http_transport The transport to send the request with.
+  //! \param[out] response_body If the upload attempt is successful, this will
+  //!     be set to the response body sent by the server.
+  //!
+  //! \return A member of UploadResult indicating the result of the upload
+  //!    attempt.
+  UploadResult SendReport(const std::string& base_url,
+                          const std::map<std::string, std::string>& parameters,
+                          HTTPMultipartBuilder* http_multipart_builder,
+                          uint64_t minidump_size,
+                          HTTPTransport* http_transport,
+                          std::string* response_body);
+
+  //! \brief Executes the request configured on \a http_transport.
+  //!
+  //! When the server declines the request with status 429 or 503, this calls
+  //! DeferUploads().
+  //!
+  //! \param[in] http_transport The transport to send the request with.
+  //! \param[out] response_body If the request is successful, this will be set
+  //!     to the response body sent by the server.
+  //!
+  //! \return UploadResult::kSuccess, UploadResult::kCancelled, or
+  //!     UploadResult::kRetry.
+  UploadResult ExecuteRequest(HTTPTransport* http_transport,
+                              std::string* response_body);
+
+  //! \brief Defers all uploads from the database after a server declined one,
+  //!     as the server asked in \a retry_after, the value of its `Retry-After`
+  //!     header field, plus a jitter.
+  //!
+  //! A deferral already recorded in the database’s Settings is only ever
+  //! extended.
+  void DeferUploads(const std::string& retry_after);
+
+  //! \brief Sets \a body_stream as the body of the next request sent with \a
+  //!     http_transport, along with a timeout suited to a body of up to \a
+  //!     body_size bytes.
+  //!
+  //! When Options::upload_bandwidth_limit is set, the body is read through a
+  //! BandwidthLimitedHTTPBodyStream, and the timeout is extended by the time
+  //! that sending \a body_size bytes at the limit would take.
+  void SetBodyStream(HTTPTransport* http_transport,
+                     std::unique_ptr<HTTPBodyStream> body_stream,
+                     uint64_t body_size);
+
+  //! \brief Writes statistics_ to Options::statistics_path, if it is set.
+  void WriteStatistics();
 
   // WorkerThread::Delegate:
   //! \brief Calls ProcessPendingReports() in response to ReportPending() having
   //!     been called on any thread, as well as periodically on a timer.
   void DoWork(const WorkerThread* thread) override;
 
+  // DirectoryChangeWatcher::Delegate:
+  //! \brief Triggers ProcessPendingReports() in response to a change in the
+  //!     database.
+  void DirectoryChanged() override;
+
+  // NetworkReachabilityWatcher::Delegate:
+  //! \brief Triggers ProcessPendingReports() in response to a change in the
+  //!     network, so that uploads waiting for it resume.
+  void NetworkReachabilityChanged() override;
+
+  //! \brief Returns whether the network permits uploads now, according to
+  //!     network_watcher_, if it is watching the network.
+  //!
+  //! \param[in] explicitly_requested Whether the upload was explicitly
+  //!     requested, which permits it on a metered network.
+  bool NetworkPermitsUpload(bool explicitly_requested) const;
+
   const Options options_;
   const std::string url_;
+  DirectoryChangeWatcher pending_report_watcher_;
+
+  // Guards the state of pending_report_watcher_, which is set up on the upload
+  // thread but may be stopped by Stop() on another thread.
+  base::Lock pending_report_watcher_lock_;
+  bool pending_report_watch_attempted_;  // Only used on the upload thread.
+  bool watching_pending_reports_;
+  bool pending_report_watcher_running_;
+  bool started_;
+
+  // Set up by the first Start() when Options::wait_for_network is set, and
+  // only started and stopped by Start() and Stop() after that.
+  NetworkReachabilityWatcher network_watcher_;
+  bool network_watch_attempted_;
+  bool watching_network_;
+  bool network_watcher_running_;
+
   WorkerThread thread_;
-  ThreadSafeVector<UUID> known_pending_report_uuids_;
+  // Pushed from any thread, and taken only by ProcessPendingReports() on the
+  // upload thread.
+  MPSCQueue<KnownPendingReport> known_pending_report_uuids_;
   CrashReportDatabase* database_;  // weak
 
+  // Held while checking whether rate limiting permits an upload and claiming
+  // the attempt, so that concurrent uploads can’t together exceed the limit.
+  base::Lock rate_limit_lock_;
+
+  // The transports that reports are uploaded with, one for each thread that
+  // processes reports concurrently. These persist from one pass to the next so
+  // that their connections to the server can be reused, and are lent to the
+  // worker threads during a pass. The vector itself is not modified after
+  // construction, so Stop() may cancel the transports from any thread.
+  const std::vector<std::unique_ptr<HTTPTransport>> http_transports_;
+
+  // Limits the aggregate rate of all uploads when
+  // Options::upload_bandwidth_limit is set, and is nullptr otherwise.
+  const std::unique_ptr<HTTPBandwidthLimiter> bandwidth_limiter_;
+
+  UploadStatistics statistics_;
+
   DISALLOW_COPY_AND_ASSIGN(CrashReportUploadThread);
 };
 
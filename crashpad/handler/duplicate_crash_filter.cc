@@ -0,0 +1,49 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/duplicate_crash_filter.h"
+
+#include <stdint.h>
+#include <time.h>
+
+#include "base/strings/stringprintf.h"
+#include "client/crash_signature_history.h"
+#include "snapshot/crash_signature.h"
+
+namespace crashpad {
+
+bool ShouldReportCrash(CrashSignatureHistory* signature_history,
+                       const ProcessSnapshot* process_snapshot,
+                       std::map<std::string, std::string>* annotations) {
+  uint64_t signature;
+  if (!signature_history ||
+      !ComputeCrashSignature(
+          process_snapshot, kCrashSignatureDefaultFrameCount, &signature)) {
+    return true;
+  }
+
+  uint32_t suppressed_count;
+  if (!signature_history->RecordCrash(
+          signature, time(nullptr), &suppressed_count)) {
+    return false;
+  }
+
+  if (suppressed_count) {
+    (*annotations)[kSuppressedDuplicatesAnnotation] =
+        base::StringPrintf("%u", suppressed_count);
+  }
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,48 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_DUPLICATE_CRASH_FILTER_H_
+#define CRASHPAD_HANDLER_DUPLICATE_CRASH_FILTER_H_
+
+#include <map>
+#include <string>
+
+namespace crashpad {
+
+class CrashSignatureHistory;
+class ProcessSnapshot;
+
+//! \brief The process-level annotation that carries the number of crashes like
+//!     a reported one that were not themselves reported.
+constexpr char kSuppressedDuplicatesAnnotation[] = "suppressed_duplicates";
+
+//! \brief Determines whether a crash should be reported, or collapsed into a
+//!     later report of an earlier crash with the same signature.
+//!
+//! \param[in] signature_history The history of crash signatures to consult and
+//!     update. `nullptr` to report every crash.
+//! \param[in] process_snapshot An initialized snapshot of the crashing process,
+//!     with its exception initialized.
+//! \param[in,out] annotations The process-level annotations to attach to the
+//!     report. If the report will stand for crashes that were not reported,
+//!     kSuppressedDuplicatesAnnotation is set to their number.
+//!
+//! \return `true` if the crash should be reported, `false` if it should not.
+bool ShouldReportCrash(CrashSignatureHistory* signature_history,
+                       const ProcessSnapshot* process_snapshot,
+                       std::map<std::string, std::string>* annotations);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_DUPLICATE_CRASH_FILTER_H_
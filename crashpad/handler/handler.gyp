@@ -35,10 +35,30 @@
         '..',
       ],
       'sources': [
+        'capture_pipeline.cc',
+        'capture_pipeline.h',
+        'capture_tier.cc',
+        'capture_tier.h',
+        'client_dump_quota.cc',
+        'client_dump_quota.h',
+        'crash_report_compress_thread.cc',
+        'crash_report_compress_thread.h',
         'crash_report_upload_thread.cc',
         'crash_report_upload_thread.h',
+        'duplicate_crash_filter.cc',
+        'duplicate_crash_filter.h',
+        'hang_detector.cc',
+        'hang_detector.h',
         'handler_main.cc',
         'handler_main.h',
+        'idle_memory_trimmer.cc',
+        'idle_memory_trimmer.h',
+        'lazy_crash_report_database.cc',
+        'lazy_crash_report_database.h',
+        'linux/crash_report_exception_handler.cc',
+        'linux/crash_report_exception_handler.h',
+        'linux/exception_handler_server.cc',
+        'linux/exception_handler_server.h',
         'mac/crash_report_exception_handler.cc',
         'mac/crash_report_exception_handler.h',
         'mac/exception_handler_server.cc',
@@ -47,10 +67,18 @@
         'mac/file_limit_annotation.h',
         'prune_crash_reports_thread.cc',
         'prune_crash_reports_thread.h',
+        'spare_report_files_thread.cc',
+        'spare_report_files_thread.h',
+        'upload_parameters.cc',
+        'upload_parameters.h',
+        'upload_statistics.cc',
+        'upload_statistics.h',
         'user_stream_data_source.cc',
         'user_stream_data_source.h',
         'win/crash_report_exception_handler.cc',
         'win/crash_report_exception_handler.h',
+        'win/hang_sampler.cc',
+        'win/hang_sampler.h',
       ],
     },
     {
@@ -16,11 +16,15 @@
 
 #include <errno.h>
 #include <getopt.h>
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
+#include <time.h>
 
 #include <algorithm>
+#include <limits>
 #include <map>
 #include <memory>
 #include <string>
@@ -38,21 +42,34 @@
 #include "base/strings/utf_string_conversions.h"
 #include "build/build_config.h"
 #include "client/crash_report_database.h"
+#include "client/crash_signature_history.h"
 #include "client/crashpad_client.h"
 #include "client/crashpad_info.h"
 #include "client/prune_crash_reports.h"
 #include "client/simple_string_dictionary.h"
+#include "handler/capture_tier.h"
+#include "handler/client_dump_quota.h"
+#include "handler/crash_report_compress_thread.h"
 #include "handler/crash_report_upload_thread.h"
+#include "handler/idle_memory_trimmer.h"
+#include "handler/lazy_crash_report_database.h"
 #include "handler/prune_crash_reports_thread.h"
+#include "handler/spare_report_files_thread.h"
+#include "minidump/minidump_static_stream_cache.h"
+#include "snapshot/redacted/redaction_policy.h"
 #include "tools/tool_support.h"
 #include "util/file/file_io.h"
+#include "util/file/page_store.h"
+#include "util/misc/memory_reserve.h"
 #include "util/misc/metrics.h"
 #include "util/misc/paths.h"
+#include "util/net/http_body_compression.h"
 #include "util/numeric/in_range_cast.h"
 #include "util/stdlib/map_insert.h"
 #include "util/stdlib/string_number_conversion.h"
 #include "util/string/split_string.h"
 #include "util/synchronization/semaphore.h"
+#include "util/thread/worker_thread_executor.h"
 
 #if defined(OS_MACOSX)
 #include <libgen.h>
@@ -69,7 +86,9 @@
 #elif defined(OS_WIN)
 #include <windows.h>
 
+#include "handler/capture_pipeline.h"
 #include "handler/win/crash_report_exception_handler.h"
+#include "handler/win/hang_sampler.h"
 #include "util/win/exception_handler_server.h"
 #include "util/win/handle.h"
 #include "util/win/initial_client_data.h"
@@ -85,12 +104,34 @@ void Usage(const base::FilePath& me) {
 "Usage: %" PRFilePath " [OPTION]...\n"
 "Crashpad's exception handler server.\n"
 "\n"
+"      --adaptive-capture      capture less in crash reports as the system\n"
+"                              comes under load\n"
 "      --annotation=KEY=VALUE  set a process annotation in each crash report\n"
+"      --attachment=PATH       attach the file at PATH to each crash report\n"
+#if defined(OS_WIN)
+"      --capture-deadline-ms=MS\n"
+"                              leave optional content out of reports that\n"
+"                              would take longer than MS milliseconds to\n"
+"                              capture\n"
+#endif  // OS_WIN
+"      --capture-only          write crash reports to the database without\n"
+"                              uploading, compressing, or pruning them\n"
+"      --compress-reports      store crash reports compressed in the database\n"
 "      --database=PATH         store the crash report database at PATH\n"
+"      --delta-dumps           omit unchanged streams from repeated dumps\n"
+"                              requested by a running process\n"
+"      --durable-reports       flush new crash reports to storage before\n"
+"                              making them pending\n"
 #if defined(OS_MACOSX)
 "      --handshake-fd=FD       establish communication with the client over FD\n"
 #endif  // OS_MACOSX
 #if defined(OS_WIN)
+"      --hang-sample-interval-ms=MS\n"
+"                              sample for --hang-threshold every MS\n"
+"                              milliseconds\n"
+"      --hang-threshold=SECONDS\n"
+"                              report the initial client's main thread as\n"
+"                              hung after SECONDS of unchanged stack samples\n"
 "      --initial-client-data=HANDLE_request_crash_dump,\n"
 "                            HANDLE_request_non_crash_dump,\n"
 "                            HANDLE_non_crash_dump_completed,\n"
@@ -104,6 +145,16 @@ void Usage(const base::FilePath& me) {
 #if defined(OS_MACOSX)
 "      --mach-service=SERVICE  register SERVICE with the bootstrap server\n"
 #endif  // OS_MACOSX
+"      --lock-reserved-memory  keep the memory of --reserve-memory resident\n"
+"      --max-client-dump-bytes-per-hour=BYTES\n"
+"                              write at most BYTES of dumps requested without\n"
+"                              a crash per client per hour\n"
+"      --max-client-dumps-per-minute=COUNT\n"
+"                              take at most COUNT dumps requested without a\n"
+"                              crash per client per minute\n"
+"      --max-duplicate-reports=COUNT\n"
+"                              report at most COUNT crashes with the same\n"
+"                              signature per hour, counting the rest\n"
 "      --metrics-dir=DIR       store metrics files in DIR (only in Chromium)\n"
 "      --monitor-self          run a second handler to catch crashes in the first\n"
 "      --monitor-self-annotation=KEY=VALUE\n"
@@ -116,13 +167,65 @@ void Usage(const base::FilePath& me) {
 "      --no-periodic-tasks     don't scan for new reports or prune the database\n"
 "      --no-rate-limit         don't rate limit crash uploads\n"
 "      --no-upload-gzip        don't use gzip compression when uploading\n"
+"      --no-wait-for-network   attempt uploads even while no network is\n"
+"                              reachable\n"
 #if defined(OS_WIN)
 "      --pipe-name=PIPE        communicate with the client over PIPE\n"
 #endif  // OS_WIN
+"      --report-commit-window-ms=MS\n"
+"                              flush --durable-reports finished within MS\n"
+"                              milliseconds of each other together\n"
+"      --report-preallocation-size=BYTES\n"
+"                              reserve BYTES of storage for each new crash\n"
+"                              report file\n"
+"      --reserve-memory=BYTES  set aside BYTES of memory at startup, to be\n"
+"                              released when the handler runs out\n"
 #if defined(OS_MACOSX)
 "      --reset-own-crash-exception-port-to-system-default\n"
 "                              reset the server's exception handler to default\n"
 #endif  // OS_MACOSX
+"      --spare-report-files=COUNT\n"
+"                              keep COUNT crash report files created in\n"
+"                              advance\n"
+"      --store-pages           store crash report memory pages shared between\n"
+"                              reports only once in the database\n"
+"      --upload-bandwidth-burst=BYTES\n"
+"                              permit bursts of BYTES at full speed when\n"
+"                              limiting upload bandwidth\n"
+"      --upload-bandwidth-limit=BYTES_PER_SECOND\n"
+"                              limit crash uploads to BYTES_PER_SECOND\n"
+"      --upload-batch-size=COUNT\n"
+"                              send at most COUNT reports in each request to\n"
+"                              the batch upload URL (default 10)\n"
+"      --upload-batch-url=URL  send small reports of processes that continued\n"
+"                              running to URL, several at a time\n"
+"      --upload-content-length send crash uploads with a Content-Length\n"
+"      --upload-directly       upload new crash reports as they are written,\n"
+"                              without storing them in the database\n"
+"      --upload-drop-extra-memory\n"
+"                              remove memory other than thread stacks from\n"
+"                              crash reports before uploading them\n"
+"      --upload-gzip-level=LEVEL\n"
+"                              compress uploads at LEVEL, from 1 (fastest) to\n"
+"                              9 (smallest)\n"
+"      --upload-gzip-threads=COUNT\n"
+"                              compress each upload on COUNT threads\n"
+"      --upload-max-memory-map-regions=COUNT\n"
+"                              retain at most COUNT memory map regions in\n"
+"                              crash reports uploaded\n"
+"      --upload-metered=POLICY upload all (default) or only requested crash\n"
+"                              reports over a metered network\n"
+"      --upload-minimal-first  upload minimal crash reports, followed by full\n"
+"                              ones only when the server asks for them\n"
+"      --upload-order=ORDER    upload reports of equal priority in ORDER,\n"
+"                              newest-first (default) or oldest-first\n"
+"      --upload-redact-annotation=PREFIX\n"
+"                              remove annotations whose keys begin with PREFIX\n"
+"                              from crash reports before uploading them\n"
+"      --upload-resumable-url=URL\n"
+"                              send minidump files to URL in resumable chunks\n"
+"      --upload-stats          write upload statistics to the database\n"
+"                              directory\n"
 "      --url=URL               send crash reports to this Breakpad server URL,\n"
 "                              only if uploads are enabled for the database\n"
 "      --help                  display this help and exit\n"
@@ -134,7 +237,10 @@ void Usage(const base::FilePath& me) {
 struct Options {
   std::map<std::string, std::string> annotations;
   std::map<std::string, std::string> monitor_self_annotations;
+  std::vector<base::FilePath> attachments;
   std::string url;
+  std::string upload_resumable_url;
+  std::string upload_batch_url;
   base::FilePath database;
   base::FilePath metrics_dir;
   std::vector<std::string> monitor_self_arguments;
@@ -145,12 +251,42 @@ struct Options {
 #elif defined(OS_WIN)
   std::string pipe_name;
   InitialClientData initial_client_data;
+  unsigned int capture_deadline_ms;
+  unsigned int hang_sample_interval_ms;
+  unsigned int hang_threshold_seconds;
 #endif  // OS_MACOSX
+  RedactionPolicy upload_redaction_policy;
+  bool adaptive_capture;
+  bool capture_only;
+  bool compress_reports;
+  bool delta_dumps;
+  bool durable_reports;
   bool identify_client_via_url;
+  bool lock_reserved_memory;
   bool monitor_self;
   bool periodic_tasks;
   bool rate_limit;
+  bool store_pages;
+  bool upload_content_length;
+  bool upload_directly;
   bool upload_gzip;
+  bool upload_minimal_first;
+  bool upload_stats;
+  bool wait_for_network;
+  int upload_gzip_level;
+  unsigned int upload_gzip_threads;
+  unsigned int max_client_dumps_per_minute;
+  unsigned int max_duplicate_reports;
+  unsigned int report_commit_window_ms;
+  unsigned int spare_report_files;
+  unsigned int upload_batch_size;
+  uint64_t max_client_dump_bytes_per_hour;
+  uint64_t report_preallocation_size;
+  uint64_t reserve_memory_size;
+  uint64_t upload_bandwidth_burst;
+  uint64_t upload_bandwidth_limit;
+  CrashReportUploadThread::MeteredNetworkPolicy upload_metered_policy;
+  CrashReportUploadThread::UploadOrder upload_order;
 };
 
 // Splits |key_value| on '=' and inserts the resulting key and value into |map|.
@@ -208,8 +344,60 @@ class CallMetricsRecordNormalExit {
   DISALLOW_COPY_AND_ASSIGN(CallMetricsRecordNormalExit);
 };
 
+// The number of crash reports that may be uploaded at once. Reports queued
+// behind a slow upload, such as after an outage, are sent over this many
+// connections, each kept alive from one report to the next.
+constexpr size_t kUploadThreads = 4;
+
+// The number of threads shared by the upload, prune, hang sampling, and memory
+// trimming tasks.
+// The upload task can occupy one for as long as an upload takes, so a second
+// keeps the others on schedule meanwhile.
+constexpr size_t kBackgroundThreads = 2;
+
+// How long after startup the upload thread first scans the database for pending
+// reports. The database is opened lazily, so until then, or until a crash is
+// reported, the handler services clients without having touched it, keeping
+// its startup from competing with that of the application it’s monitoring.
+constexpr double kInitialUploadScanDelaySeconds = 30;
+
+// How long the handler must be idle after writing a crash report before it
+// returns the memory that it used to do so to the system. Crashes often come in
+// bursts, so this leaves time for the next one to reuse that memory.
+constexpr double kIdleMemoryTrimSeconds = 30;
+
+// The default for --upload-batch-size. Reports eligible for batching are small,
+// so a request carrying this many remains modest.
+constexpr unsigned int kDefaultUploadBatchSize = 10;
+
+#if defined(OS_WIN)
+// The default time between stack samples for --hang-threshold.
+constexpr unsigned int kDefaultHangSampleIntervalMs = 1000;
+
+// The shape of the pipeline that writes crash reports once their processes
+// have been released. Serializing a minidump is where most of a report’s I/O
+// takes place, so two may be written at once, while committing reports to the
+// database is brief. Each queue holds this many captured reports, beyond which
+// capturing waits, bounding the memory they hold.
+constexpr size_t kCapturePipelineQueueCapacity = 4;
+constexpr size_t kCapturePipelineSerializeThreads = 2;
+constexpr size_t kCapturePipelineCommitThreads = 1;
+#endif  // OS_WIN
+
+// The period over which --max-duplicate-reports counts crashes.
+constexpr time_t kDuplicateReportWindowSeconds = 60 * 60;
+
+// The name of the file, in the database directory, that records the signatures
+// of recent crashes for --max-duplicate-reports.
+constexpr base::FilePath::CharType kCrashSignatureHistoryName[] =
+    FILE_PATH_LITERAL("crash_signatures.dat");
+
 #if defined(OS_MACOSX)
 
+// The number of threads that exception messages are received on. Exceptions in
+// different tasks are handled concurrently, up to this many at once.
+constexpr size_t kExceptionHandlerServerThreads = 4;
+
 void HandleCrashSignal(int sig, siginfo_t* siginfo, void* context) {
   MetricsRecordExit(Metrics::LifetimeMilestone::kCrashed);
 
@@ -359,16 +547,50 @@ void MonitorSelf(const Options& options) {
     LOG(WARNING) << "--monitor-self-argument=--monitor-self is not supported";
     return;
   }
+  // The second handler only needs to capture a crash of the first, so it
+  // doesn’t upload, compress, or prune reports, and isn’t given the arguments
+  // that control those. Its reports are left pending in the shared database,
+  // where the first handler, or its replacement once restarted, uploads them.
   std::vector<std::string> extra_arguments(options.monitor_self_arguments);
-  if (!options.identify_client_via_url) {
-    extra_arguments.push_back("--no-identify-client-via-url");
+  extra_arguments.push_back("--capture-only");
+  if (options.adaptive_capture) {
+    extra_arguments.push_back("--adaptive-capture");
+  }
+  if (options.durable_reports) {
+    extra_arguments.push_back("--durable-reports");
+    if (options.report_commit_window_ms) {
+      extra_arguments.push_back(
+          base::StringPrintf("--report-commit-window-ms=%u",
+                             options.report_commit_window_ms));
+    }
+  }
+  if (options.max_client_dump_bytes_per_hour) {
+    extra_arguments.push_back(
+        base::StringPrintf("--max-client-dump-bytes-per-hour=%" PRIu64,
+                           options.max_client_dump_bytes_per_hour));
+  }
+  if (options.max_client_dumps_per_minute) {
+    extra_arguments.push_back(
+        base::StringPrintf("--max-client-dumps-per-minute=%u",
+                           options.max_client_dumps_per_minute));
+  }
+  if (options.max_duplicate_reports) {
+    extra_arguments.push_back(
+        base::StringPrintf("--max-duplicate-reports=%u",
+                           options.max_duplicate_reports));
   }
-  extra_arguments.push_back("--no-periodic-tasks");
-  if (!options.rate_limit) {
-    extra_arguments.push_back("--no-rate-limit");
+  if (options.report_preallocation_size) {
+    extra_arguments.push_back(
+        base::StringPrintf("--report-preallocation-size=%" PRIu64,
+                           options.report_preallocation_size));
   }
-  if (!options.upload_gzip) {
-    extra_arguments.push_back("--no-upload-gzip");
+  if (options.reserve_memory_size) {
+    extra_arguments.push_back(
+        base::StringPrintf("--reserve-memory=%" PRIu64,
+                           options.reserve_memory_size));
+    if (options.lock_reserved_memory) {
+      extra_arguments.push_back("--lock-reserved-memory");
+    }
   }
   for (const auto& iterator : options.monitor_self_annotations) {
     extra_arguments.push_back(
@@ -384,7 +606,7 @@ void MonitorSelf(const Options& options) {
   if (!crashpad_client.StartHandler(executable_path,
                                     options.database,
                                     base::FilePath(),
-                                    options.url,
+                                    std::string(),
                                     options.annotations,
                                     extra_arguments,
                                     true,
@@ -412,17 +634,32 @@ int HandlerMain(int argc,
   enum OptionFlags {
     // Long options without short equivalents.
     kOptionLastChar = 255,
+    kOptionAdaptiveCapture,
     kOptionAnnotation,
+    kOptionAttachment,
+#if defined(OS_WIN)
+    kOptionCaptureDeadlineMs,
+#endif  // OS_WIN
+    kOptionCaptureOnly,
+    kOptionCompressReports,
     kOptionDatabase,
+    kOptionDeltaDumps,
+    kOptionDurableReports,
 #if defined(OS_MACOSX)
     kOptionHandshakeFD,
 #endif  // OS_MACOSX
 #if defined(OS_WIN)
+    kOptionHangSampleIntervalMs,
+    kOptionHangThreshold,
     kOptionInitialClientData,
 #endif  // OS_WIN
+    kOptionLockReservedMemory,
 #if defined(OS_MACOSX)
     kOptionMachService,
 #endif  // OS_MACOSX
+    kOptionMaxClientDumpBytesPerHour,
+    kOptionMaxClientDumpsPerMinute,
+    kOptionMaxDuplicateReports,
     kOptionMetrics,
     kOptionMonitorSelf,
     kOptionMonitorSelfAnnotation,
@@ -431,12 +668,34 @@ int HandlerMain(int argc,
     kOptionNoPeriodicTasks,
     kOptionNoRateLimit,
     kOptionNoUploadGzip,
+    kOptionNoWaitForNetwork,
 #if defined(OS_WIN)
     kOptionPipeName,
 #endif  // OS_WIN
+    kOptionReportCommitWindowMs,
+    kOptionReportPreallocationSize,
+    kOptionReserveMemory,
 #if defined(OS_MACOSX)
     kOptionResetOwnCrashExceptionPortToSystemDefault,
 #endif  // OS_MACOSX
+    kOptionSpareReportFiles,
+    kOptionStorePages,
+    kOptionUploadBandwidthBurst,
+    kOptionUploadBandwidthLimit,
+    kOptionUploadBatchSize,
+    kOptionUploadBatchURL,
+    kOptionUploadContentLength,
+    kOptionUploadDirectly,
+    kOptionUploadDropExtraMemory,
+    kOptionUploadGzipLevel,
+    kOptionUploadGzipThreads,
+    kOptionUploadMaxMemoryMapRegions,
+    kOptionUploadMetered,
+    kOptionUploadMinimalFirst,
+    kOptionUploadOrder,
+    kOptionUploadRedactAnnotation,
+    kOptionUploadResumableURL,
+    kOptionUploadStats,
     kOptionURL,
 
     // Standard options.
@@ -445,12 +704,29 @@ int HandlerMain(int argc,
   };
 
   static constexpr option long_options[] = {
+    {"adaptive-capture", no_argument, nullptr, kOptionAdaptiveCapture},
     {"annotation", required_argument, nullptr, kOptionAnnotation},
+    {"attachment", required_argument, nullptr, kOptionAttachment},
+#if defined(OS_WIN)
+    {"capture-deadline-ms",
+     required_argument,
+     nullptr,
+     kOptionCaptureDeadlineMs},
+#endif  // OS_WIN
+    {"capture-only", no_argument, nullptr, kOptionCaptureOnly},
+    {"compress-reports", no_argument, nullptr, kOptionCompressReports},
     {"database", required_argument, nullptr, kOptionDatabase},
+    {"delta-dumps", no_argument, nullptr, kOptionDeltaDumps},
+    {"durable-reports", no_argument, nullptr, kOptionDurableReports},
 #if defined(OS_MACOSX)
     {"handshake-fd", required_argument, nullptr, kOptionHandshakeFD},
 #endif  // OS_MACOSX
 #if defined(OS_WIN)
+    {"hang-sample-interval-ms",
+     required_argument,
+     nullptr,
+     kOptionHangSampleIntervalMs},
+    {"hang-threshold", required_argument, nullptr, kOptionHangThreshold},
     {"initial-client-data",
      required_argument,
      nullptr,
@@ -459,6 +735,19 @@ int HandlerMain(int argc,
 #if defined(OS_MACOSX)
     {"mach-service", required_argument, nullptr, kOptionMachService},
 #endif  // OS_MACOSX
+    {"lock-reserved-memory", no_argument, nullptr, kOptionLockReservedMemory},
+    {"max-client-dump-bytes-per-hour",
+     required_argument,
+     nullptr,
+     kOptionMaxClientDumpBytesPerHour},
+    {"max-client-dumps-per-minute",
+     required_argument,
+     nullptr,
+     kOptionMaxClientDumpsPerMinute},
+    {"max-duplicate-reports",
+     required_argument,
+     nullptr,
+     kOptionMaxDuplicateReports},
     {"metrics-dir", required_argument, nullptr, kOptionMetrics},
     {"monitor-self", no_argument, nullptr, kOptionMonitorSelf},
     {"monitor-self-annotation",
@@ -476,15 +765,73 @@ int HandlerMain(int argc,
     {"no-periodic-tasks", no_argument, nullptr, kOptionNoPeriodicTasks},
     {"no-rate-limit", no_argument, nullptr, kOptionNoRateLimit},
     {"no-upload-gzip", no_argument, nullptr, kOptionNoUploadGzip},
+    {"no-wait-for-network", no_argument, nullptr, kOptionNoWaitForNetwork},
 #if defined(OS_WIN)
     {"pipe-name", required_argument, nullptr, kOptionPipeName},
 #endif  // OS_WIN
+    {"report-commit-window-ms",
+     required_argument,
+     nullptr,
+     kOptionReportCommitWindowMs},
+    {"report-preallocation-size",
+     required_argument,
+     nullptr,
+     kOptionReportPreallocationSize},
+    {"reserve-memory", required_argument, nullptr, kOptionReserveMemory},
 #if defined(OS_MACOSX)
     {"reset-own-crash-exception-port-to-system-default",
      no_argument,
      nullptr,
      kOptionResetOwnCrashExceptionPortToSystemDefault},
 #endif  // OS_MACOSX
+    {"spare-report-files",
+     required_argument,
+     nullptr,
+     kOptionSpareReportFiles},
+    {"store-pages", no_argument, nullptr, kOptionStorePages},
+    {"upload-bandwidth-burst",
+     required_argument,
+     nullptr,
+     kOptionUploadBandwidthBurst},
+    {"upload-bandwidth-limit",
+     required_argument,
+     nullptr,
+     kOptionUploadBandwidthLimit},
+    {"upload-batch-size", required_argument, nullptr, kOptionUploadBatchSize},
+    {"upload-batch-url", required_argument, nullptr, kOptionUploadBatchURL},
+    {"upload-content-length",
+     no_argument,
+     nullptr,
+     kOptionUploadContentLength},
+    {"upload-directly", no_argument, nullptr, kOptionUploadDirectly},
+    {"upload-drop-extra-memory",
+     no_argument,
+     nullptr,
+     kOptionUploadDropExtraMemory},
+    {"upload-gzip-level", required_argument, nullptr, kOptionUploadGzipLevel},
+    {"upload-gzip-threads",
+     required_argument,
+     nullptr,
+     kOptionUploadGzipThreads},
+    {"upload-max-memory-map-regions",
+     required_argument,
+     nullptr,
+     kOptionUploadMaxMemoryMapRegions},
+    {"upload-metered", required_argument, nullptr, kOptionUploadMetered},
+    {"upload-minimal-first",
+     no_argument,
+     nullptr,
+     kOptionUploadMinimalFirst},
+    {"upload-order", required_argument, nullptr, kOptionUploadOrder},
+    {"upload-redact-annotation",
+     required_argument,
+     nullptr,
+     kOptionUploadRedactAnnotation},
+    {"upload-resumable-url",
+     required_argument,
+     nullptr,
+     kOptionUploadResumableURL},
+    {"upload-stats", no_argument, nullptr, kOptionUploadStats},
     {"url", required_argument, nullptr, kOptionURL},
     {"help", no_argument, nullptr, kOptionHelp},
     {"version", no_argument, nullptr, kOptionVersion},
@@ -494,26 +841,71 @@ int HandlerMain(int argc,
   Options options = {};
 #if defined(OS_MACOSX)
   options.handshake_fd = -1;
+#elif defined(OS_WIN)
+  options.hang_sample_interval_ms = kDefaultHangSampleIntervalMs;
 #endif
   options.identify_client_via_url = true;
   options.periodic_tasks = true;
   options.rate_limit = true;
+  options.upload_batch_size = kDefaultUploadBatchSize;
   options.upload_gzip = true;
+  options.upload_gzip_level = HTTPCompression::kDefaultLevel;
+  options.upload_gzip_threads = 1;
+  options.upload_metered_policy =
+      CrashReportUploadThread::MeteredNetworkPolicy::kUploadAll;
+  options.upload_order = CrashReportUploadThread::UploadOrder::kNewestFirst;
+  options.wait_for_network = true;
 
   int opt;
   while ((opt = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
     switch (opt) {
+      case kOptionAdaptiveCapture: {
+        options.adaptive_capture = true;
+        break;
+      }
       case kOptionAnnotation: {
         if (!AddKeyValueToMap(&options.annotations, optarg, "--annotation")) {
           return ExitFailure();
         }
         break;
       }
+      case kOptionAttachment: {
+        options.attachments.push_back(base::FilePath(
+            ToolSupport::CommandLineArgumentToFilePathStringType(optarg)));
+        break;
+      }
+#if defined(OS_WIN)
+      case kOptionCaptureDeadlineMs: {
+        if (!StringToNumber(optarg, &options.capture_deadline_ms) ||
+            !options.capture_deadline_ms) {
+          ToolSupport::UsageHint(
+              me, "--capture-deadline-ms requires a positive MS");
+          return ExitFailure();
+        }
+        break;
+      }
+#endif  // OS_WIN
+      case kOptionCaptureOnly: {
+        options.capture_only = true;
+        break;
+      }
+      case kOptionCompressReports: {
+        options.compress_reports = true;
+        break;
+      }
       case kOptionDatabase: {
         options.database = base::FilePath(
             ToolSupport::CommandLineArgumentToFilePathStringType(optarg));
         break;
       }
+      case kOptionDeltaDumps: {
+        options.delta_dumps = true;
+        break;
+      }
+      case kOptionDurableReports: {
+        options.durable_reports = true;
+        break;
+      }
 #if defined(OS_MACOSX)
       case kOptionHandshakeFD: {
         if (!StringToNumber(optarg, &options.handshake_fd) ||
@@ -530,6 +922,24 @@ int HandlerMain(int argc,
       }
 #endif  // OS_MACOSX
 #if defined(OS_WIN)
+      case kOptionHangSampleIntervalMs: {
+        if (!StringToNumber(optarg, &options.hang_sample_interval_ms) ||
+            !options.hang_sample_interval_ms) {
+          ToolSupport::UsageHint(
+              me, "--hang-sample-interval-ms requires a positive MS");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionHangThreshold: {
+        if (!StringToNumber(optarg, &options.hang_threshold_seconds) ||
+            !options.hang_threshold_seconds) {
+          ToolSupport::UsageHint(
+              me, "--hang-threshold requires a positive SECONDS");
+          return ExitFailure();
+        }
+        break;
+      }
       case kOptionInitialClientData: {
         if (!options.initial_client_data.InitializeFromString(optarg)) {
           ToolSupport::UsageHint(
@@ -539,6 +949,37 @@ int HandlerMain(int argc,
         break;
       }
 #endif  // OS_WIN
+      case kOptionLockReservedMemory: {
+        options.lock_reserved_memory = true;
+        break;
+      }
+      case kOptionMaxClientDumpBytesPerHour: {
+        if (!StringToNumber(optarg, &options.max_client_dump_bytes_per_hour) ||
+            !options.max_client_dump_bytes_per_hour) {
+          ToolSupport::UsageHint(
+              me, "--max-client-dump-bytes-per-hour requires a positive BYTES");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionMaxClientDumpsPerMinute: {
+        if (!StringToNumber(optarg, &options.max_client_dumps_per_minute) ||
+            !options.max_client_dumps_per_minute) {
+          ToolSupport::UsageHint(
+              me, "--max-client-dumps-per-minute requires a positive COUNT");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionMaxDuplicateReports: {
+        if (!StringToNumber(optarg, &options.max_duplicate_reports) ||
+            !options.max_duplicate_reports) {
+          ToolSupport::UsageHint(
+              me, "--max-duplicate-reports requires a positive COUNT");
+          return ExitFailure();
+        }
+        break;
+      }
       case kOptionMetrics: {
         options.metrics_dir = base::FilePath(
             ToolSupport::CommandLineArgumentToFilePathStringType(optarg));
@@ -576,18 +1017,185 @@ int HandlerMain(int argc,
         options.upload_gzip = false;
         break;
       }
+      case kOptionNoWaitForNetwork: {
+        options.wait_for_network = false;
+        break;
+      }
 #if defined(OS_WIN)
       case kOptionPipeName: {
         options.pipe_name = optarg;
         break;
       }
 #endif  // OS_WIN
+      case kOptionReportCommitWindowMs: {
+        if (!StringToNumber(optarg, &options.report_commit_window_ms) ||
+            !options.report_commit_window_ms) {
+          ToolSupport::UsageHint(
+              me, "--report-commit-window-ms requires a positive MS");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionReportPreallocationSize: {
+        if (!StringToNumber(optarg, &options.report_preallocation_size) ||
+            !options.report_preallocation_size ||
+            options.report_preallocation_size >
+                static_cast<uint64_t>(std::numeric_limits<FileOffset>::max())) {
+          ToolSupport::UsageHint(
+              me, "--report-preallocation-size requires a positive BYTES");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionReserveMemory: {
+        if (!StringToNumber(optarg, &options.reserve_memory_size) ||
+            !options.reserve_memory_size ||
+            options.reserve_memory_size >
+                static_cast<uint64_t>(std::numeric_limits<size_t>::max())) {
+          ToolSupport::UsageHint(
+              me, "--reserve-memory requires a positive BYTES");
+          return ExitFailure();
+        }
+        break;
+      }
 #if defined(OS_MACOSX)
       case kOptionResetOwnCrashExceptionPortToSystemDefault: {
         options.reset_own_crash_exception_port_to_system_default = true;
         break;
       }
 #endif  // OS_MACOSX
+      case kOptionSpareReportFiles: {
+        if (!StringToNumber(optarg, &options.spare_report_files) ||
+            !options.spare_report_files) {
+          ToolSupport::UsageHint(
+              me, "--spare-report-files requires a positive COUNT");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionStorePages: {
+        options.store_pages = true;
+        break;
+      }
+      case kOptionUploadBandwidthBurst: {
+        if (!StringToNumber(optarg, &options.upload_bandwidth_burst) ||
+            !options.upload_bandwidth_burst) {
+          ToolSupport::UsageHint(
+              me, "--upload-bandwidth-burst requires a positive BYTES");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionUploadBandwidthLimit: {
+        if (!StringToNumber(optarg, &options.upload_bandwidth_limit) ||
+            !options.upload_bandwidth_limit) {
+          ToolSupport::UsageHint(
+              me,
+              "--upload-bandwidth-limit requires a positive BYTES_PER_SECOND");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionUploadBatchSize: {
+        if (!StringToNumber(optarg, &options.upload_batch_size) ||
+            !options.upload_batch_size) {
+          ToolSupport::UsageHint(
+              me, "--upload-batch-size requires a positive COUNT");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionUploadBatchURL: {
+        options.upload_batch_url = optarg;
+        break;
+      }
+      case kOptionUploadContentLength: {
+        options.upload_content_length = true;
+        break;
+      }
+      case kOptionUploadDirectly: {
+        options.upload_directly = true;
+        break;
+      }
+      case kOptionUploadDropExtraMemory: {
+        options.upload_redaction_policy.drop_extra_memory = true;
+        break;
+      }
+      case kOptionUploadGzipLevel: {
+        if (!StringToNumber(optarg, &options.upload_gzip_level) ||
+            options.upload_gzip_level < 1 || options.upload_gzip_level > 9) {
+          ToolSupport::UsageHint(
+              me, "--upload-gzip-level requires a level from 1 to 9");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionUploadGzipThreads: {
+        if (!StringToNumber(optarg, &options.upload_gzip_threads) ||
+            options.upload_gzip_threads < 1) {
+          ToolSupport::UsageHint(
+              me, "--upload-gzip-threads requires a positive COUNT");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionUploadMaxMemoryMapRegions: {
+        unsigned int max_memory_map_regions;
+        if (!StringToNumber(optarg, &max_memory_map_regions) ||
+            !max_memory_map_regions) {
+          ToolSupport::UsageHint(
+              me, "--upload-max-memory-map-regions requires a positive count");
+          return ExitFailure();
+        }
+        options.upload_redaction_policy.max_memory_map_regions =
+            max_memory_map_regions;
+        break;
+      }
+      case kOptionUploadMetered: {
+        if (strcmp(optarg, "all") == 0) {
+          options.upload_metered_policy =
+              CrashReportUploadThread::MeteredNetworkPolicy::kUploadAll;
+        } else if (strcmp(optarg, "requested") == 0) {
+          options.upload_metered_policy = CrashReportUploadThread::
+              MeteredNetworkPolicy::kUploadRequestedOnly;
+        } else {
+          ToolSupport::UsageHint(
+              me, "--upload-metered requires all or requested");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionUploadMinimalFirst: {
+        options.upload_minimal_first = true;
+        break;
+      }
+      case kOptionUploadOrder: {
+        if (strcmp(optarg, "newest-first") == 0) {
+          options.upload_order =
+              CrashReportUploadThread::UploadOrder::kNewestFirst;
+        } else if (strcmp(optarg, "oldest-first") == 0) {
+          options.upload_order =
+              CrashReportUploadThread::UploadOrder::kOldestFirst;
+        } else {
+          ToolSupport::UsageHint(
+              me, "--upload-order requires newest-first or oldest-first");
+          return ExitFailure();
+        }
+        break;
+      }
+      case kOptionUploadRedactAnnotation: {
+        options.upload_redaction_policy.annotation_key_prefixes.push_back(
+            optarg);
+        break;
+      }
+      case kOptionUploadResumableURL: {
+        options.upload_resumable_url = optarg;
+        break;
+      }
+      case kOptionUploadStats: {
+        options.upload_stats = true;
+        break;
+      }
       case kOptionURL: {
         options.url = optarg;
         break;
@@ -632,6 +1240,12 @@ int HandlerMain(int argc,
         me, "--initial-client-data and --pipe-name are incompatible");
     return ExitFailure();
   }
+  if (options.hang_threshold_seconds &&
+      !options.initial_client_data.IsValid()) {
+    ToolSupport::UsageHint(
+        me, "--hang-threshold requires --initial-client-data");
+    return ExitFailure();
+  }
 #endif  // OS_MACOSX
 
   if (options.database.empty()) {
@@ -696,7 +1310,9 @@ int HandlerMain(int argc,
   }
 
   ExceptionHandlerServer exception_handler_server(
-      std::move(receive_right), !options.mach_service.empty());
+      std::move(receive_right),
+      !options.mach_service.empty(),
+      kExceptionHandlerServerThreads);
   base::AutoReset<ExceptionHandlerServer*> reset_g_exception_handler_server(
       &g_exception_handler_server, &exception_handler_server);
 
@@ -742,39 +1358,180 @@ int HandlerMain(int argc,
 
   Metrics::HandlerLifetimeMilestone(Metrics::LifetimeMilestone::kStarted);
 
+  // A client that crashes for want of memory may leave the handler without
+  // enough to capture it, so memory is set aside now to be given back then.
+  // A reserve that can’t be mapped in full is still installed.
+  MemoryReserve memory_reserve;
+  if (options.reserve_memory_size) {
+    memory_reserve.Initialize(static_cast<size_t>(options.reserve_memory_size),
+                              options.lock_reserved_memory);
+    memory_reserve.InstallNewHandler();
+  }
+
+  // The database is opened the first time that it’s needed, so that clients
+  // can be serviced sooner. A database that can’t be opened is reported then.
   std::unique_ptr<CrashReportDatabase> database(
-      CrashReportDatabase::Initialize(options.database));
-  if (!database) {
-    return ExitFailure();
+      new LazyCrashReportDatabase(options.database));
+
+  if (options.report_preallocation_size || options.spare_report_files ||
+      options.durable_reports) {
+    CrashReportDatabase::NewReportFileOptions new_report_file_options;
+    new_report_file_options.preallocation_size =
+        options.report_preallocation_size;
+    new_report_file_options.spare_file_count = options.spare_report_files;
+    new_report_file_options.durable = options.durable_reports;
+    new_report_file_options.commit_window_ms = options.report_commit_window_ms;
+    database->SetNewReportFileOptions(new_report_file_options);
   }
 
+  // Periodic background tasks share these threads rather than each having one
+  // of its own.
+  WorkerThreadExecutor background_executor(kBackgroundThreads);
+  background_executor.Start();
+
   // TODO(scottmg): options.rate_limit should be removed when we have a
   // configurable database setting to control upload limiting.
   // See https://crashpad.chromium.org/bug/23.
+  std::unique_ptr<PageStore> page_store;
+  if (options.store_pages) {
+    page_store.reset(
+        new PageStore(options.database.Append(FILE_PATH_LITERAL("pages"))));
+  }
+
   CrashReportUploadThread::Options upload_thread_options;
   upload_thread_options.identify_client_via_url =
       options.identify_client_via_url;
   upload_thread_options.rate_limit = options.rate_limit;
-  upload_thread_options.upload_gzip = options.upload_gzip;
+  if (options.upload_gzip) {
+    upload_thread_options.upload_compression.coding = HTTPContentCoding::kGzip;
+    upload_thread_options.upload_compression.level = options.upload_gzip_level;
+    upload_thread_options.upload_compression.threads =
+        options.upload_gzip_threads;
+  }
+  upload_thread_options.upload_content_length = options.upload_content_length;
+  upload_thread_options.redaction_policy = options.upload_redaction_policy;
+  upload_thread_options.upload_minimal_first = options.upload_minimal_first;
+  upload_thread_options.upload_directly = options.upload_directly;
   upload_thread_options.watch_pending_reports = options.periodic_tasks;
-  CrashReportUploadThread upload_thread(database.get(),
-                                        options.url,
-                                        upload_thread_options);
-  upload_thread.Start();
+  upload_thread_options.initial_work_delay = kInitialUploadScanDelaySeconds;
+  upload_thread_options.upload_thread_count = kUploadThreads;
+  upload_thread_options.resumable_upload_url = options.upload_resumable_url;
+  upload_thread_options.batch_upload_url = options.upload_batch_url;
+  upload_thread_options.batch_upload_max_reports = options.upload_batch_size;
+  upload_thread_options.upload_order = options.upload_order;
+  upload_thread_options.wait_for_network = options.wait_for_network;
+  upload_thread_options.metered_network_policy = options.upload_metered_policy;
+  upload_thread_options.upload_bandwidth_limit = options.upload_bandwidth_limit;
+  upload_thread_options.upload_bandwidth_burst = options.upload_bandwidth_burst;
+  upload_thread_options.page_store = page_store.get();
+  upload_thread_options.executor = &background_executor;
+  if (options.upload_stats) {
+    upload_thread_options.statistics_path =
+        options.database.Append(FILE_PATH_LITERAL("upload_stats"));
+  }
+  // A handler that only captures leaves its reports pending in the database,
+  // for another handler to upload.
+  std::unique_ptr<CrashReportUploadThread> upload_thread;
+  if (!options.capture_only) {
+    upload_thread.reset(new CrashReportUploadThread(
+        database.get(), options.url, upload_thread_options));
+    upload_thread->Start();
+  }
+
+  std::unique_ptr<CrashReportCompressThread> compress_thread;
+  if (upload_thread && (options.compress_reports || options.store_pages)) {
+    compress_thread.reset(new CrashReportCompressThread(
+        database.get(), page_store.get(), upload_thread.get()));
+    compress_thread->Start();
+  }
 
   std::unique_ptr<PruneCrashReportThread> prune_thread;
-  if (options.periodic_tasks) {
-    prune_thread.reset(new PruneCrashReportThread(
-        database.get(), PruneCondition::GetDefault()));
+  if (options.periodic_tasks && !options.capture_only) {
+    prune_thread.reset(new PruneCrashReportThread(database.get(),
+                                                  PruneCondition::GetDefault(),
+                                                  page_store.get(),
+                                                  &background_executor));
     prune_thread->Start();
   }
 
+  // Spare report files are only useful when they’re replaced as they’re used.
+  std::unique_ptr<SpareReportFilesThread> spare_report_files_thread;
+  if (options.periodic_tasks && !options.capture_only &&
+      options.spare_report_files) {
+    spare_report_files_thread.reset(
+        new SpareReportFilesThread(database.get(), &background_executor));
+    spare_report_files_thread->Start();
+  }
+
+  IdleMemoryTrimmer idle_memory_trimmer(kIdleMemoryTrimSeconds,
+                                        &background_executor);
+  if (options.reserve_memory_size) {
+    idle_memory_trimmer.SetMemoryReserve(&memory_reserve);
+  }
+  idle_memory_trimmer.Start();
+
+  std::unique_ptr<MinidumpStaticStreamCache> static_stream_cache;
+  if (options.delta_dumps) {
+    static_stream_cache.reset(new MinidumpStaticStreamCache());
+  }
+
+  std::unique_ptr<CrashSignatureHistory> signature_history;
+  if (options.max_duplicate_reports) {
+    signature_history.reset(new CrashSignatureHistory(
+        options.database.Append(kCrashSignatureHistoryName),
+        options.max_duplicate_reports,
+        kDuplicateReportWindowSeconds));
+  }
+
+  std::unique_ptr<ClientDumpQuota> dump_quota;
+  if (options.max_client_dumps_per_minute ||
+      options.max_client_dump_bytes_per_hour) {
+    dump_quota.reset(
+        new ClientDumpQuota(options.max_client_dumps_per_minute,
+                            options.max_client_dump_bytes_per_hour));
+  }
+
+  std::unique_ptr<CaptureTierSelector> capture_tier_selector;
+  if (options.adaptive_capture) {
+    capture_tier_selector.reset(
+        new CaptureTierSelector(database.get(), options.database));
+  }
+
   CrashReportExceptionHandler exception_handler(database.get(),
-                                                &upload_thread,
+                                                upload_thread.get(),
+                                                compress_thread.get(),
                                                 &options.annotations,
-                                                user_stream_sources);
+                                                user_stream_sources,
+                                                static_stream_cache.get(),
+                                                signature_history.get(),
+                                                dump_quota.get(),
+                                                &idle_memory_trimmer);
+  exception_handler.SetCaptureTierSelector(capture_tier_selector.get());
+  exception_handler.SetAttachments(options.attachments);
 
 #if defined(OS_WIN)
+  // Reports are written by the pipeline, which is stopped once the server
+  // stops handing it exceptions, and before anything that it writes reports to.
+  CapturePipeline capture_pipeline(kCapturePipelineQueueCapacity,
+                                   kCapturePipelineSerializeThreads,
+                                   kCapturePipelineCommitThreads);
+  capture_pipeline.Start();
+  exception_handler.SetCapturePipeline(&capture_pipeline);
+  exception_handler.SetCaptureDeadline(options.capture_deadline_ms);
+
+  // The sampler duplicates the client’s process handle before the server takes
+  // ownership of it.
+  std::unique_ptr<HangSampler> hang_sampler;
+  if (options.hang_threshold_seconds) {
+    hang_sampler.reset(
+        new HangSampler(options.initial_client_data.client_process(),
+                        &exception_handler,
+                        options.hang_threshold_seconds,
+                        options.hang_sample_interval_ms / 1000.0,
+                        &background_executor));
+    hang_sampler->Start();
+  }
+
   if (options.initial_client_data.IsValid()) {
     exception_handler_server.InitializeWithInheritedDataForInitialClient(
         options.initial_client_data, &exception_handler);
@@ -783,10 +1540,29 @@ int HandlerMain(int argc,
 
   exception_handler_server.Run(&exception_handler);
 
-  upload_thread.Stop();
+#if defined(OS_WIN)
+  if (hang_sampler) {
+    hang_sampler->Stop();
+  }
+  capture_pipeline.Stop();
+#endif  // OS_WIN
+
+  // Reports still waiting to be compressed are made pending before the upload
+  // thread stops.
+  if (compress_thread) {
+    compress_thread->Stop();
+  }
+  if (upload_thread) {
+    upload_thread->Stop();
+  }
   if (prune_thread) {
     prune_thread->Stop();
   }
+  if (spare_report_files_thread) {
+    spare_report_files_thread->Stop();
+  }
+  idle_memory_trimmer.Stop();
+  background_executor.Stop();
 
   return EXIT_SUCCESS;
 }
@@ -38,6 +38,21 @@
   'conditions': [
     ['OS=="win"', {
       'targets': [
+        {
+          'target_name': 'crash_benchmark_client',
+          'type': 'executable',
+          'dependencies': [
+            '../client/client.gyp:crashpad_client',
+            '../third_party/mini_chromium/mini_chromium.gyp:base',
+            '../util/util.gyp:crashpad_util',
+          ],
+          'include_dirs': [
+            '..',
+          ],
+          'sources': [
+            'win/crash_benchmark_client.cc',
+          ],
+        },
         {
           'target_name': 'crash_other_program',
           'type': 'executable',
@@ -71,7 +86,13 @@
             '..',
           ],
           'sources': [
+            'capture_pipeline_test.cc',
+            'capture_tier_test.cc',
+            'client_dump_quota_test.cc',
             'crashpad_handler_test.cc',
+            'hang_detector_test.cc',
+            'idle_memory_trimmer_test.cc',
+            'upload_statistics_test.cc',
           ],
         },
         {
@@ -0,0 +1,101 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/hang_detector.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+namespace {
+
+bool SameTopFrames(const HangDetector::Sample& a,
+                   const HangDetector::Sample& b) {
+  const size_t a_count =
+      std::min(a.frames.size(), HangDetector::kFramesCompared);
+  const size_t b_count =
+      std::min(b.frames.size(), HangDetector::kFramesCompared);
+  return a_count == b_count &&
+         std::equal(a.frames.begin(), a.frames.begin() + a_count,
+                    b.frames.begin());
+}
+
+}  // namespace
+
+HangDetector::Sample::Sample() : time_ns(0), frames() {}
+
+HangDetector::Sample::~Sample() {}
+
+HangDetector::HangDetector(uint64_t threshold_ns)
+    : samples_(),
+      next_sample_(0),
+      threshold_ns_(threshold_ns),
+      run_start_ns_(0),
+      run_reported_(false) {
+  samples_.reserve(kMaxSamples);
+}
+
+HangDetector::~HangDetector() {}
+
+bool HangDetector::AddSample(const Sample& sample) {
+  const Sample* latest = Latest();
+  DCHECK(!latest || sample.time_ns >= latest->time_ns);
+
+  if (!latest || sample.frames.empty() || !SameTopFrames(*latest, sample)) {
+    run_start_ns_ = sample.time_ns;
+    run_reported_ = false;
+  }
+
+  if (samples_.size() < kMaxSamples) {
+    samples_.push_back(sample);
+  } else {
+    samples_[next_sample_] = sample;
+  }
+  next_sample_ = (next_sample_ + 1) % kMaxSamples;
+
+  if (sample.frames.empty() || run_reported_ ||
+      sample.time_ns - run_start_ns_ < threshold_ns_) {
+    return false;
+  }
+
+  run_reported_ = true;
+  return true;
+}
+
+uint64_t HangDetector::CurrentRunNanoseconds() const {
+  const Sample* latest = Latest();
+  return latest && !latest->frames.empty() ? latest->time_ns - run_start_ns_
+                                           : 0;
+}
+
+std::vector<const HangDetector::Sample*> HangDetector::Samples() const {
+  std::vector<const Sample*> samples;
+  samples.reserve(samples_.size());
+  const size_t oldest = samples_.size() < kMaxSamples ? 0 : next_sample_;
+  for (size_t index = 0; index < samples_.size(); ++index) {
+    samples.push_back(&samples_[(oldest + index) % samples_.size()]);
+  }
+  return samples;
+}
+
+const HangDetector::Sample* HangDetector::Latest() const {
+  if (samples_.empty()) {
+    return nullptr;
+  }
+  return &samples_[(next_sample_ + kMaxSamples - 1) % kMaxSamples];
+}
+
+}  // namespace crashpad
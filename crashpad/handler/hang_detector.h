@@ -0,0 +1,102 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_HANG_DETECTOR_H_
+#define CRASHPAD_HANDLER_HANG_DETECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+
+namespace crashpad {
+
+//! \brief The process annotation set, to the number of seconds that the thread
+//!     had been hung, in reports written for hung threads.
+constexpr char kHangDurationAnnotation[] = "hang_duration_seconds";
+
+//! \brief Decides from periodic samples of a thread’s stack whether the thread
+//!     has hung.
+//!
+//! Each sample records the top frames of the thread’s stack. The thread is
+//! considered hung once consecutive samples have had the same top frames for
+//! at least a threshold. Each such run is reported once. A sample with
+//! different frames, or with none, ends the run.
+//!
+//! A thread that is idle, waiting for work, also has unchanging frames, so the
+//! threshold must be longer than the thread is expected to wait when it isn’t
+//! hung.
+//!
+//! The most recent samples are kept in a ring buffer of #kMaxSamples.
+class HangDetector {
+ public:
+  //! \brief The number of samples kept.
+  static constexpr size_t kMaxSamples = 64;
+
+  //! \brief The number of top frames compared between samples.
+  static constexpr size_t kFramesCompared = 8;
+
+  //! \brief A sample of a thread’s stack.
+  struct Sample {
+    Sample();
+    ~Sample();
+
+    //! \brief The time that the sample was taken, in nanoseconds, as from
+    //!     ClockMonotonicNanoseconds().
+    uint64_t time_ns;
+
+    //! \brief Return addresses found at the top of the stack, innermost first.
+    std::vector<uint64_t> frames;
+  };
+
+  //! \param[in] threshold_ns How long, in nanoseconds, the same frames must
+  //!     persist for the thread to be considered hung.
+  explicit HangDetector(uint64_t threshold_ns);
+  ~HangDetector();
+
+  //! \brief Records a sample.
+  //!
+  //! \param[in] sample The sample, which must not be older than the previous
+  //!     one.
+  //!
+  //! \return `true` if the thread is newly considered hung as of this sample,
+  //!     in which case a hang report should be written. `false` if it isn’t
+  //!     hung, or if the hang has already been reported.
+  bool AddSample(const Sample& sample);
+
+  //! \brief Returns how long the current frames have persisted, in
+  //!     nanoseconds, as of the latest sample.
+  uint64_t CurrentRunNanoseconds() const;
+
+  //! \brief Returns the samples kept, oldest first.
+  std::vector<const Sample*> Samples() const;
+
+ private:
+  //! \brief Returns the latest sample, or `nullptr` if there are none.
+  const Sample* Latest() const;
+
+  std::vector<Sample> samples_;
+  size_t next_sample_;
+  uint64_t threshold_ns_;
+  uint64_t run_start_ns_;
+  bool run_reported_;
+
+  DISALLOW_COPY_AND_ASSIGN(HangDetector);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_HANG_DETECTOR_H_
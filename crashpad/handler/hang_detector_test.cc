@@ -0,0 +1,103 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/hang_detector.h"
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr uint64_t kSecond = 1000000000;
+
+HangDetector::Sample MakeSample(uint64_t time_ns,
+                                std::vector<uint64_t> frames) {
+  HangDetector::Sample sample;
+  sample.time_ns = time_ns;
+  sample.frames = frames;
+  return sample;
+}
+
+TEST(HangDetector, ReportsPersistentFramesOnce) {
+  HangDetector detector(5 * kSecond);
+
+  for (uint64_t second = 0; second < 5; ++second) {
+    EXPECT_FALSE(detector.AddSample(MakeSample(second * kSecond, {1, 2, 3})));
+  }
+  EXPECT_EQ(detector.CurrentRunNanoseconds(), 4 * kSecond);
+
+  EXPECT_TRUE(detector.AddSample(MakeSample(5 * kSecond, {1, 2, 3})));
+  EXPECT_FALSE(detector.AddSample(MakeSample(6 * kSecond, {1, 2, 3})));
+  EXPECT_FALSE(detector.AddSample(MakeSample(60 * kSecond, {1, 2, 3})));
+}
+
+TEST(HangDetector, ChangedFramesEndRun) {
+  HangDetector detector(2 * kSecond);
+
+  EXPECT_FALSE(detector.AddSample(MakeSample(0, {1, 2})));
+  EXPECT_FALSE(detector.AddSample(MakeSample(1 * kSecond, {1, 2})));
+  EXPECT_FALSE(detector.AddSample(MakeSample(2 * kSecond, {4, 2})));
+  EXPECT_EQ(detector.CurrentRunNanoseconds(), 0u);
+  EXPECT_FALSE(detector.AddSample(MakeSample(3 * kSecond, {4, 2})));
+  EXPECT_TRUE(detector.AddSample(MakeSample(4 * kSecond, {4, 2})));
+
+  // Returning to frames that were seen before starts a new run, which is
+  // reported on its own.
+  EXPECT_FALSE(detector.AddSample(MakeSample(5 * kSecond, {1, 2})));
+  EXPECT_FALSE(detector.AddSample(MakeSample(6 * kSecond, {1, 2})));
+  EXPECT_TRUE(detector.AddSample(MakeSample(7 * kSecond, {1, 2})));
+}
+
+TEST(HangDetector, EmptySamplesNeverHang) {
+  HangDetector detector(1 * kSecond);
+
+  EXPECT_FALSE(detector.AddSample(MakeSample(0, {1})));
+  EXPECT_FALSE(detector.AddSample(MakeSample(1 * kSecond, {})));
+  EXPECT_FALSE(detector.AddSample(MakeSample(2 * kSecond, {})));
+  EXPECT_EQ(detector.CurrentRunNanoseconds(), 0u);
+  EXPECT_FALSE(detector.AddSample(MakeSample(3 * kSecond, {1})));
+  EXPECT_TRUE(detector.AddSample(MakeSample(4 * kSecond, {1})));
+}
+
+TEST(HangDetector, ComparesOnlyTopFrames) {
+  HangDetector detector(1 * kSecond);
+
+  std::vector<uint64_t> frames(HangDetector::kFramesCompared, 7);
+  frames.push_back(1);
+  EXPECT_FALSE(detector.AddSample(MakeSample(0, frames)));
+  frames.back() = 2;
+  EXPECT_TRUE(detector.AddSample(MakeSample(1 * kSecond, frames)));
+}
+
+TEST(HangDetector, RingBuffer) {
+  HangDetector detector(kSecond);
+
+  EXPECT_TRUE(detector.Samples().empty());
+
+  const uint64_t sample_count = HangDetector::kMaxSamples + 3;
+  for (uint64_t index = 0; index < sample_count; ++index) {
+    detector.AddSample(MakeSample(index, {index}));
+  }
+
+  std::vector<const HangDetector::Sample*> samples = detector.Samples();
+  ASSERT_EQ(samples.size(), HangDetector::kMaxSamples);
+  for (size_t index = 0; index < samples.size(); ++index) {
+    EXPECT_EQ(samples[index]->time_ns, index + 3);
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
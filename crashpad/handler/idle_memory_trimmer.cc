@@ -0,0 +1,110 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/idle_memory_trimmer.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "util/misc/clock.h"
+#include "util/misc/memory_reserve.h"
+#include "util/misc/memory_trim.h"
+
+namespace crashpad {
+
+namespace {
+
+constexpr uint64_t kNanosecondsPerSecond = 1E9;
+
+}  // namespace
+
+IdleMemoryTrimmer::Activity::Activity(IdleMemoryTrimmer* trimmer)
+    : trimmer_(trimmer) {
+  if (trimmer_) {
+    ++trimmer_->active_count_;
+  }
+}
+
+IdleMemoryTrimmer::Activity::~Activity() {
+  if (trimmer_) {
+    // A clock value of 0 would be taken to mean that there’s nothing to trim.
+    trimmer_->idle_since_ns_ = std::max(ClockMonotonicNanoseconds(),
+                                        static_cast<uint64_t>(1));
+    --trimmer_->active_count_;
+    if (trimmer_->thread_.is_running()) {
+      trimmer_->thread_.DoWorkNow();
+    }
+  }
+}
+
+IdleMemoryTrimmer::IdleMemoryTrimmer(double idle_seconds,
+                                     WorkerThreadExecutor* executor)
+    : thread_(WorkerThread::kIndefiniteWait, this, executor),
+      memory_reserve_(nullptr),
+      idle_seconds_(idle_seconds),
+      active_count_(0),
+      idle_since_ns_(0),
+      trim_count_(0) {}
+
+IdleMemoryTrimmer::~IdleMemoryTrimmer() {}
+
+void IdleMemoryTrimmer::SetMemoryReserve(MemoryReserve* memory_reserve) {
+  DCHECK(!thread_.is_running());
+  memory_reserve_ = memory_reserve;
+}
+
+void IdleMemoryTrimmer::Start() {
+  thread_.Start(WorkerThread::kIndefiniteWait);
+}
+
+void IdleMemoryTrimmer::Stop() {
+  thread_.Stop();
+}
+
+void IdleMemoryTrimmer::DoWork(const WorkerThread* thread) {
+  uint64_t idle_since_ns = idle_since_ns_;
+  if (!idle_since_ns) {
+    return;
+  }
+
+  // The Activity in progress will ask for this to run again when it ends.
+  if (active_count_) {
+    return;
+  }
+
+  const uint64_t idle_ns = idle_seconds_ * kNanosecondsPerSecond;
+  const uint64_t now_ns = ClockMonotonicNanoseconds();
+  if (now_ns - idle_since_ns < idle_ns) {
+    thread_.SetNextWorkDelay(
+        static_cast<double>(idle_ns - (now_ns - idle_since_ns)) /
+        kNanosecondsPerSecond);
+    return;
+  }
+
+  // If another Activity has ended since, wait to be idle after it instead.
+  if (!idle_since_ns_.compare_exchange_strong(idle_since_ns, 0)) {
+    thread_.SetNextWorkDelay(idle_seconds_);
+    return;
+  }
+
+  // Trimming first returns what the work left behind to the system, where the
+  // reserve can take it back.
+  TrimMemory();
+  if (memory_reserve_) {
+    memory_reserve_->Replenish();
+  }
+  ++trim_count_;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,113 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_IDLE_MEMORY_TRIMMER_H_
+#define CRASHPAD_HANDLER_IDLE_MEMORY_TRIMMER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "base/macros.h"
+#include "util/thread/worker_thread.h"
+
+namespace crashpad {
+
+class MemoryReserve;
+class WorkerThreadExecutor;
+
+//! \brief Returns the handler’s freed memory to the system once it has been
+//!     idle for a while after writing a crash report.
+//!
+//! The handler stays resident for as long as the processes it serves, but
+//! its heap grows while a report is captured and written, for snapshot data,
+//! minidump writers, and the like. Each time an Activity ends, memory is
+//! trimmed with TrimMemory() once no other Activity has been in progress for
+//! the idle time given to the constructor. Nothing is done while the handler
+//! has been idle since the last trim, so an idle handler isn’t woken. A
+//! MemoryReserve that was drawn on during the work is replenished at the same
+//! time.
+class IdleMemoryTrimmer : public WorkerThread::Delegate {
+ public:
+  //! \brief Marks a span of work, such as writing a crash report, after which
+  //!     memory is trimmed once the handler is idle.
+  class Activity {
+   public:
+    //! \param[in] trimmer The trimmer to notify. Weak. This may be `nullptr`,
+    //!     in which case this object does nothing.
+    explicit Activity(IdleMemoryTrimmer* trimmer);
+    ~Activity();
+
+   private:
+    IdleMemoryTrimmer* trimmer_;  // weak
+
+    DISALLOW_COPY_AND_ASSIGN(Activity);
+  };
+
+  //! \brief Constructs a new object.
+  //!
+  //! \param[in] idle_seconds How long the handler must be idle, after an
+  //!     Activity, before memory is trimmed.
+  //! \param[in] executor The executor to trim memory on, which is shared with
+  //!     other background tasks. Weak. `nullptr` to trim it on a thread of its
+  //!     own.
+  IdleMemoryTrimmer(double idle_seconds, WorkerThreadExecutor* executor);
+  ~IdleMemoryTrimmer();
+
+  //! \brief Replenishes \a memory_reserve whenever memory is trimmed.
+  //!
+  //! This method may only be called before Start().
+  //!
+  //! \param[in] memory_reserve The reserve to replenish. Weak. `nullptr`, the
+  //!     default, to replenish none.
+  void SetMemoryReserve(MemoryReserve* memory_reserve);
+
+  //! \brief Starts watching for idle time.
+  //!
+  //! This method may only be be called on a newly-constructed object or after
+  //! a call to Stop().
+  void Start();
+
+  //! \brief Stops watching for idle time.
+  //!
+  //! This method must only be called after Start(). If Start() has been called,
+  //! this method must be called before destroying an object of this class.
+  void Stop();
+
+  //! \return The number of times that memory has been trimmed.
+  uint64_t trim_count() const { return trim_count_; }
+
+ private:
+  // WorkerThread::Delegate:
+  void DoWork(const WorkerThread* thread) override;
+
+  WorkerThread thread_;
+  MemoryReserve* memory_reserve_;  // weak
+  double idle_seconds_;
+
+  // The number of Activity objects alive.
+  std::atomic<int> active_count_;
+
+  // The time that the last Activity ended, from ClockMonotonicNanoseconds(),
+  // or 0 if memory has been trimmed since.
+  std::atomic<uint64_t> idle_since_ns_;
+
+  std::atomic<uint64_t> trim_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(IdleMemoryTrimmer);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_IDLE_MEMORY_TRIMMER_H_
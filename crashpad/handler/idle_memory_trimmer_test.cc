@@ -0,0 +1,72 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/idle_memory_trimmer.h"
+
+#include "gtest/gtest.h"
+#include "util/misc/clock.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr double kIdleSeconds = 0.1;
+constexpr uint64_t kWaitNanoseconds = 500E6;
+
+TEST(IdleMemoryTrimmer, NoActivity) {
+  IdleMemoryTrimmer trimmer(kIdleSeconds, nullptr);
+  trimmer.Start();
+  SleepNanoseconds(kWaitNanoseconds);
+  trimmer.Stop();
+
+  EXPECT_EQ(trimmer.trim_count(), 0u);
+}
+
+TEST(IdleMemoryTrimmer, TrimsOnceIdle) {
+  IdleMemoryTrimmer trimmer(kIdleSeconds, nullptr);
+  trimmer.Start();
+
+  {
+    IdleMemoryTrimmer::Activity activity(&trimmer);
+
+    // Nothing is trimmed while an Activity is in progress.
+    SleepNanoseconds(kWaitNanoseconds);
+    EXPECT_EQ(trimmer.trim_count(), 0u);
+  }
+
+  // Activities that end together result in a single trim.
+  { IdleMemoryTrimmer::Activity activity(&trimmer); }
+  { IdleMemoryTrimmer::Activity activity(&trimmer); }
+
+  SleepNanoseconds(kWaitNanoseconds);
+  EXPECT_EQ(trimmer.trim_count(), 1u);
+
+  // Staying idle doesn’t trim again.
+  SleepNanoseconds(kWaitNanoseconds);
+  EXPECT_EQ(trimmer.trim_count(), 1u);
+
+  { IdleMemoryTrimmer::Activity activity(&trimmer); }
+  SleepNanoseconds(kWaitNanoseconds);
+  EXPECT_EQ(trimmer.trim_count(), 2u);
+
+  trimmer.Stop();
+}
+
+TEST(IdleMemoryTrimmer, NullTrimmer) {
+  IdleMemoryTrimmer::Activity activity(nullptr);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,192 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/lazy_crash_report_database.h"
+
+namespace crashpad {
+
+LazyCrashReportDatabase::LazyCrashReportDatabase(const base::FilePath& path)
+    : CrashReportDatabase(),
+      path_(path),
+      lock_(),
+      database_(),
+      open_attempted_(false) {}
+
+LazyCrashReportDatabase::~LazyCrashReportDatabase() {}
+
+Settings* LazyCrashReportDatabase::GetSettings() {
+  CrashReportDatabase* database = Database();
+  return database ? database->GetSettings() : nullptr;
+}
+
+CrashReportDatabase::OperationStatus
+LazyCrashReportDatabase::PrepareNewCrashReport(NewReport** report) {
+  CrashReportDatabase* database = Database();
+  return database ? database->PrepareNewCrashReport(report) : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus
+LazyCrashReportDatabase::FinishedWritingCrashReport(NewReport* report,
+                                                    UUID* uuid) {
+  CrashReportDatabase* database = Database();
+  return database ? database->FinishedWritingCrashReport(report, uuid)
+                  : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus
+LazyCrashReportDatabase::ErrorWritingCrashReport(NewReport* report) {
+  CrashReportDatabase* database = Database();
+  return database ? database->ErrorWritingCrashReport(report) : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus LazyCrashReportDatabase::LookUpCrashReport(
+    const UUID& uuid,
+    Report* report) {
+  CrashReportDatabase* database = Database();
+  return database ? database->LookUpCrashReport(uuid, report) : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus LazyCrashReportDatabase::GetPendingReports(
+    std::vector<Report>* reports) {
+  CrashReportDatabase* database = Database();
+  return database ? database->GetPendingReports(reports) : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus
+LazyCrashReportDatabase::GetCompletedReports(std::vector<Report>* reports) {
+  CrashReportDatabase* database = Database();
+  return database ? database->GetCompletedReports(reports) : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus
+LazyCrashReportDatabase::GetReportForUploading(const UUID& uuid,
+                                               const Report** report) {
+  CrashReportDatabase* database = Database();
+  return database ? database->GetReportForUploading(uuid, report)
+                  : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus
+LazyCrashReportDatabase::RecordUploadAttempt(const Report* report,
+                                             bool successful,
+                                             const std::string& id) {
+  CrashReportDatabase* database = Database();
+  return database ? database->RecordUploadAttempt(report, successful, id)
+                  : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus LazyCrashReportDatabase::SkipReportUpload(
+    const UUID& uuid,
+    Metrics::CrashSkippedReason reason) {
+  CrashReportDatabase* database = Database();
+  return database ? database->SkipReportUpload(uuid, reason) : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus LazyCrashReportDatabase::DeleteReport(
+    const UUID& uuid) {
+  CrashReportDatabase* database = Database();
+  return database ? database->DeleteReport(uuid) : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus LazyCrashReportDatabase::RequestUpload(
+    const UUID& uuid) {
+  CrashReportDatabase* database = Database();
+  return database ? database->RequestUpload(uuid) : kDatabaseError;
+}
+
+bool LazyCrashReportDatabase::WatchPendingReports(
+    DirectoryChangeWatcher* watcher) {
+  CrashReportDatabase* database = Database();
+  return database && database->WatchPendingReports(watcher);
+}
+
+CrashReportDatabase::OperationStatus LazyCrashReportDatabase::ListReports(
+    const ReportFilter& filter,
+    ListReportsDelegate* delegate) {
+  CrashReportDatabase* database = Database();
+  return database ? database->ListReports(filter, delegate) : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus LazyCrashReportDatabase::DeleteReports(
+    const ReportFilter& filter,
+    size_t* deleted_count) {
+  CrashReportDatabase* database = Database();
+  return database ? database->DeleteReports(filter, deleted_count)
+                  : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus LazyCrashReportDatabase::RequestUploads(
+    const ReportFilter& filter,
+    size_t* requested_count) {
+  CrashReportDatabase* database = Database();
+  return database ? database->RequestUploads(filter, requested_count)
+                  : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus
+LazyCrashReportDatabase::LookUpUploadParameters(
+    const UUID& uuid,
+    std::map<std::string, std::string>* parameters) {
+  CrashReportDatabase* database = Database();
+  return database ? database->LookUpUploadParameters(uuid, parameters)
+                  : kDatabaseError;
+}
+
+CrashReportDatabase::OperationStatus LazyCrashReportDatabase::GetAttachments(
+    const UUID& uuid,
+    std::vector<base::FilePath>* attachments) {
+  CrashReportDatabase* database = Database();
+  return database ? database->GetAttachments(uuid, attachments)
+                  : kDatabaseError;
+}
+
+void LazyCrashReportDatabase::SetNewReportFileOptions(
+    const NewReportFileOptions& options) {
+  base::AutoLock lock(lock_);
+  CrashReportDatabase::SetNewReportFileOptions(options);
+  if (database_) {
+    database_->SetNewReportFileOptions(options);
+  }
+}
+
+void LazyCrashReportDatabase::ReplenishSpareReportFiles() {
+  CrashReportDatabase* database;
+  {
+    base::AutoLock lock(lock_);
+    database = database_.get();
+  }
+
+  // Once opened, the database is never replaced, so it can be used without
+  // holding the lock, which isn’t held while spare files are created.
+  if (database) {
+    database->ReplenishSpareReportFiles();
+  }
+}
+
+CrashReportDatabase* LazyCrashReportDatabase::Database() {
+  base::AutoLock lock(lock_);
+  if (!open_attempted_) {
+    open_attempted_ = true;
+
+    // Initialize() logs its own failure. Because it isn’t retried, that’s the
+    // only message logged, rather than one for every use.
+    database_ = CrashReportDatabase::Initialize(path_);
+    if (database_) {
+      database_->SetNewReportFileOptions(new_report_file_options());
+    }
+  }
+  return database_.get();
+}
+
+}  // namespace crashpad
@@ -0,0 +1,112 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_LAZY_CRASH_REPORT_DATABASE_H_
+#define CRASHPAD_HANDLER_LAZY_CRASH_REPORT_DATABASE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "client/crash_report_database.h"
+
+namespace crashpad {
+
+//! \brief A CrashReportDatabase that opens the database at a path the first
+//!     time it’s used.
+//!
+//! Opening a database can involve creating its directories and reading its
+//! settings and metadata. The handler uses this so that it can begin accepting
+//! clients without first paying that cost, deferring it until a crash report
+//! is written or a background thread first examines the database.
+//!
+//! Every method opens the database if it isn’t open yet, as
+//! CrashReportDatabase::Initialize() does, and then forwards to it. If the
+//! database can’t be opened, the failure is logged once, and every method
+//! fails: methods returning an OperationStatus return #kDatabaseError,
+//! GetSettings() returns `nullptr`, and WatchPendingReports() returns `false`.
+//!
+//! This class is thread-safe.
+class LazyCrashReportDatabase final : public CrashReportDatabase {
+ public:
+  //! \param[in] path The path to the database, as would be passed to
+  //!     CrashReportDatabase::Initialize().
+  explicit LazyCrashReportDatabase(const base::FilePath& path);
+  ~LazyCrashReportDatabase() override;
+
+  // CrashReportDatabase:
+  Settings* GetSettings() override;
+  OperationStatus PrepareNewCrashReport(NewReport** report) override;
+  OperationStatus FinishedWritingCrashReport(NewReport* report,
+                                             UUID* uuid) override;
+  OperationStatus ErrorWritingCrashReport(NewReport* report) override;
+  OperationStatus LookUpCrashReport(const UUID& uuid, Report* report) override;
+  OperationStatus GetPendingReports(std::vector<Report>* reports) override;
+  OperationStatus GetCompletedReports(std::vector<Report>* reports) override;
+  OperationStatus GetReportForUploading(const UUID& uuid,
+                                        const Report** report) override;
+  OperationStatus RecordUploadAttempt(const Report* report,
+                                      bool successful,
+                                      const std::string& id) override;
+  OperationStatus SkipReportUpload(
+      const UUID& uuid,
+      Metrics::CrashSkippedReason reason) override;
+  OperationStatus DeleteReport(const UUID& uuid) override;
+  OperationStatus RequestUpload(const UUID& uuid) override;
+  bool WatchPendingReports(DirectoryChangeWatcher* watcher) override;
+  OperationStatus ListReports(const ReportFilter& filter,
+                              ListReportsDelegate* delegate) override;
+  OperationStatus DeleteReports(const ReportFilter& filter,
+                                size_t* deleted_count) override;
+  OperationStatus RequestUploads(const ReportFilter& filter,
+                                 size_t* requested_count) override;
+  OperationStatus LookUpUploadParameters(
+      const UUID& uuid,
+      std::map<std::string, std::string>* parameters) override;
+  OperationStatus GetAttachments(
+      const UUID& uuid,
+      std::vector<base::FilePath>* attachments) override;
+
+  //! \copydoc CrashReportDatabase::SetNewReportFileOptions()
+  //!
+  //! This does not open the database. The options are applied to it once it
+  //! is opened.
+  void SetNewReportFileOptions(const NewReportFileOptions& options) override;
+
+  //! \copydoc CrashReportDatabase::ReplenishSpareReportFiles()
+  //!
+  //! This does nothing until the database has been opened.
+  void ReplenishSpareReportFiles() override;
+
+ private:
+  //! \brief Returns the opened database, opening it on the first call.
+  //!
+  //! \return The database, or `nullptr` if it couldn’t be opened.
+  CrashReportDatabase* Database();
+
+  const base::FilePath path_;
+  base::Lock lock_;
+  std::unique_ptr<CrashReportDatabase> database_;
+  bool open_attempted_;
+
+  DISALLOW_COPY_AND_ASSIGN(LazyCrashReportDatabase);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_LAZY_CRASH_REPORT_DATABASE_H_
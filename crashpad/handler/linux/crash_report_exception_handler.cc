@@ -0,0 +1,348 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/linux/crash_report_exception_handler.h"
+
+#include <set>
+#include <vector>
+
+#include "base/logging.h"
+#include "client/settings.h"
+#include "handler/capture_tier.h"
+#include "handler/duplicate_crash_filter.h"
+#include "handler/idle_memory_trimmer.h"
+#include "handler/upload_parameters.h"
+#include "minidump/minidump_capture_performance_writer.h"
+#include "minidump/minidump_file_writer.h"
+#include "snapshot/linux/process_snapshot_linux.h"
+#include "snapshot/top_frames.h"
+#include "util/file/file_writer.h"
+#include "util/linux/proc_stat_reader.h"
+#include "util/linux/seize_ptrace_connection.h"
+#include "util/misc/clock.h"
+#include "util/misc/metrics.h"
+#include "util/misc/uuid.h"
+#include "util/process/process_memory.h"
+#include "util/thread/thread_priority.h"
+
+namespace crashpad {
+
+namespace {
+
+// The number of module build IDs kept across crash reports.
+constexpr size_t kBuildIDCacheSize = 1024;
+
+// Returns true if |pid| is a child of |parent_pid|. A client may only ask for a
+// snapshot of a fork of itself, not of an arbitrary process that the handler
+// is able to trace.
+bool IsChildProcess(pid_t pid, pid_t parent_pid) {
+  ProcStatReader stat;
+  pid_t actual_parent_pid;
+  if (!stat.Initialize(pid) || !stat.ParentProcessID(&actual_parent_pid)) {
+    return false;
+  }
+  if (actual_parent_pid != parent_pid) {
+    LOG(ERROR) << "process " << pid << " is not a child of " << parent_pid;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+CrashReportExceptionHandler::CrashReportExceptionHandler(
+    CrashReportDatabase* database,
+    CrashReportUploadThread* upload_thread,
+    CrashReportCompressThread* compress_thread,
+    const std::map<std::string, std::string>* process_annotations,
+    const UserStreamDataSources* user_stream_data_sources,
+    const base::FilePath& build_id_cache_path,
+    CrashSignatureHistory* signature_history,
+    size_t top_frame_count,
+    IdleMemoryTrimmer* idle_memory_trimmer)
+    : database_(database),
+      upload_thread_(upload_thread),
+      compress_thread_(compress_thread),
+      process_annotations_(process_annotations),
+      user_stream_data_sources_(user_stream_data_sources),
+      signature_history_(signature_history),
+      top_frame_count_(top_frame_count),
+      idle_memory_trimmer_(idle_memory_trimmer),
+      capture_tier_selector_(nullptr),
+      attachments_(),
+      memory_info_list_options_(),
+      exception_thread_float_context_only_(false),
+      build_id_cache_(kBuildIDCacheSize),
+      build_id_cache_path_(build_id_cache_path),
+      system_snapshot_cache_() {
+  // A cache that can’t be loaded only costs the time to read build IDs again.
+  if (!build_id_cache_path_.empty()) {
+    build_id_cache_.Load(build_id_cache_path_);
+  }
+}
+
+CrashReportExceptionHandler::~CrashReportExceptionHandler() {}
+
+void CrashReportExceptionHandler::SetExceptionThreadFloatContextOnly(
+    bool only) {
+  exception_thread_float_context_only_ = only;
+}
+
+void CrashReportExceptionHandler::SetMemoryInfoListOptions(
+    const MinidumpMemoryInfoListOptions& options) {
+  memory_info_list_options_ = options;
+}
+
+void CrashReportExceptionHandler::SetCaptureTierSelector(
+    CaptureTierSelector* capture_tier_selector) {
+  capture_tier_selector_ = capture_tier_selector;
+}
+
+void CrashReportExceptionHandler::SetAttachments(
+    const std::vector<base::FilePath>& attachments) {
+  attachments_ = attachments;
+}
+
+bool CrashReportExceptionHandler::HandleException(
+    pid_t client_process_id,
+    const ClientInformation& client_info) {
+  Metrics::ExceptionEncountered();
+
+  // Under the heaviest load, the crash is only counted, before the client is
+  // even attached to.
+  const CaptureTier tier =
+      capture_tier_selector_
+          ? capture_tier_selector_->SelectTier(ClockMonotonicNanoseconds())
+          : CaptureTier::kFull;
+  if (tier == CaptureTier::kCounterOnly) {
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kCounterOnly);
+    return true;
+  }
+
+  // The client waits while its crash is captured and written, and shouldn’t be
+  // kept waiting by other work on the system.
+  ScopedRaisedThreadPriority raise_priority;
+
+  // Memory allocated to capture and write the report is returned to the system
+  // once the handler has been idle for a while afterwards.
+  IdleMemoryTrimmer::Activity trim_when_idle(idle_memory_trimmer_);
+
+  // This is declared before the connection so that it is reported after the
+  // connection, and with it, the client’s suspension, ends.
+  Metrics::ScopedCapturePhaseTimer suspended_timer(
+      Metrics::CapturePhase::kTargetSuspended);
+
+  // A client that forked a copy-on-write child to be read in its place keeps
+  // running while the child is snapshotted.
+  const bool forked = client_info.snapshot_process_id != 0;
+  const pid_t snapshot_process_id =
+      forked ? client_info.snapshot_process_id : client_process_id;
+  if (forked && !IsChildProcess(snapshot_process_id, client_process_id)) {
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSnapshotFailed);
+    return false;
+  }
+
+  // Attaching stops every thread in the process for as long as the connection
+  // lives, so the snapshot is consistent. Seizing stops all of the threads at
+  // nearly the same time.
+  Metrics::ScopedCapturePhaseTimer suspend_timer(
+      Metrics::CapturePhase::kSuspend);
+  SeizePtraceConnection connection;
+  if (!connection.Initialize(snapshot_process_id)) {
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSnapshotFailed);
+    return false;
+  }
+  MinidumpCapturePhaseTimes phase_times;
+  phase_times.suspend_time = suspend_timer.Stop();
+
+  Metrics::ScopedCapturePhaseTimer snapshot_timer(
+      Metrics::CapturePhase::kSnapshot);
+
+  // The exception information names the exception thread, which may be the
+  // only one whose floating-point context is captured.
+  ProcessMemory memory;
+  ExceptionInformation exception_information;
+  if (!memory.Initialize(snapshot_process_id) ||
+      !memory.Read(client_info.exception_information_address,
+                   sizeof(exception_information),
+                   &exception_information)) {
+    Metrics::ExceptionCaptureResult(
+        Metrics::CaptureResult::kExceptionInitializationFailed);
+    return false;
+  }
+
+  ProcessSnapshotLinux process_snapshot;
+  process_snapshot.SetBuildIDCache(&build_id_cache_);
+  process_snapshot.SetSystemSnapshotCache(&system_snapshot_cache_);
+  if (forked) {
+    process_snapshot.SetForkedProcess(client_process_id,
+                                      client_info.thread_contexts_address,
+                                      client_info.thread_context_count);
+  }
+  if (exception_thread_float_context_only_) {
+    process_snapshot.SetFloatContextThreads(
+        std::set<pid_t>{exception_information.thread_id});
+  }
+  if (!process_snapshot.Initialize(&connection)) {
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSnapshotFailed);
+    return false;
+  }
+  phase_times.snapshot_time = snapshot_timer.Stop();
+
+  if (!process_snapshot.InitializeException(
+          exception_information.siginfo_address,
+          exception_information.context_address,
+          exception_information.thread_id)) {
+    Metrics::ExceptionCaptureResult(
+        Metrics::CaptureResult::kExceptionInitializationFailed);
+    return false;
+  }
+
+  UUID client_id;
+  Settings* const settings = database_->GetSettings();
+  if (settings) {
+    // If GetSettings() or GetClientID() fails, something else will log a
+    // message and client_id will be left at its default value, all zeroes,
+    // which is appropriate.
+    settings->GetClientID(&client_id);
+  }
+
+  process_snapshot.SetClientID(client_id);
+
+  std::map<std::string, std::string> annotations(*process_annotations_);
+  if (!ShouldReportCrash(signature_history_, &process_snapshot, &annotations)) {
+    Metrics::ExceptionCaptureResult(
+        Metrics::CaptureResult::kDuplicateSuppressed);
+    return true;
+  }
+
+  // Frames that can’t be found don’t prevent a report, which is only the less
+  // useful for sorting without them.
+  std::vector<TopFrame> top_frames;
+  if (top_frame_count_ > 0 &&
+      process_snapshot.ComputeTopFrames(top_frame_count_, &top_frames)) {
+    annotations[kTopFramesAnnotation] =
+        FormatTopFrames(process_snapshot.Modules(), top_frames);
+  }
+  if (capture_tier_selector_) {
+    annotations[kCaptureTierAnnotation] = CaptureTierName(tier);
+  }
+  process_snapshot.SetAnnotationsSimpleMap(annotations);
+
+  if (upload_thread_ && upload_thread_->CanUploadDirectly()) {
+    // The report is uploaded as its minidump is written, and is never added
+    // to the database.
+    UUID report_id;
+    if (!report_id.InitializeWithNew()) {
+      Metrics::ExceptionCaptureResult(
+          Metrics::CaptureResult::kPrepareNewCrashReportFailed);
+      return false;
+    }
+
+    process_snapshot.SetReportID(report_id);
+
+    MinidumpFileWriter minidump;
+    ApplyCaptureTier(tier, &minidump);
+    minidump.SetMemoryInfoListOptions(memory_info_list_options_);
+    minidump.SetCapturePhaseTimes(phase_times);
+    minidump.SetTopFrames(top_frames);
+    minidump.InitializeFromSnapshot(&process_snapshot);
+    AddUserExtensionStreams(
+        user_stream_data_sources_, &process_snapshot, &minidump);
+
+    if (!upload_thread_->UploadMinidumpDirectly(
+            &process_snapshot, &minidump, attachments_)) {
+      Metrics::ExceptionCaptureResult(
+          Metrics::CaptureResult::kDirectUploadFailed);
+      return false;
+    }
+  } else {
+    CrashReportDatabase::NewReport* new_report;
+    CrashReportDatabase::OperationStatus database_status =
+        database_->PrepareNewCrashReport(&new_report);
+    if (database_status != CrashReportDatabase::kNoError) {
+      Metrics::ExceptionCaptureResult(
+          Metrics::CaptureResult::kPrepareNewCrashReportFailed);
+      return false;
+    }
+
+    process_snapshot.SetReportID(new_report->uuid);
+
+    CrashReportDatabase::CallErrorWritingCrashReport
+        call_error_writing_crash_report(database_, new_report);
+
+    WeakFileHandleFileWriter file_writer(new_report->handle);
+
+    // Tracing ties the capture’s phases, on this thread, to the report.
+    Metrics::ScopedCapturePhaseTimer write_timer(
+        Metrics::CapturePhase::kMinidumpWrite);
+    write_timer.SetReportID(new_report->uuid);
+    MinidumpFileWriter minidump;
+    ApplyCaptureTier(tier, &minidump);
+    minidump.SetMemoryInfoListOptions(memory_info_list_options_);
+    minidump.SetCapturePhaseTimes(phase_times);
+    minidump.SetTopFrames(top_frames);
+    minidump.InitializeFromSnapshot(&process_snapshot);
+    AddUserExtensionStreams(
+        user_stream_data_sources_, &process_snapshot, &minidump);
+
+    // The parameters that the report will be uploaded with are recorded now,
+    // from the same snapshot as the minidump, so that the minidump needn’t be
+    // interpreted to upload it.
+    new_report->upload_parameters =
+        BreakpadHTTPFormParametersFromSnapshot(&process_snapshot);
+    new_report->attachments = attachments_;
+
+    if (!minidump.WriteEverything(&file_writer)) {
+      Metrics::ExceptionCaptureResult(
+          Metrics::CaptureResult::kMinidumpWriteFailed);
+      return false;
+    }
+    write_timer.Stop();
+
+    call_error_writing_crash_report.Disarm();
+
+    Metrics::ScopedCapturePhaseTimer finalize_timer(
+        Metrics::CapturePhase::kDatabaseFinalize);
+    if (compress_thread_) {
+      // The report is made pending once it has been compressed.
+      compress_thread_->FinishReport(new_report);
+    } else {
+      UUID uuid;
+      database_status =
+          database_->FinishedWritingCrashReport(new_report, &uuid);
+      if (database_status != CrashReportDatabase::kNoError) {
+        Metrics::ExceptionCaptureResult(
+            Metrics::CaptureResult::kFinishedWritingCrashReportFailed);
+        return false;
+      }
+
+      if (upload_thread_) {
+        upload_thread_->ReportPending(uuid);
+      }
+    }
+    finalize_timer.Stop();
+  }
+
+  // Only save the build ID cache once the report is complete, so that it never
+  // delays one.
+  if (!build_id_cache_path_.empty()) {
+    build_id_cache_.Save(build_id_cache_path_);
+  }
+
+  Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSuccess);
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,189 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_LINUX_CRASH_REPORT_EXCEPTION_HANDLER_H_
+#define CRASHPAD_HANDLER_LINUX_CRASH_REPORT_EXCEPTION_HANDLER_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "client/crash_report_database.h"
+#include "handler/crash_report_compress_thread.h"
+#include "handler/crash_report_upload_thread.h"
+#include "handler/linux/exception_handler_server.h"
+#include "handler/user_stream_data_source.h"
+#include "minidump/minidump_memory_info_writer.h"
+#include "snapshot/linux/build_id_cache.h"
+#include "snapshot/system_snapshot_cache.h"
+#include "util/linux/exception_handler_protocol.h"
+
+namespace crashpad {
+
+class CaptureTierSelector;
+class CrashSignatureHistory;
+class IdleMemoryTrimmer;
+
+//! \brief The process annotation that carries the top frames of the exception
+//!     thread’s stack, as formatted by FormatTopFrames(), when
+//!     CrashReportExceptionHandler computes them.
+constexpr char kTopFramesAnnotation[] = "top_frames";
+
+//! \brief An exception handler that writes crash reports for crash dump
+//!     requests to a CrashReportDatabase.
+class CrashReportExceptionHandler : public ExceptionHandlerServer::Delegate {
+ public:
+  //! \brief Creates a new object that will store crash reports in \a database.
+  //!
+  //! \param[in] database The database to store crash reports in. Weak.
+  //! \param[in] upload_thread The upload thread to notify when a new crash
+  //!     report is written into \a database. If the upload thread permits it,
+  //!     new crash reports are instead uploaded through it directly, without
+  //!     being written into \a database. Weak. `nullptr` to leave crash reports
+  //!     pending in \a database for another handler to upload.
+  //! \param[in] compress_thread The thread to hand each crash report written
+  //!     into \a database to, so that it is compressed before it is made
+  //!     pending and \a upload_thread is notified. Weak. `nullptr` to make
+  //!     crash reports pending as soon as they are written.
+  //! \param[in] process_annotations A map of annotations to insert as
+  //!     process-level annotations into each crash report that is written. Do
+  //!     not confuse this with module-level annotations, which are under the
+  //!     control of the crashing process, and are used to implement Chrome’s
+  //!     “crash keys.” Process-level annotations are those that are beyond the
+  //!     control of the crashing process, which must reliably be set even if
+  //!     the process crashes before it’s able to establish its own annotations.
+  //!     To interoperate with Breakpad servers, the recommended practice is to
+  //!     specify values for the `"prod"` and `"ver"` keys as process
+  //!     annotations.
+  //! \param[in] user_stream_data_sources Data sources to be used to extend
+  //!     crash reports. For each crash report that is written, the data sources
+  //!     are called in turn. These data sources may contribute additional
+  //!     minidump streams. `nullptr` if not required.
+  //! \param[in] build_id_cache_path The path of a file in which module build
+  //!     IDs are kept between runs of the handler, so that the build IDs of
+  //!     binaries seen by an earlier handler aren’t read again. If empty, build
+  //!     IDs are only kept for the lifetime of this object.
+  //! \param[in] signature_history The history of crash signatures used to
+  //!     collapse repeated crashes into a single report. Weak. `nullptr` to
+  //!     report every crash.
+  //! \param[in] top_frame_count The number of frames of the exception thread’s
+  //!     stack to unwind and identify by module and dynamic symbol when a
+  //!     crash report is written, so that crashes can be sorted before they
+  //!     are symbolized. The frames are carried in a
+  //!     kMinidumpStreamTypeCrashpadTopFrames stream, and in the
+  //!     #kTopFramesAnnotation process annotation, which is also uploaded with
+  //!     the report. `0` to do neither.
+  //! \param[in] idle_memory_trimmer The trimmer to notify when a crash report
+  //!     has been written, so that memory is returned to the system once the
+  //!     handler is idle. Weak. `nullptr` to never trim memory.
+  CrashReportExceptionHandler(
+      CrashReportDatabase* database,
+      CrashReportUploadThread* upload_thread,
+      CrashReportCompressThread* compress_thread,
+      const std::map<std::string, std::string>* process_annotations,
+      const UserStreamDataSources* user_stream_data_sources,
+      const base::FilePath& build_id_cache_path,
+      CrashSignatureHistory* signature_history,
+      size_t top_frame_count,
+      IdleMemoryTrimmer* idle_memory_trimmer);
+
+  ~CrashReportExceptionHandler();
+
+  //! \brief Limits the floating-point context captured to that of the thread
+  //!     that raised the exception.
+  //!
+  //! Retrieving each thread’s floating-point and vector registers costs an
+  //! additional `ptrace` request, which dominates capture time in processes
+  //! with thousands of threads. When \a only is `true`, the other threads’
+  //! floating-point contexts are left zeroed, other than the main thread’s.
+  //! The exception’s own context always carries the floating-point state at
+  //! the time of the exception. See ProcessReader::SetFloatContextThreads().
+  //!
+  //! \param[in] only Whether to capture only the exception thread’s
+  //!     floating-point context. The default is `false`.
+  void SetExceptionThreadFloatContextOnly(bool only);
+
+  //! \brief Sets the options for the memory info list stream.
+  //!
+  //! The stream describes each mapping in the client’s memory map, as it was
+  //! parsed to read the client, so that a crash report can describe the
+  //! client’s address space without carrying the text of `/proc/pid/maps`.
+  //! A process with many mappings can be described more compactly by merging
+  //! adjacent regions, or by keeping only those near captured memory.
+  //!
+  //! \param[in] options The options to write the stream with. The default
+  //!     records one entry for every mapping.
+  void SetMemoryInfoListOptions(const MinidumpMemoryInfoListOptions& options);
+
+  //! \brief Degrades crash reports according to the load on the system.
+  //!
+  //! Each crash is counted by \a capture_tier_selector, which picks the
+  //! CaptureTier that its report is written at, recorded in the
+  //! #kCaptureTierAnnotation process annotation. Under the heaviest load, no
+  //! report is written at all.
+  //!
+  //! \param[in] capture_tier_selector The selector to consult. Weak. `nullptr`,
+  //!     the default, to always write reports at CaptureTier::kFull.
+  void SetCaptureTierSelector(CaptureTierSelector* capture_tier_selector);
+
+  //! \brief Sets the files to attach to each crash report.
+  //!
+  //! The files are cloned into the database as each report is written, as
+  //! for CrashReportDatabase::NewReport::attachments, and uploaded from there,
+  //! or are read from where they are if the report is uploaded directly.
+  //!
+  //! \param[in] attachments The paths of the files. The default is none.
+  void SetAttachments(const std::vector<base::FilePath>& attachments);
+
+  // ExceptionHandlerServer::Delegate:
+
+  //! \brief Processes a crash dump request by writing a crash report to this
+  //!     object’s CrashReportDatabase.
+  bool HandleException(pid_t client_process_id,
+                       const ClientInformation& client_info) override;
+
+ private:
+  CrashReportDatabase* database_;  // weak
+  CrashReportUploadThread* upload_thread_;  // weak
+  CrashReportCompressThread* compress_thread_;  // weak
+  const std::map<std::string, std::string>* process_annotations_;  // weak
+  const UserStreamDataSources* user_stream_data_sources_;  // weak
+  CrashSignatureHistory* signature_history_;  // weak
+  size_t top_frame_count_;
+  IdleMemoryTrimmer* idle_memory_trimmer_;  // weak
+  CaptureTierSelector* capture_tier_selector_;  // weak
+  std::vector<base::FilePath> attachments_;
+  MinidumpMemoryInfoListOptions memory_info_list_options_;
+  bool exception_thread_float_context_only_;
+
+  // Shared by every crash report, so that the build IDs of binaries seen in an
+  // earlier report aren’t read again.
+  BuildIDCache build_id_cache_;
+  base::FilePath build_id_cache_path_;
+
+  // Shared by every crash report, so that system facts that don’t change
+  // aren’t determined again.
+  SystemSnapshotCache system_snapshot_cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(CrashReportExceptionHandler);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_LINUX_CRASH_REPORT_EXCEPTION_HANDLER_H_
@@ -0,0 +1,255 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/linux/exception_handler_server.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace crashpad {
+
+ExceptionHandlerServer::ExceptionHandlerServer()
+    : clients_(),
+      shutdown_event_(),
+      pollfd_(),
+      delegate_(nullptr),
+      keep_running_(true),
+      initialized_() {}
+
+ExceptionHandlerServer::~ExceptionHandlerServer() {}
+
+bool ExceptionHandlerServer::InitializeWithClient(ScopedFileHandle sock) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  pollfd_.reset(epoll_create1(EPOLL_CLOEXEC));
+  if (!pollfd_.is_valid()) {
+    PLOG(ERROR) << "epoll_create1";
+    return false;
+  }
+
+  shutdown_event_.reset(new Event());
+  shutdown_event_->type = Event::Type::kShutdown;
+  shutdown_event_->fd.reset(eventfd(0, EFD_CLOEXEC));
+  if (!shutdown_event_->fd.is_valid()) {
+    PLOG(ERROR) << "eventfd";
+    return false;
+  }
+
+  epoll_event poll_event;
+  poll_event.events = EPOLLIN;
+  poll_event.data.ptr = shutdown_event_.get();
+  if (epoll_ctl(pollfd_.get(),
+                EPOLL_CTL_ADD,
+                shutdown_event_->fd.get(),
+                &poll_event) != 0) {
+    PLOG(ERROR) << "epoll_ctl";
+    return false;
+  }
+
+  if (!InstallClientSocket(std::move(sock))) {
+    return false;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+void ExceptionHandlerServer::Run(Delegate* delegate) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  delegate_ = delegate;
+
+  while (keep_running_ && !clients_.empty()) {
+    epoll_event poll_event;
+    int res = HANDLE_EINTR(epoll_wait(pollfd_.get(), &poll_event, 1, -1));
+    PCHECK(res == 1) << "epoll_wait";
+    HandleEvent(static_cast<Event*>(poll_event.data.ptr), poll_event.events);
+  }
+
+  delegate_ = nullptr;
+}
+
+void ExceptionHandlerServer::Stop() {
+  // This only uses write(), which is async-signal-safe.
+  if (shutdown_event_ && shutdown_event_->fd.is_valid()) {
+    const uint64_t value = 1;
+    ssize_t res = HANDLE_EINTR(
+        write(shutdown_event_->fd.get(), &value, sizeof(value)));
+    ALLOW_UNUSED_LOCAL(res);
+  }
+}
+
+void ExceptionHandlerServer::HandleEvent(Event* event, uint32_t event_type) {
+  if (event->type == Event::Type::kShutdown) {
+    keep_running_ = false;
+    return;
+  }
+
+  DCHECK_EQ(event->type, Event::Type::kClientMessage);
+
+  // Messages that are already queued are processed before a hangup, so that a
+  // client that closes its socket right after a request is still handled.
+  if (event_type & EPOLLIN) {
+    if (ReceiveClientMessage(event)) {
+      return;
+    }
+  } else if (!(event_type & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))) {
+    LOG(ERROR) << "unexpected event 0x" << std::hex << event_type << std::dec;
+    return;
+  }
+
+  UninstallClientSocket(event);
+}
+
+bool ExceptionHandlerServer::InstallClientSocket(ScopedFileHandle socket) {
+  // Credentials are sent explicitly by ExceptionHandlerClient, but are only
+  // delivered when SO_PASSCRED is set on the receiving end.
+  int optval = 1;
+  if (setsockopt(socket.get(),
+                 SOL_SOCKET,
+                 SO_PASSCRED,
+                 &optval,
+                 sizeof(optval)) != 0) {
+    PLOG(ERROR) << "setsockopt";
+    return false;
+  }
+
+  std::unique_ptr<Event> event(new Event());
+  event->type = Event::Type::kClientMessage;
+  event->fd = std::move(socket);
+
+  epoll_event poll_event;
+  poll_event.events = EPOLLIN | EPOLLRDHUP;
+  poll_event.data.ptr = event.get();
+  if (epoll_ctl(pollfd_.get(), EPOLL_CTL_ADD, event->fd.get(), &poll_event) !=
+      0) {
+    PLOG(ERROR) << "epoll_ctl";
+    return false;
+  }
+
+  const int fd = event->fd.get();
+  clients_[fd] = std::move(event);
+  return true;
+}
+
+void ExceptionHandlerServer::UninstallClientSocket(Event* event) {
+  if (epoll_ctl(pollfd_.get(), EPOLL_CTL_DEL, event->fd.get(), nullptr) != 0) {
+    PLOG(ERROR) << "epoll_ctl";
+  }
+
+  // Erasing the entry closes the socket.
+  clients_.erase(event->fd.get());
+}
+
+bool ExceptionHandlerServer::ReceiveClientMessage(Event* event) {
+  ClientToServerMessage message;
+  iovec iov;
+  iov.iov_base = &message;
+  iov.iov_len = sizeof(message);
+
+  // Room is left for more descriptors than a valid message carries so that
+  // any extras are received, and closed, rather than causing MSG_CTRUNC.
+  char cmsg_buf[CMSG_SPACE(sizeof(ucred)) + CMSG_SPACE(sizeof(int) * 4)];
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsg_buf;
+  msg.msg_controllen = sizeof(cmsg_buf);
+
+  ssize_t res =
+      HANDLE_EINTR(recvmsg(event->fd.get(), &msg, MSG_CMSG_CLOEXEC));
+  if (res < 0) {
+    PLOG(ERROR) << "recvmsg";
+    return false;
+  }
+  if (res == 0) {
+    // The peer closed its end of the socket.
+    return false;
+  }
+
+  std::vector<ScopedFileHandle> fds;
+  const ucred* creds = nullptr;
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET) {
+      continue;
+    }
+    if (cmsg->cmsg_type == SCM_RIGHTS) {
+      const size_t fd_count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (size_t index = 0; index < fd_count; ++index) {
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg) + index * sizeof(int), sizeof(fd));
+        fds.push_back(ScopedFileHandle(fd));
+      }
+    } else if (cmsg->cmsg_type == SCM_CREDENTIALS &&
+               cmsg->cmsg_len == CMSG_LEN(sizeof(ucred))) {
+      creds = reinterpret_cast<const ucred*>(CMSG_DATA(cmsg));
+    }
+  }
+
+  if (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+    LOG(ERROR) << "truncated message";
+    return true;
+  }
+
+  if (res != sizeof(message)) {
+    LOG(ERROR) << "unexpected message size " << res;
+    return true;
+  }
+
+  if (!creds) {
+    LOG(ERROR) << "missing credentials";
+    return true;
+  }
+
+  switch (message.type) {
+    case ClientToServerMessage::kAddClient:
+      if (fds.size() != 1) {
+        LOG(ERROR) << "expected 1 socket, received " << fds.size();
+        return true;
+      }
+      InstallClientSocket(std::move(fds[0]));
+      return true;
+
+    case ClientToServerMessage::kCrashDumpRequest: {
+      ServerToClientMessage reply;
+      reply.type =
+          delegate_->HandleException(creds->pid, message.client_info)
+              ? ServerToClientMessage::kCrashDumpComplete
+              : ServerToClientMessage::kCrashDumpFailed;
+      if (HANDLE_EINTR(send(event->fd.get(),
+                            &reply,
+                            sizeof(reply),
+                            MSG_NOSIGNAL)) < 0) {
+        PLOG(ERROR) << "send";
+      }
+      return true;
+    }
+  }
+
+  LOG(ERROR) << "unknown message type " << message.type;
+  return true;
+}
+
+}  // namespace crashpad
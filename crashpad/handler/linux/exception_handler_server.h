@@ -0,0 +1,129 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_LINUX_EXCEPTION_HANDLER_SERVER_H_
+#define CRASHPAD_HANDLER_LINUX_EXCEPTION_HANDLER_SERVER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <map>
+#include <memory>
+
+#include "base/macros.h"
+#include "util/file/file_io.h"
+#include "util/linux/exception_handler_protocol.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+
+//! \brief Runs the main exception-handling server in Crashpad’s handler
+//!     process.
+//!
+//! Clients connect over `SOCK_SEQPACKET` sockets, whose other ends are given
+//! to the handler when it is started or are passed to it later by
+//! ClientToServerMessage::kAddClient. The handler is expected to be started
+//! ahead of any crash, so that its database, upload thread, and this server are
+//! fully initialized and the only work left to a crashing client is sending a
+//! single message.
+class ExceptionHandlerServer {
+ public:
+  //! \brief An interface for handling requests sent to an
+  //!     ExceptionHandlerServer.
+  class Delegate {
+   public:
+    //! \brief Called on receipt of a crash dump request from a client.
+    //!
+    //! \param[in] client_process_id The process ID of the client, as verified
+    //!     by the kernel through `SCM_CREDENTIALS` and expressed in the
+    //!     handler’s PID namespace.
+    //! \param[in] client_info Information about the client.
+    //!
+    //! \return `true` on success, `false` on failure with a message logged.
+    virtual bool HandleException(pid_t client_process_id,
+                                 const ClientInformation& client_info) = 0;
+
+   protected:
+    ~Delegate() {}
+  };
+
+  ExceptionHandlerServer();
+  ~ExceptionHandlerServer();
+
+  //! \brief Initializes this object.
+  //!
+  //! This method must be successfully called before Run().
+  //!
+  //! \param[in] sock A `SOCK_SEQPACKET` socket connected to the first client.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool InitializeWithClient(ScopedFileHandle sock);
+
+  //! \brief Runs the exception-handling server.
+  //!
+  //! This method continues running until it has no more clients, indicated by
+  //! every client socket having been closed by its peer, or until Stop() is
+  //! called.
+  //!
+  //! All crash dump requests will be passed to \a delegate.
+  //!
+  //! This method must only be called once on an ExceptionHandlerServer object.
+  //!
+  //! If an unexpected condition that prevents this method from functioning is
+  //! encountered, it will log a message and terminate execution. Receipt of an
+  //! invalid message will cause a message to be logged, but this method will
+  //! continue running normally.
+  //!
+  //! \param[in] delegate An object to send crash dump requests to.
+  void Run(Delegate* delegate);
+
+  //! \brief Stops a running exception-handling server.
+  //!
+  //! Stop() may be called from a signal handler.
+  //!
+  //! If Stop() is called before Run() it will cause Run() to return as soon as
+  //! it is called. It is harmless to call Stop() after Run() has already
+  //! returned, or to call Stop() after it has already been called.
+  void Stop();
+
+ private:
+  struct Event {
+    enum class Type { kShutdown, kClientMessage };
+
+    Type type;
+    ScopedFileHandle fd;
+  };
+
+  void HandleEvent(Event* event, uint32_t event_type);
+  bool InstallClientSocket(ScopedFileHandle socket);
+  void UninstallClientSocket(Event* event);
+
+  // Receives and handles a single message on |event|’s socket. Returns false
+  // if the socket should be uninstalled, because it was closed by its peer or
+  // because it can no longer be read.
+  bool ReceiveClientMessage(Event* event);
+
+  std::map<int, std::unique_ptr<Event>> clients_;
+  std::unique_ptr<Event> shutdown_event_;
+  ScopedFileHandle pollfd_;
+  Delegate* delegate_;  // weak
+  bool keep_running_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExceptionHandlerServer);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_LINUX_EXCEPTION_HANDLER_SERVER_H_
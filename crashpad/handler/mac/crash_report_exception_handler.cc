@@ -14,6 +14,8 @@
 
 #include "handler/mac/crash_report_exception_handler.h"
 
+#include <time.h>
+
 #include <vector>
 
 #include "base/logging.h"
@@ -21,7 +23,13 @@
 #include "base/mac/scoped_mach_port.h"
 #include "base/strings/stringprintf.h"
 #include "client/settings.h"
+#include "handler/capture_tier.h"
+#include "handler/client_dump_quota.h"
+#include "handler/duplicate_crash_filter.h"
+#include "handler/idle_memory_trimmer.h"
 #include "handler/mac/file_limit_annotation.h"
+#include "handler/upload_parameters.h"
+#include "minidump/minidump_capture_performance_writer.h"
 #include "minidump/minidump_file_writer.h"
 #include "minidump/minidump_user_extension_stream_data_source.h"
 #include "snapshot/crashpad_info_client_options.h"
@@ -34,25 +42,50 @@
 #include "util/mach/mach_message.h"
 #include "util/mach/scoped_task_suspend.h"
 #include "util/mach/symbolic_constants_mach.h"
+#include "util/misc/clock.h"
 #include "util/misc/metrics.h"
 #include "util/misc/tri_state.h"
 #include "util/misc/uuid.h"
+#include "util/thread/thread_priority.h"
 
 namespace crashpad {
 
 CrashReportExceptionHandler::CrashReportExceptionHandler(
     CrashReportDatabase* database,
     CrashReportUploadThread* upload_thread,
+    CrashReportCompressThread* compress_thread,
     const std::map<std::string, std::string>* process_annotations,
-    const UserStreamDataSources* user_stream_data_sources)
+    const UserStreamDataSources* user_stream_data_sources,
+    MinidumpStaticStreamCache* static_stream_cache,
+    CrashSignatureHistory* signature_history,
+    ClientDumpQuota* dump_quota,
+    IdleMemoryTrimmer* idle_memory_trimmer)
     : database_(database),
       upload_thread_(upload_thread),
+      compress_thread_(compress_thread),
       process_annotations_(process_annotations),
-      user_stream_data_sources_(user_stream_data_sources) {}
+      user_stream_data_sources_(user_stream_data_sources),
+      static_stream_cache_(static_stream_cache),
+      signature_history_(signature_history),
+      dump_quota_(dump_quota),
+      idle_memory_trimmer_(idle_memory_trimmer),
+      capture_tier_selector_(nullptr),
+      attachments_(),
+      system_snapshot_cache_() {}
 
 CrashReportExceptionHandler::~CrashReportExceptionHandler() {
 }
 
+void CrashReportExceptionHandler::SetCaptureTierSelector(
+    CaptureTierSelector* capture_tier_selector) {
+  capture_tier_selector_ = capture_tier_selector;
+}
+
+void CrashReportExceptionHandler::SetAttachments(
+    const std::vector<base::FilePath>& attachments) {
+  attachments_ = attachments;
+}
+
 kern_return_t CrashReportExceptionHandler::CatchMachException(
     exception_behavior_t behavior,
     exception_handler_t exception_port,
@@ -98,13 +131,62 @@ kern_return_t CrashReportExceptionHandler::CatchMachException(
     return KERN_FAILURE;
   }
 
+  // A client that keeps requesting dumps without crashing is refused once it
+  // has used its quota, before anything is read from it.
+  pid_t client_pid = -1;
+  if (exception == kMachExceptionSimulated && dump_quota_) {
+    kern_return_t kr = pid_for_task(task, &client_pid);
+    MACH_LOG_IF(WARNING, kr != KERN_SUCCESS, kr) << "pid_for_task";
+    if (kr == KERN_SUCCESS &&
+        !dump_quota_->TryAcquire(client_pid, time(nullptr))) {
+      ExcServerCopyState(
+          behavior, old_state, old_state_count, new_state, new_state_count);
+      Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kQuotaExceeded);
+      return ExcServerSuccessfulReturnValue(exception, behavior, false);
+    }
+  }
+
+  // Under the heaviest load, the exception is only counted, before the task is
+  // even suspended.
+  const CaptureTier tier =
+      capture_tier_selector_
+          ? capture_tier_selector_->SelectTier(ClockMonotonicNanoseconds())
+          : CaptureTier::kFull;
+  if (tier == CaptureTier::kCounterOnly) {
+    ExcServerCopyState(
+        behavior, old_state, old_state_count, new_state, new_state_count);
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kCounterOnly);
+    return ExcServerSuccessfulReturnValue(exception, behavior, false);
+  }
+
+  // The client waits while its crash is captured and written, and shouldn’t be
+  // kept waiting by other work on the system.
+  ScopedRaisedThreadPriority raise_priority;
+
+  // Memory allocated to capture and write the report is returned to the system
+  // once the handler has been idle for a while afterwards.
+  IdleMemoryTrimmer::Activity trim_when_idle(idle_memory_trimmer_);
+
+  // This is declared before |suspend| so that it is reported after the task is
+  // resumed.
+  Metrics::ScopedCapturePhaseTimer suspended_timer(
+      Metrics::CapturePhase::kTargetSuspended);
+
+  Metrics::ScopedCapturePhaseTimer suspend_timer(
+      Metrics::CapturePhase::kSuspend);
   ScopedTaskSuspend suspend(task);
+  MinidumpCapturePhaseTimes phase_times;
+  phase_times.suspend_time = suspend_timer.Stop();
 
+  Metrics::ScopedCapturePhaseTimer snapshot_timer(
+      Metrics::CapturePhase::kSnapshot);
   ProcessSnapshotMac process_snapshot;
+  process_snapshot.SetSystemSnapshotCache(&system_snapshot_cache_);
   if (!process_snapshot.Initialize(task)) {
     Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSnapshotFailed);
     return KERN_FAILURE;
   }
+  phase_times.snapshot_time = snapshot_timer.Stop();
 
   // Check for suspicious message sources. A suspicious exception message comes
   // from a source other than the kernel or the process that the exception
@@ -125,6 +207,7 @@ kern_return_t CrashReportExceptionHandler::CatchMachException(
   CrashpadInfoClientOptions client_options;
   process_snapshot.GetCrashpadOptions(&client_options);
 
+  bool duplicate = false;
   if (client_options.crashpad_handler_behavior != TriState::kDisabled &&
       !IsExceptionNonfatalResource(exception, code[0], pid)) {
     // Non-fatal resource exceptions are never user-visible and are not
@@ -153,46 +236,128 @@ kern_return_t CrashReportExceptionHandler::CatchMachException(
     }
 
     process_snapshot.SetClientID(client_id);
-    process_snapshot.SetAnnotationsSimpleMap(*process_annotations_);
 
-    CrashReportDatabase::NewReport* new_report;
-    CrashReportDatabase::OperationStatus database_status =
-        database_->PrepareNewCrashReport(&new_report);
-    if (database_status != CrashReportDatabase::kNoError) {
-      Metrics::ExceptionCaptureResult(
-          Metrics::CaptureResult::kPrepareNewCrashReportFailed);
-      return KERN_FAILURE;
+    std::map<std::string, std::string> annotations(*process_annotations_);
+    duplicate =
+        !ShouldReportCrash(signature_history_, &process_snapshot, &annotations);
+    if (capture_tier_selector_) {
+      annotations[kCaptureTierAnnotation] = CaptureTierName(tier);
     }
+    process_snapshot.SetAnnotationsSimpleMap(annotations);
 
-    process_snapshot.SetReportID(new_report->uuid);
+    if (duplicate) {
+      // The crash is counted in the history, and is reported along with the
+      // next crash like it that is reported. It is still forwarded to the
+      // system crash reporter below.
+    } else if (upload_thread_ && upload_thread_->CanUploadDirectly()) {
+      // The report is uploaded as its minidump is written, and is never added
+      // to the database.
+      UUID report_id;
+      if (!report_id.InitializeWithNew()) {
+        Metrics::ExceptionCaptureResult(
+            Metrics::CaptureResult::kPrepareNewCrashReportFailed);
+        return KERN_FAILURE;
+      }
 
-    CrashReportDatabase::CallErrorWritingCrashReport
-        call_error_writing_crash_report(database_, new_report);
+      process_snapshot.SetReportID(report_id);
 
-    WeakFileHandleFileWriter file_writer(new_report->handle);
+      MinidumpFileWriter minidump;
+      ApplyCaptureTier(tier, &minidump);
+      if (exception == kMachExceptionSimulated) {
+        minidump.SetStaticStreamCache(static_stream_cache_);
+      }
+      minidump.SetCapturePhaseTimes(phase_times);
+      minidump.InitializeFromSnapshot(&process_snapshot);
+      AddUserExtensionStreams(
+          user_stream_data_sources_, &process_snapshot, &minidump);
 
-    MinidumpFileWriter minidump;
-    minidump.InitializeFromSnapshot(&process_snapshot);
-    AddUserExtensionStreams(
-        user_stream_data_sources_, &process_snapshot, &minidump);
+      if (!upload_thread_->UploadMinidumpDirectly(
+              &process_snapshot, &minidump, attachments_)) {
+        Metrics::ExceptionCaptureResult(
+            Metrics::CaptureResult::kDirectUploadFailed);
+        return KERN_FAILURE;
+      }
 
-    if (!minidump.WriteEverything(&file_writer)) {
-      Metrics::ExceptionCaptureResult(
-          Metrics::CaptureResult::kMinidumpWriteFailed);
-      return KERN_FAILURE;
-    }
+      minidump.CommitStaticStreams();
+    } else {
+      CrashReportDatabase::NewReport* new_report;
+      CrashReportDatabase::OperationStatus database_status =
+          database_->PrepareNewCrashReport(&new_report);
+      if (database_status != CrashReportDatabase::kNoError) {
+        Metrics::ExceptionCaptureResult(
+            Metrics::CaptureResult::kPrepareNewCrashReportFailed);
+        return KERN_FAILURE;
+      }
 
-    call_error_writing_crash_report.Disarm();
+      process_snapshot.SetReportID(new_report->uuid);
+      new_report->dump_without_crash = exception == kMachExceptionSimulated;
 
-    UUID uuid;
-    database_status = database_->FinishedWritingCrashReport(new_report, &uuid);
-    if (database_status != CrashReportDatabase::kNoError) {
-      Metrics::ExceptionCaptureResult(
-          Metrics::CaptureResult::kFinishedWritingCrashReportFailed);
-      return KERN_FAILURE;
-    }
+      CrashReportDatabase::CallErrorWritingCrashReport
+          call_error_writing_crash_report(database_, new_report);
+
+      WeakFileHandleFileWriter file_writer(new_report->handle);
+
+      // Tracing ties the capture’s phases, on this thread, to the report.
+      Metrics::ScopedCapturePhaseTimer write_timer(
+          Metrics::CapturePhase::kMinidumpWrite);
+      write_timer.SetReportID(new_report->uuid);
+      MinidumpFileWriter minidump;
+      ApplyCaptureTier(tier, &minidump);
+      if (exception == kMachExceptionSimulated) {
+        minidump.SetStaticStreamCache(static_stream_cache_);
+      }
+      minidump.SetCapturePhaseTimes(phase_times);
+      minidump.InitializeFromSnapshot(&process_snapshot);
+      AddUserExtensionStreams(
+          user_stream_data_sources_, &process_snapshot, &minidump);
 
-    upload_thread_->ReportPending(uuid);
+      // The parameters that the report will be uploaded with are recorded now,
+      // from the same snapshot as the minidump, so that the minidump needn’t be
+      // interpreted to upload it.
+      new_report->upload_parameters =
+          BreakpadHTTPFormParametersFromSnapshot(&process_snapshot);
+      new_report->attachments = attachments_;
+
+      if (!minidump.WriteEverything(&file_writer)) {
+        Metrics::ExceptionCaptureResult(
+            Metrics::CaptureResult::kMinidumpWriteFailed);
+        return KERN_FAILURE;
+      }
+      write_timer.Stop();
+
+      call_error_writing_crash_report.Disarm();
+
+      if (dump_quota_ && client_pid != -1) {
+        // With the report written, the writer is positioned at its end.
+        FileOffset size = file_writer.Seek(0, SEEK_CUR);
+        if (size > 0) {
+          dump_quota_->RecordBytes(client_pid, size, time(nullptr));
+        }
+      }
+
+      Metrics::ScopedCapturePhaseTimer finalize_timer(
+          Metrics::CapturePhase::kDatabaseFinalize);
+      if (compress_thread_) {
+        // The report is made pending once it has been compressed.
+        compress_thread_->FinishReport(new_report);
+      } else {
+        UUID uuid;
+        database_status =
+            database_->FinishedWritingCrashReport(new_report, &uuid);
+        if (database_status != CrashReportDatabase::kNoError) {
+          Metrics::ExceptionCaptureResult(
+              Metrics::CaptureResult::kFinishedWritingCrashReportFailed);
+          return KERN_FAILURE;
+        }
+
+        if (upload_thread_) {
+          upload_thread_->ReportPending(uuid);
+        }
+      }
+      finalize_timer.Stop();
+
+      minidump.CommitStaticStreams();
+    }
   }
 
   if (client_options.system_crash_reporter_forwarding != TriState::kDisabled &&
@@ -246,7 +411,9 @@ kern_return_t CrashReportExceptionHandler::CatchMachException(
   ExcServerCopyState(
       behavior, old_state, old_state_count, new_state, new_state_count);
 
-  Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSuccess);
+  Metrics::ExceptionCaptureResult(
+      duplicate ? Metrics::CaptureResult::kDuplicateSuppressed
+                : Metrics::CaptureResult::kSuccess);
   return ExcServerSuccessfulReturnValue(exception, behavior, false);
 }
 
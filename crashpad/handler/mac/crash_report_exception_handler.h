@@ -19,15 +19,24 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
+#include "base/files/file_path.h"
 #include "base/macros.h"
 #include "client/crash_report_database.h"
+#include "handler/crash_report_compress_thread.h"
 #include "handler/crash_report_upload_thread.h"
 #include "handler/user_stream_data_source.h"
+#include "snapshot/system_snapshot_cache.h"
 #include "util/mach/exc_server_variants.h"
 
 namespace crashpad {
 
+class CaptureTierSelector;
+class ClientDumpQuota;
+class CrashSignatureHistory;
+class IdleMemoryTrimmer;
+
 //! \brief An exception handler that writes crash reports for exception messages
 //!     to a CrashReportDatabase.
 class CrashReportExceptionHandler : public UniversalMachExcServer::Interface {
@@ -36,7 +45,14 @@ class CrashReportExceptionHandler : public UniversalMachExcServer::Interface {
   //!
   //! \param[in] database The database to store crash reports in. Weak.
   //! \param[in] upload_thread The upload thread to notify when a new crash
-  //!     report is written into \a database.
+  //!     report is written into \a database. If the upload thread permits it,
+  //!     new crash reports are instead uploaded through it directly, without
+  //!     being written into \a database. Weak. `nullptr` to leave crash reports
+  //!     pending in \a database for another handler to upload.
+  //! \param[in] compress_thread The thread to hand each crash report written
+  //!     into \a database to, so that it is compressed before it is made
+  //!     pending and \a upload_thread is notified. Weak. `nullptr` to make
+  //!     crash reports pending as soon as they are written.
   //! \param[in] process_annotations A map of annotations to insert as
   //!     process-level annotations into each crash report that is written. Do
   //!     not confuse this with module-level annotations, which are under the
@@ -51,14 +67,53 @@ class CrashReportExceptionHandler : public UniversalMachExcServer::Interface {
   //!     crash reports. For each crash report that is written, the data sources
   //!     are called in turn. These data sources may contribute additional
   //!     minidump streams. `nullptr` if not required.
+  //! \param[in] static_stream_cache A cache used to omit streams that are
+  //!     unchanged since the previous crash report of the same process from
+  //!     crash reports written on request by a running process, as by
+  //!     CrashpadClient::DumpWithoutCrash(). Weak. `nullptr` to always write
+  //!     crash reports in full.
+  //! \param[in] signature_history The history of crash signatures used to
+  //!     collapse repeated crashes into a single report. Weak. `nullptr` to
+  //!     report every crash.
+  //! \param[in] dump_quota The quota limiting how many dumps each client may
+  //!     request without crashing. Weak. `nullptr` to take every such dump.
+  //! \param[in] idle_memory_trimmer The trimmer to notify when a crash report
+  //!     has been written, so that memory is returned to the system once the
+  //!     handler is idle. Weak. `nullptr` to never trim memory.
   CrashReportExceptionHandler(
       CrashReportDatabase* database,
       CrashReportUploadThread* upload_thread,
+      CrashReportCompressThread* compress_thread,
       const std::map<std::string, std::string>* process_annotations,
-      const UserStreamDataSources* user_stream_data_sources);
+      const UserStreamDataSources* user_stream_data_sources,
+      MinidumpStaticStreamCache* static_stream_cache,
+      CrashSignatureHistory* signature_history,
+      ClientDumpQuota* dump_quota,
+      IdleMemoryTrimmer* idle_memory_trimmer);
 
   ~CrashReportExceptionHandler();
 
+  //! \brief Degrades crash reports according to the load on the system.
+  //!
+  //! Each exception is counted by \a capture_tier_selector, which picks the
+  //! CaptureTier that its report is written at, recorded in the
+  //! #kCaptureTierAnnotation process annotation. Under the heaviest load, no
+  //! report is written at all, and the exception isn’t forwarded to the
+  //! system crash reporter.
+  //!
+  //! \param[in] capture_tier_selector The selector to consult. Weak. `nullptr`,
+  //!     the default, to always write reports at CaptureTier::kFull.
+  void SetCaptureTierSelector(CaptureTierSelector* capture_tier_selector);
+
+  //! \brief Sets the files to attach to each crash report.
+  //!
+  //! The files are cloned into the database as each report is written, as
+  //! for CrashReportDatabase::NewReport::attachments, and uploaded from there,
+  //! or are read from where they are if the report is uploaded directly.
+  //!
+  //! \param[in] attachments The paths of the files. The default is none.
+  void SetAttachments(const std::vector<base::FilePath>& attachments);
+
   // UniversalMachExcServer::Interface:
 
   //! \brief Processes an exception message by writing a crash report to this
@@ -82,8 +137,19 @@ class CrashReportExceptionHandler : public UniversalMachExcServer::Interface {
  private:
   CrashReportDatabase* database_;  // weak
   CrashReportUploadThread* upload_thread_;  // weak
+  CrashReportCompressThread* compress_thread_;  // weak
   const std::map<std::string, std::string>* process_annotations_;  // weak
   const UserStreamDataSources* user_stream_data_sources_;  // weak
+  MinidumpStaticStreamCache* static_stream_cache_;  // weak
+  CrashSignatureHistory* signature_history_;  // weak
+  ClientDumpQuota* dump_quota_;  // weak
+  IdleMemoryTrimmer* idle_memory_trimmer_;  // weak
+  CaptureTierSelector* capture_tier_selector_;  // weak
+  std::vector<base::FilePath> attachments_;
+
+  // Shared by every crash report, so that system facts that don’t change
+  // aren’t determined again.
+  SystemSnapshotCache system_snapshot_cache_;
 
   DISALLOW_COPY_AND_ASSIGN(CrashReportExceptionHandler);
 };
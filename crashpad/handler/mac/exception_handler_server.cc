@@ -14,20 +14,59 @@
 
 #include "handler/mac/exception_handler_server.h"
 
+#include <map>
+#include <memory>
 #include <utility>
 
 #include "base/logging.h"
 #include "base/mac/mach_logging.h"
+#include "base/synchronization/lock.h"
 #include "util/mach/composite_mach_message_server.h"
 #include "util/mach/mach_extensions.h"
 #include "util/mach/mach_message.h"
 #include "util/mach/mach_message_server.h"
 #include "util/mach/notify_server.h"
+#include "util/stdlib/pointer_container.h"
+#include "util/thread/thread.h"
 
 namespace crashpad {
 
 namespace {
 
+// Sends a synthesized no-senders notification to |notify_port|. If
+// |may_drop| is true, the message is not sent if it would block because the
+// port’s queue is full, which can only happen when another such notification
+// is already queued.
+void SendNoSendersNotification(mach_port_t notify_port, bool may_drop) {
+  // mach_no_senders_notification_t defines the receive side of this structure,
+  // with a trailer element that’s undesirable for the send side.
+  struct {
+    mach_msg_header_t header;
+    NDR_record_t ndr;
+    mach_msg_type_number_t mscount;
+  } no_senders_notification = {};
+  no_senders_notification.header.msgh_bits =
+      MACH_MSGH_BITS(MACH_MSG_TYPE_MAKE_SEND_ONCE, 0);
+  no_senders_notification.header.msgh_size = sizeof(no_senders_notification);
+  no_senders_notification.header.msgh_remote_port = notify_port;
+  no_senders_notification.header.msgh_local_port = MACH_PORT_NULL;
+  no_senders_notification.header.msgh_id = MACH_NOTIFY_NO_SENDERS;
+  no_senders_notification.ndr = NDR_record;
+  no_senders_notification.mscount = 0;
+
+  const mach_msg_option_t options =
+      MACH_SEND_MSG | (may_drop ? MACH_SEND_TIMEOUT : 0);
+  kern_return_t kr = mach_msg(&no_senders_notification.header,
+                              options,
+                              sizeof(no_senders_notification),
+                              0,
+                              MACH_PORT_NULL,
+                              MACH_MSG_TIMEOUT_NONE,
+                              MACH_PORT_NULL);
+  MACH_CHECK(kr == KERN_SUCCESS || (may_drop && kr == MACH_SEND_TIMED_OUT), kr)
+      << "mach_msg";
+}
+
 class ExceptionHandlerServerRun : public UniversalMachExcServer::Interface,
                                   public NotifyServer::DefaultInterface {
  public:
@@ -35,26 +74,26 @@ class ExceptionHandlerServerRun : public UniversalMachExcServer::Interface,
       mach_port_t exception_port,
       mach_port_t notify_port,
       bool launchd,
+      size_t thread_count,
       UniversalMachExcServer::Interface* exception_interface)
       : UniversalMachExcServer::Interface(),
         NotifyServer::DefaultInterface(),
-        mach_exc_server_(this),
-        notify_server_(this),
-        composite_mach_message_server_(),
+        task_locks_(),
         exception_interface_(exception_interface),
         exception_port_(exception_port),
         notify_port_(notify_port),
+        thread_count_(thread_count),
+        lock_(),
         running_(true),
         launchd_(launchd) {
-    composite_mach_message_server_.AddHandler(&mach_exc_server_);
-    composite_mach_message_server_.AddHandler(&notify_server_);
+    DCHECK_GE(thread_count_, 1u);
   }
 
   ~ExceptionHandlerServerRun() {
   }
 
   void Run() {
-    DCHECK(running_);
+    DCHECK(Running());
 
     kern_return_t kr;
     if (!launchd_) {
@@ -92,19 +131,51 @@ class ExceptionHandlerServerRun : public UniversalMachExcServer::Interface,
         mach_task_self(), notify_port_, server_port_set.get());
     MACH_CHECK(kr == KERN_SUCCESS, kr) << "mach_port_insert_member";
 
+    if (thread_count_ == 1) {
+      Serve(server_port_set.get());
+      return;
+    }
+
+    // Each thread receives from the same port set, so that exception messages
+    // from different tasks are handled concurrently. The number of threads
+    // caps the number of exceptions handled at once.
+    PointerVector<ServerThread> threads;
+    for (size_t index = 0; index < thread_count_; ++index) {
+      threads.push_back(new ServerThread(this, server_port_set.get()));
+      threads.back()->Start();
+    }
+    for (ServerThread* thread : threads) {
+      thread->Join();
+    }
+  }
+
+  // Receives and dispatches messages on |server_port_set| until a no-senders
+  // notification is received. This may be called on several threads at once.
+  void Serve(mach_port_t server_port_set) {
+    UniversalMachExcServer mach_exc_server(this);
+    NotifyServer notify_server(this);
+    CompositeMachMessageServer composite_mach_message_server;
+    composite_mach_message_server.AddHandler(&mach_exc_server);
+    composite_mach_message_server.AddHandler(&notify_server);
+
+    // Keep the receive and reply buffers for this thread’s lifetime rather than
+    // reallocating them for each message.
+    MachMessageServer::Buffers buffers;
+
     // Run the server in kOneShot mode so that running_ can be reevaluated after
     // each message. Receipt of a valid no-senders notification causes it to be
     // set to false.
-    while (running_) {
+    while (Running()) {
       // This will result in a call to CatchMachException() or
       // DoMachNotifyNoSenders() as appropriate.
       mach_msg_return_t mr =
-          MachMessageServer::Run(&composite_mach_message_server_,
-                                 server_port_set.get(),
+          MachMessageServer::Run(&composite_mach_message_server,
+                                 server_port_set,
                                  kMachMessageReceiveAuditTrailer,
                                  MachMessageServer::kOneShot,
                                  MachMessageServer::kReceiveLargeIgnore,
-                                 kMachMessageTimeoutWaitIndefinitely);
+                                 kMachMessageTimeoutWaitIndefinitely,
+                                 &buffers);
 
       // MACH_SEND_INVALID_DEST occurs when attempting to reply to a dead name.
       // This can happen if a mach_exc or exc client disappears before a reply
@@ -114,6 +185,13 @@ class ExceptionHandlerServerRun : public UniversalMachExcServer::Interface,
       MACH_CHECK(mr == MACH_MSG_SUCCESS || mr == MACH_SEND_INVALID_DEST, mr)
           << "MachMessageServer::Run";
     }
+
+    if (thread_count_ > 1) {
+      // Only one thread received the no-senders notification. Pass it along
+      // so that the next thread blocked in MachMessageServer::Run() wakes up
+      // and stops too.
+      SendNoSendersNotification(notify_port_, true);
+    }
   }
 
   // UniversalMachExcServer::Interface:
@@ -137,6 +215,11 @@ class ExceptionHandlerServerRun : public UniversalMachExcServer::Interface,
       return KERN_FAILURE;
     }
 
+    // Exceptions from a single task are handled one at a time, even when
+    // several threads are available. A task’s send right always has the same
+    // name in this task, so |task| identifies the task.
+    ScopedTaskLock task_lock(this, task);
+
     return exception_interface_->CatchMachException(behavior,
                                                     exception_port,
                                                     thread,
@@ -169,18 +252,82 @@ class ExceptionHandlerServerRun : public UniversalMachExcServer::Interface,
       return KERN_FAILURE;
     }
 
+    base::AutoLock lock(lock_);
     running_ = false;
 
     return KERN_SUCCESS;
   }
 
  private:
-  UniversalMachExcServer mach_exc_server_;
-  NotifyServer notify_server_;
-  CompositeMachMessageServer composite_mach_message_server_;
+  class ServerThread final : public Thread {
+   public:
+    ServerThread(ExceptionHandlerServerRun* run, mach_port_t server_port_set)
+        : Thread(), run_(run), server_port_set_(server_port_set) {}
+    ~ServerThread() override {}
+
+   private:
+    void ThreadMain() override { run_->Serve(server_port_set_); }
+
+    ExceptionHandlerServerRun* run_;  // weak
+    mach_port_t server_port_set_;  // weak
+
+    DISALLOW_COPY_AND_ASSIGN(ServerThread);
+  };
+
+  struct TaskLock {
+    TaskLock() : lock(), users(0) {}
+
+    base::Lock lock;
+    size_t users;
+  };
+
+  // Holds the TaskLock for a task for the lifetime of the object, creating it
+  // if necessary and discarding it when no other thread is using it.
+  class ScopedTaskLock {
+   public:
+    ScopedTaskLock(ExceptionHandlerServerRun* run, task_t task)
+        : run_(run), task_(task), task_lock_(nullptr) {
+      {
+        base::AutoLock lock(run_->lock_);
+        std::unique_ptr<TaskLock>& task_lock = run_->task_locks_[task_];
+        if (!task_lock) {
+          task_lock.reset(new TaskLock());
+        }
+        ++task_lock->users;
+        task_lock_ = task_lock.get();
+      }
+      task_lock_->lock.Acquire();
+    }
+
+    ~ScopedTaskLock() {
+      task_lock_->lock.Release();
+
+      base::AutoLock lock(run_->lock_);
+      if (--task_lock_->users == 0) {
+        run_->task_locks_.erase(task_);
+      }
+    }
+
+   private:
+    ExceptionHandlerServerRun* run_;  // weak
+    task_t task_;  // weak
+    TaskLock* task_lock_;  // weak
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedTaskLock);
+  };
+
+  bool Running() {
+    base::AutoLock lock(lock_);
+    return running_;
+  }
+
+  // task_locks_ and running_ are guarded by lock_.
+  std::map<task_t, std::unique_ptr<TaskLock>> task_locks_;
   UniversalMachExcServer::Interface* exception_interface_;  // weak
   mach_port_t exception_port_;  // weak
   mach_port_t notify_port_;  // weak
+  size_t thread_count_;
+  base::Lock lock_;
   bool running_;
   bool launchd_;
 
@@ -191,12 +338,15 @@ class ExceptionHandlerServerRun : public UniversalMachExcServer::Interface,
 
 ExceptionHandlerServer::ExceptionHandlerServer(
     base::mac::ScopedMachReceiveRight receive_port,
-    bool launchd)
+    bool launchd,
+    size_t thread_count)
     : receive_port_(std::move(receive_port)),
       notify_port_(NewMachPort(MACH_PORT_RIGHT_RECEIVE)),
+      thread_count_(thread_count),
       launchd_(launchd) {
   CHECK(receive_port_.is_valid());
   CHECK(notify_port_.is_valid());
+  CHECK_GE(thread_count_, 1u);
 }
 
 ExceptionHandlerServer::~ExceptionHandlerServer() {
@@ -204,39 +354,18 @@ ExceptionHandlerServer::~ExceptionHandlerServer() {
 
 void ExceptionHandlerServer::Run(
     UniversalMachExcServer::Interface* exception_interface) {
-  ExceptionHandlerServerRun run(
-      receive_port_.get(), notify_port_.get(), launchd_, exception_interface);
+  ExceptionHandlerServerRun run(receive_port_.get(),
+                                notify_port_.get(),
+                                launchd_,
+                                thread_count_,
+                                exception_interface);
   run.Run();
 }
 
 void ExceptionHandlerServer::Stop() {
   // Cause the exception handler server to stop running by sending it a
   // synthesized no-senders notification.
-  //
-  // mach_no_senders_notification_t defines the receive side of this structure,
-  // with a trailer element that’s undesirable for the send side.
-  struct {
-    mach_msg_header_t header;
-    NDR_record_t ndr;
-    mach_msg_type_number_t mscount;
-  } no_senders_notification = {};
-  no_senders_notification.header.msgh_bits =
-      MACH_MSGH_BITS(MACH_MSG_TYPE_MAKE_SEND_ONCE, 0);
-  no_senders_notification.header.msgh_size = sizeof(no_senders_notification);
-  no_senders_notification.header.msgh_remote_port = notify_port_.get();
-  no_senders_notification.header.msgh_local_port = MACH_PORT_NULL;
-  no_senders_notification.header.msgh_id = MACH_NOTIFY_NO_SENDERS;
-  no_senders_notification.ndr = NDR_record;
-  no_senders_notification.mscount = 0;
-
-  kern_return_t kr = mach_msg(&no_senders_notification.header,
-                              MACH_SEND_MSG,
-                              sizeof(no_senders_notification),
-                              0,
-                              MACH_PORT_NULL,
-                              MACH_MSG_TIMEOUT_NONE,
-                              MACH_PORT_NULL);
-  MACH_CHECK(kr == KERN_SUCCESS, kr) << "mach_msg";
+  SendNoSendersNotification(notify_port_.get(), false);
 }
 
 }  // namespace crashpad
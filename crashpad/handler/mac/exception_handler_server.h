@@ -16,6 +16,7 @@
 #define CRASHPAD_HANDLER_MAC_EXCEPTION_HANDLER_SERVER_H_
 
 #include <mach/mach.h>
+#include <stddef.h>
 
 #include "base/mac/scoped_mach_port.h"
 #include "base/macros.h"
@@ -35,8 +36,14 @@ class ExceptionHandlerServer {
   //!     launchd. \a receive_port is not monitored for no-senders
   //!     notifications, and instead, Stop() must be called to provide a “quit”
   //!     signal.
+  //! \param[in] thread_count The number of threads that Run() will receive
+  //!     messages on. When greater than `1`, exceptions from different tasks
+  //!     are handled concurrently, up to this many at once, while exceptions
+  //!     from any one task are still handled one at a time. Must be at least
+  //!     `1`.
   ExceptionHandlerServer(base::mac::ScopedMachReceiveRight receive_port,
-                         bool launchd);
+                         bool launchd,
+                         size_t thread_count);
   ~ExceptionHandlerServer();
 
   //! \brief Runs the exception-handling server.
@@ -51,7 +58,9 @@ class ExceptionHandlerServer {
   //! queued by `mach_msg()` to be sent to a client) prior to calling this
   //! method, or it will detect that it is sender-less and return immediately.
   //!
-  //! All exception messages will be passed to \a exception_interface.
+  //! All exception messages will be passed to \a exception_interface. If this
+  //! object was constructed with a `thread_count` greater than `1`, \a
+  //! exception_interface may be called on several threads at once.
   //!
   //! This method must only be called once on an ExceptionHandlerServer object.
   //!
@@ -74,6 +83,7 @@ class ExceptionHandlerServer {
  private:
   base::mac::ScopedMachReceiveRight receive_port_;
   base::mac::ScopedMachReceiveRight notify_port_;
+  size_t thread_count_;
   bool launchd_;
 
   DISALLOW_COPY_AND_ASSIGN(ExceptionHandlerServer);
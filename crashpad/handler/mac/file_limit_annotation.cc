@@ -26,6 +26,7 @@
 #include "base/format_macros.h"
 #include "base/macros.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
 #include "client/crashpad_info.h"
 #include "client/simple_string_dictionary.h"
 #include "util/posix/scoped_dir.h"
@@ -92,6 +93,11 @@ std::string StringForRLim(rlim_t limit) {
 }  // namespace
 
 void RecordFileLimitAnnotation() {
+  // Exceptions may be handled on several threads at once, and the annotation
+  // dictionary is not thread-safe.
+  static base::Lock* lock = new base::Lock();
+  base::AutoLock auto_lock(*lock);
+
   CrashpadInfo* crashpad_info = CrashpadInfo::GetCrashpadInfo();
   SimpleStringDictionary* simple_annotations =
       crashpad_info->simple_annotations();
@@ -29,6 +29,8 @@ namespace crashpad {
 //!
 //! See https://crashpad.chromium.org/bug/180.
 //!
+//! This function is thread-safe.
+//!
 //! TODO(mark): Remove this annotation after sufficient data has been collected
 //! for analysis.
 void RecordFileLimitAnnotation();
@@ -14,18 +14,32 @@
 
 #include "handler/prune_crash_reports_thread.h"
 
+#include <time.h>
+
 #include <utility>
 
 #include "client/prune_crash_reports.h"
+#include "util/thread/thread_priority.h"
 
 namespace crashpad {
 
+namespace {
+
+// Pages stored this recently may belong to a report that is still being
+// written, and so aren’t yet known to be referenced.
+constexpr time_t kMinimumUnreferencedPageAge = 60 * 60;
+
+}  // namespace
+
 PruneCrashReportThread::PruneCrashReportThread(
     CrashReportDatabase* database,
-    std::unique_ptr<PruneCondition> condition)
-    : thread_(60 * 60 * 24, this),
+    std::unique_ptr<PruneCondition> condition,
+    PageStore* page_store,
+    WorkerThreadExecutor* executor)
+    : thread_(60 * 60 * 24, this, executor),
       condition_(std::move(condition)),
-      database_(database) {}
+      database_(database),
+      page_store_(page_store) {}
 
 PruneCrashReportThread::~PruneCrashReportThread() {}
 
@@ -38,7 +52,12 @@ void PruneCrashReportThread::Stop() {
 }
 
 void PruneCrashReportThread::DoWork(const WorkerThread* thread) {
+  LowerThreadPriority();
   PruneCrashReportDatabase(database_, condition_.get());
+  if (page_store_) {
+    PruneUnreferencedPages(
+        database_, page_store_, kMinimumUnreferencedPageAge);
+  }
 }
 
 }  // namespace crashpad
@@ -23,14 +23,17 @@
 namespace crashpad {
 
 class CrashReportDatabase;
+class PageStore;
 class PruneCondition;
+class WorkerThreadExecutor;
 
 //! \brief A thread that periodically prunes crash reports from the database
 //!     using the specified condition.
 //!
 //! After the thread is started, the database is pruned using the condition
 //! every 24 hours. Upon calling Start(), the thread waits 10 minutes before
-//! performing the initial prune operation.
+//! performing the initial prune operation. When a PageStore is given, its
+//! pages that no remaining report refers to are removed after each prune.
 class PruneCrashReportThread : public WorkerThread::Delegate {
  public:
   //! \brief Constructs a new object.
@@ -38,8 +41,14 @@ class PruneCrashReportThread : public WorkerThread::Delegate {
   //! \param[in] database The database to prune crash reports from.
   //! \param[in] condition The condition used to evaluate crash reports for
   //!     pruning.
+  //! \param[in] page_store The store holding the pages of the database’s paged
+  //!     reports. Weak. `nullptr` if no reports are paged.
+  //! \param[in] executor The executor to prune on, which is shared with other
+  //!     background tasks. Weak. `nullptr` to prune on a thread of its own.
   PruneCrashReportThread(CrashReportDatabase* database,
-                         std::unique_ptr<PruneCondition> condition);
+                         std::unique_ptr<PruneCondition> condition,
+                         PageStore* page_store,
+                         WorkerThreadExecutor* executor);
   ~PruneCrashReportThread();
 
   //! \brief Starts a dedicated pruning thread.
@@ -67,6 +76,7 @@ class PruneCrashReportThread : public WorkerThread::Delegate {
   WorkerThread thread_;
   std::unique_ptr<PruneCondition> condition_;
   CrashReportDatabase* database_;  // weak
+  PageStore* page_store_;  // weak
 
   DISALLOW_COPY_AND_ASSIGN(PruneCrashReportThread);
 };
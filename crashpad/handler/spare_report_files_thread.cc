@@ -0,0 +1,39 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/spare_report_files_thread.h"
+
+#include "client/crash_report_database.h"
+
+namespace crashpad {
+
+SpareReportFilesThread::SpareReportFilesThread(CrashReportDatabase* database,
+                                               WorkerThreadExecutor* executor)
+    : thread_(60, this, executor), database_(database) {}
+
+SpareReportFilesThread::~SpareReportFilesThread() {}
+
+void SpareReportFilesThread::Start() {
+  thread_.Start(30);
+}
+
+void SpareReportFilesThread::Stop() {
+  thread_.Stop();
+}
+
+void SpareReportFilesThread::DoWork(const WorkerThread* thread) {
+  database_->ReplenishSpareReportFiles();
+}
+
+}  // namespace crashpad
@@ -0,0 +1,77 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_SPARE_REPORT_FILES_THREAD_H_
+#define CRASHPAD_HANDLER_SPARE_REPORT_FILES_THREAD_H_
+
+#include "base/macros.h"
+#include "util/thread/worker_thread.h"
+
+namespace crashpad {
+
+class CrashReportDatabase;
+class WorkerThreadExecutor;
+
+//! \brief A thread that periodically replaces the spare report files consumed
+//!     by new crash reports.
+//!
+//! After the thread is started, the database’s spare report files are
+//! replenished every minute, so that report files are created and have storage
+//! reserved for them away from the crash path. Upon calling Start(), the thread
+//! waits 30 seconds before doing so for the first time. See
+//! CrashReportDatabase::ReplenishSpareReportFiles().
+class SpareReportFilesThread : public WorkerThread::Delegate {
+ public:
+  //! \brief Constructs a new object.
+  //!
+  //! \param[in] database The database to keep spare report files in.
+  //! \param[in] executor The executor to create files on, which is shared with
+  //!     other background tasks. Weak. `nullptr` to create them on a thread of
+  //!     its own.
+  SpareReportFilesThread(CrashReportDatabase* database,
+                         WorkerThreadExecutor* executor);
+  ~SpareReportFilesThread();
+
+  //! \brief Starts replenishing spare report files.
+  //!
+  //! The thread waits before creating the initial files, so as to not interfere
+  //! with any startup-related IO performed by the client.
+  //!
+  //! This method may only be be called on a newly-constructed object or after
+  //! a call to Stop().
+  void Start();
+
+  //! \brief Stops replenishing spare report files.
+  //!
+  //! This method must only be called after Start(). If Start() has been called,
+  //! this method must be called before destroying an object of this class.
+  //!
+  //! This method may be called from any thread other than the replenishing
+  //! thread. It is expected to only be called from the same thread that called
+  //! Start().
+  void Stop();
+
+ private:
+  // WorkerThread::Delegate:
+  void DoWork(const WorkerThread* thread) override;
+
+  WorkerThread thread_;
+  CrashReportDatabase* database_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(SpareReportFilesThread);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_SPARE_REPORT_FILES_THREAD_H_
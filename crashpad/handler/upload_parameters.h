@@ -0,0 +1,47 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_UPLOAD_PARAMETERS_H_
+#define CRASHPAD_HANDLER_UPLOAD_PARAMETERS_H_
+
+#include <map>
+#include <string>
+
+namespace crashpad {
+
+class ProcessSnapshot;
+
+//! \brief Returns a map of key-value pairs to use as HTTP form parameters for
+//!     upload of a report of \a process_snapshot to a Breakpad server.
+//!
+//! The map is built by combining the process simple annotations map with each
+//! module’s simple annotations map. In the case of duplicate keys, the map will
+//! retain the first value found for any key, and will log a warning about
+//! discarded values. Each module’s annotations vector is also examined and
+//! built into a single string value, with distinct elements separated by
+//! newlines, and stored at the key named “list_annotations”, which supersedes
+//! any other key found by that name. The client ID is converted to a string and
+//! stored at the key named “guid”, which supersedes any other key found by that
+//! name.
+//!
+//! The same parameters result from a snapshot of a process and from a snapshot
+//! read from a minidump file written from it, so exception handlers use this to
+//! set CrashReportDatabase::NewReport::upload_parameters, and
+//! CrashReportUploadThread uses it for reports written without them.
+std::map<std::string, std::string> BreakpadHTTPFormParametersFromSnapshot(
+    const ProcessSnapshot* process_snapshot);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_UPLOAD_PARAMETERS_H_
@@ -0,0 +1,162 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/upload_statistics.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "build/build_config.h"
+#include "util/file/file_io.h"
+#include "util/file/file_writer.h"
+
+#if defined(OS_WIN)
+#include <windows.h>
+
+#include "base/strings/utf_string_conversions.h"
+#endif  // OS_WIN
+
+namespace crashpad {
+
+UploadStatistics::UploadStatistics()
+    : lock_(),
+      write_lock_(),
+      durations_ms_(),
+      queue_seconds_(),
+      attempts_(0),
+      successes_(0),
+      retries_(0),
+      stored_bytes_(0),
+      minidump_bytes_(0),
+      pending_reports_(0) {}
+
+UploadStatistics::~UploadStatistics() {}
+
+void UploadStatistics::SetPendingReports(size_t pending_reports) {
+  base::AutoLock lock(lock_);
+  pending_reports_ = pending_reports;
+}
+
+void UploadStatistics::RecordAttempt(const Attempt& attempt) {
+  base::AutoLock lock(lock_);
+
+  ++attempts_;
+  if (attempt.retry) {
+    ++retries_;
+  }
+  AddSample(&durations_ms_, attempt.duration_ms);
+
+  // Only what reached the server counts as uploaded.
+  if (attempt.successful) {
+    ++successes_;
+    stored_bytes_ += attempt.stored_size;
+    minidump_bytes_ += attempt.minidump_size;
+    AddSample(&queue_seconds_, attempt.queue_seconds);
+  }
+}
+
+std::string UploadStatistics::ToString() const {
+  base::AutoLock lock(lock_);
+
+  std::string text;
+  text.append(base::StringPrintf("pending_reports=%zu\n", pending_reports_));
+  text.append(base::StringPrintf("upload_attempts=%" PRIu64 "\n", attempts_));
+  text.append(base::StringPrintf("upload_successes=%" PRIu64 "\n", successes_));
+  text.append(base::StringPrintf("upload_retries=%" PRIu64 "\n", retries_));
+  text.append(
+      base::StringPrintf("uploaded_bytes=%" PRIu64 "\n", stored_bytes_));
+  text.append(base::StringPrintf("uploaded_minidump_bytes=%" PRIu64 "\n",
+                                 minidump_bytes_));
+
+  // The ratio by which minidump files were compressed in the database, or 0
+  // if nothing has been uploaded.
+  text.append(base::StringPrintf(
+      "compression_ratio=%.2f\n",
+      stored_bytes_ ? static_cast<double>(minidump_bytes_) / stored_bytes_
+                    : 0.0));
+
+  static constexpr unsigned int kPercentiles[] = {50, 90, 99};
+  for (unsigned int percentile : kPercentiles) {
+    text.append(base::StringPrintf("upload_duration_ms_p%u=%" PRIu64 "\n",
+                                   percentile,
+                                   Percentile(durations_ms_, percentile)));
+  }
+  for (unsigned int percentile : kPercentiles) {
+    text.append(base::StringPrintf("queue_seconds_p%u=%" PRIu64 "\n",
+                                   percentile,
+                                   Percentile(queue_seconds_, percentile)));
+  }
+  return text;
+}
+
+bool UploadStatistics::WriteToFile(const base::FilePath& path) const {
+  base::AutoLock write_lock(write_lock_);
+
+  const std::string text = ToString();
+  const base::FilePath new_path(path.value() + FILE_PATH_LITERAL(".new"));
+  {
+    FileWriter writer;
+    if (!writer.Open(new_path,
+                     FileWriteMode::kTruncateOrCreate,
+                     FilePermissions::kOwnerOnly) ||
+        !writer.Write(text.data(), text.size())) {
+      return false;
+    }
+  }
+
+#if defined(OS_WIN)
+  // LoggingMoveFile() doesn’t replace an existing file on Windows.
+  if (!MoveFileEx(new_path.value().c_str(),
+                  path.value().c_str(),
+                  MOVEFILE_REPLACE_EXISTING)) {
+    PLOG(ERROR) << "MoveFileEx " << base::UTF16ToUTF8(new_path.value())
+                << " to " << base::UTF16ToUTF8(path.value());
+    return false;
+  }
+  return true;
+#else
+  return LoggingMoveFile(new_path, path);
+#endif  // OS_WIN
+}
+
+// static
+uint64_t UploadStatistics::Percentile(const std::deque<uint64_t>& samples,
+                                      unsigned int percentile) {
+  if (samples.empty()) {
+    return 0;
+  }
+
+  // The nearest-rank percentile: the smallest sample at least as large as
+  // percentile percent of the samples.
+  std::vector<uint64_t> sorted(samples.begin(), samples.end());
+  const size_t rank =
+      std::max<size_t>((sorted.size() * percentile + 99) / 100, 1);
+  std::nth_element(sorted.begin(), sorted.begin() + rank - 1, sorted.end());
+  return sorted[rank - 1];
+}
+
+// static
+void UploadStatistics::AddSample(std::deque<uint64_t>* samples,
+                                 uint64_t value) {
+  samples->push_back(value);
+  if (samples->size() > kMaxSamples) {
+    samples->pop_front();
+  }
+}
+
+}  // namespace crashpad
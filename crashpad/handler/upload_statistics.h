@@ -0,0 +1,118 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_UPLOAD_STATISTICS_H_
+#define CRASHPAD_HANDLER_UPLOAD_STATISTICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+
+namespace crashpad {
+
+//! \brief Accumulates measurements of CrashReportUploadThread’s uploads since
+//!     it started, for writing to a file that can be inspected locally.
+//!
+//! Counts and byte totals cover every upload attempt. Percentiles are taken
+//! over the most recent #kMaxSamples attempts.
+//!
+//! This class is thread-safe.
+class UploadStatistics {
+ public:
+  //! \brief The number of recent attempts that percentiles are taken over.
+  static constexpr size_t kMaxSamples = 256;
+
+  //! \brief A completed upload attempt, for RecordAttempt().
+  struct Attempt {
+    //! \brief Whether the report was uploaded successfully.
+    bool successful;
+
+    //! \brief Whether an earlier attempt had been made to upload the report.
+    bool retry;
+
+    //! \brief How long the attempt took, in milliseconds.
+    uint64_t duration_ms;
+
+    //! \brief The size of the report’s minidump file as stored in the
+    //!     database, which is smaller than #minidump_size when the file is
+    //!     compressed.
+    uint64_t stored_size;
+
+    //! \brief The size of the report’s minidump file’s contents.
+    uint64_t minidump_size;
+
+    //! \brief The time from the report’s creation to the end of the attempt,
+    //!     in seconds.
+    uint64_t queue_seconds;
+  };
+
+  UploadStatistics();
+  ~UploadStatistics();
+
+  //! \brief Records the number of reports found pending at the start of a pass
+  //!     over the database, including those whose retries are deferred.
+  void SetPendingReports(size_t pending_reports);
+
+  //! \brief Records a completed upload attempt. Cancelled attempts should not
+  //!     be recorded.
+  void RecordAttempt(const Attempt& attempt);
+
+  //! \brief Formats the statistics as lines of `key=value` text.
+  std::string ToString() const;
+
+  //! \brief Writes ToString() to \a path.
+  //!
+  //! The text is written to a new file that is then moved over \a path, so
+  //! that a reader never sees a partially-written file.
+  //!
+  //! \return `true` on success. `false` on failure, with a message logged.
+  bool WriteToFile(const base::FilePath& path) const;
+
+ private:
+  //! \brief Returns the \a percentile percentile of \a samples, or `0` if it
+  //!     is empty.
+  static uint64_t Percentile(const std::deque<uint64_t>& samples,
+                             unsigned int percentile);
+
+  //! \brief Appends \a value to \a samples, discarding the oldest sample if
+  //!     there are more than #kMaxSamples.
+  static void AddSample(std::deque<uint64_t>* samples, uint64_t value);
+
+  mutable base::Lock lock_;
+
+  // Held by WriteToFile() while writing, because concurrent writers would
+  // share a new file.
+  mutable base::Lock write_lock_;
+
+  std::deque<uint64_t> durations_ms_;
+  std::deque<uint64_t> queue_seconds_;
+  uint64_t attempts_;
+  uint64_t successes_;
+  uint64_t retries_;
+  uint64_t stored_bytes_;
+  uint64_t minidump_bytes_;
+  size_t pending_reports_;
+
+  DISALLOW_COPY_AND_ASSIGN(UploadStatistics);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_UPLOAD_STATISTICS_H_
@@ -0,0 +1,120 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/upload_statistics.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "test/scoped_temp_dir.h"
+#include "util/file/file_io.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+UploadStatistics::Attempt MakeAttempt(bool successful,
+                                      uint64_t duration_ms,
+                                      uint64_t queue_seconds) {
+  UploadStatistics::Attempt attempt = {};
+  attempt.successful = successful;
+  attempt.duration_ms = duration_ms;
+  attempt.stored_size = 100;
+  attempt.minidump_size = 250;
+  attempt.queue_seconds = queue_seconds;
+  return attempt;
+}
+
+TEST(UploadStatistics, Empty) {
+  UploadStatistics statistics;
+  EXPECT_EQ(statistics.ToString(),
+            "pending_reports=0\n"
+            "upload_attempts=0\n"
+            "upload_successes=0\n"
+            "upload_retries=0\n"
+            "uploaded_bytes=0\n"
+            "uploaded_minidump_bytes=0\n"
+            "compression_ratio=0.00\n"
+            "upload_duration_ms_p50=0\n"
+            "upload_duration_ms_p90=0\n"
+            "upload_duration_ms_p99=0\n"
+            "queue_seconds_p50=0\n"
+            "queue_seconds_p90=0\n"
+            "queue_seconds_p99=0\n");
+}
+
+TEST(UploadStatistics, Attempts) {
+  UploadStatistics statistics;
+  statistics.SetPendingReports(3);
+
+  for (uint64_t index = 1; index <= 10; ++index) {
+    statistics.RecordAttempt(MakeAttempt(true, index * 10, index));
+  }
+
+  // Failed attempts count toward durations, but nothing was uploaded.
+  UploadStatistics::Attempt failed = MakeAttempt(false, 1000, 1000);
+  failed.retry = true;
+  statistics.RecordAttempt(failed);
+
+  EXPECT_EQ(statistics.ToString(),
+            "pending_reports=3\n"
+            "upload_attempts=11\n"
+            "upload_successes=10\n"
+            "upload_retries=1\n"
+            "uploaded_bytes=1000\n"
+            "uploaded_minidump_bytes=2500\n"
+            "compression_ratio=2.50\n"
+            "upload_duration_ms_p50=60\n"
+            "upload_duration_ms_p90=100\n"
+            "upload_duration_ms_p99=1000\n"
+            "queue_seconds_p50=5\n"
+            "queue_seconds_p90=9\n"
+            "queue_seconds_p99=10\n");
+}
+
+TEST(UploadStatistics, RecentSamples) {
+  UploadStatistics statistics;
+
+  // Only the most recent attempts are sampled, so an early slow upload stops
+  // affecting the percentiles.
+  statistics.RecordAttempt(MakeAttempt(true, 1000, 0));
+  for (size_t index = 0; index < UploadStatistics::kMaxSamples; ++index) {
+    statistics.RecordAttempt(MakeAttempt(true, 10, 0));
+  }
+
+  const std::string text = statistics.ToString();
+  EXPECT_NE(text.find("upload_duration_ms_p99=10\n"), std::string::npos);
+  EXPECT_NE(text.find("upload_attempts=257\n"), std::string::npos);
+}
+
+TEST(UploadStatistics, WriteToFile) {
+  ScopedTempDir temp_dir;
+  const base::FilePath path =
+      temp_dir.path().Append(FILE_PATH_LITERAL("upload_stats"));
+
+  UploadStatistics statistics;
+  ASSERT_TRUE(statistics.WriteToFile(path));
+
+  // Writing again replaces the file.
+  statistics.SetPendingReports(5);
+  ASSERT_TRUE(statistics.WriteToFile(path));
+
+  std::string contents;
+  ASSERT_TRUE(LoggingReadEntireFile(path, &contents));
+  EXPECT_EQ(contents, statistics.ToString());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,116 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <windows.h>
+
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/strings/utf_string_conversions.h"
+#include "client/crashpad_client.h"
+#include "client/crashpad_info.h"
+#include "client/simple_address_range_bag.h"
+#include "util/stdlib/string_number_conversion.h"
+
+// A crash client whose minidump size can be dialed up or down, for use by
+// crash_upload_benchmark.py. It connects to an already-running handler,
+// allocates the requested amount of memory and registers it to be captured,
+// starts the requested number of idle threads, announces on stdout that it is
+// about to crash, and then crashes.
+
+namespace crashpad {
+namespace {
+
+DWORD WINAPI IdleThread(void* arg) {
+  HANDLE event = reinterpret_cast<HANDLE>(arg);
+  WaitForSingleObject(event, INFINITE);
+  return 0;
+}
+
+bool ParseArgument(const wchar_t* argument, unsigned int* value) {
+  return StringToNumber(base::UTF16ToUTF8(argument), value);
+}
+
+int CrashBenchmarkClientMain(int argc, wchar_t* argv[]) {
+  unsigned int memory_kb;
+  unsigned int thread_count;
+  if (argc != 4 ||
+      !ParseArgument(argv[2], &memory_kb) ||
+      !ParseArgument(argv[3], &thread_count)) {
+    fprintf(stderr,
+            "Usage: %ls <server_pipe_name> <memory_kb> <threads>\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  CrashpadClient client;
+  if (!client.SetHandlerIPCPipe(argv[1])) {
+    LOG(ERROR) << "SetHandler";
+    return EXIT_FAILURE;
+  }
+
+  SimpleAddressRangeBag* extra_ranges = new SimpleAddressRangeBag();
+  CrashpadInfo::GetCrashpadInfo()->set_extra_memory_ranges(extra_ranges);
+
+  if (memory_kb) {
+    // Fill the memory with a pattern that doesn’t compress to nothing, so that
+    // the stored report size tracks the requested size.
+    const size_t memory_size = static_cast<size_t>(memory_kb) * 1024;
+    uint8_t* memory = new uint8_t[memory_size];
+    uint32_t state = 0x12345678;
+    for (size_t index = 0; index < memory_size; ++index) {
+      state = state * 1103515245 + 12345;
+      memory[index] = static_cast<uint8_t>(state >> 16);
+    }
+    if (!extra_ranges->Insert(memory, memory_size)) {
+      LOG(ERROR) << "Insert";
+      return EXIT_FAILURE;
+    }
+  }
+
+  HANDLE event = CreateEvent(nullptr, true, false, nullptr);
+  if (!event) {
+    PLOG(ERROR) << "CreateEvent";
+    return EXIT_FAILURE;
+  }
+
+  for (unsigned int index = 0; index < thread_count; ++index) {
+    HANDLE thread = CreateThread(nullptr, 0, &IdleThread, event, 0, nullptr);
+    if (!thread) {
+      PLOG(ERROR) << "CreateThread";
+      return EXIT_FAILURE;
+    }
+    CloseHandle(thread);
+  }
+
+  // The benchmark timestamps the crash on reading this line.
+  printf("crashing\n");
+  fflush(stdout);
+
+  volatile int* crash = reinterpret_cast<volatile int*>(7);
+  *crash = 42;
+
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+}  // namespace crashpad
+
+int wmain(int argc, wchar_t* argv[]) {
+  return crashpad::CrashBenchmarkClientMain(argc, argv);
+}
@@ -33,7 +33,9 @@ namespace {
 
 constexpr DWORD kCrashAndDumpTargetExitCode = 0xdeadbea7;
 
-bool CrashAndDumpTarget(const CrashpadClient& client, HANDLE process) {
+bool CrashAndDumpTarget(const CrashpadClient& client,
+                        HANDLE process,
+                        bool in_handler) {
   DWORD target_pid = GetProcessId(process);
 
   ScopedFileHANDLE thread_snap(CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0));
@@ -62,11 +64,12 @@ bool CrashAndDumpTarget(const CrashpadClient& client, HANDLE process) {
           PLOG(ERROR) << "OpenThread";
           return false;
         }
-        if (!client.DumpAndCrashTargetProcess(
-                process, thread.get(), kCrashAndDumpTargetExitCode)) {
-          return false;
+        if (in_handler) {
+          return client.DumpAndCrashTargetProcessInHandler(
+              process, thread.get(), kCrashAndDumpTargetExitCode);
         }
-        return true;
+        return client.DumpAndCrashTargetProcess(
+            process, thread.get(), kCrashAndDumpTargetExitCode);
       }
     }
   } while (Thread32Next(thread_snap.get(), &te32));
@@ -84,7 +87,9 @@ int CrashOtherProgram(int argc, wchar_t* argv[]) {
       return EXIT_FAILURE;
     }
   } else {
-    fprintf(stderr, "Usage: %ls <server_pipe_name> [noexception]\n", argv[0]);
+    fprintf(stderr,
+            "Usage: %ls <server_pipe_name> [noexception|inhandler]\n",
+            argv[0]);
     return EXIT_FAILURE;
   }
 
@@ -114,7 +119,8 @@ int CrashOtherProgram(int argc, wchar_t* argv[]) {
       return EXIT_FAILURE;
   } else {
     expect_exit_code = kCrashAndDumpTargetExitCode;
-    if (!CrashAndDumpTarget(client, child.process_handle())) {
+    const bool in_handler = argc == 3 && wcscmp(argv[2], L"inhandler") == 0;
+    if (!CrashAndDumpTarget(client, child.process_handle(), in_handler)) {
       return EXIT_FAILURE;
     }
   }
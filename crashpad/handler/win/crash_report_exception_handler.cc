@@ -14,35 +14,282 @@
 
 #include "handler/win/crash_report_exception_handler.h"
 
+#include <time.h>
+
+#include <memory>
 #include <type_traits>
+#include <utility>
 
+#include "base/strings/string_number_conversions.h"
 #include "client/crash_report_database.h"
+#include "client/crashpad_client.h"
 #include "client/settings.h"
+#include "handler/capture_pipeline.h"
+#include "handler/capture_tier.h"
+#include "handler/client_dump_quota.h"
+#include "handler/crash_report_compress_thread.h"
 #include "handler/crash_report_upload_thread.h"
+#include "handler/duplicate_crash_filter.h"
+#include "handler/idle_memory_trimmer.h"
+#include "handler/hang_detector.h"
+#include "handler/upload_parameters.h"
+#include "minidump/minidump_capture_performance_writer.h"
 #include "minidump/minidump_file_writer.h"
 #include "minidump/minidump_user_extension_stream_data_source.h"
+#include "snapshot/capture_deadline.h"
 #include "snapshot/win/process_snapshot_win.h"
 #include "util/file/file_writer.h"
+#include "util/misc/clock.h"
 #include "util/misc/metrics.h"
+#include "util/thread/thread_priority.h"
 #include "util/win/registration_protocol_win.h"
+#include "util/win/scoped_process_clone.h"
 #include "util/win/scoped_process_suspend.h"
 #include "util/win/termination_codes.h"
 
 namespace crashpad {
 
+namespace {
+
+// The number of minidumps that may be written or uploaded at once. Minidump
+// contents are read from the client while they’re written, so this is also
+// where most of the I/O for a report takes place.
+constexpr int kMaxConcurrentWrites = 2;
+
+// Priorities for CrashReportExceptionHandler::write_semaphore_. Crashed
+// clients are written before dumps requested by clients that are still
+// running.
+constexpr int kCrashWritePriority = 1;
+constexpr int kNonCrashWritePriority = 0;
+
+}  // namespace
+
+// Writes a crash report from a snapshot that no longer needs its process, so
+// that it may be written after the process is resumed or terminated.
+class CrashReportExceptionHandler::ReportJob : public CapturePipeline::Job {
+ public:
+  ReportJob(CrashReportExceptionHandler* handler,
+            std::unique_ptr<ProcessSnapshotWin> process_snapshot,
+            std::unique_ptr<ScopedProcessClone> clone)
+      : trim_when_idle_(handler->idle_memory_trimmer_),
+        minidump_(),
+        call_error_writing_crash_report_(),
+        process_snapshot_(std::move(process_snapshot)),
+        clone_(std::move(clone)),
+        handler_(handler),
+        new_report_(nullptr),
+        report_size_(0),
+        client_id_(0) {}
+
+  ~ReportJob() override {}
+
+  // Gathers everything else that the report needs from the process, which may
+  // be resumed once this returns. Returns false, with the capture result
+  // recorded, if the report can’t be written.
+  bool Prepare(DWORD client_id,
+               bool dump_without_crash,
+               CaptureTier tier,
+               const MinidumpCapturePhaseTimes& phase_times) {
+    client_id_ = client_id;
+
+    if (handler_->upload_thread_ &&
+        handler_->upload_thread_->CanUploadDirectly()) {
+      // The report is uploaded as its minidump is written, and is never added
+      // to the database.
+      UUID report_id;
+      if (!report_id.InitializeWithNew()) {
+        Metrics::ExceptionCaptureResult(
+            Metrics::CaptureResult::kPrepareNewCrashReportFailed);
+        return false;
+      }
+
+      process_snapshot_->SetReportID(report_id);
+    } else {
+      CrashReportDatabase::OperationStatus database_status =
+          handler_->database_->PrepareNewCrashReport(&new_report_);
+      if (database_status != CrashReportDatabase::kNoError) {
+        LOG(ERROR) << "PrepareNewCrashReport failed";
+        Metrics::ExceptionCaptureResult(
+            Metrics::CaptureResult::kPrepareNewCrashReportFailed);
+        return false;
+      }
+
+      process_snapshot_->SetReportID(new_report_->uuid);
+      new_report_->dump_without_crash = dump_without_crash;
+
+      call_error_writing_crash_report_.reset(
+          new CrashReportDatabase::CallErrorWritingCrashReport(
+              handler_->database_, new_report_));
+    }
+
+    ApplyCaptureTier(tier, &minidump_);
+    if (dump_without_crash) {
+      minidump_.SetStaticStreamCache(handler_->static_stream_cache_);
+    }
+    minidump_.SetCapturePhaseTimes(phase_times);
+    minidump_.InitializeFromSnapshot(process_snapshot_.get());
+    AddUserExtensionStreams(handler_->user_stream_data_sources_,
+                            process_snapshot_.get(),
+                            &minidump_);
+
+    if (new_report_) {
+      // The parameters that the report will be uploaded with are recorded
+      // now, from the same snapshot as the minidump, so that the minidump
+      // needn’t be interpreted to upload it. This reads annotations from the
+      // process, so it must precede an early resumption.
+      new_report_->upload_parameters =
+          BreakpadHTTPFormParametersFromSnapshot(process_snapshot_.get());
+      new_report_->attachments = handler_->attachments_;
+    }
+
+    return true;
+  }
+
+  // CapturePipeline::Job:
+
+  bool Serialize() override {
+    if (!new_report_) {
+      if (!handler_->upload_thread_->UploadMinidumpDirectly(
+              process_snapshot_.get(), &minidump_, handler_->attachments_)) {
+        LOG(ERROR) << "UploadMinidumpDirectly failed";
+        Metrics::ExceptionCaptureResult(
+            Metrics::CaptureResult::kDirectUploadFailed);
+        return false;
+      }
+      return true;
+    }
+
+    WeakFileHandleFileWriter file_writer(new_report_->handle);
+
+    Metrics::ScopedCapturePhaseTimer write_timer(
+        Metrics::CapturePhase::kMinidumpWrite);
+    write_timer.SetReportID(new_report_->uuid);
+    if (!minidump_.WriteEverything(&file_writer)) {
+      LOG(ERROR) << "WriteEverything failed";
+      Metrics::ExceptionCaptureResult(
+          Metrics::CaptureResult::kMinidumpWriteFailed);
+      return false;
+    }
+    write_timer.Stop();
+
+    call_error_writing_crash_report_->Disarm();
+
+    // With the report written, the writer is positioned at its end.
+    report_size_ = file_writer.Seek(0, SEEK_CUR);
+    return true;
+  }
+
+  void Commit() override {
+    if (new_report_) {
+      if (handler_->dump_quota_ && report_size_ > 0) {
+        handler_->dump_quota_->RecordBytes(
+            client_id_, report_size_, time(nullptr));
+      }
+
+      Metrics::ScopedCapturePhaseTimer finalize_timer(
+          Metrics::CapturePhase::kDatabaseFinalize);
+      if (handler_->compress_thread_) {
+        // The report is made pending once it has been compressed.
+        handler_->compress_thread_->FinishReport(new_report_);
+      } else {
+        UUID uuid;
+        CrashReportDatabase::OperationStatus database_status =
+            handler_->database_->FinishedWritingCrashReport(new_report_,
+                                                            &uuid);
+        if (database_status != CrashReportDatabase::kNoError) {
+          LOG(ERROR) << "FinishedWritingCrashReport failed";
+          Metrics::ExceptionCaptureResult(
+              Metrics::CaptureResult::kFinishedWritingCrashReportFailed);
+          return;
+        }
+
+        if (handler_->upload_thread_) {
+          handler_->upload_thread_->ReportPending(uuid);
+        }
+      }
+      finalize_timer.Stop();
+    }
+
+    minidump_.CommitStaticStreams();
+
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSuccess);
+  }
+
+ private:
+  // Memory allocated for the report is returned to the system once the handler
+  // has been idle for a while after it is written.
+  IdleMemoryTrimmer::Activity trim_when_idle_;
+
+  // minidump_ refers to process_snapshot_, which reads from clone_, so they
+  // must be destroyed in this order.
+  MinidumpFileWriter minidump_;
+  std::unique_ptr<CrashReportDatabase::CallErrorWritingCrashReport>
+      call_error_writing_crash_report_;
+  std::unique_ptr<ProcessSnapshotWin> process_snapshot_;
+  std::unique_ptr<ScopedProcessClone> clone_;
+
+  CrashReportExceptionHandler* handler_;  // weak
+
+  // Owned by the database until the report is finished or abandoned, which
+  // call_error_writing_crash_report_ does if the report isn’t written.
+  // nullptr if the report is uploaded directly.
+  CrashReportDatabase::NewReport* new_report_;
+
+  FileOffset report_size_;
+  DWORD client_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReportJob);
+};
+
 CrashReportExceptionHandler::CrashReportExceptionHandler(
     CrashReportDatabase* database,
     CrashReportUploadThread* upload_thread,
+    CrashReportCompressThread* compress_thread,
     const std::map<std::string, std::string>* process_annotations,
-    const UserStreamDataSources* user_stream_data_sources)
+    const UserStreamDataSources* user_stream_data_sources,
+    MinidumpStaticStreamCache* static_stream_cache,
+    CrashSignatureHistory* signature_history,
+    ClientDumpQuota* dump_quota,
+    IdleMemoryTrimmer* idle_memory_trimmer)
     : database_(database),
       upload_thread_(upload_thread),
+      compress_thread_(compress_thread),
       process_annotations_(process_annotations),
-      user_stream_data_sources_(user_stream_data_sources) {}
+      user_stream_data_sources_(user_stream_data_sources),
+      static_stream_cache_(static_stream_cache),
+      signature_history_(signature_history),
+      dump_quota_(dump_quota),
+      idle_memory_trimmer_(idle_memory_trimmer),
+      capture_pipeline_(nullptr),
+      capture_tier_selector_(nullptr),
+      attachments_(),
+      capture_deadline_(0),
+      write_semaphore_(kMaxConcurrentWrites),
+      system_snapshot_cache_() {}
 
 CrashReportExceptionHandler::~CrashReportExceptionHandler() {
 }
 
+void CrashReportExceptionHandler::SetCapturePipeline(
+    CapturePipeline* capture_pipeline) {
+  capture_pipeline_ = capture_pipeline;
+}
+
+void CrashReportExceptionHandler::SetCaptureDeadline(
+    unsigned int capture_deadline_ms) {
+  capture_deadline_ = static_cast<uint64_t>(capture_deadline_ms) * 1000000;
+}
+
+void CrashReportExceptionHandler::SetCaptureTierSelector(
+    CaptureTierSelector* capture_tier_selector) {
+  capture_tier_selector_ = capture_tier_selector;
+}
+
+void CrashReportExceptionHandler::SetAttachments(
+    const std::vector<base::FilePath>& attachments) {
+  attachments_ = attachments;
+}
+
 void CrashReportExceptionHandler::ExceptionHandlerServerStarted() {
 }
 
@@ -50,15 +297,81 @@ unsigned int CrashReportExceptionHandler::ExceptionHandlerServerException(
     HANDLE process,
     WinVMAddress exception_information_address,
     WinVMAddress debug_critical_section_address) {
+  return CaptureException(process,
+                          exception_information_address,
+                          debug_critical_section_address,
+                          0,
+                          0);
+}
+
+unsigned int CrashReportExceptionHandler::ExceptionHandlerServerDumpAndCrash(
+    HANDLE process,
+    DWORD thread_id,
+    DWORD exception_code,
+    WinVMAddress debug_critical_section_address) {
+  return CaptureException(
+      process, 0, debug_critical_section_address, thread_id, exception_code);
+}
+
+unsigned int CrashReportExceptionHandler::CaptureException(
+    HANDLE process,
+    WinVMAddress exception_information_address,
+    WinVMAddress debug_critical_section_address,
+    DWORD thread_id,
+    DWORD exception_code) {
   Metrics::ExceptionEncountered();
 
+  // The client waits while its crash is captured and written, and shouldn’t be
+  // kept waiting by other work on the system.
+  ScopedRaisedThreadPriority raise_priority;
+
+  // Memory allocated to capture and write the report is returned to the system
+  // once the handler has been idle for a while afterwards.
+  IdleMemoryTrimmer::Activity trim_when_idle(idle_memory_trimmer_);
+
+  // The deadline counts the time taken to suspend the process.
+  CaptureDeadline deadline(ClockMonotonicNanoseconds(), capture_deadline_);
+
+  // This is declared before |suspend| so that it is reported after the process
+  // is resumed.
+  Metrics::ScopedCapturePhaseTimer suspended_timer(
+      Metrics::CapturePhase::kTargetSuspended);
+
+  Metrics::ScopedCapturePhaseTimer suspend_timer(
+      Metrics::CapturePhase::kSuspend);
   ScopedProcessSuspend suspend(process);
+  MinidumpCapturePhaseTimes phase_times;
+  phase_times.suspend_time = suspend_timer.Stop();
+
+  // Where possible, the snapshot reads memory from a copy-on-write clone of the
+  // process, which is only a small fraction of the cost of copying it out, and
+  // which frees the process to be resumed as soon as the snapshot is
+  // initialized.
+  Metrics::ScopedCapturePhaseTimer snapshot_timer(
+      Metrics::CapturePhase::kSnapshot);
+  std::unique_ptr<ScopedProcessClone> clone(new ScopedProcessClone(process));
 
-  ProcessSnapshotWin process_snapshot;
-  if (!process_snapshot.Initialize(process,
-                                   ProcessSuspensionState::kSuspended,
-                                   exception_information_address,
-                                   debug_critical_section_address)) {
+  std::unique_ptr<ProcessSnapshotWin> process_snapshot(
+      new ProcessSnapshotWin());
+  process_snapshot->SetSystemSnapshotCache(&system_snapshot_cache_);
+  process_snapshot->SetCaptureDeadline(&deadline);
+  const bool initialized =
+      clone->clone()
+          ? process_snapshot->InitializeWithClone(
+                process,
+                clone->clone(),
+                exception_information_address,
+                debug_critical_section_address)
+          : process_snapshot->Initialize(process,
+                                         ProcessSuspensionState::kSuspended,
+                                         exception_information_address,
+                                         debug_critical_section_address);
+  phase_times.snapshot_time = snapshot_timer.Stop();
+  phase_times.skipped_content = deadline.skipped_content();
+  if (!initialized ||
+      (thread_id &&
+       !process_snapshot->InitializeSimulatedException(thread_id,
+                                                       exception_code))) {
     LOG(WARNING) << "ProcessSnapshotWin::Initialize failed";
     Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSnapshotFailed);
     return kTerminationCodeSnapshotFailed;
@@ -67,74 +380,200 @@ unsigned int CrashReportExceptionHandler::ExceptionHandlerServerException(
   // Now that we have the exception information, even if something else fails we
   // can terminate the process with the correct exit code.
   const unsigned int termination_code =
-      process_snapshot.Exception()->Exception();
+      process_snapshot->Exception()->Exception();
   static_assert(
       std::is_same<std::remove_const<decltype(termination_code)>::type,
-                   decltype(process_snapshot.Exception()->Exception())>::value,
+                   decltype(process_snapshot->Exception()->Exception())>::value,
       "expected ExceptionCode() and process termination code to match");
 
   Metrics::ExceptionCode(termination_code);
 
-  CrashpadInfoClientOptions client_options;
-  process_snapshot.GetCrashpadOptions(&client_options);
-  if (client_options.crashpad_handler_behavior != TriState::kDisabled) {
-    UUID client_id;
-    Settings* const settings = database_->GetSettings();
-    if (settings) {
-      // If GetSettings() or GetClientID() fails, something else will log a
-      // message and client_id will be left at its default value, all zeroes,
-      // which is appropriate.
-      settings->GetClientID(&client_id);
-    }
+  ReportSnapshot(process,
+                 std::move(process_snapshot),
+                 std::move(clone),
+                 &suspend,
+                 &suspended_timer,
+                 &phase_times,
+                 nullptr);
+  return termination_code;
+}
 
-    process_snapshot.SetClientID(client_id);
-    process_snapshot.SetAnnotationsSimpleMap(*process_annotations_);
+bool CrashReportExceptionHandler::DumpHungThread(HANDLE process,
+                                                 DWORD thread_id,
+                                                 unsigned int hang_seconds) {
+  Metrics::ExceptionEncountered();
 
-    CrashReportDatabase::NewReport* new_report;
-    CrashReportDatabase::OperationStatus database_status =
-        database_->PrepareNewCrashReport(&new_report);
-    if (database_status != CrashReportDatabase::kNoError) {
-      LOG(ERROR) << "PrepareNewCrashReport failed";
-      Metrics::ExceptionCaptureResult(
-          Metrics::CaptureResult::kPrepareNewCrashReportFailed);
-      return termination_code;
-    }
+  // The hung process is suspended while it’s captured. This may run on a
+  // thread whose priority was lowered for background work.
+  ScopedRaisedThreadPriority raise_priority;
 
-    process_snapshot.SetReportID(new_report->uuid);
+  // Memory allocated to capture and write the report is returned to the system
+  // once the handler has been idle for a while afterwards.
+  IdleMemoryTrimmer::Activity trim_when_idle(idle_memory_trimmer_);
 
-    CrashReportDatabase::CallErrorWritingCrashReport
-        call_error_writing_crash_report(database_, new_report);
+  // The deadline counts the time taken to suspend the process.
+  CaptureDeadline deadline(ClockMonotonicNanoseconds(), capture_deadline_);
 
-    WeakFileHandleFileWriter file_writer(new_report->handle);
+  Metrics::ScopedCapturePhaseTimer suspended_timer(
+      Metrics::CapturePhase::kTargetSuspended);
 
-    MinidumpFileWriter minidump;
-    minidump.InitializeFromSnapshot(&process_snapshot);
-    AddUserExtensionStreams(
-        user_stream_data_sources_, &process_snapshot, &minidump);
+  Metrics::ScopedCapturePhaseTimer suspend_timer(
+      Metrics::CapturePhase::kSuspend);
+  ScopedProcessSuspend suspend(process);
+  MinidumpCapturePhaseTimes phase_times;
+  phase_times.suspend_time = suspend_timer.Stop();
 
-    if (!minidump.WriteEverything(&file_writer)) {
-      LOG(ERROR) << "WriteEverything failed";
-      Metrics::ExceptionCaptureResult(
-          Metrics::CaptureResult::kMinidumpWriteFailed);
-      return termination_code;
-    }
+  Metrics::ScopedCapturePhaseTimer snapshot_timer(
+      Metrics::CapturePhase::kSnapshot);
+  std::unique_ptr<ScopedProcessClone> clone(new ScopedProcessClone(process));
 
-    call_error_writing_crash_report.Disarm();
+  std::unique_ptr<ProcessSnapshotWin> process_snapshot(
+      new ProcessSnapshotWin());
+  process_snapshot->SetSystemSnapshotCache(&system_snapshot_cache_);
+  process_snapshot->SetCaptureDeadline(&deadline);
+  const bool initialized =
+      clone->clone()
+          ? process_snapshot->InitializeWithClone(process, clone->clone(), 0, 0)
+          : process_snapshot->Initialize(
+                process, ProcessSuspensionState::kSuspended, 0, 0);
+  phase_times.snapshot_time = snapshot_timer.Stop();
+  phase_times.skipped_content = deadline.skipped_content();
+  if (!initialized ||
+      !process_snapshot->InitializeSimulatedException(
+          thread_id, CrashpadClient::kSimulatedExceptionCode)) {
+    LOG(WARNING) << "ProcessSnapshotWin::Initialize failed";
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSnapshotFailed);
+    return false;
+  }
 
-    UUID uuid;
-    database_status = database_->FinishedWritingCrashReport(new_report, &uuid);
-    if (database_status != CrashReportDatabase::kNoError) {
-      LOG(ERROR) << "FinishedWritingCrashReport failed";
-      Metrics::ExceptionCaptureResult(
-          Metrics::CaptureResult::kFinishedWritingCrashReportFailed);
-      return termination_code;
+  Metrics::ExceptionCode(process_snapshot->Exception()->Exception());
+
+  const std::map<std::string, std::string> hang_annotations = {
+      {kHangDurationAnnotation, base::UintToString(hang_seconds)}};
+  ReportSnapshot(process,
+                 std::move(process_snapshot),
+                 std::move(clone),
+                 &suspend,
+                 &suspended_timer,
+                 &phase_times,
+                 &hang_annotations);
+  return true;
+}
+
+void CrashReportExceptionHandler::ReportSnapshot(
+    HANDLE process,
+    std::unique_ptr<ProcessSnapshotWin> process_snapshot,
+    std::unique_ptr<ScopedProcessClone> clone,
+    ScopedProcessSuspend* suspend,
+    Metrics::ScopedCapturePhaseTimer* suspended_timer,
+    MinidumpCapturePhaseTimes* phase_times,
+    const std::map<std::string, std::string>* extra_annotations) {
+  const unsigned int termination_code =
+      process_snapshot->Exception()->Exception();
+  const bool dump_without_crash =
+      termination_code == CrashpadClient::kSimulatedExceptionCode;
+
+  // A client that keeps requesting dumps without crashing is refused once it
+  // has used its quota, before anything is written for it. Determining that a
+  // dump was requested requires the snapshot’s exception, but with a clone,
+  // little else has been read from the client by this point.
+  const DWORD client_id = GetProcessId(process);
+  if (dump_without_crash && dump_quota_ &&
+      !dump_quota_->TryAcquire(client_id, time(nullptr))) {
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kQuotaExceeded);
+    return;
+  }
+
+  // Under the heaviest load, the exception is only counted.
+  const CaptureTier tier =
+      capture_tier_selector_
+          ? capture_tier_selector_->SelectTier(ClockMonotonicNanoseconds())
+          : CaptureTier::kFull;
+  if (tier == CaptureTier::kCounterOnly) {
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kCounterOnly);
+    return;
+  }
+
+  CrashpadInfoClientOptions client_options;
+  process_snapshot->GetCrashpadOptions(&client_options);
+  if (client_options.crashpad_handler_behavior == TriState::kDisabled) {
+    Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSuccess);
+    return;
+  }
+
+  UUID settings_client_id;
+  Settings* const settings = database_->GetSettings();
+  if (settings) {
+    // If GetSettings() or GetClientID() fails, something else will log a
+    // message and settings_client_id will be left at its default value, all
+    // zeroes, which is appropriate.
+    settings->GetClientID(&settings_client_id);
+  }
+
+  process_snapshot->SetClientID(settings_client_id);
+
+  std::map<std::string, std::string> annotations(*process_annotations_);
+  if (extra_annotations) {
+    annotations.insert(extra_annotations->begin(), extra_annotations->end());
+  }
+  if (!ShouldReportCrash(
+          signature_history_, process_snapshot.get(), &annotations)) {
+    Metrics::ExceptionCaptureResult(
+        Metrics::CaptureResult::kDuplicateSuppressed);
+    return;
+  }
+  if (capture_tier_selector_) {
+    annotations[kCaptureTierAnnotation] = CaptureTierName(tier);
+  }
+  process_snapshot->SetAnnotationsSimpleMap(annotations);
+
+  // A dump requested without a crash is often taken to diagnose a hang in a
+  // process that must keep running, so the process is resumed as soon as
+  // everything needed from it has been gathered, and the minidump is written
+  // afterwards. When the snapshot reads from a clone, nothing more is needed
+  // from the process itself. Otherwise, memory contents are copied now, and
+  // the rest of the snapshot is gathered by ReportJob::Prepare(). A crashed
+  // process has nowhere to go, so it stays suspended until it is terminated,
+  // which happens once this method returns. When the minidump is written by
+  // capture_pipeline_, that may be before it has been written, so the crashed
+  // process must also be released early.
+  const bool resume_early = dump_without_crash;
+  if (resume_early || capture_pipeline_) {
+    if (clone->clone()) {
+      if (resume_early) {
+        suspend->Resume();
+        suspended_timer->Stop();
+      }
+    } else {
+      Metrics::ScopedCapturePhaseTimer memory_timer(
+          Metrics::CapturePhase::kMemoryCopy);
+      process_snapshot->MaterializeMemory();
+      phase_times->memory_copy_time = memory_timer.Stop();
     }
+  }
 
-    upload_thread_->ReportPending(uuid);
+  std::unique_ptr<ReportJob> job(
+      new ReportJob(this, std::move(process_snapshot), std::move(clone)));
+  if (!job->Prepare(client_id, dump_without_crash, tier, *phase_times)) {
+    return;
   }
 
-  Metrics::ExceptionCaptureResult(Metrics::CaptureResult::kSuccess);
-  return termination_code;
+  if (resume_early) {
+    suspend->Resume();
+    suspended_timer->Stop();
+  }
+
+  if (capture_pipeline_) {
+    capture_pipeline_->Submit(std::move(job), !dump_without_crash);
+    return;
+  }
+
+  ScopedPrioritySemaphoreWait write_slot(
+      &write_semaphore_,
+      dump_without_crash ? kNonCrashWritePriority : kCrashWritePriority);
+  if (job->Serialize()) {
+    job->Commit();
+  }
 }
 
 }  // namespace crashpad
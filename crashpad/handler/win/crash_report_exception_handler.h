@@ -18,16 +18,33 @@
 #include <windows.h>
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "base/files/file_path.h"
 #include "base/macros.h"
 #include "handler/user_stream_data_source.h"
+#include "snapshot/system_snapshot_cache.h"
+#include "util/misc/metrics.h"
+#include "util/synchronization/priority_semaphore.h"
 #include "util/win/exception_handler_server.h"
 
 namespace crashpad {
 
+class CapturePipeline;
+class CaptureTierSelector;
+class ClientDumpQuota;
+class CrashReportCompressThread;
 class CrashReportDatabase;
 class CrashReportUploadThread;
+class CrashSignatureHistory;
+class IdleMemoryTrimmer;
+class MinidumpStaticStreamCache;
+struct MinidumpCapturePhaseTimes;
+class ProcessSnapshotWin;
+class ScopedProcessClone;
+class ScopedProcessSuspend;
 
 //! \brief An exception handler that writes crash reports for exception messages
 //!     to a CrashReportDatabase.
@@ -37,7 +54,14 @@ class CrashReportExceptionHandler : public ExceptionHandlerServer::Delegate {
   //!
   //! \param[in] database The database to store crash reports in. Weak.
   //! \param[in] upload_thread The upload thread to notify when a new crash
-  //!     report is written into \a database.
+  //!     report is written into \a database. If the upload thread permits it,
+  //!     new crash reports are instead uploaded through it directly, without
+  //!     being written into \a database. Weak. `nullptr` to leave crash reports
+  //!     pending in \a database for another handler to upload.
+  //! \param[in] compress_thread The thread to hand each crash report written
+  //!     into \a database to, so that it is compressed before it is made
+  //!     pending and \a upload_thread is notified. Weak. `nullptr` to make
+  //!     crash reports pending as soon as they are written.
   //! \param[in] process_annotations A map of annotations to insert as
   //!     process-level annotations into each crash report that is written. Do
   //!     not confuse this with module-level annotations, which are under the
@@ -52,14 +76,79 @@ class CrashReportExceptionHandler : public ExceptionHandlerServer::Delegate {
   //!     crash reports. For each crash report that is written, the data sources
   //!     are called in turn. These data sources may contribute additional
   //!     minidump streams. `nullptr` if not required.
+  //! \param[in] static_stream_cache A cache used to omit streams that are
+  //!     unchanged since the previous crash report of the same process from
+  //!     crash reports written on request by a running process, as by
+  //!     CrashpadClient::DumpWithoutCrash(). Weak. `nullptr` to always write
+  //!     crash reports in full.
+  //! \param[in] signature_history The history of crash signatures used to
+  //!     collapse repeated crashes into a single report. Weak. `nullptr` to
+  //!     report every crash.
+  //! \param[in] dump_quota The quota limiting how many dumps each client may
+  //!     request without crashing. Weak. `nullptr` to take every such dump.
+  //! \param[in] idle_memory_trimmer The trimmer to notify when a crash report
+  //!     has been written, so that memory is returned to the system once the
+  //!     handler is idle. Weak. `nullptr` to never trim memory.
   CrashReportExceptionHandler(
       CrashReportDatabase* database,
       CrashReportUploadThread* upload_thread,
+      CrashReportCompressThread* compress_thread,
       const std::map<std::string, std::string>* process_annotations,
-      const UserStreamDataSources* user_stream_data_sources);
+      const UserStreamDataSources* user_stream_data_sources,
+      MinidumpStaticStreamCache* static_stream_cache,
+      CrashSignatureHistory* signature_history,
+      ClientDumpQuota* dump_quota,
+      IdleMemoryTrimmer* idle_memory_trimmer);
 
   ~CrashReportExceptionHandler() override;
 
+  //! \brief Sets the pipeline that writes crash reports once their processes
+  //!     have been released.
+  //!
+  //! Without a pipeline, each crash report is written on the thread that
+  //! captured it, and a crashed process is only terminated once its report has
+  //! been written. With one, the process is released as soon as its snapshot
+  //! no longer needs it, and the report is written by the pipeline’s worker
+  //! threads, ahead of reports for processes that didn’t crash.
+  //!
+  //! \param[in] capture_pipeline The pipeline to submit crash reports to. Weak.
+  //!     It must be running for as long as exceptions are handed to this
+  //!     object, and must be stopped before this object is destroyed. `nullptr`
+  //!     to write crash reports on the thread that captured them.
+  void SetCapturePipeline(CapturePipeline* capture_pipeline);
+
+  //! \brief Sets the time that capturing a snapshot may take before optional
+  //!     content is left out of it.
+  //!
+  //! See CaptureDeadline. The time is counted from when the handler begins to
+  //! suspend the client, and a client may replace it with
+  //! CrashpadInfo::set_capture_deadline_ms(). What was left out is recorded
+  //! in the kMinidumpStreamTypeCrashpadCapturePerformance stream.
+  //!
+  //! \param[in] capture_deadline_ms The time, in milliseconds. `0` for no
+  //!     limit, which is the default.
+  void SetCaptureDeadline(unsigned int capture_deadline_ms);
+
+  //! \brief Degrades crash reports according to the load on the system.
+  //!
+  //! Each exception is counted by \a capture_tier_selector, which picks the
+  //! CaptureTier that its report is written at, recorded in the
+  //! #kCaptureTierAnnotation process annotation. Under the heaviest load, no
+  //! report is written at all.
+  //!
+  //! \param[in] capture_tier_selector The selector to consult. Weak. `nullptr`,
+  //!     the default, to always write reports at CaptureTier::kFull.
+  void SetCaptureTierSelector(CaptureTierSelector* capture_tier_selector);
+
+  //! \brief Sets the files to attach to each crash report.
+  //!
+  //! The files are cloned into the database as each report is written, as
+  //! for CrashReportDatabase::NewReport::attachments, and uploaded from there,
+  //! or are read from where they are if the report is uploaded directly.
+  //!
+  //! \param[in] attachments The paths of the files. The default is none.
+  void SetAttachments(const std::vector<base::FilePath>& attachments);
+
   // ExceptionHandlerServer::Delegate:
 
   //! \brief Processes an exception message by writing a crash report to this
@@ -70,11 +159,87 @@ class CrashReportExceptionHandler : public ExceptionHandlerServer::Delegate {
       WinVMAddress exception_information_address,
       WinVMAddress debug_critical_section_address) override;
 
+  //! \brief Writes a crash report for a process that another process has
+  //!     asked to be dumped and terminated, with the exception fabricated at
+  //!     the current context of \a thread_id.
+  unsigned int ExceptionHandlerServerDumpAndCrash(
+      HANDLE process,
+      DWORD thread_id,
+      DWORD exception_code,
+      WinVMAddress debug_critical_section_address) override;
+
+  //! \brief Writes a report for a thread that has hung, as detected by the
+  //!     handler.
+  //!
+  //! The report is written like one requested by
+  //! CrashpadClient::DumpWithoutCrash(), with the exception at the current
+  //! context of \a thread_id, and with a #kHangDurationAnnotation process
+  //! annotation. \a process is suspended only as long as needed to capture
+  //! it.
+  //!
+  //! \param[in] process The process containing the hung thread.
+  //! \param[in] thread_id The thread that has hung.
+  //! \param[in] hang_seconds How long the thread has been hung.
+  //!
+  //! \return `true` if a snapshot of \a process was captured, `false`
+  //!     otherwise with an appropriate message logged.
+  bool DumpHungThread(HANDLE process,
+                      DWORD thread_id,
+                      unsigned int hang_seconds);
+
  private:
+  class ReportJob;
+
+  // Captures and reports an exception on behalf of
+  // ExceptionHandlerServerException() and ExceptionHandlerServerDumpAndCrash().
+  // If thread_id is nonzero, exception_information_address must be 0, and the
+  // exception is fabricated at the context of thread_id with exception_code.
+  // Returns the code that process should be terminated with.
+  unsigned int CaptureException(HANDLE process,
+                                WinVMAddress exception_information_address,
+                                WinVMAddress debug_critical_section_address,
+                                DWORD thread_id,
+                                DWORD exception_code);
+
+  // Reports the exception in process_snapshot, a snapshot of process, on behalf
+  // of CaptureException() and DumpHungThread(). clone is the
+  // clone of process that the snapshot reads from, if it has a clone() at all,
+  // and is kept until the report is written. suspended_timer is stopped if
+  // suspend is resumed early. phase_times holds the times of the phases
+  // already completed, and is recorded in the minidump file along with any
+  // that this method measures. extra_annotations are added to the process
+  // annotations, and may be nullptr. When this returns, the report may still
+  // be being written by capture_pipeline_, but it no longer needs process.
+  void ReportSnapshot(
+      HANDLE process,
+      std::unique_ptr<ProcessSnapshotWin> process_snapshot,
+      std::unique_ptr<ScopedProcessClone> clone,
+      ScopedProcessSuspend* suspend,
+      Metrics::ScopedCapturePhaseTimer* suspended_timer,
+      MinidumpCapturePhaseTimes* phase_times,
+      const std::map<std::string, std::string>* extra_annotations);
+
   CrashReportDatabase* database_;  // weak
   CrashReportUploadThread* upload_thread_;  // weak
+  CrashReportCompressThread* compress_thread_;  // weak
   const std::map<std::string, std::string>* process_annotations_;  // weak
   const UserStreamDataSources* user_stream_data_sources_;  // weak
+  MinidumpStaticStreamCache* static_stream_cache_;  // weak
+  CrashSignatureHistory* signature_history_;  // weak
+  ClientDumpQuota* dump_quota_;  // weak
+  IdleMemoryTrimmer* idle_memory_trimmer_;  // weak
+  CapturePipeline* capture_pipeline_;  // weak
+  CaptureTierSelector* capture_tier_selector_;  // weak
+  std::vector<base::FilePath> attachments_;
+  uint64_t capture_deadline_;  // nanoseconds, 0 for none
+
+  // Without capture_pipeline_, limits the number of minidumps written or
+  // uploaded at once, independently of the number of snapshots being captured.
+  PrioritySemaphore write_semaphore_;
+
+  // Shared by every crash report, so that system facts that don’t change
+  // aren’t determined again. Snapshots captured concurrently share it safely.
+  SystemSnapshotCache system_snapshot_cache_;
 
   DISALLOW_COPY_AND_ASSIGN(CrashReportExceptionHandler);
 };
@@ -0,0 +1,291 @@
+#!/usr/bin/env python
+
+# Copyright 2017 The Crashpad Authors. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Measures crash-to-upload latency through a real crashpad_handler.
+
+This starts crashpad_handler against a local HTTP sink, crashes
+crash_benchmark_client.exe into it, and reports, for each crash, the time from
+the client announcing its crash to the client being terminated (the handler
+only terminates the client once the minidump has been written to the
+database), and the time from the crash to the sink having received the whole
+upload. Handler CPU time consumed and the handler’s peak working set are
+reported alongside.
+
+With --clients greater than 1, each iteration is a crash storm: that many
+clients are started at once and crash concurrently. Uploads can’t be matched to
+individual clients, so a storm reports the time until the last upload has been
+received and the resulting throughput in reports per second.
+
+Usage: crash_upload_benchmark.py <binary_dir> [options]
+"""
+
+import BaseHTTPServer
+import SocketServer
+import argparse
+import os
+import pywintypes
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import win32api
+import win32con
+import win32pipe
+import win32process
+import winerror
+
+
+# time.clock() is the high-resolution wall clock on Windows.
+Now = time.clock
+
+
+class UploadSink(SocketServer.ThreadingMixIn, BaseHTTPServer.HTTPServer):
+  """An HTTP server that accepts any number of uploads and records the time at
+  which each one was completely received.
+  """
+
+  daemon_threads = True
+
+  def __init__(self):
+    BaseHTTPServer.HTTPServer.__init__(self, ('127.0.0.1', 0), SinkHandler)
+    self.condition = threading.Condition()
+    self.upload_times = []
+    self.upload_bytes = 0
+
+  def RecordUpload(self, size):
+    with self.condition:
+      self.upload_times.append(Now())
+      self.upload_bytes += size
+      self.condition.notify_all()
+
+  def WaitForUploads(self, count, timeout):
+    """Waits until at least |count| uploads have been received in total, and
+    returns the receipt times of all of them. Returns None on timeout.
+    """
+    deadline = Now() + timeout
+    with self.condition:
+      while len(self.upload_times) < count:
+        remaining = deadline - Now()
+        if remaining <= 0:
+          return None
+        self.condition.wait(remaining)
+      return list(self.upload_times)
+
+
+class SinkHandler(BaseHTTPServer.BaseHTTPRequestHandler):
+  def do_POST(self):
+    if self.headers.get('Transfer-Encoding', '').lower() == 'chunked':
+      size = self.ReadChunkedBody()
+    else:
+      size = len(self.rfile.read(int(self.headers.get('Content-Length', 0))))
+
+    self.server.RecordUpload(size)
+
+    self.send_response(200)
+    self.end_headers()
+    self.wfile.write('%016x\r\n' % random.getrandbits(64))
+
+  def ReadChunkedBody(self):
+    """Reads and discards a "Transfer-Encoding: chunked" body, returning its
+    decoded size. See util/net/http_transport_test_server.py.
+    """
+    size = 0
+    while True:
+      line = self.rfile.readline()
+      chunk_size = int(line.split(';')[0].strip(), 16)
+      if chunk_size == 0:
+        # Read through any trailer fields.
+        while self.rfile.readline().strip() != '':
+          pass
+        return size
+      size += len(self.rfile.read(chunk_size))
+      self.rfile.readline()
+
+  def log_request(self, code='-', size='-'):
+    # The default implementation logs these to sys.stderr, which is just noise.
+    pass
+
+
+def NamedPipeExistsAndReady(pipe_name):
+  """Returns False if pipe_name does not exist. If pipe_name does exist, blocks
+  until the pipe is ready to service clients, and then returns True. See
+  snapshot/win/end_to_end_test.py.
+  """
+  try:
+    win32pipe.WaitNamedPipe(pipe_name, win32pipe.NMPWAIT_WAIT_FOREVER)
+  except pywintypes.error, e:
+    if e[0] == winerror.ERROR_FILE_NOT_FOUND:
+      return False
+    raise
+  return True
+
+
+class HandlerUsage(object):
+  """Samples the CPU time and peak working set of a running process."""
+
+  def __init__(self, pid):
+    self.process = win32api.OpenProcess(
+        win32con.PROCESS_QUERY_INFORMATION | win32con.PROCESS_VM_READ,
+        False,
+        pid)
+
+  def CPUSeconds(self):
+    times = win32process.GetProcessTimes(self.process)
+    # These are in units of 100 nanoseconds.
+    return (times['UserTime'] + times['KernelTime']) / 1e7
+
+  def PeakWorkingSetBytes(self):
+    return win32process.GetProcessMemoryInfo(
+        self.process)['PeakWorkingSetSize']
+
+
+def CrashClients(out_dir, pipe_name, count, memory_kb, threads):
+  """Starts |count| clients at once and waits for all of them to crash and be
+  terminated by the handler. Returns a list of (crash_time, terminate_time)
+  pairs, one per client.
+  """
+  command = [os.path.join(out_dir, 'crash_benchmark_client.exe'),
+             pipe_name, str(memory_kb), str(threads)]
+  results = [None] * count
+
+  def RunClient(index):
+    client = subprocess.Popen(command, stdout=subprocess.PIPE)
+    line = client.stdout.readline()
+    crash_time = Now()
+    client.wait()
+    terminate_time = Now()
+    if line.strip() != 'crashing':
+      print >>sys.stderr, 'client %d failed before crashing' % index
+      return
+    if client.returncode in (0, 1):
+      print >>sys.stderr, 'client %d exited with %d' % (index,
+                                                         client.returncode)
+    results[index] = (crash_time, terminate_time)
+
+  runners = [threading.Thread(target=RunClient, args=(index,))
+             for index in xrange(count)]
+  for runner in runners:
+    runner.start()
+  for runner in runners:
+    runner.join()
+  return results
+
+
+def Median(values):
+  values = sorted(values)
+  return values[len(values) / 2]
+
+
+def RunBenchmark(out_dir, options, database, sink):
+  pipe_name = r'\\.\pipe\crash-upload-benchmark_%s_%s' % (
+      os.getpid(), str(random.getrandbits(64)))
+  handler = subprocess.Popen([
+      os.path.join(out_dir, 'crashpad_handler.com'),
+      '--pipe-name=' + pipe_name,
+      '--database=' + database,
+      '--url=http://127.0.0.1:%d/upload' % sink.server_address[1],
+      '--no-rate-limit',
+  ])
+
+  try:
+    while not NamedPipeExistsAndReady(pipe_name):
+      time.sleep(0.001)
+    usage = HandlerUsage(handler.pid)
+
+    print('%9s %7s %12s %12s %10s %12s' %
+          ('iteration', 'clients', 'to_disk_ms', 'to_upload_ms', 'cpu_ms',
+           'reports/s'))
+
+    to_disk = []
+    to_upload = []
+    cpu = []
+    throughput = []
+    uploads_expected = 0
+    for iteration in xrange(options.iterations):
+      cpu_before = usage.CPUSeconds()
+      results = CrashClients(out_dir, pipe_name, options.clients,
+                             options.memory_kb, options.threads)
+      if None in results:
+        return 1
+
+      uploads_expected += options.clients
+      upload_times = sink.WaitForUploads(uploads_expected, options.timeout)
+      if upload_times is None:
+        print >>sys.stderr, 'timed out waiting for uploads'
+        return 1
+      cpu_after = usage.CPUSeconds()
+
+      first_crash = min(crash for crash, _ in results)
+      last_upload = max(upload_times[-options.clients:])
+      to_disk.append(Median([terminate - crash
+                             for crash, terminate in results]))
+      to_upload.append(last_upload - first_crash)
+      cpu.append(cpu_after - cpu_before)
+      throughput.append(options.clients / (last_upload - first_crash))
+
+      print('%9d %7d %12.1f %12.1f %10.1f %12.2f' %
+            (iteration, options.clients, to_disk[-1] * 1e3,
+             to_upload[-1] * 1e3, cpu[-1] * 1e3, throughput[-1]))
+
+    print('%9s %7d %12.1f %12.1f %10.1f %12.2f' %
+          ('median', options.clients, Median(to_disk) * 1e3,
+           Median(to_upload) * 1e3, Median(cpu) * 1e3, Median(throughput)))
+    print('handler peak working set: %d kB' %
+          (usage.PeakWorkingSetBytes() / 1024))
+    print('uploaded: %d bytes' % sink.upload_bytes)
+    return 0
+  finally:
+    handler.kill()
+    handler.wait()
+
+
+def main(args):
+  parser = argparse.ArgumentParser(
+      description='Measure crash-to-upload latency through crashpad_handler.')
+  parser.add_argument('binary_dir',
+                      help='directory containing the built binaries')
+  parser.add_argument('-i', '--iterations', type=int, default=10,
+                      help='number of crashes (or storms) to measure')
+  parser.add_argument('-c', '--clients', type=int, default=1,
+                      help='clients to crash concurrently in each iteration')
+  parser.add_argument('-m', '--memory-kb', type=int, default=0,
+                      help='extra memory each client adds to its minidump')
+  parser.add_argument('-t', '--threads', type=int, default=0,
+                      help='extra threads each client starts')
+  parser.add_argument('--timeout', type=float, default=60,
+                      help='seconds to wait for uploads in each iteration')
+  options = parser.parse_args(args)
+
+  database = tempfile.mkdtemp()
+  sink = UploadSink()
+  sink_thread = threading.Thread(target=sink.serve_forever)
+  sink_thread.daemon = True
+  sink_thread.start()
+  try:
+    subprocess.check_call(
+        [os.path.join(options.binary_dir, 'crashpad_database_util.exe'),
+         '--create', '--database=' + database])
+    return RunBenchmark(options.binary_dir, options, database, sink)
+  finally:
+    sink.shutdown()
+    shutil.rmtree(database, ignore_errors=True)
+
+
+if __name__ == '__main__':
+  sys.exit(main(sys.argv[1:]))
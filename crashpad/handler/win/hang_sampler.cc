@@ -0,0 +1,175 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "handler/win/hang_sampler.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/logging.h"
+#include "handler/win/crash_report_exception_handler.h"
+#include "snapshot/win/process_reader_win.h"
+#include "util/misc/clock.h"
+
+namespace crashpad {
+
+namespace {
+
+// The number of bytes read from the top of the sampled thread’s stack. Frames
+// deeper than this do not distinguish one sample from another.
+constexpr WinVMSize kStackBytesSampled = 2048;
+
+constexpr uint64_t kNanosecondsPerSecond = 1000000000;
+
+bool IsInModule(const std::vector<ProcessInfo::Module>& modules,
+                WinVMAddress address) {
+  for (const ProcessInfo::Module& module : modules) {
+    if (address >= module.dll_base && address - module.dll_base < module.size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename Pointer>
+void AppendFrames(const std::vector<uint8_t>& stack,
+                  const std::vector<ProcessInfo::Module>& modules,
+                  std::vector<uint64_t>* frames) {
+  const Pointer* words = reinterpret_cast<const Pointer*>(stack.data());
+  const size_t word_count = stack.size() / sizeof(Pointer);
+  for (size_t index = 0;
+       index < word_count && frames->size() < HangDetector::kFramesCompared;
+       ++index) {
+    if (IsInModule(modules, words[index])) {
+      frames->push_back(words[index]);
+    }
+  }
+}
+
+}  // namespace
+
+HangSampler::HangSampler(HANDLE process,
+                         CrashReportExceptionHandler* exception_handler,
+                         double threshold_seconds,
+                         double sample_interval_seconds,
+                         WorkerThreadExecutor* executor)
+    : thread_(sample_interval_seconds, this, executor),
+      detector_(
+          static_cast<uint64_t>(threshold_seconds * kNanosecondsPerSecond)),
+      process_(),
+      exception_handler_(exception_handler) {
+  HANDLE duplicate;
+  if (!DuplicateHandle(GetCurrentProcess(),
+                       process,
+                       GetCurrentProcess(),
+                       &duplicate,
+                       0,
+                       false,
+                       DUPLICATE_SAME_ACCESS)) {
+    PLOG(ERROR) << "DuplicateHandle";
+    return;
+  }
+  process_.reset(duplicate);
+}
+
+HangSampler::~HangSampler() {}
+
+void HangSampler::Start() {
+  thread_.Start(0);
+}
+
+void HangSampler::Stop() {
+  thread_.Stop();
+}
+
+void HangSampler::DoWork(const WorkerThread* thread) {
+  if (!process_.is_valid() ||
+      WaitForSingleObject(process_.get(), 0) != WAIT_TIMEOUT) {
+    return;
+  }
+
+  HangDetector::Sample sample;
+  DWORD thread_id = 0;
+  if (!TakeSample(&sample, &thread_id)) {
+    sample.frames.clear();
+  }
+  sample.time_ns = ClockMonotonicNanoseconds();
+
+  if (detector_.AddSample(sample)) {
+    const unsigned int hang_seconds = static_cast<unsigned int>(
+        detector_.CurrentRunNanoseconds() / kNanosecondsPerSecond);
+    LOG(WARNING) << "thread " << thread_id << " hung for " << hang_seconds
+                 << " seconds";
+    exception_handler_->DumpHungThread(process_.get(), thread_id, hang_seconds);
+  }
+}
+
+bool HangSampler::TakeSample(HangDetector::Sample* sample, DWORD* thread_id) {
+  ProcessReaderWin process_reader;
+  if (!process_reader.Initialize(process_.get(),
+                                 ProcessSuspensionState::kRunning)) {
+    return false;
+  }
+
+  // The main thread is always first.
+  const std::vector<ProcessReaderWin::Thread>& threads =
+      process_reader.Threads();
+  if (threads.empty()) {
+    return false;
+  }
+  const ProcessReaderWin::Thread& thread = threads[0];
+  *thread_id = static_cast<DWORD>(thread.id);
+
+  WinVMAddress instruction_pointer;
+  WinVMAddress stack_pointer;
+#if defined(ARCH_CPU_64_BITS)
+  if (process_reader.Is64Bit()) {
+    instruction_pointer = thread.context.native.Rip;
+    stack_pointer = thread.context.native.Rsp;
+  } else {
+    instruction_pointer = thread.context.wow64.Eip;
+    stack_pointer = thread.context.wow64.Esp;
+  }
+#else
+  instruction_pointer = thread.context.native.Eip;
+  stack_pointer = thread.context.native.Esp;
+#endif  // ARCH_CPU_64_BITS
+
+  sample->frames.push_back(instruction_pointer);
+
+  const WinVMAddress stack_end =
+      thread.stack_region_address + thread.stack_region_size;
+  if (stack_pointer < thread.stack_region_address ||
+      stack_pointer >= stack_end) {
+    return true;
+  }
+
+  std::vector<uint8_t> stack(
+      std::min(kStackBytesSampled, stack_end - stack_pointer));
+  if (!process_reader.ReadMemory(stack_pointer, stack.size(), stack.data())) {
+    return true;
+  }
+
+  const std::vector<ProcessInfo::Module>& modules = process_reader.Modules();
+  if (process_reader.Is64Bit()) {
+    AppendFrames<uint64_t>(stack, modules, &sample->frames);
+  } else {
+    AppendFrames<uint32_t>(stack, modules, &sample->frames);
+  }
+  return true;
+}
+
+}  // namespace crashpad
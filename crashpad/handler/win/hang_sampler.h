@@ -0,0 +1,92 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_HANDLER_WIN_HANG_SAMPLER_H_
+#define CRASHPAD_HANDLER_WIN_HANG_SAMPLER_H_
+
+#include <windows.h>
+
+#include "base/macros.h"
+#include "handler/hang_detector.h"
+#include "util/thread/worker_thread.h"
+#include "util/win/scoped_handle.h"
+
+namespace crashpad {
+
+class CrashReportExceptionHandler;
+class WorkerThreadExecutor;
+
+//! \brief A thread that periodically samples the stack of a client’s main
+//!     thread, and writes a report when the thread appears to have hung.
+//!
+//! Each sample briefly suspends the client’s threads to read their contexts,
+//! and reads only the top of the main thread’s stack. The instruction pointer,
+//! followed by each stack word that points into a loaded module, stands in
+//! for the thread’s frames, without unwinding the stack. A HangDetector
+//! decides from these samples when the thread has hung, and a report is
+//! written through CrashReportExceptionHandler::DumpHungThread().
+//!
+//! Sampling stops having any effect once the client exits.
+class HangSampler : public WorkerThread::Delegate {
+ public:
+  //! \brief Constructs a new object.
+  //!
+  //! \param[in] process The client process to sample. The handle is
+  //!     duplicated, so it need not remain valid after this constructor
+  //!     returns.
+  //! \param[in] exception_handler The exception handler to write hang reports
+  //!     through. Weak.
+  //! \param[in] threshold_seconds How long the main thread’s frames must
+  //!     persist for it to be considered hung.
+  //! \param[in] sample_interval_seconds The time between samples.
+  //! \param[in] executor The executor to sample on, which is shared with other
+  //!     background tasks. Weak. `nullptr` to sample on a thread of its own.
+  HangSampler(HANDLE process,
+              CrashReportExceptionHandler* exception_handler,
+              double threshold_seconds,
+              double sample_interval_seconds,
+              WorkerThreadExecutor* executor);
+  ~HangSampler();
+
+  //! \brief Starts a dedicated sampling thread.
+  //!
+  //! This method may only be be called on a newly-constructed object or after
+  //! a call to Stop().
+  void Start();
+
+  //! \brief Stops the sampling thread.
+  //!
+  //! This method must only be called after Start(). If Start() has been called,
+  //! this method must be called before destroying an object of this class.
+  void Stop();
+
+ private:
+  // WorkerThread::Delegate:
+  void DoWork(const WorkerThread* thread) override;
+
+  // Samples the main thread’s stack into sample, setting thread_id to the
+  // main thread’s ID. Returns false if the sample could not be taken.
+  bool TakeSample(HangDetector::Sample* sample, DWORD* thread_id);
+
+  WorkerThread thread_;
+  HangDetector detector_;
+  ScopedKernelHANDLE process_;
+  CrashReportExceptionHandler* exception_handler_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(HangSampler);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_HANDLER_WIN_HANG_SAMPLER_H_
@@ -33,6 +33,12 @@
         '..',
       ],
       'sources': [
+        'minidump_annotation_writer.cc',
+        'minidump_annotation_writer.h',
+        'minidump_byte_array_writer.cc',
+        'minidump_byte_array_writer.h',
+        'minidump_capture_performance_writer.cc',
+        'minidump_capture_performance_writer.h',
         'minidump_context.h',
         'minidump_context_writer.cc',
         'minidump_context_writer.h',
@@ -42,10 +48,16 @@
         'minidump_exception_writer.h',
         'minidump_extensions.cc',
         'minidump_extensions.h',
+        'minidump_file_extension_stream_data_source.cc',
+        'minidump_file_extension_stream_data_source.h',
         'minidump_file_writer.cc',
         'minidump_file_writer.h',
         'minidump_handle_writer.cc',
         'minidump_handle_writer.h',
+        'minidump_memory_extension_stream_data_source.cc',
+        'minidump_memory_extension_stream_data_source.h',
+        'minidump_memory64_list_writer.cc',
+        'minidump_memory64_list_writer.h',
         'minidump_memory_info_writer.cc',
         'minidump_memory_info_writer.h',
         'minidump_memory_writer.cc',
@@ -56,20 +68,37 @@
         'minidump_module_crashpad_info_writer.h',
         'minidump_module_writer.cc',
         'minidump_module_writer.h',
+        'minidump_reconstructible_memory_writer.cc',
+        'minidump_reconstructible_memory_writer.h',
         'minidump_rva_list_writer.cc',
         'minidump_rva_list_writer.h',
         'minidump_simple_string_dictionary_writer.cc',
         'minidump_simple_string_dictionary_writer.h',
+        'minidump_size_budget.cc',
+        'minidump_size_budget.h',
+        'minidump_static_stream_cache.cc',
+        'minidump_static_stream_cache.h',
+        'minidump_stream_reference_writer.cc',
+        'minidump_stream_reference_writer.h',
         'minidump_stream_writer.cc',
         'minidump_stream_writer.h',
+        'minidump_string_table.cc',
+        'minidump_string_table.h',
         'minidump_string_writer.cc',
         'minidump_string_writer.h',
+        'minidump_struct_list.h',
         'minidump_system_info_writer.cc',
         'minidump_system_info_writer.h',
+        'minidump_thread_annotation_list_writer.cc',
+        'minidump_thread_annotation_list_writer.h',
         'minidump_thread_id_map.cc',
         'minidump_thread_id_map.h',
+        'minidump_thread_name_list_writer.cc',
+        'minidump_thread_name_list_writer.h',
         'minidump_thread_writer.cc',
         'minidump_thread_writer.h',
+        'minidump_top_frames_writer.cc',
+        'minidump_top_frames_writer.h',
         'minidump_unloaded_module_writer.cc',
         'minidump_unloaded_module_writer.h',
         'minidump_user_extension_stream_data_source.cc',
@@ -78,6 +107,8 @@
         'minidump_user_stream_writer.h',
         'minidump_writable.cc',
         'minidump_writable.h',
+        'minidump_writable_arena.cc',
+        'minidump_writable_arena.h',
         'minidump_writer_util.cc',
         'minidump_writer_util.h',
       ],
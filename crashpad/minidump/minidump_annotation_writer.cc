@@ -0,0 +1,176 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_annotation_writer.h"
+
+#include <utility>
+
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "util/file/file_writer.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+
+MinidumpAnnotationWriter::MinidumpAnnotationWriter()
+    : MinidumpWritable(), annotation_(), name_(), value_() {
+}
+
+MinidumpAnnotationWriter::~MinidumpAnnotationWriter() {
+}
+
+void MinidumpAnnotationWriter::InitializeFromSnapshot(
+    const AnnotationSnapshot& snapshot) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  InitializeWithData(snapshot.name, snapshot.type, snapshot.value);
+}
+
+void MinidumpAnnotationWriter::InitializeWithData(
+    const std::string& name,
+    uint16_t type,
+    const std::vector<uint8_t>& data) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  name_.SetUTF8(name);
+  annotation_.type = type;
+  annotation_.reserved = 0;
+  value_.set_data(data);
+}
+
+bool MinidumpAnnotationWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (!MinidumpWritable::Freeze()) {
+    return false;
+  }
+
+  name_.RegisterRVA(&annotation_.name);
+  value_.RegisterRVA(&annotation_.value);
+
+  return true;
+}
+
+size_t MinidumpAnnotationWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  // This object doesn’t directly write anything itself. Its MinidumpAnnotation
+  // is written by its parent as part of a MinidumpAnnotationList, and its
+  // children are responsible for writing themselves.
+  return 0;
+}
+
+std::vector<internal::MinidumpWritable*> MinidumpAnnotationWriter::Children() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  std::vector<MinidumpWritable*> children(1, &name_);
+  children.push_back(&value_);
+  return children;
+}
+
+bool MinidumpAnnotationWriter::WriteObject(FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  // This object doesn’t directly write anything itself. Its MinidumpAnnotation
+  // is written by its parent as part of a MinidumpAnnotationList, and its
+  // children are responsible for writing themselves.
+  return true;
+}
+
+MinidumpAnnotationListWriter::MinidumpAnnotationListWriter()
+    : MinidumpWritable(),
+      minidump_list_(new MinidumpAnnotationList()),
+      objects_() {
+}
+
+MinidumpAnnotationListWriter::~MinidumpAnnotationListWriter() {
+}
+
+void MinidumpAnnotationListWriter::InitializeFromList(
+    const std::vector<AnnotationSnapshot>& list) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(objects_.empty());
+
+  for (const auto& annotation : list) {
+    auto writer = base::WrapUnique(new MinidumpAnnotationWriter());
+    writer->InitializeFromSnapshot(annotation);
+    AddObject(std::move(writer));
+  }
+}
+
+void MinidumpAnnotationListWriter::AddObject(
+    std::unique_ptr<MinidumpAnnotationWriter> annotation_writer) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  objects_.push_back(std::move(annotation_writer));
+}
+
+bool MinidumpAnnotationListWriter::IsUseful() const {
+  return !objects_.empty();
+}
+
+bool MinidumpAnnotationListWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (!MinidumpWritable::Freeze()) {
+    return false;
+  }
+
+  size_t object_count = objects_.size();
+  if (!AssignIfInRange(&minidump_list_->count, object_count)) {
+    LOG(ERROR) << "object_count " << object_count << " out of range";
+    return false;
+  }
+
+  return true;
+}
+
+size_t MinidumpAnnotationListWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return sizeof(*minidump_list_) +
+         objects_.size() * sizeof(MinidumpAnnotation);
+}
+
+std::vector<internal::MinidumpWritable*>
+MinidumpAnnotationListWriter::Children() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  std::vector<MinidumpWritable*> children;
+  for (const auto& object : objects_) {
+    children.push_back(object.get());
+  }
+
+  return children;
+}
+
+bool MinidumpAnnotationListWriter::WriteObject(
+    FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  WritableIoVec iov;
+  iov.iov_base = minidump_list_.get();
+  iov.iov_len = sizeof(*minidump_list_);
+  std::vector<WritableIoVec> iovecs(1, iov);
+
+  for (const auto& object : objects_) {
+    iov.iov_base = object->minidump_annotation();
+    iov.iov_len = sizeof(MinidumpAnnotation);
+    iovecs.push_back(iov);
+  }
+
+  return file_writer->WriteIoVec(&iovecs);
+}
+
+}  // namespace crashpad
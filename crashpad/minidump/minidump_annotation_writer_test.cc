@@ -0,0 +1,134 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_annotation_writer.h"
+
+#include <memory>
+#include <utility>
+
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/test/minidump_string_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+const MinidumpAnnotationList* MinidumpAnnotationListAtStart(
+    const std::string& file_contents,
+    uint32_t count) {
+  MINIDUMP_LOCATION_DESCRIPTOR location_descriptor;
+  location_descriptor.DataSize = static_cast<uint32_t>(
+      sizeof(MinidumpAnnotationList) + count * sizeof(MinidumpAnnotation));
+  location_descriptor.Rva = 0;
+  return MinidumpWritableAtLocationDescriptor<MinidumpAnnotationList>(
+      file_contents, location_descriptor);
+}
+
+std::vector<uint8_t> ByteArrayAtRVA(const std::string& file_contents,
+                                    RVA rva) {
+  const MinidumpByteArray* array =
+      MinidumpWritableAtRVA<MinidumpByteArray>(file_contents, rva);
+  if (!array) {
+    return std::vector<uint8_t>();
+  }
+  EXPECT_LE(rva + sizeof(*array) + array->length, file_contents.size());
+  return std::vector<uint8_t>(array->data, array->data + array->length);
+}
+
+TEST(MinidumpAnnotationWriter, EmptyList) {
+  StringFile string_file;
+
+  MinidumpAnnotationListWriter list_writer;
+
+  EXPECT_FALSE(list_writer.IsUseful());
+
+  EXPECT_TRUE(list_writer.WriteEverything(&string_file));
+  ASSERT_EQ(string_file.string().size(), sizeof(MinidumpAnnotationList));
+
+  const MinidumpAnnotationList* list =
+      MinidumpAnnotationListAtStart(string_file.string(), 0);
+  ASSERT_TRUE(list);
+  EXPECT_EQ(list->count, 0u);
+}
+
+TEST(MinidumpAnnotationWriter, OneObject) {
+  StringFile string_file;
+
+  const char kName[] = "name";
+  const uint16_t kType = 0xBEEF;
+  const std::vector<uint8_t> kValue = {'v', 'a', 'l', 'u', 'e'};
+
+  MinidumpAnnotationListWriter list_writer;
+  auto annotation_writer = base::WrapUnique(new MinidumpAnnotationWriter());
+  annotation_writer->InitializeWithData(kName, kType, kValue);
+  list_writer.AddObject(std::move(annotation_writer));
+
+  EXPECT_TRUE(list_writer.IsUseful());
+
+  EXPECT_TRUE(list_writer.WriteEverything(&string_file));
+
+  const MinidumpAnnotationList* list =
+      MinidumpAnnotationListAtStart(string_file.string(), 1);
+  ASSERT_TRUE(list);
+  ASSERT_EQ(list->count, 1u);
+
+  EXPECT_EQ(
+      MinidumpUTF8StringAtRVAAsString(string_file.string(),
+                                      list->objects[0].name),
+      kName);
+  EXPECT_EQ(list->objects[0].type, kType);
+  EXPECT_EQ(list->objects[0].reserved, 0u);
+  EXPECT_EQ(ByteArrayAtRVA(string_file.string(), list->objects[0].value),
+            kValue);
+}
+
+TEST(MinidumpAnnotationWriter, ThreeObjects) {
+  StringFile string_file;
+
+  std::vector<AnnotationSnapshot> snapshots;
+  snapshots.push_back(AnnotationSnapshot("first", 1, {'a'}));
+  snapshots.push_back(AnnotationSnapshot("second", 3, {}));
+  snapshots.push_back(AnnotationSnapshot("third", 2, {1, 2, 3, 4, 5, 6}));
+
+  MinidumpAnnotationListWriter list_writer;
+  list_writer.InitializeFromList(snapshots);
+
+  EXPECT_TRUE(list_writer.IsUseful());
+
+  EXPECT_TRUE(list_writer.WriteEverything(&string_file));
+
+  const MinidumpAnnotationList* list =
+      MinidumpAnnotationListAtStart(string_file.string(), snapshots.size());
+  ASSERT_TRUE(list);
+  ASSERT_EQ(list->count, snapshots.size());
+
+  // Annotations are written in the order they were added.
+  for (size_t i = 0; i < snapshots.size(); ++i) {
+    SCOPED_TRACE(snapshots[i].name);
+    EXPECT_EQ(MinidumpUTF8StringAtRVAAsString(string_file.string(),
+                                              list->objects[i].name),
+              snapshots[i].name);
+    EXPECT_EQ(list->objects[i].type, snapshots[i].type);
+    EXPECT_EQ(ByteArrayAtRVA(string_file.string(), list->objects[i].value),
+              snapshots[i].value);
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
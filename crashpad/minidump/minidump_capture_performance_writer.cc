@@ -0,0 +1,195 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_capture_performance_writer.h"
+
+#include "base/logging.h"
+#include "snapshot/capture_deadline.h"
+#include "util/file/file_writer.h"
+#include "util/misc/memory_read_trace.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+
+static_assert(static_cast<uint32_t>(CaptureDeadline::kIndirectMemory) ==
+                  kMinidumpCrashpadSkippedIndirectMemory,
+              "skipped content mismatch");
+static_assert(static_cast<uint32_t>(CaptureDeadline::kHandleData) ==
+                  kMinidumpCrashpadSkippedHandleData,
+              "skipped content mismatch");
+static_assert(static_cast<uint32_t>(CaptureDeadline::kMemoryInfoList) ==
+                  kMinidumpCrashpadSkippedMemoryInfoList,
+              "skipped content mismatch");
+static_assert(static_cast<uint32_t>(CaptureDeadline::kUnloadedModules) ==
+                  kMinidumpCrashpadSkippedUnloadedModules,
+              "skipped content mismatch");
+static_assert(static_cast<uint32_t>(CaptureDeadline::kLocks) ==
+                  kMinidumpCrashpadSkippedLocks,
+              "skipped content mismatch");
+
+static_assert(static_cast<uint32_t>(MemoryReadSite::kOther) ==
+                  kMinidumpCrashpadMemoryReadOther,
+              "memory read site mismatch");
+static_assert(static_cast<uint32_t>(MemoryReadSite::kModules) ==
+                  kMinidumpCrashpadMemoryReadModules,
+              "memory read site mismatch");
+static_assert(static_cast<uint32_t>(MemoryReadSite::kAnnotations) ==
+                  kMinidumpCrashpadMemoryReadAnnotations,
+              "memory read site mismatch");
+static_assert(static_cast<uint32_t>(MemoryReadSite::kStacks) ==
+                  kMinidumpCrashpadMemoryReadStacks,
+              "memory read site mismatch");
+static_assert(static_cast<uint32_t>(MemoryReadSite::kIndirectMemory) ==
+                  kMinidumpCrashpadMemoryReadIndirectMemory,
+              "memory read site mismatch");
+static_assert(static_cast<uint32_t>(MemoryReadSite::kProcessData) ==
+                  kMinidumpCrashpadMemoryReadProcessData,
+              "memory read site mismatch");
+static_assert(static_cast<uint32_t>(MemoryReadSite::kCount) ==
+                  kMinidumpCrashpadMemoryReadSiteCount,
+              "memory read site mismatch");
+
+MinidumpCapturePerformanceWriter::MinidumpCapturePerformanceWriter()
+    : internal::MinidumpStreamWriter(),
+      capture_performance_(),
+      thread_count_(0),
+      module_count_(0),
+      memory_range_count_(0),
+      memory_read_trace_(nullptr),
+      offset_(0) {
+  capture_performance_.version = MinidumpCrashpadCapturePerformance::kVersion;
+}
+
+MinidumpCapturePerformanceWriter::~MinidumpCapturePerformanceWriter() {
+}
+
+void MinidumpCapturePerformanceWriter::SetPhaseTimes(
+    const MinidumpCapturePhaseTimes& phase_times) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  capture_performance_.suspend_time = phase_times.suspend_time;
+  capture_performance_.snapshot_time = phase_times.snapshot_time;
+  capture_performance_.memory_copy_time = phase_times.memory_copy_time;
+  capture_performance_.skipped_content = phase_times.skipped_content;
+}
+
+void MinidumpCapturePerformanceWriter::SetProcessShape(size_t thread_count,
+                                                       size_t module_count) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  thread_count_ = thread_count;
+  module_count_ = module_count;
+}
+
+void MinidumpCapturePerformanceWriter::SetMemory(size_t memory_range_count,
+                                                 uint64_t memory_size) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  memory_range_count_ = memory_range_count;
+  capture_performance_.memory_size = memory_size;
+}
+
+void MinidumpCapturePerformanceWriter::SetMemoryReadTrace(
+    const MemoryReadTrace* trace) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  memory_read_trace_ = trace;
+}
+
+bool MinidumpCapturePerformanceWriter::RewriteMemoryReads(
+    FileWriterInterface* file_writer,
+    FileOffset minidump_offset) {
+  DCHECK_EQ(state(), kStateWritten);
+
+  if (!memory_read_trace_) {
+    return true;
+  }
+
+  CopyMemoryReads();
+  return file_writer->Seek(minidump_offset + offset_, SEEK_SET) >= 0 &&
+         file_writer->Write(&capture_performance_,
+                            sizeof(capture_performance_));
+}
+
+bool MinidumpCapturePerformanceWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (!MinidumpStreamWriter::Freeze()) {
+    return false;
+  }
+
+  if (!AssignIfInRange(&capture_performance_.thread_count, thread_count_)) {
+    LOG(ERROR) << "thread_count " << thread_count_ << " out of range";
+    return false;
+  }
+
+  if (!AssignIfInRange(&capture_performance_.module_count, module_count_)) {
+    LOG(ERROR) << "module_count " << module_count_ << " out of range";
+    return false;
+  }
+
+  if (!AssignIfInRange(&capture_performance_.memory_range_count,
+                       memory_range_count_)) {
+    LOG(ERROR) << "memory_range_count " << memory_range_count_
+               << " out of range";
+    return false;
+  }
+
+  return true;
+}
+
+size_t MinidumpCapturePerformanceWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return sizeof(capture_performance_);
+}
+
+bool MinidumpCapturePerformanceWriter::WillWriteAtOffsetImpl(
+    FileOffset offset) {
+  DCHECK_EQ(state(), kStateFrozen);
+
+  offset_ = offset;
+  return MinidumpStreamWriter::WillWriteAtOffsetImpl(offset);
+}
+
+bool MinidumpCapturePerformanceWriter::WriteObject(
+    FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  if (memory_read_trace_) {
+    CopyMemoryReads();
+  }
+
+  return file_writer->Write(&capture_performance_,
+                            sizeof(capture_performance_));
+}
+
+MinidumpStreamType MinidumpCapturePerformanceWriter::StreamType() const {
+  return kMinidumpStreamTypeCrashpadCapturePerformance;
+}
+
+void MinidumpCapturePerformanceWriter::CopyMemoryReads() {
+  for (size_t index = 0; index < kMinidumpCrashpadMemoryReadSiteCount;
+       ++index) {
+    MemoryReadTrace::Counts counts = memory_read_trace_->CountsForSite(
+        static_cast<MemoryReadSite>(index));
+    MinidumpCrashpadMemoryReads& reads =
+        capture_performance_.memory_reads[index];
+    reads.call_count = counts.calls;
+    reads.byte_count = counts.bytes;
+    reads.time = counts.nanoseconds;
+  }
+}
+
+}  // namespace crashpad
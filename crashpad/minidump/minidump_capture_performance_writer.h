@@ -0,0 +1,137 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_CAPTURE_PERFORMANCE_WRITER_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_CAPTURE_PERFORMANCE_WRITER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "base/macros.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_stream_writer.h"
+#include "util/file/file_io.h"
+
+namespace crashpad {
+
+class MemoryReadTrace;
+
+//! \brief How long the phases of capturing a snapshot took, in nanoseconds.
+//!
+//! Phases that were not measured, or did not take place, are `0`.
+struct MinidumpCapturePhaseTimes {
+  MinidumpCapturePhaseTimes()
+      : suspend_time(0),
+        snapshot_time(0),
+        memory_copy_time(0),
+        skipped_content(0) {}
+
+  //! \brief See MinidumpCrashpadCapturePerformance::suspend_time.
+  uint64_t suspend_time;
+
+  //! \brief See MinidumpCrashpadCapturePerformance::snapshot_time.
+  uint64_t snapshot_time;
+
+  //! \brief See MinidumpCrashpadCapturePerformance::memory_copy_time.
+  uint64_t memory_copy_time;
+
+  //! \brief See MinidumpCrashpadCapturePerformance::skipped_content.
+  uint32_t skipped_content;
+};
+
+//! \brief The writer for a MinidumpCrashpadCapturePerformance stream in a
+//!     minidump file.
+class MinidumpCapturePerformanceWriter final
+    : public internal::MinidumpStreamWriter {
+ public:
+  MinidumpCapturePerformanceWriter();
+  ~MinidumpCapturePerformanceWriter() override;
+
+  //! \brief Sets the times recorded for each phase of the capture.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetPhaseTimes(const MinidumpCapturePhaseTimes& phase_times);
+
+  //! \brief Sets MinidumpCrashpadCapturePerformance::thread_count and
+  //!     MinidumpCrashpadCapturePerformance::module_count.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetProcessShape(size_t thread_count, size_t module_count);
+
+  //! \brief Sets MinidumpCrashpadCapturePerformance::memory_range_count and
+  //!     MinidumpCrashpadCapturePerformance::memory_size.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetMemory(size_t memory_range_count, uint64_t memory_size);
+
+  //! \brief Sets the trace from which
+  //!     MinidumpCrashpadCapturePerformance::memory_reads is taken.
+  //!
+  //! The reads counted by \a trace are copied when the stream is written, and
+  //! again by RewriteMemoryReads().
+  //!
+  //! \param[in] trace The trace counting the reads of the process’ memory.
+  //!     This object does not take ownership of \a trace, which must outlive
+  //!     it.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetMemoryReadTrace(const MemoryReadTrace* trace);
+
+  //! \brief Writes the stream again in place, carrying the reads counted by
+  //!     the trace set by SetMemoryReadTrace() so far.
+  //!
+  //! This is intended to be called once the entire minidump file has been
+  //! written, so that the stream accounts for the memory read from the process
+  //! while the file was being written, such as thread stacks. The position of
+  //! \a file_writer is left unspecified.
+  //!
+  //! \param[in] file_writer The file writer that the stream was written to.
+  //!     It must be able to seek.
+  //! \param[in] minidump_offset The offset in \a file_writer at which the
+  //!     minidump file begins.
+  //!
+  //! \return `true` on success. `false` on failure, with an appropriate message
+  //!     logged.
+  //!
+  //! \note Valid in #kStateWritten.
+  bool RewriteMemoryReads(FileWriterInterface* file_writer,
+                          FileOffset minidump_offset);
+
+ protected:
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t SizeOfObject() override;
+  bool WillWriteAtOffsetImpl(FileOffset offset) override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+
+  // MinidumpStreamWriter:
+  MinidumpStreamType StreamType() const override;
+
+ private:
+  // Copies the reads counted by memory_read_trace_ into capture_performance_.
+  void CopyMemoryReads();
+
+  MinidumpCrashpadCapturePerformance capture_performance_;
+  size_t thread_count_;
+  size_t module_count_;
+  size_t memory_range_count_;
+  const MemoryReadTrace* memory_read_trace_;  // weak
+  FileOffset offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpCapturePerformanceWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_CAPTURE_PERFORMANCE_WRITER_H_
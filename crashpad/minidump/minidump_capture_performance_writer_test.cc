@@ -0,0 +1,300 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_capture_performance_writer.h"
+
+#include <windows.h>
+#include <dbghelp.h>
+
+#include <string>
+#include <utility>
+
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/test/minidump_file_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "snapshot/test/test_cpu_context.h"
+#include "snapshot/test/test_memory_snapshot.h"
+#include "snapshot/test/test_module_snapshot.h"
+#include "snapshot/test/test_process_snapshot.h"
+#include "snapshot/test/test_system_snapshot.h"
+#include "snapshot/test/test_thread_snapshot.h"
+#include "util/file/string_file.h"
+#include "util/misc/memory_read_trace.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+const MinidumpCrashpadCapturePerformance* GetCapturePerformanceStream(
+    const std::string& file_contents) {
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(file_contents, &directory);
+  EXPECT_TRUE(header);
+  if (!header || !directory) {
+    return nullptr;
+  }
+
+  for (size_t index = 0; index < header->NumberOfStreams; ++index) {
+    if (directory[index].StreamType ==
+        kMinidumpStreamTypeCrashpadCapturePerformance) {
+      return MinidumpWritableAtLocationDescriptor<
+          MinidumpCrashpadCapturePerformance>(file_contents,
+                                              directory[index].Location);
+    }
+  }
+
+  return nullptr;
+}
+
+// A memory snapshot that records a read of its data, as a snapshot of another
+// process’ memory would.
+class TracedMemorySnapshot final : public MemorySnapshot {
+ public:
+  TracedMemorySnapshot(uint64_t address, size_t size) : memory_() {
+    memory_.SetAddress(address);
+    memory_.SetSize(size);
+    memory_.SetValue('t');
+  }
+
+  ~TracedMemorySnapshot() override {}
+
+  // MemorySnapshot:
+  uint64_t Address() const override { return memory_.Address(); }
+  size_t Size() const override { return memory_.Size(); }
+  bool Read(Delegate* delegate) const override {
+    {
+      ScopedMemoryRead read(Size());
+    }
+    return memory_.Read(delegate);
+  }
+  const MemorySnapshot* MergeWithOtherSnapshot(
+      const MemorySnapshot* other) const override {
+    return nullptr;
+  }
+
+ private:
+  TestMemorySnapshot memory_;
+
+  DISALLOW_COPY_AND_ASSIGN(TracedMemorySnapshot);
+};
+
+TEST(MinidumpCapturePerformanceWriter, Empty) {
+  MinidumpFileWriter minidump_file_writer;
+  ASSERT_TRUE(minidump_file_writer.AddStream(
+      base::WrapUnique(new MinidumpCapturePerformanceWriter())));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpCrashpadCapturePerformance* capture_performance =
+      GetCapturePerformanceStream(string_file.string());
+  ASSERT_TRUE(capture_performance);
+
+  EXPECT_EQ(capture_performance->version,
+            MinidumpCrashpadCapturePerformance::kVersion);
+  EXPECT_EQ(capture_performance->thread_count, 0u);
+  EXPECT_EQ(capture_performance->module_count, 0u);
+  EXPECT_EQ(capture_performance->memory_range_count, 0u);
+  EXPECT_EQ(capture_performance->memory_size, 0u);
+  EXPECT_EQ(capture_performance->suspend_time, 0u);
+  EXPECT_EQ(capture_performance->snapshot_time, 0u);
+  EXPECT_EQ(capture_performance->memory_copy_time, 0u);
+  EXPECT_EQ(capture_performance->skipped_content, 0u);
+  for (const MinidumpCrashpadMemoryReads& reads :
+       capture_performance->memory_reads) {
+    EXPECT_EQ(reads.call_count, 0u);
+    EXPECT_EQ(reads.byte_count, 0u);
+    EXPECT_EQ(reads.time, 0u);
+  }
+}
+
+TEST(MinidumpCapturePerformanceWriter, Values) {
+  MinidumpCapturePhaseTimes phase_times;
+  phase_times.suspend_time = 1000;
+  phase_times.snapshot_time = 20000000;
+  phase_times.memory_copy_time = 300000;
+  phase_times.skipped_content = kMinidumpCrashpadSkippedHandleData |
+                                kMinidumpCrashpadSkippedLocks;
+
+  auto capture_performance_writer =
+      base::WrapUnique(new MinidumpCapturePerformanceWriter());
+  capture_performance_writer->SetPhaseTimes(phase_times);
+  capture_performance_writer->SetProcessShape(12, 34);
+  capture_performance_writer->SetMemory(56, 0x123456789);
+
+  MinidumpFileWriter minidump_file_writer;
+  ASSERT_TRUE(
+      minidump_file_writer.AddStream(std::move(capture_performance_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpCrashpadCapturePerformance* capture_performance =
+      GetCapturePerformanceStream(string_file.string());
+  ASSERT_TRUE(capture_performance);
+
+  EXPECT_EQ(capture_performance->thread_count, 12u);
+  EXPECT_EQ(capture_performance->module_count, 34u);
+  EXPECT_EQ(capture_performance->memory_range_count, 56u);
+  EXPECT_EQ(capture_performance->memory_size, 0x123456789u);
+  EXPECT_EQ(capture_performance->suspend_time, phase_times.suspend_time);
+  EXPECT_EQ(capture_performance->snapshot_time, phase_times.snapshot_time);
+  EXPECT_EQ(capture_performance->memory_copy_time,
+            phase_times.memory_copy_time);
+  EXPECT_EQ(capture_performance->skipped_content,
+            phase_times.skipped_content);
+}
+
+TEST(MinidumpCapturePerformanceWriter, InitializeFromSnapshot) {
+  TestProcessSnapshot process_snapshot;
+
+  auto system_snapshot = base::WrapUnique(new TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemMacOSX);
+  process_snapshot.SetSystem(std::move(system_snapshot));
+
+  auto thread_snapshot = base::WrapUnique(new TestThreadSnapshot());
+  InitializeCPUContextX86_64(thread_snapshot->MutableContext(), 5);
+  auto stack = base::WrapUnique(new TestMemorySnapshot());
+  stack->SetAddress(0x7fff0000);
+  stack->SetSize(0x3000);
+  stack->SetValue('s');
+  thread_snapshot->SetStack(std::move(stack));
+  process_snapshot.AddThread(std::move(thread_snapshot));
+
+  process_snapshot.AddModule(base::WrapUnique(new TestModuleSnapshot()));
+  process_snapshot.AddModule(base::WrapUnique(new TestModuleSnapshot()));
+
+  // These two abut, and are coalesced into one range.
+  for (size_t index = 0; index < 2; ++index) {
+    auto memory_snapshot = base::WrapUnique(new TestMemorySnapshot());
+    memory_snapshot->SetAddress(0x10000000 + index * 0x100);
+    memory_snapshot->SetSize(0x100);
+    memory_snapshot->SetValue('m');
+    process_snapshot.AddExtraMemory(std::move(memory_snapshot));
+  }
+
+  MinidumpCapturePhaseTimes phase_times;
+  phase_times.suspend_time = 1;
+  phase_times.snapshot_time = 2;
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetCapturePhaseTimes(phase_times);
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpCrashpadCapturePerformance* capture_performance =
+      GetCapturePerformanceStream(string_file.string());
+  ASSERT_TRUE(capture_performance);
+
+  EXPECT_EQ(capture_performance->thread_count, 1u);
+  EXPECT_EQ(capture_performance->module_count, 2u);
+  EXPECT_EQ(capture_performance->memory_range_count, 2u);
+  EXPECT_EQ(capture_performance->memory_size, 0x3200u);
+  EXPECT_EQ(capture_performance->suspend_time, 1u);
+  EXPECT_EQ(capture_performance->snapshot_time, 2u);
+  EXPECT_EQ(capture_performance->memory_copy_time, 0u);
+}
+
+TEST(MinidumpCapturePerformanceWriter, MemoryReads) {
+  TestProcessSnapshot process_snapshot;
+
+  auto system_snapshot = base::WrapUnique(new TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemMacOSX);
+  process_snapshot.SetSystem(std::move(system_snapshot));
+
+  auto thread_snapshot = base::WrapUnique(new TestThreadSnapshot());
+  InitializeCPUContextX86_64(thread_snapshot->MutableContext(), 5);
+  thread_snapshot->SetStack(
+      base::WrapUnique(new TracedMemorySnapshot(0x7fff0000, 0x3000)));
+  thread_snapshot->AddExtraMemory(
+      base::WrapUnique(new TracedMemorySnapshot(0x20000000, 0x100)));
+  process_snapshot.AddThread(std::move(thread_snapshot));
+
+  process_snapshot.AddExtraMemory(
+      base::WrapUnique(new TracedMemorySnapshot(0x10000000, 0x200)));
+
+  MemoryReadTrace trace;
+  ScopedMemoryReadTrace installed_trace(&trace);
+
+  // A read made while the snapshot was taken.
+  {
+    ScopedMemoryReadSite read_site(MemoryReadSite::kModules);
+    ScopedMemoryRead read(0x40);
+  }
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetCapturePhaseTimes(MinidumpCapturePhaseTimes());
+  minidump_file_writer.SetMemoryReadTrace(&trace);
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpCrashpadCapturePerformance* capture_performance =
+      GetCapturePerformanceStream(string_file.string());
+  ASSERT_TRUE(capture_performance);
+
+  // The memory is read as it’s written, after the stream itself, and is only
+  // accounted for because the stream is rewritten afterwards.
+  const MinidumpCrashpadMemoryReads* reads =
+      capture_performance->memory_reads;
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadModules].call_count, 1u);
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadModules].byte_count, 0x40u);
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadStacks].call_count, 1u);
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadStacks].byte_count, 0x3000u);
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadIndirectMemory].call_count, 1u);
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadIndirectMemory].byte_count,
+            0x100u);
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadProcessData].call_count, 1u);
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadProcessData].byte_count, 0x200u);
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadOther].call_count, 0u);
+  EXPECT_EQ(reads[kMinidumpCrashpadMemoryReadAnnotations].call_count, 0u);
+
+  for (size_t index = 0; index < kMinidumpCrashpadMemoryReadSiteCount;
+       ++index) {
+    MemoryReadTrace::Counts counts =
+        trace.CountsForSite(static_cast<MemoryReadSite>(index));
+    EXPECT_EQ(reads[index].call_count, counts.calls);
+    EXPECT_EQ(reads[index].byte_count, counts.bytes);
+    EXPECT_EQ(reads[index].time, counts.nanoseconds);
+  }
+}
+
+TEST(MinidumpCapturePerformanceWriter, NotRequested) {
+  TestProcessSnapshot process_snapshot;
+  auto system_snapshot = base::WrapUnique(new TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemMacOSX);
+  process_snapshot.SetSystem(std::move(system_snapshot));
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  EXPECT_FALSE(GetCapturePerformanceStream(string_file.string()));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
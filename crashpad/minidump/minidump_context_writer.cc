@@ -19,10 +19,14 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
+
 #include "base/compiler_specific.h"
 #include "base/logging.h"
+#include "base/macros.h"
 #include "snapshot/cpu_context.h"
 #include "util/file/file_writer.h"
+#include "util/numeric/safe_assignment.h"
 
 namespace crashpad {
 
@@ -152,6 +156,12 @@ size_t MinidumpContextX86Writer::ContextSize() const {
   return sizeof(context_);
 }
 
+const void* MinidumpContextX86Writer::ContextData() const {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return &context_;
+}
+
 MinidumpContextAMD64Writer::MinidumpContextAMD64Writer()
     : MinidumpContextWriter(), context_() {
   context_.context_flags = kMinidumpContextAMD64;
@@ -220,4 +230,139 @@ size_t MinidumpContextAMD64Writer::ContextSize() const {
   return sizeof(context_);
 }
 
+const void* MinidumpContextAMD64Writer::ContextData() const {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return &context_;
+}
+
+namespace internal {
+
+MinidumpContextListWriter::MinidumpContextListWriter()
+    : MinidumpWritable(),
+      contexts_(),
+      location_descriptors_(),
+      entry_offsets_(),
+      size_(0),
+      alignment_(0) {
+}
+
+MinidumpContextListWriter::~MinidumpContextListWriter() {
+}
+
+void MinidumpContextListWriter::AddContext(
+    MinidumpContextWriter* context,
+    MINIDUMP_LOCATION_DESCRIPTOR* location_descriptor) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  contexts_.push_back(context);
+  location_descriptors_.push_back(location_descriptor);
+}
+
+bool MinidumpContextListWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (!MinidumpWritable::Freeze()) {
+    return false;
+  }
+
+  // The contexts aren’t children of this object, because they don’t write
+  // themselves, but they still need to be frozen to report their sizes.
+  for (MinidumpContextWriter* context : contexts_) {
+    if (!context->Freeze()) {
+      return false;
+    }
+  }
+
+  LayOut();
+  return true;
+}
+
+void MinidumpContextListWriter::LayOut() {
+  DCHECK_EQ(state(), kStateFrozen);
+  DCHECK(entry_offsets_.empty());
+
+  size_t offset = 0;
+  for (MinidumpContextWriter* context : contexts_) {
+    const size_t alignment = context->Alignment();
+    alignment_ = std::max(alignment_, alignment);
+    offset += (alignment - (offset % alignment)) % alignment;
+    entry_offsets_.push_back(offset);
+    offset += context->ContextSize();
+  }
+
+  size_ = offset;
+}
+
+size_t MinidumpContextListWriter::Alignment() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return std::max(alignment_, MinidumpWritable::Alignment());
+}
+
+size_t MinidumpContextListWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return size_;
+}
+
+bool MinidumpContextListWriter::WillWriteAtOffsetImpl(FileOffset offset) {
+  DCHECK_EQ(state(), kStateFrozen);
+
+  for (size_t index = 0; index < contexts_.size(); ++index) {
+    const FileOffset entry_offset = offset + entry_offsets_[index];
+    MINIDUMP_LOCATION_DESCRIPTOR* location_descriptor =
+        location_descriptors_[index];
+    if (!AssignIfInRange(&location_descriptor->Rva, entry_offset)) {
+      LOG(ERROR) << "offset " << entry_offset << " out of range";
+      return false;
+    }
+
+    const size_t context_size = contexts_[index]->ContextSize();
+    if (!AssignIfInRange(&location_descriptor->DataSize, context_size)) {
+      LOG(ERROR) << "size " << context_size << " out of range";
+      return false;
+    }
+  }
+
+  return MinidumpWritable::WillWriteAtOffsetImpl(offset);
+}
+
+bool MinidumpContextListWriter::WriteObject(FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  if (contexts_.empty()) {
+    return true;
+  }
+
+  // Any padding is less than the largest alignment of any context, which is
+  // that of MinidumpContextAMD64.
+  static constexpr uint8_t kZeroes[15] = {};
+
+  std::vector<WritableIoVec> iovecs;
+  size_t offset = 0;
+  for (size_t index = 0; index < contexts_.size(); ++index) {
+    const size_t padding = entry_offsets_[index] - offset;
+    if (padding) {
+      DCHECK_LE(padding, arraysize(kZeroes));
+      WritableIoVec iov;
+      iov.iov_base = kZeroes;
+      iov.iov_len = padding;
+      iovecs.push_back(iov);
+    }
+
+    const MinidumpContextWriter* context = contexts_[index];
+    WritableIoVec iov;
+    iov.iov_base = context->ContextData();
+    iov.iov_len = context->ContextSize();
+    iovecs.push_back(iov);
+
+    offset = entry_offsets_[index] + iov.iov_len;
+  }
+
+  return file_writer->WriteIoVec(&iovecs);
+}
+
+}  // namespace internal
+
 }  // namespace crashpad
@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 
+#include "base/macros.h"
 #include "gtest/gtest.h"
 #include "minidump/minidump_context.h"
 #include "minidump/test/minidump_context_test_util.h"
@@ -152,6 +153,62 @@ TEST(MinidumpContextWriter, CreateFromSnapshot_AMD64) {
   ExpectMinidumpContextAMD64(kSeed, observed, true);
 }
 
+TEST(MinidumpContextWriter, MinidumpContextListWriter) {
+  constexpr uint32_t kSeedX86 = 0x8086;
+  constexpr uint32_t kSeedAMD64 = 0x808664;
+
+  MinidumpContextX86Writer context_x86_writer;
+  InitializeMinidumpContextX86(context_x86_writer.context(), kSeedX86);
+  MinidumpContextAMD64Writer context_amd64_writers[2];
+  InitializeMinidumpContextAMD64(context_amd64_writers[0].context(),
+                                 kSeedAMD64);
+  InitializeMinidumpContextAMD64(context_amd64_writers[1].context(),
+                                 kSeedAMD64 + 1);
+
+  MINIDUMP_LOCATION_DESCRIPTOR location_descriptors[3] = {};
+  internal::MinidumpContextListWriter context_list_writer;
+  EXPECT_TRUE(context_list_writer.IsEmpty());
+  context_list_writer.AddContext(&context_x86_writer,
+                                 &location_descriptors[0]);
+  context_list_writer.AddContext(&context_amd64_writers[0],
+                                 &location_descriptors[1]);
+  context_list_writer.AddContext(&context_amd64_writers[1],
+                                 &location_descriptors[2]);
+  EXPECT_FALSE(context_list_writer.IsEmpty());
+
+  StringFile string_file;
+  ASSERT_TRUE(context_list_writer.WriteEverything(&string_file));
+
+  // The MinidumpContextAMD64 structures follow the MinidumpContextX86 back to
+  // back, after padding to their 16-byte alignment.
+  constexpr size_t kAMD64Offset = (sizeof(MinidumpContextX86) + 15) & ~15;
+  ASSERT_EQ(string_file.string().size(),
+            kAMD64Offset + 2 * sizeof(MinidumpContextAMD64));
+
+  EXPECT_EQ(location_descriptors[0].Rva, 0u);
+  EXPECT_EQ(location_descriptors[0].DataSize, sizeof(MinidumpContextX86));
+  EXPECT_EQ(location_descriptors[1].Rva, kAMD64Offset);
+  EXPECT_EQ(location_descriptors[1].DataSize, sizeof(MinidumpContextAMD64));
+  EXPECT_EQ(location_descriptors[2].Rva,
+            kAMD64Offset + sizeof(MinidumpContextAMD64));
+  EXPECT_EQ(location_descriptors[2].DataSize, sizeof(MinidumpContextAMD64));
+
+  const MinidumpContextX86* observed_x86 =
+      MinidumpWritableAtLocationDescriptor<MinidumpContextX86>(
+          string_file.string(), location_descriptors[0]);
+  ASSERT_TRUE(observed_x86);
+  ExpectMinidumpContextX86(kSeedX86, observed_x86, false);
+
+  for (size_t index = 0; index < arraysize(context_amd64_writers); ++index) {
+    SCOPED_TRACE(index);
+    const MinidumpContextAMD64* observed_amd64 =
+        MinidumpWritableAtLocationDescriptor<MinidumpContextAMD64>(
+            string_file.string(), location_descriptors[index + 1]);
+    ASSERT_TRUE(observed_amd64);
+    ExpectMinidumpContextAMD64(kSeedAMD64 + index, observed_amd64, false);
+  }
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
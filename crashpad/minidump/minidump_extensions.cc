@@ -18,5 +18,9 @@ namespace crashpad {
 
 constexpr uint32_t MinidumpModuleCrashpadInfo::kVersion;
 constexpr uint32_t MinidumpCrashpadInfo::kVersion;
+constexpr uint32_t MinidumpCrashpadTopFrame::kNoModule;
+constexpr uint32_t MinidumpCrashpadTopFrameList::kVersion;
+constexpr uint32_t MinidumpCrashpadStreamIndexFooter::kSignature;
+constexpr uint32_t MinidumpCrashpadStreamIndexFooter::kVersion;
 
 }  // namespace crashpad
@@ -71,6 +71,11 @@ enum MinidumpStreamType : uint32_t {
   //! \sa SystemInfoStream
   kMinidumpStreamTypeSystemInfo = SystemInfoStream,
 
+  //! \brief The stream type for MINIDUMP_MEMORY64_LIST.
+  //!
+  //! \sa Memory64ListStream
+  kMinidumpStreamTypeMemory64List = Memory64ListStream,
+
   //! \brief The stream type for MINIDUMP_HANDLE_DATA_STREAM.
   //!
   //! \sa HandleDataStream
@@ -92,10 +97,30 @@ enum MinidumpStreamType : uint32_t {
   //! \sa MemoryInfoListStream
   kMinidumpStreamTypeMemoryInfoList = MemoryInfoListStream,
 
+  //! \brief The stream type for MINIDUMP_THREAD_NAME_LIST.
+  //!
+  //! \sa ThreadNamesStream
+  kMinidumpStreamTypeThreadNameList = ThreadNamesStream,
+
   // 0x4350 = "CP"
 
   //! \brief The stream type for MinidumpCrashpadInfo.
   kMinidumpStreamTypeCrashpadInfo = 0x43500001,
+
+  //! \brief The stream type for MinidumpCrashpadStreamReferenceList.
+  kMinidumpStreamTypeCrashpadStreamReferenceList = 0x43500002,
+
+  //! \brief The stream type for MinidumpThreadAnnotationList.
+  kMinidumpStreamTypeCrashpadThreadAnnotations = 0x43500003,
+
+  //! \brief The stream type for MinidumpCrashpadCapturePerformance.
+  kMinidumpStreamTypeCrashpadCapturePerformance = 0x43500004,
+
+  //! \brief The stream type for MinidumpCrashpadReconstructibleMemoryList.
+  kMinidumpStreamTypeCrashpadReconstructibleMemoryList = 0x43500005,
+
+  //! \brief The stream type for MinidumpCrashpadTopFrameList.
+  kMinidumpStreamTypeCrashpadTopFrames = 0x43500006,
 };
 
 //! \brief A variable-length UTF-8-encoded string carried within a minidump
@@ -118,6 +143,17 @@ struct ALIGNAS(4) PACKED MinidumpUTF8String {
   uint8_t Buffer[0];
 };
 
+//! \brief A variable-length array of bytes carried within a minidump file.
+//!     The data have no intrinsic type and should be interpreted according
+//!     to their referencing context.
+struct ALIGNAS(4) PACKED MinidumpByteArray {
+  //! \brief The length of the #data field.
+  uint32_t length;
+
+  //! \brief The bytes of data.
+  uint8_t data[0];
+};
+
 //! \brief CPU type values for MINIDUMP_SYSTEM_INFO::ProcessorArchitecture.
 //!
 //! \sa \ref PROCESSOR_ARCHITECTURE_x "PROCESSOR_ARCHITECTURE_*"
@@ -271,6 +307,59 @@ struct ALIGNAS(4) PACKED MinidumpSimpleStringDictionary {
   MinidumpSimpleStringDictionaryEntry entries[0];
 };
 
+//! \brief A typed annotation object.
+struct ALIGNAS(4) PACKED MinidumpAnnotation {
+  //! \brief ::RVA of a MinidumpUTF8String containing the name of the
+  //!     annotation.
+  RVA name;
+
+  //! \brief The type of data stored in the #value of the annotation. This may
+  //!     correspond to an Annotation::Type.
+  uint16_t type;
+
+  //! \brief This field is always `0`.
+  uint16_t reserved;
+
+  //! \brief ::RVA of a MinidumpByteArray containing the value of the
+  //!     annotation.
+  RVA value;
+};
+
+//! \brief A list of typed annotation objects.
+struct ALIGNAS(4) PACKED MinidumpAnnotationList {
+  //! \brief The number of annotation objects present.
+  uint32_t count;
+
+  //! \brief A list of MinidumpAnnotation objects.
+  MinidumpAnnotation objects[0];
+};
+
+//! \brief The typed annotations set by a single thread.
+struct ALIGNAS(4) PACKED MinidumpThreadAnnotation {
+  //! \brief The ID of the thread that set the annotations.
+  //!
+  //! This field corresponds to MINIDUMP_THREAD::ThreadId in the thread list
+  //! stream (::kMinidumpStreamTypeThreadList).
+  uint32_t thread_id;
+
+  //! \brief A MinidumpAnnotationList of the thread’s typed annotations.
+  //!
+  //! These annotations correspond to the values of
+  //! ModuleSnapshot::ThreadAnnotationObjects() for this thread, merged across
+  //! all modules.
+  MINIDUMP_LOCATION_DESCRIPTOR annotation_objects;
+};
+
+//! \brief A list of per-thread typed annotations, carried in a stream of type
+//!     ::kMinidumpStreamTypeCrashpadThreadAnnotations.
+struct ALIGNAS(4) PACKED MinidumpThreadAnnotationList {
+  //! \brief The number of threads present.
+  uint32_t count;
+
+  //! \brief A list of MinidumpThreadAnnotation objects.
+  MinidumpThreadAnnotation threads[0];
+};
+
 //! \brief Additional Crashpad-specific information about a module carried
 //!     within a minidump file.
 //!
@@ -290,7 +379,7 @@ struct ALIGNAS(4) PACKED MinidumpModuleCrashpadInfo {
   //! \brief The structure’s currently-defined version number.
   //!
   //! \sa version
-  static constexpr uint32_t kVersion = 1;
+  static constexpr uint32_t kVersion = 2;
 
   //! \brief The structure’s version number.
   //!
@@ -321,6 +410,15 @@ struct ALIGNAS(4) PACKED MinidumpModuleCrashpadInfo {
   //!
   //! This field is present when #version is at least `1`.
   MINIDUMP_LOCATION_DESCRIPTOR simple_annotations;
+
+  //! \brief A MinidumpAnnotationList of typed annotations. The module controls
+  //!     the data that appears here.
+  //!
+  //! These annotations correspond to ModuleSnapshot::AnnotationObjects() and
+  //! do not duplicate anything in #list_annotations or #simple_annotations.
+  //!
+  //! This field is present when #version is at least `2`.
+  MINIDUMP_LOCATION_DESCRIPTOR annotation_objects;
 };
 
 //! \brief A link between a MINIDUMP_MODULE structure and additional
@@ -438,6 +536,361 @@ struct ALIGNAS(4) PACKED MinidumpCrashpadInfo {
   MINIDUMP_LOCATION_DESCRIPTOR module_list;
 };
 
+//! \brief A reference to a stream carried by a different minidump file.
+//!
+//! \sa MinidumpCrashpadStreamReferenceList
+struct ALIGNAS(4) PACKED MinidumpCrashpadStreamReference {
+  //! \brief The type of the stream that was omitted from this minidump file,
+  //!     a value of ::MinidumpStreamType.
+  uint32_t stream_type;
+
+  //! \brief The MinidumpCrashpadInfo::report_id of the minidump file that
+  //!     carries the stream.
+  UUID base_report_id;
+};
+
+//! \brief A list of streams omitted from a minidump file because they are
+//!     identical to streams carried by earlier minidump files.
+//!
+//! A minidump file containing this structure is a delta: each listed stream
+//! type is absent from its MINIDUMP_DIRECTORY, and would have carried the same
+//! data as the stream of that type in the minidump file identified by
+//! MinidumpCrashpadStreamReference::base_report_id. That earlier minidump file
+//! was captured from the same process, and carries the stream in full.
+//!
+//! This structure is followed immediately by #count
+//! MinidumpCrashpadStreamReference structures.
+struct ALIGNAS(4) PACKED MinidumpCrashpadStreamReferenceList {
+  //! \brief The number of MinidumpCrashpadStreamReference structures that
+  //!     follow this structure.
+  uint32_t count;
+};
+
+//! \brief A range of memory omitted from a minidump file because it can be
+//!     reconstructed from the module file that it was mapped from.
+//!
+//! \sa MinidumpCrashpadReconstructibleMemoryList
+struct ALIGNAS(4) PACKED MinidumpCrashpadReconstructibleMemoryRange {
+  //! \brief The base address of the memory range in the process’ address
+  //!     space.
+  uint64_t start_of_memory_range;
+
+  //! \brief The size of the memory range, in bytes.
+  uint64_t data_size;
+
+  //! \brief The index of the module that the memory range belongs to, in the
+  //!     module list stream (::kMinidumpStreamTypeModuleList).
+  uint32_t module_index;
+
+  //! \brief The offset of #start_of_memory_range from the module’s base
+  //!     address, MINIDUMP_MODULE::BaseOfImage.
+  uint64_t module_offset;
+};
+
+//! \brief A list of memory ranges omitted from a minidump file because they
+//!     can be reconstructed from the module files that they were mapped from.
+//!
+//! Each listed range was mapped from a module without being writable, so its
+//! contents are expected to be those of the module file, which a reader may
+//! obtain from a symbol server. The ranges are absent from both the memory list
+//! stream (::kMinidumpStreamTypeMemoryList) and the memory64 list stream
+//! (::kMinidumpStreamTypeMemory64List), although the memory around them may be
+//! present.
+//!
+//! This structure is followed immediately by #count
+//! MinidumpCrashpadReconstructibleMemoryRange structures, sorted by
+//! MinidumpCrashpadReconstructibleMemoryRange::start_of_memory_range, which do
+//! not overlap.
+struct ALIGNAS(4) PACKED MinidumpCrashpadReconstructibleMemoryList {
+  //! \brief The number of MinidumpCrashpadReconstructibleMemoryRange structures
+  //!     that follow this structure.
+  uint32_t count;
+};
+
+//! \brief Content left out of a minidump file to capture it within a deadline,
+//!     recorded in MinidumpCrashpadCapturePerformance::skipped_content.
+//!
+//! These are bit flags, and may be combined.
+enum MinidumpCrashpadSkippedContent : uint32_t {
+  //! \brief Memory indirectly referenced by thread stacks and registers.
+  kMinidumpCrashpadSkippedIndirectMemory = 1 << 0,
+
+  //! \brief The ::kMinidumpStreamTypeHandleData stream.
+  kMinidumpCrashpadSkippedHandleData = 1 << 1,
+
+  //! \brief The ::kMinidumpStreamTypeMemoryInfoList stream.
+  kMinidumpCrashpadSkippedMemoryInfoList = 1 << 2,
+
+  //! \brief The ::kMinidumpStreamTypeUnloadedModuleList stream.
+  kMinidumpCrashpadSkippedUnloadedModules = 1 << 3,
+
+  //! \brief The memory of the process’ locks.
+  kMinidumpCrashpadSkippedLocks = 1 << 4,
+};
+
+//! \brief The purposes for which the memory of the process was read, indexing
+//!     MinidumpCrashpadCapturePerformance::memory_reads.
+enum MinidumpCrashpadMemoryReadSite : uint32_t {
+  //! \brief Reads not attributed to any of the other purposes.
+  kMinidumpCrashpadMemoryReadOther = 0,
+
+  //! \brief Reads of module headers, load commands, and debug information.
+  kMinidumpCrashpadMemoryReadModules,
+
+  //! \brief Reads of CrashpadInfo structures and the annotations they refer
+  //!     to.
+  kMinidumpCrashpadMemoryReadAnnotations,
+
+  //! \brief Reads of thread stacks.
+  kMinidumpCrashpadMemoryReadStacks,
+
+  //! \brief Reads of memory referenced from thread contexts and stacks.
+  kMinidumpCrashpadMemoryReadIndirectMemory,
+
+  //! \brief Reads of process-wide data, such as the process environment block
+  //!     and the locks it refers to.
+  kMinidumpCrashpadMemoryReadProcessData,
+
+  //! \brief The number of purposes. This is not a valid purpose.
+  kMinidumpCrashpadMemoryReadSiteCount,
+};
+
+//! \brief The reads of the memory of the process made for one
+//!     ::MinidumpCrashpadMemoryReadSite.
+struct ALIGNAS(4) PACKED MinidumpCrashpadMemoryReads {
+  //! \brief The number of system calls that read memory.
+  uint64_t call_count;
+
+  //! \brief The number of bytes requested by those calls.
+  uint64_t byte_count;
+
+  //! \brief The time spent in those calls, in nanoseconds.
+  uint64_t time;
+};
+
+//! \brief Measurements of how the snapshot carried within a minidump file was
+//!     captured, carried in a stream of type
+//!     ::kMinidumpStreamTypeCrashpadCapturePerformance.
+//!
+//! This structure is versioned in the same way as MinidumpCrashpadInfo. Times
+//! are zero for phases that were not measured, or did not take place.
+struct ALIGNAS(4) PACKED MinidumpCrashpadCapturePerformance {
+  //! \brief The structure’s currently-defined version number.
+  //!
+  //! \sa version
+  static constexpr uint32_t kVersion = 3;
+
+  //! \brief The structure’s version number.
+  //!
+  //! Readers can use this field to determine which other fields in the
+  //! structure are valid. Upon encountering a value greater than #kVersion, a
+  //! reader should assume that the structure’s layout is compatible with the
+  //! structure defined as having value #kVersion.
+  uint32_t version;
+
+  //! \brief The number of threads in the snapshot.
+  //!
+  //! This field is present when #version is at least `1`.
+  uint32_t thread_count;
+
+  //! \brief The number of modules in the snapshot.
+  //!
+  //! This field is present when #version is at least `1`.
+  uint32_t module_count;
+
+  //! \brief The number of memory ranges in the memory list stream
+  //!     (::kMinidumpStreamTypeMemoryList), including thread stacks.
+  //!
+  //! This field is present when #version is at least `1`.
+  uint32_t memory_range_count;
+
+  //! \brief The number of bytes of memory in the ranges counted by
+  //!     #memory_range_count.
+  //!
+  //! This field is present when #version is at least `1`.
+  uint64_t memory_size;
+
+  //! \brief The time taken to suspend the process, in nanoseconds.
+  //!
+  //! This field is present when #version is at least `1`.
+  uint64_t suspend_time;
+
+  //! \brief The time taken to take the process snapshot, in nanoseconds.
+  //!
+  //! This field is present when #version is at least `1`.
+  uint64_t snapshot_time;
+
+  //! \brief The time taken to copy memory out of the process so that it could
+  //!     be resumed before the minidump file was written, in nanoseconds.
+  //!
+  //! This field is present when #version is at least `1`.
+  uint64_t memory_copy_time;
+
+  //! \brief The content left out of the snapshot so that it could be captured
+  //!     within its deadline, a bitwise OR of
+  //!     ::MinidumpCrashpadSkippedContent values.
+  //!
+  //! `0` if nothing was left out, or if there was no deadline.
+  //!
+  //! This field is present when #version is at least `2`.
+  uint32_t skipped_content;
+
+  //! \brief The reads of the memory of the process, indexed by
+  //!     ::MinidumpCrashpadMemoryReadSite.
+  //!
+  //! Reads are only counted when the capture was traced. Otherwise, every
+  //! count is `0`.
+  //!
+  //! This field is present when #version is at least `3`.
+  MinidumpCrashpadMemoryReads
+      memory_reads[kMinidumpCrashpadMemoryReadSiteCount];
+};
+
+//! \brief A frame of the exception thread’s stack, identified without symbol
+//!     files.
+//!
+//! \sa MinidumpCrashpadTopFrameList
+struct ALIGNAS(4) PACKED MinidumpCrashpadTopFrame {
+  //! \brief The value of #module_index for a frame outside of every module.
+  static constexpr uint32_t kNoModule = 0xffffffff;
+
+  //! \brief The address of the instruction the frame was executing, or for
+  //!     every frame but the innermost, its return address.
+  uint64_t address;
+
+  //! \brief The index of the module containing #address in the module list
+  //!     stream (::kMinidumpStreamTypeModuleList), or #kNoModule.
+  uint32_t module_index;
+
+  //! \brief The offset of #address from the module’s base address,
+  //!     MINIDUMP_MODULE::BaseOfImage, or `0` if #module_index is #kNoModule.
+  uint64_t module_offset;
+
+  //! \brief ::RVA of a MinidumpUTF8String containing the name of the nearest
+  //!     exported or dynamic function symbol at or below #address, or `0` if
+  //!     none was found.
+  RVA symbol_name;
+
+  //! \brief The offset of #address from the address of the symbol named by
+  //!     #symbol_name, or `0` if there is no symbol.
+  uint64_t symbol_offset;
+};
+
+//! \brief The innermost frames of the exception thread’s stack, found by
+//!     unwinding it while the minidump file was written, carried in a stream of
+//!     type ::kMinidumpStreamTypeCrashpadTopFrames.
+//!
+//! These allow a crash to be identified before the minidump file is fully
+//! symbolized. The symbols are only those a module exports or makes available
+//! for dynamic linking, so they may not name the function containing a frame’s
+//! address.
+//!
+//! This structure is versioned in the same way as MinidumpCrashpadInfo, and is
+//! followed immediately by #count MinidumpCrashpadTopFrame structures,
+//! innermost first.
+struct ALIGNAS(4) PACKED MinidumpCrashpadTopFrameList {
+  //! \brief The structure’s currently-defined version number.
+  //!
+  //! \sa version
+  static constexpr uint32_t kVersion = 1;
+
+  //! \brief The structure’s version number.
+  //!
+  //! Readers can use this field to determine which other fields in the
+  //! structure are valid. Upon encountering a value greater than #kVersion, a
+  //! reader should assume that the structure’s layout is compatible with the
+  //! structure defined as having value #kVersion.
+  uint32_t version;
+
+  //! \brief The ID of the thread whose stack was unwound, the exception
+  //!     thread.
+  //!
+  //! This field corresponds to MINIDUMP_THREAD::ThreadId in the thread list
+  //! stream (::kMinidumpStreamTypeThreadList).
+  uint32_t thread_id;
+
+  //! \brief The number of MinidumpCrashpadTopFrame structures that follow this
+  //!     structure.
+  uint32_t count;
+};
+
+//! \brief An entry in a minidump file’s stream index, locating one of its
+//!     streams. See MinidumpCrashpadStreamIndexFooter.
+struct ALIGNAS(4) PACKED MinidumpCrashpadStreamIndexEntry {
+  //! \brief The stream’s type, as in MINIDUMP_DIRECTORY::StreamType.
+  uint32_t stream_type;
+
+  //! \brief The offset of the stream’s data from the start of the minidump
+  //!     file, as in MINIDUMP_DIRECTORY::Location.
+  RVA64 offset;
+
+  //! \brief The size of the stream’s data, in bytes, as in
+  //!     MINIDUMP_DIRECTORY::Location.
+  uint64_t size;
+
+  //! \brief The XXH64 hash, with seed `0`, of the #size bytes at #offset.
+  //!
+  //! This covers only the stream’s own data. Data that it refers to by ::RVA,
+  //! such as the contexts and stacks of threads in the thread list stream,
+  //! isn’t covered.
+  uint64_t xxhash64;
+};
+
+//! \brief The footer that ends a minidump file carrying a stream index.
+//!
+//! A stream index allows a reader holding only part of a minidump file, such
+//! as one fetching ranges of it from remote storage, to locate and validate a
+//! stream with two small reads: one for this footer, at a fixed offset from
+//! the end of the file, and one for the index that it locates. The index is
+//! an array of #count MinidumpCrashpadStreamIndexEntry structures, one for
+//! each entry in the stream directory, in the same order.
+//!
+//! The index and this footer follow all other data in the minidump file, and
+//! nothing in the rest of the file refers to them, so readers unaware of them
+//! are unaffected by their presence. A minidump file that has been compressed
+//! must be decompressed before its footer can be found.
+//!
+//! This structure is versioned in the same way as MinidumpCrashpadInfo.
+struct ALIGNAS(4) PACKED MinidumpCrashpadStreamIndexFooter {
+  //! \brief The value of #signature, “CPsI”.
+  static constexpr uint32_t kSignature = 0x49735043;
+
+  //! \brief The structure’s currently-defined version number.
+  //!
+  //! \sa version
+  static constexpr uint32_t kVersion = 1;
+
+  //! \brief The structure’s version number.
+  //!
+  //! Readers can use this field to determine which other fields in the
+  //! structure are valid. Upon encountering a value greater than #kVersion, a
+  //! reader should assume that the structure’s layout is compatible with the
+  //! structure defined as having value #kVersion.
+  uint32_t version;
+
+  //! \brief The offset of the index from the start of the minidump file.
+  RVA64 index;
+
+  //! \brief The number of entries in the index.
+  uint32_t count;
+
+  //! \brief The size of each entry in the index, in bytes.
+  //!
+  //! This is at least `sizeof(MinidumpCrashpadStreamIndexEntry)`. Entries may
+  //! be extended in later versions, and readers should ignore any excess.
+  uint32_t size_of_entry;
+
+  //! \brief The XXH64 hash, with seed `0`, of the index.
+  uint64_t index_xxhash64;
+
+  //! \brief #kSignature, identifying a minidump file that carries a stream
+  //!     index.
+  //!
+  //! This is the last field, so that it always occupies the last four bytes
+  //! of the file.
+  uint32_t signature;
+};
+
 #if defined(COMPILER_MSVC)
 #pragma pack(pop)
 #endif  // COMPILER_MSVC
@@ -0,0 +1,97 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_file_extension_stream_data_source.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "util/file/file_reader.h"
+
+namespace crashpad {
+
+namespace {
+
+// The most data read from the file at once.
+constexpr size_t kChunkSize = 64 * 1024;
+
+}  // namespace
+
+MinidumpFileExtensionStreamDataSource::MinidumpFileExtensionStreamDataSource(
+    uint32_t stream_type,
+    std::unique_ptr<FileReaderInterface> reader,
+    FileOffset offset,
+    size_t size)
+    : MinidumpUserExtensionStreamDataSource(stream_type),
+      reader_(std::move(reader)),
+      offset_(offset),
+      size_(size) {}
+
+MinidumpFileExtensionStreamDataSource::
+    ~MinidumpFileExtensionStreamDataSource() {}
+
+// static
+std::unique_ptr<MinidumpFileExtensionStreamDataSource>
+MinidumpFileExtensionStreamDataSource::CreateForFile(
+    uint32_t stream_type,
+    std::unique_ptr<FileReaderInterface> reader) {
+  const FileOffset size = reader->Seek(0, SEEK_END);
+  if (size < 0) {
+    return nullptr;
+  }
+
+  return std::unique_ptr<MinidumpFileExtensionStreamDataSource>(
+      new MinidumpFileExtensionStreamDataSource(
+          stream_type, std::move(reader), 0, static_cast<size_t>(size)));
+}
+
+size_t MinidumpFileExtensionStreamDataSource::StreamDataSize() {
+  return size_;
+}
+
+bool MinidumpFileExtensionStreamDataSource::ReadStreamData(
+    Delegate* delegate) {
+  if (!reader_->SeekSet(offset_)) {
+    return false;
+  }
+
+  std::unique_ptr<uint8_t[]> buffer(new uint8_t[std::min(size_, kChunkSize)]);
+  size_t remaining = size_;
+  while (remaining) {
+    const FileOperationResult bytes =
+        reader_->Read(buffer.get(), std::min(remaining, kChunkSize));
+    if (bytes < 0) {
+      return false;
+    }
+    if (bytes == 0) {
+      // The file is shorter than it was. What was read is kept, and the writer
+      // fills the rest of the stream.
+      LOG(WARNING) << "extension stream file ended " << remaining
+                   << " bytes early";
+      break;
+    }
+
+    if (!delegate->ExtensionStreamDataSourceRead(buffer.get(), bytes)) {
+      return false;
+    }
+    remaining -= bytes;
+  }
+
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,76 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_FILE_EXTENSION_STREAM_DATA_SOURCE_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_FILE_EXTENSION_STREAM_DATA_SOURCE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <memory>
+
+#include "base/macros.h"
+#include "minidump/minidump_user_extension_stream_data_source.h"
+#include "util/file/file_io.h"
+
+namespace crashpad {
+
+class FileReaderInterface;
+
+//! \brief A user extension data source that reads its data from a file as the
+//!     minidump is written.
+//!
+//! The data is read in bounded chunks and passed to the minidump file as each
+//! is read, so a large stream is never held in memory in its entirety.
+class MinidumpFileExtensionStreamDataSource final
+    : public MinidumpUserExtensionStreamDataSource {
+ public:
+  //! \param[in] stream_type The type of the stream.
+  //! \param[in] reader The file to read the stream’s data from.
+  //! \param[in] offset The offset in \a reader that the stream’s data begins
+  //!     at.
+  //! \param[in] size The size of the stream’s data. If \a reader ends before
+  //!     \a size bytes can be read, the rest of the stream is filled with
+  //!     zeroes.
+  MinidumpFileExtensionStreamDataSource(
+      uint32_t stream_type,
+      std::unique_ptr<FileReaderInterface> reader,
+      FileOffset offset,
+      size_t size);
+  ~MinidumpFileExtensionStreamDataSource() override;
+
+  //! \brief Creates a data source for the entire contents of \a reader,
+  //!     starting at its beginning.
+  //!
+  //! \return The data source, or `nullptr` with a message logged if the size
+  //!     of \a reader could not be determined.
+  static std::unique_ptr<MinidumpFileExtensionStreamDataSource> CreateForFile(
+      uint32_t stream_type,
+      std::unique_ptr<FileReaderInterface> reader);
+
+  // MinidumpUserExtensionStreamDataSource:
+  size_t StreamDataSize() override;
+  bool ReadStreamData(Delegate* delegate) override;
+
+ private:
+  std::unique_ptr<FileReaderInterface> reader_;
+  FileOffset offset_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpFileExtensionStreamDataSource);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_FILE_EXTENSION_STREAM_DATA_SOURCE_H_
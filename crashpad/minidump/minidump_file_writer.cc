@@ -14,6 +14,10 @@
 
 #include "minidump/minidump_file_writer.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
 #include <utility>
 
 #include "base/logging.h"
@@ -21,27 +25,200 @@
 #include "minidump/minidump_crashpad_info_writer.h"
 #include "minidump/minidump_exception_writer.h"
 #include "minidump/minidump_handle_writer.h"
+#include "minidump/minidump_memory64_list_writer.h"
 #include "minidump/minidump_memory_info_writer.h"
 #include "minidump/minidump_memory_writer.h"
 #include "minidump/minidump_misc_info_writer.h"
 #include "minidump/minidump_module_writer.h"
+#include "minidump/minidump_reconstructible_memory_writer.h"
+#include "minidump/minidump_stream_reference_writer.h"
 #include "minidump/minidump_system_info_writer.h"
+#include "minidump/minidump_thread_annotation_list_writer.h"
 #include "minidump/minidump_thread_id_map.h"
+#include "minidump/minidump_thread_name_list_writer.h"
 #include "minidump/minidump_thread_writer.h"
+#include "minidump/minidump_top_frames_writer.h"
 #include "minidump/minidump_unloaded_module_writer.h"
 #include "minidump/minidump_user_extension_stream_data_source.h"
 #include "minidump/minidump_user_stream_writer.h"
 #include "minidump/minidump_writer_util.h"
 #include "snapshot/exception_snapshot.h"
+#include "snapshot/memory_snapshot.h"
 #include "snapshot/module_snapshot.h"
 #include "snapshot/process_snapshot.h"
+#include "snapshot/thread_snapshot.h"
+#include "util/file/buffered_file_writer.h"
 #include "util/file/file_writer.h"
+#include "util/file/string_file.h"
+#include "util/misc/xxhash.h"
 #include "util/numeric/safe_assignment.h"
 
 namespace crashpad {
 
+namespace {
+
+void AddMemoryRanges(const std::vector<const MemorySnapshot*>& memory,
+                     std::vector<CheckedRange<uint64_t>>* ranges) {
+  for (const MemorySnapshot* snapshot : memory) {
+    ranges->push_back(
+        CheckedRange<uint64_t>(snapshot->Address(), snapshot->Size()));
+  }
+}
+
+// Returns the address ranges of the memory that InitializeFromSnapshot() may
+// capture from |process_snapshot|: thread stacks, and the extra memory of the
+// threads, the exception, and the process.
+std::vector<CheckedRange<uint64_t>> CapturedMemoryRanges(
+    const ProcessSnapshot* process_snapshot) {
+  std::vector<CheckedRange<uint64_t>> ranges;
+  for (const ThreadSnapshot* thread : process_snapshot->Threads()) {
+    const MemorySnapshot* stack = thread->Stack();
+    if (stack) {
+      ranges.push_back(CheckedRange<uint64_t>(stack->Address(), stack->Size()));
+    }
+    AddMemoryRanges(thread->ExtraMemory(), &ranges);
+  }
+
+  const ExceptionSnapshot* exception_snapshot = process_snapshot->Exception();
+  if (exception_snapshot) {
+    AddMemoryRanges(exception_snapshot->ExtraMemory(), &ranges);
+  }
+
+  AddMemoryRanges(process_snapshot->ExtraMemory(), &ranges);
+  return ranges;
+}
+
+// Passes writes through to another FileWriterInterface, keeping a copy of what
+// is written to each of a set of ranges of the file, so that the ranges can be
+// hashed once the file has been written.
+class RangeCapturingFileWriter final : public FileWriterInterface {
+ public:
+  // Offsets given to this object are relative to |base_offset| in
+  // |file_writer|, which must be its current position.
+  RangeCapturingFileWriter(FileWriterInterface* file_writer,
+                           FileOffset base_offset)
+      : FileWriterInterface(),
+        range_offsets_(),
+        range_contents_(),
+        file_writer_(file_writer),
+        base_offset_(base_offset),
+        offset_(0) {}
+
+  ~RangeCapturingFileWriter() override {}
+
+  // Arranges for the |size| bytes at |offset| to be kept. Ranges must not
+  // overlap. Bytes in a range that are never written are kept as zeroes.
+  void AddRange(FileOffset offset, size_t size) {
+    range_offsets_.push_back(offset);
+    range_contents_.push_back(std::string(size, '\0'));
+  }
+
+  // The contents of each range, in the order in which they were added.
+  const std::vector<std::string>& range_contents() const {
+    return range_contents_;
+  }
+
+  // FileWriterInterface:
+
+  bool Write(const void* data, size_t size) override {
+    Capture(data, size, offset_);
+    if (!file_writer_->Write(data, size)) {
+      return false;
+    }
+    offset_ += size;
+    return true;
+  }
+
+  bool WriteIoVec(std::vector<WritableIoVec>* iovecs) override {
+    // |iovecs| may be modified as it’s written, so capture it first.
+    FileOffset offset = offset_;
+    for (const WritableIoVec& iov : *iovecs) {
+      Capture(iov.iov_base, iov.iov_len, offset);
+      offset += iov.iov_len;
+    }
+    if (!file_writer_->WriteIoVec(iovecs)) {
+      return false;
+    }
+    offset_ = offset;
+    return true;
+  }
+
+  FileOffset Seek(FileOffset offset, int whence) override {
+    FileOffset new_offset = file_writer_->Seek(offset, whence);
+    if (new_offset >= 0) {
+      offset_ = new_offset - base_offset_;
+    }
+    return new_offset;
+  }
+
+ private:
+  // Copies whatever part of the |size| bytes at |data|, to be written at
+  // |offset|, falls within the ranges.
+  void Capture(const void* data, size_t size, FileOffset offset) {
+    const FileOffset end = offset + size;
+    for (size_t index = 0; index < range_offsets_.size(); ++index) {
+      std::string& contents = range_contents_[index];
+      const FileOffset range_start = range_offsets_[index];
+      const FileOffset range_end = range_start + contents.size();
+      const FileOffset start = std::max(offset, range_start);
+      const FileOffset stop = std::min(end, range_end);
+      if (start < stop) {
+        memcpy(&contents[static_cast<size_t>(start - range_start)],
+               static_cast<const char*>(data) + (start - offset),
+               static_cast<size_t>(stop - start));
+      }
+    }
+  }
+
+  std::vector<FileOffset> range_offsets_;
+  std::vector<std::string> range_contents_;
+  FileWriterInterface* file_writer_;  // weak
+  FileOffset base_offset_;
+  FileOffset offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(RangeCapturingFileWriter);
+};
+
+// The alignment of the stream index within the minidump file.
+constexpr size_t kStreamIndexAlignment = 4;
+
+// Returns the most bytes that MinidumpFileWriter::WriteStreamIndex() may write
+// for |stream_count| streams, including padding.
+size_t StreamIndexSize(size_t stream_count) {
+  return kStreamIndexAlignment - 1 +
+         stream_count * sizeof(MinidumpCrashpadStreamIndexEntry) +
+         sizeof(MinidumpCrashpadStreamIndexFooter);
+}
+
+}  // namespace
+
 MinidumpFileWriter::MinidumpFileWriter()
-    : MinidumpWritable(), header_(), streams_(), stream_types_() {
+    : MinidumpWritable(),
+      header_(),
+      arena_(),
+      streams_(),
+      string_table_(),
+      stream_types_(),
+      write_thread_count_(1),
+      write_stream_index_(false),
+      size_budget_(0),
+      selected_stream_types_(),
+      stack_size_limit_(0),
+      collapse_identical_stacks_(false),
+      exclude_reconstructible_memory_(false),
+      memory_info_list_options_(),
+      capture_phase_times_(),
+      write_capture_performance_(false),
+      memory_read_trace_(nullptr),
+      top_frames_(),
+      full_memory_(),
+      full_memory_sparse_(false),
+      memory64_list_(nullptr),
+      capture_performance_(nullptr),
+      static_stream_cache_(nullptr),
+      static_stream_process_(),
+      report_id_(),
+      static_streams_to_commit_() {
   // Don’t set the signature field right away. Leave it set to 0, so that a
   // partially-written minidump file isn’t confused for a complete and valid
   // one. The header will be rewritten in WriteToFile().
@@ -63,6 +240,32 @@ void MinidumpFileWriter::InitializeFromSnapshot(
   DCHECK_EQ(header_.Flags, MiniDumpNormal);
   DCHECK(streams_.empty());
 
+  internal::MinidumpSizeBudgetPlan plan;
+  const ExceptionSnapshot* exception_snapshot = process_snapshot->Exception();
+  if (exception_snapshot) {
+    plan.has_exempt_thread_id = true;
+    plan.exempt_thread_id = exception_snapshot->ThreadID();
+  }
+
+  if (stack_size_limit_) {
+    plan.stack_size = stack_size_limit_;
+  }
+
+  if (size_budget_) {
+    PlanSizeBudget(process_snapshot, &plan);
+  }
+
+  InitializeFromSnapshotWithPlan(process_snapshot, plan);
+}
+
+void MinidumpFileWriter::InitializeFromSnapshotWithPlan(
+    const ProcessSnapshot* process_snapshot,
+    const internal::MinidumpSizeBudgetPlan& plan) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  internal::ScopedMinidumpWritableArena scoped_arena(&arena_);
+
   // This time is truncated to an integer number of seconds, not rounded, for
   // compatibility with the truncation of process_snapshot->ProcessStartTime()
   // done by MinidumpMiscInfoWriter::InitializeFromSnapshot(). Handling both
@@ -72,45 +275,110 @@ void MinidumpFileWriter::InitializeFromSnapshot(
   process_snapshot->SnapshotTime(&snapshot_time);
   SetTimestamp(snapshot_time.tv_sec);
 
+  auto stream_references =
+      base::WrapUnique(new MinidumpStreamReferenceListWriter());
+  if (static_stream_cache_) {
+    static_stream_process_ =
+        MinidumpStaticStreamCache::KeyForProcess(process_snapshot);
+    process_snapshot->ReportID(&report_id_);
+  }
+
+  bool add_stream_result;
   const SystemSnapshot* system_snapshot = process_snapshot->System();
   auto system_info = base::WrapUnique(new MinidumpSystemInfoWriter());
   system_info->InitializeFromSnapshot(system_snapshot);
-  bool add_stream_result = AddStream(std::move(system_info));
-  DCHECK(add_stream_result);
+  if (static_stream_cache_ &&
+      IsStreamSelected(kMinidumpStreamTypeSystemInfo)) {
+    auto cached_system_info = base::WrapUnique(new MinidumpSystemInfoWriter());
+    cached_system_info->InitializeFromSnapshot(system_snapshot);
+    if (ReferenceCachedStream(std::move(cached_system_info),
+                              stream_references.get())) {
+      system_info.reset();
+    }
+  }
+  if (system_info) {
+    add_stream_result = AddSelectedStream(std::move(system_info));
+    DCHECK(add_stream_result);
+  }
 
   auto misc_info = base::WrapUnique(new MinidumpMiscInfoWriter());
   misc_info->InitializeFromSnapshot(process_snapshot);
-  add_stream_result = AddStream(std::move(misc_info));
+  add_stream_result = AddSelectedStream(std::move(misc_info));
   DCHECK(add_stream_result);
 
+  // The memory list refers to the thread stacks owned by the thread list, so
+  // an unselected thread list must not be built. Other streams still need the
+  // thread ID map.
   auto memory_list = base::WrapUnique(new MinidumpMemoryListWriter());
-  auto thread_list = base::WrapUnique(new MinidumpThreadListWriter());
-  thread_list->SetMemoryListWriter(memory_list.get());
   MinidumpThreadIDMap thread_id_map;
-  thread_list->InitializeFromSnapshot(process_snapshot->Threads(),
-                                      &thread_id_map);
-  add_stream_result = AddStream(std::move(thread_list));
-  DCHECK(add_stream_result);
+  if (IsStreamSelected(kMinidumpStreamTypeThreadList)) {
+    auto thread_list = base::WrapUnique(new MinidumpThreadListWriter());
+    thread_list->SetMemoryListWriter(memory_list.get());
+    thread_list->SetSizeBudgetPlan(plan);
+    thread_list->SetCollapseIdenticalStacks(collapse_identical_stacks_);
+    thread_list->InitializeFromSnapshot(process_snapshot->Threads(),
+                                        &thread_id_map);
+    add_stream_result = AddStream(std::move(thread_list));
+    DCHECK(add_stream_result);
+  } else {
+    BuildMinidumpThreadIDMap(process_snapshot->Threads(), &thread_id_map);
+  }
+
+  auto thread_name_list = base::WrapUnique(new MinidumpThreadNameListWriter());
+  thread_name_list->InitializeFromSnapshot(process_snapshot->Threads(),
+                                           &thread_id_map);
+  if (thread_name_list->IsUseful()) {
+    add_stream_result = AddSelectedStream(std::move(thread_name_list));
+    DCHECK(add_stream_result);
+  }
+
+  auto thread_annotation_list =
+      base::WrapUnique(new MinidumpThreadAnnotationListWriter());
+  thread_annotation_list->InitializeFromSnapshot(process_snapshot->Modules(),
+                                                 &thread_id_map);
+  if (thread_annotation_list->IsUseful()) {
+    add_stream_result = AddSelectedStream(std::move(thread_annotation_list));
+    DCHECK(add_stream_result);
+  }
 
   const ExceptionSnapshot* exception_snapshot = process_snapshot->Exception();
   if (exception_snapshot) {
     auto exception = base::WrapUnique(new MinidumpExceptionWriter());
     exception->InitializeFromSnapshot(exception_snapshot, thread_id_map);
-    add_stream_result = AddStream(std::move(exception));
+    add_stream_result = AddSelectedStream(std::move(exception));
     DCHECK(add_stream_result);
+
+    auto top_frames = base::WrapUnique(new MinidumpTopFramesWriter());
+    top_frames->InitializeFromFrames(
+        exception_snapshot->ThreadID(), top_frames_, thread_id_map);
+    if (top_frames->IsUseful()) {
+      add_stream_result = AddSelectedStream(std::move(top_frames));
+      DCHECK(add_stream_result);
+    }
   }
 
   auto module_list = base::WrapUnique(new MinidumpModuleListWriter());
   module_list->InitializeFromSnapshot(process_snapshot->Modules());
-  add_stream_result = AddStream(std::move(module_list));
-  DCHECK(add_stream_result);
+  if (static_stream_cache_ &&
+      IsStreamSelected(kMinidumpStreamTypeModuleList)) {
+    auto cached_module_list = base::WrapUnique(new MinidumpModuleListWriter());
+    cached_module_list->InitializeFromSnapshot(process_snapshot->Modules());
+    if (ReferenceCachedStream(std::move(cached_module_list),
+                              stream_references.get())) {
+      module_list.reset();
+    }
+  }
+  if (module_list) {
+    add_stream_result = AddSelectedStream(std::move(module_list));
+    DCHECK(add_stream_result);
+  }
 
   auto unloaded_modules = process_snapshot->UnloadedModules();
   if (!unloaded_modules.empty()) {
     auto unloaded_module_list =
         base::WrapUnique(new MinidumpUnloadedModuleListWriter());
     unloaded_module_list->InitializeFromSnapshot(unloaded_modules);
-    add_stream_result = AddStream(std::move(unloaded_module_list));
+    add_stream_result = AddSelectedStream(std::move(unloaded_module_list));
     DCHECK(add_stream_result);
   }
 
@@ -120,17 +388,30 @@ void MinidumpFileWriter::InitializeFromSnapshot(
   // Since the MinidumpCrashpadInfo stream is an extension, it’s safe to not add
   // it to the minidump file if it wouldn’t carry any useful information.
   if (crashpad_info->IsUseful()) {
-    add_stream_result = AddStream(std::move(crashpad_info));
+    add_stream_result = AddSelectedStream(std::move(crashpad_info));
+    DCHECK(add_stream_result);
+  }
+
+  if (stream_references->IsUseful()) {
+    add_stream_result = AddSelectedStream(std::move(stream_references));
     DCHECK(add_stream_result);
   }
 
   std::vector<const MemoryMapRegionSnapshot*> memory_map_snapshot =
       process_snapshot->MemoryMap();
+  if (memory_map_snapshot.size() > plan.memory_info_count) {
+    memory_map_snapshot.resize(plan.memory_info_count);
+  }
   if (!memory_map_snapshot.empty()) {
     auto memory_info_list =
         base::WrapUnique(new MinidumpMemoryInfoListWriter());
-    memory_info_list->InitializeFromSnapshot(memory_map_snapshot);
-    add_stream_result = AddStream(std::move(memory_info_list));
+    std::vector<CheckedRange<uint64_t>> captured_ranges;
+    if (memory_info_list_options_.only_near_captured_memory) {
+      captured_ranges = CapturedMemoryRanges(process_snapshot);
+    }
+    memory_info_list->InitializeFromSnapshot(
+        memory_map_snapshot, memory_info_list_options_, captured_ranges);
+    add_stream_result = AddSelectedStream(std::move(memory_info_list));
     DCHECK(add_stream_result);
   }
 
@@ -138,14 +419,64 @@ void MinidumpFileWriter::InitializeFromSnapshot(
   if (!handles_snapshot.empty()) {
     auto handle_data_writer = base::WrapUnique(new MinidumpHandleDataWriter());
     handle_data_writer->InitializeFromSnapshot(handles_snapshot);
-    add_stream_result = AddStream(std::move(handle_data_writer));
+    add_stream_result = AddSelectedStream(std::move(handle_data_writer));
     DCHECK(add_stream_result);
   }
 
-  memory_list->AddFromSnapshot(process_snapshot->ExtraMemory());
+  // The memory list isn’t complete until it’s coalesced below, so the stream’s
+  // memory counts are set then.
+  MinidumpCapturePerformanceWriter* capture_performance_weak = nullptr;
+  if (write_capture_performance_ &&
+      IsStreamSelected(kMinidumpStreamTypeCrashpadCapturePerformance)) {
+    auto capture_performance =
+        base::WrapUnique(new MinidumpCapturePerformanceWriter());
+    capture_performance->SetPhaseTimes(capture_phase_times_);
+    if (memory_read_trace_) {
+      capture_performance->SetMemoryReadTrace(memory_read_trace_);
+      capture_performance_ = capture_performance.get();
+    }
+    capture_performance->SetProcessShape(process_snapshot->Threads().size(),
+                                         process_snapshot->Modules().size());
+    capture_performance_weak = capture_performance.get();
+    add_stream_result = AddStream(std::move(capture_performance));
+    DCHECK(add_stream_result);
+  }
+
+  // The process’ and the exception’s extra memory are kept apart so that
+  // reads of each are attributed to the right MemoryReadSite.
+  std::vector<const MemorySnapshot*> extra_memory =
+      process_snapshot->ExtraMemory();
+  std::vector<const MemorySnapshot*> exception_extra_memory;
   if (exception_snapshot) {
-    memory_list->AddFromSnapshot(exception_snapshot->ExtraMemory());
+    exception_extra_memory = exception_snapshot->ExtraMemory();
   }
+  std::vector<const MemorySnapshot*> full_memory = full_memory_;
+
+  // The memory list is coalesced, which can’t merge the snapshots that a split
+  // snapshot is replaced by, so only the full memory is split.
+  if (exclude_reconstructible_memory_ &&
+      IsStreamSelected(kMinidumpStreamTypeCrashpadReconstructibleMemoryList)) {
+    auto reconstructible_memory =
+        base::WrapUnique(new MinidumpReconstructibleMemoryListWriter());
+    reconstructible_memory->InitializeFromSnapshot(
+        process_snapshot->MemoryMap(), process_snapshot->Modules());
+    extra_memory =
+        reconstructible_memory->ExcludeReconstructibleMemory(extra_memory,
+                                                             false);
+    exception_extra_memory =
+        reconstructible_memory->ExcludeReconstructibleMemory(
+            exception_extra_memory, false);
+    full_memory =
+        reconstructible_memory->ExcludeReconstructibleMemory(full_memory, true);
+    if (reconstructible_memory->IsUseful()) {
+      add_stream_result = AddStream(std::move(reconstructible_memory));
+      DCHECK(add_stream_result);
+    }
+  }
+
+  memory_list->AddFromSnapshot(extra_memory, MemoryReadSite::kProcessData);
+  memory_list->AddFromSnapshot(exception_extra_memory,
+                               MemoryReadSite::kIndirectMemory);
 
   // These user streams must be added last. Otherwise, a user stream with the
   // same type as a well-known stream could preempt the well-known stream. As it
@@ -155,14 +486,16 @@ void MinidumpFileWriter::InitializeFromSnapshot(
   // stream that would preempt the memory list stream.
   for (const auto& module : process_snapshot->Modules()) {
     for (const UserMinidumpStream* stream : module->CustomMinidumpStreams()) {
-      if (stream->stream_type() == kMinidumpStreamTypeMemoryList) {
+      if (stream->stream_type() == kMinidumpStreamTypeMemoryList ||
+          (!full_memory_.empty() &&
+           stream->stream_type() == kMinidumpStreamTypeMemory64List)) {
         LOG(WARNING) << "discarding duplicate stream of type "
                      << stream->stream_type();
         continue;
       }
       auto user_stream = base::WrapUnique(new MinidumpUserStreamWriter());
       user_stream->InitializeFromSnapshot(stream);
-      AddStream(std::move(user_stream));
+      AddSelectedStream(std::move(user_stream));
     }
   }
 
@@ -172,8 +505,26 @@ void MinidumpFileWriter::InitializeFromSnapshot(
   // will not have to ride at the end of the file. Thread stack memory, for
   // example, exists as a children of threads, and appears alongside them in the
   // file, despite also being mentioned by the memory list stream.
-  add_stream_result = AddStream(std::move(memory_list));
+  memory_list->CoalesceOwnedMemory(0);
+  if (capture_performance_weak) {
+    capture_performance_weak->SetMemory(memory_list->MemoryRangeCount(),
+                                        memory_list->MemorySize());
+  }
+  add_stream_result = AddSelectedStream(std::move(memory_list));
   DCHECK(add_stream_result);
+
+  // The full memory follows even the memory list stream’s memory, so that the
+  // rest of the file remains compact.
+  if (!full_memory_.empty() &&
+      IsStreamSelected(kMinidumpStreamTypeMemory64List)) {
+    auto memory64_list = base::WrapUnique(new MinidumpMemory64ListWriter());
+    memory64_list->AddFromSnapshot(full_memory);
+    memory64_list->SetSparse(full_memory_sparse_);
+    memory64_list_ = memory64_list.get();
+    add_stream_result = AddStream(std::move(memory64_list));
+    DCHECK(add_stream_result);
+    header_.Flags |= MiniDumpWithFullMemory;
+  }
 }
 
 void MinidumpFileWriter::SetTimestamp(time_t timestamp) {
@@ -182,6 +533,162 @@ void MinidumpFileWriter::SetTimestamp(time_t timestamp) {
   internal::MinidumpWriterUtil::AssignTimeT(&header_.TimeDateStamp, timestamp);
 }
 
+void MinidumpFileWriter::PlanSizeBudget(
+    const ProcessSnapshot* process_snapshot,
+    internal::MinidumpSizeBudgetPlan* plan) {
+  DCHECK(size_budget_);
+
+  // The savings estimated by TightenMinidumpSizeBudgetPlan() can fall short
+  // when memory ranges are coalesced, so each trial is measured. On each
+  // successive pass, more than the measured excess is requested, to converge
+  // quickly.
+  constexpr int kMaximumPasses = 8;
+  for (int pass = 0;; ++pass) {
+    MinidumpFileWriter trial;
+    trial.SetStreamSelection(selected_stream_types_);
+    trial.SetCollapseIdenticalStacks(collapse_identical_stacks_);
+    trial.SetStaticStreamCache(static_stream_cache_);
+    trial.SetMemoryInfoListOptions(memory_info_list_options_);
+    if (write_capture_performance_) {
+      trial.SetCapturePhaseTimes(capture_phase_times_);
+    }
+    trial.SetTopFrames(top_frames_);
+    trial.InitializeFromSnapshotWithPlan(process_snapshot, *plan);
+
+    std::vector<MinidumpWritable*> write_sequence;
+    FileOffset size;
+    if (!trial.LayOutTree(&write_sequence, &size)) {
+      // The real minidump file will fail in the same way when written.
+      return;
+    }
+
+    if (static_cast<uint64_t>(size) <= size_budget_) {
+      return;
+    }
+
+    const uint64_t excess = (static_cast<uint64_t>(size) - size_budget_)
+                            << pass;
+    if (pass == kMaximumPasses ||
+        !internal::TightenMinidumpSizeBudgetPlan(
+            process_snapshot,
+            static_cast<size_t>(std::min(
+                excess,
+                static_cast<uint64_t>(std::numeric_limits<size_t>::max()))),
+            plan)) {
+      LOG(WARNING) << "minidump size " << size << " exceeds budget "
+                   << size_budget_;
+      return;
+    }
+  }
+}
+
+void MinidumpFileWriter::SetSizeBudget(size_t size_budget) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  size_budget_ = size_budget;
+}
+
+void MinidumpFileWriter::SetStreamSelection(
+    const std::set<MinidumpStreamType>& stream_types) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  selected_stream_types_ = stream_types;
+}
+
+void MinidumpFileWriter::SetStackSizeLimit(size_t stack_size_limit) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  stack_size_limit_ = stack_size_limit;
+}
+
+void MinidumpFileWriter::SetCollapseIdenticalStacks(bool collapse) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  collapse_identical_stacks_ = collapse;
+}
+
+void MinidumpFileWriter::SetExcludeReconstructibleMemory(bool exclude) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  exclude_reconstructible_memory_ = exclude;
+}
+
+void MinidumpFileWriter::SetStaticStreamCache(
+    MinidumpStaticStreamCache* cache) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  static_stream_cache_ = cache;
+}
+
+void MinidumpFileWriter::SetMemoryInfoListOptions(
+    const MinidumpMemoryInfoListOptions& options) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  memory_info_list_options_ = options;
+}
+
+void MinidumpFileWriter::SetCapturePhaseTimes(
+    const MinidumpCapturePhaseTimes& phase_times) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  capture_phase_times_ = phase_times;
+  write_capture_performance_ = true;
+}
+
+void MinidumpFileWriter::SetMemoryReadTrace(const MemoryReadTrace* trace) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  memory_read_trace_ = trace;
+}
+
+void MinidumpFileWriter::SetTopFrames(const std::vector<TopFrame>& frames) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  top_frames_ = frames;
+}
+
+void MinidumpFileWriter::SetFullMemory(
+    const std::vector<const MemorySnapshot*>& memory_snapshots,
+    bool sparse) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(streams_.empty());
+
+  full_memory_ = memory_snapshots;
+  full_memory_sparse_ = sparse;
+}
+
+void MinidumpFileWriter::CommitStaticStreams() {
+  DCHECK_EQ(state(), kStateWritten);
+
+  for (const auto& stream : static_streams_to_commit_) {
+    static_stream_cache_->Update(
+        static_stream_process_, stream.first, stream.second, report_id_);
+  }
+  static_streams_to_commit_.clear();
+}
+
+void MinidumpFileWriter::SetWriteThreadCount(size_t thread_count) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  write_thread_count_ = thread_count;
+}
+
+void MinidumpFileWriter::SetWriteStreamIndex(bool write_stream_index) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  write_stream_index_ = write_stream_index;
+}
+
 bool MinidumpFileWriter::AddStream(
     std::unique_ptr<internal::MinidumpStreamWriter> stream) {
   DCHECK_EQ(state(), kStateMutable);
@@ -200,6 +707,48 @@ bool MinidumpFileWriter::AddStream(
   return true;
 }
 
+bool MinidumpFileWriter::ReferenceCachedStream(
+    std::unique_ptr<internal::MinidumpStreamWriter> stream,
+    MinidumpStreamReferenceListWriter* stream_references) {
+  DCHECK(static_stream_cache_);
+
+  MinidumpStreamType stream_type = stream->StreamType();
+
+  // Render the stream on its own, so that its contents don’t depend on where
+  // it would appear in this minidump file.
+  StringFile contents;
+  if (!stream->WriteEverything(&contents)) {
+    return false;
+  }
+
+  UUID base_report_id;
+  if (static_stream_cache_->Find(static_stream_process_,
+                                 stream_type,
+                                 contents.string(),
+                                 &base_report_id)) {
+    stream_references->AddReference(stream_type, base_report_id);
+    return true;
+  }
+
+  static_streams_to_commit_.push_back(
+      std::make_pair(stream_type, contents.string()));
+  return false;
+}
+
+bool MinidumpFileWriter::IsStreamSelected(
+    MinidumpStreamType stream_type) const {
+  return selected_stream_types_.empty() ||
+         selected_stream_types_.count(stream_type);
+}
+
+bool MinidumpFileWriter::AddSelectedStream(
+    std::unique_ptr<internal::MinidumpStreamWriter> stream) {
+  if (!IsStreamSelected(stream->StreamType())) {
+    return true;
+  }
+  return AddStream(std::move(stream));
+}
+
 bool MinidumpFileWriter::AddUserExtensionStream(
     std::unique_ptr<MinidumpUserExtensionStreamDataSource>
         user_extension_stream_data) {
@@ -213,22 +762,138 @@ bool MinidumpFileWriter::AddUserExtensionStream(
 }
 
 bool MinidumpFileWriter::WriteEverything(FileWriterInterface* file_writer) {
+  // Most objects in a minidump file are small, and are written individually.
+  // Coalesce them so that a file with many threads or modules doesn’t need a
+  // system call for each record.
+  BufferedFileWriter buffered_file_writer(
+      file_writer, BufferedFileWriter::kDefaultBufferSize);
+  return WriteMinidump(&buffered_file_writer, true) &&
+         buffered_file_writer.Flush();
+}
+
+bool MinidumpFileWriter::WriteMinidump(FileWriterInterface* file_writer,
+                                       bool allow_seek) {
+  return WriteMinidumpReserving(file_writer, allow_seek, nullptr);
+}
+
+bool MinidumpFileWriter::WriteMinidumpToMemory(
+    ChunkedBufferFile* buffer_file) {
+  // Writes go straight to memory, so they aren’t coalesced as they are by
+  // WriteEverything().
+  return WriteMinidumpReserving(buffer_file, true, buffer_file);
+}
+
+bool MinidumpFileWriter::WriteMinidumpReserving(
+    FileWriterInterface* file_writer,
+    bool allow_seek,
+    ChunkedBufferFile* reserve_file) {
   DCHECK_EQ(state(), kStateMutable);
+  DCHECK(!reserve_file || reserve_file == file_writer);
 
-  FileOffset start_offset = file_writer->Seek(0, SEEK_CUR);
-  if (start_offset < 0) {
+  FileOffset start_offset = 0;
+  if (allow_seek) {
+    start_offset = file_writer->Seek(0, SEEK_CUR);
+    if (start_offset < 0) {
+      return false;
+    }
+  } else {
+    // Holes are made by seeking past them, so without the ability to seek,
+    // the full memory is written in its entirety.
+    if (memory64_list_) {
+      memory64_list_->SetSparse(false);
+    }
+
+    // Without the ability to rewind, the header is only written once, so it
+    // must carry the final signature from the start.
+    header_.Signature = MINIDUMP_SIGNATURE;
+  }
+
+  std::vector<MinidumpWritable*> write_sequence;
+  FileOffset size;
+  if (!LayOutTree(&write_sequence, &size)) {
     return false;
   }
 
-  if (!MinidumpWritable::WriteEverything(file_writer)) {
+  if (reserve_file) {
+    // The layout accounts for everything that will be written, so the file
+    // won’t need to grow again.
+    const FileOffset reserve_start_offset = reserve_file->Seek(0, SEEK_CUR);
+    if (reserve_start_offset < 0) {
+      return false;
+    }
+    uint64_t end_offset = static_cast<uint64_t>(reserve_start_offset + size);
+    if (write_stream_index_) {
+      end_offset += StreamIndexSize(streams_.size());
+    }
+    if (end_offset <= std::numeric_limits<size_t>::max()) {
+      reserve_file->Reserve(static_cast<size_t>(end_offset));
+    }
+  }
+
+  // Now that each stream’s location is known, keep a copy of the streams’
+  // data as it’s written, so that it can be hashed for the stream index.
+  std::vector<MinidumpCrashpadStreamIndexEntry> stream_index;
+  std::unique_ptr<RangeCapturingFileWriter> capturing_file_writer;
+  FileWriterInterface* tree_file_writer = file_writer;
+  if (write_stream_index_) {
+    capturing_file_writer.reset(
+        new RangeCapturingFileWriter(file_writer, start_offset));
+    for (internal::MinidumpStreamWriter* stream : streams_) {
+      const MINIDUMP_DIRECTORY* directory = stream->DirectoryListEntry();
+      MinidumpCrashpadStreamIndexEntry entry = {};
+      entry.stream_type = directory->StreamType;
+      entry.offset = directory->Location.Rva;
+      entry.size = directory->Location.DataSize;
+      stream_index.push_back(entry);
+      capturing_file_writer->AddRange(directory->Location.Rva,
+                                      directory->Location.DataSize);
+    }
+    tree_file_writer = capturing_file_writer.get();
+  }
+
+  if (!WriteLaidOutTree(
+          write_sequence, tree_file_writer, write_thread_count_)) {
     return false;
   }
 
+  if (!allow_seek) {
+    return !write_stream_index_ ||
+           WriteStreamIndex(file_writer,
+                            size,
+                            capturing_file_writer->range_contents(),
+                            &stream_index);
+  }
+
   FileOffset end_offset = file_writer->Seek(0, SEEK_CUR);
   if (end_offset < 0) {
     return false;
   }
 
+  // Thread stacks and other memory are read from the process as they’re
+  // written, so the reads are only all counted now.
+  if (capture_performance_ &&
+      !capture_performance_->RewriteMemoryReads(tree_file_writer,
+                                                start_offset)) {
+    return false;
+  }
+
+  // The index follows everything else, and is written once the streams’ data
+  // is final.
+  if (write_stream_index_) {
+    if (file_writer->Seek(end_offset, SEEK_SET) != end_offset ||
+        !WriteStreamIndex(file_writer,
+                          end_offset - start_offset,
+                          capturing_file_writer->range_contents(),
+                          &stream_index)) {
+      return false;
+    }
+
+    end_offset = file_writer->Seek(0, SEEK_CUR);
+    if (end_offset < 0) {
+      return false;
+    }
+  }
+
   // Now that the entire minidump file has been completely written, go back to
   // the beginning and rewrite the header with the correct signature to identify
   // it as a valid minidump file.
@@ -247,13 +912,71 @@ bool MinidumpFileWriter::WriteEverything(FileWriterInterface* file_writer) {
   return file_writer->Seek(end_offset, SEEK_SET) >= 0;
 }
 
+bool MinidumpFileWriter::WriteStreamIndex(
+    FileWriterInterface* file_writer,
+    FileOffset offset,
+    const std::vector<std::string>& stream_contents,
+    std::vector<MinidumpCrashpadStreamIndexEntry>* entries) {
+  DCHECK_EQ(stream_contents.size(), entries->size());
+
+  for (size_t index = 0; index < entries->size(); ++index) {
+    (*entries)[index].xxhash64 = XXHash64(
+        stream_contents[index].data(), stream_contents[index].size(), 0);
+  }
+
+  // Align the index as the rest of the file’s structures are aligned.
+  static constexpr char kZeroes[kStreamIndexAlignment - 1] = {};
+  const size_t padding =
+      (kStreamIndexAlignment - offset % kStreamIndexAlignment) %
+      kStreamIndexAlignment;
+
+  MinidumpCrashpadStreamIndexFooter footer = {};
+  footer.version = MinidumpCrashpadStreamIndexFooter::kVersion;
+  footer.index = static_cast<RVA64>(offset + padding);
+  footer.size_of_entry = sizeof(MinidumpCrashpadStreamIndexEntry);
+  footer.index_xxhash64 =
+      XXHash64(entries->data(),
+               entries->size() * sizeof(MinidumpCrashpadStreamIndexEntry),
+               0);
+  footer.signature = MinidumpCrashpadStreamIndexFooter::kSignature;
+  if (!AssignIfInRange(&footer.count, entries->size())) {
+    LOG(ERROR) << "stream_count " << entries->size() << " out of range";
+    return false;
+  }
+
+  std::vector<WritableIoVec> iovecs;
+  WritableIoVec iov;
+  if (padding) {
+    iov.iov_base = kZeroes;
+    iov.iov_len = padding;
+    iovecs.push_back(iov);
+  }
+  if (!entries->empty()) {
+    iov.iov_base = entries->data();
+    iov.iov_len = entries->size() * sizeof(MinidumpCrashpadStreamIndexEntry);
+    iovecs.push_back(iov);
+  }
+  iov.iov_base = &footer;
+  iov.iov_len = sizeof(footer);
+  iovecs.push_back(iov);
+
+  return file_writer->WriteIoVec(&iovecs);
+}
+
 bool MinidumpFileWriter::Freeze() {
   DCHECK_EQ(state(), kStateMutable);
 
-  if (!MinidumpWritable::Freeze()) {
-    return false;
+  {
+    internal::ScopedMinidumpStringTable scoped_string_table(&string_table_);
+    if (!MinidumpWritable::Freeze()) {
+      return false;
+    }
   }
 
+  // Now that every object has registered its pointers to the strings that it
+  // refers to, point references to duplicate strings at the shared copy.
+  string_table_.TransferRegistrations();
+
   size_t stream_count = streams_.size();
   CHECK_EQ(stream_count, stream_types_.size());
 
@@ -316,4 +1039,18 @@ bool MinidumpFileWriter::WriteObject(FileWriterInterface* file_writer) {
   return file_writer->WriteIoVec(&iovecs);
 }
 
+bool GenerateMinidumpInMemory(const ProcessSnapshot* process_snapshot,
+                              std::vector<ChunkedBufferFile::Buffer>* buffers) {
+  MinidumpFileWriter minidump;
+  minidump.InitializeFromSnapshot(process_snapshot);
+
+  ChunkedBufferFile buffer_file;
+  if (!minidump.WriteMinidumpToMemory(&buffer_file)) {
+    return false;
+  }
+
+  *buffers = buffer_file.TakeBuffers();
+  return true;
+}
+
 }  // namespace crashpad
@@ -21,18 +21,32 @@
 
 #include <memory>
 #include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "base/macros.h"
+#include "minidump/minidump_capture_performance_writer.h"
 #include "minidump/minidump_extensions.h"
+#include "minidump/minidump_memory_info_writer.h"
+#include "minidump/minidump_size_budget.h"
+#include "minidump/minidump_static_stream_cache.h"
 #include "minidump/minidump_stream_writer.h"
+#include "minidump/minidump_string_table.h"
 #include "minidump/minidump_writable.h"
+#include "minidump/minidump_writable_arena.h"
+#include "snapshot/top_frames.h"
+#include "util/file/chunked_buffer_file.h"
 #include "util/file/file_io.h"
 #include "util/stdlib/pointer_container.h"
 
 namespace crashpad {
 
+class MemoryReadTrace;
+class MemorySnapshot;
 class ProcessSnapshot;
+class MinidumpMemory64ListWriter;
+class MinidumpStreamReferenceListWriter;
 class MinidumpUserExtensionStreamDataSource;
 
 //! \brief The root-level object in a minidump file.
@@ -60,27 +74,257 @@ class MinidumpFileWriter final : public internal::MinidumpWritable {
   //!  - kMinidumpStreamTypeSystemInfo
   //!  - kMinidumpStreamTypeMiscInfo
   //!  - kMinidumpStreamTypeThreadList
+  //!  - kMinidumpStreamTypeThreadNameList (if any thread has a name)
   //!  - kMinidumpStreamTypeException (if present)
+  //!  - kMinidumpStreamTypeCrashpadTopFrames (if SetTopFrames() was called,
+  //!    and an exception is present)
   //!  - kMinidumpStreamTypeModuleList
   //!  - kMinidumpStreamTypeUnloadedModuleList (if present)
   //!  - kMinidumpStreamTypeCrashpadInfo (if present)
+  //!  - kMinidumpStreamTypeCrashpadStreamReferenceList (if present)
   //!  - kMinidumpStreamTypeMemoryInfoList (if present)
   //!  - kMinidumpStreamTypeHandleData (if present)
+  //!  - kMinidumpStreamTypeCrashpadCapturePerformance (if
+  //!    SetCapturePhaseTimes() was called)
+  //!  - kMinidumpStreamTypeCrashpadReconstructibleMemoryList (if
+  //!    SetExcludeReconstructibleMemory() was called, and memory was excluded)
   //!  - User streams (if present)
   //!  - kMinidumpStreamTypeMemoryList
+  //!  - kMinidumpStreamTypeMemory64List (if SetFullMemory() was called)
+  //!
+  //! If a size budget has been set by SetSizeBudget(), the amount of memory
+  //! data taken from \a process_snapshot is limited accordingly. Only the
+  //! streams selected by SetStreamSelection() are added, and thread stacks are
+  //! limited as set by SetStackSizeLimit().
   //!
   //! \param[in] process_snapshot The process snapshot to use as source data.
   //!
   //! \note Valid in #kStateMutable. No mutator methods may be called before
-  //!     this method, and it is not normally necessary to call any mutator
-  //!     methods after this method.
+  //!     this method, other than SetSizeBudget(), SetStreamSelection(),
+  //!     SetStackSizeLimit(), SetCollapseIdenticalStacks(),
+  //!     SetStaticStreamCache(), SetMemoryInfoListOptions(),
+  //!     SetCapturePhaseTimes(), SetTopFrames(), SetFullMemory(),
+  //!     SetExcludeReconstructibleMemory(), and SetWriteThreadCount(), and it
+  //!     is not normally necessary to call any mutator methods after this
+  //!     method.
   void InitializeFromSnapshot(const ProcessSnapshot* process_snapshot);
 
+  //! \brief Limits the size of the minidump file populated by
+  //!     InitializeFromSnapshot().
+  //!
+  //! When the minidump file would otherwise be larger than \a size_budget,
+  //! InitializeFromSnapshot() leaves out data in order of increasing
+  //! importance until it fits: first, memory indirectly referenced by thread
+  //! stacks and registers; next, memory map entries from the end of the
+  //! kMinidumpStreamTypeMemoryInfoList stream; and finally, the portions of
+  //! thread stacks furthest from their stack pointers. The stack of the thread
+  //! that raised the exception is always written in full.
+  //!
+  //! The budget accounts only for streams added by InitializeFromSnapshot().
+  //! Streams added afterwards, such as by AddUserExtensionStream(), are not
+  //! counted against it. If the budget can’t be met by leaving out memory
+  //! data, a warning is logged and the minidump file is written as small as
+  //! possible, but still larger than \a size_budget.
+  //!
+  //! \param[in] size_budget The maximum size of the minidump file, in bytes.
+  //!     `0` for no limit, which is the default.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetSizeBudget(size_t size_budget);
+
+  //! \brief Restricts the streams that InitializeFromSnapshot() adds.
+  //!
+  //! Streams of types not in \a stream_types are left out, along with any
+  //! data that only they would carry. Thread stacks are carried by
+  //! kMinidumpStreamTypeThreadList, so they are retained without
+  //! kMinidumpStreamTypeMemoryList, although memory readers that consult only
+  //! the memory list won’t find them.
+  //!
+  //! \param[in] stream_types The types of the streams to add. Empty to add
+  //!     every stream, which is the default.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetStreamSelection(const std::set<MinidumpStreamType>& stream_types);
+
+  //! \brief Limits the number of bytes of each thread’s stack that
+  //!     InitializeFromSnapshot() takes, retaining the memory nearest each
+  //!     stack pointer.
+  //!
+  //! As with SetSizeBudget(), the stack of the thread that raised the
+  //! exception is always written in full.
+  //!
+  //! \param[in] stack_size_limit The maximum number of bytes of each stack.
+  //!     `0` for no limit, which is the default.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetStackSizeLimit(size_t stack_size_limit);
+
+  //! \brief Arranges for InitializeFromSnapshot() to write the contents of
+  //!     identical thread stacks only once.
+  //!
+  //! This is useful for processes with large pools of idle threads. The stack
+  //! of the thread that raised the exception is always written on its own. See
+  //! MinidumpThreadListWriter::SetCollapseIdenticalStacks().
+  //!
+  //! \param[in] collapse Whether to collapse identical stacks. The default is
+  //!     `false`.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetCollapseIdenticalStacks(bool collapse);
+
+  //! \brief Arranges for InitializeFromSnapshot() to omit memory that can be
+  //!     reconstructed from module files, recording what it omitted in a
+  //!     kMinidumpStreamTypeCrashpadReconstructibleMemoryList stream.
+  //!
+  //! Memory mapped from a module without being writable, such as its code and
+  //! read-only data, is omitted from the memory given to SetFullMemory(), and
+  //! extra memory ranges lying entirely within such memory are omitted from
+  //! the kMinidumpStreamTypeMemoryList stream. Thread stacks are never
+  //! omitted. This relies on ProcessSnapshot::MemoryMap(), so has no effect
+  //! for snapshots without a memory map. See
+  //! MinidumpReconstructibleMemoryListWriter.
+  //!
+  //! \param[in] exclude Whether to omit reconstructible memory. The default is
+  //!     `false`.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetExcludeReconstructibleMemory(bool exclude);
+
+  //! \brief Arranges for InitializeFromSnapshot() to omit streams that are
+  //!     unchanged since an earlier minidump file of the same process.
+  //!
+  //! The system information and module list streams are compared against
+  //! those recorded in \a cache. Each that is identical is left out of this
+  //! minidump file, and a kMinidumpStreamTypeCrashpadStreamReferenceList
+  //! stream identifies the earlier minidump file that carries it instead. Each
+  //! that differs is written in full, and will be recorded in \a cache by
+  //! CommitStaticStreams().
+  //!
+  //! \param[in] cache The cache to consult. Weak. `nullptr` to write every
+  //!     stream in full, which is the default.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetStaticStreamCache(MinidumpStaticStreamCache* cache);
+
+  //! \brief Reduces the kMinidumpStreamTypeMemoryInfoList stream populated by
+  //!     InitializeFromSnapshot().
+  //!
+  //! Processes with many memory map regions, such as those that generate code
+  //! at run time, can otherwise produce a stream much larger than the rest of
+  //! the minidump file. For the purpose of \a options, memory is considered
+  //! captured if it is part of a thread stack or of any memory range added to
+  //! the kMinidumpStreamTypeMemoryList stream.
+  //!
+  //! \param[in] options The options to use. By default, every memory map region
+  //!     is recorded.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetMemoryInfoListOptions(const MinidumpMemoryInfoListOptions& options);
+
+  //! \brief Arranges for InitializeFromSnapshot() to add a
+  //!     kMinidumpStreamTypeCrashpadCapturePerformance stream, recording \a
+  //!     phase_times along with the number of threads, modules, and memory
+  //!     ranges captured.
+  //!
+  //! \param[in] phase_times How long the phases of capturing the snapshot
+  //!     given to InitializeFromSnapshot() took.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetCapturePhaseTimes(const MinidumpCapturePhaseTimes& phase_times);
+
+  //! \brief Arranges for the kMinidumpStreamTypeCrashpadCapturePerformance
+  //!     stream to carry the reads of the process’ memory counted by \a trace.
+  //!
+  //! The stream is only added if SetCapturePhaseTimes() is also called. When
+  //! the minidump file is written to a file writer that can seek, the stream
+  //! is rewritten after the rest of the file, so that it accounts for the
+  //! memory read while writing. Otherwise, it accounts for the reads made
+  //! before it was written.
+  //!
+  //! \param[in] trace The trace counting the reads. This object does not take
+  //!     ownership of \a trace, which must outlive it.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetMemoryReadTrace(const MemoryReadTrace* trace);
+
+  //! \brief Arranges for InitializeFromSnapshot() to add a
+  //!     kMinidumpStreamTypeCrashpadTopFrames stream carrying \a frames.
+  //!
+  //! The stream is only added if the snapshot has an exception, as the frames
+  //! are taken to be those of the exception thread. See
+  //! MinidumpTopFramesWriter.
+  //!
+  //! \param[in] frames The innermost frames of the exception thread’s stack.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetTopFrames(const std::vector<TopFrame>& frames);
+
+  //! \brief Arranges for InitializeFromSnapshot() to add a
+  //!     kMinidumpStreamTypeMemory64List stream containing \a memory_snapshots,
+  //!     and to identify the minidump file as ::MiniDumpWithFullMemory.
+  //!
+  //! This is meant for minidump files that capture most or all of a process’
+  //! memory, such as the regions of its memory map. The memory is written in a
+  //! single sequential pass at the end of the file, after the
+  //! kMinidumpStreamTypeMemoryList stream’s memory, and may extend beyond the
+  //! first 4GB of the file. See MinidumpMemory64ListWriter. It isn’t counted
+  //! against any budget set by SetSizeBudget().
+  //!
+  //! \param[in] memory_snapshots The memory to capture. The snapshots are not
+  //!     owned by this object, and must remain valid until it has been
+  //!     written. By default, there are none, and no stream is added.
+  //! \param[in] sparse Whether blocks of memory that are entirely zero are to
+  //!     be left as holes in a sparse file instead of being written, as
+  //!     described at MinidumpMemory64ListWriter::SetSparse(). This is ignored
+  //!     by WriteMinidump() when seeking isn’t allowed.
+  //!
+  //! \note Valid in #kStateMutable, before InitializeFromSnapshot().
+  void SetFullMemory(const std::vector<const MemorySnapshot*>& memory_snapshots,
+                     bool sparse);
+
+  //! \brief Records the streams written in full by this object in the cache
+  //!     given to SetStaticStreamCache(), so that later minidump files of the
+  //!     same process may refer to them.
+  //!
+  //! Call this once the minidump file has been durably stored and will be
+  //! available to whoever reassembles later minidump files that refer to it.
+  //!
+  //! \note Valid in #kStateWritten.
+  void CommitStaticStreams();
+
   //! \brief Sets MINIDUMP_HEADER::Timestamp.
   //!
   //! \note Valid in #kStateMutable.
   void SetTimestamp(time_t timestamp);
 
+  //! \brief Sets the number of threads used to serialize the minidump file.
+  //!
+  //! By default, objects are serialized on the calling thread. With a larger
+  //! \a thread_count, independent streams and memory ranges are serialized
+  //! concurrently, as described in internal::MinidumpWritable::WriteTree().
+  //! This is most useful when a large amount of memory must be read from the
+  //! snapshot process, which can proceed in parallel.
+  //!
+  //! Objects added to this writer, and the snapshots they read from, must be
+  //! safe to write concurrently when \a thread_count is greater than `1`. This
+  //! is the case for all objects created by InitializeFromSnapshot().
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetWriteThreadCount(size_t thread_count);
+
+  //! \brief Arranges for the minidump file to end with a stream index.
+  //!
+  //! The index records the offset, size, and hash of each stream’s data, and
+  //! is followed by a MinidumpCrashpadStreamIndexFooter, which locates it from
+  //! the end of the file. This allows readers holding only part of the file to
+  //! find and validate individual streams.
+  //!
+  //! \param[in] write_stream_index Whether to write the index. The default is
+  //!     `false`.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetWriteStreamIndex(bool write_stream_index);
+
   //! \brief Adds a stream to the minidump file and arranges for a
   //!     MINIDUMP_DIRECTORY entry to point to it.
   //!
@@ -124,6 +368,49 @@ class MinidumpFileWriter final : public internal::MinidumpWritable {
       std::unique_ptr<MinidumpUserExtensionStreamDataSource>
           user_extension_stream_data);
 
+  //! \brief Writes this object to a minidump file.
+  //!
+  //! Same as \ref WriteEverything, but give the option to disable the seek. It
+  //! is typically used to write to stream backed \ref FileWriterInterface
+  //! which doesn’t support seeking, such as a pipe or a socket.
+  //!
+  //! The layout of the entire file, including the MINIDUMP_HEADER, the stream
+  //! directory, and every stream, is determined before anything is written, so
+  //! that each object is written exactly once, in file order.
+  //!
+  //! \param[in] file_writer The file writer to receive the minidump file’s
+  //!     content.
+  //! \param[in] allow_seek Whether seeking is allowed. If `true`, the
+  //!     MINIDUMP_HEADER::Signature field is written last, as described in
+  //!     WriteEverything(). If `false`, the final signature is written along
+  //!     with the rest of the header and \a file_writer is never seeked,
+  //!     although an incompletely-written minidump file will then not be
+  //!     distinguishable from a valid one by its signature alone, unless it
+  //!     ends with the footer written by SetWriteStreamIndex().
+  //!
+  //! \return `true` on success. `false` on failure, with an appropriate message
+  //!     logged.
+  //!
+  //! \note Valid in #kStateMutable.
+  bool WriteMinidump(FileWriterInterface* file_writer, bool allow_seek);
+
+  //! \brief Writes this object to a minidump file held in memory.
+  //!
+  //! This is equivalent to calling WriteMinidump() with \a allow_seek set to
+  //! `true`, except that once the layout of the file has been determined,
+  //! storage for all of it is reserved in \a buffer_file. A minidump file
+  //! written to an empty ChunkedBufferFile therefore occupies a single buffer,
+  //! which is allocated once and never copied, and which can be handed off
+  //! with ChunkedBufferFile::TakeBuffers().
+  //!
+  //! \param[in] buffer_file The file to receive the minidump file’s content.
+  //!
+  //! \return `true` on success. `false` on failure, with an appropriate message
+  //!     logged.
+  //!
+  //! \note Valid in #kStateMutable.
+  bool WriteMinidumpToMemory(ChunkedBufferFile* buffer_file);
+
   // MinidumpWritable:
 
   //! \copydoc internal::MinidumpWritable::WriteEverything()
@@ -133,6 +420,10 @@ class MinidumpFileWriter final : public internal::MinidumpWritable {
   //! rewinds to the beginning of the file and writes the correct value for this
   //! field. This prevents incompletely-written minidump files from being
   //! mistaken for valid ones.
+  //!
+  //! This is equivalent to calling WriteMinidump() with \a allow_seek set to
+  //! `true`, except that writes are coalesced through a BufferedFileWriter so
+  //! that \a file_writer receives a smaller number of larger writes.
   bool WriteEverything(FileWriterInterface* file_writer) override;
 
  protected:
@@ -144,15 +435,122 @@ class MinidumpFileWriter final : public internal::MinidumpWritable {
   bool WriteObject(FileWriterInterface* file_writer) override;
 
  private:
+  // Does the work of WriteMinidump() and WriteMinidumpToMemory(). If
+  // |reserve_file| is not nullptr, it is |file_writer|, and storage for the
+  // entire minidump file is reserved in it once the file’s layout has been
+  // determined.
+  bool WriteMinidumpReserving(FileWriterInterface* file_writer,
+                              bool allow_seek,
+                              ChunkedBufferFile* reserve_file);
+
+  // Writes the stream index and its footer at |offset|, the current position
+  // of |file_writer| relative to the start of the minidump file. |entries|
+  // locates each stream in streams_, in order, and |stream_contents| holds
+  // their data, from which the entries’ hashes are filled in.
+  bool WriteStreamIndex(
+      FileWriterInterface* file_writer,
+      FileOffset offset,
+      const std::vector<std::string>& stream_contents,
+      std::vector<MinidumpCrashpadStreamIndexEntry>* entries);
+
+  // Does the work of InitializeFromSnapshot(), limiting the data taken from
+  // |process_snapshot| according to |plan|.
+  void InitializeFromSnapshotWithPlan(
+      const ProcessSnapshot* process_snapshot,
+      const internal::MinidumpSizeBudgetPlan& plan);
+
+  // Tightens |plan| until a minidump file populated from |process_snapshot|
+  // according to it fits within size_budget_, by laying out trial minidump
+  // files and measuring them.
+  void PlanSizeBudget(const ProcessSnapshot* process_snapshot,
+                      internal::MinidumpSizeBudgetPlan* plan);
+
+  // Determines whether static_stream_cache_ holds a copy of |stream| from an
+  // earlier minidump file. If so, adds a reference to that file to
+  // |stream_references| and returns true. Otherwise, arranges for
+  // CommitStaticStreams() to cache |stream| and returns false. |stream| is
+  // consumed in the process, and can’t be added to this object.
+  bool ReferenceCachedStream(
+      std::unique_ptr<internal::MinidumpStreamWriter> stream,
+      MinidumpStreamReferenceListWriter* stream_references);
+
+  // Returns whether streams of |stream_type| were selected by
+  // SetStreamSelection().
+  bool IsStreamSelected(MinidumpStreamType stream_type) const;
+
+  // Calls AddStream() if |stream| was selected by SetStreamSelection(), and
+  // otherwise discards it and returns true.
+  bool AddSelectedStream(
+      std::unique_ptr<internal::MinidumpStreamWriter> stream);
+
   MINIDUMP_HEADER header_;
+
+  // Backs the objects created by InitializeFromSnapshot(). This must be
+  // declared before streams_ so that it outlives them.
+  internal::MinidumpWritableArena arena_;
+
   PointerVector<internal::MinidumpStreamWriter> streams_;
 
+  // Shares a single copy of each distinct string among all streams.
+  internal::MinidumpStringTable string_table_;
+
   // Protects against multiple streams with the same ID being added.
   std::set<MinidumpStreamType> stream_types_;
 
+  size_t write_thread_count_;
+  bool write_stream_index_;
+  size_t size_budget_;
+  std::set<MinidumpStreamType> selected_stream_types_;
+  size_t stack_size_limit_;
+  bool collapse_identical_stacks_;
+  bool exclude_reconstructible_memory_;
+  MinidumpMemoryInfoListOptions memory_info_list_options_;
+  MinidumpCapturePhaseTimes capture_phase_times_;
+  bool write_capture_performance_;
+  const MemoryReadTrace* memory_read_trace_;  // weak
+  std::vector<TopFrame> top_frames_;
+  std::vector<const MemorySnapshot*> full_memory_;  // weak
+  bool full_memory_sparse_;
+
+  // The stream added for full_memory_, if any, so that WriteMinidump() can stop
+  // it from seeking.
+  MinidumpMemory64ListWriter* memory64_list_;  // weak
+
+  // The stream that carries memory_read_trace_, if any, so that WriteMinidump()
+  // can rewrite it once the rest of the file has been written.
+  MinidumpCapturePerformanceWriter* capture_performance_;  // weak
+
+  MinidumpStaticStreamCache* static_stream_cache_;  // weak
+  MinidumpStaticStreamCache::ProcessKey static_stream_process_;
+  UUID report_id_;
+
+  // Streams written in full, as (stream type, stream contents) pairs, to be
+  // recorded in static_stream_cache_ by CommitStaticStreams().
+  std::vector<std::pair<MinidumpStreamType, std::string>>
+      static_streams_to_commit_;
+
   DISALLOW_COPY_AND_ASSIGN(MinidumpFileWriter);
 };
 
+//! \brief Writes a minidump file of \a process_snapshot to memory, as the
+//!     `generate_dump` tool writes one to disk.
+//!
+//! This is meant for embedders that send minidump files over channels of their
+//! own and never store them as files. The minidump file is written with the
+//! default options of MinidumpFileWriter, as by
+//! MinidumpFileWriter::WriteMinidumpToMemory(). To set other options, use
+//! MinidumpFileWriter directly.
+//!
+//! \param[in] process_snapshot The process to write a minidump file of.
+//! \param[out] buffers The minidump file’s contents, which are the
+//!     concatenation of the buffers, in order. Ownership of them passes to the
+//!     caller, without their contents being copied.
+//!
+//! \return `true` on success. `false` on failure, with an appropriate message
+//!     logged.
+bool GenerateMinidumpInMemory(const ProcessSnapshot* process_snapshot,
+                              std::vector<ChunkedBufferFile::Buffer>* buffers);
+
 }  // namespace crashpad
 
 #endif  // CRASHPAD_MINIDUMP_MINIDUMP_WRITER_H_
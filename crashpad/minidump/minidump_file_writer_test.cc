@@ -19,6 +19,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
@@ -30,6 +31,7 @@
 #include "minidump/test/minidump_file_writer_test_util.h"
 #include "minidump/test/minidump_user_extension_stream_util.h"
 #include "minidump/test/minidump_writable_test_util.h"
+#include "snapshot/minidump/process_snapshot_minidump.h"
 #include "snapshot/test/test_cpu_context.h"
 #include "snapshot/test/test_exception_snapshot.h"
 #include "snapshot/test/test_memory_snapshot.h"
@@ -38,7 +40,9 @@
 #include "snapshot/test/test_system_snapshot.h"
 #include "snapshot/test/test_thread_snapshot.h"
 #include "test/gtest_death_check.h"
+#include "util/file/chunked_buffer_file.h"
 #include "util/file/string_file.h"
+#include "util/misc/xxhash.h"
 
 namespace crashpad {
 namespace test {
@@ -131,6 +135,59 @@ TEST(MinidumpFileWriter, OneStream) {
   EXPECT_EQ(memcmp(stream_data, expected_stream.c_str(), kStreamSize), 0);
 }
 
+// A StringFile that refuses to seek, standing in for a pipe or socket.
+class NonSeekableStringFile final : public StringFile {
+ public:
+  NonSeekableStringFile() : StringFile() {}
+  ~NonSeekableStringFile() override {}
+
+  // FileSeekerInterface:
+  FileOffset Seek(FileOffset offset, int whence) override {
+    ADD_FAILURE() << "unexpected Seek";
+    return -1;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NonSeekableStringFile);
+};
+
+TEST(MinidumpFileWriter, WriteMinidumpWithoutSeek) {
+  constexpr time_t kTimestamp = 0x155d2fb8;
+  constexpr size_t kStreamSize = 5;
+  constexpr MinidumpStreamType kStreamType =
+      static_cast<MinidumpStreamType>(0x4d);
+  constexpr uint8_t kStreamValue = 0x5a;
+
+  MinidumpFileWriter seekable_minidump_file;
+  seekable_minidump_file.SetTimestamp(kTimestamp);
+  ASSERT_TRUE(seekable_minidump_file.AddStream(base::WrapUnique(
+      new TestStream(kStreamType, kStreamSize, kStreamValue))));
+
+  StringFile seekable_string_file;
+  ASSERT_TRUE(seekable_minidump_file.WriteMinidump(&seekable_string_file,
+                                                   true));
+
+  MinidumpFileWriter minidump_file;
+  minidump_file.SetTimestamp(kTimestamp);
+  ASSERT_TRUE(minidump_file.AddStream(base::WrapUnique(
+      new TestStream(kStreamType, kStreamSize, kStreamValue))));
+
+  NonSeekableStringFile string_file;
+  ASSERT_TRUE(minidump_file.WriteMinidump(&string_file, false));
+
+  constexpr size_t kFileSize =
+      sizeof(MINIDUMP_HEADER) + sizeof(MINIDUMP_DIRECTORY) + kStreamSize;
+  ASSERT_EQ(string_file.string().size(), kFileSize);
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(string_file.string(), &directory);
+  ASSERT_NO_FATAL_FAILURE(VerifyMinidumpHeader(header, 1, kTimestamp));
+  ASSERT_TRUE(directory);
+
+  EXPECT_EQ(string_file.string(), seekable_string_file.string());
+}
+
 TEST(MinidumpFileWriter, AddUserExtensionStream) {
   MinidumpFileWriter minidump_file;
   constexpr time_t kTimestamp = 0x155d2fb8;
@@ -393,6 +450,180 @@ TEST(MinidumpFileWriter, InitializeFromSnapshot_Basic) {
   EXPECT_EQ(memory_list->MemoryRanges[0].Memory.DataSize, kPebSize);
 }
 
+// Populates process_snapshot with a thread and several extra memory regions,
+// enough to give MinidumpWritable::WriteTree() several objects to serialize.
+void PopulateProcessSnapshotForConcurrentWrite(
+    TestProcessSnapshot* process_snapshot) {
+  constexpr timeval kSnapshotTimeval = {static_cast<time_t>(0x4976043c), 0};
+  process_snapshot->SetSnapshotTime(kSnapshotTimeval);
+
+  auto system_snapshot = base::WrapUnique(new TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemMacOSX);
+  process_snapshot->SetSystem(std::move(system_snapshot));
+
+  auto thread_snapshot = base::WrapUnique(new TestThreadSnapshot());
+  InitializeCPUContextX86_64(thread_snapshot->MutableContext(), 5);
+  auto stack = base::WrapUnique(new TestMemorySnapshot());
+  stack->SetAddress(0x7fff0000);
+  stack->SetSize(0x3000);
+  stack->SetValue('s');
+  thread_snapshot->SetStack(std::move(stack));
+  process_snapshot->AddThread(std::move(thread_snapshot));
+
+  for (size_t index = 0; index < 16; ++index) {
+    auto memory_snapshot = base::WrapUnique(new TestMemorySnapshot());
+    memory_snapshot->SetAddress(0x10000000 + index * 0x10000);
+    memory_snapshot->SetSize(0x100 * (index + 1));
+    memory_snapshot->SetValue('a' + index);
+    process_snapshot->AddExtraMemory(std::move(memory_snapshot));
+  }
+}
+
+TEST(MinidumpFileWriter, ConcurrentWrite) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshotForConcurrentWrite(&process_snapshot);
+
+  MinidumpFileWriter sequential_minidump_file_writer;
+  sequential_minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile sequential_string_file;
+  ASSERT_TRUE(
+      sequential_minidump_file_writer.WriteEverything(&sequential_string_file));
+
+  for (size_t thread_count : {2, 4, 32}) {
+    SCOPED_TRACE(thread_count);
+
+    MinidumpFileWriter minidump_file_writer;
+    minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+    minidump_file_writer.SetWriteThreadCount(thread_count);
+
+    StringFile string_file;
+    ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+    EXPECT_EQ(string_file.string(), sequential_string_file.string());
+  }
+}
+
+TEST(MinidumpFileWriter, WriteMinidumpToMemory) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshotForConcurrentWrite(&process_snapshot);
+
+  MinidumpFileWriter string_minidump_file_writer;
+  string_minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+  StringFile string_file;
+  ASSERT_TRUE(string_minidump_file_writer.WriteEverything(&string_file));
+
+  // The storage reserved for the laid-out file holds all of it.
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+  ChunkedBufferFile buffer_file;
+  ASSERT_TRUE(minidump_file_writer.WriteMinidumpToMemory(&buffer_file));
+  std::vector<ChunkedBufferFile::Buffer> buffers = buffer_file.TakeBuffers();
+  ASSERT_EQ(buffers.size(), 1u);
+  EXPECT_EQ(std::string(buffers[0].begin(), buffers[0].end()),
+            string_file.string());
+
+  buffers.clear();
+  ASSERT_TRUE(GenerateMinidumpInMemory(&process_snapshot, &buffers));
+  ASSERT_EQ(buffers.size(), 1u);
+  EXPECT_EQ(std::string(buffers[0].begin(), buffers[0].end()),
+            string_file.string());
+}
+
+// Verifies that |minidump| ends with a stream index consistent with its stream
+// directory.
+void VerifyStreamIndex(const std::string& minidump) {
+  using Footer = MinidumpCrashpadStreamIndexFooter;
+  using Entry = MinidumpCrashpadStreamIndexEntry;
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header = MinidumpHeaderAtStart(minidump, &directory);
+  ASSERT_TRUE(header);
+  ASSERT_TRUE(directory);
+
+  ASSERT_GE(minidump.size(), sizeof(Footer));
+  Footer footer;
+  memcpy(&footer, &minidump[minidump.size() - sizeof(footer)], sizeof(footer));
+  EXPECT_EQ(footer.signature, Footer::kSignature);
+  EXPECT_EQ(footer.version, Footer::kVersion);
+  ASSERT_EQ(footer.count, header->NumberOfStreams);
+  ASSERT_EQ(footer.size_of_entry, sizeof(Entry));
+  EXPECT_EQ(footer.index % 4, 0u);
+  ASSERT_EQ(footer.index + footer.count * sizeof(Entry),
+            minidump.size() - sizeof(footer));
+  EXPECT_EQ(XXHash64(&minidump[footer.index], footer.count * sizeof(Entry), 0),
+            footer.index_xxhash64);
+
+  for (size_t index = 0; index < footer.count; ++index) {
+    SCOPED_TRACE(index);
+
+    Entry entry;
+    memcpy(&entry, &minidump[footer.index + index * sizeof(entry)],
+           sizeof(entry));
+    EXPECT_EQ(entry.stream_type, directory[index].StreamType);
+    ASSERT_EQ(entry.offset, directory[index].Location.Rva);
+    ASSERT_EQ(entry.size, directory[index].Location.DataSize);
+    EXPECT_EQ(entry.xxhash64,
+              XXHash64(&minidump[entry.offset], entry.size, 0));
+  }
+}
+
+TEST(MinidumpFileWriter, StreamIndex) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshotForConcurrentWrite(&process_snapshot);
+
+  MinidumpFileWriter unindexed_minidump_file_writer;
+  unindexed_minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+  StringFile unindexed_string_file;
+  ASSERT_TRUE(
+      unindexed_minidump_file_writer.WriteEverything(&unindexed_string_file));
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+  minidump_file_writer.SetWriteStreamIndex(true);
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+  ASSERT_NO_FATAL_FAILURE(VerifyStreamIndex(string_file.string()));
+
+  // The index only follows what would otherwise be written.
+  const std::string& unindexed = unindexed_string_file.string();
+  ASSERT_GT(string_file.string().size(), unindexed.size());
+  EXPECT_EQ(string_file.string().substr(0, unindexed.size()), unindexed);
+
+  // Streams read back through the index are verified against it.
+  ProcessSnapshotMinidump process_snapshot_minidump;
+  ASSERT_TRUE(process_snapshot_minidump.Initialize(&string_file));
+  EXPECT_EQ(process_snapshot_minidump.Threads().size(),
+            process_snapshot.Threads().size());
+
+  {
+    SCOPED_TRACE("without seek");
+    MinidumpFileWriter non_seekable_minidump_file_writer;
+    non_seekable_minidump_file_writer.InitializeFromSnapshot(
+        &process_snapshot);
+    non_seekable_minidump_file_writer.SetWriteStreamIndex(true);
+    NonSeekableStringFile non_seekable_string_file;
+    ASSERT_TRUE(non_seekable_minidump_file_writer.WriteMinidump(
+        &non_seekable_string_file, false));
+    EXPECT_EQ(non_seekable_string_file.string(), string_file.string());
+  }
+
+  {
+    SCOPED_TRACE("in memory");
+    MinidumpFileWriter buffer_minidump_file_writer;
+    buffer_minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+    buffer_minidump_file_writer.SetWriteStreamIndex(true);
+    ChunkedBufferFile buffer_file;
+    ASSERT_TRUE(
+        buffer_minidump_file_writer.WriteMinidumpToMemory(&buffer_file));
+    ASSERT_EQ(buffer_file.buffers().size(), 1u);
+    EXPECT_EQ(std::string(buffer_file.buffers()[0].begin(),
+                          buffer_file.buffers()[0].end()),
+              string_file.string());
+  }
+}
+
 TEST(MinidumpFileWriter, InitializeFromSnapshot_Exception) {
   // In a 32-bit environment, this will give a “timestamp out of range” warning,
   // but the test should complete without failure.
@@ -529,6 +760,247 @@ TEST(MinidumpFileWriter, InitializeFromSnapshot_CrashpadInfo) {
                   string_file.string(), directory[6].Location));
 }
 
+TEST(MinidumpFileWriter, InitializeFromSnapshot_RoundTrip) {
+  constexpr uint32_t kSnapshotTime = 0x59a1e2c5;
+  constexpr timeval kSnapshotTimeval = {static_cast<time_t>(kSnapshotTime), 0};
+
+  TestProcessSnapshot process_snapshot;
+  process_snapshot.SetSnapshotTime(kSnapshotTimeval);
+
+  auto system_snapshot = base::WrapUnique(new TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetCPUCount(4);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemMacOSX);
+  system_snapshot->SetOSVersion(10, 12, 6, "16G29");
+  process_snapshot.SetSystem(std::move(system_snapshot));
+
+  constexpr uint64_t kThreadID = 0x1234;
+  constexpr uint64_t kStackAddress = 0x7fff5fbff000;
+  constexpr size_t kStackSize = 0x1000;
+  auto thread_snapshot = base::WrapUnique(new TestThreadSnapshot());
+  thread_snapshot->SetThreadID(kThreadID);
+  InitializeCPUContextX86_64(thread_snapshot->MutableContext(), 5);
+  auto stack_snapshot = base::WrapUnique(new TestMemorySnapshot());
+  stack_snapshot->SetAddress(kStackAddress);
+  stack_snapshot->SetSize(kStackSize);
+  stack_snapshot->SetValue('s');
+  thread_snapshot->SetStack(std::move(stack_snapshot));
+  process_snapshot.AddThread(std::move(thread_snapshot));
+
+  constexpr uint32_t kExceptionCode = 0x10;
+  auto exception_snapshot = base::WrapUnique(new TestExceptionSnapshot());
+  exception_snapshot->SetThreadID(kThreadID);
+  exception_snapshot->SetException(kExceptionCode);
+  InitializeCPUContextX86_64(exception_snapshot->MutableContext(), 11);
+  process_snapshot.SetException(std::move(exception_snapshot));
+
+  constexpr char kModuleName[] = "/usr/lib/libSystem.B.dylib";
+  constexpr uint64_t kModuleAddress = 0x7fff90000000;
+  constexpr uint64_t kModuleSize = 0x2000;
+  auto module_snapshot = base::WrapUnique(new TestModuleSnapshot());
+  module_snapshot->SetName(kModuleName);
+  module_snapshot->SetAddressAndSize(kModuleAddress, kModuleSize);
+  process_snapshot.AddModule(std::move(module_snapshot));
+
+  constexpr uint64_t kExtraMemoryAddress = 0x07f90000;
+  constexpr size_t kExtraMemorySize = 0x280;
+  auto extra_memory_snapshot = base::WrapUnique(new TestMemorySnapshot());
+  extra_memory_snapshot->SetAddress(kExtraMemoryAddress);
+  extra_memory_snapshot->SetSize(kExtraMemorySize);
+  extra_memory_snapshot->SetValue('e');
+  process_snapshot.AddExtraMemory(std::move(extra_memory_snapshot));
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  ASSERT_TRUE(string_file.SeekSet(0));
+  ProcessSnapshotMinidump minidump_snapshot;
+  ASSERT_TRUE(minidump_snapshot.Initialize(&string_file));
+
+  timeval snapshot_time;
+  minidump_snapshot.SnapshotTime(&snapshot_time);
+  EXPECT_EQ(snapshot_time.tv_sec, static_cast<time_t>(kSnapshotTime));
+
+  const SystemSnapshot* system = minidump_snapshot.System();
+  ASSERT_TRUE(system);
+  EXPECT_EQ(system->GetCPUArchitecture(), kCPUArchitectureX86_64);
+  EXPECT_EQ(system->CPUCount(), 4u);
+  EXPECT_EQ(system->GetOperatingSystem(),
+            SystemSnapshot::kOperatingSystemMacOSX);
+  int os_version_major;
+  int os_version_minor;
+  int os_version_bugfix;
+  std::string os_version_build;
+  system->OSVersion(&os_version_major,
+                    &os_version_minor,
+                    &os_version_bugfix,
+                    &os_version_build);
+  EXPECT_EQ(os_version_major, 10);
+  EXPECT_EQ(os_version_minor, 12);
+  EXPECT_EQ(os_version_bugfix, 6);
+
+  std::vector<const ThreadSnapshot*> threads = minidump_snapshot.Threads();
+  ASSERT_EQ(threads.size(), 1u);
+  EXPECT_EQ(threads[0]->ThreadID(), kThreadID);
+  ASSERT_TRUE(threads[0]->Context());
+  ASSERT_EQ(threads[0]->Context()->architecture, kCPUArchitectureX86_64);
+  EXPECT_EQ(threads[0]->Context()->x86_64->rip,
+            process_snapshot.Threads()[0]->Context()->x86_64->rip);
+  const MemorySnapshot* stack = threads[0]->Stack();
+  ASSERT_TRUE(stack);
+  EXPECT_EQ(stack->Address(), kStackAddress);
+  EXPECT_EQ(stack->Size(), kStackSize);
+
+  const ExceptionSnapshot* exception = minidump_snapshot.Exception();
+  ASSERT_TRUE(exception);
+  EXPECT_EQ(exception->ThreadID(), kThreadID);
+  EXPECT_EQ(exception->Exception(), kExceptionCode);
+  ASSERT_TRUE(exception->Context());
+  EXPECT_EQ(exception->Context()->x86_64->rip,
+            process_snapshot.Exception()->Context()->x86_64->rip);
+
+  std::vector<const ModuleSnapshot*> modules = minidump_snapshot.Modules();
+  ASSERT_EQ(modules.size(), 1u);
+  EXPECT_EQ(modules[0]->Name(), kModuleName);
+  EXPECT_EQ(modules[0]->Address(), kModuleAddress);
+  EXPECT_EQ(modules[0]->Size(), kModuleSize);
+
+  // The stack is carried in the memory list too, but is only exposed through
+  // the thread.
+  std::vector<const MemorySnapshot*> extra_memory =
+      minidump_snapshot.ExtraMemory();
+  ASSERT_EQ(extra_memory.size(), 1u);
+  EXPECT_EQ(extra_memory[0]->Address(), kExtraMemoryAddress);
+  EXPECT_EQ(extra_memory[0]->Size(), kExtraMemorySize);
+
+  // The snapshot read back from the minidump file can itself be written.
+  MinidumpFileWriter rewritten_minidump_file_writer;
+  rewritten_minidump_file_writer.InitializeFromSnapshot(&minidump_snapshot);
+
+  StringFile rewritten_string_file;
+  EXPECT_TRUE(
+      rewritten_minidump_file_writer.WriteEverything(&rewritten_string_file));
+}
+
+TEST(MinidumpFileWriter, InitializeFromSnapshot_StreamSelection) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshotForConcurrentWrite(&process_snapshot);
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetStreamSelection(
+      {kMinidumpStreamTypeThreadList, kMinidumpStreamTypeModuleList});
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(string_file.string(), &directory);
+  ASSERT_NO_FATAL_FAILURE(VerifyMinidumpHeader(header, 2, 0x4976043c));
+  ASSERT_TRUE(directory);
+
+  EXPECT_EQ(directory[0].StreamType, kMinidumpStreamTypeThreadList);
+  const MINIDUMP_THREAD_LIST* thread_list =
+      MinidumpWritableAtLocationDescriptor<MINIDUMP_THREAD_LIST>(
+          string_file.string(), directory[0].Location);
+  ASSERT_TRUE(thread_list);
+  ASSERT_EQ(thread_list->NumberOfThreads, 1u);
+
+  // The stack is carried by the thread list even without the memory list.
+  EXPECT_EQ(thread_list->Threads[0].Stack.Memory.DataSize, 0x3000u);
+
+  EXPECT_EQ(directory[1].StreamType, kMinidumpStreamTypeModuleList);
+  EXPECT_TRUE(MinidumpWritableAtLocationDescriptor<MINIDUMP_MODULE_LIST>(
+                  string_file.string(), directory[1].Location));
+
+  // All 16 extra memory ranges were left out with the memory list.
+  EXPECT_LT(string_file.string().size(), 0x3000u + 0x1000u);
+}
+
+TEST(MinidumpFileWriter, InitializeFromSnapshot_StackSizeLimit) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshotForConcurrentWrite(&process_snapshot);
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetStackSizeLimit(0x1000);
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(string_file.string(), &directory);
+  ASSERT_TRUE(header);
+  ASSERT_TRUE(directory);
+
+  const MINIDUMP_THREAD_LIST* thread_list = nullptr;
+  for (size_t index = 0; index < header->NumberOfStreams; ++index) {
+    if (directory[index].StreamType == kMinidumpStreamTypeThreadList) {
+      thread_list = MinidumpWritableAtLocationDescriptor<MINIDUMP_THREAD_LIST>(
+          string_file.string(), directory[index].Location);
+    }
+  }
+  ASSERT_TRUE(thread_list);
+  ASSERT_EQ(thread_list->NumberOfThreads, 1u);
+
+  // The memory nearest the stack pointer, at the lowest addresses, is kept.
+  EXPECT_EQ(thread_list->Threads[0].Stack.StartOfMemoryRange, 0x7fff0000u);
+  EXPECT_EQ(thread_list->Threads[0].Stack.Memory.DataSize, 0x1000u);
+}
+
+TEST(MinidumpFileWriter, InitializeFromSnapshot_FullMemory) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshotForConcurrentWrite(&process_snapshot);
+
+  TestMemorySnapshot full_memory_snapshot;
+  constexpr uint64_t kFullMemoryAddress = 0x10000000;
+  full_memory_snapshot.SetAddress(kFullMemoryAddress);
+  constexpr size_t kFullMemorySize = 0x2000;
+  full_memory_snapshot.SetSize(kFullMemorySize);
+  full_memory_snapshot.SetValue('f');
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetFullMemory(
+      std::vector<const MemorySnapshot*>(1, &full_memory_snapshot), false);
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(string_file.string(), &directory);
+  ASSERT_TRUE(header);
+  ASSERT_TRUE(directory);
+  EXPECT_EQ(header->Flags, static_cast<uint64_t>(MiniDumpWithFullMemory));
+
+  const MINIDUMP_MEMORY64_LIST* memory64_list = nullptr;
+  for (size_t index = 0; index < header->NumberOfStreams; ++index) {
+    if (directory[index].StreamType == kMinidumpStreamTypeMemory64List) {
+      memory64_list =
+          MinidumpWritableAtLocationDescriptor<MINIDUMP_MEMORY64_LIST>(
+              string_file.string(), directory[index].Location);
+    }
+  }
+  ASSERT_TRUE(memory64_list);
+  ASSERT_EQ(memory64_list->NumberOfMemoryRanges, 1u);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].StartOfMemoryRange,
+            kFullMemoryAddress);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].DataSize, kFullMemorySize);
+
+  // The full memory is the last thing in the file.
+  ASSERT_EQ(string_file.string().size(),
+            memory64_list->BaseRva + kFullMemorySize);
+  EXPECT_EQ(string_file.string().substr(
+                static_cast<size_t>(memory64_list->BaseRva)),
+            std::string(kFullMemorySize, 'f'));
+}
+
 TEST(MinidumpFileWriter, SameStreamType) {
   MinidumpFileWriter minidump_file;
 
@@ -24,7 +24,7 @@
 namespace crashpad {
 
 MinidumpHandleDataWriter::MinidumpHandleDataWriter()
-    : handle_data_stream_base_(), handle_descriptors_(), strings_() {
+    : handle_data_(), strings_() {
 }
 
 MinidumpHandleDataWriter::~MinidumpHandleDataWriter() {
@@ -36,13 +36,15 @@ void MinidumpHandleDataWriter::InitializeFromSnapshot(
     const std::vector<HandleSnapshot>& handle_snapshots) {
   DCHECK_EQ(state(), kStateMutable);
 
-  DCHECK(handle_descriptors_.empty());
+  std::vector<MINIDUMP_HANDLE_DESCRIPTOR>& handle_descriptors =
+      handle_data_.entries();
+  DCHECK(handle_descriptors.empty());
   // Because we RegisterRVA() on the string writer below, we preallocate and
-  // never resize the handle_descriptors_ vector.
-  handle_descriptors_.resize(handle_snapshots.size());
+  // never resize the handle_descriptors vector.
+  handle_descriptors.resize(handle_snapshots.size());
   for (size_t i = 0; i < handle_snapshots.size(); ++i) {
     const HandleSnapshot& handle_snapshot = handle_snapshots[i];
-    MINIDUMP_HANDLE_DESCRIPTOR& descriptor = handle_descriptors_[i];
+    MINIDUMP_HANDLE_DESCRIPTOR& descriptor = handle_descriptors[i];
 
     descriptor.Handle = handle_snapshot.handle;
 
@@ -75,23 +77,23 @@ bool MinidumpHandleDataWriter::Freeze() {
   if (!MinidumpStreamWriter::Freeze())
     return false;
 
-  handle_data_stream_base_.SizeOfHeader = sizeof(handle_data_stream_base_);
-  handle_data_stream_base_.SizeOfDescriptor = sizeof(handle_descriptors_[0]);
-  const size_t handle_count = handle_descriptors_.size();
-  if (!AssignIfInRange(&handle_data_stream_base_.NumberOfDescriptors,
+  MINIDUMP_HANDLE_DATA_STREAM& handle_data_stream = handle_data_.header();
+  handle_data_stream.SizeOfHeader = sizeof(MINIDUMP_HANDLE_DATA_STREAM);
+  handle_data_stream.SizeOfDescriptor = sizeof(MINIDUMP_HANDLE_DESCRIPTOR);
+  const size_t handle_count = handle_data_.entries().size();
+  if (!AssignIfInRange(&handle_data_stream.NumberOfDescriptors,
                        handle_count)) {
     LOG(ERROR) << "handle_count " << handle_count << " out of range";
     return false;
   }
-  handle_data_stream_base_.Reserved = 0;
+  handle_data_stream.Reserved = 0;
 
   return true;
 }
 
 size_t MinidumpHandleDataWriter::SizeOfObject() {
   DCHECK_GE(state(), kStateFrozen);
-  return sizeof(handle_data_stream_base_) +
-         sizeof(handle_descriptors_[0]) * handle_descriptors_.size();
+  return handle_data_.Size();
 }
 
 std::vector<internal::MinidumpWritable*> MinidumpHandleDataWriter::Children() {
@@ -106,18 +108,7 @@ std::vector<internal::MinidumpWritable*> MinidumpHandleDataWriter::Children() {
 bool MinidumpHandleDataWriter::WriteObject(FileWriterInterface* file_writer) {
   DCHECK_EQ(state(), kStateWritable);
 
-  WritableIoVec iov;
-  iov.iov_base = &handle_data_stream_base_;
-  iov.iov_len = sizeof(handle_data_stream_base_);
-  std::vector<WritableIoVec> iovecs(1, iov);
-
-  for (const auto& descriptor : handle_descriptors_) {
-    iov.iov_base = &descriptor;
-    iov.iov_len = sizeof(descriptor);
-    iovecs.push_back(iov);
-  }
-
-  return file_writer->WriteIoVec(&iovecs);
+  return handle_data_.Write(file_writer);
 }
 
 MinidumpStreamType MinidumpHandleDataWriter::StreamType() const {
@@ -25,6 +25,7 @@
 
 #include "minidump/minidump_stream_writer.h"
 #include "minidump/minidump_string_writer.h"
+#include "minidump/minidump_struct_list.h"
 #include "minidump/minidump_writable.h"
 #include "snapshot/handle_snapshot.h"
 
@@ -65,8 +66,9 @@ class MinidumpHandleDataWriter final : public internal::MinidumpStreamWriter {
   MinidumpStreamType StreamType() const override;
 
  private:
-  MINIDUMP_HANDLE_DATA_STREAM handle_data_stream_base_;
-  std::vector<MINIDUMP_HANDLE_DESCRIPTOR> handle_descriptors_;
+  internal::MinidumpStructList<MINIDUMP_HANDLE_DATA_STREAM,
+                               MINIDUMP_HANDLE_DESCRIPTOR>
+      handle_data_;
   std::map<std::string, internal::MinidumpUTF16StringWriter*> strings_;
 
   DISALLOW_COPY_AND_ASSIGN(MinidumpHandleDataWriter);
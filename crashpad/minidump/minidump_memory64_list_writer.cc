@@ -0,0 +1,388 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_memory64_list_writer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/auto_reset.h"
+#include "base/logging.h"
+#include "util/file/file_writer.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+
+namespace {
+
+// When a memory snapshot can’t be read, this much zero-filled data at a time
+// takes its place, so that the snapshots following it remain where the
+// MINIDUMP_MEMORY64_LIST says they are.
+constexpr size_t kZeroFillChunkSize = 64 * 1024;
+
+// Holes are made in units of this many bytes, aligned to this boundary in the
+// file. This is the page size on most systems, and the allocation unit of most
+// file systems, so a zero page that isn’t written needn’t be allocated.
+constexpr size_t kSparseBlockSize = 4096;
+
+// Returns whether the kSparseBlockSize bytes at |data| are all zero. The block
+// is checked a cache line at a time, with the words of each line combined
+// without branches, so that compilers can vectorize the check while still
+// returning promptly at the first nonzero line, as most nonzero blocks have.
+bool IsZeroBlock(const uint8_t* data) {
+  constexpr size_t kLineSize = 64;
+  static_assert(kSparseBlockSize % kLineSize == 0, "block size");
+  for (size_t line = 0; line < kSparseBlockSize; line += kLineSize) {
+    uint64_t words[kLineSize / sizeof(uint64_t)];
+    memcpy(words, data + line, sizeof(words));
+    uint64_t combined = 0;
+    for (uint64_t word : words) {
+      combined |= word;
+    }
+    if (combined) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace internal {
+
+MinidumpMemory64DataWriter::MinidumpMemory64DataWriter()
+    : MinidumpWritable(),
+      MemorySnapshot::Delegate(),
+      memory_snapshots_(),
+      size_(0),
+      file_writer_(nullptr),
+      offset_(0),
+      pending_hole_size_(0),
+      sparse_(false),
+      wrote_snapshot_data_(false),
+      read_buffer_pool_(),
+      read_buffer_() {}
+
+MinidumpMemory64DataWriter::~MinidumpMemory64DataWriter() {}
+
+void MinidumpMemory64DataWriter::SetSnapshots(
+    const std::vector<const MemorySnapshot*>& memory_snapshots) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  memory_snapshots_ = memory_snapshots;
+}
+
+void MinidumpMemory64DataWriter::SetSparse(bool sparse) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  sparse_ = sparse;
+}
+
+bool MinidumpMemory64DataWriter::MemorySnapshotDelegateRead(void* data,
+                                                            size_t size) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  wrote_snapshot_data_ = true;
+  return WriteMemory(data, size);
+}
+
+void* MinidumpMemory64DataWriter::MemorySnapshotDelegateBuffer(size_t size) {
+  DCHECK_EQ(state(), kStateWritable);
+  DCHECK(!read_buffer_);
+
+  read_buffer_ = read_buffer_pool_.Take(size);
+  return read_buffer_->data();
+}
+
+bool MinidumpMemory64DataWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (!MinidumpWritable::Freeze()) {
+    return false;
+  }
+
+  uint64_t size = 0;
+  for (const MemorySnapshot* memory_snapshot : memory_snapshots_) {
+    size += memory_snapshot->Size();
+  }
+  if (!AssignIfInRange(&size_, size)) {
+    LOG(ERROR) << "size " << size << " out of range";
+    return false;
+  }
+
+  return true;
+}
+
+size_t MinidumpMemory64DataWriter::Alignment() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  // As in SnapshotMinidumpMemoryWriter, the memory is aligned to a 16-byte
+  // boundary. Only the first snapshot is aligned, because the rest must
+  // follow it contiguously.
+  return 16;
+}
+
+size_t MinidumpMemory64DataWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return size_;
+}
+
+bool MinidumpMemory64DataWriter::WillWriteAtOffsetImpl(FileOffset offset) {
+  DCHECK_EQ(state(), kStateFrozen);
+
+  offset_ = offset;
+  return MinidumpWritable::WillWriteAtOffsetImpl(offset);
+}
+
+bool MinidumpMemory64DataWriter::WriteObject(FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+  DCHECK(!file_writer_);
+
+  base::AutoReset<FileWriterInterface*> file_writer_reset(&file_writer_,
+                                                          file_writer);
+
+  for (const MemorySnapshot* memory_snapshot : memory_snapshots_) {
+    wrote_snapshot_data_ = false;
+
+    // This will result in MemorySnapshotDelegateRead() being called.
+    const bool rv = memory_snapshot->Read(this);
+
+    if (read_buffer_) {
+      read_buffer_pool_.Return(std::move(read_buffer_));
+    }
+
+    if (rv) {
+      continue;
+    }
+    if (wrote_snapshot_data_) {
+      return false;
+    }
+
+    LOG(WARNING) << "zero-filling unreadable memory at 0x" << std::hex
+                 << memory_snapshot->Address() << std::dec << ", size "
+                 << memory_snapshot->Size();
+    const std::vector<uint8_t> zeroes(
+        std::min(memory_snapshot->Size(), kZeroFillChunkSize));
+    size_t remaining = memory_snapshot->Size();
+    while (remaining > 0) {
+      const size_t chunk_size = std::min(remaining, zeroes.size());
+      if (!WriteMemory(zeroes.data(), chunk_size)) {
+        return false;
+      }
+      remaining -= chunk_size;
+    }
+  }
+
+  // A hole at the end of the file doesn’t extend it, so the last byte of the
+  // hole is written to give the file its full size.
+  if (pending_hole_size_ > 0) {
+    if (file_writer->Seek(pending_hole_size_ - 1, SEEK_CUR) < 0) {
+      return false;
+    }
+    pending_hole_size_ = 0;
+    constexpr uint8_t kZero = 0;
+    if (!file_writer->Write(&kZero, sizeof(kZero))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool MinidumpMemory64DataWriter::WriteMemory(const void* data, size_t size) {
+  if (!sparse_) {
+    return file_writer_->Write(data, size);
+  }
+
+  // Consecutive nonzero blocks are gathered into a single write, beginning at
+  // run_start.
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  size_t run_start = 0;
+  size_t index = 0;
+  while (index < size) {
+    const size_t block_remaining =
+        kSparseBlockSize - static_cast<size_t>(offset_ % kSparseBlockSize);
+    const size_t chunk_size = std::min(size - index, block_remaining);
+
+    if (chunk_size == kSparseBlockSize && IsZeroBlock(bytes + index)) {
+      if (index > run_start &&
+          !file_writer_->Write(bytes + run_start, index - run_start)) {
+        return false;
+      }
+      pending_hole_size_ += chunk_size;
+      run_start = index + chunk_size;
+    } else if (pending_hole_size_ > 0) {
+      DCHECK_EQ(run_start, index);
+      if (file_writer_->Seek(pending_hole_size_, SEEK_CUR) < 0) {
+        return false;
+      }
+      pending_hole_size_ = 0;
+    }
+
+    index += chunk_size;
+    offset_ += chunk_size;
+  }
+
+  return index == run_start ||
+         file_writer_->Write(bytes + run_start, index - run_start);
+}
+
+MinidumpWritable::Phase MinidumpMemory64DataWriter::WritePhase() {
+  // The memory follows everything else in the minidump file, including the
+  // memory ranges of any MINIDUMP_MEMORY_LIST, so that the rest of the file is
+  // compact and can be read without reading past it.
+  return kPhaseLate;
+}
+
+}  // namespace internal
+
+MinidumpMemory64ListWriter::MinidumpMemory64ListWriter()
+    : MinidumpStreamWriter(),
+      memory_snapshots_(),
+      memory_descriptors_(),
+      memory64_list_base_(),
+      data_writer_(new internal::MinidumpMemory64DataWriter()),
+      snapshots_created_during_merge_() {}
+
+MinidumpMemory64ListWriter::~MinidumpMemory64ListWriter() {}
+
+void MinidumpMemory64ListWriter::AddFromSnapshot(
+    const std::vector<const MemorySnapshot*>& memory_snapshots) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  memory_snapshots_.insert(memory_snapshots_.end(),
+                           memory_snapshots.begin(),
+                           memory_snapshots.end());
+}
+
+void MinidumpMemory64ListWriter::SetSparse(bool sparse) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  data_writer_->SetSparse(sparse);
+}
+
+uint64_t MinidumpMemory64ListWriter::MemorySize() const {
+  uint64_t memory_size = 0;
+  for (const MemorySnapshot* memory_snapshot : memory_snapshots_) {
+    memory_size += memory_snapshot->Size();
+  }
+  return memory_size;
+}
+
+bool MinidumpMemory64ListWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  std::vector<const MemorySnapshot*> candidates;
+  for (const MemorySnapshot* memory_snapshot : memory_snapshots_) {
+    if (memory_snapshot->Size() > 0) {
+      candidates.push_back(memory_snapshot);
+    }
+  }
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](const MemorySnapshot* a, const MemorySnapshot* b) {
+              if (a->Address() == b->Address()) {
+                return a->Size() < b->Size();
+              }
+              return a->Address() < b->Address();
+            });
+
+  // The snapshots are written contiguously, so they must not overlap.
+  // Abutting snapshots are left separate, and share a descriptor below.
+  std::vector<const MemorySnapshot*> sorted;
+  for (const MemorySnapshot* candidate : candidates) {
+    if (!sorted.empty()) {
+      const MemorySnapshot* top = sorted.back();
+      const uint64_t top_end = top->Address() + top->Size();
+      if (candidate->Address() < top_end) {
+        std::unique_ptr<const MemorySnapshot> merged(
+            top->MergeWithOtherSnapshot(candidate));
+        if (merged) {
+          sorted.back() = merged.get();
+          snapshots_created_during_merge_.push_back(merged.release());
+        } else {
+          LOG(WARNING) << "dropping overlapping memory at 0x" << std::hex
+                       << candidate->Address() << std::dec;
+        }
+        continue;
+      }
+    }
+
+    sorted.push_back(candidate);
+  }
+  memory_snapshots_.swap(sorted);
+
+  for (const MemorySnapshot* memory_snapshot : memory_snapshots_) {
+    if (!memory_descriptors_.empty()) {
+      MINIDUMP_MEMORY_DESCRIPTOR64& last = memory_descriptors_.back();
+      if (last.StartOfMemoryRange + last.DataSize ==
+          memory_snapshot->Address()) {
+        last.DataSize += memory_snapshot->Size();
+        continue;
+      }
+    }
+
+    MINIDUMP_MEMORY_DESCRIPTOR64 memory_descriptor;
+    memory_descriptor.StartOfMemoryRange = memory_snapshot->Address();
+    memory_descriptor.DataSize = memory_snapshot->Size();
+    memory_descriptors_.push_back(memory_descriptor);
+  }
+
+  memory64_list_base_.NumberOfMemoryRanges = memory_descriptors_.size();
+  data_writer_->SetSnapshots(memory_snapshots_);
+  data_writer_->RegisterRVA(&memory64_list_base_.BaseRva);
+
+  return MinidumpStreamWriter::Freeze();
+}
+
+size_t MinidumpMemory64ListWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return sizeof(memory64_list_base_) +
+         memory_descriptors_.size() * sizeof(MINIDUMP_MEMORY_DESCRIPTOR64);
+}
+
+std::vector<internal::MinidumpWritable*>
+MinidumpMemory64ListWriter::Children() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return std::vector<MinidumpWritable*>(1, data_writer_.get());
+}
+
+bool MinidumpMemory64ListWriter::WriteObject(FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  WritableIoVec iov;
+  iov.iov_base = &memory64_list_base_;
+  iov.iov_len = sizeof(memory64_list_base_);
+  std::vector<WritableIoVec> iovecs(1, iov);
+
+  if (!memory_descriptors_.empty()) {
+    iov.iov_base = &memory_descriptors_[0];
+    iov.iov_len =
+        memory_descriptors_.size() * sizeof(MINIDUMP_MEMORY_DESCRIPTOR64);
+    iovecs.push_back(iov);
+  }
+
+  return file_writer->WriteIoVec(&iovecs);
+}
+
+MinidumpStreamType MinidumpMemory64ListWriter::StreamType() const {
+  return kMinidumpStreamTypeMemory64List;
+}
+
+}  // namespace crashpad
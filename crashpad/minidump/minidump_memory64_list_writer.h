@@ -0,0 +1,186 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_MEMORY64_LIST_WRITER_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_MEMORY64_LIST_WRITER_H_
+
+#include <windows.h>
+#include <dbghelp.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "minidump/minidump_memory_writer.h"
+#include "minidump/minidump_stream_writer.h"
+#include "minidump/minidump_writable.h"
+#include "snapshot/memory_snapshot.h"
+#include "util/file/file_io.h"
+#include "util/stdlib/pointer_container.h"
+
+namespace crashpad {
+
+namespace internal {
+
+//! \brief Writes the snapshots of the memory regions listed in a
+//!     MINIDUMP_MEMORY64_LIST, one after another with no padding between them.
+//!
+//! This is written as a single object at the end of the minidump file, so that
+//! the memory is written in one sequential pass however large it is.
+class MinidumpMemory64DataWriter final : public MinidumpWritable,
+                                         public MemorySnapshot::Delegate {
+ public:
+  MinidumpMemory64DataWriter();
+  ~MinidumpMemory64DataWriter() override;
+
+  //! \brief Sets the memory snapshots to write, in the order that they are to
+  //!     be written.
+  //!
+  //! The snapshots are not owned by this object, and must remain valid until
+  //! it has been written.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetSnapshots(const std::vector<const MemorySnapshot*>& memory_snapshots);
+
+  //! \brief Sets whether blocks of memory that are entirely zero are seeked
+  //!     past instead of written, leaving holes in a sparse file.
+  //!
+  //! This requires a FileWriterInterface that can seek forward past its end,
+  //! leaving zeroes in the range seeked past, as disk-based files can.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetSparse(bool sparse);
+
+ private:
+  // MemorySnapshot::Delegate:
+  bool MemorySnapshotDelegateRead(void* data, size_t size) override;
+  void* MemorySnapshotDelegateBuffer(size_t size) override;
+
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t Alignment() override;
+  size_t SizeOfObject() override;
+  bool WillWriteAtOffsetImpl(FileOffset offset) override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+  Phase WritePhase() override;
+
+  // Writes \a size bytes of memory at \a data to file_writer_. When sparse_ is
+  // set, zero blocks are only recorded in pending_hole_size_, to be seeked past
+  // once the next nonzero data is written, or once the last snapshot has been.
+  bool WriteMemory(const void* data, size_t size);
+
+  std::vector<const MemorySnapshot*> memory_snapshots_;  // weak
+  size_t size_;
+  FileWriterInterface* file_writer_;  // weak
+
+  // The file offset that the next byte of memory will be written at, used to
+  // find the blocks of the file that a hole can leave unallocated.
+  FileOffset offset_;
+  FileOffset pending_hole_size_;
+  bool sparse_;
+
+  // Whether any of the snapshot being written has been written yet, which
+  // distinguishes a failure to read it from a failure to write it.
+  bool wrote_snapshot_data_;
+
+  // Every snapshot is read into a buffer from here in turn, so that a single
+  // allocation, sized for the largest snapshot, serves them all.
+  MemoryReadBufferPool read_buffer_pool_;
+  std::unique_ptr<std::vector<uint8_t>> read_buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpMemory64DataWriter);
+};
+
+}  // namespace internal
+
+//! \brief The writer for a MINIDUMP_MEMORY64_LIST stream in a minidump file,
+//!     containing a list of MINIDUMP_MEMORY_DESCRIPTOR64 objects.
+//!
+//! Unlike MinidumpMemoryListWriter, which places each memory range in the
+//! minidump file individually and locates it by a 32-bit offset, this lays out
+//! all of its memory contiguously at the end of the file, beginning at a single
+//! 64-bit offset. This suits minidump files that capture most or all of a
+//! process’ memory, which may extend beyond the first 4GB of the file.
+class MinidumpMemory64ListWriter final : public internal::MinidumpStreamWriter {
+ public:
+  MinidumpMemory64ListWriter();
+  ~MinidumpMemory64ListWriter() override;
+
+  //! \brief Adds each memory snapshot in \a memory_snapshots to the
+  //!     MINIDUMP_MEMORY64_LIST.
+  //!
+  //! The snapshots may be added in any order. They are sorted by address when
+  //! this object is frozen. Snapshots that abut share a single
+  //! MINIDUMP_MEMORY_DESCRIPTOR64, but are still read one at a time, so that
+  //! a large region may be added as many smaller snapshots to bound the memory
+  //! needed to write it. Empty snapshots are dropped, as are snapshots that
+  //! overlap one at a lower address and can’t be merged with it.
+  //!
+  //! The snapshots are not owned by this object, and must remain valid until
+  //! it has been written.
+  //!
+  //! \note Valid in #kStateMutable.
+  void AddFromSnapshot(
+      const std::vector<const MemorySnapshot*>& memory_snapshots);
+
+  //! \brief Sets whether blocks of memory that are entirely zero are left as
+  //!     holes in a sparse file, instead of being written.
+  //!
+  //! Committed memory is often mostly zero pages, so this reduces both the
+  //! storage that a full-memory minidump file occupies and the time taken to
+  //! write it. Holes read back as zeroes, so the minidump file’s contents are
+  //! unchanged.
+  //!
+  //! This requires a FileWriterInterface that can seek forward past its end,
+  //! as disk-based files can. Holes only save storage on file systems that
+  //! support sparse files, and on Windows, only in files marked sparse by
+  //! LoggingSetFileSparse(). By default, every block is written.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetSparse(bool sparse);
+
+  //! \brief Returns the number of memory snapshots added by AddFromSnapshot().
+  size_t MemorySnapshotCount() const { return memory_snapshots_.size(); }
+
+  //! \brief Returns the number of bytes of memory in the snapshots added by
+  //!     AddFromSnapshot().
+  uint64_t MemorySize() const;
+
+ protected:
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t SizeOfObject() override;
+  std::vector<MinidumpWritable*> Children() override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+
+  // MinidumpStreamWriter:
+  MinidumpStreamType StreamType() const override;
+
+ private:
+  std::vector<const MemorySnapshot*> memory_snapshots_;  // weak
+  std::vector<MINIDUMP_MEMORY_DESCRIPTOR64> memory_descriptors_;
+  MINIDUMP_MEMORY64_LIST memory64_list_base_;
+  std::unique_ptr<internal::MinidumpMemory64DataWriter> data_writer_;
+
+  // Snapshots spanning overlapping memory ranges, created during Freeze().
+  PointerVector<const MemorySnapshot> snapshots_created_during_merge_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpMemory64ListWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_MEMORY64_LIST_WRITER_H_
@@ -0,0 +1,280 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_memory64_list_writer.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/test/minidump_file_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "snapshot/test/test_memory_snapshot.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+// The memory64 list is expected to be the only stream.
+void GetMemory64ListStream(const std::string& file_contents,
+                           const MINIDUMP_MEMORY64_LIST** memory64_list) {
+  constexpr size_t kDirectoryOffset = sizeof(MINIDUMP_HEADER);
+  constexpr size_t kMemory64ListStreamOffset =
+      kDirectoryOffset + sizeof(MINIDUMP_DIRECTORY);
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(file_contents, &directory);
+  ASSERT_NO_FATAL_FAILURE(VerifyMinidumpHeader(header, 1, 0));
+  ASSERT_TRUE(directory);
+
+  constexpr size_t kDirectoryIndex = 0;
+
+  ASSERT_EQ(directory[kDirectoryIndex].StreamType,
+            kMinidumpStreamTypeMemory64List);
+  EXPECT_EQ(directory[kDirectoryIndex].Location.Rva,
+            kMemory64ListStreamOffset);
+
+  *memory64_list = MinidumpWritableAtLocationDescriptor<MINIDUMP_MEMORY64_LIST>(
+      file_contents, directory[kDirectoryIndex].Location);
+  ASSERT_TRUE(*memory64_list);
+}
+
+// A StringFile that counts the bytes written to it, which excludes the bytes
+// of any holes seeked past.
+class CountingStringFile final : public StringFile {
+ public:
+  CountingStringFile() : StringFile(), bytes_written_(0) {}
+  ~CountingStringFile() override {}
+
+  size_t bytes_written() const { return bytes_written_; }
+
+  // FileWriterInterface:
+  bool Write(const void* data, size_t size) override {
+    bytes_written_ += size;
+    return StringFile::Write(data, size);
+  }
+
+  bool WriteIoVec(std::vector<WritableIoVec>* iovecs) override {
+    for (const WritableIoVec& iov : *iovecs) {
+      bytes_written_ += iov.iov_len;
+    }
+    return StringFile::WriteIoVec(iovecs);
+  }
+
+ private:
+  size_t bytes_written_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingStringFile);
+};
+
+// Expects \a size bytes of \a value in \a file_contents at \a offset.
+void ExpectMemoryData(const std::string& file_contents,
+                      uint64_t offset,
+                      size_t size,
+                      char value) {
+  ASSERT_LE(offset + size, file_contents.size());
+  EXPECT_EQ(file_contents.substr(static_cast<size_t>(offset), size),
+            std::string(size, value));
+}
+
+TEST(MinidumpMemory64ListWriter, Empty) {
+  MinidumpFileWriter minidump_file_writer;
+  auto memory64_list_writer =
+      base::WrapUnique(new MinidumpMemory64ListWriter());
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(memory64_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_MEMORY64_LIST* memory64_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetMemory64ListStream(string_file.string(), &memory64_list));
+
+  EXPECT_EQ(memory64_list->NumberOfMemoryRanges, 0u);
+  EXPECT_EQ(memory64_list->BaseRva, string_file.string().size());
+}
+
+TEST(MinidumpMemory64ListWriter, AbuttingAndSeparateRanges) {
+  MinidumpFileWriter minidump_file_writer;
+  auto memory64_list_writer =
+      base::WrapUnique(new MinidumpMemory64ListWriter());
+
+  constexpr uint64_t kBaseAddress0 = 0x1000;
+  constexpr size_t kSize0 = 0x300;
+  constexpr char kValue0 = 'a';
+  constexpr uint64_t kBaseAddress1 = kBaseAddress0 + kSize0;
+  constexpr size_t kSize1 = 0x100;
+  constexpr char kValue1 = 'b';
+  constexpr uint64_t kBaseAddress2 = 0x10000;
+  constexpr size_t kSize2 = 0x40;
+  constexpr char kValue2 = 'c';
+
+  TestMemorySnapshot memory_snapshot_0;
+  memory_snapshot_0.SetAddress(kBaseAddress0);
+  memory_snapshot_0.SetSize(kSize0);
+  memory_snapshot_0.SetValue(kValue0);
+
+  TestMemorySnapshot memory_snapshot_1;
+  memory_snapshot_1.SetAddress(kBaseAddress1);
+  memory_snapshot_1.SetSize(kSize1);
+  memory_snapshot_1.SetValue(kValue1);
+
+  TestMemorySnapshot memory_snapshot_2;
+  memory_snapshot_2.SetAddress(kBaseAddress2);
+  memory_snapshot_2.SetSize(kSize2);
+  memory_snapshot_2.SetValue(kValue2);
+
+  TestMemorySnapshot empty_memory_snapshot;
+  empty_memory_snapshot.SetAddress(0x20000);
+  empty_memory_snapshot.SetSize(0);
+
+  // Add the snapshots out of order to exercise sorting.
+  std::vector<const MemorySnapshot*> memory_snapshots;
+  memory_snapshots.push_back(&memory_snapshot_2);
+  memory_snapshots.push_back(&empty_memory_snapshot);
+  memory_snapshots.push_back(&memory_snapshot_1);
+  memory_snapshots.push_back(&memory_snapshot_0);
+  memory64_list_writer->AddFromSnapshot(memory_snapshots);
+
+  EXPECT_EQ(memory64_list_writer->MemorySnapshotCount(), 4u);
+  EXPECT_EQ(memory64_list_writer->MemorySize(), kSize0 + kSize1 + kSize2);
+
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(memory64_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_MEMORY64_LIST* memory64_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetMemory64ListStream(string_file.string(), &memory64_list));
+
+  ASSERT_EQ(memory64_list->NumberOfMemoryRanges, 2u);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].StartOfMemoryRange, kBaseAddress0);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].DataSize, kSize0 + kSize1);
+  EXPECT_EQ(memory64_list->MemoryRanges[1].StartOfMemoryRange, kBaseAddress2);
+  EXPECT_EQ(memory64_list->MemoryRanges[1].DataSize, kSize2);
+
+  const uint64_t base_rva = memory64_list->BaseRva;
+  EXPECT_EQ(base_rva % 16, 0u);
+  EXPECT_EQ(string_file.string().size(), base_rva + kSize0 + kSize1 + kSize2);
+
+  ExpectMemoryData(string_file.string(), base_rva, kSize0, kValue0);
+  ExpectMemoryData(string_file.string(), base_rva + kSize0, kSize1, kValue1);
+  ExpectMemoryData(
+      string_file.string(), base_rva + kSize0 + kSize1, kSize2, kValue2);
+}
+
+TEST(MinidumpMemory64ListWriter, OverlappingRanges) {
+  MinidumpFileWriter minidump_file_writer;
+  auto memory64_list_writer =
+      base::WrapUnique(new MinidumpMemory64ListWriter());
+
+  TestMemorySnapshot memory_snapshot_0;
+  memory_snapshot_0.SetAddress(0x1000);
+  memory_snapshot_0.SetSize(0x200);
+  memory_snapshot_0.SetValue('a');
+
+  TestMemorySnapshot memory_snapshot_1;
+  memory_snapshot_1.SetAddress(0x1100);
+  memory_snapshot_1.SetSize(0x200);
+  memory_snapshot_1.SetValue('b');
+
+  std::vector<const MemorySnapshot*> memory_snapshots;
+  memory_snapshots.push_back(&memory_snapshot_1);
+  memory_snapshots.push_back(&memory_snapshot_0);
+  memory64_list_writer->AddFromSnapshot(memory_snapshots);
+
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(memory64_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_MEMORY64_LIST* memory64_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetMemory64ListStream(string_file.string(), &memory64_list));
+
+  // The overlapping snapshots are merged into one range, filled with the value
+  // of the lower snapshot.
+  ASSERT_EQ(memory64_list->NumberOfMemoryRanges, 1u);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].StartOfMemoryRange, 0x1000u);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].DataSize, 0x300u);
+  ExpectMemoryData(string_file.string(), memory64_list->BaseRva, 0x300, 'a');
+}
+
+TEST(MinidumpMemory64ListWriter, Sparse) {
+  MinidumpFileWriter minidump_file_writer;
+  auto memory64_list_writer =
+      base::WrapUnique(new MinidumpMemory64ListWriter());
+  memory64_list_writer->SetSparse(true);
+
+  // Nonzero memory is interleaved with zero memory, the last of which ends the
+  // file.
+  constexpr uint64_t kBaseAddress = 0x40000;
+  constexpr size_t kSizes[] = {0x1000, 0x3000, 0x1800, 0x2000};
+  constexpr char kValues[] = {'a', '\0', 'b', '\0'};
+  static_assert(arraysize(kSizes) == arraysize(kValues), "array sizes");
+
+  TestMemorySnapshot memory_snapshots[arraysize(kSizes)];
+  std::vector<const MemorySnapshot*> memory_snapshot_pointers;
+  uint64_t address = kBaseAddress;
+  for (size_t index = 0; index < arraysize(kSizes); ++index) {
+    memory_snapshots[index].SetAddress(address);
+    memory_snapshots[index].SetSize(kSizes[index]);
+    memory_snapshots[index].SetValue(kValues[index]);
+    memory_snapshot_pointers.push_back(&memory_snapshots[index]);
+    address += kSizes[index];
+  }
+  memory64_list_writer->AddFromSnapshot(memory_snapshot_pointers);
+  const uint64_t memory_size = memory64_list_writer->MemorySize();
+
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(memory64_list_writer)));
+
+  CountingStringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_MEMORY64_LIST* memory64_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetMemory64ListStream(string_file.string(), &memory64_list));
+
+  ASSERT_EQ(memory64_list->NumberOfMemoryRanges, 1u);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].StartOfMemoryRange, kBaseAddress);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].DataSize, memory_size);
+
+  // The holes read back as zeroes, and the file has its full size.
+  ASSERT_EQ(string_file.string().size(), memory64_list->BaseRva + memory_size);
+  uint64_t offset = memory64_list->BaseRva;
+  for (size_t index = 0; index < arraysize(kSizes); ++index) {
+    ExpectMemoryData(
+        string_file.string(), offset, kSizes[index], kValues[index]);
+    offset += kSizes[index];
+  }
+
+  // Whatever the alignment of the memory in the file, each zero range spans at
+  // least one whole block that was seeked past rather than written.
+  EXPECT_LE(string_file.bytes_written(), string_file.string().size() - 0x2000);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
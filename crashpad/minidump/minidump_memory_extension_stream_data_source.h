@@ -0,0 +1,57 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_MEMORY_EXTENSION_STREAM_DATA_SOURCE_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_MEMORY_EXTENSION_STREAM_DATA_SOURCE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "base/macros.h"
+#include "minidump/minidump_user_extension_stream_data_source.h"
+
+namespace crashpad {
+
+//! \brief A user extension data source for data already in memory that
+//!     outlives the minidump’s writing, such as a mapped file or a buffer
+//!     that a handler maintains.
+//!
+//! The data is passed to the minidump file where it is, without being copied.
+class MinidumpMemoryExtensionStreamDataSource final
+    : public MinidumpUserExtensionStreamDataSource {
+ public:
+  //! \param[in] stream_type The type of the stream.
+  //! \param[in] data The data of the stream. This object does not take
+  //!     ownership of it, and it must remain valid and unchanged until the
+  //!     minidump is written.
+  //! \param[in] size The size of \a data.
+  MinidumpMemoryExtensionStreamDataSource(uint32_t stream_type,
+                                          const void* data,
+                                          size_t size);
+  ~MinidumpMemoryExtensionStreamDataSource() override;
+
+  // MinidumpUserExtensionStreamDataSource:
+  size_t StreamDataSize() override;
+  bool ReadStreamData(Delegate* delegate) override;
+
+ private:
+  const void* data_;  // weak
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpMemoryExtensionStreamDataSource);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_MEMORY_EXTENSION_STREAM_DATA_SOURCE_H_
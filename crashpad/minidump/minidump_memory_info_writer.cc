@@ -14,14 +14,91 @@
 
 #include "minidump/minidump_memory_info_writer.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "base/logging.h"
 #include "snapshot/memory_map_region_snapshot.h"
 #include "util/file/file_writer.h"
 
 namespace crashpad {
 
+namespace {
+
+// Sorts |ranges| and combines those that overlap or abut, so that the returned
+// ranges are disjoint and both their bases and their ends are in increasing
+// order. Invalid ranges are discarded.
+std::vector<CheckedRange<uint64_t>> CoalesceRanges(
+    const std::vector<CheckedRange<uint64_t>>& ranges) {
+  std::vector<CheckedRange<uint64_t>> sorted;
+  for (const auto& range : ranges) {
+    if (range.IsValid() && range.size()) {
+      sorted.push_back(range);
+    }
+  }
+  std::sort(sorted.begin(),
+            sorted.end(),
+            [](const CheckedRange<uint64_t>& a,
+               const CheckedRange<uint64_t>& b) {
+              return a.base() < b.base();
+            });
+
+  std::vector<CheckedRange<uint64_t>> coalesced;
+  for (const auto& range : sorted) {
+    if (!coalesced.empty() && range.base() <= coalesced.back().end()) {
+      CheckedRange<uint64_t>& last = coalesced.back();
+      last.SetRange(last.base(),
+                    std::max(last.end(), range.end()) - last.base());
+    } else {
+      coalesced.push_back(range);
+    }
+  }
+
+  return coalesced;
+}
+
+// Returns whether the region described by |memory_info|, extended by
+// |distance| bytes in each direction, overlaps any of |coalesced_ranges|, which
+// must have been produced by CoalesceRanges().
+bool RegionIsNear(const MINIDUMP_MEMORY_INFO& memory_info,
+                  const std::vector<CheckedRange<uint64_t>>& coalesced_ranges,
+                  uint64_t distance) {
+  constexpr uint64_t kMax = std::numeric_limits<uint64_t>::max();
+  const uint64_t region_base = memory_info.BaseAddress;
+  const uint64_t region_end = memory_info.RegionSize > kMax - region_base
+                                  ? kMax
+                                  : region_base + memory_info.RegionSize;
+  const uint64_t low = region_base > distance ? region_base - distance : 0;
+  const uint64_t high =
+      distance > kMax - region_end ? kMax : region_end + distance;
+
+  // Find the first range that ends after |low|. Because the ranges are sorted
+  // and disjoint, if any range overlaps [low, high), this one does.
+  auto it = std::upper_bound(coalesced_ranges.begin(),
+                             coalesced_ranges.end(),
+                             low,
+                             [](uint64_t value,
+                                const CheckedRange<uint64_t>& range) {
+                               return value < range.end();
+                             });
+  return it != coalesced_ranges.end() && it->base() < high;
+}
+
+// Returns whether |next| immediately follows |previous| and describes memory
+// with the same attributes, so that the two may be recorded as one entry.
+bool RegionsCanMerge(const MINIDUMP_MEMORY_INFO& previous,
+                     const MINIDUMP_MEMORY_INFO& next) {
+  return previous.BaseAddress + previous.RegionSize == next.BaseAddress &&
+         previous.AllocationProtect == next.AllocationProtect &&
+         previous.State == next.State &&
+         previous.Protect == next.Protect &&
+         previous.Type == next.Type;
+}
+
+}  // namespace
+
 MinidumpMemoryInfoListWriter::MinidumpMemoryInfoListWriter()
-    : memory_info_list_base_(), items_() {
+    : memory_info_list_() {
 }
 
 MinidumpMemoryInfoListWriter::~MinidumpMemoryInfoListWriter() {
@@ -31,9 +108,41 @@ void MinidumpMemoryInfoListWriter::InitializeFromSnapshot(
     const std::vector<const MemoryMapRegionSnapshot*>& memory_map) {
   DCHECK_EQ(state(), kStateMutable);
 
-  DCHECK(items_.empty());
+  std::vector<MINIDUMP_MEMORY_INFO>& items = memory_info_list_.entries();
+  DCHECK(items.empty());
   for (const auto& region : memory_map)
-    items_.push_back(region->AsMinidumpMemoryInfo());
+    items.push_back(region->AsMinidumpMemoryInfo());
+}
+
+void MinidumpMemoryInfoListWriter::InitializeFromSnapshot(
+    const std::vector<const MemoryMapRegionSnapshot*>& memory_map,
+    const MinidumpMemoryInfoListOptions& options,
+    const std::vector<CheckedRange<uint64_t>>& captured_ranges) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  std::vector<CheckedRange<uint64_t>> coalesced_ranges;
+  if (options.only_near_captured_memory) {
+    coalesced_ranges = CoalesceRanges(captured_ranges);
+  }
+
+  std::vector<MINIDUMP_MEMORY_INFO>& items = memory_info_list_.entries();
+  DCHECK(items.empty());
+  for (const auto& region : memory_map) {
+    const MINIDUMP_MEMORY_INFO& memory_info = region->AsMinidumpMemoryInfo();
+    if (options.only_near_captured_memory &&
+        !RegionIsNear(
+            memory_info, coalesced_ranges, options.nearby_distance)) {
+      continue;
+    }
+
+    if (options.merge_adjacent_regions && !items.empty() &&
+        RegionsCanMerge(items.back(), memory_info)) {
+      items.back().RegionSize += memory_info.RegionSize;
+      continue;
+    }
+
+    items.push_back(memory_info);
+  }
 }
 
 bool MinidumpMemoryInfoListWriter::Freeze() {
@@ -42,16 +151,17 @@ bool MinidumpMemoryInfoListWriter::Freeze() {
   if (!MinidumpStreamWriter::Freeze())
     return false;
 
-  memory_info_list_base_.SizeOfHeader = sizeof(MINIDUMP_MEMORY_INFO_LIST);
-  memory_info_list_base_.SizeOfEntry = sizeof(MINIDUMP_MEMORY_INFO);
-  memory_info_list_base_.NumberOfEntries = items_.size();
+  MINIDUMP_MEMORY_INFO_LIST& header = memory_info_list_.header();
+  header.SizeOfHeader = sizeof(MINIDUMP_MEMORY_INFO_LIST);
+  header.SizeOfEntry = sizeof(MINIDUMP_MEMORY_INFO);
+  header.NumberOfEntries = memory_info_list_.entries().size();
 
   return true;
 }
 
 size_t MinidumpMemoryInfoListWriter::SizeOfObject() {
   DCHECK_GE(state(), kStateFrozen);
-  return sizeof(memory_info_list_base_) + sizeof(items_[0]) * items_.size();
+  return memory_info_list_.Size();
 }
 
 std::vector<internal::MinidumpWritable*>
@@ -64,18 +174,7 @@ bool MinidumpMemoryInfoListWriter::WriteObject(
     FileWriterInterface* file_writer) {
   DCHECK_EQ(state(), kStateWritable);
 
-  WritableIoVec iov;
-  iov.iov_base = &memory_info_list_base_;
-  iov.iov_len = sizeof(memory_info_list_base_);
-  std::vector<WritableIoVec> iovecs(1, iov);
-
-  for (const auto& minidump_memory_info : items_) {
-    iov.iov_base = &minidump_memory_info;
-    iov.iov_len = sizeof(minidump_memory_info);
-    iovecs.push_back(iov);
-  }
-
-  return file_writer->WriteIoVec(&iovecs);
+  return memory_info_list_.Write(file_writer);
 }
 
 MinidumpStreamType MinidumpMemoryInfoListWriter::StreamType() const {
@@ -24,7 +24,9 @@
 
 #include "base/macros.h"
 #include "minidump/minidump_stream_writer.h"
+#include "minidump/minidump_struct_list.h"
 #include "minidump/minidump_writable.h"
+#include "util/numeric/checked_range.h"
 
 namespace crashpad {
 
@@ -33,6 +35,30 @@ class MinidumpContextWriter;
 class MinidumpMemoryListWriter;
 class MinidumpMemoryWriter;
 
+//! \brief Options that reduce the number of MINIDUMP_MEMORY_INFO entries
+//!     recorded by MinidumpMemoryInfoListWriter::InitializeFromSnapshot().
+//!
+//! The default, zero-initialized, options record one entry for every memory
+//! map region.
+struct MinidumpMemoryInfoListOptions {
+  //! \brief Whether to record adjacent regions as a single entry when they
+  //!     have the same `AllocationProtect`, `State`, `Protect`, and `Type`.
+  //!
+  //! The merged entry carries the `AllocationBase` of the first region that it
+  //! covers.
+  bool merge_adjacent_regions;
+
+  //! \brief Whether to record only regions within #nearby_distance bytes of
+  //!     memory captured elsewhere in the minidump file, such as thread stacks.
+  bool only_near_captured_memory;
+
+  //! \brief The distance, in bytes, by which a region may be separated from
+  //!     captured memory and still be recorded when
+  //!     #only_near_captured_memory is set. `0` retains only regions that
+  //!     overlap captured memory.
+  uint64_t nearby_distance;
+};
+
 //! \brief The writer for a MINIDUMP_MEMORY_INFO_LIST stream in a minidump file,
 //!     containing a list of MINIDUMP_MEMORY_INFO objects.
 class MinidumpMemoryInfoListWriter final
@@ -50,6 +76,22 @@ class MinidumpMemoryInfoListWriter final
   void InitializeFromSnapshot(
       const std::vector<const MemoryMapRegionSnapshot*>& memory_map);
 
+  //! \brief Initializes a MINIDUMP_MEMORY_INFO_LIST based on \a memory_map,
+  //!     reduced as requested by \a options.
+  //!
+  //! \param[in] memory_map The vector of memory map region snapshots to use as
+  //!     source data, in increasing address order.
+  //! \param[in] options Options selecting how the list is reduced.
+  //! \param[in] captured_ranges The address ranges of memory captured elsewhere
+  //!     in the minidump file. This is only consulted when
+  //!     MinidumpMemoryInfoListOptions::only_near_captured_memory is set.
+  //!
+  //! \note Valid in #kStateMutable.
+  void InitializeFromSnapshot(
+      const std::vector<const MemoryMapRegionSnapshot*>& memory_map,
+      const MinidumpMemoryInfoListOptions& options,
+      const std::vector<CheckedRange<uint64_t>>& captured_ranges);
+
  protected:
   // MinidumpWritable:
   bool Freeze() override;
@@ -61,8 +103,8 @@ class MinidumpMemoryInfoListWriter final
   MinidumpStreamType StreamType() const override;
 
  private:
-  MINIDUMP_MEMORY_INFO_LIST memory_info_list_base_;
-  std::vector<MINIDUMP_MEMORY_INFO> items_;
+  internal::MinidumpStructList<MINIDUMP_MEMORY_INFO_LIST, MINIDUMP_MEMORY_INFO>
+      memory_info_list_;
 
   DISALLOW_COPY_AND_ASSIGN(MinidumpMemoryInfoListWriter);
 };
@@ -14,8 +14,10 @@
 
 #include "minidump/minidump_memory_info_writer.h"
 
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/memory/ptr_util.h"
 #include "gtest/gtest.h"
@@ -125,6 +127,124 @@ TEST(MinidumpMemoryInfoWriter, OneRegion) {
   EXPECT_EQ(memory_info->Type, mmi.Type);
 }
 
+// Returns a committed, private, read-write region at |base|.
+MINIDUMP_MEMORY_INFO MakeMemoryInfo(uint64_t base, uint64_t size) {
+  MINIDUMP_MEMORY_INFO mmi = {0};
+  mmi.BaseAddress = base;
+  mmi.AllocationBase = base;
+  mmi.AllocationProtect = PAGE_READWRITE;
+  mmi.RegionSize = size;
+  mmi.State = MEM_COMMIT;
+  mmi.Protect = PAGE_READWRITE;
+  mmi.Type = MEM_PRIVATE;
+  return mmi;
+}
+
+// Writes a memory info list stream built from |regions| with |options| and
+// |captured_ranges|, and returns the entries written in |entries|.
+void WriteReducedMemoryInfoList(
+    const std::vector<MINIDUMP_MEMORY_INFO>& regions,
+    const MinidumpMemoryInfoListOptions& options,
+    const std::vector<CheckedRange<uint64_t>>& captured_ranges,
+    std::vector<MINIDUMP_MEMORY_INFO>* entries) {
+  std::vector<std::unique_ptr<TestMemoryMapRegionSnapshot>> snapshots;
+  std::vector<const MemoryMapRegionSnapshot*> memory_map;
+  for (const MINIDUMP_MEMORY_INFO& region : regions) {
+    snapshots.push_back(base::WrapUnique(new TestMemoryMapRegionSnapshot()));
+    snapshots.back()->SetMindumpMemoryInfo(region);
+    memory_map.push_back(snapshots.back().get());
+  }
+
+  MinidumpFileWriter minidump_file_writer;
+  auto memory_info_list_writer =
+      base::WrapUnique(new MinidumpMemoryInfoListWriter());
+  memory_info_list_writer->InitializeFromSnapshot(
+      memory_map, options, captured_ranges);
+  ASSERT_TRUE(
+      minidump_file_writer.AddStream(std::move(memory_info_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_MEMORY_INFO_LIST* memory_info_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetMemoryInfoListStream(string_file.string(), &memory_info_list));
+
+  const MINIDUMP_MEMORY_INFO* memory_info =
+      reinterpret_cast<const MINIDUMP_MEMORY_INFO*>(&memory_info_list[1]);
+  entries->assign(memory_info,
+                  memory_info + memory_info_list->NumberOfEntries);
+}
+
+TEST(MinidumpMemoryInfoWriter, MergeAdjacentRegions) {
+  std::vector<MINIDUMP_MEMORY_INFO> regions;
+  regions.push_back(MakeMemoryInfo(0x10000, 0x1000));
+  regions.push_back(MakeMemoryInfo(0x11000, 0x2000));
+  regions.push_back(MakeMemoryInfo(0x13000, 0x1000));
+  regions.back().Protect = PAGE_READONLY;
+  regions.push_back(MakeMemoryInfo(0x14000, 0x1000));
+  regions.back().Protect = PAGE_READONLY;
+
+  // Not adjacent to the previous region.
+  regions.push_back(MakeMemoryInfo(0x20000, 0x1000));
+  regions.back().Protect = PAGE_READONLY;
+
+  MinidumpMemoryInfoListOptions options = {};
+  options.merge_adjacent_regions = true;
+
+  std::vector<MINIDUMP_MEMORY_INFO> entries;
+  ASSERT_NO_FATAL_FAILURE(WriteReducedMemoryInfoList(
+      regions, options, std::vector<CheckedRange<uint64_t>>(), &entries));
+
+  ASSERT_EQ(entries.size(), 3u);
+  EXPECT_EQ(entries[0].BaseAddress, 0x10000u);
+  EXPECT_EQ(entries[0].AllocationBase, 0x10000u);
+  EXPECT_EQ(entries[0].RegionSize, 0x3000u);
+  EXPECT_EQ(entries[0].Protect, static_cast<uint32_t>(PAGE_READWRITE));
+  EXPECT_EQ(entries[1].BaseAddress, 0x13000u);
+  EXPECT_EQ(entries[1].RegionSize, 0x2000u);
+  EXPECT_EQ(entries[1].Protect, static_cast<uint32_t>(PAGE_READONLY));
+  EXPECT_EQ(entries[2].BaseAddress, 0x20000u);
+  EXPECT_EQ(entries[2].RegionSize, 0x1000u);
+}
+
+TEST(MinidumpMemoryInfoWriter, OnlyNearCapturedMemory) {
+  std::vector<MINIDUMP_MEMORY_INFO> regions;
+  for (uint64_t base = 0x10000; base < 0x20000; base += 0x1000) {
+    regions.push_back(MakeMemoryInfo(base, 0x1000));
+  }
+
+  // One range within a single region, and one straddling two regions.
+  std::vector<CheckedRange<uint64_t>> captured_ranges;
+  captured_ranges.push_back(CheckedRange<uint64_t>(0x1c800, 0x100));
+  captured_ranges.push_back(CheckedRange<uint64_t>(0x12f00, 0x200));
+
+  MinidumpMemoryInfoListOptions options = {};
+  options.only_near_captured_memory = true;
+
+  std::vector<MINIDUMP_MEMORY_INFO> entries;
+  ASSERT_NO_FATAL_FAILURE(
+      WriteReducedMemoryInfoList(regions, options, captured_ranges, &entries));
+
+  ASSERT_EQ(entries.size(), 3u);
+  EXPECT_EQ(entries[0].BaseAddress, 0x12000u);
+  EXPECT_EQ(entries[1].BaseAddress, 0x13000u);
+  EXPECT_EQ(entries[2].BaseAddress, 0x1c000u);
+
+  // With a nearby distance, neighboring regions are retained too, and merging
+  // combines them.
+  options.nearby_distance = 0x1000;
+  options.merge_adjacent_regions = true;
+  ASSERT_NO_FATAL_FAILURE(
+      WriteReducedMemoryInfoList(regions, options, captured_ranges, &entries));
+
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].BaseAddress, 0x11000u);
+  EXPECT_EQ(entries[0].RegionSize, 0x4000u);
+  EXPECT_EQ(entries[1].BaseAddress, 0x1b000u);
+  EXPECT_EQ(entries[1].RegionSize, 0x3000u);
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
@@ -14,6 +14,9 @@
 
 #include "minidump/minidump_memory_writer.h"
 
+#include <algorithm>
+#include <limits>
+#include <set>
 #include <utility>
 
 #include "base/auto_reset.h"
@@ -21,10 +24,44 @@
 #include "base/memory/ptr_util.h"
 #include "snapshot/memory_snapshot.h"
 #include "util/file/file_writer.h"
+#include "util/numeric/checked_range.h"
 #include "util/numeric/safe_assignment.h"
 
 namespace crashpad {
 
+namespace internal {
+
+MemoryReadBufferPool::MemoryReadBufferPool() : buffers_(), lock_() {}
+
+MemoryReadBufferPool::~MemoryReadBufferPool() {}
+
+std::unique_ptr<std::vector<uint8_t>> MemoryReadBufferPool::Take(size_t size) {
+  std::unique_ptr<std::vector<uint8_t>> buffer;
+  {
+    base::AutoLock lock_owner(lock_);
+    if (!buffers_.empty()) {
+      buffer = std::move(buffers_.back());
+      buffers_.pop_back();
+    }
+  }
+
+  if (!buffer) {
+    buffer.reset(new std::vector<uint8_t>());
+  }
+  if (buffer->size() < size) {
+    buffer->resize(size);
+  }
+  return buffer;
+}
+
+void MemoryReadBufferPool::Return(
+    std::unique_ptr<std::vector<uint8_t>> buffer) {
+  base::AutoLock lock_owner(lock_);
+  buffers_.push_back(std::move(buffer));
+}
+
+}  // namespace internal
+
 SnapshotMinidumpMemoryWriter::SnapshotMinidumpMemoryWriter(
     const MemorySnapshot* memory_snapshot)
     : internal::MinidumpWritable(),
@@ -32,7 +69,12 @@ SnapshotMinidumpMemoryWriter::SnapshotMinidumpMemoryWriter(
       memory_descriptor_(),
       registered_memory_descriptors_(),
       memory_snapshot_(memory_snapshot),
-      file_writer_(nullptr) {}
+      maximum_size_(std::numeric_limits<size_t>::max()),
+      file_writer_(nullptr),
+      read_buffer_pool_(nullptr),
+      original_(nullptr),
+      read_site_(MemoryReadSite::kOther),
+      read_buffer_() {}
 
 SnapshotMinidumpMemoryWriter::~SnapshotMinidumpMemoryWriter() {}
 
@@ -40,7 +82,19 @@ bool SnapshotMinidumpMemoryWriter::MemorySnapshotDelegateRead(void* data,
                                                               size_t size) {
   DCHECK_EQ(state(), kStateWritable);
   DCHECK_EQ(size, UnderlyingSnapshot().Size());
-  return file_writer_->Write(data, size);
+  return file_writer_->Write(data, std::min(size, maximum_size_));
+}
+
+void* SnapshotMinidumpMemoryWriter::MemorySnapshotDelegateBuffer(size_t size) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  if (!read_buffer_pool_) {
+    return nullptr;
+  }
+
+  DCHECK(!read_buffer_);
+  read_buffer_ = read_buffer_pool_->Take(size);
+  return read_buffer_->data();
 }
 
 bool SnapshotMinidumpMemoryWriter::WriteObject(
@@ -48,11 +102,26 @@ bool SnapshotMinidumpMemoryWriter::WriteObject(
   DCHECK_EQ(state(), kStateWritable);
   DCHECK(!file_writer_);
 
+  if (original_) {
+    // The data is written by original_.
+    return true;
+  }
+
   base::AutoReset<FileWriterInterface*> file_writer_reset(&file_writer_,
                                                           file_writer);
 
   // This will result in MemorySnapshotDelegateRead() being called.
-  return memory_snapshot_->Read(this);
+  bool rv;
+  {
+    ScopedMemoryReadSite read_site(read_site_);
+    rv = memory_snapshot_->Read(this);
+  }
+
+  if (read_buffer_) {
+    read_buffer_pool_->Return(std::move(read_buffer_));
+  }
+
+  return rv;
 }
 
 const MINIDUMP_MEMORY_DESCRIPTOR*
@@ -67,7 +136,47 @@ void SnapshotMinidumpMemoryWriter::RegisterMemoryDescriptor(
   DCHECK_LE(state(), kStateFrozen);
 
   registered_memory_descriptors_.push_back(memory_descriptor);
-  RegisterLocationDescriptor(&memory_descriptor->Memory);
+  if (original_) {
+    original_->RegisterLocationDescriptor(&memory_descriptor->Memory);
+  } else {
+    RegisterLocationDescriptor(&memory_descriptor->Memory);
+  }
+}
+
+void SnapshotMinidumpMemoryWriter::SetReadBufferPool(
+    internal::MemoryReadBufferPool* read_buffer_pool) {
+  DCHECK_LE(state(), kStateFrozen);
+
+  read_buffer_pool_ = read_buffer_pool;
+}
+
+void SnapshotMinidumpMemoryWriter::SetSnapshot(
+    const MemorySnapshot* memory_snapshot) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  memory_snapshot_ = memory_snapshot;
+}
+
+void SnapshotMinidumpMemoryWriter::SetMaximumSize(size_t maximum_size) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  maximum_size_ = maximum_size;
+}
+
+void SnapshotMinidumpMemoryWriter::SetDuplicateOf(
+    SnapshotMinidumpMemoryWriter* original) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(original);
+  DCHECK_NE(original, this);
+  DCHECK(!original->original_);
+  DCHECK_EQ(original->WriteSize(), WriteSize());
+  DCHECK(registered_memory_descriptors_.empty());
+
+  original_ = original;
+}
+
+size_t SnapshotMinidumpMemoryWriter::WriteSize() const {
+  return std::min(UnderlyingSnapshot().Size(), maximum_size_);
 }
 
 bool SnapshotMinidumpMemoryWriter::Freeze() {
@@ -91,7 +200,7 @@ size_t SnapshotMinidumpMemoryWriter::Alignment() {
 size_t SnapshotMinidumpMemoryWriter::SizeOfObject() {
   DCHECK_GE(state(), kStateFrozen);
 
-  return UnderlyingSnapshot().Size();
+  return original_ ? 0 : WriteSize();
 }
 
 bool SnapshotMinidumpMemoryWriter::WillWriteAtOffsetImpl(FileOffset offset) {
@@ -129,19 +238,23 @@ MinidumpMemoryListWriter::MinidumpMemoryListWriter()
     : MinidumpStreamWriter(),
       memory_writers_(),
       children_(),
-      memory_list_base_() {
+      memory_list_base_(),
+      snapshots_created_during_merge_(),
+      read_buffer_pool_() {
 }
 
 MinidumpMemoryListWriter::~MinidumpMemoryListWriter() {
 }
 
 void MinidumpMemoryListWriter::AddFromSnapshot(
-    const std::vector<const MemorySnapshot*>& memory_snapshots) {
+    const std::vector<const MemorySnapshot*>& memory_snapshots,
+    MemoryReadSite read_site) {
   DCHECK_EQ(state(), kStateMutable);
 
   for (const MemorySnapshot* memory_snapshot : memory_snapshots) {
     std::unique_ptr<SnapshotMinidumpMemoryWriter> memory(
         new SnapshotMinidumpMemoryWriter(memory_snapshot));
+    memory->SetReadSite(read_site);
     AddMemory(std::move(memory));
   }
 }
@@ -161,6 +274,105 @@ void MinidumpMemoryListWriter::AddExtraMemory(
   memory_writers_.push_back(memory_writer);
 }
 
+void MinidumpMemoryListWriter::CoalesceOwnedMemory(size_t max_gap) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (children_.empty()) {
+    return;
+  }
+
+  const std::set<SnapshotMinidumpMemoryWriter*> owned(children_.begin(),
+                                                      children_.end());
+  std::vector<CheckedRange<uint64_t, size_t>> non_owned_ranges;
+  std::vector<SnapshotMinidumpMemoryWriter*> non_owned_writers;
+  for (SnapshotMinidumpMemoryWriter* memory_writer : memory_writers_) {
+    if (owned.find(memory_writer) == owned.end()) {
+      non_owned_ranges.push_back(CheckedRange<uint64_t, size_t>(
+          memory_writer->UnderlyingSnapshot().Address(),
+          memory_writer->WriteSize()));
+      non_owned_writers.push_back(memory_writer);
+    }
+  }
+
+  // Drop empty ranges and ranges that another object will already write.
+  std::vector<SnapshotMinidumpMemoryWriter*> candidates;
+  for (SnapshotMinidumpMemoryWriter* child : children_) {
+    const MemorySnapshot& snapshot = child->UnderlyingSnapshot();
+    const CheckedRange<uint64_t, size_t> range(snapshot.Address(),
+                                               snapshot.Size());
+    bool redundant = range.size() == 0 || !range.IsValid();
+    for (size_t index = 0; !redundant && index < non_owned_ranges.size();
+         ++index) {
+      const CheckedRange<uint64_t, size_t>& non_owned_range =
+          non_owned_ranges[index];
+      redundant = non_owned_range.IsValid() &&
+                  non_owned_range.ContainsRange(range);
+    }
+
+    if (redundant) {
+      delete child;
+    } else {
+      candidates.push_back(child);
+    }
+  }
+
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](const SnapshotMinidumpMemoryWriter* a_writer,
+               const SnapshotMinidumpMemoryWriter* b_writer) {
+              const MemorySnapshot& a = a_writer->UnderlyingSnapshot();
+              const MemorySnapshot& b = b_writer->UnderlyingSnapshot();
+              if (a.Address() == b.Address()) {
+                return a.Size() < b.Size();
+              }
+              return a.Address() < b.Address();
+            });
+
+  std::vector<SnapshotMinidumpMemoryWriter*> coalesced;
+  for (SnapshotMinidumpMemoryWriter* candidate : candidates) {
+    if (!coalesced.empty()) {
+      SnapshotMinidumpMemoryWriter* top = coalesced.back();
+      const MemorySnapshot& top_snapshot = top->UnderlyingSnapshot();
+      const MemorySnapshot& candidate_snapshot =
+          candidate->UnderlyingSnapshot();
+
+      // Candidates are sorted by address, so the candidate can only begin
+      // before the end of the top range, or after it.
+      const uint64_t top_end = top_snapshot.Address() + top_snapshot.Size();
+      if (candidate_snapshot.Address() <= top_end ||
+          candidate_snapshot.Address() - top_end <= max_gap) {
+        std::unique_ptr<const MemorySnapshot> merged(
+            top_snapshot.MergeWithOtherSnapshot(&candidate_snapshot));
+        if (merged) {
+          top->SetSnapshot(merged.get());
+          snapshots_created_during_merge_.push_back(merged.release());
+          delete candidate;
+          continue;
+        }
+      }
+    }
+
+    coalesced.push_back(candidate);
+  }
+
+  // PointerVector does not delete elements removed by clear(). Every element
+  // has either been deleted above or is retained in coalesced.
+  children_.clear();
+  children_.insert(children_.end(), coalesced.begin(), coalesced.end());
+
+  memory_writers_.swap(non_owned_writers);
+  memory_writers_.insert(
+      memory_writers_.end(), coalesced.begin(), coalesced.end());
+}
+
+uint64_t MinidumpMemoryListWriter::MemorySize() const {
+  uint64_t memory_size = 0;
+  for (const SnapshotMinidumpMemoryWriter* memory_writer : memory_writers_) {
+    memory_size += memory_writer->WriteSize();
+  }
+  return memory_size;
+}
+
 bool MinidumpMemoryListWriter::Freeze() {
   DCHECK_EQ(state(), kStateMutable);
 
@@ -178,6 +390,10 @@ bool MinidumpMemoryListWriter::Freeze() {
     return false;
   }
 
+  for (SnapshotMinidumpMemoryWriter* memory_writer : memory_writers_) {
+    memory_writer->SetReadBufferPool(&read_buffer_pool_);
+  }
+
   return true;
 }
 
@@ -24,14 +24,45 @@
 #include <vector>
 
 #include "base/macros.h"
+#include "base/synchronization/lock.h"
 #include "minidump/minidump_stream_writer.h"
 #include "minidump/minidump_writable.h"
 #include "snapshot/memory_snapshot.h"
 #include "util/file/file_io.h"
+#include "util/misc/memory_read_trace.h"
 #include "util/stdlib/pointer_container.h"
 
 namespace crashpad {
 
+namespace internal {
+
+//! \brief A pool of reusable buffers that memory snapshots are read into.
+//!
+//! Buffers are retained for reuse once returned, so that memory ranges written
+//! one after another are served by a single allocation, and memory ranges
+//! written concurrently are each served by their own. This class is
+//! thread-safe.
+class MemoryReadBufferPool {
+ public:
+  MemoryReadBufferPool();
+  ~MemoryReadBufferPool();
+
+  //! \brief Obtains a buffer of at least \a size bytes from the pool,
+  //!     allocating a new one if none is available.
+  std::unique_ptr<std::vector<uint8_t>> Take(size_t size);
+
+  //! \brief Returns a buffer obtained from Take() to the pool.
+  void Return(std::unique_ptr<std::vector<uint8_t>> buffer);
+
+ private:
+  std::vector<std::unique_ptr<std::vector<uint8_t>>> buffers_;
+  base::Lock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryReadBufferPool);
+};
+
+}  // namespace internal
+
 //! \brief The base class for writers of memory ranges pointed to by
 //!     MINIDUMP_MEMORY_DESCRIPTOR objects in a minidump file.
 class SnapshotMinidumpMemoryWriter : public internal::MinidumpWritable,
@@ -61,9 +92,83 @@ class SnapshotMinidumpMemoryWriter : public internal::MinidumpWritable,
   //! \note Valid in #kStateFrozen or any preceding state.
   void RegisterMemoryDescriptor(MINIDUMP_MEMORY_DESCRIPTOR* memory_descriptor);
 
+  //! \brief Sets a pool of buffers that the underlying memory snapshot’s data
+  //!     will be read directly into when this object is written.
+  //!
+  //! The pool may be shared among any number of objects, so that a single
+  //! allocation can serve every memory range in a minidump file that is
+  //! written sequentially. MinidumpMemoryListWriter arranges for this for all
+  //! of the memory ranges it lists. If no pool is set, the memory snapshot
+  //! implementation provides its own storage.
+  //!
+  //! \param[in] read_buffer_pool The pool to use. This object does not take
+  //!     ownership of \a read_buffer_pool, which must remain valid until this
+  //!     object has been written.
+  //!
+  //! \note Valid in #kStateFrozen or any preceding state.
+  void SetReadBufferPool(internal::MemoryReadBufferPool* read_buffer_pool);
+
+  //! \brief Replaces the memory snapshot that this object will write.
+  //!
+  //! \param[in] memory_snapshot The new memory snapshot. This object does not
+  //!     take ownership of \a memory_snapshot, which must remain valid until
+  //!     this object has been written.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetSnapshot(const MemorySnapshot* memory_snapshot);
+
+  //! \brief Limits the amount of the underlying memory snapshot’s data that
+  //!     will be written.
+  //!
+  //! Only the first \a maximum_size bytes of the memory range, those at its
+  //! lowest addresses, will be written, and the MINIDUMP_MEMORY_DESCRIPTOR
+  //! will describe only that portion of the range. For a thread’s stack, which
+  //! grows downward from its highest address, this retains the memory
+  //! nearest the stack pointer.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetMaximumSize(size_t maximum_size);
+
+  //! \brief Arranges for this object’s MINIDUMP_MEMORY_DESCRIPTOR objects to
+  //!     refer to the data written by \a original instead of to a copy of
+  //!     their own.
+  //!
+  //! This is for memory ranges at different addresses whose contents are
+  //! identical, such as the stacks of idle threads in a pool. Each
+  //! MINIDUMP_MEMORY_DESCRIPTOR retains this object’s own address, but this
+  //! object writes no data.
+  //!
+  //! \param[in] original The object whose data is to be referred to. It must
+  //!     write exactly the same bytes as this object would, and must not
+  //!     itself be a duplicate. This object does not take ownership of \a
+  //!     original, which must be written as part of the same minidump file.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetDuplicateOf(SnapshotMinidumpMemoryWriter* original);
+
+  //! \brief Returns the object given to SetDuplicateOf(), or `nullptr` if this
+  //!     object writes its own data.
+  SnapshotMinidumpMemoryWriter* DuplicateOf() const { return original_; }
+
+  //! \brief Sets the site to which the reads of the underlying memory
+  //!     snapshot’s data are attributed when it is written.
+  //!
+  //! See MemoryReadTrace. The default is MemoryReadSite::kOther.
+  void SetReadSite(MemoryReadSite read_site) { read_site_ = read_site; }
+
+  //! \brief Returns the number of bytes of the underlying memory snapshot’s
+  //!     data that will be written, accounting for any limit set by
+  //!     SetMaximumSize().
+  size_t WriteSize() const;
+
+  //! \brief Gets the underlying memory snapshot that the memory writer will
+  //!     write to the minidump.
+  const MemorySnapshot& UnderlyingSnapshot() const { return *memory_snapshot_; }
+
  private:
   // MemorySnapshot::Delegate:
   bool MemorySnapshotDelegateRead(void* data, size_t size) override;
+  void* MemorySnapshotDelegateBuffer(size_t size) override;
 
   // MinidumpWritable:
   bool Freeze() override;
@@ -94,16 +199,19 @@ class SnapshotMinidumpMemoryWriter : public internal::MinidumpWritable,
   //! \note Valid in any state.
   Phase WritePhase() final;
 
-  //! \brief Gets the underlying memory snapshot that the memory writer will
-  //!     write to the minidump.
-  const MemorySnapshot& UnderlyingSnapshot() const { return *memory_snapshot_; }
-
   MINIDUMP_MEMORY_DESCRIPTOR memory_descriptor_;
 
   // weak
   std::vector<MINIDUMP_MEMORY_DESCRIPTOR*> registered_memory_descriptors_;
   const MemorySnapshot* memory_snapshot_;
+  size_t maximum_size_;
   FileWriterInterface* file_writer_;
+  internal::MemoryReadBufferPool* read_buffer_pool_;  // weak
+  SnapshotMinidumpMemoryWriter* original_;  // weak
+  MemoryReadSite read_site_;
+
+  // Taken from read_buffer_pool_ for the duration of WriteObject().
+  std::unique_ptr<std::vector<uint8_t>> read_buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(SnapshotMinidumpMemoryWriter);
 };
@@ -121,10 +229,13 @@ class MinidumpMemoryListWriter final : public internal::MinidumpStreamWriter {
   //! Memory snapshots are added in the fashion of AddMemory().
   //!
   //! \param[in] memory_snapshots The memory snapshots to use as source data.
+  //! \param[in] read_site The site to which reads of the snapshots’ data are
+  //!     attributed. See SnapshotMinidumpMemoryWriter::SetReadSite().
   //!
   //! \note Valid in #kStateMutable.
   void AddFromSnapshot(
-      const std::vector<const MemorySnapshot*>& memory_snapshots);
+      const std::vector<const MemorySnapshot*>& memory_snapshots,
+      MemoryReadSite read_site);
 
   //! \brief Adds a SnapshotMinidumpMemoryWriter to the MINIDUMP_MEMORY_LIST.
   //!
@@ -150,6 +261,37 @@ class MinidumpMemoryListWriter final : public internal::MinidumpStreamWriter {
   //! \note Valid in #kStateMutable.
   void AddExtraMemory(SnapshotMinidumpMemoryWriter* memory_writer);
 
+  //! \brief Normalizes the memory ranges owned by this object.
+  //!
+  //! Memory ranges added by AddFromSnapshot() and AddMemory() are sorted by
+  //! address, and ranges that overlap, abut, or are separated by no more than
+  //! \a max_gap bytes are merged into a single range. Ranges that are empty or
+  //! fully contained within a range added by AddExtraMemory(), such as a
+  //! thread’s stack, are dropped. This reduces the number of
+  //! MINIDUMP_MEMORY_DESCRIPTOR entries, the size of the minidump file, and the
+  //! number of reads needed to capture the memory.
+  //!
+  //! Ranges added by AddExtraMemory() are owned by other objects and are never
+  //! modified.
+  //!
+  //! \param[in] max_gap The largest number of bytes that may separate two
+  //!     ranges for them to be merged. Bytes in the gap will be captured as
+  //!     well, so this should only be nonzero when the gaps are known to be
+  //!     readable. Pass `0` to merge only overlapping and abutting ranges.
+  //!
+  //! \note Valid in #kStateMutable, after all memory has been added, and
+  //!     before any other object retains a pointer to an owned
+  //!     SnapshotMinidumpMemoryWriter.
+  void CoalesceOwnedMemory(size_t max_gap);
+
+  //! \brief Returns the number of memory ranges in the MINIDUMP_MEMORY_LIST,
+  //!     including those added by AddExtraMemory().
+  size_t MemoryRangeCount() const { return memory_writers_.size(); }
+
+  //! \brief Returns the number of bytes of memory that will be written for the
+  //!     ranges counted by MemoryRangeCount().
+  uint64_t MemorySize() const;
+
  protected:
   // MinidumpWritable:
   bool Freeze() override;
@@ -165,6 +307,12 @@ class MinidumpMemoryListWriter final : public internal::MinidumpStreamWriter {
   PointerVector<SnapshotMinidumpMemoryWriter> children_;
   MINIDUMP_MEMORY_LIST memory_list_base_;
 
+  // Snapshots spanning merged memory ranges, created by CoalesceOwnedMemory().
+  PointerVector<const MemorySnapshot> snapshots_created_during_merge_;
+
+  // Shared by every object in memory_writers_.
+  internal::MemoryReadBufferPool read_buffer_pool_;
+
   DISALLOW_COPY_AND_ASSIGN(MinidumpMemoryListWriter);
 };
 
@@ -332,7 +332,8 @@ TEST(MinidumpMemoryWriter, AddFromSnapshot) {
   }
 
   auto memory_list_writer = base::WrapUnique(new MinidumpMemoryListWriter());
-  memory_list_writer->AddFromSnapshot(memory_snapshots);
+  memory_list_writer->AddFromSnapshot(memory_snapshots,
+                                      MemoryReadSite::kOther);
 
   MinidumpFileWriter minidump_file_writer;
   ASSERT_TRUE(minidump_file_writer.AddStream(std::move(memory_list_writer)));
@@ -357,6 +358,132 @@ TEST(MinidumpMemoryWriter, AddFromSnapshot) {
   }
 }
 
+TEST(MinidumpMemoryWriter, CoalesceOwnedMemory) {
+  MinidumpFileWriter minidump_file_writer;
+
+  // A non-owned range, standing in for a thread’s stack.
+  constexpr uint64_t kStackAddress = 0x5000;
+  constexpr size_t kStackSize = 0x1000;
+  constexpr uint8_t kStackValue = 's';
+  auto test_memory_stream = base::WrapUnique(
+      new TestMemoryStream(kStackAddress, kStackSize, kStackValue));
+
+  auto memory_list_writer = base::WrapUnique(new MinidumpMemoryListWriter());
+  memory_list_writer->AddExtraMemory(test_memory_stream->memory());
+
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(test_memory_stream)));
+
+  struct {
+    uint64_t address;
+    size_t size;
+    char value;
+  } kRanges[] = {
+      // Out of order, to be sorted.
+      {0x2000, 0x10, 'c'},
+      // Overlaps and abuts each other, to be merged into [0x1000, 0x1300).
+      {0x1000, 0x100, 'a'},
+      {0x1080, 0x180, 'a'},
+      {0x1200, 0x100, 'a'},
+      // Separated from [0x2000, 0x2010) by a gap that’s too large to merge.
+      {0x2020, 0x10, 'd'},
+      // Entirely within the stack, to be dropped.
+      {0x5100, 0x200, 'x'},
+      // Empty, to be dropped.
+      {0x3000, 0, 'x'},
+  };
+
+  PointerVector<TestMemorySnapshot> memory_snapshots_owner;
+  std::vector<const MemorySnapshot*> memory_snapshots;
+  for (const auto& range : kRanges) {
+    TestMemorySnapshot* memory_snapshot = new TestMemorySnapshot();
+    memory_snapshots_owner.push_back(memory_snapshot);
+    memory_snapshot->SetAddress(range.address);
+    memory_snapshot->SetSize(range.size);
+    memory_snapshot->SetValue(range.value);
+    memory_snapshots.push_back(memory_snapshot);
+  }
+
+  memory_list_writer->AddFromSnapshot(memory_snapshots,
+                                      MemoryReadSite::kOther);
+  memory_list_writer->CoalesceOwnedMemory(0x8);
+
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(memory_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_MEMORY_LIST* memory_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetMemoryListStream(string_file.string(), &memory_list, 2));
+
+  ASSERT_EQ(memory_list->NumberOfMemoryRanges, 4u);
+
+  struct {
+    uint64_t address;
+    size_t size;
+    char value;
+  } kExpected[] = {
+      {kStackAddress, kStackSize, kStackValue},
+      {0x1000, 0x300, 'a'},
+      {0x2000, 0x10, 'c'},
+      {0x2020, 0x10, 'd'},
+  };
+
+  for (size_t index = 0; index < arraysize(kExpected); ++index) {
+    SCOPED_TRACE(base::StringPrintf("index %" PRIuS, index));
+    MINIDUMP_MEMORY_DESCRIPTOR expected = {};
+    expected.StartOfMemoryRange = kExpected[index].address;
+    expected.Memory.DataSize = kExpected[index].size;
+    ExpectMinidumpMemoryDescriptorAndContents(&expected,
+                                              &memory_list->MemoryRanges[index],
+                                              string_file.string(),
+                                              kExpected[index].value,
+                                              index == arraysize(kExpected) - 1);
+  }
+}
+
+TEST(MinidumpMemoryWriter, CoalesceOwnedMemoryWithGap) {
+  TestMemorySnapshot memory_snapshot_0;
+  memory_snapshot_0.SetAddress(0x1000);
+  memory_snapshot_0.SetSize(0x100);
+  memory_snapshot_0.SetValue('g');
+
+  TestMemorySnapshot memory_snapshot_1;
+  memory_snapshot_1.SetAddress(0x1110);
+  memory_snapshot_1.SetSize(0x10);
+  memory_snapshot_1.SetValue('h');
+
+  std::vector<const MemorySnapshot*> memory_snapshots;
+  memory_snapshots.push_back(&memory_snapshot_1);
+  memory_snapshots.push_back(&memory_snapshot_0);
+
+  auto memory_list_writer = base::WrapUnique(new MinidumpMemoryListWriter());
+  memory_list_writer->AddFromSnapshot(memory_snapshots,
+                                      MemoryReadSite::kOther);
+  memory_list_writer->CoalesceOwnedMemory(0x10);
+
+  MinidumpFileWriter minidump_file_writer;
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(memory_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_MEMORY_LIST* memory_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetMemoryListStream(string_file.string(), &memory_list, 1));
+
+  ASSERT_EQ(memory_list->NumberOfMemoryRanges, 1u);
+
+  MINIDUMP_MEMORY_DESCRIPTOR expected = {};
+  expected.StartOfMemoryRange = 0x1000;
+  expected.Memory.DataSize = 0x120;
+  ExpectMinidumpMemoryDescriptorAndContents(&expected,
+                                            &memory_list->MemoryRanges[0],
+                                            string_file.string(),
+                                            'g',
+                                            true);
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
@@ -165,10 +165,10 @@ void MinidumpMiscInfoWriter::InitializeFromSnapshot(
   system_snapshot->CPUFrequency(&current_hz, &max_hz);
   constexpr uint32_t kHzPerMHz = static_cast<const uint32_t>(1E6);
   SetProcessorPowerInfo(
-      InRangeCast<uint32_t>(current_hz / kHzPerMHz,
-                            std::numeric_limits<uint32_t>::max()),
       InRangeCast<uint32_t>(max_hz / kHzPerMHz,
                             std::numeric_limits<uint32_t>::max()),
+      InRangeCast<uint32_t>(current_hz / kHzPerMHz,
+                            std::numeric_limits<uint32_t>::max()),
       0,
       0,
       0);
@@ -741,7 +741,7 @@ TEST(MinidumpMiscInfoWriter, InitializeFromSnapshot) {
   expect_misc_info.ProcessCreateTime = 0x555c7740;
   expect_misc_info.ProcessUserTime = 60;
   expect_misc_info.ProcessKernelTime = 15;
-  expect_misc_info.ProcessorCurrentMhz = 2800;
+  expect_misc_info.ProcessorCurrentMhz = 2300;
   expect_misc_info.ProcessorMaxMhz = 2800;
   expect_misc_info.TimeZoneId = 1;
   expect_misc_info.TimeZone.Bias = 300;
@@ -29,7 +29,8 @@ MinidumpModuleCrashpadInfoWriter::MinidumpModuleCrashpadInfoWriter()
     : MinidumpWritable(),
       module_(),
       list_annotations_(),
-      simple_annotations_() {
+      simple_annotations_(),
+      annotation_objects_() {
   module_.version = MinidumpModuleCrashpadInfo::kVersion;
 }
 
@@ -41,6 +42,7 @@ void MinidumpModuleCrashpadInfoWriter::InitializeFromSnapshot(
   DCHECK_EQ(state(), kStateMutable);
   DCHECK(!list_annotations_);
   DCHECK(!simple_annotations_);
+  DCHECK(!annotation_objects_);
 
   auto list_annotations = base::WrapUnique(new MinidumpUTF8StringListWriter());
   list_annotations->InitializeFromVector(module_snapshot->AnnotationsVector());
@@ -55,6 +57,13 @@ void MinidumpModuleCrashpadInfoWriter::InitializeFromSnapshot(
   if (simple_annotations->IsUseful()) {
     SetSimpleAnnotations(std::move(simple_annotations));
   }
+
+  auto annotation_objects =
+      base::WrapUnique(new MinidumpAnnotationListWriter());
+  annotation_objects->InitializeFromList(module_snapshot->AnnotationObjects());
+  if (annotation_objects->IsUseful()) {
+    SetAnnotationObjects(std::move(annotation_objects));
+  }
 }
 
 void MinidumpModuleCrashpadInfoWriter::SetListAnnotations(
@@ -71,8 +80,15 @@ void MinidumpModuleCrashpadInfoWriter::SetSimpleAnnotations(
   simple_annotations_ = std::move(simple_annotations);
 }
 
+void MinidumpModuleCrashpadInfoWriter::SetAnnotationObjects(
+    std::unique_ptr<MinidumpAnnotationListWriter> annotation_objects) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  annotation_objects_ = std::move(annotation_objects);
+}
+
 bool MinidumpModuleCrashpadInfoWriter::IsUseful() const {
-  return list_annotations_ || simple_annotations_;
+  return list_annotations_ || simple_annotations_ || annotation_objects_;
 }
 
 bool MinidumpModuleCrashpadInfoWriter::Freeze() {
@@ -91,6 +107,11 @@ bool MinidumpModuleCrashpadInfoWriter::Freeze() {
         &module_.simple_annotations);
   }
 
+  if (annotation_objects_) {
+    annotation_objects_->RegisterLocationDescriptor(
+        &module_.annotation_objects);
+  }
+
   return true;
 }
 
@@ -111,6 +132,9 @@ MinidumpModuleCrashpadInfoWriter::Children() {
   if (simple_annotations_) {
     children.push_back(simple_annotations_.get());
   }
+  if (annotation_objects_) {
+    children.push_back(annotation_objects_.get());
+  }
 
   return children;
 }
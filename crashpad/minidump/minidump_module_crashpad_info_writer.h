@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "base/macros.h"
+#include "minidump/minidump_annotation_writer.h"
 #include "minidump/minidump_extensions.h"
 #include "minidump/minidump_string_writer.h"
 #include "minidump/minidump_writable.h"
@@ -75,11 +76,22 @@ class MinidumpModuleCrashpadInfoWriter final
   void SetSimpleAnnotations(
       std::unique_ptr<MinidumpSimpleStringDictionaryWriter> simple_annotations);
 
+  //! \brief Arranges for MinidumpModuleCrashpadInfo::annotation_objects to
+  //!     point to the MinidumpAnnotationListWriter object to be written by
+  //!     \a annotation_objects.
+  //!
+  //! This object takes ownership of \a annotation_objects and becomes its
+  //! parent in the overall tree of internal::MinidumpWritable objects.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetAnnotationObjects(
+      std::unique_ptr<MinidumpAnnotationListWriter> annotation_objects);
+
   //! \brief Determines whether the object is useful.
   //!
   //! A useful object is one that carries data that makes a meaningful
-  //! contribution to a minidump file. An object carrying list annotations or
-  //! simple annotations would be considered useful.
+  //! contribution to a minidump file. An object carrying list annotations,
+  //! simple annotations, or annotation objects would be considered useful.
   //!
   //! \return `true` if the object is useful, `false` otherwise.
   bool IsUseful() const;
@@ -95,6 +107,7 @@ class MinidumpModuleCrashpadInfoWriter final
   MinidumpModuleCrashpadInfo module_;
   std::unique_ptr<MinidumpUTF8StringListWriter> list_annotations_;
   std::unique_ptr<MinidumpSimpleStringDictionaryWriter> simple_annotations_;
+  std::unique_ptr<MinidumpAnnotationListWriter> annotation_objects_;
 
   DISALLOW_COPY_AND_ASSIGN(MinidumpModuleCrashpadInfoWriter);
 };
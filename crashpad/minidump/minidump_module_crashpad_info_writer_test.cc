@@ -105,6 +105,8 @@ TEST(MinidumpModuleCrashpadInfoWriter, EmptyModule) {
   EXPECT_EQ(module->list_annotations.Rva, 0u);
   EXPECT_EQ(module->simple_annotations.DataSize, 0u);
   EXPECT_EQ(module->simple_annotations.Rva, 0u);
+  EXPECT_EQ(module->annotation_objects.DataSize, 0u);
+  EXPECT_EQ(module->annotation_objects.Rva, 0u);
 }
 
 TEST(MinidumpModuleCrashpadInfoWriter, FullModule) {
@@ -347,6 +349,8 @@ TEST(MinidumpModuleCrashpadInfoWriter, InitializeFromSnapshot) {
   static constexpr char kValue2[] = "different_value";
   static constexpr char kEntry3A[] = "list";
   static constexpr char kEntry3B[] = "erine";
+  static constexpr char kObjectName2[] = "object";
+  static constexpr uint16_t kObjectType2 = 1;
 
   std::vector<const ModuleSnapshot*> module_snapshots;
 
@@ -366,6 +370,10 @@ TEST(MinidumpModuleCrashpadInfoWriter, InitializeFromSnapshot) {
   std::map<std::string, std::string> annotations_simple_map_2;
   annotations_simple_map_2[kKey2] = kValue2;
   module_snapshot_2.SetAnnotationsSimpleMap(annotations_simple_map_2);
+  std::vector<AnnotationSnapshot> annotation_objects_2;
+  annotation_objects_2.push_back(
+      AnnotationSnapshot(kObjectName2, kObjectType2, {'v', 'a', 'l'}));
+  module_snapshot_2.SetAnnotationObjects(annotation_objects_2);
   module_snapshots.push_back(&module_snapshot_2);
 
   TestModuleSnapshot module_snapshot_3;
@@ -445,6 +453,23 @@ TEST(MinidumpModuleCrashpadInfoWriter, InitializeFromSnapshot) {
                 string_file.string(), simple_annotations_2->entries[0].value),
             kValue2);
 
+  const MinidumpAnnotationList* annotation_objects_2_list =
+      MinidumpWritableAtLocationDescriptor<MinidumpAnnotationList>(
+          string_file.string(), module_2->annotation_objects);
+  ASSERT_TRUE(annotation_objects_2_list);
+
+  ASSERT_EQ(annotation_objects_2_list->count, annotation_objects_2.size());
+  EXPECT_EQ(MinidumpUTF8StringAtRVAAsString(
+                string_file.string(),
+                annotation_objects_2_list->objects[0].name),
+            kObjectName2);
+  EXPECT_EQ(annotation_objects_2_list->objects[0].type, kObjectType2);
+
+  const MinidumpAnnotationList* annotation_objects_0 =
+      MinidumpWritableAtLocationDescriptor<MinidumpAnnotationList>(
+          string_file.string(), module_0->annotation_objects);
+  EXPECT_FALSE(annotation_objects_0);
+
   EXPECT_EQ(module_list->modules[2].minidump_module_list_index, 3u);
   const MinidumpModuleCrashpadInfo* module_3 =
       MinidumpWritableAtLocationDescriptor<MinidumpModuleCrashpadInfo>(
@@ -0,0 +1,360 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_reconstructible_memory_writer.h"
+
+#include <windows.h>
+#include <dbghelp.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "snapshot/memory_map_region_snapshot.h"
+#include "snapshot/memory_snapshot.h"
+#include "snapshot/module_snapshot.h"
+#include "util/file/file_writer.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+
+namespace {
+
+// A MemorySnapshot of a portion of another MemorySnapshot. It reads the other
+// snapshot in full, and passes only its own portion on to its delegate.
+class MemorySnapshotSlice final : public MemorySnapshot {
+ public:
+  MemorySnapshotSlice(const MemorySnapshot* snapshot,
+                      size_t offset,
+                      size_t size)
+      : MemorySnapshot(), snapshot_(snapshot), offset_(offset), size_(size) {}
+
+  ~MemorySnapshotSlice() override {}
+
+  // MemorySnapshot:
+
+  uint64_t Address() const override { return snapshot_->Address() + offset_; }
+
+  size_t Size() const override { return size_; }
+
+  bool Read(Delegate* delegate) const override {
+    SliceDelegate slice_delegate(delegate, offset_, size_);
+    return snapshot_->Read(&slice_delegate);
+  }
+
+  const MemorySnapshot* MergeWithOtherSnapshot(
+      const MemorySnapshot* other) const override {
+    LOG(ERROR) << "memory snapshot slices cannot be merged";
+    return nullptr;
+  }
+
+ private:
+  class SliceDelegate final : public Delegate {
+   public:
+    SliceDelegate(Delegate* delegate, size_t offset, size_t size)
+        : Delegate(), delegate_(delegate), offset_(offset), size_(size) {}
+
+    ~SliceDelegate() override {}
+
+    // MemorySnapshot::Delegate:
+    bool MemorySnapshotDelegateRead(void* data, size_t size) override {
+      if (size < offset_ || size - offset_ < size_) {
+        LOG(ERROR) << "size " << size << " too small for slice";
+        return false;
+      }
+      return delegate_->MemorySnapshotDelegateRead(
+          static_cast<uint8_t*>(data) + offset_, size_);
+    }
+
+   private:
+    Delegate* delegate_;  // weak
+    size_t offset_;
+    size_t size_;
+
+    DISALLOW_COPY_AND_ASSIGN(SliceDelegate);
+  };
+
+  const MemorySnapshot* snapshot_;  // weak
+  size_t offset_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemorySnapshotSlice);
+};
+
+// Returns whether a region with the MINIDUMP_MEMORY_INFO |memory_info| holds
+// memory that can be reconstructed from the module file it was mapped from.
+bool IsReconstructibleRegion(const MINIDUMP_MEMORY_INFO& memory_info) {
+  constexpr uint32_t kWritableProtections = PAGE_READWRITE | PAGE_WRITECOPY |
+                                            PAGE_EXECUTE_READWRITE |
+                                            PAGE_EXECUTE_WRITECOPY;
+  return memory_info.State == MEM_COMMIT && memory_info.Type == MEM_IMAGE &&
+         (memory_info.Protect & kWritableProtections) == 0;
+}
+
+}  // namespace
+
+MinidumpReconstructibleMemoryListWriter::
+    MinidumpReconstructibleMemoryListWriter()
+    : internal::MinidumpStreamWriter(),
+      reconstructible_(),
+      range_list_base_(),
+      removed_ranges_(),
+      snapshots_created_during_split_() {}
+
+MinidumpReconstructibleMemoryListWriter::
+    ~MinidumpReconstructibleMemoryListWriter() {}
+
+void MinidumpReconstructibleMemoryListWriter::InitializeFromSnapshot(
+    const std::vector<const MemoryMapRegionSnapshot*>& memory_map,
+    const std::vector<const ModuleSnapshot*>& modules) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(reconstructible_.empty());
+
+  std::vector<uint32_t> modules_by_address;
+  for (size_t index = 0; index < modules.size(); ++index) {
+    uint32_t module_index;
+    if (!AssignIfInRange(&module_index, index)) {
+      break;
+    }
+    if (modules[index]->Size() > 0) {
+      modules_by_address.push_back(module_index);
+    }
+  }
+  std::sort(modules_by_address.begin(),
+            modules_by_address.end(),
+            [&modules](uint32_t a, uint32_t b) {
+              return modules[a]->Address() < modules[b]->Address();
+            });
+
+  for (const MemoryMapRegionSnapshot* region : memory_map) {
+    const MINIDUMP_MEMORY_INFO& memory_info = region->AsMinidumpMemoryInfo();
+    if (!IsReconstructibleRegion(memory_info) || memory_info.RegionSize == 0) {
+      continue;
+    }
+    const uint64_t region_base = memory_info.BaseAddress;
+    const uint64_t region_end = region_base + memory_info.RegionSize;
+
+    // Begin with the last module starting at or below the region, which may
+    // contain its start, and continue with any that begin within it.
+    auto module_it = std::upper_bound(
+        modules_by_address.begin(),
+        modules_by_address.end(),
+        region_base,
+        [&modules](uint64_t address, uint32_t module_index) {
+          return address < modules[module_index]->Address();
+        });
+    if (module_it != modules_by_address.begin()) {
+      --module_it;
+    }
+    for (; module_it != modules_by_address.end() &&
+           modules[*module_it]->Address() < region_end;
+         ++module_it) {
+      const ModuleSnapshot* module = modules[*module_it];
+      const uint64_t base = std::max(region_base, module->Address());
+      const uint64_t end =
+          std::min(region_end, module->Address() + module->Size());
+      if (base >= end) {
+        continue;
+      }
+
+      ReconstructibleRange range;
+      range.base = base;
+      range.end = end;
+      range.module_base = module->Address();
+      range.module_index = *module_it;
+      reconstructible_.push_back(range);
+    }
+  }
+
+  std::sort(reconstructible_.begin(),
+            reconstructible_.end(),
+            [](const ReconstructibleRange& a, const ReconstructibleRange& b) {
+              return a.base < b.base;
+            });
+
+  // Join the ranges of adjacent regions of the same module, and drop any range
+  // that overlaps its predecessor, as only overlapping modules could cause.
+  std::vector<ReconstructibleRange> joined;
+  for (const ReconstructibleRange& range : reconstructible_) {
+    if (!joined.empty()) {
+      ReconstructibleRange& last = joined.back();
+      if (range.base < last.end) {
+        continue;
+      }
+      if (range.base == last.end && range.module_index == last.module_index) {
+        last.end = range.end;
+        continue;
+      }
+    }
+    joined.push_back(range);
+  }
+  reconstructible_.swap(joined);
+}
+
+std::vector<const MemorySnapshot*>
+MinidumpReconstructibleMemoryListWriter::ExcludeReconstructibleMemory(
+    const std::vector<const MemorySnapshot*>& memory_snapshots,
+    bool split_snapshots) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  std::vector<const MemorySnapshot*> result;
+  for (const MemorySnapshot* memory_snapshot : memory_snapshots) {
+    const uint64_t base = memory_snapshot->Address();
+    const uint64_t end = base + memory_snapshot->Size();
+
+    // Find the first reconstructible range that ends after the snapshot
+    // begins.
+    const size_t first_index =
+        std::upper_bound(reconstructible_.begin(),
+                         reconstructible_.end(),
+                         base,
+                         [](uint64_t address, const ReconstructibleRange& r) {
+                           return address < r.end;
+                         }) -
+        reconstructible_.begin();
+
+    // Find the portions of the snapshot that aren’t reconstructible.
+    std::vector<std::pair<uint64_t, uint64_t>> kept;
+    uint64_t cursor = base;
+    size_t end_index = first_index;
+    for (; end_index < reconstructible_.size() &&
+           reconstructible_[end_index].base < end;
+         ++end_index) {
+      const ReconstructibleRange& range = reconstructible_[end_index];
+      if (range.base > cursor) {
+        kept.push_back(std::make_pair(cursor, range.base));
+      }
+      cursor = std::min(end, range.end);
+    }
+    if (cursor < end) {
+      kept.push_back(std::make_pair(cursor, end));
+    }
+
+    if (end_index == first_index || base == end ||
+        (!split_snapshots && !kept.empty())) {
+      result.push_back(memory_snapshot);
+      continue;
+    }
+
+    for (size_t index = first_index; index < end_index; ++index) {
+      const ReconstructibleRange& range = reconstructible_[index];
+      RecordRemovedRange(
+          index, std::max(base, range.base), std::min(end, range.end));
+    }
+
+    for (const auto& portion : kept) {
+      const MemorySnapshot* slice = new MemorySnapshotSlice(
+          memory_snapshot,
+          static_cast<size_t>(portion.first - base),
+          static_cast<size_t>(portion.second - portion.first));
+      snapshots_created_during_split_.push_back(slice);
+      result.push_back(slice);
+    }
+  }
+
+  return result;
+}
+
+bool MinidumpReconstructibleMemoryListWriter::IsUseful() const {
+  return !removed_ranges_.empty();
+}
+
+bool MinidumpReconstructibleMemoryListWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (!MinidumpStreamWriter::Freeze()) {
+    return false;
+  }
+
+  // The same range may have been removed from several snapshots, so the
+  // removed ranges are sorted, and those that overlap or abut within a module
+  // are joined.
+  std::sort(removed_ranges_.begin(),
+            removed_ranges_.end(),
+            [](const MinidumpCrashpadReconstructibleMemoryRange& a,
+               const MinidumpCrashpadReconstructibleMemoryRange& b) {
+              return a.start_of_memory_range < b.start_of_memory_range;
+            });
+  std::vector<MinidumpCrashpadReconstructibleMemoryRange> joined;
+  for (const MinidumpCrashpadReconstructibleMemoryRange& range :
+       removed_ranges_) {
+    if (!joined.empty()) {
+      MinidumpCrashpadReconstructibleMemoryRange& last = joined.back();
+      const uint64_t last_end = last.start_of_memory_range + last.data_size;
+      if (range.module_index == last.module_index &&
+          range.start_of_memory_range <= last_end) {
+        last.data_size =
+            std::max(last_end, range.start_of_memory_range + range.data_size) -
+            last.start_of_memory_range;
+        continue;
+      }
+    }
+    joined.push_back(range);
+  }
+  removed_ranges_.swap(joined);
+
+  size_t range_count = removed_ranges_.size();
+  if (!AssignIfInRange(&range_list_base_.count, range_count)) {
+    LOG(ERROR) << "range_count " << range_count << " out of range";
+    return false;
+  }
+
+  return true;
+}
+
+size_t MinidumpReconstructibleMemoryListWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return sizeof(range_list_base_) +
+         removed_ranges_.size() *
+             sizeof(MinidumpCrashpadReconstructibleMemoryRange);
+}
+
+bool MinidumpReconstructibleMemoryListWriter::WriteObject(
+    FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  WritableIoVec iov;
+  iov.iov_base = &range_list_base_;
+  iov.iov_len = sizeof(range_list_base_);
+  std::vector<WritableIoVec> iovecs(1, iov);
+
+  if (!removed_ranges_.empty()) {
+    iov.iov_base = &removed_ranges_[0];
+    iov.iov_len = removed_ranges_.size() *
+                  sizeof(MinidumpCrashpadReconstructibleMemoryRange);
+    iovecs.push_back(iov);
+  }
+
+  return file_writer->WriteIoVec(&iovecs);
+}
+
+MinidumpStreamType MinidumpReconstructibleMemoryListWriter::StreamType()
+    const {
+  return kMinidumpStreamTypeCrashpadReconstructibleMemoryList;
+}
+
+void MinidumpReconstructibleMemoryListWriter::RecordRemovedRange(size_t index,
+                                                                 uint64_t base,
+                                                                 uint64_t end) {
+  const ReconstructibleRange& range = reconstructible_[index];
+  MinidumpCrashpadReconstructibleMemoryRange removed_range;
+  removed_range.start_of_memory_range = base;
+  removed_range.data_size = end - base;
+  removed_range.module_index = range.module_index;
+  removed_range.module_offset = base - range.module_base;
+  removed_ranges_.push_back(removed_range);
+}
+
+}  // namespace crashpad
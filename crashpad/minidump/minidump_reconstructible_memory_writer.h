@@ -0,0 +1,132 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_RECONSTRUCTIBLE_MEMORY_WRITER_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_RECONSTRUCTIBLE_MEMORY_WRITER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_stream_writer.h"
+#include "util/stdlib/pointer_container.h"
+
+namespace crashpad {
+
+class MemoryMapRegionSnapshot;
+class MemorySnapshot;
+class ModuleSnapshot;
+
+//! \brief The writer for a MinidumpCrashpadReconstructibleMemoryList stream in
+//!     a minidump file, containing a list of
+//!     MinidumpCrashpadReconstructibleMemoryRange objects.
+//!
+//! Memory mapped from a module file without being writable, such as the code
+//! and read-only data of a module, is expected to be identical to the module
+//! file, which can be retrieved from a symbol server. This object removes such
+//! memory from the memory to be captured, and records what it removed, so that
+//! the minidump file is smaller but no less complete.
+class MinidumpReconstructibleMemoryListWriter final
+    : public internal::MinidumpStreamWriter {
+ public:
+  MinidumpReconstructibleMemoryListWriter();
+  ~MinidumpReconstructibleMemoryListWriter() override;
+
+  //! \brief Determines which memory is reconstructible from the regions of
+  //!     \a memory_map and the modules in \a modules.
+  //!
+  //! A region is reconstructible when its MINIDUMP_MEMORY_INFO has `State`
+  //! ::MEM_COMMIT, `Type` ::MEM_IMAGE, and a `Protect` value that doesn’t
+  //! allow writing, and only the portion of it within a module’s address range
+  //! is. The content of a page that was once writable can’t be told from its
+  //! current protection, so such pages are assumed to be unmodified.
+  //!
+  //! \param[in] memory_map The memory map of the process.
+  //! \param[in] modules The modules of the process, in the order of the module
+  //!     list stream, so that their indices identify them.
+  //!
+  //! \note Valid in #kStateMutable.
+  void InitializeFromSnapshot(
+      const std::vector<const MemoryMapRegionSnapshot*>& memory_map,
+      const std::vector<const ModuleSnapshot*>& modules);
+
+  //! \brief Removes reconstructible memory from \a memory_snapshots, and
+  //!     records each range removed.
+  //!
+  //! \param[in] memory_snapshots The memory to be captured.
+  //! \param[in] split_snapshots Whether a snapshot that is only partly
+  //!     reconstructible is to be replaced by snapshots of the rest of it. If
+  //!     `false`, such a snapshot is kept whole, and only snapshots that are
+  //!     entirely reconstructible are removed. The replacements read the
+  //!     snapshot they replace, but can’t be merged with other snapshots, so
+  //!     this must be `false` for memory that
+  //!     MinidumpMemoryListWriter::CoalesceOwnedMemory() will coalesce.
+  //!
+  //! \return The memory to capture in place of \a memory_snapshots. Any
+  //!     replacement snapshots are owned by this object, and remain valid for
+  //!     as long as it does.
+  //!
+  //! \note Valid in #kStateMutable, after InitializeFromSnapshot().
+  std::vector<const MemorySnapshot*> ExcludeReconstructibleMemory(
+      const std::vector<const MemorySnapshot*>& memory_snapshots,
+      bool split_snapshots);
+
+  //! \brief Determines whether the object is useful.
+  //!
+  //! A useful object is one that carries data that makes a meaningful
+  //! contribution to a minidump file. An object that has removed any memory
+  //! would be considered useful.
+  //!
+  //! \return `true` if the object is useful, `false` otherwise.
+  bool IsUseful() const;
+
+ protected:
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t SizeOfObject() override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+
+  // MinidumpStreamWriter:
+  MinidumpStreamType StreamType() const override;
+
+ private:
+  // A reconstructible address range, [base, end), within a module.
+  struct ReconstructibleRange {
+    uint64_t base;
+    uint64_t end;
+    uint64_t module_base;
+    uint32_t module_index;
+  };
+
+  // Records that [base, end) of reconstructible_[index] has been removed.
+  void RecordRemovedRange(size_t index, uint64_t base, uint64_t end);
+
+  // Sorted by base, with no overlaps.
+  std::vector<ReconstructibleRange> reconstructible_;
+
+  MinidumpCrashpadReconstructibleMemoryList range_list_base_;
+  std::vector<MinidumpCrashpadReconstructibleMemoryRange> removed_ranges_;
+
+  // Snapshots replacing those split by ExcludeReconstructibleMemory().
+  PointerVector<const MemorySnapshot> snapshots_created_during_split_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpReconstructibleMemoryListWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_RECONSTRUCTIBLE_MEMORY_WRITER_H_
@@ -0,0 +1,263 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_reconstructible_memory_writer.h"
+
+#include <windows.h>
+#include <dbghelp.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/test/minidump_file_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "snapshot/test/test_memory_map_region_snapshot.h"
+#include "snapshot/test/test_memory_snapshot.h"
+#include "snapshot/test/test_module_snapshot.h"
+#include "snapshot/test/test_process_snapshot.h"
+#include "snapshot/test/test_system_snapshot.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr uint64_t kModuleAddress = 0x400000;
+constexpr uint64_t kModuleSize = 0x10000;
+
+// Adds a module at kModuleAddress, following an unrelated module, with the
+// memory map regions of a typical image: read-only headers, code, writable
+// data, and read-only data. An anonymous region follows the module.
+void PopulateProcessSnapshot(TestProcessSnapshot* process_snapshot) {
+  auto system_snapshot = base::WrapUnique(new TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemMacOSX);
+  process_snapshot->SetSystem(std::move(system_snapshot));
+
+  auto other_module = base::WrapUnique(new TestModuleSnapshot());
+  other_module->SetName("other");
+  other_module->SetAddressAndSize(0x100000, 0x1000);
+  process_snapshot->AddModule(std::move(other_module));
+
+  auto module = base::WrapUnique(new TestModuleSnapshot());
+  module->SetName("module");
+  module->SetAddressAndSize(kModuleAddress, kModuleSize);
+  process_snapshot->AddModule(std::move(module));
+
+  struct {
+    uint64_t base;
+    uint64_t size;
+    uint32_t protect;
+    uint32_t type;
+  } constexpr kRegions[] = {
+      {0x400000, 0x1000, PAGE_READONLY, MEM_IMAGE},
+      {0x401000, 0x7000, PAGE_EXECUTE_READ, MEM_IMAGE},
+      {0x408000, 0x2000, PAGE_READWRITE, MEM_IMAGE},
+      {0x40a000, 0x6000, PAGE_READONLY, MEM_IMAGE},
+      {0x410000, 0x4000, PAGE_READONLY, MEM_PRIVATE},
+  };
+  for (const auto& region : kRegions) {
+    MINIDUMP_MEMORY_INFO memory_info = {};
+    memory_info.BaseAddress = region.base;
+    memory_info.AllocationBase = kModuleAddress;
+    memory_info.RegionSize = region.size;
+    memory_info.State = MEM_COMMIT;
+    memory_info.Protect = region.protect;
+    memory_info.AllocationProtect = region.protect;
+    memory_info.Type = region.type;
+    auto region_snapshot =
+        base::WrapUnique(new TestMemoryMapRegionSnapshot());
+    region_snapshot->SetMindumpMemoryInfo(memory_info);
+    process_snapshot->AddMemoryMapRegion(std::move(region_snapshot));
+  }
+}
+
+const MINIDUMP_DIRECTORY* FindStream(const std::string& file_contents,
+                                     MinidumpStreamType stream_type) {
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(file_contents, &directory);
+  if (!header || !directory) {
+    return nullptr;
+  }
+  for (size_t index = 0; index < header->NumberOfStreams; ++index) {
+    if (directory[index].StreamType == stream_type) {
+      return &directory[index];
+    }
+  }
+  return nullptr;
+}
+
+TEST(MinidumpReconstructibleMemoryListWriter, NoMemoryMap) {
+  TestProcessSnapshot process_snapshot;
+
+  TestMemorySnapshot memory_snapshot;
+  memory_snapshot.SetAddress(kModuleAddress);
+  memory_snapshot.SetSize(0x1000);
+  std::vector<const MemorySnapshot*> memory_snapshots(1, &memory_snapshot);
+
+  MinidumpReconstructibleMemoryListWriter reconstructible_memory;
+  reconstructible_memory.InitializeFromSnapshot(process_snapshot.MemoryMap(),
+                                                process_snapshot.Modules());
+  EXPECT_EQ(reconstructible_memory.ExcludeReconstructibleMemory(
+                memory_snapshots, true),
+            memory_snapshots);
+  EXPECT_FALSE(reconstructible_memory.IsUseful());
+}
+
+TEST(MinidumpReconstructibleMemoryListWriter, WholeSnapshots) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshot(&process_snapshot);
+
+  // Within the code, straddling the code and data, within the data, and within
+  // the unrelated module, which has no memory map regions.
+  TestMemorySnapshot memory_snapshots[4];
+  memory_snapshots[0].SetAddress(0x402000);
+  memory_snapshots[0].SetSize(0x100);
+  memory_snapshots[1].SetAddress(0x407f00);
+  memory_snapshots[1].SetSize(0x200);
+  memory_snapshots[2].SetAddress(0x408100);
+  memory_snapshots[2].SetSize(0x100);
+  memory_snapshots[3].SetAddress(0x100100);
+  memory_snapshots[3].SetSize(0x100);
+  std::vector<const MemorySnapshot*> memory_snapshot_pointers;
+  for (const TestMemorySnapshot& memory_snapshot : memory_snapshots) {
+    memory_snapshot_pointers.push_back(&memory_snapshot);
+  }
+
+  MinidumpReconstructibleMemoryListWriter reconstructible_memory;
+  reconstructible_memory.InitializeFromSnapshot(process_snapshot.MemoryMap(),
+                                                process_snapshot.Modules());
+  const std::vector<const MemorySnapshot*> kept =
+      reconstructible_memory.ExcludeReconstructibleMemory(
+          memory_snapshot_pointers, false);
+  ASSERT_EQ(kept.size(), 3u);
+  EXPECT_EQ(kept[0], &memory_snapshots[1]);
+  EXPECT_EQ(kept[1], &memory_snapshots[2]);
+  EXPECT_EQ(kept[2], &memory_snapshots[3]);
+  EXPECT_TRUE(reconstructible_memory.IsUseful());
+}
+
+TEST(MinidumpReconstructibleMemoryListWriter, InitializeFromSnapshot) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshot(&process_snapshot);
+
+  auto code_memory = base::WrapUnique(new TestMemorySnapshot());
+  code_memory->SetAddress(0x402000);
+  code_memory->SetSize(0x100);
+  code_memory->SetValue('c');
+  process_snapshot.AddExtraMemory(std::move(code_memory));
+
+  auto data_memory = base::WrapUnique(new TestMemorySnapshot());
+  constexpr uint64_t kDataMemoryAddress = 0x408100;
+  data_memory->SetAddress(kDataMemoryAddress);
+  constexpr size_t kDataMemorySize = 0x100;
+  data_memory->SetSize(kDataMemorySize);
+  data_memory->SetValue('d');
+  process_snapshot.AddExtraMemory(std::move(data_memory));
+
+  // The full memory covers the whole module, and the memory on either side of
+  // it.
+  TestMemorySnapshot full_memory_snapshot;
+  constexpr uint64_t kFullMemoryAddress = 0x3ff000;
+  full_memory_snapshot.SetAddress(kFullMemoryAddress);
+  full_memory_snapshot.SetSize(0x13000);
+  full_memory_snapshot.SetValue('f');
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetFullMemory(
+      std::vector<const MemorySnapshot*>(1, &full_memory_snapshot), false);
+  minidump_file_writer.SetExcludeReconstructibleMemory(true);
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_DIRECTORY* directory = FindStream(
+      string_file.string(),
+      kMinidumpStreamTypeCrashpadReconstructibleMemoryList);
+  ASSERT_TRUE(directory);
+  const MinidumpCrashpadReconstructibleMemoryList* range_list =
+      MinidumpWritableAtLocationDescriptor<
+          MinidumpCrashpadReconstructibleMemoryList>(string_file.string(),
+                                                     directory->Location);
+  ASSERT_TRUE(range_list);
+  ASSERT_EQ(range_list->count, 2u);
+  ASSERT_EQ(directory->Location.DataSize,
+            sizeof(MinidumpCrashpadReconstructibleMemoryList) +
+                2 * sizeof(MinidumpCrashpadReconstructibleMemoryRange));
+  const MinidumpCrashpadReconstructibleMemoryRange* ranges =
+      reinterpret_cast<const MinidumpCrashpadReconstructibleMemoryRange*>(
+          range_list + 1);
+
+  // The headers and code are joined, and the code’s extra memory range is
+  // within them.
+  EXPECT_EQ(ranges[0].start_of_memory_range, kModuleAddress);
+  EXPECT_EQ(ranges[0].data_size, 0x8000u);
+  EXPECT_EQ(ranges[0].module_index, 1u);
+  EXPECT_EQ(ranges[0].module_offset, 0u);
+  EXPECT_EQ(ranges[1].start_of_memory_range, 0x40a000u);
+  EXPECT_EQ(ranges[1].data_size, 0x6000u);
+  EXPECT_EQ(ranges[1].module_index, 1u);
+  EXPECT_EQ(ranges[1].module_offset, 0xa000u);
+
+  // Only the data’s extra memory range remains in the memory list.
+  directory =
+      FindStream(string_file.string(), kMinidumpStreamTypeMemoryList);
+  ASSERT_TRUE(directory);
+  const MINIDUMP_MEMORY_LIST* memory_list =
+      MinidumpWritableAtLocationDescriptor<MINIDUMP_MEMORY_LIST>(
+          string_file.string(), directory->Location);
+  ASSERT_TRUE(memory_list);
+  ASSERT_EQ(memory_list->NumberOfMemoryRanges, 1u);
+  EXPECT_EQ(memory_list->MemoryRanges[0].StartOfMemoryRange,
+            kDataMemoryAddress);
+  EXPECT_EQ(memory_list->MemoryRanges[0].Memory.DataSize, kDataMemorySize);
+
+  // The full memory keeps what precedes the module, its data, and what follows
+  // it.
+  directory =
+      FindStream(string_file.string(), kMinidumpStreamTypeMemory64List);
+  ASSERT_TRUE(directory);
+  const MINIDUMP_MEMORY64_LIST* memory64_list =
+      MinidumpWritableAtLocationDescriptor<MINIDUMP_MEMORY64_LIST>(
+          string_file.string(), directory->Location);
+  ASSERT_TRUE(memory64_list);
+  ASSERT_EQ(memory64_list->NumberOfMemoryRanges, 3u);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].StartOfMemoryRange,
+            kFullMemoryAddress);
+  EXPECT_EQ(memory64_list->MemoryRanges[0].DataSize, 0x1000u);
+  EXPECT_EQ(memory64_list->MemoryRanges[1].StartOfMemoryRange, 0x408000u);
+  EXPECT_EQ(memory64_list->MemoryRanges[1].DataSize, 0x2000u);
+  EXPECT_EQ(memory64_list->MemoryRanges[2].StartOfMemoryRange, 0x410000u);
+  EXPECT_EQ(memory64_list->MemoryRanges[2].DataSize, 0x2000u);
+
+  const uint64_t memory_size = 0x1000 + 0x2000 + 0x2000;
+  ASSERT_EQ(string_file.string().size(), memory64_list->BaseRva + memory_size);
+  EXPECT_EQ(string_file.string().substr(
+                static_cast<size_t>(memory64_list->BaseRva)),
+            std::string(memory_size, 'f'));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
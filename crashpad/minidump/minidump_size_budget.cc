@@ -0,0 +1,136 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_size_budget.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "minidump/minidump_extensions.h"
+#include "snapshot/exception_snapshot.h"
+#include "snapshot/memory_snapshot.h"
+#include "snapshot/process_snapshot.h"
+#include "snapshot/thread_snapshot.h"
+
+namespace crashpad {
+namespace internal {
+
+namespace {
+
+// Returns the number of bytes retained from stacks of the sizes in
+// |stack_sizes| when each is limited to |limit| bytes.
+uint64_t RetainedStackSize(const std::vector<size_t>& stack_sizes,
+                           size_t limit) {
+  uint64_t retained = 0;
+  for (size_t stack_size : stack_sizes) {
+    retained += std::min(stack_size, limit);
+  }
+  return retained;
+}
+
+}  // namespace
+
+MinidumpSizeBudgetPlan::MinidumpSizeBudgetPlan()
+    : thread_extra_memory_count(std::numeric_limits<size_t>::max()),
+      memory_info_count(std::numeric_limits<size_t>::max()),
+      stack_size(std::numeric_limits<size_t>::max()),
+      has_exempt_thread_id(false),
+      exempt_thread_id(0) {
+}
+
+bool TightenMinidumpSizeBudgetPlan(const ProcessSnapshot* process_snapshot,
+                                   size_t excess,
+                                   MinidumpSizeBudgetPlan* plan) {
+  const std::vector<const ThreadSnapshot*> threads =
+      process_snapshot->Threads();
+
+  std::vector<size_t> extra_memory_sizes;
+  std::vector<size_t> stack_sizes;
+  for (const ThreadSnapshot* thread : threads) {
+    for (const MemorySnapshot* extra_memory : thread->ExtraMemory()) {
+      extra_memory_sizes.push_back(extra_memory->Size());
+    }
+
+    if (plan->has_exempt_thread_id &&
+        thread->ThreadID() == plan->exempt_thread_id) {
+      continue;
+    }
+    const MemorySnapshot* stack = thread->Stack();
+    if (stack) {
+      stack_sizes.push_back(stack->Size());
+    }
+  }
+
+  bool changed = false;
+  uint64_t saved = 0;
+
+  // First, drop indirectly-referenced memory, from the end.
+  plan->thread_extra_memory_count =
+      std::min(plan->thread_extra_memory_count, extra_memory_sizes.size());
+  while (saved < excess && plan->thread_extra_memory_count > 0) {
+    --plan->thread_extra_memory_count;
+    saved += extra_memory_sizes[plan->thread_extra_memory_count] +
+             sizeof(MINIDUMP_MEMORY_DESCRIPTOR);
+    changed = true;
+  }
+
+  // Next, drop memory map entries, from the end.
+  plan->memory_info_count = std::min(plan->memory_info_count,
+                                     process_snapshot->MemoryMap().size());
+  if (saved < excess && plan->memory_info_count > 0) {
+    const size_t needed = (excess - saved + sizeof(MINIDUMP_MEMORY_INFO) - 1) /
+                          sizeof(MINIDUMP_MEMORY_INFO);
+    const size_t dropped = std::min(needed, plan->memory_info_count);
+    plan->memory_info_count -= dropped;
+    saved += dropped * sizeof(MINIDUMP_MEMORY_INFO);
+    changed = true;
+  }
+
+  // Finally, truncate the stacks of threads other than the exempt thread. All
+  // such stacks are limited to the same size, which is chosen to be as large
+  // as possible while still achieving the required savings.
+  if (saved < excess && !stack_sizes.empty()) {
+    size_t limit = std::min(
+        plan->stack_size,
+        *std::max_element(stack_sizes.begin(), stack_sizes.end()));
+    const uint64_t retained = RetainedStackSize(stack_sizes, limit);
+    if (retained > 0) {
+      const uint64_t remaining = excess - saved;
+      if (retained <= remaining) {
+        limit = 0;
+      } else {
+        const uint64_t target = retained - remaining;
+        size_t low = 0;
+        size_t high = limit;
+        while (low < high) {
+          const size_t middle = low + (high - low + 1) / 2;
+          if (RetainedStackSize(stack_sizes, middle) <= target) {
+            low = middle;
+          } else {
+            high = middle - 1;
+          }
+        }
+        limit = low;
+      }
+      plan->stack_size = limit;
+      changed = true;
+    }
+  }
+
+  return changed;
+}
+
+}  // namespace internal
+}  // namespace crashpad
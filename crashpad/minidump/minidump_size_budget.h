@@ -0,0 +1,86 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_SIZE_BUDGET_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_SIZE_BUDGET_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace crashpad {
+
+class ProcessSnapshot;
+
+namespace internal {
+
+//! \brief Describes how much of a process snapshot’s memory-related data is
+//!     to be written to a minidump file in order for it to fit within a size
+//!     budget.
+//!
+//! A default-constructed plan retains everything.
+struct MinidumpSizeBudgetPlan {
+  MinidumpSizeBudgetPlan();
+
+  //! \brief The number of indirectly-referenced memory ranges, obtained from
+  //!     ThreadSnapshot::ExtraMemory() for each thread in turn, to retain.
+  //!
+  //! Ranges beyond this count, taken in thread order, are dropped.
+  size_t thread_extra_memory_count;
+
+  //! \brief The number of MINIDUMP_MEMORY_INFO entries, taken in order from
+  //!     ProcessSnapshot::MemoryMap(), to retain.
+  size_t memory_info_count;
+
+  //! \brief The maximum number of bytes of each thread’s stack to retain.
+  //!
+  //! This does not apply to the thread identified by #exempt_thread_id.
+  size_t stack_size;
+
+  //! \brief Whether #exempt_thread_id is valid.
+  bool has_exempt_thread_id;
+
+  //! \brief The ID of a thread, normally the one that raised the exception,
+  //!     whose stack is never truncated.
+  uint64_t exempt_thread_id;
+};
+
+//! \brief Adjusts a size budget plan so that a minidump file written according
+//!     to it will be smaller by at least \a excess bytes.
+//!
+//! Data is evicted in priority order. Indirectly-referenced memory is the
+//! first to go, followed by memory map entries. Only after those are
+//! exhausted are the stacks of threads other than the exempt thread
+//! truncated, all to a common limit, removing the memory furthest from each
+//! stack pointer.
+//!
+//! The savings are estimated. Where memory ranges overlap and would have been
+//! coalesced, the actual savings may be smaller than estimated, so callers
+//! should measure the result and call this again if necessary.
+//!
+//! \param[in] process_snapshot The snapshot that the minidump file will be
+//!     written from.
+//! \param[in] excess The number of bytes that the minidump file must shrink
+//!     by.
+//! \param[in,out] plan The plan to adjust.
+//!
+//! \return `true` if \a plan was changed. `false` if there was nothing left to
+//!     evict, in which case \a plan is unchanged.
+bool TightenMinidumpSizeBudgetPlan(const ProcessSnapshot* process_snapshot,
+                                   size_t excess,
+                                   MinidumpSizeBudgetPlan* plan);
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_SIZE_BUDGET_H_
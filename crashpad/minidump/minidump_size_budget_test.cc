@@ -0,0 +1,186 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_size_budget.h"
+
+#include <limits>
+#include <utility>
+
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/test/minidump_file_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "snapshot/test/test_cpu_context.h"
+#include "snapshot/test/test_exception_snapshot.h"
+#include "snapshot/test/test_memory_map_region_snapshot.h"
+#include "snapshot/test/test_memory_snapshot.h"
+#include "snapshot/test/test_process_snapshot.h"
+#include "snapshot/test/test_system_snapshot.h"
+#include "snapshot/test/test_thread_snapshot.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr uint64_t kCrashingThreadID = 1;
+constexpr uint64_t kOtherThreadID = 2;
+constexpr size_t kCrashingStackSize = 0x4000;
+constexpr size_t kOtherStackSize = 0x2000;
+constexpr size_t kExtraMemorySize = 0x100;
+constexpr size_t kMemoryMapRegionCount = 4;
+
+std::unique_ptr<TestMemorySnapshot> MakeMemorySnapshot(uint64_t address,
+                                                       size_t size,
+                                                       char value) {
+  auto memory_snapshot = base::WrapUnique(new TestMemorySnapshot());
+  memory_snapshot->SetAddress(address);
+  memory_snapshot->SetSize(size);
+  memory_snapshot->SetValue(value);
+  return memory_snapshot;
+}
+
+void InitializeProcessSnapshot(TestProcessSnapshot* process_snapshot) {
+  auto system_snapshot = base::WrapUnique(new TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemMacOSX);
+  process_snapshot->SetSystem(std::move(system_snapshot));
+
+  auto crashing_thread = base::WrapUnique(new TestThreadSnapshot());
+  InitializeCPUContextX86_64(crashing_thread->MutableContext(), 5);
+  crashing_thread->SetThreadID(kCrashingThreadID);
+  crashing_thread->SetStack(
+      MakeMemorySnapshot(0x10000, kCrashingStackSize, 's'));
+  process_snapshot->AddThread(std::move(crashing_thread));
+
+  auto other_thread = base::WrapUnique(new TestThreadSnapshot());
+  InitializeCPUContextX86_64(other_thread->MutableContext(), 7);
+  other_thread->SetThreadID(kOtherThreadID);
+  other_thread->SetStack(MakeMemorySnapshot(0x20000, kOtherStackSize, 't'));
+  other_thread->AddExtraMemory(
+      MakeMemorySnapshot(0x30000, kExtraMemorySize, 'a'));
+  other_thread->AddExtraMemory(
+      MakeMemorySnapshot(0x40000, kExtraMemorySize, 'b'));
+  process_snapshot->AddThread(std::move(other_thread));
+
+  auto exception_snapshot = base::WrapUnique(new TestExceptionSnapshot());
+  InitializeCPUContextX86_64(exception_snapshot->MutableContext(), 11);
+  exception_snapshot->SetThreadID(kCrashingThreadID);
+  process_snapshot->SetException(std::move(exception_snapshot));
+
+  for (size_t index = 0; index < kMemoryMapRegionCount; ++index) {
+    auto region = base::WrapUnique(new TestMemoryMapRegionSnapshot());
+    MINIDUMP_MEMORY_INFO memory_info = {};
+    memory_info.BaseAddress = 0x100000 * (index + 1);
+    memory_info.RegionSize = 0x1000;
+    region->SetMindumpMemoryInfo(memory_info);
+    process_snapshot->AddMemoryMapRegion(std::move(region));
+  }
+}
+
+TEST(MinidumpSizeBudget, TightenPlan) {
+  TestProcessSnapshot process_snapshot;
+  InitializeProcessSnapshot(&process_snapshot);
+
+  internal::MinidumpSizeBudgetPlan plan;
+  plan.has_exempt_thread_id = true;
+  plan.exempt_thread_id = kCrashingThreadID;
+
+  // Indirectly-referenced memory goes first, from the end.
+  ASSERT_TRUE(internal::TightenMinidumpSizeBudgetPlan(
+      &process_snapshot, 1, &plan));
+  EXPECT_EQ(plan.thread_extra_memory_count, 1u);
+  EXPECT_EQ(plan.memory_info_count, kMemoryMapRegionCount);
+  EXPECT_EQ(plan.stack_size, std::numeric_limits<size_t>::max());
+
+  // Memory map entries are dropped once indirectly-referenced memory is gone.
+  ASSERT_TRUE(internal::TightenMinidumpSizeBudgetPlan(
+      &process_snapshot,
+      kExtraMemorySize + sizeof(MINIDUMP_MEMORY_DESCRIPTOR) + 1,
+      &plan));
+  EXPECT_EQ(plan.thread_extra_memory_count, 0u);
+  EXPECT_EQ(plan.memory_info_count, kMemoryMapRegionCount - 1);
+  EXPECT_EQ(plan.stack_size, std::numeric_limits<size_t>::max());
+
+  // Stacks are truncated last, and the crashing thread’s stack doesn’t count.
+  ASSERT_TRUE(internal::TightenMinidumpSizeBudgetPlan(
+      &process_snapshot,
+      (kMemoryMapRegionCount - 1) * sizeof(MINIDUMP_MEMORY_INFO) + 0x800,
+      &plan));
+  EXPECT_EQ(plan.thread_extra_memory_count, 0u);
+  EXPECT_EQ(plan.memory_info_count, 0u);
+  EXPECT_EQ(plan.stack_size, kOtherStackSize - 0x800);
+
+  ASSERT_TRUE(internal::TightenMinidumpSizeBudgetPlan(
+      &process_snapshot, kCrashingStackSize * 2, &plan));
+  EXPECT_EQ(plan.stack_size, 0u);
+
+  // There’s nothing left to evict.
+  EXPECT_FALSE(internal::TightenMinidumpSizeBudgetPlan(
+      &process_snapshot, 1, &plan));
+}
+
+TEST(MinidumpSizeBudget, MinidumpFileWriter) {
+  TestProcessSnapshot process_snapshot;
+  InitializeProcessSnapshot(&process_snapshot);
+
+  StringFile full_file;
+  {
+    MinidumpFileWriter minidump_file_writer;
+    minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+    ASSERT_TRUE(minidump_file_writer.WriteEverything(&full_file));
+  }
+
+  // Ask for a file that can only be achieved by truncating the other thread’s
+  // stack.
+  const size_t size_budget = full_file.string().size() - kOtherStackSize / 2;
+
+  StringFile budgeted_file;
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetSizeBudget(size_budget);
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&budgeted_file));
+  EXPECT_LE(budgeted_file.string().size(), size_budget);
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(budgeted_file.string(), &directory);
+  ASSERT_TRUE(header);
+  ASSERT_TRUE(directory);
+
+  const MINIDUMP_THREAD_LIST* thread_list = nullptr;
+  for (size_t index = 0; index < header->NumberOfStreams; ++index) {
+    // The memory map was dropped completely.
+    EXPECT_NE(directory[index].StreamType, kMinidumpStreamTypeMemoryInfoList);
+    if (directory[index].StreamType == kMinidumpStreamTypeThreadList) {
+      thread_list = MinidumpWritableAtLocationDescriptor<MINIDUMP_THREAD_LIST>(
+          budgeted_file.string(), directory[index].Location);
+    }
+  }
+  ASSERT_TRUE(thread_list);
+  ASSERT_EQ(thread_list->NumberOfThreads, 2u);
+
+  EXPECT_EQ(thread_list->Threads[0].ThreadId, kCrashingThreadID);
+  EXPECT_EQ(thread_list->Threads[0].Stack.Memory.DataSize, kCrashingStackSize);
+
+  EXPECT_EQ(thread_list->Threads[1].ThreadId, kOtherThreadID);
+  EXPECT_GT(thread_list->Threads[1].Stack.Memory.DataSize, 0u);
+  EXPECT_LT(thread_list->Threads[1].Stack.Memory.DataSize, kOtherStackSize);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
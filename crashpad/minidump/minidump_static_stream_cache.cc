@@ -0,0 +1,93 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_static_stream_cache.h"
+
+#include "snapshot/process_snapshot.h"
+
+namespace crashpad {
+
+namespace {
+
+// The number of processes to remember streams for. When exceeded, the process
+// whose streams were least recently used is forgotten.
+constexpr size_t kMaximumProcesses = 32;
+
+}  // namespace
+
+MinidumpStaticStreamCache::MinidumpStaticStreamCache()
+    : lock_(), processes_(), use_count_(0) {
+}
+
+MinidumpStaticStreamCache::~MinidumpStaticStreamCache() {
+}
+
+// static
+MinidumpStaticStreamCache::ProcessKey MinidumpStaticStreamCache::KeyForProcess(
+    const ProcessSnapshot* process_snapshot) {
+  timeval start_time;
+  process_snapshot->ProcessStartTime(&start_time);
+  return ProcessKey(process_snapshot->ProcessID(),
+                    static_cast<uint64_t>(start_time.tv_sec) * 1000000 +
+                        start_time.tv_usec);
+}
+
+bool MinidumpStaticStreamCache::Find(const ProcessKey& process,
+                                     MinidumpStreamType stream_type,
+                                     const std::string& contents,
+                                     UUID* base_report_id) {
+  base::AutoLock lock_owner(lock_);
+
+  auto process_it = processes_.find(process);
+  if (process_it == processes_.end()) {
+    return false;
+  }
+
+  auto stream_it = process_it->second.streams.find(stream_type);
+  if (stream_it == process_it->second.streams.end() ||
+      stream_it->second.contents != contents) {
+    return false;
+  }
+
+  process_it->second.last_used = ++use_count_;
+  *base_report_id = stream_it->second.report_id;
+  return true;
+}
+
+void MinidumpStaticStreamCache::Update(const ProcessKey& process,
+                                       MinidumpStreamType stream_type,
+                                       const std::string& contents,
+                                       const UUID& report_id) {
+  base::AutoLock lock_owner(lock_);
+
+  if (processes_.find(process) == processes_.end() &&
+      processes_.size() >= kMaximumProcesses) {
+    auto least_recent = processes_.begin();
+    for (auto it = processes_.begin(); it != processes_.end(); ++it) {
+      if (it->second.last_used < least_recent->second.last_used) {
+        least_recent = it;
+      }
+    }
+    processes_.erase(least_recent);
+  }
+
+  ProcessStreams& process_streams = processes_[process];
+  process_streams.last_used = ++use_count_;
+
+  CachedStream& cached_stream = process_streams.streams[stream_type];
+  cached_stream.contents = contents;
+  cached_stream.report_id = report_id;
+}
+
+}  // namespace crashpad
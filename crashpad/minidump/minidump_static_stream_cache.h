@@ -0,0 +1,109 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_STATIC_STREAM_CACHE_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_STATIC_STREAM_CACHE_H_
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "minidump/minidump_extensions.h"
+#include "util/misc/uuid.h"
+
+namespace crashpad {
+
+class ProcessSnapshot;
+
+//! \brief Remembers the streams that rarely change over a process’ lifetime,
+//!     such as its system information and module list, across the minidump
+//!     files written for that process.
+//!
+//! When a MinidumpFileWriter is given a cache with
+//! MinidumpFileWriter::SetStaticStreamCache(), it omits each such stream whose
+//! content is identical to what it was in the last minidump file committed for
+//! the same process, and records a MinidumpCrashpadStreamReference to that file
+//! in its place. This allows frequent non-crash dumps of a single process to
+//! avoid repeating data that the collection server has already received.
+//!
+//! Processes are identified by their process ID and start time, so that a
+//! reused process ID is never mistaken for the process that previously had it.
+//!
+//! This class is thread-safe.
+class MinidumpStaticStreamCache {
+ public:
+  MinidumpStaticStreamCache();
+  ~MinidumpStaticStreamCache();
+
+  //! \brief Identifies a process.
+  using ProcessKey = std::pair<pid_t, uint64_t>;
+
+  //! \brief Returns the key for the process described by \a process_snapshot.
+  static ProcessKey KeyForProcess(const ProcessSnapshot* process_snapshot);
+
+  //! \brief Determines whether the last minidump file committed for a process
+  //!     carried a stream with identical content.
+  //!
+  //! \param[in] process The process.
+  //! \param[in] stream_type The stream’s type.
+  //! \param[in] contents The stream’s content, as written when the stream is
+  //!     the only object in a file.
+  //! \param[out] base_report_id The report ID of the minidump file carrying
+  //!     the stream, if found.
+  //!
+  //! \return `true` if an identical stream was found, with \a base_report_id
+  //!     set. `false` otherwise.
+  bool Find(const ProcessKey& process,
+            MinidumpStreamType stream_type,
+            const std::string& contents,
+            UUID* base_report_id);
+
+  //! \brief Records that a minidump file identified by \a report_id carries a
+  //!     stream in full.
+  //!
+  //! This should only be called once the minidump file has been durably
+  //! stored, so that later minidump files never refer to one that does not
+  //! exist.
+  void Update(const ProcessKey& process,
+              MinidumpStreamType stream_type,
+              const std::string& contents,
+              const UUID& report_id);
+
+ private:
+  struct CachedStream {
+    std::string contents;
+    UUID report_id;
+  };
+
+  struct ProcessStreams {
+    std::map<MinidumpStreamType, CachedStream> streams;
+    uint64_t last_used;
+  };
+
+  base::Lock lock_;
+  std::map<ProcessKey, ProcessStreams> processes_;
+  uint64_t use_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpStaticStreamCache);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_STATIC_STREAM_CACHE_H_
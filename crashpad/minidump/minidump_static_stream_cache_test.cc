@@ -0,0 +1,199 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_static_stream_cache.h"
+
+#include <string>
+#include <utility>
+
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/test/minidump_file_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "snapshot/test/test_module_snapshot.h"
+#include "snapshot/test/test_process_snapshot.h"
+#include "snapshot/test/test_system_snapshot.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(MinidumpStaticStreamCache, FindAndUpdate) {
+  MinidumpStaticStreamCache cache;
+
+  const MinidumpStaticStreamCache::ProcessKey process(1, 2);
+  const MinidumpStaticStreamCache::ProcessKey other_process(1, 3);
+
+  UUID report_id_0;
+  ASSERT_TRUE(
+      report_id_0.InitializeFromString("00000000-0000-0000-0000-000000000001"));
+  UUID report_id_1;
+  ASSERT_TRUE(
+      report_id_1.InitializeFromString("00000000-0000-0000-0000-000000000002"));
+
+  UUID base_report_id;
+  EXPECT_FALSE(cache.Find(
+      process, kMinidumpStreamTypeModuleList, "modules", &base_report_id));
+
+  cache.Update(process, kMinidumpStreamTypeModuleList, "modules", report_id_0);
+  ASSERT_TRUE(cache.Find(
+      process, kMinidumpStreamTypeModuleList, "modules", &base_report_id));
+  EXPECT_EQ(base_report_id, report_id_0);
+
+  EXPECT_FALSE(cache.Find(
+      process, kMinidumpStreamTypeModuleList, "changed", &base_report_id));
+  EXPECT_FALSE(cache.Find(
+      process, kMinidumpStreamTypeSystemInfo, "modules", &base_report_id));
+  EXPECT_FALSE(cache.Find(other_process,
+                          kMinidumpStreamTypeModuleList,
+                          "modules",
+                          &base_report_id));
+
+  cache.Update(process, kMinidumpStreamTypeModuleList, "changed", report_id_1);
+  EXPECT_FALSE(cache.Find(
+      process, kMinidumpStreamTypeModuleList, "modules", &base_report_id));
+  ASSERT_TRUE(cache.Find(
+      process, kMinidumpStreamTypeModuleList, "changed", &base_report_id));
+  EXPECT_EQ(base_report_id, report_id_1);
+}
+
+void InitializeProcessSnapshot(TestProcessSnapshot* process_snapshot,
+                               const char* report_id) {
+  process_snapshot->SetProcessID(1234);
+  constexpr timeval kStartTime = {static_cast<time_t>(0x4976043c), 0};
+  process_snapshot->SetProcessStartTime(kStartTime);
+
+  UUID uuid;
+  ASSERT_TRUE(uuid.InitializeFromString(report_id));
+  process_snapshot->SetReportID(uuid);
+
+  auto system_snapshot = base::WrapUnique(new TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemMacOSX);
+  process_snapshot->SetSystem(std::move(system_snapshot));
+
+  auto module_snapshot = base::WrapUnique(new TestModuleSnapshot());
+  module_snapshot->SetName("/usr/lib/libtest.dylib");
+  module_snapshot->SetAddressAndSize(0x10000, 0x1000);
+  process_snapshot->AddModule(std::move(module_snapshot));
+}
+
+// Writes a minidump file for |process_snapshot| while consulting |cache|, and
+// commits it to |cache|.
+void WriteWithCache(const ProcessSnapshot* process_snapshot,
+                    MinidumpStaticStreamCache* cache,
+                    StringFile* string_file) {
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetStaticStreamCache(cache);
+  minidump_file_writer.InitializeFromSnapshot(process_snapshot);
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(string_file));
+  minidump_file_writer.CommitStaticStreams();
+}
+
+const MINIDUMP_DIRECTORY* FindStream(const std::string& file_contents,
+                                     MinidumpStreamType stream_type) {
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(file_contents, &directory);
+  if (!header || !directory) {
+    return nullptr;
+  }
+  for (size_t index = 0; index < header->NumberOfStreams; ++index) {
+    if (directory[index].StreamType == stream_type) {
+      return &directory[index];
+    }
+  }
+  return nullptr;
+}
+
+TEST(MinidumpStaticStreamCache, DeltaMinidump) {
+  static constexpr char kReportID0[] = "00000000-0000-0000-0000-000000000001";
+  static constexpr char kReportID1[] = "00000000-0000-0000-0000-000000000002";
+  static constexpr char kReportID2[] = "00000000-0000-0000-0000-000000000003";
+
+  MinidumpStaticStreamCache cache;
+
+  // The first minidump file carries every stream in full.
+  TestProcessSnapshot process_snapshot_0;
+  ASSERT_NO_FATAL_FAILURE(
+      InitializeProcessSnapshot(&process_snapshot_0, kReportID0));
+  StringFile string_file_0;
+  ASSERT_NO_FATAL_FAILURE(
+      WriteWithCache(&process_snapshot_0, &cache, &string_file_0));
+  EXPECT_TRUE(
+      FindStream(string_file_0.string(), kMinidumpStreamTypeSystemInfo));
+  EXPECT_TRUE(
+      FindStream(string_file_0.string(), kMinidumpStreamTypeModuleList));
+  EXPECT_FALSE(FindStream(string_file_0.string(),
+                          kMinidumpStreamTypeCrashpadStreamReferenceList));
+
+  // The second refers to the first for both static streams.
+  TestProcessSnapshot process_snapshot_1;
+  ASSERT_NO_FATAL_FAILURE(
+      InitializeProcessSnapshot(&process_snapshot_1, kReportID1));
+  StringFile string_file_1;
+  ASSERT_NO_FATAL_FAILURE(
+      WriteWithCache(&process_snapshot_1, &cache, &string_file_1));
+  EXPECT_FALSE(
+      FindStream(string_file_1.string(), kMinidumpStreamTypeSystemInfo));
+  EXPECT_FALSE(
+      FindStream(string_file_1.string(), kMinidumpStreamTypeModuleList));
+  EXPECT_LT(string_file_1.string().size(), string_file_0.string().size());
+
+  const MINIDUMP_DIRECTORY* references_directory = FindStream(
+      string_file_1.string(), kMinidumpStreamTypeCrashpadStreamReferenceList);
+  ASSERT_TRUE(references_directory);
+  const MinidumpCrashpadStreamReferenceList* reference_list =
+      MinidumpWritableAtLocationDescriptor<
+          MinidumpCrashpadStreamReferenceList>(string_file_1.string(),
+                                               references_directory->Location);
+  ASSERT_TRUE(reference_list);
+  ASSERT_EQ(reference_list->count, 2u);
+  ASSERT_EQ(references_directory->Location.DataSize,
+            sizeof(MinidumpCrashpadStreamReferenceList) +
+                2 * sizeof(MinidumpCrashpadStreamReference));
+  const MinidumpCrashpadStreamReference* references =
+      reinterpret_cast<const MinidumpCrashpadStreamReference*>(
+          reference_list + 1);
+
+  UUID report_id_0;
+  ASSERT_TRUE(report_id_0.InitializeFromString(kReportID0));
+  EXPECT_EQ(references[0].stream_type, kMinidumpStreamTypeSystemInfo);
+  EXPECT_EQ(references[0].base_report_id, report_id_0);
+  EXPECT_EQ(references[1].stream_type, kMinidumpStreamTypeModuleList);
+  EXPECT_EQ(references[1].base_report_id, report_id_0);
+
+  // Once a module is loaded, the module list is carried in full again, and
+  // later minidump files refer to this one for it.
+  TestProcessSnapshot process_snapshot_2;
+  ASSERT_NO_FATAL_FAILURE(
+      InitializeProcessSnapshot(&process_snapshot_2, kReportID2));
+  auto module_snapshot = base::WrapUnique(new TestModuleSnapshot());
+  module_snapshot->SetName("/usr/lib/libloaded.dylib");
+  process_snapshot_2.AddModule(std::move(module_snapshot));
+  StringFile string_file_2;
+  ASSERT_NO_FATAL_FAILURE(
+      WriteWithCache(&process_snapshot_2, &cache, &string_file_2));
+  EXPECT_FALSE(
+      FindStream(string_file_2.string(), kMinidumpStreamTypeSystemInfo));
+  EXPECT_TRUE(
+      FindStream(string_file_2.string(), kMinidumpStreamTypeModuleList));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
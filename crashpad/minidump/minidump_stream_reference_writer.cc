@@ -0,0 +1,93 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_stream_reference_writer.h"
+
+#include "base/logging.h"
+#include "util/file/file_writer.h"
+#include "util/misc/uuid.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+
+MinidumpStreamReferenceListWriter::MinidumpStreamReferenceListWriter()
+    : internal::MinidumpStreamWriter(),
+      reference_list_base_(),
+      references_() {
+}
+
+MinidumpStreamReferenceListWriter::~MinidumpStreamReferenceListWriter() {
+}
+
+void MinidumpStreamReferenceListWriter::AddReference(
+    MinidumpStreamType stream_type,
+    const UUID& base_report_id) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  MinidumpCrashpadStreamReference reference;
+  reference.stream_type = stream_type;
+  reference.base_report_id = base_report_id;
+  references_.push_back(reference);
+}
+
+bool MinidumpStreamReferenceListWriter::IsUseful() const {
+  return !references_.empty();
+}
+
+bool MinidumpStreamReferenceListWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (!MinidumpStreamWriter::Freeze()) {
+    return false;
+  }
+
+  size_t reference_count = references_.size();
+  if (!AssignIfInRange(&reference_list_base_.count, reference_count)) {
+    LOG(ERROR) << "reference_count " << reference_count << " out of range";
+    return false;
+  }
+
+  return true;
+}
+
+size_t MinidumpStreamReferenceListWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return sizeof(reference_list_base_) +
+         references_.size() * sizeof(MinidumpCrashpadStreamReference);
+}
+
+bool MinidumpStreamReferenceListWriter::WriteObject(
+    FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  WritableIoVec iov;
+  iov.iov_base = &reference_list_base_;
+  iov.iov_len = sizeof(reference_list_base_);
+  std::vector<WritableIoVec> iovecs(1, iov);
+
+  if (!references_.empty()) {
+    iov.iov_base = &references_[0];
+    iov.iov_len = references_.size() * sizeof(MinidumpCrashpadStreamReference);
+    iovecs.push_back(iov);
+  }
+
+  return file_writer->WriteIoVec(&iovecs);
+}
+
+MinidumpStreamType MinidumpStreamReferenceListWriter::StreamType() const {
+  return kMinidumpStreamTypeCrashpadStreamReferenceList;
+}
+
+}  // namespace crashpad
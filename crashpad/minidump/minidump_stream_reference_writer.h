@@ -0,0 +1,73 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_STREAM_REFERENCE_WRITER_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_STREAM_REFERENCE_WRITER_H_
+
+#include <sys/types.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_stream_writer.h"
+
+namespace crashpad {
+
+struct UUID;
+
+//! \brief The writer for a MinidumpCrashpadStreamReferenceList stream in a
+//!     minidump file, containing a list of MinidumpCrashpadStreamReference
+//!     objects.
+class MinidumpStreamReferenceListWriter final
+    : public internal::MinidumpStreamWriter {
+ public:
+  MinidumpStreamReferenceListWriter();
+  ~MinidumpStreamReferenceListWriter() override;
+
+  //! \brief Records that the stream of type \a stream_type has been omitted
+  //!     from the minidump file, and is instead carried by the minidump file
+  //!     identified by \a base_report_id.
+  //!
+  //! \note Valid in #kStateMutable.
+  void AddReference(MinidumpStreamType stream_type, const UUID& base_report_id);
+
+  //! \brief Determines whether the object is useful.
+  //!
+  //! A useful object is one that carries data that makes a meaningful
+  //! contribution to a minidump file. An object carrying any references would
+  //! be considered useful.
+  //!
+  //! \return `true` if the object is useful, `false` otherwise.
+  bool IsUseful() const;
+
+ protected:
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t SizeOfObject() override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+
+  // MinidumpStreamWriter:
+  MinidumpStreamType StreamType() const override;
+
+ private:
+  MinidumpCrashpadStreamReferenceList reference_list_base_;
+  std::vector<MinidumpCrashpadStreamReference> references_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpStreamReferenceListWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_STREAM_REFERENCE_WRITER_H_
@@ -0,0 +1,112 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_string_table.h"
+
+#include "base/logging.h"
+#include "base/threading/thread_local_storage.h"
+#include "minidump/minidump_writable.h"
+
+namespace crashpad {
+namespace internal {
+
+namespace {
+
+class CurrentStringTableSlot {
+ public:
+  static CurrentStringTableSlot* GetInstance() {
+    static auto slot = new CurrentStringTableSlot();
+    return slot;
+  }
+
+  MinidumpStringTable* Get() {
+    return reinterpret_cast<MinidumpStringTable*>(tls_.Get());
+  }
+
+  void Set(MinidumpStringTable* string_table) { tls_.Set(string_table); }
+
+ private:
+  CurrentStringTableSlot() {
+    DCHECK(!tls_.initialized());
+    tls_.Initialize(nullptr);
+    DCHECK(tls_.initialized());
+  }
+
+  ~CurrentStringTableSlot() = delete;
+
+  static base::ThreadLocalStorage::StaticSlot tls_;
+
+  DISALLOW_COPY_AND_ASSIGN(CurrentStringTableSlot);
+};
+
+// static
+base::ThreadLocalStorage::StaticSlot CurrentStringTableSlot::tls_ =
+    TLS_INITIALIZER;
+
+}  // namespace
+
+MinidumpStringTable::MinidumpStringTable() : strings_(), duplicates_() {
+}
+
+MinidumpStringTable::~MinidumpStringTable() {
+  DCHECK_NE(Current(), this);
+}
+
+bool MinidumpStringTable::Intern(MinidumpWritable* writer,
+                                 const void* data,
+                                 size_t size,
+                                 size_t unit_size) {
+  std::string key(1, static_cast<char>(unit_size));
+  key.append(static_cast<const char*>(data), size);
+
+  auto insert_result = strings_.insert(std::make_pair(key, writer));
+  if (insert_result.second) {
+    return false;
+  }
+
+  MinidumpWritable* original = insert_result.first->second;
+  DCHECK_NE(original, writer);
+  duplicates_.push_back(std::make_pair(writer, original));
+  return true;
+}
+
+void MinidumpStringTable::TransferRegistrations() {
+  for (const auto& duplicate : duplicates_) {
+    duplicate.first->TransferRegistrationsTo(duplicate.second);
+  }
+  duplicates_.clear();
+}
+
+// static
+MinidumpStringTable* MinidumpStringTable::Current() {
+  return CurrentStringTableSlot::GetInstance()->Get();
+}
+
+// static
+void MinidumpStringTable::SetCurrent(MinidumpStringTable* string_table) {
+  CurrentStringTableSlot::GetInstance()->Set(string_table);
+}
+
+ScopedMinidumpStringTable::ScopedMinidumpStringTable(
+    MinidumpStringTable* string_table)
+    : previous_(MinidumpStringTable::Current()) {
+  MinidumpStringTable::SetCurrent(string_table);
+}
+
+ScopedMinidumpStringTable::~ScopedMinidumpStringTable() {
+  MinidumpStringTable::SetCurrent(previous_);
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,119 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_STRING_TABLE_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_STRING_TABLE_H_
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+
+namespace crashpad {
+namespace internal {
+
+class MinidumpWritable;
+
+//! \brief Tracks the strings written to a minidump file so that each distinct
+//!     string is only written once.
+//!
+//! While a ScopedMinidumpStringTable naming a table is in effect on a thread,
+//! MinidumpStringWriter objects frozen on that thread intern their contents
+//! in it. The first writer seen for a given string is written normally. Each
+//! later writer with identical contents becomes a duplicate: once the entire
+//! tree is frozen, TransferRegistrations() redirects every RVA that had been
+//! registered to point to a duplicate to the first writer instead, and the
+//! duplicate writes nothing.
+//!
+//! This makes it possible for repeated strings, such as module paths shared by
+//! the module and unloaded module lists or annotation keys shared by many
+//! modules, to be stored once regardless of which stream refers to them.
+class MinidumpStringTable {
+ public:
+  MinidumpStringTable();
+  ~MinidumpStringTable();
+
+  //! \brief Interns a string.
+  //!
+  //! \param[in] writer The writer that will write the string.
+  //! \param[in] data The string’s data, not including any NUL terminator.
+  //! \param[in] size The size of \a data, in bytes.
+  //! \param[in] unit_size The size of each code unit in \a data, in bytes.
+  //!     Strings with different code unit sizes are never considered
+  //!     identical.
+  //!
+  //! \return `true` if an identical string was previously interned by a
+  //!     different writer, in which case \a writer is a duplicate and should
+  //!     not write anything. `false` if \a writer is the first to intern this
+  //!     string.
+  bool Intern(MinidumpWritable* writer,
+              const void* data,
+              size_t size,
+              size_t unit_size);
+
+  //! \brief Moves the registered RVAs and location descriptors of each
+  //!     duplicate writer to the writer that was first to intern the same
+  //!     string.
+  //!
+  //! This must be called after the entire tree of MinidumpWritable objects
+  //! has been frozen, so that every pointer to a string has been registered,
+  //! and before any file offsets are assigned.
+  void TransferRegistrations();
+
+  //! \brief Returns the string table in effect on the current thread, or
+  //!     `nullptr` if there is none.
+  static MinidumpStringTable* Current();
+
+ private:
+  friend class ScopedMinidumpStringTable;
+
+  static void SetCurrent(MinidumpStringTable* string_table);
+
+  // Maps a string, prefixed by its code unit size, to the first writer that
+  // interned it.
+  std::map<std::string, MinidumpWritable*> strings_;  // weak values
+
+  // Pairs of (duplicate, original) writers.
+  std::vector<std::pair<MinidumpWritable*, MinidumpWritable*>>
+      duplicates_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpStringTable);
+};
+
+//! \brief Makes a MinidumpStringTable current on this thread for the lifetime
+//!     of this object.
+//!
+//! The previously-current table, if any, is restored when this object is
+//! destroyed.
+class ScopedMinidumpStringTable {
+ public:
+  //! \param[in] string_table The table to intern strings in, or `nullptr` to
+  //!     disable interning.
+  explicit ScopedMinidumpStringTable(MinidumpStringTable* string_table);
+  ~ScopedMinidumpStringTable();
+
+ private:
+  MinidumpStringTable* previous_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedMinidumpStringTable);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_STRING_TABLE_H_
@@ -0,0 +1,121 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_string_table.h"
+
+#include <string>
+#include <utility>
+
+#include "base/memory/ptr_util.h"
+#include "base/strings/utf_string_conversions.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/minidump_module_writer.h"
+#include "minidump/minidump_string_writer.h"
+#include "minidump/minidump_unloaded_module_writer.h"
+#include "minidump/test/minidump_file_writer_test_util.h"
+#include "minidump/test/minidump_string_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(MinidumpStringTable, Intern) {
+  internal::MinidumpStringTable string_table;
+  internal::MinidumpUTF8StringWriter writer_0;
+  internal::MinidumpUTF8StringWriter writer_1;
+  internal::MinidumpUTF8StringWriter writer_2;
+  internal::MinidumpUTF8StringWriter writer_3;
+
+  static constexpr char kString[] = "abcd";
+  static constexpr char kOtherString[] = "abce";
+
+  EXPECT_FALSE(string_table.Intern(&writer_0, kString, 4, 1));
+  EXPECT_TRUE(string_table.Intern(&writer_1, kString, 4, 1));
+  EXPECT_FALSE(string_table.Intern(&writer_2, kOtherString, 4, 1));
+
+  // The same bytes with a different code unit size are a different string.
+  EXPECT_FALSE(string_table.Intern(&writer_3, kString, 4, 2));
+}
+
+TEST(MinidumpStringTable, SharedAcrossStreams) {
+  MinidumpFileWriter minidump_file_writer;
+
+  static constexpr char kSharedName[] = "/lib/libshared.so";
+  static constexpr char kOtherName[] = "/lib/libother.so";
+
+  auto module_list_writer = base::WrapUnique(new MinidumpModuleListWriter());
+  for (const char* name : {kSharedName, kOtherName, kSharedName}) {
+    auto module_writer = base::WrapUnique(new MinidumpModuleWriter());
+    module_writer->SetName(name);
+    module_list_writer->AddModule(std::move(module_writer));
+  }
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(module_list_writer)));
+
+  auto unloaded_module_list_writer =
+      base::WrapUnique(new MinidumpUnloadedModuleListWriter());
+  auto unloaded_module_writer =
+      base::WrapUnique(new MinidumpUnloadedModuleWriter());
+  unloaded_module_writer->SetName(kSharedName);
+  unloaded_module_list_writer->AddUnloadedModule(
+      std::move(unloaded_module_writer));
+  ASSERT_TRUE(
+      minidump_file_writer.AddStream(std::move(unloaded_module_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(string_file.string(), &directory);
+  ASSERT_NO_FATAL_FAILURE(VerifyMinidumpHeader(header, 2, 0));
+  ASSERT_TRUE(directory);
+
+  ASSERT_EQ(directory[0].StreamType, kMinidumpStreamTypeModuleList);
+  const MINIDUMP_MODULE_LIST* module_list =
+      MinidumpWritableAtLocationDescriptor<MINIDUMP_MODULE_LIST>(
+          string_file.string(), directory[0].Location);
+  ASSERT_TRUE(module_list);
+  ASSERT_EQ(module_list->NumberOfModules, 3u);
+
+  ASSERT_EQ(directory[1].StreamType, kMinidumpStreamTypeUnloadedModuleList);
+  const MINIDUMP_UNLOADED_MODULE_LIST* unloaded_module_list =
+      MinidumpWritableAtLocationDescriptor<MINIDUMP_UNLOADED_MODULE_LIST>(
+          string_file.string(), directory[1].Location);
+  ASSERT_TRUE(unloaded_module_list);
+  ASSERT_EQ(unloaded_module_list->NumberOfEntries, 1u);
+  const MINIDUMP_UNLOADED_MODULE* unloaded_module =
+      reinterpret_cast<const MINIDUMP_UNLOADED_MODULE*>(
+          &unloaded_module_list[1]);
+
+  // Every reference to the shared name points to a single copy of it.
+  const RVA shared_name_rva = module_list->Modules[0].ModuleNameRva;
+  EXPECT_EQ(module_list->Modules[2].ModuleNameRva, shared_name_rva);
+  EXPECT_EQ(unloaded_module->ModuleNameRva, shared_name_rva);
+  EXPECT_NE(module_list->Modules[1].ModuleNameRva, shared_name_rva);
+
+  EXPECT_EQ(MinidumpStringAtRVAAsString(string_file.string(), shared_name_rva),
+            base::UTF8ToUTF16(kSharedName));
+  EXPECT_EQ(
+      MinidumpStringAtRVAAsString(string_file.string(),
+                                  module_list->Modules[1].ModuleNameRva),
+      base::UTF8ToUTF16(kOtherName));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
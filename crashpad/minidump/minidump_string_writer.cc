@@ -18,6 +18,7 @@
 
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
+#include "minidump/minidump_string_table.h"
 #include "minidump/minidump_writer_util.h"
 #include "util/file/file_writer.h"
 #include "util/numeric/safe_assignment.h"
@@ -27,7 +28,10 @@ namespace internal {
 
 template <typename Traits>
 MinidumpStringWriter<Traits>::MinidumpStringWriter()
-    : MinidumpWritable(), string_base_(new MinidumpStringType()), string_() {
+    : MinidumpWritable(),
+      string_base_(new MinidumpStringType()),
+      string_(),
+      duplicate_(false) {
 }
 
 template <typename Traits>
@@ -48,6 +52,12 @@ bool MinidumpStringWriter<Traits>::Freeze() {
     return false;
   }
 
+  MinidumpStringTable* string_table = MinidumpStringTable::Current();
+  if (string_table) {
+    duplicate_ = string_table->Intern(
+        this, string_.data(), string_bytes, sizeof(string_[0]));
+  }
+
   return true;
 }
 
@@ -55,6 +65,10 @@ template <typename Traits>
 size_t MinidumpStringWriter<Traits>::SizeOfObject() {
   DCHECK_GE(state(), kStateFrozen);
 
+  if (duplicate_) {
+    return 0;
+  }
+
   // Include the NUL terminator.
   return sizeof(*string_base_) + (string_.size() + 1) * sizeof(string_[0]);
 }
@@ -64,6 +78,10 @@ bool MinidumpStringWriter<Traits>::WriteObject(
     FileWriterInterface* file_writer) {
   DCHECK_EQ(state(), kStateWritable);
 
+  if (duplicate_) {
+    return true;
+  }
+
   // The string’s length is stored in string_base_, and its data is stored in
   // string_. Write them both.
   WritableIoVec iov;
@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/macros.h"
@@ -52,6 +53,10 @@ struct MinidumpStringWriterUTF8Traits {
 //! MinidumpStringWriter objects should not be instantiated directly. To write
 //! strings to minidump file, use the MinidumpUTF16StringWriter and
 //! MinidumpUTF8StringWriter subclasses instead.
+//!
+//! If a MinidumpStringTable is current when this object is frozen, its string
+//! is interned there, and it is only written if no other writer has already
+//! interned an identical string.
 template <typename Traits>
 class MinidumpStringWriter : public MinidumpWritable {
  public:
@@ -71,6 +76,11 @@ class MinidumpStringWriter : public MinidumpWritable {
   //! \note Valid in #kStateMutable.
   void set_string(const StringType& string) { string_.assign(string); }
 
+  //! \brief Sets the string to be written, taking ownership of its contents.
+  //!
+  //! \note Valid in #kStateMutable.
+  void set_string(StringType&& string) { string_ = std::move(string); }
+
   //! \brief Retrieves the string to be written.
   //!
   //! \note Valid in any state.
@@ -80,6 +90,11 @@ class MinidumpStringWriter : public MinidumpWritable {
   std::unique_ptr<MinidumpStringType> string_base_;
   StringType string_;
 
+  // true if an identical string was interned in the current
+  // MinidumpStringTable by another writer, which will write it on behalf of
+  // this one.
+  bool duplicate_;
+
   DISALLOW_COPY_AND_ASSIGN(MinidumpStringWriter);
 };
 
@@ -0,0 +1,92 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_STRUCT_LIST_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_STRUCT_LIST_H_
+
+#include <sys/types.h>
+
+#include <type_traits>
+#include <vector>
+
+#include "base/macros.h"
+#include "util/file/file_writer.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief A header followed by an array of entries, where both are plain
+//!     structures, as found in many minidump streams.
+//!
+//! The entries are stored contiguously, so the whole list is written with a
+//! single FileWriterInterface::WriteIoVec() call of at most two elements, and
+//! its size is computed without visiting the entries. This is intended for
+//! use by MinidumpWritable subclasses that write such a list as their own
+//! object, in their SizeOfObject() and WriteObject() implementations.
+//!
+//! \tparam Header The type of the list’s header. The header is responsible
+//!     for recording the number of entries, if the format calls for it.
+//! \tparam Entry The type of each entry.
+template <typename Header, typename Entry>
+class MinidumpStructList {
+ public:
+  static_assert(std::is_pod<Header>::value, "Header must be POD");
+  static_assert(std::is_pod<Entry>::value, "Entry must be POD");
+
+  MinidumpStructList() : header_(), entries_() {}
+  ~MinidumpStructList() {}
+
+  //! \brief The list’s header.
+  Header& header() { return header_; }
+  const Header& header() const { return header_; }
+
+  //! \brief The list’s entries.
+  std::vector<Entry>& entries() { return entries_; }
+  const std::vector<Entry>& entries() const { return entries_; }
+
+  //! \brief Returns the size of the header and all entries, in bytes.
+  size_t Size() const {
+    return sizeof(Header) + entries_.size() * sizeof(Entry);
+  }
+
+  //! \brief Writes the header followed by all entries to \a file_writer.
+  //!
+  //! \return `true` on success. `false` on failure, with an appropriate message
+  //!     logged.
+  bool Write(FileWriterInterface* file_writer) const {
+    WritableIoVec iov;
+    iov.iov_base = &header_;
+    iov.iov_len = sizeof(header_);
+    std::vector<WritableIoVec> iovecs(1, iov);
+
+    if (!entries_.empty()) {
+      iov.iov_base = &entries_[0];
+      iov.iov_len = entries_.size() * sizeof(Entry);
+      iovecs.push_back(iov);
+    }
+
+    return file_writer->WriteIoVec(&iovecs);
+  }
+
+ private:
+  Header header_;
+  std::vector<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpStructList);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_STRUCT_LIST_H_
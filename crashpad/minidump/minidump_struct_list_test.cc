@@ -0,0 +1,84 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_struct_list.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+struct TestHeader {
+  uint32_t count;
+  uint32_t reserved;
+};
+
+struct TestEntry {
+  uint64_t address;
+  uint32_t value;
+  uint32_t flags;
+};
+
+TEST(MinidumpStructList, Empty) {
+  internal::MinidumpStructList<TestHeader, TestEntry> list;
+  list.header().count = 0;
+  EXPECT_EQ(list.Size(), sizeof(TestHeader));
+
+  StringFile string_file;
+  ASSERT_TRUE(list.Write(&string_file));
+  ASSERT_EQ(string_file.string().size(), sizeof(TestHeader));
+
+  TestHeader header;
+  memcpy(&header, &string_file.string()[0], sizeof(header));
+  EXPECT_EQ(header.count, 0u);
+}
+
+TEST(MinidumpStructList, Entries) {
+  constexpr size_t kEntryCount = 3;
+  internal::MinidumpStructList<TestHeader, TestEntry> list;
+  list.header().count = kEntryCount;
+  for (size_t index = 0; index < kEntryCount; ++index) {
+    TestEntry entry = {};
+    entry.address = 0x1000 * (index + 1);
+    entry.value = static_cast<uint32_t>(index);
+    list.entries().push_back(entry);
+  }
+  EXPECT_EQ(list.Size(), sizeof(TestHeader) + kEntryCount * sizeof(TestEntry));
+
+  StringFile string_file;
+  ASSERT_TRUE(list.Write(&string_file));
+  ASSERT_EQ(string_file.string().size(), list.Size());
+
+  TestHeader header;
+  memcpy(&header, &string_file.string()[0], sizeof(header));
+  EXPECT_EQ(header.count, kEntryCount);
+
+  for (size_t index = 0; index < kEntryCount; ++index) {
+    TestEntry entry;
+    memcpy(&entry,
+           &string_file.string()[sizeof(TestHeader) + index * sizeof(entry)],
+           sizeof(entry));
+    EXPECT_EQ(entry.address, 0x1000 * (index + 1));
+    EXPECT_EQ(entry.value, index);
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -62,26 +62,57 @@
         '..',
       ],
       'sources': [
+        'minidump_annotation_writer_test.cc',
+        'minidump_byte_array_writer_test.cc',
+        'minidump_capture_performance_writer_test.cc',
         'minidump_context_writer_test.cc',
         'minidump_crashpad_info_writer_test.cc',
         'minidump_exception_writer_test.cc',
         'minidump_file_writer_test.cc',
         'minidump_handle_writer_test.cc',
+        'minidump_memory64_list_writer_test.cc',
         'minidump_memory_info_writer_test.cc',
         'minidump_memory_writer_test.cc',
         'minidump_misc_info_writer_test.cc',
         'minidump_module_crashpad_info_writer_test.cc',
         'minidump_module_writer_test.cc',
+        'minidump_reconstructible_memory_writer_test.cc',
         'minidump_rva_list_writer_test.cc',
         'minidump_simple_string_dictionary_writer_test.cc',
+        'minidump_size_budget_test.cc',
+        'minidump_static_stream_cache_test.cc',
+        'minidump_string_table_test.cc',
         'minidump_string_writer_test.cc',
+        'minidump_struct_list_test.cc',
         'minidump_system_info_writer_test.cc',
+        'minidump_thread_annotation_list_writer_test.cc',
         'minidump_thread_id_map_test.cc',
+        'minidump_thread_name_list_writer_test.cc',
         'minidump_thread_writer_test.cc',
+        'minidump_top_frames_writer_test.cc',
         'minidump_unloaded_module_writer_test.cc',
         'minidump_user_stream_writer_test.cc',
+        'minidump_writable_arena_test.cc',
         'minidump_writable_test.cc',
       ],
     },
+    {
+      'target_name': 'crashpad_minidump_benchmark',
+      'type': 'executable',
+      'dependencies': [
+        'minidump.gyp:crashpad_minidump',
+        '../compat/compat.gyp:crashpad_compat',
+        '../snapshot/snapshot_test.gyp:crashpad_snapshot_test_lib',
+        '../third_party/mini_chromium/mini_chromium.gyp:base',
+        '../tools/tools.gyp:crashpad_tool_support',
+        '../util/util.gyp:crashpad_util',
+      ],
+      'include_dirs': [
+        '..',
+      ],
+      'sources': [
+        'minidump_writer_benchmark.cc',
+      ],
+    },
   ],
 }
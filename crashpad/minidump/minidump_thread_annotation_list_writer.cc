@@ -0,0 +1,207 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_thread_annotation_list_writer.h"
+
+#include <map>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "snapshot/annotation_snapshot.h"
+#include "snapshot/module_snapshot.h"
+#include "util/file/file_writer.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+
+MinidumpThreadAnnotationWriter::MinidumpThreadAnnotationWriter()
+    : MinidumpWritable(), thread_annotation_(), annotation_objects_() {}
+
+MinidumpThreadAnnotationWriter::~MinidumpThreadAnnotationWriter() {}
+
+const MinidumpThreadAnnotation*
+MinidumpThreadAnnotationWriter::ThreadAnnotation() const {
+  DCHECK_EQ(state(), kStateWritable);
+
+  return &thread_annotation_;
+}
+
+void MinidumpThreadAnnotationWriter::SetAnnotationObjects(
+    std::unique_ptr<MinidumpAnnotationListWriter> annotation_objects) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  annotation_objects_ = std::move(annotation_objects);
+}
+
+bool MinidumpThreadAnnotationWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+  CHECK(annotation_objects_);
+
+  if (!MinidumpWritable::Freeze()) {
+    return false;
+  }
+
+  annotation_objects_->RegisterLocationDescriptor(
+      &thread_annotation_.annotation_objects);
+
+  return true;
+}
+
+size_t MinidumpThreadAnnotationWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  // This object doesn’t directly write anything itself. Its
+  // MinidumpThreadAnnotation is written by its parent as part of a
+  // MinidumpThreadAnnotationList, and its children are responsible for writing
+  // themselves.
+  return 0;
+}
+
+std::vector<internal::MinidumpWritable*>
+MinidumpThreadAnnotationWriter::Children() {
+  DCHECK_GE(state(), kStateFrozen);
+  DCHECK(annotation_objects_);
+
+  std::vector<MinidumpWritable*> children(1, annotation_objects_.get());
+  return children;
+}
+
+bool MinidumpThreadAnnotationWriter::WriteObject(
+    FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  // This object doesn’t directly write anything itself. Its
+  // MinidumpThreadAnnotation is written by its parent as part of a
+  // MinidumpThreadAnnotationList, and its children are responsible for writing
+  // themselves.
+  return true;
+}
+
+MinidumpThreadAnnotationListWriter::MinidumpThreadAnnotationListWriter()
+    : MinidumpStreamWriter(),
+      thread_annotations_(),
+      thread_annotation_list_base_() {}
+
+MinidumpThreadAnnotationListWriter::~MinidumpThreadAnnotationListWriter() {}
+
+void MinidumpThreadAnnotationListWriter::InitializeFromSnapshot(
+    const std::vector<const ModuleSnapshot*>& module_snapshots,
+    const MinidumpThreadIDMap* thread_id_map) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(thread_annotations_.empty());
+
+  // Keyed by minidump thread ID, so that the stream is written in a stable
+  // order.
+  std::map<uint32_t, std::vector<AnnotationSnapshot>> merged;
+  for (const ModuleSnapshot* module_snapshot : module_snapshots) {
+    for (auto& thread : module_snapshot->ThreadAnnotationObjects()) {
+      auto thread_id_it = thread_id_map->find(thread.first);
+      if (thread_id_it == thread_id_map->end()) {
+        continue;
+      }
+
+      std::vector<AnnotationSnapshot>& annotations =
+          merged[thread_id_it->second];
+      annotations.insert(annotations.end(),
+                         std::make_move_iterator(thread.second.begin()),
+                         std::make_move_iterator(thread.second.end()));
+    }
+  }
+
+  for (const auto& thread : merged) {
+    auto annotation_objects =
+        base::WrapUnique(new MinidumpAnnotationListWriter());
+    annotation_objects->InitializeFromList(thread.second);
+    if (!annotation_objects->IsUseful()) {
+      continue;
+    }
+
+    auto thread_annotation =
+        base::WrapUnique(new MinidumpThreadAnnotationWriter());
+    thread_annotation->SetThreadID(thread.first);
+    thread_annotation->SetAnnotationObjects(std::move(annotation_objects));
+    AddThreadAnnotation(std::move(thread_annotation));
+  }
+}
+
+void MinidumpThreadAnnotationListWriter::AddThreadAnnotation(
+    std::unique_ptr<MinidumpThreadAnnotationWriter> thread_annotation) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  thread_annotations_.push_back(std::move(thread_annotation));
+}
+
+bool MinidumpThreadAnnotationListWriter::IsUseful() const {
+  return !thread_annotations_.empty();
+}
+
+bool MinidumpThreadAnnotationListWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (!MinidumpStreamWriter::Freeze()) {
+    return false;
+  }
+
+  size_t thread_count = thread_annotations_.size();
+  if (!AssignIfInRange(&thread_annotation_list_base_.count, thread_count)) {
+    LOG(ERROR) << "thread_count " << thread_count << " out of range";
+    return false;
+  }
+
+  return true;
+}
+
+size_t MinidumpThreadAnnotationListWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return sizeof(thread_annotation_list_base_) +
+         thread_annotations_.size() * sizeof(MinidumpThreadAnnotation);
+}
+
+std::vector<internal::MinidumpWritable*>
+MinidumpThreadAnnotationListWriter::Children() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  std::vector<MinidumpWritable*> children;
+  for (const auto& thread_annotation : thread_annotations_) {
+    children.push_back(thread_annotation.get());
+  }
+
+  return children;
+}
+
+bool MinidumpThreadAnnotationListWriter::WriteObject(
+    FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  WritableIoVec iov;
+  iov.iov_base = &thread_annotation_list_base_;
+  iov.iov_len = sizeof(thread_annotation_list_base_);
+  std::vector<WritableIoVec> iovecs(1, iov);
+
+  for (const auto& thread_annotation : thread_annotations_) {
+    iov.iov_base = thread_annotation->ThreadAnnotation();
+    iov.iov_len = sizeof(MinidumpThreadAnnotation);
+    iovecs.push_back(iov);
+  }
+
+  return file_writer->WriteIoVec(&iovecs);
+}
+
+MinidumpStreamType MinidumpThreadAnnotationListWriter::StreamType() const {
+  return kMinidumpStreamTypeCrashpadThreadAnnotations;
+}
+
+}  // namespace crashpad
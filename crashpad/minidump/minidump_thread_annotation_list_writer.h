@@ -0,0 +1,152 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_THREAD_ANNOTATION_LIST_WRITER_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_THREAD_ANNOTATION_LIST_WRITER_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "minidump/minidump_annotation_writer.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_stream_writer.h"
+#include "minidump/minidump_thread_id_map.h"
+#include "minidump/minidump_writable.h"
+
+namespace crashpad {
+
+class ModuleSnapshot;
+
+//! \brief The writer for a MinidumpThreadAnnotation object in a minidump file.
+//!
+//! Because MinidumpThreadAnnotation objects only appear as elements of
+//! MinidumpThreadAnnotationList objects, this class does not write any data on
+//! its own. It makes its MinidumpThreadAnnotation data available to its
+//! MinidumpThreadAnnotationListWriter parent, which writes it as part of a
+//! MinidumpThreadAnnotationList.
+class MinidumpThreadAnnotationWriter final
+    : public internal::MinidumpWritable {
+ public:
+  MinidumpThreadAnnotationWriter();
+  ~MinidumpThreadAnnotationWriter() override;
+
+  //! \brief Returns a MinidumpThreadAnnotation referencing this object’s data.
+  //!
+  //! This method is expected to be called by a
+  //! MinidumpThreadAnnotationListWriter in order to obtain a
+  //! MinidumpThreadAnnotation to include in its list.
+  //!
+  //! \note Valid in #kStateWritable.
+  const MinidumpThreadAnnotation* ThreadAnnotation() const;
+
+  //! \brief Sets MinidumpThreadAnnotation::thread_id.
+  void SetThreadID(uint32_t thread_id) {
+    thread_annotation_.thread_id = thread_id;
+  }
+
+  //! \brief Arranges for MinidumpThreadAnnotation::annotation_objects to point
+  //!     to the MinidumpAnnotationList object to be written by \a
+  //!     annotation_objects.
+  //!
+  //! This object takes ownership of \a annotation_objects and becomes its
+  //! parent in the overall tree of internal::MinidumpWritable objects.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetAnnotationObjects(
+      std::unique_ptr<MinidumpAnnotationListWriter> annotation_objects);
+
+ protected:
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t SizeOfObject() override;
+  std::vector<MinidumpWritable*> Children() override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+
+ private:
+  MinidumpThreadAnnotation thread_annotation_;
+  std::unique_ptr<MinidumpAnnotationListWriter> annotation_objects_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpThreadAnnotationWriter);
+};
+
+//! \brief The writer for a MinidumpThreadAnnotationList stream in a minidump
+//!     file, containing a list of MinidumpThreadAnnotation objects.
+class MinidumpThreadAnnotationListWriter final
+    : public internal::MinidumpStreamWriter {
+ public:
+  MinidumpThreadAnnotationListWriter();
+  ~MinidumpThreadAnnotationListWriter() override;
+
+  //! \brief Adds an initialized MinidumpThreadAnnotation for each thread that
+  //!     has set typed annotations in any of \a module_snapshots.
+  //!
+  //! A thread’s annotations from all modules are merged into a single list.
+  //! Threads that do not appear in \a thread_id_map, such as those that exited
+  //! before the snapshot’s threads were enumerated, are omitted.
+  //!
+  //! \param[in] module_snapshots The module snapshots to use as source data.
+  //! \param[in] thread_id_map A MinidumpThreadIDMap, as built by
+  //!     MinidumpThreadListWriter::InitializeFromSnapshot(), to be consulted to
+  //!     determine the 32-bit minidump thread ID to use for each thread.
+  //!
+  //! \note Valid in #kStateMutable. AddThreadAnnotation() may not be called
+  //!     before this method, and it is not normally necessary to call
+  //!     AddThreadAnnotation() after this method.
+  void InitializeFromSnapshot(
+      const std::vector<const ModuleSnapshot*>& module_snapshots,
+      const MinidumpThreadIDMap* thread_id_map);
+
+  //! \brief Adds a MinidumpThreadAnnotationWriter to the
+  //!     MinidumpThreadAnnotationList.
+  //!
+  //! This object takes ownership of \a thread_annotation and becomes its
+  //! parent in the overall tree of internal::MinidumpWritable objects.
+  //!
+  //! \note Valid in #kStateMutable.
+  void AddThreadAnnotation(
+      std::unique_ptr<MinidumpThreadAnnotationWriter> thread_annotation);
+
+  //! \brief Determines whether the object is useful.
+  //!
+  //! A useful object is one that carries data that makes a meaningful
+  //! contribution to a minidump file. An object carrying no thread annotations
+  //! would not be considered useful.
+  //!
+  //! \return `true` if the object is useful, `false` otherwise.
+  bool IsUseful() const;
+
+ protected:
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t SizeOfObject() override;
+  std::vector<MinidumpWritable*> Children() override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+
+  // MinidumpStreamWriter:
+  MinidumpStreamType StreamType() const override;
+
+ private:
+  std::vector<std::unique_ptr<MinidumpThreadAnnotationWriter>>
+      thread_annotations_;
+  MinidumpThreadAnnotationList thread_annotation_list_base_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpThreadAnnotationListWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_THREAD_ANNOTATION_LIST_WRITER_H_
@@ -0,0 +1,201 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_thread_annotation_list_writer.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/minidump_thread_id_map.h"
+#include "minidump/test/minidump_file_writer_test_util.h"
+#include "minidump/test/minidump_string_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "snapshot/test/test_module_snapshot.h"
+#include "snapshot/test/test_thread_snapshot.h"
+#include "util/file/string_file.h"
+#include "util/stdlib/pointer_container.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+void GetThreadAnnotationListStream(
+    const std::string& file_contents,
+    const MinidumpThreadAnnotationList** thread_annotation_list) {
+  constexpr size_t kDirectoryOffset = sizeof(MINIDUMP_HEADER);
+  constexpr size_t kThreadAnnotationListStreamOffset =
+      kDirectoryOffset + sizeof(MINIDUMP_DIRECTORY);
+  constexpr size_t kThreadsOffset =
+      kThreadAnnotationListStreamOffset + sizeof(MinidumpThreadAnnotationList);
+
+  ASSERT_GE(file_contents.size(), kThreadsOffset);
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(file_contents, &directory);
+  ASSERT_NO_FATAL_FAILURE(VerifyMinidumpHeader(header, 1, 0));
+  ASSERT_TRUE(directory);
+
+  ASSERT_EQ(directory[0].StreamType,
+            kMinidumpStreamTypeCrashpadThreadAnnotations);
+  EXPECT_EQ(directory[0].Location.Rva, kThreadAnnotationListStreamOffset);
+
+  *thread_annotation_list =
+      MinidumpWritableAtLocationDescriptor<MinidumpThreadAnnotationList>(
+          file_contents, directory[0].Location);
+  ASSERT_TRUE(*thread_annotation_list);
+}
+
+// Returns the names of the annotations that |thread_annotation| refers to.
+std::vector<std::string> AnnotationNames(
+    const std::string& file_contents,
+    const MinidumpThreadAnnotation& thread_annotation) {
+  std::vector<std::string> names;
+  const MinidumpAnnotationList* list =
+      MinidumpWritableAtLocationDescriptor<MinidumpAnnotationList>(
+          file_contents, thread_annotation.annotation_objects);
+  EXPECT_TRUE(list);
+  if (!list) {
+    return names;
+  }
+  for (uint32_t index = 0; index < list->count; ++index) {
+    names.push_back(MinidumpUTF8StringAtRVAAsString(
+        file_contents, list->objects[index].name));
+  }
+  return names;
+}
+
+TEST(MinidumpThreadAnnotationListWriter, EmptyThreadAnnotationList) {
+  MinidumpFileWriter minidump_file_writer;
+  auto thread_annotation_list_writer =
+      base::WrapUnique(new MinidumpThreadAnnotationListWriter());
+  EXPECT_FALSE(thread_annotation_list_writer->IsUseful());
+
+  ASSERT_TRUE(
+      minidump_file_writer.AddStream(std::move(thread_annotation_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  ASSERT_EQ(string_file.string().size(),
+            sizeof(MINIDUMP_HEADER) + sizeof(MINIDUMP_DIRECTORY) +
+                sizeof(MinidumpThreadAnnotationList));
+
+  const MinidumpThreadAnnotationList* thread_annotation_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(GetThreadAnnotationListStream(
+      string_file.string(), &thread_annotation_list));
+
+  EXPECT_EQ(thread_annotation_list->count, 0u);
+}
+
+TEST(MinidumpThreadAnnotationListWriter, OneThread) {
+  MinidumpFileWriter minidump_file_writer;
+  auto thread_annotation_list_writer =
+      base::WrapUnique(new MinidumpThreadAnnotationListWriter());
+
+  constexpr uint32_t kThreadID = 0x11111111;
+
+  auto annotation_objects =
+      base::WrapUnique(new MinidumpAnnotationListWriter());
+  annotation_objects->InitializeFromList(
+      {AnnotationSnapshot("request", 1, {'x'})});
+  auto thread_annotation_writer =
+      base::WrapUnique(new MinidumpThreadAnnotationWriter());
+  thread_annotation_writer->SetThreadID(kThreadID);
+  thread_annotation_writer->SetAnnotationObjects(
+      std::move(annotation_objects));
+  thread_annotation_list_writer->AddThreadAnnotation(
+      std::move(thread_annotation_writer));
+  EXPECT_TRUE(thread_annotation_list_writer->IsUseful());
+
+  ASSERT_TRUE(
+      minidump_file_writer.AddStream(std::move(thread_annotation_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpThreadAnnotationList* thread_annotation_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(GetThreadAnnotationListStream(
+      string_file.string(), &thread_annotation_list));
+
+  ASSERT_EQ(thread_annotation_list->count, 1u);
+  EXPECT_EQ(thread_annotation_list->threads[0].thread_id, kThreadID);
+  EXPECT_EQ(AnnotationNames(string_file.string(),
+                            thread_annotation_list->threads[0]),
+            std::vector<std::string>{"request"});
+}
+
+TEST(MinidumpThreadAnnotationListWriter, InitializeFromSnapshot) {
+  PointerVector<TestThreadSnapshot> thread_snapshots_owner;
+  std::vector<const ThreadSnapshot*> thread_snapshots;
+  for (uint64_t thread_id : {100, 101, 102}) {
+    TestThreadSnapshot* thread_snapshot = new TestThreadSnapshot();
+    thread_snapshots_owner.push_back(thread_snapshot);
+    thread_snapshot->SetThreadID(thread_id);
+    thread_snapshots.push_back(thread_snapshot);
+  }
+
+  MinidumpThreadIDMap thread_id_map;
+  BuildMinidumpThreadIDMap(thread_snapshots, &thread_id_map);
+
+  // Thread 102 sets no annotations, and thread 200 is not in the snapshot.
+  TestModuleSnapshot module_0;
+  module_0.SetThreadAnnotationObjects(
+      {{100, {AnnotationSnapshot("a", 1, {'1'})}},
+       {101, {AnnotationSnapshot("b", 1, {'2'})}},
+       {200, {AnnotationSnapshot("c", 1, {'3'})}}});
+  TestModuleSnapshot module_1;
+  module_1.SetThreadAnnotationObjects(
+      {{101, {AnnotationSnapshot("d", 1, {'4'})}}});
+  std::vector<const ModuleSnapshot*> module_snapshots = {&module_0,
+                                                         &module_1};
+
+  auto thread_annotation_list_writer =
+      base::WrapUnique(new MinidumpThreadAnnotationListWriter());
+  thread_annotation_list_writer->InitializeFromSnapshot(module_snapshots,
+                                                        &thread_id_map);
+
+  MinidumpFileWriter minidump_file_writer;
+  ASSERT_TRUE(
+      minidump_file_writer.AddStream(std::move(thread_annotation_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpThreadAnnotationList* thread_annotation_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(GetThreadAnnotationListStream(
+      string_file.string(), &thread_annotation_list));
+
+  ASSERT_EQ(thread_annotation_list->count, 2u);
+  const MinidumpThreadAnnotation* threads = thread_annotation_list->threads;
+
+  EXPECT_EQ(threads[0].thread_id, thread_id_map[100]);
+  EXPECT_EQ(AnnotationNames(string_file.string(), threads[0]),
+            std::vector<std::string>{"a"});
+
+  // A thread’s annotations from each module are merged in module order.
+  EXPECT_EQ(threads[1].thread_id, thread_id_map[101]);
+  EXPECT_EQ(AnnotationNames(string_file.string(), threads[1]),
+            (std::vector<std::string>{"b", "d"}));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
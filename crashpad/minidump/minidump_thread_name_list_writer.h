@@ -0,0 +1,157 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_THREAD_NAME_LIST_WRITER_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_THREAD_NAME_LIST_WRITER_H_
+
+#include <windows.h>
+#include <dbghelp.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "minidump/minidump_stream_writer.h"
+#include "minidump/minidump_string_writer.h"
+#include "minidump/minidump_thread_id_map.h"
+#include "minidump/minidump_writable.h"
+#include "util/stdlib/pointer_container.h"
+
+namespace crashpad {
+
+class ThreadSnapshot;
+
+//! \brief The writer for a MINIDUMP_THREAD_NAME object in a minidump file.
+//!
+//! Because MINIDUMP_THREAD_NAME objects only appear as elements of
+//! MINIDUMP_THREAD_NAME_LIST objects, this class does not write any data on its
+//! own. It makes its MINIDUMP_THREAD_NAME data available to its
+//! MinidumpThreadNameListWriter parent, which writes it as part of a
+//! MINIDUMP_THREAD_NAME_LIST.
+//!
+//! The name itself is written by a MinidumpUTF16StringWriter, so threads that
+//! share a name, such as the workers of a thread pool, share a single copy of
+//! it when the minidump file is written with a string table in effect.
+class MinidumpThreadNameWriter final : public internal::MinidumpWritable {
+ public:
+  MinidumpThreadNameWriter();
+  ~MinidumpThreadNameWriter() override;
+
+  //! \brief Initializes the MINIDUMP_THREAD_NAME based on \a thread_snapshot.
+  //!
+  //! \param[in] thread_snapshot The thread snapshot to use as source data.
+  //! \param[in] thread_id_map A MinidumpThreadIDMap to be consulted to
+  //!     determine the 32-bit minidump thread ID to use for \a thread_snapshot.
+  //!
+  //! \note Valid in #kStateMutable. No mutator methods may be called before
+  //!     this method, and it is not normally necessary to call any mutator
+  //!     methods after this method.
+  void InitializeFromSnapshot(const ThreadSnapshot* thread_snapshot,
+                              const MinidumpThreadIDMap* thread_id_map);
+
+  //! \brief Returns a MINIDUMP_THREAD_NAME referencing this object’s data.
+  //!
+  //! This method is expected to be called by a MinidumpThreadNameListWriter in
+  //! order to obtain a MINIDUMP_THREAD_NAME to include in its list.
+  //!
+  //! \note Valid in #kStateWritable.
+  const MINIDUMP_THREAD_NAME* MinidumpThreadName() const;
+
+  //! \brief Sets MINIDUMP_THREAD_NAME::ThreadId.
+  void SetThreadID(uint32_t thread_id) { thread_name_.ThreadId = thread_id; }
+
+  //! \brief Arranges for MINIDUMP_THREAD_NAME::RvaOfThreadName to point to a
+  //!     MINIDUMP_STRING containing \a name.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetName(const std::string& name);
+
+ protected:
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t SizeOfObject() override;
+  std::vector<MinidumpWritable*> Children() override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+
+ private:
+  MINIDUMP_THREAD_NAME thread_name_;
+  std::unique_ptr<internal::MinidumpUTF16StringWriter> name_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpThreadNameWriter);
+};
+
+//! \brief The writer for a MINIDUMP_THREAD_NAME_LIST stream in a minidump
+//!     file, containing a list of MINIDUMP_THREAD_NAME objects.
+class MinidumpThreadNameListWriter final
+    : public internal::MinidumpStreamWriter {
+ public:
+  MinidumpThreadNameListWriter();
+  ~MinidumpThreadNameListWriter() override;
+
+  //! \brief Adds an initialized MINIDUMP_THREAD_NAME for each thread in \a
+  //!     thread_snapshots that has a name to the MINIDUMP_THREAD_NAME_LIST.
+  //!
+  //! Threads without names are omitted.
+  //!
+  //! \param[in] thread_snapshots The thread snapshots to use as source data.
+  //! \param[in] thread_id_map A MinidumpThreadIDMap, as built by
+  //!     MinidumpThreadListWriter::InitializeFromSnapshot(), to be consulted to
+  //!     determine the 32-bit minidump thread ID to use for each thread.
+  //!
+  //! \note Valid in #kStateMutable. AddThreadName() may not be called before
+  //!     this method, and it is not normally necessary to call AddThreadName()
+  //!     after this method.
+  void InitializeFromSnapshot(
+      const std::vector<const ThreadSnapshot*>& thread_snapshots,
+      const MinidumpThreadIDMap* thread_id_map);
+
+  //! \brief Adds a MinidumpThreadNameWriter to the MINIDUMP_THREAD_NAME_LIST.
+  //!
+  //! This object takes ownership of \a thread_name and becomes its parent in
+  //! the overall tree of internal::MinidumpWritable objects.
+  //!
+  //! \note Valid in #kStateMutable.
+  void AddThreadName(std::unique_ptr<MinidumpThreadNameWriter> thread_name);
+
+  //! \brief Determines whether the object is useful.
+  //!
+  //! A useful object is one that carries data that makes a meaningful
+  //! contribution to a minidump file. An object carrying no thread names would
+  //! not be considered useful.
+  //!
+  //! \return `true` if the object is useful, `false` otherwise.
+  bool IsUseful() const;
+
+ protected:
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t SizeOfObject() override;
+  std::vector<MinidumpWritable*> Children() override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+
+  // MinidumpStreamWriter:
+  MinidumpStreamType StreamType() const override;
+
+ private:
+  PointerVector<MinidumpThreadNameWriter> thread_names_;
+  MINIDUMP_THREAD_NAME_LIST thread_name_list_base_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpThreadNameListWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_THREAD_NAME_LIST_WRITER_H_
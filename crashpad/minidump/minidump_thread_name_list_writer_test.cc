@@ -0,0 +1,182 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_thread_name_list_writer.h"
+
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/ptr_util.h"
+#include "base/strings/utf_string_conversions.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/minidump_thread_id_map.h"
+#include "minidump/test/minidump_file_writer_test_util.h"
+#include "minidump/test/minidump_string_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "snapshot/test/test_thread_snapshot.h"
+#include "util/file/string_file.h"
+#include "util/stdlib/pointer_container.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+void GetThreadNameListStream(
+    const std::string& file_contents,
+    const MINIDUMP_THREAD_NAME_LIST** thread_name_list) {
+  constexpr size_t kDirectoryOffset = sizeof(MINIDUMP_HEADER);
+  constexpr size_t kThreadNameListStreamOffset =
+      kDirectoryOffset + sizeof(MINIDUMP_DIRECTORY);
+  constexpr size_t kThreadNamesOffset =
+      kThreadNameListStreamOffset + sizeof(MINIDUMP_THREAD_NAME_LIST);
+
+  ASSERT_GE(file_contents.size(), kThreadNamesOffset);
+
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(file_contents, &directory);
+  ASSERT_NO_FATAL_FAILURE(VerifyMinidumpHeader(header, 1, 0));
+  ASSERT_TRUE(directory);
+
+  ASSERT_EQ(directory[0].StreamType, kMinidumpStreamTypeThreadNameList);
+  EXPECT_EQ(directory[0].Location.Rva, kThreadNameListStreamOffset);
+
+  *thread_name_list =
+      MinidumpWritableAtLocationDescriptor<MINIDUMP_THREAD_NAME_LIST>(
+          file_contents, directory[0].Location);
+  ASSERT_TRUE(*thread_name_list);
+}
+
+// Returns the name that |thread_name| refers to.
+std::string ThreadNameAsString(const std::string& file_contents,
+                               const MINIDUMP_THREAD_NAME& thread_name) {
+  EXPECT_NE(thread_name.RvaOfThreadName, 0u);
+  EXPECT_LE(thread_name.RvaOfThreadName, std::numeric_limits<RVA>::max());
+  return base::UTF16ToUTF8(MinidumpStringAtRVAAsString(
+      file_contents, static_cast<RVA>(thread_name.RvaOfThreadName)));
+}
+
+TEST(MinidumpThreadNameListWriter, EmptyThreadNameList) {
+  MinidumpFileWriter minidump_file_writer;
+  auto thread_name_list_writer =
+      base::WrapUnique(new MinidumpThreadNameListWriter());
+  EXPECT_FALSE(thread_name_list_writer->IsUseful());
+
+  ASSERT_TRUE(
+      minidump_file_writer.AddStream(std::move(thread_name_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  ASSERT_EQ(string_file.string().size(),
+            sizeof(MINIDUMP_HEADER) + sizeof(MINIDUMP_DIRECTORY) +
+                sizeof(MINIDUMP_THREAD_NAME_LIST));
+
+  const MINIDUMP_THREAD_NAME_LIST* thread_name_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetThreadNameListStream(string_file.string(), &thread_name_list));
+
+  EXPECT_EQ(thread_name_list->NumberOfThreadNames, 0u);
+}
+
+TEST(MinidumpThreadNameListWriter, OneThreadName) {
+  MinidumpFileWriter minidump_file_writer;
+  auto thread_name_list_writer =
+      base::WrapUnique(new MinidumpThreadNameListWriter());
+
+  constexpr uint32_t kThreadID = 0x11111111;
+  static constexpr char kThreadName[] = "main";
+
+  auto thread_name_writer = base::WrapUnique(new MinidumpThreadNameWriter());
+  thread_name_writer->SetThreadID(kThreadID);
+  thread_name_writer->SetName(kThreadName);
+  thread_name_list_writer->AddThreadName(std::move(thread_name_writer));
+  EXPECT_TRUE(thread_name_list_writer->IsUseful());
+
+  ASSERT_TRUE(
+      minidump_file_writer.AddStream(std::move(thread_name_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_THREAD_NAME_LIST* thread_name_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetThreadNameListStream(string_file.string(), &thread_name_list));
+
+  ASSERT_EQ(thread_name_list->NumberOfThreadNames, 1u);
+  EXPECT_EQ(thread_name_list->ThreadNames[0].ThreadId, kThreadID);
+  EXPECT_EQ(ThreadNameAsString(string_file.string(),
+                               thread_name_list->ThreadNames[0]),
+            kThreadName);
+}
+
+TEST(MinidumpThreadNameListWriter, InitializeFromSnapshot) {
+  static constexpr char kWorkerName[] = "ThreadPoolWorker";
+  static constexpr char kMainName[] = "main";
+
+  PointerVector<TestThreadSnapshot> thread_snapshots_owner;
+  std::vector<const ThreadSnapshot*> thread_snapshots;
+  for (const char* name : {kMainName, "", kWorkerName, kWorkerName}) {
+    TestThreadSnapshot* thread_snapshot = new TestThreadSnapshot();
+    thread_snapshots_owner.push_back(thread_snapshot);
+    thread_snapshot->SetThreadID(thread_snapshots.size() + 100);
+    thread_snapshot->SetThreadName(name);
+    thread_snapshots.push_back(thread_snapshot);
+  }
+
+  MinidumpThreadIDMap thread_id_map;
+  BuildMinidumpThreadIDMap(thread_snapshots, &thread_id_map);
+
+  auto thread_name_list_writer =
+      base::WrapUnique(new MinidumpThreadNameListWriter());
+  thread_name_list_writer->InitializeFromSnapshot(thread_snapshots,
+                                                  &thread_id_map);
+
+  MinidumpFileWriter minidump_file_writer;
+  ASSERT_TRUE(
+      minidump_file_writer.AddStream(std::move(thread_name_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_THREAD_NAME_LIST* thread_name_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetThreadNameListStream(string_file.string(), &thread_name_list));
+
+  // The unnamed thread is omitted.
+  ASSERT_EQ(thread_name_list->NumberOfThreadNames, 3u);
+  const MINIDUMP_THREAD_NAME* thread_names = thread_name_list->ThreadNames;
+
+  EXPECT_EQ(thread_names[0].ThreadId, thread_id_map[100]);
+  EXPECT_EQ(ThreadNameAsString(string_file.string(), thread_names[0]),
+            kMainName);
+  EXPECT_EQ(thread_names[1].ThreadId, thread_id_map[102]);
+  EXPECT_EQ(ThreadNameAsString(string_file.string(), thread_names[1]),
+            kWorkerName);
+  EXPECT_EQ(thread_names[2].ThreadId, thread_id_map[103]);
+  EXPECT_EQ(ThreadNameAsString(string_file.string(), thread_names[2]),
+            kWorkerName);
+
+  // Threads that share a name share a single copy of it.
+  EXPECT_EQ(thread_names[2].RvaOfThreadName, thread_names[1].RvaOfThreadName);
+  EXPECT_NE(thread_names[1].RvaOfThreadName, thread_names[0].RvaOfThreadName);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -14,6 +14,8 @@
 
 #include "minidump/minidump_thread_writer.h"
 
+#include <algorithm>
+#include <map>
 #include <utility>
 
 #include "base/logging.h"
@@ -23,12 +25,48 @@
 #include "snapshot/memory_snapshot.h"
 #include "snapshot/thread_snapshot.h"
 #include "util/file/file_writer.h"
+#include "util/misc/xxhash.h"
 #include "util/numeric/safe_assignment.h"
 
 namespace crashpad {
 
+namespace {
+
+// Collects the data that a SnapshotMinidumpMemoryWriter will write.
+class WrittenDataReader final : public MemorySnapshot::Delegate {
+ public:
+  WrittenDataReader(size_t write_size, std::vector<uint8_t>* data)
+      : MemorySnapshot::Delegate(), data_(data), write_size_(write_size) {}
+  ~WrittenDataReader() override {}
+
+  // MemorySnapshot::Delegate:
+  bool MemorySnapshotDelegateRead(void* data, size_t size) override {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    data_->assign(bytes, bytes + std::min(size, write_size_));
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t>* data_;  // weak
+  size_t write_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(WrittenDataReader);
+};
+
+bool ReadWrittenData(const SnapshotMinidumpMemoryWriter& memory_writer,
+                     std::vector<uint8_t>* data) {
+  WrittenDataReader reader(memory_writer.WriteSize(), data);
+  return memory_writer.UnderlyingSnapshot().Read(&reader);
+}
+
+}  // namespace
+
 MinidumpThreadWriter::MinidumpThreadWriter()
-    : MinidumpWritable(), thread_(), stack_(nullptr), context_(nullptr) {
+    : MinidumpWritable(),
+      thread_(),
+      stack_(nullptr),
+      context_(nullptr),
+      context_list_(nullptr) {
 }
 
 MinidumpThreadWriter::~MinidumpThreadWriter() {
@@ -53,6 +91,7 @@ void MinidumpThreadWriter::InitializeFromSnapshot(
   if (stack_snapshot && stack_snapshot->Size() > 0) {
     std::unique_ptr<SnapshotMinidumpMemoryWriter> stack(
         new SnapshotMinidumpMemoryWriter(stack_snapshot));
+    stack->SetReadSite(MemoryReadSite::kStacks);
     SetStack(std::move(stack));
   }
 
@@ -81,6 +120,13 @@ void MinidumpThreadWriter::SetContext(
   context_ = std::move(context);
 }
 
+void MinidumpThreadWriter::SetContextListWriter(
+    internal::MinidumpContextListWriter* context_list) {
+  DCHECK_EQ(state(), kStateMutable);
+
+  context_list_ = context_list;
+}
+
 bool MinidumpThreadWriter::Freeze() {
   DCHECK_EQ(state(), kStateMutable);
   CHECK(context_);
@@ -93,7 +139,11 @@ bool MinidumpThreadWriter::Freeze() {
     stack_->RegisterMemoryDescriptor(&thread_.Stack);
   }
 
-  context_->RegisterLocationDescriptor(&thread_.ThreadContext);
+  if (context_list_) {
+    context_list_->AddContext(context_.get(), &thread_.ThreadContext);
+  } else {
+    context_->RegisterLocationDescriptor(&thread_.ThreadContext);
+  }
 
   return true;
 }
@@ -115,7 +165,9 @@ std::vector<internal::MinidumpWritable*> MinidumpThreadWriter::Children() {
   if (stack_) {
     children.push_back(stack_.get());
   }
-  children.push_back(context_.get());
+  if (!context_list_) {
+    children.push_back(context_.get());
+  }
 
   return children;
 }
@@ -133,6 +185,9 @@ MinidumpThreadListWriter::MinidumpThreadListWriter()
     : MinidumpStreamWriter(),
       threads_(),
       memory_list_writer_(nullptr),
+      size_budget_plan_(),
+      collapse_identical_stacks_(false),
+      context_list_(),
       thread_list_base_() {
 }
 
@@ -150,13 +205,49 @@ void MinidumpThreadListWriter::InitializeFromSnapshot(
   for (const ThreadSnapshot* thread_snapshot : thread_snapshots) {
     auto thread = base::WrapUnique(new MinidumpThreadWriter());
     thread->InitializeFromSnapshot(thread_snapshot, thread_id_map);
+
+    SnapshotMinidumpMemoryWriter* stack = thread->Stack();
+    if (stack && !(size_budget_plan_.has_exempt_thread_id &&
+                   thread_snapshot->ThreadID() ==
+                       size_budget_plan_.exempt_thread_id)) {
+      stack->SetMaximumSize(size_budget_plan_.stack_size);
+    }
+
     AddThread(std::move(thread));
   }
 
+  if (collapse_identical_stacks_) {
+    CollapseIdenticalStacks(thread_snapshots);
+  }
+
   // Do this in a separate loop to keep the thread stacks earlier in the dump,
   // and together.
-  for (const ThreadSnapshot* thread_snapshot : thread_snapshots)
-    memory_list_writer_->AddFromSnapshot(thread_snapshot->ExtraMemory());
+  size_t extra_memory_remaining = size_budget_plan_.thread_extra_memory_count;
+  for (const ThreadSnapshot* thread_snapshot : thread_snapshots) {
+    std::vector<const MemorySnapshot*> extra_memory =
+        thread_snapshot->ExtraMemory();
+    if (extra_memory.size() > extra_memory_remaining) {
+      extra_memory.resize(extra_memory_remaining);
+    }
+    extra_memory_remaining -= extra_memory.size();
+    memory_list_writer_->AddFromSnapshot(extra_memory,
+                                         MemoryReadSite::kIndirectMemory);
+  }
+}
+
+void MinidumpThreadListWriter::SetSizeBudgetPlan(
+    const internal::MinidumpSizeBudgetPlan& plan) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(threads_.empty());
+
+  size_budget_plan_ = plan;
+}
+
+void MinidumpThreadListWriter::SetCollapseIdenticalStacks(bool collapse) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(threads_.empty());
+
+  collapse_identical_stacks_ = collapse;
 }
 
 void MinidumpThreadListWriter::SetMemoryListWriter(
@@ -181,9 +272,65 @@ void MinidumpThreadListWriter::AddThread(
   threads_.push_back(thread.release());
 }
 
+void MinidumpThreadListWriter::CollapseIdenticalStacks(
+    const std::vector<const ThreadSnapshot*>& thread_snapshots) {
+  DCHECK_EQ(thread_snapshots.size(), threads_.size());
+
+  // Stacks that are written in full, keyed by the size and hash of their data.
+  // An original’s data is only retained once another stack’s key matches it.
+  struct Original {
+    SnapshotMinidumpMemoryWriter* memory_writer;  // weak
+    std::vector<uint8_t> data;
+    bool has_data;
+  };
+  std::map<std::pair<size_t, uint64_t>, std::vector<Original>> originals;
+
+  std::vector<uint8_t> data;
+  for (size_t index = 0; index < threads_.size(); ++index) {
+    SnapshotMinidumpMemoryWriter* stack = threads_[index]->Stack();
+    if (!stack || stack->WriteSize() == 0 ||
+        (size_budget_plan_.has_exempt_thread_id &&
+         thread_snapshots[index]->ThreadID() ==
+             size_budget_plan_.exempt_thread_id)) {
+      continue;
+    }
+
+    if (!ReadWrittenData(*stack, &data)) {
+      continue;
+    }
+
+    std::vector<Original>& candidates = originals[std::make_pair(
+        data.size(), XXHash64(data.data(), data.size(), 0))];
+    bool collapsed = false;
+    for (Original& original : candidates) {
+      if (!original.has_data) {
+        if (!ReadWrittenData(*original.memory_writer, &original.data)) {
+          continue;
+        }
+        original.has_data = true;
+      }
+      if (original.data == data) {
+        stack->SetDuplicateOf(original.memory_writer);
+        collapsed = true;
+        break;
+      }
+    }
+
+    if (!collapsed) {
+      candidates.push_back(Original{stack, std::vector<uint8_t>(), false});
+    }
+  }
+}
+
 bool MinidumpThreadListWriter::Freeze() {
   DCHECK_EQ(state(), kStateMutable);
 
+  // Write every thread’s context in a single contiguous block following the
+  // MINIDUMP_THREAD_LIST, rather than one at a time.
+  for (MinidumpThreadWriter* thread : threads_) {
+    thread->SetContextListWriter(&context_list_);
+  }
+
   if (!MinidumpStreamWriter::Freeze()) {
     return false;
   }
@@ -210,6 +357,7 @@ std::vector<internal::MinidumpWritable*> MinidumpThreadListWriter::Children() {
   for (MinidumpThreadWriter* thread : threads_) {
     children.push_back(thread);
   }
+  children.push_back(&context_list_);
 
   return children;
 }
@@ -24,6 +24,8 @@
 #include <vector>
 
 #include "base/macros.h"
+#include "minidump/minidump_context_writer.h"
+#include "minidump/minidump_size_budget.h"
 #include "minidump/minidump_stream_writer.h"
 #include "minidump/minidump_thread_id_map.h"
 #include "minidump/minidump_writable.h"
@@ -102,6 +104,18 @@ class MinidumpThreadWriter final : public internal::MinidumpWritable {
   //! \note Valid in #kStateMutable.
   void SetContext(std::unique_ptr<MinidumpContextWriter> context);
 
+  //! \brief Arranges for the CPU context set by SetContext() to be written by
+  //!     \a context_list, instead of by itself as a child of this object.
+  //!
+  //! This is expected to be called by a MinidumpThreadListWriter, so that the
+  //! contexts of all threads in the list are written together.
+  //!
+  //! \param[in] context_list The writer to add the context to when this object
+  //!     is frozen. Weak.
+  //!
+  //! \note Valid in #kStateMutable.
+  void SetContextListWriter(internal::MinidumpContextListWriter* context_list);
+
   //! \brief Sets MINIDUMP_THREAD::ThreadId.
   void SetThreadID(uint32_t thread_id) { thread_.ThreadId = thread_id; }
 
@@ -132,6 +146,7 @@ class MinidumpThreadWriter final : public internal::MinidumpWritable {
   MINIDUMP_THREAD thread_;
   std::unique_ptr<SnapshotMinidumpMemoryWriter> stack_;
   std::unique_ptr<MinidumpContextWriter> context_;
+  internal::MinidumpContextListWriter* context_list_;  // weak
 
   DISALLOW_COPY_AND_ASSIGN(MinidumpThreadWriter);
 };
@@ -184,6 +199,36 @@ class MinidumpThreadListWriter final : public internal::MinidumpStreamWriter {
   //! \note Valid in #kStateMutable.
   void SetMemoryListWriter(MinidumpMemoryListWriter* memory_list_writer);
 
+  //! \brief Sets the plan that InitializeFromSnapshot() will follow to limit
+  //!     the amount of memory from thread snapshots that is written.
+  //!
+  //! The plan’s limits on thread stack sizes and on the indirectly-referenced
+  //! memory added to the MinidumpMemoryListWriter set by SetMemoryListWriter()
+  //! are applied.
+  //!
+  //! \note This method must be called before InitializeFromSnapshot().
+  //! \note Valid in #kStateMutable.
+  void SetSizeBudgetPlan(const internal::MinidumpSizeBudgetPlan& plan);
+
+  //! \brief Arranges for InitializeFromSnapshot() to write the contents of
+  //!     identical thread stacks only once.
+  //!
+  //! Threads parked in a pool often have stacks whose captured contents are
+  //! byte-for-byte identical, although at different addresses. When this is
+  //! enabled, the stack of each thread other than the plan’s exempt thread is
+  //! read and hashed, and any whose contents match an earlier stack’s are made
+  //! duplicates of it by SnapshotMinidumpMemoryWriter::SetDuplicateOf(). Each
+  //! thread keeps its own context, and its MINIDUMP_MEMORY_DESCRIPTOR keeps
+  //! its own address, in both the MINIDUMP_THREAD and the
+  //! MINIDUMP_MEMORY_LIST. Stacks are read one additional time to do this.
+  //!
+  //! \param[in] collapse Whether to collapse identical stacks. The default is
+  //!     `false`.
+  //!
+  //! \note This method must be called before InitializeFromSnapshot().
+  //! \note Valid in #kStateMutable.
+  void SetCollapseIdenticalStacks(bool collapse);
+
   //! \brief Adds a MinidumpThreadWriter to the MINIDUMP_THREAD_LIST.
   //!
   //! This object takes ownership of \a thread and becomes its parent in the
@@ -203,8 +248,19 @@ class MinidumpThreadListWriter final : public internal::MinidumpStreamWriter {
   MinidumpStreamType StreamType() const override;
 
  private:
+  //! \brief Makes each stack in #threads_, other than the exempt thread’s,
+  //!     that is identical to an earlier one a duplicate of it.
+  //!
+  //! \a thread_snapshots are those that #threads_ were initialized from, in
+  //! the same order.
+  void CollapseIdenticalStacks(
+      const std::vector<const ThreadSnapshot*>& thread_snapshots);
+
   PointerVector<MinidumpThreadWriter> threads_;
   MinidumpMemoryListWriter* memory_list_writer_;  // weak
+  internal::MinidumpSizeBudgetPlan size_budget_plan_;
+  bool collapse_identical_stacks_;
+  internal::MinidumpContextListWriter context_list_;
   MINIDUMP_THREAD_LIST thread_list_base_;
 
   DISALLOW_COPY_AND_ASSIGN(MinidumpThreadListWriter);
@@ -696,6 +696,81 @@ TEST(MinidumpThreadWriter, InitializeFromSnapshot_ThreadIDCollision) {
   RunInitializeFromSnapshotTest<InitializeFromSnapshotX86Traits>(true);
 }
 
+TEST(MinidumpThreadWriter, InitializeFromSnapshot_CollapseIdenticalStacks) {
+  // The stacks of threads 0, 1, and 3 are identical, but thread 3 is exempt.
+  constexpr uint64_t kStackAddresses[] = {0x1000, 0x2000, 0x3000, 0x4000};
+  constexpr char kStackValues[] = {'s', 's', 'u', 's'};
+  constexpr size_t kStackSize = 0x100;
+  constexpr uint64_t kExemptThreadID = 3;
+
+  PointerVector<TestThreadSnapshot> thread_snapshots_owner;
+  std::vector<const ThreadSnapshot*> thread_snapshots;
+  for (size_t index = 0; index < arraysize(kStackAddresses); ++index) {
+    TestThreadSnapshot* thread_snapshot = new TestThreadSnapshot();
+    thread_snapshots_owner.push_back(thread_snapshot);
+
+    thread_snapshot->SetThreadID(index);
+
+    auto memory_snapshot = base::WrapUnique(new TestMemorySnapshot());
+    memory_snapshot->SetAddress(kStackAddresses[index]);
+    memory_snapshot->SetSize(kStackSize);
+    memory_snapshot->SetValue(kStackValues[index]);
+    thread_snapshot->SetStack(std::move(memory_snapshot));
+
+    InitializeFromSnapshotX86Traits::InitializeCPUContext(
+        thread_snapshot->MutableContext(), static_cast<uint32_t>(index));
+
+    thread_snapshots.push_back(thread_snapshot);
+  }
+
+  internal::MinidumpSizeBudgetPlan plan;
+  plan.has_exempt_thread_id = true;
+  plan.exempt_thread_id = kExemptThreadID;
+
+  auto thread_list_writer = base::WrapUnique(new MinidumpThreadListWriter());
+  auto memory_list_writer = base::WrapUnique(new MinidumpMemoryListWriter());
+  thread_list_writer->SetMemoryListWriter(memory_list_writer.get());
+  thread_list_writer->SetSizeBudgetPlan(plan);
+  thread_list_writer->SetCollapseIdenticalStacks(true);
+  MinidumpThreadIDMap thread_id_map;
+  thread_list_writer->InitializeFromSnapshot(thread_snapshots, &thread_id_map);
+
+  MinidumpFileWriter minidump_file_writer;
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(thread_list_writer)));
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(memory_list_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MINIDUMP_THREAD_LIST* thread_list = nullptr;
+  const MINIDUMP_MEMORY_LIST* memory_list = nullptr;
+  ASSERT_NO_FATAL_FAILURE(
+      GetThreadListStream(string_file.string(), &thread_list, &memory_list));
+
+  ASSERT_EQ(thread_list->NumberOfThreads, arraysize(kStackAddresses));
+  ASSERT_EQ(memory_list->NumberOfMemoryRanges, arraysize(kStackAddresses));
+
+  for (size_t index = 0; index < thread_list->NumberOfThreads; ++index) {
+    SCOPED_TRACE(base::StringPrintf("index %" PRIuS, index));
+
+    const MINIDUMP_MEMORY_DESCRIPTOR& stack =
+        thread_list->Threads[index].Stack;
+    EXPECT_EQ(stack.StartOfMemoryRange, kStackAddresses[index]);
+    ASSERT_EQ(stack.Memory.DataSize, kStackSize);
+    ASSERT_GE(string_file.string().size(), stack.Memory.Rva + kStackSize);
+    EXPECT_EQ(string_file.string().substr(stack.Memory.Rva, kStackSize),
+              std::string(kStackSize, kStackValues[index]));
+
+    ASSERT_NO_FATAL_FAILURE(ExpectMinidumpMemoryDescriptor(
+        &stack, &memory_list->MemoryRanges[index]));
+  }
+
+  const MINIDUMP_THREAD* threads = thread_list->Threads;
+  EXPECT_EQ(threads[1].Stack.Memory.Rva, threads[0].Stack.Memory.Rva);
+  EXPECT_NE(threads[2].Stack.Memory.Rva, threads[0].Stack.Memory.Rva);
+  EXPECT_NE(threads[3].Stack.Memory.Rva, threads[0].Stack.Memory.Rva);
+}
+
 TEST(MinidumpThreadWriterDeathTest, NoContext) {
   MinidumpFileWriter minidump_file_writer;
   auto thread_list_writer = base::WrapUnique(new MinidumpThreadListWriter());
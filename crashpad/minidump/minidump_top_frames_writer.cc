@@ -0,0 +1,133 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_top_frames_writer.h"
+
+#include <utility>
+
+#include "base/logging.h"
+#include "util/file/file_writer.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+
+MinidumpTopFramesWriter::MinidumpTopFramesWriter()
+    : internal::MinidumpStreamWriter(),
+      top_frame_list_base_(),
+      top_frames_(),
+      symbol_names_() {
+  top_frame_list_base_.version = MinidumpCrashpadTopFrameList::kVersion;
+}
+
+MinidumpTopFramesWriter::~MinidumpTopFramesWriter() {
+}
+
+void MinidumpTopFramesWriter::InitializeFromFrames(
+    uint64_t thread_id,
+    const std::vector<TopFrame>& frames,
+    const MinidumpThreadIDMap& thread_id_map) {
+  DCHECK_EQ(state(), kStateMutable);
+  DCHECK(top_frames_.empty());
+
+  auto thread_id_it = thread_id_map.find(thread_id);
+  DCHECK(thread_id_it != thread_id_map.end());
+  top_frame_list_base_.thread_id = thread_id_it->second;
+
+  for (const TopFrame& frame : frames) {
+    MinidumpCrashpadTopFrame top_frame = {};
+    top_frame.address = frame.address;
+    if (frame.module_index == TopFrame::kNoModule ||
+        !AssignIfInRange(&top_frame.module_index, frame.module_index)) {
+      top_frame.module_index = MinidumpCrashpadTopFrame::kNoModule;
+    } else {
+      top_frame.module_offset = frame.module_offset;
+    }
+    top_frames_.push_back(top_frame);
+
+    std::unique_ptr<internal::MinidumpUTF8StringWriter> symbol_name;
+    if (!frame.symbol.empty()) {
+      symbol_name.reset(new internal::MinidumpUTF8StringWriter());
+      symbol_name->SetUTF8(frame.symbol);
+      top_frames_.back().symbol_offset = frame.symbol_offset;
+    }
+    symbol_names_.push_back(std::move(symbol_name));
+  }
+}
+
+bool MinidumpTopFramesWriter::IsUseful() const {
+  return !top_frames_.empty();
+}
+
+bool MinidumpTopFramesWriter::Freeze() {
+  DCHECK_EQ(state(), kStateMutable);
+
+  if (!MinidumpStreamWriter::Freeze()) {
+    return false;
+  }
+
+  if (!AssignIfInRange(&top_frame_list_base_.count, top_frames_.size())) {
+    LOG(ERROR) << "count " << top_frames_.size() << " out of range";
+    return false;
+  }
+
+  for (size_t index = 0; index < top_frames_.size(); ++index) {
+    if (symbol_names_[index]) {
+      symbol_names_[index]->RegisterRVA(&top_frames_[index].symbol_name);
+    }
+  }
+
+  return true;
+}
+
+size_t MinidumpTopFramesWriter::SizeOfObject() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  return sizeof(top_frame_list_base_) +
+         top_frames_.size() * sizeof(top_frames_[0]);
+}
+
+std::vector<internal::MinidumpWritable*> MinidumpTopFramesWriter::Children() {
+  DCHECK_GE(state(), kStateFrozen);
+
+  std::vector<MinidumpWritable*> children;
+  for (const auto& symbol_name : symbol_names_) {
+    if (symbol_name) {
+      children.push_back(symbol_name.get());
+    }
+  }
+  return children;
+}
+
+bool MinidumpTopFramesWriter::WriteObject(FileWriterInterface* file_writer) {
+  DCHECK_EQ(state(), kStateWritable);
+
+  WritableIoVec iov;
+  iov.iov_base = &top_frame_list_base_;
+  iov.iov_len = sizeof(top_frame_list_base_);
+  std::vector<WritableIoVec> iovecs(1, iov);
+
+  if (!top_frames_.empty()) {
+    iov.iov_base = &top_frames_[0];
+    iov.iov_len = top_frames_.size() * sizeof(top_frames_[0]);
+    iovecs.push_back(iov);
+  }
+
+  return file_writer->WriteIoVec(&iovecs);
+}
+
+MinidumpStreamType MinidumpTopFramesWriter::StreamType() const {
+  return kMinidumpStreamTypeCrashpadTopFrames;
+}
+
+}  // namespace crashpad
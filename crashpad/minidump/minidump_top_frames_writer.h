@@ -0,0 +1,90 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_MINIDUMP_MINIDUMP_TOP_FRAMES_WRITER_H_
+#define CRASHPAD_MINIDUMP_MINIDUMP_TOP_FRAMES_WRITER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_stream_writer.h"
+#include "minidump/minidump_string_writer.h"
+#include "minidump/minidump_thread_id_map.h"
+#include "snapshot/top_frames.h"
+
+namespace crashpad {
+
+//! \brief The writer for a MinidumpCrashpadTopFrameList stream in a minidump
+//!     file, containing a list of MinidumpCrashpadTopFrame objects.
+class MinidumpTopFramesWriter final : public internal::MinidumpStreamWriter {
+ public:
+  MinidumpTopFramesWriter();
+  ~MinidumpTopFramesWriter() override;
+
+  //! \brief Initializes the MinidumpCrashpadTopFrameList from frames found by
+  //!     unwinding a thread’s stack, such as by
+  //!     ProcessSnapshotLinux::ComputeTopFrames().
+  //!
+  //! \param[in] thread_id The ID of the thread whose stack was unwound, as
+  //!     returned by ExceptionSnapshot::ThreadID().
+  //! \param[in] frames The frames, innermost first. TopFrame::module_index
+  //!     must refer to modules in the order of the module list stream.
+  //! \param[in] thread_id_map A MinidumpThreadIDMap to be consulted to
+  //!     determine the 32-bit minidump thread ID to use for \a thread_id.
+  //!
+  //! \note Valid in #kStateMutable. No mutator methods may be called before
+  //!     this method, and it is not normally necessary to call any mutator
+  //!     methods after this method.
+  void InitializeFromFrames(uint64_t thread_id,
+                            const std::vector<TopFrame>& frames,
+                            const MinidumpThreadIDMap& thread_id_map);
+
+  //! \brief Determines whether the object is useful.
+  //!
+  //! A useful object is one that carries data that makes a meaningful
+  //! contribution to a minidump file. An object carrying any frames would be
+  //! considered useful.
+  //!
+  //! \return `true` if the object is useful, `false` otherwise.
+  bool IsUseful() const;
+
+ protected:
+  // MinidumpWritable:
+  bool Freeze() override;
+  size_t SizeOfObject() override;
+  std::vector<MinidumpWritable*> Children() override;
+  bool WriteObject(FileWriterInterface* file_writer) override;
+
+  // MinidumpStreamWriter:
+  MinidumpStreamType StreamType() const override;
+
+ private:
+  MinidumpCrashpadTopFrameList top_frame_list_base_;
+  std::vector<MinidumpCrashpadTopFrame> top_frames_;
+
+  // Parallel to top_frames_, with nullptr for frames without a symbol.
+  std::vector<std::unique_ptr<internal::MinidumpUTF8StringWriter>>
+      symbol_names_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpTopFramesWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_MINIDUMP_MINIDUMP_TOP_FRAMES_WRITER_H_
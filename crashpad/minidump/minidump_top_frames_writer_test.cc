@@ -0,0 +1,233 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_top_frames_writer.h"
+
+#include <windows.h>
+#include <dbghelp.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_extensions.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/test/minidump_file_writer_test_util.h"
+#include "minidump/test/minidump_string_writer_test_util.h"
+#include "minidump/test/minidump_writable_test_util.h"
+#include "snapshot/test/test_cpu_context.h"
+#include "snapshot/test/test_exception_snapshot.h"
+#include "snapshot/test/test_module_snapshot.h"
+#include "snapshot/test/test_process_snapshot.h"
+#include "snapshot/test/test_system_snapshot.h"
+#include "snapshot/test/test_thread_snapshot.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr uint64_t kThreadID = 0x1234;
+
+// Returns the frames of the top frames stream in |file_contents|, or nullptr
+// if there is none, with the list header in |frame_list|.
+const MinidumpCrashpadTopFrame* GetTopFrames(
+    const std::string& file_contents,
+    const MinidumpCrashpadTopFrameList** frame_list) {
+  const MINIDUMP_DIRECTORY* directory;
+  const MINIDUMP_HEADER* header =
+      MinidumpHeaderAtStart(file_contents, &directory);
+  EXPECT_TRUE(header);
+  if (!header || !directory) {
+    return nullptr;
+  }
+
+  for (size_t index = 0; index < header->NumberOfStreams; ++index) {
+    if (directory[index].StreamType == kMinidumpStreamTypeCrashpadTopFrames) {
+      *frame_list =
+          MinidumpWritableAtLocationDescriptor<MinidumpCrashpadTopFrameList>(
+              file_contents, directory[index].Location);
+      if (!*frame_list) {
+        return nullptr;
+      }
+      EXPECT_EQ(directory[index].Location.DataSize,
+                sizeof(MinidumpCrashpadTopFrameList) +
+                    (*frame_list)->count * sizeof(MinidumpCrashpadTopFrame));
+      return reinterpret_cast<const MinidumpCrashpadTopFrame*>(*frame_list +
+                                                               1);
+    }
+  }
+
+  return nullptr;
+}
+
+std::vector<TopFrame> MakeFrames() {
+  std::vector<TopFrame> frames(3);
+  frames[0].address = 0x7fff90000123;
+  frames[0].module_index = 0;
+  frames[0].module_offset = 0x123;
+  frames[0].symbol = "abort";
+  frames[0].symbol_offset = 0x23;
+  frames[1].address = 0x7fff90001000;
+  frames[1].module_index = 0;
+  frames[1].module_offset = 0x1000;
+  frames[2].address = 0x4000;
+  return frames;
+}
+
+void ExpectFrames(const std::string& file_contents,
+                  const MinidumpCrashpadTopFrame* frames) {
+  EXPECT_EQ(frames[0].address, 0x7fff90000123u);
+  EXPECT_EQ(frames[0].module_index, 0u);
+  EXPECT_EQ(frames[0].module_offset, 0x123u);
+  EXPECT_EQ(MinidumpUTF8StringAtRVAAsString(file_contents,
+                                            frames[0].symbol_name),
+            "abort");
+  EXPECT_EQ(frames[0].symbol_offset, 0x23u);
+
+  EXPECT_EQ(frames[1].address, 0x7fff90001000u);
+  EXPECT_EQ(frames[1].module_index, 0u);
+  EXPECT_EQ(frames[1].module_offset, 0x1000u);
+  EXPECT_EQ(frames[1].symbol_name, 0u);
+  EXPECT_EQ(frames[1].symbol_offset, 0u);
+
+  EXPECT_EQ(frames[2].address, 0x4000u);
+  EXPECT_EQ(frames[2].module_index, MinidumpCrashpadTopFrame::kNoModule);
+  EXPECT_EQ(frames[2].module_offset, 0u);
+  EXPECT_EQ(frames[2].symbol_name, 0u);
+}
+
+void PopulateProcessSnapshot(TestProcessSnapshot* process_snapshot,
+                             bool with_exception) {
+  auto system_snapshot = base::WrapUnique(new TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemMacOSX);
+  process_snapshot->SetSystem(std::move(system_snapshot));
+
+  auto thread_snapshot = base::WrapUnique(new TestThreadSnapshot());
+  thread_snapshot->SetThreadID(kThreadID);
+  InitializeCPUContextX86_64(thread_snapshot->MutableContext(), 5);
+  process_snapshot->AddThread(std::move(thread_snapshot));
+
+  if (with_exception) {
+    auto exception_snapshot = base::WrapUnique(new TestExceptionSnapshot());
+    exception_snapshot->SetThreadID(kThreadID);
+    InitializeCPUContextX86_64(exception_snapshot->MutableContext(), 11);
+    process_snapshot->SetException(std::move(exception_snapshot));
+  }
+
+  auto module_snapshot = base::WrapUnique(new TestModuleSnapshot());
+  module_snapshot->SetName("/lib/libc.so.6");
+  module_snapshot->SetAddressAndSize(0x7fff90000000, 0x2000);
+  process_snapshot->AddModule(std::move(module_snapshot));
+}
+
+TEST(MinidumpTopFramesWriter, Empty) {
+  MinidumpThreadIDMap thread_id_map;
+  thread_id_map[kThreadID] = 1;
+  auto top_frames_writer = base::WrapUnique(new MinidumpTopFramesWriter());
+  top_frames_writer->InitializeFromFrames(
+      kThreadID, std::vector<TopFrame>(), thread_id_map);
+  EXPECT_FALSE(top_frames_writer->IsUseful());
+
+  MinidumpFileWriter minidump_file_writer;
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(top_frames_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpCrashpadTopFrameList* frame_list = nullptr;
+  ASSERT_TRUE(GetTopFrames(string_file.string(), &frame_list));
+  EXPECT_EQ(frame_list->version, MinidumpCrashpadTopFrameList::kVersion);
+  EXPECT_EQ(frame_list->thread_id, 1u);
+  EXPECT_EQ(frame_list->count, 0u);
+}
+
+TEST(MinidumpTopFramesWriter, Frames) {
+  MinidumpThreadIDMap thread_id_map;
+  thread_id_map[kThreadID] = 1;
+  auto top_frames_writer = base::WrapUnique(new MinidumpTopFramesWriter());
+  top_frames_writer->InitializeFromFrames(
+      kThreadID, MakeFrames(), thread_id_map);
+  EXPECT_TRUE(top_frames_writer->IsUseful());
+
+  MinidumpFileWriter minidump_file_writer;
+  ASSERT_TRUE(minidump_file_writer.AddStream(std::move(top_frames_writer)));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpCrashpadTopFrameList* frame_list = nullptr;
+  const MinidumpCrashpadTopFrame* frames =
+      GetTopFrames(string_file.string(), &frame_list);
+  ASSERT_TRUE(frames);
+  EXPECT_EQ(frame_list->thread_id, 1u);
+  ASSERT_EQ(frame_list->count, 3u);
+  ExpectFrames(string_file.string(), frames);
+}
+
+TEST(MinidumpTopFramesWriter, InitializeFromSnapshot) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshot(&process_snapshot, true);
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetTopFrames(MakeFrames());
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpCrashpadTopFrameList* frame_list = nullptr;
+  const MinidumpCrashpadTopFrame* frames =
+      GetTopFrames(string_file.string(), &frame_list);
+  ASSERT_TRUE(frames);
+  EXPECT_EQ(frame_list->thread_id, kThreadID);
+  ASSERT_EQ(frame_list->count, 3u);
+  ExpectFrames(string_file.string(), frames);
+}
+
+TEST(MinidumpTopFramesWriter, NoException) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshot(&process_snapshot, false);
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.SetTopFrames(MakeFrames());
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpCrashpadTopFrameList* frame_list = nullptr;
+  EXPECT_FALSE(GetTopFrames(string_file.string(), &frame_list));
+}
+
+TEST(MinidumpTopFramesWriter, NotRequested) {
+  TestProcessSnapshot process_snapshot;
+  PopulateProcessSnapshot(&process_snapshot, true);
+
+  MinidumpFileWriter minidump_file_writer;
+  minidump_file_writer.InitializeFromSnapshot(&process_snapshot);
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  const MinidumpCrashpadTopFrameList* frame_list = nullptr;
+  EXPECT_FALSE(GetTopFrames(string_file.string(), &frame_list));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -25,6 +25,18 @@
 namespace crashpad {
 
 //! \brief Describes a user extension data stream in a minidump.
+//!
+//! The size of the stream is obtained from StreamDataSize() when the layout of
+//! the minidump is determined, before any data is written. Its data is
+//! obtained from ReadStreamData() later, as it is written, and is passed
+//! straight to the minidump file. A data source need not hold its data in
+//! memory to know its size: see MinidumpFileExtensionStreamDataSource and
+//! MinidumpMemoryExtensionStreamDataSource.
+//!
+//! A data source that cannot know its exact size in advance may reserve an
+//! upper bound with StreamDataSize() and supply less data when it is read.
+//! The rest of the space reserved is filled with zeroes. Supplying more data
+//! than was reserved is an error.
 class MinidumpUserExtensionStreamDataSource {
  public:
   //! \brief An interface implemented by readers of
@@ -58,7 +70,8 @@ class MinidumpUserExtensionStreamDataSource {
 
   MinidumpStreamType stream_type() const { return stream_type_; }
 
-  //! \brief The size of this data stream.
+  //! \brief The size of this data stream, or the most data that
+  //!     ReadStreamData() will supply.
   virtual size_t StreamDataSize() = 0;
 
   //! \brief Calls Delegate::UserStreamDataSourceRead(), providing it with
@@ -66,7 +79,9 @@ class MinidumpUserExtensionStreamDataSource {
   //!
   //! Implementations do not necessarily compute the stream data prior to
   //! this method being called. The stream data may be computed or loaded
-  //! lazily and may be discarded after being passed to the delegate.
+  //! lazily and may be discarded after being passed to the delegate. It may be
+  //! passed in any number of calls to the delegate, which together must not
+  //! exceed StreamDataSize().
   //!
   //! \return `false` on failure, otherwise, the return value of
   //!     Delegate::ExtensionStreamDataSourceRead(), which should be `true` on
@@ -14,6 +14,10 @@
 
 #include "minidump/minidump_user_stream_writer.h"
 
+#include <stdint.h>
+
+#include <algorithm>
+
 #include "base/memory/ptr_util.h"
 #include "util/file/file_writer.h"
 
@@ -62,24 +66,49 @@ class MinidumpUserStreamWriter::ExtensionStreamContentsWriter final
  public:
   explicit ExtensionStreamContentsWriter(
       std::unique_ptr<MinidumpUserExtensionStreamDataSource> data_source)
-      : data_source_(std::move(data_source)), writer_(nullptr) {}
+      : data_source_(std::move(data_source)),
+        writer_(nullptr),
+        size_(0),
+        size_written_(0) {}
 
   bool WriteContents(FileWriterInterface* writer) override {
     DCHECK(!writer_);
 
     writer_ = writer;
-    return data_source_->ReadStreamData(this);
+    size_ = data_source_->StreamDataSize();
+    if (!data_source_->ReadStreamData(this)) {
+      return false;
+    }
+
+    // The data source may have reserved more space than it used. The layout
+    // of the rest of the file depends on the space reserved, so it is filled.
+    static constexpr uint8_t kZeroes[4096] = {};
+    while (size_written_ < size_) {
+      const size_t fill = std::min(size_ - size_written_, sizeof(kZeroes));
+      if (!writer_->Write(kZeroes, fill)) {
+        return false;
+      }
+      size_written_ += fill;
+    }
+    return true;
   }
 
   size_t GetSize() const override { return data_source_->StreamDataSize(); }
 
   bool ExtensionStreamDataSourceRead(const void* data, size_t size) override {
+    if (size > size_ - size_written_) {
+      LOG(ERROR) << "extension stream data exceeds its size " << size_;
+      return false;
+    }
+    size_written_ += size;
     return writer_->Write(data, size);
   }
 
  private:
   std::unique_ptr<MinidumpUserExtensionStreamDataSource> data_source_;
   FileWriterInterface* writer_;
+  size_t size_;
+  size_t size_written_;
 
   DISALLOW_COPY_AND_ASSIGN(ExtensionStreamContentsWriter);
 };
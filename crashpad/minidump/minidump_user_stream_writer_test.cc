@@ -19,7 +19,9 @@
 
 #include "base/memory/ptr_util.h"
 #include "gtest/gtest.h"
+#include "minidump/minidump_file_extension_stream_data_source.h"
 #include "minidump/minidump_file_writer.h"
+#include "minidump/minidump_memory_extension_stream_data_source.h"
 #include "minidump/test/minidump_file_writer_test_util.h"
 #include "minidump/test/minidump_user_extension_stream_util.h"
 #include "minidump/test/minidump_writable_test_util.h"
@@ -147,6 +149,109 @@ TEST(MinidumpUserStreamWriter, InitializeFromBufferOneStream) {
   EXPECT_EQ(stream_data, std::string(kStreamSize, 'c'));
 }
 
+// Writes a minidump with the stream from data_source, and returns the
+// stream’s data.
+void WriteExtensionStream(
+    std::unique_ptr<MinidumpUserExtensionStreamDataSource> data_source,
+    size_t stream_size,
+    std::string* stream_data) {
+  MinidumpFileWriter minidump_file_writer;
+  auto user_stream_writer = base::WrapUnique(new MinidumpUserStreamWriter());
+  user_stream_writer->InitializeFromUserExtensionStream(std::move(data_source));
+  minidump_file_writer.AddStream(std::move(user_stream_writer));
+
+  StringFile string_file;
+  ASSERT_TRUE(minidump_file_writer.WriteEverything(&string_file));
+
+  ASSERT_EQ(string_file.string().size(),
+            sizeof(MINIDUMP_HEADER) + sizeof(MINIDUMP_DIRECTORY) + stream_size);
+
+  MINIDUMP_LOCATION_DESCRIPTOR user_stream_location = {};
+  ASSERT_NO_FATAL_FAILURE(GetUserStream(
+      string_file.string(), &user_stream_location, kTestStreamId, stream_size));
+  *stream_data = string_file.string().substr(user_stream_location.Rva,
+                                             user_stream_location.DataSize);
+}
+
+TEST(MinidumpUserStreamWriter, InitializeFromMemoryOneStream) {
+  constexpr size_t kStreamSize = 128;
+  const std::string data(kStreamSize, 'm');
+
+  std::string stream_data;
+  ASSERT_NO_FATAL_FAILURE(WriteExtensionStream(
+      base::WrapUnique(new MinidumpMemoryExtensionStreamDataSource(
+          kTestStreamId, data.data(), data.size())),
+      kStreamSize,
+      &stream_data));
+  EXPECT_EQ(stream_data, data);
+}
+
+TEST(MinidumpUserStreamWriter, InitializeFromFileOneStream) {
+  // Large enough to be read in several chunks.
+  constexpr size_t kStreamSize = 200000;
+  std::string data;
+  for (size_t index = 0; index < kStreamSize; ++index) {
+    data.push_back(static_cast<char>(index % 251));
+  }
+
+  std::unique_ptr<StringFile> file(new StringFile());
+  file->SetString(data);
+  std::unique_ptr<MinidumpFileExtensionStreamDataSource> data_source =
+      MinidumpFileExtensionStreamDataSource::CreateForFile(kTestStreamId,
+                                                           std::move(file));
+  ASSERT_TRUE(data_source);
+  EXPECT_EQ(data_source->StreamDataSize(), kStreamSize);
+
+  std::string stream_data;
+  ASSERT_NO_FATAL_FAILURE(WriteExtensionStream(
+      std::move(data_source), kStreamSize, &stream_data));
+  EXPECT_EQ(stream_data, data);
+}
+
+TEST(MinidumpUserStreamWriter, ReservedSpaceFilled) {
+  // The file supplies less data than the size reserved for it.
+  std::unique_ptr<StringFile> file(new StringFile());
+  file->SetString("0123456789");
+
+  constexpr size_t kStreamSize = 16;
+  std::string stream_data;
+  ASSERT_NO_FATAL_FAILURE(WriteExtensionStream(
+      base::WrapUnique(new MinidumpFileExtensionStreamDataSource(
+          kTestStreamId, std::move(file), 2, kStreamSize)),
+      kStreamSize,
+      &stream_data));
+  EXPECT_EQ(stream_data, std::string("23456789") + std::string(8, '\0'));
+}
+
+// Supplies more data than it reserves.
+class OversizedExtensionStreamDataSource final
+    : public MinidumpUserExtensionStreamDataSource {
+ public:
+  OversizedExtensionStreamDataSource()
+      : MinidumpUserExtensionStreamDataSource(kTestStreamId) {}
+
+  size_t StreamDataSize() override { return 4; }
+
+  bool ReadStreamData(Delegate* delegate) override {
+    return delegate->ExtensionStreamDataSourceRead("0123", 4) &&
+           delegate->ExtensionStreamDataSourceRead("4", 1);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(OversizedExtensionStreamDataSource);
+};
+
+TEST(MinidumpUserStreamWriter, OversizedStream) {
+  MinidumpFileWriter minidump_file_writer;
+  auto user_stream_writer = base::WrapUnique(new MinidumpUserStreamWriter());
+  user_stream_writer->InitializeFromUserExtensionStream(
+      base::WrapUnique(new OversizedExtensionStreamDataSource()));
+  minidump_file_writer.AddStream(std::move(user_stream_writer));
+
+  StringFile string_file;
+  EXPECT_FALSE(minidump_file_writer.WriteEverything(&string_file));
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
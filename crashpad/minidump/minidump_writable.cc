@@ -16,50 +16,153 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <memory>
+#include <new>
+
 #include "base/logging.h"
+#include "base/synchronization/lock.h"
+#include "minidump/minidump_writable_arena.h"
 #include "util/file/file_writer.h"
+#include "util/file/string_file.h"
 #include "util/numeric/safe_assignment.h"
+#include "util/stdlib/pointer_container.h"
+#include "util/thread/thread.h"
 
 namespace {
 
 constexpr size_t kMaximumAlignment = 16;
 
+// The most data that WriteSequenceConcurrently() will hold in memory at once,
+// unless a single object is larger than this.
+constexpr size_t kConcurrentWriteBatchSize = 16 * 1024 * 1024;
+
+// Every MinidumpWritable allocation is preceded by this header, which records
+// the arena that it belongs to. It’s padded to preserve the alignment that
+// operator new would otherwise provide.
+struct alignas(kMaximumAlignment) AllocationHeader {
+  crashpad::internal::MinidumpWritableArena* arena;  // weak
+};
+
 }  // namespace
 
 namespace crashpad {
 namespace internal {
 
+// Serializes objects from a shared batch, each into its own buffer, until
+// none remain.
+class MinidumpWritable::ConcurrentWriteThread final : public Thread {
+ public:
+  ConcurrentWriteThread(const std::vector<MinidumpWritable*>* write_sequence,
+                        PointerVector<StringFile>* buffers,
+                        size_t batch_start,
+                        size_t* next_index,
+                        bool* failed,
+                        base::Lock* lock)
+      : Thread(),
+        write_sequence_(write_sequence),
+        buffers_(buffers),
+        batch_start_(batch_start),
+        next_index_(next_index),
+        failed_(failed),
+        lock_(lock) {}
+
+  ~ConcurrentWriteThread() override {}
+
+ private:
+  // Thread:
+  void ThreadMain() override {
+    while (true) {
+      size_t index;
+      {
+        base::AutoLock lock_owner(*lock_);
+        if (*failed_ || *next_index_ == batch_start_ + buffers_->size()) {
+          return;
+        }
+        index = (*next_index_)++;
+      }
+
+      if (!(*write_sequence_)[index]->WritePaddingAndObject(
+              (*buffers_)[index - batch_start_])) {
+        base::AutoLock lock_owner(*lock_);
+        *failed_ = true;
+        return;
+      }
+    }
+  }
+
+  const std::vector<MinidumpWritable*>* write_sequence_;  // weak
+  PointerVector<StringFile>* buffers_;  // weak
+  size_t batch_start_;
+  size_t* next_index_;  // weak
+  bool* failed_;  // weak
+  base::Lock* lock_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentWriteThread);
+};
+
 MinidumpWritable::~MinidumpWritable() {
 }
 
-bool MinidumpWritable::WriteEverything(FileWriterInterface* file_writer) {
-  DCHECK_EQ(state_, kStateMutable);
+// static
+void* MinidumpWritable::operator new(size_t size) {
+  MinidumpWritableArena* arena = MinidumpWritableArena::Current();
+  size_t allocation_size = sizeof(AllocationHeader) + size;
+  void* allocation = arena ? arena->Allocate(allocation_size)
+                           : ::operator new(allocation_size);
+  AllocationHeader* header = new (allocation) AllocationHeader();
+  header->arena = arena;
+  return header + 1;
+}
 
-  if (!Freeze()) {
-    return false;
+// static
+void MinidumpWritable::operator delete(void* pointer) {
+  if (!pointer) {
+    return;
   }
 
-  DCHECK_EQ(state_, kStateFrozen);
+  AllocationHeader* header = static_cast<AllocationHeader*>(pointer) - 1;
+  MinidumpWritableArena* arena = header->arena;
+  header->~AllocationHeader();
+  if (arena) {
+    arena->Release(header);
+  } else {
+    ::operator delete(header);
+  }
+}
 
-  FileOffset offset = 0;
+bool MinidumpWritable::WriteEverything(FileWriterInterface* file_writer) {
+  return WriteTree(file_writer, 1);
+}
+
+bool MinidumpWritable::WriteTree(FileWriterInterface* file_writer,
+                                 size_t thread_count) {
   std::vector<MinidumpWritable*> write_sequence;
-  size_t size = WillWriteAtOffset(kPhaseEarly, &offset, &write_sequence);
-  if (size == kInvalidSize) {
+  FileOffset size;
+  if (!LayOutTree(&write_sequence, &size)) {
     return false;
   }
 
-  offset += size;
-  if (WillWriteAtOffset(kPhaseLate, &offset, &write_sequence) == kInvalidSize) {
-    return false;
-  }
+  return WriteLaidOutTree(write_sequence, file_writer, thread_count);
+}
 
+bool MinidumpWritable::WriteLaidOutTree(
+    const std::vector<MinidumpWritable*>& write_sequence,
+    FileWriterInterface* file_writer,
+    size_t thread_count) {
   DCHECK_EQ(state_, kStateWritable);
   DCHECK_EQ(write_sequence.front(), this);
 
-  for (MinidumpWritable* writable : write_sequence) {
-    if (!writable->WritePaddingAndObject(file_writer)) {
+  if (thread_count > 1) {
+    if (!WriteSequenceConcurrently(write_sequence, file_writer, thread_count)) {
       return false;
     }
+  } else {
+    for (MinidumpWritable* writable : write_sequence) {
+      if (!writable->WritePaddingAndObject(file_writer)) {
+        return false;
+      }
+    }
   }
 
   DCHECK_EQ(state_, kStateWritten);
@@ -67,12 +170,49 @@ bool MinidumpWritable::WriteEverything(FileWriterInterface* file_writer) {
   return true;
 }
 
+bool MinidumpWritable::LayOutTree(
+    std::vector<MinidumpWritable*>* write_sequence,
+    FileOffset* size) {
+  DCHECK_EQ(state_, kStateMutable);
+  DCHECK(write_sequence->empty());
+
+  if (!Freeze()) {
+    return false;
+  }
+
+  DCHECK_EQ(state_, kStateFrozen);
+
+  FileOffset offset = 0;
+  size_t early_size = WillWriteAtOffset(kPhaseEarly, &offset, write_sequence);
+  if (early_size == kInvalidSize) {
+    return false;
+  }
+
+  offset += early_size;
+  size_t late_size = WillWriteAtOffset(kPhaseLate, &offset, write_sequence);
+  if (late_size == kInvalidSize) {
+    return false;
+  }
+
+  DCHECK_EQ(state_, kStateWritable);
+  DCHECK_EQ(write_sequence->front(), this);
+
+  *size = offset + late_size;
+  return true;
+}
+
 void MinidumpWritable::RegisterRVA(RVA* rva) {
   DCHECK_LE(state_, kStateFrozen);
 
   registered_rvas_.push_back(rva);
 }
 
+void MinidumpWritable::RegisterRVA(RVA64* rva64) {
+  DCHECK_LE(state_, kStateFrozen);
+
+  registered_rva64s_.push_back(rva64);
+}
+
 void MinidumpWritable::RegisterLocationDescriptor(
     MINIDUMP_LOCATION_DESCRIPTOR* location_descriptor) {
   DCHECK_LE(state_, kStateFrozen);
@@ -80,9 +220,33 @@ void MinidumpWritable::RegisterLocationDescriptor(
   registered_location_descriptors_.push_back(location_descriptor);
 }
 
+void MinidumpWritable::TransferRegistrationsTo(MinidumpWritable* other) {
+  DCHECK_EQ(state_, kStateFrozen);
+  DCHECK_EQ(other->state_, kStateFrozen);
+  DCHECK_NE(other, this);
+
+  other->registered_rvas_.insert(other->registered_rvas_.end(),
+                                 registered_rvas_.begin(),
+                                 registered_rvas_.end());
+  registered_rvas_.clear();
+
+  other->registered_rva64s_.insert(other->registered_rva64s_.end(),
+                                   registered_rva64s_.begin(),
+                                   registered_rva64s_.end());
+  registered_rva64s_.clear();
+
+  other->registered_location_descriptors_.insert(
+      other->registered_location_descriptors_.end(),
+      registered_location_descriptors_.begin(),
+      registered_location_descriptors_.end());
+  registered_location_descriptors_.clear();
+}
+
 MinidumpWritable::MinidumpWritable()
     : registered_rvas_(),
+      registered_rva64s_(),
       registered_location_descriptors_(),
+      children_(),
       leading_pad_bytes_(0),
       state_(kStateMutable) {
 }
@@ -162,6 +326,10 @@ size_t MinidumpWritable::WillWriteAtOffset(
     // this one. Typically, a parent object will have registered to point to its
     // children, but this can also occur where no parent-child relationship
     // exists.
+    for (RVA64* rva64 : registered_rva64s_) {
+      *rva64 = static_cast<RVA64>(local_offset);
+    }
+
     if (!registered_rvas_.empty() ||
         !registered_location_descriptors_.empty()) {
       RVA local_rva;
@@ -207,11 +375,18 @@ size_t MinidumpWritable::WillWriteAtOffset(
     leading_pad_bytes_this_phase = 0;
   }
 
+  // An object’s children can’t change once it’s frozen, so there’s no need to
+  // build the list again for the late phase. Implementations of Children()
+  // construct a new vector on each call, which adds up in a tree with many
+  // threads, modules, or memory ranges.
+  if (phase == kPhaseEarly) {
+    children_ = Children();
+  }
+
   // Loop over children regardless of whether this object itself will write
   // during this phase. An object’s children are not required to be written
   // during the same phase as their parent.
-  std::vector<MinidumpWritable*> children = Children();
-  for (MinidumpWritable* child : children) {
+  for (MinidumpWritable* child : children_) {
     // Use “auto” here because it’s impossible to know whether size_t (size) or
     // FileOffset (local_offset) is the wider type, and thus what type the
     // result of adding these two variables will have.
@@ -260,5 +435,76 @@ bool MinidumpWritable::WritePaddingAndObject(FileWriterInterface* file_writer) {
   return true;
 }
 
+// static
+bool MinidumpWritable::WriteSequenceConcurrently(
+    const std::vector<MinidumpWritable*>& write_sequence,
+    FileWriterInterface* file_writer,
+    size_t thread_count) {
+  size_t batch_start = 0;
+  while (batch_start < write_sequence.size()) {
+    // Gather as many objects as fit within kConcurrentWriteBatchSize, but
+    // always at least one.
+    size_t batch_end = batch_start;
+    size_t batch_size = 0;
+    while (batch_end < write_sequence.size()) {
+      size_t object_size = write_sequence[batch_end]->SizeOfObject() +
+                           write_sequence[batch_end]->leading_pad_bytes_;
+      if (batch_end != batch_start &&
+          batch_size + object_size > kConcurrentWriteBatchSize) {
+        break;
+      }
+      batch_size += object_size;
+      ++batch_end;
+    }
+
+    // An object alone in its batch gains nothing from being serialized on
+    // another thread, and may be too large to buffer, as the memory of a
+    // MINIDUMP_MEMORY64_LIST can be. It’s written directly instead.
+    if (batch_end == batch_start + 1) {
+      if (!write_sequence[batch_start]->WritePaddingAndObject(file_writer)) {
+        return false;
+      }
+      batch_start = batch_end;
+      continue;
+    }
+
+    PointerVector<StringFile> buffers;
+    for (size_t index = batch_start; index < batch_end; ++index) {
+      buffers.push_back(new StringFile());
+    }
+
+    size_t next_index = batch_start;
+    bool failed = false;
+    base::Lock lock;
+
+    PointerVector<ConcurrentWriteThread> threads;
+    size_t batch_thread_count =
+        std::min(thread_count, batch_end - batch_start);
+    for (size_t index = 0; index < batch_thread_count; ++index) {
+      threads.push_back(new ConcurrentWriteThread(
+          &write_sequence, &buffers, batch_start, &next_index, &failed, &lock));
+      threads.back()->Start();
+    }
+    for (ConcurrentWriteThread* thread : threads) {
+      thread->Join();
+    }
+
+    if (failed) {
+      return false;
+    }
+
+    for (StringFile* buffer : buffers) {
+      const std::string& data = buffer->string();
+      if (!data.empty() && !file_writer->Write(data.data(), data.size())) {
+        return false;
+      }
+    }
+
+    batch_start = batch_end;
+  }
+
+  return true;
+}
+
 }  // namespace internal
 }  // namespace crashpad
@@ -37,6 +37,16 @@ class MinidumpWritable {
  public:
   virtual ~MinidumpWritable();
 
+  //! \brief Allocates storage for a MinidumpWritable object.
+  //!
+  //! If a MinidumpWritableArena is current on the calling thread, the object is
+  //! allocated from it. Otherwise, it is allocated from the heap.
+  static void* operator new(size_t size);
+
+  //! \brief Releases storage obtained from operator new(), to the arena that
+  //!     it was allocated from, if any.
+  static void operator delete(void* pointer);
+
   //! \brief Writes an object and all of its children to a minidump file.
   //!
   //! Use this on the root object of a tree of MinidumpWritable objects,
@@ -69,6 +79,15 @@ class MinidumpWritable {
   // to be able to register their own pointers with distinct objects.
   void RegisterRVA(RVA* rva);
 
+  //! \brief Registers a 64-bit file offset pointer as one that should point to
+  //!     the object on which this method is called.
+  //!
+  //! This behaves identically to RegisterRVA(RVA*), for structures that refer
+  //! to other objects by RVA64.
+  //!
+  //! \note Valid in #kStateFrozen or any preceding state.
+  void RegisterRVA(RVA64* rva64);
+
   //! \brief Registers a location descriptor as one that should point to the
   //!     object on which this method is called.
   //!
@@ -87,6 +106,16 @@ class MinidumpWritable {
   void RegisterLocationDescriptor(
       MINIDUMP_LOCATION_DESCRIPTOR* location_descriptor);
 
+  //! \brief Moves all registered RVAs and location descriptors from the object
+  //!     on which this method is called to \a other.
+  //!
+  //! Once moved, the pointers will be updated to refer to \a other instead of
+  //! this object. This is used to make several references share a single copy
+  //! of identical content.
+  //!
+  //! \note Valid in #kStateFrozen, in which \a other must also be.
+  void TransferRegistrationsTo(MinidumpWritable* other);
+
  protected:
   //! \brief Identifies the state of an object.
   //!
@@ -142,6 +171,73 @@ class MinidumpWritable {
   //! \brief The state of the object.
   State state() const { return state_; }
 
+  //! \brief Writes an object and all of its children to a minidump file,
+  //!     optionally serializing objects on multiple threads.
+  //!
+  //! This implements WriteEverything(). The layout of the entire tree is
+  //! determined before anything is written. When \a thread_count is greater
+  //! than `1`, objects are then serialized concurrently into in-memory buffers
+  //! in bounded batches, and each batch is written to \a file_writer in file
+  //! order. This allows slow WriteObject() implementations, such as those that
+  //! read memory from another process, to proceed in parallel, while
+  //! \a file_writer still receives a single sequential stream of data.
+  //!
+  //! WriteObject() implementations must be safe to call concurrently on
+  //! distinct objects when \a thread_count is greater than `1`.
+  //!
+  //! \param[in] file_writer The file writer to receive the minidump file’s
+  //!     content.
+  //! \param[in] thread_count The number of threads to serialize objects on.
+  //!     `0` is treated as `1`.
+  //!
+  //! \return `true` on success. `false` on failure, with an appropriate message
+  //!     logged.
+  //!
+  //! \note Valid in #kStateMutable, and transitions the object and the entire
+  //!     tree beneath it through all states to #kStateWritten.
+  bool WriteTree(FileWriterInterface* file_writer, size_t thread_count);
+
+  //! \brief Determines the layout of an object and all of its children in a
+  //!     minidump file, without writing anything.
+  //!
+  //! This is the first part of WriteTree(). It may be used on its own to
+  //! determine how large a minidump file would be.
+  //!
+  //! \param[out] write_sequence The objects in the tree, in the order that
+  //!     they are to be written.
+  //! \param[out] size The total size of the tree once written, including
+  //!     padding, in bytes.
+  //!
+  //! \return `true` on success. `false` on failure, with an appropriate message
+  //!     logged.
+  //!
+  //! \note Valid in #kStateMutable, and transitions the object and the entire
+  //!     tree beneath it to #kStateWritable.
+  bool LayOutTree(std::vector<MinidumpWritable*>* write_sequence,
+                  FileOffset* size);
+
+  //! \brief Writes the objects of a tree that has been laid out by
+  //!     LayOutTree(), optionally serializing them on multiple threads.
+  //!
+  //! This is the second part of WriteTree(). Calling it separately allows the
+  //! size of the tree to be acted upon before anything is written.
+  //!
+  //! \param[in] write_sequence The objects in the tree, as produced by
+  //!     LayOutTree().
+  //! \param[in] file_writer The file writer to receive the minidump file’s
+  //!     content.
+  //! \param[in] thread_count The number of threads to serialize objects on, as
+  //!     for WriteTree().
+  //!
+  //! \return `true` on success. `false` on failure, with an appropriate message
+  //!     logged.
+  //!
+  //! \note Valid in #kStateWritable, and transitions the object and the entire
+  //!     tree beneath it to #kStateWritten.
+  bool WriteLaidOutTree(const std::vector<MinidumpWritable*>& write_sequence,
+                        FileWriterInterface* file_writer,
+                        size_t thread_count);
+
   //! \brief Transitions the object from #kStateMutable to #kStateFrozen.
   //!
   //! The default implementation marks the object as frozen and recursively
@@ -263,11 +359,25 @@ class MinidumpWritable {
   virtual bool WriteObject(FileWriterInterface* file_writer) = 0;
 
  private:
+  class ConcurrentWriteThread;
+
+  //! \brief Writes \a write_sequence, as produced by WillWriteAtOffset(), to
+  //!     \a file_writer, serializing objects on \a thread_count threads.
+  static bool WriteSequenceConcurrently(
+      const std::vector<MinidumpWritable*>& write_sequence,
+      FileWriterInterface* file_writer,
+      size_t thread_count);
+
   std::vector<RVA*> registered_rvas_;  // weak
+  std::vector<RVA64*> registered_rva64s_;  // weak
 
   // weak
   std::vector<MINIDUMP_LOCATION_DESCRIPTOR*> registered_location_descriptors_;
 
+  // The result of Children(), obtained by WillWriteAtOffset() during the early
+  // phase and reused during the late phase.
+  std::vector<MinidumpWritable*> children_;  // weak
+
   size_t leading_pad_bytes_;
   State state_;
 
@@ -0,0 +1,146 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_writable_arena.h"
+
+#include <utility>
+
+#include "base/logging.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace crashpad {
+namespace internal {
+
+namespace {
+
+constexpr size_t kAllocationAlignment = 16;
+
+// Objects are carved out of chunks of this size. An object too large to fit
+// comfortably gets a chunk of its own.
+constexpr size_t kChunkSize = 64 * 1024;
+
+class CurrentArenaSlot {
+ public:
+  static CurrentArenaSlot* GetInstance() {
+    static auto slot = new CurrentArenaSlot();
+    return slot;
+  }
+
+  MinidumpWritableArena* Get() {
+    return reinterpret_cast<MinidumpWritableArena*>(tls_.Get());
+  }
+
+  void Set(MinidumpWritableArena* arena) { tls_.Set(arena); }
+
+ private:
+  CurrentArenaSlot() {
+    DCHECK(!tls_.initialized());
+    tls_.Initialize(nullptr);
+    DCHECK(tls_.initialized());
+  }
+
+  ~CurrentArenaSlot() = delete;
+
+  static base::ThreadLocalStorage::StaticSlot tls_;
+
+  DISALLOW_COPY_AND_ASSIGN(CurrentArenaSlot);
+};
+
+// static
+base::ThreadLocalStorage::StaticSlot CurrentArenaSlot::tls_ = TLS_INITIALIZER;
+
+}  // namespace
+
+MinidumpWritableArena::MinidumpWritableArena()
+    : chunks_(),
+      large_chunks_(),
+      current_chunk_used_(0),
+      live_allocations_(0) {
+}
+
+MinidumpWritableArena::~MinidumpWritableArena() {
+  DCHECK_EQ(live_allocations_, 0u);
+  DCHECK_NE(Current(), this);
+}
+
+void* MinidumpWritableArena::Allocate(size_t size) {
+  size = (size + kAllocationAlignment - 1) & ~(kAllocationAlignment - 1);
+
+  ++live_allocations_;
+
+  if (size > kChunkSize / 4) {
+    // Give large objects storage of their own, leaving the remainder of the
+    // current chunk available for small objects.
+    Chunk chunk;
+    chunk.data.reset(new uint8_t[size]);
+    chunk.size = size;
+    uint8_t* allocation = chunk.data.get();
+    large_chunks_.push_back(std::move(chunk));
+    return allocation;
+  }
+
+  if (chunks_.empty() || current_chunk_used_ + size > chunks_.back().size) {
+    Chunk chunk;
+    chunk.data.reset(new uint8_t[kChunkSize]);
+    chunk.size = kChunkSize;
+    chunks_.push_back(std::move(chunk));
+    current_chunk_used_ = 0;
+  }
+
+  uint8_t* allocation = chunks_.back().data.get() + current_chunk_used_;
+  current_chunk_used_ += size;
+  return allocation;
+}
+
+void MinidumpWritableArena::Release(void* pointer) {
+  DCHECK(Owns(pointer));
+  DCHECK_GT(live_allocations_, 0u);
+  --live_allocations_;
+}
+
+bool MinidumpWritableArena::Owns(const void* pointer) const {
+  const uint8_t* pointer_c = static_cast<const uint8_t*>(pointer);
+  for (const std::vector<Chunk>* chunks : {&chunks_, &large_chunks_}) {
+    for (const Chunk& chunk : *chunks) {
+      if (pointer_c >= chunk.data.get() &&
+          pointer_c < chunk.data.get() + chunk.size) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// static
+MinidumpWritableArena* MinidumpWritableArena::Current() {
+  return CurrentArenaSlot::GetInstance()->Get();
+}
+
+// static
+void MinidumpWritableArena::SetCurrent(MinidumpWritableArena* arena) {
+  CurrentArenaSlot::GetInstance()->Set(arena);
+}
+
+ScopedMinidumpWritableArena::ScopedMinidumpWritableArena(
+    MinidumpWritableArena* arena)
+    : previous_(MinidumpWritableArena::Current()) {
+  MinidumpWritableArena::SetCurrent(arena);
+}
+
+ScopedMinidumpWritableArena::~ScopedMinidumpWritableArena() {
+  MinidumpWritableArena::SetCurrent(previous_);
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,114 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "minidump/minidump_writable_arena.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "minidump/minidump_string_writer.h"
+#include "minidump/test/minidump_string_writer_test_util.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(MinidumpWritableArena, Allocate) {
+  internal::MinidumpWritableArena arena;
+
+  void* small_1 = arena.Allocate(1);
+  void* small_2 = arena.Allocate(24);
+  void* large = arena.Allocate(1024 * 1024);
+  void* small_3 = arena.Allocate(8);
+
+  for (void* allocation : {small_1, small_2, large, small_3}) {
+    EXPECT_TRUE(arena.Owns(allocation));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(allocation) % 16, 0u);
+  }
+
+  // Small allocations are packed together, even around a large one.
+  EXPECT_EQ(static_cast<uint8_t*>(small_2) - static_cast<uint8_t*>(small_1),
+            16);
+  EXPECT_EQ(static_cast<uint8_t*>(small_3) - static_cast<uint8_t*>(small_2),
+            32);
+
+  int not_owned;
+  EXPECT_FALSE(arena.Owns(&not_owned));
+
+  for (void* allocation : {small_1, small_2, large, small_3}) {
+    arena.Release(allocation);
+  }
+}
+
+TEST(MinidumpWritableArena, ScopedMinidumpWritableArena) {
+  EXPECT_FALSE(internal::MinidumpWritableArena::Current());
+
+  internal::MinidumpWritableArena outer_arena;
+  internal::MinidumpWritableArena inner_arena;
+  {
+    internal::ScopedMinidumpWritableArena outer_scope(&outer_arena);
+    EXPECT_EQ(internal::MinidumpWritableArena::Current(), &outer_arena);
+    {
+      internal::ScopedMinidumpWritableArena inner_scope(&inner_arena);
+      EXPECT_EQ(internal::MinidumpWritableArena::Current(), &inner_arena);
+      {
+        internal::ScopedMinidumpWritableArena heap_scope(nullptr);
+        EXPECT_FALSE(internal::MinidumpWritableArena::Current());
+      }
+      EXPECT_EQ(internal::MinidumpWritableArena::Current(), &inner_arena);
+    }
+    EXPECT_EQ(internal::MinidumpWritableArena::Current(), &outer_arena);
+  }
+  EXPECT_FALSE(internal::MinidumpWritableArena::Current());
+}
+
+TEST(MinidumpWritableArena, MinidumpWritable) {
+  const std::string kText("arena");
+
+  internal::MinidumpWritableArena arena;
+  std::unique_ptr<internal::MinidumpUTF8StringWriter> arena_writer;
+  {
+    internal::ScopedMinidumpWritableArena scoped_arena(&arena);
+    arena_writer = base::WrapUnique(new internal::MinidumpUTF8StringWriter());
+  }
+  EXPECT_TRUE(arena.Owns(arena_writer.get()));
+
+  auto heap_writer =
+      base::WrapUnique(new internal::MinidumpUTF8StringWriter());
+  EXPECT_FALSE(arena.Owns(heap_writer.get()));
+
+  // Objects allocated from an arena behave just like those allocated from the
+  // heap.
+  for (internal::MinidumpUTF8StringWriter* writer :
+       {arena_writer.get(), heap_writer.get()}) {
+    writer->SetUTF8(kText);
+
+    StringFile string_file;
+    ASSERT_TRUE(writer->WriteEverything(&string_file));
+    EXPECT_EQ(MinidumpUTF8StringAtRVAAsString(string_file.string(), 0),
+              kText);
+  }
+
+  arena_writer.reset();
+  heap_writer.reset();
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,514 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/stringprintf.h"
+#include "build/build_config.h"
+#include "minidump/minidump_file_writer.h"
+#include "minidump/minidump_memory_info_writer.h"
+#include "minidump/minidump_memory_writer.h"
+#include "minidump/minidump_misc_info_writer.h"
+#include "minidump/minidump_module_writer.h"
+#include "minidump/minidump_system_info_writer.h"
+#include "minidump/minidump_thread_id_map.h"
+#include "minidump/minidump_thread_writer.h"
+#include "snapshot/test/test_cpu_context.h"
+#include "snapshot/test/test_memory_map_region_snapshot.h"
+#include "snapshot/test/test_memory_snapshot.h"
+#include "snapshot/test/test_module_snapshot.h"
+#include "snapshot/test/test_process_snapshot.h"
+#include "snapshot/test/test_system_snapshot.h"
+#include "snapshot/test/test_thread_snapshot.h"
+#include "tools/tool_support.h"
+#include "util/file/file_writer.h"
+#include "util/misc/clock.h"
+#include "util/stdlib/string_number_conversion.h"
+
+// Every allocation made through the global operator new is counted, so that
+// changes in the number of allocations made while producing a minidump file
+// can be tracked alongside changes in time.
+namespace {
+std::atomic<uint64_t> g_allocation_count(0);
+
+void* CountedAllocate(size_t size) {
+  ++g_allocation_count;
+  void* pointer = malloc(size ? size : 1);
+  if (!pointer) {
+    abort();
+  }
+  return pointer;
+}
+}  // namespace
+
+void* operator new(size_t size) {
+  return CountedAllocate(size);
+}
+
+void* operator new[](size_t size) {
+  return CountedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  free(pointer);
+}
+
+namespace crashpad {
+namespace {
+
+// A FileWriterInterface that discards the data written to it, while recording
+// how much was written and when the first write occurred. Writing to memory or
+// to disk would add costs unrelated to the minidump writer.
+class CountingFileWriter : public FileWriterInterface {
+ public:
+  CountingFileWriter()
+      : FileWriterInterface(), position_(0), size_(0), first_write_time_(0) {}
+
+  ~CountingFileWriter() override {}
+
+  //! The value of ClockMonotonicNanoseconds() at the first write, or `0` if
+  //! nothing has been written.
+  uint64_t first_write_time() const { return first_write_time_; }
+
+  //! The number of bytes written.
+  FileOffset size() const { return size_; }
+
+  // FileWriterInterface:
+  bool Write(const void* data, size_t size) override {
+    if (!first_write_time_) {
+      first_write_time_ = ClockMonotonicNanoseconds();
+    }
+    position_ += size;
+    size_ = std::max(size_, position_);
+    return true;
+  }
+
+  bool WriteIoVec(std::vector<WritableIoVec>* iovecs) override {
+    for (const WritableIoVec& iov : *iovecs) {
+      Write(iov.iov_base, iov.iov_len);
+    }
+    return true;
+  }
+
+  // FileSeekerInterface:
+  FileOffset Seek(FileOffset offset, int whence) override {
+    switch (whence) {
+      case SEEK_SET:
+        position_ = offset;
+        break;
+      case SEEK_CUR:
+        position_ += offset;
+        break;
+      case SEEK_END:
+        position_ = size_ + offset;
+        break;
+      default:
+        return -1;
+    }
+    return position_;
+  }
+
+ private:
+  FileOffset position_;
+  FileOffset size_;
+  uint64_t first_write_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingFileWriter);
+};
+
+struct SnapshotParameters {
+  unsigned int thread_count;
+  unsigned int module_count;
+  unsigned int memory_range_count;
+  unsigned int memory_map_region_count;
+  unsigned int stack_size;
+};
+
+// Builds a process snapshot with the shape described by |parameters|. Extra
+// memory ranges cycle through a selection of sizes, from a single cache line
+// to many pages.
+void BuildProcessSnapshot(const SnapshotParameters& parameters,
+                          test::TestProcessSnapshot* process_snapshot) {
+  constexpr timeval kSnapshotTime = {0x5a000000, 0};
+  process_snapshot->SetSnapshotTime(kSnapshotTime);
+
+  auto system_snapshot = base::WrapUnique(new test::TestSystemSnapshot());
+  system_snapshot->SetCPUArchitecture(kCPUArchitectureX86_64);
+  system_snapshot->SetOperatingSystem(SystemSnapshot::kOperatingSystemWindows);
+  process_snapshot->SetSystem(std::move(system_snapshot));
+
+  constexpr uint64_t kStackBase = 0x100000000;
+  for (unsigned int index = 0; index < parameters.thread_count; ++index) {
+    auto thread_snapshot = base::WrapUnique(new test::TestThreadSnapshot());
+    test::InitializeCPUContextX86_64(thread_snapshot->MutableContext(), index);
+    thread_snapshot->SetThreadID(index + 1);
+
+    auto stack = base::WrapUnique(new test::TestMemorySnapshot());
+    stack->SetAddress(kStackBase + index * 0x100000ull);
+    stack->SetSize(parameters.stack_size);
+    stack->SetValue('s');
+    thread_snapshot->SetStack(std::move(stack));
+
+    process_snapshot->AddThread(std::move(thread_snapshot));
+  }
+
+  constexpr uint64_t kModuleBase = 0x200000000;
+  for (unsigned int index = 0; index < parameters.module_count; ++index) {
+    auto module_snapshot = base::WrapUnique(new test::TestModuleSnapshot());
+    module_snapshot->SetName(
+        base::StringPrintf("/benchmark/lib/module_%u.so", index));
+    module_snapshot->SetAddressAndSize(kModuleBase + index * 0x100000ull,
+                                       0x80000);
+    module_snapshot->SetDebugFileName(
+        base::StringPrintf("module_%u.pdb", index));
+    process_snapshot->AddModule(std::move(module_snapshot));
+  }
+
+  static constexpr size_t kMemoryRangeSizes[] = {64, 4096, 65536, 262144};
+  constexpr uint64_t kMemoryBase = 0x300000000;
+  for (unsigned int index = 0; index < parameters.memory_range_count;
+       ++index) {
+    auto memory = base::WrapUnique(new test::TestMemorySnapshot());
+    memory->SetAddress(kMemoryBase + index * 0x100000ull);
+    memory->SetSize(kMemoryRangeSizes[index % arraysize(kMemoryRangeSizes)]);
+    memory->SetValue('m');
+    process_snapshot->AddExtraMemory(std::move(memory));
+  }
+
+  constexpr uint64_t kRegionSize = 0x1000;
+  for (unsigned int index = 0; index < parameters.memory_map_region_count;
+       ++index) {
+    MINIDUMP_MEMORY_INFO memory_info = {};
+    memory_info.BaseAddress = kMemoryBase + index * kRegionSize;
+    memory_info.AllocationBase = memory_info.BaseAddress;
+    memory_info.AllocationProtect = PAGE_READWRITE;
+    memory_info.RegionSize = kRegionSize;
+    memory_info.State = MEM_COMMIT;
+    memory_info.Protect = index % 2 ? PAGE_READONLY : PAGE_READWRITE;
+    memory_info.Type = MEM_PRIVATE;
+
+    auto region = base::WrapUnique(new test::TestMemoryMapRegionSnapshot());
+    region->SetMindumpMemoryInfo(memory_info);
+    process_snapshot->AddMemoryMapRegion(std::move(region));
+  }
+}
+
+// Accumulated measurements for one case, summed over all iterations.
+struct Measurement {
+  uint64_t initialize_ns;
+  uint64_t freeze_ns;
+  uint64_t write_ns;
+  uint64_t initialize_allocations;
+  uint64_t write_allocations;
+  uint64_t bytes;
+};
+
+// Populates |minidump| with the streams under test.
+using InitializeFunction = void (*)(const ProcessSnapshot* process_snapshot,
+                                    MinidumpFileWriter* minidump);
+
+// Initializes, lays out, and writes a minidump file, adding the results to
+// |measurement|.
+//
+// Freezing and layout occur before the first write, so the time before the
+// first write is attributed to freezing, and the remainder to writing.
+bool MeasureOnce(const ProcessSnapshot* process_snapshot,
+                 InitializeFunction initialize,
+                 Measurement* measurement) {
+  const uint64_t start_allocations = g_allocation_count;
+  const uint64_t start_time = ClockMonotonicNanoseconds();
+
+  MinidumpFileWriter minidump;
+  initialize(process_snapshot, &minidump);
+
+  const uint64_t initialized_allocations = g_allocation_count;
+  const uint64_t initialized_time = ClockMonotonicNanoseconds();
+
+  CountingFileWriter file_writer;
+  if (!minidump.WriteMinidump(&file_writer, true)) {
+    LOG(ERROR) << "WriteMinidump failed";
+    return false;
+  }
+
+  const uint64_t end_time = ClockMonotonicNanoseconds();
+  const uint64_t first_write_time =
+      file_writer.first_write_time() ? file_writer.first_write_time()
+                                     : end_time;
+
+  measurement->initialize_ns += initialized_time - start_time;
+  measurement->freeze_ns += first_write_time - initialized_time;
+  measurement->write_ns += end_time - first_write_time;
+  measurement->initialize_allocations +=
+      initialized_allocations - start_allocations;
+  measurement->write_allocations +=
+      g_allocation_count - initialized_allocations;
+  measurement->bytes += file_writer.size();
+  return true;
+}
+
+void InitializeFullMinidump(const ProcessSnapshot* process_snapshot,
+                            MinidumpFileWriter* minidump) {
+  minidump->InitializeFromSnapshot(process_snapshot);
+}
+
+void InitializeSystemInfo(const ProcessSnapshot* process_snapshot,
+                          MinidumpFileWriter* minidump) {
+  auto system_info = base::WrapUnique(new MinidumpSystemInfoWriter());
+  system_info->InitializeFromSnapshot(process_snapshot->System());
+  minidump->AddStream(std::move(system_info));
+}
+
+void InitializeMiscInfo(const ProcessSnapshot* process_snapshot,
+                        MinidumpFileWriter* minidump) {
+  auto misc_info = base::WrapUnique(new MinidumpMiscInfoWriter());
+  misc_info->InitializeFromSnapshot(process_snapshot);
+  minidump->AddStream(std::move(misc_info));
+}
+
+void InitializeThreadList(const ProcessSnapshot* process_snapshot,
+                          MinidumpFileWriter* minidump) {
+  // The memory list carries the descriptors of the thread stacks, so it is
+  // measured along with the thread list.
+  auto memory_list = base::WrapUnique(new MinidumpMemoryListWriter());
+  auto thread_list = base::WrapUnique(new MinidumpThreadListWriter());
+  thread_list->SetMemoryListWriter(memory_list.get());
+  MinidumpThreadIDMap thread_id_map;
+  thread_list->InitializeFromSnapshot(process_snapshot->Threads(),
+                                      &thread_id_map);
+  minidump->AddStream(std::move(thread_list));
+  minidump->AddStream(std::move(memory_list));
+}
+
+void InitializeModuleList(const ProcessSnapshot* process_snapshot,
+                          MinidumpFileWriter* minidump) {
+  auto module_list = base::WrapUnique(new MinidumpModuleListWriter());
+  module_list->InitializeFromSnapshot(process_snapshot->Modules());
+  minidump->AddStream(std::move(module_list));
+}
+
+void InitializeMemoryList(const ProcessSnapshot* process_snapshot,
+                          MinidumpFileWriter* minidump) {
+  auto memory_list = base::WrapUnique(new MinidumpMemoryListWriter());
+  memory_list->AddFromSnapshot(process_snapshot->ExtraMemory(),
+                               MemoryReadSite::kProcessData);
+  minidump->AddStream(std::move(memory_list));
+}
+
+void InitializeMemoryInfoList(const ProcessSnapshot* process_snapshot,
+                              MinidumpFileWriter* minidump) {
+  auto memory_info_list = base::WrapUnique(new MinidumpMemoryInfoListWriter());
+  memory_info_list->InitializeFromSnapshot(process_snapshot->MemoryMap());
+  minidump->AddStream(std::move(memory_info_list));
+}
+
+void Usage(const base::FilePath& me) {
+  fprintf(stderr,
+"Usage: %" PRFilePath " [OPTION]...\n"
+"Measure the time, allocations, and size of minidump files written from a\n"
+"synthetic process snapshot, for the whole file and for each stream.\n"
+"\n"
+"  -i, --iterations=COUNT        repeat each measurement COUNT times (10)\n"
+"  -t, --threads=COUNT           give the process COUNT threads (64)\n"
+"  -m, --modules=COUNT           give the process COUNT modules (256)\n"
+"  -r, --memory-ranges=COUNT     capture COUNT extra memory ranges (256)\n"
+"  -R, --memory-map-regions=COUNT\n"
+"                                give the process COUNT memory map regions\n"
+"                                (10000)\n"
+"  -s, --stack-size=BYTES        give each thread a BYTES-byte stack (16384)\n"
+"      --help                    display this help and exit\n"
+"      --version                 output version information and exit\n",
+          me.value().c_str());
+  ToolSupport::UsageTail(me);
+}
+
+int MinidumpWriterBenchmarkMain(int argc, char* argv[]) {
+  const base::FilePath argv0(
+      ToolSupport::CommandLineArgumentToFilePathStringType(argv[0]));
+  const base::FilePath me(argv0.BaseName());
+
+  enum OptionFlags {
+    // “Short” (single-character) options.
+    kOptionIterations = 'i',
+    kOptionModules = 'm',
+    kOptionMemoryRanges = 'r',
+    kOptionMemoryMapRegions = 'R',
+    kOptionStackSize = 's',
+    kOptionThreads = 't',
+
+    // Long options without short equivalents.
+    kOptionLastChar = 255,
+
+    // Standard options.
+    kOptionHelp = -2,
+    kOptionVersion = -3,
+  };
+
+  unsigned int iterations = 10;
+  SnapshotParameters parameters;
+  parameters.thread_count = 64;
+  parameters.module_count = 256;
+  parameters.memory_range_count = 256;
+  parameters.memory_map_region_count = 10000;
+  parameters.stack_size = 16384;
+
+  static constexpr option long_options[] = {
+      {"iterations", required_argument, nullptr, kOptionIterations},
+      {"threads", required_argument, nullptr, kOptionThreads},
+      {"modules", required_argument, nullptr, kOptionModules},
+      {"memory-ranges", required_argument, nullptr, kOptionMemoryRanges},
+      {"memory-map-regions",
+       required_argument,
+       nullptr,
+       kOptionMemoryMapRegions},
+      {"stack-size", required_argument, nullptr, kOptionStackSize},
+      {"help", no_argument, nullptr, kOptionHelp},
+      {"version", no_argument, nullptr, kOptionVersion},
+      {nullptr, 0, nullptr, 0},
+  };
+
+  int opt;
+  while ((opt = getopt_long(
+              argc, argv, "i:m:r:R:s:t:", long_options, nullptr)) != -1) {
+    unsigned int* value;
+    switch (opt) {
+      case kOptionIterations:
+        value = &iterations;
+        break;
+      case kOptionModules:
+        value = &parameters.module_count;
+        break;
+      case kOptionMemoryRanges:
+        value = &parameters.memory_range_count;
+        break;
+      case kOptionMemoryMapRegions:
+        value = &parameters.memory_map_region_count;
+        break;
+      case kOptionStackSize:
+        value = &parameters.stack_size;
+        break;
+      case kOptionThreads:
+        value = &parameters.thread_count;
+        break;
+      case kOptionHelp:
+        Usage(me);
+        return EXIT_SUCCESS;
+      case kOptionVersion:
+        ToolSupport::Version(me);
+        return EXIT_SUCCESS;
+      default:
+        ToolSupport::UsageHint(me, nullptr);
+        return EXIT_FAILURE;
+    }
+
+    if (!StringToNumber(optarg, value)) {
+      ToolSupport::UsageHint(me, "numeric value required");
+      return EXIT_FAILURE;
+    }
+  }
+  argc -= optind;
+  argv += optind;
+
+  if (argc != 0 || iterations == 0) {
+    ToolSupport::UsageHint(me, nullptr);
+    return EXIT_FAILURE;
+  }
+
+  test::TestProcessSnapshot process_snapshot;
+  BuildProcessSnapshot(parameters, &process_snapshot);
+
+  static constexpr struct {
+    const char* name;
+    InitializeFunction initialize;
+  } kCases[] = {
+      {"minidump", InitializeFullMinidump},
+      {"system_info", InitializeSystemInfo},
+      {"misc_info", InitializeMiscInfo},
+      {"thread_list", InitializeThreadList},
+      {"module_list", InitializeModuleList},
+      {"memory_list", InitializeMemoryList},
+      {"memory_info_list", InitializeMemoryInfoList},
+  };
+
+  printf("%u threads, %u modules, %u memory ranges, %u memory map regions, "
+         "%u iterations\n",
+         parameters.thread_count,
+         parameters.module_count,
+         parameters.memory_range_count,
+         parameters.memory_map_region_count,
+         iterations);
+  printf("%-18s %12s %12s %12s %10s %10s %12s\n",
+         "case",
+         "init_us",
+         "freeze_us",
+         "write_us",
+         "init_alloc",
+         "write_alloc",
+         "bytes");
+
+  for (const auto& test_case : kCases) {
+    Measurement measurement = {};
+    for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+      if (!MeasureOnce(
+              &process_snapshot, test_case.initialize, &measurement)) {
+        return EXIT_FAILURE;
+      }
+    }
+
+    printf("%-18s %12.1f %12.1f %12.1f %10llu %10llu %12llu\n",
+           test_case.name,
+           measurement.initialize_ns / 1E3 / iterations,
+           measurement.freeze_ns / 1E3 / iterations,
+           measurement.write_ns / 1E3 / iterations,
+           static_cast<unsigned long long>(
+               measurement.initialize_allocations / iterations),
+           static_cast<unsigned long long>(
+               measurement.write_allocations / iterations),
+           static_cast<unsigned long long>(measurement.bytes / iterations));
+  }
+
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+}  // namespace crashpad
+
+#if defined(OS_POSIX)
+int main(int argc, char* argv[]) {
+  return crashpad::MinidumpWriterBenchmarkMain(argc, argv);
+}
+#elif defined(OS_WIN)
+int wmain(int argc, wchar_t* argv[]) {
+  return crashpad::ToolSupport::Wmain(
+      argc, argv, crashpad::MinidumpWriterBenchmarkMain);
+}
+#endif  // OS_POSIX
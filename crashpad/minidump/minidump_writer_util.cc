@@ -16,8 +16,8 @@
 
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
-#include "base/strings/utf_string_conversions.h"
 #include "util/stdlib/strlcpy.h"
+#include "util/string/utf_conversion.h"
 
 namespace crashpad {
 namespace internal {
@@ -34,7 +34,7 @@ void MinidumpWriterUtil::AssignTimeT(uint32_t* destination, time_t source) {
 // static
 base::string16 MinidumpWriterUtil::ConvertUTF8ToUTF16(const std::string& utf8) {
   base::string16 utf16;
-  if (!base::UTF8ToUTF16(utf8.data(), utf8.length(), &utf16)) {
+  if (!TranscodeUTF8ToUTF16(utf8.data(), utf8.length(), &utf16)) {
     LOG(WARNING) << "string " << utf8
                  << " cannot be converted to UTF-16 losslessly";
   }
@@ -167,6 +167,14 @@ struct MinidumpMemoryListTraits {
   }
 };
 
+struct MinidumpMemory64ListTraits {
+  using ListType = MINIDUMP_MEMORY64_LIST;
+  enum : size_t { kElementSize = sizeof(MINIDUMP_MEMORY_DESCRIPTOR64) };
+  static size_t ElementCount(const ListType* list) {
+    return static_cast<size_t>(list->NumberOfMemoryRanges);
+  }
+};
+
 struct MinidumpModuleListTraits {
   using ListType = MINIDUMP_MODULE_LIST;
   enum : size_t { kElementSize = sizeof(MINIDUMP_MODULE) };
@@ -223,6 +231,22 @@ struct MinidumpSimpleStringDictionaryListTraits {
   }
 };
 
+struct MinidumpAnnotationListObjectsTraits {
+  using ListType = MinidumpAnnotationList;
+  enum : size_t { kElementSize = sizeof(MinidumpAnnotation) };
+  static size_t ElementCount(const ListType* list) {
+    return list->count;
+  }
+};
+
+struct MinidumpThreadAnnotationListThreadsTraits {
+  using ListType = MinidumpThreadAnnotationList;
+  enum : size_t { kElementSize = sizeof(MinidumpThreadAnnotation) };
+  static size_t ElementCount(const ListType* list) {
+    return list->count;
+  }
+};
+
 template <typename T>
 const typename T::ListType* MinidumpListAtLocationDescriptor(
     const std::string& file_contents,
@@ -254,6 +278,14 @@ const MINIDUMP_MEMORY_LIST* MinidumpWritableAtLocationDescriptor<
       file_contents, location);
 }
 
+template <>
+const MINIDUMP_MEMORY64_LIST* MinidumpWritableAtLocationDescriptor<
+    MINIDUMP_MEMORY64_LIST>(const std::string& file_contents,
+                            const MINIDUMP_LOCATION_DESCRIPTOR& location) {
+  return MinidumpListAtLocationDescriptor<MinidumpMemory64ListTraits>(
+      file_contents, location);
+}
+
 template <>
 const MINIDUMP_MODULE_LIST* MinidumpWritableAtLocationDescriptor<
     MINIDUMP_MODULE_LIST>(const std::string& file_contents,
@@ -313,6 +345,24 @@ MinidumpWritableAtLocationDescriptor<MinidumpSimpleStringDictionary>(
       MinidumpSimpleStringDictionaryListTraits>(file_contents, location);
 }
 
+template <>
+const MinidumpAnnotationList*
+MinidumpWritableAtLocationDescriptor<MinidumpAnnotationList>(
+    const std::string& file_contents,
+    const MINIDUMP_LOCATION_DESCRIPTOR& location) {
+  return MinidumpListAtLocationDescriptor<MinidumpAnnotationListObjectsTraits>(
+      file_contents, location);
+}
+
+template <>
+const MinidumpThreadAnnotationList*
+MinidumpWritableAtLocationDescriptor<MinidumpThreadAnnotationList>(
+    const std::string& file_contents,
+    const MINIDUMP_LOCATION_DESCRIPTOR& location) {
+  return MinidumpListAtLocationDescriptor<
+      MinidumpThreadAnnotationListThreadsTraits>(file_contents, location);
+}
+
 namespace {
 
 template <typename T>
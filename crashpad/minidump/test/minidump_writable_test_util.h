@@ -88,19 +88,26 @@ MINIDUMP_ALLOW_OVERSIZED_DATA(MINIDUMP_DIRECTORY);
 // These types are permitted to be oversized because their final fields are
 // variable-sized lists.
 MINIDUMP_ALLOW_OVERSIZED_DATA(MINIDUMP_MEMORY_LIST);
+MINIDUMP_ALLOW_OVERSIZED_DATA(MINIDUMP_MEMORY64_LIST);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MINIDUMP_MODULE_LIST);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MINIDUMP_UNLOADED_MODULE_LIST);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MINIDUMP_THREAD_LIST);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MINIDUMP_HANDLE_DATA_STREAM);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MINIDUMP_MEMORY_INFO_LIST);
+MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpAnnotationList);
+MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpCrashpadReconstructibleMemoryList);
+MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpCrashpadStreamReferenceList);
+MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpCrashpadTopFrameList);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpModuleCrashpadInfoList);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpRVAList);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpSimpleStringDictionary);
+MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpThreadAnnotationList);
 
 // These types have final fields carrying variable-sized data (typically string
 // data).
 MINIDUMP_ALLOW_OVERSIZED_DATA(IMAGE_DEBUG_MISC);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MINIDUMP_STRING);
+MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpByteArray);
 MINIDUMP_ALLOW_OVERSIZED_DATA(CodeViewRecordPDB20);
 MINIDUMP_ALLOW_OVERSIZED_DATA(CodeViewRecordPDB70);
 MINIDUMP_ALLOW_OVERSIZED_DATA(MinidumpUTF8String);
@@ -141,8 +148,10 @@ const T* TMinidumpWritableAtLocationDescriptor(
 //!  - With a MINIDUMP_HEADER template parameter, a template specialization
 //!    ensures that the structure’s magic number and version fields are correct.
 //!  - With a MINIDUMP_MEMORY_LIST, MINIDUMP_THREAD_LIST, MINIDUMP_MODULE_LIST,
-//!    MINIDUMP_MEMORY_INFO_LIST, or MinidumpSimpleStringDictionary template
-//!    parameter, template specializations ensure that the size given by \a
+//!    MINIDUMP_MEMORY_INFO_LIST, MinidumpSimpleStringDictionary,
+//!    MinidumpAnnotationList, or MinidumpThreadAnnotationList template
+//!    parameter, template specializations
+//!    ensure that the size given by \a
 //!    location matches the size expected of a stream containing the number of
 //!    elements it claims to have.
 //!  - With an IMAGE_DEBUG_MISC, CodeViewRecordPDB20, or CodeViewRecordPDB70
@@ -182,6 +191,11 @@ const MINIDUMP_MEMORY_LIST* MinidumpWritableAtLocationDescriptor<
     MINIDUMP_MEMORY_LIST>(const std::string& file_contents,
                           const MINIDUMP_LOCATION_DESCRIPTOR& location);
 
+template <>
+const MINIDUMP_MEMORY64_LIST* MinidumpWritableAtLocationDescriptor<
+    MINIDUMP_MEMORY64_LIST>(const std::string& file_contents,
+                            const MINIDUMP_LOCATION_DESCRIPTOR& location);
+
 template <>
 const MINIDUMP_MODULE_LIST* MinidumpWritableAtLocationDescriptor<
     MINIDUMP_MODULE_LIST>(const std::string& file_contents,
@@ -230,6 +244,18 @@ MinidumpWritableAtLocationDescriptor<MinidumpSimpleStringDictionary>(
     const std::string& file_contents,
     const MINIDUMP_LOCATION_DESCRIPTOR& location);
 
+template <>
+const MinidumpAnnotationList*
+MinidumpWritableAtLocationDescriptor<MinidumpAnnotationList>(
+    const std::string& file_contents,
+    const MINIDUMP_LOCATION_DESCRIPTOR& location);
+
+template <>
+const MinidumpThreadAnnotationList*
+MinidumpWritableAtLocationDescriptor<MinidumpThreadAnnotationList>(
+    const std::string& file_contents,
+    const MINIDUMP_LOCATION_DESCRIPTOR& location);
+
 //! \brief Returns a typed minidump object located within a minidump file’s
 //!     contents, where the offset of the object is known.
 //!
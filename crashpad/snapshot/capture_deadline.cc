@@ -0,0 +1,64 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/capture_deadline.h"
+
+#include "util/misc/clock.h"
+
+namespace crashpad {
+
+namespace {
+
+// Optional content is captured during the first three quarters of the budget.
+// The rest is reserved for the content that every report needs, such as
+// thread stacks, and for copying memory out of the process.
+constexpr uint64_t kOptionalBudgetNumerator = 3;
+constexpr uint64_t kOptionalBudgetDenominator = 4;
+
+// The value of CaptureDeadline::optional_end_time_ when there’s no budget.
+constexpr uint64_t kNoEndTime = UINT64_MAX;
+
+uint64_t OptionalEndTime(uint64_t start_time, uint64_t budget) {
+  if (!budget) {
+    return kNoEndTime;
+  }
+  return start_time +
+         budget / kOptionalBudgetDenominator * kOptionalBudgetNumerator;
+}
+
+}  // namespace
+
+CaptureDeadline::CaptureDeadline(uint64_t start_time, uint64_t budget)
+    : optional_end_time_(OptionalEndTime(start_time, budget)),
+      skipped_content_(0),
+      start_time_(start_time) {}
+
+CaptureDeadline::~CaptureDeadline() {}
+
+void CaptureDeadline::SetBudget(uint64_t budget) {
+  optional_end_time_ = OptionalEndTime(start_time_, budget);
+}
+
+bool CaptureDeadline::ShouldCapture(Content content) {
+  const uint64_t optional_end_time = optional_end_time_;
+  if (optional_end_time == kNoEndTime ||
+      ClockMonotonicNanoseconds() < optional_end_time) {
+    return true;
+  }
+
+  skipped_content_ |= content;
+  return false;
+}
+
+}  // namespace crashpad
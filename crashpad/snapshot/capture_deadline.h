@@ -0,0 +1,107 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_CAPTURE_DEADLINE_H_
+#define CRASHPAD_SNAPSHOT_CAPTURE_DEADLINE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "base/macros.h"
+
+namespace crashpad {
+
+//! \brief A limit on the time that capturing a snapshot may take, beyond which
+//!     optional content is left out.
+//!
+//! Systems may terminate a process that stays suspended for too long, in which
+//! case no report is produced at all. Snapshots consult an object of this class
+//! before each piece of content that a report can do without. Once the
+//! deadline nears, that content is skipped, leaving the remaining time for the
+//! content that every report needs, and what was skipped is recorded so that
+//! it can be noted in the report.
+class CaptureDeadline {
+ public:
+  //! \brief Content that may be skipped to meet the deadline.
+  //!
+  //! These values are recorded in
+  //! MinidumpCrashpadCapturePerformance::skipped_content, and match the
+  //! corresponding ::MinidumpCrashpadSkippedContent values.
+  enum Content : uint32_t {
+    //! \brief Memory referenced by thread stacks and registers.
+    kIndirectMemory = 1 << 0,
+
+    //! \brief The process’ handles.
+    kHandleData = 1 << 1,
+
+    //! \brief The process’ memory map.
+    kMemoryInfoList = 1 << 2,
+
+    //! \brief Modules that were unloaded from the process.
+    kUnloadedModules = 1 << 3,
+
+    //! \brief The process’ locks.
+    kLocks = 1 << 4,
+  };
+
+  //! \brief Constructs a new object.
+  //!
+  //! \param[in] start_time The time that capture started, as returned by
+  //!     ClockMonotonicNanoseconds(). This is normally before the process was
+  //!     suspended, so that the time taken to suspend it is counted.
+  //! \param[in] budget The time that capture may take, in nanoseconds. `0` for
+  //!     no limit, in which case nothing is ever skipped.
+  CaptureDeadline(uint64_t start_time, uint64_t budget);
+  ~CaptureDeadline();
+
+  //! \brief Replaces the time that capture may take.
+  //!
+  //! This allows a budget requested by the process being captured to take
+  //! effect once it has been read. Content that has already been skipped
+  //! remains skipped.
+  //!
+  //! \param[in] budget The time that capture may take, in nanoseconds,
+  //!     counted from the start time given to the constructor. `0` for no
+  //!     limit.
+  void SetBudget(uint64_t budget);
+
+  //! \brief Determines whether optional content should be captured.
+  //!
+  //! Optional content may be captured until the portion of the budget
+  //! reserved for required content is reached. When \a content should be
+  //! skipped, it is also recorded in skipped_content().
+  //!
+  //! This method may be called concurrently from multiple threads.
+  //!
+  //! \param[in] content The content about to be captured.
+  //!
+  //! \return `true` if \a content should be captured, `false` if it should be
+  //!     skipped.
+  bool ShouldCapture(Content content);
+
+  //! \return A bitwise OR of the Content values that were skipped.
+  uint32_t skipped_content() const { return skipped_content_; }
+
+ private:
+  std::atomic<uint64_t> optional_end_time_;
+  std::atomic<uint32_t> skipped_content_;
+  uint64_t start_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(CaptureDeadline);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_CAPTURE_DEADLINE_H_
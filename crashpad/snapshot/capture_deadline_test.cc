@@ -0,0 +1,75 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/capture_deadline.h"
+
+#include "gtest/gtest.h"
+#include "util/misc/clock.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr uint64_t kSecond = 1000000000;
+
+TEST(CaptureDeadline, NoBudget) {
+  CaptureDeadline deadline(0, 0);
+  EXPECT_TRUE(deadline.ShouldCapture(CaptureDeadline::kIndirectMemory));
+  EXPECT_TRUE(deadline.ShouldCapture(CaptureDeadline::kLocks));
+  EXPECT_EQ(deadline.skipped_content(), 0u);
+}
+
+TEST(CaptureDeadline, WithinBudget) {
+  CaptureDeadline deadline(ClockMonotonicNanoseconds(), 60 * kSecond);
+  EXPECT_TRUE(deadline.ShouldCapture(CaptureDeadline::kHandleData));
+  EXPECT_TRUE(deadline.ShouldCapture(CaptureDeadline::kMemoryInfoList));
+  EXPECT_EQ(deadline.skipped_content(), 0u);
+}
+
+TEST(CaptureDeadline, NearDeadline) {
+  // The reserve for required content begins three quarters of the way through
+  // the budget, which has already been reached.
+  CaptureDeadline deadline(ClockMonotonicNanoseconds() - 4 * kSecond,
+                           5 * kSecond);
+  EXPECT_FALSE(deadline.ShouldCapture(CaptureDeadline::kHandleData));
+  EXPECT_FALSE(deadline.ShouldCapture(CaptureDeadline::kUnloadedModules));
+  EXPECT_EQ(deadline.skipped_content(),
+            static_cast<uint32_t>(CaptureDeadline::kHandleData |
+                                  CaptureDeadline::kUnloadedModules));
+}
+
+TEST(CaptureDeadline, SetBudget) {
+  CaptureDeadline deadline(ClockMonotonicNanoseconds() - 4 * kSecond,
+                           5 * kSecond);
+  EXPECT_FALSE(deadline.ShouldCapture(CaptureDeadline::kLocks));
+
+  // A longer budget takes effect, but what was skipped stays skipped.
+  deadline.SetBudget(60 * kSecond);
+  EXPECT_TRUE(deadline.ShouldCapture(CaptureDeadline::kIndirectMemory));
+  EXPECT_EQ(deadline.skipped_content(),
+            static_cast<uint32_t>(CaptureDeadline::kLocks));
+
+  deadline.SetBudget(0);
+  EXPECT_TRUE(deadline.ShouldCapture(CaptureDeadline::kLocks));
+
+  deadline.SetBudget(kSecond);
+  EXPECT_FALSE(deadline.ShouldCapture(CaptureDeadline::kMemoryInfoList));
+  EXPECT_EQ(deadline.skipped_content(),
+            static_cast<uint32_t>(CaptureDeadline::kLocks |
+                                  CaptureDeadline::kMemoryInfoList));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -16,83 +16,421 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <limits>
 #include <memory>
+#include <queue>
+#include <utility>
 
 #include "snapshot/memory_snapshot.h"
+#include "snapshot/x86/memory_operands.h"
 
 namespace crashpad {
 namespace internal {
 
 namespace {
 
+// Values this close to zero or to the top of the address space are not
+// considered pointers.
+constexpr uint64_t kNonAddressOffset = 0x10000;
+
+// The memory captured around a pointer starts this far before it…
+constexpr uint64_t kRegisterByteOffset = 128;
+
+// …and is this large.
+constexpr uint64_t kCaptureSize = 512;
+
+static_assert(kRegisterByteOffset <= kCaptureSize / 2,
+              "negative offset too large");
+
+// The code captured around an exception’s instruction pointer starts this far
+// before it…
+constexpr uint64_t kCodeBytesBefore = 256;
+
+// …and ends this far after it.
+constexpr uint64_t kCodeBytesAfter = 256;
+
+// The size of the page captured around an exception’s fault address.
+constexpr uint64_t kFaultPageSize = 4096;
+
+uint64_t MaxAddress(const CaptureMemory::Delegate* delegate) {
+  return delegate->Is64Bit() ? std::numeric_limits<uint64_t>::max()
+                             : std::numeric_limits<uint32_t>::max();
+}
+
+bool IsPointerLike(const CaptureMemory::Delegate* delegate, uint64_t value) {
+  return value >= kNonAddressOffset &&
+         value <= MaxAddress(delegate) - kNonAddressOffset;
+}
+
+// The ranges that a delegate excludes from capture, merged and sorted so that
+// they can be searched.
+class ExcludedRanges {
+ public:
+  explicit ExcludedRanges(const CaptureMemory::Delegate* delegate)
+      : ranges_() {
+    std::vector<CheckedRange<uint64_t>> ranges = delegate->GetExcludedRanges();
+    std::sort(ranges.begin(),
+              ranges.end(),
+              [](const CheckedRange<uint64_t>& a,
+                 const CheckedRange<uint64_t>& b) {
+                return a.base() < b.base();
+              });
+    for (const auto& range : ranges) {
+      if (range.size() == 0 || !range.IsValid()) {
+        continue;
+      }
+      if (!ranges_.empty() && range.base() <= ranges_.back().end()) {
+        if (range.end() > ranges_.back().end()) {
+          ranges_.back().SetRange(ranges_.back().base(),
+                                  range.end() - ranges_.back().base());
+        }
+      } else {
+        ranges_.push_back(range);
+      }
+    }
+  }
+
+  bool empty() const { return ranges_.empty(); }
+
+  // Returns true if all of |range| is excluded.
+  bool Covers(const CheckedRange<uint64_t>& range) const {
+    auto it = std::upper_bound(ranges_.begin(),
+                               ranges_.end(),
+                               range.base(),
+                               [](uint64_t value,
+                                  const CheckedRange<uint64_t>& excluded) {
+                                 return value < excluded.base();
+                               });
+    if (it == ranges_.begin()) {
+      return false;
+    }
+    --it;
+    return range.end() <= it->end();
+  }
+
+  // Returns the portions of |range| that aren’t excluded, in address order.
+  std::vector<CheckedRange<uint64_t>> Remove(
+      const CheckedRange<uint64_t>& range) const {
+    std::vector<CheckedRange<uint64_t>> result;
+    uint64_t base = range.base();
+    const uint64_t end = range.end();
+
+    // The ranges are disjoint, so they’re sorted by their ends too.
+    auto it = std::upper_bound(ranges_.begin(),
+                               ranges_.end(),
+                               base,
+                               [](uint64_t value,
+                                  const CheckedRange<uint64_t>& excluded) {
+                                 return value < excluded.end();
+                               });
+    for (; it != ranges_.end() && it->base() < end; ++it) {
+      if (it->base() > base) {
+        result.push_back(CheckedRange<uint64_t>(base, it->base() - base));
+      }
+      base = std::max(base, it->end());
+    }
+    if (base < end) {
+      result.push_back(CheckedRange<uint64_t>(base, end - base));
+    }
+    return result;
+  }
+
+ private:
+  std::vector<CheckedRange<uint64_t>> ranges_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExcludedRanges);
+};
+
+// Adds the portions of |range| that aren’t excluded to the capture.
+void AddCapturedRange(const CheckedRange<uint64_t>& range,
+                      const ExcludedRanges& excluded,
+                      CaptureMemory::Delegate* delegate) {
+  if (excluded.empty()) {
+    delegate->AddNewMemorySnapshot(range);
+    return;
+  }
+  for (const auto& included : excluded.Remove(range)) {
+    delegate->AddNewMemorySnapshot(included);
+  }
+}
+
+// Returns the range to be captured for |value|.
+CheckedRange<uint64_t> CaptureTarget(uint64_t value) {
+  return CheckedRange<uint64_t>(value - kRegisterByteOffset, kCaptureSize);
+}
+
 void MaybeCaptureMemoryAround(CaptureMemory::Delegate* delegate,
+                              const ExcludedRanges& excluded,
                               uint64_t address) {
-  constexpr uint64_t non_address_offset = 0x10000;
-  if (address < non_address_offset)
+  if (!IsPointerLike(delegate, address))
     return;
 
-  const uint64_t max_address = delegate->Is64Bit() ?
-      std::numeric_limits<uint64_t>::max() :
-      std::numeric_limits<uint32_t>::max();
-  if (address > max_address - non_address_offset)
+  const CheckedRange<uint64_t> target = CaptureTarget(address);
+  if (excluded.Covers(target))
     return;
 
-  constexpr uint64_t kRegisterByteOffset = 128;
-  const uint64_t target = address - kRegisterByteOffset;
-  constexpr uint64_t size = 512;
-  static_assert(kRegisterByteOffset <= size / 2,
-                "negative offset too large");
-  auto ranges =
-      delegate->GetReadableRanges(CheckedRange<uint64_t>(target, size));
+  auto ranges = delegate->GetReadableRanges(target);
   for (const auto& range : ranges) {
-    delegate->AddNewMemorySnapshot(range);
+    AddCapturedRange(range, excluded, delegate);
   }
 }
 
+// A pointer-like value found in memory.
+struct PointerCandidate {
+  // The value.
+  uint64_t value;
+
+  // The address that the value was read from.
+  uint64_t slot;
+};
+
+// Appends each value in |buffer|, which was read from |buffer_address|, that is
+// within [|low|, |high|] to |candidates|.
+//
+// Most values in a stack aren’t pointers into mapped memory, so this is mostly
+// a filter. Values are tested a block at a time without branching, in a form
+// the compiler can vectorize, and only blocks containing a candidate are
+// examined individually.
 template <class T>
-void CaptureAtPointersInRange(uint8_t* buffer,
-                              uint64_t buffer_size,
-                              CaptureMemory::Delegate* delegate) {
-  for (uint64_t address_offset = 0; address_offset < buffer_size;
-       address_offset += sizeof(T)) {
-    uint64_t target_address = *reinterpret_cast<T*>(&buffer[address_offset]);
-    MaybeCaptureMemoryAround(delegate, target_address);
+void FindPointerCandidates(const uint8_t* buffer,
+                           uint64_t buffer_address,
+                           uint64_t buffer_size,
+                           uint64_t low,
+                           uint64_t high,
+                           std::vector<PointerCandidate>* candidates) {
+  const T* values = reinterpret_cast<const T*>(buffer);
+  const size_t count = static_cast<size_t>(buffer_size / sizeof(T));
+
+  // A single unsigned comparison tests both bounds.
+  const uint64_t span = high - low;
+
+  constexpr size_t kBlockSize = 16;
+  size_t index = 0;
+  for (; index + kBlockSize <= count; index += kBlockSize) {
+    bool in_window[kBlockSize];
+    bool any_in_window = false;
+    for (size_t block_index = 0; block_index < kBlockSize; ++block_index) {
+      in_window[block_index] =
+          static_cast<uint64_t>(values[index + block_index]) - low <= span;
+      any_in_window |= in_window[block_index];
+    }
+
+    if (!any_in_window) {
+      continue;
+    }
+
+    for (size_t block_index = 0; block_index < kBlockSize; ++block_index) {
+      if (in_window[block_index]) {
+        candidates->push_back(
+            {values[index + block_index],
+             buffer_address + (index + block_index) * sizeof(T)});
+      }
+    }
+  }
+
+  for (; index < count; ++index) {
+    if (static_cast<uint64_t>(values[index]) - low <= span) {
+      candidates->push_back(
+          {values[index], buffer_address + index * sizeof(T)});
+    }
+  }
+}
+
+// Reads |memory| into |buffer|, and appends the pointer-sized values in it
+// that could lead to a capture to |candidates|, in order of their address.
+// Returns false, with a message logged if appropriate, if there’s nothing to
+// capture.
+bool FindPointerCandidatesInRange(const MemorySnapshot& memory,
+                                  CaptureMemory::Delegate* delegate,
+                                  std::unique_ptr<uint8_t[]>* buffer,
+                                  std::vector<PointerCandidate>* candidates) {
+  if (memory.Size() == 0)
+    return false;
+
+  const size_t alignment =
+      delegate->Is64Bit() ? sizeof(uint64_t) : sizeof(uint32_t);
+  if (memory.Address() % alignment != 0 || memory.Size() % alignment != 0) {
+    LOG(ERROR) << "unaligned range";
+    return false;
+  }
+
+  buffer->reset(new uint8_t[memory.Size()]);
+  if (!delegate->ReadMemory(memory.Address(), memory.Size(), buffer->get())) {
+    LOG(ERROR) << "ReadMemory";
+    return false;
+  }
+
+  // Only values near mapped memory can lead to a capture. A value is in range
+  // if the memory captured around it would overlap the mapped address space.
+  uint64_t mapped_low;
+  uint64_t mapped_high;
+  delegate->GetMappedAddressBounds(&mapped_low, &mapped_high);
+  const uint64_t max_address = MaxAddress(delegate);
+  const uint64_t trailing_bytes = kCaptureSize - kRegisterByteOffset;
+  const uint64_t low = std::max(
+      kNonAddressOffset,
+      mapped_low > trailing_bytes ? mapped_low - trailing_bytes + 1 : 0);
+  const uint64_t high = std::min(
+      max_address - kNonAddressOffset,
+      mapped_high < max_address - kRegisterByteOffset
+          ? mapped_high + kRegisterByteOffset
+          : max_address);
+  if (low > high)
+    return false;
+
+  if (delegate->Is64Bit()) {
+    FindPointerCandidates<uint64_t>(
+        buffer->get(), memory.Address(), memory.Size(), low, high, candidates);
+  } else {
+    FindPointerCandidates<uint32_t>(
+        buffer->get(), memory.Address(), memory.Size(), low, high, candidates);
+  }
+  return !candidates->empty();
+}
+
+// Returns the ranges to be captured for each of |values|.
+std::vector<CheckedRange<uint64_t>> CaptureTargets(
+    const std::vector<uint64_t>& values) {
+  std::vector<CheckedRange<uint64_t>> targets;
+  targets.reserve(values.size());
+  for (uint64_t value : values) {
+    targets.push_back(CaptureTarget(value));
+  }
+  return targets;
+}
+
+// The number of frame records followed when prioritizing stack values.
+constexpr size_t kMaxStackFrames = 256;
+
+// Pointers into the heap are treated as though they were stored this many
+// times closer to the stack pointer or a frame pointer than they are.
+constexpr uint64_t kHeapPreference = 4;
+
+uint64_t FramePointer(const CPUContext& context) {
+#if defined(ARCH_CPU_X86_FAMILY)
+  return context.architecture == kCPUArchitectureX86_64 ? context.x86_64->rbp
+                                                        : context.x86->ebp;
+#else
+#error non-x86
+#endif
+}
+
+// Returns the stack pointer, followed by the addresses of the frame records
+// found by following the frame pointer chain through |stack|, which was read
+// into |buffer|, in address order.
+std::vector<uint64_t> StackAnchors(const MemorySnapshot& stack,
+                                   const uint8_t* buffer,
+                                   const CPUContext& context,
+                                   bool is_64_bit) {
+  std::vector<uint64_t> anchors(1, context.StackPointer());
+
+  const uint64_t pointer_size = is_64_bit ? 8 : 4;
+  const uint64_t stack_end = stack.Address() + stack.Size();
+  uint64_t frame_pointer = FramePointer(context);
+  for (size_t frame = 0; frame < kMaxStackFrames; ++frame) {
+    if (frame_pointer % pointer_size != 0 ||
+        frame_pointer < stack.Address() ||
+        frame_pointer > stack_end - pointer_size) {
+      break;
+    }
+    anchors.push_back(frame_pointer);
+
+    const uint8_t* record = buffer + (frame_pointer - stack.Address());
+    const uint64_t next_frame_pointer =
+        is_64_bit ? *reinterpret_cast<const uint64_t*>(record)
+                  : *reinterpret_cast<const uint32_t*>(record);
+
+    // Callers’ frames are at higher addresses. Stopping otherwise also
+    // guarantees that a corrupt chain can’t loop.
+    if (next_frame_pointer <= frame_pointer) {
+      break;
+    }
+    frame_pointer = next_frame_pointer;
+  }
+
+  std::sort(anchors.begin(), anchors.end());
+  return anchors;
+}
+
+// Returns the distance from |slot| to the nearest of |anchors|, which must be
+// sorted and non-empty.
+uint64_t DistanceToNearestAnchor(const std::vector<uint64_t>& anchors,
+                                 uint64_t slot) {
+  auto it = std::lower_bound(anchors.begin(), anchors.end(), slot);
+  uint64_t distance = std::numeric_limits<uint64_t>::max();
+  if (it != anchors.end()) {
+    distance = *it - slot;
+  }
+  if (it != anchors.begin()) {
+    distance = std::min(distance, slot - *(it - 1));
   }
+  return distance;
 }
 
 }  // namespace
 
+std::vector<std::vector<CheckedRange<uint64_t>>>
+CaptureMemory::Delegate::GetReadableRanges(
+    const std::vector<CheckedRange<uint64_t>>& ranges) const {
+  std::vector<std::vector<CheckedRange<uint64_t>>> result;
+  result.reserve(ranges.size());
+  for (const auto& range : ranges) {
+    result.push_back(GetReadableRanges(range));
+  }
+  return result;
+}
+
+void CaptureMemory::Delegate::GetMappedAddressBounds(uint64_t* low,
+                                                     uint64_t* high) const {
+  *low = 0;
+  *high = MaxAddress(this);
+}
+
+bool CaptureMemory::Delegate::IsHeapAddress(uint64_t address) const {
+  return false;
+}
+
+std::vector<CheckedRange<uint64_t>>
+CaptureMemory::Delegate::GetExcludedRanges() const {
+  return std::vector<CheckedRange<uint64_t>>();
+}
+
+bool CaptureMemory::Delegate::HasBudgetRemaining() const {
+  return true;
+}
+
 // static
 void CaptureMemory::PointedToByContext(const CPUContext& context,
                                        Delegate* delegate) {
+  const ExcludedRanges excluded(delegate);
 #if defined(ARCH_CPU_X86_FAMILY)
   if (context.architecture == kCPUArchitectureX86_64) {
-    MaybeCaptureMemoryAround(delegate, context.x86_64->rax);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->rbx);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->rcx);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->rdx);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->rdi);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->rsi);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->rbp);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->r8);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->r9);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->r10);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->r11);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->r12);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->r13);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->r14);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->r15);
-    MaybeCaptureMemoryAround(delegate, context.x86_64->rip);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->rax);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->rbx);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->rcx);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->rdx);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->rdi);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->rsi);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->rbp);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->r8);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->r9);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->r10);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->r11);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->r12);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->r13);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->r14);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->r15);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86_64->rip);
   } else {
-    MaybeCaptureMemoryAround(delegate, context.x86->eax);
-    MaybeCaptureMemoryAround(delegate, context.x86->ebx);
-    MaybeCaptureMemoryAround(delegate, context.x86->ecx);
-    MaybeCaptureMemoryAround(delegate, context.x86->edx);
-    MaybeCaptureMemoryAround(delegate, context.x86->edi);
-    MaybeCaptureMemoryAround(delegate, context.x86->esi);
-    MaybeCaptureMemoryAround(delegate, context.x86->ebp);
-    MaybeCaptureMemoryAround(delegate, context.x86->eip);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86->eax);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86->ebx);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86->ecx);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86->edx);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86->edi);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86->esi);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86->ebp);
+    MaybeCaptureMemoryAround(delegate, excluded, context.x86->eip);
   }
 #else
 #error non-x86
@@ -102,26 +440,178 @@ void CaptureMemory::PointedToByContext(const CPUContext& context,
 // static
 void CaptureMemory::PointedToByMemoryRange(const MemorySnapshot& memory,
                                            Delegate* delegate) {
-  if (memory.Size() == 0)
+  std::unique_ptr<uint8_t[]> buffer;
+  std::vector<PointerCandidate> candidates;
+  if (!FindPointerCandidatesInRange(memory, delegate, &buffer, &candidates))
     return;
 
-  const size_t alignment =
-      delegate->Is64Bit() ? sizeof(uint64_t) : sizeof(uint32_t);
-  if (memory.Address() % alignment != 0 || memory.Size() % alignment != 0) {
-    LOG(ERROR) << "unaligned range";
+  // The same pointer often appears many times in a stack. Each is only
+  // captured once.
+  std::vector<uint64_t> values;
+  values.reserve(candidates.size());
+  for (const PointerCandidate& candidate : candidates) {
+    values.push_back(candidate.value);
+  }
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+
+  const ExcludedRanges excluded(delegate);
+  values.erase(std::remove_if(values.begin(),
+                              values.end(),
+                              [&excluded](uint64_t value) {
+                                return excluded.Covers(CaptureTarget(value));
+                              }),
+               values.end());
+
+  const auto readable_ranges =
+      delegate->GetReadableRanges(CaptureTargets(values));
+  for (const auto& ranges : readable_ranges) {
+    for (const auto& range : ranges) {
+      AddCapturedRange(range, excluded, delegate);
+    }
+  }
+}
+
+// static
+void CaptureMemory::PointedToByStack(const MemorySnapshot& stack,
+                                     const CPUContext& context,
+                                     Delegate* delegate) {
+  std::unique_ptr<uint8_t[]> buffer;
+  std::vector<PointerCandidate> candidates;
+  if (!FindPointerCandidatesInRange(stack, delegate, &buffer, &candidates))
     return;
+
+  const std::vector<uint64_t> anchors =
+      StackAnchors(stack, buffer.get(), context, delegate->Is64Bit());
+
+  // Rank each distinct value by the nearest place it was stored to the stack
+  // pointer or a frame record.
+  std::vector<std::pair<uint64_t, uint64_t>> ranked;
+  ranked.reserve(candidates.size());
+  for (const PointerCandidate& candidate : candidates) {
+    ranked.push_back(std::make_pair(
+        candidate.value, DistanceToNearestAnchor(anchors, candidate.slot)));
   }
+  std::sort(ranked.begin(), ranked.end());
+  ranked.erase(std::unique(ranked.begin(),
+                           ranked.end(),
+                           [](const std::pair<uint64_t, uint64_t>& a,
+                              const std::pair<uint64_t, uint64_t>& b) {
+                             return a.first == b.first;
+                           }),
+               ranked.end());
 
-  std::unique_ptr<uint8_t[]> buffer(new uint8_t[memory.Size()]);
-  if (!delegate->ReadMemory(memory.Address(), memory.Size(), buffer.get())) {
-    LOG(ERROR) << "ReadMemory";
+  const ExcludedRanges excluded(delegate);
+  ranked.erase(std::remove_if(ranked.begin(),
+                              ranked.end(),
+                              [&excluded](const std::pair<uint64_t, uint64_t>&
+                                              value_and_distance) {
+                                return excluded.Covers(
+                                    CaptureTarget(value_and_distance.first));
+                              }),
+               ranked.end());
+
+  std::vector<uint64_t> values;
+  values.reserve(ranked.size());
+  for (const auto& value_and_distance : ranked) {
+    values.push_back(value_and_distance.first);
+  }
+  const auto readable_ranges =
+      delegate->GetReadableRanges(CaptureTargets(values));
+
+  // Capture the closest values first, so that what the budget allows is the
+  // most useful.
+  std::priority_queue<std::pair<uint64_t, size_t>> queue;
+  for (size_t index = 0; index < ranked.size(); ++index) {
+    if (readable_ranges[index].empty()) {
+      continue;
+    }
+    uint64_t distance = ranked[index].second;
+    if (delegate->IsHeapAddress(ranked[index].first)) {
+      distance /= kHeapPreference;
+    }
+    queue.push(
+        std::make_pair(std::numeric_limits<uint64_t>::max() - distance, index));
+  }
+
+  while (!queue.empty() && delegate->HasBudgetRemaining()) {
+    for (const auto& range : readable_ranges[queue.top().second]) {
+      AddCapturedRange(range, excluded, delegate);
+    }
+    queue.pop();
+  }
+}
+
+// static
+void CaptureMemory::AroundException(const CPUContext& context,
+                                    uint64_t fault_address,
+                                    Delegate* delegate) {
+  const ExcludedRanges excluded(delegate);
+  std::vector<CheckedRange<uint64_t>> targets;
+
+  const uint64_t instruction_pointer = context.InstructionPointer();
+  const CheckedRange<uint64_t> code_range(
+      instruction_pointer - kCodeBytesBefore,
+      kCodeBytesBefore + kCodeBytesAfter);
+  if (IsPointerLike(delegate, instruction_pointer) &&
+      !excluded.Covers(code_range)) {
+    const auto code_ranges = delegate->GetReadableRanges(code_range);
+    for (const auto& range : code_ranges) {
+      AddCapturedRange(range, excluded, delegate);
+
+      // The instruction is decoded from as much of it as is readable.
+      if (!range.ContainsValue(instruction_pointer)) {
+        continue;
+      }
+      uint8_t instruction[kMaxX86InstructionLength];
+      const size_t instruction_size = static_cast<size_t>(
+          std::min(static_cast<uint64_t>(sizeof(instruction)),
+                   range.end() - instruction_pointer));
+      std::vector<uint64_t> operands;
+      if (delegate->ReadMemory(
+              instruction_pointer, instruction_size, instruction) &&
+          GetMemoryOperandAddresses(
+              instruction, instruction_size, context, &operands)) {
+        for (uint64_t operand : operands) {
+          if (IsPointerLike(delegate, operand)) {
+            targets.push_back(CheckedRange<uint64_t>(
+                operand - kRegisterByteOffset, kCaptureSize));
+          }
+        }
+      }
+    }
+  }
+
+  if (IsPointerLike(delegate, fault_address)) {
+    targets.push_back(CheckedRange<uint64_t>(
+        fault_address & ~(kFaultPageSize - 1), kFaultPageSize));
+  }
+
+  targets.erase(
+      std::remove_if(targets.begin(),
+                     targets.end(),
+                     [&excluded](const CheckedRange<uint64_t>& target) {
+                       return excluded.Covers(target);
+                     }),
+      targets.end());
+  if (targets.empty()) {
     return;
   }
 
-  if (delegate->Is64Bit())
-    CaptureAtPointersInRange<uint64_t>(buffer.get(), memory.Size(), delegate);
-  else
-    CaptureAtPointersInRange<uint32_t>(buffer.get(), memory.Size(), delegate);
+  // The operands and the fault page are usually near one another, and are
+  // checked for readability together.
+  std::sort(targets.begin(),
+            targets.end(),
+            [](const CheckedRange<uint64_t>& a,
+               const CheckedRange<uint64_t>& b) {
+              return a.base() < b.base();
+            });
+  const auto readable_ranges = delegate->GetReadableRanges(targets);
+  for (const auto& ranges : readable_ranges) {
+    for (const auto& range : ranges) {
+      AddCapturedRange(range, excluded, delegate);
+    }
+  }
 }
 
 }  // namespace internal
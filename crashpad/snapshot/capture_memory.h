@@ -58,6 +58,57 @@ class CaptureMemory {
     virtual std::vector<CheckedRange<uint64_t>> GetReadableRanges(
         const CheckedRange<uint64_t, uint64_t>& range) const = 0;
 
+    //! \brief Given several ranges to be read from the target process, returns
+    //!     the readable portions of each of them.
+    //!
+    //! The default implementation calls GetReadableRanges() for each element
+    //! of \a ranges. Delegates that can answer many queries at once more
+    //! cheaply should override it.
+    //!
+    //! \param[in] ranges The ranges being identified, sorted by base address.
+    //!
+    //! \return A vector with one element for each element of \a ranges, in the
+    //!     same order, each containing the portion of that range that is
+    //!     readable.
+    virtual std::vector<std::vector<CheckedRange<uint64_t>>> GetReadableRanges(
+        const std::vector<CheckedRange<uint64_t>>& ranges) const;
+
+    //! \brief Returns the bounds of the target process’ mapped address space.
+    //!
+    //! Values outside these bounds can’t point to readable memory, and are
+    //! discarded without being queried individually.
+    //!
+    //! The default implementation returns the entire address space.
+    //!
+    //! \param[out] low The lowest mapped address.
+    //! \param[out] high The highest mapped address, inclusive.
+    virtual void GetMappedAddressBounds(uint64_t* low, uint64_t* high) const;
+
+    //! \brief Determines whether an address is in writable heap memory.
+    //!
+    //! Memory captured for pointers into the heap is preferred when the
+    //! capture budget is limited. The default implementation returns `false`.
+    //!
+    //! \param[in] address The address to check.
+    //!
+    //! \return `true` if \a address is in memory that is likely to be part of a
+    //!     heap.
+    virtual bool IsHeapAddress(uint64_t address) const;
+
+    //! \brief Returns the ranges of the target process’ address space that
+    //!     are never to be captured.
+    //!
+    //! Pointers whose captures would fall entirely within these ranges are
+    //! discarded before their readability is queried, and captures that
+    //! overlap them are trimmed. The ranges may be in any order, and may
+    //! overlap. This is called once for each capture operation. The default
+    //! implementation returns no ranges.
+    virtual std::vector<CheckedRange<uint64_t>> GetExcludedRanges() const;
+
+    //! \brief Returns `false` if no further memory will be accepted by
+    //!     AddNewMemorySnapshot(). The default implementation returns `true`.
+    virtual bool HasBudgetRemaining() const;
+
     //! \brief Adds the given range representing a memory snapshot in the target
     //!     process to the result.
     virtual void AddNewMemorySnapshot(
@@ -79,6 +130,9 @@ class CaptureMemory {
   //! process,
   //!     captures a small amount of memory near the pointed to location.
   //!
+  //! Candidate values are filtered in bulk, deduplicated, and then checked for
+  //! readability in a single batch of queries.
+  //!
   //! \param[in] memory An existing MemorySnapshot of the range to search. The
   //!     base address and size must be pointer-aligned and an integral number
   //!     of
@@ -88,6 +142,48 @@ class CaptureMemory {
   static void PointedToByMemoryRange(const MemorySnapshot& memory,
                                      Delegate* delegate);
 
+  //! \brief For all pointer-like values in a thread’s stack, captures a small
+  //!     amount of memory near the pointed to location, most useful first.
+  //!
+  //! This is like PointedToByMemoryRange(), but when the delegate has a
+  //! capture budget, it decides what is captured within the budget. Values
+  //! stored near the stack pointer or near a frame pointer found by walking the
+  //! frame pointer chain from \a context are preferred, and pointers into heap
+  //! memory are preferred over others. Capture stops once the budget is
+  //! exhausted.
+  //!
+  //! \param[in] stack An existing MemorySnapshot of the thread’s stack. The
+  //!     base address and size must be pointer-aligned and an integral number
+  //!     of pointers long.
+  //! \param[in] context The thread’s context.
+  //! \param[in] delegate A Delegate that handles reading from the target
+  //!     process and adding new ranges.
+  static void PointedToByStack(const MemorySnapshot& stack,
+                               const CPUContext& context,
+                               Delegate* delegate);
+
+  //! \brief Captures the memory most likely to explain an exception, at a
+  //!     small, fixed cost.
+  //!
+  //! Three things are captured: the code around the instruction pointer in \a
+  //! context, the page containing \a fault_address, and the memory around
+  //! each memory operand of the instruction at the instruction pointer, found
+  //! by decoding it with GetMemoryOperandAddresses(). Unlike
+  //! PointedToByContext(), registers’ values are only treated as pointers if
+  //! the instruction uses them to address memory, so this is cheap enough to
+  //! do for every exception.
+  //!
+  //! \param[in] context The context of the thread that sustained the
+  //!     exception.
+  //! \param[in] fault_address The address of the data access that caused the
+  //!     exception, or `0` if it wasn’t caused by a data access or the address
+  //!     isn’t known.
+  //! \param[in] delegate A Delegate that handles reading from the target
+  //!     process and adding new ranges.
+  static void AroundException(const CPUContext& context,
+                              uint64_t fault_address,
+                              Delegate* delegate);
+
  private:
   DISALLOW_IMPLICIT_CONSTRUCTORS(CaptureMemory);
 };
@@ -0,0 +1,368 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/capture_memory.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "base/macros.h"
+#include "gtest/gtest.h"
+#include "snapshot/test/test_memory_snapshot.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+// A delegate for a 64-bit process with a single readable region.
+class TestDelegate : public internal::CaptureMemory::Delegate {
+ public:
+  TestDelegate(const std::vector<uint64_t>& memory,
+               uint64_t readable_base,
+               uint64_t readable_size)
+      : memory_(memory),
+        readable_(readable_base, readable_size),
+        captured_(),
+        excluded_(),
+        heap_base_(std::numeric_limits<uint64_t>::max()),
+        budget_(std::numeric_limits<size_t>::max()),
+        single_queries_(0),
+        batch_queries_(0) {}
+
+  ~TestDelegate() override {}
+
+  const std::vector<CheckedRange<uint64_t>>& captured() const {
+    return captured_;
+  }
+  size_t single_queries() const { return single_queries_; }
+  size_t batch_queries() const { return batch_queries_; }
+
+  // Addresses at or above |heap_base| are treated as heap addresses.
+  void set_heap_base(uint64_t heap_base) { heap_base_ = heap_base; }
+
+  // Limits the number of ranges that will be captured.
+  void set_budget(size_t budget) { budget_ = budget; }
+
+  void set_excluded(const std::vector<CheckedRange<uint64_t>>& excluded) {
+    excluded_ = excluded;
+  }
+
+  // CaptureMemory::Delegate:
+  bool Is64Bit() const override { return true; }
+
+  bool ReadMemory(uint64_t at,
+                  uint64_t num_bytes,
+                  void* into) const override {
+    EXPECT_EQ(num_bytes, memory_.size() * sizeof(memory_[0]));
+    memcpy(into, memory_.data(), static_cast<size_t>(num_bytes));
+    return true;
+  }
+
+  std::vector<CheckedRange<uint64_t>> GetReadableRanges(
+      const CheckedRange<uint64_t, uint64_t>& range) const override {
+    ++single_queries_;
+    std::vector<CheckedRange<uint64_t>> result;
+    if (readable_.OverlapsRange(range)) {
+      const uint64_t base = std::max(range.base(), readable_.base());
+      const uint64_t end = std::min(range.end(), readable_.end());
+      result.push_back(CheckedRange<uint64_t>(base, end - base));
+    }
+    return result;
+  }
+
+  std::vector<std::vector<CheckedRange<uint64_t>>> GetReadableRanges(
+      const std::vector<CheckedRange<uint64_t>>& ranges) const override {
+    ++batch_queries_;
+    return Delegate::GetReadableRanges(ranges);
+  }
+
+  void GetMappedAddressBounds(uint64_t* low, uint64_t* high) const override {
+    *low = readable_.base();
+    *high = readable_.end() - 1;
+  }
+
+  bool IsHeapAddress(uint64_t address) const override {
+    return address >= heap_base_;
+  }
+
+  std::vector<CheckedRange<uint64_t>> GetExcludedRanges() const override {
+    return excluded_;
+  }
+
+  bool HasBudgetRemaining() const override {
+    return captured_.size() < budget_;
+  }
+
+  void AddNewMemorySnapshot(
+      const CheckedRange<uint64_t, uint64_t>& range) override {
+    if (HasBudgetRemaining()) {
+      captured_.push_back(range);
+    }
+  }
+
+ private:
+  std::vector<uint64_t> memory_;
+  CheckedRange<uint64_t> readable_;
+  std::vector<CheckedRange<uint64_t>> captured_;
+  std::vector<CheckedRange<uint64_t>> excluded_;
+  uint64_t heap_base_;
+  size_t budget_;
+  mutable size_t single_queries_;
+  mutable size_t batch_queries_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestDelegate);
+};
+
+TEST(CaptureMemory, PointedToByMemoryRange) {
+  constexpr uint64_t kReadableBase = 0x100000;
+  constexpr uint64_t kReadableSize = 0x100000;
+
+  // More values than fit in a single block of the scanner, with candidates
+  // both inside and outside of a block.
+  std::vector<uint64_t> memory(40, 0);
+  memory[1] = 0x180000;
+  memory[3] = 0x150000;
+  memory[5] = 0xffffffffffffffff;
+  memory[7] = 0x50000;
+  memory[9] = kReadableBase + 0x10;
+  memory[20] = 0x150000;
+  memory[38] = 0x150000;
+  memory[39] = kReadableBase + kReadableSize + 0x1000;
+
+  TestDelegate delegate(memory, kReadableBase, kReadableSize);
+  TestMemorySnapshot stack;
+  stack.SetAddress(0x7fff0000);
+  stack.SetSize(memory.size() * sizeof(memory[0]));
+
+  internal::CaptureMemory::PointedToByMemoryRange(stack, &delegate);
+
+  // Each distinct candidate is queried once, in one batch, and captures are
+  // made in address order.
+  EXPECT_EQ(delegate.batch_queries(), 1u);
+  EXPECT_EQ(delegate.single_queries(), 3u);
+
+  const auto& captured = delegate.captured();
+  ASSERT_EQ(captured.size(), 3u);
+  EXPECT_EQ(captured[0].base(), kReadableBase);
+  EXPECT_EQ(captured[0].size(), 0x190u);
+  EXPECT_EQ(captured[1].base(), 0x150000u - 128);
+  EXPECT_EQ(captured[1].size(), 512u);
+  EXPECT_EQ(captured[2].base(), 0x180000u - 128);
+  EXPECT_EQ(captured[2].size(), 512u);
+}
+
+TEST(CaptureMemory, PointedToByMemoryRangeExcluded) {
+  constexpr uint64_t kReadableBase = 0x100000;
+  constexpr uint64_t kReadableSize = 0x100000;
+
+  std::vector<uint64_t> memory(4, 0);
+  memory[0] = 0x120000;
+  memory[1] = 0x150000;
+  memory[2] = 0x180000;
+
+  TestDelegate delegate(memory, kReadableBase, kReadableSize);
+
+  // The capture for 0x180000 is excluded entirely, and lies across two
+  // overlapping ranges. The capture for 0x150000 is excluded from its pointed
+  // to address on.
+  delegate.set_excluded({CheckedRange<uint64_t>(0x178000, 0x10000),
+                         CheckedRange<uint64_t>(0x150000, 0x1000),
+                         CheckedRange<uint64_t>(0x170000, 0x10000)});
+  TestMemorySnapshot stack;
+  stack.SetAddress(0x7fff0000);
+  stack.SetSize(memory.size() * sizeof(memory[0]));
+
+  internal::CaptureMemory::PointedToByMemoryRange(stack, &delegate);
+
+  // The excluded value isn’t queried.
+  EXPECT_EQ(delegate.single_queries(), 2u);
+
+  const auto& captured = delegate.captured();
+  ASSERT_EQ(captured.size(), 2u);
+  EXPECT_EQ(captured[0].base(), 0x120000u - 128);
+  EXPECT_EQ(captured[0].size(), 512u);
+  EXPECT_EQ(captured[1].base(), 0x150000u - 128);
+  EXPECT_EQ(captured[1].size(), 128u);
+}
+
+TEST(CaptureMemory, PointedToByMemoryRangeEmpty) {
+  std::vector<uint64_t> memory;
+
+  TestDelegate delegate(memory, 0x100000, 0x100000);
+  TestMemorySnapshot stack;
+  stack.SetAddress(0x7fff0000);
+  stack.SetSize(0);
+
+  internal::CaptureMemory::PointedToByMemoryRange(stack, &delegate);
+  EXPECT_EQ(delegate.batch_queries(), 0u);
+  EXPECT_TRUE(delegate.captured().empty());
+}
+
+TEST(CaptureMemory, PointedToByStack) {
+  constexpr uint64_t kStackAddress = 0x7fff0000;
+  constexpr uint64_t kReadableBase = 0x100000;
+  constexpr uint64_t kReadableSize = 0x100000;
+
+  std::vector<uint64_t> memory(64, 0);
+
+  // Stored 16 bytes from the stack pointer.
+  memory[30] = 0x120000;
+
+  // Stored 8 bytes from a frame record.
+  memory[47] = 0x130000;
+
+  // Stored 256 bytes from the stack pointer.
+  memory[0] = 0x140000;
+
+  // Stored 176 bytes from the stack pointer, but a heap address.
+  memory[10] = 0x190000;
+
+  // The frame record’s saved frame pointer ends the chain.
+  memory[48] = 0;
+
+  CPUContextX86_64 context_x86_64 = {};
+  context_x86_64.rsp = kStackAddress + 32 * sizeof(memory[0]);
+  context_x86_64.rbp = kStackAddress + 48 * sizeof(memory[0]);
+  CPUContext context;
+  context.architecture = kCPUArchitectureX86_64;
+  context.x86_64 = &context_x86_64;
+
+  TestMemorySnapshot stack;
+  stack.SetAddress(kStackAddress);
+  stack.SetSize(memory.size() * sizeof(memory[0]));
+
+  {
+    TestDelegate delegate(memory, kReadableBase, kReadableSize);
+    delegate.set_heap_base(0x180000);
+    internal::CaptureMemory::PointedToByStack(stack, context, &delegate);
+
+    // Without a budget, everything is captured, most useful first.
+    EXPECT_EQ(delegate.batch_queries(), 1u);
+    const auto& captured = delegate.captured();
+    ASSERT_EQ(captured.size(), 4u);
+    EXPECT_EQ(captured[0].base(), 0x130000u - 128);
+    EXPECT_EQ(captured[1].base(), 0x120000u - 128);
+    EXPECT_EQ(captured[2].base(), 0x190000u - 128);
+    EXPECT_EQ(captured[3].base(), 0x140000u - 128);
+  }
+
+  {
+    TestDelegate delegate(memory, kReadableBase, kReadableSize);
+    delegate.set_heap_base(0x180000);
+    delegate.set_budget(2);
+    internal::CaptureMemory::PointedToByStack(stack, context, &delegate);
+
+    const auto& captured = delegate.captured();
+    ASSERT_EQ(captured.size(), 2u);
+    EXPECT_EQ(captured[0].base(), 0x130000u - 128);
+    EXPECT_EQ(captured[1].base(), 0x120000u - 128);
+  }
+}
+
+// A TestDelegate whose memory holds an instruction at a given address.
+class InstructionTestDelegate : public TestDelegate {
+ public:
+  InstructionTestDelegate(const std::vector<uint8_t>& instruction,
+                          uint64_t instruction_address,
+                          uint64_t readable_base,
+                          uint64_t readable_size)
+      : TestDelegate(std::vector<uint64_t>(), readable_base, readable_size),
+        instruction_(instruction),
+        instruction_address_(instruction_address) {}
+
+  ~InstructionTestDelegate() override {}
+
+  bool ReadMemory(uint64_t at,
+                  uint64_t num_bytes,
+                  void* into) const override {
+    EXPECT_EQ(at, instruction_address_);
+    memset(into, 0xcc, static_cast<size_t>(num_bytes));
+    memcpy(into,
+           instruction_.data(),
+           std::min(instruction_.size(), static_cast<size_t>(num_bytes)));
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> instruction_;
+  uint64_t instruction_address_;
+
+  DISALLOW_COPY_AND_ASSIGN(InstructionTestDelegate);
+};
+
+TEST(CaptureMemory, AroundException) {
+  constexpr uint64_t kReadableBase = 0x100000;
+  constexpr uint64_t kReadableSize = 0x10000;
+
+  CPUContextX86_64 context_x86_64 = {};
+  context_x86_64.rip = 0x101000;
+  context_x86_64.rbx = 0x108000;
+  CPUContext context;
+  context.architecture = kCPUArchitectureX86_64;
+  context.x86_64 = &context_x86_64;
+
+  // mov rax, [rbx + 0x10]
+  const std::vector<uint8_t> instruction = {0x48, 0x8b, 0x43, 0x10};
+
+  {
+    InstructionTestDelegate delegate(
+        instruction, context_x86_64.rip, kReadableBase, kReadableSize);
+    internal::CaptureMemory::AroundException(context, 0x108010, &delegate);
+
+    // The code, the memory around the operand, and the fault page. The
+    // operand and fault page are checked for readability together.
+    EXPECT_EQ(delegate.batch_queries(), 1u);
+    const auto& captured = delegate.captured();
+    ASSERT_EQ(captured.size(), 3u);
+    EXPECT_EQ(captured[0].base(), 0x101000u - 256);
+    EXPECT_EQ(captured[0].size(), 512u);
+    EXPECT_EQ(captured[1].base(), 0x108010u - 128);
+    EXPECT_EQ(captured[1].size(), 512u);
+    EXPECT_EQ(captured[2].base(), 0x108000u);
+    EXPECT_EQ(captured[2].size(), 4096u);
+  }
+
+  {
+    // Only as much of the code as is readable is captured, and the
+    // instruction is decoded from it. The fault address isn’t readable.
+    context_x86_64.rip = kReadableBase + kReadableSize - sizeof(instruction);
+    InstructionTestDelegate delegate(
+        instruction, context_x86_64.rip, kReadableBase, kReadableSize);
+    internal::CaptureMemory::AroundException(context, 0x200000, &delegate);
+
+    const auto& captured = delegate.captured();
+    ASSERT_EQ(captured.size(), 2u);
+    EXPECT_EQ(captured[0].base(), context_x86_64.rip - 256);
+    EXPECT_EQ(captured[0].end(), kReadableBase + kReadableSize);
+    EXPECT_EQ(captured[1].base(), 0x108010u - 128);
+  }
+
+  {
+    // A jump to unmapped memory leaves nothing to decode or capture.
+    context_x86_64.rip = 0x200000;
+    InstructionTestDelegate delegate(
+        instruction, context_x86_64.rip, kReadableBase, kReadableSize);
+    internal::CaptureMemory::AroundException(
+        context, context_x86_64.rip, &delegate);
+
+    EXPECT_TRUE(delegate.captured().empty());
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -170,4 +170,16 @@ uint64_t CPUContext::InstructionPointer() const {
   }
 }
 
+uint64_t CPUContext::StackPointer() const {
+  switch (architecture) {
+    case kCPUArchitectureX86:
+      return x86->esp;
+    case kCPUArchitectureX86_64:
+      return x86_64->rsp;
+    default:
+      NOTREACHED();
+      return ~0ull;
+  }
+}
+
 }  // namespace crashpad
@@ -0,0 +1,240 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/crash_signature.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "snapshot/cpu_context.h"
+#include "snapshot/exception_snapshot.h"
+#include "snapshot/memory_snapshot.h"
+#include "snapshot/module_snapshot.h"
+#include "snapshot/process_snapshot.h"
+#include "snapshot/thread_snapshot.h"
+
+namespace crashpad {
+
+namespace {
+
+// Accumulates a 64-bit FNV-1a hash.
+class SignatureHash {
+ public:
+  SignatureHash() : hash_(0xcbf29ce484222325) {}
+
+  void Add(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t index = 0; index < size; ++index) {
+      hash_ = (hash_ ^ bytes[index]) * 0x100000001b3;
+    }
+  }
+
+  void AddUInt64(uint64_t value) { Add(&value, sizeof(value)); }
+
+  void AddString(const std::string& string) {
+    AddUInt64(string.size());
+    Add(string.data(), string.size());
+  }
+
+  uint64_t hash() const { return hash_; }
+
+ private:
+  uint64_t hash_;
+
+  DISALLOW_COPY_AND_ASSIGN(SignatureHash);
+};
+
+// A loaded module’s address range, and its name without any directory.
+struct ModuleRange {
+  uint64_t address;
+  uint64_t size;
+  std::string name;
+
+  bool operator<(const ModuleRange& other) const {
+    return address < other.address;
+  }
+};
+
+// Locates the modules containing addresses.
+class ModuleRanges {
+ public:
+  explicit ModuleRanges(const ProcessSnapshot* process_snapshot) : ranges_() {
+    for (const ModuleSnapshot* module : process_snapshot->Modules()) {
+      if (!module->Size()) {
+        continue;
+      }
+      ModuleRange range;
+      range.address = module->Address();
+      range.size = module->Size();
+      range.name = module->Name();
+      const size_t separator = range.name.find_last_of("/\\");
+      if (separator != std::string::npos) {
+        range.name = range.name.substr(separator + 1);
+      }
+      ranges_.push_back(range);
+    }
+    std::sort(ranges_.begin(), ranges_.end());
+  }
+
+  // Returns the module containing |address|, or nullptr if none does.
+  const ModuleRange* Find(uint64_t address) const {
+    ModuleRange key;
+    key.address = address;
+    auto it = std::upper_bound(ranges_.begin(), ranges_.end(), key);
+    if (it == ranges_.begin()) {
+      return nullptr;
+    }
+    --it;
+    return address - it->address < it->size ? &*it : nullptr;
+  }
+
+ private:
+  std::vector<ModuleRange> ranges_;
+
+  DISALLOW_COPY_AND_ASSIGN(ModuleRanges);
+};
+
+// Adds the location of |address| to |hash| as its module’s name and its offset
+// into the module. Returns false without changing |hash| if no module contains
+// |address|.
+bool AddModuleOffset(const ModuleRanges& modules,
+                     uint64_t address,
+                     SignatureHash* hash) {
+  const ModuleRange* module = modules.Find(address);
+  if (!module) {
+    return false;
+  }
+  hash->AddString(module->name);
+  hash->AddUInt64(address - module->address);
+  return true;
+}
+
+// Copies a stack’s contents.
+class StackReader : public MemorySnapshot::Delegate {
+ public:
+  StackReader() : contents_() {}
+  ~StackReader() override {}
+
+  const std::vector<uint8_t>& contents() const { return contents_; }
+
+  // MemorySnapshot::Delegate:
+  bool MemorySnapshotDelegateRead(void* data, size_t size) override {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    contents_.assign(bytes, bytes + size);
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> contents_;
+
+  DISALLOW_COPY_AND_ASSIGN(StackReader);
+};
+
+// Adds up to |frame_count| return addresses found on |stack| above
+// |stack_pointer| to |hash|.
+void AddReturnAddresses(const ModuleRanges& modules,
+                        const MemorySnapshot* stack,
+                        uint64_t stack_pointer,
+                        size_t pointer_size,
+                        size_t frame_count,
+                        SignatureHash* hash) {
+  StackReader reader;
+  if (!frame_count || !stack->Read(&reader)) {
+    return;
+  }
+  const std::vector<uint8_t>& contents = reader.contents();
+
+  // Scan from the stack pointer, or from the start of the captured stack if the
+  // stack pointer lies outside of it, at the stack’s natural alignment.
+  uint64_t offset = 0;
+  if (stack_pointer > stack->Address() &&
+      stack_pointer - stack->Address() < contents.size()) {
+    offset = stack_pointer - stack->Address();
+  }
+  offset += (pointer_size - (stack->Address() + offset) % pointer_size) %
+            pointer_size;
+
+  size_t frames = 0;
+  for (; offset + pointer_size <= contents.size() && frames < frame_count;
+       offset += pointer_size) {
+    uint64_t value = 0;
+    memcpy(&value, &contents[static_cast<size_t>(offset)], pointer_size);
+    if (AddModuleOffset(modules, value, hash)) {
+      ++frames;
+    }
+  }
+}
+
+}  // namespace
+
+bool ComputeCrashSignature(const ProcessSnapshot* process_snapshot,
+                           size_t frame_count,
+                           uint64_t* signature) {
+  const ExceptionSnapshot* exception = process_snapshot->Exception();
+  if (!exception) {
+    return false;
+  }
+
+  const ModuleRanges modules(process_snapshot);
+
+  SignatureHash hash;
+  hash.AddUInt64(exception->Exception());
+  if (!AddModuleOffset(modules, exception->ExceptionAddress(), &hash)) {
+    // Code outside of any module, such as generated code, has no stable
+    // location to identify it by.
+    hash.AddString(std::string());
+  }
+
+  const CPUContext* context = exception->Context();
+  uint64_t stack_pointer = 0;
+  size_t pointer_size = sizeof(uint64_t);
+  if (context) {
+    switch (context->architecture) {
+      case kCPUArchitectureX86:
+        pointer_size = sizeof(uint32_t);
+        stack_pointer = context->StackPointer();
+        break;
+      case kCPUArchitectureX86_64:
+        stack_pointer = context->StackPointer();
+        break;
+      default:
+        break;
+    }
+  }
+
+  for (const ThreadSnapshot* thread : process_snapshot->Threads()) {
+    if (thread->ThreadID() != exception->ThreadID()) {
+      continue;
+    }
+    const MemorySnapshot* stack = thread->Stack();
+    if (stack) {
+      AddReturnAddresses(modules,
+                         stack,
+                         stack_pointer,
+                         pointer_size,
+                         frame_count,
+                         &hash);
+    }
+    break;
+  }
+
+  *signature = hash.hash();
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,55 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_CRASH_SIGNATURE_H_
+#define CRASHPAD_SNAPSHOT_CRASH_SIGNATURE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace crashpad {
+
+class ProcessSnapshot;
+
+//! \brief The number of return addresses that ComputeCrashSignature()
+//!     considers by default.
+constexpr size_t kCrashSignatureDefaultFrameCount = 4;
+
+//! \brief Computes a signature identifying crashes that are likely to share a
+//!     cause.
+//!
+//! The signature combines the exception code, the module containing the
+//! exception address together with the address’ offset into it, and the
+//! modules and offsets of up to \a frame_count return addresses found on the
+//! stack of the thread that raised the exception. Offsets are used in place of
+//! addresses so that the signature is unaffected by where modules were loaded.
+//!
+//! Return addresses are found by scanning the stack upwards from the stack
+//! pointer for values that point into a loaded module, without unwinding. Some
+//! of these may be other pointers into modules’ data, but because the same
+//! code tends to leave the same values on the stack, they serve to distinguish
+//! crashes just as well.
+//!
+//! \param[in] process_snapshot The snapshot of the crashed process.
+//! \param[in] frame_count The number of return addresses to consider.
+//! \param[out] signature The signature.
+//!
+//! \return `true` on success. `false` if \a process_snapshot has no exception.
+bool ComputeCrashSignature(const ProcessSnapshot* process_snapshot,
+                           size_t frame_count,
+                           uint64_t* signature);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_CRASH_SIGNATURE_H_
@@ -0,0 +1,208 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/crash_signature.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "snapshot/test/test_exception_snapshot.h"
+#include "snapshot/test/test_module_snapshot.h"
+#include "snapshot/test/test_process_snapshot.h"
+#include "snapshot/test/test_thread_snapshot.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr uint64_t kThreadID = 7;
+constexpr uint64_t kStackAddress = 0x7000;
+
+// A MemorySnapshot carrying a sequence of 64-bit values.
+class StackMemorySnapshot final : public MemorySnapshot {
+ public:
+  StackMemorySnapshot(uint64_t address, const std::vector<uint64_t>& values)
+      : MemorySnapshot(), address_(address), values_(values) {}
+  ~StackMemorySnapshot() override {}
+
+  // MemorySnapshot:
+
+  uint64_t Address() const override { return address_; }
+  size_t Size() const override { return values_.size() * sizeof(values_[0]); }
+  bool Read(Delegate* delegate) const override {
+    return delegate->MemorySnapshotDelegateRead(
+        const_cast<uint64_t*>(values_.data()), Size());
+  }
+  const MemorySnapshot* MergeWithOtherSnapshot(
+      const MemorySnapshot* other) const override {
+    return nullptr;
+  }
+
+ private:
+  uint64_t address_;
+  std::vector<uint64_t> values_;
+
+  DISALLOW_COPY_AND_ASSIGN(StackMemorySnapshot);
+};
+
+// Describes a crash in a process with two modules, libfoo and libbar, each
+// 0x1000 bytes long.
+struct Crash {
+  Crash()
+      : libfoo_address(0x10000),
+        libbar_address(0x20000),
+        libfoo_path("/usr/lib/libfoo.so"),
+        exception(11),
+        exception_offset(0x100),
+        stack_pointer(kStackAddress),
+        stack({1, 0x20010, 2, 0x10200, 0x20300}) {}
+
+  uint64_t libfoo_address;
+  uint64_t libbar_address;
+  std::string libfoo_path;
+  uint32_t exception;
+  uint64_t exception_offset;
+  uint64_t stack_pointer;
+
+  // Values on the stack, as though libfoo were loaded at 0x10000 and libbar at
+  // 0x20000. They are relocated to the actual load addresses by Relocate().
+  std::vector<uint64_t> stack;
+};
+
+uint64_t Relocate(const Crash& crash, uint64_t value) {
+  if (value >= 0x20000) {
+    return value - 0x20000 + crash.libbar_address;
+  }
+  if (value >= 0x10000) {
+    return value - 0x10000 + crash.libfoo_address;
+  }
+  return value;
+}
+
+bool Signature(const Crash& crash, size_t frame_count, uint64_t* signature) {
+  TestProcessSnapshot process_snapshot;
+
+  auto libfoo = base::WrapUnique(new TestModuleSnapshot());
+  libfoo->SetName(crash.libfoo_path);
+  libfoo->SetAddressAndSize(crash.libfoo_address, 0x1000);
+  process_snapshot.AddModule(std::move(libfoo));
+
+  auto libbar = base::WrapUnique(new TestModuleSnapshot());
+  libbar->SetName("libbar.so");
+  libbar->SetAddressAndSize(crash.libbar_address, 0x1000);
+  process_snapshot.AddModule(std::move(libbar));
+
+  std::vector<uint64_t> stack;
+  for (uint64_t value : crash.stack) {
+    stack.push_back(Relocate(crash, value));
+  }
+  auto thread = base::WrapUnique(new TestThreadSnapshot());
+  thread->SetThreadID(kThreadID);
+  thread->SetStack(
+      base::WrapUnique(new StackMemorySnapshot(kStackAddress, stack)));
+  process_snapshot.AddThread(std::move(thread));
+
+  auto exception = base::WrapUnique(new TestExceptionSnapshot());
+  exception->SetThreadID(kThreadID);
+  exception->SetException(crash.exception);
+  exception->SetExceptionAddress(crash.libfoo_address +
+                                 crash.exception_offset);
+  CPUContext* context = exception->MutableContext();
+  context->architecture = kCPUArchitectureX86_64;
+  context->x86_64->rsp = crash.stack_pointer;
+  process_snapshot.SetException(std::move(exception));
+
+  return ComputeCrashSignature(&process_snapshot, frame_count, signature);
+}
+
+uint64_t Signature(const Crash& crash) {
+  uint64_t signature;
+  EXPECT_TRUE(
+      Signature(crash, kCrashSignatureDefaultFrameCount, &signature));
+  return signature;
+}
+
+TEST(CrashSignature, NoException) {
+  TestProcessSnapshot process_snapshot;
+  uint64_t signature;
+  EXPECT_FALSE(ComputeCrashSignature(
+      &process_snapshot, kCrashSignatureDefaultFrameCount, &signature));
+}
+
+TEST(CrashSignature, IndependentOfLoadAddresses) {
+  const Crash crash;
+  Crash relocated;
+  relocated.libfoo_address = 0x7fff0000;
+  relocated.libbar_address = 0x30000;
+  relocated.libfoo_path = "C:\\Program Files\\libfoo.so";
+  EXPECT_EQ(Signature(relocated), Signature(crash));
+}
+
+TEST(CrashSignature, Exception) {
+  const Crash crash;
+  Crash other_exception;
+  other_exception.exception = 6;
+  EXPECT_NE(Signature(other_exception), Signature(crash));
+
+  Crash other_address;
+  other_address.exception_offset = 0x104;
+  EXPECT_NE(Signature(other_address), Signature(crash));
+}
+
+TEST(CrashSignature, ReturnAddresses) {
+  const Crash crash;
+  Crash other_return_address;
+  other_return_address.stack[3] = 0x10204;
+  EXPECT_NE(Signature(other_return_address), Signature(crash));
+
+  // Values that don’t point into a module are not considered.
+  Crash other_value;
+  other_value.stack[0] = 3;
+  EXPECT_EQ(Signature(other_value), Signature(crash));
+
+  // Values below the stack pointer are not considered.
+  Crash high_stack_pointer;
+  high_stack_pointer.stack_pointer = kStackAddress + 2 * sizeof(uint64_t);
+  EXPECT_NE(Signature(high_stack_pointer), Signature(crash));
+  Crash below_stack_pointer = high_stack_pointer;
+  below_stack_pointer.stack[1] = 0x20014;
+  EXPECT_EQ(Signature(below_stack_pointer), Signature(high_stack_pointer));
+}
+
+TEST(CrashSignature, FrameCount) {
+  const Crash crash;
+  Crash other_third_frame;
+  other_third_frame.stack[4] = 0x20304;
+
+  uint64_t signature;
+  uint64_t other_signature;
+  ASSERT_TRUE(Signature(crash, 2, &signature));
+  ASSERT_TRUE(Signature(other_third_frame, 2, &other_signature));
+  EXPECT_EQ(other_signature, signature);
+
+  ASSERT_TRUE(Signature(crash, 3, &signature));
+  ASSERT_TRUE(Signature(other_third_frame, 3, &other_signature));
+  EXPECT_NE(other_signature, signature);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -39,7 +39,9 @@ TriState CrashpadInfoClientOptions::TriStateFromCrashpadInfo(
 CrashpadInfoClientOptions::CrashpadInfoClientOptions()
     : crashpad_handler_behavior(TriState::kUnset),
       system_crash_reporter_forwarding(TriState::kUnset),
-      gather_indirectly_referenced_memory(TriState::kUnset) {
+      gather_indirectly_referenced_memory(TriState::kUnset),
+      indirectly_referenced_memory_cap(0),
+      capture_deadline_ms(0) {
 }
 
 }  // namespace crashpad
@@ -65,6 +65,9 @@ struct CrashpadInfoClientOptions {
 
   //! \sa CrashpadInfo::set_gather_indirectly_referenced_memory()
   uint32_t indirectly_referenced_memory_cap;
+
+  //! \sa CrashpadInfo::set_capture_deadline_ms()
+  uint32_t capture_deadline_ms;
 };
 
 }  // namespace crashpad
@@ -0,0 +1,964 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/elf/elf_eh_frame_reader.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+namespace {
+
+// Pointer encodings, from the Linux Standard Base Core Specification’s
+// description of .eh_frame.
+constexpr uint8_t kDW_EH_PE_absptr = 0x00;
+constexpr uint8_t kDW_EH_PE_uleb128 = 0x01;
+constexpr uint8_t kDW_EH_PE_udata2 = 0x02;
+constexpr uint8_t kDW_EH_PE_udata4 = 0x03;
+constexpr uint8_t kDW_EH_PE_udata8 = 0x04;
+constexpr uint8_t kDW_EH_PE_sleb128 = 0x09;
+constexpr uint8_t kDW_EH_PE_sdata2 = 0x0a;
+constexpr uint8_t kDW_EH_PE_sdata4 = 0x0b;
+constexpr uint8_t kDW_EH_PE_sdata8 = 0x0c;
+constexpr uint8_t kDW_EH_PE_pcrel = 0x10;
+constexpr uint8_t kDW_EH_PE_datarel = 0x30;
+constexpr uint8_t kDW_EH_PE_omit = 0xff;
+
+// Call frame instructions, from the DWARF 4 specification, section 7.23, and
+// the GNU extensions.
+constexpr uint8_t kDW_CFA_advance_loc = 0x40;
+constexpr uint8_t kDW_CFA_offset = 0x80;
+constexpr uint8_t kDW_CFA_restore = 0xc0;
+constexpr uint8_t kDW_CFA_nop = 0x00;
+constexpr uint8_t kDW_CFA_set_loc = 0x01;
+constexpr uint8_t kDW_CFA_advance_loc1 = 0x02;
+constexpr uint8_t kDW_CFA_advance_loc2 = 0x03;
+constexpr uint8_t kDW_CFA_advance_loc4 = 0x04;
+constexpr uint8_t kDW_CFA_offset_extended = 0x05;
+constexpr uint8_t kDW_CFA_restore_extended = 0x06;
+constexpr uint8_t kDW_CFA_undefined = 0x07;
+constexpr uint8_t kDW_CFA_same_value = 0x08;
+constexpr uint8_t kDW_CFA_register = 0x09;
+constexpr uint8_t kDW_CFA_remember_state = 0x0a;
+constexpr uint8_t kDW_CFA_restore_state = 0x0b;
+constexpr uint8_t kDW_CFA_def_cfa = 0x0c;
+constexpr uint8_t kDW_CFA_def_cfa_register = 0x0d;
+constexpr uint8_t kDW_CFA_def_cfa_offset = 0x0e;
+constexpr uint8_t kDW_CFA_def_cfa_expression = 0x0f;
+constexpr uint8_t kDW_CFA_expression = 0x10;
+constexpr uint8_t kDW_CFA_offset_extended_sf = 0x11;
+constexpr uint8_t kDW_CFA_def_cfa_sf = 0x12;
+constexpr uint8_t kDW_CFA_def_cfa_offset_sf = 0x13;
+constexpr uint8_t kDW_CFA_val_offset = 0x14;
+constexpr uint8_t kDW_CFA_val_offset_sf = 0x15;
+constexpr uint8_t kDW_CFA_val_expression = 0x16;
+constexpr uint8_t kDW_CFA_AARCH64_negate_ra_state = 0x2d;
+constexpr uint8_t kDW_CFA_GNU_args_size = 0x2e;
+constexpr uint8_t kDW_CFA_GNU_negative_offset_extended = 0x2f;
+
+// The largest CIE or FDE that will be read.
+constexpr VMSize kMaxRecordSize = 64 * 1024;
+
+// Reads values from a CIE or FDE, or from .eh_frame_hdr, copied from the
+// target process. address is where data begins in the target process, which
+// pc-relative pointers are relative to.
+class Cursor {
+ public:
+  Cursor(const std::string& data, VMAddress address, bool is_64_bit)
+      : data_(data), address_(address), offset_(0), is_64_bit_(is_64_bit) {}
+
+  VMAddress Address() const { return address_ + offset_; }
+  size_t PointerSize() const { return is_64_bit_ ? 8 : 4; }
+  size_t Offset() const { return offset_; }
+  size_t Remaining() const { return data_.size() - offset_; }
+
+  bool Seek(size_t offset) {
+    if (offset > data_.size()) {
+      return false;
+    }
+    offset_ = offset;
+    return true;
+  }
+
+  bool Skip(uint64_t size) {
+    if (size > Remaining()) {
+      return false;
+    }
+    offset_ += size;
+    return true;
+  }
+
+  template <typename T>
+  bool Read(T* value) {
+    if (Remaining() < sizeof(*value)) {
+      return false;
+    }
+    memcpy(value, &data_[offset_], sizeof(*value));
+    offset_ += sizeof(*value);
+    return true;
+  }
+
+  bool ReadULEB128(uint64_t* value) {
+    uint64_t result = 0;
+    unsigned int shift = 0;
+    uint8_t byte;
+    do {
+      if (!Read(&byte)) {
+        return false;
+      }
+      if (shift < 64) {
+        result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      }
+      shift += 7;
+    } while (byte & 0x80);
+    *value = result;
+    return true;
+  }
+
+  bool ReadSLEB128(int64_t* value) {
+    uint64_t result = 0;
+    unsigned int shift = 0;
+    uint8_t byte;
+    do {
+      if (!Read(&byte)) {
+        return false;
+      }
+      if (shift < 64) {
+        result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      }
+      shift += 7;
+    } while (byte & 0x80);
+    if (shift < 64 && (byte & 0x40)) {
+      result |= ~uint64_t{0} << shift;
+    }
+    *value = static_cast<int64_t>(result);
+    return true;
+  }
+
+  bool ReadCString(std::string* string) {
+    const size_t end = data_.find('\0', offset_);
+    if (end == std::string::npos) {
+      return false;
+    }
+    string->assign(data_, offset_, end - offset_);
+    offset_ = end + 1;
+    return true;
+  }
+
+  // Reads a pointer in |encoding|. data_base is the base for datarel
+  // pointers, or 0 if there is none. An indirect pointer is returned as the
+  // address it is stored at, because only personality routines are indirect,
+  // and they aren’t needed to unwind.
+  bool ReadEncodedPointer(uint8_t encoding,
+                          VMAddress data_base,
+                          VMAddress* pointer) {
+    if (encoding == kDW_EH_PE_omit) {
+      return false;
+    }
+
+    const VMAddress field_address = Address();
+    uint64_t value;
+    switch (encoding & 0x0f) {
+      case kDW_EH_PE_absptr:
+        if (is_64_bit_) {
+          if (!Read(&value)) {
+            return false;
+          }
+        } else {
+          uint32_t value32;
+          if (!Read(&value32)) {
+            return false;
+          }
+          value = value32;
+        }
+        break;
+      case kDW_EH_PE_uleb128:
+        if (!ReadULEB128(&value)) {
+          return false;
+        }
+        break;
+      case kDW_EH_PE_udata2: {
+        uint16_t value16;
+        if (!Read(&value16)) {
+          return false;
+        }
+        value = value16;
+        break;
+      }
+      case kDW_EH_PE_udata4: {
+        uint32_t value32;
+        if (!Read(&value32)) {
+          return false;
+        }
+        value = value32;
+        break;
+      }
+      case kDW_EH_PE_udata8:
+        if (!Read(&value)) {
+          return false;
+        }
+        break;
+      case kDW_EH_PE_sleb128: {
+        int64_t signed_value;
+        if (!ReadSLEB128(&signed_value)) {
+          return false;
+        }
+        value = static_cast<uint64_t>(signed_value);
+        break;
+      }
+      case kDW_EH_PE_sdata2: {
+        int16_t value16;
+        if (!Read(&value16)) {
+          return false;
+        }
+        value = static_cast<uint64_t>(int64_t{value16});
+        break;
+      }
+      case kDW_EH_PE_sdata4: {
+        int32_t value32;
+        if (!Read(&value32)) {
+          return false;
+        }
+        value = static_cast<uint64_t>(int64_t{value32});
+        break;
+      }
+      case kDW_EH_PE_sdata8:
+        if (!Read(&value)) {
+          return false;
+        }
+        break;
+      default:
+        return false;
+    }
+
+    switch (encoding & 0x70) {
+      case 0:
+        break;
+      case kDW_EH_PE_pcrel:
+        value += field_address;
+        break;
+      case kDW_EH_PE_datarel:
+        if (!data_base) {
+          return false;
+        }
+        value += data_base;
+        break;
+      default:
+        return false;
+    }
+
+    *pointer = is_64_bit_ ? value : static_cast<uint32_t>(value);
+    return true;
+  }
+
+ private:
+  const std::string& data_;
+  VMAddress address_;
+  size_t offset_;
+  bool is_64_bit_;
+
+  DISALLOW_COPY_AND_ASSIGN(Cursor);
+};
+
+// Reads the CIE or FDE at |address|. Its contents, following the length, are
+// placed in |record|, and contents_address is set to where they begin.
+// dwarf64 is set if the record uses the 64-bit DWARF format.
+bool ReadRecord(const ProcessMemoryRange& memory,
+                VMAddress address,
+                std::string* record,
+                VMAddress* contents_address,
+                bool* dwarf64) {
+  uint32_t length32;
+  if (!memory.Read(address, sizeof(length32), &length32)) {
+    return false;
+  }
+
+  uint64_t length;
+  if (length32 == 0xffffffff) {
+    if (!memory.Read(address + sizeof(length32), sizeof(length), &length)) {
+      return false;
+    }
+    *contents_address = address + sizeof(length32) + sizeof(length);
+    *dwarf64 = true;
+  } else {
+    length = length32;
+    *contents_address = address + sizeof(length32);
+    *dwarf64 = false;
+  }
+
+  if (length == 0 || length > kMaxRecordSize) {
+    LOG(ERROR) << "bad eh_frame record length " << length;
+    return false;
+  }
+
+  record->resize(length);
+  return memory.Read(*contents_address, length, &(*record)[0]);
+}
+
+struct CIE {
+  CIE()
+      : code_alignment(1),
+        data_alignment(1),
+        return_address_register(0),
+        fde_encoding(kDW_EH_PE_absptr),
+        has_augmentation_data(false),
+        signal_frame(false),
+        instructions_offset(0) {}
+
+  uint64_t code_alignment;
+  int64_t data_alignment;
+  uint32_t return_address_register;
+  uint8_t fde_encoding;
+  bool has_augmentation_data;
+  bool signal_frame;
+  size_t instructions_offset;
+};
+
+bool ParseCIE(Cursor* cursor, bool dwarf64, CIE* cie) {
+  uint64_t id;
+  if (dwarf64) {
+    if (!cursor->Read(&id)) {
+      return false;
+    }
+  } else {
+    uint32_t id32;
+    if (!cursor->Read(&id32)) {
+      return false;
+    }
+    id = id32;
+  }
+  if (id != 0) {
+    LOG(ERROR) << "FDE doesn’t refer to a CIE";
+    return false;
+  }
+
+  uint8_t version;
+  std::string augmentation;
+  if (!cursor->Read(&version) || !cursor->ReadCString(&augmentation)) {
+    return false;
+  }
+  if (version != 1 && version != 3 && version != 4) {
+    LOG(ERROR) << "unexpected CIE version " << static_cast<int>(version);
+    return false;
+  }
+
+  // “eh” marks an obsolete GCC augmentation, followed by a pointer.
+  if (augmentation.compare(0, 2, "eh") == 0) {
+    if (!cursor->Skip(cursor->PointerSize())) {
+      return false;
+    }
+    augmentation.erase(0, 2);
+  }
+
+  if (version == 4) {
+    uint8_t address_size;
+    uint8_t segment_selector_size;
+    if (!cursor->Read(&address_size) ||
+        !cursor->Read(&segment_selector_size)) {
+      return false;
+    }
+  }
+
+  uint64_t return_address_register;
+  if (!cursor->ReadULEB128(&cie->code_alignment) ||
+      !cursor->ReadSLEB128(&cie->data_alignment)) {
+    return false;
+  }
+  if (version == 1) {
+    uint8_t register8;
+    if (!cursor->Read(&register8)) {
+      return false;
+    }
+    return_address_register = register8;
+  } else if (!cursor->ReadULEB128(&return_address_register)) {
+    return false;
+  }
+  cie->return_address_register =
+      static_cast<uint32_t>(return_address_register);
+
+  if (!augmentation.empty()) {
+    if (augmentation[0] != 'z') {
+      LOG(ERROR) << "unsupported CIE augmentation " << augmentation;
+      return false;
+    }
+    cie->has_augmentation_data = true;
+
+    uint64_t augmentation_size;
+    if (!cursor->ReadULEB128(&augmentation_size) ||
+        augmentation_size > cursor->Remaining()) {
+      return false;
+    }
+    const size_t augmentation_end = cursor->Offset() + augmentation_size;
+
+    // Unknown augmentations end interpretation, but not parsing, since the
+    // augmentation data’s size is known.
+    for (size_t index = 1; index < augmentation.size(); ++index) {
+      const char character = augmentation[index];
+      if (character == 'L') {
+        uint8_t lsda_encoding;
+        if (!cursor->Read(&lsda_encoding)) {
+          return false;
+        }
+      } else if (character == 'P') {
+        uint8_t personality_encoding;
+        VMAddress personality;
+        if (!cursor->Read(&personality_encoding) ||
+            !cursor->ReadEncodedPointer(
+                personality_encoding, 0, &personality)) {
+          return false;
+        }
+      } else if (character == 'R') {
+        if (!cursor->Read(&cie->fde_encoding)) {
+          return false;
+        }
+      } else if (character == 'S') {
+        cie->signal_frame = true;
+      } else if (character != 'B' && character != 'G') {
+        break;
+      }
+    }
+
+    if (!cursor->Seek(augmentation_end)) {
+      return false;
+    }
+  }
+
+  cie->instructions_offset = cursor->Offset();
+  return true;
+}
+
+// A row, along with whether its CFA is computed by a DWARF expression, which
+// makes the row unusable.
+struct State {
+  ElfEhFrameReader::Row row;
+  bool cfa_expression;
+};
+
+void SetRule(State* state,
+             uint64_t reg,
+             ElfEhFrameReader::RegisterRule::Type type,
+             int64_t offset,
+             uint64_t other_reg) {
+  ElfEhFrameReader::RegisterRule& rule =
+      state->row.registers[static_cast<uint32_t>(reg)];
+  rule.type = type;
+  rule.reg = static_cast<uint32_t>(other_reg);
+  rule.offset = offset;
+}
+
+// Executes call frame instructions until the location advances past pc.
+// initial is the state after the CIE’s initial instructions, which
+// DW_CFA_restore returns to, or nullptr while executing those instructions.
+bool ExecuteInstructions(Cursor* cursor,
+                         const CIE& cie,
+                         VMAddress pc,
+                         const State* initial,
+                         VMAddress* location,
+                         State* state) {
+  using RegisterRule = ElfEhFrameReader::RegisterRule;
+
+  std::vector<State> remembered;
+  const auto restore = [initial, state](uint64_t reg) {
+    const uint32_t reg32 = static_cast<uint32_t>(reg);
+    if (initial) {
+      const auto it = initial->row.registers.find(reg32);
+      if (it != initial->row.registers.end()) {
+        state->row.registers[reg32] = it->second;
+        return;
+      }
+    }
+    state->row.registers.erase(reg32);
+  };
+  const auto advance = [&cie, location, pc](uint64_t delta) {
+    *location += delta * cie.code_alignment;
+    return *location <= pc;
+  };
+
+  while (cursor->Remaining()) {
+    uint8_t instruction;
+    cursor->Read(&instruction);
+    const uint8_t operand = instruction & 0x3f;
+
+    uint64_t reg;
+    uint64_t value;
+    int64_t signed_value;
+    switch (instruction & 0xc0) {
+      case kDW_CFA_advance_loc:
+        if (!advance(operand)) {
+          return true;
+        }
+        continue;
+      case kDW_CFA_offset:
+        if (!cursor->ReadULEB128(&value)) {
+          return false;
+        }
+        SetRule(state,
+                operand,
+                RegisterRule::kOffset,
+                static_cast<int64_t>(value) * cie.data_alignment,
+                0);
+        continue;
+      case kDW_CFA_restore:
+        restore(operand);
+        continue;
+    }
+
+    switch (instruction) {
+      case kDW_CFA_nop:
+        break;
+
+      case kDW_CFA_set_loc:
+        if (!cursor->ReadEncodedPointer(cie.fde_encoding, 0, location)) {
+          return false;
+        }
+        if (*location > pc) {
+          return true;
+        }
+        break;
+
+      case kDW_CFA_advance_loc1: {
+        uint8_t delta;
+        if (!cursor->Read(&delta)) {
+          return false;
+        }
+        if (!advance(delta)) {
+          return true;
+        }
+        break;
+      }
+
+      case kDW_CFA_advance_loc2: {
+        uint16_t delta;
+        if (!cursor->Read(&delta)) {
+          return false;
+        }
+        if (!advance(delta)) {
+          return true;
+        }
+        break;
+      }
+
+      case kDW_CFA_advance_loc4: {
+        uint32_t delta;
+        if (!cursor->Read(&delta)) {
+          return false;
+        }
+        if (!advance(delta)) {
+          return true;
+        }
+        break;
+      }
+
+      case kDW_CFA_offset_extended:
+        if (!cursor->ReadULEB128(&reg) || !cursor->ReadULEB128(&value)) {
+          return false;
+        }
+        SetRule(state,
+                reg,
+                RegisterRule::kOffset,
+                static_cast<int64_t>(value) * cie.data_alignment,
+                0);
+        break;
+
+      case kDW_CFA_restore_extended:
+        if (!cursor->ReadULEB128(&reg)) {
+          return false;
+        }
+        restore(reg);
+        break;
+
+      case kDW_CFA_undefined:
+        if (!cursor->ReadULEB128(&reg)) {
+          return false;
+        }
+        SetRule(state, reg, RegisterRule::kUndefined, 0, 0);
+        break;
+
+      case kDW_CFA_same_value:
+        if (!cursor->ReadULEB128(&reg)) {
+          return false;
+        }
+        SetRule(state, reg, RegisterRule::kSameValue, 0, 0);
+        break;
+
+      case kDW_CFA_register:
+        if (!cursor->ReadULEB128(&reg) || !cursor->ReadULEB128(&value)) {
+          return false;
+        }
+        SetRule(state, reg, RegisterRule::kRegister, 0, value);
+        break;
+
+      case kDW_CFA_remember_state:
+        remembered.push_back(*state);
+        break;
+
+      case kDW_CFA_restore_state:
+        if (remembered.empty()) {
+          return false;
+        }
+        *state = remembered.back();
+        remembered.pop_back();
+        break;
+
+      case kDW_CFA_def_cfa:
+        if (!cursor->ReadULEB128(&reg) || !cursor->ReadULEB128(&value)) {
+          return false;
+        }
+        state->row.cfa_register = static_cast<uint32_t>(reg);
+        state->row.cfa_offset = static_cast<int64_t>(value);
+        state->cfa_expression = false;
+        break;
+
+      case kDW_CFA_def_cfa_register:
+        if (!cursor->ReadULEB128(&reg)) {
+          return false;
+        }
+        state->row.cfa_register = static_cast<uint32_t>(reg);
+        state->cfa_expression = false;
+        break;
+
+      case kDW_CFA_def_cfa_offset:
+        if (!cursor->ReadULEB128(&value)) {
+          return false;
+        }
+        state->row.cfa_offset = static_cast<int64_t>(value);
+        break;
+
+      case kDW_CFA_def_cfa_expression:
+        if (!cursor->ReadULEB128(&value) || !cursor->Skip(value)) {
+          return false;
+        }
+        state->cfa_expression = true;
+        break;
+
+      case kDW_CFA_expression:
+      case kDW_CFA_val_expression:
+        if (!cursor->ReadULEB128(&reg) || !cursor->ReadULEB128(&value) ||
+            !cursor->Skip(value)) {
+          return false;
+        }
+        SetRule(state, reg, RegisterRule::kExpression, 0, 0);
+        break;
+
+      case kDW_CFA_offset_extended_sf:
+        if (!cursor->ReadULEB128(&reg) || !cursor->ReadSLEB128(&signed_value)) {
+          return false;
+        }
+        SetRule(state,
+                reg,
+                RegisterRule::kOffset,
+                signed_value * cie.data_alignment,
+                0);
+        break;
+
+      case kDW_CFA_def_cfa_sf:
+        if (!cursor->ReadULEB128(&reg) || !cursor->ReadSLEB128(&signed_value)) {
+          return false;
+        }
+        state->row.cfa_register = static_cast<uint32_t>(reg);
+        state->row.cfa_offset = signed_value * cie.data_alignment;
+        state->cfa_expression = false;
+        break;
+
+      case kDW_CFA_def_cfa_offset_sf:
+        if (!cursor->ReadSLEB128(&signed_value)) {
+          return false;
+        }
+        state->row.cfa_offset = signed_value * cie.data_alignment;
+        break;
+
+      case kDW_CFA_val_offset:
+        if (!cursor->ReadULEB128(&reg) || !cursor->ReadULEB128(&value)) {
+          return false;
+        }
+        SetRule(state,
+                reg,
+                RegisterRule::kValueOffset,
+                static_cast<int64_t>(value) * cie.data_alignment,
+                0);
+        break;
+
+      case kDW_CFA_val_offset_sf:
+        if (!cursor->ReadULEB128(&reg) || !cursor->ReadSLEB128(&signed_value)) {
+          return false;
+        }
+        SetRule(state,
+                reg,
+                RegisterRule::kValueOffset,
+                signed_value * cie.data_alignment,
+                0);
+        break;
+
+      case kDW_CFA_AARCH64_negate_ra_state:
+        state->row.return_address_signed = !state->row.return_address_signed;
+        break;
+
+      case kDW_CFA_GNU_args_size:
+        if (!cursor->ReadULEB128(&value)) {
+          return false;
+        }
+        break;
+
+      case kDW_CFA_GNU_negative_offset_extended:
+        if (!cursor->ReadULEB128(&reg) || !cursor->ReadULEB128(&value)) {
+          return false;
+        }
+        SetRule(state,
+                reg,
+                RegisterRule::kOffset,
+                -static_cast<int64_t>(value) * cie.data_alignment,
+                0);
+        break;
+
+      default:
+        LOG(ERROR) << "unknown call frame instruction "
+                   << static_cast<int>(instruction);
+        return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace
+
+ElfEhFrameReader::Row::Row()
+    : cfa_register(0),
+      cfa_offset(0),
+      return_address_register(0),
+      signal_frame(false),
+      return_address_signed(false),
+      registers() {}
+
+ElfEhFrameReader::Row::~Row() {}
+
+ElfEhFrameReader::ElfEhFrameReader()
+    : memory_(),
+      header_address_(0),
+      table_address_(0),
+      table_entry_count_(0),
+      initialized_() {}
+
+ElfEhFrameReader::~ElfEhFrameReader() {}
+
+bool ElfEhFrameReader::Initialize(const ProcessMemoryRange& memory,
+                                  VMAddress address) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+  if (!memory_.Initialize(memory)) {
+    return false;
+  }
+  header_address_ = address;
+
+  // The header is followed by the address of .eh_frame and the number of
+  // entries in the lookup table, each at most 8 bytes.
+  if (address < memory_.Base() ||
+      address - memory_.Base() >= memory_.Size()) {
+    LOG(ERROR) << "eh_frame_hdr out of range";
+    return false;
+  }
+  std::string header(
+      std::min(VMSize{20}, memory_.Size() - (address - memory_.Base())), '\0');
+  if (!memory_.Read(address, header.size(), &header[0])) {
+    return false;
+  }
+
+  Cursor cursor(header, address, memory_.Is64Bit());
+  uint8_t version;
+  uint8_t eh_frame_pointer_encoding;
+  uint8_t entry_count_encoding;
+  uint8_t table_encoding;
+  if (!cursor.Read(&version) || !cursor.Read(&eh_frame_pointer_encoding) ||
+      !cursor.Read(&entry_count_encoding) || !cursor.Read(&table_encoding)) {
+    return false;
+  }
+  if (version != 1) {
+    LOG(ERROR) << "unexpected eh_frame_hdr version "
+               << static_cast<int>(version);
+    return false;
+  }
+
+  // Entries must have a fixed size to be searched, and every linker that
+  // writes the table uses this encoding.
+  VMAddress eh_frame_address;
+  VMAddress entry_count;
+  if (table_encoding != (kDW_EH_PE_datarel | kDW_EH_PE_sdata4) ||
+      !cursor.ReadEncodedPointer(
+          eh_frame_pointer_encoding, address, &eh_frame_address) ||
+      !cursor.ReadEncodedPointer(entry_count_encoding, address, &entry_count)) {
+    LOG(ERROR) << "unsupported eh_frame_hdr";
+    return false;
+  }
+
+  table_address_ = cursor.Address();
+  table_entry_count_ = entry_count;
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+bool ElfEhFrameReader::FindRow(VMAddress pc, Row* row) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  VMAddress fde_address;
+  if (!FindFDE(pc, &fde_address)) {
+    return false;
+  }
+
+  const bool is_64_bit = memory_.Is64Bit();
+
+  std::string fde;
+  VMAddress fde_contents_address;
+  bool fde_dwarf64;
+  if (!ReadRecord(
+          memory_, fde_address, &fde, &fde_contents_address, &fde_dwarf64)) {
+    return false;
+  }
+  Cursor fde_cursor(fde, fde_contents_address, is_64_bit);
+
+  // The CIE pointer is relative to where it’s stored, at the start of the
+  // FDE’s contents.
+  uint64_t cie_pointer;
+  if (fde_dwarf64) {
+    if (!fde_cursor.Read(&cie_pointer)) {
+      return false;
+    }
+  } else {
+    uint32_t cie_pointer32;
+    if (!fde_cursor.Read(&cie_pointer32)) {
+      return false;
+    }
+    cie_pointer = cie_pointer32;
+  }
+  if (cie_pointer == 0 || cie_pointer > fde_contents_address) {
+    LOG(ERROR) << "bad CIE pointer";
+    return false;
+  }
+
+  std::string cie_record;
+  VMAddress cie_contents_address;
+  bool cie_dwarf64;
+  if (!ReadRecord(memory_,
+                  fde_contents_address - cie_pointer,
+                  &cie_record,
+                  &cie_contents_address,
+                  &cie_dwarf64)) {
+    return false;
+  }
+  Cursor cie_cursor(cie_record, cie_contents_address, is_64_bit);
+  CIE cie;
+  if (!ParseCIE(&cie_cursor, cie_dwarf64, &cie)) {
+    return false;
+  }
+
+  VMAddress pc_begin;
+  VMAddress pc_range;
+  if (!fde_cursor.ReadEncodedPointer(cie.fde_encoding, 0, &pc_begin) ||
+      !fde_cursor.ReadEncodedPointer(cie.fde_encoding & 0x0f, 0, &pc_range)) {
+    LOG(ERROR) << "bad FDE";
+    return false;
+  }
+
+  // The lookup table only says that this FDE is the nearest one below pc.
+  if (pc < pc_begin || pc - pc_begin >= pc_range) {
+    return false;
+  }
+
+  if (cie.has_augmentation_data) {
+    uint64_t augmentation_size;
+    if (!fde_cursor.ReadULEB128(&augmentation_size) ||
+        !fde_cursor.Skip(augmentation_size)) {
+      return false;
+    }
+  }
+
+  State state;
+  state.row.return_address_register = cie.return_address_register;
+  state.row.signal_frame = cie.signal_frame;
+  state.cfa_expression = false;
+
+  VMAddress location = pc_begin;
+  if (!ExecuteInstructions(
+          &cie_cursor, cie, pc, nullptr, &location, &state)) {
+    LOG(ERROR) << "bad CIE instructions";
+    return false;
+  }
+  const State initial = state;
+  if (!ExecuteInstructions(
+          &fde_cursor, cie, pc, &initial, &location, &state)) {
+    LOG(ERROR) << "bad FDE instructions";
+    return false;
+  }
+
+  if (state.cfa_expression) {
+    return false;
+  }
+
+  *row = state.row;
+  return true;
+}
+
+bool ElfEhFrameReader::FindFDE(VMAddress pc, VMAddress* fde_address) const {
+  // Each entry holds the start of a function, followed by the address of its
+  // FDE, both relative to .eh_frame_hdr. Entries are sorted by function.
+  struct Entry {
+    int32_t initial_location;
+    int32_t fde_offset;
+  };
+  const auto read_entry = [this](VMSize index, Entry* entry) {
+    return memory_.Read(
+        table_address_ + index * sizeof(*entry), sizeof(*entry), entry);
+  };
+  const auto location = [this](const Entry& entry) {
+    const VMAddress location = header_address_ + entry.initial_location;
+    return memory_.Is64Bit() ? location : static_cast<uint32_t>(location);
+  };
+
+  if (table_entry_count_ == 0) {
+    return false;
+  }
+
+  // Find the last entry for a function that starts at or below pc.
+  VMSize low = 0;
+  VMSize high = table_entry_count_;
+  Entry entry;
+  while (high - low > 1) {
+    const VMSize middle = low + (high - low) / 2;
+    if (!read_entry(middle, &entry)) {
+      return false;
+    }
+    if (location(entry) <= pc) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+
+  if (!read_entry(low, &entry) || location(entry) > pc) {
+    return false;
+  }
+
+  *fde_address = header_address_ + entry.fde_offset;
+  if (!memory_.Is64Bit()) {
+    *fde_address = static_cast<uint32_t>(*fde_address);
+  }
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,133 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_ELF_ELF_EH_FRAME_READER_H_
+#define CRASHPAD_SNAPSHOT_ELF_ELF_EH_FRAME_READER_H_
+
+#include <stdint.h>
+
+#include <map>
+
+#include "base/macros.h"
+#include "util/misc/address_types.h"
+#include "util/misc/initialization_state_dcheck.h"
+#include "util/process/process_memory_range.h"
+
+namespace crashpad {
+
+//! \brief A reader for the DWARF call frame information in an ELF image’s
+//!     `.eh_frame` section, found through its `.eh_frame_hdr` lookup table.
+//!
+//! Only what is needed to unwind a stack is interpreted. Rules computed by
+//! DWARF expressions are recognized but not evaluated.
+class ElfEhFrameReader {
+ public:
+  //! \brief How to recover a register’s value in the caller’s frame.
+  struct RegisterRule {
+    enum Type : uint8_t {
+      //! \brief The register’s value is not recoverable.
+      kUndefined = 0,
+
+      //! \brief The register’s value is unchanged from the callee’s frame.
+      kSameValue,
+
+      //! \brief The register is saved at the address CFA + offset.
+      kOffset,
+
+      //! \brief The register’s value is CFA + offset.
+      kValueOffset,
+
+      //! \brief The register’s value is in the callee’s register \a reg.
+      kRegister,
+
+      //! \brief The register’s value is computed by a DWARF expression, which
+      //!     this reader does not evaluate.
+      kExpression,
+    };
+
+    Type type;
+    uint32_t reg;
+    int64_t offset;
+  };
+
+  //! \brief The unwind rules in effect at an instruction.
+  struct Row {
+    Row();
+    ~Row();
+
+    //! \brief The register that the canonical frame address (CFA) is relative
+    //!     to.
+    uint32_t cfa_register;
+
+    //! \brief The offset of the CFA from \a cfa_register.
+    int64_t cfa_offset;
+
+    //! \brief The register holding the return address.
+    uint32_t return_address_register;
+
+    //! \brief Whether the frame is a signal frame, whose program counter is
+    //!     resumed exactly rather than being a return address.
+    bool signal_frame;
+
+    //! \brief Whether the return address is signed, as with AArch64 pointer
+    //!     authentication.
+    bool return_address_signed;
+
+    //! \brief Rules for the registers that the frame saves or changes. Any
+    //!     register not present keeps its value from the callee’s frame.
+    std::map<uint32_t, RegisterRule> registers;
+  };
+
+  ElfEhFrameReader();
+  ~ElfEhFrameReader();
+
+  //! \brief Initializes the reader.
+  //!
+  //! This method must be called once on an object and must be successfully
+  //! called before any other method in this class may be called.
+  //!
+  //! \param[in] memory A memory reader for the image. Both `.eh_frame_hdr` and
+  //!     `.eh_frame` must lie within it.
+  //! \param[in] address The address of `.eh_frame_hdr`, from the image’s
+  //!     `PT_GNU_EH_FRAME` segment.
+  //! \return `true` on success. `false` on failure with a message logged.
+  bool Initialize(const ProcessMemoryRange& memory, VMAddress address);
+
+  //! \brief Finds the unwind rules in effect at \a pc.
+  //!
+  //! \param[in] pc The address of an instruction in the image. For a caller’s
+  //!     frame, this should lie within the call instruction rather than be the
+  //!     return address, which may begin a different function.
+  //! \param[out] row The rules, if found.
+  //! \return `true` if \a pc is covered by a frame description entry whose
+  //!     canonical frame address isn’t computed by a DWARF expression.
+  //!     Otherwise `false`, with a message logged only if the call frame
+  //!     information could not be parsed.
+  bool FindRow(VMAddress pc, Row* row) const;
+
+ private:
+  bool FindFDE(VMAddress pc, VMAddress* fde_address) const;
+
+  ProcessMemoryRange memory_;
+  VMAddress header_address_;
+  VMAddress table_address_;
+  VMSize table_entry_count_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(ElfEhFrameReader);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_ELF_ELF_EH_FRAME_READER_H_
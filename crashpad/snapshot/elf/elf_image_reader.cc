@@ -15,7 +15,9 @@
 #include "snapshot/elf/elf_image_reader.h"
 
 #include <stddef.h>
+#include <string.h>
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 
@@ -32,9 +34,15 @@ class ElfImageReader::ProgramHeaderTable {
   virtual bool VerifyLoadSegments() const = 0;
   virtual size_t Size() const = 0;
   virtual bool GetDynamicSegment(VMAddress* address, VMSize* size) const = 0;
+  virtual bool GetEhFrameHeaderSegment(VMAddress* address) const = 0;
+  virtual bool GetFirstWrittenAddress(VMAddress* address) const = 0;
   virtual bool GetPreferredElfHeaderAddress(VMAddress* address) const = 0;
   virtual bool GetPreferredLoadedMemoryRange(VMAddress* address,
                                              VMSize* size) const = 0;
+  virtual bool GetNoteSegment(size_t* start_index,
+                              VMAddress* address,
+                              VMSize* size,
+                              VMSize* alignment) const = 0;
 
  protected:
   ProgramHeaderTable() {}
@@ -139,6 +147,50 @@ class ElfImageReader::ProgramHeaderTableSpecific
     return true;
   }
 
+  bool GetEhFrameHeaderSegment(VMAddress* address) const override {
+    INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+    const PhdrType* phdr;
+    if (!GetProgramHeader(PT_GNU_EH_FRAME, &phdr)) {
+      return false;
+    }
+    *address = phdr->p_vaddr;
+    return true;
+  }
+
+  bool GetFirstWrittenAddress(VMAddress* address) const override {
+    INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+    bool found = false;
+    for (const auto& header : table_) {
+      // The loader writes to the dynamic array and to the relocation read-only
+      // segment before protecting it, as well as to writable segments.
+      if (header.p_type == PT_DYNAMIC || header.p_type == PT_GNU_RELRO ||
+          (header.p_type == PT_LOAD && (header.p_flags & PF_W))) {
+        if (!found || header.p_vaddr < *address) {
+          *address = header.p_vaddr;
+          found = true;
+        }
+      }
+    }
+    return found;
+  }
+
+  bool GetNoteSegment(size_t* start_index,
+                      VMAddress* address,
+                      VMSize* size,
+                      VMSize* alignment) const override {
+    INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+    for (size_t index = *start_index; index < table_.size(); ++index) {
+      if (table_[index].p_type == PT_NOTE) {
+        *start_index = index + 1;
+        *address = table_[index].p_vaddr;
+        *size = table_[index].p_memsz;
+        *alignment = table_[index].p_align;
+        return true;
+      }
+    }
+    return false;
+  }
+
   bool GetProgramHeader(uint32_t type, const PhdrType** header_out) const {
     INITIALIZATION_STATE_DCHECK_VALID(initialized_);
     for (const auto& header : table_) {
@@ -165,9 +217,11 @@ ElfImageReader::ElfImageReader()
       program_headers_(),
       dynamic_array_(),
       symbol_table_(),
+      eh_frame_(),
       initialized_(),
       dynamic_array_initialized_(),
-      symbol_table_initialized_() {}
+      symbol_table_initialized_(),
+      eh_frame_initialized_() {}
 
 ElfImageReader::~ElfImageReader() {}
 
@@ -262,6 +316,22 @@ bool ElfImageReader::Initialize(const ProcessMemoryRange& memory,
     return false;
   }
 
+  // The module’s file can stand in for the target’s memory only below the
+  // first segment that the loader modifies.
+  if (memory_.FileBacking()) {
+    VMSize unmodified_size = loaded_size;
+    VMAddress written_address;
+    if (program_headers_.get()->GetFirstWrittenAddress(&written_address)) {
+      written_address += load_bias_;
+      unmodified_size =
+          written_address > base_address
+              ? std::min(written_address - base_address, loaded_size)
+              : 0;
+    }
+    memory_.SetFileBacking(
+        memory_.FileBacking(), base_address, unmodified_size);
+  }
+
   VMSize ehdr_size;
   VMAddress phdr_address;
   if (memory_.Is64Bit()) {
@@ -342,6 +412,25 @@ bool ElfImageReader::GetDynamicSymbol(const std::string& name,
   return true;
 }
 
+bool ElfImageReader::GetNearestDynamicFunctionSymbol(
+    VMAddress address,
+    std::string* name,
+    VMAddress* symbol_address) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  if (!InitializeDynamicSymbolTable()) {
+    return false;
+  }
+
+  ElfSymbolTableReader::SymbolInformation info;
+  if (!symbol_table_->GetNearestFunctionSymbol(
+          address - GetLoadBias(), name, &info)) {
+    return false;
+  }
+
+  *symbol_address = info.address + GetLoadBias();
+  return true;
+}
+
 bool ElfImageReader::ReadDynamicStringTableAtOffset(VMSize offset,
                                                     std::string* string) {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
@@ -377,6 +466,92 @@ bool ElfImageReader::GetDebugAddress(VMAddress* debug) {
   return GetAddressFromDynamicArray(DT_DEBUG, debug);
 }
 
+bool ElfImageReader::GetBuildID(std::string* build_id) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::vector<NoteSegment> segments;
+  GetNoteSegments(&segments);
+  for (const NoteSegment& segment : segments) {
+    std::string notes(segment.size, '\0');
+    if (memory_.Read(segment.address, segment.size, &notes[0]) &&
+        FindBuildIDInNotes(notes, segment.alignment, build_id)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ElfImageReader::GetNoteSegments(std::vector<NoteSegment>* segments) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  segments->clear();
+
+  size_t index = 0;
+  NoteSegment segment;
+  while (program_headers_->GetNoteSegment(
+      &index, &segment.address, &segment.size, &segment.alignment)) {
+    segment.address += GetLoadBias();
+
+    // A corrupt header mustn’t lead to reading, or allocating for, memory
+    // outside of the image.
+    if (segment.size == 0 || segment.address < memory_.Base() ||
+        segment.address - memory_.Base() >= memory_.Size() ||
+        segment.size > memory_.Size() - (segment.address - memory_.Base())) {
+      continue;
+    }
+    segments->push_back(segment);
+  }
+}
+
+// static
+bool ElfImageReader::FindBuildIDInNotes(const std::string& notes,
+                                        VMSize alignment,
+                                        std::string* build_id) {
+  static constexpr char kGNUNoteName[] = "GNU";
+
+  // Notes are padded to 4 bytes, or to 8 bytes in segments so aligned.
+  // Elf32_Nhdr and Elf64_Nhdr have the same layout.
+  const VMSize note_alignment = alignment == 8 ? 8 : 4;
+  const auto align = [note_alignment](VMSize value) {
+    return (value + note_alignment - 1) & ~(note_alignment - 1);
+  };
+
+  const VMSize size = notes.size();
+  VMSize offset = 0;
+  while (size - offset >= sizeof(Elf32_Nhdr)) {
+    Elf32_Nhdr header;
+    memcpy(&header, &notes[offset], sizeof(header));
+    offset += sizeof(header);
+
+    const VMSize name_size = align(header.n_namesz);
+    const VMSize desc_size = align(header.n_descsz);
+    if (name_size > size - offset || desc_size > size - offset - name_size) {
+      LOG(ERROR) << "note out of range";
+      return false;
+    }
+
+    if (header.n_type == NT_GNU_BUILD_ID &&
+        header.n_namesz == sizeof(kGNUNoteName) &&
+        memcmp(&notes[offset], kGNUNoteName, sizeof(kGNUNoteName)) == 0) {
+      build_id->assign(&notes[offset + name_size], header.n_descsz);
+      return true;
+    }
+
+    offset += name_size + desc_size;
+  }
+
+  return false;
+}
+
+bool ElfImageReader::GetCallFrameRow(VMAddress pc,
+                                     ElfEhFrameReader::Row* row) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  if (!InitializeEhFrame()) {
+    return false;
+  }
+  return eh_frame_->FindRow(pc, row);
+}
+
 bool ElfImageReader::InitializeProgramHeaders() {
 #define INITIALIZE_PROGRAM_HEADERS(PhdrType, header)                    \
   do {                                                                  \
@@ -446,12 +621,52 @@ bool ElfImageReader::InitializeDynamicSymbolTable() {
     return false;
   }
 
-  symbol_table_.reset(
-      new ElfSymbolTableReader(&memory_, this, symbol_table_address));
+  // Either hash table makes lookups independent of the symbol table’s size.
+  // Most images have at least one.
+  VMAddress gnu_hash_address;
+  if (!GetAddressFromDynamicArray(DT_GNU_HASH, &gnu_hash_address)) {
+    gnu_hash_address = 0;
+  }
+  VMAddress hash_address;
+  if (!GetAddressFromDynamicArray(DT_HASH, &hash_address)) {
+    hash_address = 0;
+  }
+
+  symbol_table_.reset(new ElfSymbolTableReader(&memory_,
+                                               this,
+                                               symbol_table_address,
+                                               gnu_hash_address,
+                                               hash_address));
   symbol_table_initialized_.set_valid();
   return true;
 }
 
+bool ElfImageReader::InitializeEhFrame() {
+  if (eh_frame_initialized_.is_valid()) {
+    return true;
+  }
+  if (!eh_frame_initialized_.is_uninitialized()) {
+    return false;
+  }
+  eh_frame_initialized_.set_invalid();
+
+  // Images without call frame information are unremarkable, so this isn’t
+  // logged.
+  VMAddress eh_frame_header_address;
+  if (!program_headers_.get()->GetEhFrameHeaderSegment(
+          &eh_frame_header_address)) {
+    return false;
+  }
+
+  eh_frame_.reset(new ElfEhFrameReader());
+  if (!eh_frame_->Initialize(memory_,
+                             eh_frame_header_address + GetLoadBias())) {
+    return false;
+  }
+  eh_frame_initialized_.set_valid();
+  return true;
+}
+
 bool ElfImageReader::GetAddressFromDynamicArray(uint64_t tag,
                                                 VMAddress* address) {
   if (!dynamic_array_->GetValue(tag, address)) {
@@ -20,9 +20,11 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/macros.h"
 #include "snapshot/elf/elf_dynamic_array_reader.h"
+#include "snapshot/elf/elf_eh_frame_reader.h"
 #include "snapshot/elf/elf_symbol_table_reader.h"
 #include "util/misc/address_types.h"
 #include "util/misc/initialization_state.h"
@@ -36,6 +38,19 @@ namespace crashpad {
 //! This class is capable of reading both 32-bit and 64-bit images.
 class ElfImageReader {
  public:
+  //! \brief Describes a `PT_NOTE` segment of an image.
+  struct NoteSegment {
+    //! \brief The address of the segment in the target process’ address space.
+    VMAddress address;
+
+    //! \brief The size of the segment.
+    VMSize size;
+
+    //! \brief The segment’s alignment, which determines how notes within it
+    //!     are padded.
+    VMSize alignment;
+  };
+
   ElfImageReader();
   ~ElfImageReader();
 
@@ -44,7 +59,9 @@ class ElfImageReader {
   //! This method must be called once on an object and must be successfully
   //! called before any other method in this class may be called.
   //!
-  //! \param[in] memory A memory reader for the remote process.
+  //! \param[in] memory A memory reader for the remote process. If it has a
+  //!     file backing, its window is replaced by the part of the image that the
+  //!     loader leaves unmodified.
   //! \param[in] address The address in the remote process' address space where
   //!     the ELF image is loaded.
   bool Initialize(const ProcessMemoryRange& memory, VMAddress address);
@@ -84,6 +101,21 @@ class ElfImageReader {
                         VMAddress* address,
                         VMSize* size);
 
+  //! \brief Finds the dynamic function symbol nearest to and at or below \a
+  //!     address.
+  //!
+  //! Only symbols exported in the dynamic symbol table are considered, so the
+  //! symbol found may not be the function that contains \a address.
+  //!
+  //! \param[in] address An address in the target process’ address space.
+  //! \param[out] name The name of the symbol, if found.
+  //! \param[out] symbol_address The address of the symbol in the target
+  //!     process’ address space, if found.
+  //! \return `true` if a symbol was found.
+  bool GetNearestDynamicFunctionSymbol(VMAddress address,
+                                       std::string* name,
+                                       VMAddress* symbol_address);
+
   //! \brief Reads a `NUL`-terminated C string from this image's dynamic string
   //!     table.
   //!
@@ -101,6 +133,47 @@ class ElfImageReader {
   //! \return `true` if the debug address was found.
   bool GetDebugAddress(VMAddress* debug);
 
+  //! \brief Reads the build ID from this image’s `NT_GNU_BUILD_ID` note.
+  //!
+  //! \param[out] build_id The contents of the note’s descriptor, if found.
+  //! \return `true` if a build ID note was found. Otherwise `false`, with a
+  //!     message logged only if the notes could not be parsed.
+  bool GetBuildID(std::string* build_id);
+
+  //! \brief Returns this image’s non-empty `PT_NOTE` segments that lie within
+  //!     the image.
+  //!
+  //! Together with FindBuildIDInNotes(), this allows the notes of several
+  //! images to be read together, rather than by a GetBuildID() call each.
+  //!
+  //! \param[out] segments The note segments, adjusted for the load bias.
+  void GetNoteSegments(std::vector<NoteSegment>* segments) const;
+
+  //! \brief Finds an `NT_GNU_BUILD_ID` note in the contents of a note segment.
+  //!
+  //! \param[in] notes The contents of a note segment.
+  //! \param[in] alignment The alignment of the segment, from NoteSegment.
+  //! \param[out] build_id The contents of the note’s descriptor, if found.
+  //! \return `true` if a build ID note was found. Otherwise `false`, with a
+  //!     message logged only if the notes could not be parsed.
+  static bool FindBuildIDInNotes(const std::string& notes,
+                                 VMSize alignment,
+                                 std::string* build_id);
+
+  //! \brief Finds the unwind rules in effect at \a pc in this image’s call
+  //!     frame information.
+  //!
+  //! The call frame information is located through the image’s
+  //! `PT_GNU_EH_FRAME` segment, which is read the first time this method is
+  //! called. See ElfEhFrameReader::FindRow().
+  //!
+  //! \param[in] pc The address of an instruction in the image.
+  //! \param[out] row The rules, if found.
+  //! \return `true` if rules for \a pc were found. Otherwise `false`, with a
+  //!     message logged only if the call frame information could not be
+  //!     parsed.
+  bool GetCallFrameRow(VMAddress pc, ElfEhFrameReader::Row* row);
+
  private:
   class ProgramHeaderTable;
   template <typename PhdrType>
@@ -109,6 +182,7 @@ class ElfImageReader {
   bool InitializeProgramHeaders();
   bool InitializeDynamicArray();
   bool InitializeDynamicSymbolTable();
+  bool InitializeEhFrame();
   bool GetAddressFromDynamicArray(uint64_t tag, VMAddress* address);
 
   union {
@@ -121,9 +195,11 @@ class ElfImageReader {
   std::unique_ptr<ProgramHeaderTable> program_headers_;
   std::unique_ptr<ElfDynamicArrayReader> dynamic_array_;
   std::unique_ptr<ElfSymbolTableReader> symbol_table_;
+  std::unique_ptr<ElfEhFrameReader> eh_frame_;
   InitializationStateDcheck initialized_;
   InitializationState dynamic_array_initialized_;
   InitializationState symbol_table_initialized_;
+  InitializationState eh_frame_initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(ElfImageReader);
 };
@@ -74,6 +74,14 @@ void ExpectElfImageWithSymbol(pid_t pid,
 
   EXPECT_FALSE(
       reader.GetDynamicSymbol("notasymbol", &symbol_address, &symbol_size));
+
+  // The symbol may have aliases, so only its address is compared.
+  std::string nearest_name;
+  VMAddress nearest_address;
+  ASSERT_TRUE(reader.GetNearestDynamicFunctionSymbol(
+      expected_symbol_address + 1, &nearest_name, &nearest_address));
+  EXPECT_EQ(nearest_address, expected_symbol_address);
+  EXPECT_FALSE(nearest_name.empty());
 }
 
 void ReadThisExecutableInTarget(pid_t pid) {
@@ -153,6 +161,76 @@ TEST(ElfImageReader, OneModuleChild) {
   test.Run();
 }
 
+// Expects the rules that every ABI defines at a function’s first instruction,
+// before it has adjusted the stack or saved anything.
+void ExpectCallFrameRowAtEntry(const ElfEhFrameReader::Row& row) {
+#if defined(ARCH_CPU_X86_64)
+  constexpr uint32_t kStackPointer = 7;
+  constexpr uint32_t kReturnAddress = 16;
+  constexpr int64_t kPointerSize = 8;
+#elif defined(ARCH_CPU_X86)
+  constexpr uint32_t kStackPointer = 4;
+  constexpr uint32_t kReturnAddress = 8;
+  constexpr int64_t kPointerSize = 4;
+#elif defined(ARCH_CPU_ARM64)
+  constexpr uint32_t kStackPointer = 31;
+  constexpr uint32_t kReturnAddress = 30;
+#endif
+
+#if defined(ARCH_CPU_X86_FAMILY)
+  // The call pushed the return address, which the CFA is just above.
+  EXPECT_EQ(row.cfa_register, kStackPointer);
+  EXPECT_EQ(row.cfa_offset, kPointerSize);
+  EXPECT_EQ(row.return_address_register, kReturnAddress);
+  const auto it = row.registers.find(kReturnAddress);
+  ASSERT_NE(it, row.registers.end());
+  EXPECT_EQ(it->second.type, ElfEhFrameReader::RegisterRule::kOffset);
+  EXPECT_EQ(it->second.offset, -kPointerSize);
+#elif defined(ARCH_CPU_ARM64)
+  // The return address is still in the link register.
+  EXPECT_EQ(row.cfa_register, kStackPointer);
+  EXPECT_EQ(row.cfa_offset, 0);
+  EXPECT_EQ(row.return_address_register, kReturnAddress);
+  EXPECT_EQ(row.registers.count(kReturnAddress), 0u);
+#endif
+}
+
+TEST(ElfImageReader, CallFrameRowSelf) {
+#if defined(ARCH_CPU_64_BITS)
+  constexpr bool am_64_bit = true;
+#else
+  constexpr bool am_64_bit = false;
+#endif  // ARCH_CPU_64_BITS
+
+  ProcessMemory memory;
+  ASSERT_TRUE(memory.Initialize(getpid()));
+  ProcessMemoryRange range;
+  ASSERT_TRUE(range.Initialize(&memory, am_64_bit));
+
+  VMAddress elf_address;
+  LocateExecutable(getpid(), am_64_bit, &elf_address);
+  ElfImageReader exe_reader;
+  ASSERT_TRUE(exe_reader.Initialize(range, elf_address));
+
+  ElfEhFrameReader::Row row;
+  ASSERT_TRUE(exe_reader.GetCallFrameRow(
+      FromPointerCast<VMAddress>(ElfImageReaderTestExportedSymbol), &row));
+  ExpectCallFrameRowAtEntry(row);
+
+  // The ELF header isn’t code.
+  EXPECT_FALSE(exe_reader.GetCallFrameRow(elf_address, &row));
+
+  Dl_info info;
+  ASSERT_TRUE(dladdr(reinterpret_cast<void*>(getpid), &info)) << "dladdr:"
+                                                              << dlerror();
+  ElfImageReader libc_reader;
+  ASSERT_TRUE(libc_reader.Initialize(
+      range, FromPointerCast<VMAddress>(info.dli_fbase)));
+  ASSERT_TRUE(
+      libc_reader.GetCallFrameRow(FromPointerCast<VMAddress>(getpid), &row));
+  ExpectCallFrameRowAtEntry(row);
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
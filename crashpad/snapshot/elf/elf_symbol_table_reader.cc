@@ -16,6 +16,9 @@
 
 #include <elf.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "base/logging.h"
 #include "snapshot/elf/elf_image_reader.h"
 
@@ -47,41 +50,364 @@ uint8_t GetVisibility(const Elf64_Sym& sym) {
   return ELF64_ST_VISIBILITY(sym.st_other);
 }
 
+uint32_t GnuHash(const std::string& name) {
+  uint32_t hash = 5381;
+  for (unsigned char c : name) {
+    hash = hash * 33 + c;
+  }
+  return hash;
+}
+
+uint32_t SysVHash(const std::string& name) {
+  uint32_t hash = 0;
+  for (unsigned char c : name) {
+    hash = (hash << 4) + c;
+    const uint32_t high = hash & 0xf0000000;
+    hash ^= high >> 24;
+    hash &= ~high;
+  }
+  return hash;
+}
+
+// The header of a DT_GNU_HASH table. It is followed by |bloom_size| bloom
+// filter words of the image’s address size, |bucket_count| buckets, and the
+// hash chain.
+struct GnuHashHeader {
+  uint32_t bucket_count;
+  uint32_t symbol_offset;
+  uint32_t bloom_size;
+  uint32_t bloom_shift;
+};
+
+// The header of a DT_HASH table. It is followed by |bucket_count| buckets and
+// |chain_count| chain entries.
+struct HashHeader {
+  uint32_t bucket_count;
+  uint32_t chain_count;
+};
+
+// The most symbols read by GetNearestFunctionSymbol(), bounding the read if a
+// hash table is corrupt.
+constexpr uint32_t kMaxNearestSymbolCount = 1 << 20;
+
 }  // namespace
 
 ElfSymbolTableReader::ElfSymbolTableReader(const ProcessMemoryRange* memory,
                                            ElfImageReader* elf_reader,
-                                           VMAddress address)
-    : memory_(memory), elf_reader_(elf_reader), base_address_(address) {}
+                                           VMAddress address,
+                                           VMAddress gnu_hash_address,
+                                           VMAddress hash_address)
+    : memory_(memory),
+      elf_reader_(elf_reader),
+      base_address_(address),
+      gnu_hash_address_(gnu_hash_address),
+      hash_address_(hash_address) {}
 
 ElfSymbolTableReader::~ElfSymbolTableReader() {}
 
 bool ElfSymbolTableReader::GetSymbol(const std::string& name,
                                      SymbolInformation* info) {
-  return memory_->Is64Bit() ? ScanSymbolTable<Elf64_Sym>(name, info)
-                            : ScanSymbolTable<Elf32_Sym>(name, info);
+  const bool is_64_bit = memory_->Is64Bit();
+  bool found;
+  if (gnu_hash_address_ &&
+      (is_64_bit ? GnuHashLookup<Elf64_Sym, uint64_t>(name, info, &found)
+                 : GnuHashLookup<Elf32_Sym, uint32_t>(name, info, &found))) {
+    return found;
+  }
+  if (hash_address_ &&
+      (is_64_bit ? HashLookup<Elf64_Sym>(name, info, &found)
+                 : HashLookup<Elf32_Sym>(name, info, &found))) {
+    return found;
+  }
+  return is_64_bit ? ScanSymbolTable<Elf64_Sym>(name, info)
+                   : ScanSymbolTable<Elf32_Sym>(name, info);
+}
+
+bool ElfSymbolTableReader::GetNearestFunctionSymbol(VMAddress address,
+                                                    std::string* name,
+                                                    SymbolInformation* info) {
+  return memory_->Is64Bit()
+             ? FindNearestFunctionSymbol<Elf64_Sym>(address, name, info)
+             : FindNearestFunctionSymbol<Elf32_Sym>(address, name, info);
+}
+
+template <typename SymEnt, typename BloomWord>
+bool ElfSymbolTableReader::GnuHashLookup(const std::string& name,
+                                         SymbolInformation* info,
+                                         bool* found) {
+  GnuHashHeader header;
+  if (!memory_->Read(gnu_hash_address_, sizeof(header), &header)) {
+    return false;
+  }
+  if (header.bucket_count == 0 || header.bloom_size == 0) {
+    LOG(ERROR) << "empty gnu hash table";
+    return false;
+  }
+
+  const uint32_t hash = GnuHash(name);
+  *found = false;
+
+  // The bloom filter rejects most absent names with a single read.
+  constexpr uint32_t kBloomWordBits = sizeof(BloomWord) * 8;
+  const VMAddress bloom_address = gnu_hash_address_ + sizeof(header);
+  BloomWord bloom_word;
+  if (!memory_->Read(bloom_address +
+                         ((hash / kBloomWordBits) % header.bloom_size) *
+                             sizeof(bloom_word),
+                     sizeof(bloom_word),
+                     &bloom_word)) {
+    return false;
+  }
+  const BloomWord mask =
+      (static_cast<BloomWord>(1) << (hash % kBloomWordBits)) |
+      (static_cast<BloomWord>(1)
+       << ((hash >> header.bloom_shift) % kBloomWordBits));
+  if ((bloom_word & mask) != mask) {
+    return true;
+  }
+
+  const VMAddress buckets_address =
+      bloom_address +
+      static_cast<VMSize>(header.bloom_size) * sizeof(bloom_word);
+  uint32_t index;
+  if (!memory_->Read(buckets_address +
+                         (hash % header.bucket_count) * sizeof(index),
+                     sizeof(index),
+                     &index)) {
+    return false;
+  }
+  if (index < header.symbol_offset) {
+    return true;
+  }
+
+  // Each chain entry holds the hash of the symbol at the same index, with its
+  // low bit replaced by whether it ends the chain.
+  const VMAddress chain_address =
+      buckets_address +
+      static_cast<VMSize>(header.bucket_count) * sizeof(index);
+  uint32_t chain_hash;
+  do {
+    if (!memory_->Read(chain_address +
+                           static_cast<VMSize>(index - header.symbol_offset) *
+                               sizeof(chain_hash),
+                       sizeof(chain_hash),
+                       &chain_hash)) {
+      return false;
+    }
+    if ((chain_hash | 1) == (hash | 1)) {
+      if (!ReadSymbol<SymEnt>(index, name, info, found)) {
+        return false;
+      }
+      if (*found) {
+        return true;
+      }
+    }
+  } while (!(chain_hash & 1) && ++index != 0);
+
+  return true;
+}
+
+template <typename SymEnt>
+bool ElfSymbolTableReader::HashLookup(const std::string& name,
+                                      SymbolInformation* info,
+                                      bool* found) {
+  HashHeader header;
+  if (!memory_->Read(hash_address_, sizeof(header), &header)) {
+    return false;
+  }
+  if (header.bucket_count == 0) {
+    LOG(ERROR) << "empty hash table";
+    return false;
+  }
+
+  *found = false;
+
+  const VMAddress buckets_address = hash_address_ + sizeof(header);
+  const VMAddress chain_address =
+      buckets_address + static_cast<VMSize>(header.bucket_count) *
+                            sizeof(uint32_t);
+  uint32_t index;
+  if (!memory_->Read(buckets_address +
+                         (SysVHash(name) % header.bucket_count) * sizeof(index),
+                     sizeof(index),
+                     &index)) {
+    return false;
+  }
+
+  // A chain can’t be longer than the chain array, which bounds the walk if the
+  // table is corrupt.
+  for (uint32_t steps = 0; index != STN_UNDEF && steps < header.chain_count;
+       ++steps) {
+    if (index >= header.chain_count) {
+      LOG(ERROR) << "bad hash chain";
+      return false;
+    }
+    if (!ReadSymbol<SymEnt>(index, name, info, found)) {
+      return false;
+    }
+    if (*found) {
+      return true;
+    }
+    if (!memory_->Read(chain_address + index * sizeof(index),
+                       sizeof(index),
+                       &index)) {
+      return false;
+    }
+  }
+
+  return true;
 }
 
 template <typename SymEnt>
 bool ElfSymbolTableReader::ScanSymbolTable(const std::string& name,
                                            SymbolInformation* info_out) {
-  VMAddress address = base_address_;
-  SymEnt entry;
-  std::string string;
-  while (memory_->Read(address, sizeof(entry), &entry) &&
-         elf_reader_->ReadDynamicStringTableAtOffset(entry.st_name, &string)) {
-    if (string == name) {
-      info_out->address = entry.st_value;
-      info_out->size = entry.st_size;
-      info_out->shndx = entry.st_shndx;
-      info_out->binding = GetBinding(entry);
-      info_out->type = GetType(entry);
-      info_out->visibility = GetVisibility(entry);
+  for (uint32_t index = 0;; ++index) {
+    bool matched;
+    if (!ReadSymbol<SymEnt>(index, name, info_out, &matched)) {
+      return false;
+    }
+    if (matched) {
       return true;
     }
-    address += sizeof(entry);
   }
-  return false;
+}
+
+template <typename BloomWord>
+bool ElfSymbolTableReader::GetSymbolCount(uint32_t* count) {
+  if (hash_address_) {
+    HashHeader header;
+    if (!memory_->Read(hash_address_, sizeof(header), &header)) {
+      return false;
+    }
+    *count = header.chain_count;
+    return true;
+  }
+
+  if (!gnu_hash_address_) {
+    return false;
+  }
+
+  // A GNU hash table doesn’t record the symbol count. The last symbol is at the
+  // end of the chain that begins at the highest bucket.
+  GnuHashHeader header;
+  if (!memory_->Read(gnu_hash_address_, sizeof(header), &header)) {
+    return false;
+  }
+  if (header.bucket_count == 0 ||
+      header.bucket_count > kMaxNearestSymbolCount) {
+    LOG(ERROR) << "bad gnu hash table";
+    return false;
+  }
+
+  const VMAddress buckets_address =
+      gnu_hash_address_ + sizeof(header) +
+      static_cast<VMSize>(header.bloom_size) * sizeof(BloomWord);
+  std::vector<uint32_t> buckets(header.bucket_count);
+  if (!memory_->Read(buckets_address,
+                     buckets.size() * sizeof(buckets[0]),
+                     buckets.data())) {
+    return false;
+  }
+
+  uint32_t index = 0;
+  for (uint32_t bucket : buckets) {
+    index = std::max(index, bucket);
+  }
+  if (index < header.symbol_offset) {
+    *count = header.symbol_offset;
+    return true;
+  }
+
+  const VMAddress chain_address =
+      buckets_address +
+      static_cast<VMSize>(header.bucket_count) * sizeof(index);
+  uint32_t chain_hash;
+  do {
+    if (index >= kMaxNearestSymbolCount) {
+      LOG(ERROR) << "bad gnu hash chain";
+      return false;
+    }
+    if (!memory_->Read(chain_address +
+                           static_cast<VMSize>(index - header.symbol_offset) *
+                               sizeof(chain_hash),
+                       sizeof(chain_hash),
+                       &chain_hash)) {
+      return false;
+    }
+    ++index;
+  } while (!(chain_hash & 1));
+
+  *count = index;
+  return true;
+}
+
+template <typename SymEnt>
+bool ElfSymbolTableReader::FindNearestFunctionSymbol(VMAddress address,
+                                                     std::string* name,
+                                                     SymbolInformation* info) {
+  uint32_t count;
+  if (!(memory_->Is64Bit() ? GetSymbolCount<uint64_t>(&count)
+                           : GetSymbolCount<uint32_t>(&count))) {
+    return false;
+  }
+  if (count > kMaxNearestSymbolCount) {
+    LOG(ERROR) << "too many symbols " << count;
+    return false;
+  }
+
+  std::vector<SymEnt> symbols(count);
+  if (!memory_->Read(base_address_,
+                     symbols.size() * sizeof(SymEnt),
+                     symbols.data())) {
+    return false;
+  }
+
+  const SymEnt* nearest = nullptr;
+  for (const SymEnt& symbol : symbols) {
+    if (GetType(symbol) == STT_FUNC && symbol.st_shndx != SHN_UNDEF &&
+        symbol.st_value <= address &&
+        (!nearest || symbol.st_value > nearest->st_value)) {
+      nearest = &symbol;
+    }
+  }
+  if (!nearest ||
+      !elf_reader_->ReadDynamicStringTableAtOffset(nearest->st_name, name)) {
+    return false;
+  }
+
+  info->address = nearest->st_value;
+  info->size = nearest->st_size;
+  info->shndx = nearest->st_shndx;
+  info->binding = GetBinding(*nearest);
+  info->type = GetType(*nearest);
+  info->visibility = GetVisibility(*nearest);
+  return true;
+}
+
+template <typename SymEnt>
+bool ElfSymbolTableReader::ReadSymbol(uint32_t index,
+                                      const std::string& name,
+                                      SymbolInformation* info_out,
+                                      bool* matched) {
+  SymEnt entry;
+  std::string string;
+  if (!memory_->Read(base_address_ + static_cast<VMSize>(index) * sizeof(entry),
+                     sizeof(entry),
+                     &entry) ||
+      !elf_reader_->ReadDynamicStringTableAtOffset(entry.st_name, &string)) {
+    return false;
+  }
+
+  *matched = string == name;
+  if (*matched) {
+    info_out->address = entry.st_value;
+    info_out->size = entry.st_size;
+    info_out->shndx = entry.st_shndx;
+    info_out->binding = GetBinding(entry);
+    info_out->type = GetType(entry);
+    info_out->visibility = GetVisibility(entry);
+  }
+  return true;
 }
 
 }  // namespace crashpad
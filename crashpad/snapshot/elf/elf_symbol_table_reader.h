@@ -57,11 +57,24 @@ class ElfSymbolTableReader {
     uint8_t visibility;
   };
 
-  // TODO(jperaza): Support using .hash and .gnu.hash sections to improve symbol
-  // lookup.
+  //! \brief Constructs the object.
+  //!
+  //! \param[in] memory A memory reader for the target process.
+  //! \param[in] elf_reader The image the symbol table belongs to, used to read
+  //!     symbol names.
+  //! \param[in] address The address of the symbol table, from `DT_SYMTAB`.
+  //! \param[in] gnu_hash_address The address of the image’s GNU hash table,
+  //!     from `DT_GNU_HASH`, or `0` if it has none.
+  //! \param[in] hash_address The address of the image’s System V hash table,
+  //!     from `DT_HASH`, or `0` if it has none.
+  //!
+  //! Lookups use the GNU hash table if there is one, then the System V hash
+  //! table, and only scan the symbol table if neither is present or readable.
   ElfSymbolTableReader(const ProcessMemoryRange* memory,
                        ElfImageReader* elf_reader,
-                       VMAddress address);
+                       VMAddress address,
+                       VMAddress gnu_hash_address,
+                       VMAddress hash_address);
   ~ElfSymbolTableReader();
 
   //! \brief Lookup information about a symbol.
@@ -71,13 +84,60 @@ class ElfSymbolTableReader {
   //! \return `true` if the symbol is found.
   bool GetSymbol(const std::string& name, SymbolInformation* info);
 
+  //! \brief Finds the defined function symbol with the highest address at or
+  //!     below \a address.
+  //!
+  //! This reads the whole symbol table, whose size is found from the image’s
+  //! hash table. Images without a hash table can’t be searched.
+  //!
+  //! \param[in] address An address as it exists in the symbol table, not
+  //!     adjusted for any load bias.
+  //! \param[out] name The symbol’s name, if found.
+  //! \param[out] info The symbol information, if found.
+  //! \return `true` if a symbol was found. Otherwise `false`, with a message
+  //!     logged only if the symbol table could not be read.
+  bool GetNearestFunctionSymbol(VMAddress address,
+                                std::string* name,
+                                SymbolInformation* info);
+
  private:
+  // Each lookup returns false if its table could not be read, and otherwise
+  // sets |found| to whether the table holds |name|.
+  template <typename SymEnt, typename BloomWord>
+  bool GnuHashLookup(const std::string& name,
+                     SymbolInformation* info,
+                     bool* found);
+  template <typename SymEnt>
+  bool HashLookup(const std::string& name,
+                  SymbolInformation* info,
+                  bool* found);
+
   template <typename SymEnt>
   bool ScanSymbolTable(const std::string& name, SymbolInformation* info);
 
+  // Determines the number of symbols in the symbol table from a hash table.
+  // Returns false if there is no hash table or it could not be read.
+  template <typename BloomWord>
+  bool GetSymbolCount(uint32_t* count);
+
+  template <typename SymEnt>
+  bool FindNearestFunctionSymbol(VMAddress address,
+                                 std::string* name,
+                                 SymbolInformation* info);
+
+  // Reads the symbol at |index| and, if it is named |name|, sets |info| and
+  // |matched|. Returns false if the symbol could not be read.
+  template <typename SymEnt>
+  bool ReadSymbol(uint32_t index,
+                  const std::string& name,
+                  SymbolInformation* info,
+                  bool* matched);
+
   const ProcessMemoryRange* const memory_;  // weak
   ElfImageReader* const elf_reader_;  // weak
   const VMAddress base_address_;
+  const VMAddress gnu_hash_address_;
+  const VMAddress hash_address_;
 
   DISALLOW_COPY_AND_ASSIGN(ElfSymbolTableReader);
 };
@@ -0,0 +1,225 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/linux/build_id_cache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+#include "base/logging.h"
+#include "util/file/file_io.h"
+#include "util/file/file_reader.h"
+#include "util/file/file_writer.h"
+
+namespace crashpad {
+
+namespace {
+
+// Build IDs are most often 20-byte SHA-1 digests. Anything far longer in a
+// saved file indicates corruption.
+constexpr uint32_t kMaxBuildIDSize = 1024;
+
+}  // namespace
+
+struct BuildIDCache::FileHeader {
+  static constexpr uint32_t kMagic = 'CPbi';
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  uint64_t entry_count;
+};
+
+// Followed by build_id_size bytes of build ID.
+struct BuildIDCache::FileEntry {
+  uint64_t device;
+  uint64_t inode;
+  int64_t modification_time_seconds;
+  int64_t modification_time_nanoseconds;
+  uint32_t build_id_size;
+  uint32_t padding;
+};
+
+bool BuildIDCache::Key::operator<(const Key& other) const {
+  return std::tie(device,
+                  inode,
+                  modification_time_seconds,
+                  modification_time_nanoseconds) <
+         std::tie(other.device,
+                  other.inode,
+                  other.modification_time_seconds,
+                  other.modification_time_nanoseconds);
+}
+
+BuildIDCache::BuildIDCache(size_t max_entries)
+    : entries_(), lock_(), max_entries_(max_entries), modified_(false) {}
+
+BuildIDCache::~BuildIDCache() {}
+
+// static
+bool BuildIDCache::GetKey(const std::string& path,
+                          dev_t device,
+                          ino_t inode,
+                          Key* key) {
+  // The path may not name the same file in this process as in the target, as
+  // when the target is in another mount namespace, or when the file has been
+  // replaced since it was mapped. Only trust the modification time of the file
+  // that was actually mapped.
+  struct stat st;
+  if (path.empty() || stat(path.c_str(), &st) != 0 || st.st_dev != device ||
+      st.st_ino != inode) {
+    return false;
+  }
+
+  key->device = device;
+  key->inode = inode;
+  key->modification_time_seconds = st.st_mtim.tv_sec;
+  key->modification_time_nanoseconds = st.st_mtim.tv_nsec;
+  return true;
+}
+
+bool BuildIDCache::Lookup(const Key& key, std::string* build_id) {
+  base::AutoLock lock(lock_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  *build_id = it->second;
+  return true;
+}
+
+void BuildIDCache::Insert(const Key& key, const std::string& build_id) {
+  base::AutoLock lock(lock_);
+  if (max_entries_ == 0) {
+    return;
+  }
+  if (entries_.size() >= max_entries_ && entries_.find(key) == entries_.end()) {
+    entries_.erase(entries_.begin());
+  }
+  entries_[key] = build_id;
+  modified_ = true;
+}
+
+bool BuildIDCache::Load(const base::FilePath& path) {
+  ScopedFileHandle handle(OpenFileForRead(path));
+  if (!handle.is_valid()) {
+    if (errno == ENOENT) {
+      return true;
+    }
+    PLOG(ERROR) << "open " << path.value();
+    return false;
+  }
+
+  WeakFileHandleFileReader reader(handle.get());
+  FileHeader header;
+  if (!reader.ReadExactly(&header, sizeof(header))) {
+    return false;
+  }
+  if (header.magic != FileHeader::kMagic ||
+      header.version != FileHeader::kVersion) {
+    LOG(ERROR) << "unexpected build ID cache header in " << path.value();
+    return false;
+  }
+
+  base::AutoLock lock(lock_);
+  for (uint64_t index = 0; index < header.entry_count; ++index) {
+    FileEntry file_entry;
+    if (!reader.ReadExactly(&file_entry, sizeof(file_entry))) {
+      return false;
+    }
+    if (file_entry.build_id_size > kMaxBuildIDSize) {
+      LOG(ERROR) << "build ID size " << file_entry.build_id_size
+                 << " out of range in " << path.value();
+      return false;
+    }
+
+    std::string build_id(file_entry.build_id_size, '\0');
+    if (!build_id.empty() &&
+        !reader.ReadExactly(&build_id[0], build_id.size())) {
+      return false;
+    }
+
+    if (entries_.size() >= max_entries_) {
+      continue;
+    }
+
+    Key key;
+    key.device = file_entry.device;
+    key.inode = file_entry.inode;
+    key.modification_time_seconds = file_entry.modification_time_seconds;
+    key.modification_time_nanoseconds =
+        file_entry.modification_time_nanoseconds;
+    entries_.insert(std::make_pair(key, build_id));
+  }
+
+  return true;
+}
+
+bool BuildIDCache::Save(const base::FilePath& path) {
+  base::AutoLock lock(lock_);
+  if (!modified_) {
+    return true;
+  }
+
+  // Write a new file and rename it over the old one, so that a handler
+  // starting concurrently never loads a partially-written file.
+  const base::FilePath new_path(path.value() + ".new");
+  {
+    FileWriter writer;
+    if (!writer.Open(new_path,
+                     FileWriteMode::kTruncateOrCreate,
+                     FilePermissions::kOwnerOnly)) {
+      return false;
+    }
+
+    FileHeader header;
+    header.magic = FileHeader::kMagic;
+    header.version = FileHeader::kVersion;
+    header.entry_count = entries_.size();
+    if (!writer.Write(&header, sizeof(header))) {
+      return false;
+    }
+
+    for (const auto& entry : entries_) {
+      FileEntry file_entry = {};
+      file_entry.device = entry.first.device;
+      file_entry.inode = entry.first.inode;
+      file_entry.modification_time_seconds =
+          entry.first.modification_time_seconds;
+      file_entry.modification_time_nanoseconds =
+          entry.first.modification_time_nanoseconds;
+      file_entry.build_id_size =
+          std::min(entry.second.size(), static_cast<size_t>(kMaxBuildIDSize));
+      if (!writer.Write(&file_entry, sizeof(file_entry)) ||
+          !writer.Write(entry.second.data(), file_entry.build_id_size)) {
+        return false;
+      }
+    }
+  }
+
+  if (rename(new_path.value().c_str(), path.value().c_str()) != 0) {
+    PLOG(ERROR) << "rename " << new_path.value() << " to " << path.value();
+    return false;
+  }
+
+  modified_ = false;
+  return true;
+}
+
+}  // namespace crashpad
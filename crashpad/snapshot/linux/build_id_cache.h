@@ -0,0 +1,121 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_LINUX_BUILD_ID_CACHE_H_
+#define CRASHPAD_SNAPSHOT_LINUX_BUILD_ID_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+
+namespace crashpad {
+
+//! \brief A cache of module build IDs, shared by the snapshots of many
+//!     processes.
+//!
+//! A handler that writes many reports on the same host sees the same binaries
+//! over and over. Entries are keyed by the identity and modification time of
+//! the file that a module was mapped from, so a cached build ID is only used
+//! for an unchanged file. Because most of those binaries outlive any one
+//! handler, the cache can be saved to a file and loaded again when the next
+//! handler starts.
+//!
+//! This class is thread-safe.
+class BuildIDCache {
+ public:
+  //! \brief Identifies a mapped file.
+  struct Key {
+    bool operator<(const Key& other) const;
+
+    dev_t device;
+    ino_t inode;
+    int64_t modification_time_seconds;
+    int64_t modification_time_nanoseconds;
+  };
+
+  //! \brief Constructs the object.
+  //!
+  //! \param[in] max_entries The maximum number of build IDs to keep. When the
+  //!     cache is full, an arbitrary entry is discarded for each new one.
+  explicit BuildIDCache(size_t max_entries);
+
+  ~BuildIDCache();
+
+  //! \brief Determines the key for a module.
+  //!
+  //! \param[in] path The path of the module’s file.
+  //! \param[in] device The device of the module’s mapping.
+  //! \param[in] inode The inode of the module’s mapping.
+  //! \param[out] key The key, if found.
+  //! \return `true` if \a path names the file with \a device and \a inode, as
+  //!     seen by this process. `false` otherwise, in which case the module must
+  //!     not be cached. No message is logged.
+  static bool GetKey(const std::string& path,
+                     dev_t device,
+                     ino_t inode,
+                     Key* key);
+
+  //! \brief Looks up a build ID.
+  //!
+  //! \param[in] key The key of the module.
+  //! \param[out] build_id The build ID, if found. This is empty for a module
+  //!     known to have no build ID.
+  //! \return `true` if \a key was found.
+  bool Lookup(const Key& key, std::string* build_id);
+
+  //! \brief Records a build ID, which may be empty if the module has none.
+  void Insert(const Key& key, const std::string& build_id);
+
+  //! \brief Adds the entries saved to a file by Save().
+  //!
+  //! Entries already in the cache are kept in preference to those in the file.
+  //!
+  //! \param[in] path The path of the file.
+  //! \return `true` on success, or if \a path doesn’t exist. `false` if the
+  //!     file couldn’t be read or isn’t valid, with a message logged. Entries
+  //!     read before an error was detected are kept.
+  bool Load(const base::FilePath& path);
+
+  //! \brief Saves the cache’s entries to a file, if any have been inserted
+  //!     since the cache was last loaded or saved.
+  //!
+  //! The file is replaced atomically, so a concurrent Load() sees either the
+  //! old or the new contents.
+  //!
+  //! \param[in] path The path of the file.
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool Save(const base::FilePath& path);
+
+ private:
+  struct FileHeader;
+  struct FileEntry;
+
+  std::map<Key, std::string> entries_;
+  base::Lock lock_;
+  const size_t max_entries_;
+  bool modified_;
+
+  DISALLOW_COPY_AND_ASSIGN(BuildIDCache);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_LINUX_BUILD_ID_CACHE_H_
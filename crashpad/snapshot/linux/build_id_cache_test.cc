@@ -0,0 +1,149 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/linux/build_id_cache.h"
+
+#include <sys/stat.h>
+
+#include "base/files/file_path.h"
+#include "gtest/gtest.h"
+#include "test/errors.h"
+#include "test/scoped_temp_dir.h"
+#include "util/file/file_io.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+BuildIDCache::Key MakeKey(ino_t inode) {
+  BuildIDCache::Key key;
+  key.device = 1;
+  key.inode = inode;
+  key.modification_time_seconds = 2;
+  key.modification_time_nanoseconds = 3;
+  return key;
+}
+
+TEST(BuildIDCache, LookupAndInsert) {
+  BuildIDCache cache(2);
+
+  std::string build_id;
+  EXPECT_FALSE(cache.Lookup(MakeKey(1), &build_id));
+
+  cache.Insert(MakeKey(1), "one");
+  cache.Insert(MakeKey(2), std::string());
+  ASSERT_TRUE(cache.Lookup(MakeKey(1), &build_id));
+  EXPECT_EQ(build_id, "one");
+
+  // A module without a build ID is cached as such.
+  build_id = "stale";
+  ASSERT_TRUE(cache.Lookup(MakeKey(2), &build_id));
+  EXPECT_TRUE(build_id.empty());
+
+  // Replacing an entry doesn’t evict another.
+  cache.Insert(MakeKey(1), "uno");
+  ASSERT_TRUE(cache.Lookup(MakeKey(1), &build_id));
+  EXPECT_EQ(build_id, "uno");
+  EXPECT_TRUE(cache.Lookup(MakeKey(2), &build_id));
+
+  // A full cache makes room for a new entry.
+  cache.Insert(MakeKey(3), "three");
+  ASSERT_TRUE(cache.Lookup(MakeKey(3), &build_id));
+  EXPECT_EQ(build_id, "three");
+  EXPECT_NE(cache.Lookup(MakeKey(1), &build_id),
+            cache.Lookup(MakeKey(2), &build_id));
+
+  // The modification time is part of the key.
+  BuildIDCache::Key key = MakeKey(3);
+  ++key.modification_time_nanoseconds;
+  EXPECT_FALSE(cache.Lookup(key, &build_id));
+}
+
+TEST(BuildIDCache, GetKey) {
+  ScopedTempDir temp_dir;
+  base::FilePath path = temp_dir.path().Append(FILE_PATH_LITERAL("module"));
+  ScopedFileHandle handle(LoggingOpenFileForWrite(
+      path, FileWriteMode::kCreateOrFail, FilePermissions::kOwnerOnly));
+  ASSERT_TRUE(handle.is_valid());
+
+  struct stat st;
+  ASSERT_EQ(stat(path.value().c_str(), &st), 0) << ErrnoMessage("stat");
+
+  BuildIDCache::Key key;
+  ASSERT_TRUE(BuildIDCache::GetKey(path.value(), st.st_dev, st.st_ino, &key));
+  EXPECT_EQ(key.device, st.st_dev);
+  EXPECT_EQ(key.inode, st.st_ino);
+  EXPECT_EQ(key.modification_time_seconds, st.st_mtim.tv_sec);
+  EXPECT_EQ(key.modification_time_nanoseconds, st.st_mtim.tv_nsec);
+
+  // A path that no longer names the mapped file can’t be keyed.
+  EXPECT_FALSE(
+      BuildIDCache::GetKey(path.value(), st.st_dev, st.st_ino + 1, &key));
+  EXPECT_FALSE(BuildIDCache::GetKey(
+      temp_dir.path().Append(FILE_PATH_LITERAL("missing")).value(),
+      st.st_dev,
+      st.st_ino,
+      &key));
+  EXPECT_FALSE(BuildIDCache::GetKey(std::string(), st.st_dev, st.st_ino, &key));
+}
+
+TEST(BuildIDCache, SaveAndLoad) {
+  ScopedTempDir temp_dir;
+  base::FilePath path = temp_dir.path().Append(FILE_PATH_LITERAL("cache"));
+
+  // A missing file is an empty cache.
+  BuildIDCache cache(3);
+  ASSERT_TRUE(cache.Load(path));
+
+  cache.Insert(MakeKey(1), "one");
+  cache.Insert(MakeKey(2), std::string());
+  ASSERT_TRUE(cache.Save(path));
+
+  BuildIDCache loaded(3);
+  loaded.Insert(MakeKey(1), "uno");
+  ASSERT_TRUE(loaded.Load(path));
+
+  // Entries already in the cache are kept.
+  std::string build_id;
+  ASSERT_TRUE(loaded.Lookup(MakeKey(1), &build_id));
+  EXPECT_EQ(build_id, "uno");
+  build_id = "stale";
+  ASSERT_TRUE(loaded.Lookup(MakeKey(2), &build_id));
+  EXPECT_TRUE(build_id.empty());
+  EXPECT_FALSE(loaded.Lookup(MakeKey(3), &build_id));
+
+  // Loading doesn’t exceed the cache’s capacity.
+  BuildIDCache small(1);
+  ASSERT_TRUE(small.Load(path));
+  EXPECT_NE(small.Lookup(MakeKey(1), &build_id),
+            small.Lookup(MakeKey(2), &build_id));
+
+  // A cache with nothing new to save leaves the file alone.
+  ASSERT_TRUE(small.Save(base::FilePath()));
+
+  // A file that isn’t a cache isn’t loaded.
+  base::FilePath bogus_path =
+      temp_dir.path().Append(FILE_PATH_LITERAL("bogus"));
+  ScopedFileHandle handle(LoggingOpenFileForWrite(
+      bogus_path, FileWriteMode::kCreateOrFail, FilePermissions::kOwnerOnly));
+  ASSERT_TRUE(handle.is_valid());
+  static constexpr char kBogus[] = "not a build ID cache";
+  ASSERT_TRUE(LoggingWriteFile(handle.get(), kBogus, sizeof(kBogus)));
+  handle.reset();
+  EXPECT_FALSE(loaded.Load(bogus_path));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
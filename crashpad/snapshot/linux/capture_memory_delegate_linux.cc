@@ -0,0 +1,127 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/linux/capture_memory_delegate_linux.h"
+
+#include <algorithm>
+
+#include "base/numerics/safe_conversions.h"
+#include "snapshot/linux/memory_snapshot_linux.h"
+#include "util/linux/memory_map.h"
+
+namespace crashpad {
+namespace internal {
+
+CaptureMemoryDelegateLinux::CaptureMemoryDelegateLinux(
+    ProcessReader* process_reader,
+    const CheckedRange<uint64_t, uint64_t>& stack,
+    PointerVector<MemorySnapshotLinux>* snapshots)
+    : stack_(stack),
+      process_reader_(process_reader),
+      snapshots_(snapshots) {}
+
+CaptureMemoryDelegateLinux::~CaptureMemoryDelegateLinux() {}
+
+bool CaptureMemoryDelegateLinux::Is64Bit() const {
+  return process_reader_->Is64Bit();
+}
+
+bool CaptureMemoryDelegateLinux::ReadMemory(uint64_t at,
+                                            uint64_t num_bytes,
+                                            void* into) const {
+  return base::IsValueInRangeForNumericType<size_t>(num_bytes) &&
+         process_reader_->Memory()->Read(
+             at, static_cast<size_t>(num_bytes), into);
+}
+
+std::vector<CheckedRange<uint64_t>>
+CaptureMemoryDelegateLinux::GetReadableRanges(
+    const CheckedRange<uint64_t, uint64_t>& range) const {
+  std::vector<CheckedRange<uint64_t>> ranges;
+  if (!range.IsValid() || range.size() == 0) {
+    return ranges;
+  }
+
+  // Mappings are sorted and don’t overlap, so the ones overlapping |range|
+  // start with the first that ends after its base.
+  const std::vector<MemoryMap::Mapping>& mappings =
+      process_reader_->GetMemoryMap()->Mappings();
+  auto it = std::upper_bound(
+      mappings.begin(),
+      mappings.end(),
+      range.base(),
+      [](uint64_t address, const MemoryMap::Mapping& mapping) {
+        return address < mapping.range.End();
+      });
+  for (; it != mappings.end() && it->range.Base() < range.end(); ++it) {
+    if (!it->readable) {
+      continue;
+    }
+
+    const uint64_t base = std::max(range.base(), it->range.Base());
+    const uint64_t end = std::min(range.end(), it->range.End());
+    if (!ranges.empty() && ranges.back().end() == base) {
+      // Adjacent readable mappings are captured as one range.
+      ranges.back().SetRange(ranges.back().base(),
+                             end - ranges.back().base());
+    } else {
+      ranges.push_back(CheckedRange<uint64_t>(base, end - base));
+    }
+  }
+  return ranges;
+}
+
+void CaptureMemoryDelegateLinux::GetMappedAddressBounds(uint64_t* low,
+                                                        uint64_t* high) const {
+  const std::vector<MemoryMap::Mapping>& mappings =
+      process_reader_->GetMemoryMap()->Mappings();
+  if (mappings.empty()) {
+    // Nothing is mapped, so nothing can be captured.
+    *low = 1;
+    *high = 0;
+    return;
+  }
+
+  *low = mappings.front().range.Base();
+  *high = mappings.back().range.End() - 1;
+}
+
+bool CaptureMemoryDelegateLinux::IsHeapAddress(uint64_t address) const {
+  // Heaps are built from writable, anonymous, private mappings: [heap] itself
+  // and the unnamed mappings that allocators create. Stacks are too, but
+  // pointers into this thread’s stack aren’t captured anyway.
+  const MemoryMap::Mapping* mapping =
+      process_reader_->GetMemoryMap()->FindMapping(address);
+  return mapping && mapping->readable && mapping->writable &&
+         !mapping->executable && !mapping->shareable && mapping->inode == 0 &&
+         (mapping->name.empty() || mapping->name == "[heap]");
+}
+
+void CaptureMemoryDelegateLinux::AddNewMemorySnapshot(
+    const CheckedRange<uint64_t, uint64_t>& range) {
+  // Don’t bother storing this memory if it points back into the stack.
+  if (stack_.ContainsRange(range))
+    return;
+  if (range.size() == 0)
+    return;
+  if (!base::IsValueInRangeForNumericType<size_t>(range.size()))
+    return;
+  MemorySnapshotLinux* snapshot = new MemorySnapshotLinux();
+  snapshot->Initialize(
+      process_reader_, range.base(), static_cast<size_t>(range.size()));
+  snapshots_->push_back(snapshot);
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,69 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_LINUX_CAPTURE_MEMORY_DELEGATE_LINUX_H_
+#define CRASHPAD_SNAPSHOT_LINUX_CAPTURE_MEMORY_DELEGATE_LINUX_H_
+
+#include "snapshot/capture_memory.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "snapshot/linux/process_reader.h"
+#include "util/stdlib/pointer_container.h"
+
+namespace crashpad {
+namespace internal {
+
+class MemorySnapshotLinux;
+
+class CaptureMemoryDelegateLinux : public CaptureMemory::Delegate {
+ public:
+  //! \brief A MemoryCaptureDelegate for Linux.
+  //!
+  //! \param[in] process_reader A ProcessReader for the target process.
+  //! \param[in] stack The stack of the thread being inspected, or an empty
+  //!     range if it isn’t known. Memory ranges within it will be ignored on
+  //!     the assumption that they’re already captured elsewhere.
+  //! \param[in] snapshots A vector of MemorySnapshotLinux to which the captured
+  //!     memory will be added.
+  CaptureMemoryDelegateLinux(ProcessReader* process_reader,
+                             const CheckedRange<uint64_t, uint64_t>& stack,
+                             PointerVector<MemorySnapshotLinux>* snapshots);
+  ~CaptureMemoryDelegateLinux() override;
+
+  // MemoryCaptureDelegate:
+  bool Is64Bit() const override;
+  bool ReadMemory(uint64_t at, uint64_t num_bytes, void* into) const override;
+  std::vector<CheckedRange<uint64_t>> GetReadableRanges(
+      const CheckedRange<uint64_t, uint64_t>& range) const override;
+  void GetMappedAddressBounds(uint64_t* low, uint64_t* high) const override;
+  bool IsHeapAddress(uint64_t address) const override;
+  void AddNewMemorySnapshot(
+      const CheckedRange<uint64_t, uint64_t>& range) override;
+
+ private:
+  CheckedRange<uint64_t, uint64_t> stack_;
+  ProcessReader* process_reader_;  // weak
+  PointerVector<MemorySnapshotLinux>* snapshots_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(CaptureMemoryDelegateLinux);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_LINUX_CAPTURE_MEMORY_DELEGATE_LINUX_H_
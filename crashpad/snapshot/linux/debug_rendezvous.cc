@@ -52,23 +52,27 @@ struct LinkEntrySpecific {
   typename Traits::Address l_prev;
 };
 
+constexpr size_t kMaxNameSize = 4096;
+
+// Reads the link_map entry at |*address| into |entry_out|, except for its name,
+// whose address is appended to |names|.
 template <typename Traits>
 bool ReadLinkEntry(const ProcessMemoryRange& memory,
                    LinuxVMAddress* address,
-                   DebugRendezvous::LinkEntry* entry_out) {
+                   DebugRendezvous::LinkEntry* entry_out,
+                   std::vector<ProcessMemory::CStringRequest>* names) {
   LinkEntrySpecific<Traits> entry;
   if (!memory.Read(*address, sizeof(entry), &entry)) {
     return false;
   }
 
-  std::string name;
-  if (!memory.ReadCStringSizeLimited(entry.l_name, 4096, &name)) {
-    return false;
-  }
+  ProcessMemory::CStringRequest name;
+  name.address = entry.l_name;
+  name.size = kMaxNameSize;
+  names->push_back(name);
 
   entry_out->load_bias = entry.l_addr;
   entry_out->dynamic_array = entry.l_ld;
-  entry_out->name.swap(name);
 
   *address = entry.l_next;
   return true;
@@ -118,8 +122,10 @@ bool DebugRendezvous::InitializeSpecific(const ProcessMemoryRange& memory,
     return false;
   }
 
+  std::vector<ProcessMemory::CStringRequest> names;
   LinuxVMAddress link_entry_address = debug.r_map;
-  if (!ReadLinkEntry<Traits>(memory, &link_entry_address, &executable_)) {
+  if (!ReadLinkEntry<Traits>(
+          memory, &link_entry_address, &executable_, &names)) {
     return false;
   }
 
@@ -131,12 +137,25 @@ bool DebugRendezvous::InitializeSpecific(const ProcessMemoryRange& memory,
     }
 
     LinkEntry entry;
-    if (!ReadLinkEntry<Traits>(memory, &link_entry_address, &entry)) {
+    if (!ReadLinkEntry<Traits>(memory, &link_entry_address, &entry, &names)) {
       return false;
     }
     modules_.push_back(entry);
   }
 
+  // The loader allocates the names close together, so reading them all at
+  // once takes only as many reads as the pages they share.
+  std::string arena;
+  std::vector<size_t> offsets;
+  if (!memory.ReadCStringBatch(names, &arena, &offsets)) {
+    return false;
+  }
+  DCHECK_EQ(offsets.size(), modules_.size() + 1);
+  executable_.name.assign(arena.c_str() + offsets[0]);
+  for (size_t index = 0; index < modules_.size(); ++index) {
+    modules_[index].name.assign(arena.c_str() + offsets[index + 1]);
+  }
+
   return true;
 }
 
@@ -160,7 +160,7 @@ void TestAgainstTarget(pid_t pid, bool is_64_bit) {
                  (module_name.empty() ||
                   module_name.compare(0, strlen(kPrefix), kPrefix) == 0);
         },
-        module_mapping->name,
+        module_mapping->name.as_string(),
         module_mapping->device,
         module_mapping->inode,
         module.name);
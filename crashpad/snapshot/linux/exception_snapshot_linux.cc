@@ -17,10 +17,14 @@
 #include <signal.h>
 
 #include "base/logging.h"
+#include "snapshot/capture_memory.h"
+#include "snapshot/linux/capture_memory_delegate_linux.h"
 #include "snapshot/linux/cpu_context_linux.h"
+#include "snapshot/linux/memory_snapshot_linux.h"
 #include "snapshot/linux/process_reader.h"
 #include "snapshot/linux/signal_context.h"
 #include "util/linux/traits.h"
+#include "util/misc/memory_read_trace.h"
 #include "util/misc/reinterpret_bytes.h"
 #include "util/numeric/safe_assignment.h"
 
@@ -32,6 +36,7 @@ ExceptionSnapshotLinux::ExceptionSnapshotLinux()
       context_union_(),
       context_(),
       codes_(),
+      extra_memory_(),
       thread_id_(0),
       exception_address_(0),
       signal_number_(0),
@@ -113,10 +118,37 @@ bool ExceptionSnapshotLinux::Initialize(ProcessReader* process_reader,
     }
   }
 
+#if defined(ARCH_CPU_X86_FAMILY)
+  CaptureExceptionMemory(process_reader);
+#endif
+
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
 
+#if defined(ARCH_CPU_X86_FAMILY)
+void ExceptionSnapshotLinux::CaptureExceptionMemory(ProcessReader* reader) {
+  // The thread’s stack is captured with the thread, so memory within it isn’t
+  // captured again here.
+  CheckedRange<uint64_t, uint64_t> stack(0, 0);
+  for (const ProcessReader::Thread& thread : reader->Threads()) {
+    if (thread.tid == static_cast<pid_t>(thread_id_)) {
+      stack.SetRange(thread.stack_region_address, thread.stack_region_size);
+      break;
+    }
+  }
+
+  // Only these signals’ addresses are those of a data access.
+  const uint64_t fault_address =
+      signal_number_ == SIGSEGV || signal_number_ == SIGBUS ? exception_address_
+                                                            : 0;
+
+  ScopedMemoryReadSite read_site(MemoryReadSite::kIndirectMemory);
+  CaptureMemoryDelegateLinux delegate(reader, stack, &extra_memory_);
+  CaptureMemory::AroundException(context_, fault_address, &delegate);
+}
+#endif  // ARCH_CPU_X86_FAMILY
+
 template <typename Traits>
 bool ExceptionSnapshotLinux::ReadSiginfo(ProcessReader* reader,
                                          LinuxVMAddress siginfo_address) {
@@ -230,7 +262,8 @@ const std::vector<uint64_t>& ExceptionSnapshotLinux::Codes() const {
 
 std::vector<const MemorySnapshot*> ExceptionSnapshotLinux::ExtraMemory() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  return std::vector<const MemorySnapshot*>();
+  return std::vector<const MemorySnapshot*>(extra_memory_.begin(),
+                                            extra_memory_.end());
 }
 
 }  // namespace internal
@@ -28,10 +28,13 @@
 #include "snapshot/linux/process_reader.h"
 #include "util/linux/address_types.h"
 #include "util/misc/initialization_state_dcheck.h"
+#include "util/stdlib/pointer_container.h"
 
 namespace crashpad {
 namespace internal {
 
+class MemorySnapshotLinux;
+
 //! \brief An ExceptionSnapshot of an signal received by a running (or crashed)
 //!     process on a Linux system.
 class ExceptionSnapshotLinux final : public ExceptionSnapshot {
@@ -49,6 +52,10 @@ class ExceptionSnapshotLinux final : public ExceptionSnapshot {
   //!     space of the ucontext_t passed to the signal handler.
   //! \param[in] thread_id The thread ID of the thread that received the signal.
   //!
+  //! On x86 and x86_64, the memory around the instruction pointer, the fault
+  //! address, and the faulting instruction’s memory operands is captured too,
+  //! and is available through ExtraMemory().
+  //!
   //! \return `true` if the snapshot could be created, `false` otherwise with
   //!     an appropriate message logged.
   bool Initialize(ProcessReader* process_reader,
@@ -73,6 +80,10 @@ class ExceptionSnapshotLinux final : public ExceptionSnapshot {
   template <typename Traits>
   bool ReadContext(ProcessReader* reader, LinuxVMAddress context_address);
 
+#if defined(ARCH_CPU_X86_FAMILY)
+  void CaptureExceptionMemory(ProcessReader* reader);
+#endif
+
 #if defined(ARCH_CPU_X86_FAMILY)
   union {
     CPUContextX86 x86;
@@ -81,6 +92,7 @@ class ExceptionSnapshotLinux final : public ExceptionSnapshot {
 #endif
   CPUContext context_;
   std::vector<uint64_t> codes_;
+  PointerVector<MemorySnapshotLinux> extra_memory_;
   uint64_t thread_id_;
   uint64_t exception_address_;
   uint32_t signal_number_;
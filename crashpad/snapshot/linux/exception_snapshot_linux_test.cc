@@ -60,6 +60,10 @@ void InitializeContext(NativeCPUContext* context) {
   memset(&context->fxsave, 43, sizeof(context->fxsave));
 }
 
+void SetInstructionPointer(NativeCPUContext* context, uintptr_t address) {
+  context->ucontext.uc_mcontext.gregs[REG_EIP] = address;
+}
+
 void ExpectContext(const CPUContext& actual, const NativeCPUContext& expected) {
   EXPECT_EQ(actual.architecture, kCPUArchitectureX86);
   EXPECT_EQ(actual.x86->eax,
@@ -79,6 +83,10 @@ void InitializeContext(NativeCPUContext* context) {
   memset(&context->__fpregs_mem, 44, sizeof(context->__fpregs_mem));
 }
 
+void SetInstructionPointer(NativeCPUContext* context, uintptr_t address) {
+  context->uc_mcontext.gregs[REG_RIP] = address;
+}
+
 void ExpectContext(const CPUContext& actual, const NativeCPUContext& expected) {
   EXPECT_EQ(actual.architecture, kCPUArchitectureX86_64);
   EXPECT_EQ(actual.x86_64->rax,
@@ -111,6 +119,8 @@ TEST(ExceptionSnapshotLinux, SelfBasic) {
 
   NativeCPUContext context;
   InitializeContext(&context);
+  const uint64_t instruction_pointer = FromPointerCast<uint64_t>(gettid);
+  SetInstructionPointer(&context, static_cast<uintptr_t>(instruction_pointer));
 
   internal::ExceptionSnapshotLinux exception;
   ASSERT_TRUE(exception.Initialize(&process_reader,
@@ -122,6 +132,16 @@ TEST(ExceptionSnapshotLinux, SelfBasic) {
   EXPECT_EQ(exception.ExceptionAddress(),
             FromPointerCast<uint64_t>(siginfo.si_addr));
   ExpectContext(*exception.Context(), context);
+
+  // The code around the instruction pointer is captured.
+  bool captured_code = false;
+  for (const MemorySnapshot* memory : exception.ExtraMemory()) {
+    if (instruction_pointer >= memory->Address() &&
+        instruction_pointer - memory->Address() < memory->Size()) {
+      captured_code = true;
+    }
+  }
+  EXPECT_TRUE(captured_code);
 }
 
 class ScopedSigactionRestore {
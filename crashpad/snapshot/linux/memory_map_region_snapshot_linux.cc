@@ -0,0 +1,69 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/linux/memory_map_region_snapshot_linux.h"
+
+namespace crashpad {
+namespace internal {
+
+namespace {
+
+uint32_t ProtectionForMapping(const MemoryMap::Mapping& mapping) {
+  if (mapping.writable) {
+    return mapping.executable ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE;
+  }
+  if (mapping.readable) {
+    return mapping.executable ? PAGE_EXECUTE_READ : PAGE_READONLY;
+  }
+  return mapping.executable ? PAGE_EXECUTE : PAGE_NOACCESS;
+}
+
+}  // namespace
+
+MemoryMapRegionSnapshotLinux::MemoryMapRegionSnapshotLinux(
+    const MemoryMap::Mapping& mapping,
+    LinuxVMAddress allocation_base,
+    bool is_module)
+    : MemoryMapRegionSnapshot(), memory_info_() {
+  memory_info_.BaseAddress = mapping.range.Base();
+  memory_info_.AllocationBase = allocation_base;
+  memory_info_.AllocationProtect = ProtectionForMapping(mapping);
+  memory_info_.RegionSize = mapping.range.Size();
+  memory_info_.State = MEM_COMMIT;
+  memory_info_.Protect = memory_info_.AllocationProtect;
+  if (mapping.inode == 0 && !mapping.shareable &&
+      memory_info_.AllocationProtect == PAGE_NOACCESS) {
+    // Anonymous memory that can’t be accessed, such as a guard page or address
+    // space set aside by an allocator, corresponds to reserved memory.
+    memory_info_.State = MEM_RESERVE;
+    memory_info_.Protect = 0;
+  }
+  if (mapping.inode == 0) {
+    memory_info_.Type = MEM_PRIVATE;
+  } else if (is_module && !mapping.shareable) {
+    memory_info_.Type = MEM_IMAGE;
+  } else {
+    memory_info_.Type = MEM_MAPPED;
+  }
+}
+
+MemoryMapRegionSnapshotLinux::~MemoryMapRegionSnapshotLinux() {}
+
+const MINIDUMP_MEMORY_INFO& MemoryMapRegionSnapshotLinux::AsMinidumpMemoryInfo()
+    const {
+  return memory_info_;
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,61 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_LINUX_MEMORY_MAP_REGION_SNAPSHOT_LINUX_H_
+#define CRASHPAD_SNAPSHOT_LINUX_MEMORY_MAP_REGION_SNAPSHOT_LINUX_H_
+
+#include "base/macros.h"
+#include "snapshot/memory_map_region_snapshot.h"
+#include "util/linux/address_types.h"
+#include "util/linux/memory_map.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief A MemoryMapRegionSnapshot of a mapping in a process running on a
+//!     Linux system.
+class MemoryMapRegionSnapshotLinux final : public MemoryMapRegionSnapshot {
+ public:
+  //! \brief Describes \a mapping in a MINIDUMP_MEMORY_INFO.
+  //!
+  //! The mapping’s permissions are expressed as an equivalent \ref PAGE_x
+  //! "PAGE_*" value. A mapping of a module file that isn’t shared is given the
+  //! type ::MEM_IMAGE, another mapping of a file is given ::MEM_MAPPED, and an
+  //! anonymous mapping is given ::MEM_PRIVATE. Every mapping is ::MEM_COMMIT,
+  //! except for a private anonymous mapping that can’t be accessed, which is
+  //! ::MEM_RESERVE with no `Protect` value. Nothing is read from the process.
+  //!
+  //! \param[in] mapping The mapping to describe.
+  //! \param[in] allocation_base The base address of the first mapping of the
+  //!     file that \a mapping maps, or of \a mapping itself if it doesn’t map
+  //!     a file.
+  //! \param[in] is_module Whether \a mapping maps the file of a module.
+  MemoryMapRegionSnapshotLinux(const MemoryMap::Mapping& mapping,
+                               LinuxVMAddress allocation_base,
+                               bool is_module);
+  ~MemoryMapRegionSnapshotLinux() override;
+
+  // MemoryMapRegionSnapshot:
+  const MINIDUMP_MEMORY_INFO& AsMinidumpMemoryInfo() const override;
+
+ private:
+  MINIDUMP_MEMORY_INFO memory_info_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryMapRegionSnapshotLinux);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_LINUX_MEMORY_MAP_REGION_SNAPSHOT_LINUX_H_
@@ -0,0 +1,93 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/linux/memory_map_region_snapshot_linux.h"
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr LinuxVMAddress kBase = 0x10000;
+constexpr LinuxVMSize kSize = 0x3000;
+
+MemoryMap::Mapping AnonymousMapping(bool readable, bool writable) {
+  MemoryMap::Mapping mapping;
+  mapping.range.SetRange(true, kBase, kSize);
+  mapping.readable = readable;
+  mapping.writable = writable;
+  return mapping;
+}
+
+TEST(MemoryMapRegionSnapshotLinux, Anonymous) {
+  internal::MemoryMapRegionSnapshotLinux region(
+      AnonymousMapping(true, true), kBase, false);
+  const MINIDUMP_MEMORY_INFO& memory_info = region.AsMinidumpMemoryInfo();
+  EXPECT_EQ(memory_info.BaseAddress, kBase);
+  EXPECT_EQ(memory_info.AllocationBase, kBase);
+  EXPECT_EQ(memory_info.RegionSize, kSize);
+  EXPECT_EQ(memory_info.State, static_cast<uint32_t>(MEM_COMMIT));
+  EXPECT_EQ(memory_info.Protect, static_cast<uint32_t>(PAGE_READWRITE));
+  EXPECT_EQ(memory_info.AllocationProtect,
+            static_cast<uint32_t>(PAGE_READWRITE));
+  EXPECT_EQ(memory_info.Type, static_cast<uint32_t>(MEM_PRIVATE));
+}
+
+TEST(MemoryMapRegionSnapshotLinux, Reserved) {
+  internal::MemoryMapRegionSnapshotLinux region(
+      AnonymousMapping(false, false), kBase, false);
+  const MINIDUMP_MEMORY_INFO& memory_info = region.AsMinidumpMemoryInfo();
+  EXPECT_EQ(memory_info.State, static_cast<uint32_t>(MEM_RESERVE));
+  EXPECT_EQ(memory_info.Protect, 0u);
+  EXPECT_EQ(memory_info.AllocationProtect,
+            static_cast<uint32_t>(PAGE_NOACCESS));
+  EXPECT_EQ(memory_info.Type, static_cast<uint32_t>(MEM_PRIVATE));
+}
+
+TEST(MemoryMapRegionSnapshotLinux, Module) {
+  MemoryMap::Mapping mapping;
+  mapping.range.SetRange(true, kBase + kSize, kSize);
+  mapping.inode = 1;
+  mapping.readable = true;
+  mapping.executable = true;
+
+  internal::MemoryMapRegionSnapshotLinux module_region(mapping, kBase, true);
+  const MINIDUMP_MEMORY_INFO& module_info =
+      module_region.AsMinidumpMemoryInfo();
+  EXPECT_EQ(module_info.BaseAddress, kBase + kSize);
+  EXPECT_EQ(module_info.AllocationBase, kBase);
+  EXPECT_EQ(module_info.State, static_cast<uint32_t>(MEM_COMMIT));
+  EXPECT_EQ(module_info.Protect, static_cast<uint32_t>(PAGE_EXECUTE_READ));
+  EXPECT_EQ(module_info.Type, static_cast<uint32_t>(MEM_IMAGE));
+
+  // A file that isn’t a module’s is mapped, as is a module’s shared mapping,
+  // and neither is reserved even if it can’t be accessed.
+  mapping.readable = false;
+  mapping.executable = false;
+  internal::MemoryMapRegionSnapshotLinux file_region(mapping, kBase, false);
+  const MINIDUMP_MEMORY_INFO& file_info = file_region.AsMinidumpMemoryInfo();
+  EXPECT_EQ(file_info.State, static_cast<uint32_t>(MEM_COMMIT));
+  EXPECT_EQ(file_info.Protect, static_cast<uint32_t>(PAGE_NOACCESS));
+  EXPECT_EQ(file_info.Type, static_cast<uint32_t>(MEM_MAPPED));
+
+  mapping.shareable = true;
+  internal::MemoryMapRegionSnapshotLinux shared_region(mapping, kBase, true);
+  EXPECT_EQ(shared_region.AsMinidumpMemoryInfo().Type,
+            static_cast<uint32_t>(MEM_MAPPED));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
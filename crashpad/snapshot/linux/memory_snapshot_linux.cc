@@ -16,6 +16,8 @@
 
 #include <memory>
 
+#include "base/logging.h"
+
 namespace crashpad {
 namespace internal {
 
@@ -57,11 +59,42 @@ bool MemorySnapshotLinux::Read(Delegate* delegate) const {
     return delegate->MemorySnapshotDelegateRead(nullptr, size_);
   }
 
-  std::unique_ptr<uint8_t[]> buffer(new uint8_t[size_]);
-  if (!process_reader_->Memory()->Read(address_, size_, buffer.get())) {
+  // Read directly into the delegate’s storage when it offers some, avoiding
+  // an intermediate allocation and copy.
+  void* buffer = delegate->MemorySnapshotDelegateBuffer(size_);
+  std::unique_ptr<uint8_t[]> owned_buffer;
+  if (!buffer) {
+    owned_buffer.reset(new uint8_t[size_]);
+    buffer = owned_buffer.get();
+  }
+
+  if (!process_reader_->Memory()->Read(address_, size_, buffer)) {
     return false;
   }
-  return delegate->MemorySnapshotDelegateRead(buffer.get(), size_);
+  return delegate->MemorySnapshotDelegateRead(buffer, size_);
+}
+
+const MemorySnapshot* MemorySnapshotLinux::MergeWithOtherSnapshot(
+    const MemorySnapshot* other) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // All memory snapshots merged together come from the same process snapshot,
+  // and are therefore of this concrete type.
+  const MemorySnapshotLinux* other_as_linux =
+      reinterpret_cast<const MemorySnapshotLinux*>(other);
+  if (process_reader_ != other_as_linux->process_reader_) {
+    LOG(ERROR) << "different process_reader_ for snapshots";
+    return nullptr;
+  }
+
+  CheckedRange<uint64_t, size_t> merged(0, 0);
+  if (!DetermineMergedRange(this, other, &merged)) {
+    return nullptr;
+  }
+
+  MemorySnapshotLinux* result = new MemorySnapshotLinux();
+  result->Initialize(process_reader_, merged.base(), merged.size());
+  return result;
 }
 
 }  // namespace internal
@@ -0,0 +1,157 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/linux/module_snapshot_linux.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/files/file_path.h"
+
+namespace crashpad {
+namespace internal {
+
+ModuleSnapshotLinux::ModuleSnapshotLinux()
+    : ModuleSnapshot(),
+      name_(),
+      uuid_(),
+      elf_reader_(nullptr),
+      type_(kModuleTypeUnknown),
+      initialized_() {}
+
+ModuleSnapshotLinux::~ModuleSnapshotLinux() {}
+
+bool ModuleSnapshotLinux::Initialize(
+    const ProcessReader::Module& process_reader_module) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  name_ = process_reader_module.name;
+  elf_reader_ = process_reader_module.elf_reader;
+  type_ = process_reader_module.type;
+  if (!elf_reader_) {
+    return false;
+  }
+
+  // The build ID identifies the image to symbol servers in the position that a
+  // Mach-O UUID or PDB GUID would. Build IDs are most often 20-byte SHA-1
+  // digests, so use the first 16 bytes, padded with zeroes if shorter. The
+  // ProcessReader reads the build IDs of every module together.
+  uint8_t uuid_bytes[sizeof(UUID)] = {};
+  const std::string& build_id = process_reader_module.build_id;
+  memcpy(uuid_bytes,
+         build_id.data(),
+         std::min(build_id.size(), sizeof(uuid_bytes)));
+  uuid_.InitializeFromBytes(uuid_bytes);
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+std::string ModuleSnapshotLinux::Name() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return name_;
+}
+
+uint64_t ModuleSnapshotLinux::Address() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return elf_reader_->Address();
+}
+
+uint64_t ModuleSnapshotLinux::Size() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return elf_reader_->Size();
+}
+
+time_t ModuleSnapshotLinux::Timestamp() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return 0;
+}
+
+void ModuleSnapshotLinux::FileVersion(uint16_t* version_0,
+                                      uint16_t* version_1,
+                                      uint16_t* version_2,
+                                      uint16_t* version_3) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  *version_0 = 0;
+  *version_1 = 0;
+  *version_2 = 0;
+  *version_3 = 0;
+}
+
+void ModuleSnapshotLinux::SourceVersion(uint16_t* version_0,
+                                        uint16_t* version_1,
+                                        uint16_t* version_2,
+                                        uint16_t* version_3) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  *version_0 = 0;
+  *version_1 = 0;
+  *version_2 = 0;
+  *version_3 = 0;
+}
+
+ModuleSnapshot::ModuleType ModuleSnapshotLinux::GetModuleType() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return type_;
+}
+
+void ModuleSnapshotLinux::UUIDAndAge(crashpad::UUID* uuid,
+                                     uint32_t* age) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  *uuid = uuid_;
+  *age = 0;
+}
+
+std::string ModuleSnapshotLinux::DebugFileName() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return base::FilePath(Name()).BaseName().value();
+}
+
+std::vector<std::string> ModuleSnapshotLinux::AnnotationsVector() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::vector<std::string>();
+}
+
+std::map<std::string, std::string> ModuleSnapshotLinux::AnnotationsSimpleMap()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::map<std::string, std::string>();
+}
+
+std::vector<AnnotationSnapshot> ModuleSnapshotLinux::AnnotationObjects()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::vector<AnnotationSnapshot>();
+}
+
+std::map<uint64_t, std::vector<AnnotationSnapshot>>
+ModuleSnapshotLinux::ThreadAnnotationObjects() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::map<uint64_t, std::vector<AnnotationSnapshot>>();
+}
+
+std::set<CheckedRange<uint64_t>> ModuleSnapshotLinux::ExtraMemoryRanges()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::set<CheckedRange<uint64_t>>();
+}
+
+std::vector<const UserMinidumpStream*>
+ModuleSnapshotLinux::CustomMinidumpStreams() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::vector<const UserMinidumpStream*>();
+}
+
+}  // namespace internal
+}  // namespace crashpad
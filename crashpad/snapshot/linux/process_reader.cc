@@ -16,7 +16,10 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <linux/auxvec.h>
 #include <sched.h>
+#include <signal.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/resource.h>
@@ -24,16 +27,229 @@
 
 #include <algorithm>
 
+#include "base/files/file_path.h"
 #include "base/logging.h"
+#include "base/memory/ptr_util.h"
 #include "base/strings/string_number_conversions.h"
 #include "build/build_config.h"
+#include "snapshot/cpu_context.h"
+#include "snapshot/linux/debug_rendezvous.h"
+#include "util/file/file_io.h"
+#include "util/linux/auxiliary_vector.h"
 #include "util/linux/proc_stat_reader.h"
 #include "util/posix/scoped_dir.h"
 
+#if defined(ARCH_CPU_X86_FAMILY)
+#include "snapshot/linux/signal_context.h"
+#endif  // ARCH_CPU_X86_FAMILY
+
 namespace crashpad {
 
 namespace {
 
+// The number of pages of target memory kept by the ProcessMemoryCache that
+// backs MemoryRange().
+constexpr size_t kMemoryCachePageCount = 64;
+
+// When the stack capture window is limited, the number of frame records
+// followed past it, and the number of bytes below each frame record captured
+// with it.
+constexpr size_t kMaxStackFrames = 256;
+constexpr LinuxVMSize kFrameLocalsSize = 512;
+
+// When the stack is unwound, the number of bytes above the outermost frame
+// captured with it, which holds the start of its caller’s frame.
+constexpr LinuxVMSize kUnwoundStackMargin = 512;
+
+// Sets |registers| from a thread’s context, along with the DWARF register
+// number of the stack pointer and the address of the instruction that the
+// thread is executing. Returns false if unwinding isn’t supported for the
+// thread’s architecture.
+bool InitializeUnwindRegisters(const ThreadInfo& thread_info,
+                               bool is_64_bit,
+                               ProcessReader::UnwindRegisters* registers,
+                               uint32_t* stack_pointer_register,
+                               LinuxVMAddress* pc) {
+  registers->clear();
+#if defined(ARCH_CPU_X86_FAMILY)
+  if (is_64_bit) {
+    const ThreadContext::t64_t& context = thread_info.thread_context.t64;
+    const uint64_t values[] = {context.rax,
+                               context.rdx,
+                               context.rcx,
+                               context.rbx,
+                               context.rsi,
+                               context.rdi,
+                               context.rbp,
+                               context.rsp,
+                               context.r8,
+                               context.r9,
+                               context.r10,
+                               context.r11,
+                               context.r12,
+                               context.r13,
+                               context.r14,
+                               context.r15};
+    for (size_t index = 0; index < arraysize(values); ++index) {
+      (*registers)[index] = values[index];
+    }
+    *stack_pointer_register = 7;
+    *pc = context.rip;
+  } else {
+    const ThreadContext::t32_t& context = thread_info.thread_context.t32;
+    const uint32_t values[] = {context.eax,
+                               context.ecx,
+                               context.edx,
+                               context.ebx,
+                               context.esp,
+                               context.ebp,
+                               context.esi,
+                               context.edi};
+    for (size_t index = 0; index < arraysize(values); ++index) {
+      (*registers)[index] = values[index];
+    }
+    *stack_pointer_register = 4;
+    *pc = context.eip;
+  }
+  return true;
+#elif defined(ARCH_CPU_ARM_FAMILY)
+  // 32-bit ARM code describes its frames in .ARM.exidx rather than .eh_frame.
+  if (!is_64_bit) {
+    return false;
+  }
+  const ThreadContext::t64_t& context = thread_info.thread_context.t64;
+  for (size_t index = 0; index < arraysize(context.regs); ++index) {
+    (*registers)[index] = context.regs[index];
+  }
+  (*registers)[31] = context.sp;
+  *stack_pointer_register = 31;
+  *pc = context.pc;
+  return true;
+#else
+#error Port.
+#endif
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+// Sets |thread_info| from a ForkedThreadContext’s ucontext_t, which, like the
+// one given to a signal handler, has its floating-point state at fpptr.
+template <typename Traits>
+bool ReadForkedThreadInfo(ProcessMemory* memory,
+                          const ForkedThreadContext& forked_context,
+                          ThreadInfo* thread_info);
+
+template <>
+bool ReadForkedThreadInfo<internal::ContextTraits32>(
+    ProcessMemory* memory,
+    const ForkedThreadContext& forked_context,
+    ThreadInfo* thread_info) {
+  using internal::ContextTraits32;
+  internal::MContext<ContextTraits32> mcontext;
+  if (!memory->Read(
+          forked_context.context_address +
+              offsetof(internal::UContext<ContextTraits32>, mcontext),
+          sizeof(mcontext),
+          &mcontext)) {
+    return false;
+  }
+
+  const internal::SignalThreadContext32& gprs = mcontext.gprs;
+  ThreadContext::t32_t& context = thread_info->thread_context.t32;
+  context.ebx = gprs.ebx;
+  context.ecx = gprs.ecx;
+  context.edx = gprs.edx;
+  context.esi = gprs.esi;
+  context.edi = gprs.edi;
+  context.ebp = gprs.ebp;
+  context.eax = gprs.eax;
+  context.xds = gprs.xds;
+  context.xes = gprs.xes;
+  context.xfs = gprs.xfs;
+  context.xgs = gprs.xgs;
+  context.orig_eax = -1;
+  context.eip = gprs.eip;
+  context.xcs = gprs.xcs;
+  context.eflags = gprs.eflags;
+  context.esp = gprs.esp;
+  context.xss = gprs.xss;
+
+  // Only the fxsave format is captured by ptrace. Without it, which is only
+  // the case for processors that predate SSE, the floating-point state is left
+  // empty.
+  internal::SignalFloatContext32 float_context;
+  if (mcontext.fpptr &&
+      memory->Read(mcontext.fpptr, sizeof(float_context), &float_context) &&
+      float_context.magic == X86_FXSR_MAGIC) {
+    static_assert(sizeof(thread_info->float_context.f32.fxsave) ==
+                      sizeof(CPUContextX86::Fxsave),
+                  "fxsave size mismatch");
+    memory->Read(mcontext.fpptr + offsetof(internal::SignalFloatContext32,
+                                           fxsave),
+                 sizeof(thread_info->float_context.f32.fxsave),
+                 &thread_info->float_context.f32.fxsave);
+  }
+
+  thread_info->thread_specific_data_address =
+      forked_context.thread_specific_data_address;
+  return true;
+}
+
+template <>
+bool ReadForkedThreadInfo<internal::ContextTraits64>(
+    ProcessMemory* memory,
+    const ForkedThreadContext& forked_context,
+    ThreadInfo* thread_info) {
+  using internal::ContextTraits64;
+  internal::MContext<ContextTraits64> mcontext;
+  if (!memory->Read(
+          forked_context.context_address +
+              offsetof(internal::UContext<ContextTraits64>, mcontext),
+          sizeof(mcontext),
+          &mcontext)) {
+    return false;
+  }
+
+  const internal::SignalThreadContext64& gprs = mcontext.gprs;
+  ThreadContext::t64_t& context = thread_info->thread_context.t64;
+  context.r15 = gprs.r15;
+  context.r14 = gprs.r14;
+  context.r13 = gprs.r13;
+  context.r12 = gprs.r12;
+  context.rbp = gprs.rbp;
+  context.rbx = gprs.rbx;
+  context.r11 = gprs.r11;
+  context.r10 = gprs.r10;
+  context.r9 = gprs.r9;
+  context.r8 = gprs.r8;
+  context.rax = gprs.rax;
+  context.rcx = gprs.rcx;
+  context.rdx = gprs.rdx;
+  context.rsi = gprs.rsi;
+  context.rdi = gprs.rdi;
+  context.orig_rax = -1;
+  context.rip = gprs.rip;
+  context.cs = gprs.cs;
+  context.eflags = gprs.eflags;
+  context.rsp = gprs.rsp;
+  context.fs_base = forked_context.thread_specific_data_address;
+  context.fs = gprs.fs;
+  context.gs = gprs.gs;
+
+  static_assert(sizeof(thread_info->float_context.f64.fxsave) ==
+                    sizeof(internal::SignalFloatContext64),
+                "fxsave size mismatch");
+  if (mcontext.fpptr) {
+    memory->Read(mcontext.fpptr,
+                 sizeof(thread_info->float_context.f64.fxsave),
+                 &thread_info->float_context.f64.fxsave);
+  }
+
+  thread_info->thread_specific_data_address =
+      forked_context.thread_specific_data_address;
+  return true;
+}
+#endif  // ARCH_CPU_X86_FAMILY
+
 bool ShouldMergeStackMappings(const MemoryMap::Mapping& stack_mapping,
                               const MemoryMap::Mapping& adj_mapping) {
   DCHECK(stack_mapping.readable);
@@ -45,8 +261,11 @@ bool ShouldMergeStackMappings(const MemoryMap::Mapping& stack_mapping,
 
 ProcessReader::Thread::Thread()
     : thread_info(),
+      name(),
       stack_region_address(0),
       stack_region_size(0),
+      stack_frame_regions(),
+      unwound_frame_count(0),
       tid(-1),
       static_priority(-1),
       nice_value(-1) {}
@@ -54,10 +273,11 @@ ProcessReader::Thread::Thread()
 ProcessReader::Thread::~Thread() {}
 
 bool ProcessReader::Thread::InitializePtrace(PtraceConnection* connection) {
-  if (!connection->GetThreadInfo(tid, &thread_info)) {
-    return false;
-  }
+  return connection->GetThreadInfo(tid, &thread_info) &&
+         InitializeScheduling();
+}
 
+bool ProcessReader::Thread::InitializeScheduling() {
   // TODO(jperaza): Starting with Linux 3.14, scheduling policy, static
   // priority, and nice value can be collected all in one call with
   // sched_getattr().
@@ -86,6 +306,23 @@ bool ProcessReader::Thread::InitializePtrace(PtraceConnection* connection) {
   return true;
 }
 
+void ProcessReader::Thread::InitializeName(ProcessReader* reader) {
+  // A thread’s comm is at most 15 bytes, and is followed by a newline.
+  char path[64];
+  snprintf(path,
+           arraysize(path),
+           "/proc/%d/task/%d/comm",
+           reader->ProcessID(),
+           tid);
+  if (!LoggingReadEntireFile(base::FilePath(path), &name)) {
+    name.clear();
+    return;
+  }
+  if (!name.empty() && name.back() == '\n') {
+    name.pop_back();
+  }
+}
+
 void ProcessReader::Thread::InitializeStack(ProcessReader* reader) {
   LinuxVMAddress stack_pointer;
 #if defined(ARCH_CPU_X86_FAMILY)
@@ -164,16 +401,178 @@ void ProcessReader::Thread::InitializeStack(ProcessReader* reader) {
     stack_region_size =
         thread_info.thread_specific_data_address - stack_region_address;
   }
+
+  // The region may begin at the base of a mapping, far below the stack
+  // pointer. Pages there that the thread never touched hold only zeroes, so
+  // start the region at the first touched page instead. Below the stack
+  // pointer, only pages up to the one holding it need to be examined.
+  const LinuxVMAddress region_end = stack_region_address + stack_region_size;
+  LinuxVMAddress search_end = region_end;
+  if (stack_pointer > stack_region_address && stack_pointer < region_end) {
+    const LinuxVMSize page_size = getpagesize();
+    search_end = stack_pointer - stack_pointer % page_size;
+  }
+  LinuxVMAddress first_touched;
+  if (search_end > stack_region_address &&
+      reader->page_map_.FirstTouchedPage(
+          stack_region_address, search_end, &first_touched) &&
+      first_touched > stack_region_address &&
+      (first_touched < region_end || search_end < region_end)) {
+    stack_region_address = first_touched;
+    stack_region_size = region_end - stack_region_address;
+  }
+
+  if (reader->stack_frame_limit_ > 0) {
+    UnwindStack(reader, stack_region_address + stack_region_size);
+  }
+
+  const LinuxVMSize window_size = reader->stack_capture_window_;
+  if (window_size > 0 && stack_region_size > window_size) {
+    const LinuxVMAddress stack_region_end =
+        stack_region_address + stack_region_size;
+    stack_region_size = window_size;
+    InitializeStackFrames(reader, stack_region_end);
+  }
+}
+
+void ProcessReader::Thread::InitializeStackFrames(ProcessReader* reader,
+                                                  LinuxVMAddress stack_end) {
+  // Each frame record holds the caller’s frame pointer followed by the return
+  // address. ARM is assumed to use the AAPCS frame record layout, with the
+  // frame pointer in r11.
+  LinuxVMAddress frame_pointer;
+#if defined(ARCH_CPU_X86_FAMILY)
+  frame_pointer = reader->Is64Bit() ? thread_info.thread_context.t64.rbp
+                                    : thread_info.thread_context.t32.ebp;
+#elif defined(ARCH_CPU_ARM_FAMILY)
+  frame_pointer = reader->Is64Bit() ? thread_info.thread_context.t64.regs[29]
+                                    : thread_info.thread_context.t32.fp;
+#else
+#error Port.
+#endif
+
+  const LinuxVMSize pointer_size = reader->Is64Bit() ? 8 : 4;
+  const LinuxVMSize record_size = pointer_size * 2;
+  LinuxVMAddress captured_end = stack_region_address + stack_region_size;
+
+  for (size_t frame = 0; frame < kMaxStackFrames; ++frame) {
+    // A frame record must lie entirely within the stack. Anything else means
+    // the chain has ended, or that the code doesn’t maintain frame pointers.
+    if (frame_pointer % pointer_size != 0 ||
+        frame_pointer < stack_region_address || frame_pointer >= stack_end ||
+        stack_end - frame_pointer < record_size) {
+      break;
+    }
+
+    const LinuxVMAddress record_end = frame_pointer + record_size;
+    if (record_end > captured_end) {
+      const LinuxVMAddress region_start = std::max(
+          captured_end,
+          frame_pointer - std::min(frame_pointer, kFrameLocalsSize));
+      if (region_start == stack_region_address + stack_region_size) {
+        stack_region_size = record_end - stack_region_address;
+      } else if (!stack_frame_regions.empty() &&
+                 stack_frame_regions.back().end() == region_start) {
+        CheckedRange<LinuxVMAddress, LinuxVMSize>& last =
+            stack_frame_regions.back();
+        last.SetRange(last.base(), record_end - last.base());
+      } else {
+        stack_frame_regions.push_back(CheckedRange<LinuxVMAddress, LinuxVMSize>(
+            region_start, record_end - region_start));
+      }
+      captured_end = record_end;
+    }
+
+    LinuxVMAddress next_frame_pointer;
+    if (reader->Is64Bit()) {
+      uint64_t value;
+      if (!reader->MemoryRange()->Read(frame_pointer, sizeof(value), &value)) {
+        break;
+      }
+      next_frame_pointer = value;
+    } else {
+      uint32_t value;
+      if (!reader->MemoryRange()->Read(frame_pointer, sizeof(value), &value)) {
+        break;
+      }
+      next_frame_pointer = value;
+    }
+
+    // Callers’ frames are at higher addresses. Stopping otherwise also
+    // guarantees that a corrupt chain can’t loop.
+    if (next_frame_pointer <= frame_pointer) {
+      break;
+    }
+    frame_pointer = next_frame_pointer;
+  }
 }
 
+void ProcessReader::Thread::UnwindStack(ProcessReader* reader,
+                                        LinuxVMAddress stack_end) {
+  UnwindRegisters registers;
+  uint32_t stack_pointer_register;
+  LinuxVMAddress pc;
+  if (!InitializeUnwindRegisters(thread_info,
+                                 reader->Is64Bit(),
+                                 &registers,
+                                 &stack_pointer_register,
+                                 &pc)) {
+    return;
+  }
+
+  std::vector<LinuxVMAddress> frames;
+  LinuxVMAddress frames_end;
+  if (!reader->UnwindStack(registers,
+                           stack_pointer_register,
+                           pc,
+                           stack_end,
+                           reader->stack_frame_limit_,
+                           &frames,
+                           &frames_end)) {
+    return;
+  }
+
+  unwound_frame_count = frames.size();
+  const LinuxVMAddress capture_end =
+      stack_end - frames_end > kUnwoundStackMargin
+          ? frames_end + kUnwoundStackMargin
+          : stack_end;
+  stack_region_size = capture_end - stack_region_address;
+}
+
+ProcessReader::Module::Module()
+    : name(),
+      elf_reader(nullptr),
+      type(ModuleSnapshot::kModuleTypeUnknown),
+      build_id() {}
+
+ProcessReader::Module::~Module() {}
+
 ProcessReader::ProcessReader()
     : connection_(),
       process_info_(),
+      proc_dir_(),
       memory_map_(),
+      page_map_(),
       threads_(),
+      modules_(),
+      module_readers_(),
+      module_files_(),
       process_memory_(),
+      memory_cache_(),
+      memory_range_(),
+      stack_capture_window_(0),
+      stack_frame_limit_(0),
+      float_context_thread_ids_(),
+      limit_float_context_threads_(false),
+      build_id_cache_(nullptr),
+      recording_(nullptr),
+      thread_contexts_address_(0),
+      thread_context_count_(0),
+      forked_process_id_(0),
       is_64_bit_(false),
       initialized_threads_(false),
+      initialized_modules_(false),
       initialized_() {}
 
 ProcessReader::~ProcessReader() {}
@@ -183,26 +582,81 @@ bool ProcessReader::Initialize(PtraceConnection* connection) {
   DCHECK(connection);
   connection_ = connection;
 
-  if (!process_info_.InitializeWithPtrace(connection_)) {
+  if (forked_process_id_ ? !process_info_.InitializeWithPtraceToFork(
+                               connection_, forked_process_id_)
+                         : !process_info_.InitializeWithPtrace(connection_)) {
+    return false;
+  }
+
+  if (!proc_dir_.Initialize(ProcessID())) {
     return false;
   }
 
+  // When reading a fork, its memory stands in for the target’s.
   pid_t pid = connection->GetProcessID();
+
   if (!memory_map_.Initialize(pid)) {
     return false;
   }
 
+  // Without the page map, stacks are captured without trimming untouched
+  // pages.
+  page_map_.Initialize(pid);
+
   process_memory_.reset(new ProcessMemory());
   if (!process_memory_->Initialize(pid)) {
     return false;
   }
+  process_memory_->SetRecording(recording_);
 
   is_64_bit_ = process_info_.Is64Bit();
 
+  if (!memory_cache_.Initialize(
+          process_memory_.get(), getpagesize(), kMemoryCachePageCount) ||
+      !memory_range_.Initialize(process_memory_.get(), is_64_bit_)) {
+    return false;
+  }
+  memory_range_.SetCache(&memory_cache_);
+
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
 
+void ProcessReader::SetForkedProcess(pid_t process_id,
+                                     LinuxVMAddress thread_contexts_address,
+                                     uint32_t thread_context_count) {
+  DCHECK(!connection_);
+  forked_process_id_ = process_id;
+  thread_contexts_address_ = thread_contexts_address;
+  thread_context_count_ = thread_context_count;
+}
+
+void ProcessReader::SetStackCaptureWindow(LinuxVMSize window_size) {
+  DCHECK(!initialized_threads_);
+  stack_capture_window_ = window_size;
+}
+
+void ProcessReader::SetStackFrameLimit(size_t frame_limit) {
+  DCHECK(!initialized_threads_);
+  stack_frame_limit_ = frame_limit;
+}
+
+void ProcessReader::SetFloatContextThreads(const std::set<pid_t>& thread_ids) {
+  DCHECK(!initialized_threads_);
+  float_context_thread_ids_ = thread_ids;
+  limit_float_context_threads_ = true;
+}
+
+void ProcessReader::SetBuildIDCache(BuildIDCache* cache) {
+  DCHECK(!initialized_modules_);
+  build_id_cache_ = cache;
+}
+
+void ProcessReader::SetRecording(ProcessRecording* recording) {
+  DCHECK(!connection_);
+  recording_ = recording;
+}
+
 bool ProcessReader::StartTime(timeval* start_time) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   return process_info_.StartTime(start_time);
@@ -220,7 +674,7 @@ bool ProcessReader::CPUTimes(timeval* user_time, timeval* system_time) const {
 
   for (const Thread& thread : threads_) {
     ProcStatReader stat;
-    if (!stat.Initialize(thread.tid)) {
+    if (!stat.Initialize(proc_dir_, thread.tid)) {
       return false;
     }
 
@@ -251,8 +705,22 @@ const std::vector<ProcessReader::Thread>& ProcessReader::Threads() {
   return threads_;
 }
 
+const std::vector<ProcessReader::Module>& ProcessReader::Modules() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  if (!initialized_modules_) {
+    InitializeModules();
+  }
+  return modules_;
+}
+
 void ProcessReader::InitializeThreads() {
   DCHECK(threads_.empty());
+  initialized_threads_ = true;
+
+  if (forked_process_id_) {
+    InitializeForkedThreads();
+    return;
+  }
 
   pid_t pid = ProcessID();
   if (pid == getpid()) {
@@ -276,12 +744,12 @@ void ProcessReader::InitializeThreads() {
   Thread main_thread;
   main_thread.tid = pid;
   if (main_thread.InitializePtrace(connection_)) {
-    main_thread.InitializeStack(this);
-    threads_.push_back(main_thread);
+    AddThread(&main_thread);
   } else {
     LOG(WARNING) << "Couldn't initialize main thread.";
   }
 
+  std::vector<PtraceConnection::ThreadRequest> requests;
   bool main_thread_found = false;
   dirent* dir_entry;
   while ((dir_entry = readdir(scoped_dir.get()))) {
@@ -301,14 +769,422 @@ void ProcessReader::InitializeThreads() {
       continue;
     }
 
+    PtraceConnection::ThreadRequest request;
+    request.tid = tid;
+    request.float_context =
+        !limit_float_context_threads_ ||
+        float_context_thread_ids_.find(tid) != float_context_thread_ids_.end();
+    request.success = false;
+    requests.push_back(request);
+  }
+  DCHECK(main_thread_found);
+
+  // Attaching and reading registers dominates the cost of capturing each
+  // thread, so let the connection do it for all threads at once.
+  connection_->AttachAndGetThreadInfo(&requests);
+
+  for (const PtraceConnection::ThreadRequest& request : requests) {
+    if (!request.success) {
+      continue;
+    }
+
     Thread thread;
-    thread.tid = tid;
-    if (connection_->Attach(tid) && thread.InitializePtrace(connection_)) {
-      thread.InitializeStack(this);
-      threads_.push_back(thread);
+    thread.tid = request.tid;
+    thread.thread_info = request.info;
+    if (thread.InitializeScheduling()) {
+      AddThread(&thread);
+    }
+  }
+}
+
+void ProcessReader::InitializeForkedThreads() {
+#if defined(ARCH_CPU_X86_FAMILY)
+  std::vector<ForkedThreadContext> forked_contexts(thread_context_count_);
+  if (!forked_contexts.empty() &&
+      !process_memory_->Read(
+          thread_contexts_address_,
+          forked_contexts.size() * sizeof(forked_contexts[0]),
+          forked_contexts.data())) {
+    LOG(ERROR) << "Couldn't read thread contexts";
+    return;
+  }
+
+  // The main thread is placed first, as it is when threads are attached to.
+  const pid_t pid = ProcessID();
+  std::stable_partition(forked_contexts.begin(),
+                        forked_contexts.end(),
+                        [pid](const ForkedThreadContext& forked_context) {
+                          return forked_context.thread_id == pid;
+                        });
+
+  for (const ForkedThreadContext& forked_context : forked_contexts) {
+    if (!forked_context.valid) {
+      LOG(WARNING) << "thread " << forked_context.thread_id
+                   << " context not recorded";
+      continue;
+    }
+
+    Thread thread;
+    thread.tid = forked_context.thread_id;
+    if (!(is_64_bit_ ? ReadForkedThreadInfo<internal::ContextTraits64>(
+                           process_memory_.get(),
+                           forked_context,
+                           &thread.thread_info)
+                     : ReadForkedThreadInfo<internal::ContextTraits32>(
+                           process_memory_.get(),
+                           forked_context,
+                           &thread.thread_info))) {
+      continue;
+    }
+
+    // The thread may have exited since the fork, but its registers and stack
+    // were recorded, and are still reported without its scheduling
+    // information.
+    thread.InitializeScheduling();
+    AddThread(&thread);
+  }
+#else
+  LOG(ERROR) << "forked processes not supported";
+#endif  // ARCH_CPU_X86_FAMILY
+}
+
+void ProcessReader::AddThread(Thread* thread) {
+  thread->InitializeStack(this);
+  thread->InitializeName(this);
+  threads_.push_back(*thread);
+}
+
+void ProcessReader::InitializeModules() {
+  DCHECK(modules_.empty());
+  initialized_modules_ = true;
+
+  pid_t pid = ProcessID();
+
+  AuxiliaryVector aux;
+  if (!aux.Initialize(pid, is_64_bit_)) {
+    return;
+  }
+
+  LinuxVMAddress phdrs;
+  if (!aux.GetValue(AT_PHDR, &phdrs)) {
+    LOG(ERROR) << "AT_PHDR not found";
+    return;
+  }
+
+  const MemoryMap::Mapping* phdr_mapping = memory_map_.FindMapping(phdrs);
+  const MemoryMap::Mapping* exe_mapping =
+      phdr_mapping ? memory_map_.FindFileMmapStart(*phdr_mapping) : nullptr;
+  if (!exe_mapping) {
+    LOG(ERROR) << "no executable mapping";
+    return;
+  }
+
+  ProcessMemoryRange exe_range;
+  auto exe_reader = base::WrapUnique(new ElfImageReader());
+  if (!InitializeModuleMemoryRange(*exe_mapping, &exe_range) ||
+      !exe_reader->Initialize(exe_range, exe_mapping->range.Base())) {
+    return;
+  }
+
+  Module executable;
+  executable.name = exe_mapping->name.as_string();
+  executable.elf_reader = exe_reader.get();
+  executable.type = ModuleSnapshot::kModuleTypeExecutable;
+  module_readers_.push_back(exe_reader.release());
+  modules_.push_back(executable);
+
+  std::vector<const MemoryMap::Mapping*> module_mappings(1, exe_mapping);
+
+  // A statically-linked executable has no dynamic array, and so no link map.
+  LinuxVMAddress debug_address;
+  DebugRendezvous debug;
+  if (!executable.elf_reader->GetDebugAddress(&debug_address) ||
+      !debug.Initialize(memory_range_, debug_address)) {
+    InitializeBuildIDs(module_mappings);
+    return;
+  }
+
+  LinuxVMAddress loader_base = 0;
+  aux.GetValue(AT_BASE, &loader_base);
+
+  for (const DebugRendezvous::LinkEntry& entry : debug.Modules()) {
+    // Some dynamic linkers don’t record their own dynamic array, and without
+    // it there’s no way to find the module’s image.
+    if (!entry.dynamic_array) {
+      continue;
+    }
+
+    const MemoryMap::Mapping* dynamic_mapping =
+        memory_map_.FindMapping(entry.dynamic_array);
+    const MemoryMap::Mapping* module_mapping =
+        dynamic_mapping ? memory_map_.FindFileMmapStart(*dynamic_mapping)
+                        : nullptr;
+    if (!module_mapping) {
+      LOG(WARNING) << "no mapping for module " << entry.name;
+      continue;
+    }
+
+    ProcessMemoryRange module_range;
+    auto reader = base::WrapUnique(new ElfImageReader());
+    if (!InitializeModuleMemoryRange(*module_mapping, &module_range) ||
+        !reader->Initialize(module_range, module_mapping->range.Base())) {
+      continue;
+    }
+
+    Module module;
+    module.name = entry.name.empty() ? module_mapping->name.as_string()
+                                     : entry.name;
+    module.elf_reader = reader.get();
+    module.type = module_mapping->range.Base() == loader_base
+                      ? ModuleSnapshot::kModuleTypeDynamicLoader
+                      : ModuleSnapshot::kModuleTypeSharedLibrary;
+    module_readers_.push_back(reader.release());
+    modules_.push_back(module);
+    module_mappings.push_back(module_mapping);
+  }
+
+  InitializeBuildIDs(module_mappings);
+}
+
+bool ProcessReader::InitializeModuleMemoryRange(
+    const MemoryMap::Mapping& mapping,
+    ProcessMemoryRange* range) {
+  if (!range->Initialize(memory_range_)) {
+    return false;
+  }
+
+  // The first mapping holds the ELF and program headers, and the reader
+  // extends the window to the rest of the image that it can trust once it has
+  // read them. Mapping the file is cheaper than reading the target, and the
+  // file’s pages are shared with the target and with other dumps through the
+  // page cache. A recording must hold the headers, so they’re read from the
+  // target instead.
+  if (recording_) {
+    return true;
+  }
+  auto file = base::WrapUnique(new ModuleFileMemory());
+  if (file->Initialize(memory_map_, mapping)) {
+    range->SetFileBacking(
+        file.get(), mapping.range.Base(), mapping.range.Size());
+    module_files_.push_back(file.release());
+  }
+  return true;
+}
+
+const ProcessReader::Module* ProcessReader::FindModule(
+    LinuxVMAddress address) {
+  for (const Module& module : Modules()) {
+    const ElfImageReader* image = module.elf_reader;
+    if (address >= image->Address() &&
+        address - image->Address() < image->Size()) {
+      return &module;
+    }
+  }
+  return nullptr;
+}
+
+bool ProcessReader::UnwindStack(const UnwindRegisters& registers,
+                                uint32_t stack_pointer_register,
+                                LinuxVMAddress pc,
+                                LinuxVMAddress stack_end,
+                                size_t frame_limit,
+                                std::vector<LinuxVMAddress>* frames,
+                                LinuxVMAddress* frames_end) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  const LinuxVMSize pointer_size = Is64Bit() ? 8 : 4;
+  const LinuxVMAddress address_mask =
+      Is64Bit() ? ~LinuxVMAddress{0} : 0xffffffff;
+  const auto read_pointer = [this, pointer_size](LinuxVMAddress address,
+                                                 LinuxVMAddress* value) {
+    if (pointer_size == 8) {
+      uint64_t value64;
+      if (!MemoryRange()->Read(address, sizeof(value64), &value64)) {
+        return false;
+      }
+      *value = value64;
+    } else {
+      uint32_t value32;
+      if (!MemoryRange()->Read(address, sizeof(value32), &value32)) {
+        return false;
+      }
+      *value = value32;
+    }
+    return true;
+  };
+
+  const auto initial_stack_pointer = registers.find(stack_pointer_register);
+  if (initial_stack_pointer == registers.end()) {
+    return false;
+  }
+  LinuxVMAddress stack_pointer = initial_stack_pointer->second;
+  UnwindRegisters frame_registers(registers);
+  frames->clear();
+  *frames_end = stack_pointer;
+  bool pc_is_return_address = false;
+  while (frames->size() < frame_limit) {
+    frames->push_back(pc);
+    const Module* module = FindModule(pc);
+    if (!module) {
+      return false;
+    }
+
+    // A return address may be just past the end of the calling function, so
+    // the call instruction before it is looked up instead.
+    ElfEhFrameReader::Row row;
+    if (!module->elf_reader->GetCallFrameRow(
+            pc_is_return_address ? pc - 1 : pc, &row)) {
+      return false;
+    }
+
+    const auto cfa_register = frame_registers.find(row.cfa_register);
+    if (cfa_register == frame_registers.end()) {
+      return false;
+    }
+    const LinuxVMAddress cfa =
+        (cfa_register->second + row.cfa_offset) & address_mask;
+    if (cfa < stack_pointer || cfa > stack_end) {
+      return false;
+    }
+
+    UnwindRegisters caller_registers(frame_registers);
+    for (const auto& rule : row.registers) {
+      LinuxVMAddress value;
+      switch (rule.second.type) {
+        case ElfEhFrameReader::RegisterRule::kSameValue:
+          continue;
+        case ElfEhFrameReader::RegisterRule::kOffset:
+          if (read_pointer((cfa + rule.second.offset) & address_mask,
+                           &value)) {
+            caller_registers[rule.first] = value;
+            continue;
+          }
+          break;
+        case ElfEhFrameReader::RegisterRule::kValueOffset:
+          caller_registers[rule.first] =
+              (cfa + rule.second.offset) & address_mask;
+          continue;
+        case ElfEhFrameReader::RegisterRule::kRegister: {
+          const auto it = frame_registers.find(rule.second.reg);
+          if (it != frame_registers.end()) {
+            caller_registers[rule.first] = it->second;
+            continue;
+          }
+          break;
+        }
+        case ElfEhFrameReader::RegisterRule::kUndefined:
+        case ElfEhFrameReader::RegisterRule::kExpression:
+          break;
+      }
+      caller_registers.erase(rule.first);
+    }
+    caller_registers[stack_pointer_register] = cfa;
+
+    *frames_end = cfa;
+
+    // The outermost frame’s return address is undefined or zero.
+    const auto return_address =
+        caller_registers.find(row.return_address_register);
+    if (return_address == caller_registers.end() ||
+        return_address->second == 0) {
+      return true;
+    }
+
+    pc = return_address->second;
+#if defined(ARCH_CPU_ARM64)
+    // Strip the pointer authentication code, assuming the default 48-bit
+    // virtual addresses.
+    if (row.return_address_signed) {
+      pc &= (LinuxVMAddress{1} << 48) - 1;
+    }
+#endif  // ARCH_CPU_ARM64
+
+    // A signal frame’s caller was interrupted rather than making a call, so
+    // its pc is exact.
+    pc_is_return_address = !row.signal_frame;
+    frame_registers.swap(caller_registers);
+    stack_pointer = cfa;
+  }
+
+  return true;
+}
+
+void ProcessReader::InitializeBuildIDs(
+    const std::vector<const MemoryMap::Mapping*>& mappings) {
+  DCHECK_EQ(mappings.size(), modules_.size());
+
+  // Modules that weren’t found in the cache, and the range of note segments
+  // each one contributes to the batch.
+  struct PendingModule {
+    size_t module_index;
+    size_t first_note;
+    size_t note_count;
+    BuildIDCache::Key key;
+    bool has_key;
+  };
+  std::vector<PendingModule> pending_modules;
+  std::vector<ElfImageReader::NoteSegment> note_segments;
+
+  for (size_t index = 0; index < modules_.size(); ++index) {
+    Module& module = modules_[index];
+    const MemoryMap::Mapping* mapping = mappings[index];
+
+    PendingModule pending;
+    pending.module_index = index;
+    pending.has_key = build_id_cache_ &&
+                      BuildIDCache::GetKey(mapping->name.as_string(),
+                                           mapping->device,
+                                           mapping->inode,
+                                           &pending.key);
+    if (pending.has_key &&
+        build_id_cache_->Lookup(pending.key, &module.build_id)) {
+      continue;
+    }
+
+    std::vector<ElfImageReader::NoteSegment> module_note_segments;
+    module.elf_reader->GetNoteSegments(&module_note_segments);
+    pending.first_note = note_segments.size();
+    pending.note_count = module_note_segments.size();
+    note_segments.insert(note_segments.end(),
+                         module_note_segments.begin(),
+                         module_note_segments.end());
+    pending_modules.push_back(pending);
+  }
+
+  std::vector<std::string> notes(note_segments.size());
+  std::vector<ProcessMemory::ReadRequest> requests(note_segments.size());
+  for (size_t index = 0; index < note_segments.size(); ++index) {
+    notes[index].resize(note_segments[index].size);
+    requests[index].address = note_segments[index].address;
+    requests[index].size = note_segments[index].size;
+    requests[index].buffer = &notes[index][0];
+  }
+
+  // If any segment can’t be read, the batch fails as a whole, so fall back to
+  // reading each module’s notes on its own.
+  const bool batch_read =
+      requests.empty() || process_memory_->ReadBatch(requests);
+
+  for (const PendingModule& pending : pending_modules) {
+    Module& module = modules_[pending.module_index];
+    if (batch_read) {
+      for (size_t index = pending.first_note;
+           index < pending.first_note + pending.note_count;
+           ++index) {
+        if (ElfImageReader::FindBuildIDInNotes(notes[index],
+                                               note_segments[index].alignment,
+                                               &module.build_id)) {
+          break;
+        }
+      }
+    } else {
+      module.elf_reader->GetBuildID(&module.build_id);
+    }
+
+    if (pending.has_key) {
+      build_id_cache_->Insert(pending.key, module.build_id);
     }
   }
-  DCHECK(main_thread_found);
 }
 
 }  // namespace crashpad
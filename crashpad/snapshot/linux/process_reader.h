@@ -18,17 +18,32 @@
 #include <sys/time.h>
 #include <sys/types.h>
 
+#include <map>
 #include <memory>
+#include <set>
+#include <string>
 #include <vector>
 
 #include "base/macros.h"
+#include "snapshot/elf/elf_image_reader.h"
+#include "snapshot/linux/build_id_cache.h"
+#include "snapshot/module_snapshot.h"
 #include "util/linux/address_types.h"
+#include "util/linux/exception_handler_protocol.h"
 #include "util/linux/memory_map.h"
+#include "util/linux/module_file_memory.h"
+#include "util/linux/page_map.h"
+#include "util/linux/proc_directory.h"
+#include "util/linux/process_recording.h"
 #include "util/linux/ptrace_connection.h"
 #include "util/linux/thread_info.h"
 #include "util/misc/initialization_state_dcheck.h"
+#include "util/numeric/checked_range.h"
 #include "util/posix/process_info.h"
 #include "util/process/process_memory.h"
+#include "util/process/process_memory_cache.h"
+#include "util/process/process_memory_range.h"
+#include "util/stdlib/pointer_container.h"
 
 namespace crashpad {
 
@@ -36,14 +51,33 @@ namespace crashpad {
 //!     ID.
 class ProcessReader {
  public:
+  //! \brief Register values by DWARF register number, for the registers whose
+  //!     values in a frame are known.
+  using UnwindRegisters = std::map<uint32_t, LinuxVMAddress>;
+
   //! \brief Contains information about a thread that belongs to a process.
   struct Thread {
     Thread();
     ~Thread();
 
     ThreadInfo thread_info;
+    std::string name;
     LinuxVMAddress stack_region_address;
     LinuxVMSize stack_region_size;
+
+    //! \brief Regions of the stack above the stack region that hold the frame
+    //!     records of callers, found by walking the frame pointer chain.
+    //!
+    //! This is only populated when SetStackCaptureWindow() has limited the
+    //! stack region.
+    std::vector<CheckedRange<LinuxVMAddress, LinuxVMSize>> stack_frame_regions;
+
+    //! \brief The number of frames found by unwinding the stack with call
+    //!     frame information, or `0` if the stack wasn’t unwound.
+    //!
+    //! This is only populated when SetStackFrameLimit() has set a limit.
+    size_t unwound_frame_count;
+
     pid_t tid;
     int sched_policy;
     int static_priority;
@@ -53,7 +87,34 @@ class ProcessReader {
     friend class ProcessReader;
 
     bool InitializePtrace(PtraceConnection* connection);
+    bool InitializeScheduling();
     void InitializeStack(ProcessReader* reader);
+    void InitializeStackFrames(ProcessReader* reader, LinuxVMAddress stack_end);
+    void UnwindStack(ProcessReader* reader, LinuxVMAddress stack_end);
+    void InitializeName(ProcessReader* reader);
+  };
+
+  //! \brief Contains information about a module loaded into a process.
+  struct Module {
+    Module();
+    ~Module();
+
+    //! \brief The pathname used to load the module from disk.
+    std::string name;
+
+    //! \brief An image reader for the module.
+    //!
+    //! The lifetime of this ElfImageReader is scoped to the lifetime of the
+    //! ProcessReader that created it. Its headers are read once, when the
+    //! module list is built, and are shared by every consumer of the module.
+    ElfImageReader* elf_reader;
+
+    //! \brief The module’s type.
+    ModuleSnapshot::ModuleType type;
+
+    //! \brief The descriptor of the module’s `NT_GNU_BUILD_ID` note, or empty
+    //!     if it has none.
+    std::string build_id;
   };
 
   ProcessReader();
@@ -68,6 +129,103 @@ class ProcessReader {
   //! \return `true` on success. `false` on failure with a message logged.
   bool Initialize(PtraceConnection* connection);
 
+  //! \brief Reads a copy-on-write fork of the target process in place of the
+  //!     process itself.
+  //!
+  //! The fork’s memory is read as the target’s memory, so the snapshot is
+  //! consistent while the target continues to run. Information that a fork
+  //! doesn’t inherit, such as the process ID, start time, and thread names, is
+  //! read from the target. Because a fork has only one thread, the target’s
+  //! threads and their registers are read from the ForkedThreadContext structs
+  //! that it recorded before forking, and are not attached to.
+  //!
+  //! Forks of x86 and x86_64 processes are supported.
+  //!
+  //! This method must be called before Initialize(), which must then be given a
+  //! connection to the fork.
+  //!
+  //! \param[in] process_id The process ID of the target, the fork’s parent.
+  //! \param[in] thread_contexts_address The address, in the fork, of an array
+  //!     of ForkedThreadContext structs.
+  //! \param[in] thread_context_count The number of elements in the array at \a
+  //!     thread_contexts_address.
+  void SetForkedProcess(pid_t process_id,
+                        LinuxVMAddress thread_contexts_address,
+                        uint32_t thread_context_count);
+
+  //! \brief Limits the stack captured for each thread.
+  //!
+  //! By default, a thread’s stack region extends from its stack pointer to the
+  //! end of its stack. For deep stacks, most of that is rarely useful. When \a
+  //! window_size is nonzero, the stack region is limited to \a window_size
+  //! bytes from the stack pointer, and the frame pointer chain is walked
+  //! through the rest of the stack to record each caller’s frame record and
+  //! the locals just below it in Thread::stack_frame_regions.
+  //!
+  //! This method must be called before Threads().
+  //!
+  //! \param[in] window_size The maximum size of each thread’s stack region, or
+  //!     `0` to capture stacks in full.
+  void SetStackCaptureWindow(LinuxVMSize window_size);
+
+  //! \brief Limits the stack captured for each thread to the frames found by
+  //!     unwinding it.
+  //!
+  //! When \a frame_limit is nonzero, each thread’s stack is unwound using the
+  //! call frame information in the `.eh_frame` sections of the modules its
+  //! code belongs to, for at most \a frame_limit frames. The stack region is
+  //! then limited to the memory those frames span, along with a margin above
+  //! the outermost one that holds the start of its caller’s frame. If the
+  //! stack can’t be unwound that far, because code without call frame
+  //! information was reached before either the frame limit or the outermost
+  //! frame, the stack region is left as it was.
+  //!
+  //! This is applied before any limit set by SetStackCaptureWindow(). Unwinding
+  //! is supported for x86, x86_64, and ARM64 processes.
+  //!
+  //! This method must be called before Threads().
+  //!
+  //! \param[in] frame_limit The maximum number of frames to capture, or `0` to
+  //!     capture stacks without unwinding them.
+  void SetStackFrameLimit(size_t frame_limit);
+
+  //! \brief Limits the threads whose floating-point context is captured.
+  //!
+  //! Reading a thread’s floating-point and vector registers costs an
+  //! additional `ptrace` request, which adds up in processes with thousands of
+  //! threads. By default, every thread’s floating-point context is captured.
+  //! Once this is called, only the threads named in \a thread_ids, and the
+  //! main thread, have theirs captured, and the others’
+  //! ThreadInfo::float_context is left zeroed. This applies only to threads
+  //! read through the connection. The extent to which it saves time depends
+  //! on the connection’s PtraceConnection::AttachAndGetThreadInfo().
+  //!
+  //! This method must be called before Threads().
+  //!
+  //! \param[in] thread_ids The thread IDs of the threads whose floating-point
+  //!     context is to be captured.
+  void SetFloatContextThreads(const std::set<pid_t>& thread_ids);
+
+  //! \brief Sets a cache to consult for, and record, module build IDs.
+  //!
+  //! This method must be called before Modules().
+  //!
+  //! \param[in] cache The cache, which may be shared by many ProcessReader
+  //!     objects and must outlive this one. Weak.
+  void SetBuildIDCache(BuildIDCache* cache);
+
+  //! \brief Records the target’s memory as it is read.
+  //!
+  //! Module headers are then read from the target rather than from the
+  //! modules’ files, so that the recording holds all memory read.
+  //!
+  //! This method must be called before Initialize(). See
+  //! ProcessMemory::SetRecording().
+  //!
+  //! \param[in] recording The recording to add memory to, which must outlive
+  //!     this object. Weak.
+  void SetRecording(ProcessRecording* recording);
+
   //! \brief Return `true` if the target task is a 64-bit process.
   bool Is64Bit() const { return is_64_bit_; }
 
@@ -80,6 +238,12 @@ class ProcessReader {
   //! \brief Return a memory reader for the target process.
   ProcessMemory* Memory() { return process_memory_.get(); }
 
+  //! \brief Return a memory range covering the target process’ address space.
+  //!
+  //! The range reads through Memory() and a page cache shared with every ELF
+  //! image reader created for Modules().
+  const ProcessMemoryRange* MemoryRange() const { return &memory_range_; }
+
   //! \brief Return a memory map of the target process.
   MemoryMap* GetMemoryMap() { return &memory_map_; }
 
@@ -105,18 +269,91 @@ class ProcessReader {
   //! \brief Return a vector of threads that are in the task process. If the
   //!     main thread is able to be identified and traced, it will be placed at
   //!     index `0`.
+  //!
+  //! The threads other than the main thread are attached and read with
+  //! PtraceConnection::AttachAndGetThreadInfo(), so with a connection such as
+  //! ThreadedPtraceConnection they are captured concurrently.
   const std::vector<Thread>& Threads();
 
+  //! \return The modules loaded in the process. The first element (at index
+  //!     `0`) corresponds to the main executable. The remaining modules are
+  //!     listed in the order the dynamic linker’s link map reports them.
+  const std::vector<Module>& Modules();
+
+  //! \brief Returns the module whose image contains \a address, or `nullptr`
+  //!     if there is none.
+  const Module* FindModule(LinuxVMAddress address);
+
+  //! \brief Unwinds a stack using the call frame information in the `.eh_frame`
+  //!     sections of the modules its code belongs to.
+  //!
+  //! Unwinding is supported for x86, x86_64, and ARM64 processes.
+  //!
+  //! \param[in] registers The register values of the innermost frame.
+  //! \param[in] stack_pointer_register The DWARF register number of the stack
+  //!     pointer.
+  //! \param[in] pc The address of the instruction the innermost frame is
+  //!     executing.
+  //! \param[in] stack_end The end of the stack. No frame’s canonical frame
+  //!     address may be beyond it.
+  //! \param[in] frame_limit The maximum number of frames to unwind.
+  //! \param[out] frames The pc of each frame reached, innermost first. Every
+  //!     frame but the innermost is identified by its return address.
+  //! \param[out] frames_end The canonical frame address of the last frame
+  //!     unwound, the end of the stack memory that the unwound frames span.
+  //! \return `true` if \a frame_limit frames or the outermost frame were
+  //!     unwound. `false` if code without usable call frame information was
+  //!     reached first, in which case \a frames holds the frames reached before
+  //!     and including that code.
+  bool UnwindStack(const UnwindRegisters& registers,
+                   uint32_t stack_pointer_register,
+                   LinuxVMAddress pc,
+                   LinuxVMAddress stack_end,
+                   size_t frame_limit,
+                   std::vector<LinuxVMAddress>* frames,
+                   LinuxVMAddress* frames_end);
+
  private:
   void InitializeThreads();
+  void InitializeForkedThreads();
+  void AddThread(Thread* thread);
+  void InitializeModules();
+
+  // Initializes |range| to read the module whose first mapping is |mapping|.
+  // The module’s headers are read from its file on disk if it can be found.
+  bool InitializeModuleMemoryRange(const MemoryMap::Mapping& mapping,
+                                   ProcessMemoryRange* range);
+
+  // Sets the build_id of each module in modules_, whose mappings are the
+  // parallel |mappings|. The note segments of every module not found in
+  // build_id_cache_ are read with a single ProcessMemory::ReadBatch().
+  void InitializeBuildIDs(
+      const std::vector<const MemoryMap::Mapping*>& mappings);
 
   PtraceConnection* connection_;  // weak
   ProcessInfo process_info_;
+  ProcDirectory proc_dir_;
   class MemoryMap memory_map_;
+  PageMap page_map_;
   std::vector<Thread> threads_;
+  std::vector<Module> modules_;
+  PointerVector<ElfImageReader> module_readers_;
+  PointerVector<ModuleFileMemory> module_files_;
   std::unique_ptr<ProcessMemory> process_memory_;
+  ProcessMemoryCache memory_cache_;
+  ProcessMemoryRange memory_range_;
+  LinuxVMSize stack_capture_window_;
+  size_t stack_frame_limit_;
+  std::set<pid_t> float_context_thread_ids_;
+  bool limit_float_context_threads_;
+  BuildIDCache* build_id_cache_;  // weak
+  ProcessRecording* recording_;  // weak
+  LinuxVMAddress thread_contexts_address_;
+  uint32_t thread_context_count_;
+  pid_t forked_process_id_;
   bool is_64_bit_;
   bool initialized_threads_;
+  bool initialized_modules_;
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(ProcessReader);
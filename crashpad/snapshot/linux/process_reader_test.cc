@@ -15,18 +15,24 @@
 #include "snapshot/linux/process_reader.h"
 
 #include <errno.h>
+#include <link.h>
 #include <pthread.h>
 #include <sched.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <sys/resource.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 
 #include <map>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/format_macros.h"
+#include "base/logging.h"
 #include "base/memory/free_deleter.h"
 #include "base/strings/stringprintf.h"
 #include "build/build_config.h"
@@ -35,7 +41,9 @@
 #include "test/linux/fake_ptrace_connection.h"
 #include "test/multiprocess.h"
 #include "util/file/file_io.h"
+#include "util/linux/copy_on_write_fork.h"
 #include "util/linux/direct_ptrace_connection.h"
+#include "util/linux/threaded_ptrace_connection.h"
 #include "util/misc/from_pointer_cast.h"
 #include "util/stdlib/pointer_container.h"
 #include "util/synchronization/semaphore.h"
@@ -294,10 +302,34 @@ void ExpectThreads(const ThreadMap& thread_map,
   }
 }
 
+// Sets |expectation| for the calling thread, whose stack includes
+// |stack_address|.
+void GetCurrentThreadExpectation(
+    LinuxVMAddress stack_address,
+    TestThreadPool::ThreadExpectation* expectation) {
+  expectation->tls = GetTLS();
+  expectation->stack_address = stack_address;
+
+  int res = sched_getscheduler(0);
+  ASSERT_GE(res, 0) << ErrnoMessage("sched_getscheduler");
+  expectation->sched_policy = res;
+
+  sched_param param;
+  ASSERT_EQ(sched_getparam(0, &param), 0) << ErrnoMessage("sched_getparam");
+  expectation->static_priority = param.sched_priority;
+
+  errno = 0;
+  res = getpriority(PRIO_PROCESS, 0);
+  ASSERT_FALSE(res == -1 && errno) << ErrnoMessage("getpriority");
+  expectation->nice_value = res;
+}
+
 class ChildThreadTest : public Multiprocess {
  public:
-  ChildThreadTest(size_t stack_size = 0)
-      : Multiprocess(), stack_size_(stack_size) {}
+  // If |worker_count| is nonzero, the child is read through a
+  // ThreadedPtraceConnection with that many workers.
+  ChildThreadTest(size_t stack_size = 0, size_t worker_count = 0)
+      : Multiprocess(), stack_size_(stack_size), worker_count_(worker_count) {}
   ~ChildThreadTest() {}
 
  private:
@@ -314,11 +346,20 @@ class ChildThreadTest : public Multiprocess {
       thread_map[tid] = expectation;
     }
 
-    DirectPtraceConnection connection;
-    ASSERT_TRUE(connection.Initialize(ChildPID()));
+    std::unique_ptr<PtraceConnection> connection;
+    if (worker_count_) {
+      ThreadedPtraceConnection* threaded_connection =
+          new ThreadedPtraceConnection();
+      connection.reset(threaded_connection);
+      ASSERT_TRUE(threaded_connection->Initialize(ChildPID(), worker_count_));
+    } else {
+      DirectPtraceConnection* direct_connection = new DirectPtraceConnection();
+      connection.reset(direct_connection);
+      ASSERT_TRUE(direct_connection->Initialize(ChildPID()));
+    }
 
     ProcessReader process_reader;
-    ASSERT_TRUE(process_reader.Initialize(&connection));
+    ASSERT_TRUE(process_reader.Initialize(connection.get()));
     const std::vector<ProcessReader::Thread>& threads =
         process_reader.Threads();
     ExpectThreads(thread_map, threads, ChildPID());
@@ -329,21 +370,8 @@ class ChildThreadTest : public Multiprocess {
     thread_pool.StartThreads(kThreadCount, stack_size_);
 
     TestThreadPool::ThreadExpectation expectation;
-    expectation.tls = GetTLS();
-    expectation.stack_address = reinterpret_cast<LinuxVMAddress>(&thread_pool);
-
-    int res = sched_getscheduler(0);
-    ASSERT_GE(res, 0) << ErrnoMessage("sched_getscheduler");
-    expectation.sched_policy = res;
-
-    sched_param param;
-    ASSERT_EQ(sched_getparam(0, &param), 0) << ErrnoMessage("sched_getparam");
-    expectation.static_priority = param.sched_priority;
-
-    errno = 0;
-    res = getpriority(PRIO_PROCESS, 0);
-    ASSERT_FALSE(res == -1 && errno) << ErrnoMessage("getpriority");
-    expectation.nice_value = res;
+    ASSERT_NO_FATAL_FAILURE(GetCurrentThreadExpectation(
+        reinterpret_cast<LinuxVMAddress>(&thread_pool), &expectation));
 
     pid_t tid = gettid();
 
@@ -361,6 +389,7 @@ class ChildThreadTest : public Multiprocess {
 
   static constexpr size_t kThreadCount = 3;
   const size_t stack_size_;
+  const size_t worker_count_;
 
   DISALLOW_COPY_AND_ASSIGN(ChildThreadTest);
 };
@@ -375,6 +404,49 @@ TEST(ProcessReader, ChildThreadsWithSmallUserStacks) {
   test.Run();
 }
 
+TEST(ProcessReader, ChildWithThreadsThreadedConnection) {
+  ChildThreadTest test(0, 2);
+  test.Run();
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+TEST(ProcessReader, SelfForkedWithThreads) {
+  constexpr size_t kThreadCount = 3;
+  TestThreadPool thread_pool;
+  ASSERT_NO_FATAL_FAILURE(thread_pool.StartThreads(kThreadCount));
+
+  ThreadMap thread_map;
+  ASSERT_NO_FATAL_FAILURE(GetCurrentThreadExpectation(
+      reinterpret_cast<LinuxVMAddress>(&thread_pool), &thread_map[gettid()]));
+  for (size_t thread_index = 0; thread_index < kThreadCount; ++thread_index) {
+    TestThreadPool::ThreadExpectation expectation;
+    pid_t tid = thread_pool.GetThreadExpectation(thread_index, &expectation);
+    thread_map[tid] = expectation;
+  }
+
+  // Threads in the same thread group can’t be traced, but a fork of this
+  // process can be.
+  CopyOnWriteFork fork;
+  ASSERT_EQ(fork.Fork(SIGUSR2, 0), 0);
+
+  DirectPtraceConnection connection;
+  ASSERT_TRUE(connection.Initialize(fork.ChildProcessID()));
+
+  ProcessReader process_reader;
+  process_reader.SetForkedProcess(
+      getpid(), fork.ThreadContextsAddress(), fork.ThreadContextCount());
+  ASSERT_TRUE(process_reader.Initialize(&connection));
+
+  EXPECT_EQ(process_reader.ProcessID(), getpid());
+  EXPECT_EQ(process_reader.ParentProcessID(), getppid());
+
+  const std::vector<ProcessReader::Thread>& threads = process_reader.Threads();
+  ASSERT_FALSE(threads.empty());
+  EXPECT_EQ(threads[0].tid, getpid());
+  ExpectThreads(thread_map, threads, getpid());
+}
+#endif  // ARCH_CPU_X86_FAMILY
+
 // Tests a thread with a stack that spans multiple mappings.
 class ChildWithSplitStackTest : public Multiprocess {
  public:
@@ -460,6 +532,237 @@ TEST(ProcessReader, ChildWithSplitStack) {
   test.Run();
 }
 
+// Tests that a stack capture window limits a deep stack, and that any frame
+// regions found beyond it lie within the rest of the stack.
+constexpr LinuxVMSize kWindowSize = 4096;
+constexpr LinuxVMSize kStackSize = kWindowSize * 16;
+
+class ChildWithStackCaptureWindowTest : public Multiprocess {
+ public:
+  ChildWithStackCaptureWindowTest() : Multiprocess() {}
+  ~ChildWithStackCaptureWindowTest() {}
+
+ private:
+  void MultiprocessParent() override {
+    LinuxVMAddress bottom_of_stack;
+    CheckedReadFileExactly(
+        ReadPipeHandle(), &bottom_of_stack, sizeof(bottom_of_stack));
+
+    DirectPtraceConnection connection;
+    ASSERT_TRUE(connection.Initialize(ChildPID()));
+
+    ProcessReader process_reader;
+    ASSERT_TRUE(process_reader.Initialize(&connection));
+    process_reader.SetStackCaptureWindow(kWindowSize);
+
+    const std::vector<ProcessReader::Thread>& threads =
+        process_reader.Threads();
+    ASSERT_EQ(threads.size(), 1u);
+    const ProcessReader::Thread& thread = threads[0];
+
+    // Frame records directly above the window may extend it slightly.
+    LinuxVMAddress stack_region_end =
+        thread.stack_region_address + thread.stack_region_size;
+    EXPECT_LT(thread.stack_region_size, kStackSize);
+    EXPECT_LT(stack_region_end, bottom_of_stack);
+
+    LinuxVMAddress previous_end = stack_region_end;
+    for (const auto& region : thread.stack_frame_regions) {
+      EXPECT_GT(region.base(), previous_end);
+      EXPECT_GT(region.size(), 0u);
+      EXPECT_LE(region.size(), 1024u);
+      previous_end = region.end();
+    }
+
+    const MemoryMap::Mapping* mapping =
+        process_reader.GetMemoryMap()->FindMapping(previous_end - 1);
+    ASSERT_TRUE(mapping);
+    EXPECT_TRUE(mapping->readable);
+  }
+
+  void MultiprocessChild() override {
+    LinuxVMSize stack_size = kStackSize;
+    GrowStack(reinterpret_cast<LinuxVMAddress>(&stack_size));
+  }
+
+  void GrowStack(LinuxVMAddress bottom_of_stack) {
+    char stack_contents[1024];
+    memset(stack_contents, 0, sizeof(stack_contents));
+    auto stack_address = reinterpret_cast<LinuxVMAddress>(&stack_contents);
+
+    if (bottom_of_stack - stack_address < kStackSize) {
+      GrowStack(bottom_of_stack);
+    } else {
+      CheckedWriteFile(
+          WritePipeHandle(), &bottom_of_stack, sizeof(bottom_of_stack));
+
+      // Wait for parent to read us
+      CheckedReadFileAtEOF(ReadPipeHandle());
+    }
+
+    // Keep the frame from being optimized away.
+    CHECK_EQ(stack_contents[0], 0);
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(ChildWithStackCaptureWindowTest);
+};
+
+TEST(ProcessReader, ChildWithStackCaptureWindow) {
+  ChildWithStackCaptureWindowTest test;
+  test.Run();
+}
+
+// Tests that unwinding a deep stack limits it to the frames unwound.
+constexpr size_t kFrameLimit = 8;
+
+class ChildWithStackFrameLimitTest : public Multiprocess {
+ public:
+  ChildWithStackFrameLimitTest() : Multiprocess() {}
+  ~ChildWithStackFrameLimitTest() {}
+
+ private:
+  void MultiprocessParent() override {
+    LinuxVMAddress bottom_of_stack;
+    CheckedReadFileExactly(
+        ReadPipeHandle(), &bottom_of_stack, sizeof(bottom_of_stack));
+
+    DirectPtraceConnection connection;
+    ASSERT_TRUE(connection.Initialize(ChildPID()));
+
+    ProcessReader process_reader;
+    ASSERT_TRUE(process_reader.Initialize(&connection));
+    process_reader.SetStackFrameLimit(kFrameLimit);
+
+    const std::vector<ProcessReader::Thread>& threads =
+        process_reader.Threads();
+    ASSERT_EQ(threads.size(), 1u);
+    const ProcessReader::Thread& thread = threads[0];
+
+#if defined(ARCH_CPU_ARMEL)
+    // 32-bit ARM stacks aren’t unwound.
+    EXPECT_EQ(thread.unwound_frame_count, 0u);
+#else
+    // Each of the child’s frames holds 1024 bytes of locals, so the frames
+    // unwound span well under half of its stack.
+    EXPECT_EQ(thread.unwound_frame_count, kFrameLimit);
+    EXPECT_LT(thread.stack_region_size, kStackSize / 2);
+    EXPECT_LT(thread.stack_region_address + thread.stack_region_size,
+              bottom_of_stack);
+    EXPECT_TRUE(thread.stack_frame_regions.empty());
+#endif  // ARCH_CPU_ARMEL
+  }
+
+  void MultiprocessChild() override {
+    LinuxVMSize stack_size = kStackSize;
+    GrowStack(reinterpret_cast<LinuxVMAddress>(&stack_size));
+  }
+
+  void GrowStack(LinuxVMAddress bottom_of_stack) {
+    char stack_contents[1024];
+    memset(stack_contents, 0, sizeof(stack_contents));
+    auto stack_address = reinterpret_cast<LinuxVMAddress>(&stack_contents);
+
+    if (bottom_of_stack - stack_address < kStackSize) {
+      GrowStack(bottom_of_stack);
+    } else {
+      CheckedWriteFile(
+          WritePipeHandle(), &bottom_of_stack, sizeof(bottom_of_stack));
+
+      // Wait for parent to read us
+      CheckedReadFileAtEOF(ReadPipeHandle());
+    }
+
+    // Keep the frame from being optimized away.
+    CHECK_EQ(stack_contents[0], 0);
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(ChildWithStackFrameLimitTest);
+};
+
+TEST(ProcessReader, ChildWithStackFrameLimit) {
+  ChildWithStackFrameLimitTest test;
+  test.Run();
+}
+
+// Collects the name and load bias of each module reported by
+// dl_iterate_phdr().
+int CollectModule(dl_phdr_info* info, size_t size, void* data) {
+  auto modules =
+      reinterpret_cast<std::vector<std::pair<std::string, LinuxVMAddress>>*>(
+          data);
+  modules->push_back(std::make_pair(info->dlpi_name ? info->dlpi_name : "",
+                                    info->dlpi_addr));
+  return 0;
+}
+
+TEST(ProcessReader, SelfModules) {
+  FakePtraceConnection connection;
+  connection.Initialize(getpid());
+
+  ProcessReader process_reader;
+  ASSERT_TRUE(process_reader.Initialize(&connection));
+
+  std::vector<std::pair<std::string, LinuxVMAddress>> expected_modules;
+  dl_iterate_phdr(CollectModule, &expected_modules);
+  ASSERT_FALSE(expected_modules.empty());
+
+  const std::vector<ProcessReader::Module>& modules = process_reader.Modules();
+  ASSERT_FALSE(modules.empty());
+
+  // The executable is always first.
+  EXPECT_EQ(modules[0].type, ModuleSnapshot::kModuleTypeExecutable);
+  EXPECT_EQ(modules[0].elf_reader->GetLoadBias(),
+            static_cast<VMOffset>(expected_modules[0].second));
+
+  for (size_t index = 1; index < expected_modules.size(); ++index) {
+    const std::string& name = expected_modules[index].first;
+    if (name.empty()) {
+      continue;
+    }
+    SCOPED_TRACE(name);
+
+    const ProcessReader::Module* found_module = nullptr;
+    for (const ProcessReader::Module& module : modules) {
+      if (module.name == name) {
+        found_module = &module;
+        break;
+      }
+    }
+    ASSERT_TRUE(found_module);
+    EXPECT_NE(found_module->type, ModuleSnapshot::kModuleTypeExecutable);
+    EXPECT_EQ(found_module->elf_reader->GetLoadBias(),
+              static_cast<VMOffset>(expected_modules[index].second));
+  }
+}
+
+TEST(ProcessReader, SelfModuleBuildIDs) {
+  FakePtraceConnection connection;
+  connection.Initialize(getpid());
+
+  BuildIDCache cache(64);
+
+  // The first reader fills the cache, and the second is served from it. Both
+  // must agree with reading each module’s notes on its own.
+  for (int pass = 0; pass < 2; ++pass) {
+    SCOPED_TRACE(base::StringPrintf("pass %d", pass));
+
+    ProcessReader process_reader;
+    ASSERT_TRUE(process_reader.Initialize(&connection));
+    process_reader.SetBuildIDCache(&cache);
+
+    const std::vector<ProcessReader::Module>& modules =
+        process_reader.Modules();
+    ASSERT_FALSE(modules.empty());
+
+    for (const ProcessReader::Module& module : modules) {
+      SCOPED_TRACE(module.name);
+      std::string build_id;
+      module.elf_reader->GetBuildID(&build_id);
+      EXPECT_EQ(module.build_id, build_id);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
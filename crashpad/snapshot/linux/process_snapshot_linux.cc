@@ -0,0 +1,355 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/linux/process_snapshot_linux.h"
+
+#include <set>
+#include <string>
+
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "build/build_config.h"
+#include "snapshot/cpu_context.h"
+#include "util/misc/memory_read_trace.h"
+
+namespace crashpad {
+
+namespace {
+
+// Sets |registers| from |context| for ProcessReader::UnwindStack(), along with
+// the DWARF register number of the stack pointer. Returns false if unwinding
+// isn’t supported for the context’s architecture.
+bool UnwindRegistersFromContext(const CPUContext& context,
+                                ProcessReader::UnwindRegisters* registers,
+                                uint32_t* stack_pointer_register) {
+  registers->clear();
+  switch (context.architecture) {
+#if defined(ARCH_CPU_X86_FAMILY)
+    case kCPUArchitectureX86_64: {
+      const CPUContextX86_64& x86_64 = *context.x86_64;
+      const uint64_t values[] = {x86_64.rax,
+                                 x86_64.rdx,
+                                 x86_64.rcx,
+                                 x86_64.rbx,
+                                 x86_64.rsi,
+                                 x86_64.rdi,
+                                 x86_64.rbp,
+                                 x86_64.rsp,
+                                 x86_64.r8,
+                                 x86_64.r9,
+                                 x86_64.r10,
+                                 x86_64.r11,
+                                 x86_64.r12,
+                                 x86_64.r13,
+                                 x86_64.r14,
+                                 x86_64.r15};
+      for (size_t index = 0; index < arraysize(values); ++index) {
+        (*registers)[index] = values[index];
+      }
+      *stack_pointer_register = 7;
+      return true;
+    }
+
+    case kCPUArchitectureX86: {
+      const CPUContextX86& x86 = *context.x86;
+      const uint32_t values[] = {x86.eax,
+                                 x86.ecx,
+                                 x86.edx,
+                                 x86.ebx,
+                                 x86.esp,
+                                 x86.ebp,
+                                 x86.esi,
+                                 x86.edi};
+      for (size_t index = 0; index < arraysize(values); ++index) {
+        (*registers)[index] = values[index];
+      }
+      *stack_pointer_register = 4;
+      return true;
+    }
+#endif  // ARCH_CPU_X86_FAMILY
+
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+ProcessSnapshotLinux::ProcessSnapshotLinux()
+    : ProcessSnapshot(),
+      system_(),
+      threads_(),
+      modules_(),
+      memory_map_(),
+      exception_(),
+      process_reader_(),
+      report_id_(),
+      client_id_(),
+      annotations_simple_map_(),
+      snapshot_time_(),
+      initialized_() {}
+
+ProcessSnapshotLinux::~ProcessSnapshotLinux() {}
+
+bool ProcessSnapshotLinux::Initialize(PtraceConnection* connection) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  if (gettimeofday(&snapshot_time_, nullptr) != 0) {
+    PLOG(ERROR) << "gettimeofday";
+    return false;
+  }
+
+  if (!process_reader_.Initialize(connection)) {
+    return false;
+  }
+
+  system_.Initialize(&process_reader_, &snapshot_time_);
+
+  InitializeThreads();
+  InitializeModules();
+  InitializeMemoryMap();
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+bool ProcessSnapshotLinux::InitializeException(LinuxVMAddress siginfo_address,
+                                               LinuxVMAddress context_address,
+                                               pid_t thread_id) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(!exception_);
+
+  exception_.reset(new internal::ExceptionSnapshotLinux());
+  if (!exception_->Initialize(
+          &process_reader_, siginfo_address, context_address, thread_id)) {
+    exception_.reset();
+    return false;
+  }
+
+  return true;
+}
+
+bool ProcessSnapshotLinux::ComputeTopFrames(size_t frame_limit,
+                                            std::vector<TopFrame>* frames) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(exception_);
+
+  frames->clear();
+
+  const CPUContext* context = exception_->Context();
+  ProcessReader::UnwindRegisters registers;
+  uint32_t stack_pointer_register;
+  if (!UnwindRegistersFromContext(
+          *context, &registers, &stack_pointer_register)) {
+    return false;
+  }
+
+  const crashpad::MemoryMap::Mapping* stack_mapping =
+      process_reader_.GetMemoryMap()->FindMapping(context->StackPointer());
+  if (!stack_mapping) {
+    return false;
+  }
+
+  // Whether unwinding completed doesn’t matter, as the frames reached before
+  // it stopped are still useful.
+  std::vector<LinuxVMAddress> addresses;
+  LinuxVMAddress frames_end;
+  process_reader_.UnwindStack(registers,
+                              stack_pointer_register,
+                              context->InstructionPointer(),
+                              stack_mapping->range.End(),
+                              frame_limit,
+                              &addresses,
+                              &frames_end);
+
+  const std::vector<const ModuleSnapshot*> modules = Modules();
+  for (size_t index = 0; index < addresses.size(); ++index) {
+    TopFrame frame;
+    frame.address = addresses[index];
+
+    for (size_t module_index = 0; module_index < modules.size();
+         ++module_index) {
+      const ModuleSnapshot* module = modules[module_index];
+      if (frame.address >= module->Address() &&
+          frame.address - module->Address() < module->Size()) {
+        frame.module_index = module_index;
+        frame.module_offset = frame.address - module->Address();
+        break;
+      }
+    }
+
+    // A return address may be just past the end of the calling function, so
+    // the call instruction before it is looked up instead.
+    const ProcessReader::Module* module =
+        process_reader_.FindModule(frame.address);
+    VMAddress symbol_address;
+    if (module &&
+        module->elf_reader->GetNearestDynamicFunctionSymbol(
+            index == 0 ? frame.address : frame.address - 1,
+            &frame.symbol,
+            &symbol_address)) {
+      frame.symbol_offset = frame.address - symbol_address;
+    }
+
+    frames->push_back(frame);
+  }
+
+  return !frames->empty();
+}
+
+pid_t ProcessSnapshotLinux::ProcessID() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return process_reader_.ProcessID();
+}
+
+pid_t ProcessSnapshotLinux::ParentProcessID() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return process_reader_.ParentProcessID();
+}
+
+void ProcessSnapshotLinux::SnapshotTime(timeval* snapshot_time) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  *snapshot_time = snapshot_time_;
+}
+
+void ProcessSnapshotLinux::ProcessStartTime(timeval* start_time) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  process_reader_.StartTime(start_time);
+}
+
+void ProcessSnapshotLinux::ProcessCPUTimes(timeval* user_time,
+                                           timeval* system_time) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  process_reader_.CPUTimes(user_time, system_time);
+}
+
+void ProcessSnapshotLinux::ReportID(UUID* report_id) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  *report_id = report_id_;
+}
+
+void ProcessSnapshotLinux::ClientID(UUID* client_id) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  *client_id = client_id_;
+}
+
+const std::map<std::string, std::string>&
+ProcessSnapshotLinux::AnnotationsSimpleMap() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return annotations_simple_map_;
+}
+
+const SystemSnapshot* ProcessSnapshotLinux::System() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return &system_;
+}
+
+std::vector<const ThreadSnapshot*> ProcessSnapshotLinux::Threads() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return threads_.Kept<const ThreadSnapshot>();
+}
+
+std::vector<const ModuleSnapshot*> ProcessSnapshotLinux::Modules() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  std::vector<const ModuleSnapshot*> modules;
+  for (internal::ModuleSnapshotLinux* module : modules_) {
+    modules.push_back(module);
+  }
+  return modules;
+}
+
+std::vector<UnloadedModuleSnapshot> ProcessSnapshotLinux::UnloadedModules()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::vector<UnloadedModuleSnapshot>();
+}
+
+const ExceptionSnapshot* ProcessSnapshotLinux::Exception() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return exception_.get();
+}
+
+std::vector<const MemoryMapRegionSnapshot*> ProcessSnapshotLinux::MemoryMap()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::vector<const MemoryMapRegionSnapshot*>(memory_map_.begin(),
+                                                     memory_map_.end());
+}
+
+std::vector<HandleSnapshot> ProcessSnapshotLinux::Handles() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::vector<HandleSnapshot>();
+}
+
+std::vector<const MemorySnapshot*> ProcessSnapshotLinux::ExtraMemory() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return std::vector<const MemorySnapshot*>();
+}
+
+void ProcessSnapshotLinux::InitializeThreads() {
+  // Reading the threads unwinds the innermost frames of their stacks.
+  ScopedMemoryReadSite read_site(MemoryReadSite::kStacks);
+  const std::vector<ProcessReader::Thread>& process_reader_threads =
+      process_reader_.Threads();
+  threads_.Reset(process_reader_threads.size());
+  for (size_t index = 0; index < process_reader_threads.size(); ++index) {
+    if (threads_.at(index)->Initialize(&process_reader_,
+                                       process_reader_threads[index])) {
+      threads_.Keep(index);
+    }
+  }
+}
+
+void ProcessSnapshotLinux::InitializeModules() {
+  ScopedMemoryReadSite read_site(MemoryReadSite::kModules);
+  const std::vector<ProcessReader::Module>& process_reader_modules =
+      process_reader_.Modules();
+  for (const ProcessReader::Module& process_reader_module :
+       process_reader_modules) {
+    auto module = base::WrapUnique(new internal::ModuleSnapshotLinux());
+    if (module->Initialize(process_reader_module)) {
+      modules_.push_back(module.release());
+    }
+  }
+}
+
+void ProcessSnapshotLinux::InitializeMemoryMap() {
+  std::set<std::string> module_names;
+  for (const ProcessReader::Module& process_reader_module :
+       process_reader_.Modules()) {
+    module_names.insert(process_reader_module.name);
+  }
+
+  // MemoryMap must be qualified here, where it names the accessor.
+  const crashpad::MemoryMap* memory_map = process_reader_.GetMemoryMap();
+  for (const crashpad::MemoryMap::Mapping& mapping : memory_map->Mappings()) {
+    const bool is_module =
+        mapping.inode != 0 &&
+        module_names.find(mapping.name.as_string()) != module_names.end();
+
+    LinuxVMAddress allocation_base = mapping.range.Base();
+    if (is_module) {
+      const crashpad::MemoryMap::Mapping* start =
+          memory_map->FindFileMmapStart(mapping);
+      if (start) {
+        allocation_base = start->range.Base();
+      }
+    }
+
+    memory_map_.push_back(new internal::MemoryMapRegionSnapshotLinux(
+        mapping, allocation_base, is_module));
+  }
+}
+
+}  // namespace crashpad
@@ -0,0 +1,266 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_LINUX_PROCESS_SNAPSHOT_LINUX_H_
+#define CRASHPAD_SNAPSHOT_LINUX_PROCESS_SNAPSHOT_LINUX_H_
+
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "snapshot/exception_snapshot.h"
+#include "snapshot/linux/exception_snapshot_linux.h"
+#include "snapshot/linux/memory_map_region_snapshot_linux.h"
+#include "snapshot/linux/module_snapshot_linux.h"
+#include "snapshot/linux/process_reader.h"
+#include "snapshot/linux/system_snapshot_linux.h"
+#include "snapshot/linux/thread_snapshot_linux.h"
+#include "snapshot/memory_map_region_snapshot.h"
+#include "snapshot/module_snapshot.h"
+#include "snapshot/process_snapshot.h"
+#include "snapshot/system_snapshot.h"
+#include "snapshot/system_snapshot_cache.h"
+#include "snapshot/thread_snapshot.h"
+#include "snapshot/top_frames.h"
+#include "snapshot/unloaded_module_snapshot.h"
+#include "util/linux/address_types.h"
+#include "util/linux/process_recording.h"
+#include "util/linux/ptrace_connection.h"
+#include "util/misc/initialization_state_dcheck.h"
+#include "util/misc/uuid.h"
+#include "util/stdlib/object_array.h"
+#include "util/stdlib/pointer_container.h"
+
+namespace crashpad {
+
+//! \brief A ProcessSnapshot of a running (or crashed) process running on a
+//!     Linux system.
+class ProcessSnapshotLinux final : public ProcessSnapshot {
+ public:
+  ProcessSnapshotLinux();
+  ~ProcessSnapshotLinux() override;
+
+  //! \brief Initializes the object.
+  //!
+  //! \param[in] connection A connection to the process to snapshot. The
+  //!     connection’s threads remain attached, and the process stopped, for as
+  //!     long as the connection lives, which must be at least as long as this
+  //!     object.
+  //!
+  //! \return `true` if the snapshot could be created, `false` otherwise with
+  //!     an appropriate message logged.
+  bool Initialize(PtraceConnection* connection);
+
+  //! \brief Snapshots a copy-on-write fork of the process in place of the
+  //!     process itself.
+  //!
+  //! This method must be called before Initialize(), which must then be given a
+  //! connection to the fork. See ProcessReader::SetForkedProcess().
+  //!
+  //! \param[in] process_id The process ID of the process, the fork’s parent.
+  //! \param[in] thread_contexts_address The address, in the fork, of the
+  //!     ForkedThreadContext structs recorded by the process before forking.
+  //! \param[in] thread_context_count The number of ForkedThreadContext structs.
+  void SetForkedProcess(pid_t process_id,
+                        LinuxVMAddress thread_contexts_address,
+                        uint32_t thread_context_count) {
+    process_reader_.SetForkedProcess(
+        process_id, thread_contexts_address, thread_context_count);
+  }
+
+  //! \brief Limits the stack captured for each thread.
+  //!
+  //! This method must be called before Initialize(). See
+  //! ProcessReader::SetStackCaptureWindow().
+  //!
+  //! \param[in] window_size The maximum number of bytes to capture from each
+  //!     thread’s stack pointer, or `0` to capture stacks in full. Frame
+  //!     records beyond the window are returned in each thread’s
+  //!     ThreadSnapshot::ExtraMemory().
+  void SetStackCaptureWindow(LinuxVMSize window_size) {
+    process_reader_.SetStackCaptureWindow(window_size);
+  }
+
+  //! \brief Limits the stack captured for each thread to the frames found by
+  //!     unwinding it.
+  //!
+  //! This method must be called before Initialize(). See
+  //! ProcessReader::SetStackFrameLimit().
+  //!
+  //! \param[in] frame_limit The maximum number of frames to capture from each
+  //!     thread’s stack, or `0` to capture stacks without unwinding them.
+  void SetStackFrameLimit(size_t frame_limit) {
+    process_reader_.SetStackFrameLimit(frame_limit);
+  }
+
+  //! \brief Limits the threads whose floating-point context is captured.
+  //!
+  //! This method must be called before Initialize(). See
+  //! ProcessReader::SetFloatContextThreads().
+  //!
+  //! \param[in] thread_ids The thread IDs of the threads whose floating-point
+  //!     context is to be captured, in addition to the main thread.
+  void SetFloatContextThreads(const std::set<pid_t>& thread_ids) {
+    process_reader_.SetFloatContextThreads(thread_ids);
+  }
+
+  //! \brief Sets a cache of module build IDs to use.
+  //!
+  //! This method must be called before Initialize(). See
+  //! ProcessReader::SetBuildIDCache().
+  //!
+  //! \param[in] cache The cache, which must outlive this object. Weak.
+  void SetBuildIDCache(BuildIDCache* cache) {
+    process_reader_.SetBuildIDCache(cache);
+  }
+
+  //! \brief Records the target’s memory as it is read.
+  //!
+  //! This method must be called before Initialize(). See
+  //! ProcessReader::SetRecording().
+  //!
+  //! \param[in] recording The recording to add memory to, which must outlive
+  //!     this object. Weak.
+  void SetRecording(ProcessRecording* recording) {
+    process_reader_.SetRecording(recording);
+  }
+
+  //! \brief Sets a cache of system facts to use.
+  //!
+  //! This method must be called before Initialize(). See
+  //! SystemSnapshotLinux::SetCache().
+  //!
+  //! \param[in] cache The cache, which must outlive this object. Weak.
+  void SetSystemSnapshotCache(SystemSnapshotCache* cache) {
+    system_.SetCache(cache);
+  }
+
+  //! \brief Initializes the object’s exception.
+  //!
+  //! This populates the data to be returned by Exception().
+  //!
+  //! This method must not be called until after a successful call to
+  //! Initialize().
+  //!
+  //! \param[in] siginfo_address The address in the target process’ address
+  //!     space of the siginfo_t passed to the signal handler.
+  //! \param[in] context_address The address in the target process’ address
+  //!     space of the ucontext_t passed to the signal handler.
+  //! \param[in] thread_id The thread ID of the thread that received the signal.
+  //!
+  //! \return `true` if the exception information could be initialized, `false`
+  //!     otherwise with an appropriate message logged. When this method returns
+  //!     `false`, the ProcessSnapshotLinux object’s validity remains unchanged.
+  bool InitializeException(LinuxVMAddress siginfo_address,
+                           LinuxVMAddress context_address,
+                           pid_t thread_id);
+
+  //! \brief Unwinds the stack of the thread that received the signal, and
+  //!     identifies each frame found by its module and nearest dynamic symbol.
+  //!
+  //! The stack is unwound from the context of the signal, not from the thread’s
+  //! current context in its signal handler, using
+  //! ProcessReader::UnwindStack(). Unwinding stops at the first frame in code
+  //! without usable call frame information, which is still included. Only the
+  //! exported and dynamic symbols of modules are used, so no symbol files are
+  //! needed.
+  //!
+  //! This method must not be called until after a successful call to
+  //! InitializeException().
+  //!
+  //! \param[in] frame_limit The maximum number of frames to return.
+  //! \param[out] frames The frames, innermost first. TopFrame::module_index
+  //!     refers to the modules returned by Modules().
+  //!
+  //! \return `true` if any frames were found. `false` if the exception’s CPU
+  //!     architecture isn’t supported or its stack couldn’t be found.
+  bool ComputeTopFrames(size_t frame_limit, std::vector<TopFrame>* frames);
+
+  //! \brief Sets the value to be returned by ReportID().
+  //!
+  //! The crash report ID is under the control of the snapshot producer, which
+  //! may call this method to set the report ID. If this is not done, ReportID()
+  //! will return an identifier consisting entirely of zeroes.
+  void SetReportID(const UUID& report_id) { report_id_ = report_id; }
+
+  //! \brief Sets the value to be returned by ClientID().
+  //!
+  //! The client ID is under the control of the snapshot producer, which may
+  //! call this method to set the client ID. If this is not done, ClientID()
+  //! will return an identifier consisting entirely of zeroes.
+  void SetClientID(const UUID& client_id) { client_id_ = client_id; }
+
+  //! \brief Sets the value to be returned by AnnotationsSimpleMap().
+  //!
+  //! All process annotations are under the control of the snapshot producer,
+  //! which may call this method to establish these annotations. Contrast this
+  //! with module annotations, which are under the control of the process being
+  //! snapshotted.
+  void SetAnnotationsSimpleMap(
+      const std::map<std::string, std::string>& annotations_simple_map) {
+    annotations_simple_map_ = annotations_simple_map;
+  }
+
+  // ProcessSnapshot:
+
+  pid_t ProcessID() const override;
+  pid_t ParentProcessID() const override;
+  void SnapshotTime(timeval* snapshot_time) const override;
+  void ProcessStartTime(timeval* start_time) const override;
+  void ProcessCPUTimes(timeval* user_time, timeval* system_time) const override;
+  void ReportID(UUID* report_id) const override;
+  void ClientID(UUID* client_id) const override;
+  const std::map<std::string, std::string>& AnnotationsSimpleMap()
+      const override;
+  const SystemSnapshot* System() const override;
+  std::vector<const ThreadSnapshot*> Threads() const override;
+  std::vector<const ModuleSnapshot*> Modules() const override;
+  std::vector<UnloadedModuleSnapshot> UnloadedModules() const override;
+  const ExceptionSnapshot* Exception() const override;
+  std::vector<const MemoryMapRegionSnapshot*> MemoryMap() const override;
+  std::vector<HandleSnapshot> Handles() const override;
+  std::vector<const MemorySnapshot*> ExtraMemory() const override;
+
+ private:
+  void InitializeThreads();
+  void InitializeModules();
+  void InitializeMemoryMap();
+
+  internal::SystemSnapshotLinux system_;
+  // A process may have thousands of threads, so their snapshots are allocated
+  // together.
+  ObjectArray<internal::ThreadSnapshotLinux> threads_;
+  PointerVector<internal::ModuleSnapshotLinux> modules_;
+  PointerVector<internal::MemoryMapRegionSnapshotLinux> memory_map_;
+  std::unique_ptr<internal::ExceptionSnapshotLinux> exception_;
+
+  ProcessReader process_reader_;
+  UUID report_id_;
+  UUID client_id_;
+  std::map<std::string, std::string> annotations_simple_map_;
+  timeval snapshot_time_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProcessSnapshotLinux);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_LINUX_PROCESS_SNAPSHOT_LINUX_H_
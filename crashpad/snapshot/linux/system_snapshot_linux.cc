@@ -138,8 +138,10 @@ SystemSnapshotLinux::SystemSnapshotLinux()
       os_version_build_(),
       process_reader_(nullptr),
       snapshot_time_(nullptr),
+      cache_(nullptr),
 #if defined(ARCH_CPU_X86_FAMILY)
-      cpuid_(),
+      own_cpuid_(),
+      cpuid_(nullptr),
 #endif  // ARCH_CPU_X86_FAMILY
       os_version_major_(-1),
       os_version_minor_(-1),
@@ -157,6 +159,44 @@ void SystemSnapshotLinux::Initialize(ProcessReader* process_reader,
   process_reader_ = process_reader;
   snapshot_time_ = snapshot_time;
 
+  SystemSnapshotCache::OSVersion os_version;
+  if (cache_ && cache_->LookupOSVersion(&os_version)) {
+    os_version_full_ = os_version.full;
+    os_version_build_ = os_version.build;
+    os_version_major_ = os_version.major;
+    os_version_minor_ = os_version.minor;
+    os_version_bugfix_ = os_version.bugfix;
+  } else {
+    ReadOSVersion();
+    if (cache_) {
+      os_version.full = os_version_full_;
+      os_version.build = os_version_build_;
+      os_version.major = os_version_major_;
+      os_version.minor = os_version_minor_;
+      os_version.bugfix = os_version_bugfix_;
+      cache_->InsertOSVersion(os_version);
+    }
+  }
+
+#if defined(ARCH_CPU_X86_FAMILY)
+  if (cache_) {
+    cpuid_ = cache_->Cpuid();
+  } else {
+    own_cpuid_.reset(new CpuidReader());
+    cpuid_ = own_cpuid_.get();
+  }
+#endif  // ARCH_CPU_X86_FAMILY
+
+  // The set of CPUs online can change, so it isn’t cached.
+  if (!ReadCPUsOnline(&target_cpu_, &cpu_count_)) {
+    target_cpu_ = 0;
+    cpu_count_ = 0;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+}
+
+void SystemSnapshotLinux::ReadOSVersion() {
 #if defined(OS_ANDROID)
   std::string build_string;
   if (ReadProperty("ro.build.fingerprint", &build_string)) {
@@ -183,13 +223,6 @@ void SystemSnapshotLinux::Initialize(ProcessReader* process_reader,
   os_version_build_ += uts.version;
   os_version_build_.push_back(' ');
   os_version_build_ += uts.machine;
-
-  if (!ReadCPUsOnline(&target_cpu_, &cpu_count_)) {
-    target_cpu_ = 0;
-    cpu_count_ = 0;
-  }
-
-  INITIALIZATION_STATE_SET_VALID(initialized_);
 }
 
 CPUArchitecture SystemSnapshotLinux::GetCPUArchitecture() const {
@@ -205,7 +238,7 @@ CPUArchitecture SystemSnapshotLinux::GetCPUArchitecture() const {
 uint32_t SystemSnapshotLinux::CPURevision() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 #if defined(ARCH_CPU_X86_FAMILY)
-  return cpuid_.Revision();
+  return cpuid_->Revision();
 #else
 #error port to your architecture
 #endif
@@ -219,7 +252,7 @@ uint8_t SystemSnapshotLinux::CPUCount() const {
 std::string SystemSnapshotLinux::CPUVendor() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 #if defined(ARCH_CPU_X86_FAMILY)
-  return cpuid_.Vendor();
+  return cpuid_->Vendor();
 #else
 #error port to your architecture
 #endif
@@ -245,7 +278,7 @@ void SystemSnapshotLinux::CPUFrequency(uint64_t* current_hz,
 uint32_t SystemSnapshotLinux::CPUX86Signature() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 #if defined(ARCH_CPU_X86_FAMILY)
-  return cpuid_.Signature();
+  return cpuid_->Signature();
 #else
   NOTREACHED();
   return 0;
@@ -255,7 +288,7 @@ uint32_t SystemSnapshotLinux::CPUX86Signature() const {
 uint64_t SystemSnapshotLinux::CPUX86Features() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 #if defined(ARCH_CPU_X86_FAMILY)
-  return cpuid_.Features();
+  return cpuid_->Features();
 #else
   NOTREACHED();
   return 0;
@@ -264,13 +297,13 @@ uint64_t SystemSnapshotLinux::CPUX86Features() const {
 
 uint64_t SystemSnapshotLinux::CPUX86ExtendedFeatures() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  return cpuid_.ExtendedFeatures();
+  return cpuid_->ExtendedFeatures();
 }
 
 uint32_t SystemSnapshotLinux::CPUX86Leaf7Features() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 #if defined(ARCH_CPU_X86_FAMILY)
-  return cpuid_.Leaf7Features();
+  return cpuid_->Leaf7Features();
 #else
   NOTREACHED();
   return 0;
@@ -280,7 +313,7 @@ uint32_t SystemSnapshotLinux::CPUX86Leaf7Features() const {
 bool SystemSnapshotLinux::CPUX86SupportsDAZ() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 #if defined(ARCH_CPU_X86_FAMILY)
-  return cpuid_.SupportsDAZ();
+  return cpuid_->SupportsDAZ();
 #else
   NOTREACHED();
   return false;
@@ -340,7 +373,7 @@ std::string SystemSnapshotLinux::MachineDescription() const {
 
 bool SystemSnapshotLinux::NXEnabled() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  return cpuid_.NXEnabled();
+  return cpuid_->NXEnabled();
 }
 
 void SystemSnapshotLinux::TimeZone(DaylightSavingTimeStatus* dst_status,
@@ -349,6 +382,15 @@ void SystemSnapshotLinux::TimeZone(DaylightSavingTimeStatus* dst_status,
                                    std::string* standard_name,
                                    std::string* daylight_name) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  if (cache_) {
+    cache_->TimeZone(*snapshot_time_,
+                     dst_status,
+                     standard_offset_seconds,
+                     daylight_offset_seconds,
+                     standard_name,
+                     daylight_name);
+    return;
+  }
   internal::TimeZone(*snapshot_time_,
                      dst_status,
                      standard_offset_seconds,
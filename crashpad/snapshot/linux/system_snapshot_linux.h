@@ -18,12 +18,14 @@
 #include <stdint.h>
 #include <time.h>
 
+#include <memory>
 #include <string>
 
 #include "base/macros.h"
 #include "build/build_config.h"
 #include "snapshot/linux/process_reader.h"
 #include "snapshot/system_snapshot.h"
+#include "snapshot/system_snapshot_cache.h"
 #include "util/misc/initialization_state_dcheck.h"
 
 #if defined(ARCH_CPU_X86_FAMILY)
@@ -59,6 +61,13 @@ class SystemSnapshotLinux final : public SystemSnapshot {
   //!     generated around the daylight saving transition time.
   void Initialize(ProcessReader* process_reader, const timeval* snapshot_time);
 
+  //! \brief Sets a cache of system facts to use, shared with other snapshots.
+  //!
+  //! This method must be called before Initialize().
+  //!
+  //! \param[in] cache The cache, which must outlive this object. Weak.
+  void SetCache(SystemSnapshotCache* cache) { cache_ = cache; }
+
   // SystemSnapshot:
 
   CPUArchitecture GetCPUArchitecture() const override;
@@ -87,14 +96,18 @@ class SystemSnapshotLinux final : public SystemSnapshot {
                 std::string* daylight_name) const override;
 
  private:
+  void ReadOSVersion();
   void ReadKernelVersion(const std::string& version_string);
 
   std::string os_version_full_;
   std::string os_version_build_;
   ProcessReader* process_reader_;  // weak
   const timeval* snapshot_time_;  // weak
+  SystemSnapshotCache* cache_;  // weak
 #if defined(ARCH_CPU_X86_FAMILY)
-  CpuidReader cpuid_;
+  // cpuid_ is owned by cache_ when there is one, and by own_cpuid_ otherwise.
+  std::unique_ptr<CpuidReader> own_cpuid_;
+  const CpuidReader* cpuid_;
 #endif  // ARCH_CPU_X86_FAMILY
   int os_version_major_;
   int os_version_minor_;
@@ -28,8 +28,10 @@ ThreadSnapshotLinux::ThreadSnapshotLinux()
       context_union_(),
       context_(),
       stack_(),
+      stack_frames_(),
       thread_specific_data_address_(0),
       thread_id_(-1),
+      thread_name_(),
       priority_(-1),
       initialized_() {
 }
@@ -64,10 +66,17 @@ bool ThreadSnapshotLinux::Initialize(
                     thread.stack_region_address,
                     thread.stack_region_size);
 
+  for (const auto& region : thread.stack_frame_regions) {
+    MemorySnapshotLinux* stack_frame = new MemorySnapshotLinux();
+    stack_frames_.push_back(stack_frame);
+    stack_frame->Initialize(process_reader, region.base(), region.size());
+  }
+
   thread_specific_data_address_ =
       thread.thread_info.thread_specific_data_address;
 
   thread_id_ = thread.tid;
+  thread_name_ = thread.name;
 
   // Map Linux scheduling policy, static priority, and nice value into a single
   // int value.
@@ -181,6 +190,11 @@ uint64_t ThreadSnapshotLinux::ThreadID() const {
   return thread_id_;
 }
 
+std::string ThreadSnapshotLinux::ThreadName() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return thread_name_;
+}
+
 int ThreadSnapshotLinux::SuspendCount() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   return 0;
@@ -197,7 +211,12 @@ uint64_t ThreadSnapshotLinux::ThreadSpecificDataAddress() const {
 }
 
 std::vector<const MemorySnapshot*> ThreadSnapshotLinux::ExtraMemory() const {
-  return std::vector<const MemorySnapshot*>();
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Frames beyond a limited stack capture window are captured separately from
+  // the stack itself.
+  return std::vector<const MemorySnapshot*>(stack_frames_.begin(),
+                                            stack_frames_.end());
 }
 
 }  // namespace internal
@@ -17,6 +17,9 @@
 
 #include <stdint.h>
 
+#include <string>
+#include <vector>
+
 #include "base/macros.h"
 #include "build/build_config.h"
 #include "snapshot/cpu_context.h"
@@ -25,6 +28,7 @@
 #include "snapshot/memory_snapshot.h"
 #include "snapshot/thread_snapshot.h"
 #include "util/misc/initialization_state_dcheck.h"
+#include "util/stdlib/pointer_container.h"
 
 namespace crashpad {
 namespace internal {
@@ -52,6 +56,7 @@ class ThreadSnapshotLinux final : public ThreadSnapshot {
   const CPUContext* Context() const override;
   const MemorySnapshot* Stack() const override;
   uint64_t ThreadID() const override;
+  std::string ThreadName() const override;
   int SuspendCount() const override;
   int Priority() const override;
   uint64_t ThreadSpecificDataAddress() const override;
@@ -68,8 +73,10 @@ class ThreadSnapshotLinux final : public ThreadSnapshot {
 #endif  // ARCH_CPU_X86_FAMILY
   CPUContext context_;
   MemorySnapshotLinux stack_;
+  PointerVector<MemorySnapshotLinux> stack_frames_;
   LinuxVMAddress thread_specific_data_address_;
   pid_t thread_id_;
+  std::string thread_name_;
   int priority_;
   InitializationStateDcheck initialized_;
 
@@ -21,6 +21,7 @@
 #include <utility>
 
 #include "base/logging.h"
+#include "client/annotation.h"
 #include "client/crashpad_info.h"
 #include "client/simple_string_dictionary.h"
 #include "snapshot/mac/mach_o_image_reader.h"
@@ -57,12 +58,30 @@ std::map<std::string, std::string> MachOImageAnnotationsReader::SimpleMap()
   return simple_map_annotations;
 }
 
+std::vector<AnnotationSnapshot> MachOImageAnnotationsReader::AnnotationsList()
+    const {
+  std::vector<AnnotationSnapshot> annotations;
+
+  ReadCrashpadAnnotationsList(&annotations);
+
+  return annotations;
+}
+
+std::map<uint64_t, std::vector<AnnotationSnapshot>>
+MachOImageAnnotationsReader::ThreadAnnotationsList() const {
+  std::map<uint64_t, std::vector<AnnotationSnapshot>> thread_annotations;
+
+  ReadCrashpadThreadAnnotations(&thread_annotations);
+
+  return thread_annotations;
+}
+
 void MachOImageAnnotationsReader::ReadCrashReporterClientAnnotations(
     std::vector<std::string>* vector_annotations) const {
   mach_vm_address_t crash_info_address;
   const process_types::section* crash_info_section =
       image_reader_->GetSectionByName(
-          SEG_DATA, "__crash_info", &crash_info_address);
+          MachOName(SEG_DATA), MachOName("__crash_info"), &crash_info_address);
   if (!crash_info_section) {
     return;
   }
@@ -173,4 +192,107 @@ void MachOImageAnnotationsReader::ReadCrashpadSimpleAnnotations(
   }
 }
 
+void MachOImageAnnotationsReader::ReadCrashpadAnnotationsList(
+    std::vector<AnnotationSnapshot>* annotations) const {
+  process_types::CrashpadInfo crashpad_info;
+  if (!image_reader_->GetCrashpadInfo(&crashpad_info)) {
+    return;
+  }
+
+  if (!crashpad_info.annotations_list) {
+    return;
+  }
+
+  process_types::AnnotationList annotation_list;
+  if (!annotation_list.Read(process_reader_, crashpad_info.annotations_list)) {
+    LOG(WARNING) << "could not read annotations list in " << name_;
+    return;
+  }
+
+  ReadAnnotationsFromHead(annotation_list.head, annotations);
+}
+
+void MachOImageAnnotationsReader::ReadCrashpadThreadAnnotations(
+    std::map<uint64_t, std::vector<AnnotationSnapshot>>* thread_annotations)
+    const {
+  process_types::CrashpadInfo crashpad_info;
+  if (!image_reader_->GetCrashpadInfo(&crashpad_info)) {
+    return;
+  }
+
+  if (!crashpad_info.thread_annotations) {
+    return;
+  }
+
+  process_types::ThreadAnnotationRegistry registry;
+  if (!registry.Read(process_reader_, crashpad_info.thread_annotations)) {
+    LOG(WARNING) << "could not read thread annotations in " << name_;
+    return;
+  }
+
+  // Bound the walk, in case the registry has been corrupted into a cycle.
+  constexpr size_t kMaxSlots = 1024;
+  mach_vm_address_t node = registry.head;
+  for (size_t index = 0; node && index < kMaxSlots; ++index) {
+    process_types::ThreadAnnotationSlot slot;
+    if (!slot.Read(process_reader_, node)) {
+      LOG(WARNING) << "could not read thread annotation slot in " << name_;
+      return;
+    }
+    node = slot.link_node;
+
+    // Unowned slots have been released by the threads that used them.
+    if (slot.thread_id == 0 || !slot.annotations_head) {
+      continue;
+    }
+
+    std::vector<AnnotationSnapshot> annotations;
+    ReadAnnotationsFromHead(slot.annotations_head, &annotations);
+    if (!annotations.empty()) {
+      (*thread_annotations)[slot.thread_id] = std::move(annotations);
+    }
+  }
+}
+
+void MachOImageAnnotationsReader::ReadAnnotationsFromHead(
+    mach_vm_address_t head,
+    std::vector<AnnotationSnapshot>* annotations) const {
+  // Bound the walk, in case the list has been corrupted into a cycle.
+  constexpr size_t kMaxAnnotations = 200;
+  mach_vm_address_t node = head;
+  for (size_t index = 0; node && index < kMaxAnnotations; ++index) {
+    process_types::Annotation annotation;
+    if (!annotation.Read(process_reader_, node)) {
+      LOG(WARNING) << "could not read annotation in " << name_;
+      return;
+    }
+    node = annotation.link_node;
+
+    if (annotation.size == 0) {
+      continue;
+    }
+    if (annotation.size > Annotation::kValueMaxSize) {
+      LOG(WARNING) << "annotation size " << annotation.size << " too large in "
+                   << name_;
+      continue;
+    }
+
+    AnnotationSnapshot snapshot;
+    snapshot.type = annotation.type;
+    if (!process_reader_->Memory()->ReadCStringSizeLimited(
+            annotation.name, Annotation::kNameMaxLength + 1, &snapshot.name)) {
+      continue;
+    }
+
+    snapshot.value.resize(annotation.size);
+    if (!process_reader_->Memory()->Read(
+            annotation.value, snapshot.value.size(), &snapshot.value[0])) {
+      LOG(WARNING) << "could not read annotation value in " << name_;
+      continue;
+    }
+
+    annotations->push_back(std::move(snapshot));
+  }
+}
+
 }  // namespace crashpad
@@ -15,11 +15,15 @@
 #ifndef CRASHPAD_SNAPSHOT_MAC_MACH_O_IMAGE_ANNOTATIONS_READER_H_
 #define CRASHPAD_SNAPSHOT_MAC_MACH_O_IMAGE_ANNOTATIONS_READER_H_
 
+#include <mach/mach.h>
+#include <stdint.h>
+
 #include <map>
 #include <string>
 #include <vector>
 
 #include "base/macros.h"
+#include "snapshot/annotation_snapshot.h"
 #include "snapshot/mac/process_types.h"
 
 namespace crashpad {
@@ -36,6 +40,11 @@ class ProcessReader;
 //!  - CrashpadInfo. This format is used by Crashpad clients. The “simple
 //!    annotations” are recovered from any module with a compatible data
 //!    section, and are included in the annotations returned by SimpleMap().
+//!    Typed annotations in an AnnotationList are recovered from modules whose
+//!    CrashpadInfo is at least version 2, and are returned by
+//!    AnnotationsList(). Per-thread typed annotations in a
+//!    ThreadAnnotationRegistry are recovered from modules whose CrashpadInfo is
+//!    at least version 3, and are returned by ThreadAnnotationsList().
 //!  - `CrashReporterClient.h`’s `crashreporter_annotations_t`. This format is
 //!    used by Apple code. The `message` and `message2` fields can be recovered
 //!    from any module with a compatible data section, and are included in the
@@ -67,6 +76,14 @@ class MachOImageAnnotationsReader {
   //!     pairs, where all keys and values are strings.
   std::map<std::string, std::string> SimpleMap() const;
 
+  //! \brief Returns the module’s typed annotations that are set.
+  std::vector<AnnotationSnapshot> AnnotationsList() const;
+
+  //! \brief Returns the module’s per-thread typed annotations that are set,
+  //!     keyed by thread ID.
+  std::map<uint64_t, std::vector<AnnotationSnapshot>> ThreadAnnotationsList()
+      const;
+
  private:
   // Reades crashreporter_annotations_t::message and
   // crashreporter_annotations_t::message2 on behalf of Vector().
@@ -81,6 +98,22 @@ class MachOImageAnnotationsReader {
   void ReadCrashpadSimpleAnnotations(
       std::map<std::string, std::string>* simple_map_annotations) const;
 
+  // Reads CrashpadInfo::annotations_list_ on behalf of AnnotationsList().
+  void ReadCrashpadAnnotationsList(
+      std::vector<AnnotationSnapshot>* annotations) const;
+
+  // Reads CrashpadInfo::thread_annotations_ on behalf of
+  // ThreadAnnotationsList().
+  void ReadCrashpadThreadAnnotations(
+      std::map<uint64_t, std::vector<AnnotationSnapshot>>* thread_annotations)
+      const;
+
+  // Appends the annotations that are set in the list beginning at the
+  // Annotation at |head| to |annotations|.
+  void ReadAnnotationsFromHead(
+      mach_vm_address_t head,
+      std::vector<AnnotationSnapshot>* annotations) const;
+
   std::string name_;
   ProcessReader* process_reader_;  // weak
   const MachOImageReader* image_reader_;  // weak
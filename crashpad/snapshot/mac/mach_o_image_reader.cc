@@ -53,11 +53,14 @@ MachOImageReader::MachOImageReader()
       symtab_command_(),
       dysymtab_command_(),
       symbol_table_(),
+      looked_up_symbol_(false),
       id_dylib_command_(),
       process_reader_(nullptr),
       file_type_(0),
       initialized_(),
-      symbol_table_initialized_() {
+      symbol_table_initialized_(),
+      crashpad_info_(),
+      crashpad_info_initialized_() {
 }
 
 MachOImageReader::~MachOImageReader() {
@@ -295,7 +298,7 @@ bool MachOImageReader::Initialize(ProcessReader* process_reader,
     }
   }
 
-  if (!segment_map_.count(SEG_TEXT)) {
+  if (!FindSegment(MachOName(SEG_TEXT))) {
     // The __TEXT segment is required. Even a module with no executable code
     // will have a __TEXT segment encompassing the Mach-O header and load
     // commands. Without a __TEXT segment, |size_| will not have been computed.
@@ -316,13 +319,17 @@ const MachOImageSegmentReader* MachOImageReader::GetSegmentByName(
     const std::string& segment_name) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  const auto& iterator = segment_map_.find(segment_name);
-  if (iterator == segment_map_.end()) {
+  if (segment_name.size() > MachOName::kSize) {
     return nullptr;
   }
 
-  const MachOImageSegmentReader* segment = segments_[iterator->second];
-  return segment;
+  return FindSegment(MachOName(segment_name.c_str()));
+}
+
+const MachOImageSegmentReader* MachOImageReader::GetSegmentByName(
+    const MachOName& segment_name) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return FindSegment(segment_name);
 }
 
 const process_types::section* MachOImageReader::GetSectionByName(
@@ -339,6 +346,20 @@ const process_types::section* MachOImageReader::GetSectionByName(
   return segment->GetSectionByName(section_name, address);
 }
 
+const process_types::section* MachOImageReader::GetSectionByName(
+    const MachOName& segment_name,
+    const MachOName& section_name,
+    mach_vm_address_t* address) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  const MachOImageSegmentReader* segment = FindSegment(segment_name);
+  if (!segment) {
+    return nullptr;
+  }
+
+  return segment->GetSectionByName(section_name, address);
+}
+
 const process_types::section* MachOImageReader::GetSectionAtIndex(
     size_t index,
     const MachOImageSegmentReader** containing_segment,
@@ -379,16 +400,33 @@ bool MachOImageReader::LookUpExternalDefinedSymbol(
     mach_vm_address_t* value) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  if (symbol_table_initialized_.is_uninitialized()) {
-    InitializeSymbolTable();
-  }
+  std::unique_ptr<MachOImageSymbolTableReader> single_symbol_table;
+  const MachOImageSymbolTableReader* symbol_table;
+  if (symbol_table_initialized_.is_uninitialized() && !looked_up_symbol_) {
+    looked_up_symbol_ = true;
+    if (!symtab_command_) {
+      return false;
+    }
 
-  if (!symbol_table_initialized_.is_valid() || !symbol_table_) {
-    return false;
+    const std::vector<std::string> symbol_names(1, name);
+    single_symbol_table = ReadSymbolTable(&symbol_names);
+    if (!single_symbol_table) {
+      return false;
+    }
+    symbol_table = single_symbol_table.get();
+  } else {
+    if (symbol_table_initialized_.is_uninitialized()) {
+      InitializeSymbolTable();
+    }
+
+    if (!symbol_table_initialized_.is_valid() || !symbol_table_) {
+      return false;
+    }
+    symbol_table = symbol_table_.get();
   }
 
   const MachOImageSymbolTableReader::SymbolInformation* symbol_info =
-      symbol_table_->LookUpExternalDefinedSymbol(name);
+      symbol_table->LookUpExternalDefinedSymbol(name);
   if (!symbol_info) {
     return false;
   }
@@ -475,15 +513,37 @@ bool MachOImageReader::GetCrashpadInfo(
     process_types::CrashpadInfo* crashpad_info) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
+  if (crashpad_info_initialized_.is_uninitialized()) {
+    crashpad_info_initialized_.set_invalid();
+    std::unique_ptr<process_types::CrashpadInfo> read_crashpad_info(
+        new process_types::CrashpadInfo());
+    if (ReadCrashpadInfo(read_crashpad_info.get())) {
+      crashpad_info_ = std::move(read_crashpad_info);
+      crashpad_info_initialized_.set_valid();
+    }
+  }
+
+  if (!crashpad_info_initialized_.is_valid()) {
+    return false;
+  }
+
+  *crashpad_info = *crashpad_info_;
+  return true;
+}
+
+bool MachOImageReader::ReadCrashpadInfo(
+    process_types::CrashpadInfo* crashpad_info) const {
   mach_vm_address_t crashpad_info_address;
-  const process_types::section* crashpad_info_section =
-      GetSectionByName(SEG_DATA, "crashpad_info", &crashpad_info_address);
+  const process_types::section* crashpad_info_section = GetSectionByName(
+      MachOName(SEG_DATA), MachOName("crashpad_info"), &crashpad_info_address);
   if (!crashpad_info_section) {
     return false;
   }
 
+  // Modules built against earlier versions of the client have smaller
+  // structures. Their fields are a prefix of the current structure.
   if (crashpad_info_section->size <
-      crashpad_info->ExpectedSize(process_reader_)) {
+      crashpad_info->ExpectedSizeForVersion(process_reader_, 1)) {
     LOG(WARNING) << "small crashpad info section size "
                  << crashpad_info_section->size << module_info_;
     return false;
@@ -545,15 +605,17 @@ bool MachOImageReader::ReadSegmentCommand(
   // become inconsistent or require cleanup.
 
   const std::string segment_name = segment->Name();
-  const auto insert_result =
-      segment_map_.insert(std::make_pair(segment_name, segment_index));
-  if (!insert_result.second) {
-    LOG(WARNING) << base::StringPrintf("duplicate %s segment at %zu and %zu",
-                                       segment_name.c_str(),
-                                       insert_result.first->second,
-                                       segment_index) << load_command_info;
-    return false;
+  const MachOName segment_key(segment_name.c_str());
+  for (const auto& entry : segment_map_) {
+    if (entry.first == segment_key) {
+      LOG(WARNING) << base::StringPrintf("duplicate %s segment at %zu and %zu",
+                                         segment_name.c_str(),
+                                         entry.second,
+                                         segment_index) << load_command_info;
+      return false;
+    }
   }
+  segment_map_.push_back(std::make_pair(segment_key, segment_index));
 
   if (segment_name == SEG_TEXT) {
     mach_vm_size_t vmsize = segment->vmsize();
@@ -691,26 +753,49 @@ void MachOImageReader::InitializeSymbolTable() const {
     return;
   }
 
+  symbol_table_ = ReadSymbolTable(nullptr);
+  if (!symbol_table_) {
+    return;
+  }
+
+  symbol_table_initialized_.set_valid();
+}
+
+const MachOImageSegmentReader* MachOImageReader::FindSegment(
+    const MachOName& segment_name) const {
+  for (const auto& entry : segment_map_) {
+    if (entry.first == segment_name) {
+      return segments_[entry.second];
+    }
+  }
+  return nullptr;
+}
+
+std::unique_ptr<MachOImageSymbolTableReader> MachOImageReader::ReadSymbolTable(
+    const std::vector<std::string>* symbol_names) const {
+  DCHECK(symtab_command_);
+
   // Find the __LINKEDIT segment. Technically, the symbol table can be in any
   // mapped segment, but by convention, it’s in the one named __LINKEDIT.
   const MachOImageSegmentReader* linkedit_segment =
-      GetSegmentByName(SEG_LINKEDIT);
+      GetSegmentByName(MachOName(SEG_LINKEDIT));
   if (!linkedit_segment) {
     LOG(WARNING) << "no " SEG_LINKEDIT " segment";
-    return;
+    return std::unique_ptr<MachOImageSymbolTableReader>();
   }
 
-  symbol_table_.reset(new MachOImageSymbolTableReader());
-  if (!symbol_table_->Initialize(process_reader_,
-                                 symtab_command_.get(),
-                                 dysymtab_command_.get(),
-                                 linkedit_segment,
-                                 module_info_)) {
-    symbol_table_.reset();
-    return;
+  std::unique_ptr<MachOImageSymbolTableReader> symbol_table(
+      new MachOImageSymbolTableReader());
+  if (!symbol_table->Initialize(process_reader_,
+                                symtab_command_.get(),
+                                dysymtab_command_.get(),
+                                linkedit_segment,
+                                module_info_,
+                                symbol_names)) {
+    return std::unique_ptr<MachOImageSymbolTableReader>();
   }
 
-  symbol_table_initialized_.set_valid();
+  return symbol_table;
 }
 
 }  // namespace crashpad
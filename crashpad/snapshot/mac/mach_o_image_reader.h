@@ -19,19 +19,21 @@
 #include <stdint.h>
 #include <sys/types.h>
 
-#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/macros.h"
+#include "snapshot/mac/mach_o_image_segment_reader.h"
 #include "snapshot/mac/process_types.h"
+#include "util/misc/initialization_state.h"
 #include "util/misc/initialization_state_dcheck.h"
 #include "util/misc/uuid.h"
 #include "util/stdlib/pointer_container.h"
 
 namespace crashpad {
 
-class MachOImageSegmentReader;
 class MachOImageSymbolTableReader;
 class ProcessReader;
 
@@ -119,6 +121,14 @@ class MachOImageReader {
   const MachOImageSegmentReader* GetSegmentByName(
       const std::string& segment_name) const;
 
+  //! \brief Obtain segment information by segment name.
+  //!
+  //! This is identical to GetSegmentByName(const std::string&) const, but
+  //! avoids converting \a segment_name when the same name is looked up in many
+  //! images.
+  const MachOImageSegmentReader* GetSegmentByName(
+      const MachOName& segment_name) const;
+
   //! \brief Obtain section information by segment and section name.
   //!
   //! \param[in] segment_name The name of the segment to search for, for
@@ -147,6 +157,17 @@ class MachOImageReader {
       const std::string& section_name,
       mach_vm_address_t* address) const;
 
+  //! \brief Obtain section information by segment and section name.
+  //!
+  //! This is identical to GetSectionByName(const std::string&, const
+  //! std::string&, mach_vm_address_t*) const, but avoids converting \a
+  //! segment_name and \a section_name when the same names are looked up in
+  //! many images.
+  const process_types::section* GetSectionByName(
+      const MachOName& segment_name,
+      const MachOName& section_name,
+      mach_vm_address_t* address) const;
+
   //! \brief Obtain section information by section index.
   //!
   //! \param[in] index The index of the section to return, in the order that it
@@ -269,6 +290,9 @@ class MachOImageReader {
 
   //! \brief Obtains the module’s CrashpadInfo structure.
   //!
+  //! The structure is read from the remote process the first time that this
+  //! method is called, and is not read again.
+  //!
   //! \return `true` on success, `false` on failure. If the module does not have
   //!     a `__DATA,crashpad_info` section, this will return `false` without
   //!     logging any messages. Other failures will result in messages being
@@ -276,6 +300,9 @@ class MachOImageReader {
   bool GetCrashpadInfo(process_types::CrashpadInfo* crashpad_info) const;
 
  private:
+  // Reads the module’s CrashpadInfo structure on behalf of GetCrashpadInfo().
+  bool ReadCrashpadInfo(process_types::CrashpadInfo* crashpad_info) const;
+
   // A generic helper routine for the other Read*Command() methods.
   template <typename T>
   bool ReadLoadCommand(mach_vm_address_t load_command_address,
@@ -317,8 +344,21 @@ class MachOImageReader {
   // will be set to the valid state, but symbol_table_ will be nullptr.
   void InitializeSymbolTable() const;
 
+  // Reads the symbol table, retaining only the symbols named in |symbol_names|
+  // if it is not nullptr. symtab_command_ must be present. Returns nullptr with
+  // a warning message logged on failure.
+  std::unique_ptr<MachOImageSymbolTableReader> ReadSymbolTable(
+      const std::vector<std::string>* symbol_names) const;
+
+  // Returns the segment named |segment_name|, or nullptr if there is none. This
+  // may be called during initialization.
+  const MachOImageSegmentReader* FindSegment(
+      const MachOName& segment_name) const;
+
   PointerVector<MachOImageSegmentReader> segments_;
-  std::map<std::string, size_t> segment_map_;
+  // Maps segment names to indices into segments_. Images have few segments,
+  // so this is searched linearly.
+  std::vector<std::pair<MachOName, size_t>> segment_map_;
   std::string module_name_;
   std::string module_info_;
   std::string dylinker_name_;
@@ -336,6 +376,11 @@ class MachOImageReader {
   // const-ness, not physical const-ness.
   mutable std::unique_ptr<MachOImageSymbolTableReader> symbol_table_;
 
+  // Most images are only ever asked for a single symbol, so the first lookup is
+  // served by reading only that symbol, without building symbol_table_. This
+  // is set once that has been done, so that later lookups use symbol_table_.
+  mutable bool looked_up_symbol_;
+
   std::unique_ptr<process_types::dylib_command> id_dylib_command_;
   ProcessReader* process_reader_;  // weak
   uint32_t file_type_;
@@ -348,6 +393,13 @@ class MachOImageReader {
   // set in modules that have no symbol table.
   mutable InitializationState symbol_table_initialized_;
 
+  // crashpad_info_ holds the result of the first GetCrashpadInfo() call, which
+  // is consulted by each reader of the module’s annotations and options.
+  // crashpad_info_initialized_ is valid once it has been read successfully,
+  // and invalid if the module has no CrashpadInfo or it could not be read.
+  mutable std::unique_ptr<process_types::CrashpadInfo> crashpad_info_;
+  mutable InitializationState crashpad_info_initialized_;
+
   DISALLOW_COPY_AND_ASSIGN(MachOImageReader);
 };
 
@@ -15,6 +15,7 @@
 #include "snapshot/mac/mach_o_image_segment_reader.h"
 
 #include <mach-o/loader.h>
+#include <string.h>
 
 #include <utility>
 
@@ -35,6 +36,12 @@ std::string SizeLimitedCString(const char* c_string, size_t max_length) {
 
 }  // namespace
 
+constexpr size_t MachOName::kSize;
+
+MachOName::MachOName(const char* name) : words() {
+  memcpy(words, name, strnlen(name, kSize));
+}
+
 MachOImageSegmentReader::MachOImageSegmentReader()
     : segment_command_(),
       sections_(),
@@ -166,14 +173,16 @@ bool MachOImageSegmentReader::Initialize(ProcessReader* process_reader,
       return false;
     }
 
-    const auto insert_result =
-        section_map_.insert(std::make_pair(section_name, section_index));
-    if (!insert_result.second) {
-      LOG(WARNING) << base::StringPrintf("duplicate section name at %zu",
-                                         insert_result.first->second)
-                   << section_info;
-      return false;
+    const MachOName section_key(section.sectname);
+    for (const auto& entry : section_map_) {
+      if (entry.first == section_key) {
+        LOG(WARNING) << base::StringPrintf("duplicate section name at %zu",
+                                           entry.second)
+                     << section_info;
+        return false;
+      }
     }
+    section_map_.push_back(std::make_pair(section_key, section_index));
   }
 
   INITIALIZATION_STATE_SET_VALID(initialized_);
@@ -202,12 +211,25 @@ const process_types::section* MachOImageSegmentReader::GetSectionByName(
     mach_vm_address_t* address) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  const auto& iterator = section_map_.find(section_name);
-  if (iterator == section_map_.end()) {
+  if (section_name.size() > MachOName::kSize) {
     return nullptr;
   }
 
-  return GetSectionAtIndex(iterator->second, address);
+  return GetSectionByName(MachOName(section_name.c_str()), address);
+}
+
+const process_types::section* MachOImageSegmentReader::GetSectionByName(
+    const MachOName& section_name,
+    mach_vm_address_t* address) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  for (const auto& entry : section_map_) {
+    if (entry.first == section_name) {
+      return GetSectionAtIndex(entry.second, address);
+    }
+  }
+
+  return nullptr;
 }
 
 const process_types::section* MachOImageSegmentReader::GetSectionAtIndex(
@@ -19,8 +19,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
-#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/macros.h"
@@ -29,6 +29,37 @@
 
 namespace crashpad {
 
+//! \brief A segment or section name, as held in the fixed-size field of a
+//!     Mach-O load command.
+//!
+//! Segment and section names are at most 16 characters long. They are
+//! `NUL`-padded, and need not be `NUL`-terminated. Holding a name as two 64-bit
+//! words allows names to be compared with two integer comparisons, without
+//! constructing a string.
+struct MachOName {
+  //! \brief The size of a segment or section name field.
+  static constexpr size_t kSize = 16;
+
+  //! \brief Constructs an empty name.
+  MachOName() : words() {}
+
+  //! \brief Constructs a name from the name field at \a name, or from a
+  //!     shorter `NUL`-terminated string such as `SEG_DATA`.
+  //!
+  //! At most kSize bytes are read from \a name, and any bytes following a
+  //! `NUL` terminator are ignored.
+  explicit MachOName(const char* name);
+
+  bool operator==(const MachOName& other) const {
+    return words[0] == other.words[0] && words[1] == other.words[1];
+  }
+  bool operator!=(const MachOName& other) const { return !(*this == other); }
+
+  uint64_t words[2];
+};
+
+static_assert(sizeof(MachOName) == MachOName::kSize, "MachOName size");
+
 //! \brief A reader for `LC_SEGMENT` or `LC_SEGMENT_64` load commands in Mach-O
 //!     images mapped into another process.
 //!
@@ -164,6 +195,15 @@ class MachOImageSegmentReader {
       const std::string& section_name,
       mach_vm_address_t* address) const;
 
+  //! \brief Obtain section information by section name.
+  //!
+  //! This is identical to GetSectionByName(const std::string&,
+  //! mach_vm_address_t*) const, but avoids converting \a section_name when
+  //! the same name is looked up in many segments.
+  const process_types::section* GetSectionByName(
+      const MachOName& section_name,
+      mach_vm_address_t* address) const;
+
   //! \brief Obtain section information by section index.
   //!
   //! \param[in] index The index of the section to return, in the order that it
@@ -242,8 +282,9 @@ class MachOImageSegmentReader {
   // given in the remote process.
   std::vector<process_types::section> sections_;
 
-  // Maps section names to indices into the sections_ vector.
-  std::map<std::string, size_t> section_map_;
+  // Maps section names to indices into the sections_ vector. Segments have
+  // few sections, so this is searched linearly.
+  std::vector<std::pair<MachOName, size_t>> section_map_;
 
   // The image’s slide. Note that the segment’s slide may be 0 and not the value
   // of the image’s slide if SegmentSlides() is false. In that case, the
@@ -16,8 +16,10 @@
 
 #include <mach-o/loader.h>
 #include <mach-o/nlist.h>
+#include <string.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -57,10 +59,12 @@ class MachOImageSymbolTableReaderInitializer {
   //! \brief Reads the symbol table from another process.
   //!
   //! \sa MachOImageSymbolTableReader::Initialize()
-  bool Initialize(const process_types::symtab_command* symtab_command,
-                  const process_types::dysymtab_command* dysymtab_command,
-                  MachOImageSymbolTableReader::SymbolInformationMap*
-                      external_defined_symbols) {
+  bool Initialize(
+      const process_types::symtab_command* symtab_command,
+      const process_types::dysymtab_command* dysymtab_command,
+      const std::vector<std::string>* symbol_names,
+      MachOImageSymbolTableReader::SymbolVector* external_defined_symbols,
+      std::unique_ptr<TaskMemory::MappedMemory>* string_table_out) {
     mach_vm_address_t symtab_address =
         AddressForLinkEditComponent(symtab_command->symoff);
     uint32_t symbol_count = symtab_command->nsyms;
@@ -101,7 +105,7 @@ class MachOImageSymbolTableReaderInitializer {
     }
 
     std::unique_ptr<process_types::nlist[]> symbols(
-        new process_types::nlist[symtab_command->nsyms]);
+        new process_types::nlist[symbol_count]);
     if (!process_types::nlist::ReadArrayInto(
             process_reader_, symtab_address, symbol_count, &symbols[0])) {
       LOG(WARNING) << "could not read symbol table" << module_info_;
@@ -109,11 +113,18 @@ class MachOImageSymbolTableReaderInitializer {
     }
 
     std::unique_ptr<TaskMemory::MappedMemory> string_table;
+    MachOImageSymbolTableReader::SymbolVector symbols_found;
     for (size_t symbol_index = 0; symbol_index < symbol_count; ++symbol_index) {
       const process_types::nlist& symbol = symbols[symbol_index];
-      std::string symbol_info = base::StringPrintf(", symbol index %zu%s",
-                                                   skip_count + symbol_index,
-                                                   module_info_.c_str());
+
+      // This is only formatted when it’s needed for a message, because a
+      // module may have thousands of symbols.
+      const auto symbol_info = [this, skip_count, symbol_index]() {
+        return base::StringPrintf(", symbol index %zu%s",
+                                  skip_count + symbol_index,
+                                  module_info_.c_str());
+      };
+
       bool valid_symbol = true;
       if ((symbol.n_type & N_STAB) == 0 && (symbol.n_type & N_PEXT) == 0 &&
           (symbol.n_type & N_EXT)) {
@@ -123,7 +134,7 @@ class MachOImageSymbolTableReaderInitializer {
             LOG(WARNING) << base::StringPrintf(
                                 "string at 0x%x out of bounds (0x%llx)",
                                 symbol.n_strx,
-                                strtab_size) << symbol_info;
+                                strtab_size) << symbol_info();
             return false;
           }
 
@@ -136,33 +147,40 @@ class MachOImageSymbolTableReaderInitializer {
             }
           }
 
-          std::string name;
-          if (!string_table->ReadCString(symbol.n_strx, &name)) {
-            LOG(WARNING) << "could not read string" << symbol_info;
+          // The name refers directly to the mapped string table, which is
+          // retained along with the symbols.
+          const char* name_base =
+              reinterpret_cast<const char*>(string_table->data()) +
+              symbol.n_strx;
+          const size_t name_max_length = strtab_size - symbol.n_strx;
+          const size_t name_length = strnlen(name_base, name_max_length);
+          if (name_length == name_max_length) {
+            LOG(WARNING) << "could not read string" << symbol_info();
             return false;
           }
+          const base::StringPiece name(name_base, name_length);
 
           if (symbol_type == N_ABS && symbol.n_sect != NO_SECT) {
             LOG(WARNING) << base::StringPrintf("N_ABS symbol %s in section %u",
-                                               name.c_str(),
-                                               symbol.n_sect) << symbol_info;
+                                               name.as_string().c_str(),
+                                               symbol.n_sect)
+                         << symbol_info();
             return false;
           }
 
           if (symbol_type == N_SECT && symbol.n_sect == NO_SECT) {
             LOG(WARNING) << base::StringPrintf(
                                 "N_SECT symbol %s in section NO_SECT",
-                                name.c_str()) << symbol_info;
+                                name.as_string().c_str()) << symbol_info();
             return false;
           }
 
-          MachOImageSymbolTableReader::SymbolInformation this_symbol_info;
-          this_symbol_info.value = symbol.n_value;
-          this_symbol_info.section = symbol.n_sect;
-          if (!external_defined_symbols->insert(
-                  std::make_pair(name, this_symbol_info)).second) {
-            LOG(WARNING) << "duplicate symbol " << name << symbol_info;
-            return false;
+          if (IsSymbolWanted(name, symbol_names)) {
+            MachOImageSymbolTableReader::Symbol this_symbol;
+            this_symbol.name = name;
+            this_symbol.information.value = symbol.n_value;
+            this_symbol.information.section = symbol.n_sect;
+            symbols_found.push_back(this_symbol);
           }
         } else {
           // External indirect symbols may be found in the portion of the symbol
@@ -180,15 +198,56 @@ class MachOImageSymbolTableReaderInitializer {
       }
       if (!valid_symbol && dysymtab_command) {
         LOG(WARNING) << "non-external symbol with type " << symbol.n_type
-                     << " in extdefsym" << symbol_info;
+                     << " in extdefsym" << symbol_info();
         return false;
       }
     }
 
+    std::sort(symbols_found.begin(),
+              symbols_found.end(),
+              [](const MachOImageSymbolTableReader::Symbol& lhs,
+                 const MachOImageSymbolTableReader::Symbol& rhs) {
+                return lhs.name < rhs.name;
+              });
+    const auto duplicate = std::adjacent_find(
+        symbols_found.begin(),
+        symbols_found.end(),
+        [](const MachOImageSymbolTableReader::Symbol& lhs,
+           const MachOImageSymbolTableReader::Symbol& rhs) {
+          return lhs.name == rhs.name;
+        });
+    if (duplicate != symbols_found.end()) {
+      LOG(WARNING) << "duplicate symbol " << duplicate->name.as_string()
+                   << module_info_;
+      return false;
+    }
+
+    external_defined_symbols->swap(symbols_found);
+    *string_table_out = std::move(string_table);
     return true;
   }
 
  private:
+  //! \brief Determines whether a symbol should be retained.
+  //!
+  //! \param[in] name The symbol’s name.
+  //! \param[in] symbol_names The names of the symbols to retain, or `nullptr`
+  //!     to retain all symbols.
+  //!
+  //! \return `true` if the symbol named \a name should be retained.
+  static bool IsSymbolWanted(const base::StringPiece& name,
+                             const std::vector<std::string>* symbol_names) {
+    if (!symbol_names) {
+      return true;
+    }
+    for (const std::string& symbol_name : *symbol_names) {
+      if (name == base::StringPiece(symbol_name)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   //! \brief Computes the address for data in the `__LINKEDIT` segment
   //!     identified by its file offset in a Mach-O image.
   //!
@@ -252,7 +311,7 @@ class MachOImageSymbolTableReaderInitializer {
 }  // namespace internal
 
 MachOImageSymbolTableReader::MachOImageSymbolTableReader()
-    : external_defined_symbols_(), initialized_() {
+    : external_defined_symbols_(), string_table_(), initialized_() {
 }
 
 MachOImageSymbolTableReader::~MachOImageSymbolTableReader() {
@@ -263,14 +322,18 @@ bool MachOImageSymbolTableReader::Initialize(
     const process_types::symtab_command* symtab_command,
     const process_types::dysymtab_command* dysymtab_command,
     const MachOImageSegmentReader* linkedit_segment,
-    const std::string& module_info) {
+    const std::string& module_info,
+    const std::vector<std::string>* symbol_names) {
   INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
 
   internal::MachOImageSymbolTableReaderInitializer initializer(process_reader,
                                                                linkedit_segment,
                                                                module_info);
-  if (!initializer.Initialize(
-          symtab_command, dysymtab_command, &external_defined_symbols_)) {
+  if (!initializer.Initialize(symtab_command,
+                              dysymtab_command,
+                              symbol_names,
+                              &external_defined_symbols_,
+                              &string_table_)) {
     return false;
   }
 
@@ -283,11 +346,19 @@ MachOImageSymbolTableReader::LookUpExternalDefinedSymbol(
     const std::string& name) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  const auto& iterator = external_defined_symbols_.find(name);
-  if (iterator == external_defined_symbols_.end()) {
+  const base::StringPiece name_piece(name);
+  const auto iterator =
+      std::lower_bound(external_defined_symbols_.begin(),
+                       external_defined_symbols_.end(),
+                       name_piece,
+                       [](const Symbol& symbol, const base::StringPiece& name) {
+                         return symbol.name < name;
+                       });
+  if (iterator == external_defined_symbols_.end() ||
+      iterator->name != name_piece) {
     return nullptr;
   }
-  return &iterator->second;
+  return &iterator->information;
 }
 
 }  // namespace crashpad
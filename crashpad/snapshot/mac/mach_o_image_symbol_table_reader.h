@@ -15,16 +15,19 @@
 #ifndef CRASHPAD_SNAPSHOT_MAC_MACH_O_IMAGE_SYMBOL_TABLE_READER_H_
 #define CRASHPAD_SNAPSHOT_MAC_MACH_O_IMAGE_SYMBOL_TABLE_READER_H_
 
-#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <mach/mach.h>
 #include <stdint.h>
 
 #include "base/macros.h"
+#include "base/strings/string_piece.h"
 #include "snapshot/mac/mach_o_image_segment_reader.h"
 #include "snapshot/mac/process_reader.h"
 #include "snapshot/mac/process_types.h"
+#include "util/mach/task_memory.h"
 #include "util/misc/initialization_state_dcheck.h"
 
 namespace crashpad {
@@ -53,19 +56,26 @@ class MachOImageSymbolTableReader {
     uint8_t section;
   };
 
-  // TODO(mark): Use unordered_map or a similar hash-based map? For now,
-  // std::map is fine because this map only stores external defined symbols,
-  // and there aren’t expected to be very many of those that performance would
-  // become a problem. std::map is also guaranteed to be part of the standard
-  // library, which isn’t the case for std::unordered_map, which requires the
-  // C++11 library. In reality, std::unordered_map does not appear to provide
-  // a performance advantage. It appears that the memory copies currently done
-  // by TaskMemory::Read() have substantially more impact on symbol table
-  // operations.
-  //
-  // This is public so that the type is available to
-  // MachOImageSymbolTableReaderInitializer.
-  using SymbolInformationMap = std::map<std::string, SymbolInformation>;
+  //! \brief A symbol in a module’s symbol table, as stored by this class.
+  //!
+  //! This is public so that the type is available to
+  //! MachOImageSymbolTableReaderInitializer.
+  struct Symbol {
+    //! \brief The symbol’s name, which refers to the module’s string table
+    //!     as mapped into this process.
+    base::StringPiece name;
+
+    //! \brief Information about the symbol.
+    SymbolInformation information;
+  };
+
+  //! \brief Symbols sorted by name, so that they may be found by binary
+  //!     search.
+  //!
+  //! A flat vector is used rather than a map, because a module may define
+  //! thousands of external symbols. Their names aren’t copied, but refer to a
+  //! single mapping of the module’s string table.
+  using SymbolVector = std::vector<Symbol>;
 
   MachOImageSymbolTableReader();
   ~MachOImageSymbolTableReader();
@@ -91,6 +101,10 @@ class MachOImageSymbolTableReader {
   //!     convention, the name `__LINKEDIT` is used for this purpose.
   //! \param[in] module_info A string to be used in logged messages. This string
   //!     is for diagnostic purposes only, and may be empty.
+  //! \param[in] symbol_names If not `nullptr`, the names of the only symbols
+  //!     that LookUpExternalDefinedSymbol() will be able to find. Other symbols
+  //!     are validated, but not retained. When only a few symbols are of
+  //!     interest, this avoids building a table of every external symbol.
   //!
   //! \return `true` if the symbol table was read successfully. `false`
   //!     otherwise, with an appropriate message logged.
@@ -98,7 +112,8 @@ class MachOImageSymbolTableReader {
                   const process_types::symtab_command* symtab_command,
                   const process_types::dysymtab_command* dysymtab_command,
                   const MachOImageSegmentReader* linkedit_segment,
-                  const std::string& module_info);
+                  const std::string& module_info,
+                  const std::vector<std::string>* symbol_names);
 
   //! \brief Looks up a symbol in the image’s symbol table.
   //!
@@ -123,7 +138,8 @@ class MachOImageSymbolTableReader {
       const std::string& name) const;
 
  private:
-  SymbolInformationMap external_defined_symbols_;
+  SymbolVector external_defined_symbols_;
+  std::unique_ptr<TaskMemory::MappedMemory> string_table_;
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(MachOImageSymbolTableReader);
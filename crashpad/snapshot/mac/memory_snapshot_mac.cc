@@ -16,11 +16,21 @@
 
 #include <memory>
 
+#include "base/logging.h"
 #include "util/mach/task_memory.h"
 
 namespace crashpad {
 namespace internal {
 
+namespace {
+
+// Snapshots at least this large are mapped into the current task with
+// copy-on-write semantics and handed to the delegate in place, rather than
+// copied. Large stacks and extra memory ranges can be several megabytes.
+constexpr size_t kRemapThreshold = 64 * 1024;
+
+}  // namespace
+
 MemorySnapshotMac::MemorySnapshotMac()
     : MemorySnapshot(),
       process_reader_(nullptr),
@@ -59,11 +69,54 @@ bool MemorySnapshotMac::Read(Delegate* delegate) const {
     return delegate->MemorySnapshotDelegateRead(nullptr, size_);
   }
 
-  std::unique_ptr<uint8_t[]> buffer(new uint8_t[size_]);
-  if (!process_reader_->Memory()->Read(address_, size_, buffer.get())) {
+  if (size_ >= kRemapThreshold) {
+    // The mapping must outlive the delegate’s use of the data, which ends when
+    // MemorySnapshotDelegateRead() returns. If the memory can’t be mapped,
+    // it’s copied instead.
+    std::unique_ptr<TaskMemory::MappedMemory> mapped =
+        process_reader_->Memory()->ReadRemapped(address_, size_);
+    if (mapped) {
+      return delegate->MemorySnapshotDelegateRead(
+          const_cast<void*>(mapped->data()), size_);
+    }
+  }
+
+  // Read directly into the delegate’s storage when it offers some, avoiding
+  // an intermediate allocation and copy.
+  void* buffer = delegate->MemorySnapshotDelegateBuffer(size_);
+  std::unique_ptr<uint8_t[]> owned_buffer;
+  if (!buffer) {
+    owned_buffer.reset(new uint8_t[size_]);
+    buffer = owned_buffer.get();
+  }
+
+  if (!process_reader_->Memory()->Read(address_, size_, buffer)) {
     return false;
   }
-  return delegate->MemorySnapshotDelegateRead(buffer.get(), size_);
+  return delegate->MemorySnapshotDelegateRead(buffer, size_);
+}
+
+const MemorySnapshot* MemorySnapshotMac::MergeWithOtherSnapshot(
+    const MemorySnapshot* other) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // All memory snapshots merged together come from the same process snapshot,
+  // and are therefore of this concrete type.
+  const MemorySnapshotMac* other_as_mac =
+      reinterpret_cast<const MemorySnapshotMac*>(other);
+  if (process_reader_ != other_as_mac->process_reader_) {
+    LOG(ERROR) << "different process_reader_ for snapshots";
+    return nullptr;
+  }
+
+  CheckedRange<uint64_t, size_t> merged(0, 0);
+  if (!DetermineMergedRange(this, other, &merged)) {
+    return nullptr;
+  }
+
+  MemorySnapshotMac* result = new MemorySnapshotMac();
+  result->Initialize(process_reader_, merged.base(), merged.size());
+  return result;
 }
 
 }  // namespace internal
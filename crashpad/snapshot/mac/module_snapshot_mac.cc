@@ -21,6 +21,7 @@
 #include "base/strings/stringprintf.h"
 #include "snapshot/mac/mach_o_image_annotations_reader.h"
 #include "snapshot/mac/mach_o_image_reader.h"
+#include "util/misc/memory_read_trace.h"
 #include "util/misc/tri_state.h"
 #include "util/misc/uuid.h"
 #include "util/stdlib/strnlen.h"
@@ -59,12 +60,15 @@ bool ModuleSnapshotMac::Initialize(
 
 void ModuleSnapshotMac::GetCrashpadOptions(CrashpadInfoClientOptions* options) {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  ScopedMemoryReadSite read_site(MemoryReadSite::kAnnotations);
 
   process_types::CrashpadInfo crashpad_info;
   if (!mach_o_image_reader_->GetCrashpadInfo(&crashpad_info)) {
     options->crashpad_handler_behavior = TriState::kUnset;
     options->system_crash_reporter_forwarding = TriState::kUnset;
     options->gather_indirectly_referenced_memory = TriState::kUnset;
+    options->indirectly_referenced_memory_cap = 0;
+    options->capture_deadline_ms = 0;
     return;
   }
 
@@ -82,6 +86,8 @@ void ModuleSnapshotMac::GetCrashpadOptions(CrashpadInfoClientOptions* options) {
 
   options->indirectly_referenced_memory_cap =
       crashpad_info.indirectly_referenced_memory_cap;
+
+  options->capture_deadline_ms = crashpad_info.capture_deadline_ms;
 }
 
 std::string ModuleSnapshotMac::Name() const {
@@ -172,6 +178,7 @@ std::string ModuleSnapshotMac::DebugFileName() const {
 
 std::vector<std::string> ModuleSnapshotMac::AnnotationsVector() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  ScopedMemoryReadSite read_site(MemoryReadSite::kAnnotations);
   MachOImageAnnotationsReader annotations_reader(
       process_reader_, mach_o_image_reader_, name_);
   return annotations_reader.Vector();
@@ -180,11 +187,29 @@ std::vector<std::string> ModuleSnapshotMac::AnnotationsVector() const {
 std::map<std::string, std::string> ModuleSnapshotMac::AnnotationsSimpleMap()
     const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  ScopedMemoryReadSite read_site(MemoryReadSite::kAnnotations);
   MachOImageAnnotationsReader annotations_reader(
       process_reader_, mach_o_image_reader_, name_);
   return annotations_reader.SimpleMap();
 }
 
+std::vector<AnnotationSnapshot> ModuleSnapshotMac::AnnotationObjects() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  ScopedMemoryReadSite read_site(MemoryReadSite::kAnnotations);
+  MachOImageAnnotationsReader annotations_reader(
+      process_reader_, mach_o_image_reader_, name_);
+  return annotations_reader.AnnotationsList();
+}
+
+std::map<uint64_t, std::vector<AnnotationSnapshot>>
+ModuleSnapshotMac::ThreadAnnotationObjects() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  ScopedMemoryReadSite read_site(MemoryReadSite::kAnnotations);
+  MachOImageAnnotationsReader annotations_reader(
+      process_reader_, mach_o_image_reader_, name_);
+  return annotations_reader.ThreadAnnotationsList();
+}
+
 std::set<CheckedRange<uint64_t>> ModuleSnapshotMac::ExtraMemoryRanges() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   return std::set<CheckedRange<uint64_t>>();
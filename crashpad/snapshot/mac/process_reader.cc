@@ -16,18 +16,26 @@
 
 #include <AvailabilityMacros.h>
 #include <mach/mach_vm.h>
+#include <mach/shared_region.h>
 #include <mach-o/loader.h>
+#include <string.h>
 
 #include <algorithm>
+#include <iterator>
+#include <limits>
+#include <utility>
 
 #include "base/logging.h"
 #include "base/mac/mach_logging.h"
 #include "base/mac/scoped_mach_port.h"
 #include "base/mac/scoped_mach_vm.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
 #include "snapshot/mac/mach_o_image_reader.h"
 #include "snapshot/mac/process_types.h"
 #include "util/misc/scoped_forbid_return.h"
+#include "util/misc/uuid.h"
+#include "util/thread/thread.h"
 
 namespace {
 
@@ -70,11 +78,82 @@ kern_return_t MachVMRegionRecurseDeepest(task_t task,
 
 namespace crashpad {
 
+namespace {
+
+// The maximum number of threads used to read the images in a process.
+constexpr size_t kImageReaderThreads = 4;
+
+// Reads the names and Mach-O headers of images from a shared list, each into
+// its own slot, until none remain. A reader slot is left empty if its image
+// can’t be read.
+class ImageReaderThread final : public Thread {
+ public:
+  ImageReaderThread(
+      ProcessReader* process_reader,
+      const std::vector<process_types::dyld_image_info>* image_infos,
+      std::vector<std::string>* names,
+      std::vector<std::unique_ptr<MachOImageReader>>* readers,
+      size_t* next_index,
+      base::Lock* lock)
+      : Thread(),
+        process_reader_(process_reader),
+        image_infos_(image_infos),
+        names_(names),
+        readers_(readers),
+        next_index_(next_index),
+        lock_(lock) {}
+
+  ~ImageReaderThread() override {}
+
+ private:
+  // Thread:
+  void ThreadMain() override {
+    while (true) {
+      size_t index;
+      {
+        base::AutoLock lock_owner(*lock_);
+        if (*next_index_ == image_infos_->size()) {
+          return;
+        }
+        index = (*next_index_)++;
+      }
+
+      // Each thread writes only to the slots it claimed, so these don’t need
+      // to be guarded by lock_.
+      const process_types::dyld_image_info& image_info = (*image_infos_)[index];
+      std::string* name = &(*names_)[index];
+      if (!process_reader_->Memory()->ReadCString(image_info.imageFilePath,
+                                                  name)) {
+        LOG(WARNING) << "could not read dyld_image_info::imageFilePath";
+        // Proceed anyway with an empty module name.
+      }
+
+      std::unique_ptr<MachOImageReader> reader(new MachOImageReader());
+      if (reader->Initialize(
+              process_reader_, image_info.imageLoadAddress, *name)) {
+        (*readers_)[index] = std::move(reader);
+      }
+    }
+  }
+
+  ProcessReader* process_reader_;  // weak
+  const std::vector<process_types::dyld_image_info>* image_infos_;  // weak
+  std::vector<std::string>* names_;  // weak
+  std::vector<std::unique_ptr<MachOImageReader>>* readers_;  // weak
+  size_t* next_index_;  // weak
+  base::Lock* lock_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ImageReaderThread);
+};
+
+}  // namespace
+
 ProcessReader::Thread::Thread()
     : thread_context(),
       float_context(),
       debug_context(),
       id(0),
+      name(),
       stack_region_address(0),
       stack_region_size(0),
       thread_specific_data_address(0),
@@ -95,6 +174,7 @@ ProcessReader::ProcessReader()
       modules_(),
       module_readers_(),
       task_memory_(),
+      vm_regions_(),
       task_(TASK_NULL),
       initialized_(),
       is_64_bit_(false),
@@ -121,6 +201,14 @@ bool ProcessReader::Initialize(task_t task) {
   task_memory_.reset(new TaskMemory(task));
   task_ = task;
 
+  // Reading the loaded images alone takes many small reads from each image’s
+  // load commands, so cache what’s read from other tasks. Such tasks are
+  // expected to be suspended while they’re read. This task’s own memory
+  // continues to change as it runs, so it isn’t cached.
+  if (task != mach_task_self()) {
+    task_memory_->EnableCache();
+  }
+
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
@@ -196,6 +284,44 @@ const std::vector<ProcessReader::Module>& ProcessReader::Modules() {
   return modules_;
 }
 
+std::vector<ProcessReader::FoundSection> ProcessReader::FindSections(
+    const std::vector<SectionQuery>& queries) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  std::vector<std::pair<MachOName, MachOName>> names;
+  names.reserve(queries.size());
+  for (const SectionQuery& query : queries) {
+    names.push_back(std::make_pair(MachOName(query.segment_name),
+                                   MachOName(query.section_name)));
+  }
+
+  std::vector<FoundSection> found_sections;
+  const std::vector<Module>& modules = Modules();
+  for (size_t module_index = 0; module_index < modules.size();
+       ++module_index) {
+    const MachOImageReader* reader = modules[module_index].reader;
+    if (!reader) {
+      continue;
+    }
+
+    for (size_t query_index = 0; query_index < names.size(); ++query_index) {
+      FoundSection found_section;
+      const process_types::section* section =
+          reader->GetSectionByName(names[query_index].first,
+                                   names[query_index].second,
+                                   &found_section.address);
+      if (section) {
+        found_section.module_index = module_index;
+        found_section.query_index = query_index;
+        found_section.size = section->size;
+        found_sections.push_back(found_section);
+      }
+    }
+  }
+
+  return found_sections;
+}
+
 mach_vm_address_t ProcessReader::DyldAllImageInfo(
     mach_vm_size_t* all_image_info_size) {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
@@ -348,6 +474,24 @@ void ProcessReader::InitializeThreads() {
       thread.thread_specific_data_address = identifier_info.thread_handle;
     }
 
+#if MAC_OS_X_VERSION_MAX_ALLOWED >= MAC_OS_X_VERSION_10_10
+    // THREAD_EXTENDED_INFO carries the name set by pthread_setname_np(). It is
+    // not available before 10.10, where the kernel rejects the flavor.
+    thread_extended_info extended_info;
+    count = THREAD_EXTENDED_INFO_COUNT;
+    kr = thread_info(thread.port,
+                     THREAD_EXTENDED_INFO,
+                     reinterpret_cast<thread_info_t>(&extended_info),
+                     &count);
+    if (kr == KERN_SUCCESS) {
+      thread.name.assign(
+          extended_info.pth_name,
+          strnlen(extended_info.pth_name, sizeof(extended_info.pth_name)));
+    } else if (kr != KERN_INVALID_ARGUMENT) {
+      MACH_LOG(WARNING, kr) << "thread_info(THREAD_EXTENDED_INFO)";
+    }
+#endif
+
     thread_precedence_policy precedence;
     count = THREAD_PRECEDENCE_POLICY_COUNT;
     boolean_t get_default = FALSE;
@@ -375,6 +519,9 @@ void ProcessReader::InitializeThreads() {
   }
 
   threads_need_owners.Disarm();
+
+  // The map is only consulted to locate stacks, which is now done.
+  vm_regions_.clear();
 }
 
 void ProcessReader::InitializeModules() {
@@ -409,6 +556,24 @@ void ProcessReader::InitializeModules() {
     return;
   }
 
+  // Most images live in the dyld shared cache. Identifying it allows what’s
+  // read from it to be shared with the readers of other processes using the
+  // same shared cache.
+  if (all_image_infos.version >= 13 &&
+      !all_image_infos.processDetachedFromSharedRegion) {
+    UUID shared_cache_uuid;
+    shared_cache_uuid.InitializeFromBytes(all_image_infos.sharedCacheUUID);
+    UUID zero_uuid;
+    zero_uuid.InitializeToZero();
+    if (shared_cache_uuid != zero_uuid) {
+      task_memory_->SetSharedRegion(
+          shared_cache_uuid,
+          all_image_infos.sharedCacheSlide,
+          Is64Bit() ? SHARED_REGION_BASE_X86_64 : SHARED_REGION_BASE_I386,
+          Is64Bit() ? SHARED_REGION_SIZE_X86_64 : SHARED_REGION_SIZE_I386);
+    }
+  }
+
   // Note that all_image_infos.infoArrayCount may be 0 if a crash occurred while
   // dyld was loading the executable. This can happen if a required dynamic
   // library was not found. Similarly, all_image_infos.infoArray may be nullptr
@@ -436,22 +601,46 @@ void ProcessReader::InitializeModules() {
     return;
   }
 
+  // Reading an image takes many reads from the task, and the images are
+  // independent of one another, so they’re read concurrently. The results are
+  // then examined in the order that the images appear in infoArray.
+  std::vector<std::string> image_names(image_info_vector.size());
+  std::vector<std::unique_ptr<MachOImageReader>> image_readers(
+      image_info_vector.size());
+  {
+    size_t next_index = 0;
+    base::Lock lock;
+
+    PointerVector<ImageReaderThread> threads;
+    const size_t thread_count =
+        std::min(kImageReaderThreads, image_info_vector.size());
+    for (size_t index = 0; index < thread_count; ++index) {
+      threads.push_back(new ImageReaderThread(this,
+                                              &image_info_vector,
+                                              &image_names,
+                                              &image_readers,
+                                              &next_index,
+                                              &lock));
+      threads.back()->Start();
+    }
+    for (ImageReaderThread* thread : threads) {
+      thread->Join();
+    }
+  }
+
   size_t main_executable_count = 0;
   bool found_dyld = false;
   modules_.reserve(image_info_vector.size());
-  for (const process_types::dyld_image_info& image_info : image_info_vector) {
+  for (size_t image_index = 0; image_index < image_info_vector.size();
+       ++image_index) {
+    const process_types::dyld_image_info& image_info =
+        image_info_vector[image_index];
     Module module;
     module.timestamp = image_info.imageFileModDate;
+    module.name.swap(image_names[image_index]);
 
-    if (!task_memory_->ReadCString(image_info.imageFilePath, &module.name)) {
-      LOG(WARNING) << "could not read dyld_image_info::imageFilePath";
-      // Proceed anyway with an empty module name.
-    }
-
-    std::unique_ptr<MachOImageReader> reader(new MachOImageReader());
-    if (!reader->Initialize(this, image_info.imageLoadAddress, module.name)) {
-      reader.reset();
-    }
+    std::unique_ptr<MachOImageReader> reader(
+        std::move(image_readers[image_index]));
 
     module.reader = reader.get();
 
@@ -573,11 +762,10 @@ mach_vm_address_t ProcessReader::CalculateStackRegion(
   // stackaddr and stacksize from the TSD area could be used.
   mach_vm_address_t region_base = stack_pointer;
   mach_vm_size_t region_size;
-  natural_t depth = 0;
   vm_prot_t protection;
   unsigned int user_tag;
-  kern_return_t kr = MachVMRegionRecurseDeepest(
-      task_, &region_base, &region_size, &depth, &protection, &user_tag);
+  kern_return_t kr = VMRegionAtOrAbove(
+      &region_base, &region_size, &protection, &user_tag);
   if (kr != KERN_SUCCESS) {
     MACH_LOG(INFO, kr) << "mach_vm_region_recurse";
     *stack_region_size = 0;
@@ -651,12 +839,10 @@ mach_vm_address_t ProcessReader::CalculateStackRegion(
 
     while (try_address += region_size,
            original_try_address = try_address,
-           (kr = MachVMRegionRecurseDeepest(task_,
-                                            &try_address,
-                                            &region_size,
-                                            &depth,
-                                            &protection,
-                                            &user_tag) == KERN_SUCCESS) &&
+           (kr = VMRegionAtOrAbove(&try_address,
+                                   &region_size,
+                                   &protection,
+                                   &user_tag) == KERN_SUCCESS) &&
                try_address == original_try_address &&
                (protection & VM_PROT_READ) != 0 &&
                user_tag == VM_MEMORY_STACK) {
@@ -695,15 +881,12 @@ void ProcessReader::LocateRedZone(mach_vm_address_t* const start_address,
       // discovered.
       mach_vm_address_t red_zone_region_base = red_zone_base;
       mach_vm_size_t red_zone_region_size;
-      natural_t red_zone_depth = 0;
       vm_prot_t red_zone_protection;
       unsigned int red_zone_user_tag;
-      kern_return_t kr = MachVMRegionRecurseDeepest(task_,
-                                                    &red_zone_region_base,
-                                                    &red_zone_region_size,
-                                                    &red_zone_depth,
-                                                    &red_zone_protection,
-                                                    &red_zone_user_tag);
+      kern_return_t kr = VMRegionAtOrAbove(&red_zone_region_base,
+                                           &red_zone_region_size,
+                                           &red_zone_protection,
+                                           &red_zone_user_tag);
       if (kr != KERN_SUCCESS) {
         MACH_LOG(INFO, kr) << "mach_vm_region_recurse";
         *start_address = *region_base;
@@ -733,4 +916,62 @@ void ProcessReader::LocateRedZone(mach_vm_address_t* const start_address,
 #endif
 }
 
+kern_return_t ProcessReader::VMRegionAtOrAbove(mach_vm_address_t* address,
+                                               mach_vm_size_t* size,
+                                               vm_prot_t* protection,
+                                               unsigned int* user_tag) {
+  while (true) {
+    // Find the entry with the greatest base address not above *address, and
+    // use it if it contains *address.
+    auto it = vm_regions_.upper_bound(*address);
+    if (it != vm_regions_.begin() && *address < std::prev(it)->second.end) {
+      --it;
+      const VMRegion& region = it->second;
+      if (!region.mapped) {
+        if (region.end == std::numeric_limits<mach_vm_address_t>::max()) {
+          return KERN_INVALID_ADDRESS;
+        }
+
+        // Nothing is mapped here. The answer is the region that follows.
+        *address = region.end;
+        continue;
+      }
+
+      *address = it->first;
+      *size = region.end - it->first;
+      *protection = region.protection;
+      *user_tag = region.user_tag;
+      return KERN_SUCCESS;
+    }
+
+    mach_vm_address_t region_base = *address;
+    mach_vm_size_t region_size;
+    natural_t depth = 0;
+    vm_prot_t region_protection;
+    unsigned int region_user_tag;
+    kern_return_t kr = MachVMRegionRecurseDeepest(task_,
+                                                  &region_base,
+                                                  &region_size,
+                                                  &depth,
+                                                  &region_protection,
+                                                  &region_user_tag);
+    if (kr == KERN_INVALID_ADDRESS) {
+      // Nothing is mapped at or above *address.
+      vm_regions_[*address] = {std::numeric_limits<mach_vm_address_t>::max(),
+                               VM_PROT_NONE,
+                               0,
+                               false};
+    }
+    if (kr != KERN_SUCCESS) {
+      return kr;
+    }
+
+    if (region_base > *address) {
+      vm_regions_[*address] = {region_base, VM_PROT_NONE, 0, false};
+    }
+    vm_regions_[region_base] = {
+        region_base + region_size, region_protection, region_user_tag, true};
+  }
+}
+
 }  // namespace crashpad
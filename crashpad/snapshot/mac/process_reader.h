@@ -21,6 +21,7 @@
 #include <sys/types.h>
 #include <time.h>
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -65,6 +66,7 @@ class ProcessReader {
     FloatContext float_context;
     DebugContext debug_context;
     uint64_t id;
+    std::string name;
     mach_vm_address_t stack_region_address;
     mach_vm_size_t stack_region_size;
     mach_vm_address_t thread_specific_data_address;
@@ -150,6 +152,46 @@ class ProcessReader {
   //!     corresponds to the dynamic loader, dyld.
   const std::vector<Module>& Modules();
 
+  //! \brief A section to search every module for, used by FindSections().
+  struct SectionQuery {
+    //! \brief The name of the segment containing the section, for example,
+    //!     `"__DATA"`.
+    const char* segment_name;
+
+    //! \brief The name of the section, for example, `"__crash_info"`.
+    const char* section_name;
+  };
+
+  //! \brief A section found by FindSections().
+  struct FoundSection {
+    //! \brief The index into Modules() of the module containing the section.
+    size_t module_index;
+
+    //! \brief The index of the SectionQuery that named the section.
+    size_t query_index;
+
+    //! \brief The actual address that the section was loaded at in memory,
+    //!     taking any “slide” into account.
+    mach_vm_address_t address;
+
+    //! \brief The size of the section.
+    mach_vm_size_t size;
+  };
+
+  //! \brief Finds the sections named by \a queries in every module.
+  //!
+  //! This is equivalent to calling MachOImageReader::GetSectionByName() for
+  //! each query on each module’s reader, but converts each name only once
+  //! rather than once per module, which matters for processes with hundreds of
+  //! modules.
+  //!
+  //! \param[in] queries The sections to find.
+  //!
+  //! \return The sections found, ordered by module and then by query. Modules
+  //!     without a reader are skipped.
+  std::vector<FoundSection> FindSections(
+      const std::vector<SectionQuery>& queries);
+
   //! \brief Determines the location of the `dyld_all_image_infos` structure in
   //!     the process’ address space.
   //!
@@ -229,11 +271,54 @@ class ProcessReader {
                      mach_vm_address_t* region_size,
                      unsigned int user_tag);
 
+  //! \brief Locates the first region at or above an address in the task’s
+  //!     memory map.
+  //!
+  //! This behaves as `mach_vm_region_recurse()` does when recursing into
+  //! submaps until a region that is not a submap is found, but caches its
+  //! results in \a vm_regions_, so that a map entry shared by several
+  //! lookups, such as a guard region between two threads’ stacks, is only
+  //! requested from the kernel once.
+  //!
+  //! \param[in,out] address On entry, the address to look up. On return, the
+  //!     base address of the region found.
+  //! \param[out] size The size of the region found.
+  //! \param[out] protection The region’s current protection.
+  //! \param[out] user_tag The region’s user tag.
+  //!
+  //! \return `KERN_SUCCESS` on success, `KERN_INVALID_ADDRESS` if there is no
+  //!     region at or above \a address, or another error from
+  //!     `mach_vm_region_recurse()`.
+  kern_return_t VMRegionAtOrAbove(mach_vm_address_t* address,
+                                  mach_vm_size_t* size,
+                                  vm_prot_t* protection,
+                                  unsigned int* user_tag);
+
+  //! \brief An entry in \a vm_regions_, which is keyed by the entry’s base
+  //!     address.
+  struct VMRegion {
+    //! \brief The address just beyond the end of the entry.
+    mach_vm_address_t end;
+
+    //! \brief The region’s protection and user tag, only valid if #mapped.
+    vm_prot_t protection;
+    unsigned int user_tag;
+
+    //! \brief `false` if the entry records a range in which nothing is mapped.
+    bool mapped;
+  };
+
   ProcessInfo process_info_;
   std::vector<Thread> threads_;  // owns send rights
   std::vector<Module> modules_;
   PointerVector<MachOImageReader> module_readers_;
   std::unique_ptr<TaskMemory> task_memory_;
+
+  // A sorted snapshot of the parts of the task’s memory map that have been
+  // looked up by VMRegionAtOrAbove(). This is only populated while
+  // InitializeThreads() is running.
+  std::map<mach_vm_address_t, VMRegion> vm_regions_;
+
   task_t task_;  // weak
   InitializationStateDcheck initialized_;
 
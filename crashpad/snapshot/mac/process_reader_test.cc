@@ -708,6 +708,54 @@ TEST(ProcessReader, SelfModules) {
   }
 }
 
+TEST(ProcessReader, SelfFindSections) {
+  ProcessReader process_reader;
+  ASSERT_TRUE(process_reader.Initialize(mach_task_self()));
+
+  const std::vector<ProcessReader::SectionQuery> queries = {
+      {SEG_TEXT, SECT_TEXT},
+      {SEG_DATA, "__no_such_sect"},
+  };
+  const std::vector<ProcessReader::FoundSection> found_sections =
+      process_reader.FindSections(queries);
+
+  // The combined query finds exactly what separate lookups do.
+  const std::vector<ProcessReader::Module>& modules = process_reader.Modules();
+  size_t found_index = 0;
+  for (size_t module_index = 0; module_index < modules.size();
+       ++module_index) {
+    SCOPED_TRACE(base::StringPrintf("module %zu", module_index));
+    const MachOImageReader* reader = modules[module_index].reader;
+    if (!reader) {
+      continue;
+    }
+    for (size_t query_index = 0; query_index < queries.size();
+         ++query_index) {
+      mach_vm_address_t address;
+      const process_types::section* section =
+          reader->GetSectionByName(queries[query_index].segment_name,
+                                   queries[query_index].section_name,
+                                   &address);
+      if (!section) {
+        continue;
+      }
+      ASSERT_LT(found_index, found_sections.size());
+      const ProcessReader::FoundSection& found_section =
+          found_sections[found_index++];
+      EXPECT_EQ(found_section.module_index, module_index);
+      EXPECT_EQ(found_section.query_index, query_index);
+      EXPECT_EQ(found_section.address, address);
+      EXPECT_EQ(found_section.size, section->size);
+    }
+  }
+  EXPECT_EQ(found_index, found_sections.size());
+
+  // The main executable has code.
+  ASSERT_FALSE(found_sections.empty());
+  EXPECT_EQ(found_sections[0].module_index, 0u);
+  EXPECT_EQ(found_sections[0].query_index, 0u);
+}
+
 class ProcessReaderModulesChild final : public MachMultiprocess {
  public:
   ProcessReaderModulesChild() : MachMultiprocess() {}
@@ -16,6 +16,7 @@
 
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
+#include "util/misc/memory_read_trace.h"
 #include "util/misc/tri_state.h"
 
 namespace crashpad {
@@ -111,12 +112,16 @@ void ProcessSnapshotMac::GetCrashpadOptions(
       local_options.indirectly_referenced_memory_cap =
           module_options.indirectly_referenced_memory_cap;
     }
+    if (!local_options.capture_deadline_ms) {
+      local_options.capture_deadline_ms = module_options.capture_deadline_ms;
+    }
 
     // If non-default values have been found for all options, the loop can end
     // early.
     if (local_options.crashpad_handler_behavior != TriState::kUnset &&
         local_options.system_crash_reporter_forwarding != TriState::kUnset &&
-        local_options.gather_indirectly_referenced_memory != TriState::kUnset) {
+        local_options.gather_indirectly_referenced_memory != TriState::kUnset &&
+        local_options.capture_deadline_ms) {
       break;
     }
   }
@@ -173,11 +178,7 @@ const SystemSnapshot* ProcessSnapshotMac::System() const {
 
 std::vector<const ThreadSnapshot*> ProcessSnapshotMac::Threads() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  std::vector<const ThreadSnapshot*> threads;
-  for (internal::ThreadSnapshotMac* thread : threads_) {
-    threads.push_back(thread);
-  }
-  return threads;
+  return threads_.Kept<const ThreadSnapshot>();
 }
 
 std::vector<const ModuleSnapshot*> ProcessSnapshotMac::Modules() const {
@@ -219,16 +220,17 @@ std::vector<const MemorySnapshot*> ProcessSnapshotMac::ExtraMemory() const {
 void ProcessSnapshotMac::InitializeThreads() {
   const std::vector<ProcessReader::Thread>& process_reader_threads =
       process_reader_.Threads();
-  for (const ProcessReader::Thread& process_reader_thread :
-       process_reader_threads) {
-    auto thread = base::WrapUnique(new internal::ThreadSnapshotMac());
-    if (thread->Initialize(&process_reader_, process_reader_thread)) {
-      threads_.push_back(thread.release());
+  threads_.Reset(process_reader_threads.size());
+  for (size_t index = 0; index < process_reader_threads.size(); ++index) {
+    if (threads_.at(index)->Initialize(&process_reader_,
+                                       process_reader_threads[index])) {
+      threads_.Keep(index);
     }
   }
 }
 
 void ProcessSnapshotMac::InitializeModules() {
+  ScopedMemoryReadSite read_site(MemoryReadSite::kModules);
   const std::vector<ProcessReader::Module>& process_reader_modules =
       process_reader_.Modules();
   for (const ProcessReader::Module& process_reader_module :
@@ -37,11 +37,13 @@
 #include "snapshot/module_snapshot.h"
 #include "snapshot/process_snapshot.h"
 #include "snapshot/system_snapshot.h"
+#include "snapshot/system_snapshot_cache.h"
 #include "snapshot/thread_snapshot.h"
 #include "snapshot/unloaded_module_snapshot.h"
 #include "util/mach/mach_extensions.h"
 #include "util/misc/initialization_state_dcheck.h"
 #include "util/misc/uuid.h"
+#include "util/stdlib/object_array.h"
 #include "util/stdlib/pointer_container.h"
 
 namespace crashpad {
@@ -113,6 +115,16 @@ class ProcessSnapshotMac final : public ProcessSnapshot {
   //!     the process.
   void GetCrashpadOptions(CrashpadInfoClientOptions* options);
 
+  //! \brief Sets a cache of system facts to use.
+  //!
+  //! This method must be called before Initialize(). See
+  //! SystemSnapshotMac::SetCache().
+  //!
+  //! \param[in] cache The cache, which must outlive this object. Weak.
+  void SetSystemSnapshotCache(SystemSnapshotCache* cache) {
+    system_.SetCache(cache);
+  }
+
   // ProcessSnapshot:
 
   pid_t ProcessID() const override;
@@ -141,7 +153,9 @@ class ProcessSnapshotMac final : public ProcessSnapshot {
   void InitializeModules();
 
   internal::SystemSnapshotMac system_;
-  PointerVector<internal::ThreadSnapshotMac> threads_;
+  // A process may have thousands of threads, so their snapshots are allocated
+  // together.
+  ObjectArray<internal::ThreadSnapshotMac> threads_;
   PointerVector<internal::ModuleSnapshotMac> modules_;
   std::unique_ptr<internal::ExceptionSnapshotMac> exception_;
   ProcessReader process_reader_;
@@ -17,8 +17,10 @@
 #include <string.h>
 #include <uuid/uuid.h>
 
+#include <limits>
 #include <memory>
 
+#include "base/logging.h"
 #include "base/macros.h"
 #include "snapshot/mac/process_types/internal.h"
 #include "util/mach/task_memory.h"
@@ -211,8 +213,14 @@ inline void Assign<UInt64Array4, UInt32Array4>(UInt64Array4* destination,
                                           mach_vm_address_t address,          \
                                           size_t count,                       \
                                           struct_name<Traits>* specific) {    \
+    /* The entire array is read in a single operation, regardless of count.   \
+     * Only genericization proceeds element by element. */                    \
+    if (count > std::numeric_limits<size_t>::max() / sizeof(*specific)) {     \
+      LOG(ERROR) << "count " << count << " too large";                        \
+      return false;                                                           \
+    }                                                                         \
     return process_reader->Memory()->Read(                                    \
-        address, sizeof(struct_name<Traits>[count]), specific);               \
+        address, sizeof(*specific) * count, specific);                        \
   }                                                                           \
                                                                               \
   } /* namespace internal */                                                  \
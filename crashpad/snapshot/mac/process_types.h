@@ -86,7 +86,8 @@ DECLARE_PROCESS_TYPE_TRAITS_CLASS(Generic, 64)
                                                                                \
     /* Reads |count| objects from |process_reader| beginning at |address|, and \
      * genericizes the objects. The caller must provide storage for |count|    \
-     * objects in |generic|. */                                                \
+     * objects in |generic|. The objects are read from the process in a single \
+     * operation. */                                                           \
     static bool ReadArrayInto(ProcessReader* process_reader,                   \
                               mach_vm_address_t address,                       \
                               size_t count,                                    \
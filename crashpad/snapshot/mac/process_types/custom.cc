@@ -32,13 +32,17 @@ namespace internal {
 
 namespace {
 
+// |version_offset| is the offset of the version field within the structure,
+// which is usually its first field.
 template <typename T>
 bool ReadIntoVersioned(ProcessReader* process_reader,
                        mach_vm_address_t address,
-                       T* specific) {
+                       T* specific,
+                       size_t version_offset = 0) {
   TaskMemory* task_memory = process_reader->Memory();
-  if (!task_memory->Read(
-          address, sizeof(specific->version), &specific->version)) {
+  if (!task_memory->Read(address + version_offset,
+                         sizeof(specific->version),
+                         &specific->version)) {
     return false;
   }
 
@@ -125,6 +129,42 @@ bool crashreporter_annotations_t<Traits>::ReadInto(
   return ReadIntoVersioned(process_reader, address, specific);
 }
 
+// static
+template <typename Traits>
+size_t CrashpadInfo<Traits>::ExpectedSizeForVersion(
+    decltype(CrashpadInfo<Traits>::version) version) {
+  if (version >= 7) {
+    return sizeof(CrashpadInfo<Traits>);
+  }
+  if (version == 6) {
+    return offsetof(CrashpadInfo<Traits>, excluded_memory_ranges_count);
+  }
+  if (version == 5) {
+    return offsetof(CrashpadInfo<Traits>, capture_deadline_ms);
+  }
+  if (version == 4) {
+    return offsetof(CrashpadInfo<Traits>, module_table);
+  }
+  if (version == 3) {
+    return offsetof(CrashpadInfo<Traits>, ring_buffer_minidump_stream_head);
+  }
+  if (version == 2) {
+    return offsetof(CrashpadInfo<Traits>, thread_annotations);
+  }
+  return offsetof(CrashpadInfo<Traits>, annotations_list);
+}
+
+// static
+template <typename Traits>
+bool CrashpadInfo<Traits>::ReadInto(ProcessReader* process_reader,
+                                    mach_vm_address_t address,
+                                    CrashpadInfo<Traits>* specific) {
+  return ReadIntoVersioned(process_reader,
+                           address,
+                           specific,
+                           offsetof(CrashpadInfo<Traits>, version));
+}
+
 // Explicit template instantiation of the above.
 #define PROCESS_TYPE_FLAVOR_TRAITS(lp_bits)                                    \
   template size_t                                                              \
@@ -140,7 +180,13 @@ bool crashreporter_annotations_t<Traits>::ReadInto(
   template bool crashreporter_annotations_t<Traits##lp_bits>::ReadInto(        \
       ProcessReader*,                                                          \
       mach_vm_address_t,                                                       \
-      crashreporter_annotations_t<Traits##lp_bits>*);
+      crashreporter_annotations_t<Traits##lp_bits>*);                          \
+  template size_t CrashpadInfo<Traits##lp_bits>::ExpectedSizeForVersion(       \
+      decltype(CrashpadInfo<Traits##lp_bits>::version));                       \
+  template bool CrashpadInfo<Traits##lp_bits>::ReadInto(                       \
+      ProcessReader*,                                                          \
+      mach_vm_address_t,                                                       \
+      CrashpadInfo<Traits##lp_bits>*);
 
 #include "snapshot/mac/process_types/flavors.h"
 
@@ -94,6 +94,7 @@ SystemSnapshotMac::SystemSnapshotMac()
       os_version_build_(),
       process_reader_(nullptr),
       snapshot_time_(nullptr),
+      cache_(nullptr),
       os_version_major_(0),
       os_version_minor_(0),
       os_version_bugfix_(0),
@@ -111,6 +112,31 @@ void SystemSnapshotMac::Initialize(ProcessReader* process_reader,
   process_reader_ = process_reader;
   snapshot_time_ = snapshot_time;
 
+  SystemSnapshotCache::OSVersion os_version;
+  if (cache_ && cache_->LookupOSVersion(&os_version)) {
+    os_version_full_ = os_version.full;
+    os_version_build_ = os_version.build;
+    os_version_major_ = os_version.major;
+    os_version_minor_ = os_version.minor;
+    os_version_bugfix_ = os_version.bugfix;
+    os_server_ = os_version.server;
+  } else {
+    ReadOSVersion();
+    if (cache_) {
+      os_version.full = os_version_full_;
+      os_version.build = os_version_build_;
+      os_version.major = os_version_major_;
+      os_version.minor = os_version_minor_;
+      os_version.bugfix = os_version_bugfix_;
+      os_version.server = os_server_;
+      cache_->InsertOSVersion(os_version);
+    }
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+}
+
+void SystemSnapshotMac::ReadOSVersion() {
   // MacOSXVersion() logs its own warnings if it can’t figure anything out. It’s
   // not fatal if this happens. The default values are reasonable.
   std::string os_version_string;
@@ -140,8 +166,6 @@ void SystemSnapshotMac::Initialize(ProcessReader* process_reader,
   } else {
     os_version_full_ = uname_string;
   }
-
-  INITIALIZATION_STATE_SET_VALID(initialized_);
 }
 
 CPUArchitecture SystemSnapshotMac::GetCPUArchitecture() const {
@@ -320,6 +344,20 @@ std::string SystemSnapshotMac::OSVersionFull() const {
 std::string SystemSnapshotMac::MachineDescription() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
+  // The model and board are found in the I/O Registry, which is slow to
+  // search.
+  std::string machine_description;
+  if (cache_ && cache_->LookupMachineDescription(&machine_description)) {
+    return machine_description;
+  }
+  machine_description = ReadMachineDescription();
+  if (cache_) {
+    cache_->InsertMachineDescription(machine_description);
+  }
+  return machine_description;
+}
+
+std::string SystemSnapshotMac::ReadMachineDescription() const {
   std::string model;
   std::string board_id;
   MacModelAndBoard(&model, &board_id);
@@ -348,6 +386,15 @@ void SystemSnapshotMac::TimeZone(DaylightSavingTimeStatus* dst_status,
                                  std::string* daylight_name) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
+  if (cache_) {
+    cache_->TimeZone(*snapshot_time_,
+                     dst_status,
+                     standard_offset_seconds,
+                     daylight_offset_seconds,
+                     standard_name,
+                     daylight_name);
+    return;
+  }
   internal::TimeZone(*snapshot_time_,
                      dst_status,
                      standard_offset_seconds,
@@ -21,6 +21,7 @@
 
 #include "base/macros.h"
 #include "snapshot/system_snapshot.h"
+#include "snapshot/system_snapshot_cache.h"
 #include "util/misc/initialization_state_dcheck.h"
 
 namespace crashpad {
@@ -55,6 +56,13 @@ class SystemSnapshotMac final : public SystemSnapshot {
   //!     generated around the daylight saving transition time.
   void Initialize(ProcessReader* process_reader, const timeval* snapshot_time);
 
+  //! \brief Sets a cache of system facts to use, shared with other snapshots.
+  //!
+  //! This method must be called before Initialize().
+  //!
+  //! \param[in] cache The cache, which must outlive this object. Weak.
+  void SetCache(SystemSnapshotCache* cache) { cache_ = cache; }
+
   // SystemSnapshot:
 
   CPUArchitecture GetCPUArchitecture() const override;
@@ -81,10 +89,14 @@ class SystemSnapshotMac final : public SystemSnapshot {
                 std::string* daylight_name) const override;
 
  private:
+  void ReadOSVersion();
+  std::string ReadMachineDescription() const;
+
   std::string os_version_full_;
   std::string os_version_build_;
   ProcessReader* process_reader_;  // weak
   const timeval* snapshot_time_;  // weak
+  SystemSnapshotCache* cache_;  // weak
   int os_version_major_;
   int os_version_minor_;
   int os_version_bugfix_;
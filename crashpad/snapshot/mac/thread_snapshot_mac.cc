@@ -27,6 +27,7 @@ ThreadSnapshotMac::ThreadSnapshotMac()
       context_(),
       stack_(),
       thread_id_(0),
+      thread_name_(),
       thread_specific_data_address_(0),
       thread_(MACH_PORT_NULL),
       suspend_count_(0),
@@ -44,6 +45,7 @@ bool ThreadSnapshotMac::Initialize(
 
   thread_ = process_reader_thread.port;
   thread_id_ = process_reader_thread.id;
+  thread_name_ = process_reader_thread.name;
   suspend_count_ = process_reader_thread.suspend_count;
   priority_ = process_reader_thread.priority;
   thread_specific_data_address_ =
@@ -96,6 +98,11 @@ uint64_t ThreadSnapshotMac::ThreadID() const {
   return thread_id_;
 }
 
+std::string ThreadSnapshotMac::ThreadName() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return thread_name_;
+}
+
 int ThreadSnapshotMac::SuspendCount() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   return suspend_count_;
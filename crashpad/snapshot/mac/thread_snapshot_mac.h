@@ -18,6 +18,8 @@
 #include <mach/mach.h>
 #include <stdint.h>
 
+#include <string>
+
 #include "base/macros.h"
 #include "build/build_config.h"
 #include "snapshot/cpu_context.h"
@@ -56,6 +58,7 @@ class ThreadSnapshotMac final : public ThreadSnapshot {
   const CPUContext* Context() const override;
   const MemorySnapshot* Stack() const override;
   uint64_t ThreadID() const override;
+  std::string ThreadName() const override;
   int SuspendCount() const override;
   int Priority() const override;
   uint64_t ThreadSpecificDataAddress() const override;
@@ -71,6 +74,7 @@ class ThreadSnapshotMac final : public ThreadSnapshot {
   CPUContext context_;
   MemorySnapshotMac stack_;
   uint64_t thread_id_;
+  std::string thread_name_;
   uint64_t thread_specific_data_address_;
   thread_t thread_;
   int suspend_count_;
@@ -0,0 +1,45 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/memory_snapshot.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
+
+namespace crashpad {
+
+bool DetermineMergedRange(const MemorySnapshot* a,
+                          const MemorySnapshot* b,
+                          CheckedRange<uint64_t, size_t>* merged) {
+  const CheckedRange<uint64_t, size_t> range_a(a->Address(), a->Size());
+  const CheckedRange<uint64_t, size_t> range_b(b->Address(), b->Size());
+  if (!range_a.IsValid() || !range_b.IsValid()) {
+    LOG(ERROR) << "invalid range";
+    return false;
+  }
+
+  const uint64_t base = std::min(range_a.base(), range_b.base());
+  const uint64_t end = std::max(range_a.end(), range_b.end());
+  if (!base::IsValueInRangeForNumericType<size_t>(end - base)) {
+    LOG(ERROR) << "merged range too large";
+    return false;
+  }
+
+  merged->SetRange(base, static_cast<size_t>(end - base));
+  return true;
+}
+
+}  // namespace crashpad
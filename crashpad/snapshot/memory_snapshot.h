@@ -18,6 +18,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include "util/numeric/checked_range.h"
+
 namespace crashpad {
 
 //! \brief An abstract interface to a snapshot representing a region of memory
@@ -46,6 +48,24 @@ class MemorySnapshot {
     //! \return `true` on success, `false` on failure. MemoryDelegate::Read()
     //!     will use this as its own return value.
     virtual bool MemorySnapshotDelegateRead(void* data, size_t size) = 0;
+
+    //! \brief Called by MemorySnapshot::Read() to obtain a buffer that the
+    //!     memory snapshot’s data may be read directly into.
+    //!
+    //! Delegates that can provide storage for the data, such as one that
+    //! reuses a single buffer for many memory snapshots, may override this
+    //! method to avoid an intermediate allocation and copy in the snapshot
+    //! implementation. If a buffer is returned, the subsequent call to
+    //! MemorySnapshotDelegateRead() will receive it as its \a data argument.
+    //!
+    //! \param[in] size The size of the buffer required, which is the size of
+    //!     the memory snapshot.
+    //!
+    //! \return A pointer to at least \a size bytes of writable storage, owned
+    //!     by the delegate and valid until MemorySnapshotDelegateRead()
+    //!     returns, or `nullptr` if the snapshot implementation should provide
+    //!     its own storage. The default implementation returns `nullptr`.
+    virtual void* MemorySnapshotDelegateBuffer(size_t size) { return nullptr; }
   };
 
   virtual ~MemorySnapshot() {}
@@ -70,8 +90,36 @@ class MemorySnapshot {
   //!     Delegate::MemorySnapshotDelegateRead(), which should be `true` on
   //!     success and `false` on failure.
   virtual bool Read(Delegate* delegate) const = 0;
+
+  //! \brief Creates a new MemorySnapshot that spans this snapshot and
+  //!     \a other.
+  //!
+  //! The new snapshot covers the smallest address range containing both this
+  //! snapshot’s range and \a other’s range, including any gap between them.
+  //! Callers are responsible for only merging snapshots whose combined range
+  //! is expected to be readable, such as ranges that overlap or abut.
+  //!
+  //! \param[in] other The snapshot to merge with this one. It must be of the
+  //!     same concrete type as this snapshot and refer to the same process.
+  //!
+  //! \return A newly-allocated MemorySnapshot owned by the caller, or `nullptr`
+  //!     with a message logged if the snapshots could not be merged.
+  virtual const MemorySnapshot* MergeWithOtherSnapshot(
+      const MemorySnapshot* other) const = 0;
 };
 
+//! \brief Determines the address range spanned by two memory snapshots.
+//!
+//! \param[in] a The first snapshot.
+//! \param[in] b The second snapshot.
+//! \param[out] merged The smallest range containing both \a a and \a b.
+//!
+//! \return `true` on success. `false`, with a message logged, if the spanned
+//!     range cannot be represented.
+bool DetermineMergedRange(const MemorySnapshot* a,
+                          const MemorySnapshot* b,
+                          CheckedRange<uint64_t, size_t>* merged);
+
 }  // namespace crashpad
 
 #endif  // CRASHPAD_SNAPSHOT_MEMORY_SNAPSHOT_H_
@@ -0,0 +1,110 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/memory_snapshot.h"
+
+#include <stdint.h>
+
+#include <limits>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "snapshot/test/test_memory_snapshot.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(DetermineMergedRange, Overlapping) {
+  TestMemorySnapshot a;
+  a.SetAddress(0x1000);
+  a.SetSize(0x200);
+
+  TestMemorySnapshot b;
+  b.SetAddress(0x1100);
+  b.SetSize(0x200);
+
+  CheckedRange<uint64_t, size_t> merged(0, 0);
+  ASSERT_TRUE(DetermineMergedRange(&a, &b, &merged));
+  EXPECT_EQ(merged.base(), 0x1000u);
+  EXPECT_EQ(merged.size(), 0x300u);
+
+  ASSERT_TRUE(DetermineMergedRange(&b, &a, &merged));
+  EXPECT_EQ(merged.base(), 0x1000u);
+  EXPECT_EQ(merged.size(), 0x300u);
+}
+
+TEST(DetermineMergedRange, Contained) {
+  TestMemorySnapshot a;
+  a.SetAddress(0x1000);
+  a.SetSize(0x1000);
+
+  TestMemorySnapshot b;
+  b.SetAddress(0x1100);
+  b.SetSize(0x10);
+
+  CheckedRange<uint64_t, size_t> merged(0, 0);
+  ASSERT_TRUE(DetermineMergedRange(&a, &b, &merged));
+  EXPECT_EQ(merged.base(), 0x1000u);
+  EXPECT_EQ(merged.size(), 0x1000u);
+}
+
+TEST(DetermineMergedRange, Disjoint) {
+  TestMemorySnapshot a;
+  a.SetAddress(0x1000);
+  a.SetSize(0x10);
+
+  TestMemorySnapshot b;
+  b.SetAddress(0x2000);
+  b.SetSize(0x10);
+
+  CheckedRange<uint64_t, size_t> merged(0, 0);
+  ASSERT_TRUE(DetermineMergedRange(&a, &b, &merged));
+  EXPECT_EQ(merged.base(), 0x1000u);
+  EXPECT_EQ(merged.size(), 0x1010u);
+}
+
+TEST(DetermineMergedRange, Invalid) {
+  TestMemorySnapshot a;
+  a.SetAddress(std::numeric_limits<uint64_t>::max() - 0x10);
+  a.SetSize(0x100);
+
+  TestMemorySnapshot b;
+  b.SetAddress(0x1000);
+  b.SetSize(0x10);
+
+  CheckedRange<uint64_t, size_t> merged(0, 0);
+  EXPECT_FALSE(DetermineMergedRange(&a, &b, &merged));
+}
+
+TEST(MemorySnapshot, MergeWithOtherSnapshot) {
+  TestMemorySnapshot a;
+  a.SetAddress(0x1000);
+  a.SetSize(0x100);
+  a.SetValue('a');
+
+  TestMemorySnapshot b;
+  b.SetAddress(0x1100);
+  b.SetSize(0x100);
+  b.SetValue('b');
+
+  std::unique_ptr<const MemorySnapshot> merged(a.MergeWithOtherSnapshot(&b));
+  ASSERT_TRUE(merged);
+  EXPECT_EQ(merged->Address(), 0x1000u);
+  EXPECT_EQ(merged->Size(), 0x200u);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,118 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/minidump/exception_snapshot_minidump.h"
+
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace crashpad {
+namespace internal {
+
+ExceptionSnapshotMinidump::ExceptionSnapshotMinidump()
+    : ExceptionSnapshot(),
+      minidump_exception_stream_(),
+      context_(),
+      codes_(),
+      initialized_() {
+}
+
+ExceptionSnapshotMinidump::~ExceptionSnapshotMinidump() {
+}
+
+bool ExceptionSnapshotMinidump::Initialize(
+    FileReaderInterface* file_reader,
+    const MINIDUMP_LOCATION_DESCRIPTOR& location,
+    CPUArchitecture architecture) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  if (location.DataSize < sizeof(minidump_exception_stream_)) {
+    LOG(ERROR) << "exception size mismatch";
+    return false;
+  }
+
+  if (!file_reader->SeekSet(location.Rva)) {
+    return false;
+  }
+
+  if (!file_reader->ReadExactly(&minidump_exception_stream_,
+                                sizeof(minidump_exception_stream_))) {
+    return false;
+  }
+
+  const MINIDUMP_EXCEPTION& exception_record =
+      minidump_exception_stream_.ExceptionRecord;
+  if (exception_record.NumberParameters >
+      arraysize(exception_record.ExceptionInformation)) {
+    LOG(ERROR) << "exception parameter count "
+               << exception_record.NumberParameters << " out of range";
+    return false;
+  }
+
+  codes_.assign(exception_record.ExceptionInformation,
+                exception_record.ExceptionInformation +
+                    exception_record.NumberParameters);
+
+  if (!context_.Initialize(file_reader,
+                           architecture,
+                           minidump_exception_stream_.ThreadContext)) {
+    return false;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+const CPUContext* ExceptionSnapshotMinidump::Context() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return context_.Get();
+}
+
+uint64_t ExceptionSnapshotMinidump::ThreadID() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_exception_stream_.ThreadId;
+}
+
+uint32_t ExceptionSnapshotMinidump::Exception() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_exception_stream_.ExceptionRecord.ExceptionCode;
+}
+
+uint32_t ExceptionSnapshotMinidump::ExceptionInfo() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_exception_stream_.ExceptionRecord.ExceptionFlags;
+}
+
+uint64_t ExceptionSnapshotMinidump::ExceptionAddress() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_exception_stream_.ExceptionRecord.ExceptionAddress;
+}
+
+const std::vector<uint64_t>& ExceptionSnapshotMinidump::Codes() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return codes_;
+}
+
+std::vector<const MemorySnapshot*> ExceptionSnapshotMinidump::ExtraMemory()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Memory referenced from the exception is carried in the
+  // MINIDUMP_MEMORY_LIST stream alongside all other memory, and is available
+  // through ProcessSnapshotMinidump::ExtraMemory().
+  return std::vector<const MemorySnapshot*>();
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,34 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/minidump/memory_map_region_snapshot_minidump.h"
+
+namespace crashpad {
+namespace internal {
+
+MemoryMapRegionSnapshotMinidump::MemoryMapRegionSnapshotMinidump(
+    const MINIDUMP_MEMORY_INFO& memory_info)
+    : MemoryMapRegionSnapshot(), memory_info_(memory_info) {
+}
+
+MemoryMapRegionSnapshotMinidump::~MemoryMapRegionSnapshotMinidump() {
+}
+
+const MINIDUMP_MEMORY_INFO&
+MemoryMapRegionSnapshotMinidump::AsMinidumpMemoryInfo() const {
+  return memory_info_;
+}
+
+}  // namespace internal
+}  // namespace crashpad
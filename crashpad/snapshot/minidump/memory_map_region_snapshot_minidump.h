@@ -0,0 +1,48 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_MINIDUMP_MEMORY_MAP_REGION_SNAPSHOT_MINIDUMP_H_
+#define CRASHPAD_SNAPSHOT_MINIDUMP_MEMORY_MAP_REGION_SNAPSHOT_MINIDUMP_H_
+
+#include <windows.h>
+#include <dbghelp.h>
+
+#include "base/macros.h"
+#include "snapshot/memory_map_region_snapshot.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief A MemoryMapRegionSnapshot based on a MINIDUMP_MEMORY_INFO in a
+//!     minidump file.
+class MemoryMapRegionSnapshotMinidump final : public MemoryMapRegionSnapshot {
+ public:
+  explicit MemoryMapRegionSnapshotMinidump(
+      const MINIDUMP_MEMORY_INFO& memory_info);
+  ~MemoryMapRegionSnapshotMinidump() override;
+
+  // MemoryMapRegionSnapshot:
+
+  const MINIDUMP_MEMORY_INFO& AsMinidumpMemoryInfo() const override;
+
+ private:
+  MINIDUMP_MEMORY_INFO memory_info_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryMapRegionSnapshotMinidump);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_MINIDUMP_MEMORY_MAP_REGION_SNAPSHOT_MINIDUMP_H_
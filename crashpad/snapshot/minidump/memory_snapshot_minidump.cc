@@ -0,0 +1,153 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/minidump/memory_snapshot_minidump.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+
+#include "base/logging.h"
+#include "util/numeric/checked_range.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+namespace internal {
+
+MemorySnapshotMinidump::MemorySnapshotMinidump()
+    : MemorySnapshot(),
+      file_reader_(nullptr),
+      mapped_file_(nullptr),
+      address_(0),
+      size_(0),
+      rva_(0),
+      initialized_() {
+}
+
+MemorySnapshotMinidump::~MemorySnapshotMinidump() {
+}
+
+bool MemorySnapshotMinidump::Initialize(
+    FileReaderInterface* file_reader,
+    const MappedFileReader* mapped_file,
+    const MINIDUMP_MEMORY_DESCRIPTOR& memory_descriptor) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  file_reader_ = file_reader;
+  mapped_file_ = mapped_file;
+  address_ = memory_descriptor.StartOfMemoryRange;
+  size_ = memory_descriptor.Memory.DataSize;
+  rva_ = memory_descriptor.Memory.Rva;
+
+  // Validate the contents’ location up front when that’s cheap.
+  if (mapped_file_ && !mapped_file_->DataAt(rva_, size_)) {
+    return false;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+uint64_t MemorySnapshotMinidump::Address() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return address_;
+}
+
+size_t MemorySnapshotMinidump::Size() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return size_;
+}
+
+bool MemorySnapshotMinidump::Read(Delegate* delegate) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  if (size_ == 0) {
+    return delegate->MemorySnapshotDelegateRead(nullptr, size_);
+  }
+
+  if (mapped_file_) {
+    const void* data = mapped_file_->DataAt(rva_, size_);
+    if (!data) {
+      return false;
+    }
+
+    // The mapping is copy-on-write, so the delegate may modify the data
+    // without affecting the file or anyone else reading it.
+    return delegate->MemorySnapshotDelegateRead(const_cast<void*>(data),
+                                                size_);
+  }
+
+  if (!file_reader_->SeekSet(rva_)) {
+    return false;
+  }
+
+  std::unique_ptr<uint8_t[]> buffer;
+  void* data = delegate->MemorySnapshotDelegateBuffer(size_);
+  if (!data) {
+    buffer.reset(new uint8_t[size_]);
+    data = buffer.get();
+  }
+
+  if (!file_reader_->ReadExactly(data, size_)) {
+    return false;
+  }
+
+  return delegate->MemorySnapshotDelegateRead(data, size_);
+}
+
+const MemorySnapshot* MemorySnapshotMinidump::MergeWithOtherSnapshot(
+    const MemorySnapshot* other) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  const MemorySnapshotMinidump* other_minidump =
+      static_cast<const MemorySnapshotMinidump*>(other);
+  DCHECK_EQ(other_minidump->file_reader_, file_reader_);
+
+  const MemorySnapshotMinidump* low = this;
+  const MemorySnapshotMinidump* high = other_minidump;
+  if (high->address_ < low->address_) {
+    std::swap(low, high);
+  }
+
+  // The merged range’s contents can only be read from the file if both
+  // ranges’ contents are laid out in the file as they were in memory.
+  if (high->rva_ < low->rva_ ||
+      high->rva_ - low->rva_ != high->address_ - low->address_) {
+    LOG(WARNING) << "can't merge memory ranges not contiguous in file";
+    return nullptr;
+  }
+
+  CheckedRange<uint64_t, size_t> merged(0, 0);
+  if (!DetermineMergedRange(this, other, &merged)) {
+    return nullptr;
+  }
+
+  MINIDUMP_MEMORY_DESCRIPTOR memory_descriptor = {};
+  memory_descriptor.StartOfMemoryRange = merged.base();
+  memory_descriptor.Memory.Rva = low->rva_;
+  if (!AssignIfInRange(&memory_descriptor.Memory.DataSize, merged.size())) {
+    LOG(ERROR) << "merged size " << merged.size() << " out of range";
+    return nullptr;
+  }
+
+  std::unique_ptr<MemorySnapshotMinidump> result(new MemorySnapshotMinidump());
+  if (!result->Initialize(file_reader_, mapped_file_, memory_descriptor)) {
+    return nullptr;
+  }
+  return result.release();
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,89 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_MINIDUMP_MEMORY_SNAPSHOT_MINIDUMP_H_
+#define CRASHPAD_SNAPSHOT_MINIDUMP_MEMORY_SNAPSHOT_MINIDUMP_H_
+
+#include <windows.h>
+#include <dbghelp.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "base/macros.h"
+#include "snapshot/memory_snapshot.h"
+#include "util/file/file_reader.h"
+#include "util/file/mapped_file_reader.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief A MemorySnapshot based on a memory range in a minidump file.
+class MemorySnapshotMinidump final : public MemorySnapshot {
+ public:
+  MemorySnapshotMinidump();
+  ~MemorySnapshotMinidump() override;
+
+  //! \brief Initializes the object.
+  //!
+  //! \param[in] file_reader A file reader corresponding to a minidump file.
+  //!     The file reader must support seeking.
+  //! \param[in] mapped_file If the minidump file is accessible through a
+  //!     mapping, the mapping, which is then used in preference to \a
+  //!     file_reader. Read() will pass the delegate a pointer into the
+  //!     mapping without copying the memory’s contents. May be `nullptr`.
+  //! \param[in] memory_descriptor The MINIDUMP_MEMORY_DESCRIPTOR describing
+  //!     the memory range and the location of its contents in the file.
+  //!
+  //! \return `true` if the snapshot could be created, `false` otherwise with
+  //!     an appropriate message logged.
+  bool Initialize(FileReaderInterface* file_reader,
+                  const MappedFileReader* mapped_file,
+                  const MINIDUMP_MEMORY_DESCRIPTOR& memory_descriptor);
+
+  // MemorySnapshot:
+
+  uint64_t Address() const override;
+  size_t Size() const override;
+
+  //! \copydoc MemorySnapshot::Read()
+  //!
+  //! When this object was initialized without a \a mapped_file, this seeks
+  //! and reads through the file reader, and must not be called concurrently
+  //! with any other use of the file reader.
+  bool Read(Delegate* delegate) const override;
+
+  //! \copydoc MemorySnapshot::MergeWithOtherSnapshot()
+  //!
+  //! Merging is possible only where the two memory ranges’ contents appear in
+  //! the minidump file at the same distance from each other as the ranges
+  //! themselves have in the snapshot process’ address space.
+  const MemorySnapshot* MergeWithOtherSnapshot(
+      const MemorySnapshot* other) const override;
+
+ private:
+  FileReaderInterface* file_reader_;  // weak
+  const MappedFileReader* mapped_file_;  // weak
+  uint64_t address_;
+  size_t size_;
+  RVA rva_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemorySnapshotMinidump);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_MINIDUMP_MEMORY_SNAPSHOT_MINIDUMP_H_
@@ -0,0 +1,223 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/minidump/minidump_context_converter.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "base/logging.h"
+#include "minidump/minidump_context.h"
+
+namespace crashpad {
+namespace internal {
+
+namespace {
+
+bool HasContextPart(uint32_t context_flags, uint32_t bits) {
+  return (context_flags & bits) == bits;
+}
+
+void InitializeX86Context(const MinidumpContextX86& context,
+                          CPUContextX86* out) {
+  memset(out, 0, sizeof(*out));
+
+  if (HasContextPart(context.context_flags, kMinidumpContextX86Control)) {
+    out->ebp = context.ebp;
+    out->eip = context.eip;
+    out->cs = static_cast<uint16_t>(context.cs);
+    out->eflags = context.eflags;
+    out->esp = context.esp;
+    out->ss = static_cast<uint16_t>(context.ss);
+  }
+
+  if (HasContextPart(context.context_flags, kMinidumpContextX86Integer)) {
+    out->eax = context.eax;
+    out->ebx = context.ebx;
+    out->ecx = context.ecx;
+    out->edx = context.edx;
+    out->edi = context.edi;
+    out->esi = context.esi;
+  }
+
+  if (HasContextPart(context.context_flags, kMinidumpContextX86Segment)) {
+    out->ds = static_cast<uint16_t>(context.ds);
+    out->es = static_cast<uint16_t>(context.es);
+    out->fs = static_cast<uint16_t>(context.fs);
+    out->gs = static_cast<uint16_t>(context.gs);
+  }
+
+  if (HasContextPart(context.context_flags, kMinidumpContextX86Debug)) {
+    out->dr0 = context.dr0;
+    out->dr1 = context.dr1;
+    out->dr2 = context.dr2;
+    out->dr3 = context.dr3;
+
+    // DR4 and DR5 are obsolete synonyms for DR6 and DR7, and aren’t carried in
+    // the minidump file.
+    out->dr4 = context.dr6;
+    out->dr5 = context.dr7;
+
+    out->dr6 = context.dr6;
+    out->dr7 = context.dr7;
+  }
+
+  if (HasContextPart(context.context_flags, kMinidumpContextX86Extended)) {
+    out->fxsave = context.fxsave;
+  } else if (HasContextPart(context.context_flags,
+                            kMinidumpContextX86FloatingPoint)) {
+    CPUContextX86::FsaveToFxsave(context.fsave, &out->fxsave);
+  }
+}
+
+void InitializeAMD64Context(const MinidumpContextAMD64& context,
+                            CPUContextX86_64* out) {
+  memset(out, 0, sizeof(*out));
+
+  if (HasContextPart(context.context_flags, kMinidumpContextAMD64Control)) {
+    out->cs = context.cs;
+    out->rflags = context.eflags;
+    out->rip = context.rip;
+    out->rsp = context.rsp;
+  }
+
+  if (HasContextPart(context.context_flags, kMinidumpContextAMD64Integer)) {
+    out->rax = context.rax;
+    out->rbx = context.rbx;
+    out->rcx = context.rcx;
+    out->rdx = context.rdx;
+    out->rdi = context.rdi;
+    out->rsi = context.rsi;
+    out->rbp = context.rbp;
+    out->r8 = context.r8;
+    out->r9 = context.r9;
+    out->r10 = context.r10;
+    out->r11 = context.r11;
+    out->r12 = context.r12;
+    out->r13 = context.r13;
+    out->r14 = context.r14;
+    out->r15 = context.r15;
+  }
+
+  if (HasContextPart(context.context_flags, kMinidumpContextAMD64Segment)) {
+    out->fs = context.fs;
+    out->gs = context.gs;
+  }
+
+  if (HasContextPart(context.context_flags, kMinidumpContextAMD64Debug)) {
+    out->dr0 = context.dr0;
+    out->dr1 = context.dr1;
+    out->dr2 = context.dr2;
+    out->dr3 = context.dr3;
+
+    // DR4 and DR5 are obsolete synonyms for DR6 and DR7, and aren’t carried in
+    // the minidump file.
+    out->dr4 = context.dr6;
+    out->dr5 = context.dr7;
+
+    out->dr6 = context.dr6;
+    out->dr7 = context.dr7;
+  }
+
+  if (HasContextPart(context.context_flags,
+                     kMinidumpContextAMD64FloatingPoint)) {
+    out->fxsave = context.fxsave;
+  }
+}
+
+// Reads a context structure of type T from |location| in |file_reader|, and
+// verifies that it is identified by |architecture_flag|.
+template <typename T>
+bool ReadContext(FileReaderInterface* file_reader,
+                 const MINIDUMP_LOCATION_DESCRIPTOR& location,
+                 uint32_t architecture_flag,
+                 T* context) {
+  if (location.DataSize < sizeof(*context)) {
+    LOG(ERROR) << "context size mismatch";
+    return false;
+  }
+
+  if (!file_reader->SeekSet(location.Rva)) {
+    return false;
+  }
+
+  if (!file_reader->ReadExactly(context, sizeof(*context))) {
+    return false;
+  }
+
+  if (!HasContextPart(context->context_flags, architecture_flag)) {
+    LOG(ERROR) << "context architecture mismatch";
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+MinidumpContextConverter::MinidumpContextConverter()
+    : context_union_(), context_(), initialized_() {
+  context_.architecture = kCPUArchitectureUnknown;
+}
+
+MinidumpContextConverter::~MinidumpContextConverter() {
+}
+
+bool MinidumpContextConverter::Initialize(
+    FileReaderInterface* file_reader,
+    CPUArchitecture architecture,
+    const MINIDUMP_LOCATION_DESCRIPTOR& location) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  switch (architecture) {
+    case kCPUArchitectureX86: {
+      MinidumpContextX86 context;
+      if (!ReadContext(file_reader, location, kMinidumpContextX86, &context)) {
+        return false;
+      }
+      InitializeX86Context(context, &context_union_.x86);
+      context_.x86 = &context_union_.x86;
+      break;
+    }
+
+    case kCPUArchitectureX86_64: {
+      MinidumpContextAMD64 context;
+      if (!ReadContext(
+              file_reader, location, kMinidumpContextAMD64, &context)) {
+        return false;
+      }
+      InitializeAMD64Context(context, &context_union_.x86_64);
+      context_.x86_64 = &context_union_.x86_64;
+      break;
+    }
+
+    default: {
+      LOG(ERROR) << "unknown context architecture " << architecture;
+      return false;
+    }
+  }
+
+  context_.architecture = architecture;
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+const CPUContext* MinidumpContextConverter::Get() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return &context_;
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,71 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_MINIDUMP_MINIDUMP_CONTEXT_CONVERTER_H_
+#define CRASHPAD_SNAPSHOT_MINIDUMP_MINIDUMP_CONTEXT_CONVERTER_H_
+
+#include <windows.h>
+#include <dbghelp.h>
+
+#include "base/macros.h"
+#include "snapshot/cpu_architecture.h"
+#include "snapshot/cpu_context.h"
+#include "util/file/file_reader.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief Reads a CPU context from a minidump file and presents it as a
+//!     CPUContext.
+class MinidumpContextConverter {
+ public:
+  MinidumpContextConverter();
+  ~MinidumpContextConverter();
+
+  //! \brief Initializes the object.
+  //!
+  //! \param[in] file_reader A file reader corresponding to a minidump file.
+  //!     The file reader must support seeking.
+  //! \param[in] architecture The CPU architecture of the minidump file, which
+  //!     determines the layout of the context structure.
+  //! \param[in] location The location of the context structure, a
+  //!     MinidumpContextX86 or MinidumpContextAMD64, in the minidump file.
+  //!
+  //! \return `true` if the context could be read, `false` otherwise with an
+  //!     appropriate message logged.
+  bool Initialize(FileReaderInterface* file_reader,
+                  CPUArchitecture architecture,
+                  const MINIDUMP_LOCATION_DESCRIPTOR& location);
+
+  //! \brief Returns the converted context.
+  //!
+  //! The returned object is scoped to the lifetime of this object.
+  const CPUContext* Get() const;
+
+ private:
+  union {
+    CPUContextX86 x86;
+    CPUContextX86_64 x86_64;
+  } context_union_;
+  CPUContext context_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpContextConverter);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_MINIDUMP_MINIDUMP_CONTEXT_CONVERTER_H_
@@ -0,0 +1,127 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/minidump/minidump_stream_index_reader.h"
+
+#include <string.h>
+
+#include <memory>
+
+#include "base/logging.h"
+#include "util/misc/xxhash.h"
+
+namespace crashpad {
+namespace internal {
+
+bool ReadMinidumpStreamIndex(
+    FileReaderInterface* file_reader,
+    std::vector<MinidumpCrashpadStreamIndexEntry>* entries) {
+  entries->clear();
+
+  const FileOffset file_size = file_reader->Seek(0, SEEK_END);
+  if (file_size < 0) {
+    return false;
+  }
+
+  MinidumpCrashpadStreamIndexFooter footer;
+  const FileOffset footer_offset = file_size - sizeof(footer);
+  if (footer_offset < 0) {
+    return true;
+  }
+
+  if (!file_reader->SeekSet(footer_offset) ||
+      !file_reader->ReadExactly(&footer, sizeof(footer))) {
+    return false;
+  }
+
+  if (footer.signature != MinidumpCrashpadStreamIndexFooter::kSignature) {
+    return true;
+  }
+
+  if (footer.version == 0) {
+    LOG(ERROR) << "stream_index version mismatch";
+    return false;
+  }
+
+  const uint64_t index_size =
+      static_cast<uint64_t>(footer.count) * footer.size_of_entry;
+  if (footer.size_of_entry < sizeof(MinidumpCrashpadStreamIndexEntry) ||
+      footer.index > static_cast<uint64_t>(footer_offset) ||
+      index_size > static_cast<uint64_t>(footer_offset) - footer.index) {
+    LOG(ERROR) << "stream_index size mismatch";
+    return false;
+  }
+
+  if (footer.count == 0) {
+    return true;
+  }
+
+  // The index lies within the file, so its size fits in a FileOffset, and
+  // therefore in a size_t.
+  const size_t local_index_size = static_cast<size_t>(index_size);
+  std::unique_ptr<uint8_t[]> index(new uint8_t[local_index_size]);
+  if (!file_reader->SeekSet(footer.index) ||
+      !file_reader->ReadExactly(index.get(), local_index_size)) {
+    return false;
+  }
+
+  if (XXHash64(index.get(), local_index_size, 0) != footer.index_xxhash64) {
+    LOG(ERROR) << "stream_index hash mismatch";
+    return false;
+  }
+
+  // Entries may be larger than MinidumpCrashpadStreamIndexEntry, in which case
+  // the excess in each is ignored.
+  std::vector<MinidumpCrashpadStreamIndexEntry> local_entries(footer.count);
+  for (size_t index_entry = 0; index_entry < local_entries.size();
+       ++index_entry) {
+    memcpy(&local_entries[index_entry],
+           &index[index_entry * footer.size_of_entry],
+           sizeof(local_entries[index_entry]));
+  }
+
+  entries->swap(local_entries);
+  return true;
+}
+
+bool VerifyMinidumpStream(FileReaderInterface* file_reader,
+                          const MinidumpCrashpadStreamIndexEntry& entry) {
+  const FileOffset file_size = file_reader->Seek(0, SEEK_END);
+  if (file_size < 0) {
+    return false;
+  }
+
+  if (entry.offset > static_cast<uint64_t>(file_size) ||
+      entry.size > static_cast<uint64_t>(file_size) - entry.offset) {
+    LOG(ERROR) << "stream size mismatch for type " << entry.stream_type;
+    return false;
+  }
+
+  const size_t size = static_cast<size_t>(entry.size);
+  std::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+  if (size && (!file_reader->SeekSet(entry.offset) ||
+               !file_reader->ReadExactly(data.get(), size))) {
+    return false;
+  }
+
+  if (XXHash64(data.get(), size, 0) != entry.xxhash64) {
+    LOG(ERROR) << "stream hash mismatch for type " << entry.stream_type;
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,57 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_MINIDUMP_MINIDUMP_STREAM_INDEX_READER_H_
+#define CRASHPAD_SNAPSHOT_MINIDUMP_MINIDUMP_STREAM_INDEX_READER_H_
+
+#include <vector>
+
+#include "minidump/minidump_extensions.h"
+#include "util/file/file_reader.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief Reads the stream index from the end of a minidump file, if it has
+//!     one.
+//!
+//! \param[in] file_reader The minidump file, which must begin at offset `0`
+//!     and end where the file does.
+//! \param[out] entries The index’s entries, in the order of the stream
+//!     directory. Empty if the file doesn’t end with a
+//!     MinidumpCrashpadStreamIndexFooter.
+//!
+//! \return `true` on success, including when the file has no stream index.
+//!     `false` if the file ends with a footer that doesn’t locate a valid
+//!     index, with a message logged.
+bool ReadMinidumpStreamIndex(
+    FileReaderInterface* file_reader,
+    std::vector<MinidumpCrashpadStreamIndexEntry>* entries);
+
+//! \brief Determines whether a stream’s data matches the hash recorded for it
+//!     in a stream index.
+//!
+//! \param[in] file_reader The minidump file, which must begin at offset `0`.
+//! \param[in] entry The stream’s entry in the index, as read by
+//!     ReadMinidumpStreamIndex().
+//!
+//! \return `true` if the stream’s data matches. `false` otherwise, with a
+//!     message logged.
+bool VerifyMinidumpStream(FileReaderInterface* file_reader,
+                          const MinidumpCrashpadStreamIndexEntry& entry);
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_MINIDUMP_MINIDUMP_STREAM_INDEX_READER_H_
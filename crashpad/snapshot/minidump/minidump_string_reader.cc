@@ -17,7 +17,9 @@
 #include <stdint.h>
 
 #include "base/logging.h"
+#include "base/strings/string16.h"
 #include "minidump/minidump_extensions.h"
+#include "util/string/utf_conversion.h"
 
 namespace crashpad {
 namespace internal {
@@ -48,5 +50,41 @@ bool ReadMinidumpUTF8String(FileReaderInterface* file_reader,
   return true;
 }
 
+bool ReadMinidumpUTF16String(FileReaderInterface* file_reader,
+                             RVA rva,
+                             std::string* string) {
+  if (rva == 0) {
+    string->clear();
+    return true;
+  }
+
+  if (!file_reader->SeekSet(rva)) {
+    return false;
+  }
+
+  uint32_t string_size;
+  if (!file_reader->ReadExactly(&string_size, sizeof(string_size))) {
+    return false;
+  }
+
+  if (string_size % sizeof(base::char16) != 0) {
+    LOG(ERROR) << "string size " << string_size << " not UTF-16";
+    return false;
+  }
+
+  base::string16 string_utf16(string_size / sizeof(base::char16), 0);
+  if (string_size &&
+      !file_reader->ReadExactly(&string_utf16[0], string_size)) {
+    return false;
+  }
+
+  if (!TranscodeUTF16ToUTF8(string_utf16.data(), string_utf16.size(), string)) {
+    LOG(ERROR) << "string not UTF-16";
+    return false;
+  }
+
+  return true;
+}
+
 }  // namespace internal
 }  // namespace crashpad
@@ -34,6 +34,15 @@ bool ReadMinidumpUTF8String(FileReaderInterface* file_reader,
                             RVA rva,
                             std::string* string);
 
+//! \brief Reads a MINIDUMP_STRING from a minidump file at offset \a rva in \a
+//!     file_reader, and returns it in \a string, converted to UTF-8.
+//!
+//! \return `true` on success, with \a string set. `false` on failure, with a
+//!     message logged.
+bool ReadMinidumpUTF16String(FileReaderInterface* file_reader,
+                             RVA rva,
+                             std::string* string);
+
 }  // namespace internal
 }  // namespace crashpad
 
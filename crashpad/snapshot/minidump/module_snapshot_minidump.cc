@@ -14,9 +14,18 @@
 
 #include "snapshot/minidump/module_snapshot_minidump.h"
 
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+
 #include "minidump/minidump_extensions.h"
+#include "snapshot/minidump/minidump_annotation_reader.h"
 #include "snapshot/minidump/minidump_simple_string_dictionary_reader.h"
 #include "snapshot/minidump/minidump_string_list_reader.h"
+#include "snapshot/minidump/minidump_string_reader.h"
+#include "util/misc/pdb_structures.h"
 
 namespace crashpad {
 namespace internal {
@@ -24,8 +33,13 @@ namespace internal {
 ModuleSnapshotMinidump::ModuleSnapshotMinidump()
     : ModuleSnapshot(),
       minidump_module_(),
+      name_(),
+      uuid_(),
+      age_(0),
+      debug_file_name_(),
       annotations_vector_(),
       annotations_simple_map_(),
+      annotation_objects_(),
       initialized_() {
 }
 
@@ -47,6 +61,15 @@ bool ModuleSnapshotMinidump::Initialize(
     return false;
   }
 
+  if (!ReadMinidumpUTF16String(
+          file_reader, minidump_module_.ModuleNameRva, &name_)) {
+    return false;
+  }
+
+  if (!InitializeCodeViewRecord(file_reader)) {
+    return false;
+  }
+
   if (!InitializeModuleCrashpadInfo(file_reader,
                                     minidump_module_crashpad_info_location)) {
     return false;
@@ -58,26 +81,22 @@ bool ModuleSnapshotMinidump::Initialize(
 
 std::string ModuleSnapshotMinidump::Name() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return std::string();
+  return name_;
 }
 
 uint64_t ModuleSnapshotMinidump::Address() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return 0;
+  return minidump_module_.BaseOfImage;
 }
 
 uint64_t ModuleSnapshotMinidump::Size() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return 0;
+  return minidump_module_.SizeOfImage;
 }
 
 time_t ModuleSnapshotMinidump::Timestamp() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return 0;
+  return minidump_module_.TimeDateStamp;
 }
 
 void ModuleSnapshotMinidump::FileVersion(uint16_t* version_0,
@@ -85,11 +104,10 @@ void ModuleSnapshotMinidump::FileVersion(uint16_t* version_0,
                                          uint16_t* version_2,
                                          uint16_t* version_3) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  *version_0 = 0;
-  *version_1 = 0;
-  *version_2 = 0;
-  *version_3 = 0;
+  *version_0 = minidump_module_.VersionInfo.dwFileVersionMS >> 16;
+  *version_1 = minidump_module_.VersionInfo.dwFileVersionMS & 0xffff;
+  *version_2 = minidump_module_.VersionInfo.dwFileVersionLS >> 16;
+  *version_3 = minidump_module_.VersionInfo.dwFileVersionLS & 0xffff;
 }
 
 void ModuleSnapshotMinidump::SourceVersion(uint16_t* version_0,
@@ -97,31 +115,34 @@ void ModuleSnapshotMinidump::SourceVersion(uint16_t* version_0,
                                            uint16_t* version_2,
                                            uint16_t* version_3) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  *version_0 = 0;
-  *version_1 = 0;
-  *version_2 = 0;
-  *version_3 = 0;
+  *version_0 = minidump_module_.VersionInfo.dwProductVersionMS >> 16;
+  *version_1 = minidump_module_.VersionInfo.dwProductVersionMS & 0xffff;
+  *version_2 = minidump_module_.VersionInfo.dwProductVersionLS >> 16;
+  *version_3 = minidump_module_.VersionInfo.dwProductVersionLS & 0xffff;
 }
 
 ModuleSnapshot::ModuleType ModuleSnapshotMinidump::GetModuleType() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return kModuleTypeUnknown;
+  switch (minidump_module_.VersionInfo.dwFileType) {
+    case VFT_APP:
+      return kModuleTypeExecutable;
+    case VFT_DLL:
+      return kModuleTypeSharedLibrary;
+    default:
+      return kModuleTypeUnknown;
+  }
 }
 
 void ModuleSnapshotMinidump::UUIDAndAge(crashpad::UUID* uuid,
                                         uint32_t* age) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  *uuid = crashpad::UUID();
-  *age = 0;
+  *uuid = uuid_;
+  *age = age_;
 }
 
 std::string ModuleSnapshotMinidump::DebugFileName() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return std::string();
+  return debug_file_name_;
 }
 
 std::vector<std::string> ModuleSnapshotMinidump::AnnotationsVector() const {
@@ -135,20 +156,80 @@ ModuleSnapshotMinidump::AnnotationsSimpleMap() const {
   return annotations_simple_map_;
 }
 
+std::vector<AnnotationSnapshot> ModuleSnapshotMinidump::AnnotationObjects()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return annotation_objects_;
+}
+
+std::map<uint64_t, std::vector<AnnotationSnapshot>>
+ModuleSnapshotMinidump::ThreadAnnotationObjects() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Thread annotations are carried in the
+  // kMinidumpStreamTypeCrashpadThreadAnnotations stream, keyed by minidump
+  // thread ID rather than by module, and are not yet read.
+  return std::map<uint64_t, std::vector<AnnotationSnapshot>>();
+}
+
 std::set<CheckedRange<uint64_t>> ModuleSnapshotMinidump::ExtraMemoryRanges()
     const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
+
+  // Memory referenced from the module is carried in the MINIDUMP_MEMORY_LIST
+  // stream alongside all other memory, and is available through
+  // ProcessSnapshotMinidump::ExtraMemory().
   return std::set<CheckedRange<uint64_t>>();
 }
 
 std::vector<const UserMinidumpStream*>
 ModuleSnapshotMinidump::CustomMinidumpStreams() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
+
+  // Streams contributed by a module aren’t associated with it in the minidump
+  // file.
   return std::vector<const UserMinidumpStream*>();
 }
 
+bool ModuleSnapshotMinidump::InitializeCodeViewRecord(
+    FileReaderInterface* file_reader) {
+  const MINIDUMP_LOCATION_DESCRIPTOR& location = minidump_module_.CvRecord;
+  if (location.Rva == 0 || location.DataSize == 0) {
+    return true;
+  }
+
+  // Only CodeViewRecordPDB70 records carry a UUID. Other record types are
+  // ignored.
+  constexpr size_t kHeaderSize = offsetof(CodeViewRecordPDB70, pdb_name);
+  if (location.DataSize < kHeaderSize) {
+    return true;
+  }
+
+  if (!file_reader->SeekSet(location.Rva)) {
+    return false;
+  }
+
+  std::unique_ptr<char[]> record(new char[location.DataSize]);
+  if (!file_reader->ReadExactly(record.get(), location.DataSize)) {
+    return false;
+  }
+
+  CodeViewRecordPDB70 codeview_record;
+  memcpy(&codeview_record, record.get(), kHeaderSize);
+  if (codeview_record.signature != CodeViewRecordPDB70::kSignature) {
+    return true;
+  }
+
+  uuid_ = codeview_record.uuid;
+  age_ = codeview_record.age;
+
+  // The name is NUL-terminated within the record.
+  const char* pdb_name = record.get() + kHeaderSize;
+  debug_file_name_.assign(
+      pdb_name, strnlen(pdb_name, location.DataSize - kHeaderSize));
+  return true;
+}
+
 bool ModuleSnapshotMinidump::InitializeModuleCrashpadInfo(
     FileReaderInterface* file_reader,
     const MINIDUMP_LOCATION_DESCRIPTOR*
@@ -158,9 +239,12 @@ bool ModuleSnapshotMinidump::InitializeModuleCrashpadInfo(
     return true;
   }
 
-  MinidumpModuleCrashpadInfo minidump_module_crashpad_info;
-  if (minidump_module_crashpad_info_location->DataSize <
-          sizeof(minidump_module_crashpad_info)) {
+  // Version 1 structures end before annotation_objects. They are accepted,
+  // and carry no annotation objects.
+  constexpr size_t kVersion1Size =
+      offsetof(MinidumpModuleCrashpadInfo, annotation_objects);
+  MinidumpModuleCrashpadInfo minidump_module_crashpad_info = {};
+  if (minidump_module_crashpad_info_location->DataSize < kVersion1Size) {
     LOG(ERROR) << "minidump_module_crashpad_info size mismatch";
     return false;
   }
@@ -169,27 +253,42 @@ bool ModuleSnapshotMinidump::InitializeModuleCrashpadInfo(
     return false;
   }
 
-  if (!file_reader->ReadExactly(&minidump_module_crashpad_info,
-                                sizeof(minidump_module_crashpad_info))) {
+  size_t read_size =
+      std::min(static_cast<size_t>(
+                   minidump_module_crashpad_info_location->DataSize),
+               sizeof(minidump_module_crashpad_info));
+  if (!file_reader->ReadExactly(&minidump_module_crashpad_info, read_size)) {
     return false;
   }
 
-  if (minidump_module_crashpad_info.version !=
-          MinidumpModuleCrashpadInfo::kVersion) {
+  // Later versions are layout-compatible with this one.
+  if (minidump_module_crashpad_info.version < 1) {
     LOG(ERROR) << "minidump_module_crashpad_info version mismatch";
     return false;
   }
 
+  if (minidump_module_crashpad_info.version < 2 ||
+      read_size < sizeof(minidump_module_crashpad_info)) {
+    minidump_module_crashpad_info.annotation_objects = {};
+  }
+
   if (!ReadMinidumpStringList(file_reader,
                               minidump_module_crashpad_info.list_annotations,
                               &annotations_vector_)) {
     return false;
   }
 
-  return ReadMinidumpSimpleStringDictionary(
+  if (!ReadMinidumpSimpleStringDictionary(
+          file_reader,
+          minidump_module_crashpad_info.simple_annotations,
+          &annotations_simple_map_)) {
+    return false;
+  }
+
+  return ReadMinidumpAnnotationList(
       file_reader,
-      minidump_module_crashpad_info.simple_annotations,
-      &annotations_simple_map_);
+      minidump_module_crashpad_info.annotation_objects,
+      &annotation_objects_);
 }
 
 }  // namespace internal
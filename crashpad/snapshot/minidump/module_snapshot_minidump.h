@@ -28,6 +28,7 @@
 #include "snapshot/module_snapshot.h"
 #include "util/file/file_reader.h"
 #include "util/misc/initialization_state_dcheck.h"
+#include "util/misc/uuid.h"
 
 namespace crashpad {
 namespace internal {
@@ -76,6 +77,9 @@ class ModuleSnapshotMinidump final : public ModuleSnapshot {
   std::string DebugFileName() const override;
   std::vector<std::string> AnnotationsVector() const override;
   std::map<std::string, std::string> AnnotationsSimpleMap() const override;
+  std::vector<AnnotationSnapshot> AnnotationObjects() const override;
+  std::map<uint64_t, std::vector<AnnotationSnapshot>> ThreadAnnotationObjects()
+      const override;
   std::set<CheckedRange<uint64_t>> ExtraMemoryRanges() const override;
   std::vector<const UserMinidumpStream*> CustomMinidumpStreams() const override;
 
@@ -86,9 +90,18 @@ class ModuleSnapshotMinidump final : public ModuleSnapshot {
                                     const MINIDUMP_LOCATION_DESCRIPTOR*
                                         minidump_module_crashpad_info_location);
 
+  // Initializes data carried in the module’s CodeView record on behalf of
+  // Initialize().
+  bool InitializeCodeViewRecord(FileReaderInterface* file_reader);
+
   MINIDUMP_MODULE minidump_module_;
+  std::string name_;
+  crashpad::UUID uuid_;
+  uint32_t age_;
+  std::string debug_file_name_;
   std::vector<std::string> annotations_vector_;
   std::map<std::string, std::string> annotations_simple_map_;
+  std::vector<AnnotationSnapshot> annotation_objects_;
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(ModuleSnapshotMinidump);
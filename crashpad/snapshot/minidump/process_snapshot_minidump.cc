@@ -14,25 +14,118 @@
 
 #include "snapshot/minidump/process_snapshot_minidump.h"
 
+#include <algorithm>
 #include <memory>
+#include <set>
 #include <utility>
 
 #include "base/memory/ptr_util.h"
 #include "snapshot/minidump/minidump_simple_string_dictionary_reader.h"
+#include "snapshot/minidump/minidump_stream_index_reader.h"
+#include "snapshot/minidump/minidump_string_reader.h"
+#include "util/file/block_compressed_file_reader.h"
 #include "util/file/file_io.h"
 
 namespace crashpad {
 
+namespace {
+
+// Reads the entries of a list stream whose header, of at least |header_size|
+// bytes, declares its own size, the size of each entry, and the number of
+// entries. The entries may be larger than Entry, in which case the excess in
+// each is ignored. |name| identifies the stream in log messages.
+template <typename Entry>
+bool ReadListStreamEntries(FileReaderInterface* file_reader,
+                           const MINIDUMP_LOCATION_DESCRIPTOR& location,
+                           size_t header_size,
+                           uint32_t size_of_header,
+                           uint32_t size_of_entry,
+                           uint64_t number_of_entries,
+                           const char* name,
+                           std::vector<Entry>* entries) {
+  if (size_of_header < header_size || size_of_header > location.DataSize ||
+      size_of_entry < sizeof(Entry) ||
+      number_of_entries >
+          (location.DataSize - size_of_header) / size_of_entry) {
+    LOG(ERROR) << name << " size mismatch";
+    return false;
+  }
+
+  std::vector<Entry> local_entries(static_cast<size_t>(number_of_entries));
+  if (local_entries.empty()) {
+    entries->swap(local_entries);
+    return true;
+  }
+
+  if (size_of_entry == sizeof(Entry)) {
+    if (!file_reader->SeekSet(location.Rva + size_of_header) ||
+        !file_reader->ReadExactly(&local_entries[0],
+                                  local_entries.size() * sizeof(Entry))) {
+      return false;
+    }
+  } else {
+    for (size_t index = 0; index < local_entries.size(); ++index) {
+      if (!file_reader->SeekSet(location.Rva + size_of_header +
+                                index * size_of_entry) ||
+          !file_reader->ReadExactly(&local_entries[index], sizeof(Entry))) {
+        return false;
+      }
+    }
+  }
+
+  entries->swap(local_entries);
+  return true;
+}
+
+// Reads a stream’s fixed-size header from |location|, verifying that the
+// stream is large enough to hold it. |name| identifies the stream in log
+// messages.
+template <typename Header>
+bool ReadStreamHeader(FileReaderInterface* file_reader,
+                      const MINIDUMP_LOCATION_DESCRIPTOR& location,
+                      const char* name,
+                      Header* header) {
+  if (location.DataSize < sizeof(*header)) {
+    LOG(ERROR) << name << " size mismatch";
+    return false;
+  }
+
+  return file_reader->SeekSet(location.Rva) &&
+         file_reader->ReadExactly(header, sizeof(*header));
+}
+
+}  // namespace
+
 ProcessSnapshotMinidump::ProcessSnapshotMinidump()
     : ProcessSnapshot(),
       header_(),
       stream_directory_(),
       stream_map_(),
+      stream_index_(),
+      threads_(),
       modules_(),
       unloaded_modules_(),
+      memory_map_(),
+      handles_(),
+      extra_memory_(),
+      system_(),
+      exception_(),
+      misc_info_(),
       crashpad_info_(),
       annotations_simple_map_(),
+      crashpad_info_state_(StreamState::kUnparsed),
+      modules_state_(StreamState::kUnparsed),
+      memory_list_state_(StreamState::kUnparsed),
+      misc_info_state_(StreamState::kUnparsed),
+      system_state_(StreamState::kUnparsed),
+      threads_state_(StreamState::kUnparsed),
+      exception_state_(StreamState::kUnparsed),
+      memory_info_state_(StreamState::kUnparsed),
+      unloaded_modules_state_(StreamState::kUnparsed),
+      handles_state_(StreamState::kUnparsed),
       file_reader_(nullptr),
+      mapped_file_(nullptr),
+      compressed_file_reader_(),
       initialized_() {
 }
 
@@ -48,6 +141,16 @@ bool ProcessSnapshotMinidump::Initialize(FileReaderInterface* file_reader) {
     return false;
   }
 
+  // A minidump file written through a BlockCompressedFileWriter is read
+  // through a decompressing reader, which supports the same random access.
+  if (BlockCompressedFileReader::IsBlockCompressedFile(file_reader_)) {
+    compressed_file_reader_.reset(new BlockCompressedFileReader());
+    if (!compressed_file_reader_->Initialize(file_reader_)) {
+      return false;
+    }
+    file_reader_ = compressed_file_reader_.get();
+  }
+
   if (!file_reader_->ReadExactly(&header_, sizeof(header_))) {
     return false;
   }
@@ -62,7 +165,7 @@ bool ProcessSnapshotMinidump::Initialize(FileReaderInterface* file_reader) {
     return false;
   }
 
-  if (!file_reader->SeekSet(header_.StreamDirectoryRva)) {
+  if (!file_reader_->SeekSet(header_.StreamDirectoryRva)) {
     return false;
   }
 
@@ -85,87 +188,139 @@ bool ProcessSnapshotMinidump::Initialize(FileReaderInterface* file_reader) {
     stream_map_[stream_type] = &directory.Location;
   }
 
+  // The footer’s signature could end a file without a stream index by chance,
+  // so an index that can’t be read, or that doesn’t describe this file’s
+  // streams, is ignored rather than treated as an error.
+  std::vector<MinidumpCrashpadStreamIndexEntry> stream_index;
+  if (internal::ReadMinidumpStreamIndex(file_reader_, &stream_index) &&
+      !stream_index.empty()) {
+    bool index_matches = stream_index.size() == stream_directory_.size();
+    for (size_t index = 0; index_matches && index < stream_index.size();
+         ++index) {
+      const MinidumpCrashpadStreamIndexEntry& entry = stream_index[index];
+      const MINIDUMP_DIRECTORY& directory = stream_directory_[index];
+      index_matches = entry.stream_type == directory.StreamType &&
+                      entry.offset == directory.Location.Rva &&
+                      entry.size == directory.Location.DataSize;
+    }
+
+    if (index_matches) {
+      for (const MinidumpCrashpadStreamIndexEntry& entry : stream_index) {
+        stream_index_[static_cast<MinidumpStreamType>(entry.stream_type)] =
+            entry;
+      }
+    } else {
+      LOG(WARNING) << "stream_index mismatch, ignoring";
+    }
+  }
+
   INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
 
-  if (!InitializeCrashpadInfo()) {
+bool ProcessSnapshotMinidump::InitializeFromMappedFile(
+    MappedFileReader* mapped_file) {
+  if (!Initialize(mapped_file)) {
     return false;
   }
 
-  return InitializeModules();
+  // A block-compressed file’s mapping holds compressed data, which can’t be
+  // referred to directly.
+  if (!compressed_file_reader_) {
+    mapped_file_ = mapped_file;
+  }
+
+  return true;
 }
 
 pid_t ProcessSnapshotMinidump::ProcessID() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return 0;
+  EnsureStreamParsed(&misc_info_state_,
+                     &ProcessSnapshotMinidump::InitializeMiscInfo);
+  return (misc_info_.Flags1 & MINIDUMP_MISC1_PROCESS_ID) ? misc_info_.ProcessId
+                                                          : 0;
 }
 
 pid_t ProcessSnapshotMinidump::ParentProcessID() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
+
+  // The parent process ID isn’t carried in minidump files.
   return 0;
 }
 
 void ProcessSnapshotMinidump::SnapshotTime(timeval* snapshot_time) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  snapshot_time->tv_sec = 0;
+  snapshot_time->tv_sec = header_.TimeDateStamp;
   snapshot_time->tv_usec = 0;
 }
 
 void ProcessSnapshotMinidump::ProcessStartTime(timeval* start_time) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  start_time->tv_sec = 0;
+  EnsureStreamParsed(&misc_info_state_,
+                     &ProcessSnapshotMinidump::InitializeMiscInfo);
+  start_time->tv_sec = (misc_info_.Flags1 & MINIDUMP_MISC1_PROCESS_TIMES)
+                           ? misc_info_.ProcessCreateTime
+                           : 0;
   start_time->tv_usec = 0;
 }
 
 void ProcessSnapshotMinidump::ProcessCPUTimes(timeval* user_time,
                                               timeval* system_time) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  user_time->tv_sec = 0;
+  EnsureStreamParsed(&misc_info_state_,
+                     &ProcessSnapshotMinidump::InitializeMiscInfo);
+  const bool has_times =
+      (misc_info_.Flags1 & MINIDUMP_MISC1_PROCESS_TIMES) != 0;
+  user_time->tv_sec = has_times ? misc_info_.ProcessUserTime : 0;
   user_time->tv_usec = 0;
-  system_time->tv_sec = 0;
+  system_time->tv_sec = has_times ? misc_info_.ProcessKernelTime : 0;
   system_time->tv_usec = 0;
 }
 
 void ProcessSnapshotMinidump::ReportID(UUID* report_id) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  EnsureStreamParsed(&crashpad_info_state_,
+                     &ProcessSnapshotMinidump::InitializeCrashpadInfo);
   *report_id = crashpad_info_.report_id;
 }
 
 void ProcessSnapshotMinidump::ClientID(UUID* client_id) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  EnsureStreamParsed(&crashpad_info_state_,
+                     &ProcessSnapshotMinidump::InitializeCrashpadInfo);
   *client_id = crashpad_info_.client_id;
 }
 
 const std::map<std::string, std::string>&
 ProcessSnapshotMinidump::AnnotationsSimpleMap() const {
-  // TODO(mark): This method should not be const, although the interface
-  // currently imposes this requirement. Making it non-const would allow
-  // annotations_simple_map_ to be lazily constructed: InitializeCrashpadInfo()
-  // could be called here, and from other locations that require it, rather than
-  // calling it from Initialize().
-  // https://crashpad.chromium.org/bug/9
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  EnsureStreamParsed(&crashpad_info_state_,
+                     &ProcessSnapshotMinidump::InitializeCrashpadInfo);
   return annotations_simple_map_;
 }
 
 const SystemSnapshot* ProcessSnapshotMinidump::System() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return nullptr;
+  EnsureStreamParsed(&system_state_,
+                     &ProcessSnapshotMinidump::InitializeSystem);
+  return system_.get();
 }
 
 std::vector<const ThreadSnapshot*> ProcessSnapshotMinidump::Threads() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return std::vector<const ThreadSnapshot*>();
+  EnsureStreamParsed(&threads_state_,
+                     &ProcessSnapshotMinidump::InitializeThreads);
+  std::vector<const ThreadSnapshot*> threads;
+  for (internal::ThreadSnapshotMinidump* thread : threads_) {
+    threads.push_back(thread);
+  }
+  return threads;
 }
 
 std::vector<const ModuleSnapshot*> ProcessSnapshotMinidump::Modules() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  EnsureStreamParsed(&modules_state_,
+                     &ProcessSnapshotMinidump::InitializeModules);
   std::vector<const ModuleSnapshot*> modules;
   for (internal::ModuleSnapshotMinidump* module : modules_) {
     modules.push_back(module);
@@ -176,43 +331,70 @@ std::vector<const ModuleSnapshot*> ProcessSnapshotMinidump::Modules() const {
 std::vector<UnloadedModuleSnapshot> ProcessSnapshotMinidump::UnloadedModules()
     const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
+  EnsureStreamParsed(&unloaded_modules_state_,
+                     &ProcessSnapshotMinidump::InitializeUnloadedModules);
   return unloaded_modules_;
 }
 
 const ExceptionSnapshot* ProcessSnapshotMinidump::Exception() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return nullptr;
+  EnsureStreamParsed(&exception_state_,
+                     &ProcessSnapshotMinidump::InitializeException);
+  return exception_.get();
 }
 
 std::vector<const MemoryMapRegionSnapshot*> ProcessSnapshotMinidump::MemoryMap()
     const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return std::vector<const MemoryMapRegionSnapshot*>();
+  EnsureStreamParsed(&memory_info_state_,
+                     &ProcessSnapshotMinidump::InitializeMemoryInfo);
+  std::vector<const MemoryMapRegionSnapshot*> memory_map;
+  for (internal::MemoryMapRegionSnapshotMinidump* region : memory_map_) {
+    memory_map.push_back(region);
+  }
+  return memory_map;
 }
 
 std::vector<HandleSnapshot> ProcessSnapshotMinidump::Handles() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return std::vector<HandleSnapshot>();
+  EnsureStreamParsed(&handles_state_,
+                     &ProcessSnapshotMinidump::InitializeHandles);
+  return handles_;
 }
 
 std::vector<const MemorySnapshot*> ProcessSnapshotMinidump::ExtraMemory()
     const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  NOTREACHED();  // https://crashpad.chromium.org/bug/10
-  return std::vector<const MemorySnapshot*>();
+  EnsureStreamParsed(&memory_list_state_,
+                     &ProcessSnapshotMinidump::InitializeMemoryList);
+  std::vector<const MemorySnapshot*> extra_memory;
+  for (internal::MemorySnapshotMinidump* memory : extra_memory_) {
+    extra_memory.push_back(memory);
+  }
+  return extra_memory;
+}
+
+bool ProcessSnapshotMinidump::EnsureStreamParsed(
+    StreamState* state,
+    bool (ProcessSnapshotMinidump::*parse)() const) const {
+  if (*state == StreamState::kUnparsed) {
+    *state = (this->*parse)() ? StreamState::kParsed : StreamState::kInvalid;
+  }
+  return *state == StreamState::kParsed;
 }
 
-bool ProcessSnapshotMinidump::InitializeCrashpadInfo() {
+bool ProcessSnapshotMinidump::InitializeCrashpadInfo() const {
   const auto& stream_it = stream_map_.find(kMinidumpStreamTypeCrashpadInfo);
   if (stream_it == stream_map_.end()) {
     return true;
   }
 
-  if (stream_it->second->DataSize < sizeof(crashpad_info_)) {
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
+  MinidumpCrashpadInfo crashpad_info;
+  if (stream_it->second->DataSize < sizeof(crashpad_info)) {
     LOG(ERROR) << "crashpad_info size mismatch";
     return false;
   }
@@ -221,29 +403,43 @@ bool ProcessSnapshotMinidump::InitializeCrashpadInfo() {
     return false;
   }
 
-  if (!file_reader_->ReadExactly(&crashpad_info_, sizeof(crashpad_info_))) {
+  if (!file_reader_->ReadExactly(&crashpad_info, sizeof(crashpad_info))) {
     return false;
   }
 
-  if (crashpad_info_.version != MinidumpCrashpadInfo::kVersion) {
+  if (crashpad_info.version != MinidumpCrashpadInfo::kVersion) {
     LOG(ERROR) << "crashpad_info version mismatch";
     return false;
   }
 
-  return internal::ReadMinidumpSimpleStringDictionary(
-      file_reader_,
-      crashpad_info_.simple_annotations,
-      &annotations_simple_map_);
+  std::map<std::string, std::string> annotations_simple_map;
+  if (!internal::ReadMinidumpSimpleStringDictionary(
+          file_reader_,
+          crashpad_info.simple_annotations,
+          &annotations_simple_map)) {
+    return false;
+  }
+
+  // Only expose the stream’s data once it’s known to be valid.
+  crashpad_info_ = crashpad_info;
+  annotations_simple_map_.swap(annotations_simple_map);
+  return true;
 }
 
-bool ProcessSnapshotMinidump::InitializeModules() {
+bool ProcessSnapshotMinidump::InitializeModules() const {
   const auto& stream_it = stream_map_.find(kMinidumpStreamTypeModuleList);
   if (stream_it == stream_map_.end()) {
     return true;
   }
 
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
   std::map<uint32_t, MINIDUMP_LOCATION_DESCRIPTOR> module_crashpad_info_links;
-  if (!InitializeModulesCrashpadInfo(&module_crashpad_info_links)) {
+  if (!EnsureStreamParsed(&crashpad_info_state_,
+                          &ProcessSnapshotMinidump::InitializeCrashpadInfo) ||
+      !InitializeModulesCrashpadInfo(&module_crashpad_info_links)) {
     return false;
   }
 
@@ -267,6 +463,7 @@ bool ProcessSnapshotMinidump::InitializeModules() {
     return false;
   }
 
+  PointerVector<internal::ModuleSnapshotMinidump> modules;
   for (uint32_t module_index = 0; module_index < module_count; ++module_index) {
     const RVA module_rva = stream_it->second->Rva + sizeof(module_count) +
                            module_index * sizeof(MINIDUMP_MODULE);
@@ -284,15 +481,386 @@ bool ProcessSnapshotMinidump::InitializeModules() {
       return false;
     }
 
-    modules_.push_back(module.release());
+    modules.push_back(module.release());
   }
 
+  modules_.swap(modules);
   return true;
 }
 
+bool ProcessSnapshotMinidump::InitializeMemoryList() const {
+  const auto& stream_it = stream_map_.find(kMinidumpStreamTypeMemoryList);
+  if (stream_it == stream_map_.end()) {
+    return true;
+  }
+
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
+  if (stream_it->second->DataSize < sizeof(MINIDUMP_MEMORY_LIST)) {
+    LOG(ERROR) << "memory_list size mismatch";
+    return false;
+  }
+
+  if (!file_reader_->SeekSet(stream_it->second->Rva)) {
+    return false;
+  }
+
+  uint32_t range_count;
+  if (!file_reader_->ReadExactly(&range_count, sizeof(range_count))) {
+    return false;
+  }
+
+  if (sizeof(MINIDUMP_MEMORY_LIST) +
+          static_cast<uint64_t>(range_count) *
+              sizeof(MINIDUMP_MEMORY_DESCRIPTOR) !=
+      stream_it->second->DataSize) {
+    LOG(ERROR) << "memory_list size mismatch";
+    return false;
+  }
+
+  std::vector<MINIDUMP_MEMORY_DESCRIPTOR> descriptors(range_count);
+  if (range_count &&
+      !file_reader_->ReadExactly(
+          &descriptors[0],
+          range_count * sizeof(MINIDUMP_MEMORY_DESCRIPTOR))) {
+    return false;
+  }
+
+  // MinidumpFileWriter places thread stacks in the memory list too. They’re
+  // available through Threads(), so leave them out here, where they would
+  // otherwise be written twice if this snapshot were written to a new
+  // minidump file.
+  std::set<std::pair<uint64_t, RVA>> stacks;
+  if (EnsureStreamParsed(&threads_state_,
+                         &ProcessSnapshotMinidump::InitializeThreads)) {
+    for (const internal::ThreadSnapshotMinidump* thread : threads_) {
+      const MINIDUMP_MEMORY_DESCRIPTOR& stack = thread->StackDescriptor();
+      stacks.insert(
+          std::make_pair(stack.StartOfMemoryRange, stack.Memory.Rva));
+    }
+  }
+
+  PointerVector<internal::MemorySnapshotMinidump> extra_memory;
+  for (const MINIDUMP_MEMORY_DESCRIPTOR& descriptor : descriptors) {
+    if (stacks.find(std::make_pair(descriptor.StartOfMemoryRange,
+                                   descriptor.Memory.Rva)) != stacks.end()) {
+      continue;
+    }
+
+    auto memory = base::WrapUnique(new internal::MemorySnapshotMinidump());
+    if (!memory->Initialize(file_reader_, mapped_file_, descriptor)) {
+      return false;
+    }
+    extra_memory.push_back(memory.release());
+  }
+
+  extra_memory_.swap(extra_memory);
+  return true;
+}
+
+bool ProcessSnapshotMinidump::InitializeMiscInfo() const {
+  const auto& stream_it = stream_map_.find(kMinidumpStreamTypeMiscInfo);
+  if (stream_it == stream_map_.end()) {
+    return true;
+  }
+
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
+  // Older, smaller variants of the structure are acceptable. Fields beyond
+  // what’s present are left zeroed, and aren’t flagged as valid.
+  const uint32_t size = stream_it->second->DataSize;
+  if (size < sizeof(MINIDUMP_MISC_INFO)) {
+    LOG(ERROR) << "misc_info size mismatch";
+    return false;
+  }
+
+  if (!file_reader_->SeekSet(stream_it->second->Rva)) {
+    return false;
+  }
+
+  MINIDUMP_MISC_INFO_N misc_info = {};
+  if (!file_reader_->ReadExactly(
+          &misc_info, std::min<size_t>(size, sizeof(misc_info)))) {
+    return false;
+  }
+
+  if (misc_info.SizeOfInfo != size) {
+    LOG(ERROR) << "misc_info size mismatch";
+    return false;
+  }
+
+  misc_info_ = misc_info;
+  return true;
+}
+
+bool ProcessSnapshotMinidump::InitializeSystem() const {
+  const auto& stream_it = stream_map_.find(kMinidumpStreamTypeSystemInfo);
+  if (stream_it == stream_map_.end()) {
+    return true;
+  }
+
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
+  // A missing or invalid MINIDUMP_MISC_INFO leaves misc_info_ zeroed, which
+  // SystemSnapshotMinidump treats as though the stream were absent.
+  EnsureStreamParsed(&misc_info_state_,
+                     &ProcessSnapshotMinidump::InitializeMiscInfo);
+
+  auto system = base::WrapUnique(new internal::SystemSnapshotMinidump());
+  if (!system->Initialize(file_reader_, *stream_it->second, misc_info_)) {
+    return false;
+  }
+
+  system_ = std::move(system);
+  return true;
+}
+
+bool ProcessSnapshotMinidump::InitializeThreads() const {
+  const auto& stream_it = stream_map_.find(kMinidumpStreamTypeThreadList);
+  if (stream_it == stream_map_.end()) {
+    return true;
+  }
+
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
+  const CPUArchitecture architecture = GetArchitecture();
+  if (architecture == kCPUArchitectureUnknown) {
+    return false;
+  }
+
+  MINIDUMP_THREAD_LIST thread_list;
+  if (!ReadStreamHeader(
+          file_reader_, *stream_it->second, "thread_list", &thread_list)) {
+    return false;
+  }
+
+  if (sizeof(MINIDUMP_THREAD_LIST) +
+          static_cast<uint64_t>(thread_list.NumberOfThreads) *
+              sizeof(MINIDUMP_THREAD) !=
+      stream_it->second->DataSize) {
+    LOG(ERROR) << "thread_list size mismatch";
+    return false;
+  }
+
+  PointerVector<internal::ThreadSnapshotMinidump> threads;
+  for (uint32_t thread_index = 0;
+       thread_index < thread_list.NumberOfThreads;
+       ++thread_index) {
+    const RVA thread_rva = stream_it->second->Rva +
+                           sizeof(MINIDUMP_THREAD_LIST) +
+                           thread_index * sizeof(MINIDUMP_THREAD);
+
+    auto thread = base::WrapUnique(new internal::ThreadSnapshotMinidump());
+    if (!thread->Initialize(
+            file_reader_, mapped_file_, thread_rva, architecture)) {
+      return false;
+    }
+
+    threads.push_back(thread.release());
+  }
+
+  threads_.swap(threads);
+  return true;
+}
+
+bool ProcessSnapshotMinidump::InitializeException() const {
+  const auto& stream_it = stream_map_.find(kMinidumpStreamTypeException);
+  if (stream_it == stream_map_.end()) {
+    return true;
+  }
+
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
+  const CPUArchitecture architecture = GetArchitecture();
+  if (architecture == kCPUArchitectureUnknown) {
+    return false;
+  }
+
+  auto exception = base::WrapUnique(new internal::ExceptionSnapshotMinidump());
+  if (!exception->Initialize(file_reader_, *stream_it->second, architecture)) {
+    return false;
+  }
+
+  exception_ = std::move(exception);
+  return true;
+}
+
+bool ProcessSnapshotMinidump::InitializeMemoryInfo() const {
+  const auto& stream_it = stream_map_.find(kMinidumpStreamTypeMemoryInfoList);
+  if (stream_it == stream_map_.end()) {
+    return true;
+  }
+
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
+  MINIDUMP_MEMORY_INFO_LIST memory_info_list;
+  if (!ReadStreamHeader(file_reader_,
+                        *stream_it->second,
+                        "memory_info_list",
+                        &memory_info_list)) {
+    return false;
+  }
+
+  std::vector<MINIDUMP_MEMORY_INFO> memory_infos;
+  if (!ReadListStreamEntries(file_reader_,
+                             *stream_it->second,
+                             sizeof(memory_info_list),
+                             memory_info_list.SizeOfHeader,
+                             memory_info_list.SizeOfEntry,
+                             memory_info_list.NumberOfEntries,
+                             "memory_info_list",
+                             &memory_infos)) {
+    return false;
+  }
+
+  PointerVector<internal::MemoryMapRegionSnapshotMinidump> memory_map;
+  for (const MINIDUMP_MEMORY_INFO& memory_info : memory_infos) {
+    memory_map.push_back(
+        new internal::MemoryMapRegionSnapshotMinidump(memory_info));
+  }
+
+  memory_map_.swap(memory_map);
+  return true;
+}
+
+bool ProcessSnapshotMinidump::InitializeUnloadedModules() const {
+  const auto& stream_it =
+      stream_map_.find(kMinidumpStreamTypeUnloadedModuleList);
+  if (stream_it == stream_map_.end()) {
+    return true;
+  }
+
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
+  MINIDUMP_UNLOADED_MODULE_LIST unloaded_module_list;
+  if (!ReadStreamHeader(file_reader_,
+                        *stream_it->second,
+                        "unloaded_module_list",
+                        &unloaded_module_list)) {
+    return false;
+  }
+
+  std::vector<MINIDUMP_UNLOADED_MODULE> minidump_unloaded_modules;
+  if (!ReadListStreamEntries(file_reader_,
+                             *stream_it->second,
+                             sizeof(unloaded_module_list),
+                             unloaded_module_list.SizeOfHeader,
+                             unloaded_module_list.SizeOfEntry,
+                             unloaded_module_list.NumberOfEntries,
+                             "unloaded_module_list",
+                             &minidump_unloaded_modules)) {
+    return false;
+  }
+
+  std::vector<UnloadedModuleSnapshot> unloaded_modules;
+  for (const MINIDUMP_UNLOADED_MODULE& minidump_unloaded_module :
+       minidump_unloaded_modules) {
+    std::string name;
+    if (!internal::ReadMinidumpUTF16String(
+            file_reader_, minidump_unloaded_module.ModuleNameRva, &name)) {
+      return false;
+    }
+
+    unloaded_modules.push_back(
+        UnloadedModuleSnapshot(minidump_unloaded_module.BaseOfImage,
+                               minidump_unloaded_module.SizeOfImage,
+                               minidump_unloaded_module.CheckSum,
+                               minidump_unloaded_module.TimeDateStamp,
+                               name));
+  }
+
+  unloaded_modules_.swap(unloaded_modules);
+  return true;
+}
+
+bool ProcessSnapshotMinidump::InitializeHandles() const {
+  const auto& stream_it = stream_map_.find(kMinidumpStreamTypeHandleData);
+  if (stream_it == stream_map_.end()) {
+    return true;
+  }
+
+  if (!VerifyStream(stream_it->first)) {
+    return false;
+  }
+
+  MINIDUMP_HANDLE_DATA_STREAM handle_data_stream;
+  if (!ReadStreamHeader(file_reader_,
+                        *stream_it->second,
+                        "handle_data_stream",
+                        &handle_data_stream)) {
+    return false;
+  }
+
+  std::vector<MINIDUMP_HANDLE_DESCRIPTOR> descriptors;
+  if (!ReadListStreamEntries(file_reader_,
+                             *stream_it->second,
+                             sizeof(handle_data_stream),
+                             handle_data_stream.SizeOfHeader,
+                             handle_data_stream.SizeOfDescriptor,
+                             handle_data_stream.NumberOfDescriptors,
+                             "handle_data_stream",
+                             &descriptors)) {
+    return false;
+  }
+
+  std::vector<HandleSnapshot> handles;
+  for (const MINIDUMP_HANDLE_DESCRIPTOR& descriptor : descriptors) {
+    HandleSnapshot handle;
+    if (!internal::ReadMinidumpUTF16String(
+            file_reader_, descriptor.TypeNameRva, &handle.type_name)) {
+      return false;
+    }
+
+    handle.handle = static_cast<uint32_t>(descriptor.Handle);
+    handle.attributes = descriptor.Attributes;
+    handle.granted_access = descriptor.GrantedAccess;
+    handle.pointer_count = descriptor.PointerCount;
+    handle.handle_count = descriptor.HandleCount;
+    handles.push_back(handle);
+  }
+
+  handles_.swap(handles);
+  return true;
+}
+
+bool ProcessSnapshotMinidump::VerifyStream(
+    MinidumpStreamType stream_type) const {
+  const auto& index_it = stream_index_.find(stream_type);
+  return index_it == stream_index_.end() ||
+         internal::VerifyMinidumpStream(file_reader_, index_it->second);
+}
+
+CPUArchitecture ProcessSnapshotMinidump::GetArchitecture() const {
+  if (!EnsureStreamParsed(&system_state_,
+                          &ProcessSnapshotMinidump::InitializeSystem) ||
+      !system_) {
+    LOG(ERROR) << "no system_info";
+    return kCPUArchitectureUnknown;
+  }
+
+  const CPUArchitecture architecture = system_->GetCPUArchitecture();
+  LOG_IF(ERROR, architecture == kCPUArchitectureUnknown)
+      << "unknown architecture";
+  return architecture;
+}
+
 bool ProcessSnapshotMinidump::InitializeModulesCrashpadInfo(
     std::map<uint32_t, MINIDUMP_LOCATION_DESCRIPTOR>*
-        module_crashpad_info_links) {
+        module_crashpad_info_links) const {
   module_crashpad_info_links->clear();
 
   if (crashpad_info_.version != MinidumpCrashpadInfo::kVersion) {
@@ -21,20 +21,31 @@
 #include <sys/time.h>
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "base/macros.h"
 #include "minidump/minidump_extensions.h"
+#include "snapshot/cpu_architecture.h"
 #include "snapshot/exception_snapshot.h"
+#include "snapshot/handle_snapshot.h"
+#include "snapshot/memory_map_region_snapshot.h"
 #include "snapshot/memory_snapshot.h"
+#include "snapshot/minidump/exception_snapshot_minidump.h"
+#include "snapshot/minidump/memory_map_region_snapshot_minidump.h"
+#include "snapshot/minidump/memory_snapshot_minidump.h"
 #include "snapshot/minidump/module_snapshot_minidump.h"
+#include "snapshot/minidump/system_snapshot_minidump.h"
+#include "snapshot/minidump/thread_snapshot_minidump.h"
 #include "snapshot/module_snapshot.h"
 #include "snapshot/process_snapshot.h"
 #include "snapshot/system_snapshot.h"
 #include "snapshot/thread_snapshot.h"
 #include "snapshot/unloaded_module_snapshot.h"
+#include "util/file/block_compressed_file_reader.h"
 #include "util/file/file_reader.h"
+#include "util/file/mapped_file_reader.h"
 #include "util/misc/initialization_state_dcheck.h"
 #include "util/misc/uuid.h"
 #include "util/stdlib/pointer_container.h"
@@ -42,6 +53,19 @@
 namespace crashpad {
 
 //! \brief A ProcessSnapshot based on a minidump file.
+//!
+//! Initialization only reads and validates the minidump file’s header and
+//! stream directory. Each stream is parsed when it is first needed, so that
+//! callers interested in only a few fields don’t pay to parse the rest of the
+//! file. A stream that turns out to be malformed is logged and treated as
+//! though it were absent. If the file ends with a stream index, as written
+//! by MinidumpFileWriter::SetWriteStreamIndex(), each stream is also checked
+//! against the hash recorded for it there before it is parsed.
+//!
+//! Everything that MinidumpFileWriter::InitializeFromSnapshot() writes is read
+//! back, so that a minidump file can be re-encoded or reduced in-process.
+//! Memory referenced by threads, modules, and the exception is not attributed
+//! to them, but is all available through ExtraMemory().
 class ProcessSnapshotMinidump final : public ProcessSnapshot {
  public:
   ProcessSnapshotMinidump();
@@ -50,12 +74,29 @@ class ProcessSnapshotMinidump final : public ProcessSnapshot {
   //! \brief Initializes the object.
   //!
   //! \param[in] file_reader A file reader corresponding to a minidump file.
-  //!     The file reader must support seeking.
+  //!     The file reader must support seeking, and must remain valid for the
+  //!     lifetime of this object. The minidump file may have been written
+  //!     through a BlockCompressedFileWriter, in which case it will be
+  //!     decompressed as needed.
   //!
   //! \return `true` if the snapshot could be created, `false` otherwise with
   //!     an appropriate message logged.
   bool Initialize(FileReaderInterface* file_reader);
 
+  //! \brief Initializes the object from a memory-mapped minidump file.
+  //!
+  //! This behaves as Initialize(), but where the minidump file is not
+  //! block-compressed, streams are interpreted directly from the mapping, and
+  //! MemorySnapshot objects provide their contents as pointers into the
+  //! mapping without copying.
+  //!
+  //! \param[in] mapped_file An open mapped file reader corresponding to a
+  //!     minidump file. It must remain open for the lifetime of this object.
+  //!
+  //! \return `true` if the snapshot could be created, `false` otherwise with
+  //!     an appropriate message logged.
+  bool InitializeFromMappedFile(MappedFileReader* mapped_file);
+
   // ProcessSnapshot:
 
   pid_t ProcessID() const override;
@@ -77,29 +118,114 @@ class ProcessSnapshotMinidump final : public ProcessSnapshot {
   std::vector<const MemorySnapshot*> ExtraMemory() const override;
 
  private:
+  // The parsing state of a stream that is parsed on first use.
+  enum class StreamState {
+    kUnparsed,
+    kParsed,
+    kInvalid,
+  };
+
+  // Calls |parse| to parse a stream whose state is |*state| if it hasn’t been
+  // attempted yet, and returns whether the stream was parsed successfully.
+  // These are const because ProcessSnapshot’s accessors are.
+  bool EnsureStreamParsed(StreamState* state,
+                          bool (ProcessSnapshotMinidump::*parse)() const)
+      const;
+
   // Initializes data carried in a MinidumpCrashpadInfo stream on behalf of
-  // Initialize().
-  bool InitializeCrashpadInfo();
+  // EnsureStreamParsed().
+  bool InitializeCrashpadInfo() const;
 
   // Initializes data carried in a MINIDUMP_MODULE_LIST stream on behalf of
-  // Initialize().
-  bool InitializeModules();
+  // EnsureStreamParsed().
+  bool InitializeModules() const;
 
   // Initializes data carried in a MinidumpModuleCrashpadInfoList structure on
   // behalf of InitializeModules(). This makes use of MinidumpCrashpadInfo as
   // well, so it must be called after InitializeCrashpadInfo().
   bool InitializeModulesCrashpadInfo(
       std::map<uint32_t, MINIDUMP_LOCATION_DESCRIPTOR>*
-          module_crashpad_info_links);
+          module_crashpad_info_links) const;
+
+  // Initializes data carried in a MINIDUMP_MEMORY_LIST stream on behalf of
+  // EnsureStreamParsed().
+  bool InitializeMemoryList() const;
+
+  // Initializes data carried in a MINIDUMP_MISC_INFO stream on behalf of
+  // EnsureStreamParsed().
+  bool InitializeMiscInfo() const;
+
+  // Initializes data carried in a MINIDUMP_SYSTEM_INFO stream on behalf of
+  // EnsureStreamParsed(). This makes use of MINIDUMP_MISC_INFO as well.
+  bool InitializeSystem() const;
+
+  // Initializes data carried in a MINIDUMP_THREAD_LIST stream on behalf of
+  // EnsureStreamParsed(). The CPU architecture is taken from the
+  // MINIDUMP_SYSTEM_INFO stream, which is required.
+  bool InitializeThreads() const;
+
+  // Initializes data carried in a MINIDUMP_EXCEPTION_STREAM on behalf of
+  // EnsureStreamParsed(). The CPU architecture is taken from the
+  // MINIDUMP_SYSTEM_INFO stream, which is required.
+  bool InitializeException() const;
+
+  // Initializes data carried in a MINIDUMP_MEMORY_INFO_LIST stream on behalf
+  // of EnsureStreamParsed().
+  bool InitializeMemoryInfo() const;
+
+  // Initializes data carried in a MINIDUMP_UNLOADED_MODULE_LIST stream on
+  // behalf of EnsureStreamParsed().
+  bool InitializeUnloadedModules() const;
+
+  // Initializes data carried in a MINIDUMP_HANDLE_DATA_STREAM on behalf of
+  // EnsureStreamParsed().
+  bool InitializeHandles() const;
+
+  // Returns the CPU architecture from the MINIDUMP_SYSTEM_INFO stream, or
+  // kCPUArchitectureUnknown with a message logged if it isn’t available.
+  CPUArchitecture GetArchitecture() const;
+
+  // Returns whether the data of the stream of |stream_type| matches its hash
+  // in stream_index_, if it has one there, logging a message if not.
+  bool VerifyStream(MinidumpStreamType stream_type) const;
 
   MINIDUMP_HEADER header_;
   std::vector<MINIDUMP_DIRECTORY> stream_directory_;
   std::map<MinidumpStreamType, const MINIDUMP_LOCATION_DESCRIPTOR*> stream_map_;
-  PointerVector<internal::ModuleSnapshotMinidump> modules_;
-  std::vector<UnloadedModuleSnapshot> unloaded_modules_;
-  MinidumpCrashpadInfo crashpad_info_;
-  std::map<std::string, std::string> annotations_simple_map_;
+  std::map<MinidumpStreamType, MinidumpCrashpadStreamIndexEntry> stream_index_;
+
+  // Lazily-parsed stream data.
+  mutable PointerVector<internal::ThreadSnapshotMinidump> threads_;
+  mutable PointerVector<internal::ModuleSnapshotMinidump> modules_;
+  mutable std::vector<UnloadedModuleSnapshot> unloaded_modules_;
+  mutable PointerVector<internal::MemoryMapRegionSnapshotMinidump> memory_map_;
+  mutable std::vector<HandleSnapshot> handles_;
+  mutable PointerVector<internal::MemorySnapshotMinidump> extra_memory_;
+  mutable std::unique_ptr<internal::SystemSnapshotMinidump> system_;
+  mutable std::unique_ptr<internal::ExceptionSnapshotMinidump> exception_;
+  mutable MINIDUMP_MISC_INFO_N misc_info_;
+  mutable MinidumpCrashpadInfo crashpad_info_;
+  mutable std::map<std::string, std::string> annotations_simple_map_;
+  mutable StreamState crashpad_info_state_;
+  mutable StreamState modules_state_;
+  mutable StreamState memory_list_state_;
+  mutable StreamState misc_info_state_;
+  mutable StreamState system_state_;
+  mutable StreamState threads_state_;
+  mutable StreamState exception_state_;
+  mutable StreamState memory_info_state_;
+  mutable StreamState unloaded_modules_state_;
+  mutable StreamState handles_state_;
+
   FileReaderInterface* file_reader_;  // weak
+
+  // Set when the minidump file is mapped and not block-compressed, in which
+  // case it refers to the same file as file_reader_.
+  const MappedFileReader* mapped_file_;  // weak
+
+  // Set, and used as file_reader_, when the minidump file is block-compressed.
+  std::unique_ptr<BlockCompressedFileReader> compressed_file_reader_;
+
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(ProcessSnapshotMinidump);
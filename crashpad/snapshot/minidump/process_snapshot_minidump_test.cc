@@ -16,13 +16,24 @@
 
 #include <windows.h>
 #include <dbghelp.h>
+#include <stddef.h>
 #include <string.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "base/files/file_path.h"
+#include "base/macros.h"
 #include "gtest/gtest.h"
+#include "snapshot/memory_snapshot.h"
 #include "snapshot/module_snapshot.h"
+#include "test/scoped_temp_dir.h"
+#include "util/file/block_compressed_file_writer.h"
+#include "util/file/file_writer.h"
+#include "util/file/mapped_file_reader.h"
 #include "util/file/string_file.h"
+#include "util/misc/xxhash.h"
 
 namespace crashpad {
 namespace test {
@@ -65,6 +76,28 @@ TEST(ProcessSnapshotMinidump, Empty) {
   EXPECT_TRUE(process_snapshot.AnnotationsSimpleMap().empty());
 }
 
+TEST(ProcessSnapshotMinidump, BlockCompressed) {
+  StringFile string_file;
+
+  {
+    BlockCompressedFileWriter compressed_writer(&string_file, 16);
+
+    MINIDUMP_HEADER header = {};
+    header.Signature = MINIDUMP_SIGNATURE;
+    header.Version = MINIDUMP_VERSION;
+
+    EXPECT_TRUE(compressed_writer.Write(&header, sizeof(header)));
+    EXPECT_TRUE(compressed_writer.Close());
+  }
+
+  ProcessSnapshotMinidump process_snapshot;
+  EXPECT_TRUE(process_snapshot.Initialize(&string_file));
+
+  UUID client_id;
+  process_snapshot.ClientID(&client_id);
+  EXPECT_EQ(client_id, UUID());
+}
+
 // Writes |string| to |writer| as a MinidumpUTF8String, and returns the file
 // offst of the beginning of the string.
 RVA WriteString(FileWriterInterface* writer, const std::string& string) {
@@ -172,6 +205,113 @@ TEST(ProcessSnapshotMinidump, ClientID) {
   EXPECT_TRUE(process_snapshot.AnnotationsSimpleMap().empty());
 }
 
+// Writes a minidump file carrying only a MinidumpCrashpadInfo stream with
+// |client_id| to |string_file|, ending with a stream index. If |corrupt_stream|
+// is true, the stream is modified after the index is written. If
+// |corrupt_index| is true, the index is modified after its footer is written.
+void WriteMinidumpWithStreamIndex(StringFile* string_file,
+                                  const UUID& client_id,
+                                  bool corrupt_stream,
+                                  bool corrupt_index) {
+  MINIDUMP_HEADER header = {};
+  EXPECT_TRUE(string_file->Write(&header, sizeof(header)));
+
+  MinidumpCrashpadInfo crashpad_info = {};
+  crashpad_info.version = MinidumpCrashpadInfo::kVersion;
+  crashpad_info.client_id = client_id;
+
+  MINIDUMP_DIRECTORY crashpad_info_directory = {};
+  crashpad_info_directory.StreamType = kMinidumpStreamTypeCrashpadInfo;
+  crashpad_info_directory.Location.Rva =
+      static_cast<RVA>(string_file->SeekGet());
+  EXPECT_TRUE(string_file->Write(&crashpad_info, sizeof(crashpad_info)));
+  crashpad_info_directory.Location.DataSize = sizeof(crashpad_info);
+
+  header.StreamDirectoryRva = static_cast<RVA>(string_file->SeekGet());
+  EXPECT_TRUE(string_file->Write(&crashpad_info_directory,
+                                 sizeof(crashpad_info_directory)));
+
+  MinidumpCrashpadStreamIndexEntry entry = {};
+  entry.stream_type = crashpad_info_directory.StreamType;
+  entry.offset = crashpad_info_directory.Location.Rva;
+  entry.size = crashpad_info_directory.Location.DataSize;
+  entry.xxhash64 = XXHash64(&crashpad_info, sizeof(crashpad_info), 0);
+
+  MinidumpCrashpadStreamIndexFooter footer = {};
+  footer.version = MinidumpCrashpadStreamIndexFooter::kVersion;
+  footer.index = string_file->SeekGet();
+  footer.count = 1;
+  footer.size_of_entry = sizeof(entry);
+  footer.index_xxhash64 = XXHash64(&entry, sizeof(entry), 0);
+  footer.signature = MinidumpCrashpadStreamIndexFooter::kSignature;
+  if (corrupt_index) {
+    ++entry.xxhash64;
+  }
+  EXPECT_TRUE(string_file->Write(&entry, sizeof(entry)));
+  EXPECT_TRUE(string_file->Write(&footer, sizeof(footer)));
+
+  if (corrupt_stream) {
+    crashpad_info.client_id.data_1 ^= 1;
+    EXPECT_TRUE(string_file->SeekSet(crashpad_info_directory.Location.Rva));
+    EXPECT_TRUE(string_file->Write(&crashpad_info, sizeof(crashpad_info)));
+  }
+
+  header.Signature = MINIDUMP_SIGNATURE;
+  header.Version = MINIDUMP_VERSION;
+  header.NumberOfStreams = 1;
+  EXPECT_TRUE(string_file->SeekSet(0));
+  EXPECT_TRUE(string_file->Write(&header, sizeof(header)));
+}
+
+TEST(ProcessSnapshotMinidump, StreamIndex) {
+  UUID client_id;
+  ASSERT_TRUE(
+      client_id.InitializeFromString("0001f4a9-d00d-5155-0a55-c0ffeec0ffee"));
+
+  {
+    SCOPED_TRACE("valid");
+    StringFile string_file;
+    WriteMinidumpWithStreamIndex(&string_file, client_id, false, false);
+
+    ProcessSnapshotMinidump process_snapshot;
+    ASSERT_TRUE(process_snapshot.Initialize(&string_file));
+
+    UUID actual_client_id;
+    process_snapshot.ClientID(&actual_client_id);
+    EXPECT_EQ(actual_client_id, client_id);
+  }
+
+  {
+    // A stream that doesn’t match its hash is treated as absent.
+    SCOPED_TRACE("corrupt stream");
+    StringFile string_file;
+    WriteMinidumpWithStreamIndex(&string_file, client_id, true, false);
+
+    ProcessSnapshotMinidump process_snapshot;
+    ASSERT_TRUE(process_snapshot.Initialize(&string_file));
+
+    UUID actual_client_id;
+    process_snapshot.ClientID(&actual_client_id);
+    EXPECT_EQ(actual_client_id, UUID());
+  }
+
+  {
+    // An index that doesn’t match its own hash is ignored, so the stream is
+    // read without being checked.
+    SCOPED_TRACE("corrupt index");
+    StringFile string_file;
+    WriteMinidumpWithStreamIndex(&string_file, client_id, true, true);
+
+    ProcessSnapshotMinidump process_snapshot;
+    ASSERT_TRUE(process_snapshot.Initialize(&string_file));
+
+    UUID actual_client_id;
+    process_snapshot.ClientID(&actual_client_id);
+    EXPECT_NE(actual_client_id, UUID());
+    EXPECT_NE(actual_client_id, client_id);
+  }
+}
+
 TEST(ProcessSnapshotMinidump, AnnotationsSimpleMap) {
   StringFile string_file;
 
@@ -240,8 +380,10 @@ TEST(ProcessSnapshotMinidump, Modules) {
     EXPECT_TRUE(string_file.Write(&minidump_module, sizeof(minidump_module)));
   }
 
+  // crashpad_module_0 is written as a version 1 structure, which predates
+  // annotation_objects.
   MinidumpModuleCrashpadInfo crashpad_module_0 = {};
-  crashpad_module_0.version = MinidumpModuleCrashpadInfo::kVersion;
+  crashpad_module_0.version = 1;
   std::map<std::string, std::string> dictionary_0;
   dictionary_0["ptype"] = "browser";
   dictionary_0["pid"] = "12345";
@@ -250,9 +392,11 @@ TEST(ProcessSnapshotMinidump, Modules) {
 
   MinidumpModuleCrashpadInfoLink crashpad_module_0_link = {};
   crashpad_module_0_link.minidump_module_list_index = 0;
-  crashpad_module_0_link.location.DataSize = sizeof(crashpad_module_0);
+  crashpad_module_0_link.location.DataSize =
+      offsetof(MinidumpModuleCrashpadInfo, annotation_objects);
   crashpad_module_0_link.location.Rva = static_cast<RVA>(string_file.SeekGet());
-  EXPECT_TRUE(string_file.Write(&crashpad_module_0, sizeof(crashpad_module_0)));
+  EXPECT_TRUE(string_file.Write(&crashpad_module_0,
+                                crashpad_module_0_link.location.DataSize));
 
   MinidumpModuleCrashpadInfo crashpad_module_2 = {};
   crashpad_module_2.version = MinidumpModuleCrashpadInfo::kVersion;
@@ -321,6 +465,8 @@ TEST(ProcessSnapshotMinidump, Modules) {
   auto annotations_vector = modules[0]->AnnotationsVector();
   EXPECT_TRUE(annotations_vector.empty());
 
+  EXPECT_TRUE(modules[0]->AnnotationObjects().empty());
+
   annotations_simple_map = modules[1]->AnnotationsSimpleMap();
   EXPECT_TRUE(annotations_simple_map.empty());
 
@@ -332,6 +478,131 @@ TEST(ProcessSnapshotMinidump, Modules) {
 
   annotations_vector = modules[2]->AnnotationsVector();
   EXPECT_EQ(annotations_vector, list_annotations_2);
+
+  EXPECT_TRUE(modules[2]->AnnotationObjects().empty());
+}
+
+// Records the data passed to MemorySnapshotDelegateRead().
+class RecordingMemoryDelegate final : public MemorySnapshot::Delegate {
+ public:
+  RecordingMemoryDelegate() : data_(nullptr), contents_() {}
+  ~RecordingMemoryDelegate() override {}
+
+  const void* data() const { return data_; }
+  const std::string& contents() const { return contents_; }
+
+  // MemorySnapshot::Delegate:
+  bool MemorySnapshotDelegateRead(void* data, size_t size) override {
+    data_ = data;
+    contents_.assign(static_cast<const char*>(data), size);
+    return true;
+  }
+
+ private:
+  const void* data_;
+  std::string contents_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingMemoryDelegate);
+};
+
+// Writes a minidump file containing just a MINIDUMP_MEMORY_LIST stream with a
+// single range, at |kMemoryAddress|, containing |kMemoryContents|.
+constexpr uint64_t kMemoryAddress = 0xfedcba9876543210;
+constexpr char kMemoryContents[] = "memory range contents";
+
+void WriteMemoryListMinidump(FileWriterInterface* file_writer,
+                             RVA* memory_rva) {
+  MINIDUMP_HEADER header = {};
+  ASSERT_TRUE(file_writer->Write(&header, sizeof(header)));
+
+  MINIDUMP_DIRECTORY memory_list_directory = {};
+  memory_list_directory.StreamType = kMinidumpStreamTypeMemoryList;
+  memory_list_directory.Location.DataSize =
+      sizeof(MINIDUMP_MEMORY_LIST) + sizeof(MINIDUMP_MEMORY_DESCRIPTOR);
+
+  header.StreamDirectoryRva = sizeof(header);
+  memory_list_directory.Location.Rva =
+      header.StreamDirectoryRva + sizeof(memory_list_directory);
+  *memory_rva = memory_list_directory.Location.Rva +
+                memory_list_directory.Location.DataSize;
+
+  ASSERT_TRUE(file_writer->Write(&memory_list_directory,
+                                 sizeof(memory_list_directory)));
+
+  uint32_t range_count = 1;
+  ASSERT_TRUE(file_writer->Write(&range_count, sizeof(range_count)));
+
+  MINIDUMP_MEMORY_DESCRIPTOR memory_descriptor = {};
+  memory_descriptor.StartOfMemoryRange = kMemoryAddress;
+  memory_descriptor.Memory.DataSize = sizeof(kMemoryContents) - 1;
+  memory_descriptor.Memory.Rva = *memory_rva;
+  ASSERT_TRUE(
+      file_writer->Write(&memory_descriptor, sizeof(memory_descriptor)));
+
+  ASSERT_TRUE(
+      file_writer->Write(kMemoryContents, memory_descriptor.Memory.DataSize));
+
+  header.Signature = MINIDUMP_SIGNATURE;
+  header.Version = MINIDUMP_VERSION;
+  header.NumberOfStreams = 1;
+  ASSERT_TRUE(file_writer->SeekSet(0));
+  ASSERT_TRUE(file_writer->Write(&header, sizeof(header)));
+}
+
+TEST(ProcessSnapshotMinidump, ExtraMemory) {
+  StringFile string_file;
+  RVA memory_rva;
+  ASSERT_NO_FATAL_FAILURE(WriteMemoryListMinidump(&string_file, &memory_rva));
+
+  ProcessSnapshotMinidump process_snapshot;
+  ASSERT_TRUE(process_snapshot.Initialize(&string_file));
+
+  std::vector<const MemorySnapshot*> extra_memory =
+      process_snapshot.ExtraMemory();
+  ASSERT_EQ(extra_memory.size(), 1u);
+  EXPECT_EQ(extra_memory[0]->Address(), kMemoryAddress);
+  EXPECT_EQ(extra_memory[0]->Size(), sizeof(kMemoryContents) - 1);
+
+  RecordingMemoryDelegate delegate;
+  ASSERT_TRUE(extra_memory[0]->Read(&delegate));
+  EXPECT_EQ(delegate.contents(), kMemoryContents);
+}
+
+TEST(ProcessSnapshotMinidump, MappedFile) {
+  ScopedTempDir temp_dir;
+  base::FilePath path = temp_dir.path().Append(FILE_PATH_LITERAL("minidump"));
+  RVA memory_rva;
+  {
+    FileWriter file_writer;
+    ASSERT_TRUE(file_writer.Open(path,
+                                 FileWriteMode::kTruncateOrCreate,
+                                 FilePermissions::kOwnerOnly));
+    ASSERT_NO_FATAL_FAILURE(
+        WriteMemoryListMinidump(&file_writer, &memory_rva));
+  }
+
+  MappedFileReader mapped_file;
+  ASSERT_TRUE(mapped_file.Open(path));
+
+  ProcessSnapshotMinidump process_snapshot;
+  ASSERT_TRUE(process_snapshot.InitializeFromMappedFile(&mapped_file));
+
+  UUID client_id;
+  process_snapshot.ClientID(&client_id);
+  EXPECT_EQ(client_id, UUID());
+  EXPECT_TRUE(process_snapshot.Modules().empty());
+
+  std::vector<const MemorySnapshot*> extra_memory =
+      process_snapshot.ExtraMemory();
+  ASSERT_EQ(extra_memory.size(), 1u);
+  EXPECT_EQ(extra_memory[0]->Address(), kMemoryAddress);
+
+  // The memory’s contents are provided in place, from the mapping.
+  RecordingMemoryDelegate delegate;
+  ASSERT_TRUE(extra_memory[0]->Read(&delegate));
+  EXPECT_EQ(delegate.contents(), kMemoryContents);
+  EXPECT_EQ(delegate.data(),
+            mapped_file.DataAt(memory_rva, sizeof(kMemoryContents) - 1));
 }
 
 }  // namespace
@@ -0,0 +1,349 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/minidump/system_snapshot_minidump.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/strings/string16.h"
+#include "minidump/minidump_extensions.h"
+#include "snapshot/minidump/minidump_string_reader.h"
+#include "util/string/utf_conversion.h"
+
+namespace crashpad {
+namespace internal {
+
+namespace {
+
+// Maps cpuid feature bits to MINIDUMP_SYSTEM_INFO ProcessorFeatures bits. This
+// is the inverse of the mapping that MinidumpSystemInfoWriter uses for x86_64.
+struct FeatureBit {
+  int cpuid_bit;
+  int minidump_bit;
+};
+
+// cpuid 1 edx (low half) and ecx (high half).
+constexpr FeatureBit kFeatureBits[] = {
+    {4, PF_RDTSC_INSTRUCTION_AVAILABLE},
+    {6, PF_PAE_ENABLED},
+    {23, PF_MMX_INSTRUCTIONS_AVAILABLE},
+    {25, PF_XMMI_INSTRUCTIONS_AVAILABLE},
+    {26, PF_XMMI64_INSTRUCTIONS_AVAILABLE},
+    {32, PF_SSE3_INSTRUCTIONS_AVAILABLE},
+    {45, PF_COMPARE_EXCHANGE128},
+    {58, PF_XSAVE_ENABLED},
+    {62, PF_RDRAND_INSTRUCTION_AVAILABLE},
+};
+
+// cpuid 0x80000001 edx (low half) and ecx (high half).
+constexpr FeatureBit kExtendedFeatureBits[] = {
+    {27, PF_RDTSCP_INSTRUCTION_AVAILABLE},
+    {31, PF_3DNOW_INSTRUCTIONS_AVAILABLE},
+};
+
+// cpuid 7 ebx.
+constexpr FeatureBit kLeaf7FeatureBits[] = {
+    {0, PF_RDWRFSGSBASE_AVAILABLE},
+};
+
+// Converts a UTF-16 string in a buffer of |size| code units to UTF-8. The
+// string is NUL-terminated unless it fills the buffer.
+std::string FixedUTF16ToUTF8(const base::char16* buffer, size_t size) {
+  size_t length = 0;
+  while (length < size && buffer[length]) {
+    ++length;
+  }
+
+  std::string string;
+  TranscodeUTF16ToUTF8(buffer, length, &string);
+  return string;
+}
+
+}  // namespace
+
+SystemSnapshotMinidump::SystemSnapshotMinidump()
+    : SystemSnapshot(),
+      minidump_system_info_(),
+      misc_info_(),
+      csd_version_(),
+      build_string_(),
+      initialized_() {
+}
+
+SystemSnapshotMinidump::~SystemSnapshotMinidump() {
+}
+
+bool SystemSnapshotMinidump::Initialize(
+    FileReaderInterface* file_reader,
+    const MINIDUMP_LOCATION_DESCRIPTOR& location,
+    const MINIDUMP_MISC_INFO_N& misc_info) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  if (location.DataSize < sizeof(minidump_system_info_)) {
+    LOG(ERROR) << "system_info size mismatch";
+    return false;
+  }
+
+  if (!file_reader->SeekSet(location.Rva)) {
+    return false;
+  }
+
+  if (!file_reader->ReadExactly(&minidump_system_info_,
+                                sizeof(minidump_system_info_))) {
+    return false;
+  }
+
+  if (!ReadMinidumpUTF16String(
+          file_reader, minidump_system_info_.CSDVersionRva, &csd_version_)) {
+    return false;
+  }
+
+  misc_info_ = misc_info;
+  if (misc_info_.Flags1 & MINIDUMP_MISC4_BUILDSTRING) {
+    build_string_ = FixedUTF16ToUTF8(misc_info_.BuildString,
+                                     ARRAYSIZE_UNSAFE(misc_info_.BuildString));
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+CPUArchitecture SystemSnapshotMinidump::GetCPUArchitecture() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  switch (minidump_system_info_.ProcessorArchitecture) {
+    case kMinidumpCPUArchitectureX86:
+    case kMinidumpCPUArchitectureX86Win64:
+      return kCPUArchitectureX86;
+    case kMinidumpCPUArchitectureAMD64:
+      return kCPUArchitectureX86_64;
+    default:
+      return kCPUArchitectureUnknown;
+  }
+}
+
+uint32_t SystemSnapshotMinidump::CPURevision() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  const uint32_t level = minidump_system_info_.ProcessorLevel;
+  const uint32_t revision = minidump_system_info_.ProcessorRevision;
+  return (level << 16) | revision;
+}
+
+uint8_t SystemSnapshotMinidump::CPUCount() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_system_info_.NumberOfProcessors;
+}
+
+std::string SystemSnapshotMinidump::CPUVendor() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Only x86 minidump files carry the vendor.
+  if (GetCPUArchitecture() != kCPUArchitectureX86) {
+    return std::string();
+  }
+
+  std::string vendor(sizeof(minidump_system_info_.Cpu.X86CpuInfo.VendorId),
+                     '\0');
+  memcpy(&vendor[0],
+         minidump_system_info_.Cpu.X86CpuInfo.VendorId,
+         vendor.size());
+  return vendor;
+}
+
+void SystemSnapshotMinidump::CPUFrequency(uint64_t* current_hz,
+                                          uint64_t* max_hz) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  constexpr uint64_t kHzPerMHz = 1000000;
+  if (misc_info_.Flags1 & MINIDUMP_MISC1_PROCESSOR_POWER_INFO) {
+    *current_hz = misc_info_.ProcessorCurrentMhz * kHzPerMHz;
+    *max_hz = misc_info_.ProcessorMaxMhz * kHzPerMHz;
+  } else {
+    *current_hz = 0;
+    *max_hz = 0;
+  }
+}
+
+uint32_t SystemSnapshotMinidump::CPUX86Signature() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  if (GetCPUArchitecture() != kCPUArchitectureX86) {
+    return 0;
+  }
+  return minidump_system_info_.Cpu.X86CpuInfo.VersionInformation;
+}
+
+uint64_t SystemSnapshotMinidump::CPUX86Features() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  if (GetCPUArchitecture() == kCPUArchitectureX86) {
+    return minidump_system_info_.Cpu.X86CpuInfo.FeatureInformation;
+  }
+
+  uint64_t features = 0;
+  for (const FeatureBit& feature_bit : kFeatureBits) {
+    if (HasProcessorFeature(feature_bit.minidump_bit)) {
+      features |= UINT64_C(1) << feature_bit.cpuid_bit;
+    }
+  }
+  return features;
+}
+
+uint64_t SystemSnapshotMinidump::CPUX86ExtendedFeatures() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  if (GetCPUArchitecture() == kCPUArchitectureX86) {
+    return minidump_system_info_.Cpu.X86CpuInfo.AMDExtendedCpuFeatures;
+  }
+
+  uint64_t features = 0;
+  for (const FeatureBit& feature_bit : kExtendedFeatureBits) {
+    if (HasProcessorFeature(feature_bit.minidump_bit)) {
+      features |= UINT64_C(1) << feature_bit.cpuid_bit;
+    }
+  }
+  return features;
+}
+
+uint32_t SystemSnapshotMinidump::CPUX86Leaf7Features() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  uint32_t features = 0;
+  for (const FeatureBit& feature_bit : kLeaf7FeatureBits) {
+    if (HasProcessorFeature(feature_bit.minidump_bit)) {
+      features |= 1u << feature_bit.cpuid_bit;
+    }
+  }
+  return features;
+}
+
+bool SystemSnapshotMinidump::CPUX86SupportsDAZ() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return HasProcessorFeature(PF_SSE_DAZ_MODE_AVAILABLE);
+}
+
+SystemSnapshot::OperatingSystem SystemSnapshotMinidump::GetOperatingSystem()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  switch (minidump_system_info_.PlatformId) {
+    case kMinidumpOSMacOSX:
+      return kOperatingSystemMacOSX;
+    case kMinidumpOSWin32NT:
+      return kOperatingSystemWindows;
+    case kMinidumpOSLinux:
+      return kOperatingSystemLinux;
+    case kMinidumpOSAndroid:
+      return kOperatingSystemAndroid;
+    default:
+      return kOperatingSystemUnknown;
+  }
+}
+
+bool SystemSnapshotMinidump::OSServer() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_system_info_.ProductType == kMinidumpOSTypeServer;
+}
+
+void SystemSnapshotMinidump::OSVersion(int* major,
+                                       int* minor,
+                                       int* bugfix,
+                                       std::string* build) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  *major = minidump_system_info_.MajorVersion;
+  *minor = minidump_system_info_.MinorVersion;
+  *bugfix = minidump_system_info_.BuildNumber;
+  *build = csd_version_;
+}
+
+std::string SystemSnapshotMinidump::OSVersionFull() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // BuildString carries the full operating system version and the machine
+  // description joined together, and there’s no reliable way to separate
+  // them again.
+  return build_string_;
+}
+
+std::string SystemSnapshotMinidump::MachineDescription() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // See OSVersionFull().
+  return std::string();
+}
+
+bool SystemSnapshotMinidump::NXEnabled() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return HasProcessorFeature(PF_NX_ENABLED);
+}
+
+void SystemSnapshotMinidump::TimeZone(DaylightSavingTimeStatus* dst_status,
+                                      int* standard_offset_seconds,
+                                      int* daylight_offset_seconds,
+                                      std::string* standard_name,
+                                      std::string* daylight_name) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  if (!(misc_info_.Flags1 & MINIDUMP_MISC3_TIMEZONE)) {
+    *dst_status = kDoesNotObserveDaylightSavingTime;
+    *standard_offset_seconds = 0;
+    *daylight_offset_seconds = 0;
+    standard_name->clear();
+    daylight_name->clear();
+    return;
+  }
+
+  // TimeZoneId takes the same values as DaylightSavingTimeStatus:
+  // TIME_ZONE_ID_UNKNOWN, TIME_ZONE_ID_STANDARD, and TIME_ZONE_ID_DAYLIGHT.
+  switch (misc_info_.TimeZoneId) {
+    case kObservingStandardTime:
+    case kObservingDaylightSavingTime:
+      *dst_status =
+          static_cast<DaylightSavingTimeStatus>(misc_info_.TimeZoneId);
+      break;
+    default:
+      *dst_status = kDoesNotObserveDaylightSavingTime;
+      break;
+  }
+
+  // Bias is in minutes west of UTC, and DaylightBias is in minutes west of the
+  // standard offset.
+  *standard_offset_seconds = misc_info_.TimeZone.Bias * -60;
+  *daylight_offset_seconds =
+      *standard_offset_seconds - misc_info_.TimeZone.DaylightBias * 60;
+  *standard_name =
+      FixedUTF16ToUTF8(misc_info_.TimeZone.StandardName,
+                       ARRAYSIZE_UNSAFE(misc_info_.TimeZone.StandardName));
+  *daylight_name =
+      FixedUTF16ToUTF8(misc_info_.TimeZone.DaylightName,
+                       ARRAYSIZE_UNSAFE(misc_info_.TimeZone.DaylightName));
+}
+
+bool SystemSnapshotMinidump::HasProcessorFeature(int bit) const {
+  // Only x86_64 minidump files carry ProcessorFeatures. x86 minidump files
+  // carry X86CpuInfo in the same space.
+  if (GetCPUArchitecture() == kCPUArchitectureX86) {
+    return false;
+  }
+
+  const uint64_t features =
+      minidump_system_info_.Cpu.OtherCpuInfo.ProcessorFeatures[bit / 64];
+  return (features & (UINT64_C(1) << (bit % 64))) != 0;
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,106 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_MINIDUMP_SYSTEM_SNAPSHOT_MINIDUMP_H_
+#define CRASHPAD_SNAPSHOT_MINIDUMP_SYSTEM_SNAPSHOT_MINIDUMP_H_
+
+#include <windows.h>
+#include <dbghelp.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/macros.h"
+#include "snapshot/cpu_architecture.h"
+#include "snapshot/system_snapshot.h"
+#include "util/file/file_reader.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief A SystemSnapshot based on a MINIDUMP_SYSTEM_INFO stream in a
+//!     minidump file.
+//!
+//! Some of the information exposed through this interface is carried in the
+//! minidump file’s MINIDUMP_MISC_INFO stream, and some is carried only in
+//! reduced form. In particular, x86_64 CPU features are recovered from
+//! `ProcessorFeatures` bits, so only those features that have such bits are
+//! available, and the operating system version and machine description are
+//! both recovered from `BuildString` and exposed through OSVersionFull().
+class SystemSnapshotMinidump final : public SystemSnapshot {
+ public:
+  SystemSnapshotMinidump();
+  ~SystemSnapshotMinidump() override;
+
+  //! \brief Initializes the object.
+  //!
+  //! \param[in] file_reader A file reader corresponding to a minidump file.
+  //!     The file reader must support seeking.
+  //! \param[in] location The location of the MINIDUMP_SYSTEM_INFO stream in
+  //!     \a file_reader.
+  //! \param[in] misc_info The contents of the minidump file’s
+  //!     MINIDUMP_MISC_INFO stream. If the minidump file does not have such a
+  //!     stream, this should be zero-filled.
+  //!
+  //! \return `true` if the snapshot could be created, `false` otherwise with
+  //!     an appropriate message logged.
+  bool Initialize(FileReaderInterface* file_reader,
+                  const MINIDUMP_LOCATION_DESCRIPTOR& location,
+                  const MINIDUMP_MISC_INFO_N& misc_info);
+
+  // SystemSnapshot:
+
+  CPUArchitecture GetCPUArchitecture() const override;
+  uint32_t CPURevision() const override;
+  uint8_t CPUCount() const override;
+  std::string CPUVendor() const override;
+  void CPUFrequency(uint64_t* current_hz, uint64_t* max_hz) const override;
+  uint32_t CPUX86Signature() const override;
+  uint64_t CPUX86Features() const override;
+  uint64_t CPUX86ExtendedFeatures() const override;
+  uint32_t CPUX86Leaf7Features() const override;
+  bool CPUX86SupportsDAZ() const override;
+  OperatingSystem GetOperatingSystem() const override;
+  bool OSServer() const override;
+  void OSVersion(int* major,
+                 int* minor,
+                 int* bugfix,
+                 std::string* build) const override;
+  std::string OSVersionFull() const override;
+  std::string MachineDescription() const override;
+  bool NXEnabled() const override;
+  void TimeZone(DaylightSavingTimeStatus* dst_status,
+                int* standard_offset_seconds,
+                int* daylight_offset_seconds,
+                std::string* standard_name,
+                std::string* daylight_name) const override;
+
+ private:
+  // Returns whether the MINIDUMP_SYSTEM_INFO sets ProcessorFeatures bit |bit|.
+  bool HasProcessorFeature(int bit) const;
+
+  MINIDUMP_SYSTEM_INFO minidump_system_info_;
+  MINIDUMP_MISC_INFO_N misc_info_;
+  std::string csd_version_;
+  std::string build_string_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(SystemSnapshotMinidump);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_MINIDUMP_SYSTEM_SNAPSHOT_MINIDUMP_H_
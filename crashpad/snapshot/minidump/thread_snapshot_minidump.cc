@@ -0,0 +1,115 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/minidump/thread_snapshot_minidump.h"
+
+namespace crashpad {
+namespace internal {
+
+ThreadSnapshotMinidump::ThreadSnapshotMinidump()
+    : ThreadSnapshot(),
+      minidump_thread_(),
+      context_(),
+      stack_(),
+      initialized_() {
+}
+
+ThreadSnapshotMinidump::~ThreadSnapshotMinidump() {
+}
+
+bool ThreadSnapshotMinidump::Initialize(FileReaderInterface* file_reader,
+                                        const MappedFileReader* mapped_file,
+                                        RVA minidump_thread_rva,
+                                        CPUArchitecture architecture) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  if (!file_reader->SeekSet(minidump_thread_rva)) {
+    return false;
+  }
+
+  if (!file_reader->ReadExactly(&minidump_thread_, sizeof(minidump_thread_))) {
+    return false;
+  }
+
+  if (!context_.Initialize(
+          file_reader, architecture, minidump_thread_.ThreadContext)) {
+    return false;
+  }
+
+  if (!stack_.Initialize(file_reader, mapped_file, minidump_thread_.Stack)) {
+    return false;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+const MINIDUMP_MEMORY_DESCRIPTOR& ThreadSnapshotMinidump::StackDescriptor()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_thread_.Stack;
+}
+
+const CPUContext* ThreadSnapshotMinidump::Context() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return context_.Get();
+}
+
+const MemorySnapshot* ThreadSnapshotMinidump::Stack() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // A thread without a stack is written with an empty memory descriptor.
+  return stack_.Size() ? &stack_ : nullptr;
+}
+
+uint64_t ThreadSnapshotMinidump::ThreadID() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_thread_.ThreadId;
+}
+
+std::string ThreadSnapshotMinidump::ThreadName() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Thread names are carried in the MINIDUMP_THREAD_NAME_LIST stream, which is
+  // not yet read.
+  return std::string();
+}
+
+int ThreadSnapshotMinidump::SuspendCount() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_thread_.SuspendCount;
+}
+
+int ThreadSnapshotMinidump::Priority() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_thread_.Priority;
+}
+
+uint64_t ThreadSnapshotMinidump::ThreadSpecificDataAddress() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return minidump_thread_.Teb;
+}
+
+std::vector<const MemorySnapshot*> ThreadSnapshotMinidump::ExtraMemory()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Memory referenced from the thread is carried in the MINIDUMP_MEMORY_LIST
+  // stream alongside all other memory, and is available through
+  // ProcessSnapshotMinidump::ExtraMemory().
+  return std::vector<const MemorySnapshot*>();
+}
+
+}  // namespace internal
+}  // namespace crashpad
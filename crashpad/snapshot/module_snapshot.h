@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 
+#include "snapshot/annotation_snapshot.h"
 #include "snapshot/memory_snapshot.h"
 #include "util/misc/uuid.h"
 #include "util/numeric/checked_range.h"
@@ -195,6 +196,29 @@ class ModuleSnapshot {
   //! ProcessSnapshot::AnnotationsSimpleMap().
   virtual std::map<std::string, std::string> AnnotationsSimpleMap() const = 0;
 
+  //! \brief Returns typed annotations recorded in the module.
+  //!
+  //! These annotations are found by following the AnnotationList registered
+  //! with the module’s CrashpadInfo structure. Only annotations that were set
+  //! at the time of the snapshot are returned, most recently added first.
+  //!
+  //! The annotations returned by this method do not duplicate those returned by
+  //! AnnotationsVector() or AnnotationsSimpleMap().
+  virtual std::vector<AnnotationSnapshot> AnnotationObjects() const = 0;
+
+  //! \brief Returns typed annotations recorded in the module on behalf of
+  //!     individual threads.
+  //!
+  //! These annotations are found by following the ThreadAnnotationRegistry
+  //! registered with the module’s CrashpadInfo structure. The returned map is
+  //! keyed by thread ID, as returned by ThreadSnapshot::ThreadID(). Threads
+  //! with no annotations set at the time of the snapshot do not appear.
+  //!
+  //! The annotations returned by this method do not duplicate those returned by
+  //! AnnotationObjects().
+  virtual std::map<uint64_t, std::vector<AnnotationSnapshot>>
+  ThreadAnnotationObjects() const = 0;
+
   //! \brief Returns a set of extra memory ranges specified in the module as
   //!     being desirable to include in the crash dump.
   virtual std::set<CheckedRange<uint64_t>> ExtraMemoryRanges() const = 0;
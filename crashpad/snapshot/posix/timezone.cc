@@ -15,25 +15,28 @@
 #include "snapshot/posix/timezone.h"
 
 #include <stddef.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 #include <time.h>
 
+#include <tuple>
+
 #include "base/logging.h"
 #include "build/build_config.h"
 
 namespace crashpad {
 namespace internal {
 
-void TimeZone(const timeval& snapshot_time,
-              SystemSnapshot::DaylightSavingTimeStatus* dst_status,
-              int* standard_offset_seconds,
-              int* daylight_offset_seconds,
-              std::string* standard_name,
-              std::string* daylight_name) {
-  tzset();
-
-  tm local;
-  PCHECK(localtime_r(&snapshot_time.tv_sec, &local)) << "localtime_r";
+namespace {
 
+// Determines the time zone information for |local|, which must have been
+// obtained from localtime_r() after calling tzset().
+void TimeZoneForLocalTime(const tm& local,
+                          SystemSnapshot::DaylightSavingTimeStatus* dst_status,
+                          int* standard_offset_seconds,
+                          int* daylight_offset_seconds,
+                          std::string* standard_name,
+                          std::string* daylight_name) {
   *standard_name = tzname[0];
 
   bool found_transition = false;
@@ -114,5 +117,127 @@ void TimeZone(const timeval& snapshot_time,
   }
 }
 
+}  // namespace
+
+void TimeZone(const timeval& snapshot_time,
+              SystemSnapshot::DaylightSavingTimeStatus* dst_status,
+              int* standard_offset_seconds,
+              int* daylight_offset_seconds,
+              std::string* standard_name,
+              std::string* daylight_name) {
+  tzset();
+
+  tm local;
+  PCHECK(localtime_r(&snapshot_time.tv_sec, &local)) << "localtime_r";
+
+  TimeZoneForLocalTime(local,
+                       dst_status,
+                       standard_offset_seconds,
+                       daylight_offset_seconds,
+                       standard_name,
+                       daylight_name);
+}
+
+bool TimeZoneCache::Key::operator==(const Key& other) const {
+  return std::tie(tz_set,
+                  tz,
+                  localtime_device,
+                  localtime_inode,
+                  localtime_modification_time,
+                  standard_name,
+                  daylight_name,
+                  timezone,
+                  daylight,
+                  year,
+                  month,
+                  day,
+                  is_dst,
+                  gmt_offset) == std::tie(other.tz_set,
+                                          other.tz,
+                                          other.localtime_device,
+                                          other.localtime_inode,
+                                          other.localtime_modification_time,
+                                          other.standard_name,
+                                          other.daylight_name,
+                                          other.timezone,
+                                          other.daylight,
+                                          other.year,
+                                          other.month,
+                                          other.day,
+                                          other.is_dst,
+                                          other.gmt_offset);
+}
+
+TimeZoneCache::TimeZoneCache()
+    : key_(),
+      standard_name_(),
+      daylight_name_(),
+      dst_status_(SystemSnapshot::kDoesNotObserveDaylightSavingTime),
+      standard_offset_seconds_(0),
+      daylight_offset_seconds_(0),
+      valid_(false),
+      lock_() {}
+
+TimeZoneCache::~TimeZoneCache() {}
+
+void TimeZoneCache::TimeZone(
+    const timeval& snapshot_time,
+    SystemSnapshot::DaylightSavingTimeStatus* dst_status,
+    int* standard_offset_seconds,
+    int* daylight_offset_seconds,
+    std::string* standard_name,
+    std::string* daylight_name) {
+  base::AutoLock lock(lock_);
+
+  tzset();
+
+  tm local;
+  PCHECK(localtime_r(&snapshot_time.tv_sec, &local)) << "localtime_r";
+
+  // The result depends only on the time zone’s rules and on the local date and
+  // daylight saving time status at the snapshot time. The rules are identified
+  // by the TZ environment variable, or the file that the system’s default time
+  // zone is read from, along with what tzset() made of them.
+  Key key = {};
+  const char* tz = getenv("TZ");
+  key.tz_set = tz != nullptr;
+  if (tz) {
+    key.tz = tz;
+  } else {
+    struct stat localtime_stat;
+    if (stat("/etc/localtime", &localtime_stat) == 0) {
+      key.localtime_device = localtime_stat.st_dev;
+      key.localtime_inode = localtime_stat.st_ino;
+      key.localtime_modification_time = localtime_stat.st_mtime;
+    }
+  }
+  key.standard_name = tzname[0];
+  key.daylight_name = tzname[1];
+  key.timezone = ::timezone;
+  key.daylight = ::daylight;
+  key.year = local.tm_year;
+  key.month = local.tm_mon;
+  key.day = local.tm_mday;
+  key.is_dst = local.tm_isdst;
+  key.gmt_offset = local.tm_gmtoff;
+
+  if (!valid_ || !(key == key_)) {
+    TimeZoneForLocalTime(local,
+                         &dst_status_,
+                         &standard_offset_seconds_,
+                         &daylight_offset_seconds_,
+                         &standard_name_,
+                         &daylight_name_);
+    key_ = key;
+    valid_ = true;
+  }
+
+  *dst_status = dst_status_;
+  *standard_offset_seconds = standard_offset_seconds_;
+  *daylight_offset_seconds = daylight_offset_seconds_;
+  *standard_name = standard_name_;
+  *daylight_name = daylight_name_;
+}
+
 }  // namespace internal
 }  // namespace crashpad
@@ -16,9 +16,12 @@
 #define CRASHPAD_SNAPSHOT_POSIX_TIMEZONE_H_
 
 #include <sys/time.h>
+#include <sys/types.h>
 
 #include <string>
 
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
 #include "snapshot/system_snapshot.h"
 
 namespace crashpad {
@@ -49,6 +52,63 @@ void TimeZone(const timeval& snapshot_time,
               std::string* standard_name,
               std::string* daylight_name);
 
+//! \brief Caches the results of TimeZone() for a process that takes many
+//!     snapshots.
+//!
+//! TimeZone() probes a year’s worth of dates to find the time zone’s
+//! transitions. The result only changes when the time zone does, or when the
+//! snapshot time falls on a different local date or on the other side of a
+//! transition, so it’s computed again only then. Determining that costs just
+//! a call to `tzset()`, one to `localtime_r()`, and `stat()` of the time zone
+//! file.
+//!
+//! This class is thread-safe.
+class TimeZoneCache {
+ public:
+  TimeZoneCache();
+  ~TimeZoneCache();
+
+  //! \brief Returns the same results as internal::TimeZone(), computing them
+  //!     only if they may differ from those last returned.
+  void TimeZone(const timeval& snapshot_time,
+                SystemSnapshot::DaylightSavingTimeStatus* dst_status,
+                int* standard_offset_seconds,
+                int* daylight_offset_seconds,
+                std::string* standard_name,
+                std::string* daylight_name);
+
+ private:
+  struct Key {
+    bool operator==(const Key& other) const;
+
+    bool tz_set;
+    std::string tz;
+    dev_t localtime_device;
+    ino_t localtime_inode;
+    time_t localtime_modification_time;
+    std::string standard_name;
+    std::string daylight_name;
+    long timezone;
+    int daylight;
+    int year;
+    int month;
+    int day;
+    int is_dst;
+    long gmt_offset;
+  };
+
+  Key key_;
+  std::string standard_name_;
+  std::string daylight_name_;
+  SystemSnapshot::DaylightSavingTimeStatus dst_status_;
+  int standard_offset_seconds_;
+  int daylight_offset_seconds_;
+  bool valid_;
+  base::Lock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimeZoneCache);
+};
+
 }  // namespace internal
 }  // namespace crashpad
 
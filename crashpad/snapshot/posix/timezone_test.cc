@@ -191,6 +191,62 @@ TEST(TimeZone, Basic) {
   }
 }
 
+TEST(TimeZoneCache, MatchesTimeZone) {
+  timeval snapshot_time;
+  ASSERT_EQ(gettimeofday(&snapshot_time, nullptr), 0);
+
+  internal::TimeZoneCache cache;
+
+  // Returning to a time zone after visiting others must not return a result
+  // cached for another.
+  static constexpr const char* kTestTimeZones[] = {
+      "America/New_York",
+      "Asia/Kolkata",
+      "America/New_York",
+      "America/New_York",
+      "Europe/London",
+      "UTC",
+      "Europe/London",
+  };
+
+  for (size_t index = 0; index < arraysize(kTestTimeZones); ++index) {
+    const char* tz = kTestTimeZones[index];
+    SCOPED_TRACE(base::StringPrintf("index %zu, tz %s", index, tz));
+
+    ScopedSetTZ set_tz(tz);
+
+    SystemSnapshot::DaylightSavingTimeStatus expect_dst_status;
+    int expect_standard_offset_seconds;
+    int expect_daylight_offset_seconds;
+    std::string expect_standard_name;
+    std::string expect_daylight_name;
+    internal::TimeZone(snapshot_time,
+                       &expect_dst_status,
+                       &expect_standard_offset_seconds,
+                       &expect_daylight_offset_seconds,
+                       &expect_standard_name,
+                       &expect_daylight_name);
+
+    SystemSnapshot::DaylightSavingTimeStatus dst_status;
+    int standard_offset_seconds;
+    int daylight_offset_seconds;
+    std::string standard_name;
+    std::string daylight_name;
+    cache.TimeZone(snapshot_time,
+                   &dst_status,
+                   &standard_offset_seconds,
+                   &daylight_offset_seconds,
+                   &standard_name,
+                   &daylight_name);
+
+    EXPECT_EQ(dst_status, expect_dst_status);
+    EXPECT_EQ(standard_offset_seconds, expect_standard_offset_seconds);
+    EXPECT_EQ(daylight_offset_seconds, expect_daylight_offset_seconds);
+    EXPECT_EQ(standard_name, expect_standard_name);
+    EXPECT_EQ(daylight_name, expect_daylight_name);
+  }
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
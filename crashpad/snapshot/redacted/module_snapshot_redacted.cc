@@ -0,0 +1,144 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/redacted/module_snapshot_redacted.h"
+
+#include <algorithm>
+
+namespace crashpad {
+namespace internal {
+
+ModuleSnapshotRedacted::ModuleSnapshotRedacted(const ModuleSnapshot* snapshot,
+                                               const RedactionPolicy* policy)
+    : ModuleSnapshot(), snapshot_(snapshot), policy_(policy) {
+}
+
+ModuleSnapshotRedacted::~ModuleSnapshotRedacted() {
+}
+
+std::string ModuleSnapshotRedacted::Name() const {
+  return snapshot_->Name();
+}
+
+uint64_t ModuleSnapshotRedacted::Address() const {
+  return snapshot_->Address();
+}
+
+uint64_t ModuleSnapshotRedacted::Size() const {
+  return snapshot_->Size();
+}
+
+time_t ModuleSnapshotRedacted::Timestamp() const {
+  return snapshot_->Timestamp();
+}
+
+void ModuleSnapshotRedacted::FileVersion(uint16_t* version_0,
+                                         uint16_t* version_1,
+                                         uint16_t* version_2,
+                                         uint16_t* version_3) const {
+  snapshot_->FileVersion(version_0, version_1, version_2, version_3);
+}
+
+void ModuleSnapshotRedacted::SourceVersion(uint16_t* version_0,
+                                           uint16_t* version_1,
+                                           uint16_t* version_2,
+                                           uint16_t* version_3) const {
+  snapshot_->SourceVersion(version_0, version_1, version_2, version_3);
+}
+
+ModuleSnapshot::ModuleType ModuleSnapshotRedacted::GetModuleType() const {
+  return snapshot_->GetModuleType();
+}
+
+void ModuleSnapshotRedacted::UUIDAndAge(crashpad::UUID* uuid,
+                                        uint32_t* age) const {
+  snapshot_->UUIDAndAge(uuid, age);
+}
+
+std::string ModuleSnapshotRedacted::DebugFileName() const {
+  return snapshot_->DebugFileName();
+}
+
+std::vector<std::string> ModuleSnapshotRedacted::AnnotationsVector() const {
+  return snapshot_->AnnotationsVector();
+}
+
+std::map<std::string, std::string>
+ModuleSnapshotRedacted::AnnotationsSimpleMap() const {
+  std::map<std::string, std::string> annotations_simple_map =
+      snapshot_->AnnotationsSimpleMap();
+  for (auto it = annotations_simple_map.begin();
+       it != annotations_simple_map.end();) {
+    if (RedactionPolicyStripsAnnotation(*policy_, it->first)) {
+      it = annotations_simple_map.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return annotations_simple_map;
+}
+
+std::vector<AnnotationSnapshot> ModuleSnapshotRedacted::AnnotationObjects()
+    const {
+  std::vector<AnnotationSnapshot> annotation_objects =
+      snapshot_->AnnotationObjects();
+  annotation_objects.erase(
+      std::remove_if(annotation_objects.begin(),
+                     annotation_objects.end(),
+                     [this](const AnnotationSnapshot& annotation) {
+                       return RedactionPolicyStripsAnnotation(*policy_,
+                                                              annotation.name);
+                     }),
+      annotation_objects.end());
+  return annotation_objects;
+}
+
+std::map<uint64_t, std::vector<AnnotationSnapshot>>
+ModuleSnapshotRedacted::ThreadAnnotationObjects() const {
+  std::map<uint64_t, std::vector<AnnotationSnapshot>> thread_annotations =
+      snapshot_->ThreadAnnotationObjects();
+  for (auto it = thread_annotations.begin(); it != thread_annotations.end();) {
+    std::vector<AnnotationSnapshot>& annotation_objects = it->second;
+    annotation_objects.erase(
+        std::remove_if(annotation_objects.begin(),
+                       annotation_objects.end(),
+                       [this](const AnnotationSnapshot& annotation) {
+                         return RedactionPolicyStripsAnnotation(
+                             *policy_, annotation.name);
+                       }),
+        annotation_objects.end());
+    if (annotation_objects.empty()) {
+      it = thread_annotations.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return thread_annotations;
+}
+
+std::set<CheckedRange<uint64_t>> ModuleSnapshotRedacted::ExtraMemoryRanges()
+    const {
+  if (policy_->drop_extra_memory) {
+    return std::set<CheckedRange<uint64_t>>();
+  }
+  return snapshot_->ExtraMemoryRanges();
+}
+
+std::vector<const UserMinidumpStream*>
+ModuleSnapshotRedacted::CustomMinidumpStreams() const {
+  return snapshot_->CustomMinidumpStreams();
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,82 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_REDACTED_MODULE_SNAPSHOT_REDACTED_H_
+#define CRASHPAD_SNAPSHOT_REDACTED_MODULE_SNAPSHOT_REDACTED_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "snapshot/module_snapshot.h"
+#include "snapshot/redacted/redaction_policy.h"
+#include "util/misc/uuid.h"
+#include "util/numeric/checked_range.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief A ModuleSnapshot that presents another ModuleSnapshot with the
+//!     information removed by a RedactionPolicy.
+class ModuleSnapshotRedacted final : public ModuleSnapshot {
+ public:
+  //! \param[in] snapshot The module snapshot to redact. This object does not
+  //!     take ownership of \a snapshot, which must outlive it.
+  //! \param[in] policy The policy to apply. This object does not take
+  //!     ownership of \a policy, which must outlive it.
+  ModuleSnapshotRedacted(const ModuleSnapshot* snapshot,
+                         const RedactionPolicy* policy);
+  ~ModuleSnapshotRedacted() override;
+
+  // ModuleSnapshot:
+
+  std::string Name() const override;
+  uint64_t Address() const override;
+  uint64_t Size() const override;
+  time_t Timestamp() const override;
+  void FileVersion(uint16_t* version_0,
+                   uint16_t* version_1,
+                   uint16_t* version_2,
+                   uint16_t* version_3) const override;
+  void SourceVersion(uint16_t* version_0,
+                     uint16_t* version_1,
+                     uint16_t* version_2,
+                     uint16_t* version_3) const override;
+  ModuleType GetModuleType() const override;
+  void UUIDAndAge(crashpad::UUID* uuid, uint32_t* age) const override;
+  std::string DebugFileName() const override;
+  std::vector<std::string> AnnotationsVector() const override;
+  std::map<std::string, std::string> AnnotationsSimpleMap() const override;
+  std::vector<AnnotationSnapshot> AnnotationObjects() const override;
+  std::map<uint64_t, std::vector<AnnotationSnapshot>> ThreadAnnotationObjects()
+      const override;
+  std::set<CheckedRange<uint64_t>> ExtraMemoryRanges() const override;
+  std::vector<const UserMinidumpStream*> CustomMinidumpStreams() const override;
+
+ private:
+  const ModuleSnapshot* snapshot_;  // weak
+  const RedactionPolicy* policy_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ModuleSnapshotRedacted);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_REDACTED_MODULE_SNAPSHOT_REDACTED_H_
@@ -0,0 +1,191 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/redacted/process_snapshot_redacted.h"
+
+#include <windows.h>
+#include <dbghelp.h>
+
+#include <algorithm>
+
+namespace crashpad {
+
+namespace {
+
+bool IsCommitted(const MemoryMapRegionSnapshot* region) {
+  return region->AsMinidumpMemoryInfo().State == MEM_COMMIT;
+}
+
+}  // namespace
+
+ProcessSnapshotRedacted::ProcessSnapshotRedacted()
+    : ProcessSnapshot(),
+      policy_(),
+      annotations_simple_map_(),
+      modules_(),
+      memory_map_(),
+      snapshot_(nullptr),
+      initialized_() {
+}
+
+ProcessSnapshotRedacted::~ProcessSnapshotRedacted() {
+}
+
+bool ProcessSnapshotRedacted::Initialize(const ProcessSnapshot* snapshot,
+                                         const RedactionPolicy& policy) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  snapshot_ = snapshot;
+  policy_ = policy;
+
+  for (const auto& kv : snapshot_->AnnotationsSimpleMap()) {
+    if (!RedactionPolicyStripsAnnotation(policy_, kv.first)) {
+      annotations_simple_map_.insert(kv);
+    }
+  }
+
+  for (const ModuleSnapshot* module : snapshot_->Modules()) {
+    modules_.push_back(new internal::ModuleSnapshotRedacted(module, &policy_));
+  }
+
+  std::vector<const MemoryMapRegionSnapshot*> memory_map =
+      snapshot_->MemoryMap();
+  const size_t max_regions = policy_.max_memory_map_regions;
+  if (max_regions && memory_map.size() > max_regions) {
+    // Retain as many committed regions as possible, filling any remaining
+    // room with other regions, and keep the survivors in their original order.
+    const size_t committed_count = std::count_if(
+        memory_map.begin(), memory_map.end(), IsCommitted);
+    size_t committed_room = std::min(committed_count, max_regions);
+    size_t other_room = max_regions - committed_room;
+    for (const MemoryMapRegionSnapshot* region : memory_map) {
+      size_t* room = IsCommitted(region) ? &committed_room : &other_room;
+      if (*room) {
+        memory_map_.push_back(region);
+        --*room;
+      }
+    }
+  } else {
+    memory_map_.swap(memory_map);
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+pid_t ProcessSnapshotRedacted::ProcessID() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return snapshot_->ProcessID();
+}
+
+pid_t ProcessSnapshotRedacted::ParentProcessID() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return snapshot_->ParentProcessID();
+}
+
+void ProcessSnapshotRedacted::SnapshotTime(timeval* snapshot_time) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  snapshot_->SnapshotTime(snapshot_time);
+}
+
+void ProcessSnapshotRedacted::ProcessStartTime(timeval* start_time) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  snapshot_->ProcessStartTime(start_time);
+}
+
+void ProcessSnapshotRedacted::ProcessCPUTimes(timeval* user_time,
+                                              timeval* system_time) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  snapshot_->ProcessCPUTimes(user_time, system_time);
+}
+
+void ProcessSnapshotRedacted::ReportID(UUID* report_id) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  snapshot_->ReportID(report_id);
+}
+
+void ProcessSnapshotRedacted::ClientID(UUID* client_id) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  snapshot_->ClientID(client_id);
+}
+
+const std::map<std::string, std::string>&
+ProcessSnapshotRedacted::AnnotationsSimpleMap() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return annotations_simple_map_;
+}
+
+const SystemSnapshot* ProcessSnapshotRedacted::System() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return snapshot_->System();
+}
+
+std::vector<const ThreadSnapshot*> ProcessSnapshotRedacted::Threads() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  std::vector<const ThreadSnapshot*> threads = snapshot_->Threads();
+  const ExceptionSnapshot* exception = snapshot_->Exception();
+  if (!policy_.crashing_thread_only || !exception) {
+    return threads;
+  }
+
+  std::vector<const ThreadSnapshot*> crashing_threads;
+  for (const ThreadSnapshot* thread : threads) {
+    if (thread->ThreadID() == exception->ThreadID()) {
+      crashing_threads.push_back(thread);
+    }
+  }
+  return crashing_threads;
+}
+
+std::vector<const ModuleSnapshot*> ProcessSnapshotRedacted::Modules() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  std::vector<const ModuleSnapshot*> modules;
+  for (internal::ModuleSnapshotRedacted* module : modules_) {
+    modules.push_back(module);
+  }
+  return modules;
+}
+
+std::vector<UnloadedModuleSnapshot> ProcessSnapshotRedacted::UnloadedModules()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return snapshot_->UnloadedModules();
+}
+
+const ExceptionSnapshot* ProcessSnapshotRedacted::Exception() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return snapshot_->Exception();
+}
+
+std::vector<const MemoryMapRegionSnapshot*> ProcessSnapshotRedacted::MemoryMap()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return memory_map_;
+}
+
+std::vector<HandleSnapshot> ProcessSnapshotRedacted::Handles() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return snapshot_->Handles();
+}
+
+std::vector<const MemorySnapshot*> ProcessSnapshotRedacted::ExtraMemory()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  if (policy_.drop_extra_memory) {
+    return std::vector<const MemorySnapshot*>();
+  }
+  return snapshot_->ExtraMemory();
+}
+
+}  // namespace crashpad
@@ -0,0 +1,101 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_REDACTED_PROCESS_SNAPSHOT_REDACTED_H_
+#define CRASHPAD_SNAPSHOT_REDACTED_PROCESS_SNAPSHOT_REDACTED_H_
+
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "snapshot/exception_snapshot.h"
+#include "snapshot/handle_snapshot.h"
+#include "snapshot/memory_map_region_snapshot.h"
+#include "snapshot/memory_snapshot.h"
+#include "snapshot/module_snapshot.h"
+#include "snapshot/process_snapshot.h"
+#include "snapshot/redacted/module_snapshot_redacted.h"
+#include "snapshot/redacted/redaction_policy.h"
+#include "snapshot/system_snapshot.h"
+#include "snapshot/thread_snapshot.h"
+#include "snapshot/unloaded_module_snapshot.h"
+#include "util/misc/initialization_state_dcheck.h"
+#include "util/misc/uuid.h"
+#include "util/stdlib/pointer_container.h"
+
+namespace crashpad {
+
+//! \brief A ProcessSnapshot that presents another ProcessSnapshot with the
+//!     information removed by a RedactionPolicy.
+//!
+//! This is intended to be placed in front of a ProcessSnapshotMinidump and
+//! handed to MinidumpFileWriter::InitializeFromSnapshot() to produce a reduced
+//! minidump file, such as one suitable for upload, from a complete one.
+//!
+//! Thread stacks and contexts, the exception, and the system snapshot are
+//! passed through unchanged.
+class ProcessSnapshotRedacted final : public ProcessSnapshot {
+ public:
+  ProcessSnapshotRedacted();
+  ~ProcessSnapshotRedacted() override;
+
+  //! \brief Initializes the object.
+  //!
+  //! \param[in] snapshot The process snapshot to redact. This object does not
+  //!     take ownership of \a snapshot, which must outlive it.
+  //! \param[in] policy The policy to apply.
+  //!
+  //! \return `true` if the snapshot could be created, `false` otherwise with
+  //!     an appropriate message logged.
+  bool Initialize(const ProcessSnapshot* snapshot,
+                  const RedactionPolicy& policy);
+
+  // ProcessSnapshot:
+
+  pid_t ProcessID() const override;
+  pid_t ParentProcessID() const override;
+  void SnapshotTime(timeval* snapshot_time) const override;
+  void ProcessStartTime(timeval* start_time) const override;
+  void ProcessCPUTimes(timeval* user_time, timeval* system_time) const override;
+  void ReportID(UUID* report_id) const override;
+  void ClientID(UUID* client_id) const override;
+  const std::map<std::string, std::string>& AnnotationsSimpleMap()
+      const override;
+  const SystemSnapshot* System() const override;
+  std::vector<const ThreadSnapshot*> Threads() const override;
+  std::vector<const ModuleSnapshot*> Modules() const override;
+  std::vector<UnloadedModuleSnapshot> UnloadedModules() const override;
+  const ExceptionSnapshot* Exception() const override;
+  std::vector<const MemoryMapRegionSnapshot*> MemoryMap() const override;
+  std::vector<HandleSnapshot> Handles() const override;
+  std::vector<const MemorySnapshot*> ExtraMemory() const override;
+
+ private:
+  RedactionPolicy policy_;
+  std::map<std::string, std::string> annotations_simple_map_;
+  PointerVector<internal::ModuleSnapshotRedacted> modules_;
+  std::vector<const MemoryMapRegionSnapshot*> memory_map_;
+  const ProcessSnapshot* snapshot_;  // weak
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProcessSnapshotRedacted);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_REDACTED_PROCESS_SNAPSHOT_REDACTED_H_
@@ -0,0 +1,201 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/redacted/process_snapshot_redacted.h"
+
+#include <windows.h>
+#include <dbghelp.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/ptr_util.h"
+#include "gtest/gtest.h"
+#include "snapshot/test/test_exception_snapshot.h"
+#include "snapshot/test/test_memory_map_region_snapshot.h"
+#include "snapshot/test/test_memory_snapshot.h"
+#include "snapshot/test/test_module_snapshot.h"
+#include "snapshot/test/test_process_snapshot.h"
+#include "snapshot/test/test_thread_snapshot.h"
+#include "util/numeric/checked_range.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+void AddMemoryMapRegion(TestProcessSnapshot* process_snapshot,
+                        uint64_t base_address,
+                        uint32_t state) {
+  MINIDUMP_MEMORY_INFO memory_info = {};
+  memory_info.BaseAddress = base_address;
+  memory_info.RegionSize = 0x1000;
+  memory_info.State = state;
+  auto region = base::WrapUnique(new TestMemoryMapRegionSnapshot());
+  region->SetMindumpMemoryInfo(memory_info);
+  process_snapshot->AddMemoryMapRegion(std::move(region));
+}
+
+TEST(ProcessSnapshotRedacted, EmptyPolicy) {
+  TestProcessSnapshot process_snapshot;
+  std::map<std::string, std::string> annotations_simple_map;
+  annotations_simple_map["key"] = "value";
+  process_snapshot.SetAnnotationsSimpleMap(annotations_simple_map);
+  process_snapshot.AddExtraMemory(
+      base::WrapUnique(new TestMemorySnapshot()));
+  AddMemoryMapRegion(&process_snapshot, 0x1000, MEM_FREE);
+
+  RedactionPolicy policy;
+  EXPECT_TRUE(RedactionPolicyIsEmpty(policy));
+
+  ProcessSnapshotRedacted redacted_snapshot;
+  ASSERT_TRUE(redacted_snapshot.Initialize(&process_snapshot, policy));
+  EXPECT_EQ(redacted_snapshot.AnnotationsSimpleMap(), annotations_simple_map);
+  EXPECT_EQ(redacted_snapshot.ExtraMemory().size(), 1u);
+  EXPECT_EQ(redacted_snapshot.MemoryMap().size(), 1u);
+}
+
+TEST(ProcessSnapshotRedacted, Annotations) {
+  TestProcessSnapshot process_snapshot;
+  std::map<std::string, std::string> annotations_simple_map;
+  annotations_simple_map["url"] = "https://example.com/";
+  annotations_simple_map["url-chunk-1"] = "https://";
+  annotations_simple_map["ver"] = "1.0";
+  process_snapshot.SetAnnotationsSimpleMap(annotations_simple_map);
+
+  auto module_snapshot = base::WrapUnique(new TestModuleSnapshot());
+  std::map<std::string, std::string> module_annotations_simple_map;
+  module_annotations_simple_map["email"] = "user@example.com";
+  module_annotations_simple_map["ptype"] = "renderer";
+  module_snapshot->SetAnnotationsSimpleMap(module_annotations_simple_map);
+  std::vector<AnnotationSnapshot> module_annotation_objects;
+  module_annotation_objects.push_back(
+      AnnotationSnapshot("email-domain", 1, std::vector<uint8_t>(1, 'e')));
+  module_annotation_objects.push_back(
+      AnnotationSnapshot("tab-count", 2, std::vector<uint8_t>(8, 0)));
+  module_snapshot->SetAnnotationObjects(module_annotation_objects);
+  process_snapshot.AddModule(std::move(module_snapshot));
+
+  RedactionPolicy policy;
+  policy.annotation_key_prefixes.push_back("url");
+  policy.annotation_key_prefixes.push_back("email");
+  EXPECT_FALSE(RedactionPolicyIsEmpty(policy));
+
+  ProcessSnapshotRedacted redacted_snapshot;
+  ASSERT_TRUE(redacted_snapshot.Initialize(&process_snapshot, policy));
+
+  const std::map<std::string, std::string>& redacted_annotations =
+      redacted_snapshot.AnnotationsSimpleMap();
+  ASSERT_EQ(redacted_annotations.size(), 1u);
+  EXPECT_EQ(redacted_annotations.begin()->first, "ver");
+
+  ASSERT_EQ(redacted_snapshot.Modules().size(), 1u);
+  std::map<std::string, std::string> redacted_module_annotations =
+      redacted_snapshot.Modules()[0]->AnnotationsSimpleMap();
+  ASSERT_EQ(redacted_module_annotations.size(), 1u);
+  EXPECT_EQ(redacted_module_annotations.begin()->first, "ptype");
+
+  std::vector<AnnotationSnapshot> redacted_module_annotation_objects =
+      redacted_snapshot.Modules()[0]->AnnotationObjects();
+  ASSERT_EQ(redacted_module_annotation_objects.size(), 1u);
+  EXPECT_EQ(redacted_module_annotation_objects[0].name, "tab-count");
+}
+
+TEST(ProcessSnapshotRedacted, DropExtraMemory) {
+  TestProcessSnapshot process_snapshot;
+  process_snapshot.AddExtraMemory(
+      base::WrapUnique(new TestMemorySnapshot()));
+
+  auto module_snapshot = base::WrapUnique(new TestModuleSnapshot());
+  std::set<CheckedRange<uint64_t>> extra_memory_ranges;
+  extra_memory_ranges.insert(CheckedRange<uint64_t>(0x1000, 0x100));
+  module_snapshot->SetExtraMemoryRanges(extra_memory_ranges);
+  process_snapshot.AddModule(std::move(module_snapshot));
+
+  RedactionPolicy policy;
+  policy.drop_extra_memory = true;
+
+  ProcessSnapshotRedacted redacted_snapshot;
+  ASSERT_TRUE(redacted_snapshot.Initialize(&process_snapshot, policy));
+  EXPECT_TRUE(redacted_snapshot.ExtraMemory().empty());
+  ASSERT_EQ(redacted_snapshot.Modules().size(), 1u);
+  EXPECT_TRUE(redacted_snapshot.Modules()[0]->ExtraMemoryRanges().empty());
+}
+
+TEST(ProcessSnapshotRedacted, MemoryMapLimit) {
+  TestProcessSnapshot process_snapshot;
+  AddMemoryMapRegion(&process_snapshot, 0x1000, MEM_FREE);
+  AddMemoryMapRegion(&process_snapshot, 0x2000, MEM_COMMIT);
+  AddMemoryMapRegion(&process_snapshot, 0x3000, MEM_RESERVE);
+  AddMemoryMapRegion(&process_snapshot, 0x4000, MEM_COMMIT);
+  AddMemoryMapRegion(&process_snapshot, 0x5000, MEM_FREE);
+
+  RedactionPolicy policy;
+  policy.max_memory_map_regions = 3;
+
+  ProcessSnapshotRedacted redacted_snapshot;
+  ASSERT_TRUE(redacted_snapshot.Initialize(&process_snapshot, policy));
+
+  // Both committed regions survive, along with the first other region, in
+  // their original order.
+  std::vector<const MemoryMapRegionSnapshot*> memory_map =
+      redacted_snapshot.MemoryMap();
+  ASSERT_EQ(memory_map.size(), 3u);
+  EXPECT_EQ(memory_map[0]->AsMinidumpMemoryInfo().BaseAddress, 0x1000u);
+  EXPECT_EQ(memory_map[1]->AsMinidumpMemoryInfo().BaseAddress, 0x2000u);
+  EXPECT_EQ(memory_map[2]->AsMinidumpMemoryInfo().BaseAddress, 0x4000u);
+
+  policy.max_memory_map_regions = 1;
+  ProcessSnapshotRedacted small_redacted_snapshot;
+  ASSERT_TRUE(small_redacted_snapshot.Initialize(&process_snapshot, policy));
+  memory_map = small_redacted_snapshot.MemoryMap();
+  ASSERT_EQ(memory_map.size(), 1u);
+  EXPECT_EQ(memory_map[0]->AsMinidumpMemoryInfo().BaseAddress, 0x2000u);
+}
+
+TEST(ProcessSnapshotRedacted, CrashingThreadOnly) {
+  TestProcessSnapshot process_snapshot;
+  for (uint64_t thread_id = 1; thread_id <= 3; ++thread_id) {
+    auto thread_snapshot = base::WrapUnique(new TestThreadSnapshot());
+    thread_snapshot->SetThreadID(thread_id);
+    process_snapshot.AddThread(std::move(thread_snapshot));
+  }
+
+  RedactionPolicy policy;
+  policy.crashing_thread_only = true;
+  EXPECT_FALSE(RedactionPolicyIsEmpty(policy));
+
+  // Without an exception, there’s no crashing thread to single out.
+  ProcessSnapshotRedacted no_exception_snapshot;
+  ASSERT_TRUE(no_exception_snapshot.Initialize(&process_snapshot, policy));
+  EXPECT_EQ(no_exception_snapshot.Threads().size(), 3u);
+
+  auto exception_snapshot = base::WrapUnique(new TestExceptionSnapshot());
+  exception_snapshot->SetThreadID(2);
+  process_snapshot.SetException(std::move(exception_snapshot));
+
+  ProcessSnapshotRedacted redacted_snapshot;
+  ASSERT_TRUE(redacted_snapshot.Initialize(&process_snapshot, policy));
+  std::vector<const ThreadSnapshot*> threads = redacted_snapshot.Threads();
+  ASSERT_EQ(threads.size(), 1u);
+  EXPECT_EQ(threads[0]->ThreadID(), 2u);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,46 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/redacted/redaction_policy.h"
+
+namespace crashpad {
+
+RedactionPolicy::RedactionPolicy()
+    : annotation_key_prefixes(),
+      drop_extra_memory(false),
+      crashing_thread_only(false),
+      max_memory_map_regions(0) {
+}
+
+RedactionPolicy::RedactionPolicy(const RedactionPolicy& other) = default;
+
+RedactionPolicy::~RedactionPolicy() {
+}
+
+bool RedactionPolicyIsEmpty(const RedactionPolicy& policy) {
+  return policy.annotation_key_prefixes.empty() && !policy.drop_extra_memory &&
+         !policy.crashing_thread_only && !policy.max_memory_map_regions;
+}
+
+bool RedactionPolicyStripsAnnotation(const RedactionPolicy& policy,
+                                     const std::string& key) {
+  for (const std::string& prefix : policy.annotation_key_prefixes) {
+    if (key.compare(0, prefix.size(), prefix) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,62 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_REDACTED_REDACTION_POLICY_H_
+#define CRASHPAD_SNAPSHOT_REDACTED_REDACTION_POLICY_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+namespace crashpad {
+
+//! \brief Describes what ProcessSnapshotRedacted removes from the snapshot
+//!     that it wraps.
+struct RedactionPolicy {
+  RedactionPolicy();
+  RedactionPolicy(const RedactionPolicy& other);
+  ~RedactionPolicy();
+
+  //! \brief Simple annotations whose keys begin with any of these prefixes are
+  //!     removed from the process and from each module, as are typed
+  //!     annotations whose names do.
+  std::vector<std::string> annotation_key_prefixes;
+
+  //! \brief Whether to remove memory that is not a thread’s stack: the
+  //!     process’ extra memory, and ranges referenced by modules.
+  bool drop_extra_memory;
+
+  //! \brief Whether to remove every thread other than the one that raised the
+  //!     exception. This has no effect on a snapshot without an exception.
+  bool crashing_thread_only;
+
+  //! \brief The maximum number of memory map regions to retain, or `0` for no
+  //!     limit. When the limit is exceeded, committed regions are retained in
+  //!     preference to free and reserved ones.
+  size_t max_memory_map_regions;
+};
+
+//! \brief Returns whether \a policy has no effect, so that a snapshot redacted
+//!     according to it would be identical to the original.
+bool RedactionPolicyIsEmpty(const RedactionPolicy& policy);
+
+//! \brief Returns whether \a policy causes the simple annotation at \a key to
+//!     be removed.
+bool RedactionPolicyStripsAnnotation(const RedactionPolicy& policy,
+                                     const std::string& key);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_REDACTED_REDACTION_POLICY_H_
@@ -0,0 +1,187 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/ring_buffer_snapshot.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+
+namespace crashpad {
+namespace internal {
+
+namespace {
+
+// Copies each segment into consecutive positions of a buffer owned by the
+// caller.
+class SegmentCopyDelegate final : public MemorySnapshot::Delegate {
+ public:
+  SegmentCopyDelegate(uint8_t* buffer, size_t size)
+      : buffer_(buffer), size_(size), offset_(0) {}
+
+  ~SegmentCopyDelegate() override {}
+
+  size_t offset() const { return offset_; }
+
+  // MemorySnapshot::Delegate:
+
+  bool MemorySnapshotDelegateRead(void* data, size_t size) override {
+    if (size > size_ - offset_) {
+      LOG(ERROR) << "ring buffer segment size mismatch";
+      return false;
+    }
+    if (data != buffer_ + offset_) {
+      memcpy(buffer_ + offset_, data, size);
+    }
+    offset_ += size;
+    return true;
+  }
+
+  void* MemorySnapshotDelegateBuffer(size_t size) override {
+    return size <= size_ - offset_ ? buffer_ + offset_ : nullptr;
+  }
+
+ private:
+  uint8_t* buffer_;  // weak
+  size_t size_;
+  size_t offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(SegmentCopyDelegate);
+};
+
+}  // namespace
+
+bool GetRingBufferLiveRanges(const RingBufferDescriptor& descriptor,
+                             uint64_t max_size,
+                             std::vector<CheckedRange<uint64_t>>* ranges) {
+  ranges->clear();
+
+  const uint64_t element_size = descriptor.element_size;
+  const uint64_t capacity = descriptor.capacity;
+  if (element_size == 0 || capacity == 0 || capacity % element_size != 0 ||
+      !CheckedRange<uint64_t>(descriptor.base_address, capacity).IsValid()) {
+    LOG(WARNING) << "invalid ring buffer descriptor";
+    return false;
+  }
+  if (descriptor.head < descriptor.tail) {
+    LOG(WARNING) << "ring buffer head " << descriptor.head
+                 << " precedes tail " << descriptor.tail;
+    return false;
+  }
+
+  // Skip the partial element at the tail, which has been partly consumed, and
+  // the one at the head, which is still being written.
+  uint64_t tail = descriptor.tail;
+  const uint64_t tail_remainder = tail % element_size;
+  if (tail_remainder != 0) {
+    if (descriptor.head - tail < element_size - tail_remainder) {
+      return true;
+    }
+    tail += element_size - tail_remainder;
+  }
+  const uint64_t head = descriptor.head - descriptor.head % element_size;
+
+  // Anything more than a full buffer behind the head has been overwritten.
+  uint64_t limit = std::min(capacity, max_size);
+  limit -= limit % element_size;
+  uint64_t size = head - tail;
+  if (size > limit) {
+    tail = head - limit;
+    size = limit;
+  }
+  if (size == 0) {
+    return true;
+  }
+
+  const uint64_t start = tail % capacity;
+  const uint64_t first_size = std::min(size, capacity - start);
+  ranges->push_back(
+      CheckedRange<uint64_t>(descriptor.base_address + start, first_size));
+  if (first_size < size) {
+    ranges->push_back(
+        CheckedRange<uint64_t>(descriptor.base_address, size - first_size));
+  }
+  return true;
+}
+
+RingBufferSnapshot::RingBufferSnapshot()
+    : MemorySnapshot(), segments_(), size_(0), initialized_() {
+}
+
+RingBufferSnapshot::~RingBufferSnapshot() {
+}
+
+void RingBufferSnapshot::Initialize(
+    std::vector<std::unique_ptr<const MemorySnapshot>> segments) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+  segments_ = std::move(segments);
+  size_ = 0;
+  for (const auto& segment : segments_) {
+    size_ += segment->Size();
+  }
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+}
+
+uint64_t RingBufferSnapshot::Address() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return segments_.empty() ? 0 : segments_.front()->Address();
+}
+
+size_t RingBufferSnapshot::Size() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return size_;
+}
+
+bool RingBufferSnapshot::Read(Delegate* delegate) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // A ring buffer that hasn’t wrapped needs no linearization.
+  if (segments_.size() <= 1) {
+    return segments_.empty() ? delegate->MemorySnapshotDelegateRead(nullptr, 0)
+                             : segments_.front()->Read(delegate);
+  }
+
+  std::unique_ptr<uint8_t[]> owned_buffer;
+  uint8_t* buffer =
+      reinterpret_cast<uint8_t*>(delegate->MemorySnapshotDelegateBuffer(size_));
+  if (!buffer) {
+    owned_buffer.reset(new uint8_t[size_]);
+    buffer = owned_buffer.get();
+  }
+
+  SegmentCopyDelegate copy_delegate(buffer, size_);
+  for (const auto& segment : segments_) {
+    if (!segment->Read(&copy_delegate)) {
+      return false;
+    }
+  }
+  if (copy_delegate.offset() != size_) {
+    LOG(ERROR) << "ring buffer segment size mismatch";
+    return false;
+  }
+
+  return delegate->MemorySnapshotDelegateRead(buffer, size_);
+}
+
+const MemorySnapshot* RingBufferSnapshot::MergeWithOtherSnapshot(
+    const MemorySnapshot* other) const {
+  LOG(ERROR) << "ring buffer snapshots cannot be merged";
+  return nullptr;
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,96 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_RING_BUFFER_SNAPSHOT_H_
+#define CRASHPAD_SNAPSHOT_RING_BUFFER_SNAPSHOT_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "client/crashpad_info.h"
+#include "snapshot/memory_snapshot.h"
+#include "util/misc/initialization_state_dcheck.h"
+#include "util/numeric/checked_range.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief Determines the address ranges holding the live portion of a ring
+//!     buffer.
+//!
+//! \param[in] descriptor The descriptor of the ring buffer, as read from the
+//!     snapshot process.
+//! \param[in] max_size The maximum number of bytes to capture. If more than
+//!     this is live, only the newest data is captured.
+//! \param[out] ranges The address ranges in the snapshot process’ address
+//!     space containing the live data, ordered from oldest to newest. There
+//!     are at most two: one up to the end of the buffer, and one continuing
+//!     from its start. Empty if the ring buffer holds no complete element.
+//!
+//! \return `true` on success, `false` with a message logged if \a descriptor
+//!     is not valid.
+bool GetRingBufferLiveRanges(const RingBufferDescriptor& descriptor,
+                             uint64_t max_size,
+                             std::vector<CheckedRange<uint64_t>>* ranges);
+
+//! \brief A MemorySnapshot that presents the live portion of a ring buffer as
+//!     a single, linear block of memory.
+//!
+//! The snapshot is made up of one memory snapshot for each range returned by
+//! GetRingBufferLiveRanges(), and reads them in order.
+class RingBufferSnapshot final : public MemorySnapshot {
+ public:
+  RingBufferSnapshot();
+  ~RingBufferSnapshot() override;
+
+  //! \brief Initializes the object.
+  //!
+  //! \param[in] segments The snapshots of the ranges making up the ring
+  //!     buffer’s live data, from oldest to newest. This object takes
+  //!     ownership of them.
+  void Initialize(std::vector<std::unique_ptr<const MemorySnapshot>> segments);
+
+  // MemorySnapshot:
+
+  //! \copydoc MemorySnapshot::Address()
+  //!
+  //! This is the address of the oldest live data.
+  uint64_t Address() const override;
+
+  size_t Size() const override;
+  bool Read(Delegate* delegate) const override;
+
+  //! \copydoc MemorySnapshot::MergeWithOtherSnapshot()
+  //!
+  //! A ring buffer’s data is not contiguous in the snapshot process’ address
+  //! space, so this always fails.
+  const MemorySnapshot* MergeWithOtherSnapshot(
+      const MemorySnapshot* other) const override;
+
+ private:
+  std::vector<std::unique_ptr<const MemorySnapshot>> segments_;
+  size_t size_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(RingBufferSnapshot);
+};
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_RING_BUFFER_SNAPSHOT_H_
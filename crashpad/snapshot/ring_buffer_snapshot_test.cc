@@ -0,0 +1,189 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/ring_buffer_snapshot.h"
+
+#include <stdint.h>
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "snapshot/test/test_memory_snapshot.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+using internal::GetRingBufferLiveRanges;
+using internal::RingBufferSnapshot;
+
+constexpr uint64_t kBase = 0x10000;
+constexpr uint64_t kNoLimit = std::numeric_limits<uint64_t>::max();
+
+RingBufferDescriptor MakeDescriptor(uint64_t capacity,
+                                    uint64_t head,
+                                    uint64_t tail,
+                                    uint32_t element_size) {
+  RingBufferDescriptor descriptor = {};
+  descriptor.base_address = kBase;
+  descriptor.capacity = capacity;
+  descriptor.head = head;
+  descriptor.tail = tail;
+  descriptor.element_size = element_size;
+  return descriptor;
+}
+
+TEST(GetRingBufferLiveRanges, Empty) {
+  std::vector<CheckedRange<uint64_t>> ranges;
+  ASSERT_TRUE(GetRingBufferLiveRanges(
+      MakeDescriptor(64, 24, 24, 8), kNoLimit, &ranges));
+  EXPECT_TRUE(ranges.empty());
+}
+
+TEST(GetRingBufferLiveRanges, Contiguous) {
+  std::vector<CheckedRange<uint64_t>> ranges;
+  ASSERT_TRUE(GetRingBufferLiveRanges(
+      MakeDescriptor(64, 88, 72, 8), kNoLimit, &ranges));
+  ASSERT_EQ(ranges.size(), 1u);
+  EXPECT_EQ(ranges[0].base(), kBase + 8);
+  EXPECT_EQ(ranges[0].size(), 16u);
+}
+
+TEST(GetRingBufferLiveRanges, Wrapped) {
+  std::vector<CheckedRange<uint64_t>> ranges;
+  ASSERT_TRUE(GetRingBufferLiveRanges(
+      MakeDescriptor(64, 136, 112, 8), kNoLimit, &ranges));
+  ASSERT_EQ(ranges.size(), 2u);
+  EXPECT_EQ(ranges[0].base(), kBase + 48);
+  EXPECT_EQ(ranges[0].size(), 16u);
+  EXPECT_EQ(ranges[1].base(), kBase);
+  EXPECT_EQ(ranges[1].size(), 8u);
+}
+
+TEST(GetRingBufferLiveRanges, Overwritten) {
+  // The writer is more than a full buffer ahead of the reader, so only the
+  // newest 64 bytes remain.
+  std::vector<CheckedRange<uint64_t>> ranges;
+  ASSERT_TRUE(GetRingBufferLiveRanges(
+      MakeDescriptor(64, 200, 8, 8), kNoLimit, &ranges));
+  ASSERT_EQ(ranges.size(), 2u);
+  EXPECT_EQ(ranges[0].base(), kBase + 8);
+  EXPECT_EQ(ranges[0].size(), 56u);
+  EXPECT_EQ(ranges[1].base(), kBase);
+  EXPECT_EQ(ranges[1].size(), 8u);
+}
+
+TEST(GetRingBufferLiveRanges, MaxSize) {
+  std::vector<CheckedRange<uint64_t>> ranges;
+  ASSERT_TRUE(
+      GetRingBufferLiveRanges(MakeDescriptor(64, 64, 0, 8), 20, &ranges));
+  ASSERT_EQ(ranges.size(), 1u);
+  EXPECT_EQ(ranges[0].base(), kBase + 48);
+  EXPECT_EQ(ranges[0].size(), 16u);
+}
+
+TEST(GetRingBufferLiveRanges, PartialElements) {
+  std::vector<CheckedRange<uint64_t>> ranges;
+  ASSERT_TRUE(
+      GetRingBufferLiveRanges(MakeDescriptor(64, 37, 3, 8), kNoLimit, &ranges));
+  ASSERT_EQ(ranges.size(), 1u);
+  EXPECT_EQ(ranges[0].base(), kBase + 8);
+  EXPECT_EQ(ranges[0].size(), 24u);
+
+  // Nothing but a single partial element.
+  ASSERT_TRUE(GetRingBufferLiveRanges(
+      MakeDescriptor(64, 14, 10, 8), kNoLimit, &ranges));
+  EXPECT_TRUE(ranges.empty());
+}
+
+TEST(GetRingBufferLiveRanges, Invalid) {
+  std::vector<CheckedRange<uint64_t>> ranges;
+  EXPECT_FALSE(
+      GetRingBufferLiveRanges(MakeDescriptor(0, 0, 0, 8), kNoLimit, &ranges));
+  EXPECT_FALSE(
+      GetRingBufferLiveRanges(MakeDescriptor(64, 8, 0, 0), kNoLimit, &ranges));
+  EXPECT_FALSE(
+      GetRingBufferLiveRanges(MakeDescriptor(60, 8, 0, 8), kNoLimit, &ranges));
+  EXPECT_FALSE(
+      GetRingBufferLiveRanges(MakeDescriptor(64, 8, 16, 8), kNoLimit, &ranges));
+
+  RingBufferDescriptor descriptor = MakeDescriptor(64, 8, 0, 8);
+  descriptor.base_address = std::numeric_limits<uint64_t>::max() - 8;
+  EXPECT_FALSE(GetRingBufferLiveRanges(descriptor, kNoLimit, &ranges));
+}
+
+class ReadToString : public MemorySnapshot::Delegate {
+ public:
+  ReadToString() : result_() {}
+  ~ReadToString() override {}
+
+  const std::string& result() const { return result_; }
+
+  // MemorySnapshot::Delegate:
+  bool MemorySnapshotDelegateRead(void* data, size_t size) override {
+    result_.assign(reinterpret_cast<const char*>(data), size);
+    return true;
+  }
+
+ private:
+  std::string result_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadToString);
+};
+
+std::unique_ptr<const MemorySnapshot> MakeSegment(uint64_t address,
+                                                  size_t size,
+                                                  char value) {
+  std::unique_ptr<TestMemorySnapshot> segment(new TestMemorySnapshot());
+  segment->SetAddress(address);
+  segment->SetSize(size);
+  segment->SetValue(value);
+  return std::move(segment);
+}
+
+TEST(RingBufferSnapshot, Linearizes) {
+  std::vector<std::unique_ptr<const MemorySnapshot>> segments;
+  segments.push_back(MakeSegment(kBase + 48, 3, 'a'));
+  segments.push_back(MakeSegment(kBase, 2, 'b'));
+
+  RingBufferSnapshot snapshot;
+  snapshot.Initialize(std::move(segments));
+  EXPECT_EQ(snapshot.Address(), kBase + 48);
+  EXPECT_EQ(snapshot.Size(), 5u);
+
+  ReadToString delegate;
+  ASSERT_TRUE(snapshot.Read(&delegate));
+  EXPECT_EQ(delegate.result(), "aaabb");
+}
+
+TEST(RingBufferSnapshot, SingleSegment) {
+  std::vector<std::unique_ptr<const MemorySnapshot>> segments;
+  segments.push_back(MakeSegment(kBase + 8, 4, 'c'));
+
+  RingBufferSnapshot snapshot;
+  snapshot.Initialize(std::move(segments));
+  EXPECT_EQ(snapshot.Address(), kBase + 8);
+  EXPECT_EQ(snapshot.Size(), 4u);
+
+  ReadToString delegate;
+  ASSERT_TRUE(snapshot.Read(&delegate));
+  EXPECT_EQ(delegate.result(), "cccc");
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
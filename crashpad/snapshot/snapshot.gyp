@@ -30,15 +30,23 @@
         '..',
       ],
       'sources': [
+        'annotation_snapshot.cc',
+        'annotation_snapshot.h',
+        'capture_deadline.cc',
+        'capture_deadline.h',
         'capture_memory.cc',
         'capture_memory.h',
         'cpu_architecture.h',
         'cpu_context.cc',
         'cpu_context.h',
+        'crash_signature.cc',
+        'crash_signature.h',
         'crashpad_info_client_options.cc',
         'crashpad_info_client_options.h',
         'elf/elf_dynamic_array_reader.cc',
         'elf/elf_dynamic_array_reader.h',
+        'elf/elf_eh_frame_reader.cc',
+        'elf/elf_eh_frame_reader.h',
         'elf/elf_image_reader.cc',
         'elf/elf_image_reader.h',
         'elf/elf_symbol_table_reader.cc',
@@ -46,16 +54,26 @@
         'exception_snapshot.h',
         'handle_snapshot.cc',
         'handle_snapshot.h',
+        'linux/build_id_cache.cc',
+        'linux/build_id_cache.h',
+        'linux/capture_memory_delegate_linux.cc',
+        'linux/capture_memory_delegate_linux.h',
         'linux/cpu_context_linux.cc',
         'linux/cpu_context_linux.h',
         'linux/debug_rendezvous.cc',
         'linux/debug_rendezvous.h',
         'linux/exception_snapshot_linux.cc',
         'linux/exception_snapshot_linux.h',
+        'linux/memory_map_region_snapshot_linux.cc',
+        'linux/memory_map_region_snapshot_linux.h',
         'linux/memory_snapshot_linux.cc',
         'linux/memory_snapshot_linux.h',
+        'linux/module_snapshot_linux.cc',
+        'linux/module_snapshot_linux.h',
         'linux/process_reader.cc',
         'linux/process_reader.h',
+        'linux/process_snapshot_linux.cc',
+        'linux/process_snapshot_linux.h',
         'linux/signal_context.h',
         'linux/system_snapshot_linux.cc',
         'linux/system_snapshot_linux.h',
@@ -84,6 +102,7 @@
         'mac/process_types.cc',
         'mac/process_types.h',
         'mac/process_types/all.proctype',
+        'mac/process_types/annotation.proctype',
         'mac/process_types/crashpad_info.proctype',
         'mac/process_types/crashreporterclient.proctype',
         'mac/process_types/custom.cc',
@@ -97,9 +116,22 @@
         'mac/system_snapshot_mac.h',
         'mac/thread_snapshot_mac.cc',
         'mac/thread_snapshot_mac.h',
+        'memory_snapshot.cc',
         'memory_snapshot.h',
+        'minidump/exception_snapshot_minidump.cc',
+        'minidump/exception_snapshot_minidump.h',
+        'minidump/memory_map_region_snapshot_minidump.cc',
+        'minidump/memory_map_region_snapshot_minidump.h',
+        'minidump/memory_snapshot_minidump.cc',
+        'minidump/memory_snapshot_minidump.h',
+        'minidump/minidump_annotation_reader.cc',
+        'minidump/minidump_annotation_reader.h',
+        'minidump/minidump_context_converter.cc',
+        'minidump/minidump_context_converter.h',
         'minidump/minidump_simple_string_dictionary_reader.cc',
         'minidump/minidump_simple_string_dictionary_reader.h',
+        'minidump/minidump_stream_index_reader.cc',
+        'minidump/minidump_stream_index_reader.h',
         'minidump/minidump_string_list_reader.cc',
         'minidump/minidump_string_list_reader.h',
         'minidump/minidump_string_reader.cc',
@@ -108,12 +140,28 @@
         'minidump/module_snapshot_minidump.h',
         'minidump/process_snapshot_minidump.cc',
         'minidump/process_snapshot_minidump.h',
+        'minidump/system_snapshot_minidump.cc',
+        'minidump/system_snapshot_minidump.h',
+        'minidump/thread_snapshot_minidump.cc',
+        'minidump/thread_snapshot_minidump.h',
         'module_snapshot.h',
         'posix/timezone.cc',
         'posix/timezone.h',
         'process_snapshot.h',
+        'redacted/module_snapshot_redacted.cc',
+        'redacted/module_snapshot_redacted.h',
+        'redacted/process_snapshot_redacted.cc',
+        'redacted/process_snapshot_redacted.h',
+        'redacted/redaction_policy.cc',
+        'redacted/redaction_policy.h',
+        'ring_buffer_snapshot.cc',
+        'ring_buffer_snapshot.h',
         'system_snapshot.h',
+        'system_snapshot_cache.cc',
+        'system_snapshot_cache.h',
         'thread_snapshot.h',
+        'top_frames.cc',
+        'top_frames.h',
         'unloaded_module_snapshot.cc',
         'unloaded_module_snapshot.h',
         'win/cpu_context_win.cc',
@@ -122,6 +170,8 @@
         'win/exception_snapshot_win.h',
         'win/capture_memory_delegate_win.cc',
         'win/capture_memory_delegate_win.h',
+        'win/lock_list_walker.cc',
+        'win/lock_list_walker.h',
         'win/memory_map_region_snapshot_win.cc',
         'win/memory_map_region_snapshot_win.h',
         'win/memory_snapshot_win.cc',
@@ -146,6 +196,8 @@
         'win/thread_snapshot_win.h',
         'x86/cpuid_reader.cc',
         'x86/cpuid_reader.h',
+        'x86/memory_operands.cc',
+        'x86/memory_operands.h',
       ],
       'conditions': [
         ['OS=="win"', {
@@ -155,21 +207,11 @@
             ],
           },
         }],
-        ['OS=="linux" or OS=="android"', {
-          'sources!': [
-            'capture_memory.cc',
-            'capture_memory.h',
-          ],
-        }, {  # else: OS!="linux" and OS!="android"
+        ['OS!="linux" and OS!="android"', {
           'sources/': [
             ['exclude', '^elf/'],
           ],
         }],
-        ['target_arch!="ia32" and target_arch!="x64"', {
-          'sources/': [
-            ['exclude', '^x86/'],
-          ],
-        }],
       ],
       'target_conditions': [
         ['OS=="android"', {
@@ -177,6 +219,14 @@
             ['include', '^linux/'],
           ],
         }],
+        ['target_arch!="ia32" and target_arch!="x64"', {
+          # Memory capture decodes x86 instructions.
+          'sources/': [
+            ['exclude', '^capture_memory\\.'],
+            ['exclude', '^linux/capture_memory_delegate_linux\\.'],
+            ['exclude', '^x86/'],
+          ],
+        }],
       ],
     },
     {
@@ -0,0 +1,738 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/strings/stringprintf.h"
+#include "build/build_config.h"
+#include "client/annotation.h"
+#include "client/annotation_list.h"
+#include "client/crashpad_info.h"
+#include "client/simple_address_range_bag.h"
+#include "client/simple_string_dictionary.h"
+#include "snapshot/module_snapshot.h"
+#include "snapshot/process_snapshot.h"
+#include "test/scoped_module_handle.h"
+#include "test/scoped_temp_dir.h"
+#include "tools/tool_support.h"
+#include "util/file/file_io.h"
+#include "util/file/file_writer.h"
+#include "util/misc/clock.h"
+#include "util/stdlib/string_number_conversion.h"
+#include "util/synchronization/semaphore.h"
+#include "util/thread/thread.h"
+
+#if defined(OS_POSIX)
+#include <dlfcn.h>
+#endif  // OS_POSIX
+
+#if defined(OS_MACOSX)
+#include "snapshot/mac/process_snapshot_mac.h"
+#include "test/mac/mach_multiprocess.h"
+#include "util/mach/scoped_task_suspend.h"
+#elif defined(OS_WIN)
+#include <windows.h>
+
+#include "base/strings/utf_string_conversions.h"
+#include "snapshot/win/process_snapshot_win.h"
+#include "test/win/win_child_process.h"
+#include "util/win/scoped_process_suspend.h"
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+#include "snapshot/linux/process_snapshot_linux.h"
+#include "test/multiprocess.h"
+#include "util/linux/direct_ptrace_connection.h"
+#endif  // OS_MACOSX
+
+#if defined(COMPILER_MSVC)
+#define BENCHMARK_NOINLINE __declspec(noinline)
+#else
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#endif  // COMPILER_MSVC
+
+namespace crashpad {
+namespace {
+
+#if defined(OS_WIN)
+constexpr base::FilePath::CharType kModuleExtension[] =
+    FILE_PATH_LITERAL(".dll");
+#else
+constexpr base::FilePath::CharType kModuleExtension[] =
+    FILE_PATH_LITERAL(".so");
+#endif  // OS_WIN
+
+// The size of each stack frame that a target’s threads recurse through, and of
+// each extra memory range that it registers.
+constexpr size_t kStackFrameSize = 256;
+constexpr size_t kMemoryRangeSize = 4096;
+
+// The deepest that a thread may recurse. This keeps a thread within the
+// smallest default thread stack size, 512 kB on macOS.
+constexpr unsigned int kMaxStackDepth = 1024;
+
+// The size of each annotation object’s value.
+constexpr uint32_t kAnnotationObjectSize = 256;
+
+// The shape of a synthetic target process, sent to it by the benchmark over its
+// pipe, followed by the pathname of the directory holding the modules that it
+// loads.
+struct TargetParameters {
+  uint32_t thread_count;
+  uint32_t stack_depth;
+  uint32_t module_count;
+  uint32_t memory_range_count;
+  uint32_t annotation_count;
+  uint32_t annotation_object_count;
+};
+
+// Returns the pathname of the |index|th module in |directory|.
+base::FilePath ModulePath(const base::FilePath& directory, uint32_t index) {
+  const std::string name = base::StringPrintf("module_%u", index);
+#if defined(OS_WIN)
+  return directory.Append(base::UTF8ToUTF16(name) + kModuleExtension);
+#else
+  return directory.Append(name + kModuleExtension);
+#endif  // OS_WIN
+}
+
+// Recurses |depth| frames deep, each frame holding a buffer that the compiler
+// can’t elide, then signals |ready| and waits for |release|.
+BENCHMARK_NOINLINE void Recurse(unsigned int depth,
+                                Semaphore* ready,
+                                Semaphore* release) {
+  volatile char frame[kStackFrameSize];
+  frame[0] = static_cast<char>(depth);
+  if (depth) {
+    Recurse(depth - 1, ready, release);
+  } else {
+    ready->Signal();
+    release->Wait();
+  }
+
+  // Using the frame after the call keeps it from being a tail call.
+  frame[kStackFrameSize - 1] = frame[0];
+}
+
+// A thread of a synthetic target, which sits at the bottom of a deep stack
+// until released.
+class DeepStackThread : public Thread {
+ public:
+  DeepStackThread(unsigned int depth, Semaphore* ready, Semaphore* release)
+      : Thread(), depth_(depth), ready_(ready), release_(release) {}
+
+  ~DeepStackThread() override {}
+
+ private:
+  // Thread:
+  void ThreadMain() override { Recurse(depth_, ready_, release_); }
+
+  unsigned int depth_;
+  Semaphore* ready_;  // weak
+  Semaphore* release_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(DeepStackThread);
+};
+
+// Runs in a synthetic target process. Reads TargetParameters from
+// |read_handle|, gives the process that shape, writes a byte to |write_handle|,
+// and holds the shape until |read_handle| reaches end-of-file.
+void RunTarget(FileHandle read_handle, FileHandle write_handle) {
+  TargetParameters parameters;
+  CheckedReadFileExactly(read_handle, &parameters, sizeof(parameters));
+  uint32_t directory_length;
+  CheckedReadFileExactly(
+      read_handle, &directory_length, sizeof(directory_length));
+  base::FilePath::StringType directory_string(directory_length, '\0');
+  CheckedReadFileExactly(read_handle,
+                         &directory_string[0],
+                         directory_length * sizeof(directory_string[0]));
+  const base::FilePath directory(directory_string);
+
+  std::vector<std::unique_ptr<test::ScopedModuleHandle>> modules;
+  for (uint32_t index = 0; index < parameters.module_count; ++index) {
+    const base::FilePath module_path = ModulePath(directory, index);
+#if defined(OS_POSIX)
+    modules.push_back(std::unique_ptr<test::ScopedModuleHandle>(
+        new test::ScopedModuleHandle(
+            dlopen(module_path.value().c_str(), RTLD_NOW | RTLD_LOCAL))));
+    CHECK(modules.back()->valid()) << "dlopen " << module_path.value() << ": "
+                                   << dlerror();
+#elif defined(OS_WIN)
+    modules.push_back(std::unique_ptr<test::ScopedModuleHandle>(
+        new test::ScopedModuleHandle(
+            LoadLibrary(module_path.value().c_str()))));
+    PCHECK(modules.back()->valid())
+        << "LoadLibrary " << base::UTF16ToUTF8(module_path.value());
+#endif  // OS_POSIX
+  }
+
+  CrashpadInfo* const crashpad_info = CrashpadInfo::GetCrashpadInfo();
+
+  std::vector<std::unique_ptr<char[]>> memory_ranges;
+  SimpleAddressRangeBag extra_memory_ranges;
+  for (uint32_t index = 0; index < parameters.memory_range_count; ++index) {
+    memory_ranges.push_back(
+        std::unique_ptr<char[]>(new char[kMemoryRangeSize]));
+    memset(memory_ranges.back().get(), 'm', kMemoryRangeSize);
+    CHECK(extra_memory_ranges.Insert(memory_ranges.back().get(),
+                                     kMemoryRangeSize));
+  }
+  crashpad_info->set_extra_memory_ranges(&extra_memory_ranges);
+
+  const std::string value(SimpleStringDictionary::value_size - 1, 'v');
+  SimpleStringDictionary simple_annotations;
+  for (uint32_t index = 0; index < parameters.annotation_count; ++index) {
+    simple_annotations.SetKeyValue(
+        base::StringPrintf("annotation_%u", index), value);
+  }
+  crashpad_info->set_simple_annotations(&simple_annotations);
+
+  // The names must stay in place, so the vector must not reallocate.
+  std::vector<std::string> annotation_names;
+  annotation_names.reserve(parameters.annotation_object_count);
+  std::vector<std::unique_ptr<StringAnnotation<kAnnotationObjectSize>>>
+      annotation_objects;
+  AnnotationList* const annotation_list = AnnotationList::Register();
+  for (uint32_t index = 0; index < parameters.annotation_object_count;
+       ++index) {
+    annotation_names.push_back(base::StringPrintf("object_%u", index));
+    annotation_objects.push_back(
+        std::unique_ptr<StringAnnotation<kAnnotationObjectSize>>(
+            new StringAnnotation<kAnnotationObjectSize>(
+                annotation_names.back().c_str())));
+    annotation_objects.back()->Set(value);
+    annotation_list->Add(annotation_objects.back().get());
+  }
+
+  Semaphore ready(0);
+  Semaphore release(0);
+  std::vector<std::unique_ptr<DeepStackThread>> threads;
+  for (uint32_t index = 0; index < parameters.thread_count; ++index) {
+    threads.push_back(std::unique_ptr<DeepStackThread>(
+        new DeepStackThread(parameters.stack_depth, &ready, &release)));
+    threads.back()->Start();
+  }
+  for (uint32_t index = 0; index < parameters.thread_count; ++index) {
+    ready.Wait();
+  }
+
+  const char c = ' ';
+  CheckedWriteFile(write_handle, &c, sizeof(c));
+  CheckedReadFileAtEOF(read_handle);
+
+  for (uint32_t index = 0; index < parameters.thread_count; ++index) {
+    release.Signal();
+  }
+  for (const auto& thread : threads) {
+    thread->Join();
+  }
+
+  crashpad_info->set_simple_annotations(nullptr);
+  crashpad_info->set_extra_memory_ranges(
+      static_cast<SimpleAddressRangeBag*>(nullptr));
+}
+
+// Sends |parameters| and |module_directory| to a target over |write_handle|,
+// and waits for it to signal over |read_handle| that it has taken on its
+// shape. Returns false with a message logged on failure.
+bool StartTarget(const TargetParameters& parameters,
+                 const base::FilePath& module_directory,
+                 FileHandle read_handle,
+                 FileHandle write_handle) {
+  const base::FilePath::StringType& directory_string =
+      module_directory.value();
+  const uint32_t directory_length =
+      static_cast<uint32_t>(directory_string.size());
+  char c;
+  return LoggingWriteFile(write_handle, &parameters, sizeof(parameters)) &&
+         LoggingWriteFile(
+             write_handle, &directory_length, sizeof(directory_length)) &&
+         LoggingWriteFile(write_handle,
+                          directory_string.data(),
+                          directory_length * sizeof(directory_string[0])) &&
+         LoggingReadFileExactly(read_handle, &c, sizeof(c));
+}
+
+// The measurements taken of one snapshot of a target.
+struct Measurement {
+  //! The time taken to suspend the target. On Linux, this is the time taken to
+  //! attach to it.
+  uint64_t suspend_ns;
+
+  //! The time taken to initialize the snapshot and enumerate its threads,
+  //! modules, extra memory, and annotations.
+  uint64_t initialize_ns;
+
+  size_t thread_count;
+  size_t module_count;
+  size_t extra_memory_count;
+  size_t annotation_count;
+};
+
+// Enumerates what |process_snapshot| captured, as a snapshot’s consumer would,
+// and records the counts in |measurement|.
+void CountSnapshot(const ProcessSnapshot* process_snapshot,
+                   Measurement* measurement) {
+  measurement->thread_count = process_snapshot->Threads().size();
+  measurement->extra_memory_count = process_snapshot->ExtraMemory().size();
+
+  const std::vector<const ModuleSnapshot*> modules =
+      process_snapshot->Modules();
+  measurement->module_count = modules.size();
+  measurement->annotation_count = 0;
+  for (const ModuleSnapshot* module : modules) {
+    measurement->annotation_count += module->AnnotationsSimpleMap().size() +
+                                     module->AnnotationObjects().size();
+  }
+}
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+
+bool SnapshotTarget(pid_t pid, Measurement* measurement) {
+  const uint64_t start_time = ClockMonotonicNanoseconds();
+
+  DirectPtraceConnection connection;
+  if (!connection.Initialize(pid)) {
+    return false;
+  }
+
+  const uint64_t suspended_time = ClockMonotonicNanoseconds();
+
+  ProcessSnapshotLinux process_snapshot;
+  if (!process_snapshot.Initialize(&connection)) {
+    return false;
+  }
+  CountSnapshot(&process_snapshot, measurement);
+
+  measurement->suspend_ns = suspended_time - start_time;
+  measurement->initialize_ns = ClockMonotonicNanoseconds() - suspended_time;
+  return true;
+}
+
+#elif defined(OS_MACOSX)
+
+bool SnapshotTarget(task_t task, Measurement* measurement) {
+  const uint64_t start_time = ClockMonotonicNanoseconds();
+
+  ScopedTaskSuspend suspend(task);
+
+  const uint64_t suspended_time = ClockMonotonicNanoseconds();
+
+  ProcessSnapshotMac process_snapshot;
+  if (!process_snapshot.Initialize(task)) {
+    return false;
+  }
+  CountSnapshot(&process_snapshot, measurement);
+
+  measurement->suspend_ns = suspended_time - start_time;
+  measurement->initialize_ns = ClockMonotonicNanoseconds() - suspended_time;
+  return true;
+}
+
+#elif defined(OS_WIN)
+
+bool SnapshotTarget(HANDLE process, Measurement* measurement) {
+  const uint64_t start_time = ClockMonotonicNanoseconds();
+
+  ScopedProcessSuspend suspend(process);
+
+  const uint64_t suspended_time = ClockMonotonicNanoseconds();
+
+  ProcessSnapshotWin process_snapshot;
+  if (!process_snapshot.Initialize(
+          process, ProcessSuspensionState::kSuspended, 0, 0)) {
+    return false;
+  }
+  CountSnapshot(&process_snapshot, measurement);
+
+  measurement->suspend_ns = suspended_time - start_time;
+  measurement->initialize_ns = ClockMonotonicNanoseconds() - suspended_time;
+  return true;
+}
+
+#endif  // OS_LINUX || OS_ANDROID
+
+#if defined(OS_WIN)
+
+class BenchmarkTarget : public test::WinChildProcess {
+ public:
+  BenchmarkTarget() : test::WinChildProcess() {}
+  ~BenchmarkTarget() {}
+
+ private:
+  // WinChildProcess:
+  int Run() override {
+    RunTarget(ReadPipeHandle(), WritePipeHandle());
+    return EXIT_SUCCESS;
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(BenchmarkTarget);
+};
+
+// Starts a target, snapshots it, and stops it.
+bool MeasureOnce(const TargetParameters& parameters,
+                 const base::FilePath& module_directory,
+                 Measurement* measurement) {
+  std::unique_ptr<test::WinChildProcess::Handles> handles =
+      test::WinChildProcess::Launch();
+  if (!handles) {
+    return false;
+  }
+
+  if (!StartTarget(parameters,
+                   module_directory,
+                   handles->read.get(),
+                   handles->write.get()) ||
+      !SnapshotTarget(handles->process.get(), measurement)) {
+    return false;
+  }
+
+  handles->write.reset();
+  WaitForSingleObject(handles->process.get(), INFINITE);
+  return true;
+}
+
+#else  // OS_WIN
+
+#if defined(OS_MACOSX)
+using BenchmarkMultiprocess = test::MachMultiprocess;
+#else
+using BenchmarkMultiprocess = test::Multiprocess;
+#endif  // OS_MACOSX
+
+// A forked target, snapshotted by the parent.
+class BenchmarkTarget final : public BenchmarkMultiprocess {
+ public:
+  BenchmarkTarget(const TargetParameters& parameters,
+                  const base::FilePath& module_directory,
+                  Measurement* measurement)
+      : BenchmarkMultiprocess(),
+        module_directory_(module_directory),
+        parameters_(parameters),
+        measurement_(measurement),
+        successful_(false) {}
+
+  ~BenchmarkTarget() {}
+
+  bool successful() const { return successful_; }
+
+ private:
+  void Parent() {
+    if (!StartTarget(parameters_,
+                     module_directory_,
+                     ReadPipeHandle(),
+                     WritePipeHandle())) {
+      return;
+    }
+#if defined(OS_MACOSX)
+    successful_ = SnapshotTarget(ChildTask(), measurement_);
+#else
+    successful_ = SnapshotTarget(ChildPID(), measurement_);
+#endif  // OS_MACOSX
+    CloseWritePipe();
+  }
+
+  void Child() { RunTarget(ReadPipeHandle(), WritePipeHandle()); }
+
+#if defined(OS_MACOSX)
+  // MachMultiprocess:
+  void MachMultiprocessParent() override { Parent(); }
+  void MachMultiprocessChild() override { Child(); }
+#else
+  // Multiprocess:
+  void MultiprocessParent() override { Parent(); }
+  void MultiprocessChild() override { Child(); }
+#endif  // OS_MACOSX
+
+  base::FilePath module_directory_;
+  TargetParameters parameters_;
+  Measurement* measurement_;  // weak
+  bool successful_;
+
+  DISALLOW_COPY_AND_ASSIGN(BenchmarkTarget);
+};
+
+// Starts a target, snapshots it, and stops it.
+bool MeasureOnce(const TargetParameters& parameters,
+                 const base::FilePath& module_directory,
+                 Measurement* measurement) {
+  BenchmarkTarget target(parameters, module_directory, measurement);
+  target.Run();
+  return target.successful();
+}
+
+#endif  // OS_WIN
+
+// Copies the module at |source| to |count| distinctly-named modules in
+// |directory|, so that the target can load each as a module of its own.
+bool CopyModules(const base::FilePath& source,
+                 const base::FilePath& directory,
+                 uint32_t count) {
+  std::string contents;
+  if (count && !LoggingReadEntireFile(source, &contents)) {
+    return false;
+  }
+
+  for (uint32_t index = 0; index < count; ++index) {
+    FileWriter writer;
+    if (!writer.Open(ModulePath(directory, index),
+                     FileWriteMode::kCreateOrFail,
+                     FilePermissions::kOwnerOnly) ||
+        !writer.Write(contents.data(), contents.size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the median of |values|, which must not be empty.
+uint64_t Median(std::vector<uint64_t> values) {
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+void Usage(const base::FilePath& me) {
+  fprintf(stderr,
+"Usage: %" PRFilePath " [OPTION]...\n"
+"Measure the time taken to snapshot synthetic target processes, reporting the\n"
+"results as JSON.\n"
+"\n"
+"  -i, --iterations=COUNT        snapshot COUNT new targets (10)\n"
+"  -t, --threads=COUNT           give each target COUNT extra threads (16)\n"
+"  -d, --stack-depth=FRAMES      recurse FRAMES deep on each thread (64)\n"
+"  -m, --modules=COUNT           load COUNT extra modules (32)\n"
+"  -r, --memory-ranges=COUNT     register COUNT extra memory ranges (32)\n"
+"  -a, --annotations=COUNT       set COUNT simple annotations (64)\n"
+"  -o, --annotation-objects=COUNT\n"
+"                                set COUNT annotation objects (256)\n"
+"      --module=PATH             load copies of the module at PATH\n"
+"                                (crashpad_snapshot_test_module beside this\n"
+"                                executable)\n"
+"      --help                    display this help and exit\n"
+"      --version                 output version information and exit\n",
+          me.value().c_str());
+  ToolSupport::UsageTail(me);
+}
+
+int SnapshotBenchmarkMain(int argc, char* argv[]) {
+  const base::FilePath argv0(
+      ToolSupport::CommandLineArgumentToFilePathStringType(argv[0]));
+  const base::FilePath me(argv0.BaseName());
+
+  enum OptionFlags {
+    // “Short” (single-character) options.
+    kOptionAnnotations = 'a',
+    kOptionStackDepth = 'd',
+    kOptionIterations = 'i',
+    kOptionModules = 'm',
+    kOptionAnnotationObjects = 'o',
+    kOptionMemoryRanges = 'r',
+    kOptionThreads = 't',
+
+    // Long options without short equivalents.
+    kOptionLastChar = 255,
+    kOptionModule,
+
+    // Standard options.
+    kOptionHelp = -2,
+    kOptionVersion = -3,
+  };
+
+  unsigned int iterations = 10;
+  TargetParameters parameters;
+  parameters.thread_count = 16;
+  parameters.stack_depth = 64;
+  parameters.module_count = 32;
+  parameters.memory_range_count = 32;
+  parameters.annotation_count = 64;
+  parameters.annotation_object_count = 256;
+  base::FilePath module_path = argv0.DirName().Append(
+      base::FilePath::StringType(FILE_PATH_LITERAL(
+          "crashpad_snapshot_test_module")) +
+      kModuleExtension);
+
+  static constexpr option long_options[] = {
+      {"iterations", required_argument, nullptr, kOptionIterations},
+      {"threads", required_argument, nullptr, kOptionThreads},
+      {"stack-depth", required_argument, nullptr, kOptionStackDepth},
+      {"modules", required_argument, nullptr, kOptionModules},
+      {"memory-ranges", required_argument, nullptr, kOptionMemoryRanges},
+      {"annotations", required_argument, nullptr, kOptionAnnotations},
+      {"annotation-objects",
+       required_argument,
+       nullptr,
+       kOptionAnnotationObjects},
+      {"module", required_argument, nullptr, kOptionModule},
+      {"help", no_argument, nullptr, kOptionHelp},
+      {"version", no_argument, nullptr, kOptionVersion},
+      {nullptr, 0, nullptr, 0},
+  };
+
+  int opt;
+  while ((opt = getopt_long(
+              argc, argv, "a:d:i:m:o:r:t:", long_options, nullptr)) != -1) {
+    unsigned int* value;
+    switch (opt) {
+      case kOptionAnnotations:
+        value = &parameters.annotation_count;
+        break;
+      case kOptionAnnotationObjects:
+        value = &parameters.annotation_object_count;
+        break;
+      case kOptionIterations:
+        value = &iterations;
+        break;
+      case kOptionMemoryRanges:
+        value = &parameters.memory_range_count;
+        break;
+      case kOptionModules:
+        value = &parameters.module_count;
+        break;
+      case kOptionStackDepth:
+        value = &parameters.stack_depth;
+        break;
+      case kOptionThreads:
+        value = &parameters.thread_count;
+        break;
+      case kOptionModule:
+        module_path = base::FilePath(
+            ToolSupport::CommandLineArgumentToFilePathStringType(optarg));
+        continue;
+      case kOptionHelp:
+        Usage(me);
+        return EXIT_SUCCESS;
+      case kOptionVersion:
+        ToolSupport::Version(me);
+        return EXIT_SUCCESS;
+      default:
+        ToolSupport::UsageHint(me, nullptr);
+        return EXIT_FAILURE;
+    }
+
+    if (!StringToNumber(optarg, value)) {
+      ToolSupport::UsageHint(me, "numeric value required");
+      return EXIT_FAILURE;
+    }
+  }
+  argc -= optind;
+  argv += optind;
+
+  if (argc != 0 || iterations == 0) {
+    ToolSupport::UsageHint(me, nullptr);
+    return EXIT_FAILURE;
+  }
+
+  // The target registers its memory ranges and simple annotations with its
+  // own CrashpadInfo structure, which holds a limited number of each.
+  if (parameters.stack_depth > kMaxStackDepth ||
+      parameters.memory_range_count > SimpleAddressRangeBag::num_entries ||
+      parameters.annotation_count > SimpleStringDictionary::num_entries) {
+    ToolSupport::UsageHint(
+        me,
+        base::StringPrintf("at most %u stack frames, %zu memory ranges, and "
+                           "%zu annotations are supported",
+                           kMaxStackDepth,
+                           SimpleAddressRangeBag::num_entries,
+                           SimpleStringDictionary::num_entries)
+            .c_str());
+    return EXIT_FAILURE;
+  }
+
+  test::ScopedTempDir module_directory;
+  if (!CopyModules(
+          module_path, module_directory.path(), parameters.module_count)) {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Measurement> measurements(iterations);
+  for (Measurement& measurement : measurements) {
+    if (!MeasureOnce(parameters, module_directory.path(), &measurement)) {
+      LOG(ERROR) << "snapshot failed";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The counts are of what was captured, which includes the target’s own
+  // threads, modules, and annotations, and differ from the parameters by a
+  // constant for a given build.
+  printf("{\n");
+  printf("  \"parameters\": {\n");
+  printf("    \"iterations\": %u,\n", iterations);
+  printf("    \"threads\": %u,\n", parameters.thread_count);
+  printf("    \"stack_depth\": %u,\n", parameters.stack_depth);
+  printf("    \"modules\": %u,\n", parameters.module_count);
+  printf("    \"memory_ranges\": %u,\n", parameters.memory_range_count);
+  printf("    \"annotations\": %u,\n", parameters.annotation_count);
+  printf("    \"annotation_objects\": %u\n",
+         parameters.annotation_object_count);
+  printf("  },\n");
+
+  std::vector<uint64_t> suspend_times;
+  std::vector<uint64_t> initialize_times;
+  printf("  \"iterations\": [\n");
+  for (size_t index = 0; index < measurements.size(); ++index) {
+    const Measurement& measurement = measurements[index];
+    suspend_times.push_back(measurement.suspend_ns);
+    initialize_times.push_back(measurement.initialize_ns);
+    printf("    {\"suspend_ns\": %llu, \"initialize_ns\": %llu, "
+           "\"threads\": %zu, \"modules\": %zu, \"extra_memory\": %zu, "
+           "\"annotations\": %zu}%s\n",
+           static_cast<unsigned long long>(measurement.suspend_ns),
+           static_cast<unsigned long long>(measurement.initialize_ns),
+           measurement.thread_count,
+           measurement.module_count,
+           measurement.extra_memory_count,
+           measurement.annotation_count,
+           index + 1 < measurements.size() ? "," : "");
+  }
+  printf("  ],\n");
+
+  printf("  \"suspend_ns_median\": %llu,\n",
+         static_cast<unsigned long long>(Median(suspend_times)));
+  printf("  \"initialize_ns_min\": %llu,\n",
+         static_cast<unsigned long long>(*std::min_element(
+             initialize_times.begin(), initialize_times.end())));
+  printf("  \"initialize_ns_median\": %llu\n",
+         static_cast<unsigned long long>(Median(initialize_times)));
+  printf("}\n");
+
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+}  // namespace crashpad
+
+#if defined(OS_POSIX)
+int main(int argc, char* argv[]) {
+  return crashpad::SnapshotBenchmarkMain(argc, argv);
+}
+#elif defined(OS_WIN)
+int wmain(int argc, wchar_t* argv[]) {
+  // A relaunched copy of this executable is a target.
+  crashpad::test::WinChildProcess::EntryPoint<crashpad::BenchmarkTarget>();
+  return crashpad::ToolSupport::Wmain(
+      argc, argv, crashpad::SnapshotBenchmarkMain);
+}
+#endif  // OS_POSIX
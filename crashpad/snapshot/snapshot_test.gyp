@@ -52,6 +52,7 @@
       'target_name': 'crashpad_snapshot_test',
       'type': 'executable',
       'dependencies': [
+        'crashpad_snapshot_test_lib',
         'crashpad_snapshot_test_module',
         'snapshot.gyp:crashpad_snapshot',
         'snapshot.gyp:crashpad_snapshot_api',
@@ -67,12 +68,17 @@
         '..',
       ],
       'sources': [
+        'capture_deadline_test.cc',
+        'capture_memory_test.cc',
         'cpu_context_test.cc',
+        'crash_signature_test.cc',
         'crashpad_info_client_options_test.cc',
         'api/module_annotations_win_test.cc',
         'elf/elf_image_reader_test.cc',
+        'linux/build_id_cache_test.cc',
         'linux/debug_rendezvous_test.cc',
         'linux/exception_snapshot_linux_test.cc',
+        'linux/memory_map_region_snapshot_linux_test.cc',
         'linux/process_reader_test.cc',
         'linux/system_snapshot_linux_test.cc',
         'mac/cpu_context_mac_test.cc',
@@ -82,16 +88,22 @@
         'mac/process_reader_test.cc',
         'mac/process_types_test.cc',
         'mac/system_snapshot_mac_test.cc',
+        'memory_snapshot_test.cc',
         'minidump/process_snapshot_minidump_test.cc',
         'posix/timezone_test.cc',
+        'redacted/process_snapshot_redacted_test.cc',
+        'ring_buffer_snapshot_test.cc',
+        'top_frames_test.cc',
         'win/cpu_context_win_test.cc',
         'win/exception_snapshot_win_test.cc',
         'win/extra_memory_ranges_test.cc',
+        'win/lock_list_walker_test.cc',
         'win/pe_image_annotations_reader_test.cc',
         'win/pe_image_reader_test.cc',
         'win/process_reader_win_test.cc',
         'win/process_snapshot_win_test.cc',
         'win/system_snapshot_win_test.cc',
+        'x86/memory_operands_test.cc',
       ],
       'conditions': [
         ['OS=="mac"', {
@@ -143,6 +155,12 @@
             ['include', '^linux/'],
           ],
         }],
+        ['target_arch!="ia32" and target_arch!="x64"', {
+          'sources/': [
+            ['exclude', '^capture_memory_test\\.cc$'],
+            ['exclude', '^x86/'],
+          ],
+        }],
       ],
     },
     {
@@ -159,6 +177,36 @@
         'crashpad_info_client_options_test_module.cc',
       ],
     },
+    {
+      'target_name': 'crashpad_snapshot_benchmark',
+      'type': 'executable',
+      'dependencies': [
+        'crashpad_snapshot_test_module',
+        'snapshot.gyp:crashpad_snapshot',
+        '../client/client.gyp:crashpad_client',
+        '../compat/compat.gyp:crashpad_compat',
+        '../test/test.gyp:crashpad_test',
+        '../third_party/gtest/gtest.gyp:gtest',
+        '../third_party/mini_chromium/mini_chromium.gyp:base',
+        '../tools/tools.gyp:crashpad_tool_support',
+        '../util/util.gyp:crashpad_util',
+      ],
+      'include_dirs': [
+        '..',
+      ],
+      'sources': [
+        'snapshot_benchmark.cc',
+      ],
+      'conditions': [
+        ['OS=="linux" or OS=="android"', {
+          'link_settings': {
+            'libraries': [
+              '-ldl',
+            ],
+          },
+        }],
+      ],
+    },
   ],
   'conditions': [
     ['OS=="mac"', {
@@ -0,0 +1,86 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/system_snapshot_cache.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include "snapshot/x86/cpuid_reader.h"
+#endif  // ARCH_CPU_X86_FAMILY
+
+namespace crashpad {
+
+SystemSnapshotCache::OSVersion::OSVersion()
+    : full(), build(), major(0), minor(0), bugfix(0), server(false) {}
+
+SystemSnapshotCache::OSVersion::~OSVersion() {}
+
+SystemSnapshotCache::SystemSnapshotCache()
+    : os_version_(),
+      machine_description_(),
+#if defined(ARCH_CPU_X86_FAMILY)
+      cpuid_(),
+#endif  // ARCH_CPU_X86_FAMILY
+#if defined(OS_POSIX)
+      time_zone_(),
+#endif  // OS_POSIX
+      lock_(),
+      have_os_version_(false),
+      have_machine_description_(false) {
+}
+
+SystemSnapshotCache::~SystemSnapshotCache() {}
+
+bool SystemSnapshotCache::LookupOSVersion(OSVersion* os_version) {
+  base::AutoLock lock(lock_);
+  if (!have_os_version_) {
+    return false;
+  }
+  *os_version = os_version_;
+  return true;
+}
+
+void SystemSnapshotCache::InsertOSVersion(const OSVersion& os_version) {
+  base::AutoLock lock(lock_);
+  os_version_ = os_version;
+  have_os_version_ = true;
+}
+
+bool SystemSnapshotCache::LookupMachineDescription(
+    std::string* machine_description) {
+  base::AutoLock lock(lock_);
+  if (!have_machine_description_) {
+    return false;
+  }
+  *machine_description = machine_description_;
+  return true;
+}
+
+void SystemSnapshotCache::InsertMachineDescription(
+    const std::string& machine_description) {
+  base::AutoLock lock(lock_);
+  machine_description_ = machine_description;
+  have_machine_description_ = true;
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+const internal::CpuidReader* SystemSnapshotCache::Cpuid() {
+  base::AutoLock lock(lock_);
+  if (!cpuid_) {
+    cpuid_.reset(new internal::CpuidReader());
+  }
+  return cpuid_.get();
+}
+#endif  // ARCH_CPU_X86_FAMILY
+
+}  // namespace crashpad
@@ -0,0 +1,141 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_SYSTEM_SNAPSHOT_CACHE_H_
+#define CRASHPAD_SNAPSHOT_SYSTEM_SNAPSHOT_CACHE_H_
+
+#include <memory>
+#include <string>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "build/build_config.h"
+
+#if defined(OS_POSIX)
+#include "snapshot/posix/timezone.h"
+#endif  // OS_POSIX
+
+namespace crashpad {
+
+namespace internal {
+class CpuidReader;
+}  // namespace internal
+
+//! \brief A cache of facts about the system, shared by the SystemSnapshot
+//!     objects of many processes.
+//!
+//! A handler that writes many reports would otherwise determine the operating
+//! system version, machine description, and CPU identity anew for each,
+//! although they don’t change while it runs. Those facts are determined once,
+//! by the first snapshot that needs them. The time zone can change, so it is
+//! checked for each snapshot, but is only probed again when it may have
+//! changed. Values that are truly per-crash, such as the CPU frequency, are not
+//! cached.
+//!
+//! This class is thread-safe.
+class SystemSnapshotCache {
+ public:
+  //! \brief The operating system version, as reported by SystemSnapshot.
+  struct OSVersion {
+    OSVersion();
+    ~OSVersion();
+
+    //! \brief See SystemSnapshot::OSVersionFull().
+    std::string full;
+
+    //! \brief See SystemSnapshot::OSVersion().
+    std::string build;
+
+    //! \brief See SystemSnapshot::OSVersion().
+    int major;
+
+    //! \brief See SystemSnapshot::OSVersion().
+    int minor;
+
+    //! \brief See SystemSnapshot::OSVersion().
+    int bugfix;
+
+    //! \brief See SystemSnapshot::OSServer().
+    bool server;
+  };
+
+  SystemSnapshotCache();
+  ~SystemSnapshotCache();
+
+  //! \brief Looks up the operating system version.
+  //!
+  //! \param[out] os_version The version, if found.
+  //! \return `true` if the version has been recorded by InsertOSVersion().
+  bool LookupOSVersion(OSVersion* os_version);
+
+  //! \brief Records the operating system version.
+  void InsertOSVersion(const OSVersion& os_version);
+
+  //! \brief Looks up the machine description.
+  //!
+  //! \param[out] machine_description The description, if found, as
+  //!     SystemSnapshot::MachineDescription() would return it.
+  //! \return `true` if the description has been recorded by
+  //!     InsertMachineDescription().
+  bool LookupMachineDescription(std::string* machine_description);
+
+  //! \brief Records the machine description.
+  void InsertMachineDescription(const std::string& machine_description);
+
+#if defined(ARCH_CPU_X86_FAMILY)
+  //! \brief Returns a reader of the CPU’s `cpuid` information, created the
+  //!     first time that this is called.
+  //!
+  //! The returned object is owned by this object.
+  const internal::CpuidReader* Cpuid();
+#endif  // ARCH_CPU_X86_FAMILY
+
+#if defined(OS_POSIX)
+  //! \brief Returns time zone information as internal::TimeZone() does.
+  //!
+  //! See internal::TimeZoneCache.
+  void TimeZone(const timeval& snapshot_time,
+                SystemSnapshot::DaylightSavingTimeStatus* dst_status,
+                int* standard_offset_seconds,
+                int* daylight_offset_seconds,
+                std::string* standard_name,
+                std::string* daylight_name) {
+    time_zone_.TimeZone(snapshot_time,
+                        dst_status,
+                        standard_offset_seconds,
+                        daylight_offset_seconds,
+                        standard_name,
+                        daylight_name);
+  }
+#endif  // OS_POSIX
+
+ private:
+  OSVersion os_version_;
+  std::string machine_description_;
+#if defined(ARCH_CPU_X86_FAMILY)
+  std::unique_ptr<internal::CpuidReader> cpuid_;
+#endif  // ARCH_CPU_X86_FAMILY
+#if defined(OS_POSIX)
+  internal::TimeZoneCache time_zone_;
+#endif  // OS_POSIX
+  base::Lock lock_;
+  bool have_os_version_;
+  bool have_machine_description_;
+
+  DISALLOW_COPY_AND_ASSIGN(SystemSnapshotCache);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_SYSTEM_SNAPSHOT_CACHE_H_
@@ -14,6 +14,8 @@
 
 #include "snapshot/test/test_memory_snapshot.h"
 
+#include <string.h>
+
 #include <string>
 
 namespace crashpad {
@@ -39,9 +41,29 @@ bool TestMemorySnapshot::Read(Delegate* delegate) const {
     return delegate->MemorySnapshotDelegateRead(nullptr, size_);
   }
 
+  void* delegate_buffer = delegate->MemorySnapshotDelegateBuffer(size_);
+  if (delegate_buffer) {
+    memset(delegate_buffer, value_, size_);
+    return delegate->MemorySnapshotDelegateRead(delegate_buffer, size_);
+  }
+
   std::string buffer(size_, value_);
   return delegate->MemorySnapshotDelegateRead(&buffer[0], size_);
 }
 
+const MemorySnapshot* TestMemorySnapshot::MergeWithOtherSnapshot(
+    const MemorySnapshot* other) const {
+  CheckedRange<uint64_t, size_t> merged(0, 0);
+  if (!DetermineMergedRange(this, other, &merged)) {
+    return nullptr;
+  }
+
+  TestMemorySnapshot* result = new TestMemorySnapshot();
+  result->SetAddress(merged.base());
+  result->SetSize(merged.size());
+  result->SetValue(value_);
+  return result;
+}
+
 }  // namespace test
 }  // namespace crashpad
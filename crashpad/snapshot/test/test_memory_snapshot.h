@@ -46,6 +46,12 @@ class TestMemorySnapshot final : public MemorySnapshot {
   size_t Size() const override;
   bool Read(Delegate* delegate) const override;
 
+  //! \copydoc MemorySnapshot::MergeWithOtherSnapshot()
+  //!
+  //! The merged snapshot is filled with this snapshot’s value.
+  const MemorySnapshot* MergeWithOtherSnapshot(
+      const MemorySnapshot* other) const override;
+
  private:
   uint64_t address_;
   size_t size_;
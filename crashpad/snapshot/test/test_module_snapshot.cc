@@ -30,6 +30,8 @@ TestModuleSnapshot::TestModuleSnapshot()
       debug_file_name_(),
       annotations_vector_(),
       annotations_simple_map_(),
+      annotation_objects_(),
+      thread_annotation_objects_(),
       extra_memory_ranges_() {
 }
 
@@ -94,6 +96,15 @@ std::map<std::string, std::string> TestModuleSnapshot::AnnotationsSimpleMap()
   return annotations_simple_map_;
 }
 
+std::vector<AnnotationSnapshot> TestModuleSnapshot::AnnotationObjects() const {
+  return annotation_objects_;
+}
+
+std::map<uint64_t, std::vector<AnnotationSnapshot>>
+TestModuleSnapshot::ThreadAnnotationObjects() const {
+  return thread_annotation_objects_;
+}
+
 std::set<CheckedRange<uint64_t>> TestModuleSnapshot::ExtraMemoryRanges() const {
   return extra_memory_ranges_;
 }
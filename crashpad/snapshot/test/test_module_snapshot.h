@@ -76,6 +76,15 @@ class TestModuleSnapshot final : public ModuleSnapshot {
       const std::map<std::string, std::string>& annotations_simple_map) {
     annotations_simple_map_ = annotations_simple_map;
   }
+  void SetAnnotationObjects(
+      const std::vector<AnnotationSnapshot>& annotation_objects) {
+    annotation_objects_ = annotation_objects;
+  }
+  void SetThreadAnnotationObjects(
+      const std::map<uint64_t, std::vector<AnnotationSnapshot>>&
+          thread_annotation_objects) {
+    thread_annotation_objects_ = thread_annotation_objects;
+  }
   void SetExtraMemoryRanges(
       const std::set<CheckedRange<uint64_t>>& extra_memory_ranges) {
     extra_memory_ranges_ = extra_memory_ranges;
@@ -103,6 +112,9 @@ class TestModuleSnapshot final : public ModuleSnapshot {
   std::string DebugFileName() const override;
   std::vector<std::string> AnnotationsVector() const override;
   std::map<std::string, std::string> AnnotationsSimpleMap() const override;
+  std::vector<AnnotationSnapshot> AnnotationObjects() const override;
+  std::map<uint64_t, std::vector<AnnotationSnapshot>> ThreadAnnotationObjects()
+      const override;
   std::set<CheckedRange<uint64_t>> ExtraMemoryRanges() const override;
   std::vector<const UserMinidumpStream*> CustomMinidumpStreams() const override;
 
@@ -119,6 +131,9 @@ class TestModuleSnapshot final : public ModuleSnapshot {
   std::string debug_file_name_;
   std::vector<std::string> annotations_vector_;
   std::map<std::string, std::string> annotations_simple_map_;
+  std::vector<AnnotationSnapshot> annotation_objects_;
+  std::map<uint64_t, std::vector<AnnotationSnapshot>>
+      thread_annotation_objects_;
   std::set<CheckedRange<uint64_t>> extra_memory_ranges_;
   PointerVector<const UserMinidumpStream> custom_minidump_streams_;
 
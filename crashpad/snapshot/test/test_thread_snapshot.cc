@@ -22,6 +22,7 @@ TestThreadSnapshot::TestThreadSnapshot()
       context_(),
       stack_(),
       thread_id_(0),
+      thread_name_(),
       suspend_count_(0),
       priority_(0),
       thread_specific_data_address_(0) {
@@ -43,6 +44,10 @@ uint64_t TestThreadSnapshot::ThreadID() const {
   return thread_id_;
 }
 
+std::string TestThreadSnapshot::ThreadName() const {
+  return thread_name_;
+}
+
 int TestThreadSnapshot::SuspendCount() const {
   return suspend_count_;
 }
@@ -18,6 +18,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -61,6 +62,9 @@ class TestThreadSnapshot final : public ThreadSnapshot {
   }
 
   void SetThreadID(uint64_t thread_id) { thread_id_ = thread_id; }
+  void SetThreadName(const std::string& thread_name) {
+    thread_name_ = thread_name;
+  }
   void SetSuspendCount(int suspend_count) { suspend_count_ = suspend_count; }
   void SetPriority(int priority) { priority_ = priority; }
   void SetThreadSpecificDataAddress(uint64_t thread_specific_data_address) {
@@ -81,6 +85,7 @@ class TestThreadSnapshot final : public ThreadSnapshot {
   const CPUContext* Context() const override;
   const MemorySnapshot* Stack() const override;
   uint64_t ThreadID() const override;
+  std::string ThreadName() const override;
   int SuspendCount() const override;
   int Priority() const override;
   uint64_t ThreadSpecificDataAddress() const override;
@@ -94,6 +99,7 @@ class TestThreadSnapshot final : public ThreadSnapshot {
   CPUContext context_;
   std::unique_ptr<MemorySnapshot> stack_;
   uint64_t thread_id_;
+  std::string thread_name_;
   int suspend_count_;
   int priority_;
   uint64_t thread_specific_data_address_;
@@ -17,6 +17,7 @@
 
 #include <stdint.h>
 
+#include <string>
 #include <vector>
 
 namespace crashpad {
@@ -51,6 +52,13 @@ class ThreadSnapshot {
   //! unique system-wide.
   virtual uint64_t ThreadID() const = 0;
 
+  //! \brief Returns the thread’s name.
+  //!
+  //! A thread’s name is assigned by its process, typically to identify its
+  //! role, and need not be unique. An empty string is returned if the thread
+  //! has no name or if its name could not be determined.
+  virtual std::string ThreadName() const = 0;
+
   //! \brief Returns the thread’s suspend count.
   //!
   //! A suspend count of `0` denotes a schedulable (not suspended) thread.
@@ -0,0 +1,51 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/top_frames.h"
+
+#include <inttypes.h>
+
+#include "base/strings/stringprintf.h"
+#include "snapshot/module_snapshot.h"
+
+namespace crashpad {
+
+std::string FormatTopFrames(const std::vector<const ModuleSnapshot*>& modules,
+                            const std::vector<TopFrame>& frames) {
+  std::string formatted;
+  for (const TopFrame& frame : frames) {
+    if (!formatted.empty()) {
+      formatted.push_back('|');
+    }
+
+    if (frame.module_index >= modules.size()) {
+      formatted.append(base::StringPrintf("0x%" PRIx64, frame.address));
+      continue;
+    }
+
+    const std::string name = modules[frame.module_index]->Name();
+    const size_t slash = name.rfind('/');
+    formatted.append(slash == std::string::npos ? name
+                                                : name.substr(slash + 1));
+    formatted.append(base::StringPrintf("+0x%" PRIx64, frame.module_offset));
+    if (!frame.symbol.empty()) {
+      formatted.append(base::StringPrintf(" (%s+0x%" PRIx64 ")",
+                                          frame.symbol.c_str(),
+                                          frame.symbol_offset));
+    }
+  }
+  return formatted;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,77 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_TOP_FRAMES_H_
+#define CRASHPAD_SNAPSHOT_TOP_FRAMES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace crashpad {
+
+class ModuleSnapshot;
+
+//! \brief A frame of the exception thread’s stack, found by unwinding it and
+//!     identified without symbol files.
+struct TopFrame {
+  //! \brief The value of #module_index for a frame outside of every module.
+  static constexpr size_t kNoModule = static_cast<size_t>(-1);
+
+  TopFrame()
+      : address(0),
+        module_index(kNoModule),
+        module_offset(0),
+        symbol(),
+        symbol_offset(0) {}
+
+  //! \brief The address of the instruction the frame was executing, or for
+  //!     every frame but the innermost, its return address.
+  uint64_t address;
+
+  //! \brief The index of the module containing #address in
+  //!     ProcessSnapshot::Modules(), or #kNoModule.
+  size_t module_index;
+
+  //! \brief The offset of #address from the base address of the module at
+  //!     #module_index.
+  uint64_t module_offset;
+
+  //! \brief The name of the nearest exported or dynamic function symbol at or
+  //!     below #address, or empty if none was found.
+  std::string symbol;
+
+  //! \brief The offset of #address from the address of #symbol.
+  uint64_t symbol_offset;
+};
+
+//! \brief Formats frames compactly for use as an annotation.
+//!
+//! Each frame is formatted as the base name of its module and its offset into
+//! the module, followed by its symbol and offset into the symbol if it has
+//! one, such as `libc.so.6+0x35fc0 (abort+0x130)`. A frame outside of every
+//! module is formatted as its address. Frames are separated by `|`.
+//!
+//! \param[in] modules The modules that TopFrame::module_index refers to.
+//! \param[in] frames The frames to format.
+//!
+//! \return The formatted frames.
+std::string FormatTopFrames(const std::vector<const ModuleSnapshot*>& modules,
+                            const std::vector<TopFrame>& frames);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_TOP_FRAMES_H_
@@ -0,0 +1,66 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/top_frames.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "snapshot/test/test_module_snapshot.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TopFrame MakeFrame(uint64_t address,
+                   size_t module_index,
+                   uint64_t module_offset,
+                   const std::string& symbol,
+                   uint64_t symbol_offset) {
+  TopFrame frame;
+  frame.address = address;
+  frame.module_index = module_index;
+  frame.module_offset = module_offset;
+  frame.symbol = symbol;
+  frame.symbol_offset = symbol_offset;
+  return frame;
+}
+
+TEST(TopFrames, Empty) {
+  EXPECT_EQ(FormatTopFrames(std::vector<const ModuleSnapshot*>(),
+                            std::vector<TopFrame>()),
+            "");
+}
+
+TEST(TopFrames, Format) {
+  TestModuleSnapshot libc;
+  libc.SetName("/lib/x86_64-linux-gnu/libc.so.6");
+  TestModuleSnapshot exe;
+  exe.SetName("crashy");
+  const std::vector<const ModuleSnapshot*> modules = {&libc, &exe};
+
+  const std::vector<TopFrame> frames = {
+      MakeFrame(0x7f0000035fc0, 0, 0x35fc0, "abort", 0x130),
+      MakeFrame(0x55000000123a, 1, 0x123a, "", 0),
+      MakeFrame(0x1234, TopFrame::kNoModule, 0, "", 0),
+      MakeFrame(0x9999, 7, 0x99, "", 0),
+  };
+  EXPECT_EQ(FormatTopFrames(modules, frames),
+            "libc.so.6+0x35fc0 (abort+0x130)|crashy+0x123a|0x1234|0x9999");
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -14,6 +14,8 @@
 
 #include "snapshot/win/capture_memory_delegate_win.h"
 
+#include <algorithm>
+
 #include "base/numerics/safe_conversions.h"
 #include "snapshot/win/memory_snapshot_win.h"
 
@@ -24,11 +26,13 @@ CaptureMemoryDelegateWin::CaptureMemoryDelegateWin(
     ProcessReaderWin* process_reader,
     const ProcessReaderWin::Thread& thread,
     PointerVector<MemorySnapshotWin>* snapshots,
-    uint32_t* budget_remaining)
+    uint32_t* budget_remaining,
+    const std::vector<CheckedRange<uint64_t>>* excluded_ranges)
     : stack_(thread.stack_region_address, thread.stack_region_size),
       process_reader_(process_reader),
       snapshots_(snapshots),
-      budget_remaining_(budget_remaining) {}
+      budget_remaining_(budget_remaining),
+      excluded_ranges_(excluded_ranges) {}
 
 bool CaptureMemoryDelegateWin::Is64Bit() const {
   return process_reader_->Is64Bit();
@@ -45,6 +49,76 @@ std::vector<CheckedRange<uint64_t>> CaptureMemoryDelegateWin::GetReadableRanges(
   return process_reader_->GetProcessInfo().GetReadableRanges(range);
 }
 
+std::vector<std::vector<CheckedRange<uint64_t>>>
+CaptureMemoryDelegateWin::GetReadableRanges(
+    const std::vector<CheckedRange<uint64_t>>& ranges) const {
+  return process_reader_->GetProcessInfo().GetReadableRanges(ranges);
+}
+
+void CaptureMemoryDelegateWin::GetMappedAddressBounds(uint64_t* low,
+                                                      uint64_t* high) const {
+  // The memory map is sorted by address and covers the whole address space,
+  // including free regions, so look for the first and last regions in use.
+  const ProcessInfo::MemoryBasicInformation64Vector& memory_info =
+      process_reader_->GetProcessInfo().MemoryInfo();
+  auto first = std::find_if(memory_info.begin(),
+                            memory_info.end(),
+                            [](const MEMORY_BASIC_INFORMATION64& mbi) {
+                              return mbi.State != MEM_FREE;
+                            });
+  if (first == memory_info.end()) {
+    // Nothing is mapped, so nothing can be captured.
+    *low = 1;
+    *high = 0;
+    return;
+  }
+
+  auto last = std::find_if(memory_info.rbegin(),
+                           memory_info.rend(),
+                           [](const MEMORY_BASIC_INFORMATION64& mbi) {
+                             return mbi.State != MEM_FREE;
+                           });
+  *low = first->BaseAddress;
+  *high = last->BaseAddress + last->RegionSize - 1;
+}
+
+bool CaptureMemoryDelegateWin::IsHeapAddress(uint64_t address) const {
+  // Heaps are built from committed, private, writable memory. Stacks are too,
+  // but pointers into this thread’s stack aren’t captured anyway.
+  const ProcessInfo::MemoryBasicInformation64Vector& memory_info =
+      process_reader_->GetProcessInfo().MemoryInfo();
+  auto it = std::upper_bound(memory_info.begin(),
+                             memory_info.end(),
+                             address,
+                             [](uint64_t value,
+                                const MEMORY_BASIC_INFORMATION64& mbi) {
+                               return value < mbi.BaseAddress;
+                             });
+  if (it == memory_info.begin()) {
+    return false;
+  }
+  --it;
+  if (address - it->BaseAddress >= it->RegionSize) {
+    return false;
+  }
+
+  constexpr DWORD kWritable =
+      PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE |
+      PAGE_EXECUTE_WRITECOPY;
+  return it->State == MEM_COMMIT && it->Type == MEM_PRIVATE &&
+         (it->Protect & kWritable) != 0 && (it->Protect & PAGE_GUARD) == 0;
+}
+
+std::vector<CheckedRange<uint64_t>>
+CaptureMemoryDelegateWin::GetExcludedRanges() const {
+  return excluded_ranges_ ? *excluded_ranges_
+                          : std::vector<CheckedRange<uint64_t>>();
+}
+
+bool CaptureMemoryDelegateWin::HasBudgetRemaining() const {
+  return !budget_remaining_ || *budget_remaining_ != 0;
+}
+
 void CaptureMemoryDelegateWin::AddNewMemorySnapshot(
     const CheckedRange<uint64_t, uint64_t>& range) {
   // Don't bother storing this memory if it points back into the stack.
@@ -17,6 +17,10 @@
 
 #include "snapshot/capture_memory.h"
 
+#include <stdint.h>
+
+#include <vector>
+
 #include "snapshot/win/process_reader_win.h"
 #include "util/stdlib/pointer_container.h"
 
@@ -38,16 +42,26 @@ class CaptureMemoryDelegateWin : public CaptureMemory::Delegate {
   //! \param[in] budget_remaining If non-null, a pointer to the remaining number
   //!     of bytes to capture. If this is `0`, no further memory will be
   //!     captured.
-  CaptureMemoryDelegateWin(ProcessReaderWin* process_reader,
-                           const ProcessReaderWin::Thread& thread,
-                           PointerVector<MemorySnapshotWin>* snapshots,
-                           uint32_t* budget_remaining);
+  //! \param[in] excluded_ranges If non-null, ranges that the process’ modules
+  //!     have excluded from capture.
+  CaptureMemoryDelegateWin(
+      ProcessReaderWin* process_reader,
+      const ProcessReaderWin::Thread& thread,
+      PointerVector<MemorySnapshotWin>* snapshots,
+      uint32_t* budget_remaining,
+      const std::vector<CheckedRange<uint64_t>>* excluded_ranges);
 
   // MemoryCaptureDelegate:
   bool Is64Bit() const override;
   bool ReadMemory(uint64_t at, uint64_t num_bytes, void* into) const override;
   std::vector<CheckedRange<uint64_t>> GetReadableRanges(
       const CheckedRange<uint64_t, uint64_t>& range) const override;
+  std::vector<std::vector<CheckedRange<uint64_t>>> GetReadableRanges(
+      const std::vector<CheckedRange<uint64_t>>& ranges) const override;
+  void GetMappedAddressBounds(uint64_t* low, uint64_t* high) const override;
+  bool IsHeapAddress(uint64_t address) const override;
+  std::vector<CheckedRange<uint64_t>> GetExcludedRanges() const override;
+  bool HasBudgetRemaining() const override;
   void AddNewMemorySnapshot(const CheckedRange<uint64_t, uint64_t>& range);
 
  private:
@@ -55,6 +69,7 @@ class CaptureMemoryDelegateWin : public CaptureMemory::Delegate {
   ProcessReaderWin* process_reader_;
   PointerVector<MemorySnapshotWin>* snapshots_;
   uint32_t* budget_remaining_;
+  const std::vector<CheckedRange<uint64_t>>* excluded_ranges_;  // weak
 };
 
 }  // namespace internal
@@ -249,6 +249,7 @@ def RunTests(cdb_path,
              z7_dump_path,
              other_program_path,
              other_program_no_exception_path,
+             other_program_in_handler_path,
              sigabrt_main_path,
              sigabrt_background_path,
              pipe_name):
@@ -419,6 +420,13 @@ def RunTests(cdb_path,
             'other program with no exception given')
   out.Check('!RaiseException', 'other program in RaiseException()')
 
+  out = CdbRun(cdb_path, other_program_in_handler_path, '.ecxr;k')
+  out.Check('Unknown exception - code deadbea7',
+            'other program dumped in handler exception code')
+  out.Check('!Sleep', 'other program dumped in handler reasonable location')
+  out.Check("hanging_program!`anonymous namespace'::Thread1",
+            'other program dumped in handler right thread')
+
   out = CdbRun(cdb_path, sigabrt_main_path, '.ecxr')
   out.Check('code 40000015', 'got sigabrt signal')
   out.Check('::HandleAbortSignal', '  stack in expected location')
@@ -476,6 +484,11 @@ def main(args):
     if not other_program_no_exception_path:
       return 1
 
+    other_program_in_handler_path = GetDumpFromOtherProgram(
+        args[0], pipe_name, 'inhandler')
+    if not other_program_in_handler_path:
+      return 1
+
     sigabrt_main_path = GetDumpFromSignal(args[0], pipe_name, 'main')
     if not sigabrt_main_path:
       return 1
@@ -492,6 +505,7 @@ def main(args):
              z7_dump_path,
              other_program_path,
              other_program_no_exception_path,
+             other_program_in_handler_path,
              sigabrt_main_path,
              sigabrt_background_path,
              pipe_name)
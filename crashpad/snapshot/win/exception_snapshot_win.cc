@@ -21,6 +21,7 @@
 #include "snapshot/win/capture_memory_delegate_win.h"
 #include "snapshot/win/memory_snapshot_win.h"
 #include "snapshot/win/process_reader_win.h"
+#include "util/misc/memory_read_trace.h"
 #include "util/win/nt_internals.h"
 
 namespace crashpad {
@@ -73,6 +74,24 @@ bool ExceptionSnapshotWin::Initialize(
     ProcessReaderWin* process_reader,
     DWORD thread_id,
     WinVMAddress exception_pointers_address) {
+  return InitializeInternal(process_reader,
+                            thread_id,
+                            exception_pointers_address,
+                            CrashpadClient::kSimulatedExceptionCode);
+}
+
+bool ExceptionSnapshotWin::InitializeFromThread(
+    ProcessReaderWin* process_reader,
+    DWORD thread_id,
+    DWORD exception_code) {
+  return InitializeInternal(process_reader, thread_id, 0, exception_code);
+}
+
+bool ExceptionSnapshotWin::InitializeInternal(
+    ProcessReaderWin* process_reader,
+    DWORD thread_id,
+    WinVMAddress exception_pointers_address,
+    DWORD exception_code) {
   INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
 
   const ProcessReaderWin::Thread* thread = nullptr;
@@ -94,32 +113,54 @@ bool ExceptionSnapshotWin::Initialize(
   const bool is_64_bit = false;
 #elif defined(ARCH_CPU_64_BITS)
   const bool is_64_bit = process_reader->Is64Bit();
-  if (is_64_bit) {
-    if (!InitializeFromExceptionPointers<EXCEPTION_RECORD64,
-                                         process_types::EXCEPTION_POINTERS64>(
-            process_reader,
-            exception_pointers_address,
-            thread_id,
-            &NativeContextToCPUContext64)) {
-      return false;
+#endif
+
+  if (!exception_pointers_address) {
+    InitializeFromThreadContext(*thread, is_64_bit, exception_code);
+  } else {
+#if defined(ARCH_CPU_64_BITS)
+    if (is_64_bit) {
+      if (!InitializeFromExceptionPointers<EXCEPTION_RECORD64,
+                                           process_types::EXCEPTION_POINTERS64>(
+              process_reader,
+              exception_pointers_address,
+              thread_id,
+              &NativeContextToCPUContext64)) {
+        return false;
+      }
     }
-  }
 #endif
-  if (!is_64_bit) {
-    if (!InitializeFromExceptionPointers<EXCEPTION_RECORD32,
-                                         process_types::EXCEPTION_POINTERS32>(
-            process_reader,
-            exception_pointers_address,
-            thread_id,
-            &NativeContextToCPUContext32)) {
-      return false;
+    if (!is_64_bit) {
+      if (!InitializeFromExceptionPointers<EXCEPTION_RECORD32,
+                                           process_types::EXCEPTION_POINTERS32>(
+              process_reader,
+              exception_pointers_address,
+              thread_id,
+              &NativeContextToCPUContext32)) {
+        return false;
+      }
     }
   }
 
+  ScopedMemoryReadSite read_site(MemoryReadSite::kIndirectMemory);
+  // The exception is captured before the modules that could exclude memory
+  // from capture are read. The memory that it refers to directly is kept
+  // regardless.
   CaptureMemoryDelegateWin capture_memory_delegate(
-      process_reader, *thread, &extra_memory_, nullptr);
+      process_reader, *thread, &extra_memory_, nullptr, nullptr);
   CaptureMemory::PointedToByContext(context_, &capture_memory_delegate);
 
+  // Access violations and in-page errors carry the address of the data access
+  // in their second parameter.
+  uint64_t fault_address = 0;
+  if ((exception_code_ == EXCEPTION_ACCESS_VIOLATION ||
+       exception_code_ == EXCEPTION_IN_PAGE_ERROR) &&
+      codes_.size() >= 2) {
+    fault_address = codes_[1];
+  }
+  CaptureMemory::AroundException(
+      context_, fault_address, &capture_memory_delegate);
+
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
@@ -154,6 +195,13 @@ const std::vector<uint64_t>& ExceptionSnapshotWin::Codes() const {
   return codes_;
 }
 
+void ExceptionSnapshotWin::MaterializeMemory() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  for (MemorySnapshotWin* memory : extra_memory_) {
+    memory->Materialize();
+  }
+}
+
 std::vector<const MemorySnapshot*> ExceptionSnapshotWin::ExtraMemory() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   std::vector<const MemorySnapshot*> result;
@@ -252,5 +300,28 @@ bool ExceptionSnapshotWin::InitializeFromExceptionPointers(
   return true;
 }
 
+void ExceptionSnapshotWin::InitializeFromThreadContext(
+    const ProcessReaderWin::Thread& thread,
+    bool is_64_bit,
+    DWORD exception_code) {
+  // No exception record was supplied, so the thread’s own context, as captured
+  // while it was suspended, stands in for one.
+  exception_code_ = exception_code;
+  exception_flags_ = 0;
+#if defined(ARCH_CPU_64_BITS)
+  if (is_64_bit) {
+    NativeContextToCPUContext64(
+        thread.context.native, &context_, &context_union_);
+  } else {
+    NativeContextToCPUContext32(
+        thread.context.wow64, &context_, &context_union_);
+  }
+#else
+  NativeContextToCPUContext32(
+      thread.context.native, &context_, &context_union_);
+#endif
+  exception_address_ = context_.InstructionPointer();
+}
+
 }  // namespace internal
 }  // namespace crashpad
@@ -22,6 +22,7 @@
 #include "build/build_config.h"
 #include "snapshot/cpu_context.h"
 #include "snapshot/exception_snapshot.h"
+#include "snapshot/win/process_reader_win.h"
 #include "snapshot/win/thread_snapshot_win.h"
 #include "util/misc/initialization_state_dcheck.h"
 #include "util/stdlib/pointer_container.h"
@@ -55,7 +56,10 @@ class ExceptionSnapshotWin final : public ExceptionSnapshot {
   //! \param[in] thread_id The thread ID in which the exception occurred.
   //! \param[in] exception_pointers The address of an `EXCEPTION_POINTERS`
   //!     record in the target process, passed through from the exception
-  //!     handler.
+  //!     handler. `0` if the dump was requested by
+  //!     CrashpadClient::DumpWithoutCrashAsync(), in which case the exception
+  //!     is reported at the context of \a thread_id as read by \a
+  //!     process_reader, with CrashpadClient::kSimulatedExceptionCode.
   //!
   //! \note If the exception was triggered by
   //!     CrashpadClient::DumpAndCrashTargetProcess(), this has the side-effect
@@ -67,6 +71,29 @@ class ExceptionSnapshotWin final : public ExceptionSnapshot {
                   DWORD thread_id,
                   WinVMAddress exception_pointers);
 
+  //! \brief Initializes the object with an exception fabricated at the context
+  //!     of a thread.
+  //!
+  //! This is like calling Initialize() with \a exception_pointers `0`, but
+  //! reports \a exception_code in place of
+  //! CrashpadClient::kSimulatedExceptionCode.
+  //!
+  //! \param[in] process_reader A ProcessReader for the process.
+  //! \param[in] thread_id The thread ID to report the exception in.
+  //! \param[in] exception_code The exception code to report.
+  //!
+  //! \return `true` if the snapshot could be created, `false` otherwise with
+  //!     an appropriate message logged.
+  bool InitializeFromThread(ProcessReaderWin* process_reader,
+                            DWORD thread_id,
+                            DWORD exception_code);
+
+  //! \brief Reads all of the exception’s memory snapshots now, so that they no
+  //!     longer depend on the process.
+  //!
+  //! \sa MemorySnapshotWin::Materialize()
+  void MaterializeMemory();
+
   // ExceptionSnapshot:
 
   const CPUContext* Context() const override;
@@ -89,6 +116,17 @@ class ExceptionSnapshotWin final : public ExceptionSnapshot {
                                     CPUContext* context,
                                     CPUContextUnion* context_union));
 
+  // Implements Initialize() and InitializeFromThread(). exception_code is
+  // reported when exception_pointers is 0.
+  bool InitializeInternal(ProcessReaderWin* process_reader,
+                          DWORD thread_id,
+                          WinVMAddress exception_pointers,
+                          DWORD exception_code);
+
+  void InitializeFromThreadContext(const ProcessReaderWin::Thread& thread,
+                                   bool is_64_bit,
+                                   DWORD exception_code);
+
 #if defined(ARCH_CPU_X86_FAMILY)
   CPUContextUnion context_union_;
 #endif
@@ -112,6 +112,15 @@ class CrashingDelegate : public ExceptionHandlerServer::Delegate {
     return snapshot.Exception()->Exception();
   }
 
+  unsigned int ExceptionHandlerServerDumpAndCrash(
+      HANDLE process,
+      DWORD thread_id,
+      DWORD exception_code,
+      WinVMAddress debug_critical_section_address) override {
+    ADD_FAILURE() << "unexpected DumpAndCrashRequest";
+    return 0;
+  }
+
  private:
   HANDLE server_ready_;  // weak
   HANDLE completed_test_event_;  // weak
@@ -201,7 +210,8 @@ class SimulateDelegate : public ExceptionHandlerServer::Delegate {
                         exception_information_address,
                         debug_critical_section_address);
     EXPECT_TRUE(snapshot.Exception());
-    EXPECT_EQ(snapshot.Exception()->Exception(), 0x517a7ed);
+    EXPECT_EQ(snapshot.Exception()->Exception(),
+              CrashpadClient::kSimulatedExceptionCode);
 
     // Verify the dump was captured at the expected location with some slop
     // space.
@@ -219,6 +229,15 @@ class SimulateDelegate : public ExceptionHandlerServer::Delegate {
     return 0;
   }
 
+  unsigned int ExceptionHandlerServerDumpAndCrash(
+      HANDLE process,
+      DWORD thread_id,
+      DWORD exception_code,
+      WinVMAddress debug_critical_section_address) override {
+    ADD_FAILURE() << "unexpected DumpAndCrashRequest";
+    return 0;
+  }
+
  private:
   HANDLE server_ready_;  // weak
   HANDLE completed_test_event_;  // weak
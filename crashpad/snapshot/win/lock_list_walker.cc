@@ -0,0 +1,236 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/win/lock_list_walker.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "snapshot/win/process_reader_win.h"
+#include "util/win/process_structs.h"
+
+namespace crashpad {
+
+namespace {
+
+// The granularity at which the target process is read.
+constexpr WinVMSize kPageSize = 4096;
+
+// Neighboring ranges separated by no more than this many readable bytes are
+// joined in Ranges().
+constexpr WinVMSize kMaxCoalesceGap = 256;
+
+}  // namespace
+
+LockListWalker::LockListWalker(const ProcessReaderWin* process_reader,
+                               size_t max_locks)
+    : pages_(),
+      visited_(),
+      ranges_(),
+      process_reader_(process_reader),
+      max_locks_(max_locks),
+      lock_count_(0) {
+}
+
+LockListWalker::~LockListWalker() {
+}
+
+template <class Traits>
+bool LockListWalker::AddLock(WinVMAddress critical_section_address) {
+  if (lock_count_ >= max_locks_) {
+    return false;
+  }
+
+  process_types::RTL_CRITICAL_SECTION<Traits> critical_section;
+  if (!Read(critical_section_address,
+            sizeof(critical_section),
+            &critical_section)) {
+    return false;
+  }
+
+  ++lock_count_;
+  ranges_.push_back(CheckedRange<WinVMAddress, WinVMSize>(
+      critical_section_address, sizeof(critical_section)));
+
+  constexpr decltype(critical_section.DebugInfo) kInvalid =
+      static_cast<decltype(critical_section.DebugInfo)>(-1);
+  if (critical_section.DebugInfo != 0 &&
+      critical_section.DebugInfo != kInvalid &&
+      IsReadable(critical_section.DebugInfo,
+                 sizeof(process_types::RTL_CRITICAL_SECTION_DEBUG<Traits>))) {
+    ranges_.push_back(CheckedRange<WinVMAddress, WinVMSize>(
+        critical_section.DebugInfo,
+        sizeof(process_types::RTL_CRITICAL_SECTION_DEBUG<Traits>)));
+  }
+
+  return true;
+}
+
+template <class Traits>
+void LockListWalker::Walk(WinVMAddress critical_section_address) {
+  if (!AddLock<Traits>(critical_section_address)) {
+    return;
+  }
+
+  // This was just read by AddLock(), so it comes from the page cache.
+  process_types::RTL_CRITICAL_SECTION<Traits> critical_section;
+  Read(critical_section_address, sizeof(critical_section), &critical_section);
+
+  constexpr decltype(critical_section.DebugInfo) kInvalid =
+      static_cast<decltype(critical_section.DebugInfo)>(-1);
+  if (critical_section.DebugInfo == 0 ||
+      critical_section.DebugInfo == kInvalid) {
+    return;
+  }
+
+  using DebugType = process_types::RTL_CRITICAL_SECTION_DEBUG<Traits>;
+  constexpr WinVMSize kLinksOffset = offsetof(DebugType, ProcessLocksList);
+
+  DebugType debug;
+  if (!Read(critical_section.DebugInfo, sizeof(debug), &debug)) {
+    return;
+  }
+
+  // Walk the ProcessLocksList from this node until it returns to it. One of
+  // the nodes along the way is the list head, ntdll!RtlCriticalSectionList,
+  // which isn’t embedded in an RTL_CRITICAL_SECTION_DEBUG. It’s treated like
+  // the others, which captures the list head itself along with some of its
+  // neighbors. A debugger needs the list head to enumerate the locks.
+  const WinVMAddress start = critical_section.DebugInfo + kLinksOffset;
+  visited_.insert(start);
+  WinVMAddress current = debug.ProcessLocksList.Flink;
+  while (current != start && lock_count_ < max_locks_ &&
+         visited_.insert(current).second) {
+    const WinVMAddress debug_address = current - kLinksOffset;
+    if (!Read(debug_address, sizeof(debug), &debug)) {
+      return;
+    }
+
+    ++lock_count_;
+    ranges_.push_back(
+        CheckedRange<WinVMAddress, WinVMSize>(debug_address, sizeof(debug)));
+
+    const WinVMAddress lock_address = debug.CriticalSection;
+    if (lock_address != 0 &&
+        IsReadable(lock_address,
+                   sizeof(process_types::RTL_CRITICAL_SECTION<Traits>))) {
+      ranges_.push_back(CheckedRange<WinVMAddress, WinVMSize>(
+          lock_address, sizeof(process_types::RTL_CRITICAL_SECTION<Traits>)));
+    }
+
+    current = debug.ProcessLocksList.Flink;
+  }
+}
+
+std::vector<CheckedRange<WinVMAddress, WinVMSize>> LockListWalker::Ranges()
+    const {
+  std::vector<CheckedRange<WinVMAddress, WinVMSize>> sorted(ranges_);
+  std::sort(sorted.begin(),
+            sorted.end(),
+            [](const CheckedRange<WinVMAddress, WinVMSize>& a,
+               const CheckedRange<WinVMAddress, WinVMSize>& b) {
+              return a.base() < b.base();
+            });
+
+  std::vector<CheckedRange<WinVMAddress, WinVMSize>> result;
+  for (const auto& range : sorted) {
+    if (!result.empty()) {
+      CheckedRange<WinVMAddress, WinVMSize>& last = result.back();
+      const WinVMAddress last_end = last.end();
+      if (range.base() <= last_end ||
+          (range.base() - last_end <= kMaxCoalesceGap &&
+           IsReadable(last_end, range.base() - last_end))) {
+        last.SetRange(last.base(),
+                      std::max(last_end, range.end()) - last.base());
+        continue;
+      }
+    }
+    result.push_back(range);
+  }
+
+  return result;
+}
+
+bool LockListWalker::Read(WinVMAddress address, WinVMSize size, void* into) {
+  if (size == 0) {
+    return true;
+  }
+
+  const WinVMAddress end = address + size;
+  if (end < address) {
+    return false;
+  }
+
+  char* into_bytes = static_cast<char*>(into);
+  WinVMAddress current = address;
+  while (current < end) {
+    const WinVMAddress page_address = current - current % kPageSize;
+    const std::vector<uint8_t>& page = Page(page_address);
+    const WinVMSize offset = current - page_address;
+    const WinVMSize chunk = std::min(end - current, kPageSize - offset);
+    if (offset + chunk > page.size()) {
+      return false;
+    }
+    memcpy(into_bytes, &page[static_cast<size_t>(offset)],
+           static_cast<size_t>(chunk));
+    into_bytes += chunk;
+    current += chunk;
+  }
+
+  return true;
+}
+
+const std::vector<uint8_t>& LockListWalker::Page(WinVMAddress page_address) {
+  auto it = pages_.find(page_address);
+  if (it != pages_.end()) {
+    return it->second;
+  }
+
+  std::vector<uint8_t>& page = pages_[page_address];
+
+  // Consult the memory map first, so that unreadable pages are skipped without
+  // a failed read and logged message.
+  const auto readable = process_reader_->GetProcessInfo().GetReadableRanges(
+      CheckedRange<WinVMAddress, WinVMSize>(page_address, kPageSize));
+  if (readable.empty() || readable.front().base() != page_address) {
+    return page;
+  }
+
+  page.resize(static_cast<size_t>(readable.front().size()));
+  if (!process_reader_->ReadMemory(page_address, page.size(), page.data())) {
+    page.clear();
+  }
+  return page;
+}
+
+bool LockListWalker::IsReadable(WinVMAddress address, WinVMSize size) const {
+  const auto readable = process_reader_->GetProcessInfo().GetReadableRanges(
+      CheckedRange<WinVMAddress, WinVMSize>(address, size));
+  return readable.size() == 1 && readable.front().base() == address &&
+         readable.front().size() == size;
+}
+
+// Explicit instantiations with the only 2 valid template arguments to avoid
+// putting the body of the function in the header.
+template bool LockListWalker::AddLock<process_types::internal::Traits32>(
+    WinVMAddress critical_section_address);
+template bool LockListWalker::AddLock<process_types::internal::Traits64>(
+    WinVMAddress critical_section_address);
+template void LockListWalker::Walk<process_types::internal::Traits32>(
+    WinVMAddress critical_section_address);
+template void LockListWalker::Walk<process_types::internal::Traits64>(
+    WinVMAddress critical_section_address);
+
+}  // namespace crashpad
@@ -0,0 +1,111 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_WIN_LOCK_LIST_WALKER_H_
+#define CRASHPAD_SNAPSHOT_WIN_LOCK_LIST_WALKER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "base/macros.h"
+#include "util/numeric/checked_range.h"
+#include "util/win/address_types.h"
+
+namespace crashpad {
+
+class ProcessReaderWin;
+
+//! \brief Gathers the memory of critical sections in a remote process by
+//!     walking the list of `RTL_CRITICAL_SECTION_DEBUG` structures that links
+//!     them.
+//!
+//! A process may have many thousands of critical sections, and each list node
+//! is small, so reading them one at a time is slow. This class reads the
+//! target process in page-sized chunks and serves nodes from them, so that
+//! nodes allocated near one another take a single read. Every node address is
+//! visited at most once, so a corrupt list that loops back on itself ends the
+//! walk rather than repeating it, and the walk also stops once a fixed number
+//! of locks has been captured.
+//!
+//! The gathered memory is available from Ranges(), coalesced into as few
+//! ranges as possible.
+class LockListWalker {
+ public:
+  //! \param[in] process_reader A reader for the process whose locks will be
+  //!     walked.
+  //! \param[in] max_locks The maximum number of critical sections to capture,
+  //!     across all calls to Walk().
+  LockListWalker(const ProcessReaderWin* process_reader, size_t max_locks);
+  ~LockListWalker();
+
+  //! \brief Captures a critical section and, if it has valid debug
+  //!     information, the debug information itself.
+  //!
+  //! \param[in] critical_section_address The address of an
+  //!     `RTL_CRITICAL_SECTION` in the target process.
+  //!
+  //! \return `true` if the critical section was captured, `false` if it
+  //!     couldn’t be read or the budget was exhausted.
+  template <class Traits>
+  bool AddLock(WinVMAddress critical_section_address);
+
+  //! \brief Captures a critical section, then every critical section on the
+  //!     process’ lock list that it is linked into, until the list ends or the
+  //!     budget is exhausted.
+  //!
+  //! \param[in] critical_section_address The address of an
+  //!     `RTL_CRITICAL_SECTION` in the target process that has valid debug
+  //!     information.
+  template <class Traits>
+  void Walk(WinVMAddress critical_section_address);
+
+  //! \brief Returns the memory captured so far, sorted and coalesced.
+  //!
+  //! Neighboring ranges are joined when the gap between them is small and
+  //! readable.
+  std::vector<CheckedRange<WinVMAddress, WinVMSize>> Ranges() const;
+
+  //! \brief Returns the number of critical sections captured so far.
+  size_t LockCount() const { return lock_count_; }
+
+ private:
+  // Reads |size| bytes at |address| in the target process into |into| from
+  // cached pages, reading each page that’s not yet cached. Returns false
+  // without logging if any byte is unreadable.
+  bool Read(WinVMAddress address, WinVMSize size, void* into);
+
+  // Returns the cached contents of the page at |page_address|, reading it if
+  // necessary. The contents are truncated at the first unreadable byte.
+  const std::vector<uint8_t>& Page(WinVMAddress page_address);
+
+  // Returns true if all |size| bytes at |address| are readable.
+  bool IsReadable(WinVMAddress address, WinVMSize size) const;
+
+  std::unordered_map<WinVMAddress, std::vector<uint8_t>> pages_;
+  std::unordered_set<WinVMAddress> visited_;
+  std::vector<CheckedRange<WinVMAddress, WinVMSize>> ranges_;
+  const ProcessReaderWin* process_reader_;  // weak
+  size_t max_locks_;
+  size_t lock_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockListWalker);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_WIN_LOCK_LIST_WALKER_H_
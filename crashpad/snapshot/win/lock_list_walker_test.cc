@@ -0,0 +1,144 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/win/lock_list_walker.h"
+
+#include <windows.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "gtest/gtest.h"
+#include "snapshot/win/process_reader_win.h"
+#include "util/misc/from_pointer_cast.h"
+#include "util/win/critical_section_with_debug_info.h"
+#include "util/win/process_structs.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+#if defined(ARCH_CPU_64_BITS)
+using Traits = process_types::internal::Traits64;
+#else
+using Traits = process_types::internal::Traits32;
+#endif
+
+// Returns true if |ranges| contains all |size| bytes at |address|.
+bool RangesContain(
+    const std::vector<CheckedRange<WinVMAddress, WinVMSize>>& ranges,
+    const void* address,
+    size_t size) {
+  const CheckedRange<WinVMAddress, WinVMSize> range(
+      FromPointerCast<WinVMAddress>(address), size);
+  for (const auto& candidate : ranges) {
+    if (candidate.ContainsRange(range)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HasDebugInfo(const CRITICAL_SECTION& critical_section) {
+  return critical_section.DebugInfo &&
+         critical_section.DebugInfo !=
+             reinterpret_cast<PRTL_CRITICAL_SECTION_DEBUG>(-1);
+}
+
+class ScopedCriticalSections {
+ public:
+  ScopedCriticalSections() {
+    for (CRITICAL_SECTION& critical_section : critical_sections_) {
+      EXPECT_TRUE(
+          InitializeCriticalSectionWithDebugInfoIfPossible(&critical_section));
+    }
+  }
+
+  ~ScopedCriticalSections() {
+    for (CRITICAL_SECTION& critical_section : critical_sections_) {
+      DeleteCriticalSection(&critical_section);
+    }
+  }
+
+  CRITICAL_SECTION* get() { return critical_sections_; }
+  size_t size() const { return arraysize(critical_sections_); }
+
+ private:
+  CRITICAL_SECTION critical_sections_[4];
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedCriticalSections);
+};
+
+TEST(LockListWalker, SelfWalk) {
+  ScopedCriticalSections critical_sections;
+
+  ProcessReaderWin process_reader;
+  ASSERT_TRUE(process_reader.Initialize(GetCurrentProcess(),
+                                        ProcessSuspensionState::kRunning));
+
+  LockListWalker walker(&process_reader, 100000);
+  walker.Walk<Traits>(
+      FromPointerCast<WinVMAddress>(&critical_sections.get()[0]));
+  const auto ranges = walker.Ranges();
+
+  EXPECT_TRUE(RangesContain(
+      ranges, &critical_sections.get()[0], sizeof(CRITICAL_SECTION)));
+
+  if (!HasDebugInfo(critical_sections.get()[0])) {
+    // Critical sections can’t be allocated with .DebugInfo on some versions of
+    // Windows, so there is no list to walk.
+    EXPECT_EQ(walker.LockCount(), 1u);
+    return;
+  }
+
+  EXPECT_GE(walker.LockCount(), critical_sections.size());
+  for (size_t index = 0; index < critical_sections.size(); ++index) {
+    const CRITICAL_SECTION& critical_section = critical_sections.get()[index];
+    EXPECT_TRUE(
+        RangesContain(ranges, &critical_section, sizeof(critical_section)));
+    EXPECT_TRUE(RangesContain(ranges,
+                              critical_section.DebugInfo,
+                              sizeof(*critical_section.DebugInfo)));
+  }
+
+  // The ranges are sorted and don’t overlap.
+  for (size_t index = 1; index < ranges.size(); ++index) {
+    EXPECT_GT(ranges[index].base(), ranges[index - 1].end());
+  }
+}
+
+TEST(LockListWalker, Budget) {
+  ScopedCriticalSections critical_sections;
+  if (!HasDebugInfo(critical_sections.get()[0])) {
+    return;
+  }
+
+  ProcessReaderWin process_reader;
+  ASSERT_TRUE(process_reader.Initialize(GetCurrentProcess(),
+                                        ProcessSuspensionState::kRunning));
+
+  LockListWalker walker(&process_reader, 2);
+  walker.Walk<Traits>(
+      FromPointerCast<WinVMAddress>(&critical_sections.get()[0]));
+  EXPECT_EQ(walker.LockCount(), 2u);
+
+  // The budget is shared across calls.
+  EXPECT_FALSE(walker.AddLock<Traits>(
+      FromPointerCast<WinVMAddress>(&critical_sections.get()[1])));
+  EXPECT_EQ(walker.LockCount(), 2u);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -12,11 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
+
 #include <memory>
 
+#include "base/logging.h"
 #include "snapshot/win/memory_snapshot_win.h"
 
-
 namespace crashpad {
 namespace internal {
 
@@ -25,6 +27,8 @@ MemorySnapshotWin::MemorySnapshotWin()
       process_reader_(nullptr),
       address_(0),
       size_(0),
+      contents_(),
+      contents_state_(),
       initialized_() {
 }
 
@@ -60,11 +64,103 @@ bool MemorySnapshotWin::Read(Delegate* delegate) const {
     return delegate->MemorySnapshotDelegateRead(nullptr, size_);
   }
 
-  std::unique_ptr<uint8_t[]> buffer(new uint8_t[size_]);
-  if (!process_reader_->ReadMemory(address_, size_, buffer.get())) {
+  if (!contents_state_.is_uninitialized()) {
+    return contents_state_.is_valid() &&
+           delegate->MemorySnapshotDelegateRead(contents_.get(), size_);
+  }
+
+  // Read directly into the delegate’s storage when it offers some, avoiding
+  // an intermediate allocation and copy.
+  void* buffer = delegate->MemorySnapshotDelegateBuffer(size_);
+  std::unique_ptr<uint8_t[]> owned_buffer;
+  if (!buffer) {
+    owned_buffer.reset(new uint8_t[size_]);
+    buffer = owned_buffer.get();
+  }
+
+  if (!process_reader_->ReadMemory(address_, size_, buffer)) {
+    return false;
+  }
+  return delegate->MemorySnapshotDelegateRead(buffer, size_);
+}
+
+bool MemorySnapshotWin::Materialize() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  if (!contents_state_.is_uninitialized()) {
+    return contents_state_.is_valid();
+  }
+
+  contents_state_.set_invalid();
+  if (size_ == 0) {
+    contents_state_.set_valid();
+    return true;
+  }
+
+  contents_.reset(new uint8_t[size_]);
+  if (!process_reader_->ReadMemory(address_, size_, contents_.get())) {
+    contents_.reset();
     return false;
   }
-  return delegate->MemorySnapshotDelegateRead(buffer.get(), size_);
+
+  contents_state_.set_valid();
+  return true;
+}
+
+const MemorySnapshot* MemorySnapshotWin::MergeWithOtherSnapshot(
+    const MemorySnapshot* other) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // All memory snapshots merged together come from the same process snapshot,
+  // and are therefore of this concrete type.
+  const MemorySnapshotWin* other_as_win =
+      reinterpret_cast<const MemorySnapshotWin*>(other);
+  if (process_reader_ != other_as_win->process_reader_) {
+    LOG(ERROR) << "different process_reader_ for snapshots";
+    return nullptr;
+  }
+
+  CheckedRange<uint64_t, size_t> merged(0, 0);
+  if (!DetermineMergedRange(this, other, &merged)) {
+    return nullptr;
+  }
+
+  std::unique_ptr<MemorySnapshotWin> result(new MemorySnapshotWin());
+  result->Initialize(process_reader_, merged.base(), merged.size());
+
+  if (contents_state_.is_uninitialized() &&
+      other_as_win->contents_state_.is_uninitialized()) {
+    return result.release();
+  }
+
+  // Once materialized, the process may have been resumed, so the merged
+  // contents must come from the snapshots being merged rather than the
+  // process. Merged snapshots overlap or abut, so together they cover the
+  // merged range.
+  if (!contents_state_.is_valid() ||
+      !other_as_win->contents_state_.is_valid()) {
+    LOG(ERROR) << "merging snapshots that are not both materialized";
+    return nullptr;
+  }
+  if (address_ > other_as_win->address_ + other_as_win->size_ ||
+      other_as_win->address_ > address_ + size_) {
+    LOG(ERROR) << "merging materialized snapshots that don’t overlap";
+    return nullptr;
+  }
+
+  result->contents_.reset(new uint8_t[merged.size()]);
+  if (size_) {
+    memcpy(&result->contents_[address_ - merged.base()],
+           contents_.get(),
+           size_);
+  }
+  if (other_as_win->size_) {
+    memcpy(&result->contents_[other_as_win->address_ - merged.base()],
+           other_as_win->contents_.get(),
+           other_as_win->size_);
+  }
+  result->contents_state_.set_valid();
+  return result.release();
 }
 
 }  // namespace internal
@@ -18,9 +18,12 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <memory>
+
 #include "base/macros.h"
 #include "snapshot/memory_snapshot.h"
 #include "snapshot/win/process_reader_win.h"
+#include "util/misc/initialization_state.h"
 #include "util/misc/initialization_state_dcheck.h"
 
 namespace crashpad {
@@ -37,7 +40,7 @@ class MemorySnapshotWin final : public MemorySnapshot {
   //!
   //! Memory is read lazily. No attempt is made to read the memory snapshot data
   //! until Read() is called, and the memory snapshot data is discared when
-  //! Read() returns.
+  //! Read() returns, unless Materialize() is called.
   //!
   //! \param[in] process_reader A reader for the process being snapshotted.
   //! \param[in] address The base address of the memory region to snapshot, in
@@ -47,16 +50,31 @@ class MemorySnapshotWin final : public MemorySnapshot {
                   uint64_t address,
                   uint64_t size);
 
+  //! \brief Reads the memory snapshot data now, and keeps it.
+  //!
+  //! After this is called, Read() provides the data read here instead of
+  //! reading from the process, so the snapshot remains consistent even after
+  //! the process is resumed. If the data can’t be read here, Read() will fail.
+  //! Snapshots produced by MergeWithOtherSnapshot() from materialized
+  //! snapshots are materialized too.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool Materialize();
+
   // MemorySnapshot:
 
   uint64_t Address() const override;
   size_t Size() const override;
   bool Read(Delegate* delegate) const override;
+  const MemorySnapshot* MergeWithOtherSnapshot(
+      const MemorySnapshot* other) const override;
 
  private:
   ProcessReaderWin* process_reader_;  // weak
   uint64_t address_;
   size_t size_;
+  std::unique_ptr<uint8_t[]> contents_;
+  InitializationState contents_state_;
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(MemorySnapshotWin);
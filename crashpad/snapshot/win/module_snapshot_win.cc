@@ -14,21 +14,87 @@
 
 #include "snapshot/win/module_snapshot_win.h"
 
+#include <map>
+#include <tuple>
+#include <utility>
+
 #include "base/strings/utf_string_conversions.h"
+#include "base/synchronization/lock.h"
 #include "client/crashpad_info.h"
 #include "client/simple_address_range_bag.h"
+#include "snapshot/ring_buffer_snapshot.h"
 #include "snapshot/win/memory_snapshot_win.h"
 #include "snapshot/win/pe_image_annotations_reader.h"
 #include "snapshot/win/pe_image_reader.h"
+#include "util/misc/memory_read_trace.h"
 #include "util/misc/tri_state.h"
 #include "util/misc/uuid.h"
+#include "util/string/utf_conversion.h"
 
 namespace crashpad {
 namespace internal {
 
+namespace {
+
+// Remembers the VS_FIXEDFILEINFO of modules whose version resources have been
+// read, for the life of the process. A module is identified by its path, its
+// timestamp, and its size, so that a rebuilt module at the same path isn’t
+// mistaken for a cached one. This allows a long-lived handler to avoid
+// re-parsing the resources of system modules, which are loaded by most clients
+// and seldom change, in every dump it takes. Only successful reads are cached,
+// because failures may be specific to one process.
+class VSFixedFileInfoCache {
+ public:
+  using Key = std::tuple<std::wstring, time_t, uint64_t>;
+
+  static VSFixedFileInfoCache* Get() {
+    static VSFixedFileInfoCache* instance = new VSFixedFileInfoCache();
+    return instance;
+  }
+
+  bool Lookup(const Key& key, VS_FIXEDFILEINFO* vs_fixed_file_info) {
+    base::AutoLock lock_owner(lock_);
+    const auto it = cache_.find(key);
+    if (it == cache_.end()) {
+      return false;
+    }
+    *vs_fixed_file_info = it->second;
+    return true;
+  }
+
+  void Insert(const Key& key, const VS_FIXEDFILEINFO& vs_fixed_file_info) {
+    base::AutoLock lock_owner(lock_);
+    if (cache_.size() < kMaxEntries) {
+      cache_.insert(std::make_pair(key, vs_fixed_file_info));
+    }
+  }
+
+ private:
+  // Bounds the cache’s memory use in a handler that sees many distinct
+  // modules. Once full, further modules are simply not cached.
+  static constexpr size_t kMaxEntries = 4096;
+
+  VSFixedFileInfoCache() : cache_(), lock_() {}
+  ~VSFixedFileInfoCache() = delete;
+
+  // Access to these fields must be guarded by lock_.
+  std::map<Key, VS_FIXEDFILEINFO> cache_;
+
+  base::Lock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(VSFixedFileInfoCache);
+};
+
+// The most that will be captured from a single ring buffer. A descriptor
+// corrupted by the crash could otherwise claim an arbitrarily large buffer.
+constexpr uint64_t kMaxRingBufferStreamSize = 16 * 1024 * 1024;
+
+}  // namespace
+
 ModuleSnapshotWin::ModuleSnapshotWin()
     : ModuleSnapshot(),
       name_(),
+      name_utf8_(),
       pdb_name_(),
       uuid_(),
       pe_image_reader_(),
@@ -50,12 +116,13 @@ bool ModuleSnapshotWin::Initialize(
 
   process_reader_ = process_reader;
   name_ = process_reader_module.name;
+  TranscodeUTF16ToUTF8(name_.data(), name_.size(), &name_utf8_);
   timestamp_ = process_reader_module.timestamp;
   pe_image_reader_.reset(new PEImageReader());
   if (!pe_image_reader_->Initialize(process_reader_,
                                     process_reader_module.dll_base,
                                     process_reader_module.size,
-                                    base::UTF16ToUTF8(name_))) {
+                                    name_utf8_)) {
     return false;
   }
 
@@ -71,13 +138,18 @@ bool ModuleSnapshotWin::Initialize(
     // be using .PDB that we actually have symbols for, we simply set a
     // plausible name here, but this will never correspond to symbols that we
     // have.
-    pdb_name_ = base::UTF16ToUTF8(name_);
+    pdb_name_ = name_utf8_;
   }
 
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
 
+void ModuleSnapshotWin::SetCrashpadInfoData(std::vector<char> data) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  pe_image_reader_->SetCrashpadInfoData(std::move(data));
+}
+
 void ModuleSnapshotWin::GetCrashpadOptions(CrashpadInfoClientOptions* options) {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   if (process_reader_->Is64Bit())
@@ -88,7 +160,7 @@ void ModuleSnapshotWin::GetCrashpadOptions(CrashpadInfoClientOptions* options) {
 
 std::string ModuleSnapshotWin::Name() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  return base::UTF16ToUTF8(name_);
+  return name_utf8_;
 }
 
 uint64_t ModuleSnapshotWin::Address() const {
@@ -183,11 +255,29 @@ std::vector<std::string> ModuleSnapshotWin::AnnotationsVector() const {
 std::map<std::string, std::string> ModuleSnapshotWin::AnnotationsSimpleMap()
     const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  ScopedMemoryReadSite read_site(MemoryReadSite::kAnnotations);
   PEImageAnnotationsReader annotations_reader(
       process_reader_, pe_image_reader_.get(), name_);
   return annotations_reader.SimpleMap();
 }
 
+std::vector<AnnotationSnapshot> ModuleSnapshotWin::AnnotationObjects() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  ScopedMemoryReadSite read_site(MemoryReadSite::kAnnotations);
+  PEImageAnnotationsReader annotations_reader(
+      process_reader_, pe_image_reader_.get(), name_);
+  return annotations_reader.AnnotationsList();
+}
+
+std::map<uint64_t, std::vector<AnnotationSnapshot>>
+ModuleSnapshotWin::ThreadAnnotationObjects() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  ScopedMemoryReadSite read_site(MemoryReadSite::kAnnotations);
+  PEImageAnnotationsReader annotations_reader(
+      process_reader_, pe_image_reader_.get(), name_);
+  return annotations_reader.ThreadAnnotationsList();
+}
+
 std::set<CheckedRange<uint64_t>> ModuleSnapshotWin::ExtraMemoryRanges() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   std::set<CheckedRange<uint64_t>> ranges;
@@ -198,6 +288,19 @@ std::set<CheckedRange<uint64_t>> ModuleSnapshotWin::ExtraMemoryRanges() const {
   return ranges;
 }
 
+std::set<CheckedRange<uint64_t>> ModuleSnapshotWin::ExcludedMemoryRanges()
+    const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  std::set<CheckedRange<uint64_t>> ranges;
+  if (process_reader_->Is64Bit())
+    GetCrashpadExcludedMemoryRanges<process_types::internal::Traits64>(
+        &ranges);
+  else
+    GetCrashpadExcludedMemoryRanges<process_types::internal::Traits32>(
+        &ranges);
+  return ranges;
+}
+
 std::vector<const UserMinidumpStream*>
 ModuleSnapshotWin::CustomMinidumpStreams() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
@@ -205,9 +308,13 @@ ModuleSnapshotWin::CustomMinidumpStreams() const {
   if (process_reader_->Is64Bit()) {
     GetCrashpadUserMinidumpStreams<process_types::internal::Traits64>(
         &streams_);
+    GetCrashpadRingBufferMinidumpStreams<process_types::internal::Traits64>(
+        &streams_);
   } else {
     GetCrashpadUserMinidumpStreams<process_types::internal::Traits32>(
         &streams_);
+    GetCrashpadRingBufferMinidumpStreams<process_types::internal::Traits32>(
+        &streams_);
   }
 
   std::vector<const UserMinidumpStream*> result;
@@ -225,6 +332,7 @@ void ModuleSnapshotWin::GetCrashpadOptionsInternal(
     options->system_crash_reporter_forwarding = TriState::kUnset;
     options->gather_indirectly_referenced_memory = TriState::kUnset;
     options->indirectly_referenced_memory_cap = 0;
+    options->capture_deadline_ms = 0;
     return;
   }
 
@@ -242,6 +350,8 @@ void ModuleSnapshotWin::GetCrashpadOptionsInternal(
 
   options->indirectly_referenced_memory_cap =
       crashpad_info.indirectly_referenced_memory_cap;
+
+  options->capture_deadline_ms = crashpad_info.capture_deadline_ms;
 }
 
 const VS_FIXEDFILEINFO* ModuleSnapshotWin::VSFixedFileInfo() const {
@@ -249,7 +359,17 @@ const VS_FIXEDFILEINFO* ModuleSnapshotWin::VSFixedFileInfo() const {
 
   if (initialized_vs_fixed_file_info_.is_uninitialized()) {
     initialized_vs_fixed_file_info_.set_invalid();
-    if (pe_image_reader_->VSFixedFileInfo(&vs_fixed_file_info_)) {
+
+    // Parsing the resource directory takes many reads from the target process,
+    // so it’s deferred until the version is needed, and shared with other
+    // snapshots of the same module.
+    VSFixedFileInfoCache* cache = VSFixedFileInfoCache::Get();
+    const VSFixedFileInfoCache::Key key(
+        name_, timestamp_, pe_image_reader_->Size());
+    if (cache->Lookup(key, &vs_fixed_file_info_)) {
+      initialized_vs_fixed_file_info_.set_valid();
+    } else if (pe_image_reader_->VSFixedFileInfo(&vs_fixed_file_info_)) {
+      cache->Insert(key, vs_fixed_file_info_);
       initialized_vs_fixed_file_info_.set_valid();
     }
   }
@@ -268,10 +388,50 @@ void ModuleSnapshotWin::GetCrashpadExtraMemoryRanges(
   if (!crashpad_info.extra_address_ranges)
     return;
 
-  std::vector<SimpleAddressRangeBag::Entry> simple_ranges(
-      SimpleAddressRangeBag::num_entries);
+  // Modules that predate configurable capacities leave the count as 0.
+  size_t num_entries = crashpad_info.extra_address_ranges_count;
+  if (num_entries == 0) {
+    num_entries = SimpleAddressRangeBag::num_entries;
+  } else if (num_entries > kSimpleAddressRangeBagMaxEntries) {
+    LOG(WARNING) << "extra address range count " << num_entries
+                 << " too large in " << base::UTF16ToUTF8(name_);
+    return;
+  }
+
+  ReadAddressRangeBag(crashpad_info.extra_address_ranges, num_entries, ranges);
+}
+
+template <class Traits>
+void ModuleSnapshotWin::GetCrashpadExcludedMemoryRanges(
+    std::set<CheckedRange<uint64_t>>* ranges) const {
+  process_types::CrashpadInfo<Traits> crashpad_info;
+  if (!pe_image_reader_->GetCrashpadInfo(&crashpad_info))
+    return;
+
+  if (!crashpad_info.excluded_address_ranges)
+    return;
+
+  // Unlike the extra address ranges, these were never written with a count of
+  // 0, so it is always the bag’s capacity.
+  const size_t num_entries = crashpad_info.excluded_address_ranges_count;
+  if (num_entries == 0 || num_entries > kSimpleAddressRangeBagMaxEntries) {
+    LOG(WARNING) << "excluded address range count " << num_entries
+                 << " invalid in " << base::UTF16ToUTF8(name_);
+    return;
+  }
+
+  ReadAddressRangeBag(
+      crashpad_info.excluded_address_ranges, num_entries, ranges);
+}
+
+void ModuleSnapshotWin::ReadAddressRangeBag(
+    WinVMAddress address,
+    size_t num_entries,
+    std::set<CheckedRange<uint64_t>>* ranges) const {
+  // The entries are at the start of the bag, so they can be read at once.
+  std::vector<SimpleAddressRangeBag::Entry> simple_ranges(num_entries);
   if (!process_reader_->ReadMemory(
-          crashpad_info.extra_address_ranges,
+          address,
           simple_ranges.size() * sizeof(simple_ranges[0]),
           &simple_ranges[0])) {
     LOG(WARNING) << "could not read simple address_ranges from "
@@ -308,6 +468,11 @@ void ModuleSnapshotWin::GetCrashpadUserMinidumpStreams(
           new internal::MemorySnapshotWin());
       memory->Initialize(
           process_reader_, list_entry.base_address, list_entry.size);
+
+      // Streams are gathered from the snapshot before it’s written, and the
+      // process may be resumed in between. See
+      // ProcessSnapshotWin::MaterializeMemory().
+      memory->Materialize();
       streams->push_back(
           new UserMinidumpStream(list_entry.stream_type, memory.release()));
     }
@@ -316,5 +481,58 @@ void ModuleSnapshotWin::GetCrashpadUserMinidumpStreams(
   }
 }
 
+template <class Traits>
+void ModuleSnapshotWin::GetCrashpadRingBufferMinidumpStreams(
+    PointerVector<const UserMinidumpStream>* streams) const {
+  process_types::CrashpadInfo<Traits> crashpad_info;
+  if (!pe_image_reader_->GetCrashpadInfo(&crashpad_info))
+    return;
+
+  for (uint64_t cur = crashpad_info.ring_buffer_minidump_stream_head; cur;) {
+    internal::RingBufferMinidumpStreamListEntry list_entry;
+    if (!process_reader_->ReadMemory(cur, sizeof(list_entry), &list_entry)) {
+      LOG(WARNING) << "could not read ring buffer stream entry from "
+                   << base::UTF16ToUTF8(name_);
+      return;
+    }
+    cur = list_entry.next;
+
+    // Only the fixed-size descriptor and the live portion of the buffer that
+    // it describes are read.
+    RingBufferDescriptor descriptor;
+    if (!process_reader_->ReadMemory(list_entry.descriptor_address,
+                                     sizeof(descriptor),
+                                     &descriptor)) {
+      LOG(WARNING) << "could not read ring buffer descriptor from "
+                   << base::UTF16ToUTF8(name_);
+      continue;
+    }
+
+    std::vector<CheckedRange<uint64_t>> ranges;
+    if (!GetRingBufferLiveRanges(
+            descriptor, kMaxRingBufferStreamSize, &ranges) ||
+        ranges.empty()) {
+      continue;
+    }
+
+    std::vector<std::unique_ptr<const MemorySnapshot>> segments;
+    for (const auto& range : ranges) {
+      std::unique_ptr<internal::MemorySnapshotWin> segment(
+          new internal::MemorySnapshotWin());
+      segment->Initialize(process_reader_, range.base(), range.size());
+
+      // As with user data streams, the process may be resumed before the
+      // stream is written, and the buffer would then have moved on.
+      segment->Materialize();
+      segments.push_back(std::move(segment));
+    }
+
+    std::unique_ptr<RingBufferSnapshot> memory(new RingBufferSnapshot());
+    memory->Initialize(std::move(segments));
+    streams->push_back(
+        new UserMinidumpStream(list_entry.stream_type, memory.release()));
+  }
+}
+
 }  // namespace internal
 }  // namespace crashpad
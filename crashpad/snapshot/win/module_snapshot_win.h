@@ -67,6 +67,12 @@ class ModuleSnapshotWin final : public ModuleSnapshot {
   //!     after Initialize() is called.
   const PEImageReader& pe_image_reader() const { return *pe_image_reader_; }
 
+  //! \brief Supplies the contents of the module's `CPADinfo` section, so that
+  //!     its CrashpadInfo structure need not be read again.
+  //!
+  //! \sa PEImageReader::SetCrashpadInfoData()
+  void SetCrashpadInfoData(std::vector<char> data);
+
   // ModuleSnapshot:
 
   std::string Name() const override;
@@ -86,9 +92,16 @@ class ModuleSnapshotWin final : public ModuleSnapshot {
   std::string DebugFileName() const override;
   std::vector<std::string> AnnotationsVector() const override;
   std::map<std::string, std::string> AnnotationsSimpleMap() const override;
+  std::vector<AnnotationSnapshot> AnnotationObjects() const override;
+  std::map<uint64_t, std::vector<AnnotationSnapshot>> ThreadAnnotationObjects()
+      const override;
   std::set<CheckedRange<uint64_t>> ExtraMemoryRanges() const override;
   std::vector<const UserMinidumpStream*> CustomMinidumpStreams() const override;
 
+  //! \brief Returns the ranges that the module’s CrashpadInfo excludes from
+  //!     the indirectly referenced memory of a snapshot.
+  std::set<CheckedRange<uint64_t>> ExcludedMemoryRanges() const;
+
  private:
   template <class Traits>
   void GetCrashpadOptionsInternal(CrashpadInfoClientOptions* options);
@@ -97,16 +110,34 @@ class ModuleSnapshotWin final : public ModuleSnapshot {
   void GetCrashpadExtraMemoryRanges(
       std::set<CheckedRange<uint64_t>>* ranges) const;
 
+  template <class Traits>
+  void GetCrashpadExcludedMemoryRanges(
+      std::set<CheckedRange<uint64_t>>* ranges) const;
+
+  // Reads the entries of the TSimpleAddressRangeBag with capacity num_entries
+  // at address, and adds those in use to ranges.
+  void ReadAddressRangeBag(WinVMAddress address,
+                           size_t num_entries,
+                           std::set<CheckedRange<uint64_t>>* ranges) const;
+
   template <class Traits>
   void GetCrashpadUserMinidumpStreams(
       PointerVector<const UserMinidumpStream>* streams) const;
 
+  template <class Traits>
+  void GetCrashpadRingBufferMinidumpStreams(
+      PointerVector<const UserMinidumpStream>* streams) const;
+
   // Initializes vs_fixed_file_info_ if it has not yet been initialized, and
   // returns a pointer to it. Returns nullptr on failure, with a message logged
-  // on the first call.
+  // on the first call. The result is shared with other snapshots of a module
+  // with the same path, timestamp, and size, even across dumps.
   const VS_FIXEDFILEINFO* VSFixedFileInfo() const;
 
   std::wstring name_;
+
+  // name_ in UTF-8, converted once for Name() and the PE image reader.
+  std::string name_utf8_;
   std::string pdb_name_;
   UUID uuid_;
   std::unique_ptr<PEImageReader> pe_image_reader_;
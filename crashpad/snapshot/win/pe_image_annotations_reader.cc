@@ -17,7 +17,10 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include <utility>
+
 #include "base/strings/utf_string_conversions.h"
+#include "client/annotation.h"
 #include "client/simple_string_dictionary.h"
 #include "snapshot/win/pe_image_reader.h"
 #include "snapshot/win/process_reader_win.h"
@@ -46,6 +49,32 @@ std::map<std::string, std::string> PEImageAnnotationsReader::SimpleMap() const {
   return simple_map_annotations;
 }
 
+std::vector<AnnotationSnapshot> PEImageAnnotationsReader::AnnotationsList()
+    const {
+  std::vector<AnnotationSnapshot> annotations;
+  if (process_reader_->Is64Bit()) {
+    ReadCrashpadAnnotationsList<process_types::internal::Traits64>(
+        &annotations);
+  } else {
+    ReadCrashpadAnnotationsList<process_types::internal::Traits32>(
+        &annotations);
+  }
+  return annotations;
+}
+
+std::map<uint64_t, std::vector<AnnotationSnapshot>>
+PEImageAnnotationsReader::ThreadAnnotationsList() const {
+  std::map<uint64_t, std::vector<AnnotationSnapshot>> thread_annotations;
+  if (process_reader_->Is64Bit()) {
+    ReadCrashpadThreadAnnotations<process_types::internal::Traits64>(
+        &thread_annotations);
+  } else {
+    ReadCrashpadThreadAnnotations<process_types::internal::Traits32>(
+        &thread_annotations);
+  }
+  return thread_annotations;
+}
+
 template <class Traits>
 void PEImageAnnotationsReader::ReadCrashpadSimpleAnnotations(
     std::map<std::string, std::string>* simple_map_annotations) const {
@@ -80,4 +109,146 @@ void PEImageAnnotationsReader::ReadCrashpadSimpleAnnotations(
   }
 }
 
+template <class Traits>
+void PEImageAnnotationsReader::ReadCrashpadAnnotationsList(
+    std::vector<AnnotationSnapshot>* annotations) const {
+  process_types::CrashpadInfo<Traits> crashpad_info;
+  if (!pe_image_reader_->GetCrashpadInfo(&crashpad_info))
+    return;
+
+  if (!crashpad_info.annotations_list)
+    return;
+
+  process_types::AnnotationList<Traits> annotation_list;
+  if (!process_reader_->ReadMemory(crashpad_info.annotations_list,
+                                   sizeof(annotation_list),
+                                   &annotation_list)) {
+    LOG(WARNING) << "could not read annotations list from "
+                 << base::UTF16ToUTF8(name_);
+    return;
+  }
+
+  ReadAnnotationsFromHead<Traits>(annotation_list.head, annotations);
+}
+
+template <class Traits>
+void PEImageAnnotationsReader::ReadCrashpadThreadAnnotations(
+    std::map<uint64_t, std::vector<AnnotationSnapshot>>* thread_annotations)
+    const {
+  process_types::CrashpadInfo<Traits> crashpad_info;
+  if (!pe_image_reader_->GetCrashpadInfo(&crashpad_info))
+    return;
+
+  if (!crashpad_info.thread_annotations)
+    return;
+
+  process_types::ThreadAnnotationRegistry<Traits> registry;
+  if (!process_reader_->ReadMemory(crashpad_info.thread_annotations,
+                                   sizeof(registry),
+                                   &registry)) {
+    LOG(WARNING) << "could not read thread annotations from "
+                 << base::UTF16ToUTF8(name_);
+    return;
+  }
+
+  // Bound the walk, in case the registry has been corrupted into a cycle.
+  constexpr size_t kMaxSlots = 1024;
+  WinVMAddress node = registry.head;
+  for (size_t index = 0; node && index < kMaxSlots; ++index) {
+    process_types::ThreadAnnotationSlot<Traits> slot;
+    if (!process_reader_->ReadMemory(node, sizeof(slot), &slot)) {
+      LOG(WARNING) << "could not read thread annotation slot from "
+                   << base::UTF16ToUTF8(name_);
+      return;
+    }
+    node = slot.link_node;
+
+    // Unowned slots have been released by the threads that used them.
+    if (slot.thread_id == 0 || !slot.annotations_head)
+      continue;
+
+    std::vector<AnnotationSnapshot> annotations;
+    ReadAnnotationsFromHead<Traits>(slot.annotations_head, &annotations);
+    if (!annotations.empty())
+      (*thread_annotations)[slot.thread_id] = std::move(annotations);
+  }
+}
+
+template <class Traits>
+void PEImageAnnotationsReader::ReadAnnotationsFromHead(
+    WinVMAddress head,
+    std::vector<AnnotationSnapshot>* annotations) const {
+  // Walk the list, reading only each annotation's header. Bound the walk, in
+  // case the list has been corrupted into a cycle.
+  constexpr size_t kMaxAnnotations = 200;
+  std::vector<process_types::Annotation<Traits>> headers;
+  WinVMAddress node = head;
+  while (node && headers.size() < kMaxAnnotations) {
+    process_types::Annotation<Traits> header;
+    if (!process_reader_->ReadMemory(node, sizeof(header), &header)) {
+      LOG(WARNING) << "could not read annotation from "
+                   << base::UTF16ToUTF8(name_);
+      break;
+    }
+    node = header.link_node;
+
+    if (header.size == 0) {
+      continue;
+    }
+    if (header.size > Annotation::kValueMaxSize) {
+      LOG(WARNING) << "annotation size " << header.size << " too large in "
+                   << base::UTF16ToUTF8(name_);
+      continue;
+    }
+    headers.push_back(header);
+  }
+
+  // Then read all of the names and values together, so that those stored near
+  // one another are read at once.
+  const size_t first = annotations->size();
+  std::vector<std::vector<char>> names(headers.size());
+  annotations->resize(first + headers.size());
+  std::vector<ProcessReaderWin::MemoryRead> reads;
+  reads.reserve(headers.size() * 2);
+  for (size_t index = 0; index < headers.size(); ++index) {
+    names[index].resize(Annotation::kNameMaxLength + 1);
+    (*annotations)[first + index].value.resize(headers[index].size);
+
+    ProcessReaderWin::MemoryRead read;
+    read.address = headers[index].name;
+    read.size = names[index].size();
+    read.into = &names[index][0];
+    read.bytes_read = 0;
+    reads.push_back(read);
+
+    read.address = headers[index].value;
+    read.size = headers[index].size;
+    read.into = &(*annotations)[first + index].value[0];
+    reads.push_back(read);
+  }
+  process_reader_->ReadAvailableMemoryBatch(&reads);
+
+  size_t valid = first;
+  for (size_t index = 0; index < headers.size(); ++index) {
+    const ProcessReaderWin::MemoryRead& name_read = reads[index * 2];
+    const ProcessReaderWin::MemoryRead& value_read = reads[index * 2 + 1];
+    const size_t name_length =
+        strnlen(&names[index][0], static_cast<size_t>(name_read.bytes_read));
+    if (name_length == name_read.bytes_read ||
+        value_read.bytes_read != value_read.size) {
+      LOG(WARNING) << "could not read annotation from "
+                   << base::UTF16ToUTF8(name_);
+      continue;
+    }
+
+    AnnotationSnapshot& snapshot = (*annotations)[valid++];
+    if (&snapshot != &(*annotations)[first + index]) {
+      snapshot.value = std::move((*annotations)[first + index].value);
+    }
+    snapshot.name.assign(&names[index][0], name_length);
+    snapshot.type = headers[index].type;
+  }
+  annotations->resize(valid);
+}
+
 }  // namespace crashpad
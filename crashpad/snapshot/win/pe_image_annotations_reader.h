@@ -15,11 +15,15 @@
 #ifndef CRASHPAD_SNAPSHOT_WIN_PE_IMAGE_ANNOTATIONS_READER_H_
 #define CRASHPAD_SNAPSHOT_WIN_PE_IMAGE_ANNOTATIONS_READER_H_
 
+#include <stdint.h>
+
 #include <map>
 #include <string>
 #include <vector>
 
 #include "base/macros.h"
+#include "snapshot/annotation_snapshot.h"
+#include "util/win/address_types.h"
 
 namespace crashpad {
 
@@ -35,7 +39,12 @@ class ProcessReaderWin;
 //! Currently, this class can decode information stored only in the CrashpadInfo
 //! structure. This format is used by Crashpad clients. The "simple annotations"
 //! are recovered from any module with a compatible data section, and are
-//! included in the annotations returned by SimpleMap().
+//! included in the annotations returned by SimpleMap(). Typed annotations in an
+//! AnnotationList are recovered from modules whose CrashpadInfo is at least
+//! version 2, and are returned by AnnotationsList(). Per-thread typed
+//! annotations in a ThreadAnnotationRegistry are recovered from modules whose
+//! CrashpadInfo is at least version 3, and are returned by
+//! ThreadAnnotationsList().
 class PEImageAnnotationsReader {
  public:
   //! \brief Constructs the object.
@@ -54,12 +63,39 @@ class PEImageAnnotationsReader {
   //!     pairs, where all keys and values are strings.
   std::map<std::string, std::string> SimpleMap() const;
 
+  //! \brief Returns the module's typed annotations that are set.
+  std::vector<AnnotationSnapshot> AnnotationsList() const;
+
+  //! \brief Returns the module's per-thread typed annotations that are set,
+  //!     keyed by thread ID.
+  std::map<uint64_t, std::vector<AnnotationSnapshot>> ThreadAnnotationsList()
+      const;
+
  private:
   // Reads CrashpadInfo::simple_annotations_ on behalf of SimpleMap().
   template <class Traits>
   void ReadCrashpadSimpleAnnotations(
       std::map<std::string, std::string>* simple_map_annotations) const;
 
+  // Reads CrashpadInfo::annotations_list_ on behalf of AnnotationsList().
+  template <class Traits>
+  void ReadCrashpadAnnotationsList(
+      std::vector<AnnotationSnapshot>* annotations) const;
+
+  // Reads CrashpadInfo::thread_annotations_ on behalf of
+  // ThreadAnnotationsList().
+  template <class Traits>
+  void ReadCrashpadThreadAnnotations(
+      std::map<uint64_t, std::vector<AnnotationSnapshot>>* thread_annotations)
+      const;
+
+  // Appends the annotations that are set in the list beginning at the
+  // Annotation at |head| to |annotations|.
+  template <class Traits>
+  void ReadAnnotationsFromHead(
+      WinVMAddress head,
+      std::vector<AnnotationSnapshot>* annotations) const;
+
   std::wstring name_;
   ProcessReaderWin* process_reader_;  // weak
   const PEImageReader* pe_image_reader_;  // weak
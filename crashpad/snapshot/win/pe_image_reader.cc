@@ -17,7 +17,9 @@
 #include <stddef.h>
 #include <string.h>
 
+#include <algorithm>
 #include <memory>
+#include <utility>
 
 #include "base/logging.h"
 #include "client/crashpad_info.h"
@@ -44,10 +46,20 @@ struct NtHeadersForTraits<process_types::internal::Traits64> {
   using type = IMAGE_NT_HEADERS64;
 };
 
+// The size of the first read of an image’s headers, one page, which holds the
+// headers of any ordinary image.
+constexpr size_t kHeadersReadSize = 4096;
+
 }  // namespace
 
 PEImageReader::PEImageReader()
     : module_subrange_reader_(),
+      sections_(),
+      data_directories_(),
+      crashpad_info_address_(0),
+      crashpad_info_size_(0),
+      crashpad_info_data_(),
+      crashpad_info_data_state_(),
       initialized_() {
 }
 
@@ -65,47 +77,109 @@ bool PEImageReader::Initialize(ProcessReaderWin* process_reader,
     return false;
   }
 
+  // The headers are read once, here, and the section table and data
+  // directories are kept. An image whose headers can’t be read is still valid,
+  // but has no sections or data directories.
+  size_t max_crashpad_info_size;
+  if (process_reader->Is64Bit()) {
+    max_crashpad_info_size =
+        sizeof(process_types::CrashpadInfo<process_types::internal::Traits64>);
+    ReadHeaders<IMAGE_NT_HEADERS64>();
+  } else {
+    max_crashpad_info_size =
+        sizeof(process_types::CrashpadInfo<process_types::internal::Traits32>);
+    ReadHeaders<IMAGE_NT_HEADERS32>();
+  }
+
+  // Locate the CPADinfo section now, so that the section table is only walked
+  // once regardless of how many times GetCrashpadInfo() is called.
+  IMAGE_SECTION_HEADER section;
+  if (GetSectionByName("CPADinfo", &section)) {
+    crashpad_info_address_ = address + section.VirtualAddress;
+    crashpad_info_size_ =
+        std::min(static_cast<WinVMSize>(section.Misc.VirtualSize),
+                 static_cast<WinVMSize>(max_crashpad_info_size));
+  }
+
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
 
+bool PEImageReader::CrashpadInfoSection(WinVMAddress* address,
+                                        WinVMSize* size) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  if (!crashpad_info_size_) {
+    return false;
+  }
+
+  *address = crashpad_info_address_;
+  *size = crashpad_info_size_;
+  return true;
+}
+
+void PEImageReader::SetCrashpadInfoData(std::vector<char> data) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK_NE(crashpad_info_size_, 0u);
+  DCHECK_LE(data.size(), crashpad_info_size_);
+
+  crashpad_info_data_ = std::move(data);
+  crashpad_info_data_state_.set_valid();
+}
+
 template <class Traits>
 bool PEImageReader::GetCrashpadInfo(
     process_types::CrashpadInfo<Traits>* crashpad_info) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  IMAGE_SECTION_HEADER section;
-  if (!GetSectionByName<typename NtHeadersForTraits<Traits>::type>("CPADinfo",
-                                                                   &section)) {
+  if (!crashpad_info_size_) {
     return false;
   }
 
-  if (section.Misc.VirtualSize < sizeof(process_types::CrashpadInfo<Traits>)) {
-    LOG(WARNING) << "small crashpad info section size "
-                 << section.Misc.VirtualSize << ", "
-                 << module_subrange_reader_.name();
-    return false;
+  // The section’s contents are read at most once, unless they were already
+  // supplied by SetCrashpadInfoData().
+  if (crashpad_info_data_state_.is_uninitialized()) {
+    crashpad_info_data_state_.set_invalid();
+
+    ProcessSubrangeReader crashpad_info_subrange_reader;
+    if (!crashpad_info_subrange_reader.InitializeSubrange(
+            module_subrange_reader_,
+            crashpad_info_address_,
+            crashpad_info_size_,
+            "crashpad_info")) {
+      return false;
+    }
+
+    std::vector<char> data(static_cast<size_t>(crashpad_info_size_));
+    if (!crashpad_info_subrange_reader.ReadMemory(
+            crashpad_info_address_, data.size(), &data[0])) {
+      LOG(WARNING) << "could not read crashpad info from "
+                   << module_subrange_reader_.name();
+      return false;
+    }
+
+    crashpad_info_data_ = std::move(data);
+    crashpad_info_data_state_.set_valid();
   }
 
-  ProcessSubrangeReader crashpad_info_subrange_reader;
-  const WinVMAddress crashpad_info_address = Address() + section.VirtualAddress;
-  if (!crashpad_info_subrange_reader.InitializeSubrange(
-          module_subrange_reader_,
-          crashpad_info_address,
-          section.Misc.VirtualSize,
-          "crashpad_info")) {
+  if (!crashpad_info_data_state_.is_valid()) {
     return false;
   }
 
-  if (!crashpad_info_subrange_reader.ReadMemory(
-          crashpad_info_address,
-          sizeof(process_types::CrashpadInfo<Traits>),
-          crashpad_info)) {
-    LOG(WARNING) << "could not read crashpad info from "
+  // Modules built against earlier versions of the client have smaller
+  // structures. Their fields are a prefix of the current structure.
+  constexpr size_t kVersion1Size =
+      offsetof(process_types::CrashpadInfo<Traits>, annotations_list);
+  if (crashpad_info_data_.size() < kVersion1Size) {
+    LOG(WARNING) << "small crashpad info section size "
+                 << crashpad_info_data_.size() << ", "
                  << module_subrange_reader_.name();
     return false;
   }
 
+  memset(crashpad_info, 0, sizeof(*crashpad_info));
+  memcpy(crashpad_info, &crashpad_info_data_[0], kVersion1Size);
+
   if (crashpad_info->signature != CrashpadInfo::kSignature ||
       crashpad_info->version < 1) {
     LOG(WARNING) << "unexpected crashpad info data in "
@@ -113,6 +187,39 @@ bool PEImageReader::GetCrashpadInfo(
     return false;
   }
 
+  // The section may contain more than the structure, so only the version
+  // determines whether later fields are present.
+  size_t expected_size;
+  if (crashpad_info->version >= 7) {
+    expected_size = sizeof(*crashpad_info);
+  } else if (crashpad_info->version == 6) {
+    expected_size = offsetof(process_types::CrashpadInfo<Traits>,
+                             excluded_address_ranges_count);
+  } else if (crashpad_info->version == 5) {
+    expected_size =
+        offsetof(process_types::CrashpadInfo<Traits>, capture_deadline_ms);
+  } else if (crashpad_info->version == 4) {
+    expected_size =
+        offsetof(process_types::CrashpadInfo<Traits>, module_table);
+  } else if (crashpad_info->version == 3) {
+    expected_size = offsetof(process_types::CrashpadInfo<Traits>,
+                             ring_buffer_minidump_stream_head);
+  } else if (crashpad_info->version == 2) {
+    expected_size =
+        offsetof(process_types::CrashpadInfo<Traits>, thread_annotations);
+  } else {
+    expected_size = kVersion1Size;
+  }
+  if (crashpad_info->size < expected_size ||
+      crashpad_info_data_.size() < expected_size) {
+    LOG(WARNING) << "could not read crashpad info from "
+                 << module_subrange_reader_.name();
+    return false;
+  }
+  memcpy(reinterpret_cast<char*>(crashpad_info) + kVersion1Size,
+         &crashpad_info_data_[kVersion1Size],
+         expected_size - kVersion1Size);
+
   return true;
 }
 
@@ -273,43 +380,98 @@ bool PEImageReader::VSFixedFileInfo(
 }
 
 template <class NtHeadersType>
-bool PEImageReader::ReadNtHeaders(NtHeadersType* nt_headers,
-                                  WinVMAddress* nt_headers_address) const {
-  IMAGE_DOS_HEADER dos_header;
-  if (!module_subrange_reader_.ReadMemory(
-          Address(), sizeof(IMAGE_DOS_HEADER), &dos_header)) {
+bool PEImageReader::ReadHeaders() {
+  std::vector<char> headers(static_cast<size_t>(
+      std::min(Size(), static_cast<WinVMSize>(kHeadersReadSize))));
+
+  // Extends headers to |size| bytes, if they aren’t that long already.
+  auto read_headers = [this, &headers](WinVMSize size) {
+    if (size <= headers.size()) {
+      return true;
+    }
+    if (size > Size()) {
+      return false;
+    }
+    const size_t old_size = headers.size();
+    headers.resize(static_cast<size_t>(size));
+    return module_subrange_reader_.ReadMemory(
+        Address() + old_size, headers.size() - old_size, &headers[old_size]);
+  };
+
+  if (headers.size() < sizeof(IMAGE_DOS_HEADER) ||
+      !module_subrange_reader_.ReadMemory(
+          Address(), headers.size(), &headers[0])) {
     LOG(WARNING) << "could not read dos header from "
                  << module_subrange_reader_.name();
     return false;
   }
 
+  IMAGE_DOS_HEADER dos_header;
+  memcpy(&dos_header, &headers[0], sizeof(dos_header));
   if (dos_header.e_magic != IMAGE_DOS_SIGNATURE) {
     LOG(WARNING) << "invalid e_magic in dos header of "
                  << module_subrange_reader_.name();
     return false;
   }
 
-  WinVMAddress local_nt_headers_address = Address() + dos_header.e_lfanew;
-  if (!module_subrange_reader_.ReadMemory(
-          local_nt_headers_address, sizeof(NtHeadersType), nt_headers)) {
+  const WinVMSize nt_headers_offset =
+      static_cast<WinVMSize>(static_cast<DWORD>(dos_header.e_lfanew));
+  if (!read_headers(nt_headers_offset + sizeof(NtHeadersType))) {
     LOG(WARNING) << "could not read nt headers from "
                  << module_subrange_reader_.name();
     return false;
   }
 
-  if (nt_headers->Signature != IMAGE_NT_SIGNATURE) {
+  NtHeadersType nt_headers;
+  memcpy(&nt_headers,
+         &headers[static_cast<size_t>(nt_headers_offset)],
+         sizeof(nt_headers));
+  if (nt_headers.Signature != IMAGE_NT_SIGNATURE) {
     LOG(WARNING) << "invalid signature in nt headers of "
                  << module_subrange_reader_.name();
     return false;
   }
 
-  if (nt_headers_address)
-    *nt_headers_address = local_nt_headers_address;
+  const WinVMSize sections_offset =
+      nt_headers_offset + offsetof(NtHeadersType, OptionalHeader) +
+      nt_headers.FileHeader.SizeOfOptionalHeader;
+  const size_t section_count = nt_headers.FileHeader.NumberOfSections;
+  if (!read_headers(sections_offset +
+                    section_count * sizeof(IMAGE_SECTION_HEADER))) {
+    LOG(WARNING) << "could not read sections from "
+                 << module_subrange_reader_.name();
+    return false;
+  }
+  sections_.resize(section_count);
+  if (section_count) {
+    memcpy(&sections_[0],
+           &headers[static_cast<size_t>(sections_offset)],
+           section_count * sizeof(IMAGE_SECTION_HEADER));
+  }
+
+  // Only the entries within both the optional header and the count it declares
+  // are present.
+  using OptionalHeaderType = decltype(nt_headers.OptionalHeader);
+  const size_t data_directories_offset =
+      offsetof(OptionalHeaderType, DataDirectory);
+  size_t data_directory_count = std::min(
+      static_cast<size_t>(nt_headers.OptionalHeader.NumberOfRvaAndSizes),
+      arraysize(nt_headers.OptionalHeader.DataDirectory));
+  if (nt_headers.FileHeader.SizeOfOptionalHeader < data_directories_offset) {
+    data_directory_count = 0;
+  } else {
+    data_directory_count = std::min(
+        data_directory_count,
+        (nt_headers.FileHeader.SizeOfOptionalHeader - data_directories_offset) /
+            sizeof(IMAGE_DATA_DIRECTORY));
+  }
+  data_directories_.assign(
+      nt_headers.OptionalHeader.DataDirectory,
+      nt_headers.OptionalHeader.DataDirectory + data_directory_count);
 
   return true;
 }
 
-template <class NtHeadersType>
 bool PEImageReader::GetSectionByName(const std::string& name,
                                      IMAGE_SECTION_HEADER* section) const {
   if (name.size() > sizeof(section->Name)) {
@@ -317,26 +479,11 @@ bool PEImageReader::GetSectionByName(const std::string& name,
     return false;
   }
 
-  NtHeadersType nt_headers;
-  WinVMAddress nt_headers_address;
-  if (!ReadNtHeaders(&nt_headers, &nt_headers_address))
-    return false;
-
-  WinVMAddress first_section_address =
-      nt_headers_address + offsetof(NtHeadersType, OptionalHeader) +
-      nt_headers.FileHeader.SizeOfOptionalHeader;
-  for (DWORD i = 0; i < nt_headers.FileHeader.NumberOfSections; ++i) {
-    WinVMAddress section_address =
-        first_section_address + sizeof(IMAGE_SECTION_HEADER) * i;
-    if (!module_subrange_reader_.ReadMemory(
-            section_address, sizeof(IMAGE_SECTION_HEADER), section)) {
-      LOG(WARNING) << "could not read section " << i << " from "
-                   << module_subrange_reader_.name();
-      return false;
-    }
-    if (strncmp(reinterpret_cast<const char*>(section->Name),
+  for (const IMAGE_SECTION_HEADER& candidate : sections_) {
+    if (strncmp(reinterpret_cast<const char*>(candidate.Name),
                 name.c_str(),
-                sizeof(section->Name)) == 0) {
+                sizeof(candidate.Name)) == 0) {
+      *section = candidate;
       return true;
     }
   }
@@ -346,34 +493,12 @@ bool PEImageReader::GetSectionByName(const std::string& name,
 
 bool PEImageReader::ImageDataDirectoryEntry(size_t index,
                                             IMAGE_DATA_DIRECTORY* entry) const {
-  bool rv;
-  if (module_subrange_reader_.Is64Bit()) {
-    rv = ImageDataDirectoryEntryT<IMAGE_NT_HEADERS64>(index, entry);
-  } else {
-    rv = ImageDataDirectoryEntryT<IMAGE_NT_HEADERS32>(index, entry);
-  }
-
-  return rv && entry->VirtualAddress != 0 && entry->Size != 0;
-}
-
-template <class NtHeadersType>
-bool PEImageReader::ImageDataDirectoryEntryT(
-    size_t index,
-    IMAGE_DATA_DIRECTORY* entry) const {
-  NtHeadersType nt_headers;
-  if (!ReadNtHeaders(&nt_headers, nullptr)) {
+  if (index >= data_directories_.size()) {
     return false;
   }
 
-  if (nt_headers.FileHeader.SizeOfOptionalHeader <
-          offsetof(decltype(nt_headers.OptionalHeader), DataDirectory[index]) +
-              sizeof(nt_headers.OptionalHeader.DataDirectory[index]) ||
-      nt_headers.OptionalHeader.NumberOfRvaAndSizes <= index) {
-    return false;
-  }
-
-  *entry = nt_headers.OptionalHeader.DataDirectory[index];
-  return true;
+  *entry = data_directories_[index];
+  return entry->VirtualAddress != 0 && entry->Size != 0;
 }
 
 // Explicit instantiations with the only 2 valid template arguments to avoid
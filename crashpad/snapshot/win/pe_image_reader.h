@@ -20,9 +20,11 @@
 #include <sys/types.h>
 
 #include <string>
+#include <vector>
 
 #include "base/macros.h"
 #include "snapshot/win/process_subrange_reader.h"
+#include "util/misc/initialization_state.h"
 #include "util/misc/initialization_state_dcheck.h"
 #include "util/misc/uuid.h"
 #include "util/win/address_types.h"
@@ -40,7 +42,7 @@ struct CrashpadInfo {
   uint32_t size;
   uint32_t version;
   uint32_t indirectly_referenced_memory_cap;
-  uint32_t padding_0;
+  uint32_t extra_address_ranges_count;  // 0 for SimpleAddressRangeBag.
   uint8_t crashpad_handler_behavior;  // TriState.
   uint8_t system_crash_reporter_forwarding;  // TriState.
   uint8_t gather_indirectly_referenced_memory;  // TriState.
@@ -48,6 +50,52 @@ struct CrashpadInfo {
   typename Traits::Pointer extra_address_ranges;
   typename Traits::Pointer simple_annotations;
   typename Traits::Pointer user_data_minidump_stream_head;
+
+  // Version 2.
+  typename Traits::Pointer annotations_list;
+
+  // Version 3.
+  typename Traits::Pointer thread_annotations;
+
+  // Version 4.
+  typename Traits::Pointer ring_buffer_minidump_stream_head;
+
+  // Version 5.
+  typename Traits::Pointer module_table;
+
+  // Version 6.
+  uint32_t capture_deadline_ms;
+
+  // Version 7.
+  uint32_t excluded_address_ranges_count;
+  typename Traits::Pointer excluded_address_ranges;
+};
+
+template <class Traits>
+struct Annotation {
+  typename Traits::Pointer link_node;
+  typename Traits::Pointer name;
+  typename Traits::Pointer value;
+  uint32_t size;
+  uint16_t type;  // Annotation::Type.
+  uint16_t reserved;
+};
+
+template <class Traits>
+struct AnnotationList {
+  typename Traits::Pointer head;
+};
+
+template <class Traits>
+struct ThreadAnnotationSlot {
+  uint64_t thread_id;
+  typename Traits::Pointer link_node;
+  typename Traits::Pointer annotations_head;  // AnnotationList::head_.
+};
+
+template <class Traits>
+struct ThreadAnnotationRegistry {
+  typename Traits::Pointer head;
 };
 
 }  // namespace process_types
@@ -95,6 +143,10 @@ class PEImageReader {
 
   //! \brief Obtains the module's CrashpadInfo structure.
   //!
+  //! The structure is read from the remote process the first time that this
+  //! method is called, unless it was supplied by SetCrashpadInfoData(), and is
+  //! not read again.
+  //!
   //! \return `true` on success, `false` on failure. If the module does not have
   //!     a `CPADinfo` section, this will return `false` without logging any
   //!     messages. Other failures will result in messages being logged.
@@ -102,6 +154,29 @@ class PEImageReader {
   bool GetCrashpadInfo(
       process_types::CrashpadInfo<Traits>* crashpad_info) const;
 
+  //! \brief Locates the module's CrashpadInfo structure without reading it.
+  //!
+  //! \param[out] address The address of the module's `CPADinfo` section.
+  //! \param[out] size The number of bytes at \a address that may hold the
+  //!     CrashpadInfo structure. This is the size of the section, but no more
+  //!     than the size of the largest CrashpadInfo structure known.
+  //!
+  //! \return `true` on success. `false` if the module does not have a
+  //!     `CPADinfo` section, without logging any messages.
+  bool CrashpadInfoSection(WinVMAddress* address, WinVMSize* size) const;
+
+  //! \brief Supplies the contents of the module's `CPADinfo` section, so that
+  //!     GetCrashpadInfo() need not read them.
+  //!
+  //! This allows a caller to read the CrashpadInfo structures of many modules
+  //! at once, as located by CrashpadInfoSection().
+  //!
+  //! \param[in] data The bytes read from the section. This may be shorter than
+  //!     the size given by CrashpadInfoSection() if the read was incomplete,
+  //!     in which case GetCrashpadInfo() will fail if any fields that it needs
+  //!     are missing.
+  void SetCrashpadInfoData(std::vector<char> data);
+
   //! \brief Obtains information from the module's debug directory, if any.
   //!
   //! \param[out] uuid The unique identifier of the executable/PDB.
@@ -136,23 +211,19 @@ class PEImageReader {
   bool VSFixedFileInfo(VS_FIXEDFILEINFO* vs_fixed_file_info) const;
 
  private:
-  //! \brief Reads the `IMAGE_NT_HEADERS` from the beginning of the image.
+  //! \brief Reads the headers at the beginning of the image, and keeps its
+  //!     section table and data directories.
   //!
-  //! \param[out] nt_headers The contents of the templated NtHeadersType
-  //!     structure read from the remote process.
-  //! \param[out] nt_headers_address The address of the templated NtHeadersType
-  //!     structure in the remote process’ address space. If this information is
-  //!     not needed, this parameter may be `nullptr`.
+  //! The headers of an image normally fit within its first page, which is read
+  //! from the remote process at once. Only headers that extend beyond it
+  //! require further reads.
   //!
-  //! \return `true` on success, with \a nt_headers and optionally \a
-  //!     nt_headers_address set appropriately. `false` on failure, with a
-  //!     message logged.
+  //! \return `true` on success, with sections_ and data_directories_
+  //!     populated. `false` on failure, with a message logged.
   template <class NtHeadersType>
-  bool ReadNtHeaders(NtHeadersType* nt_headers,
-                     WinVMAddress* nt_headers_address) const;
+  bool ReadHeaders();
 
   //! \brief Finds a given section by name in the image.
-  template <class NtHeadersType>
   bool GetSectionByName(const std::string& name,
                         IMAGE_SECTION_HEADER* section) const;
 
@@ -168,13 +239,24 @@ class PEImageReader {
   //!     message. `false` on failure, with a message logged.
   bool ImageDataDirectoryEntry(size_t index, IMAGE_DATA_DIRECTORY* entry) const;
 
-  //! \brief A templatized helper for ImageDataDirectoryEntry() to account for
-  //!     differences in \a NtHeadersType.
-  template <class NtHeadersType>
-  bool ImageDataDirectoryEntryT(size_t index,
-                                IMAGE_DATA_DIRECTORY* entry) const;
-
   ProcessSubrangeReader module_subrange_reader_;
+
+  // The image’s section table and the entries of its
+  // IMAGE_OPTIONAL_HEADER::DataDirectory, as read by ReadHeaders(). Both are
+  // empty if the headers couldn’t be read.
+  std::vector<IMAGE_SECTION_HEADER> sections_;
+  std::vector<IMAGE_DATA_DIRECTORY> data_directories_;
+
+  // The location of the CPADinfo section, as returned by
+  // CrashpadInfoSection(). crashpad_info_size_ is 0 if there is none.
+  WinVMAddress crashpad_info_address_;
+  WinVMSize crashpad_info_size_;
+
+  // The contents of the CPADinfo section, once read. crashpad_info_data_state_
+  // is invalid if reading them failed.
+  mutable std::vector<char> crashpad_info_data_;
+  mutable InitializationState crashpad_info_data_state_;
+
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(PEImageReader);
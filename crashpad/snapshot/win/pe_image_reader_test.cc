@@ -16,9 +16,14 @@
 
 #define PSAPI_VERSION 1
 #include <psapi.h>
+#include <string.h>
+
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/strings/utf_string_conversions.h"
+#include "build/build_config.h"
+#include "client/crashpad_info.h"
 #include "gtest/gtest.h"
 #include "snapshot/win/process_reader_win.h"
 #include "test/errors.h"
@@ -59,6 +64,65 @@ TEST(PEImageReader, DebugDirectory) {
       0);
 }
 
+TEST(PEImageReader, CrashpadInfoData) {
+  // Ensure that this module’s CrashpadInfo is linked in.
+  ASSERT_TRUE(CrashpadInfo::GetCrashpadInfo());
+
+  ProcessReaderWin process_reader;
+  ASSERT_TRUE(process_reader.Initialize(GetCurrentProcess(),
+                                        ProcessSuspensionState::kRunning));
+  HMODULE self = reinterpret_cast<HMODULE>(&__ImageBase);
+  MODULEINFO module_info;
+  ASSERT_TRUE(CrashpadGetModuleInformation(
+      GetCurrentProcess(), self, &module_info, sizeof(module_info)))
+      << ErrorMessage("GetModuleInformation");
+
+#if defined(ARCH_CPU_64_BITS)
+  using Traits = process_types::internal::Traits64;
+#else
+  using Traits = process_types::internal::Traits32;
+#endif
+
+  // Read the structure directly.
+  PEImageReader direct_reader;
+  ASSERT_TRUE(direct_reader.Initialize(&process_reader,
+                                       FromPointerCast<WinVMAddress>(self),
+                                       module_info.SizeOfImage,
+                                       "self"));
+  process_types::CrashpadInfo<Traits> direct_info;
+  ASSERT_TRUE(direct_reader.GetCrashpadInfo(&direct_info));
+
+  // Supply the section’s contents as ProcessSnapshotWin would after reading
+  // them in a batch.
+  PEImageReader supplied_reader;
+  ASSERT_TRUE(supplied_reader.Initialize(&process_reader,
+                                         FromPointerCast<WinVMAddress>(self),
+                                         module_info.SizeOfImage,
+                                         "self"));
+  WinVMAddress address;
+  WinVMSize size;
+  ASSERT_TRUE(supplied_reader.CrashpadInfoSection(&address, &size));
+  EXPECT_EQ(size, sizeof(direct_info));
+  std::vector<char> data(static_cast<size_t>(size));
+  ASSERT_TRUE(process_reader.ReadMemory(address, size, &data[0]));
+  supplied_reader.SetCrashpadInfoData(data);
+
+  process_types::CrashpadInfo<Traits> supplied_info;
+  ASSERT_TRUE(supplied_reader.GetCrashpadInfo(&supplied_info));
+  EXPECT_EQ(memcmp(&supplied_info, &direct_info, sizeof(direct_info)), 0);
+
+  // An incomplete read is not accepted.
+  PEImageReader truncated_reader;
+  ASSERT_TRUE(truncated_reader.Initialize(&process_reader,
+                                          FromPointerCast<WinVMAddress>(self),
+                                          module_info.SizeOfImage,
+                                          "self"));
+  data.resize(data.size() - 1);
+  truncated_reader.SetCrashpadInfoData(data);
+  process_types::CrashpadInfo<Traits> truncated_info;
+  EXPECT_FALSE(truncated_reader.GetCrashpadInfo(&truncated_info));
+}
+
 void TestVSFixedFileInfo(ProcessReaderWin* process_reader,
                          const ProcessInfo::Module& module,
                          bool known_dll) {
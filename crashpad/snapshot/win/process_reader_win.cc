@@ -14,18 +14,26 @@
 
 #include "snapshot/win/process_reader_win.h"
 
+#include <stddef.h>
 #include <string.h>
 #include <winternl.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "base/numerics/safe_conversions.h"
 #include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "client/module_table.h"
+#include "snapshot/win/pe_image_reader.h"
+#include "util/misc/memory_read_trace.h"
 #include "util/win/capture_context.h"
+#include "util/win/get_function.h"
 #include "util/win/nt_internals.h"
 #include "util/win/ntstatus_logging.h"
 #include "util/win/process_structs.h"
 #include "util/win/scoped_handle.h"
+#include "util/win/scoped_local_alloc.h"
 #include "util/win/time.h"
 
 namespace crashpad {
@@ -126,6 +134,30 @@ HANDLE OpenThread(
   return handle;
 }
 
+// Returns the description assigned to a thread by SetThreadDescription(), or
+// an empty string if it has none. SetThreadDescription() and
+// GetThreadDescription() are only available on Windows 10 1607 and later, so
+// GetThreadDescription() is looked up at runtime, and without relying on its
+// declaration being present in the SDK.
+std::string GetThreadName(HANDLE thread_handle) {
+  typedef HRESULT WINAPI GetThreadDescriptionFunction(HANDLE, PWSTR*);
+  static const auto get_thread_description =
+      internal::GetFunction<GetThreadDescriptionFunction>(
+          L"kernel32.dll", "GetThreadDescription", false);
+  if (!get_thread_description) {
+    return std::string();
+  }
+
+  PWSTR description;
+  HRESULT hr = get_thread_description(thread_handle, &description);
+  if (FAILED(hr)) {
+    LOG(WARNING) << base::StringPrintf("GetThreadDescription: 0x%08lx", hr);
+    return std::string();
+  }
+  ScopedLocalAlloc description_owner(description);
+  return base::UTF16ToUTF8(description);
+}
+
 // It's necessary to suspend the thread to grab CONTEXT. SuspendThread has a
 // side-effect of returning the SuspendCount of the thread on success, so we
 // fill out these two pieces of semi-unrelated data in the same function.
@@ -192,6 +224,7 @@ bool FillThreadContextAndSuspendCount(HANDLE thread_handle,
 ProcessReaderWin::Thread::Thread()
     : context(),
       id(0),
+      name(),
       teb_address(0),
       teb_size(0),
       stack_region_address(0),
@@ -203,11 +236,13 @@ ProcessReaderWin::Thread::Thread()
 
 ProcessReaderWin::ProcessReaderWin()
     : process_(INVALID_HANDLE_VALUE),
+      memory_process_(INVALID_HANDLE_VALUE),
       process_info_(),
       threads_(),
       modules_(),
       suspension_state_(),
       initialized_threads_(false),
+      initialized_modules_(false),
       initialized_() {
 }
 
@@ -219,6 +254,7 @@ bool ProcessReaderWin::Initialize(HANDLE process,
   INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
 
   process_ = process;
+  memory_process_ = process;
   suspension_state_ = suspension_state;
   process_info_.Initialize(process);
 
@@ -226,21 +262,32 @@ bool ProcessReaderWin::Initialize(HANDLE process,
   return true;
 }
 
+bool ProcessReaderWin::InitializeWithClone(HANDLE process, HANDLE clone) {
+  if (!Initialize(process, ProcessSuspensionState::kSuspended))
+    return false;
+
+  memory_process_ = clone;
+
+  // Thread contexts and handles can’t be obtained from the clone, so gather
+  // them now, while the process is known to still be suspended.
+  Threads();
+  process_info_.Handles();
+
+  return true;
+}
+
 bool ProcessReaderWin::ReadMemory(WinVMAddress at,
                                   WinVMSize num_bytes,
                                   void* into) const {
   if (num_bytes == 0)
     return 0;
 
-  SIZE_T bytes_read;
-  if (!ReadProcessMemory(process_,
-                         reinterpret_cast<void*>(at),
-                         into,
-                         base::checked_cast<SIZE_T>(num_bytes),
-                         &bytes_read) ||
-      num_bytes != bytes_read) {
-    PLOG(ERROR) << "ReadMemory at 0x" << std::hex << at << std::dec << " of "
-                << num_bytes << " bytes failed";
+  WinVMSize bytes_read;
+  NTSTATUS status = ReadMemoryPrefix(at, num_bytes, into, &bytes_read);
+  if (!NT_SUCCESS(status) || num_bytes != bytes_read) {
+    NTSTATUS_LOG(ERROR, status) << "ReadMemory at 0x" << std::hex << at
+                                << std::dec << " of " << num_bytes
+                                << " bytes failed";
     return false;
   }
   return true;
@@ -252,33 +299,128 @@ WinVMSize ProcessReaderWin::ReadAvailableMemory(WinVMAddress at,
   if (num_bytes == 0)
     return 0;
 
+  // Try the whole range first. In the common case, it’s fully readable and
+  // this is the only read necessary.
+  WinVMSize bytes_read;
+  NTSTATUS status = ReadMemoryPrefix(at, num_bytes, into, &bytes_read);
+  if (NT_SUCCESS(status) && bytes_read == num_bytes)
+    return num_bytes;
+
+  // Keep the prefix that was copied. NT may stop short of the last readable
+  // byte, so consult the memory map for whatever remains.
+  const WinVMAddress remaining_at = at + bytes_read;
+  const WinVMSize remaining_bytes = num_bytes - bytes_read;
   auto ranges = process_info_.GetReadableRanges(
-      CheckedRange<WinVMAddress, WinVMSize>(at, num_bytes));
+      CheckedRange<WinVMAddress, WinVMSize>(remaining_at, remaining_bytes));
 
   // We only read up until the first unavailable byte, so we only read from the
-  // first range. If we have no ranges, then no bytes were accessible anywhere
-  // in the range.
-  if (ranges.empty()) {
-    LOG(ERROR) << base::StringPrintf(
-        "range at 0x%llx, size 0x%llx completely inaccessible", at, num_bytes);
-    return 0;
+  // first range. If we have no ranges, or the start address was adjusted, the
+  // byte following the prefix is inaccessible.
+  if (ranges.empty() || ranges.front().base() != remaining_at) {
+    if (bytes_read == 0) {
+      LOG(ERROR) << base::StringPrintf(
+          "start of range at 0x%llx, size 0x%llx inaccessible", at, num_bytes);
+    }
+    return bytes_read;
   }
 
-  // If the start address was adjusted, we couldn't read even the first
-  // requested byte.
-  if (ranges.front().base() != at) {
-    LOG(ERROR) << base::StringPrintf(
-        "start of range at 0x%llx, size 0x%llx inaccessible", at, num_bytes);
-    return 0;
+  DCHECK_LE(ranges.front().size(), remaining_bytes);
+
+  // If we fail on a normal read, then something went very wrong.
+  if (!ReadMemory(ranges.front().base(),
+                  ranges.front().size(),
+                  static_cast<char*>(into) + bytes_read)) {
+    return bytes_read;
   }
 
-  DCHECK_LE(ranges.front().size(), num_bytes);
+  return bytes_read + ranges.front().size();
+}
 
-  // If we fail on a normal read, then something went very wrong.
-  if (!ReadMemory(ranges.front().base(), ranges.front().size(), into))
-    return 0;
+void ProcessReaderWin::ReadAvailableMemoryBatch(
+    std::vector<MemoryRead>* reads) const {
+  // Requests are combined only while the combined read stays below this size,
+  // bounding the temporary buffer that combined reads go through.
+  constexpr WinVMSize kMaxCombinedReadSize = 1024 * 1024;
+
+  std::vector<MemoryRead*> sorted;
+  sorted.reserve(reads->size());
+  for (MemoryRead& read : *reads) {
+    read.bytes_read = 0;
+    if (read.size != 0)
+      sorted.push_back(&read);
+  }
+  std::sort(sorted.begin(),
+            sorted.end(),
+            [](const MemoryRead* lhs, const MemoryRead* rhs) {
+              return lhs->address < rhs->address;
+            });
+
+  std::vector<char> buffer;
+  size_t index = 0;
+  while (index < sorted.size()) {
+    // Find the run of requests that are adjacent to or overlap the first one.
+    const WinVMAddress span_base = sorted[index]->address;
+    WinVMAddress span_end = span_base + sorted[index]->size;
+    size_t run_end = index + 1;
+    while (run_end < sorted.size() && sorted[run_end]->address <= span_end) {
+      const WinVMAddress end =
+          std::max(span_end, sorted[run_end]->address + sorted[run_end]->size);
+      if (end - span_base > kMaxCombinedReadSize)
+        break;
+      span_end = end;
+      ++run_end;
+    }
 
-  return ranges.front().size();
+    if (run_end == index + 1) {
+      // Nothing to combine with, so read directly into the caller’s buffer.
+      MemoryRead* read = sorted[index];
+      read->bytes_read =
+          ReadAvailableMemory(read->address, read->size, read->into);
+      ++index;
+      continue;
+    }
+
+    buffer.resize(base::checked_cast<size_t>(span_end - span_base));
+    const WinVMSize span_read =
+        ReadAvailableMemory(span_base, span_end - span_base, buffer.data());
+    const WinVMAddress span_read_end = span_base + span_read;
+
+    for (; index < run_end; ++index) {
+      MemoryRead* read = sorted[index];
+      if (read->address >= span_read_end) {
+        // The combined read stopped before reaching this request, but there
+        // may be readable memory beyond the inaccessible byte that ended it.
+        read->bytes_read =
+            ReadAvailableMemory(read->address, read->size, read->into);
+        continue;
+      }
+      read->bytes_read = std::min(read->size, span_read_end - read->address);
+      memcpy(read->into,
+             &buffer[base::checked_cast<size_t>(read->address - span_base)],
+             base::checked_cast<size_t>(read->bytes_read));
+    }
+  }
+}
+
+NTSTATUS ProcessReaderWin::ReadMemoryPrefix(WinVMAddress at,
+                                            WinVMSize num_bytes,
+                                            void* into,
+                                            WinVMSize* bytes_read) const {
+  SIZE_T nt_bytes_read = 0;
+  NTSTATUS status;
+  {
+    ScopedMemoryRead read(base::checked_cast<size_t>(num_bytes));
+    status =
+        crashpad::NtReadVirtualMemory(memory_process_,
+                                      reinterpret_cast<void*>(at),
+                                      into,
+                                      base::checked_cast<SIZE_T>(num_bytes),
+                                      &nt_bytes_read);
+  }
+  *bytes_read = NT_SUCCESS(status) || status == STATUS_PARTIAL_COPY
+                    ? nt_bytes_read
+                    : 0;
+  return status;
 }
 
 bool ProcessReaderWin::StartTime(timeval* start_time) const {
@@ -323,7 +465,16 @@ const std::vector<ProcessReaderWin::Thread>& ProcessReaderWin::Threads() {
 const std::vector<ProcessInfo::Module>& ProcessReaderWin::Modules() {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  if (!process_info_.Modules(&modules_)) {
+  if (initialized_modules_)
+    return modules_;
+
+  initialized_modules_ = true;
+
+  const bool read_module_table =
+      process_info_.Is64Bit()
+          ? ReadModuleTable<process_types::internal::Traits64>()
+          : ReadModuleTable<process_types::internal::Traits32>();
+  if (!read_module_table && !process_info_.Modules(&modules_)) {
     LOG(ERROR) << "couldn't retrieve modules";
   }
 
@@ -349,6 +500,33 @@ template <class Traits>
 void ProcessReaderWin::ReadThreadData(bool is_64_reading_32) {
   DCHECK(threads_.empty());
 
+  // Walking the target’s own thread handles avoids NtQuerySystemInformation(),
+  // which has to describe every process and thread on the system, and which
+  // gets expensive on a busy host. The system-wide query is only a fallback
+  // for systems that don’t provide NtGetNextThread().
+  const ACCESS_MASK thread_access =
+      THREAD_GET_CONTEXT | THREAD_SUSPEND_RESUME | THREAD_QUERY_INFORMATION;
+  ScopedKernelHANDLE last_thread_handle;
+  for (;;) {
+    HANDLE next_thread_handle;
+    NTSTATUS status = crashpad::NtGetNextThread(process_,
+                                                last_thread_handle.get(),
+                                                thread_access,
+                                                0,
+                                                0,
+                                                &next_thread_handle);
+    if (status == STATUS_NO_MORE_ENTRIES)
+      return;
+    if (!NT_SUCCESS(status)) {
+      if (!last_thread_handle.is_valid())
+        break;
+      NTSTATUS_LOG(ERROR, status) << "NtGetNextThread";
+      return;
+    }
+    last_thread_handle.reset(next_thread_handle);
+    ReadThread<Traits>(last_thread_handle.get(), is_64_reading_32);
+  }
+
   std::unique_ptr<uint8_t[]> buffer;
   process_types::SYSTEM_PROCESS_INFORMATION<Traits>* process_information =
       GetProcessInformation<Traits>(process_, &buffer);
@@ -356,79 +534,181 @@ void ProcessReaderWin::ReadThreadData(bool is_64_reading_32) {
     return;
 
   for (unsigned long i = 0; i < process_information->NumberOfThreads; ++i) {
-    const process_types::SYSTEM_THREAD_INFORMATION<Traits>& thread_info =
-        process_information->Threads[i];
-    ProcessReaderWin::Thread thread;
-    thread.id = thread_info.ClientId.UniqueThread;
-
-    ScopedKernelHANDLE thread_handle(OpenThread(thread_info));
+    ScopedKernelHANDLE thread_handle(
+        OpenThread(process_information->Threads[i]));
     if (!thread_handle.is_valid())
       continue;
+    ReadThread<Traits>(thread_handle.get(), is_64_reading_32);
+  }
+}
 
-    if (!FillThreadContextAndSuspendCount<Traits>(thread_handle.get(),
-                                                  &thread,
-                                                  suspension_state_,
-                                                  is_64_reading_32)) {
-      continue;
+template <class Traits>
+void ProcessReaderWin::ReadThread(HANDLE thread_handle, bool is_64_reading_32) {
+  process_types::THREAD_BASIC_INFORMATION<Traits> thread_basic_info;
+  NTSTATUS status = crashpad::NtQueryInformationThread(
+      thread_handle,
+      static_cast<THREADINFOCLASS>(ThreadBasicInformation),
+      &thread_basic_info,
+      sizeof(thread_basic_info),
+      nullptr);
+  if (!NT_SUCCESS(status)) {
+    NTSTATUS_LOG(ERROR, status) << "NtQueryInformationThread";
+    return;
+  }
+
+  ProcessReaderWin::Thread thread;
+  thread.id = thread_basic_info.ClientId.UniqueThread;
+
+  if (!FillThreadContextAndSuspendCount<Traits>(
+          thread_handle, &thread, suspension_state_, is_64_reading_32)) {
+    return;
+  }
+
+  // TODO(scottmg): I believe we could reverse engineer the PriorityClass from
+  // the Priority, BasePriority, and
+  // https://msdn.microsoft.com/en-us/library/windows/desktop/ms685100 .
+  // MinidumpThreadWriter doesn't handle it yet in any case, so investigate
+  // both of those at the same time if it's useful.
+  thread.priority_class = NORMAL_PRIORITY_CLASS;
+
+  thread.priority = thread_basic_info.Priority;
+
+  thread.name = GetThreadName(thread_handle);
+
+  // Read the TIB (Thread Information Block) which is the first element of the
+  // TEB, for its stack fields.
+  process_types::NT_TIB<Traits> tib;
+  thread.teb_address = thread_basic_info.TebBaseAddress;
+  thread.teb_size = sizeof(process_types::TEB<Traits>);
+  if (ReadMemory(thread.teb_address, sizeof(tib), &tib)) {
+    WinVMAddress base = 0;
+    WinVMAddress limit = 0;
+    // If we're reading a WOW64 process, then the TIB we just retrieved is the
+    // x64 one. The first word of the x64 TIB points at the x86 TIB. See
+    // https://msdn.microsoft.com/en-us/library/dn424783.aspx
+    if (is_64_reading_32) {
+      process_types::NT_TIB<process_types::internal::Traits32> tib32;
+      thread.teb_address = tib.Wow64Teb;
+      thread.teb_size =
+          sizeof(process_types::TEB<process_types::internal::Traits32>);
+      if (ReadMemory(thread.teb_address, sizeof(tib32), &tib32)) {
+        base = tib32.StackBase;
+        limit = tib32.StackLimit;
+      }
+    } else {
+      base = tib.StackBase;
+      limit = tib.StackLimit;
     }
 
-    // TODO(scottmg): I believe we could reverse engineer the PriorityClass from
-    // the Priority, BasePriority, and
-    // https://msdn.microsoft.com/en-us/library/windows/desktop/ms685100 .
-    // MinidumpThreadWriter doesn't handle it yet in any case, so investigate
-    // both of those at the same time if it's useful.
-    thread.priority_class = NORMAL_PRIORITY_CLASS;
-
-    thread.priority = thread_info.Priority;
-
-    process_types::THREAD_BASIC_INFORMATION<Traits> thread_basic_info;
-    NTSTATUS status = crashpad::NtQueryInformationThread(
-        thread_handle.get(),
-        static_cast<THREADINFOCLASS>(ThreadBasicInformation),
-        &thread_basic_info,
-        sizeof(thread_basic_info),
-        nullptr);
-    if (!NT_SUCCESS(status)) {
-      NTSTATUS_LOG(ERROR, status) << "NtQueryInformationThread";
+    // Note, "backwards" because of direction of stack growth.
+    thread.stack_region_address = limit;
+    if (limit > base) {
+      LOG(ERROR) << "invalid stack range: " << base << " - " << limit;
+      thread.stack_region_size = 0;
+    } else {
+      thread.stack_region_size = base - limit;
+    }
+  }
+  threads_.push_back(thread);
+}
+
+template <class Traits>
+bool ProcessReaderWin::ReadModuleTable() {
+  ProcessInfo::Module main_module;
+  if (!process_info_.MainModule(&main_module)) {
+    return false;
+  }
+
+  PEImageReader main_image_reader;
+  if (!main_image_reader.Initialize(this,
+                                    main_module.dll_base,
+                                    main_module.size,
+                                    base::UTF16ToUTF8(main_module.name))) {
+    return false;
+  }
+
+  process_types::CrashpadInfo<Traits> crashpad_info;
+  if (!main_image_reader.GetCrashpadInfo(&crashpad_info) ||
+      crashpad_info.version < 5 || !crashpad_info.module_table) {
+    return false;
+  }
+
+  ModuleTableHeader header;
+  if (!ReadMemory(crashpad_info.module_table, sizeof(header), &header)) {
+    return false;
+  }
+
+  // A table that was being modified when the process was suspended, or that
+  // couldn’t hold every module, is no good, and the loader’s list is used
+  // instead.
+  if (header.version != ModuleTable::kVersion || header.generation % 2 != 0 ||
+      header.flags & ModuleTable::kFlagOverflowed || header.count == 0 ||
+      header.count > ModuleTable::kCapacity) {
+    return false;
+  }
+
+  std::vector<ModuleTableEntry> entries(header.count);
+  if (!ReadMemory(header.entries_address,
+                  entries.size() * sizeof(entries[0]),
+                  &entries[0])) {
+    return false;
+  }
+
+  // The names are small and scattered, so they’re read together.
+  std::vector<ProcessInfo::Module> modules(1, main_module);
+  for (const ModuleTableEntry& entry : entries) {
+    if (entry.base_address == main_module.dll_base) {
       continue;
     }
 
-    // Read the TIB (Thread Information Block) which is the first element of the
-    // TEB, for its stack fields.
-    process_types::NT_TIB<Traits> tib;
-    thread.teb_address = thread_basic_info.TebBaseAddress;
-    thread.teb_size = sizeof(process_types::TEB<Traits>);
-    if (ReadMemory(thread.teb_address, sizeof(tib), &tib)) {
-      WinVMAddress base = 0;
-      WinVMAddress limit = 0;
-      // If we're reading a WOW64 process, then the TIB we just retrieved is the
-      // x64 one. The first word of the x64 TIB points at the x86 TIB. See
-      // https://msdn.microsoft.com/en-us/library/dn424783.aspx
-      if (is_64_reading_32) {
-        process_types::NT_TIB<process_types::internal::Traits32> tib32;
-        thread.teb_address = tib.Wow64Teb;
-        thread.teb_size =
-            sizeof(process_types::TEB<process_types::internal::Traits32>);
-        if (ReadMemory(thread.teb_address, sizeof(tib32), &tib32)) {
-          base = tib32.StackBase;
-          limit = tib32.StackLimit;
-        }
-      } else {
-        base = tib.StackBase;
-        limit = tib.StackLimit;
-      }
+    // A UNICODE_STRING holds at most 32,767 characters.
+    constexpr uint32_t kMaxNameSize = 32767 * sizeof(wchar_t);
+    if (entry.name_size == 0 || entry.name_size > kMaxNameSize) {
+      return false;
+    }
 
-      // Note, "backwards" because of direction of stack growth.
-      thread.stack_region_address = limit;
-      if (limit > base) {
-        LOG(ERROR) << "invalid stack range: " << base << " - " << limit;
-        thread.stack_region_size = 0;
-      } else {
-        thread.stack_region_size = base - limit;
-      }
+    ProcessInfo::Module module;
+    module.name.resize(entry.name_size / sizeof(wchar_t));
+    module.dll_base = entry.base_address;
+    module.size = entry.size;
+    module.timestamp = entry.timestamp;
+    modules.push_back(module);
+  }
+
+  std::vector<MemoryRead> name_reads;
+  size_t module_index = 1;
+  for (const ModuleTableEntry& entry : entries) {
+    if (entry.base_address == main_module.dll_base) {
+      continue;
+    }
+    MemoryRead read;
+    read.address = entry.name_address;
+    read.size = modules[module_index].name.size() * sizeof(wchar_t);
+    read.into = &modules[module_index].name[0];
+    read.bytes_read = 0;
+    name_reads.push_back(read);
+    ++module_index;
+  }
+  ReadAvailableMemoryBatch(&name_reads);
+  for (const MemoryRead& read : name_reads) {
+    if (read.bytes_read != read.size) {
+      return false;
     }
-    threads_.push_back(thread);
   }
+
+  // The process is normally suspended, but a table that changed while it was
+  // being read can’t be trusted.
+  uint32_t generation;
+  if (!ReadMemory(crashpad_info.module_table +
+                      offsetof(ModuleTableHeader, generation),
+                  sizeof(generation),
+                  &generation) ||
+      generation != header.generation) {
+    return false;
+  }
+
+  modules_.swap(modules);
+  return true;
 }
 
 }  // namespace crashpad
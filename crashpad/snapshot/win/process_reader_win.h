@@ -18,6 +18,7 @@
 #include <windows.h>
 #include <sys/time.h>
 
+#include <string>
 #include <vector>
 
 #include "base/macros.h"
@@ -52,6 +53,7 @@ class ProcessReaderWin {
 #endif
     } context;
     uint64_t id;
+    std::string name;
     WinVMAddress teb_address;
     WinVMSize teb_size;
     WinVMAddress stack_region_address;
@@ -81,6 +83,29 @@ class ProcessReaderWin {
   //! \sa ScopedProcessSuspend
   bool Initialize(HANDLE process, ProcessSuspensionState suspension_state);
 
+  //! \brief Initializes this object to read memory from a copy-on-write clone
+  //!     of the process’ address space. This method must be called before any
+  //!     other.
+  //!
+  //! Everything that can only be obtained from \a process itself, including
+  //! thread contexts and the process’ handles, is gathered before this method
+  //! returns, so \a process may be resumed as soon as it does. Thereafter,
+  //! memory is read from \a clone, and reflects the state of \a process when
+  //! \a clone was made.
+  //!
+  //! \param[in] process Process handle, must have `PROCESS_QUERY_INFORMATION`,
+  //!     `PROCESS_VM_READ`, and `PROCESS_DUP_HANDLE` access. It must be
+  //!     suspended when this method is called.
+  //! \param[in] clone A clone of \a process, made while \a process was
+  //!     suspended, which must remain valid for the lifetime of this object.
+  //!
+  //! \return `true` on success, indicating that this object will respond
+  //!     validly to further method calls. `false` on failure. On failure, no
+  //!     further method calls should be made.
+  //!
+  //! \sa ScopedProcessClone
+  bool InitializeWithClone(HANDLE process, HANDLE clone);
+
   //! \return `true` if the target task is a 64-bit process.
   bool Is64Bit() const { return process_info_.Is64Bit(); }
 
@@ -104,6 +129,33 @@ class ProcessReaderWin {
                                 WinVMSize num_bytes,
                                 void* into) const;
 
+  //! \brief A single request to be serviced by ReadAvailableMemoryBatch().
+  struct MemoryRead {
+    //! \brief The address in the target process to read from.
+    WinVMAddress address;
+
+    //! \brief The number of bytes to read.
+    WinVMSize size;
+
+    //! \brief The buffer to read into, which must be at least \a size bytes.
+    void* into;
+
+    //! \brief The number of bytes actually read, set by
+    //!     ReadAvailableMemoryBatch().
+    WinVMSize bytes_read;
+  };
+
+  //! \brief Services several ReadAvailableMemory() requests at once.
+  //!
+  //! The requests are sorted by address, and requests that are adjacent or
+  //! overlap in the target process are combined into a single larger read, so
+  //! that fewer reads cross the process boundary.
+  //!
+  //! \param[in,out] reads The requests to service. On return, the `bytes_read`
+  //!     field of each element is set as ReadAvailableMemory() would have
+  //!     returned for that request alone.
+  void ReadAvailableMemoryBatch(std::vector<MemoryRead>* reads) const;
+
   //! \brief Determines the target process' start time.
   //!
   //! \param[out] start_time The time that the process started.
@@ -127,6 +179,10 @@ class ProcessReaderWin {
 
   //! \return The modules loaded in the process. The first element (at index
   //!     `0`) corresponds to the main executable.
+  //!
+  //! If the main executable registered a ModuleTable with its CrashpadInfo
+  //! structure, the modules are read from that table. Otherwise, they’re
+  //! found by walking the loader’s module list.
   const std::vector<ProcessInfo::Module>& Modules();
 
   //! \return A ProcessInfo object for the process being read.
@@ -143,12 +199,36 @@ class ProcessReaderWin {
   template <class Traits>
   void ReadThreadData(bool is_64_reading_32);
 
+  // Reads the thread open as |thread_handle| and appends it to threads_, or
+  // logs an error and leaves threads_ alone if it can’t be read.
+  template <class Traits>
+  void ReadThread(HANDLE thread_handle, bool is_64_reading_32);
+
+  // Reads modules_ from the ModuleTable registered with the main executable’s
+  // CrashpadInfo structure. Returns false without logging anything if there
+  // is no table, or if it is unusable.
+  template <class Traits>
+  bool ReadModuleTable();
+
+  // Reads from the target process with NtReadVirtualMemory(), setting
+  // |bytes_read| to the length of the prefix that was read even when the
+  // returned status indicates failure.
+  NTSTATUS ReadMemoryPrefix(WinVMAddress at,
+                            WinVMSize num_bytes,
+                            void* into,
+                            WinVMSize* bytes_read) const;
+
   HANDLE process_;
+
+  // The process that memory is read from. This is process_, or a clone of it.
+  HANDLE memory_process_;
+
   ProcessInfo process_info_;
   std::vector<Thread> threads_;
   std::vector<ProcessInfo::Module> modules_;
   ProcessSuspensionState suspension_state_;
   bool initialized_threads_;
+  bool initialized_modules_;
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(ProcessReaderWin);
@@ -17,6 +17,8 @@
 #include <windows.h>
 #include <string.h>
 
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "test/win/win_multiprocess.h"
 #include "util/misc/from_pointer_cast.h"
@@ -48,6 +50,72 @@ TEST(ProcessReaderWin, SelfBasic) {
   EXPECT_STREQ(kTestMemory, buffer);
 }
 
+TEST(ProcessReaderWin, SelfReadAvailableMemory) {
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  const size_t page_size = system_info.dwPageSize;
+
+  // Reserve three pages and commit the first and last, leaving an
+  // inaccessible page in the middle.
+  char* region = static_cast<char*>(
+      VirtualAlloc(nullptr, page_size * 3, MEM_RESERVE, PAGE_READWRITE));
+  ASSERT_TRUE(region);
+  ASSERT_TRUE(VirtualAlloc(region, page_size, MEM_COMMIT, PAGE_READWRITE));
+  ASSERT_TRUE(VirtualAlloc(
+      region + page_size * 2, page_size, MEM_COMMIT, PAGE_READWRITE));
+  for (size_t index = 0; index < page_size; ++index) {
+    region[index] = static_cast<char>(index);
+    region[page_size * 2 + index] = static_cast<char>(~index);
+  }
+
+  ProcessReaderWin process_reader;
+  ASSERT_TRUE(process_reader.Initialize(GetCurrentProcess(),
+                                        ProcessSuspensionState::kRunning));
+
+  const WinVMAddress base = FromPointerCast<WinVMAddress>(region);
+  std::vector<char> buffer(page_size);
+  EXPECT_EQ(process_reader.ReadAvailableMemory(
+                base + page_size - 16, 32, buffer.data()),
+            16u);
+  EXPECT_EQ(memcmp(buffer.data(), region + page_size - 16, 16), 0);
+  EXPECT_EQ(
+      process_reader.ReadAvailableMemory(base + page_size, 16, buffer.data()),
+      0u);
+
+  // The first two requests are adjacent and the second runs into the
+  // inaccessible page. The last two overlap.
+  std::vector<char> buffers[5];
+  std::vector<ProcessReaderWin::MemoryRead> reads(arraysize(buffers));
+  reads[0].address = base + page_size * 2 + 64;
+  reads[0].size = 128;
+  reads[1].address = base;
+  reads[1].size = page_size - 32;
+  reads[2].address = base + page_size - 32;
+  reads[2].size = 64;
+  reads[3].address = base + page_size * 2;
+  reads[3].size = 96;
+  reads[4].address = base + page_size + 16;
+  reads[4].size = 16;
+  for (size_t index = 0; index < reads.size(); ++index) {
+    buffers[index].resize(static_cast<size_t>(reads[index].size));
+    reads[index].into = buffers[index].data();
+  }
+
+  process_reader.ReadAvailableMemoryBatch(&reads);
+
+  EXPECT_EQ(reads[0].bytes_read, 128u);
+  EXPECT_EQ(memcmp(buffers[0].data(), region + page_size * 2 + 64, 128), 0);
+  EXPECT_EQ(reads[1].bytes_read, page_size - 32);
+  EXPECT_EQ(memcmp(buffers[1].data(), region, page_size - 32), 0);
+  EXPECT_EQ(reads[2].bytes_read, 32u);
+  EXPECT_EQ(memcmp(buffers[2].data(), region + page_size - 32, 32), 0);
+  EXPECT_EQ(reads[3].bytes_read, 96u);
+  EXPECT_EQ(memcmp(buffers[3].data(), region + page_size * 2, 96), 0);
+  EXPECT_EQ(reads[4].bytes_read, 0u);
+
+  EXPECT_TRUE(VirtualFree(region, 0, MEM_RELEASE));
+}
+
 constexpr char kTestMemory[] = "Read me from another process";
 
 class ProcessReaderChild final : public WinMultiprocess {
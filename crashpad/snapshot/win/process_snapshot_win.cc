@@ -18,21 +18,90 @@
 #include <wchar.h>
 
 #include <algorithm>
+#include <utility>
 
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/synchronization/lock.h"
 #include "snapshot/win/exception_snapshot_win.h"
+#include "snapshot/win/lock_list_walker.h"
 #include "snapshot/win/memory_snapshot_win.h"
 #include "snapshot/win/module_snapshot_win.h"
 #include "util/misc/from_pointer_cast.h"
+#include "util/misc/memory_read_trace.h"
+#include "util/thread/thread.h"
 #include "util/win/nt_internals.h"
 #include "util/win/registration_protocol_win.h"
 #include "util/win/time.h"
 
 namespace crashpad {
 
+namespace {
+
+// The maximum number of threads used to initialize module snapshots.
+constexpr size_t kModuleInitializationThreads = 4;
+
+// The maximum number of critical sections to capture from the process’ lock
+// list. Some processes have many thousands.
+constexpr size_t kMaxLocks = 2048;
+
+// Initializes module snapshots from a shared list, each into its own slot,
+// until none remain. A slot is left empty if its module fails to initialize.
+class ModuleInitializationThread final : public Thread {
+ public:
+  ModuleInitializationThread(
+      ProcessReaderWin* process_reader,
+      const std::vector<ProcessInfo::Module>* process_reader_modules,
+      std::vector<std::unique_ptr<internal::ModuleSnapshotWin>>* modules,
+      size_t* next_index,
+      base::Lock* lock)
+      : Thread(),
+        process_reader_(process_reader),
+        process_reader_modules_(process_reader_modules),
+        modules_(modules),
+        next_index_(next_index),
+        lock_(lock) {}
+
+  ~ModuleInitializationThread() override {}
+
+ private:
+  // Thread:
+  void ThreadMain() override {
+    ScopedMemoryReadSite read_site(MemoryReadSite::kModules);
+    while (true) {
+      size_t index;
+      {
+        base::AutoLock lock_owner(*lock_);
+        if (*next_index_ == process_reader_modules_->size()) {
+          return;
+        }
+        index = (*next_index_)++;
+      }
+
+      auto module = base::WrapUnique(new internal::ModuleSnapshotWin());
+      if (module->Initialize(process_reader_,
+                             (*process_reader_modules_)[index])) {
+        // Each thread writes only to the slots it claimed, so this doesn’t
+        // need to be guarded by lock_.
+        (*modules_)[index] = std::move(module);
+      }
+    }
+  }
+
+  ProcessReaderWin* process_reader_;  // weak
+  const std::vector<ProcessInfo::Module>* process_reader_modules_;  // weak
+  std::vector<std::unique_ptr<internal::ModuleSnapshotWin>>*
+      modules_;  // weak
+  size_t* next_index_;  // weak
+  base::Lock* lock_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ModuleInitializationThread);
+};
+
+}  // namespace
+
 ProcessSnapshotWin::ProcessSnapshotWin()
     : ProcessSnapshot(),
       system_(),
@@ -46,6 +115,8 @@ ProcessSnapshotWin::ProcessSnapshotWin()
       annotations_simple_map_(),
       snapshot_time_(),
       options_(),
+      capture_deadline_(nullptr),
+      capture_handles_(true),
       initialized_() {
 }
 
@@ -64,6 +135,44 @@ bool ProcessSnapshotWin::Initialize(
   if (!process_reader_.Initialize(process, suspension_state))
     return false;
 
+  return InitializeFromReader(exception_information_address,
+                              debug_critical_section_address);
+}
+
+bool ProcessSnapshotWin::InitializeWithClone(
+    HANDLE process,
+    HANDLE clone,
+    WinVMAddress exception_information_address,
+    WinVMAddress debug_critical_section_address) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  GetTimeOfDay(&snapshot_time_);
+
+  if (!process_reader_.InitializeWithClone(process, clone))
+    return false;
+
+  return InitializeFromReader(exception_information_address,
+                              debug_critical_section_address);
+}
+
+bool ProcessSnapshotWin::InitializeSimulatedException(DWORD thread_id,
+                                                      DWORD exception_code) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(!exception_);
+
+  exception_.reset(new internal::ExceptionSnapshotWin());
+  if (!exception_->InitializeFromThread(
+          &process_reader_, thread_id, exception_code)) {
+    exception_.reset();
+    return false;
+  }
+
+  return true;
+}
+
+bool ProcessSnapshotWin::InitializeFromReader(
+    WinVMAddress exception_information_address,
+    WinVMAddress debug_critical_section_address) {
   if (exception_information_address != 0) {
     ExceptionInformation exception_information = {};
     if (!process_reader_.ReadMemory(exception_information_address,
@@ -94,25 +203,41 @@ bool ProcessSnapshotWin::Initialize(
   }
 
   InitializeModules();
-  InitializeUnloadedModules();
 
   GetCrashpadOptionsInternal(&options_);
+  if (capture_deadline_ && options_.capture_deadline_ms) {
+    capture_deadline_->SetBudget(
+        static_cast<uint64_t>(options_.capture_deadline_ms) * 1000000);
+  }
+
+  if (ShouldCapture(CaptureDeadline::kUnloadedModules)) {
+    InitializeUnloadedModules();
+  }
 
   InitializeThreads(
-      options_.gather_indirectly_referenced_memory == TriState::kEnabled,
+      options_.gather_indirectly_referenced_memory == TriState::kEnabled &&
+          ShouldCapture(CaptureDeadline::kIndirectMemory),
       options_.indirectly_referenced_memory_cap);
 
-  for (const MEMORY_BASIC_INFORMATION64& mbi :
-       process_reader_.GetProcessInfo().MemoryInfo()) {
-    memory_map_.push_back(new internal::MemoryMapRegionSnapshotWin(mbi));
+  if (ShouldCapture(CaptureDeadline::kMemoryInfoList)) {
+    for (const MEMORY_BASIC_INFORMATION64& mbi :
+         process_reader_.GetProcessInfo().MemoryInfo()) {
+      memory_map_.push_back(new internal::MemoryMapRegionSnapshotWin(mbi));
+    }
   }
 
+  // Handles are read from the process when they are first requested, so
+  // whether to do so is decided now, while the deadline applies.
+  capture_handles_ = ShouldCapture(CaptureDeadline::kHandleData);
+
   for (const auto& module : modules_) {
     for (const auto& range : module->ExtraMemoryRanges()) {
       AddMemorySnapshot(range.base(), range.size(), &extra_memory_);
     }
   }
 
+  capture_deadline_ = nullptr;
+
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
@@ -123,6 +248,20 @@ void ProcessSnapshotWin::GetCrashpadOptions(
   *options = options_;
 }
 
+void ProcessSnapshotWin::MaterializeMemory() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  for (internal::ThreadSnapshotWin* thread : threads_.Kept()) {
+    thread->MaterializeMemory();
+  }
+  if (exception_) {
+    exception_->MaterializeMemory();
+  }
+  for (internal::MemorySnapshotWin* memory : extra_memory_) {
+    memory->Materialize();
+  }
+}
+
 pid_t ProcessSnapshotWin::ProcessID() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   return process_reader_.GetProcessInfo().ProcessID();
@@ -172,11 +311,7 @@ const SystemSnapshot* ProcessSnapshotWin::System() const {
 
 std::vector<const ThreadSnapshot*> ProcessSnapshotWin::Threads() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
-  std::vector<const ThreadSnapshot*> threads;
-  for (internal::ThreadSnapshotWin* thread : threads_) {
-    threads.push_back(thread);
-  }
-  return threads;
+  return threads_.Kept<const ThreadSnapshot>();
 }
 
 std::vector<const ModuleSnapshot*> ProcessSnapshotWin::Modules() const {
@@ -208,6 +343,9 @@ std::vector<const MemoryMapRegionSnapshot*> ProcessSnapshotWin::MemoryMap()
 
 std::vector<HandleSnapshot> ProcessSnapshotWin::Handles() const {
   std::vector<HandleSnapshot> result;
+  if (!capture_handles_) {
+    return result;
+  }
   for (const auto& handle : process_reader_.GetProcessInfo().Handles()) {
     HandleSnapshot snapshot;
     // This is probably not strictly correct, but these are not localized so we
@@ -241,27 +379,113 @@ void ProcessSnapshotWin::InitializeThreads(
   uint32_t budget_remaining = indirectly_referenced_memory_cap;
   if (gather_indirectly_referenced_memory)
     budget_remaining_pointer = &budget_remaining;
-  for (const ProcessReaderWin::Thread& process_reader_thread :
-       process_reader_threads) {
-    auto thread = base::WrapUnique(new internal::ThreadSnapshotWin());
-    if (thread->Initialize(&process_reader_,
-                           process_reader_thread,
-                           budget_remaining_pointer)) {
-      threads_.push_back(thread.release());
+
+  // The budget is shared by all threads, and each thread spends what it needs
+  // as it’s initialized. Initialize the thread that raised the exception first,
+  // so that its memory, which is most likely to be relevant, is captured.
+  // threads_ stays in the original order.
+  std::vector<size_t> initialization_order;
+  initialization_order.reserve(process_reader_threads.size());
+  for (size_t index = 0; index < process_reader_threads.size(); ++index) {
+    initialization_order.push_back(index);
+  }
+  if (exception_) {
+    std::stable_partition(
+        initialization_order.begin(),
+        initialization_order.end(),
+        [this, &process_reader_threads](size_t index) {
+          return process_reader_threads[index].id == exception_->ThreadID();
+        });
+  }
+
+  // Modules may exclude memory from capture, and they apply to every thread.
+  std::vector<CheckedRange<uint64_t>> excluded_memory_ranges;
+  for (const internal::ModuleSnapshotWin* module : modules_) {
+    for (const auto& range : module->ExcludedMemoryRanges()) {
+      excluded_memory_ranges.push_back(range);
+    }
+  }
+
+  threads_.Reset(process_reader_threads.size());
+  for (size_t index : initialization_order) {
+    if (threads_.at(index)->Initialize(&process_reader_,
+                                       process_reader_threads[index],
+                                       budget_remaining_pointer,
+                                       excluded_memory_ranges)) {
+      threads_.Keep(index);
     }
   }
 }
 
 void ProcessSnapshotWin::InitializeModules() {
+  // The module list is gathered here, before any threads are started, so that
+  // the threads only ever make const reads of process_reader_.
   const std::vector<ProcessInfo::Module>& process_reader_modules =
       process_reader_.Modules();
-  for (const ProcessInfo::Module& process_reader_module :
-       process_reader_modules) {
-    auto module = base::WrapUnique(new internal::ModuleSnapshotWin());
-    if (module->Initialize(&process_reader_, process_reader_module)) {
+
+  // Parsing each module’s headers, debug directory, and resources means many
+  // small reads from the target process. The modules are independent of one
+  // another, so they’re initialized concurrently, and collected in their
+  // original order afterwards.
+  std::vector<std::unique_ptr<internal::ModuleSnapshotWin>> modules(
+      process_reader_modules.size());
+  size_t next_index = 0;
+  base::Lock lock;
+
+  PointerVector<ModuleInitializationThread> threads;
+  const size_t thread_count =
+      std::min(kModuleInitializationThreads, process_reader_modules.size());
+  for (size_t index = 0; index < thread_count; ++index) {
+    threads.push_back(new ModuleInitializationThread(
+        &process_reader_, &process_reader_modules, &modules, &next_index,
+        &lock));
+    threads.back()->Start();
+  }
+  for (ModuleInitializationThread* thread : threads) {
+    thread->Join();
+  }
+
+  for (auto& module : modules) {
+    if (module) {
       modules_.push_back(module.release());
     }
   }
+
+  ReadModulesCrashpadInfo();
+}
+
+void ProcessSnapshotWin::ReadModulesCrashpadInfo() {
+  // Each module’s CrashpadInfo is consulted several times while the snapshot
+  // is built, and most modules don’t have one. Locating the structures first
+  // and reading all of them together, rather than one module at a time as each
+  // is needed, keeps the number of reads from the target process small.
+  ScopedMemoryReadSite read_site(MemoryReadSite::kAnnotations);
+  std::vector<internal::ModuleSnapshotWin*> modules;
+  std::vector<std::vector<char>> data;
+  std::vector<ProcessReaderWin::MemoryRead> reads;
+  for (internal::ModuleSnapshotWin* module : modules_) {
+    ProcessReaderWin::MemoryRead read;
+    if (!module->pe_image_reader().CrashpadInfoSection(&read.address,
+                                                       &read.size)) {
+      continue;
+    }
+    modules.push_back(module);
+    data.emplace_back(static_cast<size_t>(read.size));
+    read.into = &data.back()[0];
+    read.bytes_read = 0;
+    reads.push_back(read);
+  }
+
+  if (reads.empty()) {
+    return;
+  }
+
+  process_reader_.ReadAvailableMemoryBatch(&reads);
+
+  for (size_t index = 0; index < modules.size(); ++index) {
+    data[index].resize(static_cast<size_t>(reads[index].bytes_read));
+    modules[index]->SetCrashpadInfoData(std::move(data[index]));
+  }
 }
 
 void ProcessSnapshotWin::InitializeUnloadedModules() {
@@ -334,6 +558,10 @@ void ProcessSnapshotWin::InitializeUnloadedModules() {
   }
 }
 
+bool ProcessSnapshotWin::ShouldCapture(CaptureDeadline::Content content) {
+  return !capture_deadline_ || capture_deadline_->ShouldCapture(content);
+}
+
 void ProcessSnapshotWin::GetCrashpadOptionsInternal(
     CrashpadInfoClientOptions* options) {
   CrashpadInfoClientOptions local_options;
@@ -356,12 +584,16 @@ void ProcessSnapshotWin::GetCrashpadOptionsInternal(
       local_options.indirectly_referenced_memory_cap =
           module_options.indirectly_referenced_memory_cap;
     }
+    if (!local_options.capture_deadline_ms) {
+      local_options.capture_deadline_ms = module_options.capture_deadline_ms;
+    }
 
     // If non-default values have been found for all options, the loop can end
     // early.
     if (local_options.crashpad_handler_behavior != TriState::kUnset &&
         local_options.system_crash_reporter_forwarding != TriState::kUnset &&
-        local_options.gather_indirectly_referenced_memory != TriState::kUnset) {
+        local_options.gather_indirectly_referenced_memory != TriState::kUnset &&
+        local_options.capture_deadline_ms) {
       break;
     }
   }
@@ -372,6 +604,7 @@ void ProcessSnapshotWin::GetCrashpadOptionsInternal(
 template <class Traits>
 void ProcessSnapshotWin::InitializePebData(
     WinVMAddress debug_critical_section_address) {
+  ScopedMemoryReadSite read_site(MemoryReadSite::kProcessData);
   WinVMAddress peb_address;
   WinVMSize peb_size;
   process_reader_.GetProcessInfo().Peb(&peb_address, &peb_size);
@@ -437,16 +670,22 @@ void ProcessSnapshotWin::InitializePebData(
       DetermineSizeOfEnvironmentBlock(process_parameters.Environment),
       &extra_memory_);
 
-  // Walk the loader lock which is directly referenced by the PEB.
-  ReadLock<Traits>(peb_data.LoaderLock, &extra_memory_);
-
-  // TODO(scottmg): Use debug_critical_section_address to walk the list of
-  // locks (see history of this file for walking code). In some configurations
-  // this can walk many thousands of locks, so we may want to get some
-  // annotation from the client for which locks to grab. Unfortunately, without
-  // walking the list, the !locks command in windbg won't work because it
-  // requires the lock pointed to by ntdll!RtlCriticalSectionList, which we
-  // won't have captured.
+  // Capture the loader lock which is directly referenced by the PEB, and then
+  // walk the list of locks from the client’s lock, if it provided one. The
+  // list also contains ntdll!RtlCriticalSectionList, which the !locks command
+  // in windbg requires. The walk is bounded because some processes have very
+  // many locks.
+  if (!ShouldCapture(CaptureDeadline::kLocks)) {
+    return;
+  }
+  LockListWalker lock_list_walker(&process_reader_, kMaxLocks);
+  lock_list_walker.AddLock<Traits>(peb_data.LoaderLock);
+  if (debug_critical_section_address) {
+    lock_list_walker.Walk<Traits>(debug_critical_section_address);
+  }
+  for (const auto& range : lock_list_walker.Ranges()) {
+    AddMemorySnapshot(range.base(), range.size(), &extra_memory_);
+  }
 }
 
 void ProcessSnapshotWin::AddMemorySnapshot(
@@ -536,32 +775,4 @@ WinVMSize ProcessSnapshotWin::DetermineSizeOfEnvironmentBlock(
   return env_block.size() * sizeof(env_block[0]);
 }
 
-template <class Traits>
-void ProcessSnapshotWin::ReadLock(
-    WinVMAddress start,
-    PointerVector<internal::MemorySnapshotWin>* into) {
-  // We're walking the RTL_CRITICAL_SECTION_DEBUG ProcessLocksList, but starting
-  // from an actual RTL_CRITICAL_SECTION, so start by getting to the first
-  // RTL_CRITICAL_SECTION_DEBUG.
-
-  process_types::RTL_CRITICAL_SECTION<Traits> critical_section;
-  if (!process_reader_.ReadMemory(
-          start, sizeof(critical_section), &critical_section)) {
-    LOG(ERROR) << "failed to read RTL_CRITICAL_SECTION";
-    return;
-  }
-
-  AddMemorySnapshot(
-      start, sizeof(process_types::RTL_CRITICAL_SECTION<Traits>), into);
-
-  constexpr decltype(critical_section.DebugInfo) kInvalid =
-      static_cast<decltype(critical_section.DebugInfo)>(-1);
-  if (critical_section.DebugInfo == kInvalid)
-    return;
-
-  AddMemorySnapshot(critical_section.DebugInfo,
-                    sizeof(process_types::RTL_CRITICAL_SECTION_DEBUG<Traits>),
-                    into);
-}
-
 }  // namespace crashpad
@@ -27,6 +27,7 @@
 
 #include "base/macros.h"
 #include "client/crashpad_info.h"
+#include "snapshot/capture_deadline.h"
 #include "snapshot/crashpad_info_client_options.h"
 #include "snapshot/exception_snapshot.h"
 #include "snapshot/memory_map_region_snapshot.h"
@@ -34,6 +35,7 @@
 #include "snapshot/module_snapshot.h"
 #include "snapshot/process_snapshot.h"
 #include "snapshot/system_snapshot.h"
+#include "snapshot/system_snapshot_cache.h"
 #include "snapshot/thread_snapshot.h"
 #include "snapshot/unloaded_module_snapshot.h"
 #include "snapshot/win/exception_snapshot_win.h"
@@ -44,6 +46,7 @@
 #include "snapshot/win/thread_snapshot_win.h"
 #include "util/misc/initialization_state_dcheck.h"
 #include "util/misc/uuid.h"
+#include "util/stdlib/object_array.h"
 #include "util/stdlib/pointer_container.h"
 #include "util/win/address_types.h"
 #include "util/win/process_structs.h"
@@ -79,6 +82,75 @@ class ProcessSnapshotWin final : public ProcessSnapshot {
                   WinVMAddress exception_information_address,
                   WinVMAddress debug_critical_section_address);
 
+  //! \brief Initializes the object, reading memory from a copy-on-write clone
+  //!     of the process’ address space.
+  //!
+  //! Once this method returns, everything that must be obtained from
+  //! \a process itself has been gathered, and \a process may be resumed. All
+  //! memory is read from \a clone, so the snapshot reflects the state of
+  //! \a process when \a clone was made, without the need to call
+  //! MaterializeMemory().
+  //!
+  //! \param[in] process The handle to create a snapshot from, which must be
+  //!     suspended when this method is called.
+  //! \param[in] clone A clone of \a process, made while \a process was
+  //!     suspended, which must remain valid for the lifetime of this object.
+  //! \param[in] exception_information_address See Initialize().
+  //! \param[in] debug_critical_section_address See Initialize().
+  //!
+  //! \return `true` if the snapshot could be created, `false` otherwise with
+  //!     an appropriate message logged.
+  //!
+  //! \sa ScopedProcessClone
+  bool InitializeWithClone(HANDLE process,
+                           HANDLE clone,
+                           WinVMAddress exception_information_address,
+                           WinVMAddress debug_critical_section_address);
+
+  //! \brief Reports a simulated exception at a thread of an object that was
+  //!     initialized without exception data.
+  //!
+  //! This is used when the handler itself decides to capture a report, as on
+  //! detecting that a thread has hung, or when it is asked to by another
+  //! process. The exception is reported at the context of \a thread_id as it
+  //! was captured during initialization.
+  //!
+  //! \param[in] thread_id The thread to report the exception in.
+  //! \param[in] exception_code The exception code to report, generally
+  //!     CrashpadClient::kSimulatedExceptionCode.
+  //!
+  //! \return `true` on success, `false` otherwise with an appropriate message
+  //!     logged.
+  bool InitializeSimulatedException(DWORD thread_id, DWORD exception_code);
+
+  //! \brief Sets a cache of system facts to use.
+  //!
+  //! This method must be called before Initialize() or InitializeWithClone().
+  //! See SystemSnapshotWin::SetCache().
+  //!
+  //! \param[in] cache The cache, which must outlive this object. Weak.
+  void SetSystemSnapshotCache(SystemSnapshotCache* cache) {
+    system_.SetCache(cache);
+  }
+
+  //! \brief Sets a deadline for initialization, beyond which optional content
+  //!     is left out.
+  //!
+  //! This method must be called before Initialize() or InitializeWithClone().
+  //! Those methods consult \a deadline before gathering the process’ locks,
+  //! unloaded modules, indirectly referenced memory, memory map, and handles,
+  //! and leave out what it says to skip. A
+  //! CrashpadInfoClientOptions::capture_deadline_ms requested by the process
+  //! replaces the budget of \a deadline once the process’ options have been
+  //! read, which is after its locks have been gathered.
+  //!
+  //! \param[in] deadline The deadline, which must remain valid until the
+  //!     initialization method returns. Weak. `nullptr` to gather everything,
+  //!     which is the default.
+  void SetCaptureDeadline(CaptureDeadline* deadline) {
+    capture_deadline_ = deadline;
+  }
+
   //! \brief Sets the value to be returned by ReportID().
   //!
   //! The crash report ID is under the control of the snapshot producer, which
@@ -111,6 +183,19 @@ class ProcessSnapshotWin final : public ProcessSnapshot {
   //!     the process.
   void GetCrashpadOptions(CrashpadInfoClientOptions* options);
 
+  //! \brief Reads the contents of every memory snapshot now, rather than when
+  //!     they’re read.
+  //!
+  //! Once this has been called, the memory snapshots no longer depend on the
+  //! process, so it may be resumed. Other data, such as module annotations, is
+  //! still read from the process when requested, so a consumer like
+  //! MinidumpFileWriter::InitializeFromSnapshot() should gather it before the
+  //! process is resumed. Only the writing of memory contents may then be
+  //! deferred.
+  //!
+  //! \sa MemorySnapshotWin::Materialize()
+  void MaterializeMemory();
+
   // ProcessSnapshot:
 
   pid_t ProcessID() const override;
@@ -132,6 +217,11 @@ class ProcessSnapshotWin final : public ProcessSnapshot {
   std::vector<const MemorySnapshot*> ExtraMemory() const override;
 
  private:
+  // Initializes everything other than process_reader_ on behalf of
+  // Initialize() and InitializeWithClone().
+  bool InitializeFromReader(WinVMAddress exception_information_address,
+                            WinVMAddress debug_critical_section_address);
+
   // Initializes threads_ on behalf of Initialize().
   void InitializeThreads(bool gather_indirectly_referenced_memory,
                          uint32_t indirectly_referenced_memory_cap);
@@ -139,12 +229,20 @@ class ProcessSnapshotWin final : public ProcessSnapshot {
   // Initializes modules_ on behalf of Initialize().
   void InitializeModules();
 
+  // Reads the CrashpadInfo structure of every module in modules_ in a single
+  // batch, on behalf of InitializeModules().
+  void ReadModulesCrashpadInfo();
+
   // Initializes unloaded_modules_ on behalf of Initialize().
   void InitializeUnloadedModules();
 
   // Initializes options_ on behalf of Initialize().
   void GetCrashpadOptionsInternal(CrashpadInfoClientOptions* options);
 
+  // Returns true if content should be captured, consulting capture_deadline_ if
+  // there is one.
+  bool ShouldCapture(CaptureDeadline::Content content);
+
   // Initializes various memory blocks reachable from the PEB on behalf of
   // Initialize().
   template <class Traits>
@@ -168,15 +266,11 @@ class ProcessSnapshotWin final : public ProcessSnapshot {
   WinVMSize DetermineSizeOfEnvironmentBlock(
       WinVMAddress start_of_environment_block);
 
-  // Starting from the address of a CRITICAL_SECTION, add a lock and, if valid,
-  // its .DebugInfo field to the snapshot.
-  template <class Traits>
-  void ReadLock(WinVMAddress start,
-                PointerVector<internal::MemorySnapshotWin>* into);
-
   internal::SystemSnapshotWin system_;
   PointerVector<internal::MemorySnapshotWin> extra_memory_;
-  PointerVector<internal::ThreadSnapshotWin> threads_;
+  // A process may have thousands of threads, so their snapshots are allocated
+  // together.
+  ObjectArray<internal::ThreadSnapshotWin> threads_;
   PointerVector<internal::ModuleSnapshotWin> modules_;
   std::vector<UnloadedModuleSnapshot> unloaded_modules_;
   std::unique_ptr<internal::ExceptionSnapshotWin> exception_;
@@ -187,6 +281,8 @@ class ProcessSnapshotWin final : public ProcessSnapshot {
   std::map<std::string, std::string> annotations_simple_map_;
   timeval snapshot_time_;
   CrashpadInfoClientOptions options_;
+  CaptureDeadline* capture_deadline_;  // weak, only during initialization
+  bool capture_handles_;
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(ProcessSnapshotWin);
@@ -14,15 +14,29 @@
 
 #include "snapshot/win/process_subrange_reader.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/logging.h"
 #include "snapshot/win/process_reader_win.h"
 
 namespace crashpad {
 
+namespace {
+
+// The amount read ahead on a buffer miss. Reads larger than this bypass the
+// buffer.
+constexpr WinVMSize kReadAheadSize = 4096;
+
+}  // namespace
+
 ProcessSubrangeReader::ProcessSubrangeReader()
     : name_(),
       range_(),
-      process_reader_(nullptr) {
+      process_reader_(nullptr),
+      buffer_(),
+      buffer_address_(0) {
 }
 
 ProcessSubrangeReader::~ProcessSubrangeReader() {
@@ -82,9 +96,41 @@ bool ProcessSubrangeReader::ReadMemory(WinVMAddress address,
     return false;
   }
 
+  if (ReadBuffered(address, size, into)) {
+    return true;
+  }
+
   return process_reader_->ReadMemory(address, size, into);
 }
 
+bool ProcessSubrangeReader::ReadBuffered(WinVMAddress address,
+                                         WinVMSize size,
+                                         void* into) const {
+  if (size > kReadAheadSize) {
+    return false;
+  }
+
+  if (address < buffer_address_ ||
+      address - buffer_address_ + size > buffer_.size()) {
+    // Never read ahead beyond the end of the range, which may not be mapped.
+    const WinVMSize read_size =
+        std::min(kReadAheadSize, range_.End() - address);
+    buffer_.resize(static_cast<size_t>(read_size));
+    buffer_address_ = address;
+    const WinVMSize bytes_read = process_reader_->ReadAvailableMemory(
+        address, read_size, buffer_.data());
+    buffer_.resize(static_cast<size_t>(bytes_read));
+    if (bytes_read < size) {
+      return false;
+    }
+  }
+
+  memcpy(into,
+         &buffer_[static_cast<size_t>(address - buffer_address_)],
+         static_cast<size_t>(size));
+  return true;
+}
+
 bool ProcessSubrangeReader::InitializeInternal(ProcessReaderWin* process_reader,
                                                WinVMAddress base,
                                                WinVMSize size,
@@ -97,6 +143,8 @@ bool ProcessSubrangeReader::InitializeInternal(ProcessReaderWin* process_reader,
 
   name_ = name;
   process_reader_ = process_reader;
+  buffer_.clear();
+  buffer_address_ = 0;
 
   return true;
 }
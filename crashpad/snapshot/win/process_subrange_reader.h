@@ -17,6 +17,10 @@
 
 #include <string>
 
+#include <stdint.h>
+
+#include <vector>
+
 #include "base/macros.h"
 #include "util/misc/initialization_state_dcheck.h"
 #include "util/win/address_types.h"
@@ -32,6 +36,12 @@ class ProcessReaderWin;
 //! This class is useful to restrict reads to a specific address range, such as
 //! the address range occupied by a loaded module, or a specific section within
 //! a module.
+//!
+//! Each object keeps its own small read-ahead buffer, so that the many small
+//! reads made while parsing headers and directories within a module are served
+//! without a system call each. Because the buffer is not shared, objects for
+//! different ranges may be used on different threads concurrently, but a single
+//! object must not be.
 class ProcessSubrangeReader {
  public:
   ProcessSubrangeReader();
@@ -101,9 +111,19 @@ class ProcessSubrangeReader {
                           WinVMSize size,
                           const std::string& name);
 
+  // Serves a read of |size| bytes at |address| from buffer_, refilling it
+  // first if necessary. Returns false without logging if the read can’t be
+  // served from the buffer.
+  bool ReadBuffered(WinVMAddress address, WinVMSize size, void* into) const;
+
   std::string name_;
   CheckedWinAddressRange range_;
   ProcessReaderWin* process_reader_;  // weak
+
+  // ReadMemory() is logically const, but fills the read-ahead buffer. See
+  // https://crashpad.chromium.org/bug/9.
+  mutable std::vector<uint8_t> buffer_;
+  mutable WinVMAddress buffer_address_;
   InitializationStateDcheck initialized_;
 
   DISALLOW_COPY_AND_ASSIGN(ProcessSubrangeReader);
@@ -71,6 +71,7 @@ SystemSnapshotWin::SystemSnapshotWin()
       os_version_full_(),
       os_version_build_(),
       process_reader_(nullptr),
+      cache_(nullptr),
       os_version_major_(0),
       os_version_minor_(0),
       os_version_bugfix_(0),
@@ -86,6 +87,31 @@ void SystemSnapshotWin::Initialize(ProcessReaderWin* process_reader) {
 
   process_reader_ = process_reader;
 
+  SystemSnapshotCache::OSVersion os_version;
+  if (cache_ && cache_->LookupOSVersion(&os_version)) {
+    os_version_full_ = os_version.full;
+    os_version_build_ = os_version.build;
+    os_version_major_ = os_version.major;
+    os_version_minor_ = os_version.minor;
+    os_version_bugfix_ = os_version.bugfix;
+    os_server_ = os_version.server;
+  } else {
+    ReadOSVersion();
+    if (cache_) {
+      os_version.full = os_version_full_;
+      os_version.build = os_version_build_;
+      os_version.major = os_version_major_;
+      os_version.minor = os_version_minor_;
+      os_version.bugfix = os_version_bugfix_;
+      os_version.server = os_server_;
+      cache_->InsertOSVersion(os_version);
+    }
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+}
+
+void SystemSnapshotWin::ReadOSVersion() {
   // We use both GetVersionEx() and GetModuleVersionAndType() (which uses
   // VerQueryValue() internally). GetVersionEx() is not trustworthy after
   // Windows 8 (depending on the application manifest) so its data is used only
@@ -118,8 +144,6 @@ void SystemSnapshotWin::Initialize(ProcessReaderWin* process_reader) {
             ? ""
             : (std::string(" (") + flags_string + ")").c_str());
   }
-
-  INITIALIZATION_STATE_SET_VALID(initialized_);
 }
 
 CPUArchitecture SystemSnapshotWin::GetCPUArchitecture() const {
@@ -22,6 +22,7 @@
 
 #include "base/macros.h"
 #include "snapshot/system_snapshot.h"
+#include "snapshot/system_snapshot_cache.h"
 #include "snapshot/win/process_reader_win.h"
 #include "util/misc/initialization_state_dcheck.h"
 
@@ -50,6 +51,13 @@ class SystemSnapshotWin final : public SystemSnapshot {
   //!     32-bit x86 processes.
   void Initialize(ProcessReaderWin* process_reader);
 
+  //! \brief Sets a cache of system facts to use, shared with other snapshots.
+  //!
+  //! This method must be called before Initialize().
+  //!
+  //! \param[in] cache The cache, which must outlive this object. Weak.
+  void SetCache(SystemSnapshotCache* cache) { cache_ = cache; }
+
   // SystemSnapshot:
 
   CPUArchitecture GetCPUArchitecture() const override;
@@ -78,9 +86,12 @@ class SystemSnapshotWin final : public SystemSnapshot {
                 std::string* daylight_name) const override;
 
  private:
+  void ReadOSVersion();
+
   std::string os_version_full_;
   std::string os_version_build_;
   ProcessReaderWin* process_reader_;  // weak
+  SystemSnapshotCache* cache_;  // weak
   int os_version_major_;
   int os_version_minor_;
   int os_version_bugfix_;
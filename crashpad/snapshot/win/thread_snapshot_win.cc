@@ -22,6 +22,7 @@
 #include "snapshot/win/cpu_context_win.h"
 #include "snapshot/win/capture_memory_delegate_win.h"
 #include "snapshot/win/process_reader_win.h"
+#include "util/misc/memory_read_trace.h"
 
 namespace crashpad {
 namespace internal {
@@ -41,19 +42,33 @@ ThreadSnapshotWin::~ThreadSnapshotWin() {
 bool ThreadSnapshotWin::Initialize(
     ProcessReaderWin* process_reader,
     const ProcessReaderWin::Thread& process_reader_thread,
-    uint32_t* gather_indirectly_referenced_memory_bytes_remaining) {
+    uint32_t* gather_indirectly_referenced_memory_bytes_remaining,
+    const std::vector<CheckedRange<uint64_t>>& excluded_memory_ranges) {
   INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
 
   thread_ = process_reader_thread;
-  if (process_reader->GetProcessInfo().LoggingRangeIsFullyReadable(
+
+  // Pages between the stack limit and the stack base are committed only once
+  // the thread has touched them, but a guard page or a page that is not
+  // committed can still lie within that range. Rather than dropping the stack
+  // entirely, capture the readable portion that ends at the stack base, where
+  // the thread’s live frames are.
+  const WinVMAddress stack_base =
+      thread_.stack_region_address + thread_.stack_region_size;
+  std::vector<CheckedRange<WinVMAddress, WinVMSize>> stack_ranges =
+      process_reader->GetProcessInfo().GetReadableRanges(
           CheckedRange<WinVMAddress, WinVMSize>(thread_.stack_region_address,
-                                                thread_.stack_region_size))) {
-    stack_.Initialize(process_reader,
-                      thread_.stack_region_address,
-                      thread_.stack_region_size);
+                                                thread_.stack_region_size));
+  if (!stack_ranges.empty() && stack_ranges.back().end() == stack_base) {
+    thread_.stack_region_address = stack_ranges.back().base();
+    thread_.stack_region_size = stack_ranges.back().size();
   } else {
-    stack_.Initialize(process_reader, 0, 0);
+    thread_.stack_region_address = 0;
+    thread_.stack_region_size = 0;
   }
+  stack_.Initialize(process_reader,
+                    thread_.stack_region_address,
+                    thread_.stack_region_size);
 
   if (process_reader->GetProcessInfo().LoggingRangeIsFullyReadable(
           CheckedRange<WinVMAddress, WinVMSize>(thread_.teb_address,
@@ -79,20 +94,32 @@ bool ThreadSnapshotWin::Initialize(
   InitializeX86Context(process_reader_thread.context.native, context_.x86);
 #endif  // ARCH_CPU_X86_64
 
+  ScopedMemoryReadSite read_site(MemoryReadSite::kIndirectMemory);
   CaptureMemoryDelegateWin capture_memory_delegate(
       process_reader,
       thread_,
       &pointed_to_memory_,
-      gather_indirectly_referenced_memory_bytes_remaining);
+      gather_indirectly_referenced_memory_bytes_remaining,
+      &excluded_memory_ranges);
   CaptureMemory::PointedToByContext(context_, &capture_memory_delegate);
   if (gather_indirectly_referenced_memory_bytes_remaining) {
-    CaptureMemory::PointedToByMemoryRange(stack_, &capture_memory_delegate);
+    CaptureMemory::PointedToByStack(
+        stack_, context_, &capture_memory_delegate);
   }
 
   INITIALIZATION_STATE_SET_VALID(initialized_);
   return true;
 }
 
+void ThreadSnapshotWin::MaterializeMemory() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  stack_.Materialize();
+  teb_.Materialize();
+  for (MemorySnapshotWin* memory : pointed_to_memory_) {
+    memory->Materialize();
+  }
+}
+
 const CPUContext* ThreadSnapshotWin::Context() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   return &context_;
@@ -108,6 +135,11 @@ uint64_t ThreadSnapshotWin::ThreadID() const {
   return thread_.id;
 }
 
+std::string ThreadSnapshotWin::ThreadName() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return thread_.name;
+}
+
 int ThreadSnapshotWin::SuspendCount() const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
   return thread_.suspend_count;
@@ -17,6 +17,7 @@
 
 #include <stdint.h>
 
+#include <string>
 #include <vector>
 
 #include "base/macros.h"
@@ -27,6 +28,7 @@
 #include "snapshot/win/memory_snapshot_win.h"
 #include "snapshot/win/process_reader_win.h"
 #include "util/misc/initialization_state_dcheck.h"
+#include "util/numeric/checked_range.h"
 #include "util/stdlib/pointer_container.h"
 
 namespace crashpad {
@@ -52,19 +54,29 @@ class ThreadSnapshotWin final : public ThreadSnapshot {
   //!     non-null, add extra memory regions to the snapshot pointed to by the
   //!     thread's stack. The size of the regions added is subtracted from the
   //!     count, and when it's `0`, no more regions will be added.
+  //! \param[in] excluded_memory_ranges Ranges that no memory referenced by
+  //!     the thread’s context or stack will be captured from.
   //!
   //! \return `true` if the snapshot could be created, `false` otherwise with
   //!     an appropriate message logged.
   bool Initialize(
       ProcessReaderWin* process_reader,
       const ProcessReaderWin::Thread& process_reader_thread,
-      uint32_t* gather_indirectly_referenced_memory_bytes_remaining);
+      uint32_t* gather_indirectly_referenced_memory_bytes_remaining,
+      const std::vector<CheckedRange<uint64_t>>& excluded_memory_ranges);
+
+  //! \brief Reads all of the thread’s memory snapshots now, so that they no
+  //!     longer depend on the process.
+  //!
+  //! \sa MemorySnapshotWin::Materialize()
+  void MaterializeMemory();
 
   // ThreadSnapshot:
 
   const CPUContext* Context() const override;
   const MemorySnapshot* Stack() const override;
   uint64_t ThreadID() const override;
+  std::string ThreadName() const override;
   int SuspendCount() const override;
   int Priority() const override;
   uint64_t ThreadSpecificDataAddress() const override;
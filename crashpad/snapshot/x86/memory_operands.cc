@@ -0,0 +1,439 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/x86/memory_operands.h"
+
+#include <algorithm>
+
+namespace crashpad {
+namespace internal {
+
+namespace {
+
+// The maps that an opcode can come from.
+enum class OpcodeMap {
+  kOneByte,
+  k0F,
+  k0F38,
+  k0F3A,
+};
+
+// REX prefix bits, which VEX prefixes also carry.
+constexpr uint8_t kRexW = 0x08;
+constexpr uint8_t kRexR = 0x04;
+constexpr uint8_t kRexX = 0x02;
+constexpr uint8_t kRexB = 0x01;
+
+// The general-purpose registers in the order in which instructions encode
+// them, and the instruction pointer.
+struct Registers {
+  uint64_t gpr[16];
+  uint64_t ip;
+};
+
+void GetRegisters(const CPUContext& context, Registers* registers) {
+  std::fill(std::begin(registers->gpr), std::end(registers->gpr), 0);
+  if (context.architecture == kCPUArchitectureX86_64) {
+    const CPUContextX86_64* x86_64 = context.x86_64;
+    registers->gpr[0] = x86_64->rax;
+    registers->gpr[1] = x86_64->rcx;
+    registers->gpr[2] = x86_64->rdx;
+    registers->gpr[3] = x86_64->rbx;
+    registers->gpr[4] = x86_64->rsp;
+    registers->gpr[5] = x86_64->rbp;
+    registers->gpr[6] = x86_64->rsi;
+    registers->gpr[7] = x86_64->rdi;
+    registers->gpr[8] = x86_64->r8;
+    registers->gpr[9] = x86_64->r9;
+    registers->gpr[10] = x86_64->r10;
+    registers->gpr[11] = x86_64->r11;
+    registers->gpr[12] = x86_64->r12;
+    registers->gpr[13] = x86_64->r13;
+    registers->gpr[14] = x86_64->r14;
+    registers->gpr[15] = x86_64->r15;
+    registers->ip = x86_64->rip;
+  } else {
+    const CPUContextX86* x86 = context.x86;
+    registers->gpr[0] = x86->eax;
+    registers->gpr[1] = x86->ecx;
+    registers->gpr[2] = x86->edx;
+    registers->gpr[3] = x86->ebx;
+    registers->gpr[4] = x86->esp;
+    registers->gpr[5] = x86->ebp;
+    registers->gpr[6] = x86->esi;
+    registers->gpr[7] = x86->edi;
+    registers->ip = x86->eip;
+  }
+}
+
+bool OneByteOpcodeHasModRM(uint8_t opcode) {
+  if (opcode < 0x40) {
+    // The arithmetic instructions, each with four ModR/M forms followed by
+    // forms that take an accumulator operand, and prefixes and escapes.
+    return (opcode & 0x07) < 0x04;
+  }
+
+  switch (opcode) {
+    case 0x62:  // bound
+    case 0x63:  // arpl, movsxd
+    case 0x69:  // imul
+    case 0x6b:  // imul
+    case 0xc0:  // shift group 2
+    case 0xc1:
+    case 0xc4:  // les
+    case 0xc5:  // lds
+    case 0xc6:  // mov
+    case 0xc7:
+    case 0xf6:  // group 3
+    case 0xf7:
+    case 0xfe:  // group 4
+    case 0xff:  // group 5
+      return true;
+  }
+
+  return (opcode >= 0x80 && opcode <= 0x8f) ||  // groups 1 and 1a, mov, etc.
+         (opcode >= 0xd0 && opcode <= 0xd3) ||  // shift group 2
+         (opcode >= 0xd8 && opcode <= 0xdf);    // x87
+}
+
+bool TwoByteOpcodeHasModRM(uint8_t opcode) {
+  switch (opcode) {
+    case 0x04:
+    case 0x05:  // syscall
+    case 0x06:  // clts
+    case 0x07:  // sysret
+    case 0x08:  // invd
+    case 0x09:  // wbinvd
+    case 0x0a:
+    case 0x0b:  // ud2
+    case 0x0e:  // femms
+    case 0x77:  // emms
+    case 0xa0:  // push fs
+    case 0xa1:  // pop fs
+    case 0xa2:  // cpuid
+    case 0xa8:  // push gs
+    case 0xa9:  // pop gs
+    case 0xaa:  // rsm
+      return false;
+  }
+
+  return !(opcode >= 0x30 && opcode <= 0x37) &&  // wrmsr, rdtsc, etc.
+         !(opcode >= 0x80 && opcode <= 0x8f) &&  // jcc
+         !(opcode >= 0xc8 && opcode <= 0xcf);    // bswap
+}
+
+// Returns the size of the immediate operand that follows the ModR/M operand of
+// an instruction, which is needed to find the end of the instruction.
+size_t ImmediateSize(OpcodeMap map,
+                     uint8_t opcode,
+                     uint8_t modrm_reg,
+                     bool operand_size_override) {
+  // The size of an immediate that is the operand size, but never 64 bits.
+  const size_t immediate_z = operand_size_override ? 2 : 4;
+
+  switch (map) {
+    case OpcodeMap::kOneByte:
+      switch (opcode) {
+        case 0x69:
+        case 0x81:
+        case 0xc7:
+          return immediate_z;
+        case 0x6b:
+        case 0x80:
+        case 0x82:
+        case 0x83:
+        case 0xc0:
+        case 0xc1:
+        case 0xc6:
+          return 1;
+        case 0xf6:
+          return modrm_reg <= 1 ? 1 : 0;
+        case 0xf7:
+          return modrm_reg <= 1 ? immediate_z : 0;
+      }
+      return 0;
+
+    case OpcodeMap::k0F:
+      switch (opcode) {
+        case 0x0f:  // 3DNow!, whose opcode is a trailing immediate
+        case 0x70:
+        case 0x71:
+        case 0x72:
+        case 0x73:
+        case 0xa4:  // shld
+        case 0xac:  // shrd
+        case 0xba:  // group 8
+        case 0xc2:
+        case 0xc4:
+        case 0xc5:
+        case 0xc6:
+          return 1;
+      }
+      return 0;
+
+    case OpcodeMap::k0F38:
+      return 0;
+
+    case OpcodeMap::k0F3A:
+      return 1;
+  }
+
+  return 0;
+}
+
+// Reads a little-endian, sign-extended value of |size| bytes from |bytes|.
+int64_t ReadSigned(const uint8_t* bytes, size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+
+  uint64_t value = 0;
+  for (size_t index = 0; index < size; ++index) {
+    value |= static_cast<uint64_t>(bytes[index]) << (index * 8);
+  }
+  const unsigned int shift = static_cast<unsigned int>(64 - size * 8);
+  return static_cast<int64_t>(value << shift) >> shift;
+}
+
+}  // namespace
+
+bool GetMemoryOperandAddresses(const uint8_t* instruction,
+                               size_t size,
+                               const CPUContext& context,
+                               std::vector<uint64_t>* addresses) {
+  const bool is_64_bit = context.architecture == kCPUArchitectureX86_64;
+  size = std::min(size, kMaxX86InstructionLength);
+
+  Registers registers;
+  GetRegisters(context, &registers);
+
+  // Legacy prefixes.
+  bool operand_size_override = false;
+  bool address_size_override = false;
+  size_t offset = 0;
+  for (; offset < size; ++offset) {
+    const uint8_t prefix = instruction[offset];
+    if (prefix == 0x66) {
+      operand_size_override = true;
+    } else if (prefix == 0x67) {
+      address_size_override = true;
+    } else if (prefix == 0x64 || prefix == 0x65) {
+      // fs and gs bases aren’t part of the context.
+      return false;
+    } else if (prefix != 0xf0 && prefix != 0xf2 && prefix != 0xf3 &&
+               prefix != 0x26 && prefix != 0x2e && prefix != 0x36 &&
+               prefix != 0x3e) {
+      break;
+    }
+  }
+
+  // 16-bit addressing isn’t used by any code that this will see.
+  const unsigned int address_bits =
+      is_64_bit ? (address_size_override ? 32 : 64)
+                : (address_size_override ? 16 : 32);
+  if (address_bits == 16) {
+    return false;
+  }
+  const uint64_t address_mask =
+      address_bits == 64 ? ~UINT64_C(0) : UINT64_C(0xffffffff);
+
+  uint8_t rex = 0;
+  if (is_64_bit && offset < size && (instruction[offset] & 0xf0) == 0x40) {
+    rex = instruction[offset++];
+  }
+
+  if (offset >= size) {
+    return false;
+  }
+
+  OpcodeMap map = OpcodeMap::kOneByte;
+  uint8_t opcode = instruction[offset++];
+  if ((opcode == 0xc4 || opcode == 0xc5) && offset < size &&
+      (is_64_bit || (instruction[offset] & 0xc0) == 0xc0)) {
+    // A VEX prefix, which carries inverted REX bits and the opcode map.
+    const uint8_t vex_1 = instruction[offset++];
+    rex = (vex_1 & 0x80) ? 0 : kRexR;
+    if (opcode == 0xc5) {
+      map = OpcodeMap::k0F;
+    } else {
+      if (offset >= size) {
+        return false;
+      }
+      const uint8_t vex_2 = instruction[offset++];
+      if (is_64_bit) {
+        rex |= ((vex_1 & 0x40) ? 0 : kRexX) | ((vex_1 & 0x20) ? 0 : kRexB) |
+               ((vex_2 & 0x80) ? kRexW : 0);
+      }
+      switch (vex_1 & 0x1f) {
+        case 1:
+          map = OpcodeMap::k0F;
+          break;
+        case 2:
+          map = OpcodeMap::k0F38;
+          break;
+        case 3:
+          map = OpcodeMap::k0F3A;
+          break;
+        default:
+          return false;
+      }
+    }
+    if (!is_64_bit) {
+      rex = 0;
+    }
+    if (offset >= size) {
+      return false;
+    }
+    opcode = instruction[offset++];
+
+    // The gathers address memory with a vector of indices.
+    if (map == OpcodeMap::k0F38 && opcode >= 0x90 && opcode <= 0x93) {
+      return false;
+    }
+  } else if (opcode == 0x62 && is_64_bit) {
+    // EVEX.
+    return false;
+  } else if (opcode == 0x0f) {
+    if (offset >= size) {
+      return false;
+    }
+    opcode = instruction[offset++];
+    if (opcode == 0x38 || opcode == 0x3a) {
+      map = opcode == 0x38 ? OpcodeMap::k0F38 : OpcodeMap::k0F3A;
+      if (offset >= size) {
+        return false;
+      }
+      opcode = instruction[offset++];
+    } else {
+      map = OpcodeMap::k0F;
+    }
+  }
+
+  if (map == OpcodeMap::kOneByte) {
+    switch (opcode) {
+      case 0xa0:  // mov al, moffs
+      case 0xa1:  // mov eax, moffs
+      case 0xa2:  // mov moffs, al
+      case 0xa3: {  // mov moffs, eax
+        const size_t moffs_size = address_bits / 8;
+        if (size - offset < moffs_size) {
+          return false;
+        }
+        const int64_t moffs = ReadSigned(instruction + offset, moffs_size);
+        addresses->push_back(static_cast<uint64_t>(moffs) & address_mask);
+        return true;
+      }
+
+      case 0xa4:  // movs
+      case 0xa5:
+      case 0xa6:  // cmps
+      case 0xa7:
+        addresses->push_back(registers.gpr[6] & address_mask);
+        addresses->push_back(registers.gpr[7] & address_mask);
+        return true;
+
+      case 0xaa:  // stos
+      case 0xab:
+      case 0xae:  // scas
+      case 0xaf:
+        addresses->push_back(registers.gpr[7] & address_mask);
+        return true;
+
+      case 0xac:  // lods
+      case 0xad:
+        addresses->push_back(registers.gpr[6] & address_mask);
+        return true;
+
+      case 0x8d:  // lea
+        return true;
+
+      case 0x8f:
+        if (offset < size && (instruction[offset] & 0x38) != 0) {
+          // XOP.
+          return false;
+        }
+        break;
+    }
+
+    if (!OneByteOpcodeHasModRM(opcode)) {
+      return true;
+    }
+  } else if (map == OpcodeMap::k0F) {
+    if (opcode == 0x1f) {  // nop
+      return true;
+    }
+    if (!TwoByteOpcodeHasModRM(opcode)) {
+      return true;
+    }
+  }
+
+  if (offset >= size) {
+    return false;
+  }
+  const uint8_t modrm = instruction[offset++];
+  const uint8_t mod = modrm >> 6;
+  const uint8_t reg = (modrm >> 3) & 0x07;
+  const uint8_t rm = modrm & 0x07;
+  if (mod == 3) {
+    // A register operand.
+    return true;
+  }
+
+  uint64_t address = 0;
+  bool ip_relative = false;
+  size_t displacement_size = mod == 1 ? 1 : (mod == 2 ? 4 : 0);
+  if (rm == 4) {
+    if (offset >= size) {
+      return false;
+    }
+    const uint8_t sib = instruction[offset++];
+    const uint8_t scale = sib >> 6;
+    const uint8_t index = ((sib >> 3) & 0x07) | ((rex & kRexX) ? 8 : 0);
+    const uint8_t base = (sib & 0x07) | ((rex & kRexB) ? 8 : 0);
+    if (index != 4) {
+      address += registers.gpr[index] << scale;
+    }
+    if ((sib & 0x07) == 5 && mod == 0) {
+      displacement_size = 4;
+    } else {
+      address += registers.gpr[base];
+    }
+  } else if (rm == 5 && mod == 0) {
+    displacement_size = 4;
+    ip_relative = is_64_bit;
+  } else {
+    address += registers.gpr[rm | ((rex & kRexB) ? 8 : 0)];
+  }
+
+  if (size - offset < displacement_size) {
+    return false;
+  }
+  address += ReadSigned(instruction + offset, displacement_size);
+  offset += displacement_size;
+
+  if (ip_relative) {
+    // The address is relative to the end of the instruction.
+    offset += ImmediateSize(map, opcode, reg, operand_size_override);
+    if (offset > size) {
+      return false;
+    }
+    address += registers.ip + offset;
+  }
+
+  addresses->push_back(address & address_mask);
+  return true;
+}
+
+}  // namespace internal
+}  // namespace crashpad
@@ -0,0 +1,64 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_SNAPSHOT_X86_MEMORY_OPERANDS_H_
+#define CRASHPAD_SNAPSHOT_X86_MEMORY_OPERANDS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "snapshot/cpu_context.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief The longest that an x86 or x86_64 instruction can be.
+constexpr size_t kMaxX86InstructionLength = 15;
+
+//! \brief Determines the addresses of the memory that an x86 or x86_64
+//!     instruction accesses.
+//!
+//! Only as much of the instruction is decoded as is needed to find its memory
+//! operands: prefixes, the opcode, and any ModR/M, SIB, displacement, and (for
+//! `rip`-relative operands) immediate bytes. An explicit memory operand’s
+//! effective address is computed from the registers in \a context. The operands
+//! of the string instructions, which are addressed by `rsi` and `rdi`, and the
+//! absolute operands of `mov` to and from `moffs` are found too. Stack
+//! operands, which are implicit in instructions like `push`, and `lea`, which
+//! computes an address without accessing it, are not reported.
+//!
+//! \param[in] instruction The instruction’s bytes, which must begin at \a
+//!     context’s instruction pointer.
+//! \param[in] size The number of bytes available at \a instruction. Bytes
+//!     beyond kMaxX86InstructionLength are never examined.
+//! \param[in] context The context of the thread about to execute, or faulting
+//!     in, the instruction.
+//! \param[out] addresses The addresses of the instruction’s memory operands
+//!     are appended to this vector.
+//!
+//! \return `true` if the instruction was understood, even if it doesn’t access
+//!     memory. `false` if the instruction couldn’t be decoded, or its operands
+//!     are relative to `fs` or `gs` and so can’t be computed from \a context.
+//!     \a addresses is left unchanged in that case.
+bool GetMemoryOperandAddresses(const uint8_t* instruction,
+                               size_t size,
+                               const CPUContext& context,
+                               std::vector<uint64_t>* addresses);
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_SNAPSHOT_X86_MEMORY_OPERANDS_H_
@@ -0,0 +1,207 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot/x86/memory_operands.h"
+
+#include <vector>
+
+#include "base/macros.h"
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+using internal::GetMemoryOperandAddresses;
+
+class MemoryOperandsX86_64 : public testing::Test {
+ public:
+  MemoryOperandsX86_64() : context_x86_64_(), context_() {
+    context_.architecture = kCPUArchitectureX86_64;
+    context_.x86_64 = &context_x86_64_;
+    context_x86_64_.rax = 0x10000;
+    context_x86_64_.rbx = 0x20000;
+    context_x86_64_.rsi = 0x30000;
+    context_x86_64_.rdi = 0x40000;
+    context_x86_64_.r12 = 0x50000;
+    context_x86_64_.r13 = 0x60000;
+    context_x86_64_.rsp = 0x70000;
+    context_x86_64_.rip = 0x400000;
+  }
+
+  std::vector<uint64_t> Decode(const std::vector<uint8_t>& instruction,
+                               bool expect_success) {
+    std::vector<uint64_t> addresses;
+    EXPECT_EQ(GetMemoryOperandAddresses(
+                  instruction.data(), instruction.size(), context_, &addresses),
+              expect_success);
+    return addresses;
+  }
+
+ private:
+  CPUContextX86_64 context_x86_64_;
+  CPUContext context_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryOperandsX86_64);
+};
+
+TEST_F(MemoryOperandsX86_64, ModRM) {
+  // mov eax, [rbx]
+  EXPECT_EQ(Decode({0x8b, 0x03}, true), std::vector<uint64_t>({0x20000}));
+
+  // mov qword [rbx + 0x10], rax
+  EXPECT_EQ(Decode({0x48, 0x89, 0x43, 0x10}, true),
+            std::vector<uint64_t>({0x20010}));
+
+  // mov rax, [rbx - 8]
+  EXPECT_EQ(Decode({0x48, 0x8b, 0x43, 0xf8}, true),
+            std::vector<uint64_t>({0x1fff8}));
+
+  // mov eax, [r12 + 0x1000]: the r12 base needs a SIB byte.
+  EXPECT_EQ(Decode({0x41, 0x8b, 0x84, 0x24, 0x00, 0x10, 0x00, 0x00}, true),
+            std::vector<uint64_t>({0x51000}));
+
+  // mov eax, [r13]: the r13 base needs a displacement.
+  EXPECT_EQ(Decode({0x41, 0x8b, 0x45, 0x00}, true),
+            std::vector<uint64_t>({0x60000}));
+
+  // mov eax, [rsi + rax * 4]
+  EXPECT_EQ(Decode({0x8b, 0x04, 0x86}, true),
+            std::vector<uint64_t>({0x70000}));
+
+  // mov eax, [rax * 8 + 0x100]: no base.
+  EXPECT_EQ(Decode({0x8b, 0x04, 0xc5, 0x00, 0x01, 0x00, 0x00}, true),
+            std::vector<uint64_t>({0x80100}));
+
+  // mov eax, [esi]: 32-bit addressing.
+  EXPECT_EQ(Decode({0x67, 0x8b, 0x06}, true),
+            std::vector<uint64_t>({0x30000}));
+
+  // call [rax]
+  EXPECT_EQ(Decode({0xff, 0x10}, true), std::vector<uint64_t>({0x10000}));
+
+  // movdqu xmm0, [rdi]
+  EXPECT_EQ(Decode({0xf3, 0x0f, 0x6f, 0x07}, true),
+            std::vector<uint64_t>({0x40000}));
+
+  // vmovdqu ymm0, [rdi]
+  EXPECT_EQ(Decode({0xc5, 0xfe, 0x6f, 0x07}, true),
+            std::vector<uint64_t>({0x40000}));
+
+  // vmovdqu ymm0, [r12]
+  EXPECT_EQ(Decode({0xc4, 0xc1, 0x7e, 0x6f, 0x04, 0x24}, true),
+            std::vector<uint64_t>({0x50000}));
+}
+
+TEST_F(MemoryOperandsX86_64, RIPRelative) {
+  // mov rax, [rip + 0x100]
+  EXPECT_EQ(Decode({0x48, 0x8b, 0x05, 0x00, 0x01, 0x00, 0x00}, true),
+            std::vector<uint64_t>({0x400107}));
+
+  // mov dword [rip + 0x100], 1: the immediate is part of the instruction.
+  EXPECT_EQ(Decode({0xc7, 0x05, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00},
+                   true),
+            std::vector<uint64_t>({0x40010a}));
+
+  // cmp byte [rip - 0x10], 0
+  EXPECT_EQ(Decode({0x80, 0x3d, 0xf0, 0xff, 0xff, 0xff, 0x00}, true),
+            std::vector<uint64_t>({0x3ffff7}));
+}
+
+TEST_F(MemoryOperandsX86_64, Implicit) {
+  // rep movsb
+  EXPECT_EQ(Decode({0xf3, 0xa4}, true),
+            std::vector<uint64_t>({0x30000, 0x40000}));
+
+  // stosq
+  EXPECT_EQ(Decode({0x48, 0xab}, true), std::vector<uint64_t>({0x40000}));
+
+  // mov eax, [0x123456789]
+  EXPECT_EQ(
+      Decode({0xa1, 0x89, 0x67, 0x45, 0x23, 0x01, 0x00, 0x00, 0x00}, true),
+      std::vector<uint64_t>({0x123456789}));
+}
+
+TEST_F(MemoryOperandsX86_64, NoMemoryOperand) {
+  // mov eax, ebx
+  EXPECT_TRUE(Decode({0x89, 0xd8}, true).empty());
+
+  // lea rax, [rbx + 8]
+  EXPECT_TRUE(Decode({0x48, 0x8d, 0x43, 0x08}, true).empty());
+
+  // nop dword [rax]
+  EXPECT_TRUE(Decode({0x0f, 0x1f, 0x00}, true).empty());
+
+  // ret
+  EXPECT_TRUE(Decode({0xc3}, true).empty());
+
+  // ud2
+  EXPECT_TRUE(Decode({0x0f, 0x0b}, true).empty());
+}
+
+TEST_F(MemoryOperandsX86_64, Undecodable) {
+  // mov rax, fs:[0x28]
+  EXPECT_TRUE(
+      Decode({0x64, 0x48, 0x8b, 0x04, 0x25, 0x28, 0x00, 0x00, 0x00}, false)
+          .empty());
+
+  // Truncated: mov rax, [rbx + 0x1000]
+  EXPECT_TRUE(Decode({0x48, 0x8b, 0x83, 0x00, 0x10}, false).empty());
+
+  // Only prefixes.
+  EXPECT_TRUE(Decode({0x66, 0x66, 0x66}, false).empty());
+
+  EXPECT_TRUE(Decode({}, false).empty());
+}
+
+TEST(MemoryOperandsX86, ModRM) {
+  CPUContextX86 context_x86 = {};
+  CPUContext context;
+  context.architecture = kCPUArchitectureX86;
+  context.x86 = &context_x86;
+  context_x86.eax = 0x10000;
+  context_x86.ecx = 0xfffffff0;
+  context_x86.eip = 0x400000;
+
+  // In 32-bit code, 0x40 is inc eax rather than a REX prefix.
+  std::vector<uint8_t> instruction = {0x40};
+  std::vector<uint64_t> addresses;
+  EXPECT_TRUE(GetMemoryOperandAddresses(
+      instruction.data(), instruction.size(), context, &addresses));
+  EXPECT_TRUE(addresses.empty());
+
+  // mov eax, [0x12345678]: absolute, not relative to eip.
+  instruction = {0x8b, 0x05, 0x78, 0x56, 0x34, 0x12};
+  EXPECT_TRUE(GetMemoryOperandAddresses(
+      instruction.data(), instruction.size(), context, &addresses));
+  EXPECT_EQ(addresses, std::vector<uint64_t>({0x12345678}));
+
+  // mov eax, [ecx + eax]: the address wraps.
+  addresses.clear();
+  instruction = {0x8b, 0x04, 0x01};
+  EXPECT_TRUE(GetMemoryOperandAddresses(
+      instruction.data(), instruction.size(), context, &addresses));
+  EXPECT_EQ(addresses, std::vector<uint64_t>({0xfff0}));
+
+  // les eax, [eax], which looks like a VEX prefix in 64-bit code.
+  addresses.clear();
+  instruction = {0xc4, 0x00};
+  EXPECT_TRUE(GetMemoryOperandAddresses(
+      instruction.data(), instruction.size(), context, &addresses));
+  EXPECT_EQ(addresses, std::vector<uint64_t>({0x10000}));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
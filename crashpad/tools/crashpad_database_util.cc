@@ -14,6 +14,8 @@
 
 #include <errno.h>
 #include <getopt.h>
+#include <inttypes.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,6 +29,7 @@
 #include <vector>
 
 #include "base/files/file_path.h"
+#include "base/format_macros.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/numerics/safe_conversions.h"
@@ -34,6 +37,7 @@
 #include "build/build_config.h"
 #include "client/crash_report_database.h"
 #include "client/settings.h"
+#include "tools/json_line.h"
 #include "tools/tool_support.h"
 #include "util/file/file_io.h"
 #include "util/file/file_reader.h"
@@ -57,11 +61,20 @@ void Usage(const base::FilePath& me) {
 "      --show-pending-reports      show reports eligible for upload\n"
 "      --show-completed-reports    show reports not eligible for upload\n"
 "      --show-all-report-info      with --show-*-reports, show more information\n"
+"      --show-report-counts        show the number and size of reports\n"
 "      --show-report=UUID          show report stored under UUID\n"
 "      --set-uploads-enabled=BOOL  enable or disable uploads\n"
 "      --set-last-upload-attempt-time=TIME\n"
 "                                  set the last-upload-attempt time to TIME\n"
+"      --mark-for-upload-all-pending\n"
+"                                  request upload of every pending report\n"
+"      --delete-reports=STATE      delete reports in STATE: pending,\n"
+"                                  completed, uploaded, or all\n"
+"      --created-before=TIME       with --delete-reports or\n"
+"                                  --mark-for-upload-all-pending, operate\n"
+"                                  only on reports created before TIME\n"
 "      --new-report=PATH           submit a new report at PATH, or - for stdin\n"
+"      --json                      show information as lines of JSON\n"
 "      --utc                       show and set UTC times instead of local\n"
 "      --help                      display this help and exit\n"
 "      --version                   output version information and exit\n",
@@ -74,7 +87,10 @@ struct Options {
   std::vector<base::FilePath> new_report_paths;
   const char* database;
   const char* set_last_upload_attempt_time_string;
+  const char* created_before_string;
   time_t set_last_upload_attempt_time;
+  time_t created_before;
+  CrashReportDatabase::ReportFilter delete_reports_filter;
   bool create;
   bool show_client_id;
   bool show_uploads_enabled;
@@ -82,8 +98,12 @@ struct Options {
   bool show_pending_reports;
   bool show_completed_reports;
   bool show_all_report_info;
+  bool show_report_counts;
   bool set_uploads_enabled;
   bool has_set_uploads_enabled;
+  bool mark_for_upload_all_pending;
+  bool delete_reports;
+  bool json;
   bool utc;
 };
 
@@ -220,6 +240,64 @@ std::string TimeToString(time_t out_time, bool utc) {
   return std::string(string);
 }
 
+// Converts |path| to UTF-8.
+std::string FilePathToUTF8(const base::FilePath& path) {
+#if defined(OS_WIN)
+  return base::UTF16ToUTF8(path.value());
+#else
+  return path.value();
+#endif  // OS_WIN
+}
+
+// Shows information about a single |report| as a line of JSON.
+void ShowReportJSON(const CrashReportDatabase::Report& report) {
+  JSONLine line;
+  line.AddString("uuid", report.uuid.ToString());
+  line.AddBool("found", true);
+  line.AddString("path", FilePathToUTF8(report.file_path));
+  line.AddString("remote_id", report.id);
+  line.AddNumber("creation_time", report.creation_time);
+  line.AddBool("uploaded", report.uploaded);
+  line.AddNumber("last_upload_attempt_time", report.last_upload_attempt_time);
+  line.AddNumber("upload_attempts", report.upload_attempts);
+  line.AddBool("upload_explicitly_requested",
+               report.upload_explicitly_requested);
+  line.AddBool("dump_without_crash", report.dump_without_crash);
+  line.AddNumber("size_in_kb", report.size_in_kb);
+  line.Print();
+}
+
+// Shows information about each report listed as a line of JSON, as it is
+// listed.
+class ReportJSONPrinter final
+    : public CrashReportDatabase::ListReportsDelegate {
+ public:
+  ReportJSONPrinter() {}
+  ~ReportJSONPrinter() {}
+
+  // CrashReportDatabase::ListReportsDelegate:
+  bool ReportListed(
+      const CrashReportDatabase::ReportSummary& summary) override {
+    JSONLine line;
+    line.AddString("uuid", summary.uuid.ToString());
+    line.AddString("state", summary.pending ? "pending" : "completed");
+    line.AddNumber("creation_time", summary.creation_time);
+    line.AddBool("uploaded", summary.uploaded);
+    line.AddNumber("last_upload_attempt_time",
+                   summary.last_upload_attempt_time);
+    line.AddNumber("upload_attempts", summary.upload_attempts);
+    line.AddBool("upload_explicitly_requested",
+                 summary.upload_explicitly_requested);
+    line.AddBool("dump_without_crash", summary.dump_without_crash);
+    line.AddNumber("size_in_kb", summary.size_in_kb);
+    line.Print();
+    return true;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ReportJSONPrinter);
+};
+
 // Shows information about a single |report|. |space_count| is the number of
 // spaces to print before each line that is printed. |utc| determines whether
 // times should be shown in UTC or the local time zone.
@@ -246,6 +324,58 @@ void ShowReport(const CrashReportDatabase::Report& report,
   printf("%sUpload attempts: %d\n", spaces.c_str(), report.upload_attempts);
 }
 
+// Prints the UUID of each report listed, preceded by |space_count| spaces.
+class ReportUUIDPrinter final
+    : public CrashReportDatabase::ListReportsDelegate {
+ public:
+  explicit ReportUUIDPrinter(size_t space_count) : spaces_(space_count, ' ') {}
+  ~ReportUUIDPrinter() {}
+
+  // CrashReportDatabase::ListReportsDelegate:
+  bool ReportListed(
+      const CrashReportDatabase::ReportSummary& summary) override {
+    printf("%s%s\n", spaces_.c_str(), summary.uuid.ToString().c_str());
+    return true;
+  }
+
+ private:
+  const std::string spaces_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReportUUIDPrinter);
+};
+
+// Counts the reports listed, and totals their sizes.
+class ReportCounter final : public CrashReportDatabase::ListReportsDelegate {
+ public:
+  ReportCounter()
+      : pending_count_(0), completed_count_(0), uploaded_count_(0), kb_(0) {}
+  ~ReportCounter() {}
+
+  // CrashReportDatabase::ListReportsDelegate:
+  bool ReportListed(
+      const CrashReportDatabase::ReportSummary& summary) override {
+    ++(summary.pending ? pending_count_ : completed_count_);
+    if (summary.uploaded) {
+      ++uploaded_count_;
+    }
+    kb_ += summary.size_in_kb;
+    return true;
+  }
+
+  size_t pending_count() const { return pending_count_; }
+  size_t completed_count() const { return completed_count_; }
+  size_t uploaded_count() const { return uploaded_count_; }
+  uint64_t kb() const { return kb_; }
+
+ private:
+  size_t pending_count_;
+  size_t completed_count_;
+  size_t uploaded_count_;
+  uint64_t kb_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReportCounter);
+};
+
 // Shows information about a vector of |reports|. |space_count| is the number of
 // spaces to print before each line that is printed. |options| will be consulted
 // to determine whether to show expanded information
@@ -265,6 +395,72 @@ void ShowReports(const std::vector<CrashReportDatabase::Report>& reports,
   }
 }
 
+// Shows the pending reports in |database| if |pending| is true, and the
+// completed reports otherwise. If |heading| is not nullptr, it is shown first,
+// and the reports are indented beneath it. Returns false on failure.
+//
+// Only UUIDs are shown without options.show_all_report_info, so the reports are
+// listed without looking up each report’s path and remote ID.
+bool ShowReportsInState(CrashReportDatabase* database,
+                        bool pending,
+                        const char* heading,
+                        const Options& options) {
+  const size_t space_count = heading ? 2 : 0;
+
+  // Each report is printed as it’s listed, and every line identifies the
+  // report’s state, so there’s no heading.
+  if (options.json) {
+    CrashReportDatabase::ReportFilter filter;
+    filter.pending = pending;
+    filter.completed = !pending;
+    ReportJSONPrinter printer;
+    return database->ListReports(filter, &printer) ==
+           CrashReportDatabase::kNoError;
+  }
+
+  if (!options.show_all_report_info) {
+    if (heading) {
+      printf("%s\n", heading);
+    }
+
+    CrashReportDatabase::ReportFilter filter;
+    filter.pending = pending;
+    filter.completed = !pending;
+    ReportUUIDPrinter printer(space_count);
+    return database->ListReports(filter, &printer) ==
+           CrashReportDatabase::kNoError;
+  }
+
+  std::vector<CrashReportDatabase::Report> reports;
+  if ((pending ? database->GetPendingReports(&reports)
+               : database->GetCompletedReports(&reports)) !=
+      CrashReportDatabase::kNoError) {
+    return false;
+  }
+
+  if (heading) {
+    printf("%s\n", heading);
+  }
+
+  ShowReports(reports, space_count, options);
+  return true;
+}
+
+// Shows the number of reports affected by a bulk operation, as |json_key| with
+// --json, and otherwise labeled with |text|.
+void ShowBulkOperationCount(const char* json_key,
+                            const char* text,
+                            size_t count,
+                            const Options& options) {
+  if (options.json) {
+    JSONLine line;
+    line.AddNumber(json_key, count);
+    line.Print();
+  } else {
+    printf("%s: %" PRIuS "\n", text, count);
+  }
+}
+
 int DatabaseUtilMain(int argc, char* argv[]) {
   const base::FilePath argv0(
       ToolSupport::CommandLineArgumentToFilePathStringType(argv[0]));
@@ -283,10 +479,15 @@ int DatabaseUtilMain(int argc, char* argv[]) {
     kOptionShowPendingReports,
     kOptionShowCompletedReports,
     kOptionShowAllReportInfo,
+    kOptionShowReportCounts,
     kOptionShowReport,
     kOptionSetUploadsEnabled,
     kOptionSetLastUploadAttemptTime,
+    kOptionMarkForUploadAllPending,
+    kOptionDeleteReports,
+    kOptionCreatedBefore,
     kOptionNewReport,
+    kOptionJSON,
     kOptionUTC,
 
     // Standard options.
@@ -309,6 +510,7 @@ int DatabaseUtilMain(int argc, char* argv[]) {
        nullptr,
        kOptionShowCompletedReports},
       {"show-all-report-info", no_argument, nullptr, kOptionShowAllReportInfo},
+      {"show-report-counts", no_argument, nullptr, kOptionShowReportCounts},
       {"show-report", required_argument, nullptr, kOptionShowReport},
       {"set-uploads-enabled",
        required_argument,
@@ -318,7 +520,14 @@ int DatabaseUtilMain(int argc, char* argv[]) {
        required_argument,
        nullptr,
        kOptionSetLastUploadAttemptTime},
+      {"mark-for-upload-all-pending",
+       no_argument,
+       nullptr,
+       kOptionMarkForUploadAllPending},
+      {"delete-reports", required_argument, nullptr, kOptionDeleteReports},
+      {"created-before", required_argument, nullptr, kOptionCreatedBefore},
       {"new-report", required_argument, nullptr, kOptionNewReport},
+      {"json", no_argument, nullptr, kOptionJSON},
       {"utc", no_argument, nullptr, kOptionUTC},
       {"help", no_argument, nullptr, kOptionHelp},
       {"version", no_argument, nullptr, kOptionVersion},
@@ -362,6 +571,10 @@ int DatabaseUtilMain(int argc, char* argv[]) {
         options.show_all_report_info = true;
         break;
       }
+      case kOptionShowReportCounts: {
+        options.show_report_counts = true;
+        break;
+      }
       case kOptionShowReport: {
         UUID uuid;
         if (!uuid.InitializeFromString(optarg)) {
@@ -383,11 +596,40 @@ int DatabaseUtilMain(int argc, char* argv[]) {
         options.set_last_upload_attempt_time_string = optarg;
         break;
       }
+      case kOptionMarkForUploadAllPending: {
+        options.mark_for_upload_all_pending = true;
+        break;
+      }
+      case kOptionDeleteReports: {
+        CrashReportDatabase::ReportFilter& filter =
+            options.delete_reports_filter;
+        if (strcmp(optarg, "pending") == 0) {
+          filter.completed = false;
+        } else if (strcmp(optarg, "completed") == 0) {
+          filter.pending = false;
+        } else if (strcmp(optarg, "uploaded") == 0) {
+          filter.upload_status =
+              CrashReportDatabase::ReportFilter::UploadStatus::kUploaded;
+        } else if (strcmp(optarg, "all") != 0) {
+          ToolSupport::UsageHint(me, "--delete-reports requires a STATE");
+          return EXIT_FAILURE;
+        }
+        options.delete_reports = true;
+        break;
+      }
+      case kOptionCreatedBefore: {
+        options.created_before_string = optarg;
+        break;
+      }
       case kOptionNewReport: {
         options.new_report_paths.push_back(base::FilePath(
             ToolSupport::CommandLineArgumentToFilePathStringType(optarg)));
         break;
       }
+      case kOptionJSON: {
+        options.json = true;
+        break;
+      }
       case kOptionUTC: {
         options.utc = true;
         break;
@@ -427,17 +669,35 @@ int DatabaseUtilMain(int argc, char* argv[]) {
     }
   }
 
+  if (options.created_before_string) {
+    if (!options.delete_reports && !options.mark_for_upload_all_pending) {
+      ToolSupport::UsageHint(me,
+                             "--created-before requires --delete-reports or "
+                             "--mark-for-upload-all-pending");
+      return EXIT_FAILURE;
+    }
+    if (!StringToTime(options.created_before_string,
+                      &options.created_before,
+                      options.utc) ||
+        options.created_before == 0) {
+      ToolSupport::UsageHint(me, "--created-before requires a TIME");
+      return EXIT_FAILURE;
+    }
+  }
+
   // --new-report is treated as a show operation because it produces output.
   const size_t show_operations = options.show_client_id +
                                  options.show_uploads_enabled +
                                  options.show_last_upload_attempt_time +
                                  options.show_pending_reports +
                                  options.show_completed_reports +
+                                 options.show_report_counts +
                                  options.show_reports.size() +
                                  options.new_report_paths.size();
   const size_t set_operations =
       options.has_set_uploads_enabled +
-      (options.set_last_upload_attempt_time_string != nullptr);
+      (options.set_last_upload_attempt_time_string != nullptr) +
+      options.mark_for_upload_all_pending + options.delete_reports;
 
   if ((options.create ? 1 : 0) + show_operations + set_operations == 0) {
     ToolSupport::UsageHint(me, "nothing to do");
@@ -467,9 +727,15 @@ int DatabaseUtilMain(int argc, char* argv[]) {
       return EXIT_FAILURE;
     }
 
-    const char* prefix = (show_operations > 1) ? "Client ID: " : "";
+    if (options.json) {
+      JSONLine line;
+      line.AddString("client_id", client_id.ToString());
+      line.Print();
+    } else {
+      const char* prefix = (show_operations > 1) ? "Client ID: " : "";
 
-    printf("%s%s\n", prefix, client_id.ToString().c_str());
+      printf("%s%s\n", prefix, client_id.ToString().c_str());
+    }
   }
 
   if (options.show_uploads_enabled) {
@@ -478,9 +744,15 @@ int DatabaseUtilMain(int argc, char* argv[]) {
       return EXIT_FAILURE;
     }
 
-    const char* prefix = (show_operations > 1) ? "Uploads enabled: " : "";
+    if (options.json) {
+      JSONLine line;
+      line.AddBool("uploads_enabled", uploads_enabled);
+      line.Print();
+    } else {
+      const char* prefix = (show_operations > 1) ? "Uploads enabled: " : "";
 
-    printf("%s%s\n", prefix, BoolToString(uploads_enabled).c_str());
+      printf("%s%s\n", prefix, BoolToString(uploads_enabled).c_str());
+    }
   }
 
   if (options.show_last_upload_attempt_time) {
@@ -489,41 +761,59 @@ int DatabaseUtilMain(int argc, char* argv[]) {
       return EXIT_FAILURE;
     }
 
-    const char* prefix =
-        (show_operations > 1) ? "Last upload attempt time: " : "";
-
-    printf("%s%s (%ld)\n",
-           prefix,
-           TimeToString(last_upload_attempt_time, options.utc).c_str(),
-           static_cast<long>(last_upload_attempt_time));
-  }
+    if (options.json) {
+      JSONLine line;
+      line.AddNumber("last_upload_attempt_time", last_upload_attempt_time);
+      line.Print();
+    } else {
+      const char* prefix =
+          (show_operations > 1) ? "Last upload attempt time: " : "";
 
-  if (options.show_pending_reports) {
-    std::vector<CrashReportDatabase::Report> pending_reports;
-    if (database->GetPendingReports(&pending_reports) !=
-        CrashReportDatabase::kNoError) {
-      return EXIT_FAILURE;
+      printf("%s%s (%ld)\n",
+             prefix,
+             TimeToString(last_upload_attempt_time, options.utc).c_str(),
+             static_cast<long>(last_upload_attempt_time));
     }
+  }
 
-    if (show_operations > 1) {
-      printf("Pending reports:\n");
-    }
+  if (options.show_pending_reports &&
+      !ShowReportsInState(database.get(),
+                          true,
+                          show_operations > 1 ? "Pending reports:" : nullptr,
+                          options)) {
+    return EXIT_FAILURE;
+  }
 
-    ShowReports(pending_reports, show_operations > 1 ? 2 : 0, options);
+  if (options.show_completed_reports &&
+      !ShowReportsInState(database.get(),
+                          false,
+                          show_operations > 1 ? "Completed reports:" : nullptr,
+                          options)) {
+    return EXIT_FAILURE;
   }
 
-  if (options.show_completed_reports) {
-    std::vector<CrashReportDatabase::Report> completed_reports;
-    if (database->GetCompletedReports(&completed_reports) !=
+  if (options.show_report_counts) {
+    // All of the counts are taken from a single listing, so that they’re
+    // consistent with one another.
+    ReportCounter counter;
+    if (database->ListReports(CrashReportDatabase::ReportFilter(), &counter) !=
         CrashReportDatabase::kNoError) {
       return EXIT_FAILURE;
     }
 
-    if (show_operations > 1) {
-      printf("Completed reports:\n");
+    if (options.json) {
+      JSONLine line;
+      line.AddNumber("pending_reports", counter.pending_count());
+      line.AddNumber("completed_reports", counter.completed_count());
+      line.AddNumber("uploaded_reports", counter.uploaded_count());
+      line.AddNumber("size_in_kb", counter.kb());
+      line.Print();
+    } else {
+      printf("Pending reports: %" PRIuS "\n", counter.pending_count());
+      printf("Completed reports: %" PRIuS "\n", counter.completed_count());
+      printf("Uploaded reports: %" PRIuS "\n", counter.uploaded_count());
+      printf("Report size: %" PRIu64 " KB\n", counter.kb());
     }
-
-    ShowReports(completed_reports, show_operations > 1 ? 2 : 0, options);
   }
 
   for (const UUID& uuid : options.show_reports) {
@@ -531,6 +821,10 @@ int DatabaseUtilMain(int argc, char* argv[]) {
     CrashReportDatabase::OperationStatus status =
         database->LookUpCrashReport(uuid, &report);
     if (status == CrashReportDatabase::kNoError) {
+      if (options.json) {
+        ShowReportJSON(report);
+        continue;
+      }
       if (show_operations > 1) {
         printf("Report %s:\n", uuid.ToString().c_str());
       }
@@ -543,7 +837,14 @@ int DatabaseUtilMain(int argc, char* argv[]) {
             stderr, "%" PRFilePath ": Report not found\n", me.value().c_str());
         return EXIT_FAILURE;
       }
-      printf("Report %s not found\n", uuid.ToString().c_str());
+      if (options.json) {
+        JSONLine line;
+        line.AddString("uuid", uuid.ToString());
+        line.AddBool("found", false);
+        line.Print();
+      } else {
+        printf("Report %s not found\n", uuid.ToString().c_str());
+      }
     } else {
       return EXIT_FAILURE;
     }
@@ -560,6 +861,35 @@ int DatabaseUtilMain(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
+  // Each bulk operation selects and updates its reports in a single operation
+  // on the database, rather than looking them up one UUID at a time.
+  if (options.mark_for_upload_all_pending) {
+    CrashReportDatabase::ReportFilter filter;
+    filter.completed = false;
+    filter.created_before = options.created_before;
+    size_t requested_count;
+    if (database->RequestUploads(filter, &requested_count) !=
+        CrashReportDatabase::kNoError) {
+      return EXIT_FAILURE;
+    }
+    ShowBulkOperationCount("upload_requested_reports",
+                           "Reports requested for upload",
+                           requested_count,
+                           options);
+  }
+
+  if (options.delete_reports) {
+    options.delete_reports_filter.created_before = options.created_before;
+    size_t deleted_count;
+    if (database->DeleteReports(options.delete_reports_filter,
+                                &deleted_count) !=
+        CrashReportDatabase::kNoError) {
+      return EXIT_FAILURE;
+    }
+    ShowBulkOperationCount(
+        "deleted_reports", "Reports deleted", deleted_count, options);
+  }
+
   bool used_stdin = false;
   for (const base::FilePath new_report_path : options.new_report_paths) {
     std::unique_ptr<FileReaderInterface> file_reader;
@@ -615,8 +945,14 @@ int DatabaseUtilMain(int argc, char* argv[]) {
       return EXIT_FAILURE;
     }
 
-    const char* prefix = (show_operations > 1) ? "New report ID: " : "";
-    printf("%s%s\n", prefix, uuid.ToString().c_str());
+    if (options.json) {
+      JSONLine line;
+      line.AddString("new_report", uuid.ToString());
+      line.Print();
+    } else {
+      const char* prefix = (show_operations > 1) ? "New report ID: " : "";
+      printf("%s%s\n", prefix, uuid.ToString().c_str());
+    }
   }
 
   return EXIT_SUCCESS;
@@ -13,31 +13,81 @@
 // limitations under the License.
 
 #include <getopt.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
+#include <time.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "build/build_config.h"
+#include "tools/json_line.h"
 #include "tools/tool_support.h"
+#include "util/file/delimited_file_reader.h"
+#include "util/file/file_reader.h"
 #include "util/file/file_writer.h"
+#include "util/misc/clock.h"
 #include "util/net/http_body.h"
 #include "util/net/http_multipart_builder.h"
+#include "util/net/http_retry_after.h"
 #include "util/net/http_transport.h"
+#include "util/stdlib/string_number_conversion.h"
 #include "util/string/split_string.h"
+#include "util/thread/thread.h"
+
+#if defined(OS_POSIX)
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "util/posix/scoped_dir.h"
+#elif defined(OS_WIN)
+#include <windows.h>
+
+#include "base/strings/utf_string_conversions.h"
+#endif  // OS_POSIX
 
 namespace crashpad {
 namespace {
 
+// The number of concurrent uploads in batch mode, unless --jobs says otherwise.
+constexpr unsigned int kDefaultJobs = 4;
+
+// The number of times that a failed upload is retried in batch mode, unless
+// --retries says otherwise.
+constexpr unsigned int kDefaultRetries = 3;
+
+// The delay before the first retry of an upload, which doubles for each retry
+// after it. No delay, including one asked for by the server, is longer than
+// kMaxRetryDelaySeconds.
+constexpr time_t kInitialRetryDelaySeconds = 1;
+constexpr time_t kMaxRetryDelaySeconds = 300;
+
 void Usage(const base::FilePath& me) {
   fprintf(stderr,
 "Usage: %" PRFilePath " [OPTION]...\n"
 "Send an HTTP POST request.\n"
+"  -d, --directory=KEY=DIR upload each file in DIR, in a request of its own,\n"
+"                          for the HTTP KEY parameter\n"
 "  -f, --file=KEY=PATH     upload the file at PATH for the HTTP KEY parameter\n"
+"  -j, --jobs=COUNT        send up to COUNT requests at once for --directory\n"
+"                          and --manifest (default 4)\n"
+"  -m, --manifest=KEY=FILE upload each file listed in FILE, one path per\n"
+"                          line, for the HTTP KEY parameter, in a request of\n"
+"                          its own\n"
 "      --no-upload-gzip    don't use gzip compression when uploading\n"
 "  -o, --output=FILE       write the response body to FILE instead of stdout\n"
+"      --retries=COUNT     retry each failed request for --directory and\n"
+"                          --manifest up to COUNT times (default 3)\n"
 "  -s, --string=KEY=VALUE  set the HTTP KEY parameter to VALUE\n"
 "  -u, --url=URL           send the request to URL\n"
 "      --help              display this help and exit\n"
@@ -46,6 +96,303 @@ void Usage(const base::FilePath& me) {
   ToolSupport::UsageTail(me);
 }
 
+struct Options {
+  // Form data and files sent with every request.
+  std::vector<std::pair<std::string, std::string>> form_data;
+  std::vector<std::pair<std::string, base::FilePath>> file_attachments;
+
+  // The files named by --directory and --manifest, each sent in a request of
+  // its own, along with the key that each is sent for.
+  std::vector<std::pair<std::string, base::FilePath>> batch_files;
+
+  std::string url;
+  const char* output;
+  unsigned int jobs;
+  unsigned int retries;
+  bool batch;
+  bool upload_gzip;
+};
+
+// Adds the form data and files that are sent with every request to
+// |http_multipart_builder|.
+void PopulateMultipartBuilder(const Options& options,
+                              HTTPMultipartBuilder* http_multipart_builder) {
+  for (const auto& form_data : options.form_data) {
+    http_multipart_builder->SetFormData(form_data.first, form_data.second);
+  }
+  for (const auto& file_attachment : options.file_attachments) {
+    http_multipart_builder->SetFileAttachment(
+        file_attachment.first,
+        ToolSupport::FilePathToCommandLineArgument(
+            file_attachment.second.BaseName()),
+        file_attachment.second,
+        "application/octet-stream");
+  }
+  http_multipart_builder->SetGzipEnabled(options.upload_gzip);
+}
+
+// Prepares |http_transport| to send the request built by
+// |http_multipart_builder| to |url|. A transport may be prepared again for
+// each request that it sends, and its connection to the server is reused.
+void PrepareTransport(const std::string& url,
+                      HTTPMultipartBuilder* http_multipart_builder,
+                      HTTPTransport* http_transport) {
+  http_transport->SetURL(url);
+  http_transport->ClearHeaders();
+
+  HTTPHeaders content_headers;
+  http_multipart_builder->PopulateContentHeaders(&content_headers);
+  for (const auto& content_header : content_headers) {
+    http_transport->SetHeader(content_header.first, content_header.second);
+  }
+
+  http_transport->SetBodyStream(http_multipart_builder->GetBodyStream());
+}
+
+// Appends each regular file in |directory| to |paths|, in sorted order.
+// Returns false, with a message logged, if |directory| can’t be read.
+bool ListDirectory(const base::FilePath& directory,
+                   std::vector<base::FilePath>* paths) {
+  std::vector<base::FilePath> local_paths;
+#if defined(OS_WIN)
+  WIN32_FIND_DATA find_data;
+  HANDLE find_handle =
+      FindFirstFile(directory.Append(L"*").value().c_str(), &find_data);
+  if (find_handle == INVALID_HANDLE_VALUE) {
+    PLOG(ERROR) << "FindFirstFile " << base::UTF16ToUTF8(directory.value());
+    return false;
+  }
+  do {
+    if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+      local_paths.push_back(directory.Append(find_data.cFileName));
+    }
+  } while (FindNextFile(find_handle, &find_data));
+  FindClose(find_handle);
+#else
+  ScopedDIR dir(opendir(directory.value().c_str()));
+  if (!dir) {
+    PLOG(ERROR) << "opendir " << directory.value();
+    return false;
+  }
+  dirent* entry;
+  while ((entry = readdir(dir.get())) != nullptr) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+    const base::FilePath path = directory.Append(entry->d_name);
+    struct stat st;
+    if (stat(path.value().c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+      local_paths.push_back(path);
+    }
+  }
+#endif  // OS_WIN
+
+  std::sort(local_paths.begin(),
+            local_paths.end(),
+            [](const base::FilePath& lhs, const base::FilePath& rhs) {
+              return lhs.value() < rhs.value();
+            });
+  paths->insert(paths->end(), local_paths.begin(), local_paths.end());
+  return true;
+}
+
+// Appends each path listed in the file at |manifest|, one per line, to |paths|.
+// Blank lines are skipped. Returns false, with a message logged, if |manifest|
+// can’t be read.
+bool ReadManifest(const base::FilePath& manifest,
+                  std::vector<base::FilePath>* paths) {
+  FileReader file_reader;
+  if (!file_reader.Open(manifest)) {
+    return false;
+  }
+
+  DelimitedFileReader delimited_file_reader(&file_reader);
+  std::string line;
+  DelimitedFileReader::Result result;
+  while ((result = delimited_file_reader.GetLine(&line)) ==
+         DelimitedFileReader::Result::kSuccess) {
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      paths->push_back(base::FilePath(
+          ToolSupport::CommandLineArgumentToFilePathStringType(line)));
+    }
+  }
+  return result == DelimitedFileReader::Result::kEndOfFile;
+}
+
+// Returns true if a request that failed with |status| may succeed if it is
+// sent again. A |status| of 0 means that no response was received.
+bool IsRetryableStatus(int status) {
+  return status == 0 || status == 408 || status == 429 || status >= 500;
+}
+
+// Returns the number of seconds to wait before retrying a request that
+// |http_transport| failed to send, for the |retry|th time, counting from 0.
+time_t RetryDelay(const HTTPTransport& http_transport, unsigned int retry) {
+  const std::string& retry_after = http_transport.response_retry_after();
+  time_t delay;
+  if (!retry_after.empty() &&
+      ParseHTTPRetryAfter(retry_after, time(nullptr), &delay)) {
+    return std::min(delay, kMaxRetryDelaySeconds);
+  }
+  return std::min(kInitialRetryDelaySeconds << std::min(retry, 8u),
+                  kMaxRetryDelaySeconds);
+}
+
+// Uploads the files of Options::batch_files, several at a time, writing a line
+// of JSON describing the result of each to |output|, and a final line
+// summarizing them all.
+class BatchUploader {
+ public:
+  BatchUploader(const Options* options, FileWriterInterface* output)
+      : lock_(),
+        options_(options),
+        output_(output),
+        next_index_(0),
+        completed_(0),
+        failed_(0),
+        output_failed_(false) {}
+
+  ~BatchUploader() {}
+
+  // Uploads every file, returning true if all of them were uploaded.
+  bool Run();
+
+ private:
+  class UploadThread : public Thread {
+   public:
+    explicit UploadThread(BatchUploader* uploader)
+        : Thread(),
+          http_transport_(HTTPTransport::Create()),
+          uploader_(uploader) {}
+
+    ~UploadThread() override {}
+
+   private:
+    // Thread:
+    void ThreadMain() override {
+      while (uploader_->UploadNext(http_transport_.get())) {
+      }
+    }
+
+    // Each thread keeps its transport for all of the requests that it sends,
+    // so that its connection to the server is reused.
+    std::unique_ptr<HTTPTransport> http_transport_;
+    BatchUploader* uploader_;  // weak
+
+    DISALLOW_COPY_AND_ASSIGN(UploadThread);
+  };
+
+  // Uploads the next file that no thread has taken yet through
+  // |http_transport|. Returns false if there were none left.
+  bool UploadNext(HTTPTransport* http_transport);
+
+  // Writes |line| to output_, followed by a newline.
+  void WriteLineLocked(const JSONLine& line);
+
+  base::Lock lock_;
+  const Options* options_;  // weak
+  FileWriterInterface* output_;  // weak
+
+  // These are protected by lock_.
+  size_t next_index_;
+  size_t completed_;
+  size_t failed_;
+  bool output_failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(BatchUploader);
+};
+
+bool BatchUploader::Run() {
+  const size_t thread_count =
+      std::min(static_cast<size_t>(options_->jobs),
+               std::max(options_->batch_files.size(), static_cast<size_t>(1)));
+  std::vector<std::unique_ptr<UploadThread>> threads;
+  for (size_t index = 0; index < thread_count; ++index) {
+    threads.push_back(std::unique_ptr<UploadThread>(new UploadThread(this)));
+    threads.back()->Start();
+  }
+  for (const auto& thread : threads) {
+    thread->Join();
+  }
+
+  base::AutoLock lock(lock_);
+  JSONLine line;
+  line.AddString("type", "summary");
+  line.AddNumber("total", options_->batch_files.size());
+  line.AddNumber("uploaded", completed_ - failed_);
+  line.AddNumber("failed", failed_);
+  WriteLineLocked(line);
+  return !failed_ && !output_failed_;
+}
+
+bool BatchUploader::UploadNext(HTTPTransport* http_transport) {
+  size_t index;
+  {
+    base::AutoLock lock(lock_);
+    if (next_index_ == options_->batch_files.size()) {
+      return false;
+    }
+    index = next_index_++;
+  }
+
+  const auto& batch_file = options_->batch_files[index];
+  std::string response_body;
+  bool uploaded = false;
+  unsigned int attempts = 0;
+  while (true) {
+    HTTPMultipartBuilder http_multipart_builder;
+    PopulateMultipartBuilder(*options_, &http_multipart_builder);
+    http_multipart_builder.SetFileAttachment(
+        batch_file.first,
+        ToolSupport::FilePathToCommandLineArgument(
+            batch_file.second.BaseName()),
+        batch_file.second,
+        "application/octet-stream");
+    PrepareTransport(options_->url, &http_multipart_builder, http_transport);
+
+    ++attempts;
+    uploaded = http_transport->ExecuteSynchronously(&response_body);
+    if (uploaded || attempts > options_->retries ||
+        !IsRetryableStatus(http_transport->response_status())) {
+      break;
+    }
+    SleepNanoseconds(RetryDelay(*http_transport, attempts - 1) *
+                     static_cast<uint64_t>(1E9));
+  }
+
+  base::AutoLock lock(lock_);
+  ++completed_;
+  if (!uploaded) {
+    ++failed_;
+  }
+
+  JSONLine line;
+  line.AddString("type", "result");
+  line.AddString("file",
+                 ToolSupport::FilePathToCommandLineArgument(batch_file.second));
+  line.AddBool("uploaded", uploaded);
+  line.AddNumber("status", http_transport->response_status());
+  line.AddNumber("attempts", attempts);
+  if (uploaded) {
+    line.AddString("response", response_body);
+  }
+  line.AddNumber("completed", completed_);
+  line.AddNumber("total", options_->batch_files.size());
+  WriteLineLocked(line);
+  return true;
+}
+
+void BatchUploader::WriteLineLocked(const JSONLine& line) {
+  lock_.AssertAcquired();
+  const std::string string = line.ToString() + "\n";
+  if (!output_->Write(string.data(), string.size())) {
+    output_failed_ = true;
+  }
+}
+
 int HTTPUploadMain(int argc, char* argv[]) {
   const base::FilePath argv0(
       ToolSupport::CommandLineArgumentToFilePathStringType(argv[0]));
@@ -53,7 +400,10 @@ int HTTPUploadMain(int argc, char* argv[]) {
 
   enum OptionFlags {
     // “Short” (single-character) options.
+    kOptionDirectory = 'd',
     kOptionFile = 'f',
+    kOptionJobs = 'j',
+    kOptionManifest = 'm',
     kOptionOutput = 'o',
     kOptionString = 's',
     kOptionURL = 'u',
@@ -61,23 +411,26 @@ int HTTPUploadMain(int argc, char* argv[]) {
     // Long options without short equivalents.
     kOptionLastChar = 255,
     kOptionNoUploadGzip,
+    kOptionRetries,
 
     // Standard options.
     kOptionHelp = -2,
     kOptionVersion = -3,
   };
 
-  struct {
-    std::string url;
-    const char* output;
-    bool upload_gzip;
-  } options = {};
+  Options options = {};
+  options.jobs = kDefaultJobs;
+  options.retries = kDefaultRetries;
   options.upload_gzip = true;
 
   static constexpr option long_options[] = {
+      {"directory", required_argument, nullptr, kOptionDirectory},
       {"file", required_argument, nullptr, kOptionFile},
+      {"jobs", required_argument, nullptr, kOptionJobs},
+      {"manifest", required_argument, nullptr, kOptionManifest},
       {"no-upload-gzip", no_argument, nullptr, kOptionNoUploadGzip},
       {"output", required_argument, nullptr, kOptionOutput},
+      {"retries", required_argument, nullptr, kOptionRetries},
       {"string", required_argument, nullptr, kOptionString},
       {"url", required_argument, nullptr, kOptionURL},
       {"help", no_argument, nullptr, kOptionHelp},
@@ -85,25 +438,52 @@ int HTTPUploadMain(int argc, char* argv[]) {
       {nullptr, 0, nullptr, 0},
   };
 
-  HTTPMultipartBuilder http_multipart_builder;
-
   int opt;
-  while ((opt = getopt_long(argc, argv, "f:o:s:u:", long_options, nullptr)) !=
-         -1) {
+  while ((opt = getopt_long(
+              argc, argv, "d:f:j:m:o:s:u:", long_options, nullptr)) != -1) {
     switch (opt) {
-      case kOptionFile: {
+      case kOptionDirectory:
+      case kOptionManifest: {
         std::string key;
         std::string path;
         if (!SplitStringFirst(optarg, '=', &key, &path)) {
-          ToolSupport::UsageHint(me, "--file requires KEY=STRING");
+          ToolSupport::UsageHint(me,
+                                 opt == kOptionDirectory
+                                     ? "--directory requires KEY=DIR"
+                                     : "--manifest requires KEY=FILE");
           return EXIT_FAILURE;
         }
         base::FilePath file_path(
             ToolSupport::CommandLineArgumentToFilePathStringType(path));
-        std::string file_name(
-            ToolSupport::FilePathToCommandLineArgument(file_path.BaseName()));
-        http_multipart_builder.SetFileAttachment(
-            key, file_name, file_path, "application/octet-stream");
+        std::vector<base::FilePath> paths;
+        if (opt == kOptionDirectory ? !ListDirectory(file_path, &paths)
+                                    : !ReadManifest(file_path, &paths)) {
+          return EXIT_FAILURE;
+        }
+        for (const base::FilePath& batch_path : paths) {
+          options.batch_files.push_back(std::make_pair(key, batch_path));
+        }
+        options.batch = true;
+        break;
+      }
+      case kOptionFile: {
+        std::string key;
+        std::string path;
+        if (!SplitStringFirst(optarg, '=', &key, &path)) {
+          ToolSupport::UsageHint(me, "--file requires KEY=STRING");
+          return EXIT_FAILURE;
+        }
+        options.file_attachments.push_back(std::make_pair(
+            key,
+            base::FilePath(
+                ToolSupport::CommandLineArgumentToFilePathStringType(path))));
+        break;
+      }
+      case kOptionJobs: {
+        if (!StringToNumber(optarg, &options.jobs) || !options.jobs) {
+          ToolSupport::UsageHint(me, "--jobs requires a positive COUNT");
+          return EXIT_FAILURE;
+        }
         break;
       }
       case kOptionNoUploadGzip: {
@@ -114,6 +494,13 @@ int HTTPUploadMain(int argc, char* argv[]) {
         options.output = optarg;
         break;
       }
+      case kOptionRetries: {
+        if (!StringToNumber(optarg, &options.retries)) {
+          ToolSupport::UsageHint(me, "--retries requires a COUNT");
+          return EXIT_FAILURE;
+        }
+        break;
+      }
       case kOptionString: {
         std::string key;
         std::string value;
@@ -121,7 +508,7 @@ int HTTPUploadMain(int argc, char* argv[]) {
           ToolSupport::UsageHint(me, "--string requires KEY=VALUE");
           return EXIT_FAILURE;
         }
-        http_multipart_builder.SetFormData(key, value);
+        options.form_data.push_back(std::make_pair(key, value));
         break;
       }
       case kOptionURL:
@@ -167,18 +554,16 @@ int HTTPUploadMain(int argc, char* argv[]) {
         StdioFileHandle(StdioStream::kStandardOutput)));
   }
 
-  http_multipart_builder.SetGzipEnabled(options.upload_gzip);
-
-  std::unique_ptr<HTTPTransport> http_transport(HTTPTransport::Create());
-  http_transport->SetURL(options.url);
-
-  HTTPHeaders content_headers;
-  http_multipart_builder.PopulateContentHeaders(&content_headers);
-  for (const auto& content_header : content_headers) {
-    http_transport->SetHeader(content_header.first, content_header.second);
+  if (options.batch) {
+    BatchUploader batch_uploader(&options, file_writer.get());
+    return batch_uploader.Run() ? EXIT_SUCCESS : EXIT_FAILURE;
   }
 
-  http_transport->SetBodyStream(http_multipart_builder.GetBodyStream());
+  HTTPMultipartBuilder http_multipart_builder;
+  PopulateMultipartBuilder(options, &http_multipart_builder);
+
+  std::unique_ptr<HTTPTransport> http_transport(HTTPTransport::Create());
+  PrepareTransport(options.url, &http_multipart_builder, http_transport.get());
 
   std::string response_body;
   if (!http_transport->ExecuteSynchronously(&response_body)) {
@@ -13,21 +13,35 @@
 // limitations under the License.
 
 #include <getopt.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
 #include "build/build_config.h"
+#include "minidump/minidump_extensions.h"
 #include "minidump/minidump_file_writer.h"
 #include "tools/tool_support.h"
+#include "util/file/block_compressed_file_writer.h"
+#include "util/file/chunked_buffer_file.h"
 #include "util/file/file_writer.h"
+#include "util/misc/memory_read_trace.h"
 #include "util/posix/drop_privileges.h"
 #include "util/stdlib/string_number_conversion.h"
+#include "util/string/split_string.h"
+#include "util/thread/thread.h"
 
 #if defined(OS_MACOSX)
 #include <mach/mach.h>
@@ -42,20 +56,427 @@
 #include "snapshot/win/process_snapshot_win.h"
 #include "util/win/scoped_process_suspend.h"
 #include "util/win/xp_compat.h"
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+#include <unistd.h>
+
+#include "snapshot/linux/build_id_cache.h"
+#include "snapshot/linux/process_snapshot_linux.h"
+#include "util/linux/direct_ptrace_connection.h"
+#include "util/linux/process_recording.h"
+#include "util/linux/recording_ptrace_connection.h"
 #endif  // OS_MACOSX
 
 namespace crashpad {
 namespace {
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+constexpr size_t kBuildIDCacheSize = 1024;
+#endif  // OS_LINUX || OS_ANDROID
+
+enum class SuspendMode {
+  // The target process is suspended until the minidump file has been written.
+  kFull,
+
+  // The target process is suspended only while it is captured and the
+  // minidump is serialized in memory, and resumes before the minidump file is
+  // compressed and written.
+  kMinimal,
+
+  // The target process is not suspended.
+  kNone,
+};
+
+struct StreamName {
+  const char* name;
+  MinidumpStreamType stream_type;
+};
+
+constexpr StreamName kStreamNames[] = {
+    {"system_info", kMinidumpStreamTypeSystemInfo},
+    {"misc_info", kMinidumpStreamTypeMiscInfo},
+    {"threads", kMinidumpStreamTypeThreadList},
+    {"thread_names", kMinidumpStreamTypeThreadNameList},
+    {"thread_annotations", kMinidumpStreamTypeCrashpadThreadAnnotations},
+    {"exception", kMinidumpStreamTypeException},
+    {"modules", kMinidumpStreamTypeModuleList},
+    {"unloaded_modules", kMinidumpStreamTypeUnloadedModuleList},
+    {"crashpad_info", kMinidumpStreamTypeCrashpadInfo},
+    {"memory_info", kMinidumpStreamTypeMemoryInfoList},
+    {"handles", kMinidumpStreamTypeHandleData},
+    {"memory", kMinidumpStreamTypeMemoryList},
+};
+
+// Parses a comma-separated list of names from kStreamNames into
+// |stream_types|.
+bool ParseStreamList(const std::string& list,
+                     std::set<MinidumpStreamType>* stream_types) {
+  stream_types->clear();
+  for (const std::string& name : SplitString(list, ',')) {
+    bool found = false;
+    for (const StreamName& stream_name : kStreamNames) {
+      if (name == stream_name.name) {
+        stream_types->insert(stream_name.stream_type);
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return !stream_types->empty();
+}
+
+bool OpenDumpFile(const std::string& dump_path, FileWriter* file_writer) {
+  return file_writer->Open(
+      base::FilePath(
+          ToolSupport::CommandLineArgumentToFilePathStringType(dump_path)),
+      FileWriteMode::kTruncateOrCreate,
+      FilePermissions::kWorldReadable);
+}
+
+// Removes a minidump file that couldn’t be written completely.
+void RemoveDumpFile(const std::string& dump_path, FileWriter* file_writer) {
+  file_writer->Close();
+  if (unlink(dump_path.c_str()) != 0) {
+    PLOG(ERROR) << "unlink";
+  }
+}
+
+// Writes |minidump| to |file_writer|, compressing it if |compress| is true.
+bool WriteDumpFile(MinidumpFileWriter* minidump,
+                   FileWriter* file_writer,
+                   bool compress) {
+  if (!compress) {
+    return minidump->WriteEverything(file_writer);
+  }
+
+  // The compressed writer can’t seek back to finish the header, so write the
+  // minidump in a single forward pass.
+  BlockCompressedFileWriter compressed_file_writer(
+      file_writer, BlockCompressedFileWriter::kDefaultBlockSize);
+  return minidump->WriteMinidump(&compressed_file_writer, false) &&
+         compressed_file_writer.Close();
+}
+
+// Writes |buffers|, a minidump already serialized in memory, to
+// |file_writer|, compressing it if |compress| is true.
+bool WriteDumpFile(const std::vector<ChunkedBufferFile::Buffer>& buffers,
+                   FileWriter* file_writer,
+                   bool compress) {
+  std::unique_ptr<BlockCompressedFileWriter> compressed_file_writer;
+  FileWriterInterface* writer = file_writer;
+  if (compress) {
+    compressed_file_writer.reset(new BlockCompressedFileWriter(
+        file_writer, BlockCompressedFileWriter::kDefaultBlockSize));
+    writer = compressed_file_writer.get();
+  }
+
+  for (const ChunkedBufferFile::Buffer& buffer : buffers) {
+    if (!writer->Write(buffer.data(), buffer.size())) {
+      return false;
+    }
+  }
+
+  return !compressed_file_writer || compressed_file_writer->Close();
+}
+
+struct Options {
+  std::string dump_path;
+  std::set<MinidumpStreamType> stream_types;
+  uint64_t stack_size;
+  unsigned int jobs;
+  bool collapse_stacks;
+  bool stream_index;
+  bool trace_reads;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  std::string record_path;
+#endif  // OS_LINUX || OS_ANDROID
+  SuspendMode suspend_mode;
+  bool compress;
+};
+
+// A process to snapshot, opened before any privileges are dropped.
+struct Target {
+  Target() : dump_path(), pid(0), success(false) {}
+
+  std::string dump_path;
+#if defined(OS_MACOSX)
+  base::mac::ScopedMachSendRight task;
+#elif defined(OS_WIN)
+  ScopedKernelHANDLE process;
+#endif  // OS_MACOSX
+  pid_t pid;
+  bool success;
+};
+
+// Snapshots a batch of processes, several at a time. Caches that outlive any
+// one snapshot are shared by all of them.
+class DumpBatch {
+ public:
+  DumpBatch(const Options& options,
+            std::vector<std::unique_ptr<Target>>* targets)
+      : lock_(),
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+        build_id_cache_(kBuildIDCacheSize),
+        recording_(),
+#endif  // OS_LINUX || OS_ANDROID
+        options_(options),
+        targets_(targets),
+        next_target_(0) {}
+
+  // Snapshots every target using up to |jobs| threads, setting each target’s
+  // success. Returns true if every target was snapshotted.
+  bool Run(size_t jobs) {
+    jobs = std::min(jobs, targets_->size());
+    if (jobs <= 1) {
+      DumpTargets();
+    } else {
+      std::vector<std::unique_ptr<DumpThread>> threads;
+      for (size_t index = 0; index < jobs; ++index) {
+        threads.push_back(base::WrapUnique(new DumpThread(this)));
+        threads.back()->Start();
+      }
+      for (const auto& thread : threads) {
+        thread->Join();
+      }
+    }
+
+    bool success = true;
+    for (const auto& target : *targets_) {
+      success &= target->success;
+    }
+    return success;
+  }
+
+ private:
+  class DumpThread : public Thread {
+   public:
+    explicit DumpThread(DumpBatch* batch) : Thread(), batch_(batch) {}
+    ~DumpThread() override {}
+
+   private:
+    void ThreadMain() override { batch_->DumpTargets(); }
+
+    DumpBatch* batch_;  // weak
+
+    DISALLOW_COPY_AND_ASSIGN(DumpThread);
+  };
+
+  // Snapshots targets until none remain.
+  void DumpTargets() {
+    while (true) {
+      Target* target;
+      {
+        base::AutoLock lock(lock_);
+        if (next_target_ == targets_->size()) {
+          return;
+        }
+        target = (*targets_)[next_target_++].get();
+      }
+      if (options_.trace_reads) {
+        MemoryReadTrace trace;
+        {
+          ScopedMemoryReadTrace installed_trace(&trace);
+          target->success = GenerateDump(target, &trace);
+        }
+        PrintMemoryReads(target->pid, trace);
+      } else {
+        target->success = GenerateDump(target, nullptr);
+      }
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+      if (target->success && !options_.record_path.empty()) {
+        target->success =
+            recording_.Save(base::FilePath(options_.record_path));
+      }
+#endif  // OS_LINUX || OS_ANDROID
+      if (!target->success && targets_->size() > 1) {
+        LOG(ERROR) << "could not snapshot process " << target->pid;
+      }
+    }
+  }
+
+  // Snapshots |target|. If |trace| is not nullptr, the reads it counts are
+  // recorded in the minidump’s capture performance stream.
+  bool GenerateDump(Target* target, const MemoryReadTrace* trace);
+
+  // Prints a summary of the reads of |pid|’s memory counted by |trace|.
+  static void PrintMemoryReads(pid_t pid, const MemoryReadTrace& trace);
+
+  base::Lock lock_;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  BuildIDCache build_id_cache_;
+
+  // What was read from the target for --record, which allows a single PID.
+  ProcessRecording recording_;
+#endif  // OS_LINUX || OS_ANDROID
+  const Options& options_;
+  std::vector<std::unique_ptr<Target>>* targets_;  // weak
+
+  // Guarded by lock_.
+  size_t next_target_;
+
+  DISALLOW_COPY_AND_ASSIGN(DumpBatch);
+};
+
+bool DumpBatch::GenerateDump(Target* target, const MemoryReadTrace* trace) {
+  const bool suspend = options_.suspend_mode != SuspendMode::kNone;
+
+  FileWriter file_writer;
+  ChunkedBufferFile minidump_data;
+  {
+#if defined(OS_MACOSX)
+    std::unique_ptr<ScopedTaskSuspend> task_suspend;
+    if (suspend) {
+      task_suspend.reset(new ScopedTaskSuspend(target->task.get()));
+    }
+#elif defined(OS_WIN)
+    std::unique_ptr<ScopedProcessSuspend> process_suspend;
+    if (suspend) {
+      process_suspend.reset(new ScopedProcessSuspend(target->process.get()));
+    }
+#endif  // OS_MACOSX
+
+#if defined(OS_MACOSX)
+    ProcessSnapshotMac process_snapshot;
+    if (!process_snapshot.Initialize(target->task.get())) {
+      return false;
+    }
+#elif defined(OS_WIN)
+    ProcessSnapshotWin process_snapshot;
+    if (!process_snapshot.Initialize(target->process.get(),
+                                     suspend
+                                         ? ProcessSuspensionState::kSuspended
+                                         : ProcessSuspensionState::kRunning,
+                                     0,
+                                     0)) {
+      return false;
+    }
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+    // The process’ threads are stopped as they are attached, and remain stopped
+    // until the connection is destroyed after the minidump has been written,
+    // or after it has been serialized with --suspend=minimal.
+    DirectPtraceConnection connection;
+    if (!connection.Initialize(target->pid)) {
+      return false;
+    }
+
+    // With --record, the snapshot reads through a connection that records the
+    // threads’ information, and the memory it reads is recorded too.
+    std::unique_ptr<RecordingPtraceConnection> recording_connection;
+    PtraceConnection* snapshot_connection = &connection;
+    ProcessSnapshotLinux process_snapshot;
+    process_snapshot.SetBuildIDCache(&build_id_cache_);
+    if (!options_.record_path.empty()) {
+      recording_connection.reset(
+          new RecordingPtraceConnection(&connection, &recording_));
+      snapshot_connection = recording_connection.get();
+      process_snapshot.SetRecording(&recording_);
+    }
+    if (!process_snapshot.Initialize(snapshot_connection)) {
+      return false;
+    }
+#endif  // OS_MACOSX
+
+    MinidumpFileWriter minidump;
+    minidump.SetStreamSelection(options_.stream_types);
+    minidump.SetStackSizeLimit(
+        base::saturated_cast<size_t>(options_.stack_size));
+    minidump.SetCollapseIdenticalStacks(options_.collapse_stacks);
+    minidump.SetWriteStreamIndex(options_.stream_index);
+    if (trace) {
+      // No phase times are measured, but the stream carries the reads.
+      minidump.SetCapturePhaseTimes(MinidumpCapturePhaseTimes());
+      minidump.SetMemoryReadTrace(trace);
+    }
+    minidump.InitializeFromSnapshot(&process_snapshot);
+
+    if (options_.suspend_mode == SuspendMode::kMinimal) {
+      // Memory is read from the target process as the minidump is serialized,
+      // so serialize it here, and leave compressing and writing the file until
+      // the target process has resumed as this scope is left.
+      if (!minidump.WriteMinidumpToMemory(&minidump_data)) {
+        return false;
+      }
+    } else {
+      if (!OpenDumpFile(target->dump_path, &file_writer)) {
+        return false;
+      }
+      if (!WriteDumpFile(&minidump, &file_writer, options_.compress)) {
+        RemoveDumpFile(target->dump_path, &file_writer);
+        return false;
+      }
+      return true;
+    }
+  }
+
+  if (!OpenDumpFile(target->dump_path, &file_writer)) {
+    return false;
+  }
+  if (!WriteDumpFile(
+          minidump_data.buffers(), &file_writer, options_.compress)) {
+    RemoveDumpFile(target->dump_path, &file_writer);
+    return false;
+  }
+
+  return true;
+}
+
+// static
+void DumpBatch::PrintMemoryReads(pid_t pid, const MemoryReadTrace& trace) {
+  static constexpr const char* kSiteNames[] = {
+      "other",
+      "modules",
+      "annotations",
+      "stacks",
+      "indirect memory",
+      "process data",
+  };
+  static_assert(arraysize(kSiteNames) ==
+                    static_cast<size_t>(MemoryReadSite::kCount),
+                "site names mismatch");
+
+  fprintf(stderr, "memory reads from process %d:\n", static_cast<int>(pid));
+  for (size_t index = 0; index < arraysize(kSiteNames); ++index) {
+    const MemoryReadTrace::Counts counts =
+        trace.CountsForSite(static_cast<MemoryReadSite>(index));
+    fprintf(stderr,
+            "  %-16s %8" PRIu64 " calls %12" PRIu64 " bytes %10.3f ms\n",
+            kSiteNames[index],
+            counts.calls,
+            counts.bytes,
+            counts.nanoseconds / 1E6);
+  }
+}
+
 void Usage(const base::FilePath& me) {
   fprintf(stderr,
-"Usage: %" PRFilePath " [OPTION]... PID\n"
-"Generate a minidump file containing a snapshot of a running process.\n"
+"Usage: %" PRFilePath " [OPTION]... PID...\n"
+"Generate a minidump file containing a snapshot of each running process.\n"
 "\n"
-"  -r, --no-suspend   don't suspend the target process during dump generation\n"
-"  -o, --output=FILE  write the minidump to FILE instead of minidump.PID\n"
-"      --help         display this help and exit\n"
-"      --version      output version information and exit\n",
+"      --suspend=MODE    suspend the target process fully (the default), only\n"
+"                        while it is captured (minimal), or not at all (none)\n"
+"  -r, --no-suspend      same as --suspend=none\n"
+"  -o, --output=FILE     write the minidump to FILE instead of minidump.PID,\n"
+"                        with a single PID\n"
+"  -j, --jobs=N          snapshot up to N processes at a time\n"
+"  -z, --compress        compress the minidump in blocks as it is written\n"
+"      --streams=LIST    write only the comma-separated streams in LIST, from\n"
+"                        system_info, misc_info, threads, thread_names,\n"
+"                        thread_annotations, exception, modules,\n"
+"                        unloaded_modules, crashpad_info, memory_info,\n"
+"                        handles, and memory\n"
+"      --stack-size=SIZE write at most SIZE bytes of each thread's stack\n"
+"      --collapse-stacks write the contents of identical thread stacks once\n"
+"      --stream-index    end the minidump with an index of its streams\n"
+"      --trace-reads     count the reads of each process' memory, and print a\n"
+"                        summary\n"
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+"      --record=FILE     save the thread contexts and memory read from the\n"
+"                        process to FILE, with a single PID\n"
+#endif  // OS_LINUX || OS_ANDROID
+"      --help            display this help and exit\n"
+"      --version         output version information and exit\n",
           me.value().c_str());
   ToolSupport::UsageTail(me);
 }
@@ -67,41 +488,112 @@ int GenerateDumpMain(int argc, char* argv[]) {
 
   enum OptionFlags {
     // “Short” (single-character) options.
+    kOptionJobs = 'j',
     kOptionOutput = 'o',
     kOptionNoSuspend = 'r',
+    kOptionCompress = 'z',
 
     // Long options without short equivalents.
     kOptionLastChar = 255,
+    kOptionSuspend,
+    kOptionStreams,
+    kOptionStackSize,
+    kOptionCollapseStacks,
+    kOptionStreamIndex,
+    kOptionTraceReads,
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    kOptionRecord,
+#endif  // OS_LINUX || OS_ANDROID
 
     // Standard options.
     kOptionHelp = -2,
     kOptionVersion = -3,
   };
 
-  struct {
-    std::string dump_path;
-    pid_t pid;
-    bool suspend;
-  } options = {};
-  options.suspend = true;
+  Options options = {};
+  options.jobs = 1;
+  options.suspend_mode = SuspendMode::kFull;
 
   static constexpr option long_options[] = {
+      {"suspend", required_argument, nullptr, kOptionSuspend},
       {"no-suspend", no_argument, nullptr, kOptionNoSuspend},
       {"output", required_argument, nullptr, kOptionOutput},
+      {"jobs", required_argument, nullptr, kOptionJobs},
+      {"compress", no_argument, nullptr, kOptionCompress},
+      {"streams", required_argument, nullptr, kOptionStreams},
+      {"stack-size", required_argument, nullptr, kOptionStackSize},
+      {"collapse-stacks", no_argument, nullptr, kOptionCollapseStacks},
+      {"stream-index", no_argument, nullptr, kOptionStreamIndex},
+      {"trace-reads", no_argument, nullptr, kOptionTraceReads},
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+      {"record", required_argument, nullptr, kOptionRecord},
+#endif  // OS_LINUX || OS_ANDROID
       {"help", no_argument, nullptr, kOptionHelp},
       {"version", no_argument, nullptr, kOptionVersion},
       {nullptr, 0, nullptr, 0},
   };
 
   int opt;
-  while ((opt = getopt_long(argc, argv, "o:r", long_options, nullptr)) != -1) {
+  while ((opt = getopt_long(argc, argv, "j:o:rz", long_options, nullptr)) !=
+         -1) {
     switch (opt) {
       case kOptionOutput:
         options.dump_path = optarg;
         break;
+      case kOptionJobs:
+        if (!StringToNumber(optarg, &options.jobs) || options.jobs == 0) {
+          ToolSupport::UsageHint(me, "--jobs requires a positive N");
+          return EXIT_FAILURE;
+        }
+        break;
+      case kOptionSuspend: {
+        std::string mode(optarg);
+        if (mode == "full") {
+          options.suspend_mode = SuspendMode::kFull;
+        } else if (mode == "minimal") {
+          options.suspend_mode = SuspendMode::kMinimal;
+        } else if (mode == "none") {
+          options.suspend_mode = SuspendMode::kNone;
+        } else {
+          ToolSupport::UsageHint(me,
+                                 "--suspend requires full, minimal, or none");
+          return EXIT_FAILURE;
+        }
+        break;
+      }
       case kOptionNoSuspend:
-        options.suspend = false;
+        options.suspend_mode = SuspendMode::kNone;
+        break;
+      case kOptionCompress:
+        options.compress = true;
+        break;
+      case kOptionStreams:
+        if (!ParseStreamList(optarg, &options.stream_types)) {
+          ToolSupport::UsageHint(me, "--streams requires a list of streams");
+          return EXIT_FAILURE;
+        }
+        break;
+      case kOptionStackSize:
+        if (!StringToNumber(optarg, &options.stack_size) ||
+            options.stack_size == 0) {
+          ToolSupport::UsageHint(me, "--stack-size requires a positive SIZE");
+          return EXIT_FAILURE;
+        }
+        break;
+      case kOptionCollapseStacks:
+        options.collapse_stacks = true;
         break;
+      case kOptionStreamIndex:
+        options.stream_index = true;
+        break;
+      case kOptionTraceReads:
+        options.trace_reads = true;
+        break;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+      case kOptionRecord:
+        options.record_path = optarg;
+        break;
+#endif  // OS_LINUX || OS_ANDROID
       case kOptionHelp:
         Usage(me);
         return EXIT_SUCCESS;
@@ -116,102 +608,91 @@ int GenerateDumpMain(int argc, char* argv[]) {
   argc -= optind;
   argv += optind;
 
-  if (argc != 1) {
+  if (argc < 1) {
     ToolSupport::UsageHint(me, "PID is required");
     return EXIT_FAILURE;
   }
 
-  if (!StringToNumber(argv[0], &options.pid) || options.pid <= 0) {
-    fprintf(stderr,
-            "%" PRFilePath ": invalid PID: %s\n",
-            me.value().c_str(),
-            argv[0]);
+  if (argc > 1 && !options.dump_path.empty()) {
+    ToolSupport::UsageHint(me, "--output requires a single PID");
     return EXIT_FAILURE;
   }
 
-#if defined(OS_MACOSX)
-  task_t task = TaskForPID(options.pid);
-  if (task == TASK_NULL) {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  if (argc > 1 && !options.record_path.empty()) {
+    ToolSupport::UsageHint(me, "--record requires a single PID");
     return EXIT_FAILURE;
   }
-  base::mac::ScopedMachSendRight task_owner(task);
+#endif  // OS_LINUX || OS_ANDROID
 
-  // This tool may have been installed as a setuid binary so that TaskForPID()
-  // could succeed. Drop any privileges now that they’re no longer necessary.
-  DropPrivileges();
+  // A trace counts the reads made by every thread, so only one process may be
+  // snapshotted at a time.
+  if (options.trace_reads && options.jobs > 1) {
+    ToolSupport::UsageHint(me, "--trace-reads cannot be used with --jobs");
+    return EXIT_FAILURE;
+  }
 
-  if (options.pid == getpid()) {
-    if (options.suspend) {
-      LOG(ERROR) << "cannot suspend myself";
+  std::vector<std::unique_ptr<Target>> targets;
+  for (int index = 0; index < argc; ++index) {
+    auto target = base::WrapUnique(new Target());
+    if (!StringToNumber(argv[index], &target->pid) || target->pid <= 0) {
+      fprintf(stderr,
+              "%" PRFilePath ": invalid PID: %s\n",
+              me.value().c_str(),
+              argv[index]);
       return EXIT_FAILURE;
     }
-    LOG(WARNING) << "operating on myself";
+    target->dump_path =
+        options.dump_path.empty()
+            ? base::StringPrintf("minidump.%d", target->pid)
+            : options.dump_path;
+    targets.push_back(std::move(target));
   }
-#elif defined(OS_WIN)
-  ScopedKernelHANDLE process(
-      OpenProcess(kXPProcessAllAccess, false, options.pid));
-  if (!process.is_valid()) {
-    PLOG(ERROR) << "could not open process " << options.pid;
-    return EXIT_FAILURE;
-  }
-#endif  // OS_MACOSX
 
-  if (options.dump_path.empty()) {
-    options.dump_path = base::StringPrintf("minidump.%d", options.pid);
-  }
+  const bool suspend = options.suspend_mode != SuspendMode::kNone;
 
-  {
+  for (const auto& target : targets) {
 #if defined(OS_MACOSX)
-    std::unique_ptr<ScopedTaskSuspend> suspend;
-    if (options.suspend) {
-      suspend.reset(new ScopedTaskSuspend(task));
-    }
-#elif defined(OS_WIN)
-    std::unique_ptr<ScopedProcessSuspend> suspend;
-    if (options.suspend) {
-      suspend.reset(new ScopedProcessSuspend(process.get()));
+    task_t task = TaskForPID(target->pid);
+    if (task == TASK_NULL) {
+      return EXIT_FAILURE;
     }
-#endif  // OS_MACOSX
+    target->task.reset(task);
 
-#if defined(OS_MACOSX)
-    ProcessSnapshotMac process_snapshot;
-    if (!process_snapshot.Initialize(task)) {
-      return EXIT_FAILURE;
+    if (target->pid == getpid()) {
+      if (suspend) {
+        LOG(ERROR) << "cannot suspend myself";
+        return EXIT_FAILURE;
+      }
+      LOG(WARNING) << "operating on myself";
     }
 #elif defined(OS_WIN)
-    ProcessSnapshotWin process_snapshot;
-    if (!process_snapshot.Initialize(process.get(),
-                                     options.suspend
-                                         ? ProcessSuspensionState::kSuspended
-                                         : ProcessSuspensionState::kRunning,
-                                     0,
-                                     0)) {
+    target->process.reset(
+        OpenProcess(kXPProcessAllAccess, false, target->pid));
+    if (!target->process.is_valid()) {
+      PLOG(ERROR) << "could not open process " << target->pid;
       return EXIT_FAILURE;
     }
-#endif  // OS_MACOSX
-
-    FileWriter file_writer;
-    base::FilePath dump_path(
-        ToolSupport::CommandLineArgumentToFilePathStringType(
-            options.dump_path));
-    if (!file_writer.Open(dump_path,
-                          FileWriteMode::kTruncateOrCreate,
-                          FilePermissions::kWorldReadable)) {
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+    if (target->pid == getpid()) {
+      LOG(ERROR) << "cannot ptrace myself";
       return EXIT_FAILURE;
     }
+#endif  // OS_MACOSX
+  }
 
-    MinidumpFileWriter minidump;
-    minidump.InitializeFromSnapshot(&process_snapshot);
-    if (!minidump.WriteEverything(&file_writer)) {
-      file_writer.Close();
-      if (unlink(options.dump_path.c_str()) != 0) {
-        PLOG(ERROR) << "unlink";
-      }
-      return EXIT_FAILURE;
-    }
+#if defined(OS_MACOSX)
+  // This tool may have been installed as a setuid binary so that TaskForPID()
+  // could succeed. Drop any privileges now that they’re no longer necessary.
+  DropPrivileges();
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+  if (!suspend) {
+    LOG(WARNING) << "ptrace stops the target process, ignoring --suspend=none";
   }
+#endif  // OS_MACOSX
 
-  return EXIT_SUCCESS;
+  DumpBatch batch(options, &targets);
+  return batch.Run(options.jobs) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 }  // namespace
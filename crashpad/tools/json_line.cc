@@ -0,0 +1,69 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/json_line.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "base/strings/stringprintf.h"
+
+namespace crashpad {
+
+JSONLine::JSONLine() : line_("{") {}
+
+JSONLine::~JSONLine() {}
+
+void JSONLine::AddString(const char* key, const std::string& value) {
+  AddKey(key);
+  line_.push_back('"');
+  for (unsigned char c : value) {
+    if (c == '"' || c == '\\') {
+      line_.push_back('\\');
+      line_.push_back(c);
+    } else if (c < 0x20) {
+      line_.append(base::StringPrintf("\\u%04x", c));
+    } else {
+      line_.push_back(c);
+    }
+  }
+  line_.push_back('"');
+}
+
+void JSONLine::AddNumber(const char* key, int64_t value) {
+  AddKey(key);
+  line_.append(base::StringPrintf("%" PRId64, value));
+}
+
+void JSONLine::AddBool(const char* key, bool value) {
+  AddKey(key);
+  line_.append(value ? "true" : "false");
+}
+
+std::string JSONLine::ToString() const {
+  return line_ + "}";
+}
+
+void JSONLine::Print() const {
+  printf("%s\n", ToString().c_str());
+}
+
+void JSONLine::AddKey(const char* key) {
+  if (line_.size() > 1) {
+    line_.push_back(',');
+  }
+  line_.append(base::StringPrintf("\"%s\":", key));
+}
+
+}  // namespace crashpad
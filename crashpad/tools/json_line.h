@@ -0,0 +1,60 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_TOOLS_JSON_LINE_H_
+#define CRASHPAD_TOOLS_JSON_LINE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "base/macros.h"
+
+namespace crashpad {
+
+//! \brief Builds a JSON object, to be printed on a single line.
+//!
+//! Command line tools use this to write output meant to be read by other
+//! programs, one object per line.
+class JSONLine {
+ public:
+  JSONLine();
+  ~JSONLine();
+
+  //! \brief Adds a member whose value is \a value, as a string.
+  void AddString(const char* key, const std::string& value);
+
+  //! \brief Adds a member whose value is \a value, as a number.
+  void AddNumber(const char* key, int64_t value);
+
+  //! \brief Adds a member whose value is \a value, as `true` or `false`.
+  void AddBool(const char* key, bool value);
+
+  //! \brief Returns the object as it stands, without a trailing newline.
+  std::string ToString() const;
+
+  //! \brief Prints the object to standard output, followed by a newline.
+  void Print() const;
+
+ private:
+  void AddKey(const char* key);
+
+  std::string line_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONLine);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_TOOLS_JSON_LINE_H_
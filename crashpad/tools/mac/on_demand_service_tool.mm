@@ -12,10 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <CoreFoundation/CoreFoundation.h>
-#import <Foundation/Foundation.h>
 #include <getopt.h>
-#include <launch.h>
 #include <libgen.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,11 +21,8 @@
 #include <string>
 #include <vector>
 
-#include "base/mac/foundation_util.h"
-#include "base/strings/sys_string_conversions.h"
 #include "tools/tool_support.h"
 #include "util/mac/service_management.h"
-#include "util/stdlib/objc.h"
 
 namespace crashpad {
 namespace {
@@ -133,41 +127,11 @@ int OnDemandServiceToolMain(int argc, char* argv[]) {
         return EXIT_FAILURE;
       }
 
-      @autoreleasepool {
-        NSString* job_label = base::SysUTF8ToNSString(options.job_label);
-
-        NSMutableArray* command = [NSMutableArray arrayWithCapacity:argc];
-        for (int index = 0; index < argc; ++index) {
-          NSString* argument = base::SysUTF8ToNSString(argv[index]);
-          [command addObject:argument];
-        }
-
-        NSDictionary* job_dictionary = @{
-          @LAUNCH_JOBKEY_LABEL : job_label,
-          @LAUNCH_JOBKEY_PROGRAMARGUMENTS : command,
-        };
-
-        if (!options.mach_services.empty()) {
-          NSMutableDictionary* mach_services = [NSMutableDictionary
-              dictionaryWithCapacity:options.mach_services.size()];
-          for (std::string mach_service : options.mach_services) {
-            NSString* mach_service_ns = base::SysUTF8ToNSString(mach_service);
-            [mach_services setObject:@YES forKey:mach_service_ns];
-          }
-
-          NSMutableDictionary* mutable_job_dictionary =
-              [[job_dictionary mutableCopy] autorelease];
-          [mutable_job_dictionary setObject:mach_services
-                                     forKey:@LAUNCH_JOBKEY_MACHSERVICES];
-          job_dictionary = mutable_job_dictionary;
-        }
-
-        CFDictionaryRef job_dictionary_cf =
-            base::mac::NSToCFCast(job_dictionary);
-        if (!ServiceManagementSubmitJob(job_dictionary_cf)) {
-          fprintf(stderr, "%s: failed to submit job\n", me.c_str());
-          return EXIT_FAILURE;
-        }
+      const std::vector<std::string> command(argv, argv + argc);
+      if (!ServiceManagementSubmitOnDemandJob(
+              options.job_label, command, options.mach_services)) {
+        fprintf(stderr, "%s: failed to submit job\n", me.c_str());
+        return EXIT_FAILURE;
       }
 
       return EXIT_SUCCESS;
@@ -27,6 +27,8 @@
         '..',
       ],
       'sources': [
+        'json_line.cc',
+        'json_line.h',
         'tool_support.cc',
         'tool_support.h',
       ],
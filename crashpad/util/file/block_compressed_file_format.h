@@ -0,0 +1,69 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_BLOCK_COMPRESSED_FILE_FORMAT_H_
+#define CRASHPAD_UTIL_FILE_BLOCK_COMPRESSED_FILE_FORMAT_H_
+
+#include <stdint.h>
+
+namespace crashpad {
+namespace internal {
+
+// A block-compressed file consists of a BlockCompressedFileHeader, followed by
+// any number of blocks, each a BlockCompressedFileBlockHeader followed by the
+// block’s data, followed by an index of uint64_t offsets of each block header
+// relative to the start of the file, followed by a
+// BlockCompressedFileTrailer. All values are stored in native byte order.
+//
+// Every block but the last holds BlockCompressedFileHeader::block_size bytes of
+// uncompressed data. A block whose compressed_size equals its
+// uncompressed_size is stored without compression. Otherwise, it is a zlib
+// stream as produced by compress2().
+
+//! \brief The signature in BlockCompressedFileHeader::signature, “CPzB”.
+constexpr uint32_t kBlockCompressedFileSignature = 0x427a5043;
+
+//! \brief The signature in BlockCompressedFileTrailer::signature, “CPzE”.
+constexpr uint32_t kBlockCompressedFileTrailerSignature = 0x457a5043;
+
+//! \brief The current version of the block-compressed file format.
+constexpr uint32_t kBlockCompressedFileVersion = 1;
+
+struct BlockCompressedFileHeader {
+  uint32_t signature;
+  uint32_t version;
+  uint32_t block_size;
+  uint32_t reserved;
+};
+static_assert(sizeof(BlockCompressedFileHeader) == 16, "header size");
+
+struct BlockCompressedFileBlockHeader {
+  uint32_t compressed_size;
+  uint32_t uncompressed_size;
+};
+static_assert(sizeof(BlockCompressedFileBlockHeader) == 8,
+              "block header size");
+
+struct BlockCompressedFileTrailer {
+  uint64_t index_offset;
+  uint64_t uncompressed_size;
+  uint32_t block_count;
+  uint32_t signature;
+};
+static_assert(sizeof(BlockCompressedFileTrailer) == 24, "trailer size");
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_BLOCK_COMPRESSED_FILE_FORMAT_H_
@@ -0,0 +1,275 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/block_compressed_file_reader.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
+#include "third_party/zlib/zlib_crashpad.h"
+#include "util/file/block_compressed_file_format.h"
+#include "util/misc/zlib.h"
+
+namespace crashpad {
+
+BlockCompressedFileReader::BlockCompressedFileReader()
+    : block_offsets_(),
+      block_(),
+      compressed_block_(),
+      file_reader_(nullptr),
+      start_offset_(0),
+      uncompressed_size_(0),
+      offset_(0),
+      block_size_(0),
+      block_index_(std::numeric_limits<size_t>::max()),
+      block_compressed_(false),
+      initialized_() {
+}
+
+BlockCompressedFileReader::~BlockCompressedFileReader() {
+}
+
+// static
+bool BlockCompressedFileReader::IsBlockCompressedFile(
+    FileReaderInterface* file_reader) {
+  FileOffset start_offset = file_reader->SeekGet();
+  if (start_offset < 0) {
+    return false;
+  }
+
+  uint32_t signature;
+  FileOperationResult rv = file_reader->Read(&signature, sizeof(signature));
+  if (!file_reader->SeekSet(start_offset)) {
+    return false;
+  }
+
+  return rv == sizeof(signature) &&
+         signature == internal::kBlockCompressedFileSignature;
+}
+
+bool BlockCompressedFileReader::Initialize(FileReaderInterface* file_reader) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  file_reader_ = file_reader;
+
+  start_offset_ = file_reader_->SeekGet();
+  if (start_offset_ < 0) {
+    return false;
+  }
+
+  internal::BlockCompressedFileHeader header;
+  if (!file_reader_->ReadExactly(&header, sizeof(header))) {
+    return false;
+  }
+
+  if (header.signature != internal::kBlockCompressedFileSignature) {
+    LOG(ERROR) << "header signature mismatch";
+    return false;
+  }
+
+  if (header.version != internal::kBlockCompressedFileVersion) {
+    LOG(ERROR) << "header version mismatch";
+    return false;
+  }
+
+  if (header.block_size == 0) {
+    LOG(ERROR) << "invalid block size";
+    return false;
+  }
+  block_size_ = header.block_size;
+
+  FileOffset end_offset = file_reader_->Seek(0, SEEK_END);
+  if (end_offset < 0) {
+    return false;
+  }
+
+  internal::BlockCompressedFileTrailer trailer;
+  if (end_offset - start_offset_ <
+          static_cast<FileOffset>(sizeof(header) + sizeof(trailer)) ||
+      !file_reader_->SeekSet(end_offset - sizeof(trailer)) ||
+      !file_reader_->ReadExactly(&trailer, sizeof(trailer))) {
+    LOG(ERROR) << "no trailer";
+    return false;
+  }
+
+  if (trailer.signature != internal::kBlockCompressedFileTrailerSignature) {
+    LOG(ERROR) << "trailer signature mismatch";
+    return false;
+  }
+
+  if (trailer.uncompressed_size >
+          static_cast<uint64_t>(trailer.block_count) * block_size_ ||
+      (trailer.block_count > 0 &&
+       trailer.uncompressed_size <=
+           static_cast<uint64_t>(trailer.block_count - 1) * block_size_)) {
+    LOG(ERROR) << "inconsistent trailer";
+    return false;
+  }
+  uncompressed_size_ = trailer.uncompressed_size;
+
+  if (!base::IsValueInRangeForNumericType<FileOffset>(trailer.index_offset) ||
+      trailer.index_offset + trailer.block_count * sizeof(uint64_t) +
+              sizeof(trailer) !=
+          static_cast<uint64_t>(end_offset - start_offset_)) {
+    LOG(ERROR) << "invalid index";
+    return false;
+  }
+
+  block_offsets_.resize(trailer.block_count);
+  if (!block_offsets_.empty() &&
+      (!file_reader_->SeekSet(start_offset_ + trailer.index_offset) ||
+       !file_reader_->ReadExactly(
+           &block_offsets_[0],
+           block_offsets_.size() * sizeof(block_offsets_[0])))) {
+    return false;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+size_t BlockCompressedFileReader::BlockCount() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return block_offsets_.size();
+}
+
+bool BlockCompressedFileReader::ReadBlock(size_t index,
+                                          const std::string** data,
+                                          const std::string** zlib_data) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK_LT(index, block_offsets_.size());
+
+  if (!LoadBlock(static_cast<uint64_t>(index) * block_size_)) {
+    return false;
+  }
+
+  *data = &block_;
+  *zlib_data = block_compressed_ ? &compressed_block_ : nullptr;
+  return true;
+}
+
+FileOperationResult BlockCompressedFileReader::Read(void* data, size_t size) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  uint8_t* data_c = static_cast<uint8_t*>(data);
+  size_t total_read = 0;
+  size = std::min(size,
+                  base::saturated_cast<size_t>(
+                      std::numeric_limits<FileOperationResult>::max()));
+  while (total_read < size && offset_ < uncompressed_size_) {
+    if (!LoadBlock(offset_)) {
+      return -1;
+    }
+
+    size_t offset_in_block = static_cast<size_t>(offset_ % block_size_);
+    size_t chunk = std::min(size - total_read, block_.size() - offset_in_block);
+    memcpy(data_c + total_read, &block_[offset_in_block], chunk);
+    total_read += chunk;
+    offset_ += chunk;
+  }
+
+  return total_read;
+}
+
+FileOffset BlockCompressedFileReader::Seek(FileOffset offset, int whence) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  FileOffset base;
+  switch (whence) {
+    case SEEK_SET:
+      base = 0;
+      break;
+    case SEEK_CUR:
+      base = static_cast<FileOffset>(offset_);
+      break;
+    case SEEK_END:
+      base = static_cast<FileOffset>(uncompressed_size_);
+      break;
+    default:
+      LOG(ERROR) << "Seek(): invalid whence " << whence;
+      return -1;
+  }
+
+  if ((offset > 0 && base > std::numeric_limits<FileOffset>::max() - offset) ||
+      base + offset < 0) {
+    LOG(ERROR) << "Seek(): invalid offset";
+    return -1;
+  }
+
+  offset_ = base + offset;
+  return static_cast<FileOffset>(offset_);
+}
+
+bool BlockCompressedFileReader::LoadBlock(uint64_t offset) {
+  const size_t block_index = static_cast<size_t>(offset / block_size_);
+  if (block_index == block_index_) {
+    return true;
+  }
+
+  DCHECK_LT(block_index, block_offsets_.size());
+  block_index_ = std::numeric_limits<size_t>::max();
+
+  internal::BlockCompressedFileBlockHeader block_header;
+  if (!file_reader_->SeekSet(start_offset_ + block_offsets_[block_index]) ||
+      !file_reader_->ReadExactly(&block_header, sizeof(block_header))) {
+    return false;
+  }
+
+  const uint64_t expected_size =
+      std::min(static_cast<uint64_t>(block_size_),
+               uncompressed_size_ - block_index * block_size_);
+  if (block_header.uncompressed_size != expected_size ||
+      block_header.compressed_size == 0) {
+    LOG(ERROR) << "block " << block_index << " size mismatch";
+    return false;
+  }
+
+  block_.resize(block_header.uncompressed_size);
+  block_compressed_ =
+      block_header.compressed_size != block_header.uncompressed_size;
+  if (!block_compressed_) {
+    if (!file_reader_->ReadExactly(&block_[0], block_.size())) {
+      return false;
+    }
+  } else {
+    compressed_block_.resize(block_header.compressed_size);
+    if (!file_reader_->ReadExactly(&compressed_block_[0],
+                                   compressed_block_.size())) {
+      return false;
+    }
+
+    uLongf uncompressed_size = block_.size();
+    int zr = uncompress(reinterpret_cast<Bytef*>(&block_[0]),
+                        &uncompressed_size,
+                        reinterpret_cast<const Bytef*>(&compressed_block_[0]),
+                        compressed_block_.size());
+    if (zr != Z_OK) {
+      LOG(ERROR) << "uncompress: " << ZlibErrorString(zr);
+      return false;
+    }
+    if (uncompressed_size != block_.size()) {
+      LOG(ERROR) << "block " << block_index << " decompressed size mismatch";
+      return false;
+    }
+  }
+
+  block_index_ = block_index;
+  return true;
+}
+
+}  // namespace crashpad
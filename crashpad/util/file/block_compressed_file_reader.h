@@ -0,0 +1,111 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_BLOCK_COMPRESSED_FILE_READER_H_
+#define CRASHPAD_UTIL_FILE_BLOCK_COMPRESSED_FILE_READER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "util/file/file_reader.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+
+//! \brief A file reader that decompresses data written by
+//!     BlockCompressedFileWriter.
+//!
+//! Seeking to any uncompressed offset is supported, and requires decompressing
+//! at most one block. The most recently decompressed block is retained, so
+//! that sequential reads and nearby seeks are inexpensive.
+class BlockCompressedFileReader : public FileReaderInterface {
+ public:
+  BlockCompressedFileReader();
+  ~BlockCompressedFileReader() override;
+
+  //! \brief Determines whether a file is a block-compressed file.
+  //!
+  //! \param[in] file_reader The file to examine, positioned at its start. Its
+  //!     position is restored before this method returns.
+  //!
+  //! \return `true` if \a file_reader begins with a block-compressed file
+  //!     header. `false` otherwise, or on error.
+  static bool IsBlockCompressedFile(FileReaderInterface* file_reader);
+
+  //! \brief Initializes the object.
+  //!
+  //! \param[in] file_reader The underlying block-compressed file, positioned
+  //!     at its start, which must support seeking. The block-compressed data
+  //!     must extend to the end of the file. This object does not take
+  //!     ownership of \a file_reader, which must remain valid for this object’s
+  //!     lifetime.
+  //!
+  //! \return `true` on success. `false` on failure, with an error message
+  //!     logged.
+  bool Initialize(FileReaderInterface* file_reader);
+
+  //! \brief Returns the number of blocks in the file.
+  size_t BlockCount() const;
+
+  //! \brief Reads a single block, both decompressed and as it is stored.
+  //!
+  //! This allows a block’s compressed data to be reused without compressing
+  //! it again. The position used by Read() is not affected.
+  //!
+  //! \param[in] index The index of the block to read, less than BlockCount().
+  //! \param[out] data The block’s decompressed data.
+  //! \param[out] zlib_data The block’s data as stored, a zlib stream, or
+  //!     `nullptr` if the block is stored without compression.
+  //!
+  //! The strings returned through \a data and \a zlib_data remain valid until
+  //! the next call to a method of this object.
+  //!
+  //! \return `true` on success. `false` on failure, with an error message
+  //!     logged.
+  bool ReadBlock(size_t index,
+                 const std::string** data,
+                 const std::string** zlib_data);
+
+  // FileReaderInterface:
+  FileOperationResult Read(void* data, size_t size) override;
+
+  // FileSeekerInterface:
+  FileOffset Seek(FileOffset offset, int whence) override;
+
+ private:
+  //! \brief Makes the block containing \a offset the current block.
+  bool LoadBlock(uint64_t offset);
+
+  std::vector<uint64_t> block_offsets_;
+  std::string block_;
+  std::string compressed_block_;
+  FileReaderInterface* file_reader_;  // weak
+  FileOffset start_offset_;
+  uint64_t uncompressed_size_;
+  uint64_t offset_;
+  size_t block_size_;
+  size_t block_index_;
+  bool block_compressed_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockCompressedFileReader);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_BLOCK_COMPRESSED_FILE_READER_H_
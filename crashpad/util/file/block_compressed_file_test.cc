@@ -0,0 +1,215 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "third_party/zlib/zlib_crashpad.h"
+#include "util/file/block_compressed_file_reader.h"
+#include "util/file/block_compressed_file_writer.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+// Produces data that compresses well in some places and poorly in others.
+std::string MakeTestData(size_t size) {
+  std::string data;
+  uint32_t state = 0x12345678;
+  while (data.size() < size) {
+    if ((data.size() / 1000) % 2) {
+      data.push_back('z');
+    } else {
+      state = state * 1103515245 + 12345;
+      data.push_back(static_cast<char>(state >> 24));
+    }
+  }
+  return data;
+}
+
+TEST(BlockCompressedFile, Empty) {
+  StringFile string_file;
+  BlockCompressedFileWriter writer(
+      &string_file, BlockCompressedFileWriter::kDefaultBlockSize);
+  EXPECT_EQ(writer.SeekGet(), 0);
+  ASSERT_TRUE(writer.Close());
+
+  ASSERT_TRUE(string_file.SeekSet(0));
+  EXPECT_TRUE(BlockCompressedFileReader::IsBlockCompressedFile(&string_file));
+  EXPECT_EQ(string_file.SeekGet(), 0);
+
+  BlockCompressedFileReader reader;
+  ASSERT_TRUE(reader.Initialize(&string_file));
+  EXPECT_EQ(reader.Seek(0, SEEK_END), 0);
+  ASSERT_TRUE(reader.SeekSet(0));
+  char c;
+  EXPECT_EQ(reader.Read(&c, 1), 0);
+}
+
+TEST(BlockCompressedFile, RoundTrip) {
+  constexpr size_t kBlockSize = 4096;
+  const std::string data = MakeTestData(10 * kBlockSize + 123);
+
+  StringFile string_file;
+  BlockCompressedFileWriter writer(&string_file, kBlockSize);
+
+  // Write in pieces that don’t line up with block boundaries.
+  size_t offset = 0;
+  size_t piece = 1;
+  while (offset < data.size()) {
+    size_t size = std::min(piece, data.size() - offset);
+    ASSERT_TRUE(writer.Write(&data[offset], size));
+    offset += size;
+    piece = piece * 3 + 1;
+    EXPECT_EQ(writer.SeekGet(), static_cast<FileOffset>(offset));
+  }
+  EXPECT_EQ(writer.Seek(0, SEEK_SET), -1);
+  ASSERT_TRUE(writer.Close());
+
+  EXPECT_LT(string_file.string().size(), data.size());
+
+  ASSERT_TRUE(string_file.SeekSet(0));
+  BlockCompressedFileReader reader;
+  ASSERT_TRUE(reader.Initialize(&string_file));
+
+  EXPECT_EQ(reader.Seek(0, SEEK_END), static_cast<FileOffset>(data.size()));
+  ASSERT_TRUE(reader.SeekSet(0));
+
+  std::string read_data(data.size(), '\0');
+  ASSERT_TRUE(reader.ReadExactly(&read_data[0], read_data.size()));
+  EXPECT_EQ(read_data, data);
+
+  char c;
+  EXPECT_EQ(reader.Read(&c, 1), 0);
+
+  // Random access across block boundaries.
+  const size_t kOffsets[] = {
+      0, kBlockSize - 1, 5 * kBlockSize + 17, 3, data.size() - 10};
+  for (size_t read_offset : kOffsets) {
+    SCOPED_TRACE(read_offset);
+    ASSERT_TRUE(reader.SeekSet(read_offset));
+    std::string part(10, '\0');
+    ASSERT_TRUE(reader.ReadExactly(&part[0], part.size()));
+    EXPECT_EQ(part, data.substr(read_offset, part.size()));
+  }
+
+  ASSERT_TRUE(reader.SeekSet(data.size() - 5));
+  std::string tail(10, '\0');
+  EXPECT_EQ(reader.Read(&tail[0], tail.size()), 5);
+  EXPECT_EQ(tail.substr(0, 5), data.substr(data.size() - 5));
+}
+
+TEST(BlockCompressedFile, WriteIoVec) {
+  StringFile string_file;
+  BlockCompressedFileWriter writer(&string_file, 8);
+
+  const std::string kParts[] = {"Hello, ", "block-compressed ", "world"};
+  std::vector<WritableIoVec> iovecs;
+  std::string expected;
+  for (const std::string& part : kParts) {
+    WritableIoVec iov;
+    iov.iov_base = part.data();
+    iov.iov_len = part.size();
+    iovecs.push_back(iov);
+    expected += part;
+  }
+  ASSERT_TRUE(writer.WriteIoVec(&iovecs));
+  ASSERT_TRUE(writer.Close());
+
+  ASSERT_TRUE(string_file.SeekSet(0));
+  BlockCompressedFileReader reader;
+  ASSERT_TRUE(reader.Initialize(&string_file));
+
+  std::string read_data(expected.size(), '\0');
+  ASSERT_TRUE(reader.ReadExactly(&read_data[0], read_data.size()));
+  EXPECT_EQ(read_data, expected);
+}
+
+TEST(BlockCompressedFile, ReadBlock) {
+  // Blocks alternate between data that can’t be compressed, which is stored as
+  // it is, and data that can.
+  constexpr size_t kBlockSize = 1000;
+  const std::string data = MakeTestData(4 * kBlockSize + 500);
+
+  StringFile string_file;
+  BlockCompressedFileWriter writer(&string_file, kBlockSize);
+  ASSERT_TRUE(writer.Write(data.data(), data.size()));
+  ASSERT_TRUE(writer.Close());
+
+  ASSERT_TRUE(string_file.SeekSet(0));
+  BlockCompressedFileReader reader;
+  ASSERT_TRUE(reader.Initialize(&string_file));
+  ASSERT_EQ(reader.BlockCount(), 5u);
+  ASSERT_TRUE(reader.SeekSet(10));
+
+  for (size_t index = 0; index < reader.BlockCount(); ++index) {
+    SCOPED_TRACE(index);
+    const std::string* block_data;
+    const std::string* zlib_data;
+    ASSERT_TRUE(reader.ReadBlock(index, &block_data, &zlib_data));
+    EXPECT_EQ(*block_data, data.substr(index * kBlockSize, kBlockSize));
+    if (index % 2) {
+      ASSERT_TRUE(zlib_data);
+      std::string uncompressed(block_data->size(), '\0');
+      uLongf uncompressed_size = uncompressed.size();
+      ASSERT_EQ(uncompress(reinterpret_cast<Bytef*>(&uncompressed[0]),
+                           &uncompressed_size,
+                           reinterpret_cast<const Bytef*>(zlib_data->data()),
+                           zlib_data->size()),
+                Z_OK);
+      EXPECT_EQ(uncompressed, *block_data);
+    } else {
+      EXPECT_FALSE(zlib_data);
+    }
+  }
+
+  // Reading blocks doesn’t disturb the position used by Read().
+  EXPECT_EQ(reader.SeekGet(), 10);
+  std::string part(10, '\0');
+  ASSERT_TRUE(reader.ReadExactly(&part[0], part.size()));
+  EXPECT_EQ(part, data.substr(10, part.size()));
+}
+
+TEST(BlockCompressedFile, NotCompressed) {
+  StringFile string_file;
+  string_file.SetString("MDMP and then some");
+  EXPECT_FALSE(BlockCompressedFileReader::IsBlockCompressedFile(&string_file));
+
+  BlockCompressedFileReader reader;
+  EXPECT_FALSE(reader.Initialize(&string_file));
+}
+
+TEST(BlockCompressedFile, Truncated) {
+  StringFile string_file;
+  BlockCompressedFileWriter writer(&string_file, 64);
+  const std::string data = MakeTestData(1000);
+  ASSERT_TRUE(writer.Write(data.data(), data.size()));
+  ASSERT_TRUE(writer.Close());
+
+  std::string contents = string_file.string();
+  contents.resize(contents.size() - 1);
+  string_file.SetString(contents);
+
+  BlockCompressedFileReader reader;
+  EXPECT_FALSE(reader.Initialize(&string_file));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,202 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/block_compressed_file_writer.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
+#include "third_party/zlib/zlib_crashpad.h"
+#include "util/file/block_compressed_file_format.h"
+#include "util/misc/zlib.h"
+
+namespace crashpad {
+
+BlockCompressedFileWriter::BlockCompressedFileWriter(
+    FileWriterInterface* file_writer,
+    size_t block_size)
+    : block_(),
+      compressed_block_(),
+      block_offsets_(),
+      file_writer_(file_writer),
+      underlying_offset_(0),
+      uncompressed_size_(0),
+      block_size_(block_size),
+      wrote_header_(false),
+      closed_(false) {
+  DCHECK_GT(block_size_, 0u);
+  DCHECK_LE(block_size_, std::numeric_limits<uint32_t>::max());
+  block_.reserve(block_size_);
+}
+
+BlockCompressedFileWriter::~BlockCompressedFileWriter() {
+}
+
+bool BlockCompressedFileWriter::Close() {
+  DCHECK(!closed_);
+  closed_ = true;
+
+  if (!WriteHeaderIfNeeded() || !FlushBlock()) {
+    return false;
+  }
+
+  internal::BlockCompressedFileTrailer trailer = {};
+  trailer.index_offset = underlying_offset_;
+  trailer.uncompressed_size = uncompressed_size_;
+  if (!base::IsValueInRangeForNumericType<uint32_t>(block_offsets_.size())) {
+    LOG(ERROR) << "too many blocks";
+    return false;
+  }
+  trailer.block_count = static_cast<uint32_t>(block_offsets_.size());
+  trailer.signature = internal::kBlockCompressedFileTrailerSignature;
+
+  std::vector<WritableIoVec> iovecs;
+  if (!block_offsets_.empty()) {
+    WritableIoVec iov;
+    iov.iov_base = &block_offsets_[0];
+    iov.iov_len = block_offsets_.size() * sizeof(block_offsets_[0]);
+    iovecs.push_back(iov);
+  }
+
+  WritableIoVec iov;
+  iov.iov_base = &trailer;
+  iov.iov_len = sizeof(trailer);
+  iovecs.push_back(iov);
+
+  return file_writer_->WriteIoVec(&iovecs);
+}
+
+bool BlockCompressedFileWriter::Write(const void* data, size_t size) {
+  DCHECK(!closed_);
+
+  if (!WriteHeaderIfNeeded()) {
+    return false;
+  }
+
+  const char* data_c = static_cast<const char*>(data);
+  while (size > 0) {
+    size_t chunk = std::min(size, block_size_ - block_.size());
+    block_.append(data_c, chunk);
+    data_c += chunk;
+    size -= chunk;
+    uncompressed_size_ += chunk;
+
+    if (block_.size() == block_size_ && !FlushBlock()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool BlockCompressedFileWriter::WriteIoVec(
+    std::vector<WritableIoVec>* iovecs) {
+  if (iovecs->empty()) {
+    LOG(ERROR) << "WriteIoVec(): no iovecs";
+    return false;
+  }
+
+  for (const WritableIoVec& iov : *iovecs) {
+    if (!Write(iov.iov_base, iov.iov_len)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+FileOffset BlockCompressedFileWriter::Seek(FileOffset offset, int whence) {
+  if (offset != 0 || whence != SEEK_CUR) {
+    LOG(ERROR) << "Seek(): only the current position is available";
+    return -1;
+  }
+
+  if (!base::IsValueInRangeForNumericType<FileOffset>(uncompressed_size_)) {
+    LOG(ERROR) << "Seek(): file too large";
+    return -1;
+  }
+
+  return static_cast<FileOffset>(uncompressed_size_);
+}
+
+bool BlockCompressedFileWriter::WriteHeaderIfNeeded() {
+  if (wrote_header_) {
+    return true;
+  }
+  wrote_header_ = true;
+
+  internal::BlockCompressedFileHeader header = {};
+  header.signature = internal::kBlockCompressedFileSignature;
+  header.version = internal::kBlockCompressedFileVersion;
+  header.block_size = static_cast<uint32_t>(block_size_);
+  if (!file_writer_->Write(&header, sizeof(header))) {
+    return false;
+  }
+
+  underlying_offset_ += sizeof(header);
+  return true;
+}
+
+bool BlockCompressedFileWriter::FlushBlock() {
+  if (block_.empty()) {
+    return true;
+  }
+
+  // Favor speed over ratio. Data is typically compressed while a crashed
+  // process is suspended.
+  uLongf compressed_size = compressBound(block_.size());
+  compressed_block_.resize(compressed_size);
+  int zr = compress2(reinterpret_cast<Bytef*>(&compressed_block_[0]),
+                     &compressed_size,
+                     reinterpret_cast<const Bytef*>(block_.data()),
+                     block_.size(),
+                     Z_BEST_SPEED);
+  if (zr != Z_OK) {
+    LOG(ERROR) << "compress2: " << ZlibErrorString(zr);
+    return false;
+  }
+
+  // Store the block uncompressed if compression didn’t make it smaller.
+  const std::string* block_data = &compressed_block_;
+  if (compressed_size >= block_.size()) {
+    block_data = &block_;
+    compressed_size = block_.size();
+  }
+
+  internal::BlockCompressedFileBlockHeader block_header;
+  block_header.compressed_size = static_cast<uint32_t>(compressed_size);
+  block_header.uncompressed_size = static_cast<uint32_t>(block_.size());
+
+  WritableIoVec iov;
+  iov.iov_base = &block_header;
+  iov.iov_len = sizeof(block_header);
+  std::vector<WritableIoVec> iovecs(1, iov);
+
+  iov.iov_base = block_data->data();
+  iov.iov_len = compressed_size;
+  iovecs.push_back(iov);
+
+  if (!file_writer_->WriteIoVec(&iovecs)) {
+    return false;
+  }
+
+  block_offsets_.push_back(underlying_offset_);
+  underlying_offset_ += sizeof(block_header) + compressed_size;
+  block_.clear();
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,98 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_BLOCK_COMPRESSED_FILE_WRITER_H_
+#define CRASHPAD_UTIL_FILE_BLOCK_COMPRESSED_FILE_WRITER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "util/file/file_writer.h"
+
+namespace crashpad {
+
+//! \brief A file writer that compresses data written to it in independently
+//!     decompressible blocks.
+//!
+//! Data is accumulated into blocks of a fixed uncompressed size. Each block is
+//! compressed with zlib and written to an underlying FileWriterInterface as
+//! soon as it is full, so that the uncompressed data never has to be written
+//! in its entirety. When Close() is called, an index of blocks is written,
+//! allowing BlockCompressedFileReader to seek to any uncompressed offset while
+//! decompressing only a single block.
+//!
+//! Data can only be written sequentially. Seek() supports only obtaining the
+//! current position, so this class is suitable for use with
+//! MinidumpFileWriter::WriteMinidump() with `allow_seek` set to `false`.
+class BlockCompressedFileWriter : public FileWriterInterface {
+ public:
+  //! \brief The default uncompressed size of each block, in bytes.
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  //! \brief Constructs the object.
+  //!
+  //! \param[in] file_writer The underlying file writer to receive compressed
+  //!     data. This object does not take ownership of \a file_writer, which
+  //!     must remain valid until Close() has been called.
+  //! \param[in] block_size The uncompressed size of each block, in bytes. A
+  //!     typical value is #kDefaultBlockSize.
+  BlockCompressedFileWriter(FileWriterInterface* file_writer,
+                            size_t block_size);
+  ~BlockCompressedFileWriter() override;
+
+  //! \brief Writes any buffered data, the block index, and the file trailer.
+  //!
+  //! This must be called once all data has been written. No further data may
+  //! be written after this method is called.
+  //!
+  //! \return `true` on success. `false` on failure, with an error message
+  //!     logged.
+  bool Close();
+
+  // FileWriterInterface:
+  bool Write(const void* data, size_t size) override;
+  bool WriteIoVec(std::vector<WritableIoVec>* iovecs) override;
+
+  // FileSeekerInterface:
+
+  //! \copydoc FileWriterInterface::Seek()
+  //!
+  //! \note Only `Seek(0, SEEK_CUR)`, which returns the current uncompressed
+  //!     offset, is supported. All other uses fail.
+  FileOffset Seek(FileOffset offset, int whence) override;
+
+ private:
+  bool WriteHeaderIfNeeded();
+  bool FlushBlock();
+
+  std::string block_;
+  std::string compressed_block_;
+  std::vector<uint64_t> block_offsets_;
+  FileWriterInterface* file_writer_;  // weak
+  uint64_t underlying_offset_;
+  uint64_t uncompressed_size_;
+  size_t block_size_;
+  bool wrote_header_;
+  bool closed_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockCompressedFileWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_BLOCK_COMPRESSED_FILE_WRITER_H_
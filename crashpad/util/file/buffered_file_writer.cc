@@ -0,0 +1,79 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/buffered_file_writer.h"
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+BufferedFileWriter::BufferedFileWriter(FileWriterInterface* file_writer,
+                                       size_t buffer_size)
+    : buffer_(), file_writer_(file_writer), buffer_size_(buffer_size) {
+  DCHECK_GT(buffer_size_, 0u);
+  buffer_.reserve(buffer_size_);
+}
+
+BufferedFileWriter::~BufferedFileWriter() {
+}
+
+bool BufferedFileWriter::Flush() {
+  if (buffer_.empty()) {
+    return true;
+  }
+
+  // Clear the buffer even on failure, so that a later Flush() doesn’t write
+  // the same data again.
+  bool rv = file_writer_->Write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+  return rv;
+}
+
+bool BufferedFileWriter::Write(const void* data, size_t size) {
+  if (size > buffer_size_ - buffer_.size() && !Flush()) {
+    return false;
+  }
+
+  if (size >= buffer_size_) {
+    return file_writer_->Write(data, size);
+  }
+
+  buffer_.append(static_cast<const char*>(data), size);
+  return true;
+}
+
+bool BufferedFileWriter::WriteIoVec(std::vector<WritableIoVec>* iovecs) {
+  if (iovecs->empty()) {
+    LOG(ERROR) << "WriteIoVec(): no iovecs";
+    return false;
+  }
+
+  for (const WritableIoVec& iov : *iovecs) {
+    if (!Write(iov.iov_base, iov.iov_len)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+FileOffset BufferedFileWriter::Seek(FileOffset offset, int whence) {
+  if (!Flush()) {
+    return -1;
+  }
+
+  return file_writer_->Seek(offset, whence);
+}
+
+}  // namespace crashpad
@@ -0,0 +1,78 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_BUFFERED_FILE_WRITER_H_
+#define CRASHPAD_UTIL_FILE_BUFFERED_FILE_WRITER_H_
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "util/file/file_writer.h"
+
+namespace crashpad {
+
+//! \brief A file writer that coalesces small writes into larger ones.
+//!
+//! Data written to this object is accumulated in a buffer and passed to an
+//! underlying FileWriterInterface once the buffer fills, so that a sequence of
+//! small writes results in few writes to the underlying file. A single write at
+//! least as large as the buffer bypasses it, after writing anything already
+//! buffered.
+//!
+//! Seek() writes any buffered data before seeking the underlying file, so
+//! this class may be used wherever its underlying file writer could be.
+//! Flush() must be called once all data has been written. Data still buffered
+//! when this object is destroyed is discarded.
+class BufferedFileWriter : public FileWriterInterface {
+ public:
+  //! \brief The default buffer size, in bytes.
+  static constexpr size_t kDefaultBufferSize = 256 * 1024;
+
+  //! \brief Constructs the object.
+  //!
+  //! \param[in] file_writer The underlying file writer to receive buffered
+  //!     data. This object does not take ownership of \a file_writer, which
+  //!     must remain valid until this object is destroyed.
+  //! \param[in] buffer_size The size of the buffer, in bytes. A typical value
+  //!     is #kDefaultBufferSize.
+  BufferedFileWriter(FileWriterInterface* file_writer, size_t buffer_size);
+  ~BufferedFileWriter() override;
+
+  //! \brief Writes any buffered data to the underlying file writer.
+  //!
+  //! \return `true` on success. `false` on failure, with an error message
+  //!     logged.
+  bool Flush();
+
+  // FileWriterInterface:
+  bool Write(const void* data, size_t size) override;
+  bool WriteIoVec(std::vector<WritableIoVec>* iovecs) override;
+
+  // FileSeekerInterface:
+  FileOffset Seek(FileOffset offset, int whence) override;
+
+ private:
+  std::string buffer_;
+  FileWriterInterface* file_writer_;  // weak
+  size_t buffer_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferedFileWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_BUFFERED_FILE_WRITER_H_
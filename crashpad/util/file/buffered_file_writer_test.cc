@@ -0,0 +1,127 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/buffered_file_writer.h"
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "gtest/gtest.h"
+#include "util/file/string_file.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+// A StringFile that counts the writes made to it.
+class CountingStringFile : public StringFile {
+ public:
+  CountingStringFile() : StringFile(), write_count_(0) {}
+  ~CountingStringFile() override {}
+
+  size_t write_count() const { return write_count_; }
+
+  // FileWriterInterface:
+  bool Write(const void* data, size_t size) override {
+    ++write_count_;
+    return StringFile::Write(data, size);
+  }
+
+ private:
+  size_t write_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingStringFile);
+};
+
+TEST(BufferedFileWriter, CoalescesSmallWrites) {
+  CountingStringFile string_file;
+  BufferedFileWriter buffered_file_writer(&string_file, 16);
+
+  ASSERT_TRUE(buffered_file_writer.Write("abcd", 4));
+  ASSERT_TRUE(buffered_file_writer.Write("efgh", 4));
+  ASSERT_TRUE(buffered_file_writer.Write("ijkl", 4));
+  EXPECT_EQ(string_file.write_count(), 0u);
+  EXPECT_TRUE(string_file.string().empty());
+
+  // This doesn’t fit in what remains of the buffer, so the buffer is written
+  // first.
+  ASSERT_TRUE(buffered_file_writer.Write("mnopqr", 6));
+  EXPECT_EQ(string_file.write_count(), 1u);
+  EXPECT_EQ(string_file.string(), "abcdefghijkl");
+
+  ASSERT_TRUE(buffered_file_writer.Flush());
+  EXPECT_EQ(string_file.write_count(), 2u);
+  EXPECT_EQ(string_file.string(), "abcdefghijklmnopqr");
+
+  // Flushing an empty buffer doesn’t write anything.
+  ASSERT_TRUE(buffered_file_writer.Flush());
+  EXPECT_EQ(string_file.write_count(), 2u);
+}
+
+TEST(BufferedFileWriter, LargeWrite) {
+  CountingStringFile string_file;
+  BufferedFileWriter buffered_file_writer(&string_file, 16);
+
+  ASSERT_TRUE(buffered_file_writer.Write("ab", 2));
+
+  const std::string large(40, 'z');
+  ASSERT_TRUE(buffered_file_writer.Write(large.data(), large.size()));
+  EXPECT_EQ(string_file.write_count(), 2u);
+  EXPECT_EQ(string_file.string(), "ab" + large);
+
+  ASSERT_TRUE(buffered_file_writer.Flush());
+  EXPECT_EQ(string_file.write_count(), 2u);
+}
+
+TEST(BufferedFileWriter, WriteIoVec) {
+  CountingStringFile string_file;
+  BufferedFileWriter buffered_file_writer(&string_file, 16);
+
+  std::vector<WritableIoVec> iovecs;
+  WritableIoVec iov;
+  iov.iov_base = "abc";
+  iov.iov_len = 3;
+  iovecs.push_back(iov);
+  iov.iov_base = "defg";
+  iov.iov_len = 4;
+  iovecs.push_back(iov);
+  ASSERT_TRUE(buffered_file_writer.WriteIoVec(&iovecs));
+
+  ASSERT_TRUE(buffered_file_writer.Flush());
+  EXPECT_EQ(string_file.write_count(), 1u);
+  EXPECT_EQ(string_file.string(), "abcdefg");
+}
+
+TEST(BufferedFileWriter, Seek) {
+  CountingStringFile string_file;
+  BufferedFileWriter buffered_file_writer(&string_file, 16);
+
+  ASSERT_TRUE(buffered_file_writer.Write("abcdefgh", 8));
+  EXPECT_EQ(buffered_file_writer.Seek(0, SEEK_CUR), 8);
+  EXPECT_EQ(string_file.string(), "abcdefgh");
+
+  EXPECT_EQ(buffered_file_writer.Seek(2, SEEK_SET), 2);
+  ASSERT_TRUE(buffered_file_writer.Write("CD", 2));
+  EXPECT_EQ(buffered_file_writer.Seek(0, SEEK_END), 8);
+  ASSERT_TRUE(buffered_file_writer.Write("ij", 2));
+  ASSERT_TRUE(buffered_file_writer.Flush());
+  EXPECT_EQ(string_file.string(), "abCDefghij");
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,202 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/chunked_buffer_file.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+namespace {
+
+// The largest file that can be described by FileOperationResult and
+// FileOffset, as for StringFile.
+constexpr size_t kMaximumSize =
+    static_cast<size_t>(std::numeric_limits<FileOperationResult>::max());
+
+}  // namespace
+
+constexpr size_t ChunkedBufferFile::kMinimumBufferSize;
+
+ChunkedBufferFile::ChunkedBufferFile()
+    : buffers_(), buffer_offsets_(), size_(0), offset_(0) {}
+
+ChunkedBufferFile::~ChunkedBufferFile() {}
+
+void ChunkedBufferFile::Reserve(size_t size) {
+  const size_t available =
+      buffers_.empty() ? 0
+                       : buffers_.back().capacity() - buffers_.back().size();
+  if (size <= size_ || size - size_ <= available) {
+    return;
+  }
+
+  // An empty buffer can grow without anything being copied.
+  if (buffers_.empty() || !buffers_.back().empty()) {
+    buffers_.push_back(Buffer());
+    buffer_offsets_.push_back(size_);
+  }
+  buffers_.back().reserve(size - size_);
+}
+
+std::vector<ChunkedBufferFile::Buffer> ChunkedBufferFile::TakeBuffers() {
+  std::vector<Buffer> buffers;
+  buffers.swap(buffers_);
+  if (!buffers.empty() && buffers.back().empty()) {
+    buffers.pop_back();
+  }
+  buffer_offsets_.clear();
+  size_ = 0;
+  offset_ = 0;
+  return buffers;
+}
+
+bool ChunkedBufferFile::Write(const void* data, size_t size) {
+  if (size > kMaximumSize - offset_) {
+    LOG(ERROR) << "Write(): file too large";
+    return false;
+  }
+
+  if (offset_ > size_) {
+    Append(nullptr, offset_ - size_);
+  }
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  const size_t overwrite_size = std::min(size, size_ - offset_);
+  Overwrite(offset_, bytes, overwrite_size);
+  Append(bytes + overwrite_size, size - overwrite_size);
+  offset_ += size;
+  return true;
+}
+
+bool ChunkedBufferFile::WriteIoVec(std::vector<WritableIoVec>* iovecs) {
+  if (iovecs->empty()) {
+    LOG(ERROR) << "WriteIoVec(): no iovecs";
+    return false;
+  }
+
+  // Avoid writing anything at all if it would cause an overflow.
+  size_t total_size = 0;
+  for (const WritableIoVec& iov : *iovecs) {
+    if (iov.iov_len > kMaximumSize - offset_ - total_size) {
+      LOG(ERROR) << "WriteIoVec(): file too large";
+      return false;
+    }
+    total_size += iov.iov_len;
+  }
+
+  for (const WritableIoVec& iov : *iovecs) {
+    if (!Write(iov.iov_base, iov.iov_len)) {
+      return false;
+    }
+  }
+
+#ifndef NDEBUG
+  // The interface says that |iovecs| is not sacred, so scramble it to make sure
+  // that nobody depends on it.
+  memset(&(*iovecs)[0], 0xa5, sizeof((*iovecs)[0]) * iovecs->size());
+#endif
+
+  return true;
+}
+
+FileOffset ChunkedBufferFile::Seek(FileOffset offset, int whence) {
+  size_t base_offset;
+  switch (whence) {
+    case SEEK_SET:
+      base_offset = 0;
+      break;
+
+    case SEEK_CUR:
+      base_offset = offset_;
+      break;
+
+    case SEEK_END:
+      base_offset = size_;
+      break;
+
+    default:
+      LOG(ERROR) << "Seek(): invalid whence " << whence;
+      return -1;
+  }
+
+  // base_offset never exceeds kMaximumSize, so it is a valid FileOffset.
+  const FileOffset base = static_cast<FileOffset>(base_offset);
+  if ((offset < 0 && -offset > base) ||
+      (offset > 0 &&
+       static_cast<size_t>(offset) > kMaximumSize - base_offset)) {
+    LOG(ERROR) << "Seek(): new_offset invalid";
+    return -1;
+  }
+
+  offset_ = static_cast<size_t>(base + offset);
+  return static_cast<FileOffset>(offset_);
+}
+
+void ChunkedBufferFile::Overwrite(size_t offset,
+                                  const uint8_t* data,
+                                  size_t size) {
+  if (!size) {
+    return;
+  }
+  DCHECK_LE(offset + size, size_);
+
+  // Find the last buffer that begins at or before |offset|.
+  size_t index = std::upper_bound(buffer_offsets_.begin(),
+                                  buffer_offsets_.end(),
+                                  offset) -
+                 buffer_offsets_.begin() - 1;
+  while (size) {
+    Buffer& buffer = buffers_[index];
+    const size_t buffer_offset = offset - buffer_offsets_[index];
+    const size_t copy_size = std::min(size, buffer.size() - buffer_offset);
+    memcpy(&buffer[buffer_offset], data, copy_size);
+    data += copy_size;
+    offset += copy_size;
+    size -= copy_size;
+    ++index;
+  }
+}
+
+void ChunkedBufferFile::Append(const uint8_t* data, size_t size) {
+  while (size) {
+    if (buffers_.empty() ||
+        buffers_.back().size() == buffers_.back().capacity()) {
+      buffers_.push_back(Buffer());
+      buffer_offsets_.push_back(size_);
+      buffers_.back().reserve(std::max(size, kMinimumBufferSize));
+    }
+
+    // This stays within the buffer’s capacity, so nothing already in it moves.
+    Buffer& buffer = buffers_.back();
+    const size_t append_size =
+        std::min(size, buffer.capacity() - buffer.size());
+    if (data) {
+      buffer.insert(buffer.end(), data, data + append_size);
+      data += append_size;
+    } else {
+      buffer.insert(buffer.end(), append_size, 0);
+    }
+    size_ += append_size;
+    size -= append_size;
+  }
+}
+
+}  // namespace crashpad
@@ -0,0 +1,103 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_CHUNKED_BUFFER_FILE_H_
+#define CRASHPAD_UTIL_FILE_CHUNKED_BUFFER_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "util/file/file_io.h"
+#include "util/file/file_writer.h"
+
+namespace crashpad {
+
+//! \brief A file writer that keeps the file’s contents in memory, in a list of
+//!     separately-allocated buffers.
+//!
+//! Unlike StringFile, whose single buffer is reallocated and copied as the
+//! file grows, this never moves anything once it has been written. When the
+//! last buffer is full, another is added. Reserve() allocates for a known total
+//! size at once, so that a file of that size occupies a single buffer. The
+//! buffers can be handed off with TakeBuffers() without being copied.
+//!
+//! Seeking is supported as it is by StringFile: a write past the end of the
+//! file fills the gap with zeroes, and a write before the end replaces what
+//! was there.
+class ChunkedBufferFile : public FileWriterInterface {
+ public:
+  //! \brief A buffer holding part of the file’s contents.
+  using Buffer = std::vector<uint8_t>;
+
+  //! \brief The smallest buffer that is added when the last one is full, in
+  //!     bytes.
+  static constexpr size_t kMinimumBufferSize = 64 * 1024;
+
+  ChunkedBufferFile();
+  ~ChunkedBufferFile() override;
+
+  //! \brief Allocates storage so that the file can grow to \a size bytes
+  //!     without any further allocation.
+  //!
+  //! This is most effective before anything is written, when it results in a
+  //! single buffer. Storage left in the last buffer when this adds another goes
+  //! unused.
+  void Reserve(size_t size);
+
+  //! \brief Returns the size of the file’s contents, in bytes.
+  size_t size() const { return size_; }
+
+  //! \brief Returns the file’s contents, which are the concatenation of the
+  //!     buffers, in order.
+  const std::vector<Buffer>& buffers() const { return buffers_; }
+
+  //! \brief Transfers the file’s contents to the caller, leaving the file
+  //!     empty with its position at `0`.
+  //!
+  //! \return The buffers, in order. None is empty.
+  std::vector<Buffer> TakeBuffers();
+
+  // FileWriterInterface:
+  bool Write(const void* data, size_t size) override;
+  bool WriteIoVec(std::vector<WritableIoVec>* iovecs) override;
+
+  // FileSeekerInterface:
+  FileOffset Seek(FileOffset offset, int whence) override;
+
+ private:
+  // Copies |size| bytes from |data| over the contents at |offset|, all of which
+  // must already have been written.
+  void Overwrite(size_t offset, const uint8_t* data, size_t size);
+
+  // Appends |size| bytes from |data|, or zeroes if |data| is nullptr.
+  void Append(const uint8_t* data, size_t size);
+
+  std::vector<Buffer> buffers_;
+
+  // The offset in the file of the start of each of buffers_. Only the last of
+  // buffers_ ever grows, so these don’t change once recorded.
+  std::vector<size_t> buffer_offsets_;
+
+  size_t size_;
+  size_t offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChunkedBufferFile);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_CHUNKED_BUFFER_FILE_H_
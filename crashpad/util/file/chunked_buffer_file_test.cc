@@ -0,0 +1,142 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/chunked_buffer_file.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+std::string Contents(const std::vector<ChunkedBufferFile::Buffer>& buffers) {
+  std::string contents;
+  for (const ChunkedBufferFile::Buffer& buffer : buffers) {
+    contents.append(buffer.begin(), buffer.end());
+  }
+  return contents;
+}
+
+TEST(ChunkedBufferFile, EmptyFile) {
+  ChunkedBufferFile file;
+  EXPECT_EQ(file.size(), 0u);
+  EXPECT_EQ(file.Seek(0, SEEK_CUR), 0);
+  EXPECT_TRUE(file.Write("", 0));
+  EXPECT_EQ(file.size(), 0u);
+  EXPECT_TRUE(file.TakeBuffers().empty());
+}
+
+TEST(ChunkedBufferFile, GrowsWithoutMoving) {
+  ChunkedBufferFile file;
+  const std::string first(ChunkedBufferFile::kMinimumBufferSize - 1, 'a');
+  ASSERT_TRUE(file.Write(first.data(), first.size()));
+  ASSERT_EQ(file.buffers().size(), 1u);
+  const uint8_t* first_data = file.buffers()[0].data();
+
+  // This fills the first buffer and spills into a second.
+  const std::string second(ChunkedBufferFile::kMinimumBufferSize, 'b');
+  ASSERT_TRUE(file.Write(second.data(), second.size()));
+  ASSERT_EQ(file.buffers().size(), 2u);
+  EXPECT_EQ(file.buffers()[0].data(), first_data);
+  EXPECT_EQ(file.buffers()[0].size(), ChunkedBufferFile::kMinimumBufferSize);
+  EXPECT_EQ(file.size(), first.size() + second.size());
+  EXPECT_EQ(file.Seek(0, SEEK_CUR),
+            static_cast<FileOffset>(first.size() + second.size()));
+
+  EXPECT_EQ(Contents(file.TakeBuffers()), first + second);
+  EXPECT_EQ(file.size(), 0u);
+  EXPECT_EQ(file.Seek(0, SEEK_CUR), 0);
+  EXPECT_TRUE(file.buffers().empty());
+}
+
+TEST(ChunkedBufferFile, Reserve) {
+  constexpr size_t kSize = 3 * ChunkedBufferFile::kMinimumBufferSize;
+  ChunkedBufferFile file;
+  file.Reserve(kSize);
+  ASSERT_EQ(file.buffers().size(), 1u);
+  EXPECT_GE(file.buffers()[0].capacity(), kSize);
+
+  const std::string contents(kSize, 'c');
+  constexpr size_t kWriteSize = 1000;
+  for (size_t offset = 0; offset < kSize; offset += kWriteSize) {
+    ASSERT_TRUE(
+        file.Write(&contents[offset], std::min(kSize - offset, kWriteSize)));
+  }
+
+  std::vector<ChunkedBufferFile::Buffer> buffers = file.TakeBuffers();
+  ASSERT_EQ(buffers.size(), 1u);
+  EXPECT_EQ(Contents(buffers), contents);
+
+  // Reserving less than has been written has no effect.
+  ASSERT_TRUE(file.Write("d", 1));
+  file.Reserve(1);
+  EXPECT_EQ(file.buffers().size(), 1u);
+}
+
+TEST(ChunkedBufferFile, SeekAndOverwrite) {
+  ChunkedBufferFile file;
+  const std::string first(ChunkedBufferFile::kMinimumBufferSize, 'a');
+  const std::string second(10, 'b');
+  ASSERT_TRUE(file.Write(first.data(), first.size()));
+  ASSERT_TRUE(file.Write(second.data(), second.size()));
+  ASSERT_EQ(file.buffers().size(), 2u);
+
+  // A write that straddles the buffers replaces what was there.
+  const FileOffset straddle = ChunkedBufferFile::kMinimumBufferSize - 2;
+  EXPECT_EQ(file.Seek(straddle, SEEK_SET), straddle);
+  ASSERT_TRUE(file.Write("wxyz", 4));
+  EXPECT_EQ(file.Seek(0, SEEK_CUR), straddle + 4);
+  EXPECT_EQ(file.size(), first.size() + second.size());
+
+  // A write past the end fills the gap with zeroes.
+  EXPECT_EQ(file.Seek(2, SEEK_END),
+            static_cast<FileOffset>(first.size() + second.size() + 2));
+  ASSERT_TRUE(file.Write("e", 1));
+
+  EXPECT_EQ(file.Seek(-1, SEEK_SET), -1);
+  EXPECT_EQ(file.Seek(0, 3), -1);
+
+  std::string expected = first + second;
+  expected.replace(straddle, 4, "wxyz");
+  expected.append(2, '\0');
+  expected.append("e");
+  EXPECT_EQ(Contents(file.buffers()), expected);
+}
+
+TEST(ChunkedBufferFile, WriteIoVec) {
+  ChunkedBufferFile file;
+  std::vector<WritableIoVec> iovecs;
+  WritableIoVec iov;
+  iov.iov_base = "ab";
+  iov.iov_len = 2;
+  iovecs.push_back(iov);
+  iov.iov_base = "cde";
+  iov.iov_len = 3;
+  iovecs.push_back(iov);
+  ASSERT_TRUE(file.WriteIoVec(&iovecs));
+  EXPECT_EQ(Contents(file.buffers()), "abcde");
+
+  iovecs.clear();
+  EXPECT_FALSE(file.WriteIoVec(&iovecs));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,124 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_DIRECTORY_CHANGE_WATCHER_H_
+#define CRASHPAD_UTIL_FILE_DIRECTORY_CHANGE_WATCHER_H_
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "build/build_config.h"
+#include "util/misc/initialization_state_dcheck.h"
+#include "util/thread/thread.h"
+
+#if defined(OS_POSIX)
+#include "base/files/scoped_file.h"
+#elif defined(OS_WIN)
+#include "util/win/scoped_handle.h"
+#endif  // OS_POSIX
+
+namespace crashpad {
+
+//! \brief Watches a directory for files being written to or moved into it,
+//!     notifying a delegate on a dedicated thread.
+//!
+//! This uses inotify on Linux and Android, a kqueue `EVFILT_VNODE` filter on
+//! macOS, and `ReadDirectoryChangesW()` on Windows. The delegate is notified
+//! that the directory may have changed, and not of what changed. Changes that
+//! occur in quick succession may result in a single notification. On Windows,
+//! changes within the directory’s subdirectories are reported too.
+class DirectoryChangeWatcher final : public Thread {
+ public:
+  //! \brief An interface for receiving change notifications.
+  class Delegate {
+   public:
+    //! \brief Called on the watcher’s thread when files in the watched
+    //!     directory may have been written to, or moved into it.
+    virtual void DirectoryChanged() = 0;
+
+   protected:
+    ~Delegate() {}
+  };
+
+  DirectoryChangeWatcher();
+  ~DirectoryChangeWatcher() override;
+
+  //! \brief Begins watching \a directory.
+  //!
+  //! Changes that occur after this method returns successfully are reported
+  //! once Start() is called.
+  //!
+  //! \param[in] directory The directory to watch.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool Initialize(const base::FilePath& directory);
+
+  //! \brief Starts a dedicated thread that calls Delegate::DirectoryChanged()
+  //!     when the directory changes.
+  //!
+  //! This method may be called after Initialize() has succeeded, and again
+  //! after Stop(). Changes that occur while the thread is stopped may not be
+  //! reported.
+  //!
+  //! \param[in] delegate The delegate to notify. It must outlive the thread.
+  void Start(Delegate* delegate);
+
+  //! \brief Stops the thread started by Start(), and waits for it to exit.
+  //!
+  //! This method must be called after Start(), and before destroying the
+  //! object. It may not be called from the watcher’s thread.
+  void Stop();
+
+ private:
+  // Thread:
+  void ThreadMain() override;
+
+#if defined(OS_WIN)
+  // Begins an asynchronous ReadDirectoryChangesW() operation, which completes
+  // when the directory changes. Returns false with a message logged on
+  // failure.
+  bool ReadDirectoryChanges();
+
+  // Cancels any outstanding ReadDirectoryChangesW() operation, waiting for it
+  // to complete.
+  void CancelReadDirectoryChanges();
+#endif  // OS_WIN
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  base::ScopedFD inotify_fd_;
+  base::ScopedFD stop_fd_;  // An eventfd.
+#elif defined(OS_MACOSX)
+  base::ScopedFD directory_fd_;
+  base::ScopedFD kqueue_fd_;
+#elif defined(OS_WIN)
+  ScopedFileHANDLE directory_handle_;
+  ScopedKernelHANDLE change_event_;
+  ScopedKernelHANDLE stop_event_;
+  OVERLAPPED overlapped_;
+
+  // The notification records are not examined, but ReadDirectoryChangesW()
+  // requires a buffer to place them in. If they overflow it, the operation
+  // still completes, which is sufficient to signal a change.
+  alignas(DWORD) char buffer_[4096];
+  bool read_pending_;
+#endif  // OS_LINUX || OS_ANDROID
+
+  Delegate* delegate_;  // weak
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(DirectoryChangeWatcher);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_DIRECTORY_CHANGE_WATCHER_H_
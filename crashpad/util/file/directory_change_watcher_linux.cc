@@ -0,0 +1,131 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/directory_change_watcher.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace crashpad {
+
+DirectoryChangeWatcher::DirectoryChangeWatcher()
+    : Thread(),
+      inotify_fd_(),
+      stop_fd_(),
+      delegate_(nullptr),
+      initialized_() {
+}
+
+DirectoryChangeWatcher::~DirectoryChangeWatcher() {
+}
+
+bool DirectoryChangeWatcher::Initialize(const base::FilePath& directory) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  inotify_fd_.reset(inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+  if (!inotify_fd_.is_valid()) {
+    PLOG(ERROR) << "inotify_init1";
+    return false;
+  }
+
+  if (inotify_add_watch(inotify_fd_.get(),
+                        directory.value().c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) < 0) {
+    PLOG(ERROR) << "inotify_add_watch " << directory.value();
+    return false;
+  }
+
+  stop_fd_.reset(eventfd(0, EFD_CLOEXEC));
+  if (!stop_fd_.is_valid()) {
+    PLOG(ERROR) << "eventfd";
+    return false;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+void DirectoryChangeWatcher::Start(Delegate* delegate) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(!delegate_);
+
+  delegate_ = delegate;
+  Thread::Start();
+}
+
+void DirectoryChangeWatcher::Stop() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(delegate_);
+
+  const uint64_t value = 1;
+  if (HANDLE_EINTR(write(stop_fd_.get(), &value, sizeof(value))) !=
+      sizeof(value)) {
+    PLOG(ERROR) << "write";
+  }
+  Join();
+  delegate_ = nullptr;
+}
+
+void DirectoryChangeWatcher::ThreadMain() {
+  pollfd fds[2] = {};
+  fds[0].fd = inotify_fd_.get();
+  fds[0].events = POLLIN;
+  fds[1].fd = stop_fd_.get();
+  fds[1].events = POLLIN;
+
+  while (true) {
+    if (HANDLE_EINTR(poll(fds, arraysize(fds), -1)) < 0) {
+      PLOG(ERROR) << "poll";
+      return;
+    }
+
+    if (fds[1].revents) {
+      // Reset the eventfd’s counter, so that the thread can be restarted.
+      uint64_t value;
+      if (HANDLE_EINTR(read(stop_fd_.get(), &value, sizeof(value))) !=
+          sizeof(value)) {
+        PLOG(ERROR) << "read";
+      }
+      return;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      // Drain all pending events, reporting them together. Only the fact that
+      // the directory changed is of interest, not the events themselves.
+      alignas(inotify_event) char buffer[4096];
+      ssize_t rv;
+      do {
+        rv = HANDLE_EINTR(read(inotify_fd_.get(), buffer, sizeof(buffer)));
+      } while (rv > 0);
+      if (rv < 0 && errno != EAGAIN) {
+        PLOG(ERROR) << "read";
+        return;
+      }
+
+      delegate_->DirectoryChanged();
+    } else if (fds[0].revents) {
+      LOG(ERROR) << "poll: unexpected revents " << fds[0].revents;
+      return;
+    }
+  }
+}
+
+}  // namespace crashpad
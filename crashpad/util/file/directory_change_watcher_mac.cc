@@ -0,0 +1,134 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/directory_change_watcher.h"
+
+#include <fcntl.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace crashpad {
+
+namespace {
+
+// The identifier of the EVFILT_USER event that Stop() triggers.
+constexpr uintptr_t kStopIdent = 0;
+
+}  // namespace
+
+DirectoryChangeWatcher::DirectoryChangeWatcher()
+    : Thread(),
+      directory_fd_(),
+      kqueue_fd_(),
+      delegate_(nullptr),
+      initialized_() {
+}
+
+DirectoryChangeWatcher::~DirectoryChangeWatcher() {
+}
+
+bool DirectoryChangeWatcher::Initialize(const base::FilePath& directory) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  directory_fd_.reset(HANDLE_EINTR(
+      open(directory.value().c_str(), O_EVTONLY | O_DIRECTORY | O_CLOEXEC)));
+  if (!directory_fd_.is_valid()) {
+    PLOG(ERROR) << "open " << directory.value();
+    return false;
+  }
+
+  kqueue_fd_.reset(kqueue());
+  if (!kqueue_fd_.is_valid()) {
+    PLOG(ERROR) << "kqueue";
+    return false;
+  }
+
+  // A directory’s vnode receives NOTE_WRITE when entries are added to it or
+  // removed from it, including by rename().
+  struct kevent changes[2];
+  EV_SET(&changes[0],
+         directory_fd_.get(),
+         EVFILT_VNODE,
+         EV_ADD | EV_CLEAR,
+         NOTE_WRITE,
+         0,
+         nullptr);
+  EV_SET(&changes[1],
+         kStopIdent,
+         EVFILT_USER,
+         EV_ADD | EV_CLEAR,
+         0,
+         0,
+         nullptr);
+  if (kevent(kqueue_fd_.get(), changes, arraysize(changes), nullptr, 0,
+             nullptr) != 0) {
+    PLOG(ERROR) << "kevent";
+    return false;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+void DirectoryChangeWatcher::Start(Delegate* delegate) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(!delegate_);
+
+  delegate_ = delegate;
+  Thread::Start();
+}
+
+void DirectoryChangeWatcher::Stop() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(delegate_);
+
+  struct kevent change;
+  EV_SET(&change, kStopIdent, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+  if (kevent(kqueue_fd_.get(), &change, 1, nullptr, 0, nullptr) != 0) {
+    PLOG(ERROR) << "kevent";
+  }
+  Join();
+  delegate_ = nullptr;
+}
+
+void DirectoryChangeWatcher::ThreadMain() {
+  while (true) {
+    struct kevent event;
+    int rv = HANDLE_EINTR(
+        kevent(kqueue_fd_.get(), nullptr, 0, &event, 1, nullptr));
+    if (rv < 0) {
+      PLOG(ERROR) << "kevent";
+      return;
+    }
+    if (rv == 0) {
+      continue;
+    }
+
+    if (event.filter == EVFILT_USER) {
+      return;
+    }
+    if (event.flags & EV_ERROR) {
+      LOG(ERROR) << "kevent: error " << event.data;
+      return;
+    }
+
+    delegate_->DirectoryChanged();
+  }
+}
+
+}  // namespace crashpad
@@ -0,0 +1,111 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/directory_change_watcher.h"
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "gtest/gtest.h"
+#include "test/scoped_temp_dir.h"
+#include "util/file/file_writer.h"
+#include "util/synchronization/semaphore.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+class TestDelegate : public DirectoryChangeWatcher::Delegate {
+ public:
+  TestDelegate() : DirectoryChangeWatcher::Delegate(), semaphore_(0) {}
+  ~TestDelegate() {}
+
+  // Waits for DirectoryChanged() to be called, returning false if it is not
+  // called within a generous timeout.
+  bool WaitForChange() { return semaphore_.TimedWait(5); }
+
+  // DirectoryChangeWatcher::Delegate:
+  void DirectoryChanged() override { semaphore_.Signal(); }
+
+ private:
+  Semaphore semaphore_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestDelegate);
+};
+
+void WriteTestFile(const base::FilePath& path) {
+  FileWriter writer;
+  ASSERT_TRUE(writer.Open(path,
+                          FileWriteMode::kTruncateOrCreate,
+                          FilePermissions::kOwnerOnly));
+  ASSERT_TRUE(writer.Write("test", 4));
+  writer.Close();
+}
+
+TEST(DirectoryChangeWatcher, FileWritten) {
+  ScopedTempDir temp_dir;
+
+  DirectoryChangeWatcher watcher;
+  ASSERT_TRUE(watcher.Initialize(temp_dir.path()));
+
+  TestDelegate delegate;
+  watcher.Start(&delegate);
+
+  WriteTestFile(temp_dir.path().Append(FILE_PATH_LITERAL("file_1")));
+  EXPECT_TRUE(delegate.WaitForChange());
+
+  // The watcher continues to report changes after the first.
+  WriteTestFile(temp_dir.path().Append(FILE_PATH_LITERAL("file_2")));
+  EXPECT_TRUE(delegate.WaitForChange());
+
+  watcher.Stop();
+}
+
+TEST(DirectoryChangeWatcher, ChangeBeforeStart) {
+  ScopedTempDir temp_dir;
+
+  DirectoryChangeWatcher watcher;
+  ASSERT_TRUE(watcher.Initialize(temp_dir.path()));
+
+  // A change made between Initialize() and Start() is reported once started.
+  WriteTestFile(temp_dir.path().Append(FILE_PATH_LITERAL("file")));
+
+  TestDelegate delegate;
+  watcher.Start(&delegate);
+  EXPECT_TRUE(delegate.WaitForChange());
+
+  watcher.Stop();
+}
+
+TEST(DirectoryChangeWatcher, StopWithoutChange) {
+  ScopedTempDir temp_dir;
+
+  DirectoryChangeWatcher watcher;
+  ASSERT_TRUE(watcher.Initialize(temp_dir.path()));
+
+  TestDelegate delegate;
+  watcher.Start(&delegate);
+  watcher.Stop();
+}
+
+TEST(DirectoryChangeWatcher, NonexistentDirectory) {
+  ScopedTempDir temp_dir;
+
+  DirectoryChangeWatcher watcher;
+  EXPECT_FALSE(watcher.Initialize(
+      temp_dir.path().Append(FILE_PATH_LITERAL("nonexistent"))));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,173 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/directory_change_watcher.h"
+
+#include <string.h>
+#include <windows.h>
+
+#include "base/logging.h"
+#include "base/strings/utf_string_conversions.h"
+
+namespace crashpad {
+
+DirectoryChangeWatcher::DirectoryChangeWatcher()
+    : Thread(),
+      directory_handle_(),
+      change_event_(),
+      stop_event_(),
+      overlapped_(),
+      read_pending_(false),
+      delegate_(nullptr),
+      initialized_() {
+}
+
+DirectoryChangeWatcher::~DirectoryChangeWatcher() {
+  CancelReadDirectoryChanges();
+}
+
+bool DirectoryChangeWatcher::Initialize(const base::FilePath& directory) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  directory_handle_.reset(
+      CreateFile(directory.value().c_str(),
+                 FILE_LIST_DIRECTORY,
+                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                 nullptr,
+                 OPEN_EXISTING,
+                 FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                 nullptr));
+  if (!directory_handle_.is_valid()) {
+    PLOG(ERROR) << "CreateFile " << base::UTF16ToUTF8(directory.value());
+    return false;
+  }
+
+  change_event_.reset(CreateEvent(nullptr, true, false, nullptr));
+  stop_event_.reset(CreateEvent(nullptr, true, false, nullptr));
+  if (!change_event_.is_valid() || !stop_event_.is_valid()) {
+    PLOG(ERROR) << "CreateEvent";
+    return false;
+  }
+
+  // Changes are only recorded once the first read has been issued, so issue it
+  // now rather than on the watcher’s thread.
+  if (!ReadDirectoryChanges())
+    return false;
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+void DirectoryChangeWatcher::Start(Delegate* delegate) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(!delegate_);
+
+  delegate_ = delegate;
+
+  // Stop() cancels the outstanding read, so if the thread is being restarted,
+  // a new read is needed.
+  if (!read_pending_) {
+    ReadDirectoryChanges();
+  }
+
+  Thread::Start();
+}
+
+void DirectoryChangeWatcher::Stop() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(delegate_);
+
+  if (!SetEvent(stop_event_.get())) {
+    PLOG(ERROR) << "SetEvent";
+  }
+  Join();
+
+  if (!ResetEvent(stop_event_.get())) {
+    PLOG(ERROR) << "ResetEvent";
+  }
+  delegate_ = nullptr;
+}
+
+void DirectoryChangeWatcher::ThreadMain() {
+  while (read_pending_) {
+    HANDLE handles[] = {change_event_.get(), stop_event_.get()};
+    DWORD result =
+        WaitForMultipleObjects(arraysize(handles), handles, false, INFINITE);
+    if (result != WAIT_OBJECT_0) {
+      PLOG_IF(ERROR, result != WAIT_OBJECT_0 + 1) << "WaitForMultipleObjects";
+      CancelReadDirectoryChanges();
+      return;
+    }
+
+    read_pending_ = false;
+    DWORD bytes_transferred;
+    if (!GetOverlappedResult(directory_handle_.get(),
+                             &overlapped_,
+                             &bytes_transferred,
+                             false)) {
+      PLOG(ERROR) << "GetOverlappedResult";
+      return;
+    }
+
+    // Issue the next read before notifying the delegate, so that changes made
+    // while the delegate runs are not missed.
+    if (!ReadDirectoryChanges()) {
+      return;
+    }
+
+    delegate_->DirectoryChanged();
+  }
+}
+
+bool DirectoryChangeWatcher::ReadDirectoryChanges() {
+  DCHECK(!read_pending_);
+
+  memset(&overlapped_, 0, sizeof(overlapped_));
+  overlapped_.hEvent = change_event_.get();
+  if (!ResetEvent(change_event_.get())) {
+    PLOG(ERROR) << "ResetEvent";
+    return false;
+  }
+
+  if (!ReadDirectoryChangesW(
+          directory_handle_.get(),
+          buffer_,
+          sizeof(buffer_),
+          true,
+          FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+          nullptr,
+          &overlapped_,
+          nullptr)) {
+    PLOG(ERROR) << "ReadDirectoryChangesW";
+    return false;
+  }
+
+  read_pending_ = true;
+  return true;
+}
+
+void DirectoryChangeWatcher::CancelReadDirectoryChanges() {
+  if (!read_pending_)
+    return;
+
+  // The operation must be complete before |overlapped_| and |buffer_| go away.
+  // It may have been issued on another thread, so CancelIo() won’t do.
+  CancelIoEx(directory_handle_.get(), &overlapped_);
+  DWORD bytes_transferred;
+  GetOverlappedResult(
+      directory_handle_.get(), &overlapped_, &bytes_transferred, true);
+  read_pending_ = false;
+}
+
+}  // namespace crashpad
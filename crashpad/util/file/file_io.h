@@ -449,6 +449,106 @@ FileOffset LoggingSeekFile(FileHandle file, FileOffset offset, int whence);
 //! \return `true` on success, or `false`, and a message will be logged.
 bool LoggingTruncateFile(FileHandle file);
 
+//! \brief Wraps `rename()` or `MoveFileEx()`, logging an error if the
+//!     operation fails.
+//!
+//! \a from and \a to must be on the same file system. If \a to exists, it is
+//! replaced on POSIX, and the operation fails on Windows.
+//!
+//! \return `true` on success, or `false` and a message will be logged.
+bool LoggingMoveFile(const base::FilePath& from, const base::FilePath& to);
+
+//! \brief Makes \a to a copy of the file at \a from without copying its
+//!     contents, logging an error if this isn’t possible.
+//!
+//! Where the file system supports it, \a to is a copy-on-write clone of \a
+//! from, made with `clonefile()` on macOS or the `FICLONE` ioctl on Linux and
+//! Android, so that later changes to either file don’t affect the other.
+//! Otherwise, and always on Windows, \a to is a hard link to \a from, which
+//! continues to share its contents. Either way, \a to remains after \a from is
+//! deleted or replaced.
+//!
+//! \a from and \a to must be on the same file system, and \a to must not
+//! exist.
+//!
+//! \return `true` on success, or `false` and a message will be logged.
+bool LoggingCloneFile(const base::FilePath& from, const base::FilePath& to);
+
+//! \brief Reserves storage for a file without changing its size.
+//!
+//! This uses `fallocate()` on Linux and Android, `fcntl(F_PREALLOCATE)` on
+//! macOS, and `SetFileInformationByHandle(FileAllocationInfo)` on Windows. It
+//! allows a file that will be extended by many writes to be allocated at once,
+//! which avoids repeated metadata updates and fragmentation. Storage left
+//! unused can be returned with LoggingReleaseUnusedFileStorage().
+//!
+//! \param[in] file The file, open for writing.
+//! \param[in] size The number of bytes to reserve, from the start of the file.
+//!
+//! \return `true` on success, or `false` and a message will be logged. Failure
+//!     is expected on file systems that don’t support reserving storage.
+bool LoggingReserveFileStorage(FileHandle file, FileOffset size);
+
+//! \brief Releases storage reserved beyond the end of a file by
+//!     LoggingReserveFileStorage().
+//!
+//! \return `true` on success, or `false` and a message will be logged.
+bool LoggingReleaseUnusedFileStorage(FileHandle file);
+
+//! \brief Marks a file as sparse, so that ranges seeked past rather than
+//!     written need not occupy storage.
+//!
+//! On Windows, this uses `FSCTL_SET_SPARSE`, without which NTFS allocates and
+//! zero-fills every range seeked past. On POSIX, file systems that support
+//! sparse files leave such ranges unallocated without being asked, and this
+//! does nothing. Storage reserved by LoggingReserveFileStorage() is allocated
+//! regardless.
+//!
+//! \return `true` on success, or `false` and a message will be logged. Failure
+//!     is expected on file systems that don’t support sparse files.
+bool LoggingSetFileSparse(FileHandle file);
+
+//! \brief Advises the operating system that the contents of \a file need not
+//!     be kept in its cache.
+//!
+//! This is meant for files that are written once and not soon read, so that
+//! writing them doesn’t displace more useful data from the cache. It should be
+//! called both once \a file is opened and once it has been written. On macOS,
+//! this disables caching of subsequent reads and writes with `F_NOCACHE`. On
+//! Linux and Android, this writes data already written to disk and then drops
+//! it from the cache with `posix_fadvise()`. On Windows, this does nothing,
+//! because `FILE_FLAG_NO_BUFFERING` requires every write to be aligned to the
+//! volume’s sector size.
+//!
+//! \return `true` on success, or `false` and a message will be logged.
+bool LoggingDiscardFileCache(FileHandle file);
+
+//! \brief Writes the contents of \a file to its storage device, returning once
+//!     they are durable.
+//!
+//! On Linux and Android, this uses `fdatasync()`. On macOS, `fsync()` only
+//! hands data to the drive, which may hold it in a volatile cache, so this uses
+//! `F_FULLFSYNC`, falling back to `fsync()` on file systems that don’t support
+//! it. On Windows, this uses `FlushFileBuffers()`, which requires \a file to
+//! have been opened for writing.
+//!
+//! This can take tens of milliseconds, so it shouldn’t be called where latency
+//! matters more than durability.
+//!
+//! \return `true` on success, or `false` and a message will be logged.
+bool LoggingFlushFile(FileHandle file);
+
+//! \brief Makes the entries of the directory at \a path durable, so that files
+//!     created in, renamed into, or removed from it remain so after a power
+//!     failure.
+//!
+//! On POSIX, this opens the directory and calls `fsync()` on it. On Windows,
+//! NTFS records changes to directories in its journal, which is written
+//! through by LoggingFlushFile(), so this does nothing.
+//!
+//! \return `true` on success, or `false` and a message will be logged.
+bool LoggingFlushDirectory(const base::FilePath& path);
+
 //! \brief Wraps `close()` or `CloseHandle()`, logging an error if the operation
 //!     fails.
 //!
@@ -14,17 +14,26 @@
 
 #include "util/file/file_io.h"
 
+#include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
 #include <sys/file.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <sys/ioctl.h>
+#elif defined(OS_MACOSX)
+#include <dlfcn.h>
+#endif
+
 #include <algorithm>
 #include <limits>
 
 #include "base/files/file_path.h"
 #include "base/logging.h"
 #include "base/posix/eintr_wrapper.h"
+#include "build/build_config.h"
 
 namespace crashpad {
 
@@ -174,6 +183,175 @@ bool LoggingTruncateFile(FileHandle file) {
   return true;
 }
 
+bool LoggingMoveFile(const base::FilePath& from, const base::FilePath& to) {
+  if (rename(from.value().c_str(), to.value().c_str()) != 0) {
+    PLOG(ERROR) << "rename " << from.value() << " to " << to.value();
+    return false;
+  }
+  return true;
+}
+
+bool LoggingCloneFile(const base::FilePath& from, const base::FilePath& to) {
+#if defined(OS_MACOSX)
+  // clonefile() is only available on macOS 10.12 and later, and only clones
+  // files on APFS.
+  using CloneFileType = int (*)(const char*, const char*, uint32_t);
+  static const CloneFileType clone_file =
+      reinterpret_cast<CloneFileType>(dlsym(RTLD_DEFAULT, "clonefile"));
+  if (clone_file &&
+      clone_file(from.value().c_str(), to.value().c_str(), 0) == 0) {
+    return true;
+  }
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+#if !defined(FICLONE)
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+  {
+    // FICLONE is supported by Btrfs, XFS, and some others. Elsewhere, the empty
+    // file is removed so that a hard link can take its place.
+    int from_fd = HANDLE_EINTR(
+        open(from.value().c_str(), O_RDONLY | O_NOCTTY | O_CLOEXEC));
+    if (from_fd < 0) {
+      PLOG(ERROR) << "open " << from.value();
+      return false;
+    }
+    int to_fd = HANDLE_EINTR(open(to.value().c_str(),
+                                  O_WRONLY | O_CREAT | O_EXCL | O_NOCTTY |
+                                      O_CLOEXEC,
+                                  0600));
+    if (to_fd < 0) {
+      PLOG(ERROR) << "open " << to.value();
+      IGNORE_EINTR(close(from_fd));
+      return false;
+    }
+    const bool cloned = ioctl(to_fd, FICLONE, from_fd) == 0;
+    IGNORE_EINTR(close(to_fd));
+    IGNORE_EINTR(close(from_fd));
+    if (cloned) {
+      return true;
+    }
+    if (unlink(to.value().c_str()) != 0) {
+      PLOG(ERROR) << "unlink " << to.value();
+      return false;
+    }
+  }
+#endif
+
+  if (link(from.value().c_str(), to.value().c_str()) != 0) {
+    PLOG(ERROR) << "link " << from.value() << " to " << to.value();
+    return false;
+  }
+  return true;
+}
+
+bool LoggingReserveFileStorage(FileHandle file, FileOffset size) {
+#if defined(OS_MACOSX)
+  fstore_t store = {};
+  store.fst_flags = F_ALLOCATECONTIG;
+  store.fst_posmode = F_PEOFPOSMODE;
+  store.fst_offset = 0;
+  store.fst_length = size;
+  if (fcntl(file, F_PREALLOCATE, &store) != 0) {
+    // Contiguous storage may not be available, but any storage reserved at
+    // once is still better than storage allocated write by write.
+    store.fst_flags = F_ALLOCATEALL;
+    if (fcntl(file, F_PREALLOCATE, &store) != 0) {
+      PLOG(WARNING) << "fcntl F_PREALLOCATE";
+      return false;
+    }
+  }
+  return true;
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+  if (HANDLE_EINTR(fallocate(file, FALLOC_FL_KEEP_SIZE, 0, size)) != 0) {
+    PLOG(WARNING) << "fallocate";
+    return false;
+  }
+  return true;
+#else
+#error Port
+#endif
+}
+
+bool LoggingReleaseUnusedFileStorage(FileHandle file) {
+  // Truncating a file to its own size releases storage reserved past its end.
+  FileOffset size = LoggingFileSizeByHandle(file);
+  if (size < 0) {
+    return false;
+  }
+  if (HANDLE_EINTR(ftruncate(file, size)) != 0) {
+    PLOG(ERROR) << "ftruncate";
+    return false;
+  }
+  return true;
+}
+
+bool LoggingSetFileSparse(FileHandle file) {
+  return true;
+}
+
+bool LoggingDiscardFileCache(FileHandle file) {
+#if defined(OS_MACOSX)
+  if (fcntl(file, F_NOCACHE, 1) != 0) {
+    PLOG(WARNING) << "fcntl F_NOCACHE";
+    return false;
+  }
+  return true;
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+  // Only clean pages can be dropped, so anything written must reach the disk
+  // first.
+  if (HANDLE_EINTR(fdatasync(file)) != 0) {
+    PLOG(WARNING) << "fdatasync";
+    return false;
+  }
+  int rv = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+  if (rv != 0) {
+    errno = rv;
+    PLOG(WARNING) << "posix_fadvise";
+    return false;
+  }
+  return true;
+#else
+#error Port
+#endif
+}
+
+bool LoggingFlushFile(FileHandle file) {
+#if defined(OS_MACOSX)
+  if (fcntl(file, F_FULLFSYNC) == 0) {
+    return true;
+  }
+  // Some file systems, such as those mounted over a network, don’t support
+  // F_FULLFSYNC. fsync() is the best that can be done for them.
+  if (HANDLE_EINTR(fsync(file)) != 0) {
+    PLOG(ERROR) << "fsync";
+    return false;
+  }
+  return true;
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+  if (HANDLE_EINTR(fdatasync(file)) != 0) {
+    PLOG(ERROR) << "fdatasync";
+    return false;
+  }
+  return true;
+#else
+#error Port
+#endif
+}
+
+bool LoggingFlushDirectory(const base::FilePath& path) {
+  ScopedFileHandle directory(HANDLE_EINTR(
+      open(path.value().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)));
+  if (!directory.is_valid()) {
+    PLOG(ERROR) << "open " << path.value();
+    return false;
+  }
+  if (HANDLE_EINTR(fsync(directory.get())) != 0) {
+    PLOG(ERROR) << "fsync " << path.value();
+    return false;
+  }
+  return true;
+}
+
 bool LoggingCloseFile(FileHandle file) {
   int rv = IGNORE_EINTR(close(file));
   PLOG_IF(ERROR, rv != 0) << "close";
@@ -15,8 +15,10 @@
 #include "util/file/file_io.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include <limits>
+#include <string>
 #include <type_traits>
 
 #include "base/atomicops.h"
@@ -548,6 +550,32 @@ TEST(FileIO, MultipleSharedLocks) {
   EXPECT_TRUE(LoggingUnlockFile(handle2.get()));
 }
 
+TEST(FileIO, LoggingCloneFile) {
+  ScopedTempDir temp_dir;
+  base::FilePath from = temp_dir.path().Append(FILE_PATH_LITERAL("from"));
+  base::FilePath to = temp_dir.path().Append(FILE_PATH_LITERAL("to"));
+
+  constexpr char kData[] = "attachment";
+  {
+    ScopedFileHandle handle(LoggingOpenFileForWrite(
+        from, FileWriteMode::kCreateOrFail, FilePermissions::kOwnerOnly));
+    ASSERT_NE(handle, kInvalidFileHandle);
+    ASSERT_TRUE(LoggingWriteFile(handle.get(), kData, strlen(kData)));
+  }
+
+  ASSERT_TRUE(LoggingCloneFile(from, to));
+  EXPECT_TRUE(FileExists(from));
+
+  ScopedFileHandle handle(LoggingOpenFileForRead(to));
+  ASSERT_NE(handle, kInvalidFileHandle);
+  char data[sizeof(kData)] = {};
+  EXPECT_TRUE(LoggingReadFileExactly(handle.get(), data, strlen(kData)));
+  EXPECT_STREQ(data, kData);
+
+  // The destination must not already exist.
+  EXPECT_FALSE(LoggingCloneFile(to, to));
+}
+
 class LockingTestThread : public Thread {
  public:
   LockingTestThread()
@@ -666,6 +694,82 @@ TEST(FileIO, FileSizeByHandle) {
   EXPECT_EQ(LoggingFileSizeByHandle(file_handle.get()), 9);
 }
 
+TEST(FileIO, ReserveFileStorage) {
+  ScopedTempDir temp_dir;
+  base::FilePath file_path =
+      temp_dir.path().Append(FILE_PATH_LITERAL("reserved"));
+
+  ScopedFileHandle file_handle(LoggingOpenFileForWrite(
+      file_path, FileWriteMode::kCreateOrFail, FilePermissions::kOwnerOnly));
+  ASSERT_NE(file_handle.get(), kInvalidFileHandle);
+
+  // Not every file system can reserve storage, but reserving it must never
+  // change the file’s size.
+  LoggingReserveFileStorage(file_handle.get(), 1024 * 1024);
+  EXPECT_EQ(LoggingFileSizeByHandle(file_handle.get()), 0);
+  EXPECT_TRUE(LoggingDiscardFileCache(file_handle.get()));
+
+  static constexpr char data[] = "zippyzap";
+  ASSERT_TRUE(LoggingWriteFile(file_handle.get(), &data, sizeof(data)));
+  EXPECT_EQ(LoggingFileSizeByHandle(file_handle.get()), 9);
+
+  EXPECT_TRUE(LoggingReleaseUnusedFileStorage(file_handle.get()));
+  EXPECT_TRUE(LoggingDiscardFileCache(file_handle.get()));
+  EXPECT_EQ(LoggingFileSizeByHandle(file_handle.get()), 9);
+
+  std::string contents;
+  ASSERT_TRUE(LoggingReadEntireFile(file_path, &contents));
+  EXPECT_EQ(contents, std::string(data, sizeof(data)));
+}
+
+TEST(FileIO, FlushFile) {
+  ScopedTempDir temp_dir;
+  base::FilePath file_path =
+      temp_dir.path().Append(FILE_PATH_LITERAL("flushed"));
+
+  ScopedFileHandle file_handle(LoggingOpenFileForWrite(
+      file_path, FileWriteMode::kCreateOrFail, FilePermissions::kOwnerOnly));
+  ASSERT_NE(file_handle.get(), kInvalidFileHandle);
+
+  static constexpr char data[] = "zippyzap";
+  ASSERT_TRUE(LoggingWriteFile(file_handle.get(), &data, sizeof(data)));
+  EXPECT_TRUE(LoggingFlushFile(file_handle.get()));
+  EXPECT_TRUE(LoggingFlushDirectory(temp_dir.path()));
+
+  std::string contents;
+  ASSERT_TRUE(LoggingReadEntireFile(file_path, &contents));
+  EXPECT_EQ(contents, std::string(data, sizeof(data)));
+}
+
+TEST(FileIO, SetFileSparse) {
+  ScopedTempDir temp_dir;
+  base::FilePath file_path =
+      temp_dir.path().Append(FILE_PATH_LITERAL("sparse"));
+
+  ScopedFileHandle file_handle(LoggingOpenFileForWrite(
+      file_path, FileWriteMode::kCreateOrFail, FilePermissions::kOwnerOnly));
+  ASSERT_NE(file_handle.get(), kInvalidFileHandle);
+
+  // Not every file system supports sparse files, but a range seeked past must
+  // read back as zeroes either way.
+  LoggingSetFileSparse(file_handle.get());
+
+  static constexpr char data[] = "zippyzap";
+  ASSERT_TRUE(LoggingWriteFile(file_handle.get(), &data, sizeof(data)));
+  constexpr FileOffset kHoleSize = 1024 * 1024;
+  ASSERT_EQ(LoggingSeekFile(file_handle.get(), kHoleSize, SEEK_CUR),
+            static_cast<FileOffset>(sizeof(data)) + kHoleSize);
+  ASSERT_TRUE(LoggingWriteFile(file_handle.get(), &data, sizeof(data)));
+  EXPECT_EQ(LoggingFileSizeByHandle(file_handle.get()),
+            static_cast<FileOffset>(2 * sizeof(data)) + kHoleSize);
+
+  std::string contents;
+  ASSERT_TRUE(LoggingReadEntireFile(file_path, &contents));
+  EXPECT_EQ(contents,
+            std::string(data, sizeof(data)) + std::string(kHoleSize, '\0') +
+                std::string(data, sizeof(data)));
+}
+
 FileHandle FileHandleForFILE(FILE* file) {
   int fd = fileno(file);
 #if defined(OS_POSIX)
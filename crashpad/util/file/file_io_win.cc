@@ -14,6 +14,8 @@
 
 #include "util/file/file_io.h"
 
+#include <winioctl.h>
+
 #include <algorithm>
 #include <limits>
 
@@ -246,6 +248,90 @@ bool LoggingTruncateFile(FileHandle file) {
   return true;
 }
 
+bool LoggingMoveFile(const base::FilePath& from, const base::FilePath& to) {
+  if (!MoveFileEx(from.value().c_str(), to.value().c_str(), 0)) {
+    PLOG(ERROR) << "MoveFileEx " << base::UTF16ToUTF8(from.value()) << " to "
+                << base::UTF16ToUTF8(to.value());
+    return false;
+  }
+  return true;
+}
+
+bool LoggingCloneFile(const base::FilePath& from, const base::FilePath& to) {
+  // NTFS has no copy-on-write clones of whole files, so this is always a hard
+  // link.
+  if (!CreateHardLink(to.value().c_str(), from.value().c_str(), nullptr)) {
+    PLOG(ERROR) << "CreateHardLink " << base::UTF16ToUTF8(from.value())
+                << " to " << base::UTF16ToUTF8(to.value());
+    return false;
+  }
+  return true;
+}
+
+bool LoggingReserveFileStorage(FileHandle file, FileOffset size) {
+  FILE_ALLOCATION_INFO allocation_info = {};
+  allocation_info.AllocationSize.QuadPart = size;
+  if (!SetFileInformationByHandle(file,
+                                  FileAllocationInfo,
+                                  &allocation_info,
+                                  sizeof(allocation_info))) {
+    PLOG(WARNING) << "SetFileInformationByHandle";
+    return false;
+  }
+  return true;
+}
+
+bool LoggingReleaseUnusedFileStorage(FileHandle file) {
+  // Setting the allocation size to the file’s size releases anything reserved
+  // past its end.
+  FileOffset size = LoggingFileSizeByHandle(file);
+  if (size < 0) {
+    return false;
+  }
+  FILE_ALLOCATION_INFO allocation_info = {};
+  allocation_info.AllocationSize.QuadPart = size;
+  if (!SetFileInformationByHandle(file,
+                                  FileAllocationInfo,
+                                  &allocation_info,
+                                  sizeof(allocation_info))) {
+    PLOG(ERROR) << "SetFileInformationByHandle";
+    return false;
+  }
+  return true;
+}
+
+bool LoggingSetFileSparse(FileHandle file) {
+  DWORD bytes_returned;
+  if (!DeviceIoControl(file,
+                       FSCTL_SET_SPARSE,
+                       nullptr,
+                       0,
+                       nullptr,
+                       0,
+                       &bytes_returned,
+                       nullptr)) {
+    PLOG(WARNING) << "DeviceIoControl FSCTL_SET_SPARSE";
+    return false;
+  }
+  return true;
+}
+
+bool LoggingDiscardFileCache(FileHandle file) {
+  return true;
+}
+
+bool LoggingFlushFile(FileHandle file) {
+  if (!FlushFileBuffers(file)) {
+    PLOG(ERROR) << "FlushFileBuffers";
+    return false;
+  }
+  return true;
+}
+
+bool LoggingFlushDirectory(const base::FilePath& path) {
+  return true;
+}
+
 bool LoggingCloseFile(FileHandle file) {
   BOOL rv = CloseHandle(file);
   PLOG_IF(ERROR, !rv) << "CloseHandle";
@@ -0,0 +1,169 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/mapped_file_reader.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/numerics/safe_math.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+
+MappedFileReader::MappedFileReader()
+    :
+#if defined(OS_POSIX)
+      mapping_(),
+#elif defined(OS_WIN)
+      view_(nullptr),
+#endif  // OS_POSIX
+      data_(nullptr),
+      size_(0),
+      offset_(0),
+      is_open_(false) {
+}
+
+MappedFileReader::~MappedFileReader() {
+  if (is_open_) {
+    Close();
+  }
+}
+
+bool MappedFileReader::Open(const base::FilePath& path) {
+  CHECK(!is_open_);
+
+  ScopedFileHandle file(LoggingOpenFileForRead(path));
+  if (!file.is_valid()) {
+    return false;
+  }
+
+  return Open(file.get());
+}
+
+bool MappedFileReader::Open(FileHandle file) {
+  CHECK(!is_open_);
+
+  const FileOffset file_size = LoggingFileSizeByHandle(file);
+  if (file_size < 0) {
+    return false;
+  }
+
+  if (!AssignIfInRange(&size_, file_size)) {
+    LOG(ERROR) << "file size " << file_size << " out of range";
+    return false;
+  }
+
+  // An empty file can’t be mapped, but there’s also nothing to map.
+  if (size_ > 0 && !Map(file)) {
+    size_ = 0;
+    return false;
+  }
+
+  // The mapping remains valid after the file is closed.
+  offset_ = 0;
+  is_open_ = true;
+  return true;
+}
+
+void MappedFileReader::Close() {
+  CHECK(is_open_);
+
+  if (data_) {
+    Unmap();
+    data_ = nullptr;
+  }
+
+  size_ = 0;
+  offset_ = 0;
+  is_open_ = false;
+}
+
+const void* MappedFileReader::DataAt(FileOffset offset, size_t size) const {
+  DCHECK(is_open_);
+
+  size_t start;
+  if (!AssignIfInRange(&start, offset) || start > size_ ||
+      size > size_ - start) {
+    LOG(ERROR) << "range " << offset << "+" << size << " outside of file size "
+               << size_;
+    return nullptr;
+  }
+
+  return data_ + start;
+}
+
+FileOperationResult MappedFileReader::Read(void* data, size_t size) {
+  DCHECK(is_open_);
+
+  if (offset_ >= size_) {
+    return 0;
+  }
+
+  const size_t nread = std::min(size, size_ - offset_);
+  if (!base::IsValueInRangeForNumericType<FileOperationResult>(nread)) {
+    LOG(ERROR) << "Read(): size " << nread << " out of range";
+    return -1;
+  }
+
+  memcpy(data, data_ + offset_, nread);
+  offset_ += nread;
+
+  return nread;
+}
+
+FileOffset MappedFileReader::Seek(FileOffset offset, int whence) {
+  DCHECK(is_open_);
+
+  size_t base_offset;
+  switch (whence) {
+    case SEEK_SET:
+      base_offset = 0;
+      break;
+
+    case SEEK_CUR:
+      base_offset = offset_;
+      break;
+
+    case SEEK_END:
+      base_offset = size_;
+      break;
+
+    default:
+      LOG(ERROR) << "Seek(): invalid whence " << whence;
+      return -1;
+  }
+
+  FileOffset base_offset_fileoffset;
+  if (!AssignIfInRange(&base_offset_fileoffset, base_offset)) {
+    LOG(ERROR) << "Seek(): base_offset " << base_offset
+               << " invalid for FileOffset";
+    return -1;
+  }
+
+  base::CheckedNumeric<FileOffset> new_offset(base_offset_fileoffset);
+  new_offset += offset;
+  size_t new_offset_sizet;
+  if (!new_offset.AssignIfValid(&new_offset_sizet)) {
+    LOG(ERROR) << "Seek(): new_offset invalid";
+    return -1;
+  }
+
+  offset_ = new_offset_sizet;
+  return new_offset.ValueOrDie();
+}
+
+}  // namespace crashpad
@@ -0,0 +1,117 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_MAPPED_FILE_READER_H_
+#define CRASHPAD_UTIL_FILE_MAPPED_FILE_READER_H_
+
+#include <sys/types.h>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "build/build_config.h"
+#include "util/file/file_io.h"
+#include "util/file/file_reader.h"
+
+#if defined(OS_POSIX)
+#include "util/posix/scoped_mmap.h"
+#endif  // OS_POSIX
+
+namespace crashpad {
+
+//! \brief A file reader that maps an entire file into memory.
+//!
+//! Read() and Seek() behave as they would for a FileReader, but are satisfied
+//! from the mapping without any system calls. In addition, DataAt() provides
+//! direct access to the file’s contents, so that callers can interpret them
+//! in place rather than copying them out.
+//!
+//! The mapping is private and copy-on-write: memory obtained from DataAt() may
+//! be written to, but such writes are neither visible to other processes nor
+//! carried through to the file.
+//!
+//! Unlike a FileReader, this object is safe to use from multiple threads
+//! concurrently, provided that only DataAt() is used.
+class MappedFileReader final : public FileReaderInterface {
+ public:
+  MappedFileReader();
+  ~MappedFileReader() override;
+
+  //! \brief Opens and maps the file at \a path.
+  //!
+  //! \return `true` if the operation succeeded, `false` if it failed, with an
+  //!     error message logged.
+  //!
+  //! \note After a successful call, this method cannot be called again until
+  //!     after Close().
+  bool Open(const base::FilePath& path);
+
+  //! \brief Maps the file open as \a file.
+  //!
+  //! Ownership of \a file is not taken. The mapping remains valid after \a
+  //! file is closed.
+  //!
+  //! \return `true` if the operation succeeded, `false` if it failed, with an
+  //!     error message logged.
+  //!
+  //! \note After a successful call, this method cannot be called again until
+  //!     after Close().
+  bool Open(FileHandle file);
+
+  //! \brief Releases the mapping established by Open().
+  void Close();
+
+  //! \brief Returns a pointer to the file’s contents starting at \a offset.
+  //!
+  //! \param[in] offset The offset in the file of the first byte of the data.
+  //! \param[in] size The number of bytes of data required.
+  //!
+  //! \return A pointer into the mapping, valid until Close() is called or this
+  //!     object is destroyed. `nullptr` if the range does not lie entirely
+  //!     within the file, with a message logged. If \a size is `0`, the
+  //!     returned pointer must not be dereferenced.
+  const void* DataAt(FileOffset offset, size_t size) const;
+
+  //! \brief Returns the size of the file, in bytes.
+  size_t size() const { return size_; }
+
+  // FileReaderInterface:
+  FileOperationResult Read(void* data, size_t size) override;
+
+  // FileSeekerInterface:
+  FileOffset Seek(FileOffset offset, int whence) override;
+
+ private:
+  // Maps size_ bytes of |file|. Platform-specific.
+  bool Map(FileHandle file);
+
+  // Releases the mapping established by Map(). Platform-specific.
+  void Unmap();
+
+#if defined(OS_POSIX)
+  ScopedMmap mapping_;
+#elif defined(OS_WIN)
+  void* view_;
+#endif  // OS_POSIX
+
+  const char* data_;  // weak, points into the mapping
+  size_t size_;
+  size_t offset_;
+  bool is_open_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFileReader);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_MAPPED_FILE_READER_H_
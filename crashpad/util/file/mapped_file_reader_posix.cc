@@ -0,0 +1,60 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/mapped_file_reader.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+#include "base/numerics/safe_math.h"
+
+namespace crashpad {
+
+bool MappedFileReader::Map(FileHandle file) {
+  DCHECK(!mapping_.is_valid());
+  DCHECK_GT(size_, 0u);
+
+  // ScopedMmap deals in whole pages. The tail of the last page beyond the end
+  // of the file reads as zero and is never exposed by DataAt().
+  const size_t page_size = getpagesize();
+  base::CheckedNumeric<size_t> mapping_size = size_;
+  mapping_size += page_size - 1;
+  if (!mapping_size.IsValid()) {
+    LOG(ERROR) << "file size " << size_ << " out of range";
+    return false;
+  }
+  const size_t mapping_len =
+      mapping_size.ValueOrDie() / page_size * page_size;
+
+  // A private writable mapping is copy-on-write, so callers handed a pointer
+  // into it may safely treat it as their own scratch space.
+  if (!mapping_.ResetMmap(nullptr,
+                          mapping_len,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE,
+                          file,
+                          0)) {
+    return false;
+  }
+
+  data_ = mapping_.addr_as<const char*>();
+  return true;
+}
+
+void MappedFileReader::Unmap() {
+  mapping_.Reset();
+}
+
+}  // namespace crashpad
@@ -0,0 +1,118 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/mapped_file_reader.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "gtest/gtest.h"
+#include "test/scoped_temp_dir.h"
+#include "util/file/file_writer.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+base::FilePath WriteTestFile(const ScopedTempDir& temp_dir,
+                             const std::string& contents) {
+  base::FilePath path = temp_dir.path().Append(FILE_PATH_LITERAL("file"));
+  FileWriter writer;
+  EXPECT_TRUE(writer.Open(path,
+                          FileWriteMode::kTruncateOrCreate,
+                          FilePermissions::kOwnerOnly));
+  EXPECT_TRUE(writer.Write(contents.data(), contents.size()));
+  writer.Close();
+  return path;
+}
+
+TEST(MappedFileReader, ReadAndSeek) {
+  ScopedTempDir temp_dir;
+  const std::string contents("mapped file contents");
+  base::FilePath path = WriteTestFile(temp_dir, contents);
+
+  MappedFileReader reader;
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_EQ(reader.size(), contents.size());
+
+  char buffer[64];
+  ASSERT_TRUE(reader.ReadExactly(buffer, 6));
+  EXPECT_EQ(std::string(buffer, 6), "mapped");
+
+  EXPECT_EQ(reader.Seek(1, SEEK_CUR), 7);
+  ASSERT_TRUE(reader.ReadExactly(buffer, 4));
+  EXPECT_EQ(std::string(buffer, 4), "file");
+
+  EXPECT_EQ(reader.Seek(-8, SEEK_END),
+            static_cast<FileOffset>(contents.size() - 8));
+  EXPECT_EQ(reader.Read(buffer, sizeof(buffer)), 8);
+  EXPECT_EQ(std::string(buffer, 8), "contents");
+  EXPECT_EQ(reader.Read(buffer, sizeof(buffer)), 0);
+
+  EXPECT_EQ(reader.Seek(-1, SEEK_SET), -1);
+
+  reader.Close();
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_EQ(reader.Seek(0, SEEK_CUR), 0);
+}
+
+TEST(MappedFileReader, DataAt) {
+  ScopedTempDir temp_dir;
+  const std::string contents("mapped file contents");
+  base::FilePath path = WriteTestFile(temp_dir, contents);
+
+  MappedFileReader reader;
+  ASSERT_TRUE(reader.Open(path));
+
+  const char* data = static_cast<const char*>(reader.DataAt(0, 6));
+  ASSERT_TRUE(data);
+  EXPECT_EQ(std::string(data, 6), "mapped");
+
+  // Pointers into the mapping are stable.
+  EXPECT_EQ(reader.DataAt(7, 4), data + 7);
+  EXPECT_EQ(memcmp(reader.DataAt(7, 4), "file", 4), 0);
+
+  EXPECT_TRUE(reader.DataAt(0, contents.size()));
+  EXPECT_TRUE(reader.DataAt(contents.size(), 0));
+  EXPECT_FALSE(reader.DataAt(0, contents.size() + 1));
+  EXPECT_FALSE(reader.DataAt(contents.size() + 1, 0));
+  EXPECT_FALSE(reader.DataAt(-1, 1));
+}
+
+TEST(MappedFileReader, EmptyFile) {
+  ScopedTempDir temp_dir;
+  base::FilePath path = WriteTestFile(temp_dir, std::string());
+
+  MappedFileReader reader;
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_EQ(reader.size(), 0u);
+
+  char buffer[1];
+  EXPECT_EQ(reader.Read(buffer, sizeof(buffer)), 0);
+  EXPECT_FALSE(reader.DataAt(0, 1));
+}
+
+TEST(MappedFileReader, NonexistentFile) {
+  ScopedTempDir temp_dir;
+  MappedFileReader reader;
+  EXPECT_FALSE(
+      reader.Open(temp_dir.path().Append(FILE_PATH_LITERAL("nonexistent"))));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
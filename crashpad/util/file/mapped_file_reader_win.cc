@@ -0,0 +1,57 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/mapped_file_reader.h"
+
+#include <windows.h>
+
+#include "base/logging.h"
+#include "util/win/scoped_handle.h"
+
+namespace crashpad {
+
+bool MappedFileReader::Map(FileHandle file) {
+  DCHECK(!view_);
+  DCHECK_GT(size_, 0u);
+
+  // The view keeps the mapping object alive, so the handle to the mapping
+  // object can be closed as soon as the view is established.
+  ScopedKernelHANDLE mapping(
+      CreateFileMapping(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr));
+  if (!mapping.is_valid()) {
+    PLOG(ERROR) << "CreateFileMapping";
+    return false;
+  }
+
+  // A copy-on-write view allows callers handed a pointer into it to safely
+  // treat it as their own scratch space.
+  view_ = MapViewOfFile(mapping.get(), FILE_MAP_COPY, 0, 0, size_);
+  if (!view_) {
+    PLOG(ERROR) << "MapViewOfFile";
+    return false;
+  }
+
+  data_ = static_cast<const char*>(view_);
+  return true;
+}
+
+void MappedFileReader::Unmap() {
+  DCHECK(view_);
+  if (!UnmapViewOfFile(view_)) {
+    PLOG(ERROR) << "UnmapViewOfFile";
+  }
+  view_ = nullptr;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,216 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/page_store.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "build/build_config.h"
+#include "util/file/file_io.h"
+#include "util/misc/random_string.h"
+#include "util/misc/xxhash.h"
+#include "util/stdlib/string_number_conversion.h"
+
+#if defined(OS_WIN)
+#include "base/strings/utf_string_conversions.h"
+#endif  // OS_WIN
+
+namespace crashpad {
+
+namespace {
+
+// The hash that a page’s file name is formed from is always this many
+// hexadecimal digits.
+constexpr size_t kPageNameLength = 16;
+
+// A page is written to a file with a name ending in this, and then moved into
+// place, so that a page that was only partly written is never read.
+constexpr char kTemporarySuffix[] = ".tmp";
+
+std::string NameToUTF8(const base::FilePath::StringType& name) {
+#if defined(OS_WIN)
+  return base::UTF16ToUTF8(name);
+#else
+  return name;
+#endif  // OS_WIN
+}
+
+base::FilePath::StringType UTF8ToName(const std::string& name) {
+#if defined(OS_WIN)
+  return base::UTF8ToUTF16(name);
+#else
+  return name;
+#endif  // OS_WIN
+}
+
+bool HashFromPageName(const std::string& name, uint64_t* hash) {
+  if (name.size() != kPageNameLength ||
+      name.find_first_not_of("0123456789abcdef") != std::string::npos) {
+    return false;
+  }
+  return StringToNumber("0x" + name, hash);
+}
+
+bool IsTemporaryName(const std::string& name) {
+  const size_t suffix_length = strlen(kTemporarySuffix);
+  return name.size() > suffix_length &&
+         name.compare(name.size() - suffix_length,
+                      suffix_length,
+                      kTemporarySuffix) == 0;
+}
+
+// Reads at most |max_size| bytes of |file| into |data|. A page file that is
+// larger than a page is detected by asking for one byte more.
+bool ReadPageFile(FileHandle file, size_t max_size, std::string* data) {
+  data->resize(max_size);
+  size_t size = 0;
+  while (size < max_size) {
+    FileOperationResult bytes = ReadFile(file, &(*data)[size], max_size - size);
+    if (bytes < 0) {
+      PLOG(ERROR) << "ReadFile";
+      return false;
+    }
+    if (bytes == 0) {
+      break;
+    }
+    size += bytes;
+  }
+  data->resize(size);
+  return true;
+}
+
+}  // namespace
+
+constexpr size_t PageStore::kPageSize;
+
+PageStore::PageStore(const base::FilePath& path)
+    : path_(path), created_directory_(false) {}
+
+PageStore::~PageStore() {}
+
+bool PageStore::StorePage(const void* data, size_t size, uint64_t* hash) {
+  DCHECK_LE(size, kPageSize);
+
+  if (!created_directory_) {
+    if (!CreateDirectoryIfNeeded(path_)) {
+      return false;
+    }
+    created_directory_ = true;
+  }
+
+  *hash = XXHash64(data, size, 0);
+  const base::FilePath page_path = PagePath(*hash);
+
+  {
+    ScopedFileHandle handle(OpenFileForRead(page_path));
+    if (handle.is_valid()) {
+      std::string stored;
+      if (!ReadPageFile(handle.get(), kPageSize + 1, &stored)) {
+        return false;
+      }
+      if (stored.size() != size || memcmp(stored.data(), data, size) != 0) {
+        LOG(ERROR) << "page hash collision " << NameToUTF8(page_path.value());
+        return false;
+      }
+
+      // Storing the page again renews it, so that it isn’t removed before the
+      // file now referring to it is known.
+      return TouchFile(page_path);
+    }
+  }
+
+  const base::FilePath temporary_path = path_.Append(UTF8ToName(
+      base::StringPrintf("%016" PRIx64 ".%s%s",
+                         *hash,
+                         RandomString().c_str(),
+                         kTemporarySuffix)));
+  {
+    ScopedFileHandle handle(
+        LoggingOpenFileForWrite(temporary_path,
+                                FileWriteMode::kCreateOrFail,
+                                FilePermissions::kOwnerOnly));
+    if (!handle.is_valid()) {
+      return false;
+    }
+    if (!LoggingWriteFile(handle.get(), data, size)) {
+      handle.reset();
+      RemoveFile(temporary_path);
+      return false;
+    }
+  }
+
+  // If another writer stored the same page meanwhile, either copy will do.
+  if (!LoggingMoveFile(temporary_path, page_path)) {
+    RemoveFile(temporary_path);
+    return false;
+  }
+  return true;
+}
+
+bool PageStore::ReadPage(uint64_t hash, std::string* data) {
+  ScopedFileHandle handle(LoggingOpenFileForRead(PagePath(hash)));
+  if (!handle.is_valid()) {
+    return false;
+  }
+  if (!ReadPageFile(handle.get(), kPageSize + 1, data)) {
+    return false;
+  }
+  if (data->size() > kPageSize) {
+    LOG(ERROR) << "page too large";
+    return false;
+  }
+  return true;
+}
+
+size_t PageStore::RemovePagesExcept(const std::set<uint64_t>& referenced,
+                                    time_t minimum_age) {
+  std::vector<StoredFile> files;
+  if (!ListFiles(path_, &files)) {
+    return 0;
+  }
+
+  const time_t now = time(nullptr);
+  size_t removed = 0;
+  for (const StoredFile& file : files) {
+    if (now - file.modification_time < minimum_age) {
+      continue;
+    }
+
+    // Temporary files left behind by a writer that didn’t finish are removed
+    // along with the pages.
+    const std::string name = NameToUTF8(file.name);
+    uint64_t hash;
+    if (HashFromPageName(name, &hash)) {
+      if (referenced.find(hash) != referenced.end()) {
+        continue;
+      }
+    } else if (!IsTemporaryName(name)) {
+      continue;
+    }
+
+    if (RemoveFile(path_.Append(file.name)) && !IsTemporaryName(name)) {
+      ++removed;
+    }
+  }
+  return removed;
+}
+
+base::FilePath PageStore::PagePath(uint64_t hash) const {
+  return path_.Append(UTF8ToName(base::StringPrintf("%016" PRIx64, hash)));
+}
+
+}  // namespace crashpad
@@ -0,0 +1,129 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_PAGE_STORE_H_
+#define CRASHPAD_UTIL_FILE_PAGE_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+
+namespace crashpad {
+
+//! \brief A content-addressed store of pages, held as files in a directory.
+//!
+//! Each page is stored once, in a file named by its XXH64 hash in hexadecimal,
+//! however many times it has been stored. Files that refer to pages, such as
+//! those written by PagedFileWriter, hold only their hashes, so that data
+//! repeated across many such files occupies disk space only once.
+//!
+//! Because the hash is not cryptographic, a page is compared to the stored
+//! page that has the same hash before it is considered to be a duplicate. A
+//! page whose hash collides with that of a different stored page is not
+//! stored.
+//!
+//! Pages are not reference-counted. Instead, RemovePagesExcept() removes the
+//! pages that no remaining file refers to.
+class PageStore {
+ public:
+  //! \brief The largest page that may be stored, in bytes.
+  static constexpr size_t kPageSize = 4096;
+
+  //! \brief Constructs the object.
+  //!
+  //! \param[in] path The directory to store pages in. It is created when the
+  //!     first page is stored, if it doesn’t already exist, but its parent must
+  //!     exist by then. Until it exists, the store is empty.
+  explicit PageStore(const base::FilePath& path);
+  ~PageStore();
+
+  //! \brief Stores a page, if it isn’t already stored.
+  //!
+  //! \param[in] data The page’s contents.
+  //! \param[in] size The size of \a data, at most #kPageSize bytes.
+  //! \param[out] hash The hash that identifies the page.
+  //!
+  //! \return `true` if the page is stored. `false` if it could not be stored,
+  //!     or if a different page with the same hash is stored, with an error
+  //!     message logged.
+  bool StorePage(const void* data, size_t size, uint64_t* hash);
+
+  //! \brief Reads a stored page.
+  //!
+  //! \param[in] hash The hash that identifies the page, as returned by
+  //!     StorePage().
+  //! \param[out] data The page’s contents.
+  //!
+  //! \return `true` on success. `false` on failure, with an error message
+  //!     logged.
+  bool ReadPage(uint64_t hash, std::string* data);
+
+  //! \brief Removes the pages that aren’t referenced.
+  //!
+  //! A page is removed only if it was last stored at least \a minimum_age
+  //! seconds ago, so that the pages of a file that is still being written,
+  //! and isn’t yet known to refer to them, are retained.
+  //!
+  //! \param[in] referenced The hashes of the pages to retain.
+  //! \param[in] minimum_age The minimum age of a page to be removed, in
+  //!     seconds.
+  //!
+  //! \return The number of pages removed.
+  size_t RemovePagesExcept(const std::set<uint64_t>& referenced,
+                           time_t minimum_age);
+
+ private:
+  //! \brief A file in the store’s directory, as found by ListFiles().
+  struct StoredFile {
+    base::FilePath::StringType name;
+    time_t modification_time;
+  };
+
+  //! \brief Returns the path of the file that holds the page identified by
+  //!     \a hash.
+  base::FilePath PagePath(uint64_t hash) const;
+
+  // These are implemented in the platform-specific files.
+
+  //! \brief Creates the directory at \a path, unless it already exists.
+  static bool CreateDirectoryIfNeeded(const base::FilePath& path);
+
+  //! \brief Lists the regular files in the directory at \a path, which is
+  //!     considered empty if it doesn’t exist.
+  static bool ListFiles(const base::FilePath& path,
+                        std::vector<StoredFile>* files);
+
+  //! \brief Removes the file at \a path.
+  static bool RemoveFile(const base::FilePath& path);
+
+  //! \brief Sets the modification time of the file at \a path to the current
+  //!     time.
+  static bool TouchFile(const base::FilePath& path);
+
+  base::FilePath path_;
+  bool created_directory_;
+
+  DISALLOW_COPY_AND_ASSIGN(PageStore);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_PAGE_STORE_H_
@@ -0,0 +1,105 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/page_store.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+// static
+bool PageStore::CreateDirectoryIfNeeded(const base::FilePath& path) {
+  if (mkdir(path.value().c_str(), 0700) == 0) {
+    return true;
+  }
+  if (errno != EEXIST) {
+    PLOG(ERROR) << "mkdir " << path.value();
+    return false;
+  }
+
+  struct stat st;
+  if (stat(path.value().c_str(), &st) != 0) {
+    PLOG(ERROR) << "stat " << path.value();
+    return false;
+  }
+  if (!S_ISDIR(st.st_mode)) {
+    LOG(ERROR) << "not a directory " << path.value();
+    return false;
+  }
+  return true;
+}
+
+// static
+bool PageStore::ListFiles(const base::FilePath& path,
+                          std::vector<StoredFile>* files) {
+  DIR* dir = opendir(path.value().c_str());
+  if (!dir) {
+    if (errno == ENOENT) {
+      return true;
+    }
+    PLOG(ERROR) << "opendir " << path.value();
+    return false;
+  }
+
+  errno = 0;
+  dirent* entry;
+  while ((entry = readdir(dir))) {
+    struct stat st;
+    if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 ||
+        !S_ISREG(st.st_mode)) {
+      continue;
+    }
+
+    StoredFile file;
+    file.name = entry->d_name;
+    file.modification_time = st.st_mtime;
+    files->push_back(file);
+  }
+  const bool success = errno == 0;
+  if (!success) {
+    PLOG(ERROR) << "readdir " << path.value();
+  }
+
+  if (closedir(dir) != 0) {
+    PLOG(WARNING) << "closedir";
+  }
+  return success;
+}
+
+// static
+bool PageStore::RemoveFile(const base::FilePath& path) {
+  if (unlink(path.value().c_str()) != 0) {
+    PLOG(ERROR) << "unlink " << path.value();
+    return false;
+  }
+  return true;
+}
+
+// static
+bool PageStore::TouchFile(const base::FilePath& path) {
+  if (utimes(path.value().c_str(), nullptr) != 0) {
+    PLOG(ERROR) << "utimes " << path.value();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace crashpad
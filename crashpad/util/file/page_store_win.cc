@@ -0,0 +1,119 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/page_store.h"
+
+#include <windows.h>
+
+#include "base/logging.h"
+#include "base/strings/utf_string_conversions.h"
+#include "util/file/file_io.h"
+#include "util/win/time.h"
+
+namespace crashpad {
+
+// static
+bool PageStore::CreateDirectoryIfNeeded(const base::FilePath& path) {
+  if (CreateDirectory(path.value().c_str(), nullptr)) {
+    return true;
+  }
+  if (GetLastError() != ERROR_ALREADY_EXISTS) {
+    PLOG(ERROR) << "CreateDirectory " << base::UTF16ToUTF8(path.value());
+    return false;
+  }
+
+  const DWORD attributes = GetFileAttributes(path.value().c_str());
+  if (attributes == INVALID_FILE_ATTRIBUTES) {
+    PLOG(ERROR) << "GetFileAttributes " << base::UTF16ToUTF8(path.value());
+    return false;
+  }
+  if (!(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+    LOG(ERROR) << "not a directory " << base::UTF16ToUTF8(path.value());
+    return false;
+  }
+  return true;
+}
+
+// static
+bool PageStore::ListFiles(const base::FilePath& path,
+                          std::vector<StoredFile>* files) {
+  WIN32_FIND_DATA find_data;
+  HANDLE search_handle =
+      FindFirstFile(path.Append(L"*").value().c_str(), &find_data);
+  if (search_handle == INVALID_HANDLE_VALUE) {
+    if (GetLastError() == ERROR_FILE_NOT_FOUND ||
+        GetLastError() == ERROR_PATH_NOT_FOUND) {
+      return true;
+    }
+    PLOG(ERROR) << "FindFirstFile " << base::UTF16ToUTF8(path.value());
+    return false;
+  }
+
+  do {
+    if (find_data.dwFileAttributes &
+        (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_REPARSE_POINT)) {
+      continue;
+    }
+
+    StoredFile file;
+    file.name = find_data.cFileName;
+    file.modification_time =
+        FiletimeToTimevalEpoch(find_data.ftLastWriteTime).tv_sec;
+    files->push_back(file);
+  } while (FindNextFile(search_handle, &find_data));
+
+  const bool success = GetLastError() == ERROR_NO_MORE_FILES;
+  if (!success) {
+    PLOG(ERROR) << "FindNextFile";
+  }
+
+  if (!FindClose(search_handle)) {
+    PLOG(WARNING) << "FindClose";
+  }
+  return success;
+}
+
+// static
+bool PageStore::RemoveFile(const base::FilePath& path) {
+  if (!DeleteFile(path.value().c_str())) {
+    PLOG(ERROR) << "DeleteFile " << base::UTF16ToUTF8(path.value());
+    return false;
+  }
+  return true;
+}
+
+// static
+bool PageStore::TouchFile(const base::FilePath& path) {
+  ScopedFileHANDLE handle(CreateFile(path.value().c_str(),
+                                     FILE_WRITE_ATTRIBUTES,
+                                     FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                     nullptr,
+                                     OPEN_EXISTING,
+                                     FILE_ATTRIBUTE_NORMAL,
+                                     nullptr));
+  if (!handle.is_valid()) {
+    PLOG(ERROR) << "CreateFile " << base::UTF16ToUTF8(path.value());
+    return false;
+  }
+
+  FILETIME now;
+  GetSystemTimeAsFileTime(&now);
+  if (!SetFileTime(handle.get(), nullptr, nullptr, &now)) {
+    PLOG(ERROR) << "SetFileTime";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,82 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_PAGED_FILE_FORMAT_H_
+#define CRASHPAD_UTIL_FILE_PAGED_FILE_FORMAT_H_
+
+#include <stdint.h>
+
+namespace crashpad {
+namespace internal {
+
+// A paged file consists of a PagedFileHeader, followed by the data of any
+// pages stored inline, followed by an index of a PagedFileIndexEntry for each
+// page, followed by a PagedFileTrailer. All values are stored in native byte
+// order.
+//
+// Every page but the last holds PagedFileHeader::page_size bytes. A page is
+// either held in a PageStore and identified by its hash, stored inline at an
+// offset relative to the start of the file, or entirely zero and not stored at
+// all.
+
+//! \brief The signature in PagedFileHeader::signature, “CPpS”.
+constexpr uint32_t kPagedFileSignature = 0x53705043;
+
+//! \brief The signature in PagedFileTrailer::signature, “CPpE”.
+constexpr uint32_t kPagedFileTrailerSignature = 0x45705043;
+
+//! \brief The current version of the paged file format.
+constexpr uint32_t kPagedFileVersion = 1;
+
+//! \brief Values of PagedFileIndexEntry::storage.
+enum PagedFilePageStorage : uint32_t {
+  //! \brief The page is held in a PageStore, identified by
+  //!     PagedFileIndexEntry::hash.
+  kPagedFilePageInStore = 0,
+
+  //! \brief The page is stored in the file, at PagedFileIndexEntry::offset.
+  kPagedFilePageInline,
+
+  //! \brief The page is entirely zero, and isn’t stored.
+  kPagedFilePageZero,
+};
+
+struct PagedFileHeader {
+  uint32_t signature;
+  uint32_t version;
+  uint32_t page_size;
+  uint32_t reserved;
+};
+static_assert(sizeof(PagedFileHeader) == 16, "header size");
+
+struct PagedFileIndexEntry {
+  uint64_t hash;
+  uint64_t offset;
+  uint32_t size;
+  uint32_t storage;
+};
+static_assert(sizeof(PagedFileIndexEntry) == 24, "index entry size");
+
+struct PagedFileTrailer {
+  uint64_t index_offset;
+  uint64_t size;
+  uint32_t page_count;
+  uint32_t signature;
+};
+static_assert(sizeof(PagedFileTrailer) == 24, "trailer size");
+
+}  // namespace internal
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_PAGED_FILE_FORMAT_H_
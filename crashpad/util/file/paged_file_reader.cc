@@ -0,0 +1,280 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/paged_file_reader.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
+#include "util/file/page_store.h"
+#include "util/misc/xxhash.h"
+
+namespace crashpad {
+
+PagedFileReader::PagedFileReader()
+    : index_(),
+      page_(),
+      file_reader_(nullptr),
+      page_store_(nullptr),
+      start_offset_(0),
+      size_(0),
+      offset_(0),
+      page_size_(0),
+      page_index_(std::numeric_limits<size_t>::max()),
+      initialized_() {
+}
+
+PagedFileReader::~PagedFileReader() {
+}
+
+// static
+bool PagedFileReader::IsPagedFile(FileReaderInterface* file_reader) {
+  FileOffset start_offset = file_reader->SeekGet();
+  if (start_offset < 0) {
+    return false;
+  }
+
+  uint32_t signature;
+  FileOperationResult rv = file_reader->Read(&signature, sizeof(signature));
+  if (!file_reader->SeekSet(start_offset)) {
+    return false;
+  }
+
+  return rv == sizeof(signature) &&
+         signature == internal::kPagedFileSignature;
+}
+
+bool PagedFileReader::Initialize(FileReaderInterface* file_reader,
+                                 PageStore* page_store) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  file_reader_ = file_reader;
+  page_store_ = page_store;
+
+  start_offset_ = file_reader_->SeekGet();
+  if (start_offset_ < 0) {
+    return false;
+  }
+
+  internal::PagedFileHeader header;
+  if (!file_reader_->ReadExactly(&header, sizeof(header))) {
+    return false;
+  }
+
+  if (header.signature != internal::kPagedFileSignature) {
+    LOG(ERROR) << "header signature mismatch";
+    return false;
+  }
+
+  if (header.version != internal::kPagedFileVersion) {
+    LOG(ERROR) << "header version mismatch";
+    return false;
+  }
+
+  if (header.page_size == 0 || header.page_size > PageStore::kPageSize) {
+    LOG(ERROR) << "invalid page size";
+    return false;
+  }
+  page_size_ = header.page_size;
+
+  FileOffset end_offset = file_reader_->Seek(0, SEEK_END);
+  if (end_offset < 0) {
+    return false;
+  }
+
+  internal::PagedFileTrailer trailer;
+  if (end_offset - start_offset_ <
+          static_cast<FileOffset>(sizeof(header) + sizeof(trailer)) ||
+      !file_reader_->SeekSet(end_offset - sizeof(trailer)) ||
+      !file_reader_->ReadExactly(&trailer, sizeof(trailer))) {
+    LOG(ERROR) << "no trailer";
+    return false;
+  }
+
+  if (trailer.signature != internal::kPagedFileTrailerSignature) {
+    LOG(ERROR) << "trailer signature mismatch";
+    return false;
+  }
+
+  if (trailer.size > static_cast<uint64_t>(trailer.page_count) * page_size_ ||
+      (trailer.page_count > 0 &&
+       trailer.size <=
+           static_cast<uint64_t>(trailer.page_count - 1) * page_size_)) {
+    LOG(ERROR) << "inconsistent trailer";
+    return false;
+  }
+  size_ = trailer.size;
+
+  const uint64_t index_size =
+      static_cast<uint64_t>(trailer.page_count) * sizeof(index_[0]);
+  if (!base::IsValueInRangeForNumericType<FileOffset>(trailer.index_offset) ||
+      trailer.index_offset < sizeof(header) ||
+      trailer.index_offset + index_size + sizeof(trailer) !=
+          static_cast<uint64_t>(end_offset - start_offset_)) {
+    LOG(ERROR) << "invalid index";
+    return false;
+  }
+
+  index_.resize(trailer.page_count);
+  if (!index_.empty() &&
+      (!file_reader_->SeekSet(start_offset_ + trailer.index_offset) ||
+       !file_reader_->ReadExactly(&index_[0],
+                                  index_.size() * sizeof(index_[0])))) {
+    return false;
+  }
+
+  for (size_t page_index = 0; page_index < index_.size(); ++page_index) {
+    const internal::PagedFileIndexEntry& entry = index_[page_index];
+    const uint64_t expected_size =
+        std::min(static_cast<uint64_t>(page_size_),
+                 size_ - static_cast<uint64_t>(page_index) * page_size_);
+    if (entry.size != expected_size) {
+      LOG(ERROR) << "page " << page_index << " size mismatch";
+      return false;
+    }
+
+    switch (entry.storage) {
+      case internal::kPagedFilePageInStore:
+      case internal::kPagedFilePageZero:
+        break;
+      case internal::kPagedFilePageInline:
+        if (entry.offset < sizeof(header) ||
+            entry.offset + entry.size > trailer.index_offset) {
+          LOG(ERROR) << "page " << page_index << " offset out of range";
+          return false;
+        }
+        break;
+      default:
+        LOG(ERROR) << "page " << page_index << " storage " << entry.storage;
+        return false;
+    }
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+void PagedFileReader::StoredPages(std::set<uint64_t>* hashes) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  for (const internal::PagedFileIndexEntry& entry : index_) {
+    if (entry.storage == internal::kPagedFilePageInStore) {
+      hashes->insert(entry.hash);
+    }
+  }
+}
+
+FileOperationResult PagedFileReader::Read(void* data, size_t size) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  uint8_t* data_c = static_cast<uint8_t*>(data);
+  size_t total_read = 0;
+  size = std::min(size,
+                  base::saturated_cast<size_t>(
+                      std::numeric_limits<FileOperationResult>::max()));
+  while (total_read < size && offset_ < size_) {
+    if (!LoadPage(offset_)) {
+      return -1;
+    }
+
+    size_t offset_in_page = static_cast<size_t>(offset_ % page_size_);
+    size_t chunk = std::min(size - total_read, page_.size() - offset_in_page);
+    memcpy(data_c + total_read, &page_[offset_in_page], chunk);
+    total_read += chunk;
+    offset_ += chunk;
+  }
+
+  return total_read;
+}
+
+FileOffset PagedFileReader::Seek(FileOffset offset, int whence) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  FileOffset base;
+  switch (whence) {
+    case SEEK_SET:
+      base = 0;
+      break;
+    case SEEK_CUR:
+      base = static_cast<FileOffset>(offset_);
+      break;
+    case SEEK_END:
+      base = static_cast<FileOffset>(size_);
+      break;
+    default:
+      LOG(ERROR) << "Seek(): invalid whence " << whence;
+      return -1;
+  }
+
+  if ((offset > 0 && base > std::numeric_limits<FileOffset>::max() - offset) ||
+      base + offset < 0) {
+    LOG(ERROR) << "Seek(): invalid offset";
+    return -1;
+  }
+
+  offset_ = base + offset;
+  return static_cast<FileOffset>(offset_);
+}
+
+bool PagedFileReader::LoadPage(uint64_t offset) {
+  const size_t page_index = static_cast<size_t>(offset / page_size_);
+  if (page_index == page_index_) {
+    return true;
+  }
+
+  DCHECK_LT(page_index, index_.size());
+  page_index_ = std::numeric_limits<size_t>::max();
+
+  const internal::PagedFileIndexEntry& entry = index_[page_index];
+  switch (entry.storage) {
+    case internal::kPagedFilePageInStore:
+      if (!page_store_) {
+        LOG(ERROR) << "no page store";
+        return false;
+      }
+      if (!page_store_->ReadPage(entry.hash, &page_)) {
+        return false;
+      }
+
+      // A page that was replaced or damaged in the store mustn’t be taken for
+      // the one that the file refers to.
+      if (page_.size() != entry.size ||
+          XXHash64(page_.data(), page_.size(), 0) != entry.hash) {
+        LOG(ERROR) << "page " << page_index << " mismatch";
+        return false;
+      }
+      break;
+
+    case internal::kPagedFilePageInline:
+      page_.resize(entry.size);
+      if (!file_reader_->SeekSet(start_offset_ + entry.offset) ||
+          !file_reader_->ReadExactly(&page_[0], page_.size())) {
+        return false;
+      }
+      break;
+
+    case internal::kPagedFilePageZero:
+      page_.assign(entry.size, '\0');
+      break;
+  }
+
+  page_index_ = page_index;
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,99 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_PAGED_FILE_READER_H_
+#define CRASHPAD_UTIL_FILE_PAGED_FILE_READER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "util/file/file_reader.h"
+#include "util/file/paged_file_format.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+
+class PageStore;
+
+//! \brief A file reader that reassembles data written by PagedFileWriter from
+//!     its pages.
+//!
+//! Seeking to any offset is supported, and requires reading at most one page.
+//! The most recently read page is retained, so that sequential reads and
+//! nearby seeks are inexpensive.
+class PagedFileReader : public FileReaderInterface {
+ public:
+  PagedFileReader();
+  ~PagedFileReader() override;
+
+  //! \brief Determines whether a file is a paged file.
+  //!
+  //! \param[in] file_reader The file to examine, positioned at its start. Its
+  //!     position is restored before this method returns.
+  //!
+  //! \return `true` if \a file_reader begins with a paged file header. `false`
+  //!     otherwise, or on error.
+  static bool IsPagedFile(FileReaderInterface* file_reader);
+
+  //! \brief Initializes the object.
+  //!
+  //! \param[in] file_reader The underlying paged file, positioned at its
+  //!     start, which must support seeking. The paged data must extend to the
+  //!     end of the file. This object does not take ownership of \a
+  //!     file_reader, which must remain valid for this object’s lifetime.
+  //! \param[in] page_store The store holding the file’s pages. This object
+  //!     does not take ownership of \a page_store, which must remain valid for
+  //!     this object’s lifetime. It is only used by Read(), and may be
+  //!     `nullptr` if only StoredPages() is to be called.
+  //!
+  //! \return `true` on success. `false` on failure, with an error message
+  //!     logged.
+  bool Initialize(FileReaderInterface* file_reader, PageStore* page_store);
+
+  //! \brief Adds the hashes of the pages that the file refers to in its
+  //!     PageStore to \a hashes.
+  void StoredPages(std::set<uint64_t>* hashes) const;
+
+  // FileReaderInterface:
+  FileOperationResult Read(void* data, size_t size) override;
+
+  // FileSeekerInterface:
+  FileOffset Seek(FileOffset offset, int whence) override;
+
+ private:
+  //! \brief Makes the page containing \a offset the current page.
+  bool LoadPage(uint64_t offset);
+
+  std::vector<internal::PagedFileIndexEntry> index_;
+  std::string page_;
+  FileReaderInterface* file_reader_;  // weak
+  PageStore* page_store_;  // weak
+  FileOffset start_offset_;
+  uint64_t size_;
+  uint64_t offset_;
+  size_t page_size_;
+  size_t page_index_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(PagedFileReader);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_PAGED_FILE_READER_H_
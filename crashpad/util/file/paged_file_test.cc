@@ -0,0 +1,276 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <inttypes.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+#include "base/strings/stringprintf.h"
+#include "build/build_config.h"
+#include "gtest/gtest.h"
+#include "test/scoped_temp_dir.h"
+#include "util/file/file_io.h"
+#include "util/file/page_store.h"
+#include "util/file/paged_file_reader.h"
+#include "util/file/paged_file_writer.h"
+#include "util/file/string_file.h"
+
+#if defined(OS_WIN)
+#include "base/strings/utf_string_conversions.h"
+#endif  // OS_WIN
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr size_t kPageSize = PageStore::kPageSize;
+
+// Produces data whose pages differ from one another, with the pages in
+// [zero_begin, zero_end) entirely zero.
+std::string MakeTestData(size_t size, size_t zero_begin, size_t zero_end) {
+  std::string data;
+  uint32_t state = 0x12345678;
+  while (data.size() < size) {
+    const size_t page = data.size() / kPageSize;
+    if (page >= zero_begin && page < zero_end) {
+      data.push_back('\0');
+    } else {
+      state = state * 1103515245 + 12345;
+      data.push_back(static_cast<char>(state >> 24));
+    }
+  }
+  return data;
+}
+
+std::string WritePagedFile(const std::string& data, PageStore* page_store) {
+  StringFile string_file;
+  PagedFileWriter writer(&string_file, page_store);
+
+  // Write in pieces that don’t line up with page boundaries.
+  size_t offset = 0;
+  size_t piece = 1;
+  while (offset < data.size()) {
+    size_t size = std::min(piece, data.size() - offset);
+    EXPECT_TRUE(writer.Write(&data[offset], size));
+    offset += size;
+    piece = piece * 3 + 1;
+    EXPECT_EQ(writer.SeekGet(), static_cast<FileOffset>(offset));
+  }
+  EXPECT_TRUE(writer.Close());
+  return string_file.string();
+}
+
+std::string ReadPagedFile(const std::string& paged_file,
+                          PageStore* page_store) {
+  StringFile string_file;
+  string_file.SetString(paged_file);
+  EXPECT_TRUE(PagedFileReader::IsPagedFile(&string_file));
+
+  PagedFileReader reader;
+  if (!reader.Initialize(&string_file, page_store)) {
+    ADD_FAILURE();
+    return std::string();
+  }
+
+  const FileOffset size = reader.Seek(0, SEEK_END);
+  EXPECT_GE(size, 0);
+  EXPECT_TRUE(reader.SeekSet(0));
+  std::string data(static_cast<size_t>(size), '\0');
+  if (!data.empty() && !reader.ReadExactly(&data[0], data.size())) {
+    ADD_FAILURE();
+    return std::string();
+  }
+  char c;
+  EXPECT_EQ(reader.Read(&c, 1), 0);
+  return data;
+}
+
+TEST(PageStore, StoreAndRead) {
+  ScopedTempDir temp_dir;
+  const base::FilePath path =
+      temp_dir.path().Append(FILE_PATH_LITERAL("pages"));
+  PageStore page_store(path);
+
+  // The directory doesn’t exist until a page is stored.
+  EXPECT_EQ(page_store.RemovePagesExcept(std::set<uint64_t>(), 0), 0u);
+
+  const std::string page = MakeTestData(kPageSize, 0, 0);
+  uint64_t hash;
+  ASSERT_TRUE(page_store.StorePage(page.data(), page.size(), &hash));
+  uint64_t hash_again;
+  ASSERT_TRUE(page_store.StorePage(page.data(), page.size(), &hash_again));
+  EXPECT_EQ(hash_again, hash);
+
+  std::string read;
+  ASSERT_TRUE(page_store.ReadPage(hash, &read));
+  EXPECT_EQ(read, page);
+
+  const std::string short_page = page.substr(1);
+  uint64_t short_hash;
+  ASSERT_TRUE(
+      page_store.StorePage(short_page.data(), short_page.size(), &short_hash));
+  EXPECT_NE(short_hash, hash);
+  ASSERT_TRUE(page_store.ReadPage(short_hash, &read));
+  EXPECT_EQ(read, short_page);
+
+  // An existing store is reopened.
+  PageStore page_store_again(path);
+  ASSERT_TRUE(page_store_again.ReadPage(hash, &read));
+  EXPECT_EQ(read, page);
+}
+
+TEST(PageStore, RemovePagesExcept) {
+  ScopedTempDir temp_dir;
+  PageStore page_store(temp_dir.path());
+
+  const std::string pages = MakeTestData(2 * kPageSize, 0, 0);
+  uint64_t hashes[2];
+  for (size_t index = 0; index < 2; ++index) {
+    ASSERT_TRUE(page_store.StorePage(
+        &pages[index * kPageSize], kPageSize, &hashes[index]));
+  }
+  const std::set<uint64_t> referenced = {hashes[0]};
+
+  // Pages stored just now are too new to be removed.
+  EXPECT_EQ(page_store.RemovePagesExcept(referenced, 60 * 60), 0u);
+  std::string read;
+  EXPECT_TRUE(page_store.ReadPage(hashes[1], &read));
+
+  EXPECT_EQ(page_store.RemovePagesExcept(referenced, 0), 1u);
+  EXPECT_TRUE(page_store.ReadPage(hashes[0], &read));
+  EXPECT_FALSE(page_store.ReadPage(hashes[1], &read));
+}
+
+TEST(PagedFile, Empty) {
+  ScopedTempDir temp_dir;
+  PageStore page_store(temp_dir.path());
+
+  const std::string paged_file = WritePagedFile(std::string(), &page_store);
+  EXPECT_EQ(ReadPagedFile(paged_file, &page_store), std::string());
+}
+
+TEST(PagedFile, RoundTrip) {
+  ScopedTempDir temp_dir;
+  PageStore page_store(temp_dir.path());
+
+  const std::string data = MakeTestData(10 * kPageSize + 123, 3, 5);
+  const std::string paged_file = WritePagedFile(data, &page_store);
+  EXPECT_EQ(ReadPagedFile(paged_file, &page_store), data);
+
+  // Neither the stored pages nor the zero pages are held in the file.
+  EXPECT_LT(paged_file.size(), kPageSize);
+
+  StringFile string_file;
+  string_file.SetString(paged_file);
+  PagedFileReader reader;
+  ASSERT_TRUE(reader.Initialize(&string_file, &page_store));
+  std::set<uint64_t> hashes;
+  reader.StoredPages(&hashes);
+  EXPECT_EQ(hashes.size(), 9u);
+
+  // Seek around, crossing page boundaries.
+  for (size_t offset : {5 * kPageSize - 10,
+                        size_t{17},
+                        10 * kPageSize + 100,
+                        3 * kPageSize + 1}) {
+    SCOPED_TRACE(offset);
+    ASSERT_TRUE(reader.SeekSet(offset));
+    char buffer[64];
+    const size_t expected = std::min(sizeof(buffer), data.size() - offset);
+    ASSERT_EQ(reader.Read(buffer, sizeof(buffer)),
+              static_cast<FileOperationResult>(expected));
+    EXPECT_EQ(std::string(buffer, expected), data.substr(offset, expected));
+  }
+}
+
+TEST(PagedFile, SharedPages) {
+  ScopedTempDir temp_dir;
+  PageStore page_store(temp_dir.path());
+
+  const std::string data = MakeTestData(8 * kPageSize, 0, 0);
+  std::string other_data = data;
+  other_data[kPageSize + 1] ^= 1;
+
+  const std::string paged_file = WritePagedFile(data, &page_store);
+  const std::string other_paged_file = WritePagedFile(other_data, &page_store);
+  EXPECT_EQ(ReadPagedFile(paged_file, &page_store), data);
+  EXPECT_EQ(ReadPagedFile(other_paged_file, &page_store), other_data);
+
+  // The files share all but one of their pages.
+  std::set<uint64_t> hashes;
+  for (const std::string* file : {&paged_file, &other_paged_file}) {
+    StringFile string_file;
+    string_file.SetString(*file);
+    PagedFileReader reader;
+    ASSERT_TRUE(reader.Initialize(&string_file, nullptr));
+    reader.StoredPages(&hashes);
+  }
+  EXPECT_EQ(hashes.size(), 9u);
+
+  // Pages that only one file refers to are removed along with it, and the
+  // other is unaffected.
+  hashes.clear();
+  {
+    StringFile string_file;
+    string_file.SetString(other_paged_file);
+    PagedFileReader reader;
+    ASSERT_TRUE(reader.Initialize(&string_file, nullptr));
+    reader.StoredPages(&hashes);
+  }
+  EXPECT_EQ(page_store.RemovePagesExcept(hashes, 0), 1u);
+  EXPECT_EQ(ReadPagedFile(other_paged_file, &page_store), other_data);
+}
+
+TEST(PagedFile, Collision) {
+  ScopedTempDir temp_dir;
+  PageStore page_store(temp_dir.path());
+
+  const std::string data = MakeTestData(2 * kPageSize, 0, 0);
+  uint64_t hash;
+  ASSERT_TRUE(page_store.StorePage(data.data(), kPageSize, &hash));
+
+  // Replace the stored page with a different one, as though another page had
+  // the same hash. Pages are named by their hashes.
+  const std::string other_data = MakeTestData(3 * kPageSize, 0, 0);
+  {
+    const std::string name = base::StringPrintf("%016" PRIx64, hash);
+#if defined(OS_WIN)
+    const base::FilePath page_path =
+        temp_dir.path().Append(base::UTF8ToUTF16(name));
+#else
+    const base::FilePath page_path = temp_dir.path().Append(name);
+#endif  // OS_WIN
+    ScopedFileHandle handle(
+        LoggingOpenFileForWrite(page_path,
+                                FileWriteMode::kTruncateOrCreate,
+                                FilePermissions::kOwnerOnly));
+    ASSERT_TRUE(handle.is_valid());
+    ASSERT_TRUE(LoggingWriteFile(
+        handle.get(), &other_data[2 * kPageSize], kPageSize));
+  }
+
+  EXPECT_FALSE(page_store.StorePage(data.data(), kPageSize, &hash));
+
+  // The colliding page is kept in the file instead, and read back intact.
+  const std::string paged_file = WritePagedFile(data, &page_store);
+  EXPECT_GT(paged_file.size(), kPageSize);
+  EXPECT_EQ(ReadPagedFile(paged_file, &page_store), data);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
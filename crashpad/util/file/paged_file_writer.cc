@@ -0,0 +1,182 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/file/paged_file_writer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
+#include "util/file/page_store.h"
+
+namespace crashpad {
+
+namespace {
+
+constexpr char kZeroPage[PageStore::kPageSize] = {};
+
+}  // namespace
+
+PagedFileWriter::PagedFileWriter(FileWriterInterface* file_writer,
+                                 PageStore* page_store)
+    : page_(),
+      index_(),
+      file_writer_(file_writer),
+      page_store_(page_store),
+      underlying_offset_(0),
+      size_(0),
+      wrote_header_(false),
+      closed_(false) {
+  page_.reserve(PageStore::kPageSize);
+}
+
+PagedFileWriter::~PagedFileWriter() {
+}
+
+bool PagedFileWriter::Close() {
+  DCHECK(!closed_);
+  closed_ = true;
+
+  if (!WriteHeaderIfNeeded() || !FlushPage()) {
+    return false;
+  }
+
+  internal::PagedFileTrailer trailer = {};
+  trailer.index_offset = underlying_offset_;
+  trailer.size = size_;
+  if (!base::IsValueInRangeForNumericType<uint32_t>(index_.size())) {
+    LOG(ERROR) << "too many pages";
+    return false;
+  }
+  trailer.page_count = static_cast<uint32_t>(index_.size());
+  trailer.signature = internal::kPagedFileTrailerSignature;
+
+  std::vector<WritableIoVec> iovecs;
+  if (!index_.empty()) {
+    WritableIoVec iov;
+    iov.iov_base = &index_[0];
+    iov.iov_len = index_.size() * sizeof(index_[0]);
+    iovecs.push_back(iov);
+  }
+
+  WritableIoVec iov;
+  iov.iov_base = &trailer;
+  iov.iov_len = sizeof(trailer);
+  iovecs.push_back(iov);
+
+  return file_writer_->WriteIoVec(&iovecs);
+}
+
+bool PagedFileWriter::Write(const void* data, size_t size) {
+  DCHECK(!closed_);
+
+  if (!WriteHeaderIfNeeded()) {
+    return false;
+  }
+
+  const char* data_c = static_cast<const char*>(data);
+  while (size > 0) {
+    size_t chunk = std::min(size, PageStore::kPageSize - page_.size());
+    page_.append(data_c, chunk);
+    data_c += chunk;
+    size -= chunk;
+    size_ += chunk;
+
+    if (page_.size() == PageStore::kPageSize && !FlushPage()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool PagedFileWriter::WriteIoVec(std::vector<WritableIoVec>* iovecs) {
+  if (iovecs->empty()) {
+    LOG(ERROR) << "WriteIoVec(): no iovecs";
+    return false;
+  }
+
+  for (const WritableIoVec& iov : *iovecs) {
+    if (!Write(iov.iov_base, iov.iov_len)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+FileOffset PagedFileWriter::Seek(FileOffset offset, int whence) {
+  if (offset != 0 || whence != SEEK_CUR) {
+    LOG(ERROR) << "Seek(): only the current position is available";
+    return -1;
+  }
+
+  if (!base::IsValueInRangeForNumericType<FileOffset>(size_)) {
+    LOG(ERROR) << "Seek(): file too large";
+    return -1;
+  }
+
+  return static_cast<FileOffset>(size_);
+}
+
+bool PagedFileWriter::WriteHeaderIfNeeded() {
+  if (wrote_header_) {
+    return true;
+  }
+  wrote_header_ = true;
+
+  internal::PagedFileHeader header = {};
+  header.signature = internal::kPagedFileSignature;
+  header.version = internal::kPagedFileVersion;
+  header.page_size = static_cast<uint32_t>(PageStore::kPageSize);
+  if (!file_writer_->Write(&header, sizeof(header))) {
+    return false;
+  }
+
+  underlying_offset_ += sizeof(header);
+  return true;
+}
+
+bool PagedFileWriter::FlushPage() {
+  if (page_.empty()) {
+    return true;
+  }
+
+  internal::PagedFileIndexEntry entry = {};
+  entry.size = static_cast<uint32_t>(page_.size());
+  if (memcmp(page_.data(), kZeroPage, page_.size()) == 0) {
+    entry.storage = internal::kPagedFilePageZero;
+  } else if (page_store_->StorePage(page_.data(), page_.size(), &entry.hash)) {
+    entry.storage = internal::kPagedFilePageInStore;
+  } else {
+    // A page that can’t be stored, perhaps because its hash collides with
+    // another’s, is kept in the file.
+    entry.hash = 0;
+    entry.offset = underlying_offset_;
+    entry.storage = internal::kPagedFilePageInline;
+    if (!file_writer_->Write(page_.data(), page_.size())) {
+      return false;
+    }
+    underlying_offset_ += page_.size();
+  }
+
+  index_.push_back(entry);
+  page_.clear();
+  return true;
+}
+
+}  // namespace crashpad
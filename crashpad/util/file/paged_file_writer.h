@@ -0,0 +1,101 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_FILE_PAGED_FILE_WRITER_H_
+#define CRASHPAD_UTIL_FILE_PAGED_FILE_WRITER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "util/file/file_writer.h"
+#include "util/file/paged_file_format.h"
+
+namespace crashpad {
+
+class PageStore;
+
+//! \brief A file writer that stores the pages of data written to it in a
+//!     PageStore.
+//!
+//! Data is accumulated into pages of PageStore::kPageSize bytes. Each page is
+//! stored in the PageStore as soon as it is full, and only its hash is written
+//! to an underlying FileWriterInterface, so that pages repeated across files
+//! written this way are stored only once. Pages that are entirely zero aren’t
+//! stored at all, and a page that the PageStore can’t hold is written to the
+//! underlying file instead. When Close() is called, an index of pages is
+//! written, allowing PagedFileReader to seek to any offset.
+//!
+//! Pages are taken at fixed offsets from the start of the data, so data is
+//! shared between files only where it is identically aligned within them.
+//!
+//! Data can only be written sequentially. Seek() supports only obtaining the
+//! current position, so this class is suitable for use with
+//! MinidumpFileWriter::WriteMinidump() with `allow_seek` set to `false`.
+class PagedFileWriter : public FileWriterInterface {
+ public:
+  //! \brief Constructs the object.
+  //!
+  //! \param[in] file_writer The underlying file writer to receive the index of
+  //!     pages. This object does not take ownership of \a file_writer, which
+  //!     must remain valid until Close() has been called.
+  //! \param[in] page_store The store to hold pages in. This object does not
+  //!     take ownership of \a page_store, which must remain valid until
+  //!     Close() has been called.
+  PagedFileWriter(FileWriterInterface* file_writer, PageStore* page_store);
+  ~PagedFileWriter() override;
+
+  //! \brief Writes any buffered data, the page index, and the file trailer.
+  //!
+  //! This must be called once all data has been written. No further data may
+  //! be written after this method is called.
+  //!
+  //! \return `true` on success. `false` on failure, with an error message
+  //!     logged.
+  bool Close();
+
+  // FileWriterInterface:
+  bool Write(const void* data, size_t size) override;
+  bool WriteIoVec(std::vector<WritableIoVec>* iovecs) override;
+
+  // FileSeekerInterface:
+
+  //! \copydoc FileWriterInterface::Seek()
+  //!
+  //! \note Only `Seek(0, SEEK_CUR)`, which returns the current offset, is
+  //!     supported. All other uses fail.
+  FileOffset Seek(FileOffset offset, int whence) override;
+
+ private:
+  bool WriteHeaderIfNeeded();
+  bool FlushPage();
+
+  std::string page_;
+  std::vector<internal::PagedFileIndexEntry> index_;
+  FileWriterInterface* file_writer_;  // weak
+  PageStore* page_store_;  // weak
+  uint64_t underlying_offset_;
+  uint64_t size_;
+  bool wrote_header_;
+  bool closed_;
+
+  DISALLOW_COPY_AND_ASSIGN(PagedFileWriter);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_FILE_PAGED_FILE_WRITER_H_
@@ -0,0 +1,404 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/copy_on_write_fork.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "base/posix/eintr_wrapper.h"
+#include "build/build_config.h"
+
+namespace crashpad {
+
+namespace {
+
+// How long to wait for every thread to be recorded. A thread that blocks the
+// capture signal never is, so this bounds the cost of such a thread.
+constexpr long kRecordTimeoutNanoseconds = 100 * 1000 * 1000;
+
+#if defined(ARCH_CPU_X86_64)
+// The floating-point state is in the fxsave format.
+constexpr size_t kFxsaveSize = 512;
+constexpr size_t kFloatStateSize = kFxsaveSize;
+#elif defined(ARCH_CPU_X86)
+// The floating-point state begins in the fsave format, ended by a magic number
+// that, when it’s X86_FXSR_MAGIC, indicates that the state follows in the
+// fxsave format.
+constexpr size_t kFsaveSize = 112;
+constexpr size_t kFsaveMagicOffset = 110;
+constexpr size_t kFxsaveSize = 512;
+constexpr size_t kFloatStateSize = kFsaveSize + kFxsaveSize;
+#else
+// The floating-point state isn’t reached through uc_mcontext.fpregs and isn’t
+// recorded.
+constexpr size_t kFloatStateSize = 1;
+#endif  // ARCH_CPU_X86_64
+
+// The fork being created. Signal handlers that find none return without doing
+// anything.
+std::atomic<CopyOnWriteFork*> g_active_fork;
+
+// The number of capture signal handlers running. A fork waits for this to drop
+// to zero after clearing g_active_fork, so that no handler still uses it.
+std::atomic<int> g_handlers_in_flight;
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "futex size mismatch");
+
+void FutexWait(std::atomic<uint32_t>* word,
+               uint32_t value,
+               const timespec* timeout) {
+  syscall(SYS_futex,
+          reinterpret_cast<uint32_t*>(word),
+          FUTEX_WAIT_PRIVATE,
+          value,
+          timeout,
+          nullptr,
+          0);
+}
+
+void FutexWake(std::atomic<uint32_t>* word) {
+  syscall(SYS_futex,
+          reinterpret_cast<uint32_t*>(word),
+          FUTEX_WAKE_PRIVATE,
+          INT_MAX,
+          nullptr,
+          nullptr,
+          0);
+}
+
+pid_t GetTid() {
+  return syscall(SYS_gettid);
+}
+
+// Reflects struct linux_dirent64 in the getdents64(2) man page.
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  uint16_t d_reclen;
+  uint8_t d_type;
+  char d_name[];
+};
+
+// The child’s main loop. It waits to be snapshotted and then killed, and dies
+// with its parent if that comes first.
+void RunChild(pid_t parent_pid, pid_t ptracer) {
+  syscall(SYS_prctl, PR_SET_PDEATHSIG, SIGKILL, 0, 0, 0);
+  if (syscall(SYS_getppid) != parent_pid) {
+    // The parent died before the death signal was requested.
+    _exit(0);
+  }
+
+  if (ptracer) {
+    syscall(SYS_prctl, PR_SET_PTRACER, ptracer, 0, 0, 0);
+  }
+
+  while (true) {
+    pause();
+  }
+}
+
+}  // namespace
+
+struct CopyOnWriteFork::ThreadRecord {
+  ucontext_t context;
+  alignas(16) uint8_t float_state[kFloatStateSize];
+};
+
+CopyOnWriteFork::CopyOnWriteFork()
+    : memory_(nullptr),
+      memory_size_(0),
+      contexts_(nullptr),
+      records_(nullptr),
+      context_count_(0),
+      child_pid_(-1),
+      forking_tid_(-1),
+      recorded_count_(0),
+      released_(0) {}
+
+CopyOnWriteFork::~CopyOnWriteFork() {
+  if (child_pid_ > 0) {
+    kill(child_pid_, SIGKILL);
+    HANDLE_EINTR(waitpid(child_pid_, nullptr, 0));
+  }
+  if (memory_) {
+    munmap(memory_, memory_size_);
+  }
+}
+
+int CopyOnWriteFork::Fork(int capture_signal, pid_t ptracer) {
+  if (memory_) {
+    return EALREADY;
+  }
+
+#if !defined(ARCH_CPU_X86_FAMILY)
+  return ENOSYS;
+#else
+  int fd = HANDLE_EINTR(
+      open("/proc/self/task", O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+  if (fd < 0) {
+    return errno;
+  }
+
+  // Threads started after the task directory is first listed aren’t recorded.
+  uint32_t thread_count;
+  int result = ListThreads(fd, nullptr, 0, &thread_count);
+  if (result != 0) {
+    close(fd);
+    return result;
+  }
+
+  const size_t contexts_size =
+      (thread_count * sizeof(ForkedThreadContext) + alignof(ThreadRecord) - 1) &
+      ~(alignof(ThreadRecord) - 1);
+  memory_size_ = contexts_size + thread_count * sizeof(ThreadRecord);
+  void* memory = mmap(nullptr,
+                      memory_size_,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1,
+                      0);
+  if (memory == MAP_FAILED) {
+    result = errno;
+    close(fd);
+    return result;
+  }
+  memory_ = memory;
+  contexts_ = static_cast<ForkedThreadContext*>(memory_);
+  records_ = reinterpret_cast<ThreadRecord*>(static_cast<char*>(memory_) +
+                                             contexts_size);
+
+  uint32_t listed_count = 0;
+  if (lseek(fd, 0, SEEK_SET) != 0 ||
+      (result = ListThreads(fd, contexts_, thread_count, &listed_count)) !=
+          0) {
+    result = result ? result : errno;
+    close(fd);
+    return result;
+  }
+  close(fd);
+  context_count_ = std::min(listed_count, thread_count);
+
+  struct sigaction action = {};
+  sigemptyset(&action.sa_mask);
+  action.sa_sigaction = HandleCaptureSignal;
+  action.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+  if (sigaction(capture_signal, &action, nullptr) != 0) {
+    return errno;
+  }
+
+  CopyOnWriteFork* expected = nullptr;
+  if (!g_active_fork.compare_exchange_strong(expected, this)) {
+    return EBUSY;
+  }
+
+  // Every thread is signaled, including this one, whose handler runs before
+  // tgkill() returns and records it without waiting.
+  const pid_t pid = getpid();
+  forking_tid_ = GetTid();
+  uint32_t signaled_count = 0;
+  for (uint32_t index = 0; index < context_count_; ++index) {
+    if (syscall(SYS_tgkill, pid, contexts_[index].thread_id, capture_signal) ==
+        0) {
+      ++signaled_count;
+    }
+  }
+  WaitForRecords(signaled_count);
+
+  // fork() isn’t used because it runs atfork handlers, which may take locks
+  // that are held by the threads now stopped in their signal handlers.
+  long child_pid = syscall(SYS_clone, SIGCHLD, 0, 0, 0, 0);
+  if (child_pid == 0) {
+    RunChild(pid, ptracer);
+  }
+  result = child_pid < 0 ? errno : 0;
+
+  released_.store(1);
+  FutexWake(&released_);
+
+  g_active_fork.store(nullptr);
+  while (g_handlers_in_flight.load() != 0) {
+    sched_yield();
+  }
+
+  if (child_pid < 0) {
+    return result;
+  }
+  child_pid_ = child_pid;
+  return 0;
+#endif  // !ARCH_CPU_X86_FAMILY
+}
+
+// static
+int CopyOnWriteFork::ListThreads(int fd,
+                                 ForkedThreadContext* contexts,
+                                 uint32_t max_count,
+                                 uint32_t* count) {
+  *count = 0;
+
+  // This may run on a small signal stack, so the directory is read in small
+  // pieces.
+  alignas(LinuxDirent64) char buffer[1024];
+  while (true) {
+    long size = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+    if (size < 0) {
+      return errno;
+    }
+    if (size == 0) {
+      return 0;
+    }
+
+    for (long offset = 0; offset < size;) {
+      const LinuxDirent64* entry =
+          reinterpret_cast<const LinuxDirent64*>(&buffer[offset]);
+      offset += entry->d_reclen;
+
+      // Skip “.” and “..”.
+      const char* name = entry->d_name;
+      if (*name < '0' || *name > '9') {
+        continue;
+      }
+      pid_t tid = 0;
+      for (; *name >= '0' && *name <= '9'; ++name) {
+        tid = tid * 10 + (*name - '0');
+      }
+
+      if (contexts && *count < max_count) {
+        contexts[*count].thread_id = tid;
+      }
+      ++*count;
+    }
+  }
+}
+
+// static
+void CopyOnWriteFork::HandleCaptureSignal(int signo,
+                                          siginfo_t* siginfo,
+                                          void* context) {
+  const int saved_errno = errno;
+  g_handlers_in_flight.fetch_add(1);
+  CopyOnWriteFork* fork = g_active_fork.load();
+  if (fork) {
+    fork->RecordThread(static_cast<const ucontext_t*>(context));
+  }
+  g_handlers_in_flight.fetch_sub(1);
+  errno = saved_errno;
+}
+
+void CopyOnWriteFork::RecordThread(const ucontext_t* context) {
+#if defined(ARCH_CPU_X86_FAMILY)
+  // A thread recorded too late to be included in the fork doesn’t stop.
+  if (released_.load()) {
+    return;
+  }
+
+  const pid_t tid = GetTid();
+  uint32_t index = 0;
+  while (index < context_count_ &&
+         (contexts_[index].thread_id != tid || contexts_[index].valid)) {
+    ++index;
+  }
+  if (index == context_count_) {
+    return;
+  }
+
+  // The signal handler’s context is copied up to its signal mask, which isn’t
+  // needed. Its floating-point state is elsewhere on the signal stack, and is
+  // copied alongside it.
+  ThreadRecord* record = &records_[index];
+  memcpy(&record->context, context, offsetof(ucontext_t, uc_sigmask));
+  const uint8_t* fpregs =
+      reinterpret_cast<const uint8_t*>(context->uc_mcontext.fpregs);
+  if (fpregs) {
+#if defined(ARCH_CPU_X86_64)
+    memcpy(record->float_state, fpregs, kFxsaveSize);
+#else
+    memcpy(record->float_state, fpregs, kFsaveSize);
+    uint16_t magic;
+    memcpy(&magic, fpregs + kFsaveMagicOffset, sizeof(magic));
+    if (magic == X86_FXSR_MAGIC) {
+      memcpy(
+          record->float_state + kFsaveSize, fpregs + kFsaveSize, kFxsaveSize);
+    }
+#endif  // ARCH_CPU_X86_64
+    record->context.uc_mcontext.fpregs =
+        reinterpret_cast<fpregset_t>(record->float_state);
+  }
+
+  ForkedThreadContext* forked_context = &contexts_[index];
+  forked_context->context_address =
+      reinterpret_cast<LinuxVMAddress>(&record->context);
+  forked_context->thread_specific_data_address =
+      static_cast<LinuxVMAddress>(pthread_self());
+
+  // The record must be complete in the fork if it is marked valid there.
+  std::atomic_thread_fence(std::memory_order_release);
+  forked_context->valid = 1;
+
+  recorded_count_.fetch_add(1);
+  FutexWake(&recorded_count_);
+
+  if (tid == forking_tid_) {
+    return;
+  }
+
+  // Stay stopped here, where the context was recorded, until the fork exists.
+  while (!released_.load()) {
+    FutexWait(&released_, 0, nullptr);
+  }
+#endif  // ARCH_CPU_X86_FAMILY
+}
+
+void CopyOnWriteFork::WaitForRecords(uint32_t expected_count) {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  timespec deadline = now;
+  deadline.tv_nsec += kRecordTimeoutNanoseconds;
+  if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+    deadline.tv_sec += 1;
+    deadline.tv_nsec -= 1000 * 1000 * 1000;
+  }
+
+  uint32_t recorded_count;
+  while ((recorded_count = recorded_count_.load()) < expected_count) {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    timespec remaining;
+    remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+    remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+    if (remaining.tv_nsec < 0) {
+      remaining.tv_sec -= 1;
+      remaining.tv_nsec += 1000 * 1000 * 1000;
+    }
+    if (remaining.tv_sec < 0) {
+      return;
+    }
+    FutexWait(&recorded_count_, recorded_count, &remaining);
+  }
+}
+
+}  // namespace crashpad
@@ -0,0 +1,124 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_COPY_ON_WRITE_FORK_H_
+#define CRASHPAD_UTIL_LINUX_COPY_ON_WRITE_FORK_H_
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <atomic>
+
+#include "base/macros.h"
+#include "util/linux/address_types.h"
+#include "util/linux/exception_handler_protocol.h"
+
+namespace crashpad {
+
+//! \brief Forks a frozen copy-on-write copy of this process, recording the
+//!     registers of each of its threads beforehand, so that the copy can be
+//!     snapshotted while this process continues to run.
+//!
+//! A fork has only the thread that created it, so the context of every thread
+//! is recorded in memory that the fork inherits, as an array of
+//! ForkedThreadContext structs. A handler reads the fork’s memory and these
+//! contexts in place of the process itself. See
+//! ClientInformation::snapshot_process_id.
+//!
+//! Threads are recorded by sending each of them a signal reserved for this
+//! purpose, whose handler records the thread’s context and then waits until
+//! the fork has been created, so that every thread is stopped where it was
+//! recorded when the process is copied. A thread that blocks the signal, or
+//! that doesn’t handle it in time, is left unrecorded.
+//!
+//! The fork is killed when this object is destroyed.
+//!
+//! All methods of this class are async-signal-safe, so that they may be used
+//! from a signal handler. Errors are reported through return values and are
+//! never logged. Only one fork may be created at a time in a process.
+class CopyOnWriteFork {
+ public:
+  CopyOnWriteFork();
+
+  //! \brief Kills and reaps the fork, if one was created.
+  ~CopyOnWriteFork();
+
+  //! \brief Records the context of each thread in this process, and then
+  //!     forks a copy of it that waits to be killed.
+  //!
+  //! This method may only be called once.
+  //!
+  //! \param[in] capture_signal The signal to send to each thread to record its
+  //!     context. A handler for it is installed when this method is first
+  //!     called and is left installed, so that a signal that arrives late is
+  //!     ignored. The signal must not be used for anything else.
+  //! \param[in] ptracer The process ID of a handler to permit to trace the fork
+  //!     when the Yama Linux security module is active, or `0` if no process
+  //!     other than this one’s ancestors needs to trace it.
+  //!
+  //! \return `0` on success. Otherwise, an `errno` value describing the
+  //!     failure. `EBUSY` is returned if another fork is being created.
+  int Fork(int capture_signal, pid_t ptracer);
+
+  //! \brief Returns the process ID of the fork, or `-1` if there is none.
+  pid_t ChildProcessID() const { return child_pid_; }
+
+  //! \brief Returns the address, in this process and in the fork, of the
+  //!     ForkedThreadContext structs describing this process’ threads.
+  LinuxVMAddress ThreadContextsAddress() const {
+    return reinterpret_cast<LinuxVMAddress>(contexts_);
+  }
+
+  //! \brief Returns the number of ForkedThreadContext structs at
+  //!     ThreadContextsAddress().
+  uint32_t ThreadContextCount() const { return context_count_; }
+
+ private:
+  struct ThreadRecord;
+
+  // Sets |count| to the number of threads named in the /proc/self/task
+  // directory open at |fd|, storing the thread IDs of up to |max_count| of them
+  // in |contexts| if it isn’t nullptr. Returns 0 or an errno value.
+  static int ListThreads(int fd,
+                         ForkedThreadContext* contexts,
+                         uint32_t max_count,
+                         uint32_t* count);
+
+  static void HandleCaptureSignal(int signo, siginfo_t* siginfo, void* context);
+
+  // Records the calling thread’s |context|, then waits until released_ is set.
+  void RecordThread(const ucontext_t* context);
+
+  // Waits until |expected_count| threads have been recorded, or until the
+  // timeout expires.
+  void WaitForRecords(uint32_t expected_count);
+
+  void* memory_;
+  size_t memory_size_;
+  ForkedThreadContext* contexts_;  // in memory_
+  ThreadRecord* records_;  // in memory_
+  uint32_t context_count_;
+  pid_t child_pid_;
+  pid_t forking_tid_;
+  std::atomic<uint32_t> recorded_count_;
+  std::atomic<uint32_t> released_;
+
+  DISALLOW_COPY_AND_ASSIGN(CopyOnWriteFork);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_COPY_ON_WRITE_FORK_H_
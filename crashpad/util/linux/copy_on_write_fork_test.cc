@@ -0,0 +1,153 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/copy_on_write_fork.h"
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <set>
+#include <vector>
+
+#include "build/build_config.h"
+#include "gtest/gtest.h"
+#include "util/linux/proc_stat_reader.h"
+#include "util/misc/from_pointer_cast.h"
+#include "util/process/process_memory.h"
+#include "util/synchronization/semaphore.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr int kCaptureSignal = SIGUSR2;
+
+pid_t GetTid() {
+  return syscall(SYS_gettid);
+}
+
+// Waits to be released once it has started.
+class WaitingThread : public Thread {
+ public:
+  WaitingThread() : Thread(), started_(0), released_(0), tid_(-1) {}
+  ~WaitingThread() {}
+
+  void WaitUntilStarted() { started_.Wait(); }
+  void Release() { released_.Signal(); }
+  pid_t tid() const { return tid_; }
+
+ private:
+  void ThreadMain() override {
+    tid_ = GetTid();
+    started_.Signal();
+    released_.Wait();
+  }
+
+  Semaphore started_;
+  Semaphore released_;
+  pid_t tid_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaitingThread);
+};
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+TEST(CopyOnWriteFork, RecordsThreads) {
+  constexpr size_t kThreadCount = 3;
+  WaitingThread threads[kThreadCount];
+  for (WaitingThread& thread : threads) {
+    thread.Start();
+    thread.WaitUntilStarted();
+  }
+
+  int value = 1;
+  CopyOnWriteFork fork;
+  ASSERT_EQ(fork.Fork(kCaptureSignal, 0), 0);
+  value = 2;
+
+  const pid_t child_pid = fork.ChildProcessID();
+  ASSERT_GT(child_pid, 0);
+
+  ProcStatReader stat;
+  ASSERT_TRUE(stat.Initialize(child_pid));
+  pid_t parent_pid;
+  ASSERT_TRUE(stat.ParentProcessID(&parent_pid));
+  EXPECT_EQ(parent_pid, getpid());
+
+  // The fork’s memory is a copy made before value changed.
+  ProcessMemory memory;
+  ASSERT_TRUE(memory.Initialize(child_pid));
+  int forked_value;
+  ASSERT_TRUE(memory.Read(
+      FromPointerCast<LinuxVMAddress>(&value), sizeof(value), &forked_value));
+  EXPECT_EQ(forked_value, 1);
+  EXPECT_EQ(value, 2);
+
+  std::vector<ForkedThreadContext> contexts(fork.ThreadContextCount());
+  ASSERT_GE(contexts.size(), kThreadCount + 1);
+  ASSERT_TRUE(memory.Read(fork.ThreadContextsAddress(),
+                          contexts.size() * sizeof(contexts[0]),
+                          contexts.data()));
+
+  std::set<pid_t> recorded_tids;
+  for (const ForkedThreadContext& context : contexts) {
+    EXPECT_TRUE(context.valid) << context.thread_id;
+    EXPECT_NE(context.thread_specific_data_address, 0u);
+    recorded_tids.insert(context.thread_id);
+
+    if (context.thread_id != getpid()) {
+      continue;
+    }
+
+    EXPECT_EQ(context.thread_specific_data_address,
+              static_cast<LinuxVMAddress>(pthread_self()));
+
+    // The main thread was recorded while in Fork(), below this frame.
+    ucontext_t ucontext;
+    ASSERT_TRUE(memory.Read(
+        context.context_address, sizeof(ucontext), &ucontext));
+#if defined(ARCH_CPU_X86_64)
+    const LinuxVMAddress stack_pointer = ucontext.uc_mcontext.gregs[REG_RSP];
+#else
+    const LinuxVMAddress stack_pointer = ucontext.uc_mcontext.gregs[REG_ESP];
+#endif  // ARCH_CPU_X86_64
+    EXPECT_LT(stack_pointer, FromPointerCast<LinuxVMAddress>(&value));
+    EXPECT_NE(ucontext.uc_mcontext.fpregs, nullptr);
+  }
+
+  EXPECT_EQ(recorded_tids.count(getpid()), 1u);
+  for (WaitingThread& thread : threads) {
+    EXPECT_EQ(recorded_tids.count(thread.tid()), 1u);
+  }
+
+  for (WaitingThread& thread : threads) {
+    thread.Release();
+    thread.Join();
+  }
+}
+
+TEST(CopyOnWriteFork, OnlyOnce) {
+  CopyOnWriteFork fork;
+  ASSERT_EQ(fork.Fork(kCaptureSignal, 0), 0);
+  EXPECT_EQ(fork.Fork(kCaptureSignal, 0), EALREADY);
+}
+
+#endif  // ARCH_CPU_X86_FAMILY
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -63,4 +63,16 @@ bool DirectPtraceConnection::GetThreadInfo(pid_t tid, ThreadInfo* info) {
   return ptracer_.GetThreadInfo(tid, info);
 }
 
+void DirectPtraceConnection::AttachAndGetThreadInfo(
+    std::vector<ThreadRequest>* requests) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  for (ThreadRequest& request : *requests) {
+    request.success =
+        Attach(request.tid) &&
+        ptracer_.GetThreadInfo(
+            request.tid, request.float_context, &request.info);
+  }
+}
+
 }  // namespace crashpad
@@ -50,6 +50,7 @@ class DirectPtraceConnection : public PtraceConnection {
   bool Attach(pid_t tid) override;
   bool Is64Bit() override;
   bool GetThreadInfo(pid_t tid, ThreadInfo* info) override;
+  void AttachAndGetThreadInfo(std::vector<ThreadRequest>* requests) override;
 
  private:
   PointerVector<ScopedPtraceAttach> attachments_;
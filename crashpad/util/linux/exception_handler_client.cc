@@ -0,0 +1,133 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/exception_handler_client.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base/posix/eintr_wrapper.h"
+#include "util/linux/copy_on_write_fork.h"
+
+namespace crashpad {
+
+ExceptionHandlerClient::ExceptionHandlerClient(int sock)
+    : server_sock_(sock) {}
+
+ExceptionHandlerClient::~ExceptionHandlerClient() {}
+
+int ExceptionHandlerClient::RequestCrashDump(const ClientInformation& info) {
+  ClientToServerMessage message;
+  message.type = ClientToServerMessage::kCrashDumpRequest;
+  message.client_info = info;
+
+  int result = SendMessage(message, -1);
+  if (result != 0) {
+    return result;
+  }
+
+  ServerToClientMessage reply;
+  ssize_t received =
+      HANDLE_EINTR(recv(server_sock_, &reply, sizeof(reply), 0));
+  if (received < 0) {
+    return errno;
+  }
+  if (received != sizeof(reply)) {
+    // A zero-length read means the server went away without replying.
+    return received == 0 ? ECONNRESET : EPROTO;
+  }
+
+  return reply.type == ServerToClientMessage::kCrashDumpComplete ? 0 : EIO;
+}
+
+int ExceptionHandlerClient::RequestForkedCrashDump(
+    const ClientInformation& info,
+    int capture_signal,
+    pid_t ptracer) {
+  CopyOnWriteFork fork;
+  int result = fork.Fork(capture_signal, ptracer);
+  if (result != 0) {
+    return result;
+  }
+
+  ClientInformation forked_info = info;
+  forked_info.snapshot_process_id = fork.ChildProcessID();
+  forked_info.thread_contexts_address = fork.ThreadContextsAddress();
+  forked_info.thread_context_count = fork.ThreadContextCount();
+  return RequestCrashDump(forked_info);
+}
+
+int ExceptionHandlerClient::AddClient(int client_sock) {
+  ClientToServerMessage message;
+  message.type = ClientToServerMessage::kAddClient;
+  return SendMessage(message, client_sock);
+}
+
+// static
+int ExceptionHandlerClient::SetPtracer(pid_t pid) {
+  if (prctl(PR_SET_PTRACER, pid, 0, 0, 0) == 0) {
+    return 0;
+  }
+
+  // EINVAL means that Yama is not active, in which case there’s nothing to
+  // do.
+  return errno == EINVAL ? 0 : errno;
+}
+
+int ExceptionHandlerClient::SendMessage(const ClientToServerMessage& message,
+                                        int fd) {
+  iovec iov;
+  iov.iov_base = const_cast<ClientToServerMessage*>(&message);
+  iov.iov_len = sizeof(message);
+
+  // The server requires credentials with every message. They are sent
+  // explicitly so that the request doesn’t depend on SO_PASSCRED having been
+  // set on the server’s end before this message was queued.
+  char cmsg_buf[CMSG_SPACE(sizeof(ucred)) + CMSG_SPACE(sizeof(int))];
+  memset(cmsg_buf, 0, sizeof(cmsg_buf));
+
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsg_buf;
+  msg.msg_controllen = CMSG_SPACE(sizeof(ucred));
+
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_CREDENTIALS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(ucred));
+  ucred* creds = reinterpret_cast<ucred*>(CMSG_DATA(cmsg));
+  creds->pid = getpid();
+  creds->uid = geteuid();
+  creds->gid = getegid();
+
+  if (fd >= 0) {
+    msg.msg_controllen += CMSG_SPACE(sizeof(int));
+    cmsg = CMSG_NXTHDR(&msg, cmsg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+  }
+
+  if (HANDLE_EINTR(sendmsg(server_sock_, &msg, MSG_NOSIGNAL)) < 0) {
+    return errno;
+  }
+  return 0;
+}
+
+}  // namespace crashpad
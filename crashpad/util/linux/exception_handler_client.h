@@ -0,0 +1,110 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_EXCEPTION_HANDLER_CLIENT_H_
+#define CRASHPAD_UTIL_LINUX_EXCEPTION_HANDLER_CLIENT_H_
+
+#include <sys/types.h>
+
+#include "base/macros.h"
+#include "util/linux/exception_handler_protocol.h"
+
+namespace crashpad {
+
+//! \brief A client for an ExceptionHandlerServer.
+//!
+//! All methods of this class are async-signal-safe, so that they may be used
+//! from a crash signal handler. Errors are reported through return values and
+//! are never logged.
+class ExceptionHandlerClient {
+ public:
+  //! \brief Constructs this object.
+  //!
+  //! \param[in] sock A `SOCK_SEQPACKET` socket connected to an
+  //!     ExceptionHandlerServer. The caller retains ownership of \a sock.
+  explicit ExceptionHandlerClient(int sock);
+
+  ~ExceptionHandlerClient();
+
+  //! \brief Requests a crash dump of this process and waits for the server to
+  //!     finish writing it.
+  //!
+  //! \param[in] info Information about this client. Its
+  //!     ClientInformation::exception_information_address must name an
+  //!     ExceptionInformation in this process that remains valid until this
+  //!     method returns.
+  //!
+  //! \return `0` if the crash dump was written. Otherwise, an `errno` value
+  //!     describing the failure. `EIO` is returned if the server reported that
+  //!     it was unable to write the crash dump.
+  int RequestCrashDump(const ClientInformation& info);
+
+  //! \brief Requests a crash dump of a copy-on-write fork of this process and
+  //!     waits for the server to finish writing it.
+  //!
+  //! The registers of each thread are recorded and the process is forked with
+  //! a CopyOnWriteFork. The server reads the fork in place of this process, so
+  //! that the threads of this process are only stopped while the fork is
+  //! created, and not while the snapshot is taken. This suits dumps that are
+  //! requested without a crash, after which this process continues to run.
+  //!
+  //! \param[in] info Information about this client, as for
+  //!     RequestCrashDump(). The ClientInformation::snapshot_process_id and
+  //!     thread context fields are set by this method.
+  //! \param[in] capture_signal The signal reserved for recording each thread’s
+  //!     registers. See CopyOnWriteFork::Fork().
+  //! \param[in] ptracer The process ID of the handler, if it must be permitted
+  //!     to trace the fork, or `0`. See SetPtracer().
+  //!
+  //! \return `0` if the crash dump was written. Otherwise, an `errno` value
+  //!     describing the failure, as for RequestCrashDump().
+  int RequestForkedCrashDump(const ClientInformation& info,
+                             int capture_signal,
+                             pid_t ptracer);
+
+  //! \brief Registers another socket with the server.
+  //!
+  //! \param[in] client_sock One end of a `SOCK_SEQPACKET` socket pair. The
+  //!     server will accept crash dump requests from the other end as though
+  //!     it had been connected from the start. The caller retains ownership of
+  //!     \a client_sock, and may close it after this method returns.
+  //!
+  //! \return `0` on success. Otherwise, an `errno` value describing the
+  //!     failure.
+  int AddClient(int client_sock);
+
+  //! \brief Permits \a pid to trace this process.
+  //!
+  //! When the Yama Linux security module is active, a process may only be
+  //! traced by its ancestors unless it names its tracer explicitly. A handler
+  //! that is not an ancestor of its client must be named with this method
+  //! before it can produce a crash dump.
+  //!
+  //! \param[in] pid The process ID of the handler.
+  //!
+  //! \return `0` on success or if Yama is not active. Otherwise, an `errno`
+  //!     value describing the failure.
+  static int SetPtracer(pid_t pid);
+
+ private:
+  int SendMessage(const ClientToServerMessage& message, int fd);
+
+  int server_sock_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExceptionHandlerClient);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_EXCEPTION_HANDLER_CLIENT_H_
@@ -0,0 +1,138 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_EXCEPTION_HANDLER_PROTOCOL_H_
+#define CRASHPAD_UTIL_LINUX_EXCEPTION_HANDLER_PROTOCOL_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "util/linux/address_types.h"
+
+namespace crashpad {
+
+#pragma pack(push, 1)
+
+//! \brief The signal context of a crash, which a client stores in its own
+//!     memory before requesting a crash dump.
+struct ExceptionInformation {
+  //! \brief The address of the `siginfo_t` passed to the signal handler.
+  LinuxVMAddress siginfo_address;
+
+  //! \brief The address of the `ucontext_t` passed to the signal handler.
+  LinuxVMAddress context_address;
+
+  //! \brief The thread ID of the thread that received the signal.
+  pid_t thread_id;
+};
+
+//! \brief The context of one thread of a client that is snapshotted through a
+//!     copy-on-write fork, recorded by the client before forking.
+//!
+//! A fork has only one thread, so the context of each of the client’s threads
+//! is recorded in memory that the fork inherits, from which the handler reads
+//! it in place of the registers of the thread itself.
+struct ForkedThreadContext {
+  //! \brief The address of a `ucontext_t` holding the thread’s registers.
+  //!
+  //! Its `uc_mcontext.fpregs` points to a copy of the thread’s floating-point
+  //! state in the same memory.
+  LinuxVMAddress context_address;
+
+  //! \brief The thread’s thread-specific data address, as reported by
+  //!     `pthread_self()`.
+  LinuxVMAddress thread_specific_data_address;
+
+  //! \brief The thread ID of the thread.
+  pid_t thread_id;
+
+  //! \brief Nonzero if the thread’s context was recorded. A thread that didn’t
+  //!     respond in time, such as one blocking the signal used to record it,
+  //!     leaves this `0`.
+  uint32_t valid;
+};
+
+//! \brief Information about a client sent with a crash dump request.
+struct ClientInformation {
+  ClientInformation();
+
+  //! \brief The address, in the client’s address space, of an
+  //!     ExceptionInformation struct.
+  LinuxVMAddress exception_information_address;
+
+  //! \brief The process ID of a copy-on-write fork of the client to read in
+  //!     place of the client, or `0` to read the client itself.
+  //!
+  //! The fork must be a child of the client. Its memory is read as the client’s
+  //! memory, including the ExceptionInformation at
+  //! #exception_information_address, while the client continues to run.
+  pid_t snapshot_process_id;
+
+  //! \brief The number of ForkedThreadContext structs at
+  //!     #thread_contexts_address, valid when #snapshot_process_id is nonzero.
+  uint32_t thread_context_count;
+
+  //! \brief The address, in the fork’s address space, of an array of
+  //!     ForkedThreadContext structs describing the client’s threads, valid
+  //!     when #snapshot_process_id is nonzero.
+  LinuxVMAddress thread_contexts_address;
+};
+
+//! \brief A message sent from a client to an ExceptionHandlerServer over a
+//!     `SOCK_SEQPACKET` socket.
+//!
+//! Every message is accompanied by `SCM_CREDENTIALS` identifying the sender.
+struct ClientToServerMessage {
+  enum Type : uint32_t {
+    //! \brief Requests a crash dump of the sending process. The sender must
+    //!     wait for a ServerToClientMessage before continuing.
+    kCrashDumpRequest = 0,
+
+    //! \brief Passes, as `SCM_RIGHTS`, another `SOCK_SEQPACKET` socket for the
+    //!     server to accept requests on. This lets a client register a new
+    //!     process, such as a child, with an already-running handler.
+    kAddClient,
+  };
+
+  ClientToServerMessage();
+
+  //! \brief The kind of request.
+  Type type;
+
+  //! \brief Information about the client, valid for #kCrashDumpRequest.
+  ClientInformation client_info;
+};
+
+//! \brief A message sent from an ExceptionHandlerServer to a client in reply
+//!     to a ClientToServerMessage::kCrashDumpRequest.
+struct ServerToClientMessage {
+  enum Type : uint32_t {
+    //! \brief The crash dump was written.
+    kCrashDumpComplete = 0,
+
+    //! \brief The crash dump could not be written.
+    kCrashDumpFailed,
+  };
+
+  ServerToClientMessage();
+
+  //! \brief The result of the request.
+  Type type;
+};
+
+#pragma pack(pop)
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_EXCEPTION_HANDLER_PROTOCOL_H_
@@ -0,0 +1,236 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/io_uring_reader.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+#include "build/build_config.h"
+
+namespace crashpad {
+
+IOUringReader::IOUringReader()
+    : ring_fd_(),
+      sq_ring_(),
+      cq_ring_(),
+      sqes_mapping_(),
+      sq_tail_(nullptr),
+      sq_array_(nullptr),
+      sqes_(nullptr),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cqes_(nullptr),
+      sq_mask_(0),
+      cq_mask_(0),
+      sq_entries_(0),
+      fd_(-1) {}
+
+IOUringReader::~IOUringReader() {}
+
+bool IOUringReader::Initialize(int fd, unsigned int queue_depth) {
+#if defined(OS_ANDROID) || !defined(__NR_io_uring_setup)
+  // Android’s seccomp policy for apps kills a process that uses io_uring,
+  // rather than failing the call.
+  return false;
+#else
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+  if (ring_fd < 0) {
+    if (errno != ENOSYS && errno != EPERM) {
+      PLOG(ERROR) << "io_uring_setup";
+    }
+    return false;
+  }
+  ring_fd_.reset(ring_fd);
+
+  // The rings and the submission queue entries are mapped separately, which
+  // every kernel with io_uring allows.
+  const size_t page_size = getpagesize();
+  const auto mapping_size = [page_size](size_t size) {
+    return (size + page_size - 1) & ~(page_size - 1);
+  };
+  if (!sq_ring_.ResetMmap(
+          nullptr,
+          mapping_size(params.sq_off.array +
+                       params.sq_entries * sizeof(uint32_t)),
+          PROT_READ | PROT_WRITE,
+          MAP_SHARED | MAP_POPULATE,
+          ring_fd_.get(),
+          IORING_OFF_SQ_RING) ||
+      !cq_ring_.ResetMmap(
+          nullptr,
+          mapping_size(params.cq_off.cqes +
+                       params.cq_entries * sizeof(io_uring_cqe)),
+          PROT_READ | PROT_WRITE,
+          MAP_SHARED | MAP_POPULATE,
+          ring_fd_.get(),
+          IORING_OFF_CQ_RING) ||
+      !sqes_mapping_.ResetMmap(
+          nullptr,
+          mapping_size(params.sq_entries * sizeof(io_uring_sqe)),
+          PROT_READ | PROT_WRITE,
+          MAP_SHARED | MAP_POPULATE,
+          ring_fd_.get(),
+          IORING_OFF_SQES)) {
+    return false;
+  }
+
+  char* sq_ring = sq_ring_.addr_as<char*>();
+  sq_tail_ = reinterpret_cast<uint32_t*>(sq_ring + params.sq_off.tail);
+  sq_array_ = reinterpret_cast<uint32_t*>(sq_ring + params.sq_off.array);
+  sq_mask_ = *reinterpret_cast<uint32_t*>(sq_ring + params.sq_off.ring_mask);
+  sqes_ = sqes_mapping_.addr_as<io_uring_sqe*>();
+
+  char* cq_ring = cq_ring_.addr_as<char*>();
+  cq_head_ = reinterpret_cast<uint32_t*>(cq_ring + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<const uint32_t*>(cq_ring + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32_t*>(cq_ring + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<const io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+
+  sq_entries_ = params.sq_entries;
+  fd_ = fd;
+  return true;
+#endif
+}
+
+bool IOUringReader::ReadBatch(const std::vector<Request>& requests,
+                              std::vector<size_t>* bytes_read) {
+  DCHECK(ring_fd_.is_valid());
+
+  bytes_read->assign(requests.size(), 0);
+
+#if defined(__NR_io_uring_enter)
+  // Each outstanding read occupies a slot, by which its completion is
+  // identified. The iovec must outlive the read. No more reads are outstanding
+  // than there are submission queue entries, and the kernel makes the
+  // completion queue at least as large, so it can’t overflow.
+  struct Slot {
+    size_t request;
+    iovec iov;
+  };
+  std::vector<Slot> slots(sq_entries_);
+  std::vector<uint32_t> free_slots;
+  free_slots.reserve(sq_entries_);
+  for (uint32_t slot = 0; slot < sq_entries_; ++slot) {
+    free_slots.push_back(slot);
+  }
+
+  // Requests that stopped short, to be continued before new ones are started.
+  std::vector<size_t> continuations;
+  size_t next_request = 0;
+  uint32_t outstanding = 0;
+  uint32_t unsubmitted = 0;
+  uint32_t sq_tail = *sq_tail_;
+
+  while (true) {
+    while (!free_slots.empty()) {
+      size_t request_index;
+      if (!continuations.empty()) {
+        request_index = continuations.back();
+        continuations.pop_back();
+      } else if (next_request < requests.size()) {
+        request_index = next_request++;
+        if (requests[request_index].size == 0) {
+          continue;
+        }
+      } else {
+        break;
+      }
+
+      const Request& request = requests[request_index];
+      const size_t done = (*bytes_read)[request_index];
+      const uint32_t slot_index = free_slots.back();
+      free_slots.pop_back();
+      Slot& slot = slots[slot_index];
+      slot.request = request_index;
+      slot.iov.iov_base = static_cast<char*>(request.buffer) + done;
+      slot.iov.iov_len = request.size - done;
+
+      const uint32_t sq_index = sq_tail & sq_mask_;
+      io_uring_sqe* sqe = &sqes_[sq_index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_READV;
+      sqe->fd = fd_;
+      sqe->off = request.offset + done;
+      sqe->addr = reinterpret_cast<uintptr_t>(&slot.iov);
+      sqe->len = 1;
+      sqe->user_data = slot_index;
+      sq_array_[sq_index] = sq_index;
+      ++sq_tail;
+      ++unsubmitted;
+      ++outstanding;
+    }
+
+    if (outstanding == 0) {
+      return true;
+    }
+
+    // Publishes the new entries to the kernel before it’s asked to consume
+    // them.
+    __atomic_store_n(sq_tail_, sq_tail, __ATOMIC_RELEASE);
+    const int submitted = syscall(__NR_io_uring_enter,
+                                  ring_fd_.get(),
+                                  unsubmitted,
+                                  1,
+                                  IORING_ENTER_GETEVENTS,
+                                  nullptr,
+                                  0);
+    if (submitted < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      PLOG(ERROR) << "io_uring_enter";
+      return false;
+    }
+    unsubmitted -= submitted;
+
+    uint32_t cq_head = *cq_head_;
+    const uint32_t cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; cq_head != cq_tail; ++cq_head) {
+      const io_uring_cqe& cqe = cqes_[cq_head & cq_mask_];
+      const uint32_t slot_index = static_cast<uint32_t>(cqe.user_data);
+      const size_t request_index = slots[slot_index].request;
+      free_slots.push_back(slot_index);
+      --outstanding;
+
+      if (cqe.res > 0) {
+        size_t& done = (*bytes_read)[request_index];
+        done += cqe.res;
+        if (done < requests[request_index].size) {
+          continuations.push_back(request_index);
+        }
+      } else if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+        continuations.push_back(request_index);
+      }
+
+      // Otherwise, the read reached the end of the file or failed, and the
+      // caller learns which from pread64().
+    }
+    __atomic_store_n(cq_head_, cq_head, __ATOMIC_RELEASE);
+  }
+#else
+  NOTREACHED();
+  return false;
+#endif
+}
+
+}  // namespace crashpad
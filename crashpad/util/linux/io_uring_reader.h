@@ -0,0 +1,103 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_IO_URING_READER_H_
+#define CRASHPAD_UTIL_LINUX_IO_URING_READER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/files/scoped_file.h"
+#include "base/macros.h"
+#include "util/posix/scoped_mmap.h"
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace crashpad {
+
+//! \brief Reads many regions of a file at once with `io_uring`.
+//!
+//! Each `pread64()` waits for its read to finish before the next can be
+//! issued. This keeps many reads outstanding, so that reads of a file such as
+//! `/proc/<pid>/mem`, which the kernel services in worker threads, proceed
+//! together. A read that stops short is continued from where it stopped until
+//! it finishes, reaches the end of the file, or fails.
+class IOUringReader {
+ public:
+  //! \brief A request to read a region of the file, used by ReadBatch().
+  struct Request {
+    //! \brief The offset in the file of the region to read.
+    uint64_t offset;
+
+    //! \brief The size, in bytes, of the region to read.
+    size_t size;
+
+    //! \brief The buffer, at least #size bytes long, into which the region
+    //!     will be read.
+    void* buffer;
+  };
+
+  IOUringReader();
+  ~IOUringReader();
+
+  //! \brief Initializes this object to read from a file.
+  //!
+  //! \param[in] fd The file to read from. It must remain open while this
+  //!     object is in use.
+  //! \param[in] queue_depth The number of reads to keep outstanding.
+  //!
+  //! \return `true` on success. `false` on failure, in which case the file
+  //!     should be read with `pread64()`. A message is logged unless
+  //!     `io_uring` is unavailable because the kernel predates it or it is
+  //!     disallowed.
+  bool Initialize(int fd, unsigned int queue_depth);
+
+  //! \brief Reads several regions of the file.
+  //!
+  //! \param[in] requests The regions to read.
+  //! \param[out] bytes_read The number of bytes read from the start of each of
+  //!     \a requests, in the same order. A region that couldn’t be read in
+  //!     full can be read from there with `pread64()`, to learn why.
+  //!
+  //! \return `true` if every read was attempted. `false` if the ring failed,
+  //!     with a message logged. In that case, \a bytes_read holds what was
+  //!     read before the failure, and this object mustn’t be used further.
+  bool ReadBatch(const std::vector<Request>& requests,
+                 std::vector<size_t>* bytes_read);
+
+ private:
+  base::ScopedFD ring_fd_;
+  ScopedMmap sq_ring_;
+  ScopedMmap cq_ring_;
+  ScopedMmap sqes_mapping_;
+  uint32_t* sq_tail_;  // weak, in sq_ring_
+  uint32_t* sq_array_;  // weak, in sq_ring_
+  io_uring_sqe* sqes_;  // weak, in sqes_mapping_
+  uint32_t* cq_head_;  // weak, in cq_ring_
+  const uint32_t* cq_tail_;  // weak, in cq_ring_
+  const io_uring_cqe* cqes_;  // weak, in cq_ring_
+  uint32_t sq_mask_;
+  uint32_t cq_mask_;
+  uint32_t sq_entries_;
+  int fd_;
+
+  DISALLOW_COPY_AND_ASSIGN(IOUringReader);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_IO_URING_READER_H_
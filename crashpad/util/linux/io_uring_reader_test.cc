@@ -0,0 +1,100 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/io_uring_reader.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "base/posix/eintr_wrapper.h"
+#include "gtest/gtest.h"
+#include "test/errors.h"
+#include "util/misc/from_pointer_cast.h"
+#include "util/posix/scoped_mmap.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(IOUringReader, ReadBatch) {
+  base::ScopedFD mem_fd(
+      HANDLE_EINTR(open("/proc/self/mem", O_RDONLY | O_NOCTTY | O_CLOEXEC)));
+  ASSERT_TRUE(mem_fd.is_valid()) << ErrnoMessage("open");
+
+  IOUringReader reader;
+  if (!reader.Initialize(mem_fd.get(), 8)) {
+    // io_uring is unavailable here, and callers read with pread64() instead.
+    return;
+  }
+
+  const size_t page_size = getpagesize();
+  ScopedMmap mapping;
+  ASSERT_TRUE(mapping.ResetMmap(nullptr,
+                                3 * page_size,
+                                PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS,
+                                -1,
+                                0));
+  char* region = mapping.addr_as<char*>();
+  for (size_t index = 0; index < 2 * page_size; ++index) {
+    region[index] = static_cast<char>(index * 7);
+  }
+
+  // /proc/<pid>/mem reads memory regardless of its protection, so the last
+  // page is unmapped to make it unreadable.
+  ASSERT_TRUE(mapping.ResetAddrLen(region, 2 * page_size));
+
+  // More requests than the queue holds, so that slots are reused, one that
+  // stops short at the unreadable page, and one that can’t be read at all.
+  std::vector<char> results(2 * page_size + 2 * page_size + 16, 0);
+  std::vector<IOUringReader::Request> requests;
+  constexpr size_t kSmallReads = 32;
+  const size_t small_size = 2 * page_size / kSmallReads;
+  for (size_t index = 0; index < kSmallReads; ++index) {
+    requests.push_back({FromPointerCast<uint64_t>(region) + index * small_size,
+                        small_size,
+                        &results[index * small_size]});
+  }
+  requests.push_back({FromPointerCast<uint64_t>(region) + page_size,
+                      2 * page_size,
+                      &results[2 * page_size]});
+  requests.push_back({FromPointerCast<uint64_t>(region) + 2 * page_size,
+                      16,
+                      &results[4 * page_size]});
+  requests.push_back({FromPointerCast<uint64_t>(region), 0, nullptr});
+
+  std::vector<size_t> bytes_read;
+  ASSERT_TRUE(reader.ReadBatch(requests, &bytes_read));
+  ASSERT_EQ(bytes_read.size(), requests.size());
+
+  for (size_t index = 0; index < kSmallReads; ++index) {
+    EXPECT_EQ(bytes_read[index], small_size);
+  }
+  EXPECT_EQ(memcmp(&results[0], region, 2 * page_size), 0);
+
+  EXPECT_EQ(bytes_read[kSmallReads], page_size);
+  EXPECT_EQ(memcmp(&results[2 * page_size], region + page_size, page_size),
+            0);
+
+  EXPECT_EQ(bytes_read[kSmallReads + 1], 0u);
+  EXPECT_EQ(bytes_read[kSmallReads + 2], 0u);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -15,46 +15,96 @@
 #include "util/linux/memory_map.h"
 
 #include <linux/kdev_t.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <limits>
+
 #include "base/files/file_path.h"
 #include "base/logging.h"
 #include "build/build_config.h"
-#include "util/file/delimited_file_reader.h"
 #include "util/file/file_io.h"
-#include "util/file/string_file.h"
-#include "util/stdlib/string_number_conversion.h"
 
 namespace crashpad {
 
 namespace {
 
-// This function is used in this file specfically for signed or unsigned longs.
-// longs are typically either int or int64 sized, but pointers to longs are not
-// automatically coerced to pointers to ints when they are the same size.
-// Simply adding a StringToNumber for longs doesn't work since sometimes long
-// and int64_t are actually the same type, resulting in a redefinition error.
-template <typename Type>
-bool LocalStringToNumber(const base::StringPiece& string, Type* number) {
-  static_assert(sizeof(Type) == sizeof(int) || sizeof(Type) == sizeof(int64_t),
-                "Unexpected Type size");
-
-  if (sizeof(Type) == sizeof(int)) {
-    return std::numeric_limits<Type>::is_signed
-               ? StringToNumber(string, reinterpret_cast<int*>(number))
-               : StringToNumber(string,
-                                reinterpret_cast<unsigned int*>(number));
-  } else {
-    return std::numeric_limits<Type>::is_signed
-               ? StringToNumber(string, reinterpret_cast<int64_t*>(number))
-               : StringToNumber(string, reinterpret_cast<uint64_t*>(number));
+// Reads the entire maps file at |path| into |contents|.
+//
+// The kernel produces maps files through seq_file, which fills as much of each
+// read() buffer as it can while holding the target’s memory map lock. Reading
+// into a buffer large enough for the whole file keeps the number of reads, and
+// the window for the map to change between them, as small as possible.
+// |contents| is used as the initial buffer, so a buffer sized by a previous
+// attempt can be reused.
+bool ReadMapsFile(const base::FilePath& path, std::string* contents) {
+  ScopedFileHandle handle(LoggingOpenFileForRead(path));
+  if (!handle.is_valid()) {
+    return false;
+  }
+
+  constexpr size_t kMinimumBufferSize = 64 * 1024;
+  contents->resize(std::max(contents->capacity(), kMinimumBufferSize));
+
+  size_t length = 0;
+  FileOperationResult rv;
+  while ((rv = ReadFile(
+              handle.get(), &(*contents)[length], contents->size() - length)) >
+         0) {
+    length += rv;
+    if (length == contents->size()) {
+      contents->resize(contents->size() * 2);
+    }
+  }
+  if (rv < 0) {
+    PLOG(ERROR) << internal::kNativeReadFunctionName;
+    return false;
   }
+
+  contents->resize(length);
+  return true;
 }
 
+// Parses digits in |base| at |*position| up to |delimiter|, advancing
+// |*position| past |delimiter|.
 template <typename Type>
-bool HexStringToNumber(const std::string& string, Type* number) {
-  return LocalStringToNumber("0x" + string, number);
+bool ParseNumber(const char** position,
+                 const char* end,
+                 unsigned int base,
+                 char delimiter,
+                 Type* number) {
+  const char* cursor = *position;
+  uint64_t value = 0;
+  for (; cursor < end && *cursor != delimiter; ++cursor) {
+    unsigned int digit;
+    const char c = *cursor;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (base == 16 && c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (base == 16 && c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return false;
+    }
+    if (digit >= base ||
+        value > (std::numeric_limits<uint64_t>::max() - digit) / base) {
+      return false;
+    }
+    value = value * base + digit;
+  }
+
+  if (cursor == *position || cursor == end ||
+      value > static_cast<uint64_t>(std::numeric_limits<Type>::max())) {
+    return false;
+  }
+
+  *number = static_cast<Type>(value);
+
+  *position = cursor + 1;
+  return true;
 }
 
 // The result from parsing a line from the maps file.
@@ -73,36 +123,31 @@ enum class ParseResult {
   kError
 };
 
-// Reads a line from a maps file being read by maps_file_reader and extends
-// mappings with a new MemoryMap::Mapping describing the line.
-ParseResult ParseMapsLine(DelimitedFileReader* maps_file_reader,
+// Parses the line at |*position| in a maps file ending at |end| and extends
+// mappings with a new MemoryMap::Mapping describing the line. The mapping’s
+// name refers to the maps file contents. |*position| is advanced to the start
+// of the next line.
+ParseResult ParseMapsLine(const char** position,
+                          const char* end,
                           std::vector<MemoryMap::Mapping>* mappings) {
-  std::string field;
-  LinuxVMAddress start_address;
-  switch (maps_file_reader->GetDelim('-', &field)) {
-    case DelimitedFileReader::Result::kError:
-      return ParseResult::kError;
-    case DelimitedFileReader::Result::kEndOfFile:
-      return ParseResult::kEndOfFile;
-    case DelimitedFileReader::Result::kSuccess:
-      field.pop_back();
-      if (!HexStringToNumber(field, &start_address)) {
-        LOG(ERROR) << "format error";
-        return ParseResult::kError;
-      }
-      if (!mappings->empty() && start_address < mappings->back().range.End()) {
-        return ParseResult::kRetry;
-      }
+  if (*position == end) {
+    return ParseResult::kEndOfFile;
   }
 
-  LinuxVMAddress end_address;
-  if (maps_file_reader->GetDelim(' ', &field) !=
-          DelimitedFileReader::Result::kSuccess ||
-      (field.pop_back(), !HexStringToNumber(field, &end_address))) {
+  const char* cursor = *position;
+
+  LinuxVMAddress start_address;
+  if (!ParseNumber(&cursor, end, 16, '-', &start_address)) {
     LOG(ERROR) << "format error";
     return ParseResult::kError;
   }
-  if (end_address <= start_address) {
+  if (!mappings->empty() && start_address < mappings->back().range.End()) {
+    return ParseResult::kRetry;
+  }
+
+  LinuxVMAddress end_address;
+  if (!ParseNumber(&cursor, end, 16, ' ', &end_address) ||
+      end_address <= start_address) {
     LOG(ERROR) << "format error";
     return ParseResult::kError;
   }
@@ -117,9 +162,7 @@ ParseResult ParseMapsLine(DelimitedFileReader* maps_file_reader,
   MemoryMap::Mapping mapping;
   mapping.range.SetRange(is_64_bit, start_address, end_address - start_address);
 
-  if (maps_file_reader->GetDelim(' ', &field) !=
-          DelimitedFileReader::Result::kSuccess ||
-      (field.pop_back(), field.size() != 4)) {
+  if (end - cursor < 5 || cursor[4] != ' ') {
     LOG(ERROR) << "format error";
     return ParseResult::kError;
   }
@@ -134,54 +177,45 @@ ParseResult ParseMapsLine(DelimitedFileReader* maps_file_reader,
       return ParseResult::kError;                            \
     }                                                        \
   } while (false)
-  SET_FIELD(field[0], &mapping.readable, "r", "-");
-  SET_FIELD(field[1], &mapping.writable, "w", "-");
-  SET_FIELD(field[2], &mapping.executable, "x", "-");
-  SET_FIELD(field[3], &mapping.shareable, "sS", "p");
+  SET_FIELD(cursor[0], &mapping.readable, "r", "-");
+  SET_FIELD(cursor[1], &mapping.writable, "w", "-");
+  SET_FIELD(cursor[2], &mapping.executable, "x", "-");
+  SET_FIELD(cursor[3], &mapping.shareable, "sS", "p");
 #undef SET_FIELD
+  cursor += 5;
 
-  if (maps_file_reader->GetDelim(' ', &field) !=
-          DelimitedFileReader::Result::kSuccess ||
-      (field.pop_back(), !HexStringToNumber(field, &mapping.offset))) {
+  if (!ParseNumber(&cursor, end, 16, ' ', &mapping.offset)) {
     LOG(ERROR) << "format error";
     return ParseResult::kError;
   }
 
-  int major, minor;
-  if (maps_file_reader->GetDelim(' ', &field) !=
-          DelimitedFileReader::Result::kSuccess ||
-      (field.pop_back(), field.size() != 5) ||
-      !HexStringToNumber(field.substr(0, 2), &major) ||
-      !HexStringToNumber(field.substr(3, 2), &minor)) {
+  unsigned int major, minor;
+  if (!ParseNumber(&cursor, end, 16, ':', &major) ||
+      !ParseNumber(&cursor, end, 16, ' ', &minor)) {
     LOG(ERROR) << "format error";
     return ParseResult::kError;
   }
   mapping.device = MKDEV(major, minor);
 
-  if (maps_file_reader->GetDelim(' ', &field) !=
-          DelimitedFileReader::Result::kSuccess ||
-      (field.pop_back(), !LocalStringToNumber(field, &mapping.inode))) {
+  if (!ParseNumber(&cursor, end, 10, ' ', &mapping.inode)) {
     LOG(ERROR) << "format error";
     return ParseResult::kError;
   }
 
-  if (maps_file_reader->GetDelim('\n', &field) !=
-      DelimitedFileReader::Result::kSuccess) {
+  const char* line_end =
+      static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+  if (!line_end) {
     LOG(ERROR) << "format error";
     return ParseResult::kError;
   }
-  if (field.back() != '\n') {
-    LOG(ERROR) << "format error";
-    return ParseResult::kError;
+
+  while (cursor < line_end && *cursor == ' ') {
+    ++cursor;
   }
-  field.pop_back();
+  mapping.name = base::StringPiece(cursor, line_end - cursor);
 
   mappings->push_back(mapping);
-
-  size_t path_start = field.find_first_not_of(' ');
-  if (path_start != std::string::npos) {
-    mappings->back().name = field.substr(path_start);
-  }
+  *position = line_end + 1;
   return ParseResult::kSuccess;
 }
 
@@ -198,7 +232,8 @@ MemoryMap::Mapping::Mapping()
       executable(false),
       shareable(false) {}
 
-MemoryMap::MemoryMap() : mappings_(), initialized_() {}
+MemoryMap::MemoryMap()
+    : mappings_(), names_(), name_index_(), initialized_() {}
 
 MemoryMap::~MemoryMap() {}
 
@@ -212,34 +247,51 @@ bool MemoryMap::Mapping::Equals(const Mapping& other) const {
          shareable == other.shareable;
 }
 
+size_t MemoryMap::NameHash::operator()(const base::StringPiece& name) const {
+  // FNV-1a.
+  uint64_t hash = UINT64_C(0xcbf29ce484222325);
+  for (size_t index = 0; index < name.size(); ++index) {
+    hash = (hash ^ static_cast<unsigned char>(name[index])) *
+           UINT64_C(0x100000001b3);
+  }
+  return static_cast<size_t>(hash);
+}
+
 bool MemoryMap::Initialize(pid_t pid) {
   INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
 
   // If the maps file is not read atomically, entries can be read multiple times
-  // or missed entirely. The kernel reads entries from this file into a page
-  // sized buffer, so maps files larger than a page require multiple reads.
-  // Attempt to reduce the time between reads by reading the entire file into a
-  // StringFile before attempting to parse it. If ParseMapsLine detects
-  // duplicate, overlapping, or out-of-order entries, it will trigger restarting
-  // the read up to |attempts| times.
+  // or missed entirely. ReadMapsFile() keeps the number of reads small, but
+  // can’t make them atomic. If ParseMapsLine detects duplicate, overlapping,
+  // or out-of-order entries, it will trigger restarting the read up to
+  // |attempts| times.
+  //
+  // Lines are parsed in place, without copying fields out of the file
+  // contents. Names are only copied once parsing succeeds, by InternNames().
+  char path[32];
+  snprintf(path, sizeof(path), "/proc/%d/maps", pid);
+
+  std::string contents;
   int attempts = 3;
   do {
-    std::string contents;
-    char path[32];
-    snprintf(path, sizeof(path), "/proc/%d/maps", pid);
-    if (!LoggingReadEntireFile(base::FilePath(path), &contents)) {
+    if (!ReadMapsFile(base::FilePath(path), &contents)) {
       return false;
     }
 
-    StringFile maps_file;
-    maps_file.SetString(contents);
-    DelimitedFileReader maps_file_reader(&maps_file);
+    // Most lines are near 100 bytes, so this avoids most regrowth of
+    // mappings_ without measuring the file first.
+    mappings_.clear();
+    mappings_.reserve(contents.size() / 64);
 
+    const char* position = contents.data();
+    const char* const end = contents.data() + contents.size();
     ParseResult result;
-    while ((result = ParseMapsLine(&maps_file_reader, &mappings_)) ==
+    while ((result = ParseMapsLine(&position, end, &mappings_)) ==
            ParseResult::kSuccess) {
     }
     if (result == ParseResult::kEndOfFile) {
+      mappings_.shrink_to_fit();
+      InternNames();
       INITIALIZATION_STATE_SET_VALID(initialized_);
       return true;
     }
@@ -254,13 +306,52 @@ bool MemoryMap::Initialize(pid_t pid) {
   return false;
 }
 
+void MemoryMap::InternNames() {
+  // The names still refer to the maps file contents. Find the distinct names
+  // and their total size, so that names_ is allocated exactly once and never
+  // moves after names begin referring to it.
+  size_t names_size = 0;
+  for (size_t index = 0; index < mappings_.size(); ++index) {
+    const base::StringPiece& name = mappings_[index].name;
+    if (!name.empty() && name_index_.insert(std::make_pair(name, index))
+                             .second) {
+      names_size += name.size();
+    }
+  }
+
+  names_.reserve(names_size);
+  std::unordered_map<base::StringPiece, size_t, NameHash> name_index;
+  name_index.reserve(name_index_.size());
+  for (const auto& entry : name_index_) {
+    base::StringPiece interned(names_.data() + names_.size(),
+                               entry.first.size());
+    names_.append(entry.first.data(), entry.first.size());
+    name_index.insert(std::make_pair(interned, entry.second));
+  }
+  DCHECK_EQ(names_.size(), names_size);
+
+  for (Mapping& mapping : mappings_) {
+    if (!mapping.name.empty()) {
+      mapping.name = name_index.find(mapping.name)->first;
+    }
+  }
+  name_index_.swap(name_index);
+}
+
 const MemoryMap::Mapping* MemoryMap::FindMapping(LinuxVMAddress address) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  for (const auto& mapping : mappings_) {
-    if (mapping.range.Base() <= address && mapping.range.End() > address) {
-      return &mapping;
-    }
+  // Find the first mapping that ends after |address|. Since mappings are
+  // sorted and don’t overlap, it’s the only one that can contain it.
+  auto it = std::upper_bound(
+      mappings_.begin(),
+      mappings_.end(),
+      address,
+      [](LinuxVMAddress address, const Mapping& mapping) {
+        return address < mapping.range.End();
+      });
+  if (it != mappings_.end() && it->range.Base() <= address) {
+    return &*it;
   }
   return nullptr;
 }
@@ -269,28 +360,26 @@ const MemoryMap::Mapping* MemoryMap::FindMappingWithName(
     const std::string& name) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  for (const auto& mapping : mappings_) {
-    if (mapping.name == name) {
-      return &mapping;
-    }
-  }
-  return nullptr;
+  auto it = name_index_.find(base::StringPiece(name));
+  return it != name_index_.end() ? &mappings_[it->second] : nullptr;
 }
 
 const MemoryMap::Mapping* MemoryMap::FindFileMmapStart(
     const Mapping& mapping) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  size_t index = 0;
-  for (; index < mappings_.size(); ++index) {
-    if (mappings_[index].Equals(mapping)) {
-      break;
-    }
-  }
-  if (index >= mappings_.size()) {
+  auto it = std::lower_bound(
+      mappings_.begin(),
+      mappings_.end(),
+      mapping.range.Base(),
+      [](const Mapping& candidate, LinuxVMAddress base) {
+        return candidate.range.Base() < base;
+      });
+  if (it == mappings_.end() || !it->Equals(mapping)) {
     LOG(ERROR) << "mapping not found";
     return nullptr;
   }
+  size_t index = it - mappings_.begin();
 
   // If the mapping is anonymous, as is for the VDSO, there is no mapped file to
   // find the start of, so just return the input mapping.
@@ -313,4 +402,9 @@ const MemoryMap::Mapping* MemoryMap::FindFileMmapStart(
   return nullptr;
 }
 
+const std::vector<MemoryMap::Mapping>& MemoryMap::Mappings() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return mappings_;
+}
+
 }  // namespace crashpad
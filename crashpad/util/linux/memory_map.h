@@ -15,11 +15,15 @@
 #ifndef CRASHPAD_UTIL_LINUX_MEMORY_MAP_H_
 #define CRASHPAD_UTIL_LINUX_MEMORY_MAP_H_
 
+#include <stddef.h>
 #include <sys/types.h>
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
 #include "util/linux/address_types.h"
 #include "util/linux/checked_linux_address_range.h"
 #include "util/misc/initialization_state_dcheck.h"
@@ -39,7 +43,12 @@ class MemoryMap {
     Mapping();
     bool Equals(const Mapping& other) const;
 
-    std::string name;
+    //! \brief The name of the mapping, usually the path of the mapped file.
+    //!
+    //! Names are interned: every Mapping with the same name refers to the same
+    //! storage, which is owned by the MemoryMap that the Mapping was obtained
+    //! from.
+    base::StringPiece name;
     CheckedLinuxAddressRange range;
     off_t offset;
     dev_t device;
@@ -90,9 +99,32 @@ class MemoryMap {
   //!     message logged.
   const Mapping* FindFileMmapStart(const Mapping& mapping) const;
 
+  //! \return Every Mapping, sorted by base address, with no overlaps. The
+  //!     mappings are scoped to the lifetime of the MemoryMap object that they
+  //!     were obtained from.
+  const std::vector<Mapping>& Mappings() const;
+
  private:
+  struct NameHash {
+    size_t operator()(const base::StringPiece& name) const;
+  };
+
+  // Interns every name in mappings_ into names_, and indexes each name by the
+  // first mapping that uses it.
+  void InternNames();
+
+  // Sorted by base address, with no overlaps.
   std::vector<Mapping> mappings_;
+
+  // The interned names, referenced by mappings_ and name_index_.
+  std::string names_;
+
+  // Maps names to indices into mappings_.
+  std::unordered_map<base::StringPiece, size_t, NameHash> name_index_;
+
   InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryMap);
 };
 
 }  // namespace crashpad
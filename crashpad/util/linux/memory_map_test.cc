@@ -156,13 +156,13 @@ class MapChildTest : public Multiprocess {
     EXPECT_TRUE(mapping->writable);
     EXPECT_FALSE(mapping->executable);
     EXPECT_FALSE(mapping->shareable);
-    EXPECT_EQ(mapping->name, mapped_file_name);
+    EXPECT_EQ(mapping->name.as_string(), mapped_file_name);
     struct stat file_stat;
     ASSERT_EQ(stat(mapped_file_name.c_str(), &file_stat), 0)
         << ErrnoMessage("stat");
     EXPECT_EQ(mapping->device, file_stat.st_dev);
     EXPECT_EQ(mapping->inode, file_stat.st_ino);
-    EXPECT_EQ(map.FindMappingWithName(mapping->name), mapping);
+    EXPECT_EQ(map.FindMappingWithName(mapping->name.as_string()), mapping);
   }
 
   void MultiprocessChild() override {
@@ -408,6 +408,13 @@ TEST(MemoryMap, FindFileMmapStart) {
     EXPECT_EQ(map.FindFileMmapStart(*mapping2), mapping1);
     EXPECT_EQ(map.FindFileMmapStart(*mapping3), mapping1);
 
+    // Mappings of the same file share a single interned name, which is found
+    // at the lowest mapping.
+    EXPECT_EQ(mapping1->name.as_string(), path.value());
+    EXPECT_EQ(mapping1->name.data(), mapping2->name.data());
+    EXPECT_EQ(mapping1->name.data(), mapping3->name.data());
+    EXPECT_EQ(map.FindMappingWithName(path.value()), mapping1);
+
 #if defined(ARCH_CPU_64_BITS)
     constexpr bool is_64_bit = true;
 #else
@@ -0,0 +1,169 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/module_file_memory.h"
+
+#include <fcntl.h>
+#include <linux/kdev_t.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <algorithm>
+
+#include "base/files/scoped_file.h"
+#include "base/posix/eintr_wrapper.h"
+#include "util/numeric/safe_assignment.h"
+
+namespace crashpad {
+
+ModuleFileMemory::ModuleFileMemory() : file_(), segments_(), initialized_() {}
+
+ModuleFileMemory::~ModuleFileMemory() {}
+
+bool ModuleFileMemory::Initialize(const MemoryMap& memory_map,
+                                  const MemoryMap::Mapping& start) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  // Only a file mapped by its path can be found again on disk. Anything else,
+  // such as the VDSO, has to be read from the target.
+  if (start.offset != 0 || start.inode == 0 || start.name.empty() ||
+      start.name[0] != '/') {
+    return false;
+  }
+
+  base::ScopedFD file(HANDLE_EINTR(
+      open(start.name.as_string().c_str(), O_RDONLY | O_NOCTTY | O_CLOEXEC)));
+  if (!file.is_valid()) {
+    return false;
+  }
+
+  // MemoryMap reports devices in the kernel’s encoding, which differs from
+  // the C library’s.
+  struct stat st;
+  if (fstat(file.get(), &st) != 0 ||
+      static_cast<dev_t>(MKDEV(major(st.st_dev), minor(st.st_dev))) !=
+          start.device ||
+      st.st_ino != start.inode) {
+    return false;
+  }
+
+  if (!file_.Open(file.get())) {
+    return false;
+  }
+
+  const std::vector<MemoryMap::Mapping>& mappings = memory_map.Mappings();
+  for (auto it = std::lower_bound(
+           mappings.begin(),
+           mappings.end(),
+           start.range.Base(),
+           [](const MemoryMap::Mapping& mapping, LinuxVMAddress base) {
+             return mapping.range.Base() < base;
+           });
+       it != mappings.end();
+       ++it) {
+    const MemoryMap::Mapping& mapping = *it;
+    if (mapping.device != start.device || mapping.inode != start.inode) {
+      // Anonymous mappings, such as for .bss, may be interleaved with the
+      // module’s own, but another file marks the end of the module.
+      if (mapping.inode == 0) {
+        continue;
+      }
+      break;
+    }
+
+    // The same file mapped again from its start is a different module.
+    if (mapping.offset == 0 && mapping.range.Base() != start.range.Base()) {
+      break;
+    }
+
+    size_t offset;
+    if (!mapping.readable || mapping.writable ||
+        !AssignIfInRange(&offset, mapping.offset) || offset >= file_.size()) {
+      continue;
+    }
+
+    // A mapping’s last page may extend past the end of the file.
+    const size_t size = static_cast<size_t>(std::min(
+        mapping.range.Size(), static_cast<LinuxVMSize>(file_.size() - offset)));
+
+    if (!segments_.empty()) {
+      Segment& previous = segments_.back();
+      if (previous.address + previous.size == mapping.range.Base() &&
+          previous.offset + previous.size == offset) {
+        previous.size += size;
+        continue;
+      }
+    }
+    segments_.push_back({mapping.range.Base(), size, offset});
+  }
+
+  if (segments_.empty()) {
+    return false;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+bool ModuleFileMemory::Read(LinuxVMAddress address,
+                            size_t size,
+                            void* buffer) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  size_t available;
+  const char* data = Find(address, &available);
+  if (!data || size > available) {
+    return false;
+  }
+
+  memcpy(buffer, data, size);
+  return true;
+}
+
+bool ModuleFileMemory::ReadCStringSizeLimited(LinuxVMAddress address,
+                                              size_t size,
+                                              std::string* string) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  size_t available;
+  const char* data = Find(address, &available);
+  if (!data) {
+    return false;
+  }
+
+  const void* nul = memchr(data, '\0', std::min(size, available));
+  if (!nul) {
+    return false;
+  }
+
+  string->assign(data, static_cast<const char*>(nul) - data);
+  return true;
+}
+
+const char* ModuleFileMemory::Find(LinuxVMAddress address,
+                                   size_t* available) const {
+  for (const Segment& segment : segments_) {
+    if (address >= segment.address &&
+        address - segment.address < segment.size) {
+      const size_t delta = static_cast<size_t>(address - segment.address);
+      *available = segment.size - delta;
+      return static_cast<const char*>(
+          file_.DataAt(segment.offset + delta, *available));
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,112 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_MODULE_FILE_MEMORY_H_
+#define CRASHPAD_UTIL_LINUX_MODULE_FILE_MEMORY_H_
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "util/file/mapped_file_reader.h"
+#include "util/linux/address_types.h"
+#include "util/linux/memory_map.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+
+//! \brief Serves reads of a module’s read-only mappings from the module’s file
+//!     on disk.
+//!
+//! Reading a target’s memory requires ptrace access and a system call per
+//! read. A module’s read-only, file-backed mappings usually hold exactly the
+//! bytes at the corresponding offsets in the file, which can instead be mapped
+//! into this process, where they are shared with every other user of the file
+//! through the page cache.
+//!
+//! The file is only used if its device and inode match the target’s mapping,
+//! so a file replaced on disk after it was loaded is never consulted. The
+//! contents of a private mapping may still have been modified in the target,
+//! by relocation or otherwise, so callers must only use this for data that is
+//! not expected to change after loading, such as headers, notes, and symbol
+//! tables.
+class ModuleFileMemory {
+ public:
+  ModuleFileMemory();
+  ~ModuleFileMemory();
+
+  //! \brief Initializes this object with the module whose first mapping is \a
+  //!     start.
+  //!
+  //! \param[in] memory_map The target’s memory map.
+  //! \param[in] start The mapping of the module’s file at offset 0, as returned
+  //!     by MemoryMap::FindFileMmapStart().
+  //!
+  //! \return `true` on success. `false` if the module has no file on disk that
+  //!     matches its mapping, which is not an error and so is not logged.
+  bool Initialize(const MemoryMap& memory_map,
+                  const MemoryMap::Mapping& start);
+
+  //! \brief Copies memory from the module’s file.
+  //!
+  //! \param[in] address The address in the target of the memory to read.
+  //! \param[in] size The number of bytes to read.
+  //! \param[out] buffer A buffer of at least \a size bytes to receive the
+  //!     memory.
+  //!
+  //! \return `true` on success. `false`, without a message logged, if the
+  //!     memory does not lie entirely within the module’s read-only mappings,
+  //!     in which case it must be read from the target instead.
+  bool Read(LinuxVMAddress address, size_t size, void* buffer) const;
+
+  //! \brief Reads a `NUL`-terminated C string from the module’s file.
+  //!
+  //! \param[in] address The address in the target of the string.
+  //! \param[in] size The maximum number of bytes to read, including the `NUL`
+  //!     terminator.
+  //! \param[out] string The string read, not including the `NUL` terminator.
+  //!
+  //! \return `true` on success. `false`, without a message logged, if the
+  //!     string and its terminator do not lie entirely within one of the
+  //!     module’s read-only mappings and within \a size bytes.
+  bool ReadCStringSizeLimited(LinuxVMAddress address,
+                              size_t size,
+                              std::string* string) const;
+
+ private:
+  // A run of read-only mappings contiguous in both the target’s address space
+  // and the file.
+  struct Segment {
+    LinuxVMAddress address;
+    size_t size;
+    size_t offset;
+  };
+
+  // Returns the contents of the file at |address| in the target and sets
+  // |*available| to the number of bytes from there to the end of its segment,
+  // or returns nullptr if |address| is not in a segment.
+  const char* Find(LinuxVMAddress address, size_t* available) const;
+
+  MappedFileReader file_;
+  std::vector<Segment> segments_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(ModuleFileMemory);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_MODULE_FILE_MEMORY_H_
@@ -0,0 +1,95 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/module_file_memory.h"
+
+#include <elf.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "util/linux/memory_map.h"
+#include "util/misc/from_pointer_cast.h"
+#include "util/posix/scoped_mmap.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+const char kReadOnlyString[] = "module file memory";
+char g_writable_string[] = "writable";
+
+TEST(ModuleFileMemory, Self) {
+  MemoryMap map;
+  ASSERT_TRUE(map.Initialize(getpid()));
+
+  const auto string_address = FromPointerCast<LinuxVMAddress>(kReadOnlyString);
+  const MemoryMap::Mapping* mapping = map.FindMapping(string_address);
+  ASSERT_TRUE(mapping);
+  const MemoryMap::Mapping* start = map.FindFileMmapStart(*mapping);
+  ASSERT_TRUE(start);
+
+  ModuleFileMemory file;
+  ASSERT_TRUE(file.Initialize(map, *start));
+
+  // The ELF header reads the same from the file as from memory.
+  char header[EI_NIDENT];
+  ASSERT_TRUE(file.Read(start->range.Base(), sizeof(header), header));
+  EXPECT_EQ(memcmp(header,
+                   reinterpret_cast<const void*>(start->range.Base()),
+                   sizeof(header)),
+            0);
+
+  char string[sizeof(kReadOnlyString)];
+  ASSERT_TRUE(file.Read(string_address, sizeof(string), string));
+  EXPECT_STREQ(string, kReadOnlyString);
+
+  std::string cstring;
+  ASSERT_TRUE(file.ReadCStringSizeLimited(
+      string_address, sizeof(kReadOnlyString), &cstring));
+  EXPECT_EQ(cstring, kReadOnlyString);
+
+  // The terminator must lie within the size limit.
+  EXPECT_FALSE(file.ReadCStringSizeLimited(
+      string_address, sizeof(kReadOnlyString) - 1, &cstring));
+
+  // Writable memory is never served from the file.
+  EXPECT_FALSE(file.Read(FromPointerCast<LinuxVMAddress>(g_writable_string),
+                         sizeof(g_writable_string),
+                         string));
+}
+
+TEST(ModuleFileMemory, Anonymous) {
+  ScopedMmap mmapping;
+  ASSERT_TRUE(mmapping.ResetMmap(nullptr,
+                                 getpagesize(),
+                                 PROT_READ,
+                                 MAP_PRIVATE | MAP_ANON,
+                                 -1,
+                                 0));
+
+  MemoryMap map;
+  ASSERT_TRUE(map.Initialize(getpid()));
+  const MemoryMap::Mapping* mapping =
+      map.FindMapping(mmapping.addr_as<LinuxVMAddress>());
+  ASSERT_TRUE(mapping);
+
+  ModuleFileMemory file;
+  EXPECT_FALSE(file.Initialize(map, *mapping));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
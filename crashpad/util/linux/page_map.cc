@@ -0,0 +1,89 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/page_map.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace crashpad {
+
+namespace {
+
+// See Documentation/vm/pagemap.txt.
+constexpr uint64_t kPagePresent = UINT64_C(1) << 63;
+constexpr uint64_t kPageSwapped = UINT64_C(1) << 62;
+
+// The number of entries read at once.
+constexpr size_t kEntriesPerRead = 512;
+
+}  // namespace
+
+PageMap::PageMap() : pagemap_fd_(), page_size_(getpagesize()) {}
+
+PageMap::~PageMap() {}
+
+bool PageMap::Initialize(pid_t pid) {
+  char path[32];
+  snprintf(path, sizeof(path), "/proc/%d/pagemap", pid);
+  pagemap_fd_.reset(HANDLE_EINTR(open(path, O_RDONLY | O_NOCTTY | O_CLOEXEC)));
+  if (!pagemap_fd_.is_valid()) {
+    PLOG(WARNING) << "open";
+    return false;
+  }
+  return true;
+}
+
+bool PageMap::FirstTouchedPage(LinuxVMAddress start,
+                               LinuxVMAddress end,
+                               LinuxVMAddress* first_touched) const {
+  if (!pagemap_fd_.is_valid()) {
+    return false;
+  }
+
+  uint64_t entries[kEntriesPerRead];
+  LinuxVMAddress page = start - start % page_size_;
+  while (page < end) {
+    const size_t page_count = static_cast<size_t>(std::min<LinuxVMSize>(
+        kEntriesPerRead, (end - page + page_size_ - 1) / page_size_));
+    const off64_t offset = page / page_size_ * sizeof(entries[0]);
+    ssize_t bytes_read = HANDLE_EINTR(pread64(
+        pagemap_fd_.get(), entries, page_count * sizeof(entries[0]), offset));
+    if (bytes_read <= 0 || bytes_read % sizeof(entries[0]) != 0) {
+      PLOG_IF(WARNING, bytes_read < 0) << "pread64";
+      return false;
+    }
+
+    const size_t entries_read = bytes_read / sizeof(entries[0]);
+    for (size_t index = 0; index < entries_read; ++index) {
+      if (entries[index] & (kPagePresent | kPageSwapped)) {
+        *first_touched = std::max(start, page);
+        return true;
+      }
+      page += page_size_;
+    }
+  }
+
+  *first_touched = end;
+  return true;
+}
+
+}  // namespace crashpad
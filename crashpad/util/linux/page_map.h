@@ -0,0 +1,69 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_PAGE_MAP_H_
+#define CRASHPAD_UTIL_LINUX_PAGE_MAP_H_
+
+#include <sys/types.h>
+
+#include "base/files/scoped_file.h"
+#include "base/macros.h"
+#include "util/linux/address_types.h"
+
+namespace crashpad {
+
+//! \brief Reads the residency of a process’ pages from /proc/[pid]/pagemap.
+//!
+//! A page of private anonymous memory that has never been touched has no page
+//! table entry and is not in swap. Reading it yields zeroes, so it needn’t be
+//! read at all.
+class PageMap {
+ public:
+  PageMap();
+  ~PageMap();
+
+  //! \brief Initializes this object.
+  //!
+  //! \param[in] pid The process whose pages are to be examined.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  //!     Other methods fail if this hasn’t succeeded.
+  bool Initialize(pid_t pid);
+
+  //! \brief Finds the lowest page, within a range, that has been touched.
+  //!
+  //! A page has been touched if it is present in memory or in swap.
+  //!
+  //! \param[in] start The start of the range, which need not be page-aligned.
+  //! \param[in] end The end of the range.
+  //! \param[out] first_touched The greater of \a start and the base of the
+  //!     lowest page in the range that has been touched, or \a end if none
+  //!     has.
+  //!
+  //! \return `true` on success, `false` on failure, with a message logged if
+  //!     reading failed.
+  bool FirstTouchedPage(LinuxVMAddress start,
+                        LinuxVMAddress end,
+                        LinuxVMAddress* first_touched) const;
+
+ private:
+  base::ScopedFD pagemap_fd_;
+  LinuxVMSize page_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(PageMap);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_PAGE_MAP_H_
@@ -0,0 +1,81 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/page_map.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "test/errors.h"
+#include "util/misc/from_pointer_cast.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(PageMap, FirstTouchedPage) {
+  PageMap page_map;
+  ASSERT_TRUE(page_map.Initialize(getpid()));
+
+  const size_t page_size = getpagesize();
+  constexpr size_t kPageCount = 16;
+  void* mapping = mmap(nullptr,
+                       kPageCount * page_size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1,
+                       0);
+  ASSERT_NE(mapping, MAP_FAILED) << ErrnoMessage("mmap");
+  char* pages = static_cast<char*>(mapping);
+  const LinuxVMAddress base = FromPointerCast<LinuxVMAddress>(pages);
+  const LinuxVMAddress end = base + kPageCount * page_size;
+
+  // Nothing has been touched yet.
+  LinuxVMAddress first_touched;
+  ASSERT_TRUE(page_map.FirstTouchedPage(base, end, &first_touched));
+  EXPECT_EQ(first_touched, end);
+
+  pages[9 * page_size + 1] = 1;
+  pages[5 * page_size + 2] = 1;
+
+  ASSERT_TRUE(page_map.FirstTouchedPage(base, end, &first_touched));
+  EXPECT_EQ(first_touched, base + 5 * page_size);
+
+  // A start within a touched page is returned as is.
+  ASSERT_TRUE(page_map.FirstTouchedPage(
+      base + 5 * page_size + 8, end, &first_touched));
+  EXPECT_EQ(first_touched, base + 5 * page_size + 8);
+
+  ASSERT_TRUE(
+      page_map.FirstTouchedPage(base + 6 * page_size, end, &first_touched));
+  EXPECT_EQ(first_touched, base + 9 * page_size);
+
+  ASSERT_TRUE(page_map.FirstTouchedPage(
+      base + 10 * page_size, end, &first_touched));
+  EXPECT_EQ(first_touched, end);
+
+  EXPECT_EQ(munmap(mapping, kPageCount * page_size), 0)
+      << ErrnoMessage("munmap");
+}
+
+TEST(PageMap, NotInitialized) {
+  PageMap page_map;
+  LinuxVMAddress first_touched;
+  EXPECT_FALSE(page_map.FirstTouchedPage(0, 4096, &first_touched));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
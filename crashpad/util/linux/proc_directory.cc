@@ -0,0 +1,94 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/proc_directory.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace crashpad {
+
+namespace {
+
+// Large enough for the stat and status files in a single read.
+constexpr size_t kInitialBufferSize = 4096;
+
+}  // namespace
+
+ProcDirectory::ProcDirectory() : dir_(), pid_(-1), initialized_() {}
+
+ProcDirectory::~ProcDirectory() {}
+
+bool ProcDirectory::Initialize(pid_t pid) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  char path[32];
+  snprintf(path, sizeof(path), "/proc/%d", pid);
+  dir_.reset(HANDLE_EINTR(open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)));
+  if (!dir_.is_valid()) {
+    PLOG(ERROR) << "open " << path;
+    return false;
+  }
+  pid_ = pid;
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+bool ProcDirectory::ReadEntireFile(const char* relative_path,
+                                   std::string* contents) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  ScopedFileHandle handle(HANDLE_EINTR(openat(
+      dir_.get(), relative_path, O_RDONLY | O_NOCTTY | O_CLOEXEC)));
+  if (!handle.is_valid()) {
+    PLOG(ERROR) << "openat /proc/" << pid_ << "/" << relative_path;
+    return false;
+  }
+
+  contents->resize(std::max(contents->capacity(), kInitialBufferSize));
+  size_t size = 0;
+  while (true) {
+    if (size == contents->size()) {
+      contents->resize(size * 2);
+    }
+
+    FileOperationResult rv =
+        ReadFile(handle.get(), &(*contents)[size], contents->size() - size);
+    if (rv < 0) {
+      PLOG(ERROR) << "read /proc/" << pid_ << "/" << relative_path;
+      contents->clear();
+      return false;
+    }
+    if (rv == 0) {
+      break;
+    }
+    size += rv;
+  }
+
+  contents->resize(size);
+  return true;
+}
+
+pid_t ProcDirectory::ProcessID() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return pid_;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,72 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_PROC_DIRECTORY_H_
+#define CRASHPAD_UTIL_LINUX_PROC_DIRECTORY_H_
+
+#include <sys/types.h>
+
+#include <string>
+
+#include "base/macros.h"
+#include "util/file/file_io.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+
+//! \brief Reads files in a process’ /proc/[pid] directory.
+//!
+//! The directory is opened once, and each file is then opened relative to it,
+//! which avoids resolving the full path for every file. This matters for files
+//! read once per thread, such as task/[tid]/stat. It also ensures that every
+//! file is read from the same process, even if its process ID is reused.
+class ProcDirectory {
+ public:
+  ProcDirectory();
+  ~ProcDirectory();
+
+  //! \brief Initializes the reader.
+  //!
+  //! This method must be successfully called before calling any other.
+  //!
+  //! \param[in] pid The process ID whose directory to open.
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool Initialize(pid_t pid);
+
+  //! \brief Reads the contents of a file in the directory.
+  //!
+  //! Files in /proc report a size of 0, so the file is read until end-of-file.
+  //! The storage already held by \a contents is reused, so a caller that reads
+  //! many similar files into the same string need not allocate for each one.
+  //!
+  //! \param[in] relative_path The path of the file relative to /proc/[pid],
+  //!     such as `"status"` or `"task/123/stat"`.
+  //! \param[out] contents The file’s contents.
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool ReadEntireFile(const char* relative_path, std::string* contents) const;
+
+  //! \return The process ID whose directory was opened.
+  pid_t ProcessID() const;
+
+ private:
+  ScopedFileHandle dir_;
+  pid_t pid_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProcDirectory);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_PROC_DIRECTORY_H_
@@ -0,0 +1,75 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/proc_directory.h"
+
+#include <unistd.h>
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "gtest/gtest.h"
+#include "util/file/file_io.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(ProcDirectory, ReadEntireFile) {
+  ProcDirectory proc_dir;
+  ASSERT_TRUE(proc_dir.Initialize(getpid()));
+  EXPECT_EQ(proc_dir.ProcessID(), getpid());
+
+  // These files don’t change while the process runs.
+  for (const char* name : {"auxv", "cmdline"}) {
+    SCOPED_TRACE(name);
+
+    std::string expected;
+    ASSERT_TRUE(LoggingReadEntireFile(
+        base::FilePath("/proc/self").Append(name), &expected));
+
+    std::string contents;
+    ASSERT_TRUE(proc_dir.ReadEntireFile(name, &contents));
+    EXPECT_EQ(contents, expected);
+
+    // A buffer that already holds other data is reused.
+    contents.assign(8192, 'x');
+    ASSERT_TRUE(proc_dir.ReadEntireFile(name, &contents));
+    EXPECT_EQ(contents, expected);
+  }
+
+  std::string contents;
+  EXPECT_FALSE(proc_dir.ReadEntireFile("nonexistent", &contents));
+}
+
+TEST(ProcDirectory, LargeFile) {
+  ProcDirectory proc_dir;
+  ASSERT_TRUE(proc_dir.Initialize(getpid()));
+
+  // smaps describes every mapping in many lines, so it is larger than a single
+  // page for any realistic process.
+  std::string contents;
+  ASSERT_TRUE(proc_dir.ReadEntireFile("smaps", &contents));
+  EXPECT_GT(contents.size(), 4096u);
+  EXPECT_EQ(contents.back(), '\n');
+}
+
+TEST(ProcDirectory, NoProcess) {
+  ProcDirectory proc_dir;
+  EXPECT_FALSE(proc_dir.Initialize(-1));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
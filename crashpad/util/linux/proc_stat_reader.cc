@@ -60,10 +60,28 @@ ProcStatReader::~ProcStatReader() {}
 
 bool ProcStatReader::Initialize(pid_t tid) {
   INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
-  if (!ReadFile(tid)) {
+  if (!ReadFile(tid) || !FindThirdColumn()) {
     return false;
   }
 
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+bool ProcStatReader::Initialize(const ProcDirectory& proc_dir, pid_t tid) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  char path[32];
+  snprintf(path, arraysize(path), "task/%d/stat", tid);
+  if (!proc_dir.ReadEntireFile(path, &contents_) || !FindThirdColumn()) {
+    return false;
+  }
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+bool ProcStatReader::FindThirdColumn() {
   // The first column is process ID and the second column is the executable name
   // in parentheses. This class only cares about columns after the second, so
   // find the start of the third here and save it for later.
@@ -82,7 +100,21 @@ bool ProcStatReader::Initialize(pid_t tid) {
     return false;
   }
 
-  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+bool ProcStatReader::ParentProcessID(pid_t* parent_pid) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  const char* ppid_ptr;
+  if (!FindColumn(3, &ppid_ptr)) {
+    return false;
+  }
+
+  if (!AdvancePastNumber<pid_t>(&ppid_ptr, parent_pid)) {
+    LOG(ERROR) << "format error";
+    return false;
+  }
   return true;
 }
 
@@ -22,6 +22,7 @@
 #include <string>
 
 #include "base/macros.h"
+#include "util/linux/proc_directory.h"
 #include "util/misc/initialization_state_dcheck.h"
 
 namespace crashpad {
@@ -39,6 +40,24 @@ class ProcStatReader {
   //! \param[in] tid The thread ID to read the stat file for.
   bool Initialize(pid_t tid);
 
+  //! \brief Initializes the reader for a thread in a process whose /proc
+  //!     directory is already open.
+  //!
+  //! This is preferable to Initialize(pid_t) when reading the stat files of
+  //! many threads in the same process.
+  //!
+  //! \param[in] proc_dir The thread’s process’ /proc directory.
+  //! \param[in] tid The thread ID to read the stat file for.
+  bool Initialize(const ProcDirectory& proc_dir, pid_t tid);
+
+  //! \brief Determines the process ID of the parent of the thread’s process.
+  //!
+  //! \param[out] parent_pid The parent process ID.
+  //!
+  //! \return `true` on success, with \a parent_pid set. Otherwise, `false` with
+  //!     a message logged.
+  bool ParentProcessID(pid_t* parent_pid) const;
+
   //! \brief Determines the time the thread has spent executing in user mode.
   //!
   //! \param[out] user_time The time spent executing in user mode.
@@ -65,6 +84,7 @@ class ProcStatReader {
 
  private:
   bool ReadFile(pid_t tid);
+  bool FindThirdColumn();
   bool FindColumn(int index, const char** column) const;
   bool ReadTimeAtIndex(int index, timeval* time_val) const;
 
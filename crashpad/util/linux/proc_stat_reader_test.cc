@@ -46,6 +46,10 @@ TEST(ProcStatReader, Basic) {
   timeval system_time;
   ASSERT_TRUE(stat.SystemCPUTime(&system_time));
   EXPECT_LE(system_time.tv_sec, elapsed_sec);
+
+  pid_t parent_pid;
+  ASSERT_TRUE(stat.ParentProcessID(&parent_pid));
+  EXPECT_EQ(parent_pid, getppid());
 }
 
 pid_t gettid() {
@@ -90,6 +94,35 @@ TEST(ProcStatReader, Threads) {
       thread_time.tv_usec);
 }
 
+TEST(ProcStatReader, ProcDirectory) {
+  ProcDirectory proc_dir;
+  ASSERT_TRUE(proc_dir.Initialize(getpid()));
+
+  ProcStatReader dir_stat;
+  ASSERT_TRUE(dir_stat.Initialize(proc_dir, gettid()));
+  timeval dir_start_time;
+  ASSERT_TRUE(dir_stat.StartTime(&dir_start_time));
+
+  ProcStatReader stat;
+  ASSERT_TRUE(stat.Initialize(gettid()));
+  timeval start_time;
+  ASSERT_TRUE(stat.StartTime(&start_time));
+
+  // Both are derived from the same tick count, but the boot time is
+  // recomputed for each, so allow for a small difference.
+  timeval difference;
+  if (timercmp(&dir_start_time, &start_time, <)) {
+    timersub(&start_time, &dir_start_time, &difference);
+  } else {
+    timersub(&dir_start_time, &start_time, &difference);
+  }
+  EXPECT_EQ(difference.tv_sec, 0);
+
+  // A thread that isn’t in the process can’t be read.
+  ProcStatReader missing_stat;
+  EXPECT_FALSE(missing_stat.Initialize(proc_dir, -1));
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
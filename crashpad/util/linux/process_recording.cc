@@ -0,0 +1,284 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/process_recording.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include "base/logging.h"
+#include "util/file/file_io.h"
+#include "util/file/file_reader.h"
+#include "util/file/file_writer.h"
+
+namespace crashpad {
+
+namespace {
+
+// Anything larger in a saved file indicates corruption.
+constexpr uint64_t kMaxRegionSize = 1ull << 30;
+
+}  // namespace
+
+struct ProcessRecording::FileHeader {
+  static constexpr uint32_t kMagic = 'CPpr';
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  int32_t process_id;
+  uint32_t is_64_bit;
+
+  // Recordings are only usable by a build with the same ThreadInfo layout.
+  uint32_t thread_info_size;
+  uint32_t thread_count;
+  uint64_t region_count;
+};
+
+// Followed by FileHeader::thread_info_size bytes of ThreadInfo.
+struct ProcessRecording::FileThread {
+  int32_t thread_id;
+  uint32_t padding;
+};
+
+// Followed by size bytes of memory.
+struct ProcessRecording::FileRegion {
+  uint64_t address;
+  uint64_t size;
+};
+
+ProcessRecording::ProcessRecording()
+    : threads_(), regions_(), lock_(), pid_(-1), is_64_bit_(false) {}
+
+ProcessRecording::~ProcessRecording() {}
+
+void ProcessRecording::SetProcessID(pid_t pid) {
+  base::AutoLock lock(lock_);
+  pid_ = pid;
+}
+
+pid_t ProcessRecording::ProcessID() const {
+  base::AutoLock lock(lock_);
+  return pid_;
+}
+
+void ProcessRecording::SetIs64Bit(bool is_64_bit) {
+  base::AutoLock lock(lock_);
+  is_64_bit_ = is_64_bit;
+}
+
+bool ProcessRecording::Is64Bit() const {
+  base::AutoLock lock(lock_);
+  return is_64_bit_;
+}
+
+void ProcessRecording::AddThread(pid_t tid, const ThreadInfo& info) {
+  base::AutoLock lock(lock_);
+  threads_[tid] = info;
+}
+
+bool ProcessRecording::GetThread(pid_t tid, ThreadInfo* info) const {
+  base::AutoLock lock(lock_);
+  auto it = threads_.find(tid);
+  if (it == threads_.end()) {
+    return false;
+  }
+  *info = it->second;
+  return true;
+}
+
+void ProcessRecording::AddMemory(VMAddress address,
+                                 const void* data,
+                                 size_t size) {
+  if (size == 0) {
+    return;
+  }
+  const VMAddress end = address + size;
+  DCHECK_GT(end, address);
+
+  base::AutoLock lock(lock_);
+
+  // Find the regions that overlap or abut the new one, which are joined with
+  // it.
+  auto first = regions_.upper_bound(address);
+  if (first != regions_.begin()) {
+    auto previous = std::prev(first);
+    if (previous->first + previous->second.size() >= address) {
+      first = previous;
+    }
+  }
+  auto last = first;
+  VMAddress joined_end = end;
+  while (last != regions_.end() && last->first <= end) {
+    joined_end = std::max(joined_end,
+                          static_cast<VMAddress>(last->first +
+                                                 last->second.size()));
+    ++last;
+  }
+
+  // Memory is most often read in ascending order, so the region that the new
+  // one extends is grown in place where possible.
+  std::string joined;
+  VMAddress joined_address;
+  if (first != last && first->first <= address) {
+    joined_address = first->first;
+    joined.swap(first->second);
+    ++first;
+  } else {
+    joined_address = address;
+  }
+  joined.resize(joined_end - joined_address);
+  for (auto it = first; it != last; ++it) {
+    memcpy(&joined[it->first - joined_address],
+           it->second.data(),
+           it->second.size());
+  }
+  memcpy(&joined[address - joined_address], data, size);
+
+  if (first != regions_.begin() && std::prev(first)->first == joined_address) {
+    --first;
+  }
+  regions_.erase(first, last);
+  regions_[joined_address].swap(joined);
+}
+
+size_t ProcessRecording::ReadMemory(VMAddress address,
+                                    size_t size,
+                                    void* buffer) const {
+  base::AutoLock lock(lock_);
+
+  auto it = regions_.upper_bound(address);
+  if (it == regions_.begin()) {
+    return 0;
+  }
+  --it;
+  const VMAddress region_end = it->first + it->second.size();
+  if (address >= region_end) {
+    return 0;
+  }
+
+  const size_t copy_size =
+      static_cast<size_t>(std::min<VMAddress>(size, region_end - address));
+  memcpy(buffer, &it->second[address - it->first], copy_size);
+  return copy_size;
+}
+
+bool ProcessRecording::Load(const base::FilePath& path) {
+  ScopedFileHandle handle(LoggingOpenFileForRead(path));
+  if (!handle.is_valid()) {
+    return false;
+  }
+
+  WeakFileHandleFileReader reader(handle.get());
+  FileHeader header;
+  if (!reader.ReadExactly(&header, sizeof(header))) {
+    return false;
+  }
+  if (header.magic != FileHeader::kMagic ||
+      header.version != FileHeader::kVersion) {
+    LOG(ERROR) << "unexpected recording header in " << path.value();
+    return false;
+  }
+  if (header.thread_info_size != sizeof(ThreadInfo)) {
+    LOG(ERROR) << "recording " << path.value()
+               << " was made for another architecture";
+    return false;
+  }
+
+  std::map<pid_t, ThreadInfo> threads;
+  for (uint32_t index = 0; index < header.thread_count; ++index) {
+    FileThread file_thread;
+    ThreadInfo info;
+    if (!reader.ReadExactly(&file_thread, sizeof(file_thread)) ||
+        !reader.ReadExactly(&info, sizeof(info))) {
+      return false;
+    }
+    threads[file_thread.thread_id] = info;
+  }
+
+  std::map<VMAddress, std::string> regions;
+  for (uint64_t index = 0; index < header.region_count; ++index) {
+    FileRegion file_region;
+    if (!reader.ReadExactly(&file_region, sizeof(file_region))) {
+      return false;
+    }
+    if (file_region.size == 0 || file_region.size > kMaxRegionSize) {
+      LOG(ERROR) << "region size " << file_region.size
+                 << " out of range in " << path.value();
+      return false;
+    }
+
+    std::string& data = regions[file_region.address];
+    data.resize(static_cast<size_t>(file_region.size));
+    if (!reader.ReadExactly(&data[0], data.size())) {
+      return false;
+    }
+  }
+
+  base::AutoLock lock(lock_);
+  pid_ = header.process_id;
+  is_64_bit_ = header.is_64_bit != 0;
+  threads_.swap(threads);
+  regions_.swap(regions);
+  return true;
+}
+
+bool ProcessRecording::Save(const base::FilePath& path) const {
+  base::AutoLock lock(lock_);
+
+  FileWriter writer;
+  if (!writer.Open(path,
+                   FileWriteMode::kTruncateOrCreate,
+                   FilePermissions::kOwnerOnly)) {
+    return false;
+  }
+
+  FileHeader header;
+  header.magic = FileHeader::kMagic;
+  header.version = FileHeader::kVersion;
+  header.process_id = pid_;
+  header.is_64_bit = is_64_bit_;
+  header.thread_info_size = sizeof(ThreadInfo);
+  header.thread_count = static_cast<uint32_t>(threads_.size());
+  header.region_count = regions_.size();
+  if (!writer.Write(&header, sizeof(header))) {
+    return false;
+  }
+
+  for (const auto& thread : threads_) {
+    FileThread file_thread = {};
+    file_thread.thread_id = thread.first;
+    if (!writer.Write(&file_thread, sizeof(file_thread)) ||
+        !writer.Write(&thread.second, sizeof(thread.second))) {
+      return false;
+    }
+  }
+
+  for (const auto& region : regions_) {
+    FileRegion file_region;
+    file_region.address = region.first;
+    file_region.size = region.second.size();
+    if (!writer.Write(&file_region, sizeof(file_region)) ||
+        !writer.Write(region.second.data(), region.second.size())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace crashpad
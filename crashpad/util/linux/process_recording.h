@@ -0,0 +1,123 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef CRASHPAD_UTIL_LINUX_PROCESS_RECORDING_H_
+#define CRASHPAD_UTIL_LINUX_PROCESS_RECORDING_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "util/linux/thread_info.h"
+#include "util/misc/address_types.h"
+
+namespace crashpad {
+
+//! \brief The data that a capture read from a process, saved so that the
+//!     capture can be repeated without the process.
+//!
+//! A recording is made by a RecordingPtraceConnection, which records each
+//! thread’s ThreadInfo, and by a ProcessMemory given the recording with
+//! ProcessMemory::SetRecording(), which records each byte of memory read. It
+//! is replayed by a ReplayPtraceConnection and by a ProcessMemory initialized
+//! with ProcessMemory::InitializeFromRecording(), so that code reading a
+//! process can be profiled deterministically against a recorded target.
+//!
+//! Thread contexts are saved in this process’ native layout, so a recording
+//! can only be replayed on the architecture that made it.
+//!
+//! This class is thread-safe.
+class ProcessRecording {
+ public:
+  ProcessRecording();
+  ~ProcessRecording();
+
+  //! \brief Sets the process ID of the recorded process.
+  void SetProcessID(pid_t pid);
+
+  //! \brief Returns the process ID of the recorded process, or `-1` if none
+  //!     was recorded.
+  pid_t ProcessID() const;
+
+  //! \brief Sets whether the recorded process is 64-bit.
+  void SetIs64Bit(bool is_64_bit);
+
+  //! \brief Returns `true` if the recorded process is 64-bit.
+  bool Is64Bit() const;
+
+  //! \brief Records the information retrieved for a thread, replacing any
+  //!     recorded before.
+  void AddThread(pid_t tid, const ThreadInfo& info);
+
+  //! \brief Retrieves the information recorded for a thread.
+  //!
+  //! \return `true` on success. `false` if the thread was not recorded, with
+  //!     no message logged.
+  bool GetThread(pid_t tid, ThreadInfo* info) const;
+
+  //! \brief Records the contents of a region of the process’ memory.
+  //!
+  //! Where the region overlaps memory recorded before, \a data replaces it.
+  //!
+  //! \param[in] address The address of the region.
+  //! \param[in] data The contents of the region.
+  //! \param[in] size The size of the region.
+  void AddMemory(VMAddress address, const void* data, size_t size);
+
+  //! \brief Copies recorded memory.
+  //!
+  //! \param[in] address The address of the memory to copy.
+  //! \param[in] size The maximum number of bytes to copy.
+  //! \param[out] buffer The buffer, at least \a size bytes long, to copy the
+  //!     memory into.
+  //!
+  //! \return The number of bytes copied, those recorded contiguously from \a
+  //!     address. This is `0` if \a address was not recorded.
+  size_t ReadMemory(VMAddress address, size_t size, void* buffer) const;
+
+  //! \brief Replaces this object’s contents with a recording saved by Save().
+  //!
+  //! \return `true` on success. `false` on failure, with a message logged.
+  bool Load(const base::FilePath& path);
+
+  //! \brief Saves the recording to a file.
+  //!
+  //! \return `true` on success. `false` on failure, with a message logged.
+  bool Save(const base::FilePath& path) const;
+
+ private:
+  struct FileHeader;
+  struct FileThread;
+  struct FileRegion;
+
+  std::map<pid_t, ThreadInfo> threads_;
+
+  // Recorded memory, keyed by address. Regions never overlap or abut, because
+  // they’re joined as they’re added.
+  std::map<VMAddress, std::string> regions_;
+
+  mutable base::Lock lock_;
+  pid_t pid_;
+  bool is_64_bit_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProcessRecording);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_PROCESS_RECORDING_H_
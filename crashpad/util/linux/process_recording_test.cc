@@ -0,0 +1,159 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/process_recording.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "gtest/gtest.h"
+#include "test/linux/fake_ptrace_connection.h"
+#include "test/scoped_temp_dir.h"
+#include "util/linux/recording_ptrace_connection.h"
+#include "util/misc/from_pointer_cast.h"
+#include "util/process/process_memory.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+std::string ReadRecorded(const ProcessRecording& recording,
+                         VMAddress address,
+                         size_t size) {
+  std::string data(size, '\0');
+  data.resize(recording.ReadMemory(address, size, &data[0]));
+  return data;
+}
+
+TEST(ProcessRecording, Memory) {
+  ProcessRecording recording;
+  EXPECT_EQ(ReadRecorded(recording, 0x1000, 4), "");
+
+  recording.AddMemory(0x1000, "abcd", 4);
+  recording.AddMemory(0x1008, "ijkl", 4);
+  EXPECT_EQ(ReadRecorded(recording, 0x1000, 8), "abcd");
+  EXPECT_EQ(ReadRecorded(recording, 0x1002, 1), "c");
+  EXPECT_EQ(ReadRecorded(recording, 0x1004, 4), "");
+  EXPECT_EQ(ReadRecorded(recording, 0x1009, 8), "jkl");
+  EXPECT_EQ(ReadRecorded(recording, 0x0fff, 4), "");
+
+  // Abutting regions are joined.
+  recording.AddMemory(0x1004, "efgh", 4);
+  EXPECT_EQ(ReadRecorded(recording, 0x1000, 16), "abcdefghijkl");
+
+  // New data replaces what it overlaps, and may extend a region at either end.
+  recording.AddMemory(0x0ffe, "yzA", 3);
+  recording.AddMemory(0x100a, "KLmn", 4);
+  EXPECT_EQ(ReadRecorded(recording, 0x0ffe, 32), "yzAbcdefghijKLmn");
+
+  // A region spanning several others replaces them all.
+  recording.AddMemory(0x0ff0, "0123456789abcdefghijklmnopqrstuvwxyz", 36);
+  recording.AddMemory(0x2000, "z", 1);
+  EXPECT_EQ(ReadRecorded(recording, 0x0ff0, 64),
+            "0123456789abcdefghijklmnopqrstuvwxyz");
+  EXPECT_EQ(ReadRecorded(recording, 0x2000, 64), "z");
+}
+
+TEST(ProcessRecording, Threads) {
+  FakePtraceConnection fake_connection;
+  ASSERT_TRUE(fake_connection.Initialize(getpid()));
+
+  ProcessRecording recording;
+  RecordingPtraceConnection connection(&fake_connection, &recording);
+  EXPECT_EQ(recording.ProcessID(), getpid());
+  EXPECT_EQ(recording.Is64Bit(), fake_connection.Is64Bit());
+
+  // The main thread was attached by Initialize().
+  const pid_t tid = getpid();
+  ThreadInfo info;
+  memset(&info, 0, sizeof(info));
+  info.thread_specific_data_address = 0x1234;
+  ASSERT_TRUE(connection.GetThreadInfo(tid, &info));
+
+  ReplayPtraceConnection replay(&recording);
+  EXPECT_EQ(replay.GetProcessID(), getpid());
+  EXPECT_EQ(replay.Is64Bit(), fake_connection.Is64Bit());
+  ASSERT_TRUE(replay.Attach(tid));
+  ThreadInfo replayed_info;
+  ASSERT_TRUE(replay.GetThreadInfo(tid, &replayed_info));
+  EXPECT_EQ(replayed_info.thread_specific_data_address, 0x1234u);
+
+  EXPECT_FALSE(replay.Attach(tid + 1));
+  EXPECT_FALSE(replay.GetThreadInfo(tid + 1, &replayed_info));
+}
+
+TEST(ProcessRecording, ProcessMemory) {
+  static constexpr char kString[] = "a recorded string";
+  std::vector<char> block(4096 * 3);
+  for (size_t index = 0; index < block.size(); ++index) {
+    block[index] = static_cast<char>(index * 7);
+  }
+  const VMAddress string_address = FromPointerCast<VMAddress>(kString);
+  const VMAddress block_address = FromPointerCast<VMAddress>(block.data());
+
+  ProcessRecording recording;
+  {
+    ProcessMemory memory;
+    ASSERT_TRUE(memory.Initialize(getpid()));
+    memory.SetRecording(&recording);
+
+    std::string string;
+    ASSERT_TRUE(memory.ReadCString(string_address, &string));
+    EXPECT_EQ(string, kString);
+
+    std::vector<char> first(100);
+    std::vector<char> second(block.size() - 200);
+    std::vector<ProcessMemory::ReadRequest> requests(2);
+    requests[0].address = block_address;
+    requests[0].size = first.size();
+    requests[0].buffer = first.data();
+    requests[1].address = block_address + 200;
+    requests[1].size = second.size();
+    requests[1].buffer = second.data();
+    ASSERT_TRUE(memory.ReadBatch(requests));
+  }
+
+  ScopedTempDir temp_dir;
+  const base::FilePath path =
+      temp_dir.path().Append(FILE_PATH_LITERAL("recording"));
+  ASSERT_TRUE(recording.Save(path));
+
+  ProcessRecording loaded;
+  ASSERT_TRUE(loaded.Load(path));
+
+  ProcessMemory memory;
+  memory.InitializeFromRecording(&loaded);
+
+  std::string string;
+  ASSERT_TRUE(memory.ReadCString(string_address, &string));
+  EXPECT_EQ(string, kString);
+
+  std::vector<char> data(100);
+  ASSERT_TRUE(memory.Read(block_address, data.size(), data.data()));
+  EXPECT_EQ(memcmp(data.data(), block.data(), data.size()), 0);
+  data.resize(block.size() - 200);
+  ASSERT_TRUE(memory.Read(block_address + 200, data.size(), data.data()));
+  EXPECT_EQ(memcmp(data.data(), &block[200], data.size()), 0);
+
+  // The gap between the two reads was never recorded.
+  EXPECT_FALSE(memory.Read(block_address + 100, 100, data.data()));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
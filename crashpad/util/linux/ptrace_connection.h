@@ -17,6 +17,8 @@
 
 #include <sys/types.h>
 
+#include <vector>
+
 #include "util/linux/thread_info.h"
 
 namespace crashpad {
@@ -25,6 +27,24 @@ namespace crashpad {
 //!     and its threads.
 class PtraceConnection {
  public:
+  //! \brief A thread to be attached and read by AttachAndGetThreadInfo().
+  struct ThreadRequest {
+    //! \brief The thread ID of the thread to attach.
+    pid_t tid;
+
+    //! \brief Information about the thread, valid if #success is `true`.
+    ThreadInfo info;
+
+    //! \brief Whether ThreadInfo::float_context is to be retrieved.
+    //!
+    //! Reading a thread’s floating-point context costs an additional `ptrace`
+    //! request. If this is `false`, an implementation may leave it zeroed.
+    bool float_context;
+
+    //! \brief Whether the thread was attached and its information retrieved.
+    bool success;
+  };
+
   virtual ~PtraceConnection() {}
 
   //! \brief Returns the process ID of the connected process.
@@ -45,6 +65,18 @@ class PtraceConnection {
   //! \param[out] info Information about the thread.
   //! \return `true` on success. `false` on failure with a message logged.
   virtual bool GetThreadInfo(pid_t tid, ThreadInfo* info) = 0;
+
+  //! \brief Attaches to several threads and retrieves a ThreadInfo for each.
+  //!
+  //! The default implementation calls Attach() and GetThreadInfo() for each
+  //! thread in turn, and so retrieves every thread’s floating-point context.
+  //! Implementations able to trace from several threads may service the
+  //! requests concurrently.
+  //!
+  //! \param[in,out] requests The threads to attach. On return, the `info` and
+  //!     `success` fields of each element are set. A message is logged for
+  //!     each request that fails.
+  virtual void AttachAndGetThreadInfo(std::vector<ThreadRequest>* requests);
 };
 
 }  // namespace crashpad
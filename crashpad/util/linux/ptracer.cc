@@ -329,17 +329,27 @@ bool Ptracer::Is64Bit() {
 }
 
 bool Ptracer::GetThreadInfo(pid_t tid, ThreadInfo* info) {
+  return GetThreadInfo(tid, true, info);
+}
+
+bool Ptracer::GetThreadInfo(pid_t tid, bool float_context, ThreadInfo* info) {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
+  if (!float_context) {
+    memset(&info->float_context, 0, sizeof(info->float_context));
+  }
+
   if (is_64_bit_) {
     return GetGeneralPurposeRegisters64(tid, &info->thread_context) &&
-           GetFloatingPointRegisters64(tid, &info->float_context) &&
+           (!float_context ||
+            GetFloatingPointRegisters64(tid, &info->float_context)) &&
            GetThreadArea64(
                tid, info->thread_context, &info->thread_specific_data_address);
   }
 
   return GetGeneralPurposeRegisters32(tid, &info->thread_context) &&
-         GetFloatingPointRegisters32(tid, &info->float_context) &&
+         (!float_context ||
+          GetFloatingPointRegisters32(tid, &info->float_context)) &&
          GetThreadArea32(
              tid, info->thread_context, &info->thread_specific_data_address);
 }
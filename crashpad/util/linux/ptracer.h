@@ -66,6 +66,19 @@ class Ptracer {
   //! \return `true` on success. `false` on failure with a message logged.
   bool GetThreadInfo(pid_t tid, ThreadInfo* info);
 
+  //! \brief Uses `ptrace` to collect information about the thread with thread
+  //!     ID \a tid, optionally leaving out its floating-point context.
+  //!
+  //! This behaves identically to GetThreadInfo(pid_t, ThreadInfo*) when \a
+  //! float_context is `true`.
+  //!
+  //! \param[in] tid The thread ID of the thread to collect information for.
+  //! \param[in] float_context Whether to collect ThreadInfo::float_context.
+  //!     If `false`, it is zeroed, saving a `ptrace` request.
+  //! \param[out] info A ThreadInfo for the thread.
+  //! \return `true` on success. `false` on failure with a message logged.
+  bool GetThreadInfo(pid_t tid, bool float_context, ThreadInfo* info);
+
  private:
   bool is_64_bit_;
   InitializationStateDcheck initialized_;
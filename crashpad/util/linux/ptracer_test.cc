@@ -14,6 +14,8 @@
 
 #include "util/linux/ptracer.h"
 
+#include <string.h>
+
 #include "build/build_config.h"
 #include "gtest/gtest.h"
 #include "test/multiprocess.h"
@@ -57,6 +59,22 @@ class SameBitnessTest : public Multiprocess {
 #endif  // ARCH_CPU_X86_64
 
     EXPECT_EQ(thread_info.thread_specific_data_address, expected_tls);
+
+    // Without its floating-point context, the rest of the thread’s
+    // information is still collected.
+    ThreadInfo integer_thread_info;
+    memset(&integer_thread_info.float_context,
+           0xff,
+           sizeof(integer_thread_info.float_context));
+    ASSERT_TRUE(ptracer.GetThreadInfo(ChildPID(), false, &integer_thread_info));
+    EXPECT_EQ(integer_thread_info.thread_specific_data_address, expected_tls);
+
+    FloatContext zero_float_context;
+    memset(&zero_float_context, 0, sizeof(zero_float_context));
+    EXPECT_EQ(memcmp(&integer_thread_info.float_context,
+                     &zero_float_context,
+                     sizeof(zero_float_context)),
+              0);
   }
 
   void MultiprocessChild() override {
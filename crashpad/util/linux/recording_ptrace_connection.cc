@@ -0,0 +1,92 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/recording_ptrace_connection.h"
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+RecordingPtraceConnection::RecordingPtraceConnection(
+    PtraceConnection* connection,
+    ProcessRecording* recording)
+    : PtraceConnection(), connection_(connection), recording_(recording) {
+  recording_->SetProcessID(connection_->GetProcessID());
+  recording_->SetIs64Bit(connection_->Is64Bit());
+}
+
+RecordingPtraceConnection::~RecordingPtraceConnection() {}
+
+pid_t RecordingPtraceConnection::GetProcessID() {
+  return connection_->GetProcessID();
+}
+
+bool RecordingPtraceConnection::Attach(pid_t tid) {
+  return connection_->Attach(tid);
+}
+
+bool RecordingPtraceConnection::Is64Bit() {
+  return connection_->Is64Bit();
+}
+
+bool RecordingPtraceConnection::GetThreadInfo(pid_t tid, ThreadInfo* info) {
+  if (!connection_->GetThreadInfo(tid, info)) {
+    return false;
+  }
+  recording_->AddThread(tid, *info);
+  return true;
+}
+
+void RecordingPtraceConnection::AttachAndGetThreadInfo(
+    std::vector<ThreadRequest>* requests) {
+  connection_->AttachAndGetThreadInfo(requests);
+  for (const ThreadRequest& request : *requests) {
+    if (request.success) {
+      recording_->AddThread(request.tid, request.info);
+    }
+  }
+}
+
+ReplayPtraceConnection::ReplayPtraceConnection(
+    const ProcessRecording* recording)
+    : PtraceConnection(), recording_(recording) {}
+
+ReplayPtraceConnection::~ReplayPtraceConnection() {}
+
+pid_t ReplayPtraceConnection::GetProcessID() {
+  return recording_->ProcessID();
+}
+
+bool ReplayPtraceConnection::Attach(pid_t tid) {
+  ThreadInfo info;
+  if (!recording_->GetThread(tid, &info)) {
+    LOG(ERROR) << "thread " << tid << " not recorded";
+    return false;
+  }
+  return true;
+}
+
+bool ReplayPtraceConnection::Is64Bit() {
+  return recording_->Is64Bit();
+}
+
+bool ReplayPtraceConnection::GetThreadInfo(pid_t tid, ThreadInfo* info) {
+  if (!recording_->GetThread(tid, info)) {
+    LOG(ERROR) << "thread " << tid << " not recorded";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,78 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_RECORDING_PTRACE_CONNECTION_H_
+#define CRASHPAD_UTIL_LINUX_RECORDING_PTRACE_CONNECTION_H_
+
+#include <sys/types.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "util/linux/process_recording.h"
+#include "util/linux/ptrace_connection.h"
+
+namespace crashpad {
+
+//! \brief A PtraceConnection that forwards requests to another connection,
+//!     recording the process and thread information retrieved.
+class RecordingPtraceConnection : public PtraceConnection {
+ public:
+  //! \param[in] connection The connection to forward requests to.
+  //! \param[in] recording The recording to add retrieved information to.
+  RecordingPtraceConnection(PtraceConnection* connection,
+                            ProcessRecording* recording);
+  ~RecordingPtraceConnection();
+
+  // PtraceConnection:
+
+  pid_t GetProcessID() override;
+  bool Attach(pid_t tid) override;
+  bool Is64Bit() override;
+  bool GetThreadInfo(pid_t tid, ThreadInfo* info) override;
+  void AttachAndGetThreadInfo(std::vector<ThreadRequest>* requests) override;
+
+ private:
+  PtraceConnection* connection_;  // weak
+  ProcessRecording* recording_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingPtraceConnection);
+};
+
+//! \brief A PtraceConnection that answers requests from a ProcessRecording
+//!     made by a RecordingPtraceConnection.
+//!
+//! Only threads present in the recording may be attached.
+class ReplayPtraceConnection : public PtraceConnection {
+ public:
+  //! \param[in] recording The recording to answer requests from.
+  explicit ReplayPtraceConnection(const ProcessRecording* recording);
+  ~ReplayPtraceConnection();
+
+  // PtraceConnection:
+
+  pid_t GetProcessID() override;
+  bool Attach(pid_t tid) override;
+  bool Is64Bit() override;
+  bool GetThreadInfo(pid_t tid, ThreadInfo* info) override;
+
+ private:
+  const ProcessRecording* recording_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ReplayPtraceConnection);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_RECORDING_PTRACE_CONNECTION_H_
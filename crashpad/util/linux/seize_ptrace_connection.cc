@@ -0,0 +1,155 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/seize_ptrace_connection.h"
+
+#include <stdint.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace crashpad {
+
+SeizePtraceConnection::SeizePtraceConnection()
+    : PtraceConnection(),
+      attachments_(),
+      pid_(-1),
+      ptracer_(),
+      initialized_() {}
+
+SeizePtraceConnection::~SeizePtraceConnection() {
+  DetachAll();
+}
+
+bool SeizePtraceConnection::Initialize(pid_t pid) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  if (!Attach(pid) || !ptracer_.Initialize(pid)) {
+    return false;
+  }
+  pid_ = pid;
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+pid_t SeizePtraceConnection::GetProcessID() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return pid_;
+}
+
+bool SeizePtraceConnection::Attach(pid_t tid) {
+  return Seize(tid) && WaitForStop(attachments_.size() - 1);
+}
+
+bool SeizePtraceConnection::Is64Bit() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return ptracer_.Is64Bit();
+}
+
+bool SeizePtraceConnection::GetThreadInfo(pid_t tid, ThreadInfo* info) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return ptracer_.GetThreadInfo(tid, info);
+}
+
+void SeizePtraceConnection::AttachAndGetThreadInfo(
+    std::vector<ThreadRequest>* requests) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  // Interrupt every thread before waiting for any of them, so that they all
+  // stop at nearly the same time. Each thread’s index in attachments_ is kept
+  // in its request’s position until it has stopped.
+  std::vector<size_t> attachment_indices(requests->size());
+  for (size_t index = 0; index < requests->size(); ++index) {
+    ThreadRequest& request = (*requests)[index];
+    request.success = Seize(request.tid);
+    attachment_indices[index] = attachments_.size() - 1;
+  }
+
+  for (size_t index = 0; index < requests->size(); ++index) {
+    ThreadRequest& request = (*requests)[index];
+    if (request.success) {
+      request.success = WaitForStop(attachment_indices[index]);
+    }
+  }
+
+  for (ThreadRequest& request : *requests) {
+    if (request.success) {
+      request.success = ptracer_.GetThreadInfo(
+          request.tid, request.float_context, &request.info);
+    }
+  }
+}
+
+bool SeizePtraceConnection::Seize(pid_t tid) {
+  if (ptrace(PTRACE_SEIZE, tid, nullptr, nullptr) != 0) {
+    PLOG(ERROR) << "ptrace";
+    return false;
+  }
+
+  Attachment attachment;
+  attachment.tid = tid;
+  attachment.pending_signal = 0;
+  attachments_.push_back(attachment);
+
+  if (ptrace(PTRACE_INTERRUPT, tid, nullptr, nullptr) != 0) {
+    PLOG(ERROR) << "ptrace";
+    return false;
+  }
+  return true;
+}
+
+bool SeizePtraceConnection::WaitForStop(size_t index) {
+  Attachment& attachment = attachments_[index];
+
+  int status;
+  if (HANDLE_EINTR(waitpid(attachment.tid, &status, __WALL)) < 0) {
+    PLOG(ERROR) << "waitpid";
+    return false;
+  }
+  if (!WIFSTOPPED(status)) {
+    // The thread exited between being seized and stopping, and is no longer
+    // traced.
+    LOG(ERROR) << "thread " << attachment.tid << " not stopped";
+    attachment.tid = -1;
+    return false;
+  }
+
+  // A signal that was about to be delivered when the interrupt arrived stops
+  // the thread in a signal-delivery-stop instead. The thread is stopped all the
+  // same, but the signal is suppressed unless it’s passed back on detach.
+  // PTRACE_INTERRUPT stops report PTRACE_EVENT_STOP and carry no signal.
+  if (status >> 16 == 0) {
+    attachment.pending_signal = WSTOPSIG(status);
+  }
+  return true;
+}
+
+void SeizePtraceConnection::DetachAll() {
+  for (const Attachment& attachment : attachments_) {
+    if (attachment.tid >= 0 &&
+        ptrace(PTRACE_DETACH,
+               attachment.tid,
+               nullptr,
+               reinterpret_cast<void*>(
+                   static_cast<intptr_t>(attachment.pending_signal))) != 0) {
+      PLOG(ERROR) << "ptrace";
+    }
+  }
+  attachments_.clear();
+}
+
+}  // namespace crashpad
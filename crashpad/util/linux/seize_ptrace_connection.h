@@ -0,0 +1,95 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_SEIZE_PTRACE_CONNECTION_H_
+#define CRASHPAD_UTIL_LINUX_SEIZE_PTRACE_CONNECTION_H_
+
+#include <sys/types.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "util/linux/ptrace_connection.h"
+#include "util/linux/ptracer.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+
+//! \brief Manages a direct `ptrace` connection to a process, attaching threads
+//!     with `PTRACE_SEIZE` and stopping them with `PTRACE_INTERRUPT`.
+//!
+//! DirectPtraceConnection attaches with `PTRACE_ATTACH`, which sends each
+//! thread a `SIGSTOP` and must wait for it to stop before the next thread is
+//! attached. AttachAndGetThreadInfo() on this connection instead seizes and
+//! interrupts every requested thread before waiting for any of them to stop,
+//! so all threads stop at nearly the same time. This narrows the window in
+//! which some of a large process’ threads are stopped while others continue to
+//! run and modify shared state. No signal is sent, so the target can’t observe
+//! or mishandle a stray `SIGSTOP`.
+//!
+//! Like DirectPtraceConnection, this class may only be used from the thread
+//! that initialized it. Threads remain attached, and stopped, until the
+//! connection is destroyed.
+class SeizePtraceConnection : public PtraceConnection {
+ public:
+  SeizePtraceConnection();
+  ~SeizePtraceConnection();
+
+  //! \brief Initializes this connection for the process whose process ID is
+  //!     \a pid.
+  //!
+  //! The main thread of the process is automatically attached by this call.
+  //!
+  //! \param[in] pid The process ID of the process to connect to.
+  //! \return `true` on success. `false` on failure with a message logged.
+  bool Initialize(pid_t pid);
+
+  // PtraceConnection:
+
+  pid_t GetProcessID() override;
+  bool Attach(pid_t tid) override;
+  bool Is64Bit() override;
+  bool GetThreadInfo(pid_t tid, ThreadInfo* info) override;
+  void AttachAndGetThreadInfo(std::vector<ThreadRequest>* requests) override;
+
+ private:
+  struct Attachment {
+    pid_t tid;
+
+    // A signal whose delivery was intercepted when the thread stopped, to be
+    // delivered when it is detached, or 0.
+    int pending_signal;
+  };
+
+  // Seizes and interrupts |tid|, adding it to attachments_. The thread may not
+  // yet have stopped.
+  bool Seize(pid_t tid);
+
+  // Waits for the thread in attachments_[index], seized by Seize(), to stop.
+  bool WaitForStop(size_t index);
+
+  // Detaches every thread in attachments_.
+  void DetachAll();
+
+  std::vector<Attachment> attachments_;
+  pid_t pid_;
+  Ptracer ptracer_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(SeizePtraceConnection);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_SEIZE_PTRACE_CONNECTION_H_
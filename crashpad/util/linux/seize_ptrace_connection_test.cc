@@ -0,0 +1,146 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/seize_ptrace_connection.h"
+
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "build/build_config.h"
+#include "gtest/gtest.h"
+#include "test/multiprocess.h"
+#include "util/file/file_io.h"
+#include "util/stdlib/pointer_container.h"
+#include "util/synchronization/semaphore.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr size_t kThreadCount = 8;
+
+pid_t gettid() {
+  return syscall(SYS_gettid);
+}
+
+// Returns the state field of a thread’s stat file, or '\0' on failure.
+char ThreadState(pid_t pid, pid_t tid) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", pid, tid);
+  std::string contents;
+  if (!LoggingReadEntireFile(base::FilePath(path), &contents)) {
+    return '\0';
+  }
+  size_t state_position = contents.rfind(") ");
+  if (state_position == std::string::npos ||
+      state_position + 2 >= contents.size()) {
+    return '\0';
+  }
+  return contents[state_position + 2];
+}
+
+class BlockedThread : public Thread {
+ public:
+  BlockedThread(FileHandle write_handle, Semaphore* semaphore)
+      : Thread(), write_handle_(write_handle), semaphore_(semaphore) {}
+  ~BlockedThread() override {}
+
+ private:
+  void ThreadMain() override {
+    pid_t tid = gettid();
+    CheckedWriteFile(write_handle_, &tid, sizeof(tid));
+    semaphore_->Wait();
+  }
+
+  FileHandle write_handle_;
+  Semaphore* semaphore_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(BlockedThread);
+};
+
+class SeizeAllThreadsTest : public Multiprocess {
+ public:
+  SeizeAllThreadsTest() : Multiprocess() {}
+  ~SeizeAllThreadsTest() {}
+
+ private:
+  void MultiprocessParent() override {
+    std::vector<PtraceConnection::ThreadRequest> requests(kThreadCount);
+    for (PtraceConnection::ThreadRequest& request : requests) {
+      CheckedReadFileExactly(
+          ReadPipeHandle(), &request.tid, sizeof(request.tid));
+      request.success = false;
+    }
+
+    SeizePtraceConnection connection;
+    ASSERT_TRUE(connection.Initialize(ChildPID()));
+    EXPECT_EQ(connection.GetProcessID(), ChildPID());
+
+#if defined(ARCH_CPU_64_BITS)
+    EXPECT_TRUE(connection.Is64Bit());
+#else
+    EXPECT_FALSE(connection.Is64Bit());
+#endif  // ARCH_CPU_64_BITS
+
+    ThreadInfo main_info;
+    EXPECT_TRUE(connection.GetThreadInfo(ChildPID(), &main_info));
+    EXPECT_EQ(ThreadState(ChildPID(), ChildPID()), 't');
+
+    connection.AttachAndGetThreadInfo(&requests);
+    for (const PtraceConnection::ThreadRequest& request : requests) {
+      SCOPED_TRACE(request.tid);
+      EXPECT_TRUE(request.success);
+      EXPECT_EQ(ThreadState(ChildPID(), request.tid), 't');
+    }
+
+    // A thread can’t be seized twice.
+    EXPECT_FALSE(connection.Attach(requests[0].tid));
+  }
+
+  void MultiprocessChild() override {
+    Semaphore semaphore(0);
+    PointerVector<BlockedThread> threads;
+    for (size_t index = 0; index < kThreadCount; ++index) {
+      threads.push_back(new BlockedThread(WritePipeHandle(), &semaphore));
+      threads.back()->Start();
+    }
+
+    // The threads continue once the parent has detached from them.
+    CheckedReadFileAtEOF(ReadPipeHandle());
+
+    for (size_t index = 0; index < kThreadCount; ++index) {
+      semaphore.Signal();
+    }
+    for (BlockedThread* thread : threads) {
+      thread->Join();
+    }
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(SeizeAllThreadsTest);
+};
+
+TEST(SeizePtraceConnection, SeizeAllThreads) {
+  SeizeAllThreadsTest test;
+  test.Run();
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
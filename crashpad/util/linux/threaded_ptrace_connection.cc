@@ -0,0 +1,325 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/linux/threaded_ptrace_connection.h"
+
+#include <utility>
+
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "util/linux/ptracer.h"
+#include "util/linux/scoped_ptrace_attach.h"
+#include "util/synchronization/semaphore.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace internal {
+
+//! \brief A tracer thread owned by a ThreadedPtraceConnection.
+//!
+//! Requests posted to the worker are serviced on its own thread, which is the
+//! tracer of each thread that it attaches.
+class PtraceWorker final : public Thread {
+ public:
+  struct Request {
+    enum Operation {
+      //! \brief Attaches to #tid and determines whether its process is 64-bit.
+      kInitialize,
+
+      //! \brief Attaches to #tid.
+      kAttach,
+
+      //! \brief Retrieves #info for #tid, which this worker has attached.
+      kGetThreadInfo,
+
+      //! \brief Attaches to #tid and retrieves its #info.
+      kAttachAndGetThreadInfo,
+    };
+
+    Operation operation;
+    pid_t tid;
+    ThreadInfo* info;
+    bool float_context;
+    bool success;
+  };
+
+  PtraceWorker()
+      : Thread(),
+        attachments_(),
+        ptracer_(),
+        requests_(nullptr),
+        work_semaphore_(0),
+        done_semaphore_(0),
+        exit_(false) {}
+
+  ~PtraceWorker() override {}
+
+  //! \brief Begins servicing \a requests on the worker thread.
+  //!
+  //! Wait() must be called before \a requests is examined and before Post() is
+  //! called again.
+  void Post(std::vector<Request>* requests) {
+    requests_ = requests;
+    work_semaphore_.Signal();
+  }
+
+  //! \brief Waits for the requests passed to Post() to be serviced.
+  void Wait() { done_semaphore_.Wait(); }
+
+  //! \brief Services \a requests and waits for them to complete.
+  void Run(std::vector<Request>* requests) {
+    Post(requests);
+    Wait();
+  }
+
+  //! \brief Detaches from every thread that this worker attached, and joins
+  //!     the worker thread.
+  void Stop() {
+    exit_ = true;
+    work_semaphore_.Signal();
+    Join();
+  }
+
+  //! \brief Prepares a worker that will not service a Request::kInitialize
+  //!     request to read registers of a process of the given bitness.
+  //!
+  //! This may not be called while requests are being serviced.
+  void SetIs64Bit(bool is_64_bit) { ptracer_.reset(new Ptracer(is_64_bit)); }
+
+  //! \brief Returns whether the connected process is 64-bit. This is valid
+  //!     after a Request::kInitialize request has succeeded, or after
+  //!     SetIs64Bit() has been called.
+  bool Is64Bit() { return ptracer_->Is64Bit(); }
+
+ private:
+  void ThreadMain() override {
+    while (true) {
+      work_semaphore_.Wait();
+      if (exit_) {
+        // ptrace relationships can only be ended by the tracer, so detach here
+        // rather than when the worker is destroyed.
+        attachments_.clear();
+        return;
+      }
+
+      for (Request& request : *requests_) {
+        Service(&request);
+      }
+      done_semaphore_.Signal();
+    }
+  }
+
+  void Service(Request* request) {
+    switch (request->operation) {
+      case Request::kInitialize: {
+        std::unique_ptr<Ptracer> ptracer(new Ptracer());
+        request->success =
+            AttachThread(request->tid) && ptracer->Initialize(request->tid);
+        if (request->success) {
+          ptracer_ = std::move(ptracer);
+        }
+        break;
+      }
+
+      case Request::kAttach:
+        request->success = AttachThread(request->tid);
+        break;
+
+      case Request::kGetThreadInfo:
+        DCHECK(ptracer_);
+        request->success = ptracer_->GetThreadInfo(
+            request->tid, request->float_context, request->info);
+        break;
+
+      case Request::kAttachAndGetThreadInfo:
+        DCHECK(ptracer_);
+        request->success =
+            AttachThread(request->tid) &&
+            ptracer_->GetThreadInfo(
+                request->tid, request->float_context, request->info);
+        break;
+    }
+  }
+
+  bool AttachThread(pid_t tid) {
+    std::unique_ptr<ScopedPtraceAttach> attach(new ScopedPtraceAttach);
+    if (!attach->ResetAttach(tid)) {
+      return false;
+    }
+    attachments_.push_back(std::move(attach));
+    return true;
+  }
+
+  std::vector<std::unique_ptr<ScopedPtraceAttach>> attachments_;
+  std::unique_ptr<Ptracer> ptracer_;
+  std::vector<Request>* requests_;  // weak
+  Semaphore work_semaphore_;
+  Semaphore done_semaphore_;
+  bool exit_;
+
+  DISALLOW_COPY_AND_ASSIGN(PtraceWorker);
+};
+
+}  // namespace internal
+
+ThreadedPtraceConnection::ThreadedPtraceConnection()
+    : PtraceConnection(),
+      workers_(),
+      tracers_(),
+      lock_(),
+      next_worker_(0),
+      pid_(-1),
+      is_64_bit_(false),
+      initialized_() {}
+
+ThreadedPtraceConnection::~ThreadedPtraceConnection() {
+  for (const auto& worker : workers_) {
+    worker->Stop();
+  }
+}
+
+bool ThreadedPtraceConnection::Initialize(pid_t pid, size_t worker_count) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+  DCHECK_GT(worker_count, 0u);
+
+  base::AutoLock lock_owner(lock_);
+
+  for (size_t index = 0; index < worker_count; ++index) {
+    workers_.push_back(base::WrapUnique(new internal::PtraceWorker()));
+    workers_.back()->Start();
+  }
+
+  std::vector<internal::PtraceWorker::Request> requests(1);
+  requests[0].operation = internal::PtraceWorker::Request::kInitialize;
+  requests[0].tid = pid;
+  requests[0].info = nullptr;
+  workers_[0]->Run(&requests);
+  if (!requests[0].success) {
+    return false;
+  }
+
+  is_64_bit_ = workers_[0]->Is64Bit();
+  for (size_t index = 1; index < workers_.size(); ++index) {
+    workers_[index]->SetIs64Bit(is_64_bit_);
+  }
+
+  tracers_[pid] = workers_[0].get();
+  next_worker_ = 1 % workers_.size();
+  pid_ = pid;
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+pid_t ThreadedPtraceConnection::GetProcessID() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return pid_;
+}
+
+bool ThreadedPtraceConnection::Attach(pid_t tid) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  base::AutoLock lock_owner(lock_);
+
+  internal::PtraceWorker* worker = workers_[next_worker_].get();
+  next_worker_ = (next_worker_ + 1) % workers_.size();
+
+  std::vector<internal::PtraceWorker::Request> requests(1);
+  requests[0].operation = internal::PtraceWorker::Request::kAttach;
+  requests[0].tid = tid;
+  requests[0].info = nullptr;
+  worker->Run(&requests);
+  if (!requests[0].success) {
+    return false;
+  }
+
+  tracers_[tid] = worker;
+  return true;
+}
+
+bool ThreadedPtraceConnection::Is64Bit() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  return is_64_bit_;
+}
+
+bool ThreadedPtraceConnection::GetThreadInfo(pid_t tid, ThreadInfo* info) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  base::AutoLock lock_owner(lock_);
+
+  const auto& iterator = tracers_.find(tid);
+  if (iterator == tracers_.end()) {
+    LOG(ERROR) << "thread " << tid << " not attached";
+    return false;
+  }
+
+  std::vector<internal::PtraceWorker::Request> requests(1);
+  requests[0].operation = internal::PtraceWorker::Request::kGetThreadInfo;
+  requests[0].tid = tid;
+  requests[0].info = info;
+  requests[0].float_context = true;
+  iterator->second->Run(&requests);
+  return requests[0].success;
+}
+
+void ThreadedPtraceConnection::AttachAndGetThreadInfo(
+    std::vector<ThreadRequest>* requests) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  base::AutoLock lock_owner(lock_);
+
+  // Deal the requests out to the workers, remembering where each came from.
+  std::vector<std::vector<internal::PtraceWorker::Request>> worker_requests(
+      workers_.size());
+  std::vector<std::vector<size_t>> request_indices(workers_.size());
+  for (size_t index = 0; index < requests->size(); ++index) {
+    internal::PtraceWorker::Request request;
+    request.operation =
+        internal::PtraceWorker::Request::kAttachAndGetThreadInfo;
+    request.tid = (*requests)[index].tid;
+    request.info = &(*requests)[index].info;
+    request.float_context = (*requests)[index].float_context;
+    request.success = false;
+    worker_requests[next_worker_].push_back(request);
+    request_indices[next_worker_].push_back(index);
+    next_worker_ = (next_worker_ + 1) % workers_.size();
+  }
+
+  for (size_t worker_index = 0; worker_index < workers_.size();
+       ++worker_index) {
+    if (!worker_requests[worker_index].empty()) {
+      workers_[worker_index]->Post(&worker_requests[worker_index]);
+    }
+  }
+
+  for (size_t worker_index = 0; worker_index < workers_.size();
+       ++worker_index) {
+    if (worker_requests[worker_index].empty()) {
+      continue;
+    }
+    workers_[worker_index]->Wait();
+
+    for (size_t index = 0; index < worker_requests[worker_index].size();
+         ++index) {
+      const internal::PtraceWorker::Request& request =
+          worker_requests[worker_index][index];
+      ThreadRequest& thread_request =
+          (*requests)[request_indices[worker_index][index]];
+      thread_request.success = request.success;
+
+      if (request.success) {
+        tracers_[request.tid] = workers_[worker_index].get();
+      }
+    }
+  }
+}
+
+}  // namespace crashpad
@@ -0,0 +1,91 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_LINUX_THREADED_PTRACE_CONNECTION_H_
+#define CRASHPAD_UTIL_LINUX_THREADED_PTRACE_CONNECTION_H_
+
+#include <sys/types.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "util/linux/ptrace_connection.h"
+#include "util/misc/initialization_state_dcheck.h"
+
+namespace crashpad {
+
+namespace internal {
+class PtraceWorker;
+}  // namespace internal
+
+//! \brief Manages a direct `ptrace` connection to a process, spreading the
+//!     attached threads across a pool of tracer threads.
+//!
+//! A `ptrace` relationship belongs to the thread that attached, not to its
+//! process, so DirectPtraceConnection can only be used from the thread that
+//! initialized it and services each thread serially. This connection instead
+//! owns a bounded number of worker threads, each with its own `ptrace`
+//! relationships. AttachAndGetThreadInfo() distributes threads among the
+//! workers so that they are attached and read concurrently, and later requests
+//! for a thread are routed to the worker that attached it. The connection’s
+//! methods may be called from any thread.
+//!
+//! Threads remain attached, and stopped, until the connection is destroyed.
+class ThreadedPtraceConnection : public PtraceConnection {
+ public:
+  ThreadedPtraceConnection();
+  ~ThreadedPtraceConnection();
+
+  //! \brief Initializes this connection for the process whose process ID is
+  //!     \a pid.
+  //!
+  //! The main thread of the process is automatically attached by this call.
+  //!
+  //! \param[in] pid The process ID of the process to connect to.
+  //! \param[in] worker_count The number of tracer threads to start. This must
+  //!     be at least `1`.
+  //! \return `true` on success. `false` on failure with a message logged.
+  bool Initialize(pid_t pid, size_t worker_count);
+
+  // PtraceConnection:
+
+  pid_t GetProcessID() override;
+  bool Attach(pid_t tid) override;
+  bool Is64Bit() override;
+  bool GetThreadInfo(pid_t tid, ThreadInfo* info) override;
+  void AttachAndGetThreadInfo(std::vector<ThreadRequest>* requests) override;
+
+ private:
+  std::vector<std::unique_ptr<internal::PtraceWorker>> workers_;
+
+  // Maps each attached thread to the worker that is its tracer.
+  std::map<pid_t, internal::PtraceWorker*> tracers_;
+
+  // Serializes access to workers_ and tracers_.
+  base::Lock lock_;
+
+  size_t next_worker_;
+  pid_t pid_;
+  bool is_64_bit_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadedPtraceConnection);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_LINUX_THREADED_PTRACE_CONNECTION_H_
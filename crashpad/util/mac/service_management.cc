@@ -17,7 +17,9 @@
 #include <errno.h>
 #include <launch.h>
 
+#include "base/mac/scoped_cftyperef.h"
 #include "base/mac/scoped_launch_data.h"
+#include "base/strings/sys_string_conversions.h"
 #include "util/mac/launchd.h"
 #include "util/misc/clock.h"
 
@@ -74,6 +76,51 @@ bool ServiceManagementSubmitJob(CFDictionaryRef job_cf) {
   return true;
 }
 
+bool ServiceManagementSubmitOnDemandJob(
+    const std::string& label,
+    const std::vector<std::string>& program_arguments,
+    const std::vector<std::string>& mach_services) {
+  base::ScopedCFTypeRef<CFMutableDictionaryRef> job(
+      CFDictionaryCreateMutable(kCFAllocatorDefault,
+                                0,
+                                &kCFTypeDictionaryKeyCallBacks,
+                                &kCFTypeDictionaryValueCallBacks));
+
+  base::ScopedCFTypeRef<CFStringRef> label_cf(
+      base::SysUTF8ToCFStringRef(label));
+  CFDictionarySetValue(job, CFSTR(LAUNCH_JOBKEY_LABEL), label_cf);
+
+  base::ScopedCFTypeRef<CFMutableArrayRef> program_arguments_cf(
+      CFArrayCreateMutable(kCFAllocatorDefault,
+                           program_arguments.size(),
+                           &kCFTypeArrayCallBacks));
+  for (const std::string& argument : program_arguments) {
+    base::ScopedCFTypeRef<CFStringRef> argument_cf(
+        base::SysUTF8ToCFStringRef(argument));
+    CFArrayAppendValue(program_arguments_cf, argument_cf);
+  }
+  CFDictionarySetValue(
+      job, CFSTR(LAUNCH_JOBKEY_PROGRAMARGUMENTS), program_arguments_cf);
+
+  // Without RunAtLoad or KeepAlive, launchd starts the job only on demand.
+  if (!mach_services.empty()) {
+    base::ScopedCFTypeRef<CFMutableDictionaryRef> mach_services_cf(
+        CFDictionaryCreateMutable(kCFAllocatorDefault,
+                                  mach_services.size(),
+                                  &kCFTypeDictionaryKeyCallBacks,
+                                  &kCFTypeDictionaryValueCallBacks));
+    for (const std::string& mach_service : mach_services) {
+      base::ScopedCFTypeRef<CFStringRef> mach_service_cf(
+          base::SysUTF8ToCFStringRef(mach_service));
+      CFDictionarySetValue(mach_services_cf, mach_service_cf, kCFBooleanTrue);
+    }
+    CFDictionarySetValue(
+        job, CFSTR(LAUNCH_JOBKEY_MACHSERVICES), mach_services_cf);
+  }
+
+  return ServiceManagementSubmitJob(job);
+}
+
 bool ServiceManagementRemoveJob(const std::string& label, bool wait) {
   base::mac::ScopedLaunchData request(LaunchDataAlloc(LAUNCH_DATA_DICTIONARY));
   LaunchDataDictInsert(
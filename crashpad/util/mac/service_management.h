@@ -19,6 +19,7 @@
 #include <unistd.h>
 
 #include <string>
+#include <vector>
 
 namespace crashpad {
 
@@ -33,6 +34,25 @@ namespace crashpad {
 //!     `ServiceManagement.framework`.
 bool ServiceManagementSubmitJob(CFDictionaryRef job_cf);
 
+//! \brief Submits a job to the user launchd domain that launchd starts only
+//!     when a message arrives for one of its Mach services.
+//!
+//! The job is submitted with ServiceManagementSubmitJob(), and remains loaded
+//! until it is removed or the user’s session ends.
+//!
+//! \param[in] label The label for the job.
+//! \param[in] program_arguments The job’s command, starting with the path to
+//!     the executable to run.
+//! \param[in] mach_services The Mach services to reserve for the job with the
+//!     bootstrap server. The job is expected to check in under each of these
+//!     names when it starts.
+//!
+//! \return `true` if the job was submitted successfully, otherwise `false`.
+bool ServiceManagementSubmitOnDemandJob(
+    const std::string& label,
+    const std::vector<std::string>& program_arguments,
+    const std::vector<std::string>& mach_services);
+
 //! \brief Removes a job from the user launchd domain as in `SMJobRemove()`.
 //!
 //! \param[in] label The label for the job to remove.
@@ -25,6 +25,7 @@
 #include "base/strings/stringprintf.h"
 #include "base/strings/sys_string_conversions.h"
 #include "gtest/gtest.h"
+#include "util/mach/mach_extensions.h"
 #include "util/misc/clock.h"
 #include "util/misc/random_string.h"
 #include "util/posix/process_info.h"
@@ -157,6 +158,35 @@ TEST(ServiceManagement, SubmitRemoveJob) {
   }
 }
 
+TEST(ServiceManagement, SubmitOnDemandJob) {
+  const std::string cookie = RandomString();
+  const std::string shell_script =
+      base::StringPrintf("sleep 10; echo %s", cookie.c_str());
+
+  static constexpr char kJobLabel[] =
+      "org.chromium.crashpad.test.service_management.on_demand";
+  const std::string mach_service = std::string(kJobLabel) + "." + cookie;
+
+  // The job may be left over from a failed previous run.
+  if (ServiceManagementIsJobLoaded(kJobLabel)) {
+    EXPECT_TRUE(ServiceManagementRemoveJob(kJobLabel, true));
+  }
+
+  ASSERT_TRUE(ServiceManagementSubmitOnDemandJob(
+      kJobLabel,
+      {"/bin/sh", "-c", shell_script},
+      std::vector<std::string>(1, mach_service)));
+  EXPECT_TRUE(ServiceManagementIsJobLoaded(kJobLabel));
+
+  // launchd doesn’t start the job until a message arrives for its service, but
+  // the service can be looked up already.
+  EXPECT_EQ(ServiceManagementIsJobRunning(kJobLabel), 0);
+  EXPECT_TRUE(BootstrapLookUp(mach_service).is_valid());
+
+  ASSERT_TRUE(ServiceManagementRemoveJob(kJobLabel, true));
+  EXPECT_FALSE(ServiceManagementIsJobLoaded(kJobLabel));
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
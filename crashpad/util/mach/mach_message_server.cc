@@ -15,7 +15,9 @@
 #include "util/mach/mach_message_server.h"
 
 #include <string.h>
+#include <sys/mman.h>
 
+#include <algorithm>
 #include <limits>
 
 #include "base/logging.h"
@@ -30,29 +32,38 @@ namespace {
 //! \brief Manages a dynamically-allocated buffer to be used for Mach messaging.
 class MachMessageBuffer {
  public:
-  MachMessageBuffer() : vm_() {}
+  //! \param[in] vm The storage for the buffer.
+  //! \param[in] keep `true` if \a vm is owned by a MachMessageServer::Buffers
+  //!     object and outlives this object, in which case it is only grown and
+  //!     is wired when allocated. `false` if \a vm is only used for a single
+  //!     MachMessageServer::Run() call, in which case it is reallocated to the
+  //!     exact size needed.
+  MachMessageBuffer(base::mac::ScopedMachVM* vm, bool keep)
+      : vm_(vm), keep_(keep) {}
 
   ~MachMessageBuffer() {}
 
   //! \return A pointer to the buffer.
   mach_msg_header_t* Header() const {
-    return reinterpret_cast<mach_msg_header_t*>(vm_.address());
+    return reinterpret_cast<mach_msg_header_t*>(vm_->address());
   }
 
-  //! \brief Ensures that this object has a buffer of exactly \a size bytes
+  //! \brief Ensures that this object has a buffer of at least \a size bytes
   //!     available.
   //!
-  //! If the existing buffer is a different size, it will be reallocated without
+  //! If the existing buffer is not suitable, it will be reallocated without
   //! copying any of the old buffer’s contents to the new buffer. The contents
   //! of the buffer are unspecified after this call, even if no reallocation is
   //! performed.
   kern_return_t Reallocate(vm_size_t size) {
-    // This test uses == instead of > so that a large reallocation to receive a
-    // large message doesn’t cause permanent memory bloat for the duration of
-    // a MachMessageServer::Run() loop.
-    if (size != vm_.size()) {
+    // Without keep_, this test uses != instead of < so that a large
+    // reallocation to receive a large message doesn’t cause permanent memory
+    // bloat for the duration of a MachMessageServer::Run() loop. With keep_,
+    // the caller has chosen to retain the buffer, so growing it once is
+    // preferable to reallocating it for every large message.
+    if (keep_ ? size > vm_->size() : size != vm_->size()) {
       // reset() first, so that two allocations don’t exist simultaneously.
-      vm_.reset();
+      vm_->reset();
 
       if (size) {
         vm_address_t address;
@@ -65,7 +76,14 @@ class MachMessageBuffer {
           return kr;
         }
 
-        vm_.reset(address, size);
+        vm_->reset(address, size);
+
+        if (keep_) {
+          // Wiring is an optimization that avoids page faults when a message
+          // is received. It may fail if RLIMIT_MEMLOCK is exhausted, in which
+          // case the buffer is still usable.
+          mlock(reinterpret_cast<void*>(address), size);
+        }
       }
     }
 
@@ -80,7 +98,8 @@ class MachMessageBuffer {
   }
 
  private:
-  base::mac::ScopedMachVM vm_;
+  base::mac::ScopedMachVM* vm_;  // weak
+  bool keep_;
 
   DISALLOW_COPY_AND_ASSIGN(MachMessageBuffer);
 };
@@ -112,6 +131,26 @@ mach_msg_return_t MachMessageAllocateReceive(MachMessageBuffer* request,
 
 }  // namespace
 
+MachMessageServer::Buffers::Buffers() : request_(), reply_() {}
+
+MachMessageServer::Buffers::~Buffers() {}
+
+// static
+mach_msg_return_t MachMessageServer::Run(Interface* interface,
+                                         mach_port_t receive_port,
+                                         mach_msg_options_t options,
+                                         Persistent persistent,
+                                         ReceiveLarge receive_large,
+                                         mach_msg_timeout_t timeout_ms) {
+  return Run(interface,
+             receive_port,
+             options,
+             persistent,
+             receive_large,
+             timeout_ms,
+             nullptr);
+}
+
 // This method implements a server similar to 10.9.4
 // xnu-2422.110.17/libsyscall/mach/mach_msg.c mach_msg_server_once(). The server
 // callback function and |max_size| parameter have been replaced with a C++
@@ -125,7 +164,8 @@ mach_msg_return_t MachMessageServer::Run(Interface* interface,
                                          mach_msg_options_t options,
                                          Persistent persistent,
                                          ReceiveLarge receive_large,
-                                         mach_msg_timeout_t timeout_ms) {
+                                         mach_msg_timeout_t timeout_ms,
+                                         Buffers* buffers) {
   options &= ~(MACH_RCV_MSG | MACH_SEND_MSG);
 
   const MachMessageDeadline deadline =
@@ -140,11 +180,22 @@ mach_msg_return_t MachMessageServer::Run(Interface* interface,
   const mach_msg_size_t trailer_alloc = REQUESTED_TRAILER_SIZE(options);
   const mach_msg_size_t expected_receive_size =
       round_msg(interface->MachMessageServerRequestSize()) + trailer_alloc;
-  const mach_msg_size_t request_size = (receive_large == kReceiveLargeResize)
-                                           ? round_page(expected_receive_size)
-                                           : expected_receive_size;
+  mach_msg_size_t request_size = (receive_large == kReceiveLargeResize)
+                                     ? round_page(expected_receive_size)
+                                     : expected_receive_size;
   DCHECK_GE(request_size, sizeof(mach_msg_empty_rcv_t));
 
+  if (buffers && receive_large == kReceiveLargeResize &&
+      buffers->request_.size() > request_size) {
+    // A previous large message grew the retained request buffer. Receive into
+    // all of it, so that another message of that size doesn’t need to be
+    // received twice.
+    request_size = static_cast<mach_msg_size_t>(
+        std::min(buffers->request_.size(),
+                 static_cast<vm_size_t>(
+                     std::numeric_limits<mach_msg_size_t>::max())));
+  }
+
   // mach_msg_server() and mach_msg_server_once() would consider whether
   // |options| contains MACH_SEND_TRAILER and include MAX_TRAILER_SIZE in this
   // computation if it does, but that option is ineffective on macOS.
@@ -152,8 +203,12 @@ mach_msg_return_t MachMessageServer::Run(Interface* interface,
   DCHECK_GE(reply_size, sizeof(mach_msg_empty_send_t));
   const mach_msg_size_t reply_alloc = round_page(reply_size);
 
-  MachMessageBuffer request;
-  MachMessageBuffer reply;
+  base::mac::ScopedMachVM request_vm;
+  base::mac::ScopedMachVM reply_vm;
+  MachMessageBuffer request(buffers ? &buffers->request_ : &request_vm,
+                            buffers != nullptr);
+  MachMessageBuffer reply(buffers ? &buffers->reply_ : &reply_vm,
+                          buffers != nullptr);
   bool received_any_request = false;
   bool retry;
 
@@ -19,6 +19,7 @@
 
 #include <set>
 
+#include "base/mac/scoped_mach_vm.h"
 #include "base/macros.h"
 
 namespace crashpad {
@@ -125,6 +126,32 @@ class MachMessageServer {
     kReceiveLargeResize,
   };
 
+  //! \brief Request and reply buffers that persist across calls to Run().
+  //!
+  //! Without one of these objects, Run() allocates its buffers when it is
+  //! called and deallocates them before returning, and may reallocate them
+  //! for each message. A caller that calls Run() repeatedly, such as in a
+  //! #kOneShot loop, can keep a Buffers object for the server’s lifetime
+  //! instead. Buffers are allocated on first use, wired into memory where
+  //! possible, and only grown, such as when #kReceiveLargeResize requires a
+  //! larger request buffer.
+  //!
+  //! A Buffers object must not be used by more than one call to Run() at a
+  //! time.
+  class Buffers {
+   public:
+    Buffers();
+    ~Buffers();
+
+   private:
+    friend class MachMessageServer;
+
+    base::mac::ScopedMachVM request_;
+    base::mac::ScopedMachVM reply_;
+
+    DISALLOW_COPY_AND_ASSIGN(Buffers);
+  };
+
   //! \brief Runs a Mach message server to handle a Mach RPC request for MIG
   //!     servers.
   //!
@@ -174,6 +201,23 @@ class MachMessageServer {
                                ReceiveLarge receive_large,
                                mach_msg_timeout_t timeout_ms);
 
+  //! \brief Runs a Mach message server to handle a Mach RPC request for MIG
+  //!     servers, using caller-owned buffers.
+  //!
+  //! This function behaves exactly as the other Run(), except that the request
+  //! and reply buffers are taken from \a buffers and left there on return, so
+  //! that subsequent calls can reuse them.
+  //!
+  //! \param[in,out] buffers The buffers to receive requests and build replies
+  //!     in. If `nullptr`, buffers are allocated for the duration of this call.
+  static mach_msg_return_t Run(Interface* interface,
+                               mach_port_t receive_port,
+                               mach_msg_options_t options,
+                               Persistent persistent,
+                               ReceiveLarge receive_large,
+                               mach_msg_timeout_t timeout_ms,
+                               Buffers* buffers);
+
  private:
   DISALLOW_IMPLICIT_CONSTRUCTORS(MachMessageServer);
 };
@@ -77,7 +77,8 @@ class TestMachMessageServer : public MachMessageServer::Interface,
           client_reply_port_type(kReplyPortNormal),
           client_expect_reply(true),
           child_send_all_requests_before_receiving_any_replies(false),
-          child_wait_for_parent_pipe_late(false) {
+          child_wait_for_parent_pipe_late(false),
+          server_use_buffers(false) {
     }
 
     // true if MachMessageServerFunction() is expected to be called.
@@ -170,6 +171,11 @@ class TestMachMessageServer : public MachMessageServer::Interface,
     // child exited before the parent had a chance to examine it. This would be
     // a race.
     bool child_wait_for_parent_pipe_late;
+
+    // true if the server should pass a MachMessageServer::Buffers object to
+    // MachMessageServer::Run(), and then reuse it for a second, nonblocking
+    // call that finds no message.
+    bool server_use_buffers;
   };
 
   explicit TestMachMessageServer(const Options& options)
@@ -349,15 +355,32 @@ class TestMachMessageServer : public MachMessageServer::Interface,
       EXPECT_EQ(c, '\0');
     }
 
-    ASSERT_EQ((kr = MachMessageServer::Run(this,
-                                           local_port,
-                                           options_.server_options,
-                                           options_.server_persistent,
-                                           options_.server_receive_large,
-                                           options_.server_timeout_ms)),
+    MachMessageServer::Buffers buffers;
+    ASSERT_EQ((kr = MachMessageServer::Run(
+                   this,
+                   local_port,
+                   options_.server_options,
+                   options_.server_persistent,
+                   options_.server_receive_large,
+                   options_.server_timeout_ms,
+                   options_.server_use_buffers ? &buffers : nullptr)),
               options_.expect_server_result)
         << MachErrorMessage(kr, "MachMessageServer");
 
+    if (options_.server_use_buffers) {
+      // The buffers outlive MachMessageServer::Run(). Running again with them
+      // in nonblocking mode reuses them, and finds no message.
+      ASSERT_EQ((kr = MachMessageServer::Run(this,
+                                             local_port,
+                                             options_.server_options,
+                                             MachMessageServer::kOneShot,
+                                             options_.server_receive_large,
+                                             kMachMessageTimeoutNonblocking,
+                                             &buffers)),
+                MACH_RCV_TIMED_OUT)
+          << MachErrorMessage(kr, "MachMessageServer");
+    }
+
     if (options_.client_send_complex) {
       EXPECT_NE(parent_complex_message_port_, kMachPortNull);
       mach_port_type_t type;
@@ -669,6 +692,20 @@ TEST(MachMessageServer, PersistentTenMessages) {
   test_mach_message_server.Test();
 }
 
+TEST(MachMessageServer, PersistentTenMessagesBuffers) {
+  // This is the same as PersistentTenMessages, but caller-owned buffers are
+  // reused for each message.
+  TestMachMessageServer::Options options;
+  options.server_persistent = MachMessageServer::kPersistent;
+  options.server_timeout_ms = 10;
+  options.expect_server_result = MACH_RCV_TIMED_OUT;
+  options.expect_server_transaction_count = 10;
+  options.client_send_request_count = 10;
+  options.server_use_buffers = true;
+  TestMachMessageServer test_mach_message_server(options);
+  test_mach_message_server.Test();
+}
+
 TEST(MachMessageServer, PersistentNonblockingFourMessages) {
   // The client sends several messages to the server and then signals the server
   // that it’s safe to start waiting for them in nonblocking mode. The server
@@ -837,6 +874,17 @@ TEST(MachMessageServer, ReceiveLargeRetry) {
   test_mach_message_server.Test();
 }
 
+TEST(MachMessageServer, ReceiveLargeRetryBuffers) {
+  // This is the same as ReceiveLargeRetry, but the large request is received
+  // into a caller-owned buffer, which is grown to hold it.
+  TestMachMessageServer::Options options;
+  options.server_receive_large = MachMessageServer::kReceiveLargeResize;
+  options.client_send_large = true;
+  options.server_use_buffers = true;
+  TestMachMessageServer test_mach_message_server(options);
+  test_mach_message_server.Test();
+}
+
 TEST(MachMessageServer, ReceiveLargeIgnore) {
   // The client sends a request to the server that is larger than the server is
   // expecting. server_receive_large is kReceiveLargeIgnore, so the request is
@@ -18,14 +18,90 @@
 #include <string.h>
 
 #include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/mac/mach_logging.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "util/misc/memory_read_trace.h"
 #include "util/stdlib/strnlen.h"
 
 namespace crashpad {
 
+namespace {
+
+// Reads no larger than this are served from the cache, once it’s enabled.
+// Larger reads are copied directly into the caller’s buffer.
+constexpr size_t kMaxCachedReadSize = 4 * PAGE_SIZE;
+
+// The maximum number of pages copied into the cache at once when a read misses
+// the cache.
+constexpr mach_vm_size_t kCacheReadAheadPages = 16;
+
+// The cache is emptied when it would otherwise grow beyond this many pages.
+constexpr size_t kMaxCachedPages = 1024;
+
+// Requests are combined by ReadBatch() only while the combined copy stays
+// below this size, bounding the temporary buffer that combined copies go
+// through.
+constexpr mach_vm_size_t kMaxCombinedReadSize = 1024 * 1024;
+
+// Remembers the contents of read-only pages in the shared regions of tasks
+// that have been read, for the life of the process. A page is identified by the
+// UUID and slide of the dyld shared cache mapped into the shared region, and by
+// its address, so that pages are only shared between tasks that map the same
+// shared cache in the same place. Each page is copied out of the first task it
+// is read from, and is served from here for every later task.
+class SharedRegionPageCache {
+ public:
+  using Key = std::tuple<std::string, mach_vm_size_t, mach_vm_address_t>;
+
+  static SharedRegionPageCache* Get() {
+    static SharedRegionPageCache* instance = new SharedRegionPageCache();
+    return instance;
+  }
+
+  bool Lookup(const Key& key, uint8_t* page) {
+    base::AutoLock lock_owner(lock_);
+    const auto it = cache_.find(key);
+    if (it == cache_.end()) {
+      return false;
+    }
+    memcpy(page, it->second.get(), PAGE_SIZE);
+    return true;
+  }
+
+  void Insert(const Key& key, const uint8_t* page) {
+    base::AutoLock lock_owner(lock_);
+    if (cache_.size() < kMaxPages && !cache_.count(key)) {
+      std::unique_ptr<uint8_t[]> contents(new uint8_t[PAGE_SIZE]);
+      memcpy(contents.get(), page, PAGE_SIZE);
+      cache_.insert(std::make_pair(key, std::move(contents)));
+    }
+  }
+
+ private:
+  // Bounds the cache’s memory use. Once full, further pages are simply not
+  // cached.
+  static constexpr size_t kMaxPages = 4096;
+
+  SharedRegionPageCache() : cache_(), lock_() {}
+  ~SharedRegionPageCache() = delete;
+
+  // Access to these fields must be guarded by lock_.
+  std::map<Key, std::unique_ptr<uint8_t[]>> cache_;
+
+  base::Lock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedRegionPageCache);
+};
+
+}  // namespace
+
 TaskMemory::MappedMemory::~MappedMemory() {
 }
 
@@ -64,19 +140,117 @@ TaskMemory::MappedMemory::MappedMemory(vm_address_t vm_address,
   DCHECK_LE(user_end, vm_end);
 }
 
-TaskMemory::TaskMemory(task_t task) : task_(task) {
+TaskMemory::TaskMemory(task_t task)
+    : pages_(),
+      regions_(),
+      shared_cache_uuid_(),
+      shared_cache_slide_(0),
+      shared_region_address_(0),
+      shared_region_size_(0),
+      task_(task),
+      cache_enabled_(false) {
+}
+
+TaskMemory::~TaskMemory() {
+}
+
+void TaskMemory::EnableCache() {
+  cache_enabled_ = true;
+}
+
+void TaskMemory::SetSharedRegion(const UUID& shared_cache_uuid,
+                                 mach_vm_size_t shared_cache_slide,
+                                 mach_vm_address_t address,
+                                 mach_vm_size_t size) {
+  shared_cache_uuid_ = shared_cache_uuid;
+  shared_cache_slide_ = shared_cache_slide;
+  shared_region_address_ = address;
+  shared_region_size_ = size;
 }
 
 bool TaskMemory::Read(mach_vm_address_t address, size_t size, void* buffer) {
-  std::unique_ptr<MappedMemory> memory = ReadMapped(address, size);
-  if (!memory) {
+  if (size == 0) {
+    return true;
+  }
+
+  if (cache_enabled_ && size <= kMaxCachedReadSize &&
+      ReadCached(address, size, buffer)) {
+    return true;
+  }
+
+  // On a cache miss for unreadable memory, this repeats the read so that the
+  // failure is logged consistently.
+  kern_return_t kr = ReadOverwrite(address, size, buffer);
+  if (kr != KERN_SUCCESS) {
+    MACH_LOG(WARNING, kr) << base::StringPrintf(
+        "mach_vm_read_overwrite(0x%llx, 0x%zx)", address, size);
     return false;
   }
 
-  memcpy(buffer, memory->data(), size);
   return true;
 }
 
+void TaskMemory::ReadBatch(std::vector<ReadRequest>* requests) {
+  std::vector<ReadRequest*> sorted;
+  sorted.reserve(requests->size());
+  for (ReadRequest& request : *requests) {
+    request.success = request.size == 0;
+    if (request.size != 0) {
+      sorted.push_back(&request);
+    }
+  }
+  std::sort(sorted.begin(),
+            sorted.end(),
+            [](const ReadRequest* lhs, const ReadRequest* rhs) {
+              return lhs->address < rhs->address;
+            });
+
+  std::vector<uint8_t> buffer;
+  size_t index = 0;
+  while (index < sorted.size()) {
+    // Find the run of requests that are adjacent to or overlap the first one.
+    const mach_vm_address_t span_address = sorted[index]->address;
+    mach_vm_address_t span_end = span_address + sorted[index]->size;
+    size_t run_end = index + 1;
+    while (run_end < sorted.size() && sorted[run_end]->address <= span_end) {
+      const mach_vm_address_t end = std::max(
+          span_end, sorted[run_end]->address + sorted[run_end]->size);
+      if (end - span_address > kMaxCombinedReadSize) {
+        break;
+      }
+      span_end = end;
+      ++run_end;
+    }
+
+    if (run_end == index + 1) {
+      // Nothing to combine with, so read directly into the caller’s buffer.
+      ReadRequest* request = sorted[index];
+      request->success = Read(request->address, request->size, request->buffer);
+      ++index;
+      continue;
+    }
+
+    buffer.resize(span_end - span_address);
+    const bool span_success =
+        ReadOverwrite(span_address, buffer.size(), &buffer[0]) == KERN_SUCCESS;
+
+    for (; index < run_end; ++index) {
+      ReadRequest* request = sorted[index];
+      if (!span_success) {
+        // Some of the combined span is unreadable, but this request may not
+        // touch that part of it.
+        request->success =
+            Read(request->address, request->size, request->buffer);
+        continue;
+      }
+      memcpy(request->buffer,
+             &buffer[request->address - span_address],
+             request->size);
+      request->success = true;
+    }
+  }
+}
+
 std::unique_ptr<TaskMemory::MappedMemory> TaskMemory::ReadMapped(
     mach_vm_address_t address,
     size_t size) {
@@ -90,8 +264,12 @@ std::unique_ptr<TaskMemory::MappedMemory> TaskMemory::ReadMapped(
 
   vm_offset_t region;
   mach_msg_type_number_t region_count;
-  kern_return_t kr =
-      mach_vm_read(task_, region_address, region_size, &region, &region_count);
+  kern_return_t kr;
+  {
+    ScopedMemoryRead read(region_size);
+    kr = mach_vm_read(
+        task_, region_address, region_size, &region, &region_count);
+  }
   if (kr != KERN_SUCCESS) {
     MACH_LOG(WARNING, kr) << base::StringPrintf(
         "mach_vm_read(0x%llx, 0x%llx)", region_address, region_size);
@@ -103,6 +281,60 @@ std::unique_ptr<TaskMemory::MappedMemory> TaskMemory::ReadMapped(
       new MappedMemory(region, region_size, address - region_address, size));
 }
 
+std::unique_ptr<TaskMemory::MappedMemory> TaskMemory::ReadRemapped(
+    mach_vm_address_t address,
+    size_t size) {
+  if (size == 0) {
+    return std::unique_ptr<MappedMemory>(new MappedMemory(0, 0, 0, 0));
+  }
+
+  mach_vm_address_t region_address = mach_vm_trunc_page(address);
+  mach_vm_size_t region_size =
+      mach_vm_round_page(address - region_address + size);
+
+  mach_vm_address_t local_address = 0;
+  vm_prot_t current_protection;
+  vm_prot_t maximum_protection;
+  kern_return_t kr;
+  {
+    ScopedMemoryRead read(region_size);
+    kr = mach_vm_remap(mach_task_self(),
+                       &local_address,
+                       region_size,
+                       0,
+                       VM_FLAGS_ANYWHERE,
+                       task_,
+                       region_address,
+                       TRUE,
+                       &current_protection,
+                       &maximum_protection,
+                       VM_INHERIT_NONE);
+  }
+  if (kr != KERN_SUCCESS) {
+    MACH_LOG(WARNING, kr) << base::StringPrintf(
+        "mach_vm_remap(0x%llx, 0x%llx)", region_address, region_size);
+    return std::unique_ptr<MappedMemory>();
+  }
+
+  // The mapping’s protection is the most restrictive of the pages it spans, so
+  // an unreadable page anywhere makes it unreadable, just as it would make
+  // mach_vm_read() fail. The mapping is released on return in that case.
+  std::unique_ptr<MappedMemory> mapped(
+      new MappedMemory(static_cast<vm_address_t>(local_address),
+                       region_size,
+                       address - region_address,
+                       size));
+  if (!(current_protection & VM_PROT_READ)) {
+    LOG(WARNING) << base::StringPrintf(
+        "mach_vm_remap(0x%llx, 0x%llx): not readable",
+        region_address,
+        region_size);
+    return std::unique_ptr<MappedMemory>();
+  }
+
+  return mapped;
+}
+
 bool TaskMemory::ReadCString(mach_vm_address_t address, std::string* string) {
   return ReadCStringInternal(address, false, 0, string);
 }
@@ -127,20 +359,18 @@ bool TaskMemory::ReadCStringInternal(mach_vm_address_t address,
   }
 
   std::string local_string;
+  std::vector<char> read_region_data(PAGE_SIZE);
   mach_vm_address_t read_address = address;
   do {
     mach_vm_size_t read_length =
         std::min(size, PAGE_SIZE - (read_address % PAGE_SIZE));
-    std::unique_ptr<MappedMemory> read_region =
-        ReadMapped(read_address, read_length);
-    if (!read_region) {
+    if (!Read(read_address, read_length, &read_region_data[0])) {
       return false;
     }
 
-    const char* read_region_data =
-        reinterpret_cast<const char*>(read_region->data());
-    size_t read_region_data_length = strnlen(read_region_data, read_length);
-    local_string.append(read_region_data, read_region_data_length);
+    size_t read_region_data_length =
+        strnlen(&read_region_data[0], read_length);
+    local_string.append(&read_region_data[0], read_region_data_length);
     if (read_region_data_length < read_length) {
       string->swap(local_string);
       return true;
@@ -156,4 +386,177 @@ bool TaskMemory::ReadCStringInternal(mach_vm_address_t address,
   return false;
 }
 
+kern_return_t TaskMemory::ReadOverwrite(mach_vm_address_t address,
+                                        size_t size,
+                                        void* buffer) {
+  mach_vm_size_t size_read;
+  ScopedMemoryRead read(size);
+  kern_return_t kr =
+      mach_vm_read_overwrite(task_,
+                             address,
+                             size,
+                             reinterpret_cast<mach_vm_address_t>(buffer),
+                             &size_read);
+  if (kr == KERN_SUCCESS) {
+    DCHECK_EQ(size_read, size);
+  }
+  return kr;
+}
+
+bool TaskMemory::ReadCached(mach_vm_address_t address,
+                            size_t size,
+                            void* buffer) {
+  uint8_t* buffer_bytes = reinterpret_cast<uint8_t*>(buffer);
+  while (size > 0) {
+    const mach_vm_address_t page_address = mach_vm_trunc_page(address);
+    const size_t page_offset = address - page_address;
+    const size_t copy_size = std::min(size, PAGE_SIZE - page_offset);
+    if (!ReadCachedPage(page_address, page_offset, copy_size, buffer_bytes)) {
+      return false;
+    }
+
+    buffer_bytes += copy_size;
+    address += copy_size;
+    size -= copy_size;
+  }
+
+  return true;
+}
+
+bool TaskMemory::ReadCachedPage(mach_vm_address_t page_address,
+                                size_t offset,
+                                size_t size,
+                                uint8_t* buffer) {
+  const bool in_shared_region =
+      page_address - shared_region_address_ < shared_region_size_;
+  mach_vm_size_t page_count = 1;
+  bool share_pages = false;
+  {
+    base::AutoLock lock_owner(cache_lock_);
+
+    const auto cached = pages_.find(page_address);
+    if (cached != pages_.end()) {
+      memcpy(buffer, cached->second.get() + offset, size);
+      return true;
+    }
+
+    if (in_shared_region) {
+      std::unique_ptr<uint8_t[]> page(new uint8_t[PAGE_SIZE]);
+      if (SharedRegionPageCache::Get()->Lookup(
+              SharedRegionPageKey(page_address), page.get())) {
+        memcpy(buffer, page.get() + offset, size);
+        if (pages_.size() >= kMaxCachedPages) {
+          pages_.clear();
+        }
+        pages_[page_address] = std::move(page);
+        return true;
+      }
+    }
+
+    const Region* region = FindRegion(page_address);
+    if (!region || !(region->protection & VM_PROT_READ)) {
+      return false;
+    }
+
+    // Read ahead to the end of the region, stopping short of pages that are
+    // already cached.
+    while (page_count < kCacheReadAheadPages) {
+      const mach_vm_address_t next_page =
+          page_address + page_count * PAGE_SIZE;
+      if (next_page >= region->end || pages_.count(next_page)) {
+        break;
+      }
+      ++page_count;
+    }
+
+    // Writable pages may have been modified by the task, so only read-only
+    // pages are shared with other tasks.
+    share_pages = in_shared_region && !(region->protection & VM_PROT_WRITE);
+  }
+
+  // The lock isn’t held while copying out of the task, so that other threads
+  // can be served from the cache in the meantime. If another thread copies
+  // the same pages concurrently, whichever finishes last replaces the other’s
+  // identical copy.
+  std::vector<uint8_t> contents(page_count * PAGE_SIZE);
+  if (ReadOverwrite(page_address, contents.size(), &contents[0]) !=
+      KERN_SUCCESS) {
+    return false;
+  }
+  memcpy(buffer, &contents[offset], size);
+
+  base::AutoLock lock_owner(cache_lock_);
+
+  if (pages_.size() + page_count > kMaxCachedPages) {
+    pages_.clear();
+  }
+
+  for (mach_vm_size_t index = 0; index < page_count; ++index) {
+    const mach_vm_address_t address = page_address + index * PAGE_SIZE;
+    std::unique_ptr<uint8_t[]> page(new uint8_t[PAGE_SIZE]);
+    memcpy(page.get(), &contents[index * PAGE_SIZE], PAGE_SIZE);
+    if (share_pages &&
+        address - shared_region_address_ < shared_region_size_) {
+      SharedRegionPageCache::Get()->Insert(SharedRegionPageKey(address),
+                                           page.get());
+    }
+    pages_[address] = std::move(page);
+  }
+
+  return true;
+}
+
+std::tuple<std::string, mach_vm_size_t, mach_vm_address_t>
+TaskMemory::SharedRegionPageKey(mach_vm_address_t page_address) const {
+  return std::make_tuple(
+      shared_cache_uuid_.ToString(), shared_cache_slide_, page_address);
+}
+
+const TaskMemory::Region* TaskMemory::FindRegion(mach_vm_address_t address) {
+  auto cached = regions_.upper_bound(address);
+  if (cached != regions_.begin()) {
+    --cached;
+    if (address < cached->second.end) {
+      return &cached->second;
+    }
+  }
+
+  mach_vm_address_t region_address = address;
+  mach_vm_size_t region_size;
+  natural_t depth = 0;
+  vm_region_submap_short_info_64 submap_info;
+  while (true) {
+    mach_msg_type_number_t count = VM_REGION_SUBMAP_SHORT_INFO_COUNT_64;
+    kern_return_t kr = mach_vm_region_recurse(
+        task_,
+        &region_address,
+        &region_size,
+        &depth,
+        reinterpret_cast<vm_region_recurse_info_t>(&submap_info),
+        &count);
+    if (kr != KERN_SUCCESS) {
+      return nullptr;
+    }
+    if (!submap_info.is_submap) {
+      break;
+    }
+    ++depth;
+  }
+
+  // mach_vm_region_recurse() returns the first region at or beyond |address|.
+  // If |address| falls in a gap, record the gap so that it needn’t be queried
+  // again.
+  Region& region = regions_[region_address];
+  region = {region_address + region_size, submap_info.protection};
+
+  const mach_vm_address_t page_address = mach_vm_trunc_page(address);
+  if (region_address > page_address) {
+    Region& gap = regions_[page_address];
+    gap = {region_address, VM_PROT_NONE};
+    return &gap;
+  }
+
+  return &region;
+}
+
 }  // namespace crashpad
@@ -16,17 +16,27 @@
 #define CRASHPAD_UTIL_MACH_TASK_MEMORY_H_
 
 #include <mach/mach.h>
+#include <stdint.h>
 #include <sys/types.h>
 
+#include <map>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include "base/mac/scoped_mach_vm.h"
 #include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "util/misc/uuid.h"
 
 namespace crashpad {
 
 //! \brief Accesses the memory of another Mach task.
+//!
+//! Once EnableCache() and SetSharedRegion() have been called as needed, the
+//! reading methods of an object of this class may be called from several
+//! threads at once.
 class TaskMemory {
  public:
   //! \brief A memory region mapped from another Mach task.
@@ -87,11 +97,79 @@ class TaskMemory {
     DISALLOW_COPY_AND_ASSIGN(MappedMemory);
   };
 
+  //! \brief A single request to be serviced by ReadBatch().
+  struct ReadRequest {
+    //! \brief The address, in the target task’s address space, of the memory
+    //!     region to copy.
+    mach_vm_address_t address;
+
+    //! \brief The size, in bytes, of the memory region to copy.
+    size_t size;
+
+    //! \brief The buffer into which the memory will be copied, which must be
+    //!     at least \a size bytes.
+    void* buffer;
+
+    //! \brief Whether the memory was copied successfully, set by
+    //!     ReadBatch().
+    bool success;
+  };
+
   //! \param[in] task A send right to the target task’s task port. This object
   //!     does not take ownership of the send right.
   explicit TaskMemory(task_t task);
 
-  ~TaskMemory() {}
+  ~TaskMemory();
+
+  //! \brief Enables caching of memory copied from the target task.
+  //!
+  //! Once caching is enabled, small reads made by Read() and the
+  //! ReadCString*() methods are served from a cache of whole pages. When a read
+  //! misses the cache, several pages are copied at once, up to the end of the
+  //! VM region containing the read, as reported by `mach_vm_region_recurse()`.
+  //! The region metadata is cached as well, so reads of unmapped or unreadable
+  //! memory are rejected without needing to enter the kernel again.
+  //!
+  //! This should only be used when the target task’s memory can’t change while
+  //! this object exists, such as when the task is suspended. ReadMapped() is
+  //! not affected.
+  void EnableCache();
+
+  //! \brief Identifies the target task’s shared region, allowing its cached
+  //!     contents to be shared with other TaskMemory objects.
+  //!
+  //! Most of the images loaded in a task live in the dyld shared cache, mapped
+  //! into the task’s shared region. Tasks using the same shared cache at the
+  //! same slide map identical contents there, so the read-only pages that
+  //! hold those images’ headers, load commands, and symbol tables are cached
+  //! for the life of this process once any TaskMemory object has read them,
+  //! and are then available to every other TaskMemory object whose target
+  //! uses the same shared cache. A long-lived handler thus avoids copying
+  //! those pages out of every task that it takes a dump of.
+  //!
+  //! This has no effect unless EnableCache() has also been called.
+  //!
+  //! \param[in] shared_cache_uuid The UUID of the dyld shared cache mapped into
+  //!     the target task.
+  //! \param[in] shared_cache_slide The slide applied to the dyld shared cache
+  //!     in the target task.
+  //! \param[in] address The address of the target task’s shared region.
+  //! \param[in] size The size of the target task’s shared region.
+  void SetSharedRegion(const UUID& shared_cache_uuid,
+                       mach_vm_size_t shared_cache_slide,
+                       mach_vm_address_t address,
+                       mach_vm_size_t size);
+
+  //! \brief Services several Read() requests at once.
+  //!
+  //! The requests are sorted by address, and requests that are adjacent or
+  //! overlap in the target task are combined into a single copy, so that fewer
+  //! Mach traps are needed.
+  //!
+  //! \param[in,out] requests The requests to service. On return, the `success`
+  //!     field of each element is set as Read() would have returned for that
+  //!     request alone. A warning is logged for each request that fails.
+  void ReadBatch(std::vector<ReadRequest>* requests);
 
   //! \brief Copies memory from the target task into a caller-provided buffer in
   //!     the current task.
@@ -126,6 +204,26 @@ class TaskMemory {
   std::unique_ptr<MappedMemory> ReadMapped(mach_vm_address_t address,
                                            size_t size);
 
+  //! \brief Maps memory from the target task into the current task with
+  //!     copy-on-write semantics.
+  //!
+  //! This is like ReadMapped(), but uses `mach_vm_remap()`. The target task’s
+  //! pages are shared with the current task rather than copied. A page is
+  //! only copied if it’s written by either task while the mapping exists,
+  //! which makes this the cheapest way to get at large regions of memory.
+  //! ReadMapped() may be preferable for small regions, where the cost of
+  //! setting up and tearing down mappings dominates.
+  //!
+  //! \param[in] address The address, in the target task’s address space, of the
+  //!     memory region to map.
+  //! \param[in] size The size, in bytes, of the memory region to map.
+  //!
+  //! \return On success, a MappedMemory object that provides access to the data
+  //!     requested. On failure, `nullptr`, with a warning logged. Failures can
+  //!     occur, for example, when encountering unmapped or unreadable pages.
+  std::unique_ptr<MappedMemory> ReadRemapped(mach_vm_address_t address,
+                                             size_t size);
+
   //! \brief Reads a `NUL`-terminated C string from the target task into a
   //!     string in the current task.
   //!
@@ -163,13 +261,64 @@ class TaskMemory {
                               std::string* string);
 
  private:
+  // A VM region in the target task, as reported by mach_vm_region_recurse().
+  // Gaps between regions are recorded as regions with no access.
+  struct Region {
+    mach_vm_address_t end;
+    vm_prot_t protection;
+  };
+
+  // Copies memory from the target task with mach_vm_read_overwrite(), without
+  // logging failures.
+  kern_return_t ReadOverwrite(mach_vm_address_t address,
+                              size_t size,
+                              void* buffer);
+
+  // Serves a Read() from the page cache, returning false without logging if
+  // any of the memory is not readable.
+  bool ReadCached(mach_vm_address_t address, size_t size, void* buffer);
+
+  // Copies |size| bytes at |offset| into the page at |page_address| from the
+  // cache into |buffer|, first copying the page and the pages that follow it in
+  // the same region into the cache if necessary. Returns false if the page is
+  // not readable.
+  bool ReadCachedPage(mach_vm_address_t page_address,
+                      size_t offset,
+                      size_t size,
+                      uint8_t* buffer);
+
+  // Returns the key identifying the page at |page_address| in the target
+  // task’s shared region, for use with pages cached across tasks.
+  std::tuple<std::string, mach_vm_size_t, mach_vm_address_t>
+  SharedRegionPageKey(mach_vm_address_t page_address) const;
+
+  // Returns the region containing |address|, querying and caching it if
+  // necessary. Returns nullptr if there is no region at or beyond |address|.
+  // cache_lock_ must be held.
+  const Region* FindRegion(mach_vm_address_t address);
+
   // The common internal implementation shared by the ReadCString*() methods.
   bool ReadCStringInternal(mach_vm_address_t address,
                            bool has_size,
                            mach_vm_size_t size,
                            std::string* string);
 
+  // Cached page contents, keyed by page address, and cached regions, keyed by
+  // region address. Only used once EnableCache() has been called. Access to
+  // these fields must be guarded by cache_lock_.
+  std::map<mach_vm_address_t, std::unique_ptr<uint8_t[]>> pages_;
+  std::map<mach_vm_address_t, Region> regions_;
+  base::Lock cache_lock_;
+
+  // Identifies the target task’s shared region, as set by SetSharedRegion().
+  // shared_region_size_ is 0 if it has not been set.
+  UUID shared_cache_uuid_;
+  mach_vm_size_t shared_cache_slide_;
+  mach_vm_address_t shared_region_address_;
+  mach_vm_size_t shared_region_size_;
+
   task_t task_;  // weak
+  bool cache_enabled_;
 
   DISALLOW_COPY_AND_ASSIGN(TaskMemory);
 };
@@ -20,12 +20,15 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/mac/scoped_mach_port.h"
 #include "base/mac/scoped_mach_vm.h"
 #include "gtest/gtest.h"
 #include "test/mac/mach_errors.h"
 #include "util/misc/from_pointer_cast.h"
+#include "util/misc/uuid.h"
+#include "util/thread/thread.h"
 
 namespace crashpad {
 namespace test {
@@ -161,6 +164,268 @@ TEST(TaskMemory, ReadSelfUnmapped) {
   EXPECT_TRUE((mapped = memory.ReadMapped(address + PAGE_SIZE - 1, 1)));
 }
 
+TEST(TaskMemory, ReadRemappedSelf) {
+  vm_address_t address = 0;
+  constexpr vm_size_t kSize = 4 * PAGE_SIZE;
+  kern_return_t kr =
+      vm_allocate(mach_task_self(), &address, kSize, VM_FLAGS_ANYWHERE);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_allocate");
+  base::mac::ScopedMachVM vm_owner(address, mach_vm_round_page(kSize));
+
+  char* region = reinterpret_cast<char*>(address);
+  for (size_t index = 0; index < kSize; ++index) {
+    region[index] = (index % 256) ^ ((index >> 8) % 256);
+  }
+  const std::string original(region, kSize);
+
+  TaskMemory memory(mach_task_self());
+  std::unique_ptr<TaskMemory::MappedMemory> mapped;
+
+  ASSERT_TRUE((mapped = memory.ReadRemapped(address, kSize)));
+  EXPECT_NE(mapped->data(), region);
+  EXPECT_EQ(memcmp(region, mapped->data(), kSize), 0);
+
+  // The mapping is a copy: later changes to the original aren’t seen in it.
+  memset(region + PAGE_SIZE, 0, PAGE_SIZE);
+  EXPECT_EQ(memcmp(original.data(), mapped->data(), kSize), 0);
+
+  ASSERT_TRUE((mapped = memory.ReadRemapped(address + 1, kSize - 2)));
+  EXPECT_EQ(memcmp(region + 1, mapped->data(), kSize - 2), 0);
+
+  ASSERT_TRUE((mapped = memory.ReadRemapped(address + 2, 0)));
+
+  // An unreadable page anywhere in the range makes it unreadable.
+  kr = vm_protect(
+      mach_task_self(), address + PAGE_SIZE, PAGE_SIZE, FALSE, VM_PROT_NONE);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_protect");
+  EXPECT_FALSE((mapped = memory.ReadRemapped(address, kSize)));
+  EXPECT_FALSE((mapped = memory.ReadRemapped(address + PAGE_SIZE - 1, 2)));
+  EXPECT_TRUE((mapped = memory.ReadRemapped(address, PAGE_SIZE)));
+  EXPECT_TRUE((mapped = memory.ReadRemapped(address + 2 * PAGE_SIZE, 1)));
+}
+
+TEST(TaskMemory, ReadSelfCached) {
+  vm_address_t address = 0;
+  constexpr vm_size_t kSize = 4 * PAGE_SIZE;
+  kern_return_t kr =
+      vm_allocate(mach_task_self(), &address, kSize, VM_FLAGS_ANYWHERE);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_allocate");
+  base::mac::ScopedMachVM vm_owner(address, mach_vm_round_page(kSize));
+
+  char* region = reinterpret_cast<char*>(address);
+  for (size_t index = 0; index < kSize; ++index) {
+    region[index] = (index % 255) + 1;
+  }
+  region[kSize - 1] = '\0';
+
+  kr = vm_protect(mach_task_self(),
+                  address + 2 * PAGE_SIZE,
+                  PAGE_SIZE,
+                  FALSE,
+                  VM_PROT_NONE);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_protect");
+
+  TaskMemory memory(mach_task_self());
+  memory.EnableCache();
+  std::string result(kSize, '\0');
+
+  ASSERT_TRUE(memory.Read(address, 2 * PAGE_SIZE, &result[0]));
+  EXPECT_EQ(memcmp(region, &result[0], 2 * PAGE_SIZE), 0);
+  ASSERT_TRUE(memory.Read(address + PAGE_SIZE - 1, 2, &result[0]));
+  EXPECT_EQ(memcmp(region + PAGE_SIZE - 1, &result[0], 2), 0);
+
+  // Once cached, memory is served from the cache even after it changes.
+  const char original = region[1];
+  region[1] = original + 1;
+  ASSERT_TRUE(memory.Read(address + 1, 1, &result[0]));
+  EXPECT_EQ(result[0], original);
+
+  // Reads that touch the unreadable page fail, whether or not they also touch
+  // cached pages.
+  EXPECT_FALSE(memory.Read(address + 2 * PAGE_SIZE, 1, &result[0]));
+  EXPECT_FALSE(memory.Read(address + 2 * PAGE_SIZE - 1, 2, &result[0]));
+  EXPECT_FALSE(memory.Read(address, kSize, &result[0]));
+
+  // The page beyond the unreadable one is readable.
+  std::string string;
+  ASSERT_TRUE(memory.ReadCString(address + 3 * PAGE_SIZE, &string));
+  EXPECT_EQ(string, std::string(region + 3 * PAGE_SIZE));
+}
+
+class CachedReaderThread final : public Thread {
+ public:
+  CachedReaderThread(TaskMemory* memory, const char* region, size_t size)
+      : Thread(), memory_(memory), region_(region), size_(size) {}
+  ~CachedReaderThread() override {}
+
+  bool success() const { return success_; }
+
+ private:
+  // Thread:
+  void ThreadMain() override {
+    std::string result(size_, '\0');
+    for (size_t offset = 0; offset < size_; offset += 7) {
+      const size_t read_size = std::min(size_t{13}, size_ - offset);
+      if (!memory_->Read(FromPointerCast<mach_vm_address_t>(region_ + offset),
+                         read_size,
+                         &result[0]) ||
+          memcmp(region_ + offset, &result[0], read_size) != 0) {
+        success_ = false;
+        return;
+      }
+    }
+  }
+
+  TaskMemory* memory_;  // weak
+  const char* region_;  // weak
+  size_t size_;
+  bool success_ = true;
+
+  DISALLOW_COPY_AND_ASSIGN(CachedReaderThread);
+};
+
+TEST(TaskMemory, ReadSelfCachedThreads) {
+  vm_address_t address = 0;
+  constexpr vm_size_t kSize = 64 * PAGE_SIZE;
+  kern_return_t kr =
+      vm_allocate(mach_task_self(), &address, kSize, VM_FLAGS_ANYWHERE);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_allocate");
+  base::mac::ScopedMachVM vm_owner(address, mach_vm_round_page(kSize));
+
+  char* region = reinterpret_cast<char*>(address);
+  for (size_t index = 0; index < kSize; ++index) {
+    region[index] = (index % 256) ^ ((index >> 8) % 256);
+  }
+
+  TaskMemory memory(mach_task_self());
+  memory.EnableCache();
+
+  CachedReaderThread threads[] = {
+      {&memory, region, kSize},
+      {&memory, region, kSize},
+      {&memory, region, kSize},
+      {&memory, region, kSize},
+  };
+  for (CachedReaderThread& thread : threads) {
+    thread.Start();
+  }
+  for (CachedReaderThread& thread : threads) {
+    thread.Join();
+    EXPECT_TRUE(thread.success());
+  }
+}
+
+TEST(TaskMemory, ReadSelfSharedRegion) {
+  vm_address_t address = 0;
+  constexpr vm_size_t kSize = 2 * PAGE_SIZE;
+  kern_return_t kr =
+      vm_allocate(mach_task_self(), &address, kSize, VM_FLAGS_ANYWHERE);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_allocate");
+  base::mac::ScopedMachVM vm_owner(address, mach_vm_round_page(kSize));
+
+  char* region = reinterpret_cast<char*>(address);
+  region[0] = 'a';
+  region[PAGE_SIZE] = 'b';
+
+  // Only the first page is read-only, so only it is shared.
+  kr = vm_protect(mach_task_self(), address, PAGE_SIZE, FALSE, VM_PROT_READ);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_protect");
+
+  UUID uuid;
+  ASSERT_TRUE(uuid.InitializeWithNew());
+
+  char result;
+  {
+    TaskMemory memory(mach_task_self());
+    memory.EnableCache();
+    memory.SetSharedRegion(uuid, 0, address, kSize);
+    ASSERT_TRUE(memory.Read(address, 1, &result));
+    EXPECT_EQ(result, 'a');
+    ASSERT_TRUE(memory.Read(address + PAGE_SIZE, 1, &result));
+    EXPECT_EQ(result, 'b');
+  }
+
+  kr = vm_protect(mach_task_self(),
+                  address,
+                  PAGE_SIZE,
+                  FALSE,
+                  VM_PROT_READ | VM_PROT_WRITE);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_protect");
+  region[0] = 'c';
+  region[PAGE_SIZE] = 'd';
+  kr = vm_protect(mach_task_self(), address, PAGE_SIZE, FALSE, VM_PROT_READ);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_protect");
+
+  // Another object reading the same shared region sees the read-only page as
+  // it was first read, and reads the writable page afresh.
+  {
+    TaskMemory memory(mach_task_self());
+    memory.EnableCache();
+    memory.SetSharedRegion(uuid, 0, address, kSize);
+    ASSERT_TRUE(memory.Read(address, 1, &result));
+    EXPECT_EQ(result, 'a');
+    ASSERT_TRUE(memory.Read(address + PAGE_SIZE, 1, &result));
+    EXPECT_EQ(result, 'd');
+  }
+
+  // A different shared cache, or the same one at a different slide, doesn’t
+  // share the page.
+  {
+    TaskMemory memory(mach_task_self());
+    memory.EnableCache();
+    memory.SetSharedRegion(uuid, PAGE_SIZE, address, kSize);
+    ASSERT_TRUE(memory.Read(address, 1, &result));
+    EXPECT_EQ(result, 'c');
+  }
+}
+
+TEST(TaskMemory, ReadBatchSelf) {
+  vm_address_t address = 0;
+  constexpr vm_size_t kSize = 4 * PAGE_SIZE;
+  kern_return_t kr =
+      vm_allocate(mach_task_self(), &address, kSize, VM_FLAGS_ANYWHERE);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_allocate");
+  base::mac::ScopedMachVM vm_owner(address, mach_vm_round_page(kSize));
+
+  char* region = reinterpret_cast<char*>(address);
+  for (size_t index = 0; index < kSize; ++index) {
+    region[index] = (index % 256) ^ ((index >> 8) % 256);
+  }
+
+  kr = vm_protect(
+      mach_task_self(), address + PAGE_SIZE, PAGE_SIZE, FALSE, VM_PROT_NONE);
+  ASSERT_EQ(kr, KERN_SUCCESS) << MachErrorMessage(kr, "vm_protect");
+
+  TaskMemory memory(mach_task_self());
+
+  // The requests are out of order. Some are adjacent to or overlap others, one
+  // touches the unreadable page, and one is empty.
+  std::string results[6];
+  for (std::string& result : results) {
+    result.assign(64, '\0');
+  }
+  std::vector<TaskMemory::ReadRequest> requests = {
+      {address + 3 * PAGE_SIZE + 16, 16, &results[0][0], false},
+      {address + 8, 8, &results[1][0], false},
+      {address, 16, &results[2][0], false},
+      {address + 12, 32, &results[3][0], false},
+      {address + PAGE_SIZE - 8, 16, &results[4][0], false},
+      {address + 3 * PAGE_SIZE, 0, &results[5][0], false},
+  };
+  memory.ReadBatch(&requests);
+
+  EXPECT_TRUE(requests[0].success);
+  EXPECT_EQ(memcmp(region + 3 * PAGE_SIZE + 16, &results[0][0], 16), 0);
+  EXPECT_TRUE(requests[1].success);
+  EXPECT_EQ(memcmp(region + 8, &results[1][0], 8), 0);
+  EXPECT_TRUE(requests[2].success);
+  EXPECT_EQ(memcmp(region, &results[2][0], 16), 0);
+  EXPECT_TRUE(requests[3].success);
+  EXPECT_EQ(memcmp(region + 12, &results[3][0], 32), 0);
+  EXPECT_FALSE(requests[4].success);
+  EXPECT_TRUE(requests[5].success);
+}
+
 // This function consolidates the cast from a char* to mach_vm_address_t in one
 // location when reading from the current task.
 bool ReadCStringSelf(TaskMemory* memory,
@@ -0,0 +1,119 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "util/misc/memory_read_trace.h"
+
+#include "base/logging.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace crashpad {
+
+namespace {
+
+class CurrentSiteSlot {
+ public:
+  static CurrentSiteSlot* GetInstance() {
+    static auto slot = new CurrentSiteSlot();
+    return slot;
+  }
+
+  // The site is stored in the slot’s pointer-sized value. An unset slot reads
+  // as kOther.
+  MemoryReadSite Get() {
+    return static_cast<MemoryReadSite>(
+        reinterpret_cast<uintptr_t>(tls_.Get()));
+  }
+
+  void Set(MemoryReadSite site) {
+    tls_.Set(reinterpret_cast<void*>(static_cast<uintptr_t>(site)));
+  }
+
+ private:
+  CurrentSiteSlot() {
+    DCHECK(!tls_.initialized());
+    tls_.Initialize(nullptr);
+    DCHECK(tls_.initialized());
+  }
+
+  ~CurrentSiteSlot() = delete;
+
+  static base::ThreadLocalStorage::StaticSlot tls_;
+
+  DISALLOW_COPY_AND_ASSIGN(CurrentSiteSlot);
+};
+
+// static
+base::ThreadLocalStorage::StaticSlot CurrentSiteSlot::tls_ = TLS_INITIALIZER;
+
+}  // namespace
+
+// static
+std::atomic<MemoryReadTrace*> MemoryReadTrace::installed_(nullptr);
+
+MemoryReadTrace::MemoryReadTrace() : counts_() {}
+
+MemoryReadTrace::~MemoryReadTrace() {
+  DCHECK_NE(installed_.load(std::memory_order_relaxed), this);
+}
+
+void MemoryReadTrace::Record(MemoryReadSite site,
+                             uint64_t bytes,
+                             uint64_t nanoseconds) {
+  DCHECK_LT(static_cast<size_t>(site),
+            static_cast<size_t>(MemoryReadSite::kCount));
+  AtomicCounts& counts = counts_[static_cast<size_t>(site)];
+  counts.calls.fetch_add(1, std::memory_order_relaxed);
+  counts.bytes.fetch_add(bytes, std::memory_order_relaxed);
+  counts.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+MemoryReadTrace::Counts MemoryReadTrace::CountsForSite(
+    MemoryReadSite site) const {
+  DCHECK_LT(static_cast<size_t>(site),
+            static_cast<size_t>(MemoryReadSite::kCount));
+  const AtomicCounts& counts = counts_[static_cast<size_t>(site)];
+  Counts result;
+  result.calls = counts.calls.load(std::memory_order_relaxed);
+  result.bytes = counts.bytes.load(std::memory_order_relaxed);
+  result.nanoseconds = counts.nanoseconds.load(std::memory_order_relaxed);
+  return result;
+}
+
+ScopedMemoryReadTrace::ScopedMemoryReadTrace(MemoryReadTrace* trace)
+    : trace_(trace) {
+  MemoryReadTrace* previous =
+      MemoryReadTrace::installed_.exchange(trace_, std::memory_order_acq_rel);
+  DCHECK(!previous);
+}
+
+ScopedMemoryReadTrace::~ScopedMemoryReadTrace() {
+  MemoryReadTrace* previous = MemoryReadTrace::installed_.exchange(
+      nullptr, std::memory_order_acq_rel);
+  DCHECK_EQ(previous, trace_);
+}
+
+ScopedMemoryReadSite::ScopedMemoryReadSite(MemoryReadSite site)
+    : previous_(CurrentSiteSlot::GetInstance()->Get()) {
+  CurrentSiteSlot::GetInstance()->Set(site);
+}
+
+ScopedMemoryReadSite::~ScopedMemoryReadSite() {
+  CurrentSiteSlot::GetInstance()->Set(previous_);
+}
+
+// static
+MemoryReadSite ScopedMemoryReadSite::Current() {
+  return CurrentSiteSlot::GetInstance()->Get();
+}
+
+}  // namespace crashpad
@@ -0,0 +1,179 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef CRASHPAD_UTIL_MISC_MEMORY_READ_TRACE_H_
+#define CRASHPAD_UTIL_MISC_MEMORY_READ_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "base/macros.h"
+#include "util/misc/clock.h"
+
+namespace crashpad {
+
+//! \brief The purposes for which another process’ memory is read.
+//!
+//! A MemoryReadTrace attributes each read it counts to one of these, as set
+//! on the reading thread by the innermost ScopedMemoryReadSite.
+enum class MemoryReadSite : uint8_t {
+  //! \brief A read made outside of any ScopedMemoryReadSite.
+  kOther = 0,
+
+  //! \brief Reads of module headers, load commands, and debug information.
+  kModules,
+
+  //! \brief Reads of CrashpadInfo structures and the annotations they refer
+  //!     to.
+  kAnnotations,
+
+  //! \brief Reads of thread stacks.
+  kStacks,
+
+  //! \brief Reads of memory referenced from thread contexts and stacks.
+  kIndirectMemory,
+
+  //! \brief Reads of process-wide data, such as the process environment
+  //!     block.
+  kProcessData,
+
+  //! \brief The number of sites. This is not a valid site.
+  kCount,
+};
+
+//! \brief Counts the reads of another process’ memory, by MemoryReadSite.
+//!
+//! The readers of another process’ memory, ProcessMemory, TaskMemory, and
+//! ProcessReaderWin, record each system call that copies memory with a
+//! ScopedMemoryRead. Reads are counted only while a trace is installed by
+//! ScopedMemoryReadTrace. Otherwise, recording a read costs a single atomic
+//! load.
+//!
+//! An installed trace counts the reads made by every thread in the process,
+//! so only one may be installed at a time. This class is thread-safe.
+class MemoryReadTrace {
+ public:
+  //! \brief The reads counted for a MemoryReadSite.
+  struct Counts {
+    //! \brief The number of reads.
+    uint64_t calls;
+
+    //! \brief The number of bytes requested by the reads.
+    uint64_t bytes;
+
+    //! \brief The time spent in the reads, in nanoseconds.
+    uint64_t nanoseconds;
+  };
+
+  MemoryReadTrace();
+  ~MemoryReadTrace();
+
+  //! \brief Returns the installed trace, or `nullptr` if none is installed.
+  static MemoryReadTrace* Installed() {
+    return installed_.load(std::memory_order_acquire);
+  }
+
+  //! \brief Counts a read attributed to \a site.
+  //!
+  //! \param[in] site The site that made the read.
+  //! \param[in] bytes The number of bytes requested.
+  //! \param[in] nanoseconds The time spent in the read.
+  void Record(MemoryReadSite site, uint64_t bytes, uint64_t nanoseconds);
+
+  //! \brief Returns the reads counted for \a site so far.
+  Counts CountsForSite(MemoryReadSite site) const;
+
+ private:
+  friend class ScopedMemoryReadTrace;
+
+  struct AtomicCounts {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> nanoseconds;
+  };
+
+  AtomicCounts counts_[static_cast<size_t>(MemoryReadSite::kCount)];
+
+  static std::atomic<MemoryReadTrace*> installed_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryReadTrace);
+};
+
+//! \brief Installs a MemoryReadTrace for the lifetime of the object.
+class ScopedMemoryReadTrace {
+ public:
+  //! \param[in] trace The trace to install. No other trace may be installed.
+  //!     This object does not take ownership of \a trace, which must outlive
+  //!     it.
+  explicit ScopedMemoryReadTrace(MemoryReadTrace* trace);
+  ~ScopedMemoryReadTrace();
+
+ private:
+  MemoryReadTrace* trace_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedMemoryReadTrace);
+};
+
+//! \brief Attributes the reads made by the current thread to a
+//!     MemoryReadSite for the lifetime of the object.
+//!
+//! Scopes nest. The site in effect before construction is restored on
+//! destruction.
+class ScopedMemoryReadSite {
+ public:
+  explicit ScopedMemoryReadSite(MemoryReadSite site);
+  ~ScopedMemoryReadSite();
+
+  //! \brief Returns the site in effect on the current thread.
+  static MemoryReadSite Current();
+
+ private:
+  MemoryReadSite previous_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedMemoryReadSite);
+};
+
+//! \brief Records a single read of another process’ memory to the installed
+//!     MemoryReadTrace, if any.
+//!
+//! Construct one immediately before the system call that copies memory, in a
+//! scope that ends immediately after it.
+class ScopedMemoryRead {
+ public:
+  //! \param[in] bytes The number of bytes requested.
+  explicit ScopedMemoryRead(size_t bytes)
+      : trace_(MemoryReadTrace::Installed()),
+        bytes_(bytes),
+        start_time_(trace_ ? ClockMonotonicNanoseconds() : 0) {}
+
+  ~ScopedMemoryRead() {
+    if (trace_) {
+      trace_->Record(ScopedMemoryReadSite::Current(),
+                     bytes_,
+                     ClockMonotonicNanoseconds() - start_time_);
+    }
+  }
+
+ private:
+  MemoryReadTrace* trace_;  // weak
+  uint64_t bytes_;
+  uint64_t start_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedMemoryRead);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_MISC_MEMORY_READ_TRACE_H_
@@ -0,0 +1,115 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "util/misc/memory_read_trace.h"
+
+#include "gtest/gtest.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+void RecordRead(size_t size) {
+  ScopedMemoryRead read(size);
+}
+
+TEST(MemoryReadTrace, NotInstalled) {
+  EXPECT_FALSE(MemoryReadTrace::Installed());
+
+  MemoryReadTrace trace;
+  RecordRead(16);
+
+  MemoryReadTrace::Counts counts = trace.CountsForSite(MemoryReadSite::kOther);
+  EXPECT_EQ(counts.calls, 0u);
+  EXPECT_EQ(counts.bytes, 0u);
+  EXPECT_EQ(counts.nanoseconds, 0u);
+}
+
+TEST(MemoryReadTrace, Sites) {
+  MemoryReadTrace trace;
+  {
+    ScopedMemoryReadTrace installed(&trace);
+    EXPECT_EQ(MemoryReadTrace::Installed(), &trace);
+
+    RecordRead(1);
+    {
+      ScopedMemoryReadSite modules(MemoryReadSite::kModules);
+      EXPECT_EQ(ScopedMemoryReadSite::Current(), MemoryReadSite::kModules);
+      RecordRead(2);
+      {
+        ScopedMemoryReadSite stacks(MemoryReadSite::kStacks);
+        RecordRead(4);
+        RecordRead(8);
+      }
+      RecordRead(16);
+    }
+    EXPECT_EQ(ScopedMemoryReadSite::Current(), MemoryReadSite::kOther);
+  }
+  EXPECT_FALSE(MemoryReadTrace::Installed());
+  RecordRead(32);
+
+  MemoryReadTrace::Counts counts = trace.CountsForSite(MemoryReadSite::kOther);
+  EXPECT_EQ(counts.calls, 1u);
+  EXPECT_EQ(counts.bytes, 1u);
+
+  counts = trace.CountsForSite(MemoryReadSite::kModules);
+  EXPECT_EQ(counts.calls, 2u);
+  EXPECT_EQ(counts.bytes, 18u);
+
+  counts = trace.CountsForSite(MemoryReadSite::kStacks);
+  EXPECT_EQ(counts.calls, 2u);
+  EXPECT_EQ(counts.bytes, 12u);
+
+  counts = trace.CountsForSite(MemoryReadSite::kAnnotations);
+  EXPECT_EQ(counts.calls, 0u);
+  EXPECT_EQ(counts.bytes, 0u);
+}
+
+class ReadingThread : public Thread {
+ public:
+  ReadingThread() : Thread() {}
+  ~ReadingThread() override {}
+
+ private:
+  void ThreadMain() override {
+    // The site is per-thread, so this thread starts out at kOther.
+    EXPECT_EQ(ScopedMemoryReadSite::Current(), MemoryReadSite::kOther);
+    ScopedMemoryReadSite site(MemoryReadSite::kIndirectMemory);
+    RecordRead(64);
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(ReadingThread);
+};
+
+TEST(MemoryReadTrace, Threads) {
+  MemoryReadTrace trace;
+  ScopedMemoryReadTrace installed(&trace);
+  ScopedMemoryReadSite site(MemoryReadSite::kStacks);
+
+  ReadingThread thread;
+  thread.Start();
+  thread.Join();
+
+  EXPECT_EQ(ScopedMemoryReadSite::Current(), MemoryReadSite::kStacks);
+
+  MemoryReadTrace::Counts counts =
+      trace.CountsForSite(MemoryReadSite::kIndirectMemory);
+  EXPECT_EQ(counts.calls, 1u);
+  EXPECT_EQ(counts.bytes, 64u);
+  EXPECT_EQ(trace.CountsForSite(MemoryReadSite::kStacks).calls, 0u);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
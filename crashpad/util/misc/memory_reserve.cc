@@ -0,0 +1,148 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/memory_reserve.h"
+
+#include <atomic>
+#include <new>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+namespace {
+
+std::atomic<MemoryReserve*> g_installed_reserve;
+
+}  // namespace
+
+MemoryReserve::MemoryReserve()
+    : lock_(),
+      chunks_(),
+      chunk_count_(0),
+      released_count_(0),
+      lock_chunks_(false),
+      installed_(false) {}
+
+MemoryReserve::~MemoryReserve() {
+  if (installed_) {
+    std::set_new_handler(nullptr);
+    g_installed_reserve = nullptr;
+  }
+  for (void* chunk : chunks_) {
+    UnmapChunk(chunk);
+  }
+}
+
+bool MemoryReserve::Initialize(size_t size, bool lock) {
+  {
+    base::AutoLock auto_lock(lock_);
+    DCHECK_EQ(chunk_count_, 0u);
+
+    lock_chunks_ = lock;
+    chunk_count_ = (size + kChunkSize - 1) / kChunkSize;
+
+    // The vector’s storage is reserved now, so that releasing and replenishing
+    // chunks never allocates.
+    chunks_.reserve(chunk_count_);
+  }
+
+  return Replenish();
+}
+
+void MemoryReserve::InstallNewHandler() {
+  MemoryReserve* expected = nullptr;
+  CHECK(g_installed_reserve.compare_exchange_strong(expected, this));
+  installed_ = true;
+  std::set_new_handler(NewHandler);
+}
+
+bool MemoryReserve::ReleaseChunk() {
+  base::AutoLock auto_lock(lock_);
+  if (chunks_.empty()) {
+    return false;
+  }
+  UnmapChunk(chunks_.back());
+  chunks_.pop_back();
+  ++released_count_;
+  return true;
+}
+
+bool MemoryReserve::Replenish() {
+  uint64_t released_count;
+  {
+    base::AutoLock auto_lock(lock_);
+    released_count = released_count_;
+    released_count_ = 0;
+  }
+
+  // Chunks are mapped without holding lock_, because a message logged on
+  // failure may allocate, and the new handler takes lock_ if that fails.
+  bool whole = true;
+  for (;;) {
+    {
+      base::AutoLock auto_lock(lock_);
+      if (chunks_.size() >= chunk_count_) {
+        break;
+      }
+    }
+
+    void* chunk = MapChunk(lock_chunks_);
+    if (!chunk) {
+      whole = false;
+      break;
+    }
+
+    bool kept = false;
+    {
+      base::AutoLock auto_lock(lock_);
+      if (chunks_.size() < chunk_count_) {
+        chunks_.push_back(chunk);
+        kept = true;
+      }
+    }
+    if (!kept) {
+      // Another thread replenished the reserve in the meantime.
+      UnmapChunk(chunk);
+      break;
+    }
+  }
+
+  // The reserve may have been used up, and the handler uninstalled, by the
+  // allocation that failed last.
+  if (installed_ && whole) {
+    std::set_new_handler(NewHandler);
+  }
+
+  LOG_IF(WARNING, released_count)
+      << released_count << " chunks of the memory reserve were used";
+  return whole;
+}
+
+size_t MemoryReserve::reserved_size() {
+  base::AutoLock auto_lock(lock_);
+  return chunks_.size() * kChunkSize;
+}
+
+// static
+void MemoryReserve::NewHandler() {
+  // operator new retries the allocation once this returns. Without a chunk to
+  // release, the handler is removed, so that the allocation fails.
+  MemoryReserve* reserve = g_installed_reserve;
+  if (!reserve || !reserve->ReleaseChunk()) {
+    std::set_new_handler(nullptr);
+  }
+}
+
+}  // namespace crashpad
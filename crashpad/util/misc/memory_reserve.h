@@ -0,0 +1,120 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_MISC_MEMORY_RESERVE_H_
+#define CRASHPAD_UTIL_MISC_MEMORY_RESERVE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+
+namespace crashpad {
+
+//! \brief Memory set aside while memory is plentiful, to be given back to the
+//!     system once the process can no longer allocate.
+//!
+//! Many crashes are caused by running out of memory, and the handler must
+//! then allocate to capture and write the report while the system is still
+//! short. The reserve is mapped in chunks of #kChunkSize, each of which is
+//! touched in full, so that it is backed by physical memory, and optionally
+//! locked there. Once installed by InstallNewHandler(), each failure of
+//! `operator new` releases a chunk and retries the allocation, so the
+//! allocation is satisfied from the memory that the chunk gave back. Once the
+//! reserve has been used up, allocation fails as it would without it.
+//!
+//! Chunks are returned to the system rather than allocated from directly, so
+//! that objects throughout the capture path, from snapshot vectors to minidump
+//! writers and I/O buffers, benefit without being written against a special
+//! allocator. Replenish() maps released chunks again, and is best called once
+//! the process has been idle for a while.
+//!
+//! This class is thread-safe.
+class MemoryReserve {
+ public:
+  //! \brief The size of each chunk of the reserve, released one at a time.
+  static constexpr size_t kChunkSize = 1024 * 1024;
+
+  MemoryReserve();
+
+  //! \brief Releases the reserve, and uninstalls the new handler if it was
+  //!     installed by this object.
+  ~MemoryReserve();
+
+  //! \brief Maps the reserve.
+  //!
+  //! \param[in] size The size of the reserve, which is rounded up to a
+  //!     multiple of #kChunkSize.
+  //! \param[in] lock Whether to lock the reserve in physical memory, so that
+  //!     it isn’t paged out while the system is short of memory. Failure to
+  //!     lock it is logged, but leaves the reserve usable.
+  //!
+  //! \return `true` if the whole reserve was mapped. `false`, with a message
+  //!     logged, if it wasn’t. The part of the reserve that was mapped is
+  //!     kept.
+  bool Initialize(size_t size, bool lock);
+
+  //! \brief Installs a `new` handler that releases this reserve a chunk at a
+  //!     time when allocation fails.
+  //!
+  //! At most one MemoryReserve may be installed at a time.
+  void InstallNewHandler();
+
+  //! \brief Releases one chunk of the reserve to the system.
+  //!
+  //! This doesn’t allocate or log, so that it’s safe to call once allocation
+  //! has failed.
+  //!
+  //! \return `true` if a chunk was released, or `false` if none remained.
+  bool ReleaseChunk();
+
+  //! \brief Maps the chunks that have been released again.
+  //!
+  //! \return `true` if the reserve is whole, or `false` with a message logged
+  //!     if chunks couldn’t be mapped.
+  bool Replenish();
+
+  //! \return The number of bytes currently held in the reserve.
+  size_t reserved_size();
+
+ private:
+  //! \brief Maps, touches, and, if \a lock, locks a chunk of #kChunkSize
+  //!     bytes. This is implemented separately for each platform.
+  //!
+  //! \return The chunk, or `nullptr` with a message logged on failure.
+  static void* MapChunk(bool lock);
+
+  //! \brief Unmaps a chunk returned by MapChunk(), without logging. This is
+  //!     implemented separately for each platform.
+  static void UnmapChunk(void* chunk);
+
+  //! \brief The function installed by InstallNewHandler().
+  static void NewHandler();
+
+  base::Lock lock_;
+  std::vector<void*> chunks_;
+  size_t chunk_count_;
+  uint64_t released_count_;
+  bool lock_chunks_;
+  bool installed_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryReserve);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_MISC_MEMORY_RESERVE_H_
@@ -0,0 +1,53 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/memory_reserve.h"
+
+#include <string.h>
+#include <sys/mman.h>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+// static
+void* MemoryReserve::MapChunk(bool lock) {
+  void* chunk = mmap(nullptr,
+                     kChunkSize,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1,
+                     0);
+  if (chunk == MAP_FAILED) {
+    PLOG(ERROR) << "mmap";
+    return nullptr;
+  }
+
+  // Writing to every page gives each its own physical memory, which a page
+  // that has only been mapped, or only read, doesn’t have.
+  memset(chunk, 0xff, kChunkSize);
+
+  if (lock && mlock(chunk, kChunkSize) != 0) {
+    PLOG(WARNING) << "mlock";
+  }
+  return chunk;
+}
+
+// static
+void MemoryReserve::UnmapChunk(void* chunk) {
+  // This also unlocks the chunk. It can only fail for an invalid range.
+  munmap(chunk, kChunkSize);
+}
+
+}  // namespace crashpad
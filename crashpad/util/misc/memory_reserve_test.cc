@@ -0,0 +1,76 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/memory_reserve.h"
+
+#include <new>
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(MemoryReserve, ReleaseAndReplenish) {
+  MemoryReserve reserve;
+  EXPECT_EQ(reserve.reserved_size(), 0u);
+  EXPECT_FALSE(reserve.ReleaseChunk());
+
+  // The size is rounded up to whole chunks.
+  ASSERT_TRUE(reserve.Initialize(MemoryReserve::kChunkSize + 1, false));
+  EXPECT_EQ(reserve.reserved_size(), 2 * MemoryReserve::kChunkSize);
+
+  EXPECT_TRUE(reserve.ReleaseChunk());
+  EXPECT_EQ(reserve.reserved_size(), MemoryReserve::kChunkSize);
+  EXPECT_TRUE(reserve.ReleaseChunk());
+  EXPECT_EQ(reserve.reserved_size(), 0u);
+  EXPECT_FALSE(reserve.ReleaseChunk());
+
+  EXPECT_TRUE(reserve.Replenish());
+  EXPECT_EQ(reserve.reserved_size(), 2 * MemoryReserve::kChunkSize);
+}
+
+TEST(MemoryReserve, Locked) {
+  // Locking may be refused for want of privilege, which is only logged.
+  MemoryReserve reserve;
+  ASSERT_TRUE(reserve.Initialize(MemoryReserve::kChunkSize, true));
+  EXPECT_EQ(reserve.reserved_size(), MemoryReserve::kChunkSize);
+}
+
+TEST(MemoryReserve, NewHandler) {
+  MemoryReserve reserve;
+  ASSERT_TRUE(reserve.Initialize(2 * MemoryReserve::kChunkSize, false));
+  reserve.InstallNewHandler();
+
+  // Each time the handler is called, as operator new does when allocation
+  // fails, a chunk is released, until there are none left and the handler
+  // removes itself.
+  std::new_handler handler = std::get_new_handler();
+  ASSERT_TRUE(handler);
+  handler();
+  EXPECT_EQ(reserve.reserved_size(), MemoryReserve::kChunkSize);
+  handler();
+  EXPECT_EQ(reserve.reserved_size(), 0u);
+  EXPECT_EQ(std::get_new_handler(), handler);
+  handler();
+  EXPECT_FALSE(std::get_new_handler());
+
+  // Replenishing the reserve installs the handler again.
+  EXPECT_TRUE(reserve.Replenish());
+  EXPECT_EQ(std::get_new_handler(), handler);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
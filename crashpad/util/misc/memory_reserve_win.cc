@@ -0,0 +1,51 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/memory_reserve.h"
+
+#include <string.h>
+#include <windows.h>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+// static
+void* MemoryReserve::MapChunk(bool lock) {
+  void* chunk = VirtualAlloc(
+      nullptr, kChunkSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  if (!chunk) {
+    PLOG(ERROR) << "VirtualAlloc";
+    return nullptr;
+  }
+
+  // Committing charges the chunk against the commit limit, and writing to
+  // every page brings it into the working set.
+  memset(chunk, 0xff, kChunkSize);
+
+  // A process may only lock as much as its minimum working set size, so a
+  // large reserve may need SetProcessWorkingSetSize() first.
+  if (lock && !VirtualLock(chunk, kChunkSize)) {
+    PLOG(WARNING) << "VirtualLock";
+  }
+  return chunk;
+}
+
+// static
+void MemoryReserve::UnmapChunk(void* chunk) {
+  // This also unlocks the chunk.
+  VirtualFree(chunk, 0, MEM_RELEASE);
+}
+
+}  // namespace crashpad
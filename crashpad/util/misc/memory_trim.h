@@ -0,0 +1,31 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_MISC_MEMORY_TRIM_H_
+#define CRASHPAD_UTIL_MISC_MEMORY_TRIM_H_
+
+namespace crashpad {
+
+//! \brief Returns memory that the process has freed, but that its allocator
+//!     still holds, to the system, and drops pages from the working set where
+//!     the system allows it.
+//!
+//! This costs nothing to the correctness of the process, but pages that are
+//! touched again afterwards must be faulted back in, so it’s best done after
+//! a burst of allocation, once the process has been idle for a while.
+void TrimMemory();
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_MISC_MEMORY_TRIM_H_
@@ -0,0 +1,31 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/memory_trim.h"
+
+#include <malloc.h>
+
+namespace crashpad {
+
+void TrimMemory() {
+#if defined(__GLIBC__)
+  // This releases the free memory of every arena, not just at the top of the
+  // heap.
+  malloc_trim(0);
+#elif defined(M_PURGE)
+  mallopt(M_PURGE, 0);
+#endif  // __GLIBC__
+}
+
+}  // namespace crashpad
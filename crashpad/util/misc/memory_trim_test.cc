@@ -0,0 +1,46 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/memory_trim.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(MemoryTrim, AfterFree) {
+  TrimMemory();
+
+  {
+    std::vector<std::unique_ptr<char[]>> blocks;
+    for (size_t index = 0; index < 256; ++index) {
+      blocks.push_back(std::unique_ptr<char[]>(new char[64 * 1024]));
+      blocks.back()[0] = static_cast<char>(index);
+    }
+  }
+  TrimMemory();
+
+  // Memory remains usable afterwards.
+  std::unique_ptr<char[]> block(new char[64 * 1024]);
+  block[0] = 1;
+  EXPECT_EQ(block[0], 1);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
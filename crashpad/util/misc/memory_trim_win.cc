@@ -0,0 +1,40 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/memory_trim.h"
+
+#include <windows.h>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+void TrimMemory() {
+  // The C runtime allocates from the process heap. HeapCompact() returns 0
+  // both on failure and when there is no free block left.
+  SetLastError(NO_ERROR);
+  if (HeapCompact(GetProcessHeap(), 0) == 0 && GetLastError() != NO_ERROR) {
+    PLOG(WARNING) << "HeapCompact";
+  }
+
+  // This removes as many pages as possible from the working set. They stay
+  // committed, and are faulted back in if they’re touched again.
+  if (!SetProcessWorkingSetSize(GetCurrentProcess(),
+                                static_cast<SIZE_T>(-1),
+                                static_cast<SIZE_T>(-1))) {
+    PLOG(WARNING) << "SetProcessWorkingSetSize";
+  }
+}
+
+}  // namespace crashpad
@@ -14,9 +14,14 @@
 
 #include "util/misc/metrics.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/metrics/sparse_histogram.h"
 #include "build/build_config.h"
+#include "util/misc/clock.h"
 
 #if defined(OS_MACOSX)
 #define METRICS_OS_NAME "Mac"
@@ -71,6 +76,54 @@ void Metrics::CrashUploadAttempted(bool successful) {
                        static_cast<int32_t>(successful));
 }
 
+// static
+void Metrics::CrashUploadQueueDepth(size_t pending_reports) {
+  UMA_HISTOGRAM_COUNTS("Crashpad.CrashUpload.QueueDepth",
+                       static_cast<int32_t>(std::min<size_t>(
+                           pending_reports,
+                           std::numeric_limits<int32_t>::max())));
+}
+
+// static
+void Metrics::CrashUploadDuration(uint64_t milliseconds) {
+  UMA_HISTOGRAM_CUSTOM_COUNTS(
+      "Crashpad.CrashUpload.Duration",
+      static_cast<int32_t>(std::min<uint64_t>(
+          milliseconds, std::numeric_limits<int32_t>::max())),
+      1,
+      60 * 60 * 1000,
+      50);
+}
+
+// static
+void Metrics::CrashUploadTimeInQueue(uint64_t seconds) {
+  UMA_HISTOGRAM_CUSTOM_COUNTS(
+      "Crashpad.CrashUpload.TimeInQueue",
+      static_cast<int32_t>(std::min<uint64_t>(
+          seconds, std::numeric_limits<int32_t>::max())),
+      1,
+      30 * 24 * 60 * 60,
+      50);
+}
+
+// static
+void Metrics::CrashUploadAttemptCount(int attempts) {
+  UMA_HISTOGRAM_CUSTOM_COUNTS(
+      "Crashpad.CrashUpload.AttemptCount", attempts, 1, 100, 20);
+}
+
+// static
+void Metrics::CrashUploadCompressionRatio(uint64_t stored_size,
+                                          uint64_t minidump_size) {
+  if (!minidump_size) {
+    return;
+  }
+  const int32_t percent = static_cast<int32_t>(
+      std::min<uint64_t>(stored_size * 100 / minidump_size, 100));
+  UMA_HISTOGRAM_CUSTOM_COUNTS(
+      "Crashpad.CrashUpload.CompressionRatio", percent, 1, 101, 50);
+}
+
 // static
 void Metrics::CrashUploadSkipped(CrashSkippedReason reason) {
   UMA_HISTOGRAM_ENUMERATION(
@@ -87,6 +140,80 @@ void Metrics::ExceptionCaptureResult(CaptureResult result) {
                             static_cast<int32_t>(CaptureResult::kMaxValue));
 }
 
+// static
+void Metrics::ExceptionCapturePhaseTime(CapturePhase phase,
+                                        uint64_t nanoseconds) {
+  const int32_t milliseconds = static_cast<int32_t>(std::min<uint64_t>(
+      nanoseconds / 1000000, std::numeric_limits<int32_t>::max()));
+
+#define CAPTURE_PHASE_TIME(name)                                          \
+  UMA_HISTOGRAM_CUSTOM_COUNTS("Crashpad.ExceptionCapturePhaseTime." name, \
+                              milliseconds,                               \
+                              1,                                          \
+                              10 * 60 * 1000,                             \
+                              50)
+
+  switch (phase) {
+    case CapturePhase::kSuspend:
+      CAPTURE_PHASE_TIME("Suspend");
+      break;
+    case CapturePhase::kSnapshot:
+      CAPTURE_PHASE_TIME("Snapshot");
+      break;
+    case CapturePhase::kMemoryCopy:
+      CAPTURE_PHASE_TIME("MemoryCopy");
+      break;
+    case CapturePhase::kMinidumpWrite:
+      CAPTURE_PHASE_TIME("MinidumpWrite");
+      break;
+    case CapturePhase::kDatabaseFinalize:
+      CAPTURE_PHASE_TIME("DatabaseFinalize");
+      break;
+    case CapturePhase::kTargetSuspended:
+      CAPTURE_PHASE_TIME("TargetSuspended");
+      break;
+    case CapturePhase::kMaxValue:
+      NOTREACHED();
+      break;
+  }
+
+#undef CAPTURE_PHASE_TIME
+}
+
+// Each capture phase is traced as the TraceEvent of the same value.
+static_assert(static_cast<int32_t>(TraceEvent::kCaptureSuspend) ==
+                  static_cast<int32_t>(Metrics::CapturePhase::kSuspend),
+              "capture phase trace events mismatch");
+static_assert(static_cast<int32_t>(TraceEvent::kCaptureTargetSuspended) + 1 ==
+                  static_cast<int32_t>(Metrics::CapturePhase::kMaxValue),
+              "capture phase trace events mismatch");
+
+Metrics::ScopedCapturePhaseTimer::ScopedCapturePhaseTimer(CapturePhase phase)
+    : trace_event_(static_cast<TraceEvent>(phase), nullptr),
+      start_time_(ClockMonotonicNanoseconds()),
+      duration_(0),
+      phase_(phase),
+      stopped_(false) {
+}
+
+Metrics::ScopedCapturePhaseTimer::~ScopedCapturePhaseTimer() {
+  Stop();
+}
+
+void Metrics::ScopedCapturePhaseTimer::SetReportID(const UUID& report_id) {
+  trace_event_.SetReportID(report_id);
+}
+
+uint64_t Metrics::ScopedCapturePhaseTimer::Stop() {
+  if (!stopped_) {
+    stopped_ = true;
+    duration_ = ClockMonotonicNanoseconds() - start_time_;
+    trace_event_.End();
+    ExceptionCapturePhaseTime(phase_, duration_);
+  }
+  return duration_;
+}
+
 // static
 void Metrics::ExceptionCode(uint32_t exception_code) {
   UMA_HISTOGRAM_SPARSE_SLOWLY("Crashpad.ExceptionCode." METRICS_OS_NAME,
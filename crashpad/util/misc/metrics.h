@@ -16,9 +16,11 @@
 #define CRASHPAD_UTIL_MISC_METRICS_H_
 
 #include <inttypes.h>
+#include <stddef.h>
 
 #include "base/macros.h"
 #include "util/file/file_io.h"
+#include "util/misc/trace_event.h"
 
 namespace crashpad {
 
@@ -55,6 +57,28 @@ class Metrics {
   //! \brief Reports on a crash upload attempt, and if it succeeded.
   static void CrashUploadAttempted(bool successful);
 
+  //! \brief Reports the number of reports found pending by a pass of the
+  //!     upload thread, including those whose retries are deferred.
+  static void CrashUploadQueueDepth(size_t pending_reports);
+
+  //! \brief Reports how long a crash upload attempt took, in milliseconds.
+  //!     Cancelled attempts are not reported.
+  static void CrashUploadDuration(uint64_t milliseconds);
+
+  //! \brief Reports the time from a report’s creation until it was uploaded
+  //!     successfully, in seconds.
+  static void CrashUploadTimeInQueue(uint64_t seconds);
+
+  //! \brief Reports the number of attempts made to upload a report, when it is
+  //!     either uploaded successfully or given up on.
+  static void CrashUploadAttemptCount(int attempts);
+
+  //! \brief Reports the size of a minidump file as stored in the database as a
+  //!     percentage of the size of its contents, when it is uploaded
+  //!     successfully.
+  static void CrashUploadCompressionRatio(uint64_t stored_size,
+                                          uint64_t minidump_size);
+
   //! \brief Values for CrashUploadSkipped().
   //!
   //! \note These are used as metrics enumeration values, so new values should
@@ -119,6 +143,22 @@ class Metrics {
     //! \brief There was a database error in attempt to complete the report.
     kFinishedWritingCrashReportFailed = 7,
 
+    //! \brief Uploading the report as its minidump was written failed. The
+    //!     report was not retained.
+    kDirectUploadFailed = 8,
+
+    //! \brief The crash was not reported because crashes with the same
+    //!     signature had already been reported recently.
+    kDuplicateSuppressed = 9,
+
+    //! \brief The dump was requested without a crash by a client that had
+    //!     already had as many dumps taken recently as it is permitted.
+    kQuotaExceeded = 10,
+
+    //! \brief The crash was only counted, without a report being written,
+    //!     because the system was under too much load. See CaptureTier.
+    kCounterOnly = 11,
+
     //! \brief The number of values in this enumeration; not a valid value.
     kMaxValue
   };
@@ -127,6 +167,78 @@ class Metrics {
   //!     handler. Should be called on all capture completion paths.
   static void ExceptionCaptureResult(CaptureResult result);
 
+  //! \brief A phase of capturing an exception, for ExceptionCapturePhaseTime().
+  //!
+  //! \note These are used as metrics enumeration values, so new values should
+  //!     always be added at the end, before CapturePhase::kMaxValue.
+  enum class CapturePhase : int32_t {
+    //! \brief Suspending the process that the exception occurred in.
+    kSuspend = 0,
+
+    //! \brief Taking the process snapshot, including enumerating the
+    //!     process’ threads, modules, and memory regions.
+    kSnapshot = 1,
+
+    //! \brief Copying the memory referenced by the snapshot out of the process
+    //!     ahead of resuming it.
+    //!
+    //! This value is only used on Windows.
+    kMemoryCopy = 2,
+
+    //! \brief Writing the minidump to the crash report database, including
+    //!     reading the memory it contains from the process.
+    kMinidumpWrite = 3,
+
+    //! \brief Completing the report in the crash report database once its
+    //!     minidump has been written.
+    kDatabaseFinalize = 4,
+
+    //! \brief The time from the start of suspending the process until it was
+    //!     resumed.
+    kTargetSuspended = 5,
+
+    //! \brief The number of values in this enumeration; not a valid value.
+    kMaxValue
+  };
+
+  //! \brief Reports how long a phase of capturing an exception took, in
+  //!     nanoseconds.
+  static void ExceptionCapturePhaseTime(CapturePhase phase,
+                                        uint64_t nanoseconds);
+
+  //! \brief Measures a CapturePhase, reporting it with
+  //!     ExceptionCapturePhaseTime() when Stop() is called or the object is
+  //!     destroyed, whichever happens first.
+  //!
+  //! A phase that fails is reported in the same way as one that succeeds. The
+  //! phase is also marked in system-wide traces by a ScopedTraceEvent.
+  class ScopedCapturePhaseTimer {
+   public:
+    explicit ScopedCapturePhaseTimer(CapturePhase phase);
+    ~ScopedCapturePhaseTimer();
+
+    //! \brief Associates the phase with the report it is capturing, for
+    //!     tracing, once the report’s UUID is known. See
+    //!     ScopedTraceEvent::SetReportID().
+    void SetReportID(const UUID& report_id);
+
+    //! \brief Reports the phase’s duration now. Once this has been called,
+    //!     calling it again or destroying the object has no further effect.
+    //!
+    //! \return The phase’s duration, in nanoseconds. Later calls return the
+    //!     same value.
+    uint64_t Stop();
+
+   private:
+    ScopedTraceEvent trace_event_;
+    uint64_t start_time_;  // ClockMonotonicNanoseconds()
+    uint64_t duration_;
+    CapturePhase phase_;
+    bool stopped_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedCapturePhaseTimer);
+  };
+
   //! \brief The exception code for an exception was retrieved.
   //!
   //! These values are OS-specific, and correspond to
@@ -0,0 +1,49 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_MISC_SYSTEM_RESOURCES_H_
+#define CRASHPAD_UTIL_MISC_SYSTEM_RESOURCES_H_
+
+#include <stdint.h>
+
+#include "base/files/file_path.h"
+
+namespace crashpad {
+
+//! \brief Determines how much space is available to unprivileged users on the
+//!     volume that holds \a path.
+//!
+//! \param[in] path A file or directory on the volume.
+//! \param[out] available_bytes The number of bytes that may still be written
+//!     to the volume.
+//!
+//! \return `true` on success, or `false` with a message logged.
+bool GetAvailableDiskSpace(const base::FilePath& path,
+                           uint64_t* available_bytes);
+
+//! \brief Determines how much of the system’s physical memory is in use.
+//!
+//! Memory that the system can reclaim without paging, such as clean file
+//! caches, is counted as available, so a high load indicates that the system
+//! is under memory pressure.
+//!
+//! \param[out] percent_in_use The proportion of memory in use, from `0` to
+//!     `100`.
+//!
+//! \return `true` on success, or `false` with a message logged.
+bool GetSystemMemoryLoad(int* percent_in_use);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_MISC_SYSTEM_RESOURCES_H_
@@ -0,0 +1,68 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/system_resources.h"
+
+#include <string>
+
+#include "base/logging.h"
+#include "util/file/delimited_file_reader.h"
+#include "util/file/file_io.h"
+#include "util/file/string_file.h"
+#include "util/misc/lexing.h"
+
+namespace crashpad {
+
+bool GetSystemMemoryLoad(int* percent_in_use) {
+  std::string meminfo;
+  if (!LoggingReadEntireFile(base::FilePath("/proc/meminfo"), &meminfo)) {
+    return false;
+  }
+  StringFile meminfo_file;
+  meminfo_file.SetString(meminfo);
+  DelimitedFileReader line_reader(&meminfo_file);
+
+  // Both values are in kB. MemAvailable estimates the memory that could be
+  // allocated without swapping, including reclaimable caches.
+  uint64_t total = 0;
+  uint64_t available = 0;
+  bool have_total = false;
+  bool have_available = false;
+  std::string line;
+  while ((!have_total || !have_available) &&
+         line_reader.GetLine(&line) == DelimitedFileReader::Result::kSuccess) {
+    const char* line_c = line.c_str();
+    if (AdvancePastPrefix(&line_c, "MemTotal:")) {
+      while (*line_c == ' ') {
+        ++line_c;
+      }
+      have_total = AdvancePastNumber(&line_c, &total);
+    } else if (AdvancePastPrefix(&line_c, "MemAvailable:")) {
+      while (*line_c == ' ') {
+        ++line_c;
+      }
+      have_available = AdvancePastNumber(&line_c, &available);
+    }
+  }
+
+  if (!have_total || !have_available || total == 0 || available > total) {
+    LOG(ERROR) << "format error: /proc/meminfo";
+    return false;
+  }
+
+  *percent_in_use = static_cast<int>((total - available) * 100 / total);
+  return true;
+}
+
+}  // namespace crashpad
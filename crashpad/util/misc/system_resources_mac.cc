@@ -0,0 +1,42 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/system_resources.h"
+
+#include <sys/sysctl.h>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+bool GetSystemMemoryLoad(int* percent_in_use) {
+  // This is the proportion of memory available, as the kernel’s memory status
+  // tracks it to decide when to warn of and respond to memory pressure.
+  int level;
+  size_t len = sizeof(level);
+  if (sysctlbyname("kern.memorystatus_level", &level, &len, nullptr, 0) !=
+      0) {
+    PLOG(ERROR) << "sysctlbyname kern.memorystatus_level";
+    return false;
+  }
+  if (level < 0 || level > 100) {
+    LOG(ERROR) << "unexpected kern.memorystatus_level " << level;
+    return false;
+  }
+
+  *percent_in_use = 100 - level;
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,37 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/system_resources.h"
+
+#include <sys/statvfs.h>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace crashpad {
+
+bool GetAvailableDiskSpace(const base::FilePath& path,
+                           uint64_t* available_bytes) {
+  struct statvfs fs;
+  if (HANDLE_EINTR(statvfs(path.value().c_str(), &fs)) != 0) {
+    PLOG(ERROR) << "statvfs " << path.value();
+    return false;
+  }
+
+  // f_bavail excludes the blocks reserved for the superuser.
+  *available_bytes = static_cast<uint64_t>(fs.f_bavail) * fs.f_frsize;
+  return true;
+}
+
+}  // namespace crashpad
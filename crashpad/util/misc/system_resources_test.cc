@@ -0,0 +1,45 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/system_resources.h"
+
+#include "gtest/gtest.h"
+#include "test/scoped_temp_dir.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(SystemResources, AvailableDiskSpace) {
+  ScopedTempDir temp_dir;
+  uint64_t available_bytes;
+  ASSERT_TRUE(GetAvailableDiskSpace(temp_dir.path(), &available_bytes));
+
+  // The temporary directory was just created, so its volume isn’t full.
+  EXPECT_GT(available_bytes, 0u);
+
+  EXPECT_FALSE(GetAvailableDiskSpace(
+      temp_dir.path().Append(FILE_PATH_LITERAL("missing")), &available_bytes));
+}
+
+TEST(SystemResources, SystemMemoryLoad) {
+  int percent_in_use;
+  ASSERT_TRUE(GetSystemMemoryLoad(&percent_in_use));
+  EXPECT_GE(percent_in_use, 0);
+  EXPECT_LE(percent_in_use, 100);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
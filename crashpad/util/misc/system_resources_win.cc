@@ -0,0 +1,48 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/system_resources.h"
+
+#include <windows.h>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+bool GetAvailableDiskSpace(const base::FilePath& path,
+                           uint64_t* available_bytes) {
+  // The first count accounts for any quota that applies to the caller.
+  ULARGE_INTEGER available;
+  if (!GetDiskFreeSpaceEx(path.value().c_str(), &available, nullptr, nullptr)) {
+    PLOG(ERROR) << "GetDiskFreeSpaceEx";
+    return false;
+  }
+
+  *available_bytes = available.QuadPart;
+  return true;
+}
+
+bool GetSystemMemoryLoad(int* percent_in_use) {
+  MEMORYSTATUSEX status = {};
+  status.dwLength = sizeof(status);
+  if (!GlobalMemoryStatusEx(&status)) {
+    PLOG(ERROR) << "GlobalMemoryStatusEx";
+    return false;
+  }
+
+  *percent_in_use = static_cast<int>(status.dwMemoryLoad);
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,73 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/trace_event.h"
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+ScopedTraceEvent::ScopedTraceEvent(TraceEvent event, const UUID* report_id)
+    : report_id_(),
+      event_(event),
+      has_report_id_(report_id != nullptr),
+      ended_(false) {
+  if (report_id) {
+    report_id_ = *report_id;
+  }
+  Emit(Phase::kBegin, event_, report_id);
+}
+
+ScopedTraceEvent::~ScopedTraceEvent() {
+  End();
+}
+
+void ScopedTraceEvent::SetReportID(const UUID& report_id) {
+  DCHECK(!ended_);
+  report_id_ = report_id;
+  has_report_id_ = true;
+  Emit(Phase::kReport, event_, &report_id_);
+}
+
+void ScopedTraceEvent::End() {
+  if (!ended_) {
+    ended_ = true;
+    Emit(Phase::kEnd, event_, has_report_id_ ? &report_id_ : nullptr);
+  }
+}
+
+// static
+const char* ScopedTraceEvent::EventName(TraceEvent event) {
+  static constexpr const char* kEventNames[] = {
+      "capture suspend",
+      "capture snapshot",
+      "capture memory copy",
+      "capture minidump write",
+      "capture database finalize",
+      "capture target suspended",
+      "compress",
+      "database commit",
+      "upload",
+      "upload batch",
+  };
+  static_assert(arraysize(kEventNames) ==
+                    static_cast<size_t>(TraceEvent::kCount),
+                "event names mismatch");
+
+  const size_t index = static_cast<size_t>(event);
+  DCHECK_LT(index, arraysize(kEventNames));
+  return kEventNames[index];
+}
+
+}  // namespace crashpad
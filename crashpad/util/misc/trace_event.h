@@ -0,0 +1,126 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_MISC_TRACE_EVENT_H_
+#define CRASHPAD_UTIL_MISC_TRACE_EVENT_H_
+
+#include <stdint.h>
+
+#include "base/macros.h"
+#include "util/misc/uuid.h"
+
+namespace crashpad {
+
+//! \brief A span of the handler’s work, marked by a ScopedTraceEvent.
+//!
+//! \note These identify events to macOS tracing tools, so new values should
+//!     always be added at the end, before TraceEvent::kCount.
+enum class TraceEvent : uint32_t {
+  //! \brief Metrics::CapturePhase::kSuspend.
+  kCaptureSuspend = 0,
+
+  //! \brief Metrics::CapturePhase::kSnapshot.
+  kCaptureSnapshot,
+
+  //! \brief Metrics::CapturePhase::kMemoryCopy.
+  kCaptureMemoryCopy,
+
+  //! \brief Metrics::CapturePhase::kMinidumpWrite.
+  kCaptureMinidumpWrite,
+
+  //! \brief Metrics::CapturePhase::kDatabaseFinalize.
+  kCaptureDatabaseFinalize,
+
+  //! \brief Metrics::CapturePhase::kTargetSuspended.
+  kCaptureTargetSuspended,
+
+  //! \brief Compressing a report’s minidump once it has been written.
+  kCompress,
+
+  //! \brief Committing a report to the database, making it pending.
+  kDatabaseCommit,
+
+  //! \brief Uploading a report.
+  kUpload,
+
+  //! \brief Uploading several reports in a single request.
+  kUploadBatch,
+
+  //! \brief The number of values in this enumeration; not a valid value.
+  kCount
+};
+
+//! \brief Marks a span of the handler’s work in system-wide traces, so that it
+//!     can be lined up against the activity of other processes, such as the
+//!     crashing client.
+//!
+//! Events are emitted through the system’s own tracing facility:
+//!  - On Linux and Android, they are written to the `ftrace` marker, where they
+//!    appear as slices in Perfetto and systrace.
+//!  - On macOS, they are kdebug signposts, which appear as points of interest
+//!    in Instruments. The code identifying each is its TraceEvent value, and
+//!    the first two arguments hold the report’s UUID, if known, in the order
+//!    that UUID::ToString() prints it.
+//!  - On Windows, they are ETW start and stop events from the `Crashpad`
+//!    TraceLogging provider, {c14c5221-c5b8-5876-64c7-404d8b443401}.
+//!
+//! When no trace is being recorded, an event costs little more than a system
+//! call on Linux and Android, and next to nothing elsewhere.
+class ScopedTraceEvent {
+ public:
+  //! \brief Begins the span.
+  //!
+  //! \param[in] event The work that the span covers.
+  //! \param[in] report_id The report that the work is for, or `nullptr` if it
+  //!     isn’t known yet, or the work isn’t for a single report.
+  ScopedTraceEvent(TraceEvent event, const UUID* report_id);
+
+  ~ScopedTraceEvent();
+
+  //! \brief Associates the span with a report once its UUID is known, marking
+  //!     the trace with the UUID at the current time.
+  //!
+  //! This may be called more than once for a span that covers several reports.
+  void SetReportID(const UUID& report_id);
+
+  //! \brief Ends the span now. Once this has been called, calling it again or
+  //!     destroying the object has no further effect.
+  void End();
+
+  //! \brief Returns the name of \a event, as it appears in traces where events
+  //!     are named.
+  static const char* EventName(TraceEvent event);
+
+ private:
+  enum class Phase {
+    kBegin,
+    kEnd,
+    kReport,
+  };
+
+  // Emits an event through the system’s tracing facility. This is implemented
+  // separately for each platform.
+  static void Emit(Phase phase, TraceEvent event, const UUID* report_id);
+
+  UUID report_id_;
+  TraceEvent event_;
+  bool has_report_id_;
+  bool ended_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedTraceEvent);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_MISC_TRACE_EVENT_H_
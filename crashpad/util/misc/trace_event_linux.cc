@@ -0,0 +1,91 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/trace_event.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "base/macros.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/strings/stringprintf.h"
+
+namespace crashpad {
+
+namespace {
+
+// Opens the ftrace marker, from wherever tracefs is mounted, returning -1 if
+// it can’t be opened. Tracing tools collect events written to it in the
+// systrace format.
+int OpenTraceMarker() {
+  static constexpr const char* kPaths[] = {
+      "/sys/kernel/tracing/trace_marker",
+      "/sys/kernel/debug/tracing/trace_marker",
+  };
+  for (const char* path : kPaths) {
+    int fd = HANDLE_EINTR(open(path, O_WRONLY | O_NOCTTY | O_CLOEXEC));
+    if (fd >= 0) {
+      return fd;
+    }
+  }
+  return -1;
+}
+
+// Each event is written with a single write(), which the kernel records
+// atomically. Failures are ignored, as they are when tracing is off.
+void WriteMarker(int fd, const std::string& marker) {
+  ignore_result(HANDLE_EINTR(write(fd, marker.data(), marker.size())));
+}
+
+}  // namespace
+
+// static
+void ScopedTraceEvent::Emit(Phase phase,
+                            TraceEvent event,
+                            const UUID* report_id) {
+  // The marker is opened once, and left open for the life of the process. The
+  // handler usually can’t open it, in which case nothing is emitted.
+  static const int trace_marker_fd = OpenTraceMarker();
+  if (trace_marker_fd < 0) {
+    return;
+  }
+
+  // A slice begins with B and ends with the next E from the same thread. A
+  // report’s UUID is part of the name of a slice that knows it when it begins,
+  // and is otherwise marked by an empty slice nested within it.
+  const int pid = getpid();
+  switch (phase) {
+    case Phase::kBegin: {
+      std::string marker = base::StringPrintf("B|%d|%s", pid, EventName(event));
+      if (report_id) {
+        marker += " " + report_id->ToString();
+      }
+      WriteMarker(trace_marker_fd, marker);
+      break;
+    }
+    case Phase::kEnd:
+      WriteMarker(trace_marker_fd, base::StringPrintf("E|%d", pid));
+      break;
+    case Phase::kReport:
+      WriteMarker(trace_marker_fd,
+                  base::StringPrintf(
+                      "B|%d|report %s", pid, report_id->ToString().c_str()));
+      WriteMarker(trace_marker_fd, base::StringPrintf("E|%d", pid));
+      break;
+  }
+}
+
+}  // namespace crashpad
@@ -0,0 +1,88 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/trace_event.h"
+
+#include <dlfcn.h>
+#include <stdint.h>
+
+namespace crashpad {
+
+namespace {
+
+using KdebugSignpostType = int (*)(uint32_t code,
+                                   uintptr_t arg1,
+                                   uintptr_t arg2,
+                                   uintptr_t arg3,
+                                   uintptr_t arg4);
+
+// kdebug_signpost() and its interval variants are present on macOS 10.12 and
+// later, and are looked up dynamically so that older systems and SDKs are
+// tolerated. Where they’re missing, no events are emitted.
+struct KdebugSignposts {
+  KdebugSignposts()
+      : start(reinterpret_cast<KdebugSignpostType>(
+            dlsym(RTLD_DEFAULT, "kdebug_signpost_start"))),
+        end(reinterpret_cast<KdebugSignpostType>(
+            dlsym(RTLD_DEFAULT, "kdebug_signpost_end"))),
+        point(reinterpret_cast<KdebugSignpostType>(
+            dlsym(RTLD_DEFAULT, "kdebug_signpost"))) {}
+
+  KdebugSignpostType start;
+  KdebugSignpostType end;
+  KdebugSignpostType point;
+};
+
+}  // namespace
+
+// static
+void ScopedTraceEvent::Emit(Phase phase,
+                            TraceEvent event,
+                            const UUID* report_id) {
+  static const KdebugSignposts signposts;
+
+  // The UUID is split across two 64-bit arguments, each holding half of it as
+  // UUID::ToString() prints it.
+  uintptr_t uuid_high = 0;
+  uintptr_t uuid_low = 0;
+  if (report_id) {
+    uuid_high = (static_cast<uint64_t>(report_id->data_1) << 32) |
+                (static_cast<uint64_t>(report_id->data_2) << 16) |
+                report_id->data_3;
+    for (uint8_t byte : report_id->data_4) {
+      uuid_low = (uuid_low << 8) | byte;
+    }
+    for (uint8_t byte : report_id->data_5) {
+      uuid_low = (uuid_low << 8) | byte;
+    }
+  }
+
+  KdebugSignpostType signpost = nullptr;
+  switch (phase) {
+    case Phase::kBegin:
+      signpost = signposts.start;
+      break;
+    case Phase::kEnd:
+      signpost = signposts.end;
+      break;
+    case Phase::kReport:
+      signpost = signposts.point;
+      break;
+  }
+  if (signpost) {
+    signpost(static_cast<uint32_t>(event), uuid_high, uuid_low, 0, 0);
+  }
+}
+
+}  // namespace crashpad
@@ -0,0 +1,64 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/trace_event.h"
+
+#include <set>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(ScopedTraceEvent, EventNames) {
+  std::set<std::string> names;
+  for (uint32_t index = 0;
+       index < static_cast<uint32_t>(TraceEvent::kCount);
+       ++index) {
+    const char* name =
+        ScopedTraceEvent::EventName(static_cast<TraceEvent>(index));
+    ASSERT_TRUE(name);
+    EXPECT_NE(name[0], '\0');
+    EXPECT_TRUE(names.insert(name).second) << name;
+  }
+}
+
+TEST(ScopedTraceEvent, Spans) {
+  // Whether or not a trace is being recorded, events are emitted without
+  // failing.
+  UUID report_id;
+  ASSERT_TRUE(report_id.InitializeWithNew());
+
+  {
+    ScopedTraceEvent upload(TraceEvent::kUpload, &report_id);
+  }
+
+  ScopedTraceEvent batch(TraceEvent::kUploadBatch, nullptr);
+  UUID other_report_id;
+  ASSERT_TRUE(other_report_id.InitializeWithNew());
+  {
+    ScopedTraceEvent compress(TraceEvent::kCompress, nullptr);
+    compress.SetReportID(report_id);
+    compress.End();
+    compress.End();
+  }
+  batch.SetReportID(report_id);
+  batch.SetReportID(other_report_id);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
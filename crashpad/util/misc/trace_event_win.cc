@@ -0,0 +1,95 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/trace_event.h"
+
+#include <string.h>
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+#include <winmeta.h>
+
+namespace crashpad {
+
+namespace {
+
+// The provider’s GUID is the one that TraceLogging derives from its name, so
+// that tools can enable it as either.
+TRACELOGGING_DEFINE_PROVIDER(
+    g_trace_provider,
+    "Crashpad",
+    // {c14c5221-c5b8-5876-64c7-404d8b443401}
+    (0xc14c5221,
+     0xc5b8,
+     0x5876,
+     0x64,
+     0xc7,
+     0x40,
+     0x4d,
+     0x8b,
+     0x44,
+     0x34,
+     0x01));
+
+// The provider is registered once, and remains registered for the life of the
+// process.
+bool RegisterTraceProvider() {
+  return SUCCEEDED(TraceLoggingRegister(g_trace_provider));
+}
+
+}  // namespace
+
+// static
+void ScopedTraceEvent::Emit(Phase phase,
+                            TraceEvent event,
+                            const UUID* report_id) {
+  static const bool registered = RegisterTraceProvider();
+  if (!registered || !TraceLoggingProviderEnabled(g_trace_provider, 0, 0)) {
+    return;
+  }
+
+  // UUID and GUID share a layout. A span not yet associated with a report
+  // carries the nil GUID.
+  GUID report_guid = {};
+  if (report_id) {
+    static_assert(sizeof(report_guid) == sizeof(*report_id), "GUID size");
+    memcpy(&report_guid, report_id, sizeof(report_guid));
+  }
+
+  const char* const name = EventName(event);
+  switch (phase) {
+    case Phase::kBegin:
+      TraceLoggingWrite(g_trace_provider,
+                        "Span",
+                        TraceLoggingOpcode(WINEVENT_OPCODE_START),
+                        TraceLoggingString(name, "Name"),
+                        TraceLoggingGuid(report_guid, "ReportID"));
+      break;
+    case Phase::kEnd:
+      TraceLoggingWrite(g_trace_provider,
+                        "Span",
+                        TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+                        TraceLoggingString(name, "Name"),
+                        TraceLoggingGuid(report_guid, "ReportID"));
+      break;
+    case Phase::kReport:
+      TraceLoggingWrite(g_trace_provider,
+                        "Report",
+                        TraceLoggingOpcode(WINEVENT_OPCODE_INFO),
+                        TraceLoggingString(name, "Name"),
+                        TraceLoggingGuid(report_guid, "ReportID"));
+      break;
+  }
+}
+
+}  // namespace crashpad
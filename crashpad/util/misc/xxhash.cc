@@ -0,0 +1,112 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/xxhash.h"
+
+#include <string.h>
+
+namespace crashpad {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9e3779b185ebca87;
+constexpr uint64_t kPrime2 = 0xc2b2ae3d27d4eb4f;
+constexpr uint64_t kPrime3 = 0x165667b19e3779f9;
+constexpr uint64_t kPrime4 = 0x85ebca77c2b2ae63;
+constexpr uint64_t kPrime5 = 0x27d4eb2f165667c5;
+
+uint64_t RotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t Read64(const uint8_t* data) {
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t Read32(const uint8_t* data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint64_t Round(uint64_t accumulator, uint64_t input) {
+  accumulator += input * kPrime2;
+  accumulator = RotateLeft(accumulator, 31);
+  return accumulator * kPrime1;
+}
+
+uint64_t MergeRound(uint64_t hash, uint64_t accumulator) {
+  hash ^= Round(0, accumulator);
+  return hash * kPrime1 + kPrime4;
+}
+
+}  // namespace
+
+uint64_t XXHash64(const void* data, size_t size, uint64_t seed) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  const uint8_t* const end = bytes + size;
+
+  uint64_t hash;
+  if (size >= 32) {
+    // Four lanes each consume eight bytes of every 32-byte stripe.
+    uint64_t lanes[4] = {
+        seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1};
+    const uint8_t* const last_stripe = end - 32;
+    do {
+      for (uint64_t& lane : lanes) {
+        lane = Round(lane, Read64(bytes));
+        bytes += 8;
+      }
+    } while (bytes <= last_stripe);
+
+    hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) +
+           RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+    for (uint64_t lane : lanes) {
+      hash = MergeRound(hash, lane);
+    }
+  } else {
+    hash = seed + kPrime5;
+  }
+
+  hash += size;
+
+  while (end - bytes >= 8) {
+    hash ^= Round(0, Read64(bytes));
+    hash = RotateLeft(hash, 27) * kPrime1 + kPrime4;
+    bytes += 8;
+  }
+
+  if (end - bytes >= 4) {
+    hash ^= Read32(bytes) * kPrime1;
+    hash = RotateLeft(hash, 23) * kPrime2 + kPrime3;
+    bytes += 4;
+  }
+
+  while (bytes < end) {
+    hash ^= *bytes * kPrime5;
+    hash = RotateLeft(hash, 11) * kPrime1;
+    ++bytes;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,40 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_MISC_XXHASH_H_
+#define CRASHPAD_UTIL_MISC_XXHASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace crashpad {
+
+//! \brief Computes the XXH64 hash of a buffer.
+//!
+//! XXH64 is a fast non-cryptographic hash, suitable for identifying data by
+//! its contents where an adversary can’t choose the data. Its output matches
+//! the reference implementation when \a data is read in little-endian byte
+//! order, which is the native order on every supported architecture.
+//!
+//! \param[in] data The data to hash.
+//! \param[in] size The size of \a data, in bytes.
+//! \param[in] seed A value that selects a distinct hash function, typically
+//!     `0`.
+//!
+//! \return The hash.
+uint64_t XXHash64(const void* data, size_t size, uint64_t seed);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_MISC_XXHASH_H_
@@ -0,0 +1,50 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/misc/xxhash.h"
+
+#include <string.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(XXHash, XXHash64) {
+  // Expected values are from the reference implementation.
+  EXPECT_EQ(XXHash64("", 0, 0), 0xef46db3751d8e999u);
+  EXPECT_EQ(XXHash64("abc", 3, 0), 0x44bc2cf5ad770999u);
+
+  static constexpr char kString[] = "Nobody inspects the spammish repetition";
+  EXPECT_EQ(XXHash64(kString, strlen(kString), 0), 0xfbcea83c8a378bf1u);
+  EXPECT_EQ(XXHash64("xxhash", 6, 20141025), 0xb559b98d844e0635u);
+}
+
+TEST(XXHash, XXHash64Unaligned) {
+  // The hash doesn’t depend on the alignment of the data.
+  std::string string(4096 + 1, '\0');
+  for (size_t index = 0; index < string.size(); ++index) {
+    string[index] = static_cast<char>(index * 7);
+  }
+  std::string shifted = string.substr(1);
+  EXPECT_EQ(XXHash64(&string[1], 4096, 0), XXHash64(&shifted[0], 4096, 0));
+  EXPECT_NE(XXHash64(&string[0], 4096, 0), XXHash64(&string[1], 4096, 0));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,447 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/strings/stringprintf.h"
+#include "build/build_config.h"
+#include "test/multiprocess_exec.h"
+#include "test/scoped_temp_dir.h"
+#include "test/test_paths.h"
+#include "tools/tool_support.h"
+#include "util/file/file_io.h"
+#include "util/file/file_writer.h"
+#include "util/misc/clock.h"
+#include "util/net/http_body.h"
+#include "util/net/http_body_compression.h"
+#include "util/net/http_body_gzip.h"
+#include "util/net/http_headers.h"
+#include "util/net/http_multipart_builder.h"
+#include "util/net/http_transport.h"
+#include "util/stdlib/string_number_conversion.h"
+
+#if defined(OS_WIN)
+#include "base/strings/utf_string_conversions.h"
+#endif  // OS_WIN
+
+namespace crashpad {
+namespace {
+
+// Sizes of the buffer passed to HTTPBodyStream::GetBytesBuffer(). These span
+// the buffers that the transports pass: WinHTTP and NSURLSession read in small
+// pieces, and libcurl reads into its upload buffer, 64kB by default.
+constexpr size_t kBufferSizes[] = {512, 4096, 16384, 65536, 524288};
+
+// Builds a payload resembling a minidump: pages of incompressible data
+// interleaved with pages of zeroes and of short repeating patterns, so that
+// compression makes progress at a realistic rate.
+std::string MakePayload(size_t size) {
+  std::string payload(size, '\0');
+  uint32_t state = 0x12345678;
+  constexpr size_t kPageSize = 4096;
+  for (size_t offset = 0; offset < size; offset += kPageSize) {
+    const size_t end = std::min(offset + kPageSize, size);
+    switch ((offset / kPageSize) % 3) {
+      case 0:
+        for (size_t index = offset; index < end; ++index) {
+          state = state * 1103515245 + 12345;
+          payload[index] = static_cast<char>(state >> 16);
+        }
+        break;
+      case 1:
+        break;
+      case 2:
+        for (size_t index = offset; index < end; ++index) {
+          payload[index] = static_cast<char>("crashpad"[index % 8]);
+        }
+        break;
+    }
+  }
+  return payload;
+}
+
+// The sources of one body: the payload in memory, and the same payload in a
+// file.
+struct Payload {
+  std::string data;
+  base::FilePath path;
+};
+
+// Produces a body stream carrying |payload|, and sets any headers it requires
+// in |headers|.
+using BodyFunction = std::unique_ptr<HTTPBodyStream> (*)(
+    const Payload& payload, HTTPHeaders* headers);
+
+std::unique_ptr<HTTPBodyStream> StringBody(const Payload& payload,
+                                           HTTPHeaders* headers) {
+  return std::unique_ptr<HTTPBodyStream>(
+      new StringHTTPBodyStream(payload.data));
+}
+
+std::unique_ptr<HTTPBodyStream> FileBody(const Payload& payload,
+                                         HTTPHeaders* headers) {
+  return std::unique_ptr<HTTPBodyStream>(
+      new FileHTTPBodyStream(payload.path));
+}
+
+std::unique_ptr<HTTPBodyStream> MultipartBody(const Payload& payload,
+                                              bool gzip,
+                                              HTTPHeaders* headers) {
+  HTTPMultipartBuilder builder;
+  builder.SetGzipEnabled(gzip);
+  builder.SetFormData("prod", "crashpad_http_benchmark");
+  builder.SetFormData("ver", "1");
+  builder.SetFileAttachment("upload_file_minidump",
+                            "minidump.dmp",
+                            payload.path,
+                            "application/octet-stream");
+  builder.PopulateContentHeaders(headers);
+  return builder.GetBodyStream();
+}
+
+std::unique_ptr<HTTPBodyStream> IdentityMultipartBody(const Payload& payload,
+                                                      HTTPHeaders* headers) {
+  return MultipartBody(payload, false, headers);
+}
+
+std::unique_ptr<HTTPBodyStream> GzipMultipartBody(const Payload& payload,
+                                                  HTTPHeaders* headers) {
+  return MultipartBody(payload, true, headers);
+}
+
+std::unique_ptr<HTTPBodyStream> GzipBody(const Payload& payload,
+                                         HTTPHeaders* headers) {
+  (*headers)[kContentEncoding] = "gzip";
+  return std::unique_ptr<HTTPBodyStream>(new GzipHTTPBodyStream(
+      std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream(payload.data))));
+}
+
+std::unique_ptr<HTTPBodyStream> ParallelGzipBody(const Payload& payload,
+                                                 HTTPHeaders* headers) {
+  (*headers)[kContentEncoding] = "gzip";
+  HTTPCompression compression(HTTPContentCoding::kGzip);
+  compression.threads = 4;
+  return CreateCompressingHTTPBodyStream(
+      compression,
+      std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream(payload.data)));
+}
+
+constexpr struct {
+  const char* name;
+  BodyFunction body;
+} kBodies[] = {
+    {"string", StringBody},
+    {"file", FileBody},
+    {"multipart", IdentityMultipartBody},
+    {"multipart_gzip", GzipMultipartBody},
+    {"gzip", GzipBody},
+    {"parallel_gzip", ParallelGzipBody},
+};
+
+// Reads |stream| to its end, |buffer_size| bytes at a time, discarding what it
+// produces. Returns the number of bytes read, or -1 on failure.
+int64_t DrainStream(HTTPBodyStream* stream, size_t buffer_size) {
+  std::unique_ptr<uint8_t[]> buffer(new uint8_t[buffer_size]);
+  int64_t total = 0;
+  FileOperationResult bytes_read;
+  while ((bytes_read = stream->GetBytesBuffer(buffer.get(), buffer_size)) >
+         0) {
+    total += bytes_read;
+  }
+  return bytes_read < 0 ? -1 : total;
+}
+
+// Prints, for one body and each of kBufferSizes, the rate at which the payload
+// is consumed and the size of the body produced from it.
+bool MeasureBodyStream(const char* name,
+                       BodyFunction body,
+                       const Payload& payload,
+                       unsigned int iterations) {
+  for (size_t buffer_size : kBufferSizes) {
+    uint64_t elapsed_ns = 0;
+    int64_t body_size = 0;
+    for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+      HTTPHeaders headers;
+      std::unique_ptr<HTTPBodyStream> stream = body(payload, &headers);
+      const uint64_t start_time = ClockMonotonicNanoseconds();
+      body_size = DrainStream(stream.get(), buffer_size);
+      elapsed_ns += ClockMonotonicNanoseconds() - start_time;
+      if (body_size < 0) {
+        LOG(ERROR) << name << ": GetBytesBuffer failed";
+        return false;
+      }
+    }
+
+    printf("%-16s %8" PRIuS " %12.1f %12lld\n",
+           name,
+           buffer_size,
+           payload.data.size() * 1E3 * iterations / std::max(elapsed_ns,
+                                                              uint64_t{1}),
+           static_cast<long long>(body_size));
+  }
+  return true;
+}
+
+// Uploads a body to a one-shot instance of http_transport_test_server.py over
+// loopback, timing ExecuteSynchronously().
+class LoopbackUpload final : public test::MultiprocessExec {
+ public:
+  LoopbackUpload(std::unique_ptr<HTTPBodyStream> body_stream,
+                 const HTTPHeaders& headers)
+      : test::MultiprocessExec(),
+        headers_(headers),
+        body_stream_(std::move(body_stream)),
+        elapsed_ns_(0),
+        successful_(false) {
+    base::FilePath server_path = test::TestPaths::TestDataRoot().Append(
+        FILE_PATH_LITERAL("util/net/http_transport_test_server.py"));
+#if defined(OS_POSIX)
+    SetChildCommand(server_path.value(), nullptr);
+#elif defined(OS_WIN)
+    // Explicitly invoke a shell and python so that python can be found in the
+    // path, and run the server script.
+    std::vector<std::string> args;
+    args.push_back("/c");
+    args.push_back("python");
+    args.push_back(base::UTF16ToUTF8(server_path.value()));
+    SetChildCommand(getenv("COMSPEC"), &args);
+#endif  // OS_POSIX
+  }
+
+  ~LoopbackUpload() {}
+
+  uint64_t elapsed_ns() const { return elapsed_ns_; }
+  bool successful() const { return successful_; }
+
+ private:
+  // MultiprocessExec:
+  void MultiprocessParent() override {
+    // See HTTPTransportTestFixture in http_transport_test.cc for the protocol
+    // spoken with the server.
+    uint16_t port;
+    if (!LoggingReadFileExactly(ReadPipeHandle(), &port, sizeof(port))) {
+      return;
+    }
+
+    constexpr uint16_t kResponseCode = 200;
+    constexpr char kResponseBody[] = "0123456789abcdef";
+    if (!LoggingWriteFile(
+            WritePipeHandle(), &kResponseCode, sizeof(kResponseCode)) ||
+        !LoggingWriteFile(
+            WritePipeHandle(), kResponseBody, sizeof(kResponseBody) - 1)) {
+      return;
+    }
+
+    std::unique_ptr<HTTPTransport> transport(HTTPTransport::Create());
+    transport->SetURL(base::StringPrintf("http://127.0.0.1:%d/upload", port));
+    for (const auto& pair : headers_) {
+      transport->SetHeader(pair.first, pair.second);
+    }
+    transport->SetBodyStream(std::move(body_stream_));
+    transport->SetTimeout(600);
+
+    const uint64_t start_time = ClockMonotonicNanoseconds();
+    const bool uploaded = transport->ExecuteSynchronously(nullptr);
+    elapsed_ns_ = ClockMonotonicNanoseconds() - start_time;
+
+    // The server writes the whole request back once it has responded. Read it
+    // to the end so that the server can exit.
+    char buffer[4096];
+    FileOperationResult bytes_read;
+    while ((bytes_read = ReadFile(ReadPipeHandle(), buffer, sizeof(buffer))) >
+           0) {
+    }
+
+    successful_ = uploaded && bytes_read == 0;
+  }
+
+  HTTPHeaders headers_;
+  std::unique_ptr<HTTPBodyStream> body_stream_;
+  uint64_t elapsed_ns_;
+  bool successful_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoopbackUpload);
+};
+
+// Prints, for one body, the rate at which the payload is uploaded by this
+// platform’s HTTPTransport.
+bool MeasureTransport(const char* name,
+                      BodyFunction body,
+                      const Payload& payload,
+                      unsigned int iterations) {
+  uint64_t elapsed_ns = 0;
+  for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+    HTTPHeaders headers;
+    std::unique_ptr<HTTPBodyStream> stream = body(payload, &headers);
+    LoopbackUpload upload(std::move(stream), headers);
+    upload.Run();
+    if (!upload.successful()) {
+      LOG(ERROR) << name << ": upload failed";
+      return false;
+    }
+    elapsed_ns += upload.elapsed_ns();
+  }
+
+  printf("%-16s %12.1f %12.1f\n",
+         name,
+         elapsed_ns / 1E6 / iterations,
+         payload.data.size() * 1E3 * iterations /
+             std::max(elapsed_ns, uint64_t{1}));
+  return true;
+}
+
+void Usage(const base::FilePath& me) {
+  fprintf(stderr,
+"Usage: %" PRFilePath " [OPTION]...\n"
+"Measure the throughput of HTTP body streams for a range of read sizes, and\n"
+"of uploads through this platform’s HTTP transport over loopback.\n"
+"\n"
+"  -i, --iterations=COUNT  repeat each measurement COUNT times (5)\n"
+"  -s, --size=BYTES        use a BYTES-byte payload (16777216)\n"
+"      --no-transport      don’t measure uploads\n"
+"      --help              display this help and exit\n"
+"      --version           output version information and exit\n",
+          me.value().c_str());
+  ToolSupport::UsageTail(me);
+}
+
+int HTTPBenchmarkMain(int argc, char* argv[]) {
+  const base::FilePath argv0(
+      ToolSupport::CommandLineArgumentToFilePathStringType(argv[0]));
+  const base::FilePath me(argv0.BaseName());
+
+  enum OptionFlags {
+    // “Short” (single-character) options.
+    kOptionIterations = 'i',
+    kOptionSize = 's',
+
+    // Long options without short equivalents.
+    kOptionLastChar = 255,
+    kOptionNoTransport,
+
+    // Standard options.
+    kOptionHelp = -2,
+    kOptionVersion = -3,
+  };
+
+  unsigned int iterations = 5;
+  unsigned int size = 16 * 1024 * 1024;
+  bool transport = true;
+
+  static constexpr option long_options[] = {
+      {"iterations", required_argument, nullptr, kOptionIterations},
+      {"size", required_argument, nullptr, kOptionSize},
+      {"no-transport", no_argument, nullptr, kOptionNoTransport},
+      {"help", no_argument, nullptr, kOptionHelp},
+      {"version", no_argument, nullptr, kOptionVersion},
+      {nullptr, 0, nullptr, 0},
+  };
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "i:s:", long_options, nullptr)) !=
+         -1) {
+    switch (opt) {
+      case kOptionIterations:
+        if (!StringToNumber(optarg, &iterations)) {
+          ToolSupport::UsageHint(me, "numeric value required");
+          return EXIT_FAILURE;
+        }
+        break;
+      case kOptionSize:
+        if (!StringToNumber(optarg, &size)) {
+          ToolSupport::UsageHint(me, "numeric value required");
+          return EXIT_FAILURE;
+        }
+        break;
+      case kOptionNoTransport:
+        transport = false;
+        break;
+      case kOptionHelp:
+        Usage(me);
+        return EXIT_SUCCESS;
+      case kOptionVersion:
+        ToolSupport::Version(me);
+        return EXIT_SUCCESS;
+      default:
+        ToolSupport::UsageHint(me, nullptr);
+        return EXIT_FAILURE;
+    }
+  }
+  argc -= optind;
+  argv += optind;
+
+  if (argc != 0 || iterations == 0) {
+    ToolSupport::UsageHint(me, nullptr);
+    return EXIT_FAILURE;
+  }
+
+  test::ScopedTempDir temp_dir;
+  Payload payload;
+  payload.data = MakePayload(size);
+  payload.path = temp_dir.path().Append(FILE_PATH_LITERAL("payload"));
+  {
+    FileWriter writer;
+    if (!writer.Open(payload.path,
+                     FileWriteMode::kTruncateOrCreate,
+                     FilePermissions::kOwnerOnly) ||
+        !writer.Write(payload.data.data(), payload.data.size())) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  printf("%u-byte payload, %u iterations\n", size, iterations);
+  printf("%-16s %8s %12s %12s\n", "body", "buffer", "MB/s", "bytes");
+  for (const auto& body : kBodies) {
+    if (!MeasureBodyStream(body.name, body.body, payload, iterations)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (transport) {
+    printf("\n%-16s %12s %12s\n", "upload", "ms", "MB/s");
+    for (const auto& body : kBodies) {
+      if (!MeasureTransport(body.name, body.body, payload, iterations)) {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+}  // namespace
+}  // namespace crashpad
+
+#if defined(OS_POSIX)
+int main(int argc, char* argv[]) {
+  return crashpad::HTTPBenchmarkMain(argc, argv);
+}
+#elif defined(OS_WIN)
+int wmain(int argc, wchar_t* argv[]) {
+  return crashpad::ToolSupport::Wmain(argc, argv, crashpad::HTTPBenchmarkMain);
+}
+#endif  // OS_POSIX
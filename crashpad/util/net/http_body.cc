@@ -20,8 +20,13 @@
 #include <limits>
 
 #include "base/logging.h"
+#include "build/build_config.h"
 #include "util/misc/implicit_cast.h"
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <fcntl.h>
+#endif  // OS_LINUX || OS_ANDROID
+
 namespace crashpad {
 
 StringHTTPBodyStream::StringHTTPBodyStream(const std::string& string)
@@ -62,6 +67,11 @@ FileOperationResult FileHTTPBodyStream::GetBytesBuffer(uint8_t* buffer,
         file_state_ = kFileOpenError;
         return -1;
       }
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+      // The file is read once from start to end, so ask the kernel for
+      // aggressive readahead. Doing without it only costs some speed.
+      posix_fadvise(file_.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif  // OS_LINUX || OS_ANDROID
       file_state_ = kReading;
       break;
     case kFileOpenError:
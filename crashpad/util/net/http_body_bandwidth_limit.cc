@@ -0,0 +1,100 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/http_body_bandwidth_limit.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "util/misc/clock.h"
+
+namespace crashpad {
+
+HTTPBandwidthLimiter::HTTPBandwidthLimiter(uint64_t bytes_per_second,
+                                           uint64_t burst_bytes)
+    : lock_(),
+      bytes_per_second_(static_cast<double>(bytes_per_second)),
+      burst_bytes_(static_cast<double>(burst_bytes)),
+      tokens_(static_cast<double>(burst_bytes)),
+      last_refill_ns_(0),
+      started_(false) {
+  DCHECK_GT(bytes_per_second, 0u);
+  DCHECK_GT(burst_bytes, 0u);
+}
+
+HTTPBandwidthLimiter::~HTTPBandwidthLimiter() {
+}
+
+size_t HTTPBandwidthLimiter::MaxReadSize(size_t max_len) const {
+  return static_cast<size_t>(
+      std::min(static_cast<double>(max_len), burst_bytes_));
+}
+
+void HTTPBandwidthLimiter::Consume(size_t bytes) {
+  uint64_t wait_ns;
+  {
+    base::AutoLock lock(lock_);
+
+    const uint64_t now_ns = NowNanoseconds();
+    if (started_ && now_ns > last_refill_ns_) {
+      tokens_ = std::min(
+          burst_bytes_,
+          tokens_ + (now_ns - last_refill_ns_) / 1E9 * bytes_per_second_);
+    }
+    last_refill_ns_ = now_ns;
+    started_ = true;
+
+    // The debt is taken on before waiting, so that concurrent senders queue up
+    // behind one another rather than all waking at once.
+    tokens_ -= bytes;
+    wait_ns = tokens_ < 0
+                  ? static_cast<uint64_t>(-tokens_ / bytes_per_second_ * 1E9)
+                  : 0;
+  }
+
+  if (wait_ns) {
+    Wait(wait_ns);
+  }
+}
+
+uint64_t HTTPBandwidthLimiter::NowNanoseconds() {
+  return ClockMonotonicNanoseconds();
+}
+
+void HTTPBandwidthLimiter::Wait(uint64_t nanoseconds) {
+  SleepNanoseconds(nanoseconds);
+}
+
+BandwidthLimitedHTTPBodyStream::BandwidthLimitedHTTPBodyStream(
+    std::unique_ptr<HTTPBodyStream> source,
+    HTTPBandwidthLimiter* limiter)
+    : HTTPBodyStream(), source_(std::move(source)), limiter_(limiter) {
+}
+
+BandwidthLimitedHTTPBodyStream::~BandwidthLimitedHTTPBodyStream() {
+}
+
+FileOperationResult BandwidthLimitedHTTPBodyStream::GetBytesBuffer(
+    uint8_t* buffer,
+    size_t max_len) {
+  FileOperationResult rv =
+      source_->GetBytesBuffer(buffer, limiter_->MaxReadSize(max_len));
+  if (rv > 0) {
+    limiter_->Consume(static_cast<size_t>(rv));
+  }
+  return rv;
+}
+
+}  // namespace crashpad
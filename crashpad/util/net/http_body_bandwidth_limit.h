@@ -0,0 +1,115 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_NET_HTTP_BODY_BANDWIDTH_LIMIT_H_
+#define CRASHPAD_UTIL_NET_HTTP_BODY_BANDWIDTH_LIMIT_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <memory>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "util/file/file_io.h"
+#include "util/net/http_body.h"
+
+namespace crashpad {
+
+//! \brief Limits the rate at which data is sent, by means of a token bucket.
+//!
+//! The bucket holds up to a burst’s worth of tokens, one per byte, and is
+//! refilled at the permitted rate. Sending data takes tokens from the bucket.
+//! When there aren’t enough, the bucket goes into debt, and the sender waits
+//! until the debt has been repaid. This permits a burst to be sent at full
+//! speed after a period of idleness, while holding the long-term rate to the
+//! limit.
+//!
+//! A single object may be shared among several streams, including on different
+//! threads, to limit their aggregate rate.
+class HTTPBandwidthLimiter {
+ public:
+  //! \param[in] bytes_per_second The permitted long-term rate. This must be
+  //!     positive.
+  //! \param[in] burst_bytes The size of the bucket, which is the most that may
+  //!     be sent at full speed after a period of idleness. This must be
+  //!     positive.
+  HTTPBandwidthLimiter(uint64_t bytes_per_second, uint64_t burst_bytes);
+  virtual ~HTTPBandwidthLimiter();
+
+  //! \brief Returns the number of bytes that a stream should read at once,
+  //!     given a buffer of \a max_len bytes.
+  //!
+  //! This is limited to the size of the bucket, so that no single read incurs
+  //! more than a burst’s worth of delay.
+  size_t MaxReadSize(size_t max_len) const;
+
+  //! \brief Takes \a bytes tokens from the bucket, waiting as needed to hold
+  //!     the rate to the limit.
+  void Consume(size_t bytes);
+
+ protected:
+  //! \brief Returns the current time, in ClockMonotonicNanoseconds() terms.
+  //!
+  //! This is virtual so that tests can substitute a fake clock.
+  virtual uint64_t NowNanoseconds();
+
+  //! \brief Waits for \a nanoseconds.
+  //!
+  //! This is virtual so that tests can substitute a fake clock.
+  virtual void Wait(uint64_t nanoseconds);
+
+ private:
+  // Guards every member below.
+  base::Lock lock_;
+
+  const double bytes_per_second_;
+  const double burst_bytes_;
+
+  // The tokens in the bucket as of last_refill_ns_. This is negative when the
+  // bucket is in debt.
+  double tokens_;
+  uint64_t last_refill_ns_;
+  bool started_;
+
+  DISALLOW_COPY_AND_ASSIGN(HTTPBandwidthLimiter);
+};
+
+//! \brief An implementation of HTTPBodyStream that limits the rate at which
+//!     another HTTPBodyStream is read.
+//!
+//! Because HTTPTransport reads the body as fast as it can send it, this limits
+//! the rate at which the body is sent.
+class BandwidthLimitedHTTPBodyStream : public HTTPBodyStream {
+ public:
+  //! \param[in] source The stream to read from.
+  //! \param[in] limiter The limiter to apply. This object does not take
+  //!     ownership of \a limiter, which must outlive it.
+  BandwidthLimitedHTTPBodyStream(std::unique_ptr<HTTPBodyStream> source,
+                                 HTTPBandwidthLimiter* limiter);
+  ~BandwidthLimitedHTTPBodyStream() override;
+
+  // HTTPBodyStream:
+  FileOperationResult GetBytesBuffer(uint8_t* buffer, size_t max_len) override;
+
+ private:
+  std::unique_ptr<HTTPBodyStream> source_;
+  HTTPBandwidthLimiter* limiter_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(BandwidthLimitedHTTPBodyStream);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_NET_HTTP_BODY_BANDWIDTH_LIMIT_H_
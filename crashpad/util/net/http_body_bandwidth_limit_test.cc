@@ -0,0 +1,105 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/http_body_bandwidth_limit.h"
+
+#include <string>
+
+#include "base/macros.h"
+#include "gtest/gtest.h"
+#include "util/net/http_body_test_util.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+// An HTTPBandwidthLimiter whose clock only advances while it waits, as though
+// sending took no time.
+class TestBandwidthLimiter final : public HTTPBandwidthLimiter {
+ public:
+  TestBandwidthLimiter(uint64_t bytes_per_second, uint64_t burst_bytes)
+      : HTTPBandwidthLimiter(bytes_per_second, burst_bytes), now_ns_(0) {}
+
+  ~TestBandwidthLimiter() override {}
+
+  uint64_t now_ns() const { return now_ns_; }
+  void Advance(uint64_t nanoseconds) { now_ns_ += nanoseconds; }
+
+ protected:
+  // HTTPBandwidthLimiter:
+  uint64_t NowNanoseconds() override { return now_ns_; }
+  void Wait(uint64_t nanoseconds) override { now_ns_ += nanoseconds; }
+
+ private:
+  uint64_t now_ns_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestBandwidthLimiter);
+};
+
+constexpr uint64_t kNanosecondsPerSecond = static_cast<uint64_t>(1E9);
+
+TEST(HTTPBandwidthLimiter, Burst) {
+  TestBandwidthLimiter limiter(1000, 500);
+  EXPECT_EQ(limiter.MaxReadSize(100), 100u);
+  EXPECT_EQ(limiter.MaxReadSize(4096), 500u);
+
+  // A full bucket is sent without waiting.
+  limiter.Consume(500);
+  EXPECT_EQ(limiter.now_ns(), 0u);
+
+  // After that, sending waits to hold the rate to the limit.
+  limiter.Consume(250);
+  EXPECT_EQ(limiter.now_ns(), kNanosecondsPerSecond / 4);
+  limiter.Consume(500);
+  EXPECT_EQ(limiter.now_ns(), kNanosecondsPerSecond * 3 / 4);
+}
+
+TEST(HTTPBandwidthLimiter, Refill) {
+  TestBandwidthLimiter limiter(1000, 500);
+  limiter.Consume(500);
+  EXPECT_EQ(limiter.now_ns(), 0u);
+
+  // Idleness refills the bucket, but never beyond its size.
+  limiter.Advance(kNanosecondsPerSecond / 5);
+  limiter.Consume(200);
+  EXPECT_EQ(limiter.now_ns(), kNanosecondsPerSecond / 5);
+
+  limiter.Advance(10 * kNanosecondsPerSecond);
+  const uint64_t idle_ns = limiter.now_ns();
+  limiter.Consume(500);
+  EXPECT_EQ(limiter.now_ns(), idle_ns);
+  limiter.Consume(100);
+  EXPECT_EQ(limiter.now_ns(), idle_ns + kNanosecondsPerSecond / 10);
+}
+
+TEST(BandwidthLimitedHTTPBodyStream, Read) {
+  std::string data;
+  for (size_t index = 0; index < 3000; ++index) {
+    data.push_back(static_cast<char>('a' + index % 26));
+  }
+
+  TestBandwidthLimiter limiter(1000, 1000);
+  BandwidthLimitedHTTPBodyStream stream(
+      std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream(data)),
+      &limiter);
+  EXPECT_EQ(ReadStreamToString(&stream, 4096), data);
+
+  // The first second’s worth was sent as a burst, and the remainder at the
+  // limit.
+  EXPECT_EQ(limiter.now_ns(), 2 * kNanosecondsPerSecond);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,61 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/http_body_compression.h"
+
+#include <utility>
+
+#include "base/logging.h"
+#include "util/net/http_body_gzip.h"
+
+namespace crashpad {
+
+// static
+constexpr int HTTPCompression::kDefaultLevel;
+
+const char* HTTPContentCodingName(HTTPContentCoding coding) {
+  switch (coding) {
+    case HTTPContentCoding::kIdentity:
+      return nullptr;
+    case HTTPContentCoding::kGzip:
+      return "gzip";
+  }
+
+  NOTREACHED();
+  return nullptr;
+}
+
+std::unique_ptr<HTTPBodyStream> CreateCompressingHTTPBodyStream(
+    const HTTPCompression& compression,
+    std::unique_ptr<HTTPBodyStream> source) {
+  switch (compression.coding) {
+    case HTTPContentCoding::kIdentity:
+      return source;
+    case HTTPContentCoding::kGzip:
+      if (compression.threads > 1) {
+        return std::unique_ptr<HTTPBodyStream>(new ParallelGzipHTTPBodyStream(
+            std::move(source),
+            compression,
+            compression.threads,
+            ParallelGzipHTTPBodyStream::kDefaultBlockSize));
+      }
+      return std::unique_ptr<HTTPBodyStream>(
+          new GzipHTTPBodyStream(std::move(source), compression));
+  }
+
+  NOTREACHED();
+  return source;
+}
+
+}  // namespace crashpad
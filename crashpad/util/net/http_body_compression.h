@@ -0,0 +1,98 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_NET_HTTP_BODY_COMPRESSION_H_
+#define CRASHPAD_UTIL_NET_HTTP_BODY_COMPRESSION_H_
+
+#include <stddef.h>
+
+#include <memory>
+
+#include "util/net/http_body.h"
+
+namespace crashpad {
+
+//! \brief An HTTP content coding that request bodies may be compressed with.
+//!
+//! See RFC 7231 §3.1.2.1.
+enum class HTTPContentCoding {
+  //! \brief No compression.
+  kIdentity,
+
+  //! \brief `gzip` compression, provided by GzipHTTPBodyStream or
+  //!     ParallelGzipHTTPBodyStream.
+  kGzip,
+};
+
+//! \brief Describes how to compress an HTTP request body.
+struct HTTPCompression {
+  //! \brief Tunes a codec for particular kinds of data.
+  //!
+  //! Codecs without such tuning ignore this. For `gzip`, these correspond to
+  //! zlib’s `Z_DEFAULT_STRATEGY`, `Z_FILTERED`, `Z_RLE`, and `Z_HUFFMAN_ONLY`.
+  enum class Strategy {
+    kDefault,
+    kFiltered,
+    kRunLength,
+    kHuffmanOnly,
+  };
+
+  //! \brief A #level that selects the codec’s default level.
+  static constexpr int kDefaultLevel = -1;
+
+  HTTPCompression()
+      : coding(HTTPContentCoding::kIdentity),
+        level(kDefaultLevel),
+        strategy(Strategy::kDefault),
+        threads(1) {}
+
+  explicit HTTPCompression(HTTPContentCoding coding)
+      : coding(coding),
+        level(kDefaultLevel),
+        strategy(Strategy::kDefault),
+        threads(1) {}
+
+  //! \brief The content coding to compress with.
+  HTTPContentCoding coding;
+
+  //! \brief The compression level, trading speed for size. For `gzip`, this
+  //!     ranges from `1`, fastest, to `9`, smallest. #kDefaultLevel selects the
+  //!     codec’s default.
+  int level;
+
+  //! \brief The compression strategy.
+  Strategy strategy;
+
+  //! \brief The number of threads to compress on.
+  //!
+  //! With more than one, `gzip` compression is done by
+  //! ParallelGzipHTTPBodyStream.
+  size_t threads;
+};
+
+//! \brief Returns the name of \a coding as used in a `Content-Encoding` header,
+//!     or `nullptr` for HTTPContentCoding::kIdentity, which is not declared.
+const char* HTTPContentCodingName(HTTPContentCoding coding);
+
+//! \brief Returns a stream that compresses \a source as \a compression
+//!     specifies.
+//!
+//! For HTTPContentCoding::kIdentity, \a source is returned unchanged.
+std::unique_ptr<HTTPBodyStream> CreateCompressingHTTPBodyStream(
+    const HTTPCompression& compression,
+    std::unique_ptr<HTTPBodyStream> source);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_NET_HTTP_BODY_COMPRESSION_H_
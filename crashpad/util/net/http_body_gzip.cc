@@ -14,19 +14,80 @@
 
 #include "util/net/http_body_gzip.h"
 
+#include <string.h>
+
+#include <algorithm>
 #include <utility>
 
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
 #include "third_party/zlib/zlib_crashpad.h"
+#include "util/file/block_compressed_file_reader.h"
 #include "util/misc/zlib.h"
+#include "util/synchronization/semaphore.h"
+#include "util/thread/thread.h"
 
 namespace crashpad {
 
+namespace {
+
+// The default values for zlib’s internal MAX_WBITS and DEF_MEM_LEVEL. These are
+// the values that deflateInit() would use, but they’re not exported from zlib.
+// deflateInit2() is used instead of deflateInit() to get the gzip wrapper.
+constexpr int kZlibMaxWindowBits = 15;
+constexpr int kZlibDefaultMemoryLevel = 8;
+
+int ZlibLevel(int level) {
+  return level == HTTPCompression::kDefaultLevel ? Z_DEFAULT_COMPRESSION
+                                                 : level;
+}
+
+int ZlibStrategy(HTTPCompression::Strategy strategy) {
+  switch (strategy) {
+    case HTTPCompression::Strategy::kDefault:
+      return Z_DEFAULT_STRATEGY;
+    case HTTPCompression::Strategy::kFiltered:
+      return Z_FILTERED;
+    case HTTPCompression::Strategy::kRunLength:
+      return Z_RLE;
+    case HTTPCompression::Strategy::kHuffmanOnly:
+      return Z_HUFFMAN_ONLY;
+  }
+
+  NOTREACHED();
+  return Z_DEFAULT_STRATEGY;
+}
+
+int GzipDeflateInit(z_stream* zlib, const HTTPCompression& compression) {
+  zlib->zalloc = Z_NULL;
+  zlib->zfree = Z_NULL;
+  zlib->opaque = Z_NULL;
+  return deflateInit2(zlib,
+                      ZlibLevel(compression.level),
+                      Z_DEFLATED,
+                      ZlibWindowBitsWithGzipWrapper(kZlibMaxWindowBits),
+                      kZlibDefaultMemoryLevel,
+                      ZlibStrategy(compression.strategy));
+}
+
+void AppendLittleEndian32(std::string* string, uint32_t value) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    string->push_back(static_cast<char>(value >> shift));
+  }
+}
+
+}  // namespace
+
 GzipHTTPBodyStream::GzipHTTPBodyStream(std::unique_ptr<HTTPBodyStream> source)
+    : GzipHTTPBodyStream(std::move(source),
+                         HTTPCompression(HTTPContentCoding::kGzip)) {}
+
+GzipHTTPBodyStream::GzipHTTPBodyStream(std::unique_ptr<HTTPBodyStream> source,
+                                       const HTTPCompression& compression)
     : input_(),
       source_(std::move(source)),
       z_stream_(new z_stream()),
+      compression_(compression),
       state_(State::kUninitialized) {}
 
 GzipHTTPBodyStream::~GzipHTTPBodyStream() {
@@ -46,23 +107,7 @@ FileOperationResult GzipHTTPBodyStream::GetBytesBuffer(uint8_t* buffer,
   }
 
   if (state_ == State::kUninitialized) {
-    z_stream_->zalloc = Z_NULL;
-    z_stream_->zfree = Z_NULL;
-    z_stream_->opaque = Z_NULL;
-
-    // The default values for zlib’s internal MAX_WBITS and DEF_MEM_LEVEL. These
-    // are the values that deflateInit() would use, but they’re not exported
-    // from zlib. deflateInit2() is used instead of deflateInit() to get the
-    // gzip wrapper.
-    constexpr int kZlibMaxWindowBits = 15;
-    constexpr int kZlibDefaultMemoryLevel = 8;
-
-    int zr = deflateInit2(z_stream_.get(),
-                          Z_DEFAULT_COMPRESSION,
-                          Z_DEFLATED,
-                          ZlibWindowBitsWithGzipWrapper(kZlibMaxWindowBits),
-                          kZlibDefaultMemoryLevel,
-                          Z_DEFAULT_STRATEGY);
+    int zr = GzipDeflateInit(z_stream_.get(), compression_);
     if (zr != Z_OK) {
       LOG(ERROR) << "deflateInit2: " << ZlibErrorString(zr);
       state_ = State::kError;
@@ -123,4 +168,355 @@ void GzipHTTPBodyStream::Done(State state) {
   }
 }
 
+// Compresses one block into a complete gzip member on its own thread. The
+// consumer hands a block over with Compress() and collects the result with
+// Wait(); the semaphores order every access to the buffers between the two.
+class ParallelGzipHTTPBodyStream::Worker final : public Thread {
+ public:
+  explicit Worker(const HTTPCompression& compression)
+      : Thread(),
+        compression_(compression),
+        start_(0),
+        done_(0),
+        input_(),
+        output_(),
+        output_offset_(0),
+        busy_(false),
+        collected_(false),
+        succeeded_(false),
+        exit_(false) {}
+
+  ~Worker() override {}
+
+  // The buffer to fill with the next block before calling Compress().
+  std::vector<uint8_t>* input() { return &input_; }
+
+  // Begins compressing input().
+  void Compress() {
+    DCHECK(!busy_);
+    busy_ = true;
+    collected_ = false;
+    output_offset_ = 0;
+    start_.Signal();
+  }
+
+  // Waits for the block to be compressed, returning whether it was.
+  bool Wait() {
+    DCHECK(busy_);
+    if (!collected_) {
+      done_.Wait();
+      collected_ = true;
+    }
+    return succeeded_;
+  }
+
+  // Copies up to |max_len| bytes of the compressed block not yet copied into
+  // |buffer|, returning the number copied. Once everything has been copied,
+  // the worker is no longer busy. Wait() must have returned true.
+  size_t Read(uint8_t* buffer, size_t max_len) {
+    DCHECK(collected_);
+    size_t size = std::min(max_len, output_.size() - output_offset_);
+    memcpy(buffer, &output_[output_offset_], size);
+    output_offset_ += size;
+    if (output_offset_ == output_.size()) {
+      busy_ = false;
+    }
+    return size;
+  }
+
+  // Whether a block has been started with Compress() and not yet entirely
+  // read.
+  bool busy() const { return busy_; }
+
+  // Waits for any compression in progress and joins the thread, which must
+  // have been started.
+  void Exit() {
+    if (busy_ && !collected_) {
+      done_.Wait();
+    }
+    exit_ = true;
+    start_.Signal();
+    Join();
+  }
+
+ private:
+  // Thread:
+  void ThreadMain() override {
+    while (true) {
+      start_.Wait();
+      if (exit_) {
+        return;
+      }
+      succeeded_ = Deflate();
+      done_.Signal();
+    }
+  }
+
+  bool Deflate() {
+    z_stream zlib = {};
+    int zr = GzipDeflateInit(&zlib, compression_);
+    if (zr != Z_OK) {
+      LOG(ERROR) << "deflateInit2: " << ZlibErrorString(zr);
+      return false;
+    }
+
+    // deflateBound() accounts for the gzip wrapper, so a single call to
+    // deflate() will always finish the member.
+    output_.resize(
+        deflateBound(&zlib, base::checked_cast<uLong>(input_.size())));
+    zlib.next_in = input_.empty() ? Z_NULL : &input_[0];
+    zlib.avail_in = base::checked_cast<uInt>(input_.size());
+    zlib.next_out = &output_[0];
+    zlib.avail_out = base::checked_cast<uInt>(output_.size());
+
+    zr = deflate(&zlib, Z_FINISH);
+    bool success = zr == Z_STREAM_END;
+    if (!success) {
+      LOG(ERROR) << "deflate: " << ZlibErrorString(zr);
+    } else {
+      output_.resize(output_.size() - zlib.avail_out);
+    }
+
+    zr = deflateEnd(&zlib);
+    if (zr != Z_OK) {
+      LOG(ERROR) << "deflateEnd: " << ZlibErrorString(zr);
+      success = false;
+    }
+
+    return success;
+  }
+
+  const HTTPCompression compression_;
+  Semaphore start_;
+  Semaphore done_;
+  std::vector<uint8_t> input_;
+  std::vector<uint8_t> output_;
+  size_t output_offset_;
+  bool busy_;
+  bool collected_;
+  bool succeeded_;
+  bool exit_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+// static
+constexpr size_t ParallelGzipHTTPBodyStream::kDefaultBlockSize;
+
+ParallelGzipHTTPBodyStream::ParallelGzipHTTPBodyStream(
+    std::unique_ptr<HTTPBodyStream> source,
+    const HTTPCompression& compression,
+    size_t thread_count,
+    size_t block_size)
+    : source_(std::move(source)),
+      workers_(),
+      compression_(compression),
+      block_size_(block_size),
+      next_worker_(0),
+      blocks_started_(0),
+      started_(false),
+      source_eof_(false),
+      error_(false) {
+  DCHECK_GE(thread_count, 1u);
+  DCHECK_GE(block_size, 1u);
+  for (size_t index = 0; index < thread_count; ++index) {
+    workers_.push_back(std::unique_ptr<Worker>(new Worker(compression_)));
+  }
+}
+
+ParallelGzipHTTPBodyStream::~ParallelGzipHTTPBodyStream() {
+  if (started_) {
+    for (const auto& worker : workers_) {
+      worker->Exit();
+    }
+  }
+}
+
+FileOperationResult ParallelGzipHTTPBodyStream::GetBytesBuffer(
+    uint8_t* buffer,
+    size_t max_len) {
+  if (error_) {
+    return -1;
+  }
+
+  if (!started_) {
+    started_ = true;
+    for (const auto& worker : workers_) {
+      worker->Start();
+    }
+    for (const auto& worker : workers_) {
+      if (!StartWorker(worker.get())) {
+        break;
+      }
+    }
+    if (error_) {
+      return -1;
+    }
+  }
+
+  // Blocks are handed to the workers in turn, so they are also collected in
+  // turn. The first worker found idle marks the end of the stream.
+  size_t copied = 0;
+  while (copied < max_len) {
+    Worker* worker = workers_[next_worker_].get();
+    if (!worker->busy()) {
+      break;
+    }
+
+    if (!worker->Wait()) {
+      error_ = true;
+      return -1;
+    }
+
+    copied += worker->Read(buffer + copied, max_len - copied);
+    if (!worker->busy()) {
+      StartWorker(worker);
+      if (error_) {
+        return -1;
+      }
+      next_worker_ = (next_worker_ + 1) % workers_.size();
+    }
+  }
+
+  return copied;
+}
+
+bool ParallelGzipHTTPBodyStream::StartWorker(Worker* worker) {
+  if (source_eof_) {
+    return false;
+  }
+
+  std::vector<uint8_t>* input = worker->input();
+  input->resize(block_size_);
+  size_t size = 0;
+  while (size < block_size_) {
+    FileOperationResult bytes =
+        source_->GetBytesBuffer(&(*input)[size], block_size_ - size);
+    if (bytes < 0) {
+      error_ = true;
+      return false;
+    }
+    if (bytes == 0) {
+      source_eof_ = true;
+      break;
+    }
+    size += bytes;
+  }
+  input->resize(size);
+
+  // Empty input still needs one member to be a valid gzip stream.
+  if (size == 0 && blocks_started_ > 0) {
+    return false;
+  }
+
+  ++blocks_started_;
+  worker->Compress();
+  return true;
+}
+
+BlockCompressedFileGzipHTTPBodyStream::BlockCompressedFileGzipHTTPBodyStream(
+    BlockCompressedFileReader* reader)
+    : member_(),
+      reader_(reader),
+      member_offset_(0),
+      next_block_(0),
+      started_(false),
+      error_(false) {}
+
+BlockCompressedFileGzipHTTPBodyStream::
+    ~BlockCompressedFileGzipHTTPBodyStream() {}
+
+FileOperationResult BlockCompressedFileGzipHTTPBodyStream::GetBytesBuffer(
+    uint8_t* buffer,
+    size_t max_len) {
+  if (error_) {
+    return -1;
+  }
+
+  size_t copied = 0;
+  while (copied < max_len) {
+    if (member_offset_ == member_.size()) {
+      if (started_ && next_block_ >= reader_->BlockCount()) {
+        break;
+      }
+      if (!LoadMember()) {
+        error_ = true;
+        return -1;
+      }
+    }
+
+    size_t size = std::min(max_len - copied, member_.size() - member_offset_);
+    memcpy(buffer + copied, &member_[member_offset_], size);
+    member_offset_ += size;
+    copied += size;
+  }
+
+  return copied;
+}
+
+bool BlockCompressedFileGzipHTTPBodyStream::LoadMember() {
+  // A gzip stream needs at least one member, so a file with no blocks is
+  // represented by a member holding an empty stored block.
+  static const std::string kEmpty;
+  const std::string* data = &kEmpty;
+  const std::string* zlib_data = nullptr;
+  if (next_block_ < reader_->BlockCount()) {
+    if (!reader_->ReadBlock(next_block_, &data, &zlib_data)) {
+      return false;
+    }
+    ++next_block_;
+  }
+  started_ = true;
+
+  // RFC 1952 §2.3: ID1, ID2, CM (deflate), FLG, MTIME, XFL, and OS (unknown).
+  static constexpr uint8_t kGzipHeader[] =
+      {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff};
+  member_.assign(reinterpret_cast<const char*>(kGzipHeader),
+                 sizeof(kGzipHeader));
+
+  if (zlib_data) {
+    // RFC 1950 §2.2: the deflate data lies between a two-byte header, which
+    // must name the deflate method and no preset dictionary, and the four-byte
+    // Adler-32 checksum.
+    constexpr size_t kZlibHeaderSize = 2;
+    constexpr size_t kZlibTrailerSize = 4;
+    if (zlib_data->size() < kZlibHeaderSize + kZlibTrailerSize ||
+        ((*zlib_data)[0] & 0x0f) != Z_DEFLATED ||
+        ((*zlib_data)[1] & 0x20) != 0) {
+      LOG(ERROR) << "unexpected zlib stream in block " << next_block_ - 1;
+      return false;
+    }
+    member_.append(*zlib_data,
+                   kZlibHeaderSize,
+                   zlib_data->size() - kZlibHeaderSize - kZlibTrailerSize);
+  } else {
+    // RFC 1951 §3.2.4: stored blocks of up to 65535 bytes, the last with
+    // BFINAL set.
+    constexpr size_t kMaxStoredSize = 0xffff;
+    size_t offset = 0;
+    do {
+      size_t size = std::min(data->size() - offset, kMaxStoredSize);
+      bool last = offset + size == data->size();
+      member_.push_back(last ? 1 : 0);
+      member_.push_back(static_cast<char>(size));
+      member_.push_back(static_cast<char>(size >> 8));
+      member_.push_back(static_cast<char>(~size));
+      member_.push_back(static_cast<char>(~size >> 8));
+      member_.append(*data, offset, size);
+      offset += size;
+    } while (offset < data->size());
+  }
+
+  // RFC 1952 §2.3.1: CRC32 and ISIZE.
+  uLong crc = crc32(0, Z_NULL, 0);
+  crc = crc32(crc,
+              reinterpret_cast<const Bytef*>(data->data()),
+              base::checked_cast<uInt>(data->size()));
+  AppendLittleEndian32(&member_, static_cast<uint32_t>(crc));
+  AppendLittleEndian32(&member_, static_cast<uint32_t>(data->size()));
+
+  member_offset_ = 0;
+  return true;
+}
+
 }  // namespace crashpad
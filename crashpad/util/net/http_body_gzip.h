@@ -19,10 +19,13 @@
 #include <sys/types.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "base/macros.h"
 #include "util/file/file_io.h"
 #include "util/net/http_body.h"
+#include "util/net/http_body_compression.h"
 
 extern "C" {
 typedef struct z_stream_s z_stream;
@@ -30,12 +33,20 @@ typedef struct z_stream_s z_stream;
 
 namespace crashpad {
 
+class BlockCompressedFileReader;
+
 //! \brief An implementation of HTTPBodyStream that `gzip`-compresses another
 //!     HTTPBodyStream.
 class GzipHTTPBodyStream : public HTTPBodyStream {
  public:
+  //! \brief Compresses \a source at zlib’s default level and strategy.
   explicit GzipHTTPBodyStream(std::unique_ptr<HTTPBodyStream> source);
 
+  //! \brief Compresses \a source at the level and with the strategy given by
+  //!     \a compression, whose HTTPCompression::coding is disregarded.
+  GzipHTTPBodyStream(std::unique_ptr<HTTPBodyStream> source,
+                     const HTTPCompression& compression);
+
   ~GzipHTTPBodyStream() override;
 
   // HTTPBodyStream:
@@ -57,11 +68,104 @@ class GzipHTTPBodyStream : public HTTPBodyStream {
   uint8_t input_[4096];
   std::unique_ptr<HTTPBodyStream> source_;
   std::unique_ptr<z_stream> z_stream_;
+  HTTPCompression compression_;
   State state_;
 
   DISALLOW_COPY_AND_ASSIGN(GzipHTTPBodyStream);
 };
 
+//! \brief An implementation of HTTPBodyStream that `gzip`-compresses another
+//!     HTTPBodyStream on several threads.
+//!
+//! The source is divided into blocks, each compressed independently into its
+//! own `gzip` member on a worker thread, and the members are concatenated in
+//! order, as `pigz` does. Per RFC 1952 §2.2, the result is a valid `gzip`
+//! stream, decompressing to the source, though it will be slightly larger than
+//! the output of GzipHTTPBodyStream because no block can refer to data in the
+//! blocks before it.
+//!
+//! The source is read on the thread calling GetBytesBuffer(), one block ahead
+//! of each worker, so at most `(thread_count + 1) * block_size` bytes of input
+//! and the corresponding output are held at once.
+class ParallelGzipHTTPBodyStream : public HTTPBodyStream {
+ public:
+  //! \brief The default size of each block, in bytes.
+  static constexpr size_t kDefaultBlockSize = 1024 * 1024;
+
+  //! \param[in] source The stream to compress.
+  //! \param[in] compression The level and strategy to compress with. Its
+  //!     HTTPCompression::coding and HTTPCompression::threads are disregarded.
+  //! \param[in] thread_count The number of worker threads, at least `1`.
+  //! \param[in] block_size The size of each block, in bytes. Larger blocks
+  //!     compress better, and smaller blocks need less memory.
+  ParallelGzipHTTPBodyStream(std::unique_ptr<HTTPBodyStream> source,
+                             const HTTPCompression& compression,
+                             size_t thread_count,
+                             size_t block_size);
+
+  ~ParallelGzipHTTPBodyStream() override;
+
+  // HTTPBodyStream:
+  FileOperationResult GetBytesBuffer(uint8_t* buffer, size_t max_len) override;
+
+ private:
+  class Worker;
+
+  // Reads the next block from source_ into |worker| and starts compressing it.
+  // Returns true if the worker was started, or false if there is no more input
+  // or if reading failed, in which case error_ is set.
+  bool StartWorker(Worker* worker);
+
+  std::unique_ptr<HTTPBodyStream> source_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  HTTPCompression compression_;
+  size_t block_size_;
+  size_t next_worker_;
+  uint64_t blocks_started_;
+  bool started_;
+  bool source_eof_;
+  bool error_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelGzipHTTPBodyStream);
+};
+
+//! \brief An implementation of HTTPBodyStream that produces a `gzip` stream
+//!     from a block-compressed file without compressing it again.
+//!
+//! Each block of the file becomes its own `gzip` member, as with
+//! ParallelGzipHTTPBodyStream. A block stored as a zlib stream already carries
+//! the deflate data that a `gzip` member needs, so only its CRC-32 must be
+//! computed, from the decompressed block. A block stored without compression
+//! is wrapped in deflate stored blocks.
+class BlockCompressedFileGzipHTTPBodyStream : public HTTPBodyStream {
+ public:
+  //! \param[in] reader An initialized reader for the block-compressed file.
+  //!     This object does not take ownership of \a reader, which must outlive
+  //!     it.
+  explicit BlockCompressedFileGzipHTTPBodyStream(
+      BlockCompressedFileReader* reader);
+
+  ~BlockCompressedFileGzipHTTPBodyStream() override;
+
+  // HTTPBodyStream:
+  FileOperationResult GetBytesBuffer(uint8_t* buffer, size_t max_len) override;
+
+ private:
+  // Replaces member_ with the gzip member for the next block, or with an empty
+  // member if the file has no blocks. Returns false with a message logged on
+  // failure.
+  bool LoadMember();
+
+  std::string member_;
+  BlockCompressedFileReader* reader_;  // weak
+  size_t member_offset_;
+  size_t next_block_;
+  bool started_;
+  bool error_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockCompressedFileGzipHTTPBodyStream);
+};
+
 }  // namespace crashpad
 
 #endif  // CRASHPAD_UTIL_NET_HTTP_BODY_GZIP_H_
@@ -24,10 +24,15 @@
 #include "base/macros.h"
 #include "base/rand_util.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/strings/stringprintf.h"
 #include "gtest/gtest.h"
 #include "third_party/zlib/zlib_crashpad.h"
+#include "util/file/block_compressed_file_reader.h"
+#include "util/file/block_compressed_file_writer.h"
+#include "util/file/string_file.h"
 #include "util/misc/zlib.h"
 #include "util/net/http_body.h"
+#include "util/net/http_body_test_util.h"
 
 namespace crashpad {
 namespace test {
@@ -76,10 +81,11 @@ void GzipInflate(const std::string& compressed,
                        buf_size - zlib.avail_out);
 }
 
-void TestGzipDeflateInflate(const std::string& string) {
+void TestGzipDeflateInflate(const std::string& string,
+                            const HTTPCompression& compression) {
   std::unique_ptr<HTTPBodyStream> string_stream(
       new StringHTTPBodyStream(string));
-  GzipHTTPBodyStream gzip_stream(std::move(string_stream));
+  GzipHTTPBodyStream gzip_stream(std::move(string_stream), compression);
 
   // The minimum size of a gzip wrapper per RFC 1952: a 10-byte header and an
   // 8-byte trailer.
@@ -117,7 +123,7 @@ void TestGzipDeflateInflate(const std::string& string) {
 
   // In block mode, compression should be identical.
   string_stream.reset(new StringHTTPBodyStream(string));
-  GzipHTTPBodyStream block_gzip_stream(std::move(string_stream));
+  GzipHTTPBodyStream block_gzip_stream(std::move(string_stream), compression);
   uint8_t block_buf[4096];
   std::string block_compressed;
   FileOperationResult block_compressed_bytes;
@@ -130,6 +136,10 @@ void TestGzipDeflateInflate(const std::string& string) {
   EXPECT_EQ(block_compressed, compressed);
 }
 
+void TestGzipDeflateInflate(const std::string& string) {
+  TestGzipDeflateInflate(string, HTTPCompression(HTTPContentCoding::kGzip));
+}
+
 std::string MakeString(size_t size) {
   std::string string;
   for (size_t i = 0; i < size; ++i) {
@@ -173,6 +183,170 @@ TEST(GzipHTTPBodyStream, ManyBytes_Random) {
   TestGzipDeflateInflate(base::RandBytesAsString(kManyBytes));
 }
 
+TEST(GzipHTTPBodyStream, LevelsAndStrategies) {
+  const std::string string = MakeString(kManyBytes);
+
+  for (int level : {1, 9}) {
+    SCOPED_TRACE(level);
+    HTTPCompression compression(HTTPContentCoding::kGzip);
+    compression.level = level;
+    TestGzipDeflateInflate(string, compression);
+  }
+
+  static constexpr HTTPCompression::Strategy kStrategies[] = {
+      HTTPCompression::Strategy::kFiltered,
+      HTTPCompression::Strategy::kRunLength,
+      HTTPCompression::Strategy::kHuffmanOnly,
+  };
+  for (HTTPCompression::Strategy strategy : kStrategies) {
+    SCOPED_TRACE(static_cast<int>(strategy));
+    HTTPCompression compression(HTTPContentCoding::kGzip);
+    compression.strategy = strategy;
+    TestGzipDeflateInflate(string, compression);
+  }
+}
+
+void TestParallelGzipDeflateInflate(const std::string& string,
+                                    size_t thread_count,
+                                    size_t block_size,
+                                    size_t read_size) {
+  SCOPED_TRACE(base::StringPrintf(
+      "%zu threads, %zu-byte blocks, %zu-byte reads",
+      thread_count,
+      block_size,
+      read_size));
+
+  ParallelGzipHTTPBodyStream gzip_stream(
+      std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream(string)),
+      HTTPCompression(HTTPContentCoding::kGzip),
+      thread_count,
+      block_size);
+
+  std::unique_ptr<uint8_t[]> buf(new uint8_t[read_size]);
+  std::string compressed;
+  FileOperationResult compressed_bytes;
+  while ((compressed_bytes = gzip_stream.GetBytesBuffer(buf.get(),
+                                                        read_size)) > 0) {
+    compressed.append(reinterpret_cast<char*>(buf.get()), compressed_bytes);
+  }
+  ASSERT_EQ(compressed_bytes, 0);
+  ASSERT_EQ(gzip_stream.GetBytesBuffer(buf.get(), read_size), 0);
+
+  ASSERT_GE(compressed.size(), 2u);
+  EXPECT_EQ(compressed[0], '\37');
+  EXPECT_EQ(compressed[1], '\213');
+
+  size_t members;
+  EXPECT_EQ(GzipInflateToString(compressed, &members), string);
+  EXPECT_EQ(members,
+            string.empty() ? 1 : (string.size() + block_size - 1) / block_size);
+}
+
+TEST(ParallelGzipHTTPBodyStream, Empty) {
+  TestParallelGzipDeflateInflate(std::string(), 2, 1024, 4096);
+}
+
+TEST(ParallelGzipHTTPBodyStream, OneBlock) {
+  TestParallelGzipDeflateInflate(MakeString(kFourKBytes), 4, 65536, 4096);
+}
+
+TEST(ParallelGzipHTTPBodyStream, ManyBlocks) {
+  const std::string string = MakeString(kManyBytes);
+  for (size_t thread_count : {1, 3, 8}) {
+    TestParallelGzipDeflateInflate(string, thread_count, 10000, 4096);
+    TestParallelGzipDeflateInflate(string, thread_count, 65536, 1);
+  }
+  TestParallelGzipDeflateInflate(
+      base::RandBytesAsString(kManyBytes), 4, 32768, 65536);
+}
+
+TEST(ParallelGzipHTTPBodyStream, ExactBlocks) {
+  TestParallelGzipDeflateInflate(MakeString(4 * kFourKBytes),
+                                 2,
+                                 kFourKBytes,
+                                 kFourKBytes);
+}
+
+TEST(ParallelGzipHTTPBodyStream, UnreadStream) {
+  // Destroying a stream with blocks still being compressed must not hang.
+  ParallelGzipHTTPBodyStream gzip_stream(
+      std::unique_ptr<HTTPBodyStream>(
+          new StringHTTPBodyStream(MakeString(kManyBytes))),
+      HTTPCompression(HTTPContentCoding::kGzip),
+      4,
+      1024);
+  uint8_t buf[16];
+  EXPECT_EQ(gzip_stream.GetBytesBuffer(buf, sizeof(buf)),
+            static_cast<FileOperationResult>(sizeof(buf)));
+}
+
+void TestBlockCompressedFileGzip(const std::string& string,
+                                 size_t block_size) {
+  SCOPED_TRACE(base::StringPrintf("%zu-byte blocks", block_size));
+
+  StringFile string_file;
+  BlockCompressedFileWriter writer(&string_file, block_size);
+  ASSERT_TRUE(writer.Write(string.data(), string.size()));
+  ASSERT_TRUE(writer.Close());
+
+  ASSERT_TRUE(string_file.SeekSet(0));
+  BlockCompressedFileReader reader;
+  ASSERT_TRUE(reader.Initialize(&string_file));
+
+  BlockCompressedFileGzipHTTPBodyStream gzip_stream(&reader);
+  std::string compressed = ReadStreamToString(&gzip_stream, 4096);
+  uint8_t buf[16];
+  ASSERT_EQ(gzip_stream.GetBytesBuffer(buf, sizeof(buf)), 0);
+
+  size_t members;
+  EXPECT_EQ(GzipInflateToString(compressed, &members), string);
+  EXPECT_EQ(members, std::max(reader.BlockCount(), size_t{1}));
+}
+
+TEST(BlockCompressedFileGzipHTTPBodyStream, Empty) {
+  TestBlockCompressedFileGzip(std::string(), 4096);
+}
+
+TEST(BlockCompressedFileGzipHTTPBodyStream, CompressedBlocks) {
+  TestBlockCompressedFileGzip(MakeString(kManyBytes), 65536);
+}
+
+TEST(BlockCompressedFileGzipHTTPBodyStream, StoredBlocks) {
+  // Random data is stored without compression. Blocks larger than 65535 bytes
+  // need several deflate stored blocks.
+  const std::string string = base::RandBytesAsString(kManyBytes);
+  TestBlockCompressedFileGzip(string, 1000);
+  TestBlockCompressedFileGzip(string, 100000);
+}
+
+TEST(BlockCompressedFileGzipHTTPBodyStream, MixedBlocks) {
+  const std::string string = MakeString(kManyBytes) +
+                             base::RandBytesAsString(kManyBytes) +
+                             MakeString(kFourKBytes);
+  TestBlockCompressedFileGzip(string, 32768);
+}
+
+TEST(GzipHTTPBodyStream, CreateCompressingHTTPBodyStream) {
+  EXPECT_STREQ(HTTPContentCodingName(HTTPContentCoding::kGzip), "gzip");
+  EXPECT_EQ(HTTPContentCodingName(HTTPContentCoding::kIdentity), nullptr);
+
+  // The identity coding passes the source through.
+  HTTPBodyStream* source = new StringHTTPBodyStream("identity");
+  std::unique_ptr<HTTPBodyStream> stream = CreateCompressingHTTPBodyStream(
+      HTTPCompression(), std::unique_ptr<HTTPBodyStream>(source));
+  EXPECT_EQ(stream.get(), source);
+
+  stream = CreateCompressingHTTPBodyStream(
+      HTTPCompression(HTTPContentCoding::kGzip),
+      std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream("gzip")));
+  uint8_t buf[64];
+  FileOperationResult compressed_bytes =
+      stream->GetBytesBuffer(buf, sizeof(buf));
+  ASSERT_GT(compressed_bytes, 2);
+  EXPECT_EQ(buf[0], 037);
+  EXPECT_EQ(buf[1], 0213);
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
@@ -0,0 +1,190 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/http_body_pipe.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+HTTPBodyPipe::Writer::Writer(HTTPBodyPipe* pipe)
+    : FileWriterInterface(), pipe_(pipe), offset_(0) {
+}
+
+HTTPBodyPipe::Writer::~Writer() {
+}
+
+bool HTTPBodyPipe::Writer::Write(const void* data, size_t size) {
+  if (!pipe_->Write(data, size)) {
+    return false;
+  }
+
+  offset_ += size;
+  return true;
+}
+
+bool HTTPBodyPipe::Writer::WriteIoVec(std::vector<WritableIoVec>* iovecs) {
+  if (iovecs->empty()) {
+    LOG(ERROR) << "WriteIoVec(): no iovecs";
+    return false;
+  }
+
+  for (const WritableIoVec& iov : *iovecs) {
+    if (!Write(iov.iov_base, iov.iov_len)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+FileOffset HTTPBodyPipe::Writer::Seek(FileOffset offset, int whence) {
+  if (offset != 0 || whence != SEEK_CUR) {
+    LOG(ERROR) << "HTTPBodyPipe can't seek";
+    return -1;
+  }
+
+  return offset_;
+}
+
+HTTPBodyPipe::HTTPBodyPipe(size_t capacity)
+    : HTTPBodyStream(),
+      lock_(),
+      readable_(0),
+      writable_(0),
+      buffer_(capacity),
+      read_index_(0),
+      buffered_size_(0),
+      reader_waiting_(false),
+      writer_waiting_(false),
+      write_closed_(false),
+      write_succeeded_(false),
+      read_closed_(false),
+      writer_(this) {
+  DCHECK_GT(capacity, 0u);
+}
+
+HTTPBodyPipe::~HTTPBodyPipe() {
+  DCHECK(!reader_waiting_);
+  DCHECK(!writer_waiting_);
+}
+
+void HTTPBodyPipe::CloseWrite(bool success) {
+  base::AutoLock lock_owner(lock_);
+  DCHECK(!write_closed_);
+  write_closed_ = true;
+  write_succeeded_ = success;
+
+  if (reader_waiting_) {
+    reader_waiting_ = false;
+    readable_.Signal();
+  }
+}
+
+void HTTPBodyPipe::CloseRead() {
+  base::AutoLock lock_owner(lock_);
+  read_closed_ = true;
+
+  if (writer_waiting_) {
+    writer_waiting_ = false;
+    writable_.Signal();
+  }
+}
+
+FileOperationResult HTTPBodyPipe::GetBytesBuffer(uint8_t* buffer,
+                                                 size_t max_len) {
+  DCHECK_GT(max_len, 0u);
+
+  while (true) {
+    {
+      base::AutoLock lock_owner(lock_);
+      DCHECK(!read_closed_);
+
+      if (write_closed_ && !write_succeeded_) {
+        LOG(ERROR) << "HTTPBodyPipe writer failed";
+        return -1;
+      }
+
+      if (buffered_size_) {
+        size_t chunk = std::min(
+            std::min(max_len, buffered_size_), buffer_.size() - read_index_);
+        memcpy(buffer, &buffer_[read_index_], chunk);
+        read_index_ = (read_index_ + chunk) % buffer_.size();
+        buffered_size_ -= chunk;
+
+        if (writer_waiting_) {
+          writer_waiting_ = false;
+          writable_.Signal();
+        }
+
+        return chunk;
+      }
+
+      if (write_closed_) {
+        return 0;
+      }
+
+      reader_waiting_ = true;
+    }
+
+    readable_.Wait();
+  }
+}
+
+bool HTTPBodyPipe::Write(const void* data, size_t size) {
+  const uint8_t* data_u8 = static_cast<const uint8_t*>(data);
+
+  while (size > 0) {
+    {
+      base::AutoLock lock_owner(lock_);
+      DCHECK(!write_closed_);
+
+      if (read_closed_) {
+        LOG(ERROR) << "HTTPBodyPipe reader closed";
+        return false;
+      }
+
+      size_t room = buffer_.size() - buffered_size_;
+      if (room) {
+        size_t write_index = (read_index_ + buffered_size_) % buffer_.size();
+        size_t chunk =
+            std::min(std::min(size, room), buffer_.size() - write_index);
+        memcpy(&buffer_[write_index], data_u8, chunk);
+        buffered_size_ += chunk;
+        data_u8 += chunk;
+        size -= chunk;
+
+        if (reader_waiting_) {
+          reader_waiting_ = false;
+          readable_.Signal();
+        }
+
+        continue;
+      }
+
+      writer_waiting_ = true;
+    }
+
+    writable_.Wait();
+  }
+
+  return true;
+}
+
+}  // namespace crashpad
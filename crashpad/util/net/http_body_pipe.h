@@ -0,0 +1,128 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_NET_HTTP_BODY_PIPE_H_
+#define CRASHPAD_UTIL_NET_HTTP_BODY_PIPE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "util/file/file_io.h"
+#include "util/file/file_writer.h"
+#include "util/net/http_body.h"
+#include "util/synchronization/semaphore.h"
+
+namespace crashpad {
+
+//! \brief An HTTPBodyStream whose contents are supplied, as they are read,
+//!     through a FileWriterInterface.
+//!
+//! This connects a producer, such as MinidumpFileWriter::WriteMinidump() with
+//! `allow_seek` set to `false`, to a consumer, such as HTTPTransport, through
+//! a bounded buffer, so that data can be uploaded as it is produced without
+//! being stored in its entirety. The producer and consumer must run on
+//! different threads: writes block while the buffer is full, and
+//! GetBytesBuffer() blocks while it is empty.
+//!
+//! The producer must call CloseWrite() once it has finished, successfully or
+//! not. The consumer must call CloseRead() once it will read no more, so that
+//! a producer blocked on a full buffer is released if the consumer gives up
+//! early.
+class HTTPBodyPipe : public HTTPBodyStream {
+ public:
+  //! \brief The default size of the buffer, in bytes.
+  static constexpr size_t kDefaultCapacity = 256 * 1024;
+
+  //! \param[in] capacity The size of the buffer, in bytes.
+  explicit HTTPBodyPipe(size_t capacity);
+  ~HTTPBodyPipe() override;
+
+  //! \brief Returns the producer’s side of the pipe.
+  //!
+  //! The returned object supports Seek() only to obtain the current position,
+  //! as `Seek(0, SEEK_CUR)`. Its writes fail once CloseRead() has been called.
+  //! It is owned by this object.
+  FileWriterInterface* writer() { return &writer_; }
+
+  //! \brief Indicates that the producer has finished writing.
+  //!
+  //! \param[in] success Whether the producer wrote everything that it intended
+  //!     to. If `true`, the consumer will see the end of the stream once it has
+  //!     read all buffered data. If `false`, the consumer will see an error
+  //!     instead, so that an incomplete body is not mistaken for a complete
+  //!     one.
+  void CloseWrite(bool success);
+
+  //! \brief Indicates that the consumer will read no more data.
+  void CloseRead();
+
+  // HTTPBodyStream:
+  FileOperationResult GetBytesBuffer(uint8_t* buffer, size_t max_len) override;
+
+ private:
+  class Writer final : public FileWriterInterface {
+   public:
+    explicit Writer(HTTPBodyPipe* pipe);
+    ~Writer() override;
+
+    // FileWriterInterface:
+    bool Write(const void* data, size_t size) override;
+    bool WriteIoVec(std::vector<WritableIoVec>* iovecs) override;
+
+    // FileSeekerInterface:
+    FileOffset Seek(FileOffset offset, int whence) override;
+
+   private:
+    HTTPBodyPipe* pipe_;  // weak
+    FileOffset offset_;
+
+    DISALLOW_COPY_AND_ASSIGN(Writer);
+  };
+
+  // Copies |size| bytes from |data| into the buffer, waiting for room as
+  // necessary. Called by Writer.
+  bool Write(const void* data, size_t size);
+
+  // Guards every member below other than the semaphores.
+  base::Lock lock_;
+
+  // Signaled when data is added or the pipe is closed, if the consumer is
+  // waiting.
+  Semaphore readable_;
+
+  // Signaled when data is removed or the pipe is closed, if the producer is
+  // waiting.
+  Semaphore writable_;
+
+  std::vector<uint8_t> buffer_;
+  size_t read_index_;
+  size_t buffered_size_;
+  bool reader_waiting_;
+  bool writer_waiting_;
+  bool write_closed_;
+  bool write_succeeded_;
+  bool read_closed_;
+
+  Writer writer_;
+
+  DISALLOW_COPY_AND_ASSIGN(HTTPBodyPipe);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_NET_HTTP_BODY_PIPE_H_
@@ -0,0 +1,147 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/http_body_pipe.h"
+
+#include <algorithm>
+#include <string>
+
+#include "base/macros.h"
+#include "gtest/gtest.h"
+#include "util/net/http_body_test_util.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+// Writes |data| to |pipe| in pieces of |piece_size| bytes, then closes the
+// pipe with |success|.
+class ProducerThread : public Thread {
+ public:
+  ProducerThread(HTTPBodyPipe* pipe,
+                 const std::string& data,
+                 size_t piece_size,
+                 bool success)
+      : Thread(),
+        pipe_(pipe),
+        data_(data),
+        piece_size_(piece_size),
+        success_(success),
+        write_result_(false) {}
+
+  ~ProducerThread() override {}
+
+  bool write_result() const { return write_result_; }
+
+ private:
+  void ThreadMain() override {
+    write_result_ = true;
+    for (size_t offset = 0; offset < data_.size(); offset += piece_size_) {
+      size_t size = std::min(piece_size_, data_.size() - offset);
+      if (!pipe_->writer()->Write(&data_[offset], size)) {
+        write_result_ = false;
+        break;
+      }
+    }
+    pipe_->CloseWrite(write_result_ && success_);
+  }
+
+  HTTPBodyPipe* pipe_;  // weak
+  std::string data_;
+  size_t piece_size_;
+  bool success_;
+  bool write_result_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProducerThread);
+};
+
+std::string MakeData(size_t size) {
+  std::string data(size, '\0');
+  for (size_t index = 0; index < size; ++index) {
+    data[index] = static_cast<char>('a' + index % 26);
+  }
+  return data;
+}
+
+TEST(HTTPBodyPipe, Empty) {
+  HTTPBodyPipe pipe(16);
+  ProducerThread producer(&pipe, std::string(), 1, true);
+  producer.Start();
+  EXPECT_EQ(ReadStreamToString(&pipe), std::string());
+  pipe.CloseRead();
+  producer.Join();
+  EXPECT_TRUE(producer.write_result());
+}
+
+TEST(HTTPBodyPipe, RoundTrip) {
+  // Piece and read sizes that don’t divide the capacity exercise wraparound.
+  const std::string data = MakeData(10000);
+  for (size_t piece_size : {1u, 7u, 16u, 100u}) {
+    SCOPED_TRACE(piece_size);
+    for (size_t read_size : {1u, 5u, 16u, 64u}) {
+      SCOPED_TRACE(read_size);
+      HTTPBodyPipe pipe(16);
+      ProducerThread producer(&pipe, data, piece_size, true);
+      producer.Start();
+      EXPECT_EQ(ReadStreamToString(&pipe, read_size), data);
+      pipe.CloseRead();
+      producer.Join();
+      EXPECT_TRUE(producer.write_result());
+    }
+  }
+}
+
+TEST(HTTPBodyPipe, Seek) {
+  HTTPBodyPipe pipe(16);
+  EXPECT_EQ(pipe.writer()->Seek(0, SEEK_CUR), 0);
+  ASSERT_TRUE(pipe.writer()->Write("abc", 3));
+  EXPECT_EQ(pipe.writer()->Seek(0, SEEK_CUR), 3);
+  EXPECT_EQ(pipe.writer()->Seek(0, SEEK_SET), -1);
+  EXPECT_EQ(pipe.writer()->Seek(1, SEEK_CUR), -1);
+  pipe.CloseWrite(true);
+  EXPECT_EQ(ReadStreamToString(&pipe), "abc");
+  pipe.CloseRead();
+}
+
+TEST(HTTPBodyPipe, WriteFailure) {
+  HTTPBodyPipe pipe(16);
+  ProducerThread producer(&pipe, MakeData(8), 8, false);
+  producer.Start();
+  producer.Join();
+
+  // The consumer sees an error rather than a truncated body.
+  uint8_t buffer[16];
+  EXPECT_EQ(pipe.GetBytesBuffer(buffer, sizeof(buffer)), -1);
+  pipe.CloseRead();
+}
+
+TEST(HTTPBodyPipe, ReaderGivesUp) {
+  HTTPBodyPipe pipe(16);
+  ProducerThread producer(&pipe, MakeData(1000), 10, true);
+  producer.Start();
+
+  uint8_t buffer[4];
+  EXPECT_EQ(pipe.GetBytesBuffer(buffer, sizeof(buffer)), 4);
+
+  // The producer is blocked on a full buffer, or will be soon. Closing the
+  // read side must release it.
+  pipe.CloseRead();
+  producer.Join();
+  EXPECT_FALSE(producer.write_result());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -18,8 +18,11 @@
 
 #include <memory>
 
+#include "base/numerics/safe_conversions.h"
 #include "gtest/gtest.h"
+#include "third_party/zlib/zlib_crashpad.h"
 #include "util/file/file_io.h"
+#include "util/misc/zlib.h"
 #include "util/net/http_body.h"
 
 namespace crashpad {
@@ -46,5 +49,64 @@ std::string ReadStreamToString(HTTPBodyStream* stream, size_t buffer_size) {
   return result;
 }
 
+std::string GzipInflateToString(const std::string& compressed,
+                                size_t* members) {
+  size_t member_count = 0;
+  if (members) {
+    *members = 0;
+  }
+
+  z_stream zlib = {};
+  zlib.zalloc = Z_NULL;
+  zlib.zfree = Z_NULL;
+  zlib.opaque = Z_NULL;
+  zlib.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+  zlib.avail_in = base::checked_cast<uInt>(compressed.size());
+
+  int zr = inflateInit2(&zlib, ZlibWindowBitsWithGzipWrapper(0));
+  if (zr != Z_OK) {
+    ADD_FAILURE() << "inflateInit2: " << ZlibErrorString(zr);
+    return std::string();
+  }
+
+  std::string result;
+  uint8_t buf[4096];
+  bool member_ended = false;
+  while (zlib.avail_in > 0 || (!member_ended && zr != Z_BUF_ERROR)) {
+    if (member_ended) {
+      zr = inflateReset(&zlib);
+      if (zr != Z_OK) {
+        break;
+      }
+    }
+
+    zlib.next_out = buf;
+    zlib.avail_out = sizeof(buf);
+    zr = inflate(&zlib, Z_NO_FLUSH);
+    if (zr != Z_OK && zr != Z_STREAM_END && zr != Z_BUF_ERROR) {
+      break;
+    }
+    result.append(reinterpret_cast<char*>(buf), sizeof(buf) - zlib.avail_out);
+
+    member_ended = zr == Z_STREAM_END;
+    if (member_ended) {
+      ++member_count;
+    }
+  }
+
+  int end_zr = inflateEnd(&zlib);
+  EXPECT_EQ(end_zr, Z_OK) << "inflateEnd: " << ZlibErrorString(end_zr);
+
+  if (!member_ended) {
+    ADD_FAILURE() << "inflate: " << ZlibErrorString(zr);
+    return std::string();
+  }
+
+  if (members) {
+    *members = member_count;
+  }
+  return result;
+}
+
 }  // namespace test
 }  // namespace crashpad
@@ -43,6 +43,17 @@ std::string ReadStreamToString(HTTPBodyStream* stream);
 //! \return The contents of the stream, or an empty string on failure.
 std::string ReadStreamToString(HTTPBodyStream* stream, size_t buffer_size);
 
+//! \brief Decompresses `gzip`-compressed data to a string. If an error occurs,
+//!     adds a test failure and returns an empty string.
+//!
+//! \param[in] compressed The data to decompress. This may consist of several
+//!     concatenated `gzip` members, as permitted by RFC 1952 §2.2.
+//! \param[out] members If not `nullptr`, the number of members in \a
+//!     compressed.
+//!
+//! \return The decompressed data, or an empty string on failure.
+std::string GzipInflateToString(const std::string& compressed, size_t* members);
+
 }  // namespace test
 }  // namespace crashpad
 
@@ -14,6 +14,7 @@
 
 #include "util/net/http_multipart_builder.h"
 
+#include <string.h>
 #include <sys/types.h>
 
 #include <utility>
@@ -22,8 +23,9 @@
 #include "base/logging.h"
 #include "base/rand_util.h"
 #include "base/strings/stringprintf.h"
+#include "util/file/file_io.h"
 #include "util/net/http_body.h"
-#include "util/net/http_body_gzip.h"
+#include "util/net/http_body_compression.h"
 
 namespace crashpad {
 
@@ -95,6 +97,37 @@ std::string GetFormDataBoundary(const std::string& boundary,
       EncodeMIMEField(name).c_str());
 }
 
+// Returns a form-data part, formatted with a multipart boundary, carrying
+// |value| at |name|.
+std::string GetFormDataPart(const std::string& boundary,
+                            const std::string& name,
+                            const std::string& value) {
+  std::string part = GetFormDataBoundary(boundary, name);
+  part += kBoundaryCRLF;
+  part += value;
+  part += kCRLF;
+  return part;
+}
+
+// Returns the header of a file attachment part, formatted with a multipart
+// boundary and a field name, after which the attachment’s contents and a
+// CRLF can be appended.
+std::string GetFileAttachmentHeader(const std::string& boundary,
+                                    const std::string& name,
+                                    const std::string& filename,
+                                    const std::string& content_type) {
+  std::string header = GetFormDataBoundary(boundary, name);
+  header += base::StringPrintf("; filename=\"%s\"%s", filename.c_str(), kCRLF);
+  header += base::StringPrintf(
+      "Content-Type: %s%s", content_type.c_str(), kBoundaryCRLF);
+  return header;
+}
+
+// Returns the delimiter that closes a multipart body.
+std::string GetCloseDelimiter(const std::string& boundary) {
+  return "--" + boundary + "--" + kCRLF;
+}
+
 void AssertSafeMIMEType(const std::string& string) {
   for (size_t i = 0; i < string.length(); ++i) {
     char c = string[i];
@@ -109,19 +142,45 @@ void AssertSafeMIMEType(const std::string& string) {
   }
 }
 
+// Reads from another HTTPBodyStream that it does not own, so that a stream
+// supplied to SetFileAttachmentStream() can be placed into a
+// CompositeHTTPBodyStream, which owns its parts.
+class WeakHTTPBodyStream : public HTTPBodyStream {
+ public:
+  explicit WeakHTTPBodyStream(HTTPBodyStream* stream)
+      : HTTPBodyStream(), stream_(stream) {}
+
+  ~WeakHTTPBodyStream() override {}
+
+  // HTTPBodyStream:
+  FileOperationResult GetBytesBuffer(uint8_t* buffer, size_t max_len) override {
+    return stream_->GetBytesBuffer(buffer, max_len);
+  }
+
+ private:
+  HTTPBodyStream* stream_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(WeakHTTPBodyStream);
+};
+
 }  // namespace
 
 HTTPMultipartBuilder::HTTPMultipartBuilder()
     : boundary_(GenerateBoundaryString()),
       form_data_(),
       file_attachments_(),
-      gzip_enabled_(false) {}
+      compression_() {}
 
 HTTPMultipartBuilder::~HTTPMultipartBuilder() {
 }
 
 void HTTPMultipartBuilder::SetGzipEnabled(bool gzip_enabled) {
-  gzip_enabled_ = gzip_enabled;
+  SetCompression(HTTPCompression(gzip_enabled ? HTTPContentCoding::kGzip
+                                              : HTTPContentCoding::kIdentity));
+}
+
+void HTTPMultipartBuilder::SetCompression(const HTTPCompression& compression) {
+  compression_ = compression;
 }
 
 void HTTPMultipartBuilder::SetFormData(const std::string& key,
@@ -135,59 +194,123 @@ void HTTPMultipartBuilder::SetFileAttachment(
     const std::string& upload_file_name,
     const base::FilePath& path,
     const std::string& content_type) {
-  EraseKey(upload_file_name);
-
-  FileAttachment attachment;
-  attachment.filename = EncodeMIMEField(upload_file_name);
+  FileAttachment attachment = {};
   attachment.path = path;
+  SetFileAttachmentCommon(key, upload_file_name, content_type, &attachment);
+}
 
-  if (content_type.empty()) {
-    attachment.content_type = "application/octet-stream";
-  } else {
-    AssertSafeMIMEType(content_type);
-    attachment.content_type = content_type;
-  }
+void HTTPMultipartBuilder::SetFileAttachmentData(
+    const std::string& key,
+    const std::string& upload_file_name,
+    const std::string& data,
+    const std::string& content_type) {
+  FileAttachment attachment = {};
+  attachment.data = data;
+  SetFileAttachmentCommon(key, upload_file_name, content_type, &attachment);
+}
 
-  file_attachments_[key] = attachment;
+void HTTPMultipartBuilder::SetFileAttachmentStream(
+    const std::string& key,
+    const std::string& upload_file_name,
+    HTTPBodyStream* stream,
+    const std::string& content_type) {
+  DCHECK(stream);
+  FileAttachment attachment = {};
+  attachment.stream = stream;
+  SetFileAttachmentCommon(key, upload_file_name, content_type, &attachment);
+}
+
+void HTTPMultipartBuilder::SetCompressedFileAttachmentStream(
+    const std::string& key,
+    const std::string& upload_file_name,
+    HTTPBodyStream* stream,
+    const std::string& content_type,
+    HTTPContentCoding coding) {
+  DCHECK(stream);
+  DCHECK(coding == HTTPContentCoding::kGzip);
+  FileAttachment attachment = {};
+  attachment.stream = stream;
+  attachment.coding = coding;
+  SetFileAttachmentCommon(key, upload_file_name, content_type, &attachment);
 }
 
 std::unique_ptr<HTTPBodyStream> HTTPMultipartBuilder::GetBodyStream() {
-  // The objects inserted into this vector will be owned by the returned
+  // The objects inserted into these vectors will be owned by the returned
   // CompositeHTTPBodyStream. Take care to not early-return without deleting
   // this memory.
+  //
+  // The parts of the body accumulate in |streams| until an already-compressed
+  // attachment is reached. The accumulated parts are then compressed as one
+  // member of |members|, and the attachment follows as the next member.
+  std::vector<HTTPBodyStream*> members;
   std::vector<HTTPBodyStream*> streams;
+  auto compress_streams = [this, &members, &streams]() {
+    if (!streams.empty()) {
+      members.push_back(
+          CreateCompressingHTTPBodyStream(
+              compression_,
+              std::unique_ptr<HTTPBodyStream>(
+                  new CompositeHTTPBodyStream(streams)))
+              .release());
+      streams.clear();
+    }
+  };
 
   for (const auto& pair : form_data_) {
-    std::string field = GetFormDataBoundary(boundary_, pair.first);
-    field += kBoundaryCRLF;
-    field += pair.second;
-    field += kCRLF;
-    streams.push_back(new StringHTTPBodyStream(field));
+    streams.push_back(new StringHTTPBodyStream(
+        GetFormDataPart(boundary_, pair.first, pair.second)));
   }
 
   for (const auto& pair : file_attachments_) {
     const FileAttachment& attachment = pair.second;
-    std::string header = GetFormDataBoundary(boundary_, pair.first);
-    header += base::StringPrintf("; filename=\"%s\"%s",
-        attachment.filename.c_str(), kCRLF);
-    header += base::StringPrintf("Content-Type: %s%s",
-        attachment.content_type.c_str(), kBoundaryCRLF);
-
-    streams.push_back(new StringHTTPBodyStream(header));
-    streams.push_back(new FileHTTPBodyStream(attachment.path));
+    streams.push_back(new StringHTTPBodyStream(
+        GetFileAttachmentHeader(boundary_,
+                                pair.first,
+                                attachment.filename,
+                                attachment.content_type)));
+    if (attachment.coding != HTTPContentCoding::kIdentity) {
+      DCHECK(attachment.coding == compression_.coding);
+      compress_streams();
+      members.push_back(new WeakHTTPBodyStream(attachment.stream));
+    } else if (attachment.stream) {
+      streams.push_back(new WeakHTTPBodyStream(attachment.stream));
+    } else if (!attachment.path.empty()) {
+      streams.push_back(new FileHTTPBodyStream(attachment.path));
+    } else {
+      streams.push_back(new StringHTTPBodyStream(attachment.data));
+    }
     streams.push_back(new StringHTTPBodyStream(kCRLF));
   }
 
-  streams.push_back(
-      new StringHTTPBodyStream("--"  + boundary_ + "--" + kCRLF));
+  streams.push_back(new StringHTTPBodyStream(GetCloseDelimiter(boundary_)));
+  compress_streams();
 
-  auto composite =
-      std::unique_ptr<HTTPBodyStream>(new CompositeHTTPBodyStream(streams));
-  if (gzip_enabled_) {
-    return std::unique_ptr<HTTPBodyStream>(
-        new GzipHTTPBodyStream(std::move(composite)));
+  if (members.size() == 1) {
+    return std::unique_ptr<HTTPBodyStream>(members[0]);
   }
-  return composite;
+  return std::unique_ptr<HTTPBodyStream>(new CompositeHTTPBodyStream(members));
+}
+
+std::unique_ptr<HTTPBodyStream> HTTPMultipartBuilder::GetBodyStreamWithLength(
+    uint64_t* length) {
+  if (ComputeUncompressedLength(length)) {
+    return GetBodyStream();
+  }
+
+  std::unique_ptr<HTTPBodyStream> body_stream = GetBodyStream();
+  std::string body;
+  uint8_t buffer[32 * 1024];
+  FileOperationResult rv;
+  while ((rv = body_stream->GetBytesBuffer(buffer, sizeof(buffer))) > 0) {
+    body.append(reinterpret_cast<const char*>(buffer), rv);
+  }
+  if (rv < 0) {
+    LOG(ERROR) << "couldn't read multipart body";
+    return nullptr;
+  }
+
+  *length = body.size();
+  return std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream(body));
 }
 
 void HTTPMultipartBuilder::PopulateContentHeaders(
@@ -196,9 +319,71 @@ void HTTPMultipartBuilder::PopulateContentHeaders(
       base::StringPrintf("multipart/form-data; boundary=%s", boundary_.c_str());
   (*http_headers)[kContentType] = content_type;
 
-  if (gzip_enabled_) {
-    (*http_headers)[kContentEncoding] = "gzip";
+  const char* const content_coding = HTTPContentCodingName(compression_.coding);
+  if (content_coding) {
+    (*http_headers)[kContentEncoding] = content_coding;
+  }
+}
+
+void HTTPMultipartBuilder::SetFileAttachmentCommon(
+    const std::string& key,
+    const std::string& upload_file_name,
+    const std::string& content_type,
+    FileAttachment* attachment) {
+  EraseKey(upload_file_name);
+
+  attachment->filename = EncodeMIMEField(upload_file_name);
+
+  if (content_type.empty()) {
+    attachment->content_type = "application/octet-stream";
+  } else {
+    AssertSafeMIMEType(content_type);
+    attachment->content_type = content_type;
+  }
+
+  file_attachments_[key] = *attachment;
+}
+
+bool HTTPMultipartBuilder::ComputeUncompressedLength(uint64_t* length) const {
+  if (compression_.coding != HTTPContentCoding::kIdentity) {
+    return false;
+  }
+
+  uint64_t local_length = 0;
+  for (const auto& pair : form_data_) {
+    local_length += GetFormDataPart(boundary_, pair.first, pair.second).size();
   }
+
+  for (const auto& pair : file_attachments_) {
+    const FileAttachment& attachment = pair.second;
+    if (attachment.stream) {
+      return false;
+    }
+
+    local_length += GetFileAttachmentHeader(boundary_,
+                                            pair.first,
+                                            attachment.filename,
+                                            attachment.content_type)
+                        .size();
+    if (!attachment.path.empty()) {
+      ScopedFileHandle file(LoggingOpenFileForRead(attachment.path));
+      if (!file.is_valid()) {
+        return false;
+      }
+      const FileOffset file_size = LoggingFileSizeByHandle(file.get());
+      if (file_size < 0) {
+        return false;
+      }
+      local_length += file_size;
+    } else {
+      local_length += attachment.data.size();
+    }
+    local_length += strlen(kCRLF);
+  }
+
+  local_length += GetCloseDelimiter(boundary_).size();
+  *length = local_length;
+  return true;
 }
 
 void HTTPMultipartBuilder::EraseKey(const std::string& key) {
@@ -15,12 +15,15 @@
 #ifndef CRASHPAD_UTIL_NET_HTTP_MULTIPART_BUILDER_H_
 #define CRASHPAD_UTIL_NET_HTTP_MULTIPART_BUILDER_H_
 
+#include <stdint.h>
+
 #include <map>
 #include <memory>
 #include <string>
 
 #include "base/files/file_path.h"
 #include "base/macros.h"
+#include "util/net/http_body_compression.h"
 #include "util/net/http_headers.h"
 
 namespace crashpad {
@@ -41,8 +44,23 @@ class HTTPMultipartBuilder {
   //! When `gzip` compression is enabled, the body stream returned by
   //! GetBodyStream() will be `gzip`-compressed, and the content headers set by
   //! PopulateContentHeaders() will contain `Content-Encoding: gzip`.
+  //!
+  //! This is equivalent to calling SetCompression() with an HTTPCompression
+  //! for HTTPContentCoding::kGzip or HTTPContentCoding::kIdentity at its
+  //! default level and strategy.
   void SetGzipEnabled(bool gzip_enabled);
 
+  //! \brief Sets how the body stream is compressed.
+  //!
+  //! \param[in] compression The codec and its parameters. The default is
+  //!     HTTPContentCoding::kIdentity, for no compression.
+  //!
+  //! The body stream returned by GetBodyStream() will be compressed as
+  //! specified, and the content headers set by PopulateContentHeaders() will
+  //! contain a `Content-Encoding` naming the codec, unless it is
+  //! HTTPContentCoding::kIdentity.
+  void SetCompression(const HTTPCompression& compression);
+
   //! \brief Sets a `Content-Disposition: form-data` key-value pair.
   //!
   //! \param[in] key The key of the form data, specified as the `name` in the
@@ -67,12 +85,103 @@ class HTTPMultipartBuilder {
                          const base::FilePath& path,
                          const std::string& content_type);
 
+  //! \brief Specifies \a data to be uploaded as multipart data, available at
+  //!     `name` of \a upload_file_name.
+  //!
+  //! This is equivalent to SetFileAttachment(), but the attachment’s contents
+  //! are supplied directly rather than read from a file.
+  //!
+  //! \param[in] key The key of the form data, specified as the `name` in the
+  //!     multipart message. Any data previously set on this class with this
+  //!     key will be overwritten.
+  //! \param[in] upload_file_name The `filename` to specify for this multipart
+  //!     data attachment.
+  //! \param[in] data The contents to be uploaded.
+  //! \param[in] content_type The `Content-Type` to specify for the attachment.
+  //!     If this is empty, `"application/octet-stream"` will be used.
+  void SetFileAttachmentData(const std::string& key,
+                             const std::string& upload_file_name,
+                             const std::string& data,
+                             const std::string& content_type);
+
+  //! \brief Specifies that the contents of \a stream are to be uploaded as
+  //!     multipart data, available at `name` of \a upload_file_name.
+  //!
+  //! This is equivalent to SetFileAttachment(), but the attachment’s contents
+  //! are read from \a stream as the body is read, so that they need not be
+  //! available in their entirety beforehand. Because \a stream can only be
+  //! read once, only a single body stream obtained from GetBodyStream() may be
+  //! read.
+  //!
+  //! \param[in] key The key of the form data, specified as the `name` in the
+  //!     multipart message. Any data previously set on this class with this
+  //!     key will be overwritten.
+  //! \param[in] upload_file_name The `filename` to specify for this multipart
+  //!     data attachment.
+  //! \param[in] stream The stream supplying the contents to be uploaded. This
+  //!     object is not owned by the builder, and must outlive any body stream
+  //!     obtained from GetBodyStream().
+  //! \param[in] content_type The `Content-Type` to specify for the attachment.
+  //!     If this is empty, `"application/octet-stream"` will be used.
+  void SetFileAttachmentStream(const std::string& key,
+                               const std::string& upload_file_name,
+                               HTTPBodyStream* stream,
+                               const std::string& content_type);
+
+  //! \brief Specifies that the contents of \a stream, which are already
+  //!     compressed, are to be uploaded as multipart data, available at `name`
+  //!     of \a upload_file_name.
+  //!
+  //! This is equivalent to SetFileAttachmentStream(), but the contents of \a
+  //! stream are placed into the body stream returned by GetBodyStream() as they
+  //! are, rather than being compressed again. The parts of the body before and
+  //! after the attachment are compressed separately, so that the body consists
+  //! of several concatenated compressed members.
+  //!
+  //! \param[in] key The key of the form data, specified as the `name` in the
+  //!     multipart message. Any data previously set on this class with this
+  //!     key will be overwritten.
+  //! \param[in] upload_file_name The `filename` to specify for this multipart
+  //!     data attachment.
+  //! \param[in] stream The stream supplying the compressed contents to be
+  //!     uploaded. This object is not owned by the builder, and must outlive
+  //!     any body stream obtained from GetBodyStream().
+  //! \param[in] content_type The `Content-Type` to specify for the attachment
+  //!     once decompressed. If this is empty, `"application/octet-stream"`
+  //!     will be used.
+  //! \param[in] coding The content coding that the contents of \a stream are
+  //!     compressed with. This must be HTTPContentCoding::kGzip, whose members
+  //!     may be concatenated, and it must match the coding set by
+  //!     SetCompression() when GetBodyStream() is called.
+  void SetCompressedFileAttachmentStream(const std::string& key,
+                                         const std::string& upload_file_name,
+                                         HTTPBodyStream* stream,
+                                         const std::string& content_type,
+                                         HTTPContentCoding coding);
+
   //! \brief Generates the HTTPBodyStream for the data currently supplied to
   //!     the builder.
   //!
   //! \return A caller-owned HTTPBodyStream object.
   std::unique_ptr<HTTPBodyStream> GetBodyStream();
 
+  //! \brief Generates the HTTPBodyStream for the data currently supplied to
+  //!     the builder, along with its length, to be sent as `Content-Length`.
+  //!
+  //! A transport sends a body whose length isn’t known in advance with
+  //! `Transfer-Encoding: chunked`, which some proxies buffer in its entirety
+  //! before forwarding. When the body is not compressed and no attachment’s
+  //! contents are supplied as a stream, its length is computed from its parts,
+  //! and it is streamed as GetBodyStream()’s would be. Otherwise, the body is
+  //! produced in its entirety and held in memory, so it’s compressed before
+  //! it’s sent rather than as it’s sent.
+  //!
+  //! \param[out] length The length of the body, in bytes.
+  //!
+  //! \return A caller-owned HTTPBodyStream object, or `nullptr` with a message
+  //!     logged if the body couldn’t be produced.
+  std::unique_ptr<HTTPBodyStream> GetBodyStreamWithLength(uint64_t* length);
+
   //! \brief Adds the appropriate content headers to \a http_headers.
   //!
   //! Any headers that this method adds will replace existing headers by the
@@ -83,9 +192,29 @@ class HTTPMultipartBuilder {
   struct FileAttachment {
     std::string filename;
     std::string content_type;
+
+    // The attachment’s contents are read from |stream| if it is not null,
+    // from |path| if it is not empty, and are otherwise taken from |data|.
+    HTTPBodyStream* stream;  // weak
     base::FilePath path;
+    std::string data;
+
+    // The coding that the contents of |stream| are already compressed with.
+    HTTPContentCoding coding;
   };
 
+  // Sets the filename and content type of |attachment| and stores it at |key|.
+  void SetFileAttachmentCommon(const std::string& key,
+                               const std::string& upload_file_name,
+                               const std::string& content_type,
+                               FileAttachment* attachment);
+
+  // Computes the length of the body GetBodyStream() returns without reading
+  // it, which is possible when the body is not compressed and no attachment is
+  // a stream. Returns false if the length can’t be computed, with a message
+  // logged if a file attachment couldn’t be examined.
+  bool ComputeUncompressedLength(uint64_t* length) const;
+
   // Removes elements from both data maps at the specified |key|, to ensure
   // uniqueness across the entire HTTP body.
   void EraseKey(const std::string& key);
@@ -93,7 +222,7 @@ class HTTPMultipartBuilder {
   std::string boundary_;
   std::map<std::string, std::string> form_data_;
   std::map<std::string, FileAttachment> file_attachments_;
-  bool gzip_enabled_;
+  HTTPCompression compression_;
 
   DISALLOW_COPY_AND_ASSIGN(HTTPMultipartBuilder);
 };
@@ -22,6 +22,7 @@
 #include "test/gtest_death_check.h"
 #include "test/test_paths.h"
 #include "util/net/http_body.h"
+#include "util/net/http_body_gzip.h"
 #include "util/net/http_body_test_util.h"
 
 namespace crashpad {
@@ -156,6 +157,159 @@ TEST(HTTPMultipartBuilder, ThreeFileAttachments) {
   EXPECT_EQ(lines_it, lines.end());
 }
 
+TEST(HTTPMultipartBuilder, FileAttachmentData) {
+  HTTPMultipartBuilder builder;
+  static constexpr char kData[] = "MDMP contents";
+  builder.SetFileAttachmentData("upload", "minidump.dmp", kData, "");
+
+  std::unique_ptr<HTTPBodyStream> body(builder.GetBodyStream());
+  ASSERT_TRUE(body.get());
+  std::string contents = ReadStreamToString(body.get());
+  auto lines = SplitCRLF(contents);
+  ASSERT_EQ(lines.size(), 6u);
+  auto lines_it = lines.begin();
+
+  const std::string& boundary = *lines_it++;
+  EXPECT_GE(boundary.length(), 1u);
+  EXPECT_LE(boundary.length(), 70u);
+
+  EXPECT_EQ(*lines_it++,
+            "Content-Disposition: form-data; "
+            "name=\"upload\"; filename=\"minidump.dmp\"");
+  EXPECT_EQ(*lines_it++, "Content-Type: application/octet-stream");
+  EXPECT_EQ(*lines_it++, "");
+  EXPECT_EQ(*lines_it++, kData);
+
+  EXPECT_EQ(*lines_it++, boundary + "--");
+
+  EXPECT_EQ(lines_it, lines.end());
+}
+
+TEST(HTTPMultipartBuilder, FileAttachmentStream) {
+  HTTPMultipartBuilder builder;
+  static constexpr char kData[] = "MDMP streamed contents";
+  StringHTTPBodyStream stream(kData);
+  builder.SetFileAttachmentStream("upload", "minidump.dmp", &stream, "");
+
+  std::unique_ptr<HTTPBodyStream> body(builder.GetBodyStream());
+  ASSERT_TRUE(body.get());
+  std::string contents = ReadStreamToString(body.get());
+  auto lines = SplitCRLF(contents);
+  ASSERT_EQ(lines.size(), 6u);
+  auto lines_it = lines.begin();
+
+  const std::string& boundary = *lines_it++;
+  EXPECT_GE(boundary.length(), 1u);
+  EXPECT_LE(boundary.length(), 70u);
+
+  EXPECT_EQ(*lines_it++,
+            "Content-Disposition: form-data; "
+            "name=\"upload\"; filename=\"minidump.dmp\"");
+  EXPECT_EQ(*lines_it++, "Content-Type: application/octet-stream");
+  EXPECT_EQ(*lines_it++, "");
+  EXPECT_EQ(*lines_it++, kData);
+
+  EXPECT_EQ(*lines_it++, boundary + "--");
+
+  EXPECT_EQ(lines_it, lines.end());
+}
+
+TEST(HTTPMultipartBuilder, CompressedFileAttachmentStream) {
+  static constexpr char kData[] = "MDMP compressed contents";
+  GzipHTTPBodyStream gzip_stream(
+      std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream(kData)));
+  const std::string compressed_data = ReadStreamToString(&gzip_stream);
+  StringHTTPBodyStream stream(compressed_data);
+
+  HTTPMultipartBuilder builder;
+  builder.SetCompression(HTTPCompression(HTTPContentCoding::kGzip));
+  builder.SetFormData("key", "value");
+  builder.SetCompressedFileAttachmentStream(
+      "upload", "minidump.dmp", &stream, "", HTTPContentCoding::kGzip);
+
+  std::unique_ptr<HTTPBodyStream> body(builder.GetBodyStream());
+  ASSERT_TRUE(body.get());
+  std::string compressed_contents = ReadStreamToString(body.get());
+
+  // The attachment is sent as it is, as the second of three gzip members.
+  EXPECT_NE(compressed_contents.find(compressed_data), std::string::npos);
+  size_t members;
+  std::string contents = GzipInflateToString(compressed_contents, &members);
+  EXPECT_EQ(members, 3u);
+  auto lines = SplitCRLF(contents);
+  ASSERT_EQ(lines.size(), 10u);
+  auto lines_it = lines.begin();
+
+  const std::string& boundary = *lines_it++;
+  EXPECT_GE(boundary.length(), 1u);
+  EXPECT_LE(boundary.length(), 70u);
+
+  EXPECT_EQ(*lines_it++, "Content-Disposition: form-data; name=\"key\"");
+  EXPECT_EQ(*lines_it++, "");
+  EXPECT_EQ(*lines_it++, "value");
+
+  EXPECT_EQ(*lines_it++, boundary);
+  EXPECT_EQ(*lines_it++,
+            "Content-Disposition: form-data; "
+            "name=\"upload\"; filename=\"minidump.dmp\"");
+  EXPECT_EQ(*lines_it++, "Content-Type: application/octet-stream");
+  EXPECT_EQ(*lines_it++, "");
+  EXPECT_EQ(*lines_it++, kData);
+
+  EXPECT_EQ(*lines_it++, boundary + "--");
+
+  EXPECT_EQ(lines_it, lines.end());
+}
+
+TEST(HTTPMultipartBuilder, BodyStreamWithLength) {
+  HTTPMultipartBuilder builder;
+  builder.SetFormData("key", "value");
+  builder.SetFileAttachment("file",
+                            "minidump.dmp",
+                            TestPaths::TestDataRoot().Append(FILE_PATH_LITERAL(
+                                "util/net/testdata/ascii_http_body.txt")),
+                            "");
+  builder.SetFileAttachmentData("data", "data.dmp", "MDMP data contents", "");
+
+  // The length of an uncompressed body is computed, and matches the body that
+  // GetBodyStream() would produce.
+  uint64_t length;
+  std::unique_ptr<HTTPBodyStream> body =
+      builder.GetBodyStreamWithLength(&length);
+  ASSERT_TRUE(body.get());
+  std::string contents = ReadStreamToString(body.get());
+  EXPECT_EQ(length, contents.size());
+
+  body = builder.GetBodyStream();
+  ASSERT_TRUE(body.get());
+  EXPECT_EQ(ReadStreamToString(body.get()), contents);
+
+  // A compressed body is produced before it’s read.
+  builder.SetGzipEnabled(true);
+  body = builder.GetBodyStreamWithLength(&length);
+  ASSERT_TRUE(body.get());
+  std::string compressed_contents = ReadStreamToString(body.get());
+  EXPECT_EQ(length, compressed_contents.size());
+  size_t members;
+  EXPECT_EQ(GzipInflateToString(compressed_contents, &members), contents);
+}
+
+TEST(HTTPMultipartBuilder, BodyStreamWithLengthFileAttachmentStream) {
+  HTTPMultipartBuilder builder;
+  static constexpr char kData[] = "MDMP streamed contents";
+  StringHTTPBodyStream stream(kData);
+  builder.SetFileAttachmentStream("upload", "minidump.dmp", &stream, "");
+
+  // A stream’s length isn’t known until it’s read.
+  uint64_t length;
+  std::unique_ptr<HTTPBodyStream> body =
+      builder.GetBodyStreamWithLength(&length);
+  ASSERT_TRUE(body.get());
+  std::string contents = ReadStreamToString(body.get());
+  EXPECT_EQ(length, contents.size());
+  EXPECT_NE(contents.find(kData), std::string::npos);
+}
+
 TEST(HTTPMultipartBuilder, OverwriteFormDataWithEscapedKey) {
   HTTPMultipartBuilder builder;
   static constexpr char kKey[] = "a 100% \"silly\"\r\ntest";
@@ -0,0 +1,126 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/http_retry_after.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <limits>
+
+#include "base/macros.h"
+
+namespace crashpad {
+
+namespace {
+
+// Interprets |value| as delta-seconds, a non-negative decimal integer. Values
+// that overflow time_t are clamped, as RFC 7234 §1.2.1 permits.
+bool ParseDeltaSeconds(const std::string& value, time_t* delay) {
+  if (value.empty()) {
+    return false;
+  }
+
+  time_t seconds = 0;
+  for (char c : value) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    const int digit = c - '0';
+    if (seconds > (std::numeric_limits<time_t>::max() - digit) / 10) {
+      seconds = std::numeric_limits<time_t>::max();
+    } else if (seconds != std::numeric_limits<time_t>::max()) {
+      seconds = seconds * 10 + digit;
+    }
+  }
+
+  *delay = seconds;
+  return true;
+}
+
+// Interprets |value| as an IMF-fixdate, returning the time that it names in
+// |date|.
+bool ParseIMFFixdate(const std::string& value, time_t* date) {
+  char day_name[4];
+  char month_name[4];
+  int day;
+  int year;
+  int hour;
+  int minute;
+  int second;
+  int consumed = 0;
+  int rv = sscanf(value.c_str(),
+                  "%3[A-Za-z], %2d %3[A-Za-z] %4d %2d:%2d:%2d GMT%n",
+                  day_name,
+                  &day,
+                  month_name,
+                  &year,
+                  &hour,
+                  &minute,
+                  &second,
+                  &consumed);
+  if (rv != 7 || consumed != static_cast<int>(value.size())) {
+    return false;
+  }
+
+  static constexpr char kMonthNames[][4] = {"Jan", "Feb", "Mar", "Apr",
+                                            "May", "Jun", "Jul", "Aug",
+                                            "Sep", "Oct", "Nov", "Dec"};
+  int month;
+  for (month = 0; month < static_cast<int>(arraysize(kMonthNames)); ++month) {
+    if (strcmp(month_name, kMonthNames[month]) == 0) {
+      break;
+    }
+  }
+  if (month == static_cast<int>(arraysize(kMonthNames)) || day < 1 ||
+      day > 31 || year < 1970 || hour > 23 || minute > 59 || second > 60) {
+    return false;
+  }
+
+  tm date_tm = {};
+  date_tm.tm_sec = second;
+  date_tm.tm_min = minute;
+  date_tm.tm_hour = hour;
+  date_tm.tm_mday = day;
+  date_tm.tm_mon = month;
+  date_tm.tm_year = year - 1900;
+  *date = timegm(&date_tm);
+  return *date != -1;
+}
+
+}  // namespace
+
+bool ParseHTTPRetryAfter(const std::string& value, time_t now, time_t* delay) {
+  static constexpr char kWhitespace[] = " \t";
+  const size_t begin = value.find_first_not_of(kWhitespace);
+  if (begin == std::string::npos) {
+    return false;
+  }
+  const std::string trimmed =
+      value.substr(begin, value.find_last_not_of(kWhitespace) - begin + 1);
+
+  if (ParseDeltaSeconds(trimmed, delay)) {
+    return true;
+  }
+
+  time_t date;
+  if (!ParseIMFFixdate(trimmed, &date)) {
+    return false;
+  }
+
+  *delay = date > now ? date - now : 0;
+  return true;
+}
+
+}  // namespace crashpad
@@ -0,0 +1,44 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_NET_HTTP_RETRY_AFTER_H_
+#define CRASHPAD_UTIL_NET_HTTP_RETRY_AFTER_H_
+
+#include <time.h>
+
+#include <string>
+
+namespace crashpad {
+
+//! \brief Interprets the value of an HTTP `Retry-After` response header field,
+//!     following RFC 7231 §7.1.3.
+//!
+//! The value may be a number of seconds to wait, or the date after which to
+//! retry, in the preferred IMF-fixdate format of RFC 7231 §7.1.1.1, such as
+//! `"Sun, 06 Nov 1994 08:49:37 GMT"`. The obsolete date formats are not
+//! recognized.
+//!
+//! \param[in] value The header field’s value. Surrounding whitespace is
+//!     ignored.
+//! \param[in] now The current time, which a date is measured from.
+//! \param[out] delay The number of seconds to wait before retrying. This is `0`
+//!     for a date that has already passed.
+//!
+//! \return `true` on success, with \a delay set. `false` if \a value couldn’t
+//!     be interpreted.
+bool ParseHTTPRetryAfter(const std::string& value, time_t now, time_t* delay);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_NET_HTTP_RETRY_AFTER_H_
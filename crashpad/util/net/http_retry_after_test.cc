@@ -0,0 +1,92 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/http_retry_after.h"
+
+#include <limits>
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+// Sun, 06 Nov 1994 08:49:37 GMT, the example date of RFC 7231 §7.1.1.1.
+constexpr time_t kExampleDate = 784111777;
+
+TEST(HTTPRetryAfter, DeltaSeconds) {
+  time_t delay;
+  ASSERT_TRUE(ParseHTTPRetryAfter("120", kExampleDate, &delay));
+  EXPECT_EQ(delay, 120);
+
+  ASSERT_TRUE(ParseHTTPRetryAfter("0", kExampleDate, &delay));
+  EXPECT_EQ(delay, 0);
+
+  // Leading zeroes don’t make the value octal.
+  ASSERT_TRUE(ParseHTTPRetryAfter("010", kExampleDate, &delay));
+  EXPECT_EQ(delay, 10);
+
+  ASSERT_TRUE(ParseHTTPRetryAfter(" \t30 ", kExampleDate, &delay));
+  EXPECT_EQ(delay, 30);
+
+  ASSERT_TRUE(ParseHTTPRetryAfter(
+      "999999999999999999999999999999", kExampleDate, &delay));
+  EXPECT_EQ(delay, std::numeric_limits<time_t>::max());
+}
+
+TEST(HTTPRetryAfter, Date) {
+  time_t delay;
+  ASSERT_TRUE(ParseHTTPRetryAfter(
+      "Sun, 06 Nov 1994 08:49:37 GMT", kExampleDate - 60, &delay));
+  EXPECT_EQ(delay, 60);
+
+  ASSERT_TRUE(ParseHTTPRetryAfter(
+      "Mon, 07 Nov 1994 08:49:37 GMT", kExampleDate, &delay));
+  EXPECT_EQ(delay, 24 * 60 * 60);
+
+  // A date that has passed calls for no delay.
+  ASSERT_TRUE(ParseHTTPRetryAfter(
+      "Sun, 06 Nov 1994 08:49:37 GMT", kExampleDate + 60, &delay));
+  EXPECT_EQ(delay, 0);
+}
+
+TEST(HTTPRetryAfter, Invalid) {
+  time_t delay = 1;
+  EXPECT_FALSE(ParseHTTPRetryAfter("", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter("  ", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter("-1", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter("+1", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter("1.5", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter("soon", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter(
+      "Sun, 06 Nov 1994 08:49:37 PST", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter(
+      "Sun, 06 Foo 1994 08:49:37 GMT", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter(
+      "Sun, 06 Nov 1994 25:49:37 GMT", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter(
+      "Sun, 06 Nov 1994 08:49:37 GMT trailing", kExampleDate, &delay));
+
+  // The obsolete RFC 850 and asctime() formats aren’t recognized.
+  EXPECT_FALSE(ParseHTTPRetryAfter(
+      "Sunday, 06-Nov-94 08:49:37 GMT", kExampleDate, &delay));
+  EXPECT_FALSE(ParseHTTPRetryAfter(
+      "Sun Nov  6 08:49:37 1994", kExampleDate, &delay));
+
+  EXPECT_EQ(delay, 1);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -25,7 +25,11 @@ HTTPTransport::HTTPTransport()
       method_("POST"),
       headers_(),
       body_stream_(),
-      timeout_(15.0) {
+      timeout_(15.0),
+      response_retry_after_(),
+      response_status_(0),
+      cancel_lock_(),
+      cancelled_(false) {
 }
 
 HTTPTransport::~HTTPTransport() {
@@ -44,6 +48,10 @@ void HTTPTransport::SetHeader(const std::string& header,
   headers_[header] = value;
 }
 
+void HTTPTransport::ClearHeaders() {
+  headers_.clear();
+}
+
 void HTTPTransport::SetBodyStream(std::unique_ptr<HTTPBodyStream> stream) {
   body_stream_ = std::move(stream);
 }
@@ -52,4 +60,28 @@ void HTTPTransport::SetTimeout(double timeout) {
   timeout_ = timeout;
 }
 
+void HTTPTransport::SetResponse(int status, const std::string& retry_after) {
+  response_status_ = status;
+  response_retry_after_ = retry_after;
+}
+
+void HTTPTransport::Cancel() {
+  {
+    base::AutoLock lock(cancel_lock_);
+    cancelled_ = true;
+  }
+
+  CancelRequest();
+}
+
+void HTTPTransport::ClearCancellation() {
+  base::AutoLock lock(cancel_lock_);
+  cancelled_ = false;
+}
+
+bool HTTPTransport::IsCancelled() const {
+  base::AutoLock lock(cancel_lock_);
+  return cancelled_;
+}
+
 }  // namespace crashpad
@@ -19,6 +19,7 @@
 #include <string>
 
 #include "base/macros.h"
+#include "base/synchronization/lock.h"
 #include "util/net/http_headers.h"
 
 namespace crashpad {
@@ -32,6 +33,16 @@ class HTTPBodyStream;
 //! This class cannot be instantiated directly. A concrete subclass must be
 //! instantiated instead, which provides an implementation to execute the
 //! request that is appropriate for the host operating system.
+//!
+//! A single object may execute several requests in sequence, by configuring
+//! each one, including with a new SetBodyStream(), before calling
+//! ExecuteSynchronously(). Settings persist from one request to the next.
+//! Implementations keep connections to servers alive between such requests
+//! where the platform permits, so that the requests need not each establish a
+//! new connection.
+//!
+//! A request being executed on one thread can be abandoned from another by
+//! calling Cancel().
 class HTTPTransport {
  public:
   virtual ~HTTPTransport();
@@ -60,6 +71,9 @@ class HTTPTransport {
   //! \param[in] value The value to set for the header.
   void SetHeader(const std::string& header, const std::string& value);
 
+  //! \brief Removes all HTTP header-value pairs set by SetHeader().
+  void ClearHeaders();
+
   //! \brief Sets the stream object from which to generate the HTTP body.
   //!
   //! \param[in] stream A HTTPBodyStream, of which this class will take
@@ -82,9 +96,62 @@ class HTTPTransport {
   //!     a HTTP status 200 (OK) code.
   virtual bool ExecuteSynchronously(std::string* response_body) = 0;
 
+  //! \brief Returns the HTTP status code of the response to the request most
+  //!     recently executed by ExecuteSynchronously(), or `0` if no response
+  //!     was received.
+  //!
+  //! This distinguishes a server that declined a request, such as with status
+  //! 429 (Too Many Requests), from a failure to reach the server.
+  int response_status() const { return response_status_; }
+
+  //! \brief Returns the value of the `Retry-After` header field of the response
+  //!     to the request most recently executed by ExecuteSynchronously(), or an
+  //!     empty string if the response had none or no response was received.
+  const std::string& response_retry_after() const {
+    return response_retry_after_;
+  }
+
+  //! \brief Cancels the request being executed by ExecuteSynchronously(), if
+  //!     any, and causes requests executed subsequently to fail immediately,
+  //!     until ClearCancellation() is called.
+  //!
+  //! A cancelled request fails promptly, although not necessarily before this
+  //! method returns.
+  //!
+  //! This method may be called from any thread.
+  void Cancel();
+
+  //! \brief Permits requests to execute again after Cancel().
+  //!
+  //! This method must not be called while a request is being executed.
+  void ClearCancellation();
+
+  //! \brief Returns `true` if Cancel() has been called more recently than
+  //!     ClearCancellation().
+  //!
+  //! This distinguishes an ExecuteSynchronously() failure caused by Cancel()
+  //! from any other failure. This method may be called from any thread.
+  bool IsCancelled() const;
+
  protected:
   HTTPTransport();
 
+  //! \brief Interrupts the request being executed on another thread, if any.
+  //!
+  //! This is called by Cancel() after IsCancelled() begins returning `true`.
+  //! Implementations must cause a request in progress to fail promptly, and
+  //! must ensure that a request that begins concurrently either observes
+  //! IsCancelled() or is interrupted.
+  virtual void CancelRequest() = 0;
+
+  //! \brief Records the response to the request being executed, for
+  //!     response_status() and response_retry_after().
+  //!
+  //! Implementations call this with `0` and an empty string as
+  //! ExecuteSynchronously() begins, and again once a response is received,
+  //! whether or not its status indicates success.
+  void SetResponse(int status, const std::string& retry_after);
+
   const std::string& url() const { return url_; }
   const std::string& method() const { return method_; }
   const HTTPHeaders& headers() const { return headers_; }
@@ -97,6 +164,10 @@ class HTTPTransport {
   HTTPHeaders headers_;
   std::unique_ptr<HTTPBodyStream> body_stream_;
   double timeout_;
+  std::string response_retry_after_;
+  int response_status_;
+  mutable base::Lock cancel_lock_;
+  bool cancelled_;
 
   DISALLOW_COPY_AND_ASSIGN(HTTPTransport);
 };
@@ -16,6 +16,7 @@
 
 #include <curl/curl.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/utsname.h>
 
 #include <algorithm>
@@ -192,6 +193,18 @@ class HTTPTransportLibcurl final : public HTTPTransport {
   bool ExecuteSynchronously(std::string* response_body) override;
 
  private:
+  // HTTPTransport:
+  // libcurl offers no way to interrupt curl_easy_perform() from another
+  // thread, so cancellation is instead observed by TransferProgress(), which
+  // libcurl calls at least once per second during a transfer.
+  void CancelRequest() override {}
+
+  // Returns a handle to execute a request with, initializing it if necessary.
+  // The handle is reused by subsequent requests, so that they can use the
+  // connections that it keeps alive and its other caches. Returns nullptr with
+  // a message logged on failure.
+  CURL* PrepareHandle();
+
   static size_t ReadRequestBody(char* buffer,
                                 size_t size,
                                 size_t nitems,
@@ -200,11 +213,27 @@ class HTTPTransportLibcurl final : public HTTPTransport {
                                   size_t size,
                                   size_t nitems,
                                   void* userdata);
+  static size_t ReadResponseHeader(char* buffer,
+                                   size_t size,
+                                   size_t nitems,
+                                   void* userdata);
+  static int TransferProgress(void* userdata,
+                              curl_off_t download_total,
+                              curl_off_t download_now,
+                              curl_off_t upload_total,
+                              curl_off_t upload_now);
+
+  ScopedCURL curl_;
+
+  // The value of the Retry-After header field of the response being received,
+  // collected by ReadResponseHeader().
+  std::string retry_after_;
 
   DISALLOW_COPY_AND_ASSIGN(HTTPTransportLibcurl);
 };
 
-HTTPTransportLibcurl::HTTPTransportLibcurl() : HTTPTransport() {}
+HTTPTransportLibcurl::HTTPTransportLibcurl()
+    : HTTPTransport(), curl_(), retry_after_() {}
 
 HTTPTransportLibcurl::~HTTPTransportLibcurl() {}
 
@@ -212,6 +241,13 @@ bool HTTPTransportLibcurl::ExecuteSynchronously(std::string* response_body) {
   DCHECK(body_stream());
 
   response_body->clear();
+  retry_after_.clear();
+  SetResponse(0, std::string());
+
+  if (IsCancelled()) {
+    LOG(ERROR) << "cancelled";
+    return false;
+  }
 
   // curl_easy_init() will do this on the first call if it hasn’t been done yet,
   // but not in a thread-safe way as is done here.
@@ -224,9 +260,8 @@ bool HTTPTransportLibcurl::ExecuteSynchronously(std::string* response_body) {
   }
 
   CurlSList curl_headers;
-  ScopedCURL curl(curl_easy_init());
-  if (!curl.get()) {
-    LOG(ERROR) << "curl_easy_init";
+  CURL* const curl = PrepareHandle();
+  if (!curl) {
     return false;
   }
 
@@ -250,15 +285,23 @@ bool HTTPTransportLibcurl::ExecuteSynchronously(std::string* response_body) {
     }                                      \
   } while (false)
 
-  TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_USERAGENT, UserAgent().c_str());
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_USERAGENT, UserAgent().c_str());
 
   // Accept and automatically decode any encoding that libcurl understands.
-  TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_ACCEPT_ENCODING, "");
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_ACCEPT_ENCODING, "");
 
-  TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_URL, url().c_str());
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_URL, url().c_str());
+
+#if LIBCURL_VERSION_NUM >= 0x072f00
+  // Negotiate HTTP/2 for https URLs where the server supports it, falling back
+  // to HTTP/1.1. This is the default as of libcurl 7.62.0. If libcurl was built
+  // without HTTP/2 support, this fails harmlessly and HTTP/1.1 is used.
+  curl_easy_setopt(
+      curl, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+#endif
 
   constexpr int kMillisecondsPerSecond = 1E3;
-  TRY_CURL_EASY_SETOPT(curl.get(),
+  TRY_CURL_EASY_SETOPT(curl,
                        CURLOPT_TIMEOUT_MS,
                        static_cast<long>(timeout() * kMillisecondsPerSecond));
 
@@ -280,7 +323,7 @@ bool HTTPTransportLibcurl::ExecuteSynchronously(std::string* response_body) {
   }
 
   if (method() == "POST") {
-    TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_POST, 1l);
+    TRY_CURL_EASY_SETOPT(curl, CURLOPT_POST, 1l);
 
     // By default when sending a POST request, libcurl includes an “Expect:
     // 100-continue” header field. Althogh this header is specified in HTTP/1.1
@@ -303,19 +346,34 @@ bool HTTPTransportLibcurl::ExecuteSynchronously(std::string* response_body) {
         return false;
       }
       TRY_CURL_EASY_SETOPT(
-          curl.get(), CURLOPT_POSTFIELDSIZE_LARGE, content_length_curl);
+          curl, CURLOPT_POSTFIELDSIZE_LARGE, content_length_curl);
     }
   } else if (method() != "GET") {
     // Untested.
-    TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_CUSTOMREQUEST, method().c_str());
+    TRY_CURL_EASY_SETOPT(curl, CURLOPT_CUSTOMREQUEST, method().c_str());
   }
 
-  TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_HTTPHEADER, curl_headers.get());
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_HTTPHEADER, curl_headers.get());
 
-  TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_READFUNCTION, ReadRequestBody);
-  TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_READDATA, this);
-  TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_WRITEFUNCTION, WriteResponseBody);
-  TRY_CURL_EASY_SETOPT(curl.get(), CURLOPT_WRITEDATA, response_body);
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_READFUNCTION, ReadRequestBody);
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_READDATA, this);
+
+#if LIBCURL_VERSION_NUM >= 0x073e00
+  // ReadRequestBody() has the body stream fill libcurl’s own upload buffer, so
+  // a file in the body is read straight into it. The default 64kB buffer costs
+  // a read callback and a read() for every 64kB of a minidump file. A larger
+  // buffer cuts those by a factor of 8. libcurl may clamp this, and older
+  // versions lack the option, so a failure here is harmless.
+  constexpr long kUploadBufferSize = 512 * 1024;
+  curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, kUploadBufferSize);
+#endif
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_WRITEFUNCTION, WriteResponseBody);
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_WRITEDATA, response_body);
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_HEADERFUNCTION, ReadResponseHeader);
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_HEADERDATA, this);
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_XFERINFOFUNCTION, TransferProgress);
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_XFERINFODATA, this);
+  TRY_CURL_EASY_SETOPT(curl, CURLOPT_NOPROGRESS, 0l);
 
 #undef TRY_CURL_EASY_SETOPT
 #undef TRY_CURL_SLIST_APPEND
@@ -325,19 +383,21 @@ bool HTTPTransportLibcurl::ExecuteSynchronously(std::string* response_body) {
   ScopedClearString clear_response_body(response_body);
 
   // Do it.
-  CURLcode curl_err = curl_easy_perform(curl.get());
+  CURLcode curl_err = curl_easy_perform(curl);
   if (curl_err != CURLE_OK) {
     LOG(ERROR) << CurlErrorMessage(curl_err, "curl_easy_perform");
     return false;
   }
 
   long status;
-  curl_err = curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &status);
+  curl_err = curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
   if (curl_err != CURLE_OK) {
     LOG(ERROR) << CurlErrorMessage(curl_err, "curl_easy_getinfo");
     return false;
   }
 
+  SetResponse(static_cast<int>(status), retry_after_);
+
   if (status != 200) {
     LOG(ERROR) << base::StringPrintf("HTTP status %ld", status);
     return false;
@@ -349,6 +409,22 @@ bool HTTPTransportLibcurl::ExecuteSynchronously(std::string* response_body) {
   return true;
 }
 
+CURL* HTTPTransportLibcurl::PrepareHandle() {
+  if (curl_.is_valid()) {
+    // This resets the options set by the previous request, but retains live
+    // connections and caches.
+    curl_easy_reset(curl_.get());
+    return curl_.get();
+  }
+
+  curl_.reset(curl_easy_init());
+  if (!curl_.is_valid()) {
+    LOG(ERROR) << "curl_easy_init";
+    return nullptr;
+  }
+  return curl_.get();
+}
+
 // static
 size_t HTTPTransportLibcurl::ReadRequestBody(char* buffer,
                                              size_t size,
@@ -392,6 +468,57 @@ size_t HTTPTransportLibcurl::WriteResponseBody(char* buffer,
   return len;
 }
 
+// static
+size_t HTTPTransportLibcurl::ReadResponseHeader(char* buffer,
+                                                size_t size,
+                                                size_t nitems,
+                                                void* userdata) {
+  HTTPTransportLibcurl* self =
+      reinterpret_cast<HTTPTransportLibcurl*>(userdata);
+
+  // libcurl passes each header line whole, including its terminating CR LF,
+  // and not NUL-terminated.
+  base::CheckedNumeric<size_t> checked_len = base::CheckMul(size, nitems);
+  size_t len = checked_len.ValueOrDefault(std::numeric_limits<size_t>::max());
+
+  // A status line begins the header of each response received, including any
+  // interim “100 Continue” response before the final one.
+  static constexpr char kStatusLinePrefix[] = "HTTP/";
+  static constexpr char kRetryAfterPrefix[] = "Retry-After:";
+  if (len >= strlen(kStatusLinePrefix) &&
+      strncmp(buffer, kStatusLinePrefix, strlen(kStatusLinePrefix)) == 0) {
+    self->retry_after_.clear();
+  } else if (len >= strlen(kRetryAfterPrefix) &&
+             strncasecmp(buffer,
+                         kRetryAfterPrefix,
+                         strlen(kRetryAfterPrefix)) == 0) {
+    size_t begin = strlen(kRetryAfterPrefix);
+    size_t end = len;
+    while (begin < end && (buffer[begin] == ' ' || buffer[begin] == '\t')) {
+      ++begin;
+    }
+    while (end > begin && strchr(" \t\r\n", buffer[end - 1])) {
+      --end;
+    }
+    self->retry_after_.assign(buffer + begin, end - begin);
+  }
+
+  return len;
+}
+
+// static
+int HTTPTransportLibcurl::TransferProgress(void* userdata,
+                                           curl_off_t download_total,
+                                           curl_off_t download_now,
+                                           curl_off_t upload_total,
+                                           curl_off_t upload_now) {
+  HTTPTransportLibcurl* self =
+      reinterpret_cast<HTTPTransportLibcurl*>(userdata);
+
+  // A nonzero return aborts the transfer with CURLE_ABORTED_BY_CALLBACK.
+  return self->IsCancelled() ? 1 : 0;
+}
+
 }  // namespace
 
 // static
@@ -14,7 +14,9 @@
 
 #include "util/net/http_transport.h"
 
+#include <AvailabilityMacros.h>
 #include <CoreFoundation/CoreFoundation.h>
+#include <dispatch/dispatch.h>
 #import <Foundation/Foundation.h>
 #include <sys/utsname.h>
 
@@ -22,6 +24,7 @@
 #import "base/mac/scoped_nsobject.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/sys_string_conversions.h"
+#include "base/synchronization/lock.h"
 #include "build/build_config.h"
 #include "package.h"
 #include "third_party/apple_cf/CFStreamAbstract.h"
@@ -227,18 +230,117 @@ class HTTPTransportMac final : public HTTPTransport {
   bool ExecuteSynchronously(std::string* response_body) override;
 
  private:
+  // Sends |request| and waits for the response, returning the response body
+  // and setting |response| and |error| as NSURLConnection’s
+  // +sendSynchronousRequest:returningResponse:error: does. The returned objects
+  // are autoreleased.
+  NSData* SendRequest(NSURLRequest* request,
+                      NSURLResponse** response,
+                      NSError** error);
+
+  // HTTPTransport:
+  // Requests sent with NSURLConnection, where NSURLSession is unavailable,
+  // can’t be interrupted. Cancellation is only observed before they begin.
+  void CancelRequest() override;
+
+  // Used where NSURLSession is available, so that connections to servers,
+  // including HTTP/2 connections, are kept alive from one request to the next.
+  // Created on first use.
+  base::scoped_nsobject<NSURLSession> session_;
+
+  // Guards task_, the task executing the request in progress, which
+  // CancelRequest() may cancel on any thread.
+  base::Lock task_lock_;
+  base::scoped_nsobject<NSURLSessionDataTask> task_;
+
   DISALLOW_COPY_AND_ASSIGN(HTTPTransportMac);
 };
 
-HTTPTransportMac::HTTPTransportMac() : HTTPTransport() {
+HTTPTransportMac::HTTPTransportMac()
+    : HTTPTransport(), session_(), task_lock_(), task_() {
 }
 
 HTTPTransportMac::~HTTPTransportMac() {
+  // A session retains its resources until it’s invalidated.
+  [session_ finishTasksAndInvalidate];
+}
+
+NSData* HTTPTransportMac::SendRequest(NSURLRequest* request,
+                                      NSURLResponse** response,
+                                      NSError** error) {
+#if MAC_OS_X_VERSION_MIN_REQUIRED < MAC_OS_X_VERSION_10_9
+  if (![NSURLSession class]) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    // Deprecated in OS X 10.11, but NSURLSession is only available on 10.9 and
+    // later.
+    return [NSURLConnection sendSynchronousRequest:request
+                                 returningResponse:response
+                                             error:error];
+#pragma clang diagnostic pop
+  }
+#endif
+
+  if (!session_) {
+    NSURLSessionConfiguration* configuration =
+        [NSURLSessionConfiguration ephemeralSessionConfiguration];
+    session_.reset([[NSURLSession sessionWithConfiguration:configuration]
+        retain]);
+  }
+
+  // The task completes on one of the session’s queues. Wait for it, retaining
+  // its results until they can be autoreleased on this thread.
+  __block NSData* body = nil;
+  __block NSURLResponse* task_response = nil;
+  __block NSError* task_error = nil;
+  dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+  NSURLSessionDataTask* task = [session_
+      dataTaskWithRequest:request
+        completionHandler:^(NSData* data,
+                            NSURLResponse* data_response,
+                            NSError* data_error) {
+          body = [data retain];
+          task_response = [data_response retain];
+          task_error = [data_error retain];
+          dispatch_semaphore_signal(semaphore);
+        }];
+  {
+    // Checking IsCancelled() with task_lock_ held ensures that a concurrent
+    // Cancel() either is observed here or cancels the task.
+    base::AutoLock lock(task_lock_);
+    task_.reset([task retain]);
+    [task resume];
+    if (IsCancelled()) {
+      [task cancel];
+    }
+  }
+  dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+  dispatch_release(semaphore);
+  {
+    base::AutoLock lock(task_lock_);
+    task_.reset();
+  }
+
+  *response = [task_response autorelease];
+  *error = [task_error autorelease];
+  return [body autorelease];
+}
+
+void HTTPTransportMac::CancelRequest() {
+  base::AutoLock lock(task_lock_);
+  [task_ cancel];
 }
 
 bool HTTPTransportMac::ExecuteSynchronously(std::string* response_body) {
   DCHECK(body_stream());
 
+  SetResponse(0, std::string());
+
+  if (IsCancelled()) {
+    LOG(ERROR) << "cancelled";
+    return false;
+  }
+
   @autoreleasepool {
     NSString* url_ns_string = base::SysUTF8ToNSString(url());
     NSURL* url = [NSURL URLWithString:url_ns_string];
@@ -267,15 +369,7 @@ bool HTTPTransportMac::ExecuteSynchronously(std::string* response_body) {
 
     NSURLResponse* response = nil;
     NSError* error = nil;
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wdeprecated-declarations"
-    // Deprecated in OS X 10.11. The suggested replacement, NSURLSession, is
-    // only available on 10.9 and later, and this needs to run on earlier
-    // releases.
-    NSData* body = [NSURLConnection sendSynchronousRequest:request
-                                         returningResponse:&response
-                                                     error:&error];
-#pragma clang diagnostic pop
+    NSData* body = SendRequest(request, &response, &error);
 
     if (error) {
       LOG(ERROR) << [[error localizedDescription] UTF8String] << " ("
@@ -293,6 +387,11 @@ bool HTTPTransportMac::ExecuteSynchronously(std::string* response_body) {
       return false;
     }
     NSInteger http_status = [http_response statusCode];
+    NSString* retry_after =
+        [[http_response allHeaderFields] objectForKey:@"Retry-After"];
+    SetResponse(static_cast<int>(http_status),
+                retry_after ? base::SysNSStringToUTF8(retry_after)
+                            : std::string());
     if (http_status != 200) {
       LOG(ERROR) << base::StringPrintf("HTTP status %ld",
                                        implicit_cast<long>(http_status));
@@ -328,6 +328,26 @@ TEST(HTTPTransport, Upload33k_LengthUnknown) {
   RunUpload33k(false);
 }
 
+TEST(HTTPTransport, Cancel) {
+  std::unique_ptr<HTTPTransport> transport(HTTPTransport::Create());
+  EXPECT_FALSE(transport->IsCancelled());
+
+  transport->Cancel();
+  EXPECT_TRUE(transport->IsCancelled());
+
+  // A cancelled transport fails without attempting a connection, so the URL
+  // needn’t refer to a server.
+  transport->SetURL("http://127.0.0.1:1/upload");
+  transport->SetBodyStream(
+      std::unique_ptr<HTTPBodyStream>(new StringHTTPBodyStream("body")));
+  std::string response_body;
+  EXPECT_FALSE(transport->ExecuteSynchronously(&response_body));
+  EXPECT_TRUE(transport->IsCancelled());
+
+  transport->ClearCancellation();
+  EXPECT_FALSE(transport->IsCancelled());
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace crashpad
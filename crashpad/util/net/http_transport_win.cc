@@ -28,6 +28,7 @@
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/synchronization/lock.h"
 #include "build/build_config.h"
 #include "package.h"
 #include "util/file/file_io.h"
@@ -127,28 +128,88 @@ class HTTPTransportWin final : public HTTPTransport {
   bool ExecuteSynchronously(std::string* response_body) override;
 
  private:
+  // Returns the session to execute a request with, opening it if necessary.
+  // WinHTTP keeps connections alive per session, so the session is reused by
+  // subsequent requests. Returns nullptr with a message logged on failure.
+  HINTERNET PrepareSession();
+
+  // Sends |request|, which must be the request registered by BeginRequest(),
+  // and reads the response into |response_body|.
+  bool SendRequestAndReadResponse(HINTERNET request,
+                                  std::string* response_body);
+
+  // Takes ownership of |request| as the request being executed. Returns false
+  // with |request| closed if the transport has been cancelled.
+  bool BeginRequest(HINTERNET request);
+
+  // Closes the request being executed, unless CancelRequest() already has.
+  void EndRequest();
+
+  // HTTPTransport:
+  // Closing a request handle causes synchronous WinHTTP calls that are using it
+  // on other threads to fail.
+  void CancelRequest() override;
+
+  ScopedHINTERNET session_;
+
+  // Guards request_, which may be closed by CancelRequest() on any thread.
+  base::Lock request_lock_;
+  ScopedHINTERNET request_;
+
   DISALLOW_COPY_AND_ASSIGN(HTTPTransportWin);
 };
 
-HTTPTransportWin::HTTPTransportWin() : HTTPTransport() {
+HTTPTransportWin::HTTPTransportWin()
+    : HTTPTransport(), session_(), request_lock_(), request_() {
 }
 
 HTTPTransportWin::~HTTPTransportWin() {
 }
 
-bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
-  ScopedHINTERNET session(WinHttpOpen(base::UTF8ToUTF16(UserAgent()).c_str(),
-                                      WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                                      WINHTTP_NO_PROXY_NAME,
-                                      WINHTTP_NO_PROXY_BYPASS,
-                                      0));
-  if (!session.get()) {
+HINTERNET HTTPTransportWin::PrepareSession() {
+  if (session_.is_valid()) {
+    return session_.get();
+  }
+
+  session_.reset(WinHttpOpen(base::UTF8ToUTF16(UserAgent()).c_str(),
+                             WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                             WINHTTP_NO_PROXY_NAME,
+                             WINHTTP_NO_PROXY_BYPASS,
+                             0));
+  if (!session_.is_valid()) {
     LOG(ERROR) << WinHttpMessage("WinHttpOpen");
+    return nullptr;
+  }
+
+#if defined(WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL)
+  // Negotiate HTTP/2 where the server supports it, falling back to HTTP/1.1.
+  // This option is only recognized as of Windows 10 1607, and failure is
+  // harmless, so it’s not logged.
+  DWORD protocols = WINHTTP_PROTOCOL_FLAG_HTTP2;
+  WinHttpSetOption(session_.get(),
+                   WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL,
+                   &protocols,
+                   sizeof(protocols));
+#endif
+
+  return session_.get();
+}
+
+bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
+  SetResponse(0, std::string());
+
+  if (IsCancelled()) {
+    LOG(ERROR) << "cancelled";
+    return false;
+  }
+
+  const HINTERNET session = PrepareSession();
+  if (!session) {
     return false;
   }
 
   int timeout_in_ms = static_cast<int>(timeout() * 1000);
-  if (!WinHttpSetTimeouts(session.get(),
+  if (!WinHttpSetTimeouts(session,
                           timeout_in_ms,
                           timeout_in_ms,
                           timeout_in_ms,
@@ -190,13 +251,13 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
       url_path.append(extra_info.substr(0, extra_info.find(L'#'))));
 
   ScopedHINTERNET connect(WinHttpConnect(
-      session.get(), host_name.c_str(), url_components.nPort, 0));
+      session, host_name.c_str(), url_components.nPort, 0));
   if (!connect.get()) {
     LOG(ERROR) << WinHttpMessage("WinHttpConnect");
     return false;
   }
 
-  ScopedHINTERNET request(WinHttpOpenRequest(
+  HINTERNET request = WinHttpOpenRequest(
       connect.get(),
       base::UTF8ToUTF16(method()).c_str(),
       request_target.c_str(),
@@ -204,12 +265,47 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
       WINHTTP_NO_REFERER,
       WINHTTP_DEFAULT_ACCEPT_TYPES,
       url_components.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE
-                                                      : 0));
-  if (!request.get()) {
+                                                      : 0);
+  if (!request) {
     LOG(ERROR) << WinHttpMessage("WinHttpOpenRequest");
     return false;
   }
 
+  if (!BeginRequest(request)) {
+    LOG(ERROR) << "cancelled";
+    return false;
+  }
+
+  const bool success = SendRequestAndReadResponse(request, response_body);
+  EndRequest();
+  return success;
+}
+
+bool HTTPTransportWin::BeginRequest(HINTERNET request) {
+  // Checking IsCancelled() with request_lock_ held ensures that a concurrent
+  // Cancel() either is observed here or closes |request|.
+  base::AutoLock lock(request_lock_);
+  DCHECK(!request_.is_valid());
+  request_.reset(request);
+  if (IsCancelled()) {
+    request_.reset();
+    return false;
+  }
+  return true;
+}
+
+void HTTPTransportWin::EndRequest() {
+  base::AutoLock lock(request_lock_);
+  request_.reset();
+}
+
+void HTTPTransportWin::CancelRequest() {
+  base::AutoLock lock(request_lock_);
+  request_.reset();
+}
+
+bool HTTPTransportWin::SendRequestAndReadResponse(HINTERNET request,
+                                                  std::string* response_body) {
   // Add headers to the request.
   //
   // If Content-Length is not provided, implement chunked mode per RFC 7230
@@ -230,7 +326,7 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
       std::wstring header_string = base::UTF8ToUTF16(pair.first) + L": " +
                                    base::UTF8ToUTF16(pair.second) + L"\r\n";
       if (!WinHttpAddRequestHeaders(
-              request.get(),
+              request,
               header_string.c_str(),
               base::checked_cast<DWORD>(header_string.size()),
               WINHTTP_ADDREQ_FLAG_ADD)) {
@@ -245,7 +341,7 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
     static constexpr wchar_t kTransferEncodingHeader[] =
         L"Transfer-Encoding: chunked\r\n";
     if (!WinHttpAddRequestHeaders(
-            request.get(),
+            request,
             kTransferEncodingHeader,
             base::checked_cast<DWORD>(wcslen(kTransferEncodingHeader)),
             WINHTTP_ADDREQ_FLAG_ADD)) {
@@ -258,7 +354,7 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
     content_length_dword = WINHTTP_IGNORE_REQUEST_TOTAL_LENGTH;
   }
 
-  if (!WinHttpSendRequest(request.get(),
+  if (!WinHttpSendRequest(request,
                           WINHTTP_NO_ADDITIONAL_HEADERS,
                           0,
                           WINHTTP_NO_REQUEST_DATA,
@@ -337,7 +433,7 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
     // a 0 return from body_stream()->GetBytesBuffer() above.
     if (write_size != 0) {
       DWORD written;
-      if (!WinHttpWriteData(request.get(), write_start, write_size, &written)) {
+      if (!WinHttpWriteData(request, write_start, write_size, &written)) {
         LOG(ERROR) << WinHttpMessage("WinHttpWriteData");
         return false;
       }
@@ -351,7 +447,7 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
     DCHECK_EQ(total_written, content_length);
   }
 
-  if (!WinHttpReceiveResponse(request.get(), nullptr)) {
+  if (!WinHttpReceiveResponse(request, nullptr)) {
     LOG(ERROR) << WinHttpMessage("WinHttpReceiveResponse");
     return false;
   }
@@ -360,7 +456,7 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
   DWORD sizeof_status_code = sizeof(status_code);
 
   if (!WinHttpQueryHeaders(
-          request.get(),
+          request,
           WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
           WINHTTP_HEADER_NAME_BY_INDEX,
           &status_code,
@@ -370,6 +466,22 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
     return false;
   }
 
+  // A response without a Retry-After header field fails this query with
+  // ERROR_WINHTTP_HEADER_NOT_FOUND, which isn’t an error here.
+  wchar_t retry_after[64];
+  DWORD sizeof_retry_after = sizeof(retry_after);
+  std::string retry_after_utf8;
+  if (WinHttpQueryHeaders(request,
+                          WINHTTP_QUERY_RETRY_AFTER,
+                          WINHTTP_HEADER_NAME_BY_INDEX,
+                          retry_after,
+                          &sizeof_retry_after,
+                          WINHTTP_NO_HEADER_INDEX)) {
+    retry_after_utf8 = base::UTF16ToUTF8(
+        std::wstring(retry_after, sizeof_retry_after / sizeof(retry_after[0])));
+  }
+  SetResponse(static_cast<int>(status_code), retry_after_utf8);
+
   if (status_code != 200) {
     LOG(ERROR) << base::StringPrintf("HTTP status %lu", status_code);
     return false;
@@ -386,7 +498,7 @@ bool HTTPTransportWin::ExecuteSynchronously(std::string* response_body) {
     do {
       char read_buffer[4096];
       if (!WinHttpReadData(
-              request.get(), read_buffer, sizeof(read_buffer), &bytes_read)) {
+              request, read_buffer, sizeof(read_buffer), &bytes_read)) {
         LOG(ERROR) << WinHttpMessage("WinHttpReadData");
         return false;
       }
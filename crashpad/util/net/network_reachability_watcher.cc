@@ -0,0 +1,94 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/network_reachability_watcher.h"
+
+#if defined(OS_POSIX)
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "base/logging.h"
+#endif  // OS_POSIX
+
+namespace crashpad {
+
+bool NetworkReachabilityWatcher::IsReachable() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  base::AutoLock lock(state_lock_);
+  return reachable_;
+}
+
+bool NetworkReachabilityWatcher::IsMetered() const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  base::AutoLock lock(state_lock_);
+  return metered_;
+}
+
+bool NetworkReachabilityWatcher::SetState(bool reachable, bool metered) {
+  base::AutoLock lock(state_lock_);
+  if (reachable == reachable_ && metered == metered_) {
+    return false;
+  }
+
+  reachable_ = reachable;
+  metered_ = metered;
+  return true;
+}
+
+#if defined(OS_POSIX)
+
+// static
+bool NetworkReachabilityWatcher::InterfaceReachable() {
+  ifaddrs* interfaces;
+  if (getifaddrs(&interfaces) != 0) {
+    // Uploads shouldn’t be held up by a failure to tell whether they can
+    // succeed.
+    PLOG(ERROR) << "getifaddrs";
+    return true;
+  }
+
+  bool reachable = false;
+  for (const ifaddrs* entry = interfaces; entry && !reachable;
+       entry = entry->ifa_next) {
+    if (!entry->ifa_addr ||
+        (entry->ifa_flags & (IFF_UP | IFF_RUNNING | IFF_LOOPBACK)) !=
+            (IFF_UP | IFF_RUNNING)) {
+      continue;
+    }
+
+    switch (entry->ifa_addr->sa_family) {
+      case AF_INET:
+        reachable = true;
+        break;
+      case AF_INET6: {
+        // Every IPv6 interface has a link-local address, which is of no use
+        // for reaching a server beyond the link.
+        const in6_addr& address =
+            reinterpret_cast<const sockaddr_in6*>(entry->ifa_addr)
+                ->sin6_addr;
+        reachable = !IN6_IS_ADDR_LINKLOCAL(&address);
+        break;
+      }
+    }
+  }
+
+  freeifaddrs(interfaces);
+  return reachable;
+}
+
+#endif  // OS_POSIX
+
+}  // namespace crashpad
@@ -0,0 +1,138 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_NET_NETWORK_REACHABILITY_WATCHER_H_
+#define CRASHPAD_UTIL_NET_NETWORK_REACHABILITY_WATCHER_H_
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "build/build_config.h"
+#include "util/misc/initialization_state_dcheck.h"
+#include "util/thread/thread.h"
+
+#if defined(OS_POSIX)
+#include "base/files/scoped_file.h"
+#elif defined(OS_WIN)
+#include "util/win/scoped_handle.h"
+#endif  // OS_POSIX
+
+namespace crashpad {
+
+//! \brief Watches whether a network is reachable, notifying a delegate on a
+//!     dedicated thread when that changes.
+//!
+//! The network is taken to be reachable when an interface other than a
+//! loopback interface is up and has an address that may be routable, which is
+//! a precondition for reaching any server, but not a guarantee of it. A network
+//! behind a captive portal appears reachable.
+//!
+//! Changes are learned of through a `NETLINK_ROUTE` socket on Linux and
+//! Android, a `PF_ROUTE` routing socket on macOS, and `NotifyAddrChange()` on
+//! Windows. Changes that occur in quick succession may result in a single
+//! notification.
+class NetworkReachabilityWatcher final : public Thread {
+ public:
+  //! \brief An interface for receiving reachability notifications.
+  class Delegate {
+   public:
+    //! \brief Called on the watcher’s thread when IsReachable() or IsMetered()
+    //!     may have changed.
+    virtual void NetworkReachabilityChanged() = 0;
+
+   protected:
+    ~Delegate() {}
+  };
+
+  NetworkReachabilityWatcher();
+  ~NetworkReachabilityWatcher() override;
+
+  //! \brief Begins watching the system’s network interfaces, and determines
+  //!     whether a network is reachable now.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool Initialize();
+
+  //! \brief Starts a dedicated thread that calls
+  //!     Delegate::NetworkReachabilityChanged() when the network changes.
+  //!
+  //! This method may be called after Initialize() has succeeded, and again
+  //! after Stop(). Changes that occur while the thread is stopped are not
+  //! reported, but are reflected in IsReachable() and IsMetered() once it is
+  //! started again.
+  //!
+  //! \param[in] delegate The delegate to notify. It must outlive the thread.
+  void Start(Delegate* delegate);
+
+  //! \brief Stops the thread started by Start(), and waits for it to exit.
+  //!
+  //! This method must be called after Start(), and before destroying the
+  //! object. It may not be called from the watcher’s thread.
+  void Stop();
+
+  //! \brief Returns whether a network was reachable when last examined.
+  //!
+  //! This method may be called from any thread once Initialize() has
+  //! succeeded.
+  bool IsReachable() const;
+
+  //! \brief Returns whether the network was metered, such that the user may
+  //!     pay for the data sent over it, when last examined.
+  //!
+  //! This is only determined on Windows 10 version 2004 and later, and is
+  //! `false` elsewhere. This method may be called from any thread once
+  //! Initialize() has succeeded.
+  bool IsMetered() const;
+
+ private:
+  // Thread:
+  void ThreadMain() override;
+
+  // Examines the system’s network interfaces, updating the state returned by
+  // IsReachable() and IsMetered(). Returns true if that state changed. This is
+  // implemented separately for each platform.
+  bool Examine();
+
+  // Records the state returned by IsReachable() and IsMetered(), returning true
+  // if it changed.
+  bool SetState(bool reachable, bool metered);
+
+#if defined(OS_POSIX)
+  // Returns whether an interface other than a loopback interface is up and has
+  // an IPv4 address or an IPv6 address beyond link-local scope.
+  static bool InterfaceReachable();
+#endif  // OS_POSIX
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  base::ScopedFD netlink_fd_;
+  base::ScopedFD stop_fd_;  // An eventfd.
+#elif defined(OS_MACOSX)
+  base::ScopedFD route_fd_;
+  base::ScopedFD kqueue_fd_;
+#elif defined(OS_WIN)
+  ScopedKernelHANDLE change_event_;
+  ScopedKernelHANDLE stop_event_;
+#endif  // OS_LINUX || OS_ANDROID
+
+  mutable base::Lock state_lock_;
+  bool reachable_;
+  bool metered_;
+  Delegate* delegate_;  // weak
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(NetworkReachabilityWatcher);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_NET_NETWORK_REACHABILITY_WATCHER_H_
@@ -0,0 +1,160 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/network_reachability_watcher.h"
+
+#include <errno.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace crashpad {
+
+NetworkReachabilityWatcher::NetworkReachabilityWatcher()
+    : Thread(),
+      netlink_fd_(),
+      stop_fd_(),
+      state_lock_(),
+      reachable_(true),
+      metered_(false),
+      delegate_(nullptr),
+      initialized_() {
+}
+
+NetworkReachabilityWatcher::~NetworkReachabilityWatcher() {
+}
+
+bool NetworkReachabilityWatcher::Initialize() {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  netlink_fd_.reset(socket(
+      AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE));
+  if (!netlink_fd_.is_valid()) {
+    PLOG(ERROR) << "socket";
+    return false;
+  }
+
+  // Links going up or down and addresses coming and going are what change
+  // whether an interface can reach the network.
+  sockaddr_nl address = {};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+  if (bind(netlink_fd_.get(),
+           reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) != 0) {
+    PLOG(ERROR) << "bind";
+    return false;
+  }
+
+  stop_fd_.reset(eventfd(0, EFD_CLOEXEC));
+  if (!stop_fd_.is_valid()) {
+    PLOG(ERROR) << "eventfd";
+    return false;
+  }
+
+  // Changes are only recorded once the socket is bound, so the state examined
+  // now can’t miss one.
+  Examine();
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+void NetworkReachabilityWatcher::Start(Delegate* delegate) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(!delegate_);
+
+  delegate_ = delegate;
+  Thread::Start();
+}
+
+void NetworkReachabilityWatcher::Stop() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(delegate_);
+
+  const uint64_t value = 1;
+  if (HANDLE_EINTR(write(stop_fd_.get(), &value, sizeof(value))) !=
+      sizeof(value)) {
+    PLOG(ERROR) << "write";
+  }
+  Join();
+  delegate_ = nullptr;
+}
+
+void NetworkReachabilityWatcher::ThreadMain() {
+  // Changes that occurred while the thread was stopped are still queued on the
+  // socket, unless it overflowed, so the state is examined afresh.
+  if (Examine()) {
+    delegate_->NetworkReachabilityChanged();
+  }
+
+  pollfd fds[2] = {};
+  fds[0].fd = netlink_fd_.get();
+  fds[0].events = POLLIN;
+  fds[1].fd = stop_fd_.get();
+  fds[1].events = POLLIN;
+
+  while (true) {
+    if (HANDLE_EINTR(poll(fds, arraysize(fds), -1)) < 0) {
+      PLOG(ERROR) << "poll";
+      return;
+    }
+
+    if (fds[1].revents) {
+      // Reset the eventfd’s counter, so that the thread can be restarted.
+      uint64_t value;
+      if (HANDLE_EINTR(read(stop_fd_.get(), &value, sizeof(value))) !=
+          sizeof(value)) {
+        PLOG(ERROR) << "read";
+      }
+      return;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      // Drain all pending messages, examining the interfaces once for all of
+      // them. The messages themselves aren’t parsed. An overflow of the
+      // socket’s buffer, reported as ENOBUFS, loses messages, but the
+      // interfaces are examined all the same.
+      alignas(nlmsghdr) char buffer[8192];
+      ssize_t rv;
+      do {
+        rv = HANDLE_EINTR(recv(netlink_fd_.get(), buffer, sizeof(buffer), 0));
+      } while (rv > 0 || (rv < 0 && errno == ENOBUFS));
+      if (rv < 0 && errno != EAGAIN) {
+        PLOG(ERROR) << "recv";
+        return;
+      }
+
+      if (Examine()) {
+        delegate_->NetworkReachabilityChanged();
+      }
+    } else if (fds[0].revents) {
+      LOG(ERROR) << "poll: unexpected revents " << fds[0].revents;
+      return;
+    }
+  }
+}
+
+bool NetworkReachabilityWatcher::Examine() {
+  return SetState(InterfaceReachable(), false);
+}
+
+}  // namespace crashpad
@@ -0,0 +1,175 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/network_reachability_watcher.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <net/route.h>
+#include <sys/event.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace crashpad {
+
+namespace {
+
+// The identifier of the EVFILT_USER event that Stop() triggers.
+constexpr uintptr_t kStopIdent = 0;
+
+}  // namespace
+
+NetworkReachabilityWatcher::NetworkReachabilityWatcher()
+    : Thread(),
+      route_fd_(),
+      kqueue_fd_(),
+      state_lock_(),
+      reachable_(true),
+      metered_(false),
+      delegate_(nullptr),
+      initialized_() {
+}
+
+NetworkReachabilityWatcher::~NetworkReachabilityWatcher() {
+}
+
+bool NetworkReachabilityWatcher::Initialize() {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  // A routing socket receives a message for every change to the system’s
+  // routes, interfaces, and addresses. Unlike SCNetworkReachability, it can be
+  // waited on with kqueue alongside the stop event, without a run loop or
+  // dispatch queue.
+  route_fd_.reset(socket(PF_ROUTE, SOCK_RAW, AF_UNSPEC));
+  if (!route_fd_.is_valid()) {
+    PLOG(ERROR) << "socket";
+    return false;
+  }
+  if (fcntl(route_fd_.get(), F_SETFL, O_NONBLOCK) != 0 ||
+      fcntl(route_fd_.get(), F_SETFD, FD_CLOEXEC) != 0) {
+    PLOG(ERROR) << "fcntl";
+    return false;
+  }
+
+  kqueue_fd_.reset(kqueue());
+  if (!kqueue_fd_.is_valid()) {
+    PLOG(ERROR) << "kqueue";
+    return false;
+  }
+
+  struct kevent changes[2];
+  EV_SET(&changes[0],
+         route_fd_.get(),
+         EVFILT_READ,
+         EV_ADD | EV_CLEAR,
+         0,
+         0,
+         nullptr);
+  EV_SET(&changes[1],
+         kStopIdent,
+         EVFILT_USER,
+         EV_ADD | EV_CLEAR,
+         0,
+         0,
+         nullptr);
+  if (kevent(kqueue_fd_.get(), changes, arraysize(changes), nullptr, 0,
+             nullptr) != 0) {
+    PLOG(ERROR) << "kevent";
+    return false;
+  }
+
+  // Changes are only recorded once the socket exists, so the state examined
+  // now can’t miss one.
+  Examine();
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+void NetworkReachabilityWatcher::Start(Delegate* delegate) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(!delegate_);
+
+  delegate_ = delegate;
+  Thread::Start();
+}
+
+void NetworkReachabilityWatcher::Stop() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(delegate_);
+
+  struct kevent change;
+  EV_SET(&change, kStopIdent, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+  if (kevent(kqueue_fd_.get(), &change, 1, nullptr, 0, nullptr) != 0) {
+    PLOG(ERROR) << "kevent";
+  }
+  Join();
+  delegate_ = nullptr;
+}
+
+void NetworkReachabilityWatcher::ThreadMain() {
+  // Changes made while the thread was stopped may have overflowed the socket’s
+  // buffer, so the state is examined afresh.
+  if (Examine()) {
+    delegate_->NetworkReachabilityChanged();
+  }
+
+  while (true) {
+    struct kevent event;
+    int rv = HANDLE_EINTR(
+        kevent(kqueue_fd_.get(), nullptr, 0, &event, 1, nullptr));
+    if (rv < 0) {
+      PLOG(ERROR) << "kevent";
+      return;
+    }
+    if (rv == 0) {
+      continue;
+    }
+
+    if (event.filter == EVFILT_USER) {
+      return;
+    }
+    if (event.flags & EV_ERROR) {
+      LOG(ERROR) << "kevent: error " << event.data;
+      return;
+    }
+
+    // Drain all pending messages, examining the interfaces once for all of
+    // them. The messages themselves aren’t parsed.
+    char buffer[4096];
+    ssize_t bytes;
+    do {
+      bytes = HANDLE_EINTR(read(route_fd_.get(), buffer, sizeof(buffer)));
+    } while (bytes > 0 || (bytes < 0 && errno == ENOBUFS));
+    if (bytes < 0 && errno != EAGAIN) {
+      PLOG(ERROR) << "read";
+      return;
+    }
+
+    if (Examine()) {
+      delegate_->NetworkReachabilityChanged();
+    }
+  }
+}
+
+bool NetworkReachabilityWatcher::Examine() {
+  return SetState(InterfaceReachable(), false);
+}
+
+}  // namespace crashpad
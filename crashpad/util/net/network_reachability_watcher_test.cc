@@ -0,0 +1,61 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/network_reachability_watcher.h"
+
+#include "base/macros.h"
+#include "build/build_config.h"
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+class TestDelegate : public NetworkReachabilityWatcher::Delegate {
+ public:
+  TestDelegate() : NetworkReachabilityWatcher::Delegate() {}
+  ~TestDelegate() {}
+
+  // NetworkReachabilityWatcher::Delegate:
+  void NetworkReachabilityChanged() override {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TestDelegate);
+};
+
+// The network can’t be changed from a test, so this only checks that the
+// watcher can be started and stopped, repeatedly, with its state intact.
+TEST(NetworkReachabilityWatcher, StartAndStop) {
+  NetworkReachabilityWatcher watcher;
+  ASSERT_TRUE(watcher.Initialize());
+
+  const bool reachable = watcher.IsReachable();
+#if !defined(OS_WIN)
+  EXPECT_FALSE(watcher.IsMetered());
+#endif  // !OS_WIN
+
+  TestDelegate delegate;
+  watcher.Start(&delegate);
+  watcher.Stop();
+
+  // The watcher can be started again after it has been stopped.
+  watcher.Start(&delegate);
+  watcher.Stop();
+
+  EXPECT_EQ(watcher.IsReachable(), reachable);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
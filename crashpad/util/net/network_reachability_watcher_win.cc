@@ -0,0 +1,185 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/net/network_reachability_watcher.h"
+
+#include <winsock2.h>
+#include <iphlpapi.h>
+#include <windows.h>
+
+#include <memory>
+
+#include "base/logging.h"
+#include "util/win/get_function.h"
+
+namespace crashpad {
+
+namespace {
+
+// Returns whether an adapter other than a loopback adapter is up and has a
+// unicast address.
+bool AdapterReachable() {
+  constexpr ULONG kFlags = GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST |
+                           GAA_FLAG_SKIP_DNS_SERVER |
+                           GAA_FLAG_SKIP_FRIENDLY_NAME;
+
+  // The size of the adapters’ addresses can change between calls, so the
+  // buffer is grown as GetAdaptersAddresses() asks, a few times at most.
+  ULONG size = 16 * 1024;
+  std::unique_ptr<char[]> buffer;
+  ULONG result = ERROR_BUFFER_OVERFLOW;
+  for (int attempt = 0; attempt < 3 && result == ERROR_BUFFER_OVERFLOW;
+       ++attempt) {
+    buffer.reset(new char[size]);
+    result = GetAdaptersAddresses(
+        AF_UNSPEC,
+        kFlags,
+        nullptr,
+        reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.get()),
+        &size);
+  }
+  if (result == ERROR_NO_DATA) {
+    return false;
+  }
+  if (result != ERROR_SUCCESS) {
+    // Uploads shouldn’t be held up by a failure to tell whether they can
+    // succeed.
+    LOG(ERROR) << "GetAdaptersAddresses: " << result;
+    return true;
+  }
+
+  for (const IP_ADAPTER_ADDRESSES* adapter =
+           reinterpret_cast<const IP_ADAPTER_ADDRESSES*>(buffer.get());
+       adapter;
+       adapter = adapter->Next) {
+    if (adapter->OperStatus == IfOperStatusUp &&
+        adapter->IfType != IF_TYPE_SOFTWARE_LOOPBACK &&
+        adapter->FirstUnicastAddress) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns whether the network that Windows prefers is metered. The hint is only
+// available from Windows 10 version 2004, and only declared by SDKs targeting
+// it.
+bool NetworkMetered() {
+#if defined(NTDDI_WIN10_VB) && NTDDI_VERSION >= NTDDI_WIN10_VB
+  static const auto get_network_connectivity_hint =
+      GET_FUNCTION(L"iphlpapi.dll", ::GetNetworkConnectivityHint);
+  NL_NETWORK_CONNECTIVITY_HINT hint;
+  if (get_network_connectivity_hint &&
+      get_network_connectivity_hint(&hint) == NO_ERROR) {
+    return hint.ConnectivityCost == NetworkConnectivityCostHintFixed ||
+           hint.ConnectivityCost == NetworkConnectivityCostHintVariable ||
+           hint.OverDataLimit || hint.Roaming;
+  }
+#endif
+  return false;
+}
+
+}  // namespace
+
+NetworkReachabilityWatcher::NetworkReachabilityWatcher()
+    : Thread(),
+      change_event_(),
+      stop_event_(),
+      state_lock_(),
+      reachable_(true),
+      metered_(false),
+      delegate_(nullptr),
+      initialized_() {
+}
+
+NetworkReachabilityWatcher::~NetworkReachabilityWatcher() {
+}
+
+bool NetworkReachabilityWatcher::Initialize() {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  change_event_.reset(CreateEvent(nullptr, true, false, nullptr));
+  stop_event_.reset(CreateEvent(nullptr, true, false, nullptr));
+  if (!change_event_.is_valid() || !stop_event_.is_valid()) {
+    PLOG(ERROR) << "CreateEvent";
+    return false;
+  }
+
+  Examine();
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+void NetworkReachabilityWatcher::Start(Delegate* delegate) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(!delegate_);
+
+  delegate_ = delegate;
+  Thread::Start();
+}
+
+void NetworkReachabilityWatcher::Stop() {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(delegate_);
+
+  if (!SetEvent(stop_event_.get())) {
+    PLOG(ERROR) << "SetEvent";
+  }
+  Join();
+
+  if (!ResetEvent(stop_event_.get())) {
+    PLOG(ERROR) << "ResetEvent";
+  }
+  delegate_ = nullptr;
+}
+
+void NetworkReachabilityWatcher::ThreadMain() {
+  while (true) {
+    // Each notification is requested before the state is examined, so that
+    // changes made while it’s examined aren’t missed. This also catches changes
+    // made while the thread was stopped.
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = change_event_.get();
+    if (!ResetEvent(change_event_.get())) {
+      PLOG(ERROR) << "ResetEvent";
+      return;
+    }
+    HANDLE notify_handle;
+    DWORD result = NotifyAddrChange(&notify_handle, &overlapped);
+    if (result != ERROR_IO_PENDING) {
+      LOG(ERROR) << "NotifyAddrChange: " << result;
+      return;
+    }
+
+    if (Examine()) {
+      delegate_->NetworkReachabilityChanged();
+    }
+
+    HANDLE handles[] = {change_event_.get(), stop_event_.get()};
+    result =
+        WaitForMultipleObjects(arraysize(handles), handles, false, INFINITE);
+    if (result != WAIT_OBJECT_0) {
+      PLOG_IF(ERROR, result != WAIT_OBJECT_0 + 1) << "WaitForMultipleObjects";
+      CancelIPChangeNotify(&overlapped);
+      return;
+    }
+  }
+}
+
+bool NetworkReachabilityWatcher::Examine() {
+  return SetState(AdapterReachable(), NetworkMetered());
+}
+
+}  // namespace crashpad
@@ -34,6 +34,7 @@
 #endif
 
 #if defined(OS_LINUX) || defined(OS_ANDROID)
+#include "util/linux/proc_directory.h"
 #include "util/linux/ptrace_connection.h"
 #endif
 
@@ -59,6 +60,20 @@ class ProcessInfo {
   //!
   //! \return `true` on success, `false` on failure with a message logged.
   bool InitializeWithPtrace(PtraceConnection* connection);
+
+  //! \brief Initializes this object with information about the process whose ID
+  //!     is \a pid, whose memory is read through a PtraceConnection \a
+  //!     fork_connection to a copy-on-write fork of it.
+  //!
+  //! This method may be called in place of InitializeWithPtrace() with the same
+  //! restrictions and considerations. The information returned describes \a
+  //! pid, not its fork.
+  //!
+  //! \param[in] fork_connection A connection to the fork of \a pid.
+  //! \param[in] pid The process ID to obtain information for.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool InitializeWithPtraceToFork(PtraceConnection* fork_connection, pid_t pid);
 #endif  // OS_LINUX || OS_ANDROID || DOXYGEN
 
 #if defined(OS_MACOSX) || DOXYGEN
@@ -169,12 +184,15 @@ class ProcessInfo {
 #if defined(OS_MACOSX)
   kinfo_proc kern_proc_info_;
 #elif defined(OS_LINUX) || defined(OS_ANDROID)
+  bool InitializeFromProcDirectory(pid_t pid, bool is_64_bit);
+
   // Some members are marked mutable so that they can be lazily initialized by
   // const methods. These are always InitializationState-protected so that
   // multiple successive calls will always produce the same return value and out
   // parameters. This is necessary for intergration with the Snapshot interface.
   // See https://crashpad.chromium.org/bug/9.
   std::set<gid_t> supplementary_groups_;
+  ProcDirectory proc_dir_;
   mutable timeval start_time_;
   pid_t pid_;
   pid_t ppid_;
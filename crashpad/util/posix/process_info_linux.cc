@@ -14,12 +14,9 @@
 
 #include "util/posix/process_info.h"
 
-#include <stdio.h>
-
-#include "base/files/file_path.h"
 #include "base/logging.h"
 #include "util/file/delimited_file_reader.h"
-#include "util/file/file_reader.h"
+#include "util/file/string_file.h"
 #include "util/linux/proc_stat_reader.h"
 #include "util/misc/lexing.h"
 
@@ -27,6 +24,7 @@ namespace crashpad {
 
 ProcessInfo::ProcessInfo()
     : supplementary_groups_(),
+      proc_dir_(),
       start_time_(),
       pid_(-1),
       ppid_(-1),
@@ -42,19 +40,37 @@ ProcessInfo::ProcessInfo()
 ProcessInfo::~ProcessInfo() {}
 
 bool ProcessInfo::InitializeWithPtrace(PtraceConnection* connection) {
-  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
   DCHECK(connection);
+  return InitializeFromProcDirectory(connection->GetProcessID(),
+                                     connection->Is64Bit());
+}
+
+bool ProcessInfo::InitializeWithPtraceToFork(PtraceConnection* fork_connection,
+                                             pid_t pid) {
+  DCHECK(fork_connection);
+
+  // A fork shares its parent’s executable, so it has the same bitness.
+  return InitializeFromProcDirectory(pid, fork_connection->Is64Bit());
+}
 
-  pid_ = connection->GetProcessID();
-  is_64_bit_ = connection->Is64Bit();
+bool ProcessInfo::InitializeFromProcDirectory(pid_t pid, bool is_64_bit) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  pid_ = pid;
+  is_64_bit_ = is_64_bit;
+
+  if (!proc_dir_.Initialize(pid_)) {
+    return false;
+  }
 
   {
-    char path[32];
-    snprintf(path, sizeof(path), "/proc/%d/status", pid_);
-    FileReader status_file;
-    if (!status_file.Open(base::FilePath(path))) {
+    // Read the whole file at once, and then parse it line by line from memory.
+    std::string status;
+    if (!proc_dir_.ReadEntireFile("status", &status)) {
       return false;
     }
+    StringFile status_file;
+    status_file.SetString(status);
 
     DelimitedFileReader status_file_line_reader(&status_file);
 
@@ -230,7 +246,7 @@ bool ProcessInfo::StartTime(timeval* start_time) const {
   if (start_time_initialized_.is_uninitialized()) {
     start_time_initialized_.set_invalid();
     ProcStatReader reader;
-    if (!reader.Initialize(pid_)) {
+    if (!reader.Initialize(proc_dir_, pid_)) {
       return false;
     }
     if (!reader.StartTime(&start_time_)) {
@@ -250,12 +266,12 @@ bool ProcessInfo::StartTime(timeval* start_time) const {
 bool ProcessInfo::Arguments(std::vector<std::string>* argv) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
 
-  char path[32];
-  snprintf(path, sizeof(path), "/proc/%d/cmdline", pid_);
-  FileReader cmdline_file;
-  if (!cmdline_file.Open(base::FilePath(path))) {
+  std::string cmdline;
+  if (!proc_dir_.ReadEntireFile("cmdline", &cmdline)) {
     return false;
   }
+  StringFile cmdline_file;
+  cmdline_file.SetString(cmdline);
 
   DelimitedFileReader cmdline_file_field_reader(&cmdline_file);
 
@@ -14,24 +14,46 @@
 
 #include "util/process/process_memory.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <utility>
 
 #include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/posix/eintr_wrapper.h"
+#include "util/linux/process_recording.h"
+#include "util/misc/memory_read_trace.h"
 
 namespace crashpad {
 
-ProcessMemory::ProcessMemory() : mem_fd_(), pid_(-1) {}
+namespace {
+
+// The number of reads of /proc/<pid>/mem that ReadBatch() keeps outstanding.
+constexpr unsigned int kRingDepth = 64;
+
+}  // namespace
+
+ProcessMemory::ProcessMemory()
+    : mem_fd_(),
+      ring_(),
+      ring_unavailable_(false),
+      recording_(nullptr),
+      replay_(nullptr),
+      pid_(-1) {}
 
 ProcessMemory::~ProcessMemory() {}
 
 bool ProcessMemory::Initialize(pid_t pid) {
   pid_ = pid;
+  ring_.reset();
+  ring_unavailable_ = false;
   char path[32];
   snprintf(path, sizeof(path), "/proc/%d/mem", pid_);
   mem_fd_.reset(HANDLE_EINTR(open(path, O_RDONLY | O_NOCTTY | O_CLOEXEC)));
@@ -42,15 +64,26 @@ bool ProcessMemory::Initialize(pid_t pid) {
   return true;
 }
 
+void ProcessMemory::InitializeFromRecording(const ProcessRecording* recording) {
+  pid_ = recording->ProcessID();
+  ring_.reset();
+  mem_fd_.reset();
+  replay_ = recording;
+}
+
+void ProcessMemory::SetRecording(ProcessRecording* recording) {
+  DCHECK(!replay_);
+  recording_ = recording;
+}
+
 bool ProcessMemory::Read(VMAddress address,
                          size_t size,
                          void* buffer) const {
-  DCHECK(mem_fd_.is_valid());
+  DCHECK(mem_fd_.is_valid() || replay_);
 
   char* buffer_c = static_cast<char*>(buffer);
   while (size > 0) {
-    ssize_t bytes_read =
-        HANDLE_EINTR(pread64(mem_fd_.get(), buffer_c, size, address));
+    ssize_t bytes_read = ReadPartial(address, size, buffer_c);
     if (bytes_read < 0) {
       PLOG(ERROR) << "pread64";
       return false;
@@ -67,6 +100,125 @@ bool ProcessMemory::Read(VMAddress address,
   return true;
 }
 
+bool ProcessMemory::ReadBatch(const std::vector<ReadRequest>& requests) const {
+  DCHECK(mem_fd_.is_valid() || replay_);
+
+  // The kernel accepts at most UIO_MAXIOV iovecs on each side of a single
+  // process_vm_readv() call.
+  constexpr size_t kMaxIovecs = 1024;
+
+  std::vector<iovec> local_iovecs;
+  std::vector<iovec> remote_iovecs;
+  // A replay is served entirely by Read().
+  bool use_process_vm_readv = !replay_;
+  size_t index = 0;
+  while (index < requests.size()) {
+    if (!use_process_vm_readv) {
+      return ReadBatchFromFile(requests, index);
+    }
+
+    local_iovecs.clear();
+    remote_iovecs.clear();
+    size_t batch_size = 0;
+    size_t batch_end = index;
+    while (batch_end < requests.size() && local_iovecs.size() < kMaxIovecs) {
+      const ReadRequest& request = requests[batch_end];
+      if (!base::IsValueInRangeForNumericType<uintptr_t>(request.address)) {
+        // This region can’t be named by a remote iovec in this process, so it
+        // must be read from /proc/<pid>/mem.
+        break;
+      }
+      ++batch_end;
+      if (request.size == 0) {
+        continue;
+      }
+
+      iovec local_iovec;
+      local_iovec.iov_base = request.buffer;
+      local_iovec.iov_len = request.size;
+      local_iovecs.push_back(local_iovec);
+
+      iovec remote_iovec;
+      remote_iovec.iov_base =
+          reinterpret_cast<void*>(static_cast<uintptr_t>(request.address));
+      remote_iovec.iov_len = request.size;
+      remote_iovecs.push_back(remote_iovec);
+
+      batch_size += request.size;
+    }
+
+    if (local_iovecs.empty()) {
+      if (batch_end == index) {
+        const ReadRequest& request = requests[index++];
+        if (!Read(request.address, request.size, request.buffer)) {
+          return false;
+        }
+      } else {
+        index = batch_end;
+      }
+      continue;
+    }
+
+    ssize_t rv;
+    {
+      ScopedMemoryRead read(batch_size);
+      rv = syscall(SYS_process_vm_readv,
+                   pid_,
+                   &local_iovecs[0],
+                   local_iovecs.size(),
+                   &remote_iovecs[0],
+                   remote_iovecs.size(),
+                   0);
+    }
+    size_t bytes_read;
+    if (rv < 0) {
+      if (errno == ENOSYS || errno == EPERM) {
+        // process_vm_readv() is unavailable, either because the kernel predates
+        // it or because it’s disallowed. Read everything else piecemeal.
+        use_process_vm_readv = false;
+        continue;
+      }
+      bytes_read = 0;
+    } else {
+      bytes_read = rv;
+    }
+
+    if (recording_) {
+      size_t recorded = 0;
+      for (size_t record = index; record < batch_end && recorded < bytes_read;
+           ++record) {
+        const ReadRequest& request = requests[record];
+        const size_t record_size =
+            std::min(request.size, bytes_read - recorded);
+        recording_->AddMemory(request.address, request.buffer, record_size);
+        recorded += record_size;
+      }
+    }
+
+    if (bytes_read == batch_size) {
+      index = batch_end;
+      continue;
+    }
+
+    // The transfer stopped short. Skip past the requests that were satisfied,
+    // then read the rest of the first unsatisfied request from
+    // /proc/<pid>/mem, which can read regions that process_vm_readv() can’t,
+    // and will log an appropriate message if the region can’t be read at all.
+    while (requests[index].size <= bytes_read) {
+      bytes_read -= requests[index].size;
+      ++index;
+    }
+    const ReadRequest& request = requests[index++];
+    if (!Read(request.address + bytes_read,
+              request.size - bytes_read,
+              static_cast<char*>(request.buffer) + bytes_read)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool ProcessMemory::ReadCString(VMAddress address,
                                 std::string* string) const {
   return ReadCStringInternal(address, false, 0, string);
@@ -82,21 +234,20 @@ bool ProcessMemory::ReadCStringInternal(VMAddress address,
                                         bool has_size,
                                         size_t size,
                                         std::string* string) const {
-  DCHECK(mem_fd_.is_valid());
+  DCHECK(mem_fd_.is_valid() || replay_);
 
   string->clear();
 
+  // Reads are aligned to the buffer’s size, which divides the page size, so
+  // that no read spans a page boundary and a string that crosses into an
+  // unreadable page is only read up to that page.
   char buffer[4096];
   do {
-    size_t read_size;
+    size_t read_size = sizeof(buffer) - address % sizeof(buffer);
     if (has_size) {
-      read_size = std::min(sizeof(buffer), size);
-    } else {
-      read_size = sizeof(buffer);
+      read_size = std::min(read_size, size);
     }
-    ssize_t bytes_read;
-    bytes_read =
-        HANDLE_EINTR(pread64(mem_fd_.get(), buffer, read_size, address));
+    ssize_t bytes_read = ReadPartial(address, read_size, buffer);
     if (bytes_read < 0) {
       PLOG(ERROR) << "pread64";
       return false;
@@ -121,4 +272,194 @@ bool ProcessMemory::ReadCStringInternal(VMAddress address,
   return false;
 }
 
+bool ProcessMemory::ReadCStringBatch(
+    const std::vector<CStringRequest>& requests,
+    std::string* arena,
+    std::vector<size_t>* offsets) const {
+  DCHECK(mem_fd_.is_valid() || replay_);
+
+  arena->clear();
+  offsets->assign(requests.size(), 0);
+
+  const VMSize page_size = getpagesize();
+  const auto page_base = [page_size](VMAddress address) {
+    return address & ~(page_size - 1);
+  };
+
+  // Where each string not yet terminated continues, and what was read of it in
+  // earlier passes.
+  struct Cursor {
+    size_t index;
+    VMAddress address;
+    size_t remaining;
+    std::string prefix;
+  };
+  std::vector<Cursor> cursors;
+  cursors.reserve(requests.size());
+  for (size_t index = 0; index < requests.size(); ++index) {
+    cursors.push_back(
+        {index, requests[index].address, requests[index].size, std::string()});
+  }
+
+  std::vector<VMAddress> pages;
+  std::vector<char> buffer;
+  std::vector<ReadRequest> reads;
+  while (!cursors.empty()) {
+    // Each pass reads the page that every unterminated string continues on,
+    // once, no matter how many strings share it.
+    pages.clear();
+    for (const Cursor& cursor : cursors) {
+      if (cursor.remaining == 0) {
+        LOG(ERROR) << "unterminated string";
+        return false;
+      }
+      pages.push_back(page_base(cursor.address));
+    }
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+    buffer.resize(pages.size() * page_size);
+    reads.clear();
+    for (size_t page = 0; page < pages.size(); ++page) {
+      if (!reads.empty() &&
+          reads.back().address + reads.back().size == pages[page]) {
+        reads.back().size += page_size;
+        continue;
+      }
+      ReadRequest read;
+      read.address = pages[page];
+      read.size = page_size;
+      read.buffer = &buffer[page * page_size];
+      reads.push_back(read);
+    }
+    if (!ReadBatch(reads)) {
+      return false;
+    }
+
+    size_t unterminated = 0;
+    for (Cursor& cursor : cursors) {
+      const VMAddress page_address = page_base(cursor.address);
+      const size_t page =
+          std::lower_bound(pages.begin(), pages.end(), page_address) -
+          pages.begin();
+      const size_t page_offset = cursor.address - page_address;
+      const char* data = &buffer[page * page_size + page_offset];
+      const size_t scan_size = std::min(
+          static_cast<size_t>(page_size - page_offset), cursor.remaining);
+
+      const char* nul = static_cast<const char*>(memchr(data, '\0', scan_size));
+      if (nul) {
+        (*offsets)[cursor.index] = arena->size();
+        arena->append(cursor.prefix);
+        arena->append(data, nul - data + 1);
+        continue;
+      }
+
+      cursor.prefix.append(data, scan_size);
+      cursor.address += scan_size;
+      cursor.remaining -= scan_size;
+      if (&cursors[unterminated] != &cursor) {
+        cursors[unterminated] = std::move(cursor);
+      }
+      ++unterminated;
+    }
+    cursors.erase(cursors.begin() + unterminated, cursors.end());
+  }
+
+  return true;
+}
+
+bool ProcessMemory::ReadBatchFromFile(const std::vector<ReadRequest>& requests,
+                                      size_t index) const {
+  IOUringReader* ring = replay_ ? nullptr : Ring();
+  if (!ring) {
+    for (; index < requests.size(); ++index) {
+      const ReadRequest& request = requests[index];
+      if (!Read(request.address, request.size, request.buffer)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<IOUringReader::Request> ring_requests;
+  ring_requests.reserve(requests.size() - index);
+  size_t batch_size = 0;
+  for (size_t request = index; request < requests.size(); ++request) {
+    ring_requests.push_back({requests[request].address,
+                             requests[request].size,
+                             requests[request].buffer});
+    batch_size += requests[request].size;
+  }
+
+  std::vector<size_t> bytes_read;
+  bool ring_read;
+  {
+    ScopedMemoryRead read(batch_size);
+    ring_read = ring->ReadBatch(ring_requests, &bytes_read);
+  }
+  if (!ring_read) {
+    ring_.reset();
+    ring_unavailable_ = true;
+  }
+
+  // Whatever the ring couldn’t read is read with pread64(), which will log an
+  // appropriate message if the region can’t be read at all.
+  for (size_t request = 0; request < ring_requests.size(); ++request) {
+    const IOUringReader::Request& ring_request = ring_requests[request];
+    const size_t done = bytes_read[request];
+    if (recording_ && done > 0) {
+      recording_->AddMemory(ring_request.offset, ring_request.buffer, done);
+    }
+    if (done < ring_request.size &&
+        !Read(ring_request.offset + done,
+              ring_request.size - done,
+              static_cast<char*>(ring_request.buffer) + done)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+IOUringReader* ProcessMemory::Ring() const {
+  // The ring’s mappings would change the memory map of a process reading
+  // itself as it’s being read, so that is done one read at a time.
+  if (!ring_ && !ring_unavailable_ && pid_ == getpid()) {
+    ring_unavailable_ = true;
+  }
+  if (!ring_ && !ring_unavailable_) {
+    std::unique_ptr<IOUringReader> ring(new IOUringReader());
+    if (ring->Initialize(mem_fd_.get(), kRingDepth)) {
+      ring_ = std::move(ring);
+    } else {
+      ring_unavailable_ = true;
+    }
+  }
+  return ring_.get();
+}
+
+ssize_t ProcessMemory::ReadPartial(VMAddress address,
+                                   size_t size,
+                                   void* buffer) const {
+  if (replay_) {
+    const size_t bytes_read = replay_->ReadMemory(address, size, buffer);
+    if (bytes_read == 0) {
+      // This is what /proc/<pid>/mem reports for unreadable memory.
+      errno = EIO;
+      return -1;
+    }
+    return bytes_read;
+  }
+
+  ssize_t bytes_read;
+  {
+    ScopedMemoryRead read(size);
+    bytes_read = HANDLE_EINTR(pread64(mem_fd_.get(), buffer, size, address));
+  }
+  if (recording_ && bytes_read > 0) {
+    recording_->AddMemory(address, buffer, bytes_read);
+  }
+  return bytes_read;
+}
+
 }  // namespace crashpad
@@ -17,17 +17,48 @@
 
 #include <sys/types.h>
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/files/scoped_file.h"
 #include "base/macros.h"
+#include "util/linux/io_uring_reader.h"
 #include "util/misc/address_types.h"
 
 namespace crashpad {
 
+class ProcessRecording;
+
 //! \brief Accesses the memory of another process.
 class ProcessMemory {
  public:
+  //! \brief A request to copy a region of memory, used by ReadBatch().
+  struct ReadRequest {
+    //! \brief The address, in the target process’ address space, of the memory
+    //!     region to copy.
+    VMAddress address;
+
+    //! \brief The size, in bytes, of the memory region to copy.
+    size_t size;
+
+    //! \brief The buffer, at least #size bytes long, into which the contents of
+    //!     the other process’ memory will be copied.
+    void* buffer;
+  };
+
+  //! \brief A request to read a `NUL`-terminated C string, used by
+  //!     ReadCStringBatch().
+  struct CStringRequest {
+    //! \brief The address, in the target process’ address space, of the
+    //!     string.
+    VMAddress address;
+
+    //! \brief The maximum number of bytes to read. The string is required to
+    //!     be `NUL`-terminated within this many bytes.
+    size_t size;
+  };
+
   ProcessMemory();
   ~ProcessMemory();
 
@@ -42,6 +73,24 @@ class ProcessMemory {
   //! \return `true` on success, `false` on failure with a message logged.
   bool Initialize(pid_t pid);
 
+  //! \brief Initializes this object to read memory from a recording made by
+  //!     another ProcessMemory given the recording with SetRecording().
+  //!
+  //! Reads of memory absent from the recording fail as reads of unreadable
+  //! memory would.
+  //!
+  //! \param[in] recording The recording to read memory from. It must outlive
+  //!     this object.
+  void InitializeFromRecording(const ProcessRecording* recording);
+
+  //! \brief Records every byte subsequently read from the target process in
+  //!     \a recording, so that the reads may be replayed by a ProcessMemory
+  //!     initialized with InitializeFromRecording().
+  //!
+  //! \param[in] recording The recording to add memory to, which must outlive
+  //!     this object, or `nullptr` to stop recording.
+  void SetRecording(ProcessRecording* recording);
+
   //! \brief Copies memory from the target process into a caller-provided buffer
   //!     in the current process.
   //!
@@ -56,6 +105,25 @@ class ProcessMemory {
   //!     failure, with a message logged.
   bool Read(VMAddress address, size_t size, void* buffer) const;
 
+  //! \brief Copies several memory regions from the target process into
+  //!     caller-provided buffers in the current process.
+  //!
+  //! This is equivalent to calling Read() for each of \a requests in turn, but
+  //! where possible, many regions are copied with a single
+  //! `process_vm_readv()` system call. Regions that `process_vm_readv()` is
+  //! unable to copy, such as those without read permission in the target
+  //! process, are read from `/proc/<pid>/mem` as by Read(). If
+  //! `process_vm_readv()` is unavailable altogether, the regions are read from
+  //! `/proc/<pid>/mem` with many reads outstanding at once through `io_uring`
+  //! where possible, and one at a time otherwise.
+  //!
+  //! \param[in] requests The regions to copy.
+  //!
+  //! \return `true` on success, with every request’s buffer filled
+  //!     appropriately. `false` on failure, with a message logged. On failure,
+  //!     the contents of the buffers are unspecified.
+  bool ReadBatch(const std::vector<ReadRequest>& requests) const;
+
   //! \brief Reads a `NUL`-terminated C string from the target process into a
   //!     string in the current process.
   //!
@@ -88,13 +156,52 @@ class ProcessMemory {
                               size_t size,
                               std::string* string) const;
 
+  //! \brief Reads several `NUL`-terminated C strings from the target process
+  //!     into a single buffer in the current process.
+  //!
+  //! This is equivalent to calling ReadCStringSizeLimited() for each of \a
+  //! requests in turn, but reads whole pages, each page at most once, with as
+  //! few ReadBatch() calls as the longest string requires. Strings that share
+  //! pages, such as those allocated together on the target’s heap, are
+  //! resolved with the same read.
+  //!
+  //! \param[in] requests The strings to read.
+  //! \param[out] arena The strings read, each followed by a `NUL` terminator.
+  //! \param[out] offsets The offset into \a arena of the string read for each
+  //!     of \a requests, in the same order.
+  //!
+  //! \return `true` on success, with \a arena and \a offsets set
+  //!     appropriately. `false` on failure, with a message logged. Failures
+  //!     occur as they would for ReadCStringSizeLimited(), for any of the
+  //!     strings.
+  bool ReadCStringBatch(const std::vector<CStringRequest>& requests,
+                        std::string* arena,
+                        std::vector<size_t>* offsets) const;
+
  private:
   bool ReadCStringInternal(VMAddress address,
                            bool has_size,
                            size_t size,
                            std::string* string) const;
 
+  // Reads up to size bytes from the target process or from replay_, returning
+  // the number read as pread64() does, and recording them in recording_.
+  ssize_t ReadPartial(VMAddress address, size_t size, void* buffer) const;
+
+  // Reads requests from index on from /proc/<pid>/mem or from replay_, on
+  // behalf of ReadBatch().
+  bool ReadBatchFromFile(const std::vector<ReadRequest>& requests,
+                         size_t index) const;
+
+  // Returns the ring that reads /proc/<pid>/mem, setting it up on first use,
+  // or nullptr if io_uring is unavailable.
+  IOUringReader* Ring() const;
+
   base::ScopedFD mem_fd_;
+  mutable std::unique_ptr<IOUringReader> ring_;
+  mutable bool ring_unavailable_;
+  ProcessRecording* recording_;  // weak
+  const ProcessRecording* replay_;  // weak
   pid_t pid_;
 
   DISALLOW_COPY_AND_ASSIGN(ProcessMemory);
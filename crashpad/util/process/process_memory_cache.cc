@@ -0,0 +1,173 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/process/process_memory_cache.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+constexpr size_t ProcessMemoryCache::kDefaultPageSize;
+
+ProcessMemoryCache::ProcessMemoryCache()
+    : pages_(),
+      page_index_(),
+      unreadable_pages_(),
+      memory_(nullptr),
+      page_size_(0),
+      page_count_(0),
+      initialized_() {}
+
+ProcessMemoryCache::~ProcessMemoryCache() {}
+
+bool ProcessMemoryCache::Initialize(const ProcessMemory* memory,
+                                    size_t page_size,
+                                    size_t page_count) {
+  INITIALIZATION_STATE_SET_INITIALIZING(initialized_);
+
+  const size_t system_page_size = getpagesize();
+  if (page_size == 0 || (page_size & (page_size - 1)) != 0 ||
+      page_size % system_page_size != 0) {
+    LOG(ERROR) << "invalid page size " << page_size;
+    return false;
+  }
+  if (page_count == 0) {
+    LOG(ERROR) << "invalid page count";
+    return false;
+  }
+
+  memory_ = memory;
+  page_size_ = page_size;
+  page_count_ = page_count;
+
+  INITIALIZATION_STATE_SET_VALID(initialized_);
+  return true;
+}
+
+bool ProcessMemoryCache::Read(VMAddress address, size_t size, void* buffer) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  if (size > page_size_) {
+    return memory_->Read(address, size, buffer);
+  }
+
+  // A read no larger than a page spans at most two pages. Only satisfy it
+  // from the cache if every page it touches can be cached, so that failures
+  // are reported by ProcessMemory.
+  const VMAddress first_page = PageBase(address);
+  const VMAddress last_page = size ? PageBase(address + size - 1) : first_page;
+  if (last_page != first_page && page_count_ < 2) {
+    // Both pages can’t be held at once.
+    return memory_->Read(address, size, buffer);
+  }
+  const uint8_t* first_data = GetPage(first_page);
+  const uint8_t* last_data =
+      last_page == first_page ? first_data : GetPage(last_page);
+  if (!first_data || !last_data) {
+    return memory_->Read(address, size, buffer);
+  }
+
+  uint8_t* buffer_bytes = static_cast<uint8_t*>(buffer);
+  const size_t first_offset = address - first_page;
+  const size_t first_size = std::min(size, page_size_ - first_offset);
+  memcpy(buffer_bytes, first_data + first_offset, first_size);
+  if (first_size < size) {
+    memcpy(buffer_bytes + first_size, last_data, size - first_size);
+  }
+  return true;
+}
+
+bool ProcessMemoryCache::ReadCStringSizeLimited(VMAddress address,
+                                                size_t size,
+                                                std::string* string) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+
+  string->clear();
+
+  VMAddress cursor = address;
+  size_t remaining = size;
+  while (remaining > 0) {
+    const VMAddress page = PageBase(cursor);
+    const uint8_t* data = GetPage(page);
+    if (!data) {
+      // Let ProcessMemory read the string directly, which will read as much
+      // of it as is readable and log an appropriate message on failure.
+      return memory_->ReadCStringSizeLimited(address, size, string);
+    }
+
+    const size_t offset = cursor - page;
+    const size_t chunk_size = std::min(remaining, page_size_ - offset);
+    const char* chunk = reinterpret_cast<const char*>(data + offset);
+    const char* nul = static_cast<const char*>(memchr(chunk, '\0', chunk_size));
+    if (nul) {
+      string->append(chunk, nul - chunk);
+      return true;
+    }
+    string->append(chunk, chunk_size);
+
+    cursor += chunk_size;
+    remaining -= chunk_size;
+  }
+
+  LOG(ERROR) << "unterminated string";
+  return false;
+}
+
+VMAddress ProcessMemoryCache::PageBase(VMAddress address) const {
+  return address & ~static_cast<VMAddress>(page_size_ - 1);
+}
+
+const uint8_t* ProcessMemoryCache::GetPage(VMAddress page_address) {
+  auto index_it = page_index_.find(page_address);
+  if (index_it != page_index_.end()) {
+    pages_.splice(pages_.begin(), pages_, index_it->second);
+    return pages_.front().data.get();
+  }
+
+  if (unreadable_pages_.find(page_address) != unreadable_pages_.end()) {
+    return nullptr;
+  }
+
+  std::unique_ptr<uint8_t[]> data;
+  if (pages_.size() < page_count_) {
+    data.reset(new uint8_t[page_size_]);
+  } else {
+    // Reuse the least recently used page’s storage.
+    data = std::move(pages_.back().data);
+    page_index_.erase(pages_.back().address);
+    pages_.pop_back();
+  }
+
+  // A page that can’t be read in its entirety, perhaps because it lies at the
+  // edge of a mapping, isn’t cached. Remember it so that it’s only attempted
+  // once.
+  if (!memory_->Read(page_address, page_size_, data.get())) {
+    unreadable_pages_.insert(page_address);
+    return nullptr;
+  }
+
+  pages_.push_front(Page());
+  pages_.front().address = page_address;
+  pages_.front().data = std::move(data);
+  page_index_[page_address] = pages_.begin();
+  return pages_.front().data.get();
+}
+
+}  // namespace crashpad
@@ -0,0 +1,117 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_PROCESS_PROCESS_MEMORY_CACHE_H_
+#define CRASHPAD_UTIL_PROCESS_PROCESS_MEMORY_CACHE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "base/macros.h"
+#include "util/misc/address_types.h"
+#include "util/misc/initialization_state_dcheck.h"
+#include "util/process/process_memory.h"
+
+namespace crashpad {
+
+//! \brief A least-recently-used cache of pages read from another process,
+//!     layered over a ProcessMemory.
+//!
+//! Parsing module headers, dynamic arrays, and the dynamic linker’s
+//! `link_map` list makes many small reads, often from the same few pages.
+//! Serving these from a cache avoids a system call for each of them.
+//!
+//! The cache assumes that the target process’ memory does not change while
+//! the cache is in use, which is true while the process is suspended to take a
+//! snapshot. Reads larger than a single cache page, and reads from pages that
+//! cannot be read in their entirety, bypass the cache.
+//!
+//! A ProcessMemoryRange can read through a cache after a call to
+//! ProcessMemoryRange::SetCache().
+class ProcessMemoryCache {
+ public:
+  //! \brief The default size of each cached page, in bytes.
+  static constexpr size_t kDefaultPageSize = 4096;
+
+  ProcessMemoryCache();
+  ~ProcessMemoryCache();
+
+  //! \brief Initializes this object.
+  //!
+  //! \param[in] memory The memory reader to read pages from.
+  //! \param[in] page_size The size of each cached page, in bytes. This must be
+  //!     a power of 2 and a multiple of the system page size, such as
+  //!     #kDefaultPageSize or the size of a huge page.
+  //! \param[in] page_count The maximum number of pages to hold at once. Once
+  //!     this many pages are held, the least recently used is discarded to
+  //!     make room for another.
+  //!
+  //! \return `true` on success, `false` on failure with a message logged.
+  bool Initialize(const ProcessMemory* memory,
+                  size_t page_size,
+                  size_t page_count);
+
+  //! \brief Returns the memory reader that pages are read from.
+  const ProcessMemory* Memory() const { return memory_; }
+
+  //! \brief Copies memory from the target process into a caller-provided
+  //!     buffer, as ProcessMemory::Read() does.
+  bool Read(VMAddress address, size_t size, void* buffer);
+
+  //! \brief Reads a `NUL`-terminated C string from the target process, as
+  //!     ProcessMemory::ReadCStringSizeLimited() does.
+  bool ReadCStringSizeLimited(VMAddress address,
+                              size_t size,
+                              std::string* string);
+
+ private:
+  struct Page {
+    VMAddress address;
+    std::unique_ptr<uint8_t[]> data;
+  };
+
+  // Returns the address of the cache page containing |address|.
+  VMAddress PageBase(VMAddress address) const;
+
+  // Returns the contents of the page starting at |page_address|, reading it
+  // into the cache if necessary, or nullptr if the page can’t be read in its
+  // entirety.
+  const uint8_t* GetPage(VMAddress page_address);
+
+  // Pages ordered from most to least recently used.
+  std::list<Page> pages_;
+
+  // Maps each page’s address to its position in pages_.
+  std::map<VMAddress, std::list<Page>::iterator> page_index_;
+
+  // Pages that could not be read in their entirety.
+  std::set<VMAddress> unreadable_pages_;
+
+  const ProcessMemory* memory_;  // weak
+  size_t page_size_;
+  size_t page_count_;
+  InitializationStateDcheck initialized_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProcessMemoryCache);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_PROCESS_PROCESS_MEMORY_CACHE_H_
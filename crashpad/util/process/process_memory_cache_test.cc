@@ -0,0 +1,188 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/process/process_memory_cache.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include "build/build_config.h"
+#include "gtest/gtest.h"
+#include "util/posix/scoped_mmap.h"
+#include "util/process/process_memory_range.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+class ProcessMemoryCacheTest : public testing::Test {
+ protected:
+  ProcessMemoryCacheTest()
+      : testing::Test(), page_size_(getpagesize()), memory_(), pages_() {}
+
+  void SetUp() override {
+    ASSERT_TRUE(memory_.Initialize(getpid()));
+
+    // Map four pages and unmap the last, so that reads that reach it fail.
+    ASSERT_TRUE(pages_.ResetMmap(nullptr,
+                                 4 * page_size_,
+                                 PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS,
+                                 -1,
+                                 0));
+    char* region = pages_.addr_as<char*>();
+    for (size_t index = 0; index < 4 * page_size_; ++index) {
+      region[index] = 'a' + index % 26;
+    }
+    ASSERT_TRUE(pages_.ResetAddrLen(region, 3 * page_size_));
+  }
+
+  char* Region() const { return pages_.addr_as<char*>(); }
+  VMAddress RegionAddress() const { return pages_.addr_as<VMAddress>(); }
+
+  const size_t page_size_;
+  ProcessMemory memory_;
+  ScopedMmap pages_;
+};
+
+TEST_F(ProcessMemoryCacheTest, Initialize) {
+  {
+    ProcessMemoryCache cache;
+    EXPECT_FALSE(cache.Initialize(&memory_, 0, 1));
+  }
+  {
+    ProcessMemoryCache cache;
+    EXPECT_FALSE(cache.Initialize(&memory_, 3 * page_size_, 1));
+  }
+  {
+    ProcessMemoryCache cache;
+    EXPECT_FALSE(cache.Initialize(&memory_, page_size_, 0));
+  }
+  {
+    ProcessMemoryCache cache;
+    EXPECT_TRUE(cache.Initialize(&memory_, 2 * page_size_, 1));
+    EXPECT_EQ(cache.Memory(), &memory_);
+  }
+}
+
+TEST_F(ProcessMemoryCacheTest, Read) {
+  ProcessMemoryCache cache;
+  ASSERT_TRUE(cache.Initialize(&memory_, page_size_, 2));
+
+  std::unique_ptr<char[]> result(new char[3 * page_size_]);
+
+  // Reads within a page, across a page boundary, and larger than a page.
+  ASSERT_TRUE(cache.Read(RegionAddress() + 1, 10, result.get()));
+  EXPECT_EQ(memcmp(result.get(), Region() + 1, 10), 0);
+  ASSERT_TRUE(cache.Read(RegionAddress() + page_size_ - 5, 10, result.get()));
+  EXPECT_EQ(memcmp(result.get(), Region() + page_size_ - 5, 10), 0);
+  ASSERT_TRUE(cache.Read(RegionAddress(), 3 * page_size_, result.get()));
+  EXPECT_EQ(memcmp(result.get(), Region(), 3 * page_size_), 0);
+  ASSERT_TRUE(cache.Read(RegionAddress(), 0, result.get()));
+
+  // The first two pages are now cached, so a change to the first isn’t
+  // observed.
+  const char original = Region()[0];
+  Region()[0] = '!';
+  ASSERT_TRUE(cache.Read(RegionAddress(), 1, result.get()));
+  EXPECT_EQ(result[0], original);
+
+  // Reading the third page evicts the least recently used page, the second.
+  // The first remains cached.
+  ASSERT_TRUE(cache.Read(RegionAddress() + 2 * page_size_, 1, result.get()));
+  EXPECT_EQ(result[0], Region()[2 * page_size_]);
+  Region()[page_size_] = '!';
+  ASSERT_TRUE(cache.Read(RegionAddress() + page_size_, 1, result.get()));
+  EXPECT_EQ(result[0], '!');
+  ASSERT_TRUE(cache.Read(RegionAddress(), 1, result.get()));
+  EXPECT_EQ(result[0], '!');
+}
+
+TEST_F(ProcessMemoryCacheTest, ReadUnmapped) {
+  ProcessMemoryCache cache;
+  ASSERT_TRUE(cache.Initialize(&memory_, page_size_, 4));
+
+  const VMAddress unmapped_address = RegionAddress() + 3 * page_size_;
+  char result[16];
+
+  ASSERT_TRUE(cache.Read(unmapped_address - 4, 4, result));
+  EXPECT_EQ(memcmp(result, Region() + 3 * page_size_ - 4, 4), 0);
+  EXPECT_FALSE(cache.Read(unmapped_address - 4, 8, result));
+  EXPECT_FALSE(cache.Read(unmapped_address, 4, result));
+
+  // A second attempt at the unreadable page still fails.
+  EXPECT_FALSE(cache.Read(unmapped_address, 4, result));
+}
+
+TEST_F(ProcessMemoryCacheTest, ReadCStringSizeLimited) {
+  ProcessMemoryCache cache;
+  ASSERT_TRUE(cache.Initialize(&memory_, page_size_, 4));
+
+  // A string that spans a page boundary.
+  const size_t nul_offset = page_size_ + 10;
+  Region()[nul_offset] = '\0';
+  const VMAddress string_address = RegionAddress() + page_size_ - 10;
+
+  std::string string;
+  ASSERT_TRUE(cache.ReadCStringSizeLimited(string_address, 100, &string));
+  EXPECT_EQ(string, std::string(Region() + page_size_ - 10, 20));
+
+  // The NUL terminator must fall within the limit.
+  EXPECT_FALSE(cache.ReadCStringSizeLimited(string_address, 20, &string));
+  ASSERT_TRUE(cache.ReadCStringSizeLimited(string_address, 21, &string));
+  EXPECT_EQ(string.size(), 20u);
+
+  // A string that runs into unmapped memory.
+  const VMAddress unmapped_address = RegionAddress() + 3 * page_size_;
+  EXPECT_FALSE(
+      cache.ReadCStringSizeLimited(unmapped_address - 4, 100, &string));
+}
+
+TEST_F(ProcessMemoryCacheTest, ProcessMemoryRange) {
+  ProcessMemoryCache cache;
+  ASSERT_TRUE(cache.Initialize(&memory_, page_size_, 4));
+
+#if defined(ARCH_CPU_64_BITS)
+  constexpr bool is_64_bit = true;
+#else
+  constexpr bool is_64_bit = false;
+#endif  // ARCH_CPU_64_BITS
+
+  ProcessMemoryRange range;
+  ASSERT_TRUE(range.Initialize(&memory_, is_64_bit));
+  range.SetCache(&cache);
+
+  ProcessMemoryRange restricted_range;
+  ASSERT_TRUE(restricted_range.Initialize(range));
+  ASSERT_TRUE(restricted_range.RestrictRange(RegionAddress(), page_size_));
+
+  char result;
+  ASSERT_TRUE(restricted_range.Read(RegionAddress(), 1, &result));
+  EXPECT_EQ(result, Region()[0]);
+  EXPECT_FALSE(restricted_range.Read(RegionAddress() + page_size_, 1, &result));
+
+  // The restricted range shares the cache, so the first page is now cached.
+  const char original = Region()[0];
+  Region()[0] = '!';
+  ASSERT_TRUE(range.Read(RegionAddress(), 1, &result));
+  EXPECT_EQ(result, original);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
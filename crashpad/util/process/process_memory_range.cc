@@ -22,7 +22,12 @@
 namespace crashpad {
 
 ProcessMemoryRange::ProcessMemoryRange()
-    : memory_(nullptr), range_(), initialized_() {}
+    : memory_(nullptr),
+      cache_(nullptr),
+      file_(nullptr),
+      file_range_(),
+      range_(),
+      initialized_() {}
 
 ProcessMemoryRange::~ProcessMemoryRange() {}
 
@@ -49,10 +54,31 @@ bool ProcessMemoryRange::Initialize(const ProcessMemory* memory,
 }
 
 bool ProcessMemoryRange::Initialize(const ProcessMemoryRange& other) {
-  return Initialize(other.memory_,
-                    other.range_.Is64Bit(),
-                    other.range_.Base(),
-                    other.range_.Size());
+  if (!Initialize(other.memory_,
+                  other.range_.Is64Bit(),
+                  other.range_.Base(),
+                  other.range_.Size())) {
+    return false;
+  }
+  cache_ = other.cache_;
+  file_ = other.file_;
+  file_range_ = other.file_range_;
+  return true;
+}
+
+void ProcessMemoryRange::SetCache(ProcessMemoryCache* cache) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  DCHECK(!cache || cache->Memory() == memory_);
+  cache_ = cache;
+}
+
+void ProcessMemoryRange::SetFileBacking(const ModuleFileMemory* file,
+                                        VMAddress base,
+                                        VMSize size) {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  file_ = file;
+  file_range_.SetRange(range_.Is64Bit(), base, size);
+  DCHECK(!file_ || file_range_.IsValid());
 }
 
 bool ProcessMemoryRange::RestrictRange(VMAddress base, VMSize size) {
@@ -75,7 +101,12 @@ bool ProcessMemoryRange::Read(VMAddress address,
     LOG(ERROR) << "read out of range";
     return false;
   }
-  return memory_->Read(address, size, buffer);
+  if (file_ && file_range_.ContainsRange(read_range) &&
+      file_->Read(address, size, buffer)) {
+    return true;
+  }
+  return cache_ ? cache_->Read(address, size, buffer)
+                : memory_->Read(address, size, buffer);
 }
 
 bool ProcessMemoryRange::ReadCStringSizeLimited(VMAddress address,
@@ -87,7 +118,32 @@ bool ProcessMemoryRange::ReadCStringSizeLimited(VMAddress address,
     return false;
   }
   size = std::min(static_cast<VMSize>(size), range_.End() - address);
-  return memory_->ReadCStringSizeLimited(address, size, string);
+  if (file_ && file_range_.ContainsValue(address) &&
+      file_->ReadCStringSizeLimited(
+          address,
+          std::min(static_cast<VMSize>(size), file_range_.End() - address),
+          string)) {
+    return true;
+  }
+  return cache_ ? cache_->ReadCStringSizeLimited(address, size, string)
+                : memory_->ReadCStringSizeLimited(address, size, string);
+}
+
+bool ProcessMemoryRange::ReadCStringBatch(
+    const std::vector<ProcessMemory::CStringRequest>& requests,
+    std::string* arena,
+    std::vector<size_t>* offsets) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  std::vector<ProcessMemory::CStringRequest> limited_requests(requests);
+  for (ProcessMemory::CStringRequest& request : limited_requests) {
+    if (!range_.ContainsValue(request.address)) {
+      LOG(ERROR) << "read out of range";
+      return false;
+    }
+    request.size = std::min(static_cast<VMSize>(request.size),
+                            range_.End() - request.address);
+  }
+  return memory_->ReadCStringBatch(limited_requests, arena, offsets);
 }
 
 }  // namespace crashpad
@@ -18,12 +18,15 @@
 #include <sys/types.h>
 
 #include <string>
+#include <vector>
 
 #include "base/macros.h"
+#include "util/linux/module_file_memory.h"
 #include "util/misc/address_types.h"
 #include "util/misc/initialization_state_dcheck.h"
 #include "util/numeric/checked_vm_address_range.h"
 #include "util/process/process_memory.h"
+#include "util/process/process_memory_cache.h"
 
 namespace crashpad {
 
@@ -67,6 +70,39 @@ class ProcessMemoryRange {
   //! \return `true` on success. `false` on failure with a message logged.
   bool Initialize(const ProcessMemoryRange& other);
 
+  //! \brief Arranges for reads to be served through \a cache.
+  //!
+  //! Ranges initialized from this object by Initialize(const
+  //! ProcessMemoryRange&) share the cache.
+  //!
+  //! \param[in] cache A cache layered over the same ProcessMemory that this
+  //!     object was initialized with, or `nullptr` to read without a cache.
+  //!     The cache must outlive this object and any ranges that share it.
+  void SetCache(ProcessMemoryCache* cache);
+
+  //! \brief Arranges for reads within part of the range to be served from the
+  //!     file of the module mapped there.
+  //!
+  //! Reads lying entirely within the window are first attempted from \a file,
+  //! and are read from the target only if \a file can’t satisfy them. Reads
+  //! outside of the window always come from the target. Ranges initialized
+  //! from this object by Initialize(const ProcessMemoryRange&) share the file
+  //! and the window.
+  //!
+  //! \param[in] file The module’s file, or `nullptr` to read only from the
+  //!     target. The file must outlive this object and any ranges that share
+  //!     it.
+  //! \param[in] base The base address of the window.
+  //! \param[in] size The size of the window, which should cover only memory
+  //!     that is not modified after the module is loaded.
+  void SetFileBacking(const ModuleFileMemory* file,
+                      VMAddress base,
+                      VMSize size);
+
+  //! \brief Returns the file passed to SetFileBacking(), or `nullptr` if there
+  //!     is none.
+  const ModuleFileMemory* FileBacking() const { return file_; }
+
   //! \brief Returns whether the range is part of a 64-bit address space.
   bool Is64Bit() const { return range_.Is64Bit(); }
 
@@ -116,8 +152,30 @@ class ProcessMemoryRange {
                               size_t size,
                               std::string* string) const;
 
+  //! \brief Reads several `NUL`-terminated C strings from the target process
+  //!     into a single buffer in the current process.
+  //!
+  //! Each string must begin within this range and is read no further than its
+  //! end. The strings are read by ProcessMemory::ReadCStringBatch(), without
+  //! going through the cache or the file backing.
+  //!
+  //! \param[in] requests The strings to read.
+  //! \param[out] arena The strings read, each followed by a `NUL` terminator.
+  //! \param[out] offsets The offset into \a arena of the string read for each
+  //!     of \a requests, in the same order.
+  //!
+  //! \return `true` on success, with \a arena and \a offsets set
+  //!     appropriately. `false` on failure, with a message logged.
+  bool ReadCStringBatch(
+      const std::vector<ProcessMemory::CStringRequest>& requests,
+      std::string* arena,
+      std::vector<size_t>* offsets) const;
+
  private:
   const ProcessMemory* memory_;  // weak
+  ProcessMemoryCache* cache_;  // weak
+  const ModuleFileMemory* file_;  // weak
+  CheckedVMAddressRange file_range_;
   CheckedVMAddressRange range_;
   InitializationStateDcheck initialized_;
 
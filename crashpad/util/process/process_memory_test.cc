@@ -18,7 +18,9 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "test/errors.h"
@@ -121,6 +123,71 @@ TEST(ProcessMemory, ReadForked) {
   test.RunAgainstForked();
 }
 
+class ReadBatchTest : public TargetProcessTest {
+ public:
+  ReadBatchTest()
+      : TargetProcessTest(),
+        region_size_(4 * getpagesize()),
+        region_(new char[region_size_]) {
+    for (size_t index = 0; index < region_size_; ++index) {
+      region_[index] = index % 251;
+    }
+  }
+
+ private:
+  void DoTest(pid_t pid) override {
+    ProcessMemory memory;
+    ASSERT_TRUE(memory.Initialize(pid));
+
+    VMAddress address = FromPointerCast<VMAddress>(region_.get());
+    std::unique_ptr<char[]> result(new char[region_size_]);
+
+    // Ensure that an empty batch succeeds.
+    EXPECT_TRUE(memory.ReadBatch(std::vector<ProcessMemory::ReadRequest>()));
+
+    // Read the region back in small, unevenly-sized pieces, out of order, with
+    // some empty requests interspersed. There are more requests than can be
+    // issued in a single system call.
+    std::vector<ProcessMemory::ReadRequest> requests;
+    size_t offset = 0;
+    for (size_t piece_size = 1; offset < region_size_;
+         piece_size = piece_size % 7 + 1) {
+      ProcessMemory::ReadRequest request;
+      request.size = std::min(piece_size, region_size_ - offset);
+      request.address = address + offset;
+      request.buffer = result.get() + offset;
+      requests.push_back(request);
+      offset += request.size;
+
+      if (piece_size == 3) {
+        request.size = 0;
+        requests.push_back(request);
+      }
+    }
+    ASSERT_GT(requests.size(), 1024u);
+    std::reverse(requests.begin(), requests.end());
+
+    memset(result.get(), '\0', region_size_);
+    ASSERT_TRUE(memory.ReadBatch(requests));
+    EXPECT_EQ(memcmp(region_.get(), result.get(), region_size_), 0);
+  }
+
+  const size_t region_size_;
+  std::unique_ptr<char[]> region_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadBatchTest);
+};
+
+TEST(ProcessMemory, ReadBatchSelf) {
+  ReadBatchTest test;
+  test.RunAgainstSelf();
+}
+
+TEST(ProcessMemory, ReadBatchForked) {
+  ReadBatchTest test;
+  test.RunAgainstForked();
+}
+
 bool ReadCString(const ProcessMemory& memory,
                  const char* pointer,
                  std::string* result) {
@@ -231,6 +298,75 @@ TEST(ProcessMemory, ReadCStringSizeLimitedForked) {
   test.RunAgainstForked();
 }
 
+class ReadCStringBatchTest : public TargetProcessTest {
+ public:
+  ReadCStringBatchTest()
+      : TargetProcessTest(), member_char_short_("A short member char[]") {
+    const size_t kStringLongSize = 4 * getpagesize();
+    for (size_t index = 0; index < kStringLongSize; ++index) {
+      string_long_.push_back((index % 255) + 1);
+    }
+  }
+
+ private:
+  static ProcessMemory::CStringRequest Request(const char* pointer,
+                                               size_t size) {
+    ProcessMemory::CStringRequest request;
+    request.address = FromPointerCast<VMAddress>(pointer);
+    request.size = size;
+    return request;
+  }
+
+  void DoTest(pid_t pid) override {
+    ProcessMemory memory;
+    ASSERT_TRUE(memory.Initialize(pid));
+
+    std::string arena;
+    std::vector<size_t> offsets;
+    ASSERT_TRUE(memory.ReadCStringBatch(
+        std::vector<ProcessMemory::CStringRequest>(), &arena, &offsets));
+    EXPECT_TRUE(arena.empty());
+    EXPECT_TRUE(offsets.empty());
+
+    // Strings sharing pages, a string spanning several pages, and the same
+    // string twice.
+    std::vector<ProcessMemory::CStringRequest> requests;
+    requests.push_back(Request(kConstCharEmpty, arraysize(kConstCharEmpty)));
+    requests.push_back(Request(kConstCharShort, arraysize(kConstCharShort)));
+    requests.push_back(
+        Request(string_long_.c_str(), string_long_.size() + 1));
+    requests.push_back(
+        Request(member_char_short_, strlen(member_char_short_) + 1));
+    requests.push_back(Request(kConstCharShort, arraysize(kConstCharShort)));
+    ASSERT_TRUE(memory.ReadCStringBatch(requests, &arena, &offsets));
+    ASSERT_EQ(offsets.size(), requests.size());
+    EXPECT_STREQ(arena.c_str() + offsets[0], kConstCharEmpty);
+    EXPECT_STREQ(arena.c_str() + offsets[1], kConstCharShort);
+    EXPECT_EQ(std::string(arena.c_str() + offsets[2]), string_long_);
+    EXPECT_STREQ(arena.c_str() + offsets[3], member_char_short_);
+    EXPECT_STREQ(arena.c_str() + offsets[4], kConstCharShort);
+
+    // Every string must be terminated within its size.
+    requests.push_back(Request(string_long_.c_str(), string_long_.size()));
+    EXPECT_FALSE(memory.ReadCStringBatch(requests, &arena, &offsets));
+  }
+
+  std::string string_long_;
+  const char* member_char_short_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadCStringBatchTest);
+};
+
+TEST(ProcessMemory, ReadCStringBatchSelf) {
+  ReadCStringBatchTest test;
+  test.RunAgainstSelf();
+}
+
+TEST(ProcessMemory, ReadCStringBatchForked) {
+  ReadCStringBatchTest test;
+  test.RunAgainstForked();
+}
+
 class ReadUnmappedTest : public TargetProcessTest {
  public:
   ReadUnmappedTest()
@@ -270,6 +406,22 @@ class ReadUnmappedTest : public TargetProcessTest {
     EXPECT_FALSE(memory.Read(page_addr1, region_size_, result_.get()));
     EXPECT_FALSE(memory.Read(page_addr2, page_size_, result_.get()));
     EXPECT_FALSE(memory.Read(page_addr2 - 1, 2, result_.get()));
+
+    std::vector<ProcessMemory::ReadRequest> requests(2);
+    requests[0].address = page_addr1;
+    requests[0].size = 1;
+    requests[0].buffer = result_.get();
+    requests[1].address = page_addr2 - 1;
+    requests[1].size = 1;
+    requests[1].buffer = result_.get() + 1;
+    EXPECT_TRUE(memory.ReadBatch(requests));
+
+    requests[1].size = 2;
+    EXPECT_FALSE(memory.ReadBatch(requests));
+
+    requests[1].address = page_addr2;
+    requests[1].size = 1;
+    EXPECT_FALSE(memory.ReadBatch(requests));
   }
 
   ScopedMmap pages_;
@@ -351,6 +503,22 @@ class ReadCStringUnmappedTest : public TargetProcessTest {
           memory, string3_, expected_length_ + 1, &result_));
       EXPECT_FALSE(ReadCStringSizeLimited(
           memory, string4_, expected_length_ + 1, &result_));
+
+      // A batch fails if any of its strings can’t be read.
+      std::vector<ProcessMemory::CStringRequest> requests(2);
+      requests[0].address = FromPointerCast<VMAddress>(string1_);
+      requests[0].size = expected_length_ + 1;
+      requests[1].address = FromPointerCast<VMAddress>(string2_);
+      requests[1].size = expected_length_ + 1;
+      std::string arena;
+      std::vector<size_t> offsets;
+      ASSERT_TRUE(memory.ReadCStringBatch(requests, &arena, &offsets));
+      EXPECT_STREQ(arena.c_str() + offsets[0], string1_);
+      EXPECT_STREQ(arena.c_str() + offsets[1], string2_);
+
+      requests.push_back(requests[0]);
+      requests.back().address = FromPointerCast<VMAddress>(string3_);
+      EXPECT_FALSE(memory.ReadCStringBatch(requests, &arena, &offsets));
     } else {
       ASSERT_TRUE(ReadCString(memory, string1_, &result_));
       EXPECT_EQ(result_, string1_);
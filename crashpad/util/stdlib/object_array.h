@@ -0,0 +1,93 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_STDLIB_OBJECT_ARRAY_H_
+#define CRASHPAD_UTIL_STDLIB_OBJECT_ARRAY_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace crashpad {
+
+//! \brief A number of objects constructed together in a single allocation, of
+//!     which some are kept.
+//!
+//! This holds many objects of the same type, such as the snapshots of the
+//! threads of a process with thousands of them, without allocating each of them
+//! separately, and keeps them next to each other in memory to be visited in
+//! order. Each object is initialized in place, and kept with Keep() if it was
+//! initialized successfully. Objects that aren’t kept remain allocated, but
+//! Kept() doesn’t return them.
+//!
+//! Objects aren’t moved once they’ve been constructed, so pointers to them
+//! remain valid until Reset() is called again or the ObjectArray is destroyed.
+template <typename T>
+class ObjectArray {
+ public:
+  ObjectArray() : objects_(), kept_(), size_(0) {}
+  ~ObjectArray() {}
+
+  //! \brief Destroys any objects present, and default-constructs \a size new
+  //!     ones, none of which are kept.
+  void Reset(size_t size) {
+    objects_.reset(size ? new T[size] : nullptr);
+    kept_.assign(size, false);
+    size_ = size;
+  }
+
+  //! \brief The number of objects, whether kept or not.
+  size_t size() const { return size_; }
+
+  //! \brief Returns the object at \a index.
+  T* at(size_t index) {
+    DCHECK_LT(index, size_);
+    return &objects_[index];
+  }
+
+  //! \brief Keeps the object at \a index, to be returned by Kept().
+  void Keep(size_t index) {
+    DCHECK_LT(index, size_);
+    kept_[index] = true;
+  }
+
+  //! \brief Returns the objects that have been kept, in index order, as
+  //!     pointers to \a U, which `T*` must be implicitly convertible to.
+  template <typename U = T>
+  std::vector<U*> Kept() const {
+    std::vector<U*> kept;
+    kept.reserve(size_);
+    for (size_t index = 0; index < size_; ++index) {
+      if (kept_[index]) {
+        kept.push_back(&objects_[index]);
+      }
+    }
+    return kept;
+  }
+
+ private:
+  std::unique_ptr<T[]> objects_;
+  std::vector<bool> kept_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ObjectArray);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_STDLIB_OBJECT_ARRAY_H_
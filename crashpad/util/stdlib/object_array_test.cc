@@ -0,0 +1,96 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/stdlib/object_array.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+class Base {
+ public:
+  virtual ~Base() {}
+};
+
+class Counted final : public Base {
+ public:
+  Counted() : value(0) { ++live_count; }
+  ~Counted() override { --live_count; }
+
+  int value;
+
+  static int live_count;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Counted);
+};
+
+int Counted::live_count = 0;
+
+TEST(ObjectArray, Empty) {
+  ObjectArray<Counted> objects;
+  EXPECT_EQ(objects.size(), 0u);
+  EXPECT_TRUE(objects.Kept().empty());
+
+  objects.Reset(0);
+  EXPECT_EQ(objects.size(), 0u);
+  EXPECT_TRUE(objects.Kept().empty());
+}
+
+TEST(ObjectArray, Keep) {
+  {
+    ObjectArray<Counted> objects;
+    objects.Reset(4);
+    EXPECT_EQ(Counted::live_count, 4);
+    ASSERT_EQ(objects.size(), 4u);
+    EXPECT_TRUE(objects.Kept().empty());
+
+    for (size_t index = 0; index < objects.size(); ++index) {
+      objects.at(index)->value = static_cast<int>(index);
+    }
+
+    // The order in which objects are kept doesn’t matter.
+    objects.Keep(3);
+    objects.Keep(0);
+    objects.Keep(2);
+
+    std::vector<Counted*> kept = objects.Kept();
+    ASSERT_EQ(kept.size(), 3u);
+    EXPECT_EQ(kept[0], objects.at(0));
+    EXPECT_EQ(kept[0]->value, 0);
+    EXPECT_EQ(kept[1]->value, 2);
+    EXPECT_EQ(kept[2]->value, 3);
+
+    // The objects are contiguous.
+    EXPECT_EQ(objects.at(1), objects.at(0) + 1);
+
+    std::vector<const Base*> kept_base = objects.Kept<const Base>();
+    ASSERT_EQ(kept_base.size(), 3u);
+    EXPECT_EQ(kept_base[1], objects.at(2));
+
+    objects.Reset(2);
+    EXPECT_EQ(Counted::live_count, 2);
+    EXPECT_EQ(objects.size(), 2u);
+    EXPECT_TRUE(objects.Kept().empty());
+  }
+  EXPECT_EQ(Counted::live_count, 0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -0,0 +1,188 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/string/utf_conversion.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "base/strings/utf_string_conversions.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CRASHPAD_UTF_CONVERSION_SSE2 1
+#elif defined(ARCH_CPU_ARM64)
+#include <arm_neon.h>
+#define CRASHPAD_UTF_CONVERSION_NEON 1
+#endif
+
+namespace crashpad {
+
+namespace {
+
+// Widens the ASCII prefix of |utf8|, up to |length| bytes, into |utf16|, which
+// has room for |length| code units. Returns the length of the prefix.
+size_t WidenASCII(const char* utf8, size_t length, base::char16* utf16) {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(utf8);
+  uint16_t* out = reinterpret_cast<uint16_t*>(utf16);
+  size_t index = 0;
+
+#if defined(CRASHPAD_UTF_CONVERSION_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; index + 16 <= length; index += 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + index));
+    if (_mm_movemask_epi8(bytes)) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + index),
+                     _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + index + 8),
+                     _mm_unpackhi_epi8(bytes, zero));
+  }
+#elif defined(CRASHPAD_UTF_CONVERSION_NEON)
+  for (; index + 16 <= length; index += 16) {
+    const uint8x16_t bytes = vld1q_u8(in + index);
+    if (vmaxvq_u8(bytes) >= 0x80) {
+      break;
+    }
+    vst1q_u16(out + index, vmovl_u8(vget_low_u8(bytes)));
+    vst1q_u16(out + index + 8, vmovl_u8(vget_high_u8(bytes)));
+  }
+#else
+  for (; index + 8 <= length; index += 8) {
+    uint64_t word;
+    memcpy(&word, in + index, sizeof(word));
+    if (word & UINT64_C(0x8080808080808080)) {
+      break;
+    }
+    for (size_t byte = 0; byte < 8; ++byte) {
+      out[index + byte] = in[index + byte];
+    }
+  }
+#endif
+
+  for (; index < length && in[index] < 0x80; ++index) {
+    out[index] = in[index];
+  }
+  return index;
+}
+
+// Narrows the ASCII prefix of |utf16|, up to |length| code units, into |utf8|,
+// which has room for |length| bytes. Returns the length of the prefix.
+size_t NarrowASCII(const base::char16* utf16, size_t length, char* utf8) {
+  const uint16_t* in = reinterpret_cast<const uint16_t*>(utf16);
+  uint8_t* out = reinterpret_cast<uint8_t*>(utf8);
+  size_t index = 0;
+
+#if defined(CRASHPAD_UTF_CONVERSION_SSE2)
+  const __m128i non_ascii_mask = _mm_set1_epi16(static_cast<int16_t>(0xff80));
+  for (; index + 16 <= length; index += 16) {
+    const __m128i low =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + index));
+    const __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + index + 8));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(
+            _mm_and_si128(_mm_or_si128(low, high), non_ascii_mask),
+            _mm_setzero_si128())) != 0xffff) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + index),
+                     _mm_packus_epi16(low, high));
+  }
+#elif defined(CRASHPAD_UTF_CONVERSION_NEON)
+  for (; index + 16 <= length; index += 16) {
+    const uint16x8_t low = vld1q_u16(in + index);
+    const uint16x8_t high = vld1q_u16(in + index + 8);
+    if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80) {
+      break;
+    }
+    vst1q_u8(out + index, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+  }
+#endif
+
+  for (; index < length && in[index] < 0x80; ++index) {
+    out[index] = static_cast<uint8_t>(in[index]);
+  }
+  return index;
+}
+
+}  // namespace
+
+bool TranscodeUTF8ToUTF16(const char* utf8,
+                          size_t length,
+                          base::string16* utf16) {
+  // A UTF-8 string never has fewer bytes than its UTF-16 form has code units,
+  // so the output is sized for the worst case up front and trimmed after.
+  utf16->resize(length);
+  bool success = true;
+  size_t in = 0;
+  size_t out = 0;
+  base::string16 run;
+  while (in < length) {
+    const size_t ascii = WidenASCII(utf8 + in, length - in, &(*utf16)[out]);
+    in += ascii;
+    out += ascii;
+    if (in == length) {
+      break;
+    }
+
+    // An ASCII byte is never part of a multibyte sequence, so the run of
+    // non-ASCII bytes up to the next one can be converted on its own.
+    size_t run_end = in + 1;
+    while (run_end < length && static_cast<uint8_t>(utf8[run_end]) >= 0x80) {
+      ++run_end;
+    }
+    success &= base::UTF8ToUTF16(utf8 + in, run_end - in, &run);
+    utf16->replace(out, run.size(), run);
+    out += run.size();
+    in = run_end;
+  }
+  utf16->resize(out);
+  return success;
+}
+
+bool TranscodeUTF16ToUTF8(const base::char16* utf16,
+                          size_t length,
+                          std::string* utf8) {
+  utf8->clear();
+  bool success = true;
+  size_t in = 0;
+  std::string run;
+  while (in < length) {
+    // The ASCII prefix is at most as long as the rest of the input.
+    const size_t out = utf8->size();
+    utf8->resize(out + length - in);
+    const size_t ascii = NarrowASCII(utf16 + in, length - in, &(*utf8)[out]);
+    utf8->resize(out + ascii);
+    in += ascii;
+    if (in == length) {
+      break;
+    }
+
+    // As with UTF-8, an ASCII code unit is never part of a surrogate pair.
+    size_t run_end = in + 1;
+    while (run_end < length && utf16[run_end] >= 0x80) {
+      ++run_end;
+    }
+    success &= base::UTF16ToUTF8(utf16 + in, run_end - in, &run);
+    utf8->append(run);
+    in = run_end;
+  }
+  return success;
+}
+
+}  // namespace crashpad
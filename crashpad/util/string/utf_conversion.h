@@ -0,0 +1,62 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_STRING_UTF_CONVERSION_H_
+#define CRASHPAD_UTIL_STRING_UTF_CONVERSION_H_
+
+#include <stddef.h>
+
+#include <string>
+
+#include "base/strings/string16.h"
+
+namespace crashpad {
+
+//! \brief Converts UTF-8 to UTF-16.
+//!
+//! This produces the same result as `base::UTF8ToUTF16()`, but converts runs
+//! of ASCII directly, many characters at a time, leaving only the rest to
+//! `base`. Module paths, annotations, and the other strings in minidumps are
+//! overwhelmingly ASCII.
+//!
+//! \param[in] utf8 The UTF-8 string to convert.
+//! \param[in] length The length of \a utf8, in bytes.
+//! \param[out] utf16 The converted string. Invalid sequences are replaced by
+//!     U+FFFD.
+//!
+//! \return `true` on success. `false` if \a utf8 was not valid UTF-8, with no
+//!     message logged.
+bool TranscodeUTF8ToUTF16(const char* utf8,
+                          size_t length,
+                          base::string16* utf16);
+
+//! \brief Converts UTF-16 to UTF-8.
+//!
+//! This produces the same result as `base::UTF16ToUTF8()`, converting runs of
+//! ASCII directly as TranscodeUTF8ToUTF16() does.
+//!
+//! \param[in] utf16 The UTF-16 string to convert.
+//! \param[in] length The length of \a utf16, in code units.
+//! \param[out] utf8 The converted string. Invalid sequences are replaced by
+//!     U+FFFD.
+//!
+//! \return `true` on success. `false` if \a utf16 was not valid UTF-16, with
+//!     no message logged.
+bool TranscodeUTF16ToUTF8(const base::char16* utf16,
+                          size_t length,
+                          std::string* utf8);
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_STRING_UTF_CONVERSION_H_
@@ -0,0 +1,105 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/string/utf_conversion.h"
+
+#include <string>
+#include <vector>
+
+#include "base/strings/utf_string_conversions.h"
+#include "gtest/gtest.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+// Strings long enough to exercise the conversion of many characters at a time,
+// with non-ASCII characters and invalid sequences at various offsets.
+std::vector<std::string> TestStrings() {
+  static constexpr const char* kInserts[] = {
+      "\xc3\xa9",  // U+00E9
+      "\xe2\x82\xac",  // U+20AC
+      "\xf0\x9f\x98\x80",  // U+1F600, a surrogate pair in UTF-16
+      "\xc3",  // Truncated
+      "\x80",  // Lone continuation byte
+      "\xed\xa0\x80",  // Encoded surrogate
+  };
+
+  const std::string ascii =
+      "/system/lib64/libandroid_runtime.so/data/app/com.example-1/base.apk";
+  std::vector<std::string> strings;
+  strings.push_back(std::string());
+  for (size_t length = 1; length <= ascii.size(); length += 7) {
+    strings.push_back(ascii.substr(0, length));
+  }
+  for (const char* insert : kInserts) {
+    for (size_t offset = 0; offset <= ascii.size(); offset += 5) {
+      std::string string = ascii;
+      string.insert(offset, insert);
+      strings.push_back(string);
+      string.insert(string.size() / 2 + offset / 2, insert);
+      strings.push_back(string);
+    }
+    strings.push_back(insert);
+  }
+  return strings;
+}
+
+TEST(UTFConversion, UTF8ToUTF16) {
+  for (const std::string& utf8 : TestStrings()) {
+    SCOPED_TRACE(utf8);
+    base::string16 expected;
+    const bool expected_success =
+        base::UTF8ToUTF16(utf8.data(), utf8.size(), &expected);
+
+    base::string16 utf16(3, 'x');
+    EXPECT_EQ(TranscodeUTF8ToUTF16(utf8.data(), utf8.size(), &utf16),
+              expected_success);
+    EXPECT_EQ(utf16, expected);
+  }
+}
+
+TEST(UTFConversion, UTF16ToUTF8) {
+  std::vector<base::string16> strings;
+  for (const std::string& utf8 : TestStrings()) {
+    strings.push_back(base::UTF8ToUTF16(utf8));
+  }
+
+  // Unpaired surrogates and characters just past ASCII.
+  base::string16 invalid = strings.back();
+  invalid.insert(invalid.begin() + invalid.size() / 2, 0xd800);
+  strings.push_back(invalid);
+  invalid.push_back(0xdc00);
+  strings.push_back(invalid);
+  base::string16 latin = base::UTF8ToUTF16(std::string(40, 'a'));
+  latin[20] = 0x80;
+  latin[33] = 0x100;
+  strings.push_back(latin);
+
+  for (const base::string16& utf16 : strings) {
+    std::string expected;
+    const bool expected_success =
+        base::UTF16ToUTF8(utf16.data(), utf16.size(), &expected);
+    SCOPED_TRACE(expected);
+
+    std::string utf8("xyz");
+    EXPECT_EQ(TranscodeUTF16ToUTF8(utf16.data(), utf16.size(), &utf8),
+              expected_success);
+    EXPECT_EQ(utf8, expected);
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
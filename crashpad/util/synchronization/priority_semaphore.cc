@@ -0,0 +1,93 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/synchronization/priority_semaphore.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace crashpad {
+
+PrioritySemaphore::PrioritySemaphore(int value)
+    : lock_(), waiters_(), next_sequence_(0), value_(value) {
+  DCHECK_GE(value, 0);
+}
+
+PrioritySemaphore::~PrioritySemaphore() {
+  DCHECK(waiters_.empty());
+}
+
+void PrioritySemaphore::Wait(int priority) {
+  Semaphore semaphore(0);
+  {
+    base::AutoLock lock(lock_);
+    if (value_ > 0 && waiters_.empty()) {
+      --value_;
+      return;
+    }
+
+    waiters_.push_back({priority, next_sequence_++, &semaphore});
+    std::push_heap(waiters_.begin(), waiters_.end(), WaiterHasLowerPriority);
+  }
+
+  semaphore.Wait();
+
+  // Signal() removes this waiter from waiters_ and signals semaphore while
+  // holding lock_. Taking lock_ here ensures that Signal() is finished with
+  // semaphore before it’s destroyed.
+  base::AutoLock lock(lock_);
+}
+
+void PrioritySemaphore::Signal() {
+  base::AutoLock lock(lock_);
+  if (waiters_.empty()) {
+    ++value_;
+    return;
+  }
+
+  // Hand the unit directly to the next waiter rather than making it available,
+  // so that a caller arriving in Wait() can’t take it first.
+  std::pop_heap(waiters_.begin(), waiters_.end(), WaiterHasLowerPriority);
+  Semaphore* semaphore = waiters_.back().semaphore;
+  waiters_.pop_back();
+  semaphore->Signal();
+}
+
+size_t PrioritySemaphore::WaiterCount() {
+  base::AutoLock lock(lock_);
+  return waiters_.size();
+}
+
+// static
+bool PrioritySemaphore::WaiterHasLowerPriority(const Waiter& lhs,
+                                               const Waiter& rhs) {
+  if (lhs.priority != rhs.priority) {
+    return lhs.priority < rhs.priority;
+  }
+  return lhs.sequence > rhs.sequence;
+}
+
+ScopedPrioritySemaphoreWait::ScopedPrioritySemaphoreWait(
+    PrioritySemaphore* semaphore,
+    int priority)
+    : semaphore_(semaphore) {
+  semaphore_->Wait(priority);
+}
+
+ScopedPrioritySemaphoreWait::~ScopedPrioritySemaphoreWait() {
+  semaphore_->Signal();
+}
+
+}  // namespace crashpad
@@ -0,0 +1,101 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_SYNCHRONIZATION_PRIORITY_SEMAPHORE_H_
+#define CRASHPAD_UTIL_SYNCHRONIZATION_PRIORITY_SEMAPHORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "util/synchronization/semaphore.h"
+
+namespace crashpad {
+
+//! \brief An in-process counting semaphore that wakes its waiters in priority
+//!     order.
+//!
+//! When a Signal() makes a unit available and callers are blocked in Wait(),
+//! the unit is handed to the waiter with the highest priority. Waiters of equal
+//! priority are woken in the order that they began waiting.
+class PrioritySemaphore {
+ public:
+  //! \brief Initializes the semaphore.
+  //!
+  //! \param[in] value The initial value of the semaphore.
+  explicit PrioritySemaphore(int value);
+
+  ~PrioritySemaphore();
+
+  //! \brief Performs the wait (or “procure”) operation on the semaphore.
+  //!
+  //! Returns immediately if a unit is available and no other caller is
+  //! waiting. Otherwise, blocks until a unit is handed to this caller by
+  //! Signal().
+  //!
+  //! \param[in] priority The priority of this caller. Larger values are woken
+  //!     before smaller ones.
+  void Wait(int priority);
+
+  //! \brief Performs the signal (or “post”) operation on the semaphore.
+  //!
+  //! Wakes the highest-priority caller blocked in Wait(), or makes a unit
+  //! available if there is none.
+  void Signal();
+
+  //! \return The number of callers currently blocked in Wait().
+  size_t WaiterCount();
+
+ private:
+  struct Waiter {
+    int priority;
+    uint64_t sequence;
+    Semaphore* semaphore;  // weak
+  };
+
+  // Orders the heap in waiters_ so that its front is the waiter with the
+  // highest priority that began waiting first.
+  static bool WaiterHasLowerPriority(const Waiter& lhs, const Waiter& rhs);
+
+  base::Lock lock_;
+  // Access to these fields must be guarded by lock_.
+  std::vector<Waiter> waiters_;
+  uint64_t next_sequence_;
+  int value_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrioritySemaphore);
+};
+
+//! \brief Waits on a PrioritySemaphore for the lifetime of the object,
+//!     signalling it on destruction.
+class ScopedPrioritySemaphoreWait {
+ public:
+  //! \param[in] semaphore The semaphore to wait on. Weak.
+  //! \param[in] priority The priority to wait with, as for
+  //!     PrioritySemaphore::Wait().
+  ScopedPrioritySemaphoreWait(PrioritySemaphore* semaphore, int priority);
+  ~ScopedPrioritySemaphoreWait();
+
+ private:
+  PrioritySemaphore* semaphore_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedPrioritySemaphoreWait);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_SYNCHRONIZATION_PRIORITY_SEMAPHORE_H_
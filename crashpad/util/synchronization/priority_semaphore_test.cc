@@ -0,0 +1,104 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/synchronization/priority_semaphore.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "gtest/gtest.h"
+#include "util/misc/clock.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(PrioritySemaphore, Simple) {
+  PrioritySemaphore semaphore(1);
+  semaphore.Wait(0);
+  EXPECT_EQ(semaphore.WaiterCount(), 0u);
+  semaphore.Signal();
+
+  {
+    ScopedPrioritySemaphoreWait wait(&semaphore, 0);
+  }
+  semaphore.Wait(0);
+  semaphore.Signal();
+}
+
+class WaitThread : public Thread {
+ public:
+  WaitThread(PrioritySemaphore* semaphore,
+             int priority,
+             base::Lock* order_lock,
+             std::vector<int>* order)
+      : Thread(),
+        semaphore_(semaphore),
+        order_lock_(order_lock),
+        order_(order),
+        priority_(priority) {}
+  ~WaitThread() override {}
+
+ private:
+  void ThreadMain() override {
+    ScopedPrioritySemaphoreWait wait(semaphore_, priority_);
+    base::AutoLock lock(*order_lock_);
+    order_->push_back(priority_);
+  }
+
+  PrioritySemaphore* semaphore_;  // weak
+  base::Lock* order_lock_;  // weak
+  std::vector<int>* order_;  // weak
+  int priority_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaitThread);
+};
+
+TEST(PrioritySemaphore, WakesInPriorityOrder) {
+  PrioritySemaphore semaphore(0);
+  base::Lock order_lock;
+  std::vector<int> order;
+
+  // Start the threads one at a time, waiting for each to block, so that the
+  // order in which they began waiting is known.
+  static constexpr int kPriorities[] = {1, 0, 2, 1, 2, 0};
+  std::unique_ptr<WaitThread> threads[arraysize(kPriorities)];
+  for (size_t index = 0; index < arraysize(kPriorities); ++index) {
+    threads[index].reset(
+        new WaitThread(&semaphore, kPriorities[index], &order_lock, &order));
+    threads[index]->Start();
+    while (semaphore.WaiterCount() != index + 1) {
+      SleepNanoseconds(1E6);  // 1ms
+    }
+  }
+
+  // Each woken thread signals the semaphore on its way out, waking the next.
+  semaphore.Signal();
+
+  for (const auto& thread : threads) {
+    thread->Join();
+  }
+
+  semaphore.Wait(0);
+
+  const std::vector<int> expected = {2, 2, 1, 1, 0, 0};
+  EXPECT_EQ(order, expected);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
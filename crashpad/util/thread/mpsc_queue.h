@@ -0,0 +1,155 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_THREAD_MPSC_QUEUE_H_
+#define CRASHPAD_UTIL_THREAD_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <memory>
+
+#include "base/macros.h"
+#include "util/synchronization/semaphore.h"
+
+namespace crashpad {
+
+//! \brief The link embedded in each element of an MPSCQueue.
+//!
+//! Elements are queued by deriving them from this class, so queueing one
+//! requires no allocation beyond that of the element itself.
+class MPSCQueueNode {
+ public:
+  MPSCQueueNode() : mpsc_queue_next_(nullptr) {}
+
+ private:
+  template <typename T>
+  friend class MPSCQueue;
+
+  MPSCQueueNode* mpsc_queue_next_;
+
+  DISALLOW_COPY_AND_ASSIGN(MPSCQueueNode);
+};
+
+//! \brief A lock-free, intrusive queue with many producers and one consumer.
+//!
+//! Any thread may Push() elements, which never blocks. A single consumer
+//! thread takes them with Pop() in the order that they were pushed, and may
+//! block until there are elements to take with Wait().
+//!
+//! Producers push onto a shared stack with a single compare-and-swap. When the
+//! consumer runs out of elements, it takes the entire stack with a single
+//! exchange and reverses it. Because the consumer never removes individual
+//! elements from the shared stack, no element can be removed and pushed again
+//! between a producer’s read and its compare-and-swap, so there is no ABA
+//! problem.
+//!
+//! \tparam T The element type, which must derive from MPSCQueueNode.
+template <typename T>
+class MPSCQueue {
+ public:
+  MPSCQueue() : head_(nullptr), consumer_head_(nullptr), semaphore_(0) {}
+
+  ~MPSCQueue() {
+    while (Pop()) {
+    }
+  }
+
+  //! \brief Adds an element to the queue.
+  //!
+  //! This method may be called from any thread.
+  //!
+  //! \param[in] element The element to add. The queue takes ownership of it.
+  //!
+  //! \return `true` if the queue’s shared stack was empty, in which case the
+  //!     consumer may need to be woken to take \a element. Wait() is woken
+  //!     automatically. `false` if an element pushed earlier has yet to be
+  //!     taken by the consumer, which is then already due to be woken.
+  bool Push(std::unique_ptr<T> element) {
+    MPSCQueueNode* node = element.release();
+
+    // Once the compare-and-swap succeeds, the consumer may take node at any
+    // time, so only the local copy of the previous head is examined after it.
+    MPSCQueueNode* head = head_.load(std::memory_order_relaxed);
+    do {
+      node->mpsc_queue_next_ = head;
+    } while (!head_.compare_exchange_weak(head,
+                                          node,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+
+    if (head) {
+      return false;
+    }
+    semaphore_.Signal();
+    return true;
+  }
+
+  //! \brief Removes the oldest element from the queue.
+  //!
+  //! This method must only be called from the consumer thread.
+  //!
+  //! \return The element, or `nullptr` if the queue is empty.
+  std::unique_ptr<T> Pop() {
+    if (!consumer_head_) {
+      // The stack is newest first. Reversing it puts the oldest element first.
+      MPSCQueueNode* node = head_.exchange(nullptr, std::memory_order_acquire);
+      while (node) {
+        MPSCQueueNode* next = node->mpsc_queue_next_;
+        node->mpsc_queue_next_ = consumer_head_;
+        consumer_head_ = node;
+        node = next;
+      }
+      if (!consumer_head_) {
+        return nullptr;
+      }
+    }
+
+    MPSCQueueNode* node = consumer_head_;
+    consumer_head_ = node->mpsc_queue_next_;
+    node->mpsc_queue_next_ = nullptr;
+    return std::unique_ptr<T>(static_cast<T*>(node));
+  }
+
+  //! \brief Waits for elements to be pushed onto the queue.
+  //!
+  //! This method must only be called from the consumer thread.
+  //!
+  //! \param[in] seconds The maximum number of seconds to wait, which may be
+  //!     Semaphore::kIndefiniteWait.
+  //!
+  //! \return `true` if the queue may have elements to Pop(), `false` if the
+  //!     wait timed out. This may return `true` for an element that was
+  //!     already taken by Pop(), so a `nullptr` from Pop() must still be
+  //!     expected.
+  bool Wait(double seconds) {
+    if (consumer_head_ || head_.load(std::memory_order_relaxed)) {
+      return true;
+    }
+    return semaphore_.TimedWait(seconds);
+  }
+
+ private:
+  std::atomic<MPSCQueueNode*> head_;
+
+  // Elements taken from head_ by the consumer, oldest first. Only the consumer
+  // accesses this.
+  MPSCQueueNode* consumer_head_;
+
+  Semaphore semaphore_;
+
+  DISALLOW_COPY_AND_ASSIGN(MPSCQueue);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_THREAD_MPSC_QUEUE_H_
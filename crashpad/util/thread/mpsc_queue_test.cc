@@ -0,0 +1,155 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/thread/mpsc_queue.h"
+
+#include "base/macros.h"
+#include "gtest/gtest.h"
+#include "util/thread/thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr int kElementsPerThread = 100;
+
+struct TestElement : public MPSCQueueNode {
+  explicit TestElement(int value) : MPSCQueueNode(), value(value) {}
+
+  int value;
+};
+
+std::unique_ptr<TestElement> MakeElement(int value) {
+  return std::unique_ptr<TestElement>(new TestElement(value));
+}
+
+class MPSCQueueTestThread : public Thread {
+ public:
+  MPSCQueueTestThread() : queue_(nullptr), start_(0) {}
+  ~MPSCQueueTestThread() {}
+
+  void SetTestParameters(MPSCQueue<TestElement>* queue, int start) {
+    queue_ = queue;
+    start_ = start;
+  }
+
+  // Thread:
+  void ThreadMain() override {
+    for (int i = start_; i < start_ + kElementsPerThread; ++i) {
+      queue_->Push(MakeElement(i));
+    }
+  }
+
+ private:
+  MPSCQueue<TestElement>* queue_;
+  int start_;
+
+  DISALLOW_COPY_AND_ASSIGN(MPSCQueueTestThread);
+};
+
+TEST(MPSCQueue, Order) {
+  MPSCQueue<TestElement> queue;
+  EXPECT_FALSE(queue.Pop());
+
+  EXPECT_TRUE(queue.Push(MakeElement(1)));
+  EXPECT_FALSE(queue.Push(MakeElement(2)));
+
+  std::unique_ptr<TestElement> element = queue.Pop();
+  ASSERT_TRUE(element);
+  EXPECT_EQ(element->value, 1);
+
+  // The rest of the elements taken from the shared stack are still ahead of
+  // those pushed since.
+  EXPECT_TRUE(queue.Push(MakeElement(3)));
+
+  element = queue.Pop();
+  ASSERT_TRUE(element);
+  EXPECT_EQ(element->value, 2);
+  element = queue.Pop();
+  ASSERT_TRUE(element);
+  EXPECT_EQ(element->value, 3);
+  EXPECT_FALSE(queue.Pop());
+}
+
+TEST(MPSCQueue, DestroyNonEmpty) {
+  MPSCQueue<TestElement> queue;
+  queue.Push(MakeElement(1));
+  queue.Push(MakeElement(2));
+  queue.Push(MakeElement(3));
+  EXPECT_TRUE(queue.Pop());
+}
+
+TEST(MPSCQueue, Wait) {
+  MPSCQueue<TestElement> queue;
+  EXPECT_FALSE(queue.Wait(0));
+
+  queue.Push(MakeElement(1));
+  EXPECT_TRUE(queue.Wait(0));
+  EXPECT_TRUE(queue.Pop());
+}
+
+TEST(MPSCQueue, Threaded) {
+  MPSCQueue<TestElement> queue;
+
+  MPSCQueueTestThread threads[100];
+  for (size_t index = 0; index < arraysize(threads); ++index) {
+    threads[index].SetTestParameters(
+        &queue, static_cast<int>(index * kElementsPerThread));
+  }
+
+  bool found[arraysize(threads) * kElementsPerThread] = {};
+  int last_found[arraysize(threads)];
+  for (int& last : last_found) {
+    last = -1;
+  }
+  size_t found_count = 0;
+  auto take_all = [&queue, &found, &last_found, &found_count]() {
+    while (std::unique_ptr<TestElement> element = queue.Pop()) {
+      EXPECT_FALSE(found[element->value]) << element->value;
+      found[element->value] = true;
+      ++found_count;
+
+      // Each thread’s elements are taken in the order it pushed them.
+      int& last = last_found[element->value / kElementsPerThread];
+      EXPECT_GT(element->value, last);
+      last = element->value;
+    }
+  };
+
+  for (size_t index = 0; index < arraysize(threads); ++index) {
+    threads[index].Start();
+
+    if (index % 10 == 0) {
+      // Take elements periodically to test that simultaneous Pop() and Push()
+      // operations work properly.
+      take_all();
+    }
+  }
+
+  while (found_count < arraysize(found) && queue.Wait(10)) {
+    take_all();
+  }
+
+  for (MPSCQueueTestThread& thread : threads) {
+    thread.Join();
+  }
+
+  take_all();
+  EXPECT_EQ(found_count, arraysize(found));
+  EXPECT_FALSE(queue.Pop());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -14,8 +14,12 @@
 
 #include "util/thread/thread_log_messages.h"
 
+#include <string.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <utility>
+
 #include "base/logging.h"
 #include "base/threading/thread_local_storage.h"
 
@@ -33,7 +37,7 @@ namespace {
 // object of this class exists.
 class ThreadLogMessagesMaster {
  public:
-  void SetThreadMessageList(std::vector<std::string>* message_list) {
+  void SetThreadMessageList(ThreadLogMessages* message_list) {
     DCHECK_EQ(logging::GetLogMessageHandler(), &LogMessageHandler);
     DCHECK_NE(tls_.Get() != nullptr, message_list != nullptr);
     tls_.Set(message_list);
@@ -61,10 +65,10 @@ class ThreadLogMessagesMaster {
                                 int line,
                                 size_t message_start,
                                 const std::string& string) {
-    std::vector<std::string>* log_messages =
-        reinterpret_cast<std::vector<std::string>*>(tls_.Get());
+    ThreadLogMessages* log_messages =
+        reinterpret_cast<ThreadLogMessages*>(tls_.Get());
     if (log_messages) {
-      log_messages->push_back(string);
+      log_messages->AddLogMessage(string);
     }
 
     // Don’t consume the message. Allow it to be logged as if nothing was set as
@@ -83,12 +87,85 @@ base::ThreadLocalStorage::StaticSlot ThreadLogMessagesMaster::tls_
 
 }  // namespace
 
-ThreadLogMessages::ThreadLogMessages() : log_messages_() {
-  ThreadLogMessagesMaster::GetInstance()->SetThreadMessageList(&log_messages_);
+// static
+constexpr size_t ThreadLogMessages::kDefaultMaxBytes;
+
+ThreadLogMessages::ThreadLogMessages(size_t max_bytes)
+    : ring_(new char[max_bytes]),
+      ring_capacity_(max_bytes),
+      ring_begin_(0),
+      ring_used_(0),
+      message_count_(0),
+      dropped_message_count_(0),
+      log_messages_() {
+  ThreadLogMessagesMaster::GetInstance()->SetThreadMessageList(this);
 }
 
 ThreadLogMessages::~ThreadLogMessages() {
   ThreadLogMessagesMaster::GetInstance()->SetThreadMessageList(nullptr);
 }
 
+const std::vector<std::string>& ThreadLogMessages::log_messages() const {
+  log_messages_.clear();
+  log_messages_.reserve(message_count_);
+
+  size_t offset = ring_begin_;
+  for (size_t index = 0; index < message_count_; ++index) {
+    size_t length;
+    ReadRing(offset, &length, sizeof(length));
+    offset += sizeof(length);
+
+    std::string message(length, '\0');
+    ReadRing(offset, &message[0], length);
+    offset += length;
+
+    log_messages_.push_back(std::move(message));
+  }
+
+  return log_messages_;
+}
+
+void ThreadLogMessages::AddLogMessage(const std::string& message) {
+  if (ring_capacity_ <= sizeof(size_t)) {
+    ++dropped_message_count_;
+    return;
+  }
+
+  const size_t length =
+      std::min(message.size(), ring_capacity_ - sizeof(size_t));
+  const size_t needed = sizeof(length) + length;
+
+  while (ring_capacity_ - ring_used_ < needed) {
+    size_t oldest_length;
+    ReadRing(ring_begin_, &oldest_length, sizeof(oldest_length));
+    const size_t oldest_size = sizeof(oldest_length) + oldest_length;
+    ring_begin_ = (ring_begin_ + oldest_size) % ring_capacity_;
+    ring_used_ -= oldest_size;
+    --message_count_;
+    ++dropped_message_count_;
+  }
+
+  const size_t end = ring_begin_ + ring_used_;
+  WriteRing(end, &length, sizeof(length));
+  WriteRing(end + sizeof(length), message.data(), length);
+  ring_used_ += needed;
+  ++message_count_;
+}
+
+void ThreadLogMessages::WriteRing(size_t offset,
+                                  const void* data,
+                                  size_t size) {
+  offset %= ring_capacity_;
+  const size_t first = std::min(size, ring_capacity_ - offset);
+  memcpy(&ring_[offset], data, first);
+  memcpy(&ring_[0], static_cast<const char*>(data) + first, size - first);
+}
+
+void ThreadLogMessages::ReadRing(size_t offset, void* data, size_t size) const {
+  offset %= ring_capacity_;
+  const size_t first = std::min(size, ring_capacity_ - offset);
+  memcpy(data, &ring_[offset], first);
+  memcpy(static_cast<char*>(data) + first, &ring_[0], size - first);
+}
+
 }  // namespace crashpad
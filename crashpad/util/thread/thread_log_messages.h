@@ -15,6 +15,9 @@
 #ifndef CRASHPAD_UTIL_THREAD_THREAD_LOG_MESSAGES_H_
 #define CRASHPAD_UTIL_THREAD_THREAD_LOG_MESSAGES_H_
 
+#include <sys/types.h>
+
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -28,17 +31,55 @@ namespace crashpad {
 //! At most one object of this class type may exist on a single thread at a
 //! time. When using this class, no other part of the program may call
 //! `logging::SetLogMessageHandler()` at any time.
+//!
+//! Messages are kept in storage of a fixed size, allocated when the object is
+//! created. When it fills, the oldest messages are discarded to make room, so
+//! that verbose logging neither grows memory use without bound nor allocates
+//! for each message.
 class ThreadLogMessages {
  public:
-  ThreadLogMessages();
+  //! \brief The default value for the \a max_bytes constructor parameter.
+  static constexpr size_t kDefaultMaxBytes = 64 * 1024;
+
+  //! \param[in] max_bytes The size of the storage for collected messages,
+  //!     including a small per-message overhead. A message too large to fit
+  //!     in this storage by itself is truncated.
+  explicit ThreadLogMessages(size_t max_bytes = kDefaultMaxBytes);
   ~ThreadLogMessages();
 
   //! \return The log messages collected on the thread that this object was
-  //!     created on since the time it was created.
-  const std::vector<std::string>& log_messages() const { return log_messages_; }
+  //!     created on since the time it was created, from oldest to newest,
+  //!     excluding any that were discarded to make room for newer ones. The
+  //!     returned reference is valid until this method is next called.
+  const std::vector<std::string>& log_messages() const;
+
+  //! \return The number of messages that were discarded to make room for
+  //!     newer ones.
+  size_t dropped_message_count() const { return dropped_message_count_; }
+
+  //! \brief Adds a message to the collected messages.
+  //!
+  //! This is called for each message logged on the thread that this object
+  //! was created on, and does not allocate memory.
+  //!
+  //! \param[in] message The message to add.
+  void AddLogMessage(const std::string& message);
 
  private:
-  std::vector<std::string> log_messages_;
+  // Copies between the ring and a linear buffer, wrapping at the end of the
+  // ring as needed.
+  void WriteRing(size_t offset, const void* data, size_t size);
+  void ReadRing(size_t offset, void* data, size_t size) const;
+
+  // Each message is stored as its size_t length followed by its contents,
+  // starting at ring_begin_ and wrapping at ring_capacity_.
+  std::unique_ptr<char[]> ring_;
+  size_t ring_capacity_;
+  size_t ring_begin_;
+  size_t ring_used_;
+  size_t message_count_;
+  size_t dropped_message_count_;
+  mutable std::vector<std::string> log_messages_;
 
   DISALLOW_COPY_AND_ASSIGN(ThreadLogMessages);
 };
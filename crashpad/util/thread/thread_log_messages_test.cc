@@ -128,6 +128,47 @@ TEST(ThreadLogMessages, Basic) {
   }
 }
 
+TEST(ThreadLogMessages, DiscardsOldest) {
+  // Room for three messages of kMessageSize bytes each.
+  constexpr size_t kMessageSize = 10;
+  ThreadLogMessages thread_log_messages(3 * (sizeof(size_t) + kMessageSize));
+
+  for (int index = 0; index < 10; ++index) {
+    thread_log_messages.AddLogMessage(
+        base::StringPrintf("message %02d", index));
+  }
+
+  const std::vector<std::string>& log_messages =
+      thread_log_messages.log_messages();
+  ASSERT_EQ(log_messages.size(), 3u);
+  EXPECT_EQ(log_messages[0], "message 07");
+  EXPECT_EQ(log_messages[1], "message 08");
+  EXPECT_EQ(log_messages[2], "message 09");
+  EXPECT_EQ(thread_log_messages.dropped_message_count(), 7u);
+
+  // A larger message displaces as many older messages as it needs to.
+  const std::string large_message(2 * kMessageSize, 'x');
+  thread_log_messages.AddLogMessage(large_message);
+  ASSERT_EQ(thread_log_messages.log_messages().size(), 2u);
+  EXPECT_EQ(thread_log_messages.log_messages()[0], "message 09");
+  EXPECT_EQ(thread_log_messages.log_messages()[1], large_message);
+  EXPECT_EQ(thread_log_messages.dropped_message_count(), 9u);
+}
+
+TEST(ThreadLogMessages, TruncatesLongMessage) {
+  constexpr size_t kMaxBytes = 64;
+  ThreadLogMessages thread_log_messages(kMaxBytes);
+
+  thread_log_messages.AddLogMessage("short");
+  thread_log_messages.AddLogMessage(std::string(2 * kMaxBytes, 'y'));
+
+  const std::vector<std::string>& log_messages =
+      thread_log_messages.log_messages();
+  ASSERT_EQ(log_messages.size(), 1u);
+  EXPECT_EQ(log_messages[0], std::string(kMaxBytes - sizeof(size_t), 'y'));
+  EXPECT_EQ(thread_log_messages.dropped_message_count(), 1u);
+}
+
 class LoggingTestThread : public Thread {
  public:
   LoggingTestThread() : thread_number_(0), start_(0), count_(0) {}
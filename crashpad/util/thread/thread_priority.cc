@@ -0,0 +1,281 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/thread/thread_priority.h"
+
+#include <errno.h>
+
+#include "base/logging.h"
+
+#if defined(OS_POSIX)
+#include <sys/resource.h>
+#endif  // OS_POSIX
+
+#if defined(OS_MACOSX)
+#include <mach/mach.h>
+#include <mach/thread_policy.h>
+#include <pthread.h>
+
+#include "base/mac/mach_logging.h"
+#elif defined(OS_WIN)
+#include <windows.h>
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // OS_MACOSX
+
+namespace crashpad {
+
+namespace {
+
+#if defined(OS_MACOSX)
+
+// The precedence of a capturing thread, relative to the other threads of the
+// handler.
+constexpr int kCaptureImportance = 16;
+
+thread_act_t CurrentThread() {
+  // Unlike mach_thread_self(), this doesn’t return a new send right.
+  return pthread_mach_thread_np(pthread_self());
+}
+
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+
+// These are from <linux/ioprio.h>, which isn’t available everywhere.
+constexpr int kIOPrioWhoProcess = 1;
+constexpr int kIOPrioClassShift = 13;
+constexpr int kIOPrioClassRT = 1;
+constexpr int kIOPrioClassBE = 2;
+constexpr int kIOPrioClassIdle = 3;
+
+constexpr int IOPrioValue(int io_class, int level) {
+  return (io_class << kIOPrioClassShift) | level;
+}
+
+// The nice value that a capturing thread asks for. An unprivileged thread is
+// usually refused, unless RLIMIT_NICE allows it.
+constexpr int kCaptureNice = -10;
+
+pid_t CurrentThread() {
+  // On Linux, the nice value and I/O priority apply to the single thread
+  // named.
+  return syscall(SYS_gettid);
+}
+
+int GetIOPriority() {
+  return syscall(SYS_ioprio_get, kIOPrioWhoProcess, CurrentThread());
+}
+
+bool SetIOPriority(int io_priority) {
+  return syscall(SYS_ioprio_set,
+                 kIOPrioWhoProcess,
+                 CurrentThread(),
+                 io_priority) == 0;
+}
+
+bool IsPermissionError(int error) {
+  return error == EPERM || error == EACCES;
+}
+
+#endif  // OS_MACOSX
+
+}  // namespace
+
+void LowerThreadPriority() {
+#if defined(OS_MACOSX)
+  // This lowers the thread’s I/O priority along with its scheduling priority.
+  if (setpriority(PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG) != 0) {
+    PLOG(WARNING) << "setpriority";
+  }
+#elif defined(OS_WIN)
+  // This lowers the thread’s I/O and memory priorities along with its
+  // scheduling priority.
+  if (!SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN) &&
+      GetLastError() != ERROR_THREAD_MODE_ALREADY_BACKGROUND) {
+    PLOG(WARNING) << "SetThreadPriority";
+  }
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+  if (setpriority(PRIO_PROCESS, CurrentThread(), 19) != 0) {
+    PLOG(WARNING) << "setpriority";
+  }
+  if (!SetIOPriority(IOPrioValue(kIOPrioClassIdle, 0))) {
+    PLOG(WARNING) << "ioprio_set";
+  }
+#endif  // OS_MACOSX
+}
+
+#if defined(OS_MACOSX)
+
+ScopedRaisedThreadPriority::ScopedRaisedThreadPriority()
+    : old_importance_(0),
+      old_io_policy_(-1),
+      importance_raised_(false),
+      was_background_(false) {
+  // This returns 1 for a background thread, and -1 with errno set on failure.
+  errno = 0;
+  int background = getpriority(PRIO_DARWIN_THREAD, 0);
+  if (background == -1 && errno != 0) {
+    PLOG(WARNING) << "getpriority";
+  } else if (background != 0) {
+    if (setpriority(PRIO_DARWIN_THREAD, 0, 0) != 0) {
+      PLOG(WARNING) << "setpriority";
+    } else {
+      was_background_ = true;
+    }
+  }
+
+  thread_precedence_policy_data_t policy;
+  mach_msg_type_number_t count = THREAD_PRECEDENCE_POLICY_COUNT;
+  boolean_t get_default = FALSE;
+  kern_return_t kr =
+      thread_policy_get(CurrentThread(),
+                        THREAD_PRECEDENCE_POLICY,
+                        reinterpret_cast<thread_policy_t>(&policy),
+                        &count,
+                        &get_default);
+  if (kr != KERN_SUCCESS) {
+    MACH_LOG(WARNING, kr) << "thread_policy_get";
+  } else if (policy.importance < kCaptureImportance) {
+    old_importance_ = policy.importance;
+    policy.importance = kCaptureImportance;
+    kr = thread_policy_set(CurrentThread(),
+                           THREAD_PRECEDENCE_POLICY,
+                           reinterpret_cast<thread_policy_t>(&policy),
+                           THREAD_PRECEDENCE_POLICY_COUNT);
+    if (kr != KERN_SUCCESS) {
+      MACH_LOG(WARNING, kr) << "thread_policy_set";
+    } else {
+      importance_raised_ = true;
+    }
+  }
+
+  int io_policy = getiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD);
+  if (io_policy < 0) {
+    PLOG(WARNING) << "getiopolicy_np";
+  } else if (io_policy != IOPOL_IMPORTANT) {
+    if (setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, IOPOL_IMPORTANT) !=
+        0) {
+      PLOG(WARNING) << "setiopolicy_np";
+    } else {
+      old_io_policy_ = io_policy;
+    }
+  }
+}
+
+ScopedRaisedThreadPriority::~ScopedRaisedThreadPriority() {
+  if (importance_raised_) {
+    thread_precedence_policy_data_t policy;
+    policy.importance = old_importance_;
+    kern_return_t kr =
+        thread_policy_set(CurrentThread(),
+                          THREAD_PRECEDENCE_POLICY,
+                          reinterpret_cast<thread_policy_t>(&policy),
+                          THREAD_PRECEDENCE_POLICY_COUNT);
+    MACH_LOG_IF(WARNING, kr != KERN_SUCCESS, kr) << "thread_policy_set";
+  }
+  if (old_io_policy_ >= 0 &&
+      setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, old_io_policy_) !=
+          0) {
+    PLOG(WARNING) << "setiopolicy_np";
+  }
+  if (was_background_ &&
+      setpriority(PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG) != 0) {
+    PLOG(WARNING) << "setpriority";
+  }
+}
+
+#elif defined(OS_WIN)
+
+// Windows has no per-thread I/O priority above normal, so only the scheduling
+// priority is raised.
+ScopedRaisedThreadPriority::ScopedRaisedThreadPriority()
+    : old_priority_(THREAD_PRIORITY_ERROR_RETURN), was_background_(false) {
+  // There’s no way to ask whether a thread is in background mode other than to
+  // try to take it out.
+  if (SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END)) {
+    was_background_ = true;
+  } else if (GetLastError() != ERROR_THREAD_MODE_NOT_BACKGROUND) {
+    PLOG(WARNING) << "SetThreadPriority";
+  }
+
+  old_priority_ = GetThreadPriority(GetCurrentThread());
+  if (old_priority_ == THREAD_PRIORITY_ERROR_RETURN) {
+    PLOG(WARNING) << "GetThreadPriority";
+  } else if (old_priority_ < THREAD_PRIORITY_HIGHEST &&
+             !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST)) {
+    PLOG(WARNING) << "SetThreadPriority";
+    old_priority_ = THREAD_PRIORITY_ERROR_RETURN;
+  }
+}
+
+ScopedRaisedThreadPriority::~ScopedRaisedThreadPriority() {
+  if (old_priority_ != THREAD_PRIORITY_ERROR_RETURN &&
+      old_priority_ < THREAD_PRIORITY_HIGHEST &&
+      !SetThreadPriority(GetCurrentThread(), old_priority_)) {
+    PLOG(WARNING) << "SetThreadPriority";
+  }
+  if (was_background_ &&
+      !SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN)) {
+    PLOG(WARNING) << "SetThreadPriority";
+  }
+}
+
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+
+ScopedRaisedThreadPriority::ScopedRaisedThreadPriority()
+    : old_nice_(0), old_io_priority_(-1), nice_raised_(false) {
+  // getpriority() can legitimately return -1, so errno distinguishes failure.
+  errno = 0;
+  int nice = getpriority(PRIO_PROCESS, CurrentThread());
+  if (nice == -1 && errno != 0) {
+    PLOG(WARNING) << "getpriority";
+  } else if (nice > kCaptureNice) {
+    if (setpriority(PRIO_PROCESS, CurrentThread(), kCaptureNice) == 0) {
+      old_nice_ = nice;
+      nice_raised_ = true;
+    } else if (!IsPermissionError(errno)) {
+      PLOG(WARNING) << "setpriority";
+    }
+  }
+
+  // A thread in the real-time class is already ahead of the best-effort class.
+  // Within best-effort, level 0 is the highest, and any thread may ask for it.
+  // An I/O priority of 0 means that none was set, and is restored as such.
+  int io_priority = GetIOPriority();
+  if (io_priority < 0) {
+    PLOG(WARNING) << "ioprio_get";
+  } else if (io_priority >> kIOPrioClassShift != kIOPrioClassRT &&
+             io_priority != IOPrioValue(kIOPrioClassBE, 0)) {
+    if (SetIOPriority(IOPrioValue(kIOPrioClassBE, 0))) {
+      old_io_priority_ = io_priority;
+    } else if (!IsPermissionError(errno)) {
+      PLOG(WARNING) << "ioprio_set";
+    }
+  }
+}
+
+ScopedRaisedThreadPriority::~ScopedRaisedThreadPriority() {
+  // Lowering a thread’s priority back to where it was never needs privilege.
+  if (nice_raised_ &&
+      setpriority(PRIO_PROCESS, CurrentThread(), old_nice_) != 0) {
+    PLOG(WARNING) << "setpriority";
+  }
+  if (old_io_priority_ >= 0 && !SetIOPriority(old_io_priority_)) {
+    PLOG(WARNING) << "ioprio_set";
+  }
+}
+
+#endif  // OS_MACOSX
+
+}  // namespace crashpad
@@ -0,0 +1,71 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_THREAD_THREAD_PRIORITY_H_
+#define CRASHPAD_UTIL_THREAD_THREAD_PRIORITY_H_
+
+#include "base/macros.h"
+#include "build/build_config.h"
+
+namespace crashpad {
+
+//! \brief Lowers the calling thread’s scheduling priority and I/O priority as
+//!     far as they will go.
+//!
+//! This is intended for threads doing work that nobody is waiting for, such as
+//! compressing, uploading, and pruning reports, which should never compete with
+//! the user’s foreground applications.
+//!
+//! On Linux and Android, an unprivileged thread can’t raise its scheduling
+//! priority once it has been lowered, so this is only appropriate for threads
+//! that will only ever do such work. Elsewhere, a ScopedRaisedThreadPriority
+//! can later undo it for a time. Calling it again has no further effect.
+void LowerThreadPriority();
+
+//! \brief Raises the calling thread’s scheduling priority and I/O priority for
+//!     the lifetime of the object, and then restores them.
+//!
+//! This is intended for capturing a crash, while the crashing process is
+//! suspended waiting for the capture to finish.
+//!
+//! The priority is raised as far as the thread is permitted to raise it, which
+//! without privileges may not be at all. Failures for lack of privilege aren’t
+//! logged. On macOS and Windows, this also takes a thread out of the
+//! background mode that LowerThreadPriority() puts it in.
+class ScopedRaisedThreadPriority {
+ public:
+  ScopedRaisedThreadPriority();
+  ~ScopedRaisedThreadPriority();
+
+ private:
+#if defined(OS_MACOSX)
+  int old_importance_;
+  int old_io_policy_;
+  bool importance_raised_;
+  bool was_background_;
+#elif defined(OS_WIN)
+  int old_priority_;
+  bool was_background_;
+#elif defined(OS_LINUX) || defined(OS_ANDROID)
+  int old_nice_;
+  int old_io_priority_;
+  bool nice_raised_;
+#endif  // OS_MACOSX
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedRaisedThreadPriority);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_THREAD_THREAD_PRIORITY_H_
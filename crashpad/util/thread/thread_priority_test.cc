@@ -0,0 +1,132 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/thread/thread_priority.h"
+
+#include "base/macros.h"
+#include "build/build_config.h"
+#include "gtest/gtest.h"
+#include "util/thread/thread.h"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // OS_LINUX || OS_ANDROID
+
+namespace crashpad {
+namespace test {
+namespace {
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+
+struct Priority {
+  int nice;
+  int io_priority;
+};
+
+Priority GetPriority() {
+  pid_t tid = syscall(SYS_gettid);
+  Priority priority;
+  errno = 0;
+  priority.nice = getpriority(PRIO_PROCESS, tid);
+  EXPECT_EQ(errno, 0);
+  priority.io_priority = syscall(SYS_ioprio_get, 1, tid);
+  EXPECT_GE(priority.io_priority, 0);
+  return priority;
+}
+
+#endif  // OS_LINUX || OS_ANDROID
+
+// Runs the test on a thread of its own, so that the test’s thread keeps its
+// priority.
+class PriorityThread : public Thread {
+ public:
+  explicit PriorityThread(void (*test)()) : test_(test) {}
+  ~PriorityThread() override {}
+
+ private:
+  void ThreadMain() override { test_(); }
+
+  void (*test_)();
+
+  DISALLOW_COPY_AND_ASSIGN(PriorityThread);
+};
+
+void RunOnThread(void (*test)()) {
+  PriorityThread thread(test);
+  thread.Start();
+  thread.Join();
+}
+
+void TestLower() {
+  LowerThreadPriority();
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  Priority priority = GetPriority();
+  EXPECT_EQ(priority.nice, 19);
+  EXPECT_EQ(priority.io_priority >> 13, 3);  // IOPRIO_CLASS_IDLE
+#endif  // OS_LINUX || OS_ANDROID
+
+  // Doing it again is harmless.
+  LowerThreadPriority();
+}
+
+TEST(ThreadPriority, Lower) {
+  RunOnThread(TestLower);
+}
+
+void TestRaise() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  Priority before = GetPriority();
+#endif  // OS_LINUX || OS_ANDROID
+
+  {
+    ScopedRaisedThreadPriority raise;
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    // The nice value can only be lowered with privilege, but the I/O priority
+    // can always be raised to the top of the best-effort class.
+    Priority during = GetPriority();
+    EXPECT_LE(during.nice, before.nice);
+    if (before.io_priority >> 13 != 1) {  // IOPRIO_CLASS_RT
+      EXPECT_EQ(during.io_priority, 2 << 13);  // IOPRIO_CLASS_BE, level 0
+    }
+#endif  // OS_LINUX || OS_ANDROID
+  }
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  Priority after = GetPriority();
+  EXPECT_EQ(after.nice, before.nice);
+  EXPECT_EQ(after.io_priority, before.io_priority);
+#endif  // OS_LINUX || OS_ANDROID
+}
+
+TEST(ThreadPriority, Raise) {
+  RunOnThread(TestRaise);
+}
+
+void TestRaiseLowered() {
+  LowerThreadPriority();
+  TestRaise();
+}
+
+TEST(ThreadPriority, RaiseLowered) {
+  RunOnThread(TestRaiseLowered);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
@@ -14,8 +14,11 @@
 
 #include "util/thread/worker_thread.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "util/thread/thread.h"
+#include "util/thread/worker_thread_executor.h"
 
 namespace crashpad {
 
@@ -34,8 +37,10 @@ class WorkerThreadImpl final : public Thread {
       semaphore_.TimedWait(initial_work_delay_);
 
     while (self_->running_) {
+      self_->work_now_pending_ = false;
+      self_->next_work_delay_ = self_->work_interval_;
       self_->delegate_->DoWork(self_);
-      semaphore_.TimedWait(self_->work_interval_);
+      semaphore_.TimedWait(self_->next_work_delay_);
     }
   }
 
@@ -54,9 +59,17 @@ class WorkerThreadImpl final : public Thread {
 
 WorkerThread::WorkerThread(double work_interval,
                            WorkerThread::Delegate* delegate)
+    : WorkerThread(work_interval, delegate, nullptr) {}
+
+WorkerThread::WorkerThread(double work_interval,
+                           WorkerThread::Delegate* delegate,
+                           WorkerThreadExecutor* executor)
     : work_interval_(work_interval),
+      next_work_delay_(work_interval),
       delegate_(delegate),
+      executor_(executor),
       impl_(),
+      work_now_pending_(false),
       running_(false) {}
 
 WorkerThread::~WorkerThread() {
@@ -66,21 +79,32 @@ WorkerThread::~WorkerThread() {
 void WorkerThread::Start(double initial_work_delay) {
   DCHECK(!impl_);
   DCHECK(!running_);
+  work_now_pending_ = false;
 
   running_ = true;
+  if (executor_) {
+    executor_->AddWorker(this, initial_work_delay);
+    return;
+  }
+
   impl_.reset(new internal::WorkerThreadImpl(this, initial_work_delay));
   impl_->Start();
 }
 
 void WorkerThread::Stop() {
   DCHECK(running_);
-  DCHECK(impl_);
+  DCHECK(impl_ || executor_);
 
   if (!running_)
     return;
 
   running_ = false;
 
+  if (executor_) {
+    executor_->RemoveWorker(this);
+    return;
+  }
+
   impl_->SignalSemaphore();
   impl_->Join();
   impl_.reset();
@@ -88,7 +112,25 @@ void WorkerThread::Stop() {
 
 void WorkerThread::DoWorkNow() {
   DCHECK(running_);
-  impl_->SignalSemaphore();
+  if (executor_) {
+    executor_->DoWorkNow(this);
+    return;
+  }
+
+  // A signal already pending wakes the thread for this request too.
+  if (!work_now_pending_.exchange(true)) {
+    impl_->SignalSemaphore();
+  }
+}
+
+void WorkerThread::SetNextWorkDelay(double delay) {
+  DCHECK_GE(delay, 0.0);
+  next_work_delay_ = std::min(next_work_delay_, delay);
+}
+
+void WorkerThread::SetWorkInterval(double work_interval) {
+  work_interval_ = work_interval;
+  next_work_delay_ = work_interval;
 }
 
 }  // namespace crashpad
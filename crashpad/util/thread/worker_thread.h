@@ -15,6 +15,7 @@
 #ifndef CRASHPAD_UTIL_THREAD_WORKER_THREAD_H_
 #define CRASHPAD_UTIL_THREAD_WORKER_THREAD_H_
 
+#include <atomic>
 #include <memory>
 
 #include "base/macros.h"
@@ -26,6 +27,8 @@ namespace internal {
 class WorkerThreadImpl;
 }  // namespace internal
 
+class WorkerThreadExecutor;
+
 //! \brief A WorkerThread executes its Delegate's DoWork method repeatedly on a
 //!     dedicated thread at a set time interval.
 class WorkerThread {
@@ -53,6 +56,22 @@ class WorkerThread {
   //!     called.
   //! \param[in] delegate The work delegate to invoke every interval.
   WorkerThread(double work_interval, Delegate* delegate);
+
+  //! \brief Creates a new WorkerThread that runs its \a delegate on the
+  //!     threads of \a executor, instead of on a dedicated thread.
+  //!
+  //! Apart from where the \a delegate runs, the object behaves exactly as one
+  //! with a dedicated thread. Stop() waits for an invocation of the \a
+  //! delegate in progress to return, instead of joining a thread.
+  //!
+  //! \param[in] work_interval See the other constructor.
+  //! \param[in] delegate See the other constructor.
+  //! \param[in] executor The executor to run \a delegate on. Weak. `nullptr`
+  //!     to use a dedicated thread. It must outlive this object.
+  WorkerThread(double work_interval,
+               Delegate* delegate,
+               WorkerThreadExecutor* executor);
+
   ~WorkerThread();
 
   //! \brief Starts the worker thread.
@@ -80,17 +99,58 @@ class WorkerThread {
   //!     waiting for the current \a work_interval to expire. After the
   //!     delegate is invoked, the WorkerThread will start waiting for a new
   //!     \a work_interval.
+  //!
+  //! Calls made before the delegate next starts running are coalesced, so
+  //! that they cause a single invocation.
   void DoWorkNow();
 
+  //! \brief Shortens the wait that follows the current invocation of
+  //!     Delegate::DoWork().
+  //!
+  //! This allows a delegate with work due at a known time to be invoked then,
+  //! without shortening the \a work_interval for every invocation. The next
+  //! invocation happens after \a delay or the \a work_interval, whichever is
+  //! shorter, or sooner if DoWorkNow() is called. The wait after that is the
+  //! \a work_interval again, unless this method is called again.
+  //!
+  //! This may only be called from within Delegate::DoWork(), on the worker
+  //! thread.
+  //!
+  //! \param[in] delay The longest time in seconds to wait before invoking the
+  //!     delegate again.
+  void SetNextWorkDelay(double delay);
+
+  //! \brief Replaces the \a work_interval passed to the constructor.
+  //!
+  //! This allows a delegate to choose its interval once it has done some
+  //! work, such as after determining whether it will be notified of new work
+  //! by other means. The new interval applies from the wait that follows the
+  //! current invocation of Delegate::DoWork(), replacing any shorter delay
+  //! requested earlier in the invocation by SetNextWorkDelay().
+  //!
+  //! This may only be called from within Delegate::DoWork(), on the worker
+  //! thread.
+  //!
+  //! \param[in] work_interval The new time interval in seconds at which the
+  //!     delegate runs. This can be #kIndefiniteWait.
+  void SetWorkInterval(double work_interval);
+
   //! \return `true` if the thread is running, `false` if it is not.
   bool is_running() const { return running_; }
 
  private:
   friend class internal::WorkerThreadImpl;
+  friend class WorkerThreadExecutor;
 
   double work_interval_;
+  double next_work_delay_;
   Delegate* delegate_;  // weak
+  WorkerThreadExecutor* executor_;  // weak
   std::unique_ptr<internal::WorkerThreadImpl> impl_;
+
+  // Set by DoWorkNow() until the dedicated thread next invokes the delegate.
+  std::atomic<bool> work_now_pending_;
+
   bool running_;
 
   DISALLOW_COPY_AND_ASSIGN(WorkerThread);
@@ -0,0 +1,289 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/thread/worker_thread_executor.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "util/misc/clock.h"
+#include "util/thread/thread.h"
+#include "util/thread/worker_thread.h"
+
+namespace crashpad {
+
+namespace {
+
+constexpr double kNanosecondsPerSecond = 1E9;
+
+// Delays longer than this are treated as indefinite, which keeps due times
+// from overflowing.
+constexpr double kMaxDelaySeconds = 60.0 * 60 * 24 * 365 * 100;
+
+}  // namespace
+
+struct WorkerThreadExecutor::Worker {
+  explicit Worker(WorkerThread* thread)
+      : thread(thread),
+        timer(),
+        removed(nullptr),
+        timer_set(false),
+        ready(false),
+        running(false),
+        work_now(false) {}
+
+  WorkerThread* thread;  // weak
+
+  // The worker’s entry in timers_, valid when timer_set is true.
+  std::multimap<uint64_t, Worker*>::iterator timer;
+
+  // Set by RemoveWorker() while the delegate is running, and signaled once it
+  // returns.
+  Semaphore* removed;  // weak
+
+  bool timer_set;
+  bool ready;
+  bool running;
+
+  // Set when DoWorkNow() is called while the delegate is running, so that it
+  // runs again as soon as it returns.
+  bool work_now;
+};
+
+class WorkerThreadExecutor::ExecutorThread final : public Thread {
+ public:
+  explicit ExecutorThread(WorkerThreadExecutor* executor)
+      : Thread(), executor_(executor) {}
+  ~ExecutorThread() override {}
+
+ private:
+  // Thread:
+  void ThreadMain() override { executor_->RunWorkers(); }
+
+  WorkerThreadExecutor* executor_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(ExecutorThread);
+};
+
+WorkerThreadExecutor::WorkerThreadExecutor(size_t thread_count)
+    : lock_(),
+      workers_(),
+      timers_(),
+      ready_(),
+      running_(false),
+      semaphore_(0),
+      threads_(),
+      thread_count_(thread_count) {
+  DCHECK_GE(thread_count_, 1u);
+}
+
+WorkerThreadExecutor::~WorkerThreadExecutor() {
+  DCHECK(threads_.empty());
+  DCHECK(workers_.empty());
+}
+
+void WorkerThreadExecutor::Start() {
+  DCHECK(threads_.empty());
+
+  {
+    base::AutoLock lock(lock_);
+    running_ = true;
+  }
+
+  for (size_t index = 0; index < thread_count_; ++index) {
+    threads_.push_back(
+        std::unique_ptr<ExecutorThread>(new ExecutorThread(this)));
+    threads_.back()->Start();
+  }
+}
+
+void WorkerThreadExecutor::Stop() {
+  {
+    base::AutoLock lock(lock_);
+    DCHECK(workers_.empty());
+    running_ = false;
+  }
+
+  for (size_t index = 0; index < threads_.size(); ++index) {
+    semaphore_.Signal();
+  }
+  for (const auto& thread : threads_) {
+    thread->Join();
+  }
+  threads_.clear();
+}
+
+void WorkerThreadExecutor::AddWorker(WorkerThread* thread,
+                                     double initial_work_delay) {
+  base::AutoLock lock(lock_);
+
+  std::unique_ptr<Worker>& worker = workers_[thread];
+  DCHECK(!worker);
+  worker.reset(new Worker(thread));
+
+  if (initial_work_delay > 0) {
+    ScheduleLocked(worker.get(), initial_work_delay);
+  } else {
+    MakeReadyLocked(worker.get());
+  }
+}
+
+void WorkerThreadExecutor::RemoveWorker(WorkerThread* thread) {
+  Semaphore removed(0);
+  {
+    base::AutoLock lock(lock_);
+
+    auto iterator = workers_.find(thread);
+    DCHECK(iterator != workers_.end());
+    Worker* worker = iterator->second.get();
+
+    CancelTimerLocked(worker);
+    if (worker->ready) {
+      ready_.erase(std::find(ready_.begin(), ready_.end(), worker));
+      worker->ready = false;
+    }
+
+    if (!worker->running) {
+      workers_.erase(iterator);
+      return;
+    }
+
+    worker->removed = &removed;
+  }
+
+  // The delegate is running, and the thread running it signals once it
+  // returns, after which the worker is no longer used there.
+  removed.Wait();
+
+  base::AutoLock lock(lock_);
+  workers_.erase(thread);
+}
+
+void WorkerThreadExecutor::DoWorkNow(WorkerThread* thread) {
+  base::AutoLock lock(lock_);
+
+  // A request racing with Stop() is dropped.
+  auto iterator = workers_.find(thread);
+  if (iterator != workers_.end()) {
+    MakeReadyLocked(iterator->second.get());
+  }
+}
+
+void WorkerThreadExecutor::RunWorkers() {
+  for (;;) {
+    Worker* worker = nullptr;
+    double wait = Semaphore::kIndefiniteWait;
+    {
+      base::AutoLock lock(lock_);
+      if (!running_) {
+        return;
+      }
+
+      const uint64_t now = ClockMonotonicNanoseconds();
+      while (!timers_.empty() && timers_.begin()->first <= now) {
+        Worker* due = timers_.begin()->second;
+        CancelTimerLocked(due);
+        due->ready = true;
+        ready_.push_back(due);
+      }
+
+      if (!ready_.empty()) {
+        worker = ready_.front();
+        ready_.pop_front();
+        worker->ready = false;
+        worker->running = true;
+        worker->work_now = false;
+
+        // Let another thread take any other worker that is due.
+        if (!ready_.empty()) {
+          semaphore_.Signal();
+        }
+      } else if (!timers_.empty()) {
+        wait = (timers_.begin()->first - now) / kNanosecondsPerSecond;
+      }
+    }
+
+    if (!worker) {
+      semaphore_.TimedWait(wait);
+      continue;
+    }
+
+    WorkerThread* thread = worker->thread;
+    thread->next_work_delay_ = thread->work_interval_;
+    thread->delegate_->DoWork(thread);
+
+    base::AutoLock lock(lock_);
+    worker->running = false;
+    if (worker->removed) {
+      worker->removed->Signal();
+    } else if (worker->work_now) {
+      MakeReadyLocked(worker);
+    } else {
+      ScheduleLocked(worker, thread->next_work_delay_);
+    }
+  }
+}
+
+void WorkerThreadExecutor::ScheduleLocked(Worker* worker, double delay) {
+  lock_.AssertAcquired();
+  DCHECK(!worker->ready);
+  DCHECK(!worker->running);
+
+  CancelTimerLocked(worker);
+  if (isinf(delay) || delay >= kMaxDelaySeconds) {
+    return;
+  }
+
+  const uint64_t due = ClockMonotonicNanoseconds() +
+                       static_cast<uint64_t>(std::max(delay, 0.0) *
+                                             kNanosecondsPerSecond);
+  worker->timer = timers_.insert(std::make_pair(due, worker));
+  worker->timer_set = true;
+
+  // A thread may be sleeping until a later time.
+  if (worker->timer == timers_.begin()) {
+    semaphore_.Signal();
+  }
+}
+
+void WorkerThreadExecutor::MakeReadyLocked(Worker* worker) {
+  lock_.AssertAcquired();
+
+  if (worker->ready) {
+    // Already due to run, which this request is coalesced into.
+    return;
+  }
+  if (worker->running) {
+    worker->work_now = true;
+    return;
+  }
+
+  CancelTimerLocked(worker);
+  worker->ready = true;
+  ready_.push_back(worker);
+  semaphore_.Signal();
+}
+
+void WorkerThreadExecutor::CancelTimerLocked(Worker* worker) {
+  lock_.AssertAcquired();
+
+  if (worker->timer_set) {
+    timers_.erase(worker->timer);
+    worker->timer_set = false;
+  }
+}
+
+}  // namespace crashpad
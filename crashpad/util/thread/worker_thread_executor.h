@@ -0,0 +1,136 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_THREAD_WORKER_THREAD_EXECUTOR_H_
+#define CRASHPAD_UTIL_THREAD_WORKER_THREAD_EXECUTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "util/synchronization/semaphore.h"
+
+namespace crashpad {
+
+class WorkerThread;
+
+//! \brief Runs the delegates of many WorkerThread objects on a small, shared
+//!     set of threads.
+//!
+//! A WorkerThread constructed with an executor doesn’t have a thread of its
+//! own. Instead, its Delegate::DoWork() is invoked on one of the executor’s
+//! threads when it is due, exactly as it would be on a dedicated thread. The
+//! delegate of any one WorkerThread is never invoked on more than one thread
+//! at a time, but delegates of different WorkerThread objects may run
+//! concurrently, on different threads of the executor.
+//!
+//! The executor’s threads sleep until the earliest time that a delegate is
+//! due, or until WorkerThread::DoWorkNow() is called, so that idle delegates
+//! cause no wakeups. Calls to WorkerThread::DoWorkNow() made before the
+//! delegate has started running are coalesced into a single invocation.
+//!
+//! A delegate that runs for a long time occupies one of the executor’s
+//! threads throughout, delaying others that come due while all threads are
+//! occupied. Delegates that must run promptly should be given an executor
+//! with enough threads, or a dedicated WorkerThread.
+class WorkerThreadExecutor {
+ public:
+  //! \param[in] thread_count The number of threads to run delegates on. This
+  //!     must be at least `1`.
+  explicit WorkerThreadExecutor(size_t thread_count);
+  ~WorkerThreadExecutor();
+
+  //! \brief Starts the executor’s threads.
+  //!
+  //! WorkerThread objects using this executor may be started before or after
+  //! this method is called, but their delegates are not invoked until it has
+  //! been.
+  //!
+  //! This method may only be be called on a newly-constructed object or after
+  //! a call to Stop().
+  void Start();
+
+  //! \brief Stops the executor’s threads, and waits for them to exit.
+  //!
+  //! Every WorkerThread using this executor must be stopped before this method
+  //! is called.
+  void Stop();
+
+ private:
+  friend class WorkerThread;
+
+  class ExecutorThread;
+  struct Worker;
+
+  //! \brief Begins invoking the delegate of \a thread after \a
+  //!     initial_work_delay, on behalf of WorkerThread::Start().
+  void AddWorker(WorkerThread* thread, double initial_work_delay);
+
+  //! \brief Stops invoking the delegate of \a thread, on behalf of
+  //!     WorkerThread::Stop(). If the delegate is running, this waits for it
+  //!     to return.
+  void RemoveWorker(WorkerThread* thread);
+
+  //! \brief Invokes the delegate of \a thread as soon as possible, on behalf
+  //!     of WorkerThread::DoWorkNow().
+  void DoWorkNow(WorkerThread* thread);
+
+  //! \brief The main function of each of the executor’s threads.
+  void RunWorkers();
+
+  //! \brief Arranges for \a worker to run after \a delay seconds. lock_ must be
+  //!     held.
+  void ScheduleLocked(Worker* worker, double delay);
+
+  //! \brief Arranges for \a worker to run as soon as possible. lock_ must be
+  //!     held.
+  void MakeReadyLocked(Worker* worker);
+
+  //! \brief Removes \a worker from timers_, if it is there. lock_ must be
+  //!     held.
+  void CancelTimerLocked(Worker* worker);
+
+  base::Lock lock_;
+
+  // All of the following members are guarded by lock_.
+  std::map<WorkerThread*, std::unique_ptr<Worker>> workers_;
+
+  // Workers waiting to run, ordered by the ClockMonotonicNanoseconds() time
+  // that each is due.
+  std::multimap<uint64_t, Worker*> timers_;
+
+  // Workers that are due, in the order that they became due.
+  std::deque<Worker*> ready_;
+
+  bool running_;
+
+  // Signaled when ready_ gains a worker or the earliest timer changes, to wake
+  // a thread to run it or to recompute how long to sleep.
+  Semaphore semaphore_;
+
+  std::vector<std::unique_ptr<ExecutorThread>> threads_;
+  const size_t thread_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkerThreadExecutor);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_THREAD_WORKER_THREAD_EXECUTOR_H_
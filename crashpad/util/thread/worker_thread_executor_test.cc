@@ -0,0 +1,183 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/thread/worker_thread_executor.h"
+
+#include <atomic>
+
+#include "base/macros.h"
+#include "gtest/gtest.h"
+#include "util/misc/clock.h"
+#include "util/synchronization/semaphore.h"
+#include "util/thread/worker_thread.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+constexpr uint64_t kNanosecondsPerSecond = static_cast<uint64_t>(1E9);
+
+class WorkDelegate : public WorkerThread::Delegate {
+ public:
+  WorkDelegate() {}
+  ~WorkDelegate() {}
+
+  void DoWork(const WorkerThread* thread) override {
+    if (++work_count_ == waiting_for_count_) {
+      semaphore_.Signal();
+    }
+  }
+
+  void SetDesiredWorkCount(int times) { waiting_for_count_ = times; }
+
+  //! \brief Suspends the calling thread until the DoWork() has been called
+  //!     the number of times specified by SetDesiredWorkCount().
+  void WaitForWorkCount() { semaphore_.Wait(); }
+
+  int work_count() const { return work_count_; }
+
+ private:
+  Semaphore semaphore_{0};
+  std::atomic<int> work_count_{0};
+  std::atomic<int> waiting_for_count_{-1};
+
+  DISALLOW_COPY_AND_ASSIGN(WorkDelegate);
+};
+
+TEST(WorkerThreadExecutor, SharedThread) {
+  WorkerThreadExecutor executor(1);
+  executor.Start();
+
+  WorkDelegate delegates[3];
+  WorkerThread thread_0(0.05, &delegates[0], &executor);
+  WorkerThread thread_1(0.05, &delegates[1], &executor);
+  WorkerThread thread_2(100, &delegates[2], &executor);
+  WorkerThread* threads[] = {&thread_0, &thread_1, &thread_2};
+
+  uint64_t start = ClockMonotonicNanoseconds();
+
+  delegates[0].SetDesiredWorkCount(2);
+  delegates[1].SetDesiredWorkCount(2);
+  delegates[2].SetDesiredWorkCount(1);
+  for (WorkerThread* thread : threads) {
+    thread->Start(0);
+    EXPECT_TRUE(thread->is_running());
+  }
+
+  for (WorkDelegate& delegate : delegates) {
+    delegate.WaitForWorkCount();
+  }
+
+  delegates[2].SetDesiredWorkCount(2);
+  thread_2.DoWorkNow();
+  delegates[2].WaitForWorkCount();
+
+  for (WorkerThread* thread : threads) {
+    thread->Stop();
+    EXPECT_FALSE(thread->is_running());
+  }
+  executor.Stop();
+
+  EXPECT_GE(100 * kNanosecondsPerSecond, ClockMonotonicNanoseconds() - start);
+}
+
+TEST(WorkerThreadExecutor, StopBeforeDoWork) {
+  WorkerThreadExecutor executor(2);
+  executor.Start();
+
+  WorkDelegate delegate;
+  WorkerThread thread(1, &delegate, &executor);
+
+  thread.Start(15);
+  thread.Stop();
+  executor.Stop();
+
+  EXPECT_EQ(delegate.work_count(), 0);
+}
+
+TEST(WorkerThreadExecutor, DoWorkNowCoalesced) {
+  WorkerThreadExecutor executor(1);
+
+  WorkDelegate delegate;
+  WorkerThread thread(100, &delegate, &executor);
+
+  // Requests made before the executor runs the delegate cause one invocation.
+  thread.Start(100);
+  thread.DoWorkNow();
+  thread.DoWorkNow();
+  thread.DoWorkNow();
+
+  delegate.SetDesiredWorkCount(1);
+  executor.Start();
+  delegate.WaitForWorkCount();
+
+  // Give any further invocations a chance to happen.
+  Semaphore(0).TimedWait(0.1);
+  EXPECT_EQ(delegate.work_count(), 1);
+
+  thread.Stop();
+  executor.Stop();
+}
+
+// Blocks in DoWork() until released, to test stopping a running delegate.
+class BlockingDelegate : public WorkerThread::Delegate {
+ public:
+  BlockingDelegate() {}
+  ~BlockingDelegate() {}
+
+  void DoWork(const WorkerThread* thread) override {
+    started_.Signal();
+    release_.Wait();
+    returned_ = true;
+  }
+
+  void WaitForStart() { started_.Wait(); }
+  void Release() { release_.Signal(); }
+  bool returned() const { return returned_; }
+
+ private:
+  Semaphore started_{0};
+  Semaphore release_{0};
+  std::atomic<bool> returned_{false};
+
+  DISALLOW_COPY_AND_ASSIGN(BlockingDelegate);
+};
+
+TEST(WorkerThreadExecutor, StopWaitsForDoWork) {
+  WorkerThreadExecutor executor(2);
+  executor.Start();
+
+  BlockingDelegate blocking_delegate;
+  WorkerThread blocking_thread(100, &blocking_delegate, &executor);
+  blocking_thread.Start(0);
+  blocking_delegate.WaitForStart();
+
+  // Other delegates still run on the executor’s other thread.
+  WorkDelegate delegate;
+  WorkerThread thread(100, &delegate, &executor);
+  delegate.SetDesiredWorkCount(1);
+  thread.Start(0);
+  delegate.WaitForWorkCount();
+  thread.Stop();
+
+  blocking_delegate.Release();
+  blocking_thread.Stop();
+  EXPECT_TRUE(blocking_delegate.returned());
+
+  executor.Stop();
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
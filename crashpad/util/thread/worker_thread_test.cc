@@ -125,6 +125,86 @@ TEST(WorkerThread, DoWorkNow) {
   EXPECT_GE(100 * kNanosecondsPerSecond, ClockMonotonicNanoseconds() - start);
 }
 
+// Asks for the second invocation to come sooner than the work interval.
+class NextWorkDelayDelegate : public WorkerThread::Delegate {
+ public:
+  NextWorkDelayDelegate() {}
+  ~NextWorkDelayDelegate() {}
+
+  void set_thread(WorkerThread* thread) { thread_ = thread; }
+
+  void DoWork(const WorkerThread* thread) override {
+    if (++work_count_ == 1) {
+      thread_->SetNextWorkDelay(0.05);
+    } else if (work_count_ == 2) {
+      semaphore_.Signal();
+    }
+  }
+
+  void WaitForSecondWork() { semaphore_.Wait(); }
+
+ private:
+  Semaphore semaphore_{0};
+  WorkerThread* thread_ = nullptr;  // weak
+  int work_count_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(NextWorkDelayDelegate);
+};
+
+TEST(WorkerThread, SetNextWorkDelay) {
+  NextWorkDelayDelegate delegate;
+  WorkerThread thread(100, &delegate);
+  delegate.set_thread(&thread);
+
+  uint64_t start = ClockMonotonicNanoseconds();
+
+  thread.Start(0);
+  delegate.WaitForSecondWork();
+  thread.Stop();
+
+  EXPECT_GE(100 * kNanosecondsPerSecond, ClockMonotonicNanoseconds() - start);
+}
+
+class WorkIntervalDelegate : public WorkerThread::Delegate {
+ public:
+  WorkIntervalDelegate() {}
+  ~WorkIntervalDelegate() {}
+
+  void set_thread(WorkerThread* thread) { thread_ = thread; }
+
+  void DoWork(const WorkerThread* thread) override {
+    if (++work_count_ == 1) {
+      thread_->SetWorkInterval(0.05);
+    } else if (work_count_ == 3) {
+      semaphore_.Signal();
+    }
+  }
+
+  void WaitForThirdWork() { semaphore_.Wait(); }
+
+ private:
+  Semaphore semaphore_{0};
+  WorkerThread* thread_ = nullptr;  // weak
+  int work_count_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkIntervalDelegate);
+};
+
+TEST(WorkerThread, SetWorkInterval) {
+  WorkIntervalDelegate delegate;
+  WorkerThread thread(100, &delegate);
+  delegate.set_thread(&thread);
+
+  uint64_t start = ClockMonotonicNanoseconds();
+
+  // Unlike SetNextWorkDelay(), the new interval persists beyond the next wait.
+  thread.Start(0);
+  delegate.WaitForThirdWork();
+  thread.Stop();
+
+  EXPECT_GE(100 * kNanosecondsPerSecond, ClockMonotonicNanoseconds() - start);
+}
+
 TEST(WorkerThread, DoWorkNowAtStart) {
   WorkDelegate delegate;
   WorkerThread thread(100, &delegate);
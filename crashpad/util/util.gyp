@@ -30,8 +30,21 @@
         '<(INTERMEDIATE_DIR)',
       ],
       'sources': [
+        'file/block_compressed_file_format.h',
+        'file/block_compressed_file_reader.cc',
+        'file/block_compressed_file_reader.h',
+        'file/block_compressed_file_writer.cc',
+        'file/block_compressed_file_writer.h',
+        'file/buffered_file_writer.cc',
+        'file/buffered_file_writer.h',
+        'file/chunked_buffer_file.cc',
+        'file/chunked_buffer_file.h',
         'file/delimited_file_reader.cc',
         'file/delimited_file_reader.h',
+        'file/directory_change_watcher.h',
+        'file/directory_change_watcher_linux.cc',
+        'file/directory_change_watcher_mac.cc',
+        'file/directory_change_watcher_win.cc',
         'file/file_io.cc',
         'file/file_io.h',
         'file/file_io_posix.cc',
@@ -42,23 +55,59 @@
         'file/file_seeker.h',
         'file/file_writer.cc',
         'file/file_writer.h',
+        'file/mapped_file_reader.cc',
+        'file/mapped_file_reader.h',
+        'file/mapped_file_reader_posix.cc',
+        'file/mapped_file_reader_win.cc',
+        'file/page_store.cc',
+        'file/page_store.h',
+        'file/page_store_posix.cc',
+        'file/page_store_win.cc',
+        'file/paged_file_format.h',
+        'file/paged_file_reader.cc',
+        'file/paged_file_reader.h',
+        'file/paged_file_writer.cc',
+        'file/paged_file_writer.h',
         'file/string_file.cc',
         'file/string_file.h',
         'linux/address_types.h',
         'linux/auxiliary_vector.cc',
         'linux/auxiliary_vector.h',
         'linux/checked_address_range.h',
+        'linux/copy_on_write_fork.cc',
+        'linux/copy_on_write_fork.h',
         'linux/direct_ptrace_connection.cc',
         'linux/direct_ptrace_connection.h',
+        'linux/exception_handler_client.cc',
+        'linux/exception_handler_client.h',
+        'linux/exception_handler_protocol.cc',
+        'linux/exception_handler_protocol.h',
+        'linux/io_uring_reader.cc',
+        'linux/io_uring_reader.h',
         'linux/memory_map.cc',
         'linux/memory_map.h',
+        'linux/module_file_memory.cc',
+        'linux/module_file_memory.h',
+        'linux/page_map.cc',
+        'linux/page_map.h',
+        'linux/proc_directory.cc',
+        'linux/proc_directory.h',
         'linux/proc_stat_reader.cc',
         'linux/proc_stat_reader.h',
+        'linux/process_recording.cc',
+        'linux/process_recording.h',
+        'linux/ptrace_connection.cc',
         'linux/ptrace_connection.h',
         'linux/ptracer.cc',
         'linux/ptracer.h',
+        'linux/recording_ptrace_connection.cc',
+        'linux/recording_ptrace_connection.h',
         'linux/scoped_ptrace_attach.cc',
         'linux/scoped_ptrace_attach.h',
+        'linux/seize_ptrace_connection.cc',
+        'linux/seize_ptrace_connection.h',
+        'linux/threaded_ptrace_connection.cc',
+        'linux/threaded_ptrace_connection.h',
         'linux/thread_info.cc',
         'linux/thread_info.h',
         'linux/traits.h',
@@ -119,6 +168,16 @@
         'misc/initialization_state_dcheck.h',
         'misc/lexing.cc',
         'misc/lexing.h',
+        'misc/memory_read_trace.cc',
+        'misc/memory_read_trace.h',
+        'misc/memory_reserve.cc',
+        'misc/memory_reserve.h',
+        'misc/memory_reserve_posix.cc',
+        'misc/memory_reserve_win.cc',
+        'misc/memory_trim.h',
+        'misc/memory_trim_linux.cc',
+        'misc/memory_trim_mac.cc',
+        'misc/memory_trim_win.cc',
         'misc/metrics.cc',
         'misc/metrics.h',
         'misc/paths.h',
@@ -134,23 +193,48 @@
         'misc/scoped_forbid_return.cc',
         'misc/scoped_forbid_return.h',
         'misc/symbolic_constants_common.h',
+        'misc/system_resources.h',
+        'misc/system_resources_linux.cc',
+        'misc/system_resources_mac.cc',
+        'misc/system_resources_posix.cc',
+        'misc/system_resources_win.cc',
+        'misc/trace_event.cc',
+        'misc/trace_event.h',
+        'misc/trace_event_linux.cc',
+        'misc/trace_event_mac.cc',
+        'misc/trace_event_win.cc',
         'misc/tri_state.h',
         'misc/uuid.cc',
         'misc/uuid.h',
+        'misc/xxhash.cc',
+        'misc/xxhash.h',
         'misc/zlib.cc',
         'misc/zlib.h',
         'net/http_body.cc',
         'net/http_body.h',
+        'net/http_body_bandwidth_limit.cc',
+        'net/http_body_bandwidth_limit.h',
+        'net/http_body_compression.cc',
+        'net/http_body_compression.h',
         'net/http_body_gzip.cc',
         'net/http_body_gzip.h',
+        'net/http_body_pipe.cc',
+        'net/http_body_pipe.h',
         'net/http_headers.h',
         'net/http_multipart_builder.cc',
         'net/http_multipart_builder.h',
+        'net/http_retry_after.cc',
+        'net/http_retry_after.h',
         'net/http_transport.cc',
         'net/http_transport.h',
         'net/http_transport_libcurl.cc',
         'net/http_transport_mac.mm',
         'net/http_transport_win.cc',
+        'net/network_reachability_watcher.cc',
+        'net/network_reachability_watcher.h',
+        'net/network_reachability_watcher_linux.cc',
+        'net/network_reachability_watcher_mac.cc',
+        'net/network_reachability_watcher_win.cc',
         'net/url.cc',
         'net/url.h',
         'numeric/checked_address_range.cc',
@@ -179,12 +263,15 @@
         'posix/symbolic_constants_posix.h',
         'process/process_memory.h',
         'process/process_memory.cc',
+        'process/process_memory_cache.cc',
+        'process/process_memory_cache.h',
         'process/process_memory_range.cc',
         'process/process_memory_range.h',
         'stdlib/aligned_allocator.cc',
         'stdlib/aligned_allocator.h',
         'stdlib/cxx.h',
         'stdlib/map_insert.h',
+        'stdlib/object_array.h',
         'stdlib/objc.h',
         'stdlib/pointer_container.h',
         'stdlib/string_number_conversion.cc',
@@ -196,18 +283,27 @@
         'stdlib/thread_safe_vector.h',
         'string/split_string.cc',
         'string/split_string.h',
+        'string/utf_conversion.cc',
+        'string/utf_conversion.h',
+        'synchronization/priority_semaphore.cc',
+        'synchronization/priority_semaphore.h',
         'synchronization/semaphore_mac.cc',
         'synchronization/semaphore_posix.cc',
         'synchronization/semaphore_win.cc',
         'synchronization/semaphore.h',
+        'thread/mpsc_queue.h',
         'thread/thread.cc',
         'thread/thread.h',
         'thread/thread_log_messages.cc',
         'thread/thread_log_messages.h',
         'thread/thread_posix.cc',
+        'thread/thread_priority.cc',
+        'thread/thread_priority.h',
         'thread/thread_win.cc',
         'thread/worker_thread.cc',
         'thread/worker_thread.h',
+        'thread/worker_thread_executor.cc',
+        'thread/worker_thread_executor.h',
         'win/address_types.h',
         'win/capture_context.asm',
         'win/capture_context.h',
@@ -243,6 +339,8 @@
         'win/scoped_handle.h',
         'win/scoped_local_alloc.cc',
         'win/scoped_local_alloc.h',
+        'win/scoped_process_clone.cc',
+        'win/scoped_process_clone.h',
         'win/scoped_process_suspend.cc',
         'win/scoped_process_suspend.h',
         'win/session_end_watcher.cc',
@@ -321,6 +419,7 @@
         ['OS=="win"', {
           'link_settings': {
             'libraries': [
+              '-liphlpapi.lib',
               '-luser32.lib',
               '-lversion.lib',
               '-lwinhttp.lib',
@@ -370,8 +469,13 @@
       'target_conditions': [
         ['OS=="android"', {
           'sources/': [
+            ['include', '^file/directory_change_watcher_linux\\.cc$'],
             ['include', '^linux/'],
+            ['include', '^misc/memory_trim_linux\\.cc$'],
             ['include', '^misc/paths_linux\\.cc$'],
+            ['include', '^misc/system_resources_linux\\.cc$'],
+            ['include', '^misc/trace_event_linux\\.cc$'],
+            ['include', '^net/network_reachability_watcher_linux\\.cc$'],
             ['include', '^posix/process_info_linux\\.cc$'],
           ],
         }],
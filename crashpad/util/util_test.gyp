@@ -35,15 +35,28 @@
         '..',
       ],
       'sources': [
+        'file/block_compressed_file_test.cc',
+        'file/buffered_file_writer_test.cc',
+        'file/chunked_buffer_file_test.cc',
         'file/delimited_file_reader_test.cc',
+        'file/directory_change_watcher_test.cc',
         'file/file_io_test.cc',
         'file/file_reader_test.cc',
+        'file/mapped_file_reader_test.cc',
+        'file/paged_file_test.cc',
         'file/string_file_test.cc',
         'linux/auxiliary_vector_test.cc',
+        'linux/copy_on_write_fork_test.cc',
+        'linux/io_uring_reader_test.cc',
         'linux/memory_map_test.cc',
+        'linux/module_file_memory_test.cc',
+        'linux/page_map_test.cc',
+        'linux/proc_directory_test.cc',
         'linux/proc_stat_reader_test.cc',
+        'linux/process_recording_test.cc',
         'linux/ptracer_test.cc',
         'linux/scoped_ptrace_attach_test.cc',
+        'linux/seize_ptrace_connection_test.cc',
         'mac/launchd_test.mm',
         'mac/mac_util_test.mm',
         'mac/service_management_test.mm',
@@ -68,17 +81,27 @@
         'misc/from_pointer_cast_test.cc',
         'misc/initialization_state_dcheck_test.cc',
         'misc/initialization_state_test.cc',
+        'misc/memory_read_trace_test.cc',
+        'misc/memory_reserve_test.cc',
+        'misc/memory_trim_test.cc',
         'misc/paths_test.cc',
         'misc/scoped_forbid_return_test.cc',
         'misc/random_string_test.cc',
         'misc/reinterpret_bytes_test.cc',
+        'misc/system_resources_test.cc',
+        'misc/trace_event_test.cc',
         'misc/uuid_test.cc',
+        'misc/xxhash_test.cc',
+        'net/http_body_bandwidth_limit_test.cc',
         'net/http_body_gzip_test.cc',
+        'net/http_body_pipe_test.cc',
         'net/http_body_test.cc',
         'net/http_body_test_util.cc',
         'net/http_body_test_util.h',
         'net/http_multipart_builder_test.cc',
+        'net/http_retry_after_test.cc',
         'net/http_transport_test.cc',
+        'net/network_reachability_watcher_test.cc',
         'net/url_test.cc',
         'numeric/checked_address_range_test.cc',
         'numeric/checked_range_test.cc',
@@ -88,18 +111,25 @@
         'posix/scoped_mmap_test.cc',
         'posix/signals_test.cc',
         'posix/symbolic_constants_posix_test.cc',
+        'process/process_memory_cache_test.cc',
         'process/process_memory_range_test.cc',
         'process/process_memory_test.cc',
         'stdlib/aligned_allocator_test.cc',
         'stdlib/map_insert_test.cc',
+        'stdlib/object_array_test.cc',
         'stdlib/string_number_conversion_test.cc',
         'stdlib/strlcpy_test.cc',
         'stdlib/strnlen_test.cc',
         'stdlib/thread_safe_vector_test.cc',
         'string/split_string_test.cc',
+        'string/utf_conversion_test.cc',
+        'synchronization/priority_semaphore_test.cc',
         'synchronization/semaphore_test.cc',
+        'thread/mpsc_queue_test.cc',
         'thread/thread_log_messages_test.cc',
+        'thread/thread_priority_test.cc',
         'thread/thread_test.cc',
+        'thread/worker_thread_executor_test.cc',
         'thread/worker_thread_test.cc',
         'win/capture_context_test.cc',
         'win/command_line_test.cc',
@@ -111,6 +141,7 @@
         'win/process_info_test.cc',
         'win/registration_protocol_win_test.cc',
         'win/safe_terminate_process_test.cc',
+        'win/scoped_process_clone_test.cc',
         'win/scoped_process_suspend_test.cc',
         'win/session_end_watcher_test.cc',
         'win/time_test.cc',
@@ -157,6 +188,24 @@
         }],
       ],
     },
+    {
+      'target_name': 'crashpad_http_benchmark',
+      'type': 'executable',
+      'dependencies': [
+        'util.gyp:crashpad_util',
+        '../compat/compat.gyp:crashpad_compat',
+        '../test/test.gyp:crashpad_test',
+        '../third_party/gtest/gtest.gyp:gtest',
+        '../third_party/mini_chromium/mini_chromium.gyp:base',
+        '../tools/tools.gyp:crashpad_tool_support',
+      ],
+      'include_dirs': [
+        '..',
+      ],
+      'sources': [
+        'net/http_benchmark.cc',
+      ],
+    },
   ],
   'conditions': [
     ['OS=="win"', {
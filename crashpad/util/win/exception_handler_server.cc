@@ -18,11 +18,13 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include <initializer_list>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
-#include "base/rand_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "minidump/minidump_file_writer.h"
@@ -41,6 +43,25 @@ namespace crashpad {
 
 namespace {
 
+// Priorities for ExceptionHandlerServer::dump_semaphore_. Clients that have
+// crashed are waiting to be terminated, so they’re served before clients that
+// requested a dump while continuing to run.
+constexpr int kCrashDumpPriority = 1;
+constexpr int kNonCrashDumpPriority = 0;
+
+// The maximum number of threads in the pool that services every client’s
+// waits. A thread pool wait occupies no thread while it is waiting, so this
+// does not need to grow with the number of clients. It allows for every dump
+// slot to be in use with as many requests again queued behind them, leaving
+// process-end callbacks, which are brief, to share the same threads.
+constexpr DWORD kMaxClientThreads =
+    ExceptionHandlerServer::kMaxConcurrentDumps * 2;
+
+// The number of threads that service the named pipe instances. Each
+// registration is brief, and the instances are serviced with overlapped I/O,
+// so this does not need to grow with the number of instances.
+constexpr size_t kPipeServiceThreads = 2;
+
 decltype(GetNamedPipeClientProcessId)* GetNamedPipeClientProcessIdFunction() {
   static const auto get_named_pipe_client_process_id =
       GET_FUNCTION(L"kernel32.dll", ::GetNamedPipeClientProcessId);
@@ -65,49 +86,267 @@ HANDLE DuplicateEvent(HANDLE process, HANDLE event) {
 
 namespace internal {
 
-//! \brief Context information for the named pipe handler threads.
+//! \brief A named pipe instance serviced through a completion port.
+//!
+//! At most one operation is outstanding on an instance at a time, so an
+//! instance is only accessed by the thread that dequeued its most recent
+//! completion.
+struct PipeInstance {
+  //! \brief The operation outstanding on the instance.
+  enum class State {
+    kConnecting,
+    kReading,
+    kWriting,
+  };
+
+  PipeInstance()
+      : overlapped(),
+        pipe(),
+        state(State::kConnecting),
+        io_pending(false),
+        message(),
+        response() {}
+
+  OVERLAPPED overlapped;
+  ScopedKernelHANDLE pipe;
+  State state;
+
+  //! \brief Whether an operation was started whose completion has not yet been
+  //!     dequeued.
+  bool io_pending;
+
+  ClientToServerMessage message;
+  ServerToClientMessage response;
+
+  DISALLOW_COPY_AND_ASSIGN(PipeInstance);
+};
+
+//! \brief Context information shared by the named pipe service threads.
+//!
+//! Pipe instances are associated with pipe_port() and driven by overlapped
+//! I/O. When every instance is busy with a client, another is created so that
+//! registrations are not turned away with `ERROR_PIPE_BUSY`, up to
+//! ExceptionHandlerServer::kMaxPipeInstances.
 class PipeServiceContext {
  public:
-  PipeServiceContext(HANDLE port,
-                     HANDLE pipe,
+  PipeServiceContext(PTP_CALLBACK_ENVIRON callback_environment,
+                     HANDLE port,
+                     const std::wstring& pipe_name,
                      ExceptionHandlerServer::Delegate* delegate,
                      base::Lock* clients_lock,
                      std::set<internal::ClientData*>* clients,
-                     uint64_t shutdown_token)
-      : port_(port),
-        pipe_(pipe),
+                     PrioritySemaphore* dump_semaphore)
+      : callback_environment_(callback_environment),
+        port_(port),
+        pipe_port_(CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 0)),
+        pipe_name_(pipe_name),
         delegate_(delegate),
         clients_lock_(clients_lock),
         clients_(clients),
-        shutdown_token_(shutdown_token) {}
+        dump_semaphore_(dump_semaphore),
+        instances_lock_(),
+        instances_(),
+        listening_instances_(0),
+        can_add_instances_(true) {
+    PCHECK(pipe_port_.is_valid()) << "CreateIoCompletionPort";
+  }
+
+  //! \brief Closes all pipe instances.
+  //!
+  //! This must not be called until every thread servicing pipe_port() has
+  //! returned.
+  ~PipeServiceContext() {
+    // Closing a pipe cancels its outstanding operation, but the completion
+    // still arrives at pipe_port_, and the instance’s OVERLAPPED is written
+    // when it does. Wait for those completions before freeing the instances.
+    size_t pending = 0;
+    for (const auto& instance : instances_) {
+      if (instance->io_pending)
+        ++pending;
+      instance->pipe.reset();
+    }
+    while (pending > 0) {
+      OVERLAPPED* ov = nullptr;
+      ULONG_PTR key = 0;
+      DWORD bytes = 0;
+      if (!GetQueuedCompletionStatus(
+              pipe_port_.get(), &bytes, &key, &ov, INFINITE) &&
+          !ov) {
+        PLOG(ERROR) << "GetQueuedCompletionStatus";
+        break;
+      }
+      if (key)
+        --pending;
+    }
+  }
 
+  PTP_CALLBACK_ENVIRON callback_environment() const {
+    return callback_environment_;
+  }
   HANDLE port() const { return port_; }
-  HANDLE pipe() const { return pipe_.get(); }
+  HANDLE pipe_port() const { return pipe_port_.get(); }
   ExceptionHandlerServer::Delegate* delegate() const { return delegate_; }
   base::Lock* clients_lock() const { return clients_lock_; }
   std::set<internal::ClientData*>* clients() const { return clients_; }
-  uint64_t shutdown_token() const { return shutdown_token_; }
+  PrioritySemaphore* dump_semaphore() const { return dump_semaphore_; }
+
+  //! \brief Takes ownership of \a pipe, an overlapped server-side pipe
+  //!     instance, and begins listening for a client on it.
+  void AddInstance(HANDLE pipe) {
+    base::AutoLock lock(instances_lock_);
+    AddInstanceLocked(pipe);
+  }
+
+  //! \brief Called when \a instance’s ConnectNamedPipe() has completed.
+  //!
+  //! If no other instance remains listening, another is created.
+  void Connected(PipeInstance* instance) {
+    base::AutoLock lock(instances_lock_);
+    DCHECK_GT(listening_instances_, 0u);
+    --listening_instances_;
+    if (listening_instances_ != 0 || !can_add_instances_ ||
+        instances_.size() >= ExceptionHandlerServer::kMaxPipeInstances) {
+      return;
+    }
+
+    HANDLE pipe = CreateNamedPipeInstance(pipe_name_, false);
+    if (pipe == INVALID_HANDLE_VALUE) {
+      // The first instance, which may have been created by the client that
+      // started this handler, determines the maximum number of instances.
+      PLOG(WARNING) << "CreateNamedPipe";
+      can_add_instances_ = false;
+      return;
+    }
+    AddInstanceLocked(pipe);
+  }
+
+  //! \brief Reads a message from the client connected to \a instance into its
+  //!     `message` field.
+  void Read(PipeInstance* instance) {
+    instance->state = PipeInstance::State::kReading;
+    memset(&instance->overlapped, 0, sizeof(instance->overlapped));
+    if (!ReadFile(instance->pipe.get(),
+                  &instance->message,
+                  sizeof(instance->message),
+                  nullptr,
+                  &instance->overlapped) &&
+        GetLastError() != ERROR_IO_PENDING &&
+        GetLastError() != ERROR_MORE_DATA) {
+      PLOG(ERROR) << "ReadFile";
+      Reset(instance);
+      return;
+    }
+    instance->io_pending = true;
+  }
+
+  //! \brief Writes \a instance’s `response` field to the client connected to
+  //!     it.
+  void Write(PipeInstance* instance) {
+    instance->state = PipeInstance::State::kWriting;
+    memset(&instance->overlapped, 0, sizeof(instance->overlapped));
+    if (!WriteFile(instance->pipe.get(),
+                   &instance->response,
+                   sizeof(instance->response),
+                   nullptr,
+                   &instance->overlapped) &&
+        GetLastError() != ERROR_IO_PENDING) {
+      PLOG(ERROR) << "WriteFile";
+      Reset(instance);
+      return;
+    }
+    instance->io_pending = true;
+  }
+
+  //! \brief Disconnects any client from \a instance and begins listening for
+  //!     a new one.
+  void Reset(PipeInstance* instance) {
+    DisconnectNamedPipe(instance->pipe.get());
+    base::AutoLock lock(instances_lock_);
+    Listen(instance);
+  }
 
  private:
+  void AddInstanceLocked(HANDLE pipe) {
+    instances_lock_.AssertAcquired();
+    std::unique_ptr<PipeInstance> instance(new PipeInstance());
+    instance->pipe.reset(pipe);
+    if (!CreateIoCompletionPort(pipe,
+                                pipe_port_.get(),
+                                reinterpret_cast<ULONG_PTR>(instance.get()),
+                                0)) {
+      PLOG(ERROR) << "CreateIoCompletionPort";
+      return;
+    }
+    Listen(instance.get());
+    instances_.push_back(std::move(instance));
+  }
+
+  void Listen(PipeInstance* instance) {
+    instances_lock_.AssertAcquired();
+    instance->state = PipeInstance::State::kConnecting;
+    memset(&instance->overlapped, 0, sizeof(instance->overlapped));
+    if (!ConnectNamedPipe(instance->pipe.get(), &instance->overlapped)) {
+      switch (GetLastError()) {
+        case ERROR_IO_PENDING:
+          break;
+
+        case ERROR_PIPE_CONNECTED:
+          // A client connected before ConnectNamedPipe() was called. No
+          // completion is queued in this case, so queue one.
+          if (!PostQueuedCompletionStatus(
+                  pipe_port_.get(),
+                  0,
+                  reinterpret_cast<ULONG_PTR>(instance),
+                  &instance->overlapped)) {
+            PLOG(ERROR) << "PostQueuedCompletionStatus";
+            return;
+          }
+          break;
+
+        default:
+          PLOG(ERROR) << "ConnectNamedPipe";
+          return;
+      }
+    }
+    instance->io_pending = true;
+    ++listening_instances_;
+  }
+
+  PTP_CALLBACK_ENVIRON callback_environment_;  // weak
   HANDLE port_;  // weak
-  ScopedKernelHANDLE pipe_;
+  ScopedKernelHANDLE pipe_port_;
+  std::wstring pipe_name_;
   ExceptionHandlerServer::Delegate* delegate_;  // weak
   base::Lock* clients_lock_;  // weak
   std::set<internal::ClientData*>* clients_;  // weak
-  uint64_t shutdown_token_;
+  PrioritySemaphore* dump_semaphore_;  // weak
+
+  base::Lock instances_lock_;
+  // Access to these fields must be guarded by instances_lock_.
+  std::vector<std::unique_ptr<PipeInstance>> instances_;
+  size_t listening_instances_;
+  bool can_add_instances_;
 
   DISALLOW_COPY_AND_ASSIGN(PipeServiceContext);
 };
 
-//! \brief The context data for registered threadpool waits.
+//! \brief The context data for a client’s thread pool waits.
 //!
 //! This object must be created and destroyed on the main thread. Access must be
-//! guarded by use of the lock() with the exception of the threadpool wait
-//! variables which are accessed only by the main thread.
+//! guarded by use of the lock() with the exception of the thread pool wait
+//! objects, which are created and closed only by the main thread.
+//!
+//! The crash dump and non-crash dump request waits are rearmed by their
+//! callbacks with RearmWait(), and the process end wait fires once. A
+//! DumpAndCrashRequest is recorded with RequestDumpAndCrash(), which is guarded
+//! by its own lock so that a pipe service thread isn’t held up by a dump in
+//! progress for the client.
 class ClientData {
  public:
-  ClientData(HANDLE port,
+  ClientData(PTP_CALLBACK_ENVIRON callback_environment,
+             HANDLE port,
              ExceptionHandlerServer::Delegate* delegate,
+             PrioritySemaphore* dump_semaphore,
              ScopedKernelHANDLE process,
              ScopedKernelHANDLE crash_dump_requested_event,
              ScopedKernelHANDLE non_crash_dump_requested_event,
@@ -115,15 +354,17 @@ class ClientData {
              WinVMAddress crash_exception_information_address,
              WinVMAddress non_crash_exception_information_address,
              WinVMAddress debug_critical_section_address,
-             WAITORTIMERCALLBACK crash_dump_request_callback,
-             WAITORTIMERCALLBACK non_crash_dump_request_callback,
-             WAITORTIMERCALLBACK process_end_callback)
-      : crash_dump_request_thread_pool_wait_(INVALID_HANDLE_VALUE),
-        non_crash_dump_request_thread_pool_wait_(INVALID_HANDLE_VALUE),
-        process_end_thread_pool_wait_(INVALID_HANDLE_VALUE),
+             PTP_WAIT_CALLBACK crash_dump_request_callback,
+             PTP_WAIT_CALLBACK non_crash_dump_request_callback,
+             PTP_WAIT_CALLBACK process_end_callback)
+      : crash_dump_request_thread_pool_wait_(nullptr),
+        non_crash_dump_request_thread_pool_wait_(nullptr),
+        process_end_thread_pool_wait_(nullptr),
         lock_(),
+        unregistering_(false),
         port_(port),
         delegate_(delegate),
+        dump_semaphore_(dump_semaphore),
         crash_dump_requested_event_(std::move(crash_dump_requested_event)),
         non_crash_dump_requested_event_(
             std::move(non_crash_dump_requested_event)),
@@ -134,8 +375,12 @@ class ClientData {
             crash_exception_information_address),
         non_crash_exception_information_address_(
             non_crash_exception_information_address),
-        debug_critical_section_address_(debug_critical_section_address) {
-    RegisterThreadPoolWaits(crash_dump_request_callback,
+        debug_critical_section_address_(debug_critical_section_address),
+        dump_and_crash_lock_(),
+        dump_and_crash_thread_id_(0),
+        dump_and_crash_exception_code_(0) {
+    RegisterThreadPoolWaits(callback_environment,
+                            crash_dump_request_callback,
                             non_crash_dump_request_callback,
                             process_end_callback);
   }
@@ -150,6 +395,7 @@ class ClientData {
   base::Lock* lock() { return &lock_; }
   HANDLE port() const { return port_; }
   ExceptionHandlerServer::Delegate* delegate() const { return delegate_; }
+  PrioritySemaphore* dump_semaphore() const { return dump_semaphore_; }
   HANDLE crash_dump_requested_event() const {
     return crash_dump_requested_event_.get();
   }
@@ -170,62 +416,113 @@ class ClientData {
   }
   HANDLE process() const { return process_.get(); }
 
- private:
-  void RegisterThreadPoolWaits(
-      WAITORTIMERCALLBACK crash_dump_request_callback,
-      WAITORTIMERCALLBACK non_crash_dump_request_callback,
-      WAITORTIMERCALLBACK process_end_callback) {
-    if (!RegisterWaitForSingleObject(&crash_dump_request_thread_pool_wait_,
-                                     crash_dump_requested_event_.get(),
-                                     crash_dump_request_callback,
-                                     this,
-                                     INFINITE,
-                                     WT_EXECUTEDEFAULT)) {
-      LOG(ERROR) << "RegisterWaitForSingleObject crash dump requested";
+  //! \brief Records a request that the client be dumped at \a thread_id and
+  //!     terminated, and signals the crash dump request event to service it.
+  void RequestDumpAndCrash(DWORD thread_id, DWORD exception_code) {
+    {
+      base::AutoLock lock(dump_and_crash_lock_);
+      dump_and_crash_thread_id_ = thread_id;
+      dump_and_crash_exception_code_ = exception_code;
     }
+    PLOG_IF(ERROR, !SetEvent(crash_dump_requested_event_.get())) << "SetEvent";
+  }
 
-    if (!RegisterWaitForSingleObject(&non_crash_dump_request_thread_pool_wait_,
-                                     non_crash_dump_requested_event_.get(),
-                                     non_crash_dump_request_callback,
-                                     this,
-                                     INFINITE,
-                                     WT_EXECUTEDEFAULT)) {
-      LOG(ERROR) << "RegisterWaitForSingleObject non-crash dump requested";
-    }
+  //! \brief Retrieves and clears the request recorded by
+  //!     RequestDumpAndCrash().
+  //!
+  //! \return `false` if there is no request.
+  bool TakeDumpAndCrashRequest(DWORD* thread_id, DWORD* exception_code) {
+    base::AutoLock lock(dump_and_crash_lock_);
+    if (!dump_and_crash_thread_id_)
+      return false;
+    *thread_id = dump_and_crash_thread_id_;
+    *exception_code = dump_and_crash_exception_code_;
+    dump_and_crash_thread_id_ = 0;
+    dump_and_crash_exception_code_ = 0;
+    return true;
+  }
+
+  //! \brief Waits on \a event with \a wait again, unless the waits are being
+  //!     unregistered.
+  //!
+  //! This must be called with lock() held, from \a wait’s callback.
+  void RearmWait(PTP_WAIT wait, HANDLE event) {
+    lock_.AssertAcquired();
+    if (!unregistering_)
+      SetThreadpoolWait(wait, event, nullptr);
+  }
 
-    if (!RegisterWaitForSingleObject(&process_end_thread_pool_wait_,
-                                     process_.get(),
-                                     process_end_callback,
-                                     this,
-                                     INFINITE,
-                                     WT_EXECUTEONLYONCE)) {
-      LOG(ERROR) << "RegisterWaitForSingleObject process end";
+ private:
+  PTP_WAIT CreateAndSetWait(PTP_CALLBACK_ENVIRON callback_environment,
+                            PTP_WAIT_CALLBACK callback,
+                            HANDLE event,
+                            const char* description) {
+    PTP_WAIT wait = CreateThreadpoolWait(callback, this, callback_environment);
+    if (!wait) {
+      PLOG(ERROR) << "CreateThreadpoolWait " << description;
+      return nullptr;
     }
+    SetThreadpoolWait(wait, event, nullptr);
+    return wait;
+  }
+
+  void RegisterThreadPoolWaits(
+      PTP_CALLBACK_ENVIRON callback_environment,
+      PTP_WAIT_CALLBACK crash_dump_request_callback,
+      PTP_WAIT_CALLBACK non_crash_dump_request_callback,
+      PTP_WAIT_CALLBACK process_end_callback) {
+    crash_dump_request_thread_pool_wait_ =
+        CreateAndSetWait(callback_environment,
+                         crash_dump_request_callback,
+                         crash_dump_requested_event_.get(),
+                         "crash dump requested");
+    non_crash_dump_request_thread_pool_wait_ =
+        CreateAndSetWait(callback_environment,
+                         non_crash_dump_request_callback,
+                         non_crash_dump_requested_event_.get(),
+                         "non-crash dump requested");
+    process_end_thread_pool_wait_ = CreateAndSetWait(callback_environment,
+                                                     process_end_callback,
+                                                     process_.get(),
+                                                     "process end");
   }
 
   // This blocks until outstanding calls complete so that we know it's safe to
   // delete this object. Because of this, it must be executed on the main
-  // thread, not a threadpool thread.
+  // thread, not a thread pool thread.
   void UnregisterThreadPoolWaits() {
-    UnregisterWaitEx(crash_dump_request_thread_pool_wait_,
-                     INVALID_HANDLE_VALUE);
-    crash_dump_request_thread_pool_wait_ = INVALID_HANDLE_VALUE;
-    UnregisterWaitEx(non_crash_dump_request_thread_pool_wait_,
-                     INVALID_HANDLE_VALUE);
-    non_crash_dump_request_thread_pool_wait_ = INVALID_HANDLE_VALUE;
-    UnregisterWaitEx(process_end_thread_pool_wait_, INVALID_HANDLE_VALUE);
-    process_end_thread_pool_wait_ = INVALID_HANDLE_VALUE;
+    // Once this is set, no callback rearms its wait, so clearing the waits
+    // below leaves none of them able to fire again.
+    {
+      base::AutoLock lock(lock_);
+      unregistering_ = true;
+    }
+
+    for (PTP_WAIT* wait : {&crash_dump_request_thread_pool_wait_,
+                           &non_crash_dump_request_thread_pool_wait_,
+                           &process_end_thread_pool_wait_}) {
+      if (!*wait)
+        continue;
+      SetThreadpoolWait(*wait, nullptr, nullptr);
+      // Callbacks already queued are allowed to run, because the process can
+      // end before its dump request is serviced.
+      WaitForThreadpoolWaitCallbacks(*wait, false);
+      CloseThreadpoolWait(*wait);
+      *wait = nullptr;
+    }
   }
 
   // These are only accessed on the main thread.
-  HANDLE crash_dump_request_thread_pool_wait_;
-  HANDLE non_crash_dump_request_thread_pool_wait_;
-  HANDLE process_end_thread_pool_wait_;
+  PTP_WAIT crash_dump_request_thread_pool_wait_;
+  PTP_WAIT non_crash_dump_request_thread_pool_wait_;
+  PTP_WAIT process_end_thread_pool_wait_;
 
   base::Lock lock_;
   // Access to these fields must be guarded by lock_.
+  bool unregistering_;
   HANDLE port_;  // weak
   ExceptionHandlerServer::Delegate* delegate_;  // weak
+  PrioritySemaphore* dump_semaphore_;  // weak
   ScopedKernelHANDLE crash_dump_requested_event_;
   ScopedKernelHANDLE non_crash_dump_requested_event_;
   ScopedKernelHANDLE non_crash_dump_completed_event_;
@@ -234,6 +531,11 @@ class ClientData {
   WinVMAddress non_crash_exception_information_address_;
   WinVMAddress debug_critical_section_address_;
 
+  base::Lock dump_and_crash_lock_;
+  // Access to these fields must be guarded by dump_and_crash_lock_.
+  DWORD dump_and_crash_thread_id_;
+  DWORD dump_and_crash_exception_code_;
+
   DISALLOW_COPY_AND_ASSIGN(ClientData);
 };
 
@@ -248,10 +550,21 @@ ExceptionHandlerServer::ExceptionHandlerServer(bool persistent)
       first_pipe_instance_(),
       clients_lock_(),
       clients_(),
+      dump_semaphore_(kMaxConcurrentDumps),
+      thread_pool_(CreateThreadpool(nullptr)),
+      callback_environment_(),
       persistent_(persistent) {
+  PCHECK(thread_pool_) << "CreateThreadpool";
+  SetThreadpoolThreadMaximum(thread_pool_, kMaxClientThreads);
+  PCHECK(SetThreadpoolThreadMinimum(thread_pool_, 1))
+      << "SetThreadpoolThreadMinimum";
+  InitializeThreadpoolEnvironment(&callback_environment_);
+  SetThreadpoolCallbackPool(&callback_environment_, thread_pool_);
 }
 
 ExceptionHandlerServer::~ExceptionHandlerServer() {
+  DestroyThreadpoolEnvironment(&callback_environment_);
+  CloseThreadpool(thread_pool_);
 }
 
 void ExceptionHandlerServer::SetPipeName(const std::wstring& pipe_name) {
@@ -288,8 +601,10 @@ void ExceptionHandlerServer::InitializeWithInheritedDataForInitialClient(
   {
     base::AutoLock lock(clients_lock_);
     internal::ClientData* client = new internal::ClientData(
+        &callback_environment_,
         port_.get(),
         delegate,
+        &dump_semaphore_,
         ScopedKernelHANDLE(initial_client_data.client_process()),
         ScopedKernelHANDLE(initial_client_data.request_crash_dump()),
         ScopedKernelHANDLE(initial_client_data.request_non_crash_dump()),
@@ -305,9 +620,14 @@ void ExceptionHandlerServer::InitializeWithInheritedDataForInitialClient(
 }
 
 void ExceptionHandlerServer::Run(Delegate* delegate) {
-  uint64_t shutdown_token = base::RandUint64();
-  ScopedKernelHANDLE thread_handles[kPipeInstances];
-  for (size_t i = 0; i < arraysize(thread_handles); ++i) {
+  internal::PipeServiceContext service_context(&callback_environment_,
+                                               port_.get(),
+                                               pipe_name_,
+                                               delegate,
+                                               &clients_lock_,
+                                               &clients_,
+                                               &dump_semaphore_);
+  for (size_t i = 0; i < kInitialPipeInstances; ++i) {
     HANDLE pipe;
     if (first_pipe_instance_.is_valid()) {
       pipe = first_pipe_instance_.release();
@@ -315,19 +635,13 @@ void ExceptionHandlerServer::Run(Delegate* delegate) {
       pipe = CreateNamedPipeInstance(pipe_name_, i == 0);
       PCHECK(pipe != INVALID_HANDLE_VALUE) << "CreateNamedPipe";
     }
+    service_context.AddInstance(pipe);
+  }
 
-    // Ownership of this object (and the pipe instance) is given to the new
-    // thread. We close the thread handles at the end of the scope. They clean
-    // up the context object and the pipe instance on termination.
-    internal::PipeServiceContext* context =
-        new internal::PipeServiceContext(port_.get(),
-                                         pipe,
-                                         delegate,
-                                         &clients_lock_,
-                                         &clients_,
-                                         shutdown_token);
-    thread_handles[i].reset(
-        CreateThread(nullptr, 0, &PipeServiceProc, context, 0, nullptr));
+  ScopedKernelHANDLE thread_handles[kPipeServiceThreads];
+  for (size_t i = 0; i < arraysize(thread_handles); ++i) {
+    thread_handles[i].reset(CreateThread(
+        nullptr, 0, &PipeServiceProc, &service_context, 0, nullptr));
     PCHECK(thread_handles[i].is_valid()) << "CreateThread";
   }
 
@@ -347,9 +661,10 @@ void ExceptionHandlerServer::Run(Delegate* delegate) {
     }
 
     // Otherwise, this is a request to unregister and destroy the given client.
-    // delete'ing the ClientData blocks in UnregisterWaitEx to ensure all
-    // outstanding threadpool waits are complete. This is important because the
-    // process handle can be signalled *before* the dump request is signalled.
+    // delete'ing the ClientData blocks in WaitForThreadpoolWaitCallbacks() to
+    // ensure all outstanding thread pool callbacks are complete. This is
+    // important because the process handle can be signalled *before* the dump
+    // request is signalled.
     internal::ClientData* client = reinterpret_cast<internal::ClientData*>(key);
     base::AutoLock lock(clients_lock_);
     clients_.erase(client);
@@ -358,16 +673,10 @@ void ExceptionHandlerServer::Run(Delegate* delegate) {
       break;
   }
 
-  // Signal to the named pipe instances that they should terminate.
+  // Signal to the named pipe service threads that they should terminate. The
+  // pipe instances are closed when service_context goes out of scope.
   for (size_t i = 0; i < arraysize(thread_handles); ++i) {
-    ClientToServerMessage message;
-    memset(&message, 0, sizeof(message));
-    message.type = ClientToServerMessage::kShutdown;
-    message.shutdown.token = shutdown_token;
-    ServerToClientMessage response;
-    SendToCrashHandlerServer(pipe_name_,
-                             reinterpret_cast<ClientToServerMessage&>(message),
-                             &response);
+    PostQueuedCompletionStatus(service_context.pipe_port(), 0, 0, nullptr);
   }
 
   for (auto& handle : thread_handles)
@@ -388,42 +697,33 @@ void ExceptionHandlerServer::Stop() {
   PostQueuedCompletionStatus(port_.get(), 0, 0, nullptr);
 }
 
-// This function must be called with service_context.pipe() already connected to
-// a client pipe. It exchanges data with the client and adds a ClientData record
-// to service_context->clients().
+// This function handles a message read from a client connected to pipe. If a
+// reply should be sent to the client, it fills in response and returns true.
+// A successful registration adds a ClientData record to
+// service_context.clients().
 //
 // static
-bool ExceptionHandlerServer::ServiceClientConnection(
-    const internal::PipeServiceContext& service_context) {
-  ClientToServerMessage message;
-
-  if (!LoggingReadFileExactly(
-          service_context.pipe(), &message, sizeof(message)))
-    return false;
-
+bool ExceptionHandlerServer::ServiceClientMessage(
+    const internal::PipeServiceContext& service_context,
+    HANDLE pipe,
+    const ClientToServerMessage& message,
+    ServerToClientMessage* response) {
   switch (message.type) {
-    case ClientToServerMessage::kShutdown: {
-      if (message.shutdown.token != service_context.shutdown_token()) {
-        LOG(ERROR) << "forged shutdown request, got: "
-                   << message.shutdown.token;
-        return false;
-      }
-      ServerToClientMessage shutdown_response = {};
-      LoggingWriteFile(service_context.pipe(),
-                       &shutdown_response,
-                       sizeof(shutdown_response));
-      return true;
-    }
+    case ClientToServerMessage::kShutdown:
+      // The server shuts its pipe service threads down directly, so this is
+      // never legitimately received.
+      LOG(ERROR) << "unexpected shutdown request";
+      return false;
 
-    case ClientToServerMessage::kPing: {
+    case ClientToServerMessage::kPing:
       // No action required, the fact that the message was processed is
       // sufficient.
-      ServerToClientMessage shutdown_response = {};
-      LoggingWriteFile(service_context.pipe(),
-                       &shutdown_response,
-                       sizeof(shutdown_response));
-      return false;
-    }
+      memset(response, 0, sizeof(*response));
+      return true;
+
+    case ClientToServerMessage::kDumpAndCrash:
+      return ServiceDumpAndCrashRequest(
+          service_context, pipe, message.dump_and_crash, response);
 
     case ClientToServerMessage::kRegister:
       // Handled below.
@@ -445,7 +745,7 @@ bool ExceptionHandlerServer::ServiceClientConnection(
   if (get_named_pipe_client_process_id) {
     // GetNamedPipeClientProcessId is only available on Vista+.
     DWORD real_pid = 0;
-    if (get_named_pipe_client_process_id(service_context.pipe(), &real_pid) &&
+    if (get_named_pipe_client_process_id(pipe, &real_pid) &&
         message.registration.client_process_id != real_pid) {
       LOG(ERROR) << "forged client pid, real pid: " << real_pid
                  << ", got: " << message.registration.client_process_id;
@@ -461,7 +761,7 @@ bool ExceptionHandlerServer::ServiceClientConnection(
   HANDLE client_process = OpenProcess(
       kXPProcessAllAccess, false, message.registration.client_process_id);
   if (!client_process) {
-    if (!ImpersonateNamedPipeClient(service_context.pipe())) {
+    if (!ImpersonateNamedPipeClient(pipe)) {
       PLOG(ERROR) << "ImpersonateNamedPipeClient";
       return false;
     }
@@ -478,8 +778,10 @@ bool ExceptionHandlerServer::ServiceClientConnection(
   {
     base::AutoLock lock(*service_context.clients_lock());
     client = new internal::ClientData(
+        service_context.callback_environment(),
         service_context.port(),
         service_context.delegate(),
+        service_context.dump_semaphore(),
         ScopedKernelHANDLE(client_process),
         ScopedKernelHANDLE(
             CreateEvent(nullptr, false /* auto reset */, false, nullptr)),
@@ -497,20 +799,62 @@ bool ExceptionHandlerServer::ServiceClientConnection(
   }
 
   // Duplicate the events back to the client so they can request a dump.
-  ServerToClientMessage response;
-  response.registration.request_crash_dump_event =
+  response->registration.request_crash_dump_event =
       HandleToInt(DuplicateEvent(
           client->process(), client->crash_dump_requested_event()));
-  response.registration.request_non_crash_dump_event =
+  response->registration.request_non_crash_dump_event =
       HandleToInt(DuplicateEvent(
           client->process(), client->non_crash_dump_requested_event()));
-  response.registration.non_crash_dump_completed_event =
+  response->registration.non_crash_dump_completed_event =
       HandleToInt(DuplicateEvent(
           client->process(), client->non_crash_dump_completed_event()));
 
-  if (!LoggingWriteFile(service_context.pipe(), &response, sizeof(response)))
+  return true;
+}
+
+// This function handles a DumpAndCrashRequest read from the process connected
+// to pipe, which need not be the client being dumped. The dump itself is taken
+// on the thread pool by OnCrashDumpEvent(), as for a crash that the client
+// reports, and the reply is sent once it has been queued.
+//
+// static
+bool ExceptionHandlerServer::ServiceDumpAndCrashRequest(
+    const internal::PipeServiceContext& service_context,
+    HANDLE pipe,
+    const DumpAndCrashRequest& request,
+    ServerToClientMessage* response) {
+  if (!request.thread_id) {
+    LOG(ERROR) << "no thread to dump";
+    return false;
+  }
+
+  // The server may be able to terminate processes that the requester can’t, so
+  // the request is only honored if the requester could terminate the client
+  // itself.
+  if (!ImpersonateNamedPipeClient(pipe)) {
+    PLOG(ERROR) << "ImpersonateNamedPipeClient";
+    return false;
+  }
+  ScopedKernelHANDLE client_process(
+      OpenProcess(PROCESS_TERMINATE, false, request.client_process_id));
+  PCHECK(RevertToSelf());
+  if (!client_process.is_valid()) {
+    LOG(ERROR) << "requester can't terminate " << request.client_process_id;
     return false;
+  }
 
+  {
+    base::AutoLock lock(*service_context.clients_lock());
+    for (internal::ClientData* client : *service_context.clients()) {
+      if (GetProcessId(client->process()) == request.client_process_id) {
+        client->RequestDumpAndCrash(request.thread_id, request.exception_code);
+        memset(response, 0, sizeof(*response));
+        return true;
+      }
+    }
+  }
+
+  LOG(ERROR) << "process " << request.client_process_id << " not registered";
   return false;
 }
 
@@ -521,53 +865,133 @@ DWORD __stdcall ExceptionHandlerServer::PipeServiceProc(void* ctx) {
   DCHECK(service_context);
 
   for (;;) {
-    bool ret = !!ConnectNamedPipe(service_context->pipe(), nullptr);
-    if (!ret && GetLastError() != ERROR_PIPE_CONNECTED) {
-      PLOG(ERROR) << "ConnectNamedPipe";
-    } else if (ServiceClientConnection(*service_context)) {
+    OVERLAPPED* ov = nullptr;
+    ULONG_PTR key = 0;
+    DWORD bytes = 0;
+    const bool result = !!GetQueuedCompletionStatus(
+        service_context->pipe_port(), &bytes, &key, &ov, INFINITE);
+    if (!key) {
+      // Shutting down.
+      PLOG_IF(ERROR, !result) << "GetQueuedCompletionStatus";
       break;
     }
-    DisconnectNamedPipe(service_context->pipe());
-  }
 
-  delete service_context;
+    // Otherwise, an operation on this pipe instance has completed.
+    internal::PipeInstance* instance =
+        reinterpret_cast<internal::PipeInstance*>(key);
+    instance->io_pending = false;
+
+    switch (instance->state) {
+      case internal::PipeInstance::State::kConnecting:
+        service_context->Connected(instance);
+        if (!result) {
+          PLOG(ERROR) << "ConnectNamedPipe";
+          service_context->Reset(instance);
+          break;
+        }
+        service_context->Read(instance);
+        break;
+
+      case internal::PipeInstance::State::kReading:
+        if (!result) {
+          PLOG(ERROR) << "ReadFile";
+          service_context->Reset(instance);
+          break;
+        }
+        if (bytes != sizeof(instance->message)) {
+          LOG(ERROR) << "ReadFile: expected " << sizeof(instance->message)
+                     << ", observed " << bytes;
+          service_context->Reset(instance);
+          break;
+        }
+        if (ServiceClientMessage(*service_context,
+                                 instance->pipe.get(),
+                                 instance->message,
+                                 &instance->response)) {
+          service_context->Write(instance);
+        } else {
+          service_context->Reset(instance);
+        }
+        break;
+
+      case internal::PipeInstance::State::kWriting:
+        PLOG_IF(ERROR, !result) << "WriteFile";
+        service_context->Reset(instance);
+        break;
+    }
+  }
 
   return 0;
 }
 
 // static
-void __stdcall ExceptionHandlerServer::OnCrashDumpEvent(void* ctx, BOOLEAN) {
+void CALLBACK
+ExceptionHandlerServer::OnCrashDumpEvent(PTP_CALLBACK_INSTANCE instance,
+                                         void* ctx,
+                                         PTP_WAIT wait,
+                                         TP_WAIT_RESULT wait_result) {
   // This function is executed on the thread pool.
   internal::ClientData* client = reinterpret_cast<internal::ClientData*>(ctx);
   base::AutoLock lock(*client->lock());
 
-  // Capture the exception.
-  unsigned int exit_code = client->delegate()->ExceptionHandlerServerException(
-      client->process(),
-      client->crash_exception_information_address(),
-      client->debug_critical_section_address());
+  // Capture the exception. A request made on the client’s behalf with
+  // DumpAndCrashRequest takes the place of any exception that the client itself
+  // signalled at the same time, as the client is terminated either way.
+  unsigned int exit_code;
+  {
+    ScopedPrioritySemaphoreWait dump_slot(client->dump_semaphore(),
+                                          kCrashDumpPriority);
+    DWORD thread_id;
+    DWORD exception_code;
+    if (client->TakeDumpAndCrashRequest(&thread_id, &exception_code)) {
+      exit_code = client->delegate()->ExceptionHandlerServerDumpAndCrash(
+          client->process(),
+          thread_id,
+          exception_code,
+          client->debug_critical_section_address());
+    } else {
+      exit_code = client->delegate()->ExceptionHandlerServerException(
+          client->process(),
+          client->crash_exception_information_address(),
+          client->debug_critical_section_address());
+    }
+  }
 
   SafeTerminateProcess(client->process(), exit_code);
+  client->RearmWait(wait, client->crash_dump_requested_event());
 }
 
 // static
-void __stdcall ExceptionHandlerServer::OnNonCrashDumpEvent(void* ctx, BOOLEAN) {
+void CALLBACK
+ExceptionHandlerServer::OnNonCrashDumpEvent(PTP_CALLBACK_INSTANCE instance,
+                                            void* ctx,
+                                            PTP_WAIT wait,
+                                            TP_WAIT_RESULT wait_result) {
   // This function is executed on the thread pool.
   internal::ClientData* client = reinterpret_cast<internal::ClientData*>(ctx);
   base::AutoLock lock(*client->lock());
 
   // Capture the exception.
-  client->delegate()->ExceptionHandlerServerException(
-      client->process(),
-      client->non_crash_exception_information_address(),
-      client->debug_critical_section_address());
+  {
+    ScopedPrioritySemaphoreWait dump_slot(client->dump_semaphore(),
+                                          kNonCrashDumpPriority);
+    client->delegate()->ExceptionHandlerServerException(
+        client->process(),
+        client->non_crash_exception_information_address(),
+        client->debug_critical_section_address());
+  }
 
   bool result = !!SetEvent(client->non_crash_dump_completed_event());
   PLOG_IF(ERROR, !result) << "SetEvent";
+  client->RearmWait(wait, client->non_crash_dump_requested_event());
 }
 
 // static
-void __stdcall ExceptionHandlerServer::OnProcessEnd(void* ctx, BOOLEAN) {
+void CALLBACK
+ExceptionHandlerServer::OnProcessEnd(PTP_CALLBACK_INSTANCE instance,
+                                     void* ctx,
+                                     PTP_WAIT wait,
+                                     TP_WAIT_RESULT wait_result) {
   // This function is executed on the thread pool.
   internal::ClientData* client = reinterpret_cast<internal::ClientData*>(ctx);
   base::AutoLock lock(*client->lock());
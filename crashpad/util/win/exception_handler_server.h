@@ -21,8 +21,10 @@
 #include "base/macros.h"
 #include "base/synchronization/lock.h"
 #include "util/file/file_io.h"
+#include "util/synchronization/priority_semaphore.h"
 #include "util/win/address_types.h"
 #include "util/win/initial_client_data.h"
+#include "util/win/registration_protocol_win.h"
 #include "util/win/scoped_handle.h"
 
 namespace crashpad {
@@ -60,6 +62,26 @@ class ExceptionHandlerServer {
         HANDLE process,
         WinVMAddress exception_information_address,
         WinVMAddress debug_critical_section_address) = 0;
+
+    //! \brief Called when another process has requested, with a
+    //!     DumpAndCrashRequest, that a crash dump be taken of the client
+    //!     without its participation.
+    //!
+    //! \param[in] process A handle to the client process. Ownership of the
+    //!     lifetime of this handle is not passed to the delegate.
+    //! \param[in] thread_id The thread in the client process that the
+    //!     exception is to be reported at, with its current context.
+    //! \param[in] exception_code The exception code to report.
+    //! \param[in] debug_critical_section_address The address in the client's
+    //!     address space of a `CRITICAL_SECTION` allocated with a valid
+    //!     `.DebugInfo` field, or `0` if unavailable.
+    //! \return The exit code that should be used when terminating the client
+    //!     process.
+    virtual unsigned int ExceptionHandlerServerDumpAndCrash(
+        HANDLE process,
+        DWORD thread_id,
+        DWORD exception_code,
+        WinVMAddress debug_critical_section_address) = 0;
   };
 
   //! \brief Constructs the exception handling server.
@@ -111,16 +133,47 @@ class ExceptionHandlerServer {
   void Stop();
 
   //! \brief The number of server-side pipe instances that the exception handler
-  //!     server creates to listen for connections from clients.
-  static const size_t kPipeInstances = 2;
+  //!     server creates to listen for connections from clients when it starts.
+  static const size_t kInitialPipeInstances = 2;
+
+  //! \brief The maximum number of server-side pipe instances.
+  //!
+  //! When a client connects to the last instance still listening, the server
+  //! creates another, up to this limit, so that clients registering at the
+  //! same time don’t queue behind one another.
+  static const size_t kMaxPipeInstances = 32;
+
+  //! \brief The maximum number of clients for which the delegate may be
+  //!     producing a dump at once.
+  //!
+  //! Requests beyond this limit wait, with crash dump requests served before
+  //! non-crash dump requests, so that a crash storm can’t saturate the handler.
+  static const int kMaxConcurrentDumps = 4;
 
  private:
-  static bool ServiceClientConnection(
-      const internal::PipeServiceContext& service_context);
+  static bool ServiceClientMessage(
+      const internal::PipeServiceContext& service_context,
+      HANDLE pipe,
+      const ClientToServerMessage& message,
+      ServerToClientMessage* response);
+  static bool ServiceDumpAndCrashRequest(
+      const internal::PipeServiceContext& service_context,
+      HANDLE pipe,
+      const DumpAndCrashRequest& request,
+      ServerToClientMessage* response);
   static DWORD __stdcall PipeServiceProc(void* ctx);
-  static void __stdcall OnCrashDumpEvent(void* ctx, BOOLEAN);
-  static void __stdcall OnNonCrashDumpEvent(void* ctx, BOOLEAN);
-  static void __stdcall OnProcessEnd(void* ctx, BOOLEAN);
+  static void CALLBACK OnCrashDumpEvent(PTP_CALLBACK_INSTANCE instance,
+                                       void* ctx,
+                                       PTP_WAIT wait,
+                                       TP_WAIT_RESULT wait_result);
+  static void CALLBACK OnNonCrashDumpEvent(PTP_CALLBACK_INSTANCE instance,
+                                          void* ctx,
+                                          PTP_WAIT wait,
+                                          TP_WAIT_RESULT wait_result);
+  static void CALLBACK OnProcessEnd(PTP_CALLBACK_INSTANCE instance,
+                                   void* ctx,
+                                   PTP_WAIT wait,
+                                   TP_WAIT_RESULT wait_result);
 
   std::wstring pipe_name_;
   ScopedKernelHANDLE port_;
@@ -129,6 +182,13 @@ class ExceptionHandlerServer {
   base::Lock clients_lock_;
   std::set<internal::ClientData*> clients_;
 
+  PrioritySemaphore dump_semaphore_;
+
+  // The pool that services every client’s waits, and the environment that
+  // associates each client’s waits with it.
+  PTP_POOL thread_pool_;
+  TP_CALLBACK_ENVIRON callback_environment_;
+
   bool persistent_;
 
   DISALLOW_COPY_AND_ASSIGN(ExceptionHandlerServer);
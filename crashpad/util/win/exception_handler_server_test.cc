@@ -68,6 +68,14 @@ class TestDelegate : public ExceptionHandlerServer::Delegate {
     return 0;
   }
 
+  unsigned int ExceptionHandlerServerDumpAndCrash(
+      HANDLE process,
+      DWORD thread_id,
+      DWORD exception_code,
+      WinVMAddress debug_critical_section_address) override {
+    return 0;
+  }
+
   void WaitForStart() { WaitForSingleObject(server_ready_, INFINITE); }
 
  private:
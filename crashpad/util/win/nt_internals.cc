@@ -38,14 +38,33 @@ NTSTATUS NTAPI NtOpenThread(HANDLE* ThreadHandle,
                             OBJECT_ATTRIBUTES* ObjectAttributes,
                             CLIENT_ID* ClientId);
 
+NTSTATUS NTAPI NtGetNextThread(HANDLE ProcessHandle,
+                               HANDLE ThreadHandle,
+                               ACCESS_MASK DesiredAccess,
+                               ULONG HandleAttributes,
+                               ULONG Flags,
+                               PHANDLE NewThreadHandle);
+
 NTSTATUS NTAPI NtSuspendProcess(HANDLE);
 
 NTSTATUS NTAPI NtResumeProcess(HANDLE);
 
+NTSTATUS NTAPI NtReadVirtualMemory(HANDLE ProcessHandle,
+                                   PVOID BaseAddress,
+                                   PVOID Buffer,
+                                   SIZE_T NumberOfBytesToRead,
+                                   PSIZE_T NumberOfBytesRead);
+
 VOID NTAPI RtlGetUnloadEventTraceEx(PULONG* ElementSize,
                                     PULONG* ElementCount,
                                     PVOID* EventTrace);
 
+NTSTATUS NTAPI LdrRegisterDllNotification(
+    ULONG Flags,
+    crashpad::LDR_DLL_NOTIFICATION_FUNCTION NotificationFunction,
+    PVOID Context,
+    PVOID* Cookie);
+
 }  // extern "C"
 
 namespace crashpad {
@@ -137,6 +156,24 @@ NTSTATUS NtQueryObject(HANDLE handle,
                          return_length);
 }
 
+NTSTATUS NtGetNextThread(HANDLE process_handle,
+                         HANDLE thread_handle,
+                         ACCESS_MASK desired_access,
+                         ULONG handle_attributes,
+                         ULONG flags,
+                         HANDLE* new_thread_handle) {
+  static const auto nt_get_next_thread =
+      GET_FUNCTION(L"ntdll.dll", ::NtGetNextThread);
+  if (!nt_get_next_thread)
+    return STATUS_NOT_IMPLEMENTED;
+  return nt_get_next_thread(process_handle,
+                            thread_handle,
+                            desired_access,
+                            handle_attributes,
+                            flags,
+                            new_thread_handle);
+}
+
 NTSTATUS NtSuspendProcess(HANDLE handle) {
   static const auto nt_suspend_process =
       GET_FUNCTION_REQUIRED(L"ntdll.dll", ::NtSuspendProcess);
@@ -149,6 +186,20 @@ NTSTATUS NtResumeProcess(HANDLE handle) {
   return nt_resume_process(handle);
 }
 
+NTSTATUS NtReadVirtualMemory(HANDLE process_handle,
+                             const void* base_address,
+                             void* buffer,
+                             SIZE_T number_of_bytes_to_read,
+                             SIZE_T* number_of_bytes_read) {
+  static const auto nt_read_virtual_memory =
+      GET_FUNCTION_REQUIRED(L"ntdll.dll", ::NtReadVirtualMemory);
+  return nt_read_virtual_memory(process_handle,
+                                const_cast<void*>(base_address),
+                                buffer,
+                                number_of_bytes_to_read,
+                                number_of_bytes_read);
+}
+
 void RtlGetUnloadEventTraceEx(ULONG** element_size,
                               ULONG** element_count,
                               void** event_trace) {
@@ -157,6 +208,17 @@ void RtlGetUnloadEventTraceEx(ULONG** element_size,
   rtl_get_unload_event_trace_ex(element_size, element_count, event_trace);
 }
 
+NTSTATUS LdrRegisterDllNotification(
+    ULONG flags,
+    LDR_DLL_NOTIFICATION_FUNCTION notification_function,
+    PVOID context,
+    PVOID* cookie) {
+  static const auto ldr_register_dll_notification =
+      GET_FUNCTION_REQUIRED(L"ntdll.dll", ::LdrRegisterDllNotification);
+  return ldr_register_dll_notification(
+      flags, notification_function, context, cookie);
+}
+
 // Explicit instantiations with the only 2 valid template arguments to avoid
 // putting the body of the function in the header.
 template NTSTATUS NtOpenThread<process_types::internal::Traits32>(
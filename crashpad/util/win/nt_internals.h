@@ -19,9 +19,13 @@
 
 // Copied from ntstatus.h because um/winnt.h conflicts with general inclusion of
 // ntstatus.h.
+#define STATUS_NOT_IMPLEMENTED ((NTSTATUS)0xC0000002L)
+#define STATUS_INVALID_INFO_CLASS ((NTSTATUS)0xC0000003L)
 #define STATUS_INFO_LENGTH_MISMATCH ((NTSTATUS)0xC0000004L)
 #define STATUS_BUFFER_TOO_SMALL ((NTSTATUS)0xC0000023L)
 #define STATUS_PROCESS_IS_TERMINATING ((NTSTATUS)0xC000010AL)
+#define STATUS_PARTIAL_COPY ((NTSTATUS)0x8000000DL)
+#define STATUS_NO_MORE_ENTRIES ((NTSTATUS)0x8000001AL)
 
 namespace crashpad {
 
@@ -48,6 +52,10 @@ enum { ThreadBasicInformation = 0 };
 // winternal.h defines SYSTEM_INFORMATION_CLASS, but not all members.
 enum { SystemExtendedHandleInformation = 64 };
 
+// winternal.h defines PROCESSINFOCLASS, but not all members. This is only
+// supported on Windows 8 and later.
+enum { ProcessHandleInformation = 51 };
+
 NTSTATUS NtQuerySystemInformation(
     SYSTEM_INFORMATION_CLASS system_information_class,
     PVOID system_information,
@@ -72,10 +80,29 @@ NTSTATUS NtQueryObject(HANDLE handle,
                        ULONG object_information_length,
                        ULONG* return_length);
 
+// Opens the thread following \a thread_handle in \a process_handle, or its
+// first thread if \a thread_handle is nullptr. Returns STATUS_NO_MORE_ENTRIES
+// after the last thread, and STATUS_NOT_IMPLEMENTED if ntdll doesn’t provide
+// this function, as before Windows Vista.
+NTSTATUS NtGetNextThread(HANDLE process_handle,
+                         HANDLE thread_handle,
+                         ACCESS_MASK desired_access,
+                         ULONG handle_attributes,
+                         ULONG flags,
+                         HANDLE* new_thread_handle);
+
 NTSTATUS NtSuspendProcess(HANDLE handle);
 
 NTSTATUS NtResumeProcess(HANDLE handle);
 
+// When this returns STATUS_PARTIAL_COPY, number_of_bytes_read is set to the
+// length of the prefix that was copied before an inaccessible byte was reached.
+NTSTATUS NtReadVirtualMemory(HANDLE process_handle,
+                             const void* base_address,
+                             void* buffer,
+                             SIZE_T number_of_bytes_to_read,
+                             SIZE_T* number_of_bytes_read);
+
 // From https://msdn.microsoft.com/en-us/library/cc678403(v=vs.85).aspx.
 template <class Traits>
 struct RTL_UNLOAD_EVENT_TRACE {
@@ -91,4 +118,36 @@ void RtlGetUnloadEventTraceEx(ULONG** element_size,
                               ULONG** element_count,
                               void** event_trace);
 
+// From https://msdn.microsoft.com/en-us/library/dd347460.aspx.
+enum {
+  LDR_DLL_NOTIFICATION_REASON_LOADED = 1,
+  LDR_DLL_NOTIFICATION_REASON_UNLOADED = 2,
+};
+
+struct LDR_DLL_LOADED_NOTIFICATION_DATA {
+  ULONG Flags;
+  const UNICODE_STRING* FullDllName;
+  const UNICODE_STRING* BaseDllName;
+  PVOID DllBase;
+  ULONG SizeOfImage;
+};
+
+using LDR_DLL_UNLOADED_NOTIFICATION_DATA = LDR_DLL_LOADED_NOTIFICATION_DATA;
+
+union LDR_DLL_NOTIFICATION_DATA {
+  LDR_DLL_LOADED_NOTIFICATION_DATA Loaded;
+  LDR_DLL_UNLOADED_NOTIFICATION_DATA Unloaded;
+};
+
+using LDR_DLL_NOTIFICATION_FUNCTION =
+    VOID(CALLBACK*)(ULONG notification_reason,
+                    const LDR_DLL_NOTIFICATION_DATA* notification_data,
+                    PVOID context);
+
+NTSTATUS LdrRegisterDllNotification(
+    ULONG flags,
+    LDR_DLL_NOTIFICATION_FUNCTION notification_function,
+    PVOID context,
+    PVOID* cookie);
+
 }  // namespace crashpad
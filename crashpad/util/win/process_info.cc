@@ -15,16 +15,19 @@
 #include "util/win/process_info.h"
 
 #include <stddef.h>
+#include <string.h>
 #include <winternl.h>
 
 #include <algorithm>
 #include <limits>
+#include <map>
 #include <memory>
 #include <new>
 #include <type_traits>
 
 #include "base/logging.h"
 #include "base/memory/free_deleter.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/process/memory.h"
 #include "base/strings/stringprintf.h"
 #include "build/build_config.h"
@@ -125,12 +128,151 @@ bool ReadStruct(HANDLE process, WinVMAddress at, T* into) {
   return true;
 }
 
+// The unit in which PageCachingReader reads from the target process.
+constexpr WinVMSize kPageSize = 4096;
+
+// Reads memory from a process a page at a time, keeping each page that it
+// reads. The loader’s entries and the strings that they point to are usually
+// allocated close together on the process heap, so this allows a walk of the
+// loader’s module list to read each page once, rather than making several
+// dependent reads for each module.
+class PageCachingReader {
+ public:
+  PageCachingReader(HANDLE process, const ProcessInfo* process_info)
+      : pages_(), process_(process), process_info_(process_info) {}
+
+  ~PageCachingReader() {}
+
+  // Reads |size| bytes at |address| into |into|, returning false without a
+  // message logged if any of them aren’t readable.
+  bool Read(WinVMAddress address, WinVMSize size, void* into) {
+    const WinVMAddress end = address + size;
+    if (end < address) {
+      return false;
+    }
+
+    char* into_bytes = static_cast<char*>(into);
+    WinVMAddress current = address;
+    while (current < end) {
+      const WinVMAddress page_address = current - current % kPageSize;
+      const std::vector<uint8_t>& page = Page(page_address);
+      const WinVMSize offset = current - page_address;
+      const WinVMSize chunk = std::min(end - current, kPageSize - offset);
+      if (offset + chunk > page.size()) {
+        return false;
+      }
+      memcpy(into_bytes,
+             &page[static_cast<size_t>(offset)],
+             static_cast<size_t>(chunk));
+      into_bytes += chunk;
+      current += chunk;
+    }
+
+    return true;
+  }
+
+ private:
+  // Returns the readable part of the page at |page_address|, reading it from
+  // the process if it hasn’t been read yet.
+  const std::vector<uint8_t>& Page(WinVMAddress page_address) {
+    auto it = pages_.find(page_address);
+    if (it != pages_.end()) {
+      return it->second;
+    }
+
+    std::vector<uint8_t>& page = pages_[page_address];
+
+    // Consult the memory map first, so that unreadable pages are skipped
+    // without a failed read.
+    const auto readable = process_info_->GetReadableRanges(
+        CheckedRange<WinVMAddress, WinVMSize>(page_address, kPageSize));
+    if (readable.empty() || readable.front().base() != page_address) {
+      return page;
+    }
+
+    page.resize(static_cast<size_t>(readable.front().size()));
+    SIZE_T bytes_read;
+    if (!ReadProcessMemory(process_,
+                           reinterpret_cast<const void*>(page_address),
+                           page.data(),
+                           page.size(),
+                           &bytes_read)) {
+      bytes_read = 0;
+    }
+    page.resize(bytes_read);
+    return page;
+  }
+
+  std::map<WinVMAddress, std::vector<uint8_t>> pages_;
+  HANDLE process_;
+  const ProcessInfo* process_info_;  // weak
+
+  DISALLOW_COPY_AND_ASSIGN(PageCachingReader);
+};
+
 bool RegionIsAccessible(const MEMORY_BASIC_INFORMATION64& memory_info) {
   return memory_info.State == MEM_COMMIT &&
          (memory_info.Protect & PAGE_NOACCESS) == 0 &&
          (memory_info.Protect & PAGE_GUARD) == 0;
 }
 
+// Returns the first region in the sorted, non-overlapping memory map between
+// |first| and |last| that ends after |address|, or |last| if there is none.
+const MEMORY_BASIC_INFORMATION64* FindFirstRegionEndingAfter(
+    const MEMORY_BASIC_INFORMATION64* first,
+    const MEMORY_BASIC_INFORMATION64* last,
+    WinVMAddress address) {
+  static_assert(std::is_same<decltype(first->BaseAddress), WinVMAddress>::value,
+                "expected range address to be WinVMAddress");
+  static_assert(std::is_same<decltype(first->RegionSize), WinVMSize>::value,
+                "expected range size to be WinVMSize");
+  return std::upper_bound(
+      first,
+      last,
+      address,
+      [](WinVMAddress value, const MEMORY_BASIC_INFORMATION64& mi) {
+        return value < mi.BaseAddress + mi.RegionSize;
+      });
+}
+
+// Appends the readable portions of |range| to |result|, coalescing adjacent
+// readable regions. |first| must be the first region that ends after the base
+// of |range|, as returned by FindFirstRegionEndingAfter().
+void AppendReadableRanges(
+    const CheckedRange<WinVMAddress, WinVMSize>& range,
+    const MEMORY_BASIC_INFORMATION64* first,
+    const MEMORY_BASIC_INFORMATION64* last,
+    std::vector<CheckedRange<WinVMAddress, WinVMSize>>* result) {
+  using Range = CheckedRange<WinVMAddress, WinVMSize>;
+
+  // Constructing Ranges and using OverlapsRange() is very, very slow in Debug
+  // builds, so do a manual check in this loop. The ranges are still validated
+  // by a CheckedRange before being returned.
+  const WinVMAddress range_base = range.base();
+  const WinVMAddress range_end = range.end();
+  const size_t first_result = result->size();
+
+  for (const MEMORY_BASIC_INFORMATION64* mi = first;
+       mi != last && mi->BaseAddress < range_end;
+       ++mi) {
+    if (!RegionIsAccessible(*mi))
+      continue;
+
+    // Trim to the boundary of the incoming range.
+    const WinVMAddress base = std::max(mi->BaseAddress, range_base);
+    const WinVMAddress end =
+        std::min(mi->BaseAddress + mi->RegionSize, range_end);
+
+    if (result->size() > first_result && result->back().end() == base) {
+      result->back().SetRange(result->back().base(),
+                              result->back().size() + (end - base));
+    } else {
+      result->push_back(Range(base, end - base));
+    }
+    DCHECK(result->back().IsValid());
+  }
+}
+
 MEMORY_BASIC_INFORMATION64 MemoryBasicInformationToMemoryBasicInformation64(
     const MEMORY_BASIC_INFORMATION& mbi) {
   MEMORY_BASIC_INFORMATION64 mbi64 = {0};
@@ -177,6 +319,24 @@ std::unique_ptr<uint8_t[]> QueryObject(
   return buffer;
 }
 
+// Returns the name of the type of the object that handle refers to, or an
+// empty string on failure with a message logged.
+std::wstring ObjectTypeName(HANDLE handle) {
+  std::unique_ptr<uint8_t[]> object_type_information_buffer = QueryObject(
+      handle, ObjectTypeInformation, sizeof(PUBLIC_OBJECT_TYPE_INFORMATION));
+  if (!object_type_information_buffer)
+    return std::wstring();
+
+  PUBLIC_OBJECT_TYPE_INFORMATION* object_type_information =
+      reinterpret_cast<PUBLIC_OBJECT_TYPE_INFORMATION*>(
+          object_type_information_buffer.get());
+
+  DCHECK_EQ(object_type_information->TypeName.Length % sizeof(wchar_t), 0u);
+  return std::wstring(object_type_information->TypeName.Buffer,
+                      object_type_information->TypeName.Length /
+                          sizeof(wchar_t));
+}
+
 }  // namespace
 
 template <class Traits>
@@ -290,40 +450,67 @@ bool ReadProcessData(HANDLE process,
   module.timestamp = ldr_data_table_entry.TimeDateStamp;
   process_info->modules_.push_back(module);
 
+  // The rest of the list is walked by ReadModuleList() when it’s needed.
+  process_info->ldr_initialization_order_first_ =
+      peb_ldr_data.InInitializationOrderModuleList.Flink;
+  process_info->ldr_initialization_order_last_ =
+      peb_ldr_data.InInitializationOrderModuleList.Blink;
+
+  return true;
+}
+
+template <class Traits>
+void ReadModuleList(HANDLE process, const ProcessInfo* process_info) {
+  using LdrDataTableEntry = process_types::LDR_DATA_TABLE_ENTRY<Traits>;
+
   // Walk the PEB LDR structure (doubly-linked list) to get the list of loaded
   // modules. We use this method rather than EnumProcessModules to get the
   // modules in initialization order rather than memory order.
-  typename Traits::Pointer last =
-      peb_ldr_data.InInitializationOrderModuleList.Blink;
-  for (typename Traits::Pointer cur =
-           peb_ldr_data.InInitializationOrderModuleList.Flink;
+  //
+  // Each entry is read through |reader|, which reads the pages around it, and
+  // the entries that follow are usually found there without another read.
+  // Only once all of the entries have been read are their names resolved, by
+  // which time the pages holding most of them have been read too.
+  PageCachingReader reader(process, process_info);
+  std::vector<LdrDataTableEntry> ldr_data_table_entries;
+  LdrDataTableEntry ldr_data_table_entry;
+  const WinVMAddress last = process_info->ldr_initialization_order_last_;
+  for (WinVMAddress cur = process_info->ldr_initialization_order_first_;
        ;
        cur = ldr_data_table_entry.InInitializationOrderLinks.Flink) {
     // |cur| is the pointer to the LIST_ENTRY embedded in the
     // LDR_DATA_TABLE_ENTRY, in the target process's address space. So we need
     // to read from the target, and also offset back to the beginning of the
     // structure.
-    if (!ReadStruct(process,
-                    static_cast<WinVMAddress>(cur) -
-                        offsetof(process_types::LDR_DATA_TABLE_ENTRY<Traits>,
-                                 InInitializationOrderLinks),
-                    &ldr_data_table_entry)) {
+    const WinVMAddress entry_address =
+        cur - offsetof(LdrDataTableEntry, InInitializationOrderLinks);
+    if (!reader.Read(entry_address,
+                     sizeof(ldr_data_table_entry),
+                     &ldr_data_table_entry) &&
+        !ReadStruct(process, entry_address, &ldr_data_table_entry)) {
       break;
     }
+    ldr_data_table_entries.push_back(ldr_data_table_entry);
+    if (cur == last)
+      break;
+  }
+
+  ProcessInfo::Module module;
+  for (const LdrDataTableEntry& entry : ldr_data_table_entries) {
     // TODO(scottmg): Capture Checksum, etc. too?
-    if (!ReadUnicodeString(
-            process, ldr_data_table_entry.FullDllName, &module.name)) {
+    const process_types::UNICODE_STRING<Traits>& name = entry.FullDllName;
+    DCHECK_EQ(name.Length % sizeof(wchar_t), 0u);
+    module.name.resize(name.Length / sizeof(wchar_t));
+    if ((name.Length == 0 ||
+         !reader.Read(name.Buffer, name.Length, &module.name[0])) &&
+        !ReadUnicodeString(process, name, &module.name)) {
       break;
     }
-    module.dll_base = ldr_data_table_entry.DllBase;
-    module.size = ldr_data_table_entry.SizeOfImage;
-    module.timestamp = ldr_data_table_entry.TimeDateStamp;
+    module.dll_base = entry.DllBase;
+    module.size = entry.SizeOfImage;
+    module.timestamp = entry.TimeDateStamp;
     process_info->modules_.push_back(module);
-    if (cur == last)
-      break;
   }
-
-  return true;
 }
 
 bool ReadMemoryInfo(HANDLE process, bool is_64_bit, ProcessInfo* process_info) {
@@ -366,6 +553,112 @@ bool ReadMemoryInfo(HANDLE process, bool is_64_bit, ProcessInfo* process_info) {
 
 std::vector<ProcessInfo::Handle> ProcessInfo::BuildHandleVector(
     HANDLE process) const {
+  std::vector<Handle> handles;
+  if (BuildHandleVectorFromProcessHandleInformation(process, &handles))
+    return handles;
+
+  return BuildHandleVectorFromSystemHandleInformation(process);
+}
+
+bool ProcessInfo::BuildHandleVectorFromProcessHandleInformation(
+    HANDLE process,
+    std::vector<Handle>* handles) const {
+  ULONG buffer_size = 64 * 1024;
+  NTSTATUS status;
+  ULONG returned_length;
+  UniqueMallocPtr buffer;
+  for (int tries = 0; tries < 5; ++tries) {
+    buffer.reset();
+    buffer = UncheckedAllocate(buffer_size);
+    if (!buffer) {
+      LOG(ERROR) << "UncheckedAllocate";
+      return false;
+    }
+
+    status = crashpad::NtQueryInformationProcess(
+        process,
+        static_cast<PROCESSINFOCLASS>(ProcessHandleInformation),
+        buffer.get(),
+        buffer_size,
+        &returned_length);
+    if (status != STATUS_INFO_LENGTH_MISMATCH)
+      break;
+
+    // The handle table may grow before the next attempt, so leave some room
+    // beyond the size that was reported.
+    buffer_size = std::max(buffer_size * 2, returned_length + 4096);
+  }
+
+  if (!NT_SUCCESS(status)) {
+    // Before Windows 8, this information class isn’t supported, and the
+    // system-wide handle table must be used instead.
+    if (status != STATUS_INVALID_INFO_CLASS) {
+      NTSTATUS_LOG(ERROR, status)
+          << "NtQueryInformationProcess ProcessHandleInformation";
+    }
+    return false;
+  }
+
+  const auto& process_handle_snapshot_information =
+      *reinterpret_cast<process_types::PROCESS_HANDLE_SNAPSHOT_INFORMATION*>(
+          buffer.get());
+
+  DCHECK_LE(
+      offsetof(process_types::PROCESS_HANDLE_SNAPSHOT_INFORMATION, Handles) +
+          process_handle_snapshot_information.NumberOfHandles *
+              sizeof(process_handle_snapshot_information.Handles[0]),
+      returned_length);
+
+  // The handle and pointer counts are reported directly, so the only
+  // information that requires a query of the object is its type name, and
+  // that’s shared by every handle with the same type index.
+  std::map<ULONG, std::wstring> type_names;
+
+  handles->clear();
+  handles->reserve(process_handle_snapshot_information.NumberOfHandles);
+  for (size_t i = 0; i < process_handle_snapshot_information.NumberOfHandles;
+       ++i) {
+    const auto& handle = process_handle_snapshot_information.Handles[i];
+
+    Handle result_handle;
+    result_handle.handle = HandleToInt(handle.HandleValue);
+    result_handle.attributes = handle.HandleAttributes;
+    result_handle.granted_access = handle.GrantedAccess;
+    result_handle.pointer_count =
+        base::saturated_cast<uint32_t>(handle.PointerCount);
+    result_handle.handle_count =
+        base::saturated_cast<uint32_t>(handle.HandleCount);
+
+    auto type_name = type_names.find(handle.ObjectTypeIndex);
+    if (type_name == type_names.end()) {
+      // If the handle can’t be duplicated, which is the case for some types
+      // such as EtwRegistration, the empty name is cached, because other
+      // handles of the same type are unlikely to fare any better.
+      std::wstring name;
+      HANDLE dup_handle;
+      if (DuplicateHandle(process,
+                          handle.HandleValue,
+                          GetCurrentProcess(),
+                          &dup_handle,
+                          0,
+                          false,
+                          DUPLICATE_SAME_ACCESS)) {
+        ScopedKernelHANDLE scoped_dup_handle(dup_handle);
+        name = ObjectTypeName(dup_handle);
+      }
+      type_name =
+          type_names.insert(std::make_pair(handle.ObjectTypeIndex, name)).first;
+    }
+    result_handle.type_name = type_name->second;
+
+    handles->push_back(result_handle);
+  }
+  return true;
+}
+
+std::vector<ProcessInfo::Handle>
+ProcessInfo::BuildHandleVectorFromSystemHandleInformation(
+    HANDLE process) const {
   ULONG buffer_size = 2 * 1024 * 1024;
   // Typically if the buffer were too small, STATUS_INFO_LENGTH_MISMATCH would
   // return the correct size in the final argument, but it does not for
@@ -409,6 +702,10 @@ std::vector<ProcessInfo::Handle> ProcessInfo::BuildHandleVector(
 
   std::vector<Handle> handles;
 
+  // Every handle with the same type index has the same type name, so it only
+  // needs to be queried once.
+  std::map<USHORT, std::wstring> type_names;
+
   for (size_t i = 0; i < system_handle_information_ex.NumberOfHandles; ++i) {
     const auto& handle = system_handle_information_ex.Handles[i];
     if (handle.UniqueProcessId != process_id_)
@@ -459,23 +756,14 @@ std::vector<ProcessInfo::Handle> ProcessInfo::BuildHandleVector(
         result_handle.handle_count = object_basic_information->HandleCount - 1;
       }
 
-      std::unique_ptr<uint8_t[]> object_type_information_buffer =
-          QueryObject(dup_handle,
-                      ObjectTypeInformation,
-                      sizeof(PUBLIC_OBJECT_TYPE_INFORMATION));
-      if (object_type_information_buffer) {
-        PUBLIC_OBJECT_TYPE_INFORMATION* object_type_information =
-            reinterpret_cast<PUBLIC_OBJECT_TYPE_INFORMATION*>(
-                object_type_information_buffer.get());
-
-        DCHECK_EQ(object_type_information->TypeName.Length %
-                      sizeof(result_handle.type_name[0]),
-                  0u);
-        result_handle.type_name =
-            std::wstring(object_type_information->TypeName.Buffer,
-                         object_type_information->TypeName.Length /
-                             sizeof(result_handle.type_name[0]));
+      auto type_name = type_names.find(handle.ObjectTypeIndex);
+      if (type_name == type_names.end()) {
+        type_name = type_names
+                        .insert(std::make_pair(handle.ObjectTypeIndex,
+                                               ObjectTypeName(dup_handle)))
+                        .first;
       }
+      result_handle.type_name = type_name->second;
     }
 
     handles.push_back(result_handle);
@@ -509,6 +797,9 @@ ProcessInfo::ProcessInfo()
       peb_address_(0),
       peb_size_(0),
       modules_(),
+      ldr_initialization_order_first_(0),
+      ldr_initialization_order_last_(0),
+      read_module_list_(false),
       memory_info_(),
       handles_(),
       is_64_bit_(false),
@@ -609,10 +900,27 @@ void ProcessInfo::Peb(WinVMAddress* peb_address, WinVMSize* peb_size) const {
 
 bool ProcessInfo::Modules(std::vector<Module>* modules) const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  if (!read_module_list_) {
+    read_module_list_ = true;
+    if (is_64_bit_) {
+      ReadModuleList<process_types::internal::Traits64>(process_, this);
+    } else {
+      ReadModuleList<process_types::internal::Traits32>(process_, this);
+    }
+  }
   *modules = modules_;
   return true;
 }
 
+bool ProcessInfo::MainModule(Module* module) const {
+  INITIALIZATION_STATE_DCHECK_VALID(initialized_);
+  if (modules_.empty()) {
+    return false;
+  }
+  *module = modules_[0];
+  return true;
+}
+
 const ProcessInfo::MemoryBasicInformation64Vector& ProcessInfo::MemoryInfo()
     const {
   INITIALIZATION_STATE_DCHECK_VALID(initialized_);
@@ -625,6 +933,12 @@ ProcessInfo::GetReadableRanges(
   return GetReadableRangesOfMemoryMap(range, MemoryInfo());
 }
 
+std::vector<std::vector<CheckedRange<WinVMAddress, WinVMSize>>>
+ProcessInfo::GetReadableRanges(
+    const std::vector<CheckedRange<WinVMAddress, WinVMSize>>& ranges) const {
+  return GetReadableRangesOfMemoryMap(ranges, MemoryInfo());
+}
+
 bool ProcessInfo::LoggingRangeIsFullyReadable(
     const CheckedRange<WinVMAddress, WinVMSize>& range) const {
   const auto ranges = GetReadableRanges(range);
@@ -658,75 +972,42 @@ const std::vector<ProcessInfo::Handle>& ProcessInfo::Handles() const {
 std::vector<CheckedRange<WinVMAddress, WinVMSize>> GetReadableRangesOfMemoryMap(
     const CheckedRange<WinVMAddress, WinVMSize>& range,
     const ProcessInfo::MemoryBasicInformation64Vector& memory_info) {
-  using Range = CheckedRange<WinVMAddress, WinVMSize>;
+  const MEMORY_BASIC_INFORMATION64* begin = memory_info.data();
+  const MEMORY_BASIC_INFORMATION64* end = begin + memory_info.size();
+
+  std::vector<CheckedRange<WinVMAddress, WinVMSize>> result;
+  AppendReadableRanges(range,
+                       FindFirstRegionEndingAfter(begin, end, range.base()),
+                       end,
+                       &result);
+  return result;
+}
 
-  // Constructing Ranges and using OverlapsRange() is very, very slow in Debug
-  // builds, so do a manual check in this loop. The ranges are still validated
-  // by a CheckedRange before being returned.
-  WinVMAddress range_base = range.base();
-  WinVMAddress range_end = range.end();
-
-  // Find all the ranges that overlap the target range, maintaining their order.
-  ProcessInfo::MemoryBasicInformation64Vector overlapping;
-  const size_t size = memory_info.size();
-
-  // This loop is written in an ugly fashion to make Debug performance
-  // reasonable.
-  const MEMORY_BASIC_INFORMATION64* begin = &memory_info[0];
-  for (size_t i = 0; i < size; ++i) {
-    const MEMORY_BASIC_INFORMATION64& mi = *(begin + i);
-    static_assert(std::is_same<decltype(mi.BaseAddress), WinVMAddress>::value,
-                  "expected range address to be WinVMAddress");
-    static_assert(std::is_same<decltype(mi.RegionSize), WinVMSize>::value,
-                  "expected range size to be WinVMSize");
-    WinVMAddress mi_end = mi.BaseAddress + mi.RegionSize;
-    if (range_base < mi_end && mi.BaseAddress < range_end)
-      overlapping.push_back(mi);
-  }
-  if (overlapping.empty())
-    return std::vector<Range>();
-
-  // For the first and last, trim to the boundary of the incoming range.
-  MEMORY_BASIC_INFORMATION64& front = overlapping.front();
-  WinVMAddress original_front_base_address = front.BaseAddress;
-  front.BaseAddress = std::max(front.BaseAddress, range.base());
-  front.RegionSize =
-      (original_front_base_address + front.RegionSize) - front.BaseAddress;
-
-  MEMORY_BASIC_INFORMATION64& back = overlapping.back();
-  WinVMAddress back_end = back.BaseAddress + back.RegionSize;
-  back.RegionSize = std::min(range.end(), back_end) - back.BaseAddress;
-
-  // Discard all non-accessible.
-  overlapping.erase(std::remove_if(overlapping.begin(),
-                                   overlapping.end(),
-                                   [](const MEMORY_BASIC_INFORMATION64& mbi) {
-                                     return !RegionIsAccessible(mbi);
-                                   }),
-                    overlapping.end());
-  if (overlapping.empty())
-    return std::vector<Range>();
-
-  // Convert to return type.
-  std::vector<Range> as_ranges;
-  for (const auto& mi : overlapping) {
-    as_ranges.push_back(Range(mi.BaseAddress, mi.RegionSize));
-    DCHECK(as_ranges.back().IsValid());
-  }
-
-  // Coalesce remaining regions.
-  std::vector<Range> result;
-  result.push_back(as_ranges[0]);
-  for (size_t i = 1; i < as_ranges.size(); ++i) {
-    if (result.back().end() == as_ranges[i].base()) {
-      result.back().SetRange(result.back().base(),
-                             result.back().size() + as_ranges[i].size());
-    } else {
-      result.push_back(as_ranges[i]);
-    }
-    DCHECK(result.back().IsValid());
+std::vector<std::vector<CheckedRange<WinVMAddress, WinVMSize>>>
+GetReadableRangesOfMemoryMap(
+    const std::vector<CheckedRange<WinVMAddress, WinVMSize>>& ranges,
+    const ProcessInfo::MemoryBasicInformation64Vector& memory_info) {
+  // Visit the ranges in order of increasing base address so that the search
+  // for each range’s first region can start where the previous one left off,
+  // instead of at the beginning of the memory map.
+  std::vector<size_t> order(ranges.size());
+  for (size_t index = 0; index < order.size(); ++index) {
+    order[index] = index;
+  }
+  std::sort(order.begin(), order.end(), [&ranges](size_t lhs, size_t rhs) {
+    return ranges[lhs].base() < ranges[rhs].base();
+  });
+
+  const MEMORY_BASIC_INFORMATION64* cursor = memory_info.data();
+  const MEMORY_BASIC_INFORMATION64* end = cursor + memory_info.size();
+
+  std::vector<std::vector<CheckedRange<WinVMAddress, WinVMSize>>> result(
+      ranges.size());
+  for (size_t index : order) {
+    const CheckedRange<WinVMAddress, WinVMSize>& range = ranges[index];
+    cursor = FindFirstRegionEndingAfter(cursor, end, range.base());
+    AppendReadableRanges(range, cursor, end, &result[index]);
   }
-
   return result;
 }
 
@@ -126,9 +126,25 @@ class ProcessInfo {
   //! The modules are enumerated in initialization order as detailed in the
   //!     Process Environment Block. The main executable will always be the
   //!     first element.
+  //!
+  //! The loader’s module list is walked the first time that this method is
+  //! called, rather than during Initialize(), so that a caller that can learn
+  //! about the modules more cheaply, using MainModule(), need not pay for the
+  //! walk.
   bool Modules(std::vector<Module>* modules) const;
 
+  //! \brief Retrieves the main executable module of the target process.
+  //!
+  //! This is the first element that Modules() would return, but doesn’t
+  //! require walking the loader’s module list.
+  //!
+  //! \return `true` on success, with \a module set. `false` if the main
+  //!     executable module could not be determined.
+  bool MainModule(Module* module) const;
+
   //! \brief Retrieves information about all pages mapped into the process.
+  //!
+  //! The regions are sorted by increasing base address and do not overlap.
   const MemoryBasicInformation64Vector& MemoryInfo() const;
 
   //! \brief Given a range to be read from the target process, returns a vector
@@ -141,6 +157,21 @@ class ProcessInfo {
   std::vector<CheckedRange<WinVMAddress, WinVMSize>> GetReadableRanges(
       const CheckedRange<WinVMAddress, WinVMSize>& range) const;
 
+  //! \brief Given several ranges to be read from the target process, returns
+  //!     the readable portions of each of them.
+  //!
+  //! This is equivalent to calling GetReadableRanges() for each element of \a
+  //!     ranges, but is faster when there are many ranges to be inspected.
+  //!
+  //! \param[in] ranges The ranges being identified.
+  //!
+  //! \return A vector with one element for each element of \a ranges, in the
+  //!     same order, each containing the portion of that range that is
+  //!     readable based on the memory map.
+  std::vector<std::vector<CheckedRange<WinVMAddress, WinVMSize>>>
+  GetReadableRanges(
+      const std::vector<CheckedRange<WinVMAddress, WinVMSize>>& ranges) const;
+
   //! \brief Given a range in the target process, determines if the entire range
   //!     is readable.
   //!
@@ -165,6 +196,8 @@ class ProcessInfo {
   friend bool ReadProcessData(HANDLE process,
                               WinVMAddress peb_address_vmaddr,
                               ProcessInfo* process_info);
+  template <class Traits>
+  friend void ReadModuleList(HANDLE process, const ProcessInfo* process_info);
 
   friend bool ReadMemoryInfo(HANDLE process,
                              bool is_64_bit,
@@ -173,13 +206,31 @@ class ProcessInfo {
   // This function is best-effort under low memory conditions.
   std::vector<Handle> BuildHandleVector(HANDLE process) const;
 
+  // Builds the handle vector from a snapshot of just this process’ handle
+  // table. Returns false if that’s not possible, such as before Windows 8.
+  bool BuildHandleVectorFromProcessHandleInformation(
+      HANDLE process,
+      std::vector<Handle>* handles) const;
+
+  // Builds the handle vector by filtering the system-wide handle table.
+  std::vector<Handle> BuildHandleVectorFromSystemHandleInformation(
+      HANDLE process) const;
+
   pid_t process_id_;
   pid_t inherited_from_process_id_;
   HANDLE process_;
   std::wstring command_line_;
   WinVMAddress peb_address_;
   WinVMSize peb_size_;
-  std::vector<Module> modules_;
+
+  // Modules() is logically const, but completes modules_ on first retrieval.
+  // Until then, modules_ holds only the main executable module, and the
+  // remaining modules are found by walking the list from
+  // ldr_initialization_order_first_ to ldr_initialization_order_last_.
+  mutable std::vector<Module> modules_;
+  WinVMAddress ldr_initialization_order_first_;
+  WinVMAddress ldr_initialization_order_last_;
+  mutable bool read_module_list_;
 
   // memory_info_ is a MemoryBasicInformation64Vector instead of a
   // std::vector<MEMORY_BASIC_INFORMATION64> because MEMORY_BASIC_INFORMATION64
@@ -209,12 +260,30 @@ class ProcessInfo {
 //!     target process, returns a vector of ranges, representing the readable
 //!     portions of the original range.
 //!
+//! \a memory_info must be sorted by increasing base address, with no
+//! overlapping regions, as returned by ProcessInfo::MemoryInfo(). The regions
+//! overlapping \a range are located by binary search.
+//!
 //! This is a free function for testing, but prefer
 //! ProcessInfo::GetReadableRanges().
 std::vector<CheckedRange<WinVMAddress, WinVMSize>> GetReadableRangesOfMemoryMap(
     const CheckedRange<WinVMAddress, WinVMSize>& range,
     const ProcessInfo::MemoryBasicInformation64Vector& memory_info);
 
+//! \brief Given a memory map of a process, and several ranges to be read from
+//!     the target process, returns the readable portions of each of them.
+//!
+//! \a memory_info has the same requirements as it does for the single-range
+//! form of this function. The result has one element for each element of \a
+//! ranges, in the same order.
+//!
+//! This is a free function for testing, but prefer
+//! ProcessInfo::GetReadableRanges().
+std::vector<std::vector<CheckedRange<WinVMAddress, WinVMSize>>>
+GetReadableRangesOfMemoryMap(
+    const std::vector<CheckedRange<WinVMAddress, WinVMSize>>& ranges,
+    const ProcessInfo::MemoryBasicInformation64Vector& memory_info);
+
 }  // namespace crashpad
 
 #endif  // CRASHPAD_UTIL_WIN_PROCESS_INFO_H_
@@ -19,6 +19,7 @@
 #include <wchar.h>
 
 #include <memory>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/strings/stringprintf.h"
@@ -448,6 +449,79 @@ TEST(ProcessInfo, RequestedAfterMap) {
   EXPECT_EQ(result[0].size(), 5);
 }
 
+TEST(ProcessInfo, AccessibleRangesBatch) {
+  ProcessInfo::MemoryBasicInformation64Vector memory_info;
+  MEMORY_BASIC_INFORMATION64 mbi = {0};
+
+  mbi.BaseAddress = 0;
+  mbi.RegionSize = 10;
+  mbi.State = MEM_COMMIT;
+  memory_info.push_back(mbi);
+
+  mbi.BaseAddress = 10;
+  mbi.RegionSize = 10;
+  mbi.State = MEM_FREE;
+  memory_info.push_back(mbi);
+
+  mbi.BaseAddress = 20;
+  mbi.RegionSize = 10;
+  mbi.State = MEM_COMMIT;
+  memory_info.push_back(mbi);
+
+  mbi.BaseAddress = 30;
+  mbi.RegionSize = 10;
+  mbi.State = MEM_COMMIT;
+  memory_info.push_back(mbi);
+
+  // The ranges are deliberately out of order, to make sure that the results
+  // are returned in the order that the ranges were given.
+  std::vector<CheckedRange<WinVMAddress, WinVMSize>> ranges;
+  ranges.push_back(CheckedRange<WinVMAddress, WinVMSize>(25, 10));
+  ranges.push_back(CheckedRange<WinVMAddress, WinVMSize>(5, 20));
+  ranges.push_back(CheckedRange<WinVMAddress, WinVMSize>(12, 4));
+  ranges.push_back(CheckedRange<WinVMAddress, WinVMSize>(35, 100));
+  ranges.push_back(CheckedRange<WinVMAddress, WinVMSize>(2, 4));
+
+  std::vector<std::vector<CheckedRange<WinVMAddress, WinVMSize>>> result =
+      GetReadableRangesOfMemoryMap(ranges, memory_info);
+  ASSERT_EQ(result.size(), ranges.size());
+
+  for (size_t index = 0; index < ranges.size(); ++index) {
+    SCOPED_TRACE(base::StringPrintf("index %zu", index));
+    std::vector<CheckedRange<WinVMAddress, WinVMSize>> expected =
+        GetReadableRangesOfMemoryMap(ranges[index], memory_info);
+    ASSERT_EQ(result[index].size(), expected.size());
+    for (size_t range_index = 0; range_index < expected.size();
+         ++range_index) {
+      EXPECT_EQ(result[index][range_index].base(),
+                expected[range_index].base());
+      EXPECT_EQ(result[index][range_index].size(),
+                expected[range_index].size());
+    }
+  }
+
+  // The two adjacent committed regions are coalesced.
+  ASSERT_EQ(result[0].size(), 1u);
+  EXPECT_EQ(result[0][0].base(), 25);
+  EXPECT_EQ(result[0][0].size(), 10);
+
+  ASSERT_EQ(result[1].size(), 2u);
+  EXPECT_EQ(result[1][0].base(), 5);
+  EXPECT_EQ(result[1][0].size(), 5);
+  EXPECT_EQ(result[1][1].base(), 20);
+  EXPECT_EQ(result[1][1].size(), 5);
+
+  EXPECT_TRUE(result[2].empty());
+
+  ASSERT_EQ(result[3].size(), 1u);
+  EXPECT_EQ(result[3][0].base(), 35);
+  EXPECT_EQ(result[3][0].size(), 5);
+
+  ASSERT_EQ(result[4].size(), 1u);
+  EXPECT_EQ(result[4][0].base(), 2);
+  EXPECT_EQ(result[4][0].size(), 4);
+}
+
 TEST(ProcessInfo, ReadableRanges) {
   SYSTEM_INFO system_info;
   GetSystemInfo(&system_info);
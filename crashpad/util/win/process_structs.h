@@ -505,6 +505,22 @@ struct SYSTEM_HANDLE_INFORMATION_EX {
   SYSTEM_HANDLE_TABLE_ENTRY_INFO_EX Handles[1];
 };
 
+struct PROCESS_HANDLE_TABLE_ENTRY_INFO {
+  HANDLE HandleValue;
+  ULONG_PTR HandleCount;
+  ULONG_PTR PointerCount;
+  ULONG GrantedAccess;
+  ULONG ObjectTypeIndex;
+  ULONG HandleAttributes;
+  ULONG Reserved;
+};
+
+struct PROCESS_HANDLE_SNAPSHOT_INFORMATION {
+  ULONG_PTR NumberOfHandles;
+  ULONG_PTR Reserved;
+  PROCESS_HANDLE_TABLE_ENTRY_INFO Handles[1];
+};
+
 #pragma pack(pop)
 
 //! \}
@@ -115,9 +115,10 @@ HANDLE CreateNamedPipeInstance(const std::wstring& pipe_name,
 
   return CreateNamedPipe(
       pipe_name.c_str(),
-      PIPE_ACCESS_DUPLEX | (first_instance ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+      PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED |
+          (first_instance ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
       PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
-      ExceptionHandlerServer::kPipeInstances,
+      ExceptionHandlerServer::kMaxPipeInstances,
       512,
       512,
       0,
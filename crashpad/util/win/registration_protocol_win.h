@@ -68,13 +68,38 @@ struct RegistrationRequest {
   WinVMAddress critical_section_address;
 };
 
-//! \brief A message only sent to the server by itself to trigger shutdown.
+//! \brief A message formerly sent to the server by itself to trigger shutdown.
+//!
+//! The server now stops its pipe service threads directly and rejects this
+//! message. It is retained so that the layout of ClientToServerMessage is
+//! unchanged.
 struct ShutdownRequest {
   //! \brief A randomly generated token used to validate the the shutdown
   //!     request was not sent from another process.
   uint64_t token;
 };
 
+//! \brief A request that the server capture a dump of a registered client and
+//!     then terminate it, sent by
+//!     CrashpadClient::DumpAndCrashTargetProcessInHandler().
+//!
+//! The dump is captured with the client’s registration data, with the
+//! exception fabricated at the current context of a thread, so no code is run
+//! in the client. The server only acts on the request if the process that
+//! sends it could itself terminate the client.
+struct DumpAndCrashRequest {
+  //! \brief The PID of the client process to be dumped.
+  DWORD client_process_id;
+
+  //! \brief The thread in the client process that the exception is reported
+  //!     at.
+  DWORD thread_id;
+
+  //! \brief The exception code to report, which is also the code that the
+  //!     client process is terminated with.
+  DWORD exception_code;
+};
+
 //! \brief The message passed from client to server by
 //!     SendToCrashHandlerServer().
 struct ClientToServerMessage {
@@ -90,11 +115,15 @@ struct ClientToServerMessage {
     //!     No data is required, this just confirms that the server is ready to
     //!     accept client registrations.
     kPing,
+
+    //! \brief For DumpAndCrashRequest.
+    kDumpAndCrash,
   } type;
 
   union {
     RegistrationRequest registration;
     ShutdownRequest shutdown;
+    DumpAndCrashRequest dump_and_crash;
   };
 };
 
@@ -142,6 +171,9 @@ bool SendToCrashHandlerServer(const base::string16& pipe_name,
 //!     pipe name is not already in use when created. The first instance will be
 //!     created with an untrusted integrity SACL so instances of this pipe can
 //!     be connected to by processes of any integrity level.
+//!
+//! The instance is created for overlapped I/O, as the exception handler server
+//! services it through a completion port.
 HANDLE CreateNamedPipeInstance(const std::wstring& pipe_name,
                                bool first_instance);
 
@@ -0,0 +1,65 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/win/scoped_process_clone.h"
+
+#include "base/logging.h"
+#include "util/win/get_function.h"
+
+namespace crashpad {
+
+ScopedProcessClone::ScopedProcessClone(HANDLE process)
+    : snapshot_(nullptr), clone_(nullptr) {
+  // These are only present in kernel32.dll on Windows 8.1 and later.
+  static const auto pss_capture_snapshot =
+      GET_FUNCTION(L"kernel32.dll", ::PssCaptureSnapshot);
+  static const auto pss_query_snapshot =
+      GET_FUNCTION(L"kernel32.dll", ::PssQuerySnapshot);
+  if (!pss_capture_snapshot || !pss_query_snapshot)
+    return;
+
+  DWORD result =
+      pss_capture_snapshot(process, PSS_CAPTURE_VA_CLONE, 0, &snapshot_);
+  if (result != ERROR_SUCCESS) {
+    snapshot_ = nullptr;
+    LOG(WARNING) << "PssCaptureSnapshot: error " << result;
+    return;
+  }
+
+  PSS_VA_CLONE_INFORMATION va_clone_information = {};
+  result = pss_query_snapshot(snapshot_,
+                              PSS_QUERY_VA_CLONE_INFORMATION,
+                              &va_clone_information,
+                              sizeof(va_clone_information));
+  if (result != ERROR_SUCCESS) {
+    LOG(WARNING) << "PssQuerySnapshot: error " << result;
+    return;
+  }
+
+  clone_ = va_clone_information.VaCloneHandle;
+}
+
+ScopedProcessClone::~ScopedProcessClone() {
+  if (snapshot_) {
+    // Freeing the snapshot also terminates the clone and closes clone_.
+    static const auto pss_free_snapshot =
+        GET_FUNCTION_REQUIRED(L"kernel32.dll", ::PssFreeSnapshot);
+    DWORD result = pss_free_snapshot(GetCurrentProcess(), snapshot_);
+    if (result != ERROR_SUCCESS) {
+      LOG(ERROR) << "PssFreeSnapshot: error " << result;
+    }
+  }
+}
+
+}  // namespace crashpad
@@ -0,0 +1,65 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CRASHPAD_UTIL_WIN_SCOPED_PROCESS_CLONE_H_
+#define CRASHPAD_UTIL_WIN_SCOPED_PROCESS_CLONE_H_
+
+#include <windows.h>
+#include <processsnapshot.h>
+
+#include "base/macros.h"
+
+namespace crashpad {
+
+//! \brief Manages a copy-on-write clone of another process’ address space.
+//!
+//! The clone is made with `PssCaptureSnapshot()` and `PSS_CAPTURE_VA_CLONE`.
+//! Its memory reflects the state of the other process at the time that the
+//! clone was made, and remains readable through clone() after the other process
+//! has resumed and gone on to modify its own memory. Pages are only copied as
+//! the other process writes to them, so making the clone is cheap compared to
+//! copying the memory of interest out of a suspended process.
+//!
+//! The clone contains no threads, and carries none of the other process’
+//! handles. Only its memory should be read.
+//!
+//! This facility is only available on Windows 8.1 and later. When it is not
+//! available, or when the clone can’t be made, clone() returns `nullptr`, and
+//! callers should read from the other process directly.
+class ScopedProcessClone {
+ public:
+  //! \brief Clones the address space of \a process.
+  //!
+  //! Does not take ownership of \a process, which must have
+  //! `PROCESS_CREATE_PROCESS`, `PROCESS_QUERY_INFORMATION`, and
+  //! `PROCESS_VM_READ` access. To obtain a consistent view of its memory,
+  //! \a process should be suspended while this constructor runs.
+  explicit ScopedProcessClone(HANDLE process);
+  ~ScopedProcessClone();
+
+  //! \return A handle to the clone, which is valid for the lifetime of this
+  //!     object and has at least `PROCESS_VM_READ` and
+  //!     `PROCESS_QUERY_INFORMATION` access, or `nullptr` if no clone was made.
+  HANDLE clone() const { return clone_; }
+
+ private:
+  HPSS snapshot_;
+  HANDLE clone_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedProcessClone);
+};
+
+}  // namespace crashpad
+
+#endif  // CRASHPAD_UTIL_WIN_SCOPED_PROCESS_CLONE_H_
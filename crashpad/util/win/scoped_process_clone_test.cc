@@ -0,0 +1,63 @@
+// Copyright 2017 The Crashpad Authors. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/win/scoped_process_clone.h"
+
+#include <stdint.h>
+
+#include "gtest/gtest.h"
+#include "test/errors.h"
+
+namespace crashpad {
+namespace test {
+namespace {
+
+TEST(ScopedProcessClone, CopyOnWrite) {
+  static volatile uint32_t value = 0x0badf00d;
+
+  ScopedProcessClone clone(GetCurrentProcess());
+  if (!clone.clone()) {
+    // Cloning isn’t available before Windows 8.1.
+    return;
+  }
+
+  uint32_t read = 0;
+  SIZE_T bytes_read = 0;
+  ASSERT_TRUE(ReadProcessMemory(clone.clone(),
+                                const_cast<uint32_t*>(&value),
+                                &read,
+                                sizeof(read),
+                                &bytes_read))
+      << ErrorMessage("ReadProcessMemory");
+  EXPECT_EQ(bytes_read, sizeof(read));
+  EXPECT_EQ(read, 0x0badf00du);
+
+  // Writes made to this process after the clone was made must not show up in
+  // the clone.
+  value = 0xfeedface;
+
+  read = 0;
+  ASSERT_TRUE(ReadProcessMemory(clone.clone(),
+                                const_cast<uint32_t*>(&value),
+                                &read,
+                                sizeof(read),
+                                &bytes_read))
+      << ErrorMessage("ReadProcessMemory");
+  EXPECT_EQ(read, 0x0badf00du);
+  EXPECT_EQ(value, 0xfeedfaceu);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace crashpad
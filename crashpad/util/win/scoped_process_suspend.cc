@@ -33,17 +33,22 @@ ScopedProcessSuspend::ScopedProcessSuspend(HANDLE process) {
 }
 
 ScopedProcessSuspend::~ScopedProcessSuspend() {
+  Resume();
+}
+
+void ScopedProcessSuspend::TolerateTermination() {
+  tolerate_termination_ = true;
+}
+
+void ScopedProcessSuspend::Resume() {
   if (process_) {
     NTSTATUS status = NtResumeProcess(process_);
     if (!NT_SUCCESS(status) &&
         (!tolerate_termination_ || status != STATUS_PROCESS_IS_TERMINATING)) {
       NTSTATUS_LOG(ERROR, status) << "NtResumeProcess";
     }
+    process_ = nullptr;
   }
 }
 
-void ScopedProcessSuspend::TolerateTermination() {
-  tolerate_termination_ = true;
-}
-
 }  // namespace crashpad
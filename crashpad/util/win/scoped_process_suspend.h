@@ -44,6 +44,13 @@ class ScopedProcessSuspend {
   //! terminating, this method may be called to suppress that error message.
   void TolerateTermination();
 
+  //! \brief Resumes the process now, rather than when the object is destroyed.
+  //!
+  //! This may be used when everything needed from the suspended process has
+  //! been gathered before the object’s scope ends. Destroying the object after
+  //! this has been called has no further effect.
+  void Resume();
+
  private:
   HANDLE process_;
   bool tolerate_termination_ = false;
@@ -109,6 +109,16 @@ TEST(ScopedProcessSuspend, ScopedProcessSuspend) {
 
   EXPECT_TRUE(SuspendCountMatches(handles->process.get(), 0));
 
+  {
+    ScopedProcessSuspend suspend(handles->process.get());
+    EXPECT_TRUE(SuspendCountMatches(handles->process.get(), 1));
+
+    suspend.Resume();
+    EXPECT_TRUE(SuspendCountMatches(handles->process.get(), 0));
+  }
+
+  EXPECT_TRUE(SuspendCountMatches(handles->process.get(), 0));
+
   // Tell the child it's OK to terminate.
   char c = ' ';
   EXPECT_TRUE(WriteFile(handles->write.get(), &c, sizeof(c)));